@@ -0,0 +1,825 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+
+// PCH header
+#include "pch.hpp"
+
+#include "AnalysisBenchmark.h"
+
+// dsa app headers
+#include "DsaController.h"
+#include "InteractionBenchmark.h"
+#include "LineOfSightController.h"
+#include "LineOfSightEngine.h"
+#include "LocationController.h"
+#include "LocationDisplay3d.h"
+#include "LocationViewshed360.h"
+#include "MemoryBudget.h"
+#include "ViewshedController.h"
+#include "ViewshedListModel.h"
+#include "ViewshedPool.h"
+#include "ViewshedRasterCache.h"
+
+// toolkit headers
+#include "ToolManager.h"
+
+// C++ API headers
+#include "ArcGISScene.h"
+#include "Graphic.h"
+#include "GraphicListModel.h"
+#include "GraphicsOverlay.h"
+#include "GraphicsOverlayListModel.h"
+#include "LayerSceneProperties.h"
+#include "SceneQuickView.h"
+#include "SimpleMarkerSymbol.h"
+#include "SimpleRenderer.h"
+#include "Surface.h"
+
+// Qt headers
+#include <QDebug>
+#include <QMutexLocker>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QQuickWindow>
+#include <QTimer>
+
+// STL headers
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+namespace Benchmark {
+
+namespace {
+constexpr double s_nsecsPerMsec = 1000000.0;
+constexpr double s_bytesPerMegabyte = 1024.0 * 1024.0;
+constexpr int s_windowWidth = 1280;
+constexpr int s_windowHeight = 720;
+constexpr int s_settleTime = 2000;
+constexpr int s_drawTimeout = 10000;
+constexpr int s_engineTimeout = 60000;
+constexpr int s_updateRounds = 5;
+constexpr int s_moveInterval = 100;
+constexpr double s_observerHeight = 10.0;
+constexpr double s_moveDegrees = 0.0002;
+constexpr double s_viewshedDistance = 1000.0;
+constexpr double s_goldenAngle = 2.39996323;
+
+// GL_NVX_gpu_memory_info, in kilobytes
+constexpr GLenum s_gpuMemoryTotal = 0x9048;
+constexpr GLenum s_gpuMemoryAvailable = 0x9049;
+}
+
+const QString AnalysisBenchmark::RESULT_PREFIX = QStringLiteral("DSA_ANALYSIS_RESULT ");
+
+/*!
+  \class Dsa::Benchmark::AnalysisBenchmark
+  \inmodule Dsa
+  \inherits QObject
+  \brief Measures how the viewshed and line of sight analyses scale with their number.
+
+  The app is started against a fixture, whose scene has the app's elevation, in a
+  window which is shown, as the analyses are only computed as the scene is drawn.
+  Observers are placed on the surface in a spiral about the center of the view, and
+  for each number of analyses in turn the benchmark creates that many of each type
+  through the tools, as they are created in the app:
+
+  \list
+    \li \c locationViewshed360 - \l LocationViewshed360 through the \l ViewshedController.
+    \li \c geoElementViewshed360 - \l GeoElementViewshed360 of graphics through the
+        \l ViewshedController.
+    \li \c geoElementLineOfSight - \c GeoElementLineOfSight from the location to
+        graphics through the \l LineOfSightController.
+  \endlist
+
+  The viewshed limit of the \l ViewshedController is lifted, so that every viewshed
+  is analysed. Each stage records the time taken to create the analyses, the latency
+  until the scene has drawn them, the latency of redrawing them after every observer
+  has moved, and the frame times while the observers move for the sample duration.
+  The latencies are measured to the next completed draw of the scene, and a draw
+  which does not complete within 10 seconds is counted as a timeout.
+
+  The resident memory and the graphics memory are recorded at the end of each stage.
+  The graphics memory is only known where the driver reports it, through the
+  \c GL_NVX_gpu_memory_info extension, and is otherwise \c -1.
+
+  Finally the CPU engines are timed for each number of observers: the
+  \l LineOfSightEngine for the lines of sight from the center of the view, first
+  with and then without sampling the terrain, and the \l ViewshedRasterCache for a
+  viewshed raster of each observer.
+ */
+
+/*!
+  \brief Constructor for the benchmark of the fixture at \a fixturePath.
+
+  The analyses are benchmarked for each of \a counts, sampling the frames for
+  \a sampleDuration milliseconds, and the benchmark gives up after \a timeout
+  milliseconds, taking an optional \a parent.
+ */
+AnalysisBenchmark::AnalysisBenchmark(const QString& fixturePath, const QList<int>& counts, int sampleDuration, int timeout,
+                                     QObject* parent /* = nullptr */):
+  QObject(parent),
+  m_fixturePath(fixturePath),
+  m_counts(counts),
+  m_sampleDuration(sampleDuration),
+  m_timeout(timeout),
+  m_drawTimer(new QTimer(this)),
+  m_moveTimer(new QTimer(this))
+{
+  std::sort(m_counts.begin(), m_counts.end());
+
+  for (AnalysisType type : {AnalysisType::LocationViewshed, AnalysisType::GeoElementViewshed, AnalysisType::LineOfSight})
+  {
+    for (int count : qAsConst(m_counts))
+      m_stages.append(Stage{type, count});
+  }
+
+  m_drawTimer->setSingleShot(true);
+  m_drawTimer->setInterval(s_drawTimeout);
+  connect(m_drawTimer, &QTimer::timeout, this, [this]()
+  {
+    auto callback = m_drawCallback;
+    m_drawCallback = nullptr;
+    if (callback)
+      callback(-1);
+  });
+
+  m_moveTimer->setInterval(s_moveInterval);
+  connect(m_moveTimer, &QTimer::timeout, this, &AnalysisBenchmark::moveObservers);
+}
+
+/*!
+  \brief Destructor.
+ */
+AnalysisBenchmark::~AnalysisBenchmark()
+{
+  delete m_window;
+}
+
+/*!
+  \brief Starts the app against the fixture and runs the benchmark.
+
+  The fixture must have been made the app's data path, for example with the
+  \c DSA_DATA_PATH environment variable, before this is called.
+ */
+void AnalysisBenchmark::start()
+{
+  m_clock.start();
+
+  m_controller = new DsaController(this);
+  connect(m_controller, &DsaController::errorOccurred, this, [](const QString& message, const QString& additionalMessage)
+  {
+    qWarning() << message << additionalMessage;
+  });
+
+  m_window = new QQuickWindow();
+  m_window->resize(s_windowWidth, s_windowHeight);
+  m_sceneView = new SceneQuickView(m_window->contentItem());
+  m_sceneView->setSize(QSizeF(s_windowWidth, s_windowHeight));
+
+  // with the threaded render loop these are emitted on the render thread
+  connect(m_window, &QQuickWindow::beforeSynchronizing, this, [this]()
+  {
+    QMutexLocker locker(&m_frameMutex);
+    if (m_collectingFrames)
+      m_frameStart = m_clock.nsecsElapsed();
+  }, Qt::DirectConnection);
+
+  connect(m_window, &QQuickWindow::afterRendering, this, [this]()
+  {
+    QMutexLocker locker(&m_frameMutex);
+    if (!m_queryGpuMemory)
+      return;
+
+    m_queryGpuMemory = false;
+    QOpenGLContext* context = QOpenGLContext::currentContext();
+    if (!context || !context->hasExtension(QByteArrayLiteral("GL_NVX_gpu_memory_info")))
+      return;
+
+    GLint total = 0;
+    GLint available = 0;
+    context->functions()->glGetIntegerv(s_gpuMemoryTotal, &total);
+    context->functions()->glGetIntegerv(s_gpuMemoryAvailable, &available);
+    m_gpuMemory = static_cast<qint64>(total - available) * 1024;
+  }, Qt::DirectConnection);
+
+  connect(m_window, &QQuickWindow::frameSwapped, this, [this]()
+  {
+    const qint64 now = m_clock.nsecsElapsed();
+    QMutexLocker locker(&m_frameMutex);
+    if (!m_collectingFrames)
+      return;
+
+    m_frameSwaps.append(now);
+    if (m_frameStart >= 0)
+      m_frameTimes.append(now - m_frameStart);
+
+    m_frameStart = -1;
+  }, Qt::DirectConnection);
+
+  connect(m_sceneView, &SceneQuickView::drawStatusChanged, this, [this](DrawStatus drawStatus)
+  {
+    if (drawStatus == DrawStatus::Completed)
+      handleDrawCompleted();
+  });
+
+  m_controller->init(m_sceneView);
+
+  // the location is the observer of the lines of sight
+  new LocationController(this);
+  m_viewshedController = new ViewshedController(this);
+  m_lineOfSightController = new LineOfSightController(this);
+  m_lineOfSightEngine = new LineOfSightEngine(this);
+  m_viewshedRasterCache = new ViewshedRasterCache(this);
+
+  m_window->show();
+
+  // the elevation is still loading when the scene first draws
+  waitForDraw([this](qint64)
+  {
+    QTimer::singleShot(s_settleTime, this, [this]()
+    {
+      setupScene();
+      runStage(0);
+    });
+  });
+
+  QTimer::singleShot(m_timeout, this, [this]()
+  {
+    finish(true);
+  });
+}
+
+/*!
+  \internal
+
+  Returns the name of the analysis \a type in the result.
+ */
+QString AnalysisBenchmark::typeName(AnalysisType type)
+{
+  switch (type)
+  {
+  case AnalysisType::LocationViewshed:
+    return QStringLiteral("locationViewshed360");
+  case AnalysisType::GeoElementViewshed:
+    return QStringLiteral("geoElementViewshed360");
+  case AnalysisType::LineOfSight:
+    return QStringLiteral("geoElementLineOfSight");
+  }
+
+  return QString();
+}
+
+/*!
+  \internal
+
+  Returns the time in nanoseconds since the benchmark started.
+ */
+qint64 AnalysisBenchmark::elapsed() const
+{
+  return m_clock.nsecsElapsed();
+}
+
+/*!
+  \internal
+
+  Calls \a callback with the nanoseconds until the scene next completes drawing, or
+  with \c -1 if it does not complete before the draw timeout.
+ */
+void AnalysisBenchmark::waitForDraw(std::function<void(qint64)> callback)
+{
+  m_drawRequested = elapsed();
+  m_drawCallback = callback;
+  m_drawTimer->start();
+}
+
+/*!
+  \internal
+ */
+void AnalysisBenchmark::handleDrawCompleted()
+{
+  if (!m_drawCallback)
+    return;
+
+  const qint64 latency = elapsed() - m_drawRequested;
+  m_drawTimer->stop();
+
+  auto callback = m_drawCallback;
+  m_drawCallback = nullptr;
+  callback(latency);
+}
+
+/*!
+  \internal
+
+  Adds the overlay of the observer graphics and places the observers and the location.
+ */
+void AnalysisBenchmark::setupScene()
+{
+  m_observerOverlay = new GraphicsOverlay(this);
+  m_observerOverlay->setOverlayId(QStringLiteral("Analysis benchmark observers"));
+  m_observerOverlay->setSceneProperties(LayerSceneProperties(SurfacePlacement::Absolute));
+  m_observerOverlay->setRenderer(new SimpleRenderer(new SimpleMarkerSymbol(SimpleMarkerSymbolStyle::Circle, QColor("cyan"), 8.0f, this), this));
+  m_sceneView->graphicsOverlays()->append(m_observerOverlay);
+
+  placeObservers();
+
+  LocationController* locationController = ToolManager::instance().tool<LocationController>();
+  if (locationController && locationController->locationDisplay() && locationController->locationDisplay()->locationGraphic())
+    locationController->locationDisplay()->locationGraphic()->setGeometry(m_center);
+
+  // every analysis is analysed, so that the cost of each is measured
+  m_viewshedController->setViewshedLimit(0);
+}
+
+/*!
+  \internal
+
+  Places the observers on the surface in a spiral about the center of the view, so
+  that any number of them are spread evenly over the same area.
+ */
+void AnalysisBenchmark::placeObservers()
+{
+  const double centerX = m_sceneView->width() / 2.0;
+  const double centerY = m_sceneView->height() / 2.0;
+  const double radius = std::min(centerX, centerY) * 0.8;
+
+  const Point center = m_sceneView->screenToBaseSurface(centerX, centerY);
+  m_center = Point(center.x(), center.y(), center.z() + s_observerHeight, center.spatialReference());
+
+  const int maximumCount = m_counts.isEmpty() ? 0 : m_counts.constLast();
+  m_observerLocations.clear();
+  m_observerLocations.reserve(maximumCount);
+  for (int i = 0; i < maximumCount; ++i)
+  {
+    const double distance = radius * std::sqrt((i + 0.5) / maximumCount);
+    const double angle = i * s_goldenAngle;
+    const Point location = m_sceneView->screenToBaseSurface(centerX + distance * std::cos(angle),
+                                                            centerY + distance * std::sin(angle));
+    if (location.isEmpty())
+      m_observerLocations.append(m_center);
+    else
+      m_observerLocations.append(Point(location.x(), location.y(), location.z() + s_observerHeight, location.spatialReference()));
+  }
+}
+
+/*!
+  \internal
+
+  Creates the analyses of the stage at \a index and measures them, moving on to the
+  CPU engines after the last stage.
+ */
+void AnalysisBenchmark::runStage(int index)
+{
+  if (m_finished)
+    return;
+
+  clearAnalyses();
+
+  if (index >= m_stages.size())
+  {
+    m_stageIndex = -1;
+    runEngines(0);
+    return;
+  }
+
+  m_stageIndex = index;
+  m_setupLatency = -1;
+  m_updateLatencies.clear();
+  m_updateTimeouts = 0;
+
+  waitForDraw([this, index](qint64 latency)
+  {
+    m_setupLatency = latency;
+    runUpdate(index, 0);
+  });
+
+  const qint64 createStart = elapsed();
+  addAnalyses(m_stages.at(index));
+  m_createNsecs = elapsed() - createStart;
+}
+
+/*!
+  \internal
+ */
+void AnalysisBenchmark::addAnalyses(const Stage& stage)
+{
+  for (int i = 0; i < stage.m_count && i < m_observerLocations.size(); ++i)
+  {
+    const Point& location = m_observerLocations.at(i);
+    if (stage.m_type == AnalysisType::LocationViewshed)
+    {
+      m_viewshedController->addLocationViewshed360(location);
+      m_viewshedController->finishActiveViewshed();
+      continue;
+    }
+
+    Graphic* graphic = new Graphic(location, m_observerOverlay);
+    m_observerOverlay->graphics()->append(graphic);
+    m_observerGraphics.append(graphic);
+
+    if (stage.m_type == AnalysisType::GeoElementViewshed)
+    {
+      m_viewshedController->addGeoElementViewshed360(graphic);
+      m_viewshedController->finishActiveViewshed();
+    }
+    else
+    {
+      m_lineOfSightController->lineOfSightFromLocationToGeoElement(graphic);
+    }
+  }
+}
+
+/*!
+  \internal
+
+  Removes every analysis and observer graphic created by the benchmark.
+ */
+void AnalysisBenchmark::clearAnalyses()
+{
+  if (m_viewshedController)
+  {
+    m_viewshedController->finishActiveViewshed();
+    if (auto viewsheds = qobject_cast<ViewshedListModel*>(m_viewshedController->viewsheds()))
+      viewsheds->clear();
+  }
+
+  if (m_lineOfSightController)
+    m_lineOfSightController->clearAnalysis();
+
+  if (m_observerOverlay)
+    m_observerOverlay->graphics()->clear();
+
+  qDeleteAll(m_observerGraphics);
+  m_observerGraphics.clear();
+}
+
+/*!
+  \internal
+
+  Moves every observer of the current stage to one side of its place, and back on
+  the next call.
+ */
+void AnalysisBenchmark::moveObservers()
+{
+  if (m_stageIndex < 0)
+    return;
+
+  ++m_moveStep;
+  const double offset = (m_moveStep % 2) ? s_moveDegrees : -s_moveDegrees;
+  const Stage& stage = m_stages.at(m_stageIndex);
+  auto viewsheds = qobject_cast<ViewshedListModel*>(m_viewshedController->viewsheds());
+
+  for (int i = 0; i < stage.m_count && i < m_observerLocations.size(); ++i)
+  {
+    const Point& location = m_observerLocations.at(i);
+    const Point moved(location.x() + offset, location.y(), location.z(), location.spatialReference());
+
+    if (stage.m_type == AnalysisType::LocationViewshed)
+    {
+      auto viewshed = viewsheds ? qobject_cast<LocationViewshed360*>(viewsheds->at(i)) : nullptr;
+      if (viewshed)
+        viewshed->setPoint(moved);
+    }
+    else if (i < m_observerGraphics.size())
+    {
+      m_observerGraphics.at(i)->setGeometry(moved);
+    }
+  }
+}
+
+/*!
+  \internal
+
+  Moves the observers of the stage at \a index and waits for the scene to redraw,
+  for each \a round of updates, then samples the frames.
+ */
+void AnalysisBenchmark::runUpdate(int index, int round)
+{
+  if (m_finished)
+    return;
+
+  if (round >= s_updateRounds)
+  {
+    sampleFrames(index);
+    return;
+  }
+
+  waitForDraw([this, index, round](qint64 latency)
+  {
+    if (latency < 0)
+      ++m_updateTimeouts;
+    else
+      m_updateLatencies.append(latency);
+
+    runUpdate(index, round + 1);
+  });
+
+  moveObservers();
+}
+
+/*!
+  \internal
+
+  Records the frames while the observers of the stage at \a index move, then
+  records the stage and starts the next.
+ */
+void AnalysisBenchmark::sampleFrames(int index)
+{
+  {
+    QMutexLocker locker(&m_frameMutex);
+    m_frameSwaps.clear();
+    m_frameTimes.clear();
+    m_frameStart = -1;
+    m_collectingFrames = true;
+  }
+
+  m_moveTimer->start();
+
+  QTimer::singleShot(m_sampleDuration, this, [this, index]()
+  {
+    m_moveTimer->stop();
+
+    {
+      QMutexLocker locker(&m_frameMutex);
+      m_collectingFrames = false;
+      m_queryGpuMemory = true;
+      m_gpuMemory = -1;
+    }
+
+    // the graphics memory is read as the next frame is rendered
+    m_window->update();
+    QTimer::singleShot(s_moveInterval, this, [this, index]()
+    {
+      if (m_finished)
+        return;
+
+      recordStage(index);
+      runStage(index + 1);
+    });
+  });
+}
+
+/*!
+  \internal
+ */
+void AnalysisBenchmark::recordStage(int index)
+{
+  const Stage& stage = m_stages.at(index);
+
+  QVector<qint64> frameSwaps;
+  QVector<qint64> frameTimes;
+  qint64 gpuMemory = -1;
+  {
+    QMutexLocker locker(&m_frameMutex);
+    frameSwaps = m_frameSwaps;
+    frameTimes = m_frameTimes;
+    gpuMemory = m_gpuMemory;
+    m_queryGpuMemory = false;
+  }
+
+  QVector<qint64> frameIntervals;
+  for (int i = 1; i < frameSwaps.size(); ++i)
+    frameIntervals.append(frameSwaps.at(i) - frameSwaps.at(i - 1));
+
+  const int shown = stage.m_type == AnalysisType::LineOfSight ? std::min(stage.m_count, m_observerGraphics.size())
+                                                              : m_viewshedController->viewshedPool()->shownCount();
+
+  QJsonObject result;
+  result.insert(QStringLiteral("analysis"), typeName(stage.m_type));
+  result.insert(QStringLiteral("count"), stage.m_count);
+  result.insert(QStringLiteral("shown"), shown);
+  result.insert(QStringLiteral("createMilliseconds"), m_createNsecs / s_nsecsPerMsec);
+  result.insert(QStringLiteral("setupLatency"), m_setupLatency < 0 ? -1.0 : m_setupLatency / s_nsecsPerMsec);
+  result.insert(QStringLiteral("updateLatency"), InteractionBenchmark::percentiles(m_updateLatencies));
+  result.insert(QStringLiteral("updateTimeouts"), m_updateTimeouts);
+  result.insert(QStringLiteral("frameTime"), InteractionBenchmark::percentiles(frameTimes));
+  result.insert(QStringLiteral("frameInterval"), InteractionBenchmark::percentiles(frameIntervals));
+
+  const qint64 memory = MemoryBudget::residentMemory();
+  result.insert(QStringLiteral("residentMegabytes"), memory < 0 ? -1.0 : memory / s_bytesPerMegabyte);
+  result.insert(QStringLiteral("gpuMegabytes"), gpuMemory < 0 ? -1.0 : gpuMemory / s_bytesPerMegabyte);
+
+  m_stageResults.append(result);
+}
+
+/*!
+  \internal
+
+  Times the CPU engines for the number of observers at \a index in the counts,
+  finishing after the last.
+ */
+void AnalysisBenchmark::runEngines(int index)
+{
+  if (m_finished)
+    return;
+
+  if (index >= m_counts.size())
+  {
+    finish(false);
+    return;
+  }
+
+  const int count = m_counts.at(index);
+  timeLineOfSightEngine(count, [this, index, count](double coldMsecs, double warmMsecs)
+  {
+    timeViewshedRasterCache(count, [this, index, count, coldMsecs, warmMsecs](double rasterMsecs)
+    {
+      QJsonObject result;
+      result.insert(QStringLiteral("count"), count);
+      result.insert(QStringLiteral("lineOfSightColdMilliseconds"), coldMsecs);
+      result.insert(QStringLiteral("lineOfSightWarmMilliseconds"), warmMsecs);
+      result.insert(QStringLiteral("viewshedRasterMilliseconds"), rasterMsecs);
+      m_engineResults.append(result);
+
+      runEngines(index + 1);
+    });
+  });
+}
+
+/*!
+  \internal
+
+  Computes the visibility of \a count observers from the center of the view with the
+  \l LineOfSightEngine twice, the first time sampling the terrain and the second
+  reusing it, and calls \a callback with the milliseconds of each, or \c -1 if the
+  engine timed out.
+ */
+void AnalysisBenchmark::timeLineOfSightEngine(int count, std::function<void(double, double)> callback)
+{
+  Surface* surface = m_sceneView->arcGISScene() ? m_sceneView->arcGISScene()->baseSurface() : nullptr;
+
+  QList<LineOfSightEngine::Pair> pairs;
+  for (int i = 0; i < count && i < m_observerLocations.size(); ++i)
+  {
+    LineOfSightEngine::Pair pair;
+    pair.m_observer = m_center;
+    pair.m_target = m_observerLocations.at(i);
+    pairs.append(pair);
+  }
+
+  m_lineOfSightEngine->clear();
+
+  struct Run
+  {
+    QUuid m_requestId;
+    qint64 m_start = 0;
+    double m_coldMsecs = -1.0;
+    QMetaObject::Connection m_connection;
+    QTimer m_timeout;
+  };
+  auto run = std::make_shared<Run>();
+  run->m_timeout.setSingleShot(true);
+
+  // the connections hold the run, so they are broken once it completes
+  auto complete = [run, callback](double warmMsecs)
+  {
+    QObject::disconnect(run->m_connection);
+    run->m_timeout.stop();
+    run->m_timeout.disconnect();
+    callback(run->m_coldMsecs, warmMsecs);
+  };
+
+  connect(&run->m_timeout, &QTimer::timeout, this, [this, run, complete]()
+  {
+    m_lineOfSightEngine->cancel();
+    complete(-1.0);
+  });
+
+  run->m_connection = connect(m_lineOfSightEngine, &LineOfSightEngine::visibilityComputed, this,
+                              [this, run, pairs, surface, complete](const QUuid& requestId, const QVector<bool>&)
+  {
+    if (requestId != run->m_requestId)
+      return;
+
+    const double msecs = (elapsed() - run->m_start) / s_nsecsPerMsec;
+    if (run->m_coldMsecs >= 0.0)
+    {
+      complete(msecs);
+      return;
+    }
+
+    run->m_coldMsecs = msecs;
+    run->m_start = elapsed();
+    run->m_requestId = m_lineOfSightEngine->computeVisibility(surface, pairs);
+  });
+
+  run->m_timeout.start(s_engineTimeout);
+  run->m_start = elapsed();
+  run->m_requestId = m_lineOfSightEngine->computeVisibility(surface, pairs);
+}
+
+/*!
+  \internal
+
+  Computes the viewshed raster of each of \a count observers with the
+  \l ViewshedRasterCache, and calls \a callback with the milliseconds taken, or
+  \c -1 if the cache timed out.
+ */
+void AnalysisBenchmark::timeViewshedRasterCache(int count, std::function<void(double)> callback)
+{
+  Surface* surface = m_sceneView->arcGISScene() ? m_sceneView->arcGISScene()->baseSurface() : nullptr;
+
+  QList<ViewshedRasterCache::Parameters> observers;
+  for (int i = 0; i < count && i < m_observerLocations.size(); ++i)
+  {
+    ViewshedRasterCache::Parameters parameters;
+    parameters.m_observer = m_observerLocations.at(i);
+    parameters.m_maxDistance = s_viewshedDistance;
+    observers.append(parameters);
+  }
+
+  m_viewshedRasterCache->clear();
+
+  struct Run
+  {
+    qint64 m_start = 0;
+    QMetaObject::Connection m_connection;
+    QTimer m_timeout;
+  };
+  auto run = std::make_shared<Run>();
+  run->m_timeout.setSingleShot(true);
+
+  auto complete = [run, callback](double msecs)
+  {
+    QObject::disconnect(run->m_connection);
+    run->m_timeout.stop();
+    run->m_timeout.disconnect();
+    callback(msecs);
+  };
+
+  connect(&run->m_timeout, &QTimer::timeout, this, [this, complete]()
+  {
+    m_viewshedRasterCache->cancel();
+    complete(-1.0);
+  });
+
+  run->m_connection = connect(m_viewshedRasterCache, &ViewshedRasterCache::finished, this, [this, run, complete]()
+  {
+    complete((elapsed() - run->m_start) / s_nsecsPerMsec);
+  });
+
+  run->m_timeout.start(s_engineTimeout);
+  run->m_start = elapsed();
+  m_viewshedRasterCache->compute(surface, observers);
+}
+
+/*!
+  \internal
+ */
+void AnalysisBenchmark::finish(bool timedOut)
+{
+  if (m_finished)
+    return;
+
+  m_finished = true;
+  m_moveTimer->stop();
+  m_drawTimer->stop();
+  m_drawCallback = nullptr;
+
+  QJsonArray counts;
+  for (int count : qAsConst(m_counts))
+    counts.append(count);
+
+  QJsonObject result;
+  result.insert(QStringLiteral("fixture"), m_fixturePath);
+  result.insert(QStringLiteral("counts"), counts);
+  result.insert(QStringLiteral("sampleMilliseconds"), m_sampleDuration);
+  result.insert(QStringLiteral("timedOut"), timedOut);
+  result.insert(QStringLiteral("stages"), m_stageResults);
+  result.insert(QStringLiteral("engines"), m_engineResults);
+
+  emit finished(result);
+}
+
+} // Benchmark
+} // Dsa
+
+// Signal Documentation
+/*!
+  \fn void AnalysisBenchmark::finished(const QJsonObject& result);
+  \brief Signal emitted when the benchmark has finished, with its \a result.
+
+  The \a result holds the \c stages, each with its \c analysis type and \c count,
+  the number \c shown, the \c createMilliseconds, \c setupLatency, \c updateLatency,
+  \c frameTime and \c frameInterval in milliseconds, and the \c residentMegabytes and
+  \c gpuMegabytes, or \c -1 where these are not known. It also holds the timings of
+  the CPU \c engines for each count, and whether the benchmark \c timedOut.
+ */
@@ -0,0 +1,153 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+
+#ifndef ANALYSISBENCHMARK_H
+#define ANALYSISBENCHMARK_H
+
+// C++ API headers
+#include "Point.h"
+
+// Qt headers
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QPointer>
+#include <QUuid>
+#include <QVector>
+
+// STL headers
+#include <functional>
+
+class QQuickWindow;
+class QTimer;
+
+namespace Esri {
+namespace ArcGISRuntime {
+class Graphic;
+class GraphicsOverlay;
+class SceneQuickView;
+}
+}
+
+namespace Dsa {
+
+class DsaController;
+class LineOfSightController;
+class LineOfSightEngine;
+class ViewshedController;
+class ViewshedRasterCache;
+
+namespace Benchmark {
+
+class AnalysisBenchmark : public QObject
+{
+  Q_OBJECT
+
+public:
+  AnalysisBenchmark(const QString& fixturePath, const QList<int>& counts, int sampleDuration, int timeout, QObject* parent = nullptr);
+  ~AnalysisBenchmark();
+
+  static const QString RESULT_PREFIX;
+
+  void start();
+
+signals:
+  void finished(const QJsonObject& result);
+
+private:
+  Q_DISABLE_COPY(AnalysisBenchmark)
+
+  enum class AnalysisType
+  {
+    LocationViewshed,
+    GeoElementViewshed,
+    LineOfSight
+  };
+
+  struct Stage
+  {
+    AnalysisType m_type = AnalysisType::LocationViewshed;
+    int m_count = 0;
+  };
+
+  static QString typeName(AnalysisType type);
+
+  qint64 elapsed() const;
+  void waitForDraw(std::function<void(qint64)> callback);
+  void handleDrawCompleted();
+  void setupScene();
+  void placeObservers();
+  void runStage(int index);
+  void addAnalyses(const Stage& stage);
+  void clearAnalyses();
+  void moveObservers();
+  void runUpdate(int index, int round);
+  void sampleFrames(int index);
+  void recordStage(int index);
+  void runEngines(int index);
+  void timeLineOfSightEngine(int count, std::function<void(double, double)> callback);
+  void timeViewshedRasterCache(int count, std::function<void(double)> callback);
+  void finish(bool timedOut);
+
+  QString                                 m_fixturePath;
+  QList<int>                              m_counts;
+  int                                     m_sampleDuration = 0;
+  int                                     m_timeout = 0;
+  QElapsedTimer                           m_clock;
+  bool                                    m_finished = false;
+  QList<Stage>                            m_stages;
+  int                                     m_stageIndex = -1;
+  QJsonArray                              m_stageResults;
+  QJsonArray                              m_engineResults;
+  QQuickWindow*                           m_window = nullptr;
+  Esri::ArcGISRuntime::SceneQuickView*    m_sceneView = nullptr;
+  DsaController*                          m_controller = nullptr;
+  ViewshedController*                     m_viewshedController = nullptr;
+  LineOfSightController*                  m_lineOfSightController = nullptr;
+  LineOfSightEngine*                      m_lineOfSightEngine = nullptr;
+  ViewshedRasterCache*                    m_viewshedRasterCache = nullptr;
+  Esri::ArcGISRuntime::GraphicsOverlay*   m_observerOverlay = nullptr;
+  QList<Esri::ArcGISRuntime::Graphic*>    m_observerGraphics;
+  QList<Esri::ArcGISRuntime::Point>       m_observerLocations;
+  Esri::ArcGISRuntime::Point              m_center;
+  QTimer*                                 m_drawTimer = nullptr;
+  std::function<void(qint64)>             m_drawCallback;
+  qint64                                  m_drawRequested = -1;
+  QTimer*                                 m_moveTimer = nullptr;
+  int                                     m_moveStep = 0;
+  qint64                                  m_createNsecs = 0;
+  qint64                                  m_setupLatency = -1;
+  QVector<qint64>                         m_updateLatencies;
+  int                                     m_updateTimeouts = 0;
+
+  // written on the render thread
+  QMutex                                  m_frameMutex;
+  bool                                    m_collectingFrames = false;
+  qint64                                  m_frameStart = -1;
+  QVector<qint64>                         m_frameSwaps;
+  QVector<qint64>                         m_frameTimes;
+  bool                                    m_queryGpuMemory = false;
+  qint64                                  m_gpuMemory = -1;
+};
+
+} // Benchmark
+} // Dsa
+
+#endif // ANALYSISBENCHMARK_H
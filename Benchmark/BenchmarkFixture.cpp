@@ -0,0 +1,262 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "BenchmarkFixture.h"
+
+// dsa app headers
+#include "AlertConstants.h"
+#include "AlertLevel.h"
+#include "AppConstants.h"
+#include "MarkupConstants.h"
+#include "OpenMobileScenePackageController.h"
+
+// Qt headers
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+
+namespace Dsa {
+namespace Benchmark {
+
+namespace {
+constexpr int s_markupElementCount = 20;
+constexpr int s_markupVertexCount = 50;
+
+const QString s_configFileName = QStringLiteral("DsaAppConfig.json");
+
+// the keys of the layers saved by the LayerCacheManager
+const QString s_layerPathKey = QStringLiteral("path");
+const QString s_layerVisibleKey = QStringLiteral("visible");
+const QString s_layerTypeKey = QStringLiteral("type");
+const QString s_layerIdKey = QStringLiteral("id");
+
+// the feeds which the default settings create, used as the sources of the conditions
+const QStringList s_feedNames{QStringLiteral("Friendly Tracks - Land"),
+                              QStringLiteral("Friendly Tracks - Air"),
+                              QStringLiteral("SA Events"),
+                              QStringLiteral("Observation Reports")};
+
+QJsonObject readConfig(const QString& fixturePath)
+{
+  QFile configFile(QDir(fixturePath).filePath(s_configFileName));
+  if (!configFile.open(QIODevice::ReadOnly))
+    return QJsonObject();
+
+  return QJsonDocument::fromJson(configFile.readAll()).object();
+}
+
+bool writeJson(const QString& path, const QJsonObject& json)
+{
+  QSaveFile file(path);
+  if (!file.open(QIODevice::WriteOnly))
+    return false;
+
+  file.write(QJsonDocument(json).toJson());
+  return file.commit();
+}
+
+// writes a markup of polylines around Monterey, which needs no other data to be restored
+bool writeMarkup(const QString& path, int markupIndex)
+{
+  QJsonArray elements;
+  for (int i = 0; i < s_markupElementCount; ++i)
+  {
+    QJsonArray vertices;
+    for (int j = 0; j < s_markupVertexCount; ++j)
+    {
+      const double x = -121.95 + 0.002 * markupIndex + 0.0005 * j;
+      const double y = 36.55 + 0.001 * i + 0.0002 * ((j * 7 + markupIndex) % 5);
+      vertices.append(QJsonArray{x, y});
+    }
+
+    QJsonObject spatialReference;
+    spatialReference.insert(QStringLiteral("wkid"), 4326);
+
+    QJsonObject geometry;
+    geometry.insert(QStringLiteral("paths"), QJsonArray{vertices});
+    geometry.insert(QStringLiteral("spatialReference"), spatialReference);
+
+    QJsonObject element;
+    element.insert(MarkupConstants::COLOR, i % 6);
+    element.insert(MarkupConstants::GEOMETRY, geometry);
+    elements.append(element);
+  }
+
+  QJsonObject markup;
+  markup.insert(MarkupConstants::NAME, QString("Benchmark markup %1").arg(markupIndex + 1));
+  markup.insert(MarkupConstants::ELEMENTS, elements);
+
+  QJsonObject markupJson;
+  markupJson.insert(MarkupConstants::VERSION, MarkupConstants::VERSIONNUMBER);
+  markupJson.insert(MarkupConstants::SHAREDBY, QStringLiteral("benchmark"));
+  markupJson.insert(MarkupConstants::MARKUP, markup);
+
+  return writeJson(path, markupJson);
+}
+
+QJsonObject layerJson(const QString& path)
+{
+  QJsonObject layer;
+  layer.insert(s_layerPathKey, path);
+  layer.insert(s_layerVisibleKey, QStringLiteral("true"));
+
+  // the tables of geodatabases and geopackages are restored by their id
+  const QString suffix = QFileInfo(path).suffix().toLower();
+  if (suffix == QStringLiteral("geodatabase"))
+    layer.insert(s_layerTypeKey, QStringLiteral("FeatureLayerGeodatabase"));
+  else if (suffix == QStringLiteral("gpkg"))
+    layer.insert(s_layerTypeKey, QStringLiteral("FeatureLayerGeoPackage"));
+
+  layer.insert(s_layerIdKey, QStringLiteral("0"));
+  return layer;
+}
+
+QJsonObject conditionJson(int conditionIndex)
+{
+  QJsonObject condition;
+  condition.insert(AlertConstants::CONDITION_NAME, QString("Benchmark condition %1").arg(conditionIndex + 1));
+  condition.insert(AlertConstants::CONDITION_LEVEL, static_cast<int>(conditionIndex % 2 == 0 ? AlertLevel::High : AlertLevel::Medium));
+
+  QJsonObject query;
+  if (conditionIndex % 2 == 0)
+  {
+    condition.insert(AlertConstants::CONDITION_TYPE, AlertConstants::attributeEqualsAlertConditionType());
+    condition.insert(AlertConstants::CONDITION_SOURCE, s_feedNames.at((conditionIndex / 2) % s_feedNames.size()));
+    condition.insert(AlertConstants::CONDITION_TARGET, QString::number(conditionIndex % 3));
+    query.insert(AlertConstants::ATTRIBUTE_NAME, QStringLiteral("status911"));
+  }
+  else
+  {
+    condition.insert(AlertConstants::CONDITION_TYPE, AlertConstants::withinDistanceAlertConditionType());
+    condition.insert(AlertConstants::CONDITION_SOURCE, AlertConstants::MY_LOCATION);
+    condition.insert(AlertConstants::CONDITION_TARGET, s_feedNames.at((conditionIndex / 2) % s_feedNames.size()));
+    query.insert(AlertConstants::METERS, 250.0 * (1 + conditionIndex % 8));
+  }
+
+  condition.insert(AlertConstants::CONDITION_QUERY, query);
+  return condition;
+}
+}
+
+/*!
+  \class Dsa::Benchmark::BenchmarkFixture
+  \inmodule Dsa
+  \brief Writes the workspaces which the startup benchmark runs the app against.
+
+  A fixture is a data directory holding a \c DsaAppConfig.json with a number of saved
+  layers and alert conditions. The settings which are not written keep the app's
+  defaults, so the message feeds are the default feeds.
+
+  Unless other layer data is given, each layer is a markup written into the fixture,
+  so that the layers can be restored without any other data. The data directories,
+  such as the basemaps and elevation, are those of the app's own data path, so the
+  scene is set up as it is in the field.
+ */
+
+/*!
+  \brief Returns the fixtures which are benchmarked by default, from an empty
+  workspace to one with 100 layers and 100 conditions.
+ */
+QList<BenchmarkFixture::Size> BenchmarkFixture::standardSizes()
+{
+  return QList<Size>{{QStringLiteral("empty"), 0, 0},
+                     {QStringLiteral("small"), 5, 5},
+                     {QStringLiteral("medium"), 25, 25},
+                     {QStringLiteral("large"), 100, 100}};
+}
+
+/*!
+  \brief Writes the fixture of the given \a size to the directory \a fixturePath,
+  replacing any fixture which is already there.
+
+  The data directories in the settings are taken from \a dataPath. If \a layerData
+  is not empty, its files are used in turn for the layers instead of markups.
+
+  Returns \c false if the fixture could not be written.
+ */
+bool BenchmarkFixture::write(const QString& fixturePath, const Size& size, const QString& dataPath, const QStringList& layerData)
+{
+  QDir fixtureDir(fixturePath);
+  if (fixtureDir.exists() && !fixtureDir.removeRecursively())
+    return false;
+
+  if (!QDir().mkpath(fixturePath))
+    return false;
+
+  QJsonObject config;
+  config.insert(QStringLiteral("RootDataDirectory"), fixtureDir.absolutePath());
+
+  if (!dataPath.isEmpty())
+  {
+    config.insert(QStringLiteral("BasemapDirectory"), QString("%1/BasemapData").arg(dataPath));
+    config.insert(QStringLiteral("ElevationDirectory"), QString("%1/ElevationData").arg(dataPath));
+    config.insert(QStringLiteral("SimulationDirectory"), QString("%1/SimulationData").arg(dataPath));
+    config.insert(QStringLiteral("ResourceDirectory"), QString("%1/ResourceData").arg(dataPath));
+    config.insert(QStringLiteral("DefaultElevationSource"), QString("%1/ElevationData/CaDEM.tpk").arg(dataPath));
+    config.insert(QStringLiteral("GpxFile"), QString("%1/SimulationData/MontereyMounted.gpx").arg(dataPath));
+    config.insert(OpenMobileScenePackageController::PACKAGE_DIRECTORY_PROPERTYNAME, QString("%1/Packages").arg(dataPath));
+  }
+
+  QJsonArray layers;
+  for (int i = 0; i < size.m_layerCount; ++i)
+  {
+    if (!layerData.isEmpty())
+    {
+      layers.append(layerJson(layerData.at(i % layerData.size())));
+      continue;
+    }
+
+    const QString markupPath = fixtureDir.filePath(QString("benchmark%1.markup").arg(i + 1));
+    if (!writeMarkup(markupPath, i))
+      return false;
+
+    layers.append(layerJson(markupPath));
+  }
+  config.insert(AppConstants::LAYERS_PROPERTYNAME, layers);
+
+  QJsonArray conditions;
+  for (int i = 0; i < size.m_conditionCount; ++i)
+    conditions.append(conditionJson(i));
+  config.insert(AlertConstants::ALERT_CONDITIONS_PROPERTYNAME, conditions);
+
+  return writeJson(fixtureDir.filePath(s_configFileName), config);
+}
+
+/*!
+  \brief Returns the number of saved layers in the fixture at \a fixturePath.
+ */
+int BenchmarkFixture::layerCount(const QString& fixturePath)
+{
+  return readConfig(fixturePath).value(AppConstants::LAYERS_PROPERTYNAME).toArray().size();
+}
+
+/*!
+  \brief Returns the number of saved alert conditions in the fixture at \a fixturePath.
+ */
+int BenchmarkFixture::conditionCount(const QString& fixturePath)
+{
+  return readConfig(fixturePath).value(AlertConstants::ALERT_CONDITIONS_PROPERTYNAME).toArray().size();
+}
+
+} // Benchmark
+} // Dsa
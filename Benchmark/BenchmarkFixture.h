@@ -0,0 +1,52 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef BENCHMARKFIXTURE_H
+#define BENCHMARKFIXTURE_H
+
+// Qt headers
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+namespace Dsa {
+namespace Benchmark {
+
+class BenchmarkFixture
+{
+public:
+  struct Size
+  {
+    QString m_name;
+    int m_layerCount = 0;
+    int m_conditionCount = 0;
+  };
+
+  static QList<Size> standardSizes();
+
+  static bool write(const QString& fixturePath, const Size& size, const QString& dataPath, const QStringList& layerData);
+
+  static int layerCount(const QString& fixturePath);
+  static int conditionCount(const QString& fixturePath);
+
+private:
+  BenchmarkFixture() = delete;
+};
+
+} // Benchmark
+} // Dsa
+
+#endif // BENCHMARKFIXTURE_H
@@ -0,0 +1,388 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "BenchmarkRunner.h"
+
+// dsa app headers
+#include "DsaUtility.h"
+#include "StartupBenchmark.h"
+
+// Qt headers
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QJsonDocument>
+#include <QProcess>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QVector>
+
+// STL headers
+#include <algorithm>
+
+namespace Dsa {
+namespace Benchmark {
+
+namespace {
+// time given to a run to exit after its own timeout
+constexpr int s_exitGrace = 30000;
+
+// differences smaller than this are treated as noise when comparing with a baseline
+constexpr double s_noiseMilliseconds = 5.0;
+
+double median(QVector<double> values)
+{
+  if (values.isEmpty())
+    return 0.0;
+
+  std::sort(values.begin(), values.end());
+  const int middle = values.size() / 2;
+  return values.size() % 2 == 1 ? values.at(middle) : (values.at(middle - 1) + values.at(middle)) / 2.0;
+}
+}
+
+/*!
+  \class Dsa::Benchmark::BenchmarkRunner
+  \inmodule Dsa
+  \brief Runs the startup benchmark against each fixture and reports the results.
+
+  Each run starts a new process of the benchmark for a single fixture, so that every
+  run is a cold start of the app. Unless runs are \l {setWarm}{warm}, the caches which
+  speed up later starts, such as the settings snapshot, are cleared beforehand. The
+  fixture is written again before each run, as the app saves its settings when it
+  exits.
+
+  For each phase the median, fastest and slowest times of the runs are reported,
+  along with the most resident memory at the end of the phase. The results can be
+  written as JSON with \l setOutputPath, and a previous output can be used as the
+  baseline which the results must not regress from with \l setBaselinePath.
+ */
+
+/*!
+  \brief Constructor for the runner of the fixtures of the given \a sizes, which are
+  written below \a workPath.
+ */
+BenchmarkRunner::BenchmarkRunner(const QString& workPath, const QList<BenchmarkFixture::Size>& sizes):
+  m_workPath(workPath),
+  m_sizes(sizes)
+{
+}
+
+/*!
+  \brief Destructor.
+ */
+BenchmarkRunner::~BenchmarkRunner()
+{
+}
+
+/*!
+  \brief Sets the data files used in turn for the layers of each fixture to \a layerData.
+
+  By default the layers are markups written into the fixture.
+ */
+void BenchmarkRunner::setLayerData(const QStringList& layerData)
+{
+  m_layerData = layerData;
+}
+
+/*!
+  \brief Sets the number of times each fixture is run to \a iterations.
+
+  The default is \c 3.
+ */
+void BenchmarkRunner::setIterations(int iterations)
+{
+  m_iterations = std::max(1, iterations);
+}
+
+/*!
+  \brief Sets the time in milliseconds after which a run gives up waiting for the
+  layers and conditions to be restored to \a timeout.
+
+  The default is 2 minutes.
+ */
+void BenchmarkRunner::setTimeout(int timeout)
+{
+  m_timeout = std::max(1000, timeout);
+}
+
+/*!
+  \brief Sets whether the caches of previous runs are kept to \a warm.
+
+  The default is \c false.
+ */
+void BenchmarkRunner::setWarm(bool warm)
+{
+  m_warm = warm;
+}
+
+/*!
+  \brief Sets the file which the results are written to as JSON to \a outputPath.
+ */
+void BenchmarkRunner::setOutputPath(const QString& outputPath)
+{
+  m_outputPath = outputPath;
+}
+
+/*!
+  \brief Sets the results which the current results are compared with to those
+  written to \a baselinePath by an earlier run.
+ */
+void BenchmarkRunner::setBaselinePath(const QString& baselinePath)
+{
+  m_baselinePath = baselinePath;
+}
+
+/*!
+  \brief Sets the fraction by which a phase may be slower than the baseline before
+  it is reported as a regression to \a tolerance.
+
+  The default is \c 0.2, i.e. 20%.
+ */
+void BenchmarkRunner::setTolerance(double tolerance)
+{
+  m_tolerance = std::max(0.0, tolerance);
+}
+
+/*!
+  \brief Runs every fixture and reports the results.
+
+  Returns \c 0 if every run completed and no phase regressed from the baseline,
+  or \c 1 otherwise.
+ */
+int BenchmarkRunner::run()
+{
+  bool completed = true;
+  QJsonArray fixtures;
+  for (const BenchmarkFixture::Size& size : qAsConst(m_sizes))
+  {
+    QJsonObject summary;
+    completed = runFixture(size, summary) && completed;
+    fixtures.append(summary);
+  }
+
+  QTextStream out(stdout);
+  if (!m_outputPath.isEmpty())
+  {
+    QJsonObject results;
+    results.insert(QStringLiteral("fixtures"), fixtures);
+
+    bool written = false;
+    QSaveFile outputFile(m_outputPath);
+    if (outputFile.open(QIODevice::WriteOnly))
+    {
+      outputFile.write(QJsonDocument(results).toJson());
+      written = outputFile.commit();
+    }
+
+    if (!written)
+      out << "Failed to write results to " << m_outputPath << "\n";
+  }
+
+  const int regressions = m_baselinePath.isEmpty() ? 0 : compareWithBaseline(fixtures);
+  return completed && regressions == 0 ? 0 : 1;
+}
+
+/*!
+  \internal
+
+  Runs the fixture of the given \a size, writing its results to \a summary.
+
+  Returns \c false if any of the runs failed or timed out.
+ */
+bool BenchmarkRunner::runFixture(const BenchmarkFixture::Size& size, QJsonObject& summary)
+{
+  QTextStream out(stdout);
+  out << size.m_name << ": " << size.m_layerCount << " layers, " << size.m_conditionCount << " conditions" << endl;
+
+  summary.insert(QStringLiteral("name"), size.m_name);
+  summary.insert(QStringLiteral("layers"), size.m_layerCount);
+  summary.insert(QStringLiteral("conditions"), size.m_conditionCount);
+  summary.insert(QStringLiteral("iterations"), m_iterations);
+
+  const QString fixturePath = QDir(m_workPath).filePath(size.m_name);
+  const QString dataPath = DsaUtility::dataPath();
+
+  QStringList phaseNames;
+  QHash<QString, QVector<double>> phaseTimes;
+  QHash<QString, double> phaseMemory;
+  int failedCount = 0;
+  for (int i = 0; i < m_iterations; ++i)
+  {
+    if (!BenchmarkFixture::write(fixturePath, size, dataPath, m_layerData))
+    {
+      out << "  failed to write the fixture to " << fixturePath << endl;
+      summary.insert(QStringLiteral("failed"), m_iterations);
+      return false;
+    }
+
+    const QJsonObject result = runOnce(fixturePath);
+    if (result.isEmpty() || result.value(QStringLiteral("timedOut")).toBool())
+    {
+      out << "  run " << (i + 1) << " did not complete";
+      if (!result.isEmpty())
+      {
+        out << " (" << result.value(QStringLiteral("restoredLayers")).toInt() << " layers and "
+            << result.value(QStringLiteral("restoredConditions")).toInt() << " conditions restored)";
+      }
+      out << endl;
+
+      ++failedCount;
+      continue;
+    }
+
+    const QJsonArray phases = result.value(QStringLiteral("phases")).toArray();
+    for (const QJsonValue& phaseValue : phases)
+    {
+      const QJsonObject phase = phaseValue.toObject();
+      const QString name = phase.value(QStringLiteral("name")).toString();
+      if (!phaseTimes.contains(name))
+        phaseNames.append(name);
+
+      phaseTimes[name].append(phase.value(QStringLiteral("milliseconds")).toDouble());
+      phaseMemory[name] = std::max(phaseMemory.value(name, -1.0), phase.value(QStringLiteral("residentMegabytes")).toDouble(-1.0));
+    }
+  }
+
+  QJsonObject phasesJson;
+  for (const QString& name : qAsConst(phaseNames))
+  {
+    const QVector<double>& times = phaseTimes[name];
+    const double medianTime = median(times);
+    const double minimumTime = *std::min_element(times.cbegin(), times.cend());
+    const double maximumTime = *std::max_element(times.cbegin(), times.cend());
+    const double memory = phaseMemory.value(name, -1.0);
+
+    QJsonObject phaseJson;
+    phaseJson.insert(QStringLiteral("milliseconds"), medianTime);
+    phaseJson.insert(QStringLiteral("minimum"), minimumTime);
+    phaseJson.insert(QStringLiteral("maximum"), maximumTime);
+    phaseJson.insert(QStringLiteral("residentMegabytes"), memory);
+    phasesJson.insert(name, phaseJson);
+
+    out << "  " << QString("%1").arg(name, -20)
+        << QString("%1 ms").arg(medianTime, 9, 'f', 1)
+        << QString("  (%1 - %2 ms)").arg(minimumTime, 0, 'f', 1).arg(maximumTime, 0, 'f', 1);
+    if (memory >= 0.0)
+      out << QString("  %1 MB").arg(memory, 0, 'f', 0);
+    out << endl;
+  }
+
+  summary.insert(QStringLiteral("failed"), failedCount);
+  summary.insert(QStringLiteral("phases"), phasesJson);
+  return failedCount == 0;
+}
+
+/*!
+  \internal
+
+  Runs the benchmark against the fixture at \a fixturePath in a new process.
+
+  Returns the result of the run, or an empty object if it failed.
+ */
+QJsonObject BenchmarkRunner::runOnce(const QString& fixturePath) const
+{
+  QStringList arguments{QStringLiteral("--run"), fixturePath,
+                        QStringLiteral("--timeout"), QString::number(m_timeout / 1000)};
+  if (m_warm)
+    arguments.append(QStringLiteral("--warm"));
+
+  QProcess process;
+  process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+  process.start(QCoreApplication::applicationFilePath(), arguments);
+  if (!process.waitForFinished(m_timeout + s_exitGrace))
+  {
+    process.kill();
+    process.waitForFinished();
+    return QJsonObject();
+  }
+
+  const QList<QByteArray> lines = process.readAllStandardOutput().split('\n');
+  const QByteArray prefix = StartupBenchmark::RESULT_PREFIX.toUtf8();
+  for (const QByteArray& line : lines)
+  {
+    if (line.startsWith(prefix))
+      return QJsonDocument::fromJson(line.mid(prefix.size())).object();
+  }
+
+  return QJsonObject();
+}
+
+/*!
+  \internal
+
+  Compares the results of the \a fixtures with the baseline, reporting each phase which
+  is slower than the baseline by more than the tolerance.
+
+  Returns the number of regressions.
+ */
+int BenchmarkRunner::compareWithBaseline(const QJsonArray& fixtures) const
+{
+  QTextStream out(stdout);
+
+  QFile baselineFile(m_baselinePath);
+  if (!baselineFile.open(QIODevice::ReadOnly))
+  {
+    out << "Failed to read the baseline " << m_baselinePath << endl;
+    return 1;
+  }
+
+  QHash<QString, QJsonObject> baselinePhases;
+  const QJsonArray baselineFixtures = QJsonDocument::fromJson(baselineFile.readAll()).object().value(QStringLiteral("fixtures")).toArray();
+  for (const QJsonValue& fixture : baselineFixtures)
+  {
+    const QJsonObject fixtureJson = fixture.toObject();
+    baselinePhases.insert(fixtureJson.value(QStringLiteral("name")).toString(), fixtureJson.value(QStringLiteral("phases")).toObject());
+  }
+
+  int regressions = 0;
+  for (const QJsonValue& fixture : fixtures)
+  {
+    const QJsonObject fixtureJson = fixture.toObject();
+    const QString fixtureName = fixtureJson.value(QStringLiteral("name")).toString();
+    const auto baselineIt = baselinePhases.constFind(fixtureName);
+    if (baselineIt == baselinePhases.constEnd())
+      continue;
+
+    const QJsonObject phases = fixtureJson.value(QStringLiteral("phases")).toObject();
+    for (auto it = baselineIt->constBegin(); it != baselineIt->constEnd(); ++it)
+    {
+      if (!phases.contains(it.key()))
+        continue;
+
+      const double baselineTime = it.value().toObject().value(QStringLiteral("milliseconds")).toDouble();
+      const double time = phases.value(it.key()).toObject().value(QStringLiteral("milliseconds")).toDouble();
+      if (time <= baselineTime * (1.0 + m_tolerance) || time - baselineTime <= s_noiseMilliseconds)
+        continue;
+
+      ++regressions;
+      out << "Regression in " << fixtureName << " " << it.key() << ": "
+          << QString::number(baselineTime, 'f', 1) << " ms -> " << QString::number(time, 'f', 1) << " ms" << endl;
+    }
+  }
+
+  if (regressions == 0)
+    out << "No regressions from " << m_baselinePath << endl;
+
+  return regressions;
+}
+
+} // Benchmark
+} // Dsa
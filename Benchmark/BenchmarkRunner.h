@@ -0,0 +1,70 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef BENCHMARKRUNNER_H
+#define BENCHMARKRUNNER_H
+
+// dsa app headers
+#include "BenchmarkFixture.h"
+
+// Qt headers
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+namespace Dsa {
+namespace Benchmark {
+
+class BenchmarkRunner
+{
+public:
+  BenchmarkRunner(const QString& workPath, const QList<BenchmarkFixture::Size>& sizes);
+  ~BenchmarkRunner();
+
+  void setLayerData(const QStringList& layerData);
+  void setIterations(int iterations);
+  void setTimeout(int timeout);
+  void setWarm(bool warm);
+  void setOutputPath(const QString& outputPath);
+  void setBaselinePath(const QString& baselinePath);
+  void setTolerance(double tolerance);
+
+  int run();
+
+private:
+  Q_DISABLE_COPY(BenchmarkRunner)
+
+  bool runFixture(const BenchmarkFixture::Size& size, QJsonObject& summary);
+  QJsonObject runOnce(const QString& fixturePath) const;
+  int compareWithBaseline(const QJsonArray& fixtures) const;
+
+  QString                         m_workPath;
+  QList<BenchmarkFixture::Size>   m_sizes;
+  QStringList                     m_layerData;
+  int                             m_iterations = 3;
+  int                             m_timeout = 120000;
+  bool                            m_warm = false;
+  QString                         m_outputPath;
+  QString                         m_baselinePath;
+  double                          m_tolerance = 0.2;
+};
+
+} // Benchmark
+} // Dsa
+
+#endif // BENCHMARKRUNNER_H
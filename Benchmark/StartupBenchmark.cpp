@@ -0,0 +1,274 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "StartupBenchmark.h"
+
+// dsa app headers
+#include "AddLocalDataController.h"
+#include "AlertConditionsController.h"
+#include "BenchmarkFixture.h"
+#include "DsaController.h"
+#include "LayerCacheManager.h"
+#include "LocationController.h"
+#include "MemoryBudget.h"
+#include "MessageFeedsController.h"
+#include "StartupProfiler.h"
+
+// toolkit headers
+#include "ToolManager.h"
+
+// C++ API headers
+#include "SceneQuickView.h"
+
+// Qt headers
+#include <QAbstractItemModel>
+#include <QDebug>
+#include <QTimer>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+namespace Benchmark {
+
+namespace {
+constexpr double s_nsecsPerMsec = 1000000.0;
+constexpr double s_bytesPerMegabyte = 1024.0 * 1024.0;
+}
+
+const QString StartupBenchmark::RESULT_PREFIX = QStringLiteral("DSA_BENCHMARK_RESULT ");
+
+/*!
+  \class Dsa::Benchmark::StartupBenchmark
+  \inmodule Dsa
+  \inherits QObject
+  \brief Starts the app against a single fixture and measures each phase of its startup.
+
+  The app is started as the headless gateway starts it, with a \c SceneQuickView
+  which is never shown. The phases measured are:
+
+  \list
+    \li \c settings - constructing the \l DsaController, which reads the fixture's settings.
+    \li \c init - \l DsaController::init, including the critical tools.
+    \li \c {layer cache manager} - configuring the \l LayerCacheManager, which requests
+        every saved layer.
+    \li \c {secondary tools} - configuring the remaining tools once control returns
+        to the event loop.
+    \li \c {message feeds} - configuring the \l MessageFeedsController, which sets up
+        the feeds.
+    \li \c {alert conditions} - configuring the \l AlertConditionsController.
+    \li \c {layer restore} - from the start of \c init until every saved layer has been
+        restored, or has failed to restore.
+    \li \c {condition restore} - from the start of \c init until every saved alert
+        condition has been added.
+  \endlist
+
+  Each phase records its wall time, and the resident memory of the app once it has
+  ended where that is known. The result is emitted by \l finished once both restores
+  have completed or the timeout has been reached.
+ */
+
+/*!
+  \brief Constructor for the benchmark of the fixture at \a fixturePath, which gives up
+  after \a timeout milliseconds, taking an optional \a parent.
+ */
+StartupBenchmark::StartupBenchmark(const QString& fixturePath, int timeout, QObject* parent /* = nullptr */):
+  QObject(parent),
+  m_fixturePath(fixturePath),
+  m_timeout(timeout),
+  m_layerCount(BenchmarkFixture::layerCount(fixturePath)),
+  m_conditionCount(BenchmarkFixture::conditionCount(fixturePath))
+{
+}
+
+/*!
+  \brief Destructor.
+ */
+StartupBenchmark::~StartupBenchmark()
+{
+  delete m_sceneView;
+}
+
+/*!
+  \brief Starts the app against the fixture.
+
+  The fixture must have been made the app's data path, for example with the
+  \c DSA_DATA_PATH environment variable, before this is called.
+ */
+void StartupBenchmark::start()
+{
+  m_clock.start();
+
+  const qint64 settingsStart = elapsed();
+  m_controller = new DsaController(this);
+  recordPhase(QStringLiteral("settings"), settingsStart, elapsed() - settingsStart);
+
+  connect(m_controller, &DsaController::errorOccurred, this, [](const QString& message, const QString& additionalMessage)
+  {
+    qWarning() << message << additionalMessage;
+  });
+
+  m_sceneView = new SceneQuickView();
+
+  // the layers are restored through the local data tool, which the apps create before init
+  new AddLocalDataController(this);
+
+  m_initStart = elapsed();
+  m_controller->init(m_sceneView);
+  recordPhase(QStringLiteral("init"), m_initStart, elapsed() - m_initStart);
+  recordToolPhase(QStringLiteral("layer cache manager"), ToolManager::instance().tool<LayerCacheManager>());
+
+  m_cacheManager = ToolManager::instance().tool<LayerCacheManager>();
+  if (m_cacheManager)
+  {
+    connect(m_cacheManager, &LayerCacheManager::restoreCompleted, this, &StartupBenchmark::checkRestored);
+    connect(m_cacheManager, &LayerCacheManager::restoreProgressChanged, this, &StartupBenchmark::checkRestored);
+  }
+
+  // the tools which need the feeds and conditions, created once init has returned as in the gateway
+  new LocationController(this);
+  auto messageFeeds = new MessageFeedsController(this);
+  m_conditionsController = new AlertConditionsController(this);
+
+  QAbstractItemModel* conditions = m_conditionsController->conditionsList();
+  connect(conditions, &QAbstractItemModel::rowsInserted, this, &StartupBenchmark::checkRestored);
+  connect(conditions, &QAbstractItemModel::modelReset, this, &StartupBenchmark::checkRestored);
+
+  // queued behind the controller's configuration of the secondary tools
+  const qint64 toolsStart = elapsed();
+  QTimer::singleShot(0, this, [this, toolsStart, messageFeeds]()
+  {
+    recordPhase(QStringLiteral("secondary tools"), toolsStart, elapsed() - toolsStart);
+    recordToolPhase(QStringLiteral("message feeds"), messageFeeds);
+    recordToolPhase(QStringLiteral("alert conditions"), m_conditionsController);
+
+    m_toolsConfigured = true;
+    checkRestored();
+  });
+
+  QTimer::singleShot(m_timeout, this, [this]()
+  {
+    finish(true);
+  });
+}
+
+/*!
+  \internal
+
+  Returns the time in microseconds since the benchmark started.
+ */
+qint64 StartupBenchmark::elapsed() const
+{
+  return m_clock.nsecsElapsed() / 1000;
+}
+
+/*!
+  \internal
+ */
+void StartupBenchmark::recordPhase(const QString& name, qint64 start, qint64 duration, bool recordMemory /* = true */)
+{
+  QJsonObject phase;
+  phase.insert(QStringLiteral("name"), name);
+  phase.insert(QStringLiteral("start"), start * 1000 / s_nsecsPerMsec);
+  phase.insert(QStringLiteral("milliseconds"), duration * 1000 / s_nsecsPerMsec);
+
+  const qint64 memory = recordMemory ? MemoryBudget::residentMemory() : -1;
+  phase.insert(QStringLiteral("residentMegabytes"), memory < 0 ? -1.0 : memory / s_bytesPerMegabyte);
+
+  m_phases.append(phase);
+}
+
+/*!
+  \internal
+
+  Records the time the controller spent configuring \a tool, as measured by the
+  \l StartupProfiler, as the phase called \a name.
+ */
+void StartupBenchmark::recordToolPhase(const QString& name, AbstractTool* tool)
+{
+  if (!tool)
+    return;
+
+  const qint64 duration = StartupProfiler::instance()->phaseDuration(QString("tool: %1").arg(tool->toolName()));
+  if (duration >= 0)
+    recordPhase(name, -1, duration, false);
+}
+
+/*!
+  \internal
+ */
+void StartupBenchmark::checkRestored()
+{
+  if (m_finished || m_initStart < 0)
+    return;
+
+  if (m_layersRestored < 0 && (!m_cacheManager || !m_cacheManager->isRestoring()))
+    m_layersRestored = elapsed();
+
+  if (m_conditionsRestored < 0 && m_conditionsController &&
+      m_conditionsController->conditionsList()->rowCount() >= m_conditionCount)
+  {
+    m_conditionsRestored = elapsed();
+  }
+
+  if (m_toolsConfigured && m_layersRestored >= 0 && m_conditionsRestored >= 0)
+    finish(false);
+}
+
+/*!
+  \internal
+ */
+void StartupBenchmark::finish(bool timedOut)
+{
+  if (m_finished)
+    return;
+
+  m_finished = true;
+
+  if (m_layersRestored >= 0)
+    recordPhase(QStringLiteral("layer restore"), m_initStart, m_layersRestored - m_initStart);
+
+  if (m_conditionsRestored >= 0)
+    recordPhase(QStringLiteral("condition restore"), m_initStart, m_conditionsRestored - m_initStart);
+
+  recordPhase(QStringLiteral("total"), 0, elapsed());
+
+  QJsonObject result;
+  result.insert(QStringLiteral("fixture"), m_fixturePath);
+  result.insert(QStringLiteral("layers"), m_layerCount);
+  result.insert(QStringLiteral("restoredLayers"), m_cacheManager ? m_cacheManager->restoredLayerCount() : 0);
+  result.insert(QStringLiteral("conditions"), m_conditionCount);
+  result.insert(QStringLiteral("restoredConditions"), m_conditionsController ? m_conditionsController->conditionsList()->rowCount() : 0);
+  result.insert(QStringLiteral("timedOut"), timedOut);
+  result.insert(QStringLiteral("phases"), m_phases);
+
+  emit finished(result);
+}
+
+} // Benchmark
+} // Dsa
+
+// Signal Documentation
+/*!
+  \fn void StartupBenchmark::finished(const QJsonObject& result);
+  \brief Signal emitted when the benchmark has finished, with its \a result.
+
+  The \a result holds the counts of saved and restored layers and conditions, whether
+  the benchmark \c timedOut, and its \c phases, each with its \c name, \c start and
+  \c milliseconds and the \c residentMegabytes once it ended, or \c -1.
+ */
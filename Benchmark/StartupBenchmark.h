@@ -0,0 +1,85 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef STARTUPBENCHMARK_H
+#define STARTUPBENCHMARK_H
+
+// Qt headers
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QObject>
+
+namespace Esri {
+namespace ArcGISRuntime {
+class SceneQuickView;
+}
+}
+
+namespace Dsa {
+
+class AbstractTool;
+class AlertConditionsController;
+class DsaController;
+class LayerCacheManager;
+
+namespace Benchmark {
+
+class StartupBenchmark : public QObject
+{
+  Q_OBJECT
+
+public:
+  StartupBenchmark(const QString& fixturePath, int timeout, QObject* parent = nullptr);
+  ~StartupBenchmark();
+
+  static const QString RESULT_PREFIX;
+
+  void start();
+
+signals:
+  void finished(const QJsonObject& result);
+
+private:
+  Q_DISABLE_COPY(StartupBenchmark)
+
+  qint64 elapsed() const;
+  void recordPhase(const QString& name, qint64 start, qint64 duration, bool recordMemory = true);
+  void recordToolPhase(const QString& name, AbstractTool* tool);
+  void checkRestored();
+  void finish(bool timedOut);
+
+  QString                                 m_fixturePath;
+  int                                     m_timeout = 0;
+  int                                     m_layerCount = 0;
+  int                                     m_conditionCount = 0;
+  QElapsedTimer                           m_clock;
+  qint64                                  m_initStart = -1;
+  qint64                                  m_layersRestored = -1;
+  qint64                                  m_conditionsRestored = -1;
+  bool                                    m_toolsConfigured = false;
+  bool                                    m_finished = false;
+  QJsonArray                              m_phases;
+  Esri::ArcGISRuntime::SceneQuickView*    m_sceneView = nullptr;
+  DsaController*                          m_controller = nullptr;
+  LayerCacheManager*                      m_cacheManager = nullptr;
+  AlertConditionsController*              m_conditionsController = nullptr;
+};
+
+} // Benchmark
+} // Dsa
+
+#endif // STARTUPBENCHMARK_H
@@ -0,0 +1,229 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+// dsa app headers
+#include "AnalysisBenchmark.h"
+#include "AppInfo.h"
+#include "BenchmarkFixture.h"
+#include "BenchmarkRunner.h"
+#include "DsaUtility.h"
+#include "StartupBenchmark.h"
+
+// Qt headers
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QGuiApplication>
+#include <QJsonDocument>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QTextStream>
+#include <QTimer>
+
+// STL headers
+#include <algorithm>
+#include <cstring>
+
+//------------------------------------------------------------------------------
+
+#define kSettingsFormat                 QSettings::IniFormat
+
+//------------------------------------------------------------------------------
+
+using namespace Dsa::Benchmark;
+
+namespace {
+
+void setApplicationInfo()
+{
+  QCoreApplication::setApplicationName(kApplicationName);
+  QCoreApplication::setApplicationVersion(kApplicationVersion);
+  QCoreApplication::setOrganizationName(kOrganizationName);
+#ifdef Q_OS_MAC
+  QCoreApplication::setOrganizationDomain(kOrganizationName);
+#else
+  QCoreApplication::setOrganizationDomain(kOrganizationDomain);
+#endif
+  QSettings::setDefaultFormat(kSettingsFormat);
+}
+
+// starts the app once against the fixture given by \c --run, writing the result to stdout
+int runFixture(int argc, char* argv[])
+{
+  // the app is never shown, so unless told otherwise it uses the offscreen platform
+  if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+
+  QGuiApplication app(argc, argv);
+  setApplicationInfo();
+
+  QCommandLineParser parser;
+  const QCommandLineOption runOption("run", "", "directory");
+  const QCommandLineOption timeoutOption("timeout", "", "seconds", "120");
+  const QCommandLineOption warmOption("warm", "");
+  parser.addOptions({runOption, timeoutOption, warmOption});
+  parser.process(app);
+
+  // the fixture is the app's data path, so its settings are the ones read
+  const QString fixturePath = QDir(parser.value(runOption)).absolutePath();
+  qputenv("DSA_DATA_PATH", fixturePath.toLocal8Bit());
+
+  // a cold start has none of the caches written by earlier runs
+  if (!parser.isSet(warmOption))
+    QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).removeRecursively();
+
+  StartupBenchmark benchmark(fixturePath, std::max(1, parser.value(timeoutOption).toInt()) * 1000);
+  QObject::connect(&benchmark, &StartupBenchmark::finished, &app, [](const QJsonObject& result)
+  {
+    QTextStream(stdout) << StartupBenchmark::RESULT_PREFIX << QJsonDocument(result).toJson(QJsonDocument::Compact) << endl;
+    QCoreApplication::exit(result.value(QStringLiteral("timedOut")).toBool() ? 2 : 0);
+  });
+
+  QTimer::singleShot(0, &benchmark, &StartupBenchmark::start);
+
+  return app.exec();
+}
+
+// benchmarks the analyses given by \c --analysis in a window, writing the result to stdout
+int runAnalysis(int argc, char* argv[])
+{
+  QGuiApplication app(argc, argv);
+  setApplicationInfo();
+
+  QCommandLineParser parser;
+  const QCommandLineOption analysisOption("analysis", "");
+  const QCommandLineOption countsOption("counts", "", "counts", "1,5,10,25,50");
+  const QCommandLineOption sampleOption("sample", "", "seconds", "5");
+  const QCommandLineOption workOption({"w", "work"}, "", "directory");
+  const QCommandLineOption outputOption({"o", "output"}, "", "file");
+  const QCommandLineOption timeoutOption({"t", "timeout"}, "", "seconds", "900");
+  parser.addOptions({analysisOption, countsOption, sampleOption, workOption, outputOption, timeoutOption});
+  parser.process(app);
+
+  QList<int> counts;
+  for (const QString& count : parser.value(countsOption).split(',', QString::SkipEmptyParts))
+  {
+    if (count.toInt() > 0)
+      counts.append(count.toInt());
+  }
+
+  // the fixture has no layers or conditions, so that only the analyses are drawn
+  const QString workPath = parser.isSet(workOption) ? parser.value(workOption)
+                                                    : QDir::temp().filePath(QStringLiteral("dsa-benchmark"));
+  const QString fixturePath = QDir(workPath).absoluteFilePath(QStringLiteral("analysis"));
+  if (!BenchmarkFixture::write(fixturePath, BenchmarkFixture::Size{QStringLiteral("analysis"), 0, 0}, Dsa::DsaUtility::dataPath(), QStringList()))
+  {
+    qWarning() << "Failed to write the fixture" << fixturePath;
+    return 1;
+  }
+
+  qputenv("DSA_DATA_PATH", fixturePath.toLocal8Bit());
+
+  const QString outputPath = parser.value(outputOption);
+  AnalysisBenchmark benchmark(fixturePath, counts, std::max(1, parser.value(sampleOption).toInt()) * 1000,
+                              std::max(1, parser.value(timeoutOption).toInt()) * 1000);
+  QObject::connect(&benchmark, &AnalysisBenchmark::finished, &app, [outputPath](const QJsonObject& result)
+  {
+    const QByteArray json = QJsonDocument(result).toJson(QJsonDocument::Compact);
+    QTextStream(stdout) << AnalysisBenchmark::RESULT_PREFIX << json << endl;
+
+    if (!outputPath.isEmpty())
+    {
+      QFile outputFile(outputPath);
+      if (outputFile.open(QIODevice::WriteOnly))
+        outputFile.write(QJsonDocument(result).toJson());
+      else
+        qWarning() << "Failed to write" << outputPath;
+    }
+
+    QCoreApplication::exit(result.value(QStringLiteral("timedOut")).toBool() ? 2 : 0);
+  });
+
+  QTimer::singleShot(0, &benchmark, &AnalysisBenchmark::start);
+
+  return app.exec();
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+  // each run is a separate process started by the runner
+  for (int i = 1; i < argc; ++i)
+  {
+    if (!strcmp(argv[i], "--run"))
+      return runFixture(argc, argv);
+
+    // the analyses are only computed as the scene is drawn, so they are benchmarked in a window
+    if (!strcmp(argv[i], "--analysis"))
+      return runAnalysis(argc, argv);
+  }
+
+  QCoreApplication app(argc, argv);
+  setApplicationInfo();
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription(kApplicationDescription);
+  parser.addHelpOption();
+
+  const QCommandLineOption fixtureOption({"f", "fixture"}, "Benchmark only the named fixture: empty, small, medium or large. Repeatable.", "name");
+  const QCommandLineOption iterationsOption({"n", "iterations"}, "Number of runs of each fixture; default is 3.", "count", "3");
+  const QCommandLineOption layerDataOption({"l", "layer-data"}, "Data file used for the saved layers instead of generated markups. Repeatable.", "file");
+  const QCommandLineOption workOption({"w", "work"}, "Directory the fixtures are written to; default is a temporary directory.", "directory");
+  const QCommandLineOption outputOption({"o", "output"}, "Write the results as JSON to the file.", "file");
+  const QCommandLineOption baselineOption({"b", "baseline"}, "Compare the results with those written by an earlier run, failing on regressions.", "file");
+  const QCommandLineOption toleranceOption("tolerance", "Percentage a phase may be slower than the baseline; default is 20.", "percent", "20");
+  const QCommandLineOption timeoutOption({"t", "timeout"}, "Seconds to wait for the layers and conditions to be restored; default is 120.", "seconds", "120");
+  const QCommandLineOption warmOption("warm", "Keep the caches of earlier runs instead of starting cold.");
+  const QCommandLineOption analysisOption("analysis", "Benchmark the viewshed and line of sight analyses in a window instead of startup.");
+  const QCommandLineOption countsOption("counts", "With --analysis, the numbers of analyses benchmarked; default is 1,5,10,25,50.", "counts", "1,5,10,25,50");
+  const QCommandLineOption sampleOption("sample", "With --analysis, seconds the frames are sampled for each number; default is 5.", "seconds", "5");
+  parser.addOptions({fixtureOption, iterationsOption, layerDataOption, workOption, outputOption, baselineOption,
+                     toleranceOption, timeoutOption, warmOption, analysisOption, countsOption, sampleOption});
+  parser.process(app);
+
+  QList<BenchmarkFixture::Size> sizes = BenchmarkFixture::standardSizes();
+  const QStringList fixtureNames = parser.values(fixtureOption);
+  if (!fixtureNames.isEmpty())
+  {
+    sizes.erase(std::remove_if(sizes.begin(), sizes.end(), [&fixtureNames](const BenchmarkFixture::Size& size)
+    {
+      return !fixtureNames.contains(size.m_name);
+    }), sizes.end());
+  }
+
+  const QString workPath = parser.isSet(workOption) ? parser.value(workOption)
+                                                    : QDir::temp().filePath(QStringLiteral("dsa-benchmark"));
+
+  BenchmarkRunner runner(workPath, sizes);
+  runner.setIterations(parser.value(iterationsOption).toInt());
+  QStringList layerData;
+  for (const QString& layerFile : parser.values(layerDataOption))
+    layerData.append(QFileInfo(layerFile).absoluteFilePath());
+  runner.setLayerData(layerData);
+  runner.setTimeout(std::max(1, parser.value(timeoutOption).toInt()) * 1000);
+  runner.setWarm(parser.isSet(warmOption));
+  runner.setOutputPath(parser.value(outputOption));
+  runner.setBaselinePath(parser.value(baselineOption));
+  runner.setTolerance(parser.value(toleranceOption).toDouble() / 100.0);
+
+  return runner.run();
+}
@@ -28,5 +28,7 @@ SUBDIRS += \
 
 !android:!ios {
 SUBDIRS += \
-  MessageSimulator
+  MessageSimulator \
+  Gateway \
+  Benchmark
 }
@@ -0,0 +1,29 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef __APPINFO__
+#define __APPINFO__
+//------------------------------------------------------------------------------
+
+#define kOrganizationName               "Esri"
+#define kOrganizationDomain             "esri.com"
+
+#define kApplicationName                "DSA_Gateway_Qt"
+#define kApplicationVersion             "1.1.6"
+#define kApplicationDescription         "Dynamic Situational Awareness - headless Gateway app"
+
+//------------------------------------------------------------------------------
+#endif
@@ -0,0 +1,95 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "Gateway.h"
+
+// dsa app headers
+#include "AlertConditionsController.h"
+#include "AlertListController.h"
+#include "AlertStateBroadcast.h"
+#include "DsaController.h"
+#include "LocationController.h"
+#include "MessageFeedsController.h"
+
+// toolkit headers
+#include "ToolResourceProvider.h"
+
+// C++ API headers
+#include "MapQuickView.h"
+
+// Qt headers
+#include <QCoreApplication>
+#include <QDebug>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+namespace Gateway {
+
+/*!
+  \class Dsa::Gateway::Gateway
+  \inmodule Dsa
+  \inherits QObject
+  \brief The headless app, which ingests the message feeds and evaluates the
+  alert conditions without rendering anything.
+
+  The tools find their overlays and the current map through a \c GeoView, so the
+  gateway gives them a \c MapQuickView which is never added to a window and
+  therefore never draws. The alert states are published by an
+  \l AlertStateBroadcast, for the devices which rely on the gateway.
+ */
+
+/*!
+  \brief Constructor taking an optional \a parent.
+ */
+Gateway::Gateway(QObject* parent /* = nullptr */):
+  QObject(parent),
+  m_mapView(new MapQuickView()),
+  m_controller(new DsaController(this))
+{
+  connect(m_controller, &DsaController::errorOccurred, this, [](const QString& message, const QString& additionalMessage)
+  {
+    qWarning() << message << additionalMessage;
+  });
+
+  connect(ToolResourceProvider::instance(), &ToolResourceProvider::mapChanged, this, [this]()
+  {
+    m_mapView->setMap(m_controller->map());
+  });
+
+  m_controller->init(m_mapView);
+
+  // the tools which ingest the feeds, track the location and evaluate the alerts
+  new LocationController(this);
+  new MessageFeedsController(this);
+  new AlertConditionsController(this);
+  new AlertListController(this);
+  new AlertStateBroadcast(this);
+}
+
+/*!
+  \brief Destructor.
+ */
+Gateway::~Gateway()
+{
+  delete m_mapView;
+}
+
+} // Gateway
+} // Dsa
@@ -0,0 +1,53 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef GATEWAY_H
+#define GATEWAY_H
+
+// Qt headers
+#include <QObject>
+
+namespace Esri {
+namespace ArcGISRuntime {
+class MapQuickView;
+}
+}
+
+namespace Dsa {
+
+class DsaController;
+
+namespace Gateway {
+
+class Gateway : public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit Gateway(QObject* parent = nullptr);
+  ~Gateway();
+
+private:
+  Q_DISABLE_COPY(Gateway)
+
+  Esri::ArcGISRuntime::MapQuickView*      m_mapView = nullptr;
+  DsaController*                          m_controller = nullptr;
+};
+
+} // Gateway
+} // Dsa
+
+#endif // GATEWAY_H
@@ -0,0 +1,55 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+// dsa app headers
+#include "AppInfo.h"
+#include "Gateway.h"
+
+// Qt headers
+#include <QGuiApplication>
+#include <QSettings>
+
+//------------------------------------------------------------------------------
+
+#define kSettingsFormat                 QSettings::IniFormat
+
+//------------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+  // the gateway has no display, so unless told otherwise it uses the offscreen platform
+  if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+
+  QGuiApplication app(argc, argv);
+
+  QCoreApplication::setApplicationName(kApplicationName);
+  QCoreApplication::setApplicationVersion(kApplicationVersion);
+  QCoreApplication::setOrganizationName(kOrganizationName);
+#ifdef Q_OS_MAC
+  QCoreApplication::setOrganizationDomain(kOrganizationName);
+#else
+  QCoreApplication::setOrganizationDomain(kOrganizationDomain);
+#endif
+  QSettings::setDefaultFormat(kSettingsFormat);
+
+  Dsa::Gateway::Gateway gateway;
+
+  return app.exec();
+}
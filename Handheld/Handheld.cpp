@@ -27,6 +27,7 @@
 #include "ToolResourceProvider.h"
 
 // C++ API headers
+#include "MapQuickView.h"
 #include "SceneQuickView.h"
 
 using namespace Esri::ArcGISRuntime;
@@ -49,16 +50,12 @@ Handheld::~Handheld()
 
 
 /*!
-   \brief Apply scene to the SceneView.
+   \brief Apply the scene to the SceneView, or the map to the MapView in 2D mode.
  */
 void Handheld::componentComplete()
 {
   QQuickItem::componentComplete();
 
-  // find QML SceneView component
-  m_sceneView = findChild<SceneQuickView*>("sceneView");
-  connect(m_sceneView, &SceneQuickView::errorOccurred, m_controller, &DsaController::onError);
-
   // connect to the DSA controller errors
   connect(m_controller, &DsaController::errorOccurred, this, [this]
           (const QString& message, const QString& additionalMessage)
@@ -66,50 +63,89 @@ void Handheld::componentComplete()
     emit errorOccurred(message, additionalMessage);
   });
 
+  // find QML MapView component when running in 2D
+  m_mapView = findChild<MapQuickView*>("mapView");
+  if (m_mapView)
+  {
+    connect(ToolResourceProvider::instance(), &ToolResourceProvider::mapChanged, this, [this]()
+    {
+      m_mapView->setMap(m_controller->map());
+    });
+
+    m_controller->init(m_mapView);
+    connectGeoView(m_mapView);
+    return;
+  }
+
+  // find QML SceneView component
+  m_sceneView = findChild<SceneQuickView*>("sceneView");
+
   connect(ToolResourceProvider::instance(), &ToolResourceProvider::sceneChanged, this, [this]()
   {
     m_sceneView->setArcGISScene(m_controller->scene());
   });
 
   m_controller->init(m_sceneView);
+  connectGeoView(m_sceneView);
 
-  // setup the connections from the view to the resource provider
-  connect(m_sceneView, &SceneQuickView::spatialReferenceChanged,
+  connect(m_sceneView, &SceneQuickView::screenToLocationCompleted,
+          ToolResourceProvider::instance(), &ToolResourceProvider::onScreenToLocationCompleted);
+}
+
+/*!
+   \brief Returns whether the app shows a 2D MapView rather than a 3D SceneView.
+
+   This is read by the QML to choose which view to create.
+ */
+bool Handheld::isMapViewMode() const
+{
+  return m_controller->isMapViewMode();
+}
+
+/*!
+   \internal
+
+   Sets up the connections from \a geoView, which is either the SceneView or the MapView,
+   to the resource provider.
+ */
+template <typename ViewType>
+void Handheld::connectGeoView(ViewType* geoView)
+{
+  connect(geoView, &ViewType::errorOccurred, m_controller, &DsaController::onError);
+
+  connect(geoView, &ViewType::spatialReferenceChanged,
           ToolResourceProvider::instance(), &ToolResourceProvider::spatialReferenceChanged);
 
-  connect(m_sceneView, &SceneQuickView::mouseClicked,
+  connect(geoView, &ViewType::mouseClicked,
           ToolResourceProvider::instance(), &ToolResourceProvider::onMouseClicked);
 
-  connect(m_sceneView, &SceneQuickView::mousePressed,
+  connect(geoView, &ViewType::mousePressed,
           ToolResourceProvider::instance(), &ToolResourceProvider::onMousePressed);
 
-  connect(m_sceneView, &SceneQuickView::mouseMoved,
+  connect(geoView, &ViewType::mouseMoved,
           ToolResourceProvider::instance(), &ToolResourceProvider::onMouseMoved);
 
-  connect(m_sceneView, &SceneQuickView::mouseReleased,
+  connect(geoView, &ViewType::mouseReleased,
           ToolResourceProvider::instance(), &ToolResourceProvider::onMouseReleased);
 
-  connect(m_sceneView, &SceneQuickView::mousePressedAndHeld,
+  connect(geoView, &ViewType::mousePressedAndHeld,
           ToolResourceProvider::instance(), &ToolResourceProvider::onMousePressedAndHeld);
 
-  connect(m_sceneView, &SceneQuickView::identifyGraphicsOverlayCompleted,
+  connect(geoView, &ViewType::identifyGraphicsOverlayCompleted,
           ToolResourceProvider::instance(), &ToolResourceProvider::onIdentifyGraphicsOverlayCompleted);
 
-  connect(m_sceneView, &SceneQuickView::identifyGraphicsOverlaysCompleted,
+  connect(geoView, &ViewType::identifyGraphicsOverlaysCompleted,
           ToolResourceProvider::instance(), &ToolResourceProvider::onIdentifyGraphicsOverlaysCompleted);
 
-  connect(m_sceneView, &SceneQuickView::identifyLayerCompleted,
+  connect(geoView, &ViewType::identifyLayerCompleted,
           ToolResourceProvider::instance(), &ToolResourceProvider::onIdentifyLayerCompleted);
 
-  connect(m_sceneView, &SceneQuickView::identifyLayersCompleted,
+  connect(geoView, &ViewType::identifyLayersCompleted,
           ToolResourceProvider::instance(), &ToolResourceProvider::onIdentifyLayersCompleted);
 
-  connect(m_sceneView, &SceneQuickView::screenToLocationCompleted,
-          ToolResourceProvider::instance(), &ToolResourceProvider::onScreenToLocationCompleted);
-
-  connect(ToolResourceProvider::instance(), &ToolResourceProvider::setMouseCursorRequested, this, [this](const QCursor& mouseCursor)
+  connect(ToolResourceProvider::instance(), &ToolResourceProvider::setMouseCursorRequested, this, [geoView](const QCursor& mouseCursor)
   {
-    m_sceneView->setCursor(mouseCursor);
+    geoView->setCursor(mouseCursor);
   });
 }
 
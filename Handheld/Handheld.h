@@ -22,6 +22,7 @@
 
 namespace Esri {
 namespace ArcGISRuntime {
+class MapQuickView;
 class SceneQuickView;
 }
 }
@@ -36,6 +37,8 @@ class Handheld : public QQuickItem
 {
   Q_OBJECT
 
+  Q_PROPERTY(bool mapViewMode READ isMapViewMode CONSTANT)
+
 public:
   Handheld(QQuickItem* parent = nullptr);
   ~Handheld();
@@ -43,11 +46,17 @@ public:
   void componentComplete() override;
   Q_INVOKABLE void resetToDefaultScene();
 
+  bool isMapViewMode() const;
+
 signals:
   void errorOccurred(const QString& message, const QString& additionalMessage);
 
 private:
+  template <typename ViewType>
+  void connectGeoView(ViewType* geoView);
+
   Esri::ArcGISRuntime::SceneQuickView*    m_sceneView = nullptr;
+  Esri::ArcGISRuntime::MapQuickView*      m_mapView = nullptr;
   DsaController*                          m_controller = nullptr;
 };
 
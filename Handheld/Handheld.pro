@@ -66,6 +66,9 @@ RESOURCES += \
   CONFIG += precompile_header
 }
 
+# qmake CONFIG+=dsa_unity compiles the Shared sources in batches
+include($$PWD/../Shared/build/unity.pri)
+
 #-------------------------------------------------------------------------------
 
 QML_IMPORT_PATH += $$PWD/../Shared/qml
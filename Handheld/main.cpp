@@ -32,6 +32,7 @@
 #include "Handheld.h"
 #include "HandheldStyles.h"
 #include "IdentifyController.h"
+#include "InteractionBenchmark.h"
 #include "LineOfSightController.h"
 #include "LocationController.h"
 #include "LocationTextController.h"
@@ -40,6 +41,8 @@
 #include "NavigationController.h"
 #include "OpenMobileScenePackageController.h"
 #include "OptionsController.h"
+#include "MemoryBudget.h"
+#include "PerformanceMonitor.h"
 #include "RuntimePermissionRequest.h"
 #include "TableOfContentsController.h"
 #include "ViewedAlertsController.h"
@@ -52,18 +55,24 @@
 
 // C++ API headers
 #include "ArcGISRuntimeEnvironment.h"
+#include "MapQuickView.h"
 #include "PopupManager.h"
 #include "SceneQuickView.h"
 
 // Qt headers
 #include <QCommandLineParser>
+#include <QDebug>
 #include <QDir>
+#include <QFile>
 #include <QGuiApplication>
+#include <QJsonDocument>
 #include <QMessageBox>
 #include <QObject>
 #include <QQmlEngine>
 #include <QQuickView>
 #include <QSettings>
+#include <QTextStream>
+#include <QTimer>
 
 #ifdef Q_OS_WIN
 #include <Windows.h>
@@ -84,6 +93,20 @@
 #define kShowMinimized                  "minimized"
 #define kShowFullScreen                 "fullscreen"
 #define kShowNormal                     "normal"
+
+#define kArgFileValueName               "file"
+#define kArgRecordInputName             "record-input"
+#define kArgRecordInputDescription      "Record the mouse input of the session to a file, for the interaction benchmark"
+#define kArgBenchmarkInputName          "benchmark-input"
+#define kArgBenchmarkInputDescription   "Replay the mouse input recorded in a file, measuring the response and frame times, then quit"
+#define kArgBenchmarkFeedName           "benchmark-feed"
+#define kArgBenchmarkFeedDescription    "Replay a message feed capture file to the feed ports with the recorded input"
+#define kArgBenchmarkOutputName         "benchmark-output"
+#define kArgBenchmarkOutputDescription  "Write the benchmark results as JSON to a file"
+#define kArgBenchmarkDelayName          "benchmark-delay"
+#define kArgBenchmarkDelayValueName     "seconds"
+#define kArgBenchmarkDelayDescription   "Seconds to wait for the app to load before replaying; default is 10"
+#define kArgBenchmarkDelayDefault       "10"
 #define STRINGIZE(x) #x
 #define QUOTE(x) STRINGIZE(x)
 
@@ -93,6 +116,8 @@ using namespace Esri::ArcGISRuntime;
 
 QObject* dsaStylesProvider(QQmlEngine* engine, QJSEngine* scriptEngine);
 QObject* dsaResourcesProvider(QQmlEngine* engine, QJSEngine* scriptEngine);
+QObject* performanceMonitorProvider(QQmlEngine* engine, QJSEngine* scriptEngine);
+QObject* memoryBudgetProvider(QQmlEngine* engine, QJSEngine* scriptEngine);
 
 int main(int argc, char *argv[])
 {
@@ -120,6 +145,7 @@ int main(int argc, char *argv[])
 
   // Register the map view for QML
   qmlRegisterType<SceneQuickView>("Esri.ArcGISRuntime.OpenSourceApps.Handheld", 1, 1, "SceneView");
+  qmlRegisterType<MapQuickView>("Esri.ArcGISRuntime.OpenSourceApps.Handheld", 1, 1, "MapView");
   qRegisterMetaType<PopupManager*>("PopupManager*");
 
   // Register the Handheld (QQuickItem) for QML
@@ -136,6 +162,8 @@ int main(int argc, char *argv[])
   qmlRegisterType<Dsa::OptionsController>("Esri.ArcGISRuntime.OpenSourceApps.DSA", 1, 1, "OptionsController");
   qmlRegisterSingletonType<Dsa::Handheld::HandheldStyles>("Esri.ArcGISRuntime.OpenSourceApps.DSA", 1, 1, "DsaStyles", &dsaStylesProvider);
   qmlRegisterSingletonType<Dsa::DsaResources>("Esri.ArcGISRuntime.OpenSourceApps.DSA", 1, 1, "DsaResources", &dsaResourcesProvider);
+  qmlRegisterSingletonType<Dsa::PerformanceMonitor>("Esri.ArcGISRuntime.OpenSourceApps.DSA", 1, 1, "PerformanceMonitor", &performanceMonitorProvider);
+  qmlRegisterSingletonType<Dsa::MemoryBudget>("Esri.ArcGISRuntime.OpenSourceApps.DSA", 1, 1, "MemoryBudget", &memoryBudgetProvider);
   qmlRegisterType<Dsa::IdentifyController>("Esri.ArcGISRuntime.OpenSourceApps.DSA", 1, 1, "IdentifyController");
   qmlRegisterType<Dsa::AlertListController>("Esri.ArcGISRuntime.OpenSourceApps.DSA", 1, 1, "AlertListController");
   qmlRegisterType<Dsa::ViewedAlertsController>("Esri.ArcGISRuntime.OpenSourceApps.DSA", 1, 1, "ViewedAlertsController");
@@ -150,6 +178,7 @@ int main(int argc, char *argv[])
 
   // Initialize application view
   QQuickView view;
+  Dsa::PerformanceMonitor::instance()->setWindow(&view);
   view.setResizeMode(QQuickView::SizeRootObjectToView);
 
   view.engine()->addImageProvider(QStringLiteral("packages"), new Dsa::PackageImageProvider());
@@ -182,15 +211,57 @@ int main(int argc, char *argv[])
 #if !defined(Q_OS_IOS) && !defined(Q_OS_ANDROID)
   // Process command line
   QCommandLineOption showOption(kArgShowName, kArgShowDescription, kArgShowValueName, kArgShowDefault);
+  QCommandLineOption recordInputOption(kArgRecordInputName, kArgRecordInputDescription, kArgFileValueName);
+  QCommandLineOption benchmarkInputOption(kArgBenchmarkInputName, kArgBenchmarkInputDescription, kArgFileValueName);
+  QCommandLineOption benchmarkFeedOption(kArgBenchmarkFeedName, kArgBenchmarkFeedDescription, kArgFileValueName);
+  QCommandLineOption benchmarkOutputOption(kArgBenchmarkOutputName, kArgBenchmarkOutputDescription, kArgFileValueName);
+  QCommandLineOption benchmarkDelayOption(kArgBenchmarkDelayName, kArgBenchmarkDelayDescription, kArgBenchmarkDelayValueName, kArgBenchmarkDelayDefault);
 
   QCommandLineParser commandLineParser;
 
   commandLineParser.setApplicationDescription(kApplicationDescription);
-  commandLineParser.addOption(showOption);
+  commandLineParser.addOptions({showOption, recordInputOption, benchmarkInputOption, benchmarkFeedOption,
+                                benchmarkOutputOption, benchmarkDelayOption});
   commandLineParser.addHelpOption();
   commandLineParser.addVersionOption();
   commandLineParser.process(app);
 
+  // record the mouse input of the session, or replay a recording to measure the response
+  if (commandLineParser.isSet(recordInputOption) || commandLineParser.isSet(benchmarkInputOption))
+  {
+    Dsa::InteractionBenchmark* benchmark = new Dsa::InteractionBenchmark(&view, &view);
+    if (commandLineParser.isSet(recordInputOption) && !benchmark->startRecording(commandLineParser.value(recordInputOption)))
+      qWarning() << "Failed to record the input to" << commandLineParser.value(recordInputOption);
+
+    if (commandLineParser.isSet(benchmarkInputOption))
+    {
+      if (!benchmark->loadInput(commandLineParser.value(benchmarkInputOption)))
+      {
+        qWarning() << "Failed to load the benchmark input" << commandLineParser.value(benchmarkInputOption);
+        return 1;
+      }
+
+      if (commandLineParser.isSet(benchmarkFeedOption) && !benchmark->loadFeedCapture(commandLineParser.value(benchmarkFeedOption)))
+        qWarning() << "Failed to load the benchmark feed capture" << commandLineParser.value(benchmarkFeedOption);
+
+      const QString outputPath = commandLineParser.value(benchmarkOutputOption);
+      QObject::connect(benchmark, &Dsa::InteractionBenchmark::finished, &app, [outputPath](const QJsonObject& result)
+      {
+        const QByteArray resultJson = QJsonDocument(result).toJson(QJsonDocument::Compact);
+        QTextStream(stdout) << Dsa::InteractionBenchmark::RESULT_PREFIX << resultJson << endl;
+
+        QFile outputFile(outputPath);
+        if (!outputPath.isEmpty() && (!outputFile.open(QIODevice::WriteOnly) || outputFile.write(resultJson) != resultJson.size()))
+          qWarning() << "Failed to write the benchmark results to" << outputPath;
+
+        QCoreApplication::quit();
+      });
+
+      QTimer::singleShot(qMax(0, commandLineParser.value(benchmarkDelayOption).toInt()) * 1000,
+                         benchmark, &Dsa::InteractionBenchmark::start);
+    }
+  }
+
   // Show app window
 
   auto showValue = commandLineParser.value(kArgShowName).toLower();
@@ -237,3 +308,20 @@ QObject* dsaResourcesProvider(QQmlEngine* engine, QJSEngine*)
   static Dsa::DsaResources* dsaResources = new Dsa::DsaResources(engine);
   return dsaResources;
 }
+
+// qml performance monitor provider
+QObject* performanceMonitorProvider(QQmlEngine*, QJSEngine*)
+{
+  // the monitor outlives the engine, so it must not be deleted with it
+  Dsa::PerformanceMonitor* performanceMonitor = Dsa::PerformanceMonitor::instance();
+  QQmlEngine::setObjectOwnership(performanceMonitor, QQmlEngine::CppOwnership);
+  return performanceMonitor;
+}
+
+QObject* memoryBudgetProvider(QQmlEngine*, QJSEngine*)
+{
+  // the budget outlives the engine, so it must not be deleted with it
+  Dsa::MemoryBudget* memoryBudget = Dsa::MemoryBudget::instance();
+  QQmlEngine::setObjectOwnership(memoryBudget, QQmlEngine::CppOwnership);
+  return memoryBudget;
+}
@@ -113,24 +113,51 @@ Handheld {
         }
     }
 
-    // Create SceneQuickView here, and create its Scene etc. in C++ code
-    SceneView {
-        id: sceneView
+    // Create the SceneQuickView here, or the MapQuickView when running in 2D,
+    // and create its Scene or Map etc. in C++ code
+    Item {
+        id: geoViewArea
         anchors {
             top: topToolbar.bottom
             left: parent.left
             right: parent.right
             bottom: categoryToolbar.top
         }
-        objectName: "sceneView"
 
-        onMousePressed: followHud.stopFollowing();
+        readonly property var geoView: geoViewLoader.item
+        readonly property real attributionTop: geoView ? geoView.attributionTop : height
+
+        Loader {
+            id: geoViewLoader
+            anchors.fill: parent
+            sourceComponent: appRoot.mapViewMode ? mapViewComponent : sceneViewComponent
+        }
+
+        Component {
+            id: sceneViewComponent
+
+            SceneView {
+                objectName: "sceneView"
+
+                onMousePressed: followHud.stopFollowing();
+            }
+        }
+
+        Component {
+            id: mapViewComponent
+
+            MapView {
+                objectName: "mapView"
+
+                onMousePressed: followHud.stopFollowing();
+            }
+        }
 
         DistressButton {
             anchors {
                 top: parent.top
                 horizontalCenter: navTool.horizontalCenter
-                topMargin: sceneView.height < navTool.height * 1.75 ? 10 * scaleFactor : 40 * scaleFactor
+                topMargin: geoViewArea.height < navTool.height * 1.75 ? 10 * scaleFactor : 40 * scaleFactor
             }
             messageFeedsController: messageFeeds.controller
         }
@@ -138,8 +165,8 @@ Handheld {
         CurrentLocation {
             id: currentLocation
             anchors {
-                bottom: sceneView.attributionTop
-                left: sceneView.left
+                bottom: geoViewArea.attributionTop
+                left: geoViewArea.left
                 margins: hudMargins
             }
             radius: hudRadius
@@ -149,8 +176,8 @@ Handheld {
         FollowHud {
             id: followHud
             anchors {
-                bottom: currentLocation.visible ? currentLocation.top : sceneView.attributionTop
-                left: sceneView.left
+                bottom: currentLocation.visible ? currentLocation.top : geoViewArea.attributionTop
+                left: geoViewArea.left
                 margins: hudMargins
             }
             enabled: false
@@ -163,7 +190,7 @@ Handheld {
             anchors {
                 margins: hudMargins
                 verticalCenter: parent.verticalCenter
-                right: sceneView.right
+                right: geoViewArea.right
             }
             opacity: hudOpacity
             radius: hudRadius
@@ -171,10 +198,10 @@ Handheld {
 
         Toolkit.NorthArrow {
             id: compass
-            geoView: sceneView
+            geoView: geoViewArea.geoView
             anchors {
                 right: parent.right
-                bottom: sceneView.attributionTop
+                bottom: geoViewArea.attributionTop
                 bottomMargin: 10 * scaleFactor
                 rightMargin: parent.height < navTool.height * 1.6 ? 60 * scaleFactor : 15 * scaleFactor
             }
@@ -192,11 +219,11 @@ Handheld {
             id: coordinateConversion
             anchors {
                 bottom: followHud.visible ? followHud.top : currentLocation.top
-                left: sceneView.left
+                left: geoViewArea.left
                 right: navTool.left
                 margins: hudMargins
             }
-            geoView: sceneView
+            geoView: geoViewArea.geoView
             controller: dsaCoordinateController.controller
             inputFormat: dsaCoordinateController.inputFormat
             visible: dsaCoordinateController.active
@@ -232,37 +259,42 @@ Handheld {
             id: contextMenu
         }
 
-        TableOfContents {
+        PanelLoader {
             id: tableOfContentsTool
             anchors {
                 left: parent.left
                 top: parent.top
-                bottom: sceneView.attributionTop
+                bottom: geoViewArea.attributionTop
             }
             width: drawer.width
-            visible: false
-            isMobile: true
-
-            onClosed: {
-                mapToolRow.tocIconSelected = false;
-                visible = false;
-                mapToolRow.state = "clear";
+            sourceComponent: Component {
+                TableOfContents {
+                    isMobile: true
+                    onClosed: {
+                        mapToolRow.tocIconSelected = false;
+                        tableOfContentsTool.visible = false;
+                        mapToolRow.state = "clear";
+                    }
+                }
             }
         }
 
-        AlertList {
+        PanelLoader {
             id: alertsTool
             anchors {
                 left: parent.left
                 top: parent.top
-                bottom: sceneView.attributionTop
+                bottom: geoViewArea.attributionTop
             }
             width: drawer.width
-            visible: false
-            isMobile: true
-            onClosed: {
-                visible = false;
-                alertToolRow.state = "clear";
+            sourceComponent: Component {
+                AlertList {
+                    isMobile: true
+                    onClosed: {
+                        alertsTool.visible = false;
+                        alertToolRow.state = "clear";
+                    }
+                }
             }
         }
 
@@ -271,7 +303,7 @@ Handheld {
             anchors {
                 left: parent.left
                 top: parent.top
-                bottom: sceneView.attributionTop
+                bottom: geoViewArea.attributionTop
             }
             width: drawer.width
             visible: false
@@ -306,7 +338,7 @@ Handheld {
             anchors {
                 right: parent.right
                 top: parent.top
-                bottom: sceneView.attributionTop
+                bottom: geoViewArea.attributionTop
             }
             width: drawer.width
             visible: false
@@ -330,19 +362,22 @@ Handheld {
             visible: false
         }
 
-        AnalysisList {
+        PanelLoader {
             id: analysisListTool
             anchors {
                 right: parent.right
                 top: parent.top
-                bottom: sceneView.attributionTop
+                bottom: geoViewArea.attributionTop
             }
             width: drawer.width
-            visible: false
-            isMobile: true
-            onClosed: {
-                visible = false;
-                analysisToolRow.state = "clear";
+            sourceComponent: Component {
+                AnalysisList {
+                    isMobile: true
+                    onClosed: {
+                        analysisListTool.visible = false;
+                        analysisToolRow.state = "clear";
+                    }
+                }
             }
         }
 
@@ -351,7 +386,7 @@ Handheld {
             anchors {
                 right: parent.right
                 top: parent.top
-                bottom: sceneView.attributionTop
+                bottom: geoViewArea.attributionTop
             }
             width: drawer.width
             visible: false
@@ -382,20 +417,15 @@ Handheld {
             }
         }
 
-        Toolkit.PopupStackView {
+        IdentifyResults {
             id: identifyResults
             anchors {
-                left: sceneView.left
-                top: sceneView.top
-                right: sceneView.right
-                bottom: sceneView.attributionTop
-            }
-            palette {
-                text: Material.foreground
-            }
-            background: Rectangle {
-                color: Material.primary
+                left: geoViewArea.left
+                top: geoViewArea.top
+                right: geoViewArea.right
+                bottom: geoViewArea.attributionTop
             }
+            identifyController: identifyController
             visible: false
         }
 
@@ -506,10 +536,8 @@ Handheld {
         }
 
         onPopupManagersChanged: {
-            if (popupManagers.length > 0) {
-                identifyResults.popupManagers = popupManagers;
+            if (popupCount > 0)
                 identifyResults.visible = true;
-            }
         }
     }
 
@@ -519,11 +547,14 @@ Handheld {
         visible: false
     }
 
-    About {
+    PanelLoader {
         id: aboutTool
         anchors.fill: parent
-
-        visible: false
+        sourceComponent: Component {
+            About {
+                onClosed: aboutTool.visible = false;
+            }
+        }
     }
 
     onErrorOccurred: {
@@ -552,6 +583,14 @@ Handheld {
         visible: identifyController.busy
     }
 
+    PerformanceHud {
+        anchors {
+            left: parent.left
+            top: parent.top
+            margins: 10 * scaleFactor
+        }
+    }
+
     Shortcut {
         sequence: "Ctrl+Q"
         onActivated: Qt.quit()
@@ -17,11 +17,80 @@
 #include "AbstractMessageParser.h"
 #include "CoTMessageParser.h"
 #include "GeoMessageParser.h"
+#include "ScenarioMessageGenerator.h"
 #include "SimulatedMessage.h"
 
-#include <QFile>
 #include <QXmlStreamReader>
 
+#include <cstring>
+
+namespace
+{
+bool isNameDelimiter(char c)
+{
+  return c == '>' || c == '/' || c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+// finds the end of a tag starting at pos, skipping over quoted attribute values
+qint64 findTagEnd(const char* data, qint64 size, qint64 pos)
+{
+  char quote = 0;
+  for (; pos < size; ++pos)
+  {
+    const char c = data[pos];
+    if (quote)
+    {
+      if (c == quote)
+        quote = 0;
+    }
+    else if (c == '"' || c == '\'')
+    {
+      quote = c;
+    }
+    else if (c == '>')
+    {
+      return pos;
+    }
+  }
+  return -1;
+}
+
+bool startsWith(const char* data, qint64 size, qint64 pos, const char* sequence)
+{
+  const qint64 length = static_cast<qint64>(std::strlen(sequence));
+  return pos + length <= size && std::memcmp(data + pos, sequence, length) == 0;
+}
+
+qint64 findSequence(const char* data, qint64 size, qint64 pos, const char* sequence)
+{
+  const qint64 length = static_cast<qint64>(std::strlen(sequence));
+  for (; pos + length <= size; ++pos)
+  {
+    if (std::memcmp(data + pos, sequence, length) == 0)
+      return pos;
+  }
+  return -1;
+}
+
+// returns true if the tag name starting at pos matches name, ignoring any namespace prefix
+bool matchesElementName(const char* data, qint64 size, qint64 pos, const QByteArray& name)
+{
+  qint64 nameEnd = pos;
+  while (nameEnd < size && !isNameDelimiter(data[nameEnd]))
+    ++nameEnd;
+
+  qint64 nameStart = pos;
+  for (qint64 i = pos; i < nameEnd; ++i)
+  {
+    if (data[i] == ':')
+      nameStart = i + 1;
+  }
+
+  return nameEnd - nameStart == name.size() &&
+      qstrnicmp(data + nameStart, name.constData(), static_cast<uint>(name.size())) == 0;
+}
+}
+
 AbstractMessageParser::AbstractMessageParser(const QString& filePath, QObject* parent) :
   QObject(parent),
   m_filePath(filePath)
@@ -30,10 +99,14 @@ AbstractMessageParser::AbstractMessageParser(const QString& filePath, QObject* p
 
 AbstractMessageParser::~AbstractMessageParser()
 {
+  closeFile();
 }
 
 AbstractMessageParser* AbstractMessageParser::createMessageParser(const QString& filePath, QObject* parent)
 {
+  if (ScenarioMessageGenerator::isScenarioFile(filePath))
+    return new ScenarioMessageGenerator(filePath, parent);
+
   QFile file(filePath);
   if (!file.open(QFile::ReadOnly | QFile::Text))
   {
@@ -66,3 +139,152 @@ QString AbstractMessageParser::filePath() const
 {
   return m_filePath;
 }
+
+// Returns a shallow slice of the mapped file, which is only valid while the parser exists
+QByteArray AbstractMessageParser::nextMessage()
+{
+  if (!m_isIndexed && !indexMessages())
+    return QByteArray();
+
+  if (m_currentIndex >= m_messageOffsets.size())
+  {
+    emit errorOccurred(tr("No more messages in ") + filePath());
+    return QByteArray();
+  }
+
+  const auto& offset = m_messageOffsets.at(m_currentIndex++);
+  return QByteArray::fromRawData(m_data + offset.m_start, static_cast<int>(offset.m_length));
+}
+
+void AbstractMessageParser::reset()
+{
+  // the index stays valid so looping just rewinds
+  m_currentIndex = 0;
+}
+
+bool AbstractMessageParser::atEnd() const
+{
+  return m_isIndexed && m_currentIndex >= m_messageOffsets.size();
+}
+
+int AbstractMessageParser::messageCount()
+{
+  if (!m_isIndexed)
+    indexMessages();
+
+  return m_messageOffsets.size();
+}
+
+int AbstractMessageParser::currentIndex() const
+{
+  return m_currentIndex;
+}
+
+bool AbstractMessageParser::seek(int index)
+{
+  if (index < 0 || index >= messageCount())
+    return false;
+
+  m_currentIndex = index;
+  return true;
+}
+
+// Maps the file and records the byte range of every message element
+bool AbstractMessageParser::indexMessages()
+{
+  closeFile();
+  m_isIndexed = true;
+
+  m_file.setFileName(m_filePath);
+  if (!m_file.open(QFile::ReadOnly))
+  {
+    emit errorOccurred(tr("Could not open ") + filePath() + tr(" for reading"));
+    return false;
+  }
+
+  m_dataSize = m_file.size();
+  m_data = reinterpret_cast<const char*>(m_file.map(0, m_dataSize));
+  if (!m_data)
+  {
+    // files that cannot be mapped (e.g. resources) are read into memory once
+    m_fileData = m_file.readAll();
+    m_file.close();
+    m_data = m_fileData.constData();
+    m_dataSize = m_fileData.size();
+  }
+
+  const QByteArray name = messageElementName().toUtf8();
+  const char* data = m_data;
+  const qint64 size = m_dataSize;
+
+  qint64 messageStart = -1;
+  int depth = 0;
+  qint64 pos = 0;
+  while (pos < size)
+  {
+    const char* tag = static_cast<const char*>(std::memchr(data + pos, '<', static_cast<size_t>(size - pos)));
+    if (!tag)
+      break;
+
+    pos = tag - data;
+    qint64 tagEnd = -1;
+    if (startsWith(data, size, pos, "<!--"))
+    {
+      tagEnd = findSequence(data, size, pos + 4, "-->");
+      tagEnd = tagEnd < 0 ? -1 : tagEnd + 2;
+    }
+    else if (startsWith(data, size, pos, "<![CDATA["))
+    {
+      tagEnd = findSequence(data, size, pos + 9, "]]>");
+      tagEnd = tagEnd < 0 ? -1 : tagEnd + 2;
+    }
+    else if (pos + 1 < size && (data[pos + 1] == '?' || data[pos + 1] == '!'))
+    {
+      tagEnd = findTagEnd(data, size, pos + 2);
+    }
+    else if (pos + 1 < size && data[pos + 1] == '/')
+    {
+      tagEnd = findTagEnd(data, size, pos + 2);
+      if (tagEnd >= 0 && depth > 0 && matchesElementName(data, size, pos + 2, name) && --depth == 0)
+      {
+        m_messageOffsets.append({messageStart, tagEnd + 1 - messageStart});
+        messageStart = -1;
+      }
+    }
+    else
+    {
+      tagEnd = findTagEnd(data, size, pos + 1);
+      if (tagEnd >= 0 && matchesElementName(data, size, pos + 1, name))
+      {
+        const bool selfClosing = data[tagEnd - 1] == '/';
+        if (depth == 0)
+        {
+          if (selfClosing)
+            m_messageOffsets.append({pos, tagEnd + 1 - pos});
+          else
+            messageStart = pos;
+        }
+
+        if (!selfClosing)
+          ++depth;
+      }
+    }
+
+    if (tagEnd < 0)
+      break;
+
+    pos = tagEnd + 1;
+  }
+
+  return !m_messageOffsets.isEmpty();
+}
+
+void AbstractMessageParser::closeFile()
+{
+  m_messageOffsets.clear();
+  m_currentIndex = 0;
+  m_data = nullptr;
+  m_dataSize = 0;
+  m_fileData.clear();
+  m_file.close(); // also unmaps the file
+}
@@ -17,7 +17,10 @@
 #ifndef ABSTRACTMESSAGEPARSER_H
 #define ABSTRACTMESSAGEPARSER_H
 
+#include <QByteArray>
+#include <QFile>
 #include <QObject>
+#include <QVector>
 
 class AbstractMessageParser : public QObject
 {
@@ -28,11 +31,15 @@ public:
 
   static AbstractMessageParser* createMessageParser(const QString& filePath, QObject* parent = nullptr);
 
-  virtual QByteArray nextMessage() = 0;
+  virtual QByteArray nextMessage();
 
-  virtual void reset() = 0;
+  virtual void reset();
 
-  virtual bool atEnd() const = 0;
+  virtual bool atEnd() const;
+
+  int messageCount();
+  int currentIndex() const;
+  bool seek(int index);
 
   QString filePath() const;
 
@@ -42,11 +49,29 @@ signals:
 protected:
   explicit AbstractMessageParser(const QString& filePath, QObject* parent = nullptr);
 
+  virtual QString messageElementName() const = 0;
+
 private:
   Q_DISABLE_COPY(AbstractMessageParser)
   AbstractMessageParser() = delete;
 
+  struct MessageOffset
+  {
+    qint64 m_start = 0;
+    qint64 m_length = 0;
+  };
+
+  bool indexMessages();
+  void closeFile();
+
   QString m_filePath;
+  QFile m_file;
+  QByteArray m_fileData;
+  const char* m_data = nullptr;
+  qint64 m_dataSize = 0;
+  QVector<MessageOffset> m_messageOffsets;
+  int m_currentIndex = 0;
+  bool m_isIndexed = false;
 };
 
 #endif // ABSTRACTMESSAGEPARSER_H
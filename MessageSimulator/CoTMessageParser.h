@@ -19,9 +19,6 @@
 
 #include "AbstractMessageParser.h"
 
-#include <QXmlStreamReader>
-#include <QFile>
-
 class CoTMessageParser : public AbstractMessageParser
 {
   Q_OBJECT
@@ -30,19 +27,12 @@ public:
   explicit CoTMessageParser(const QString& filePath, QObject* parent = nullptr);
   ~CoTMessageParser();
 
-  QByteArray nextMessage() override;
-
-  void reset() override;
-
-  bool atEnd() const override;
+protected:
+  QString messageElementName() const override;
 
 private:
   Q_DISABLE_COPY(CoTMessageParser)
   CoTMessageParser() = delete;
-
-  QFile m_device;
-  QXmlStreamReader m_reader;
-  bool m_isParsing = false;
 };
 
 #endif // COTMESSAGEPARSER_H
@@ -19,9 +19,6 @@
 
 #include "AbstractMessageParser.h"
 
-#include <QFile>
-#include <QXmlStreamReader>
-
 class GeoMessageParser : public AbstractMessageParser
 {
   Q_OBJECT
@@ -30,19 +27,12 @@ public:
   explicit GeoMessageParser(const QString& filePath, QObject* parent = nullptr);
   ~GeoMessageParser();
 
-  QByteArray nextMessage() override;
-
-  void reset() override;
-
-  bool atEnd() const override;
+protected:
+  QString messageElementName() const override;
 
 private:
   Q_DISABLE_COPY(GeoMessageParser)
   GeoMessageParser() = delete;
-
-  QFile m_device;
-  QXmlStreamReader m_reader;
-  bool m_isParsing = false;
 };
 
 #endif // GEOMESSAGEPARSER_H
@@ -17,7 +17,7 @@
 TARGET = DSA_MessageSimulator_Qt
 TEMPLATE = app
 
-QT += qml quick xml
+QT += qml quick xml network
 CONFIG += c++14
 
 INCLUDEPATH += \
@@ -26,21 +26,30 @@ INCLUDEPATH += \
 
 HEADERS += \
     $$PWD/../Shared/utilities/DataSender.h \
+    $$PWD/../Shared/utilities/DatagramCaptureFormat.h \
+    $$PWD/../Shared/utilities/DatagramCaptureReader.h \
+    $$PWD/../Shared/utilities/LatencyProbe.h \
     MessageSimulatorController.h \
     AbstractMessageParser.h \
     CoTMessageParser.h \
     SimulatedMessage.h \
     SimulatedMessageListModel.h \
-    GeoMessageParser.h
+    SimulationStream.h \
+    GeoMessageParser.h \
+    ScenarioMessageGenerator.h
 
 SOURCES += main.cpp \
     $$PWD/../Shared/utilities/DataSender.cpp \
+    $$PWD/../Shared/utilities/DatagramCaptureReader.cpp \
+    $$PWD/../Shared/utilities/LatencyProbe.cpp \
     AbstractMessageParser.cpp \
     CoTMessageParser.cpp \
     MessageSimulatorController.cpp \
     SimulatedMessage.cpp \
     SimulatedMessageListModel.cpp \
-    GeoMessageParser.cpp
+    SimulationStream.cpp \
+    GeoMessageParser.cpp \
+    ScenarioMessageGenerator.cpp
 
 RESOURCES += qml/qml.qrc \
     Resources/application.qrc
@@ -17,75 +17,50 @@
 #include "MessageSimulatorController.h"
 
 // dsa app headers
-#include "AbstractMessageParser.h"
 #include "DataSender.h"
 #include "SimulatedMessage.h"
 #include "SimulatedMessageListModel.h"
+#include "SimulationStream.h"
 
 // Qt headers
+#include <QFileInfo>
 #include <QSettings>
+#include <QUdpSocket>
 
-MessageSimulatorController::MessageSimulatorController(QObject* parent) :
-  QObject(parent),
-  m_dataSender(new Dsa::DataSender(this)),
-  m_messages(new SimulatedMessageListModel(this))
+// STL headers
+#include <algorithm>
+#include <cmath>
+
+namespace
 {
-  connect(&m_timer, &QTimer::timeout, this, [this]
-  {
-    if (m_messageParser->atEnd())
-    {
-      // reached end of the message parser
-      // check if simulation is looped, if not end the simulation
-      if (m_simulationLooped && m_messagesSent > 0)
-      {
-        // reset the message parser to the beginning to continue
-        // looping through messages
-        m_messageParser->reset();
-      }
-      else if (m_messagesSent == 0)
-      {
-        // if no messages have been sent and we've reached the end of the parser
-        // then the simulation contains no messages
-        emit errorOccurred(tr("Simulation file contains no messages"));
-        stopSimulation();
-        return;
-      }
-      else
-      {
-        // simulation has finished
-        stopSimulation();
-        return;
-      }
-    }
+// above this rate, messages are sent in bursts rather than one per timeout
+constexpr double s_maximumTimerRate = 100.0;
 
-    const auto messageBytes = m_messageParser->nextMessage();
-    if (messageBytes.isEmpty())
-    {
-      emit errorOccurred(tr("Message is empty"));
-      return;
-    }
+// the interval between bursts, in ms
+constexpr int s_burstInterval = 10;
 
-    if (m_dataSender->sendData(messageBytes) == -1)
-    {
-      emit errorOccurred(tr("Failed to send message"));
-      return;
-    }
+// the interval at which the sent statistics are updated, in ms
+constexpr int s_statisticsInterval = 1000;
 
-    m_messagesSent++;
-  });
+// the interval at which due datagrams are sent when replaying a capture, in ms
+constexpr int s_captureInterval = 1;
 
-  connect(m_dataSender, &Dsa::DataSender::dataSent, this, [this](const QByteArray& data)
-  {
-    // create a simulated message to be added to the messages model
-    SimulatedMessage* simulatedMessage = SimulatedMessage::create(data, this);
-    if (!simulatedMessage)
-    {
-      emit errorOccurred(tr("Failed to create simulated message"));
-      return;
-    }
+// the file extension of capture files
+const QString s_captureFileSuffix = QStringLiteral("dsacap");
+}
 
-    m_messages->append(simulatedMessage);
-  });
+MessageSimulatorController::MessageSimulatorController(QObject* parent) :
+  QObject(parent),
+  m_messages(new SimulatedMessageListModel(this))
+{
+  connect(&m_timer, &QTimer::timeout, this, &MessageSimulatorController::handleTimeout);
+
+  m_captureTimer.setTimerType(Qt::PreciseTimer);
+  m_captureTimer.setInterval(s_captureInterval);
+  connect(&m_captureTimer, &QTimer::timeout, this, &MessageSimulatorController::handleCaptureTimeout);
+
+  m_statisticsTimer.setInterval(s_statisticsInterval);
+  connect(&m_statisticsTimer, &QTimer::timeout, this, &MessageSimulatorController::updateStatistics);
 
   // load settings for the app if they exist
   loadSettings();
@@ -134,15 +109,12 @@ void MessageSimulatorController::setMessageFrequency(float messageFrequency)
   if (messageFrequency > 0)
   {
     m_messageFrequency = messageFrequency;
-    if (m_timer.isActive())
-      m_timer.stop();
+    m_messagesPerSecond = messageFrequency / timeUnitToSeconds(m_timeUnit);
+    if (m_primaryStream)
+      m_primaryStream->setMessagesPerSecond(m_messagesPerSecond);
 
     if (m_simulationState == SimulationState::Running)
-    {
-      float messageFrequencyInSeconds = (timeUnitToSeconds(m_timeUnit) / messageFrequency);
-      constexpr float millisecondsMultiplier = 1000.0f;
-      m_timer.start(messageFrequencyInSeconds * millisecondsMultiplier); // in ms
-    }
+      restartScheduler();
 
     if (previousMessageFrequency != m_messageFrequency)
       emit messageFrequencyChanged();
@@ -171,9 +143,34 @@ void MessageSimulatorController::setSimulationLooped(bool simulationLooped)
 
   m_simulationLooped = simulationLooped;
 
+  const auto activeStreams = streams();
+  for (SimulationStream* stream : activeStreams)
+    stream->setLooped(m_simulationLooped);
+
   emit simulationLoopedChanged();
 }
 
+bool MessageSimulatorController::isLatencyProbeEnabled() const
+{
+  return m_latencyProbeEnabled;
+}
+
+// Stamps the simulated messages with their send time and a sequence number, so
+// the receiving apps can measure the latency of the whole pipeline
+void MessageSimulatorController::setLatencyProbeEnabled(bool latencyProbeEnabled)
+{
+  if (m_latencyProbeEnabled == latencyProbeEnabled)
+    return;
+
+  m_latencyProbeEnabled = latencyProbeEnabled;
+
+  const auto activeStreams = streams();
+  for (SimulationStream* stream : activeStreams)
+    stream->setLatencyProbeEnabled(m_latencyProbeEnabled);
+
+  emit latencyProbeEnabledChanged();
+}
+
 MessageSimulatorController::TimeUnit MessageSimulatorController::timeUnit() const
 {
   return m_timeUnit;
@@ -194,28 +191,94 @@ QAbstractListModel* MessageSimulatorController::messages() const
   return m_messages;
 }
 
+int MessageSimulatorController::displaySampleInterval() const
+{
+  return m_messages->sampleInterval();
+}
+
+void MessageSimulatorController::setDisplaySampleInterval(int displaySampleInterval)
+{
+  if (displaySampleInterval <= 0 || m_messages->sampleInterval() == displaySampleInterval)
+    return;
+
+  m_messages->setSampleInterval(displaySampleInterval);
+
+  emit displaySampleIntervalChanged();
+}
+
+qint64 MessageSimulatorController::messagesSent() const
+{
+  return m_messagesSent;
+}
+
+double MessageSimulatorController::bytesPerSecond() const
+{
+  return m_bytesPerSecond;
+}
+
+void MessageSimulatorController::updateStatistics()
+{
+  const qint64 elapsed = m_statisticsClock.restart();
+  if (elapsed > 0)
+    m_bytesPerSecond = (m_bytesSent - m_statisticsBytesSent) * 1000.0 / elapsed;
+
+  m_statisticsBytesSent = m_bytesSent;
+
+  emit statisticsChanged();
+}
+
 void MessageSimulatorController::startSimulation(const QUrl& file)
 {
   // first stop the simulation if it was already running
   stopSimulation();
 
-  // create UDP connection to broadcast address with specified port
-  m_udpSocket = new QUdpSocket(this);
-  m_udpSocket->connectToHost(QHostAddress::Broadcast, m_port, QIODevice::WriteOnly);
-  m_dataSender->setDevice(m_udpSocket);
+  delete m_primaryStream;
+  m_primaryStream = nullptr;
 
-  if (m_messageParser)
-    delete m_messageParser;
+  // capture files are replayed on their original ports, with their original timing
+  const bool isCapture = isCaptureFile(file);
+  if (isCapture && !openCaptureReplay(file))
+    return;
 
-  // create a message parser with specified input file
-  m_messageParser = AbstractMessageParser::createMessageParser(file.toLocalFile(), this);
-  if (!m_messageParser)
+  if (isCapture)
   {
-    emit errorOccurred(tr("Failed to create message parser with input file"));
+    m_messages->clear();
+
+    if (m_simulationFile != file)
+    {
+      m_simulationFile = file;
+
+      emit simulationFileChanged();
+    }
+
+    m_simulationState = SimulationState::Running;
+    m_messagesSent = 0;
+    m_bytesSent = 0;
+    m_statisticsBytesSent = 0;
+    m_bytesPerSecond = 0.0;
+    m_statisticsClock.start();
+    m_statisticsTimer.start();
+    startCaptureTimer();
+
+    emit simulationStateChanged();
+    emit statisticsChanged();
+
+    saveSettings();
     return;
   }
 
-  connect(m_messageParser, &AbstractMessageParser::errorOccurred, this, &MessageSimulatorController::errorOccurred);
+  // broadcast the simulation file on the specified port
+  m_primaryStream = new SimulationStream(file, SimulationStream::Protocol::Broadcast, QHostAddress(), m_port, this);
+  m_primaryStream->setMessagesPerSecond(m_messagesPerSecond);
+  connect(m_primaryStream, &SimulationStream::errorOccurred, this, &MessageSimulatorController::errorOccurred);
+  connect(m_primaryStream->dataSender(), &Dsa::DataSender::dataSent, this, &MessageSimulatorController::handleDataSent);
+
+  if (!openStream(m_primaryStream))
+    return;
+
+  // additional streams report their own errors and do not prevent the simulation starting
+  for (SimulationStream* stream : qAsConst(m_streams))
+    openStream(stream);
 
   // clear the messages model
   m_messages->clear();
@@ -230,8 +293,14 @@ void MessageSimulatorController::startSimulation(const QUrl& file)
   m_simulationState = SimulationState::Running;
   setMessageFrequency(m_messageFrequency);
   m_messagesSent = 0;
+  m_bytesSent = 0;
+  m_statisticsBytesSent = 0;
+  m_bytesPerSecond = 0.0;
+  m_statisticsClock.start();
+  m_statisticsTimer.start();
 
   emit simulationStateChanged();
+  emit statisticsChanged();
 
   // save app settings for next time the app is launched
   saveSettings();
@@ -241,6 +310,7 @@ void MessageSimulatorController::pauseSimulation()
 {
   m_simulationState = SimulationState::Paused;
   m_timer.stop();
+  m_captureTimer.stop();
 
   emit simulationStateChanged();
 }
@@ -250,6 +320,9 @@ void MessageSimulatorController::resumeSimulation()
   m_simulationState = SimulationState::Running;
   setMessageFrequency(m_messageFrequency);
 
+  if (m_captureReader.isOpen())
+    startCaptureTimer();
+
   emit simulationStateChanged();
 }
 
@@ -262,21 +335,171 @@ void MessageSimulatorController::stopSimulation()
   m_timer.stop();
   m_simulationState = SimulationState::Stopped;
 
-  if (m_udpSocket)
+  closeCaptureReplay();
+
+  m_statisticsTimer.stop();
+  updateStatistics();
+
+  const auto activeStreams = streams();
+  for (SimulationStream* stream : activeStreams)
+    stream->close();
+
+  emit simulationStateChanged();
+}
+
+void MessageSimulatorController::handleTimeout()
+{
+  // every stream earns messages over the same elapsed time, at its own rate
+  const double elapsedSeconds = m_sendClock.nsecsElapsed() / 1.0e9;
+  m_sendClock.restart();
+
+  bool isStreaming = false;
+  const auto activeStreams = streams();
+  for (SimulationStream* stream : activeStreams)
   {
-    if (m_udpSocket->isOpen())
-      m_udpSocket->close();
+    const int dueMessages = stream->takeDueMessages(elapsedSeconds);
+    for (int i = 0; i < dueMessages; ++i)
+    {
+      const qint64 bytesSent = stream->sendNextMessage();
+      if (bytesSent == -1)
+        break;
 
-    delete m_udpSocket;
-    m_udpSocket = nullptr;
+      m_messagesSent++;
+      m_bytesSent += bytesSent;
+    }
+
+    if (stream->isOpen() && !stream->isFinished())
+      isStreaming = true;
   }
 
-  emit simulationStateChanged();
+  // the simulation has finished once every stream has
+  if (!isStreaming)
+    stopSimulation();
+}
+
+void MessageSimulatorController::handleDataSent(const QByteArray& data)
+{
+  // the model may only display a sample of the sent messages
+  if (!m_messages->acceptNextMessage())
+    return;
+
+  // create a simulated message to be added to the messages model
+  SimulatedMessage* simulatedMessage = SimulatedMessage::create(data, this);
+  if (!simulatedMessage)
+  {
+    emit errorOccurred(tr("Failed to create simulated message"));
+    return;
+  }
+
+  m_messages->append(simulatedMessage);
+}
+
+void MessageSimulatorController::restartScheduler()
+{
+  m_timer.stop();
+
+  double maximumMessagesPerSecond = 0.0;
+  const auto activeStreams = streams();
+  for (SimulationStream* stream : activeStreams)
+  {
+    if (stream->isOpen() && !stream->isFinished())
+      maximumMessagesPerSecond = std::max(maximumMessagesPerSecond, stream->messagesPerSecond());
+  }
+
+  if (maximumMessagesPerSecond <= 0.0)
+    return;
+
+  m_sendClock.start();
+  if (maximumMessagesPerSecond > s_maximumTimerRate)
+  {
+    // the timer cannot fire fast enough to send one message per timeout, so
+    // send bursts paced by each stream's token bucket
+    m_timer.setTimerType(Qt::PreciseTimer);
+    m_timer.start(s_burstInterval);
+  }
+  else
+  {
+    // one timeout per message of the fastest stream
+    constexpr double millisecondsMultiplier = 1000.0;
+    m_timer.setTimerType(Qt::CoarseTimer);
+    m_timer.start(static_cast<int>(millisecondsMultiplier / maximumMessagesPerSecond)); // in ms
+  }
+}
+
+bool MessageSimulatorController::openStream(SimulationStream* stream)
+{
+  stream->setLooped(m_simulationLooped);
+  stream->setLatencyProbeEnabled(m_latencyProbeEnabled);
+  return stream->open();
+}
+
+QList<SimulationStream*> MessageSimulatorController::streams() const
+{
+  QList<SimulationStream*> allStreams;
+  if (m_primaryStream)
+    allStreams.append(m_primaryStream);
+
+  allStreams.append(m_streams);
+  return allStreams;
 }
 
 void MessageSimulatorController::sendMessage(const QString& message)
 {
-  m_dataSender->sendData(message.toUtf8());
+  if (m_primaryStream)
+    m_primaryStream->sendData(message.toUtf8());
+}
+
+int MessageSimulatorController::streamCount() const
+{
+  return m_streams.size();
+}
+
+/*
+ Adds a stream which sends \a file to \a address and \a port alongside the simulation file,
+ at its own rate. Streams persist across simulation runs until clearStreams is called.
+ */
+bool MessageSimulatorController::addStream(const QUrl& file, const QString& protocol, const QString& address, int port, double messagesPerSecond)
+{
+  const auto streamProtocol = SimulationStream::toProtocol(protocol);
+  const QHostAddress hostAddress(address);
+  if (port <= 0 || messagesPerSecond <= 0.0 ||
+      (streamProtocol != SimulationStream::Protocol::Broadcast && hostAddress.isNull()))
+  {
+    emit errorOccurred(tr("Invalid stream configuration for ") + file.toLocalFile());
+    return false;
+  }
+
+  auto stream = new SimulationStream(file, streamProtocol, hostAddress, port, this);
+  stream->setMessagesPerSecond(messagesPerSecond);
+  connect(stream, &SimulationStream::errorOccurred, this, &MessageSimulatorController::errorOccurred);
+  connect(stream->dataSender(), &Dsa::DataSender::dataSent, this, &MessageSimulatorController::handleDataSent);
+
+  m_streams.append(stream);
+
+  // join a running simulation straight away
+  if (m_simulationState != SimulationState::Stopped && openStream(stream) &&
+      m_simulationState == SimulationState::Running)
+  {
+    restartScheduler();
+  }
+
+  emit streamsChanged();
+
+  return true;
+}
+
+void MessageSimulatorController::clearStreams()
+{
+  if (m_streams.isEmpty())
+    return;
+
+  qDeleteAll(m_streams);
+  m_streams.clear();
+
+  if (m_simulationState == SimulationState::Running)
+    restartScheduler();
+
+  emit streamsChanged();
 }
 
 void MessageSimulatorController::saveSettings()
@@ -287,6 +510,7 @@ void MessageSimulatorController::saveSettings()
   settings.setValue("messageFrequency", m_messageFrequency);
   settings.setValue("timeUnit", fromTimeUnit(m_timeUnit));
   settings.setValue("loop", m_simulationLooped);
+  settings.setValue("latencyProbe", m_latencyProbeEnabled);
 }
 
 void MessageSimulatorController::loadSettings()
@@ -297,6 +521,107 @@ void MessageSimulatorController::loadSettings()
   setMessageFrequency(settings.value("messageFrequency", 1.0f).toFloat());
   setTimeUnit(toTimeUnit(settings.value("timeUnit", "seconds").toString()));
   setSimulationLooped(settings.value("loop", true).toBool());
+  setLatencyProbeEnabled(settings.value("latencyProbe", false).toBool());
+}
+
+double MessageSimulatorController::captureReplaySpeed() const
+{
+  return m_captureReplaySpeed;
+}
+
+/*
+ Sets the multiple of the original timing at which capture files are replayed to
+ \a captureReplaySpeed. The change applies from the next datagram.
+ */
+void MessageSimulatorController::setCaptureReplaySpeed(double captureReplaySpeed)
+{
+  if (captureReplaySpeed <= 0.0 || m_captureReplaySpeed == captureReplaySpeed)
+    return;
+
+  m_captureReplaySpeed = captureReplaySpeed;
+
+  emit captureReplaySpeedChanged();
+}
+
+bool MessageSimulatorController::isCaptureFile(const QUrl& file)
+{
+  return QFileInfo(file.toLocalFile()).suffix().compare(s_captureFileSuffix, Qt::CaseInsensitive) == 0;
+}
+
+bool MessageSimulatorController::openCaptureReplay(const QUrl& file)
+{
+  closeCaptureReplay();
+
+  if (!m_captureReader.open(file.toLocalFile()))
+  {
+    emit errorOccurred(tr("Failed to open capture file ") + file.toLocalFile());
+    return false;
+  }
+
+  m_captureSocket = new QUdpSocket(this);
+  m_hasNextCaptureRecord = m_captureReader.readNext(m_nextCaptureRecord);
+  m_capturePlaybackTime = 0.0;
+  return true;
+}
+
+void MessageSimulatorController::closeCaptureReplay()
+{
+  m_captureTimer.stop();
+  m_hasNextCaptureRecord = false;
+  m_nextCaptureRecord = Dsa::DatagramCaptureReader::Record();
+  m_captureReader.close();
+
+  delete m_captureSocket;
+  m_captureSocket = nullptr;
+}
+
+void MessageSimulatorController::startCaptureTimer()
+{
+  m_captureClock.start();
+  m_captureTimer.start();
+}
+
+/*
+ Broadcasts every captured datagram which is due at the current playback time, each on
+ the port it was captured on. Datagrams which fall behind the timer are sent in a burst,
+ as the original traffic would have arrived.
+ */
+void MessageSimulatorController::handleCaptureTimeout()
+{
+  m_capturePlaybackTime += m_captureClock.nsecsElapsed() / 1000.0 * m_captureReplaySpeed;
+  m_captureClock.restart();
+
+  while (m_hasNextCaptureRecord && m_nextCaptureRecord.m_timestamp <= m_capturePlaybackTime)
+  {
+    const qint64 bytesSent = m_captureSocket->writeDatagram(m_nextCaptureRecord.m_datagram, QHostAddress::Broadcast,
+                                                            m_nextCaptureRecord.m_port);
+    if (bytesSent != -1)
+    {
+      m_messagesSent++;
+      m_bytesSent += bytesSent;
+
+      // captures can hold datagrams in any wire format, so only those which
+      // can be displayed are added to the messages model
+      if (m_messages->acceptNextMessage())
+      {
+        SimulatedMessage* simulatedMessage = SimulatedMessage::create(m_nextCaptureRecord.m_datagram, this);
+        if (simulatedMessage)
+          m_messages->append(simulatedMessage);
+      }
+    }
+
+    m_hasNextCaptureRecord = m_captureReader.readNext(m_nextCaptureRecord);
+    if (!m_hasNextCaptureRecord && m_simulationLooped)
+    {
+      m_captureReader.rewind();
+      m_capturePlaybackTime = 0.0;
+      m_hasNextCaptureRecord = m_captureReader.readNext(m_nextCaptureRecord);
+      break;
+    }
+  }
+
+  if (!m_hasNextCaptureRecord)
+    stopSimulation();
 }
 
 QString MessageSimulatorController::fromTimeUnit(TimeUnit timeUnit)
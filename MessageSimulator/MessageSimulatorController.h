@@ -17,20 +17,19 @@
 #ifndef MESSAGESIMULATORCONTROLLER_H
 #define MESSAGESIMULATORCONTROLLER_H
 
+// dsa app headers
+#include "DatagramCaptureReader.h"
 
 // Qt headers
 #include <QAbstractListModel>
+#include <QElapsedTimer>
 #include <QObject>
 #include <QTimer>
-#include <QUdpSocket>
 #include <QUrl>
 
-namespace Dsa {
-class DataSender;
-}
-
-class AbstractMessageParser;
+class QUdpSocket;
 class SimulatedMessageListModel;
+class SimulationStream;
 
 class MessageSimulatorController : public QObject
 {
@@ -40,9 +39,15 @@ class MessageSimulatorController : public QObject
   Q_PROPERTY(SimulationState simulationState READ simulationState NOTIFY simulationStateChanged)
   Q_PROPERTY(int port READ port WRITE setPort NOTIFY portChanged)
   Q_PROPERTY(bool simulationLooped READ isSimulationLooped WRITE setSimulationLooped NOTIFY simulationLoopedChanged)
+  Q_PROPERTY(bool latencyProbeEnabled READ isLatencyProbeEnabled WRITE setLatencyProbeEnabled NOTIFY latencyProbeEnabledChanged)
   Q_PROPERTY(float messageFrequency READ messageFrequency WRITE setMessageFrequency NOTIFY messageFrequencyChanged)
   Q_PROPERTY(TimeUnit timeUnit READ timeUnit WRITE setTimeUnit NOTIFY timeUnitChanged)
   Q_PROPERTY(QAbstractListModel* messages READ messages NOTIFY messagesChanged)
+  Q_PROPERTY(int displaySampleInterval READ displaySampleInterval WRITE setDisplaySampleInterval NOTIFY displaySampleIntervalChanged)
+  Q_PROPERTY(qint64 messagesSent READ messagesSent NOTIFY statisticsChanged)
+  Q_PROPERTY(double bytesPerSecond READ bytesPerSecond NOTIFY statisticsChanged)
+  Q_PROPERTY(int streamCount READ streamCount NOTIFY streamsChanged)
+  Q_PROPERTY(double captureReplaySpeed READ captureReplaySpeed WRITE setCaptureReplaySpeed NOTIFY captureReplaySpeedChanged)
 
 public:
   enum class TimeUnit
@@ -79,11 +84,20 @@ public:
   bool isSimulationLooped() const;
   void setSimulationLooped(bool simulationLooped);
 
+  bool isLatencyProbeEnabled() const;
+  void setLatencyProbeEnabled(bool latencyProbeEnabled);
+
   TimeUnit timeUnit() const;
   void setTimeUnit(TimeUnit timeUnit);
 
   QAbstractListModel* messages() const;
 
+  int displaySampleInterval() const;
+  void setDisplaySampleInterval(int displaySampleInterval);
+
+  qint64 messagesSent() const;
+  double bytesPerSecond() const;
+
   Q_INVOKABLE void startSimulation(const QUrl& file);
   Q_INVOKABLE void pauseSimulation();
   Q_INVOKABLE void resumeSimulation();
@@ -91,6 +105,15 @@ public:
 
   Q_INVOKABLE void sendMessage(const QString& message);
 
+  int streamCount() const;
+  Q_INVOKABLE bool addStream(const QUrl& file, const QString& protocol, const QString& address, int port, double messagesPerSecond);
+  Q_INVOKABLE void clearStreams();
+
+  double captureReplaySpeed() const;
+  void setCaptureReplaySpeed(double captureReplaySpeed);
+
+  Q_INVOKABLE static bool isCaptureFile(const QUrl& file);
+
   Q_INVOKABLE static QString fromTimeUnit(TimeUnit timeUnit);
   Q_INVOKABLE static TimeUnit toTimeUnit(const QString& timeUnit);
 
@@ -99,9 +122,14 @@ signals:
   void simulationStateChanged();
   void portChanged();
   void simulationLoopedChanged();
+  void latencyProbeEnabledChanged();
   void messageFrequencyChanged();
   void timeUnitChanged();
   void messagesChanged();
+  void displaySampleIntervalChanged();
+  void statisticsChanged();
+  void streamsChanged();
+  void captureReplaySpeedChanged();
   void errorOccurred(const QString& error);
 
 private:
@@ -112,23 +140,55 @@ private:
 
   static float timeUnitToSeconds(TimeUnit timeUnit);
 
-  Dsa::DataSender* m_dataSender = nullptr;
-  AbstractMessageParser* m_messageParser = nullptr;
+  void handleTimeout();
+  void handleDataSent(const QByteArray& data);
+  void restartScheduler();
+  void updateStatistics();
+  bool openStream(SimulationStream* stream);
+  QList<SimulationStream*> streams() const;
+
+  bool openCaptureReplay(const QUrl& file);
+  void closeCaptureReplay();
+  void startCaptureTimer();
+  void handleCaptureTimeout();
+
   SimulatedMessageListModel* m_messages = nullptr;
 
-  QUdpSocket* m_udpSocket = nullptr;
+  // the stream of the simulation file, followed by any additional streams
+  SimulationStream* m_primaryStream = nullptr;
+  QList<SimulationStream*> m_streams;
+
+  // a single timer paces every stream
   QTimer m_timer;
+  QTimer m_statisticsTimer;
 
   QUrl m_simulationFile;
 
   int m_port = -1;
   float m_messageFrequency = 1;
   qint64 m_messagesSent = 0;
+  qint64 m_bytesSent = 0;
+  qint64 m_statisticsBytesSent = 0;
+  double m_bytesPerSecond = 0.0;
+  QElapsedTimer m_statisticsClock;
+  double m_messagesPerSecond = 1.0;
+  QElapsedTimer m_sendClock;
 
   bool m_simulationLooped = true;
+  bool m_latencyProbeEnabled = false;
   SimulationState m_simulationState = SimulationState::Stopped;
 
   TimeUnit m_timeUnit = TimeUnit::Seconds;
+
+  // replays a capture file, written by the apps' DatagramCaptureWriter, with its original timing
+  Dsa::DatagramCaptureReader m_captureReader;
+  Dsa::DatagramCaptureReader::Record m_nextCaptureRecord;
+  bool m_hasNextCaptureRecord = false;
+  QUdpSocket* m_captureSocket = nullptr;
+  QTimer m_captureTimer;
+  QElapsedTimer m_captureClock;
+  double m_capturePlaybackTime = 0.0; // in usecs since the capture started
+  double m_captureReplaySpeed = 1.0;
 };
 
 #endif // MESSAGESIMULATORCONTROLLER_H
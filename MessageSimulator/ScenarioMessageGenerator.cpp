@@ -0,0 +1,456 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#include "ScenarioMessageGenerator.h"
+
+// dsa app headers
+#include "SimulatedMessage.h"
+
+// Qt headers
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+// STL headers
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+namespace
+{
+constexpr double s_metersPerDegree = 111320.0;
+constexpr double s_pi = 3.14159265358979323846;
+
+// entities are updated no more often than this, in seconds
+constexpr double s_minimumUpdateInterval = 0.01;
+
+// the largest number of entities in a scenario
+constexpr int s_maximumEntities = 1000000;
+
+const char* const s_scenarioFileSuffix = "scenario";
+
+// the affiliation characters of the CoT type and SIC, in the order of the affiliation weights
+const char s_cotAffiliations[] = {'f', 'h', 'n', 'u'};
+const char s_sicAffiliations[] = {'F', 'H', 'N', 'U'};
+const char* const s_affiliationNames[] = {"friendly", "hostile", "neutral", "unknown"};
+constexpr int s_affiliationCount = 4;
+
+const char* const s_cotTime = "\" time=\"";
+const char* const s_cotStart = "\" start=\"";
+const char* const s_cotStale = "\" stale=\"";
+const char* const s_cotLat = "\"><point lat=\"";
+const char* const s_cotLon = "\" lon=\"";
+const char* const s_cotCourse = "\" hae=\"0\" ce=\"10\" le=\"10\"/><detail><track course=\"";
+const char* const s_cotSpeed = "\" speed=\"";
+
+double metersPerDegreeX(double y)
+{
+  return s_metersPerDegree * std::max(std::cos(y * s_pi / 180.0), 0.01);
+}
+
+double legLength(double x1, double y1, double x2, double y2)
+{
+  return std::hypot((x2 - x1) * metersPerDegreeX((y1 + y2) / 2.0), (y2 - y1) * s_metersPerDegree);
+}
+
+QByteArray escaped(const QString& text)
+{
+  return text.toHtmlEscaped().toUtf8();
+}
+}
+
+ScenarioMessageGenerator::ScenarioMessageGenerator(const QString& filePath, QObject* parent) :
+  AbstractMessageParser(filePath, parent)
+{
+}
+
+ScenarioMessageGenerator::~ScenarioMessageGenerator()
+{
+}
+
+bool ScenarioMessageGenerator::isScenarioFile(const QString& filePath)
+{
+  return QFileInfo(filePath).suffix().compare(s_scenarioFileSuffix, Qt::CaseInsensitive) == 0;
+}
+
+// Returns the next position report of the scenario. The entities take turns in
+// proportion to their update rates, so the stream's message rate is the aggregate rate
+// of the whole scenario and the positions move with the wall clock
+QByteArray ScenarioMessageGenerator::nextMessage()
+{
+  if (!m_loaded && !loadScenario())
+    return QByteArray();
+
+  if (m_schedule.empty())
+    return QByteArray();
+
+  std::pop_heap(m_schedule.begin(), m_schedule.end(), std::greater<Due>());
+  Due& due = m_schedule.back();
+  Entity& entity = m_entities[due.m_entity];
+  due.m_time += m_groups.at(entity.m_group).m_updateInterval;
+  std::push_heap(m_schedule.begin(), m_schedule.end(), std::greater<Due>());
+
+  moveEntity(entity, m_clock.elapsed() / 1000.0);
+  updateTimestamps();
+
+  return encode(entity);
+}
+
+// The scenario is generated again from its seed on the next message
+void ScenarioMessageGenerator::reset()
+{
+  m_loaded = false;
+  m_groups.clear();
+  m_entities.clear();
+  m_schedule.clear();
+}
+
+bool ScenarioMessageGenerator::atEnd() const
+{
+  return m_loaded && m_schedule.empty();
+}
+
+int ScenarioMessageGenerator::entityCount() const
+{
+  return m_entities.size();
+}
+
+QString ScenarioMessageGenerator::messageElementName() const
+{
+  return m_format == Format::GeoMessage ? SimulatedMessage::GEOMESSAGE_ELEMENT_NAME :
+                                          SimulatedMessage::COT_ELEMENT_NAME;
+}
+
+bool ScenarioMessageGenerator::loadScenario()
+{
+  m_loaded = true;
+
+  QFile file(filePath());
+  if (!file.open(QFile::ReadOnly))
+  {
+    emit errorOccurred(tr("Failed to open ") + filePath());
+    return false;
+  }
+
+  QJsonParseError parseError;
+  const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+  if (!document.isObject())
+  {
+    emit errorOccurred(tr("Invalid scenario file ") + filePath() + ": " + parseError.errorString());
+    return false;
+  }
+
+  const QJsonObject scenario = document.object();
+  m_format = scenario.value("format").toString().compare("geomessage", Qt::CaseInsensitive) == 0 ?
+        Format::GeoMessage : Format::CoT;
+  m_staleSeconds = std::max(scenario.value("stale").toInt(120), 1);
+  m_random.seed(static_cast<std::mt19937::result_type>(scenario.value("seed").toInt(1)));
+
+  const QJsonObject area = scenario.value("area").toObject();
+  m_xMin = area.value("xmin").toDouble(-117.25);
+  m_yMin = area.value("ymin").toDouble(33.95);
+  m_xMax = area.value("xmax").toDouble(-117.05);
+  m_yMax = area.value("ymax").toDouble(34.15);
+  if (m_xMin > m_xMax)
+    std::swap(m_xMin, m_xMax);
+  if (m_yMin > m_yMax)
+    std::swap(m_yMin, m_yMax);
+
+  const QVector<double> defaultAffiliations = affiliationWeights(scenario.value("affiliations").toObject());
+  const QJsonArray groups = scenario.value("groups").toArray();
+  for (const QJsonValue& group : groups)
+  {
+    if (!addGroup(group.toObject(), defaultAffiliations))
+    {
+      reset();
+      m_loaded = true;
+      return false;
+    }
+  }
+
+  std::make_heap(m_schedule.begin(), m_schedule.end(), std::greater<Due>());
+
+  m_timestampSecond = -1;
+  m_clock.start();
+  return true;
+}
+
+bool ScenarioMessageGenerator::addGroup(const QJsonObject& groupJson, const QVector<double>& defaultAffiliations)
+{
+  Group group;
+  const QString motion = groupJson.value("motion").toString();
+  if (motion.isEmpty() || motion.compare("randomWalk", Qt::CaseInsensitive) == 0)
+    group.m_motionModel = MotionModel::RandomWalk;
+  else if (motion.compare("route", Qt::CaseInsensitive) == 0)
+    group.m_motionModel = MotionModel::Route;
+  else if (motion.compare("convoy", Qt::CaseInsensitive) == 0)
+    group.m_motionModel = MotionModel::Convoy;
+  else
+  {
+    emit errorOccurred(tr("Unknown motion model ") + motion + tr(" in ") + filePath());
+    return false;
+  }
+
+  const bool walking = group.m_motionModel == MotionModel::RandomWalk;
+  group.m_speed = std::max(groupJson.value("speed").toDouble(walking ? 1.5 : 10.0), 0.0);
+  group.m_turn = std::min(std::abs(groupJson.value("turn").toDouble(30.0)), 180.0);
+  group.m_updateInterval = std::max(groupJson.value("updateInterval").toDouble(5.0), s_minimumUpdateInterval);
+
+  if (!walking)
+  {
+    const QJsonArray waypoints = groupJson.value("waypoints").toArray();
+    for (const QJsonValue& value : waypoints)
+    {
+      const QJsonArray coordinates = value.toArray();
+      Waypoint waypoint;
+      waypoint.m_x = coordinates.at(0).toDouble();
+      waypoint.m_y = coordinates.at(1).toDouble();
+      if (!group.m_route.isEmpty())
+      {
+        const Waypoint& previous = group.m_route.constLast();
+        waypoint.m_distance = previous.m_distance + legLength(previous.m_x, previous.m_y, waypoint.m_x, waypoint.m_y);
+      }
+      group.m_route.append(waypoint);
+    }
+
+    if (group.m_route.size() < 2)
+    {
+      emit errorOccurred(tr("A route or convoy needs at least two waypoints in ") + filePath());
+      return false;
+    }
+
+    const Waypoint& first = group.m_route.constFirst();
+    const Waypoint& last = group.m_route.constLast();
+    group.m_routeLength = last.m_distance + legLength(last.m_x, last.m_y, first.m_x, first.m_y);
+    if (group.m_routeLength <= 0.0)
+    {
+      emit errorOccurred(tr("A route or convoy has no length in ") + filePath());
+      return false;
+    }
+  }
+
+  const int count = std::min(std::max(groupJson.value("count").toInt(0), 0), s_maximumEntities - m_entities.size());
+  const int convoySize = std::max(groupJson.value("convoySize").toInt(8), 1);
+  const double spacing = std::max(groupJson.value("spacing").toDouble(50.0), 0.0);
+
+  const QVector<double> weights = groupJson.contains("affiliations") ?
+        affiliationWeights(groupJson.value("affiliations").toObject()) : defaultAffiliations;
+  std::discrete_distribution<int> affiliation(weights.cbegin(), weights.cend());
+
+  QByteArray cotType = groupJson.value("cotType").toString(walking ? "a-f-G-U-C-I" : "a-f-G-E-V").toUtf8();
+  QByteArray sic = groupJson.value("sic").toString(walking ? "SFGPUCI----K---" : "SFGPEV-----K---").toUtf8();
+  const QString callsign = groupJson.value("callsign").toString(
+        group.m_motionModel == MotionModel::RandomWalk ? "Patrol" :
+        group.m_motionModel == MotionModel::Route ? "Vehicle" : "Convoy");
+
+  std::uniform_real_distribution<double> x(m_xMin, m_xMax);
+  std::uniform_real_distribution<double> y(m_yMin, m_yMax);
+  std::uniform_real_distribution<double> heading(0.0, 360.0);
+  std::uniform_real_distribution<double> routeDistance(0.0, group.m_routeLength);
+  std::uniform_real_distribution<double> due(0.0, group.m_updateInterval);
+
+  const int groupIndex = m_groups.size();
+  m_groups.append(group);
+  m_entities.reserve(m_entities.size() + count);
+  m_schedule.reserve(m_schedule.size() + static_cast<size_t>(count));
+
+  double convoyStart = 0.0;
+  for (int i = 0; i < count; ++i)
+  {
+    Entity entity;
+    entity.m_group = groupIndex;
+
+    QString name;
+    if (walking)
+    {
+      entity.m_x = x(m_random);
+      entity.m_y = y(m_random);
+      entity.m_heading = heading(m_random);
+      name = QString("%1 %2").arg(callsign).arg(i + 1);
+    }
+    else
+    {
+      if (group.m_motionModel == MotionModel::Convoy)
+      {
+        // the members of a convoy follow its leader at a fixed spacing
+        const int member = i % convoySize;
+        if (member == 0)
+          convoyStart = routeDistance(m_random);
+
+        entity.m_routeStart = convoyStart - member * spacing;
+        name = QString("%1 %2-%3").arg(callsign).arg(i / convoySize + 1).arg(member + 1);
+      }
+      else
+      {
+        entity.m_routeStart = routeDistance(m_random);
+        name = QString("%1 %2").arg(callsign).arg(i + 1);
+      }
+      routePosition(group, entity.m_routeStart, entity.m_x, entity.m_y, entity.m_heading);
+    }
+
+    const int affiliationIndex = affiliation(m_random);
+    if (cotType.size() > 2)
+      cotType[2] = s_cotAffiliations[affiliationIndex];
+    if (sic.size() > 1)
+      sic[1] = s_sicAffiliations[affiliationIndex];
+
+    const QByteArray uid = "scenario-" + QByteArray::number(m_entities.size() + 1);
+    if (m_format == Format::GeoMessage)
+    {
+      entity.m_head = "<geomessage v=\"1.0\"><_type>position_report</_type><_action>update</_action><_id>" + uid +
+          "</_id><_wkid>4326</_wkid><sic>" + escaped(QString::fromLatin1(sic)) + "</sic><uniquedesignation>" + escaped(name) +
+          "</uniquedesignation><_control_points>";
+      entity.m_tail = "</_control_points></geomessage>";
+    }
+    else
+    {
+      entity.m_head = "<event version=\"2.0\" uid=\"" + uid + "\" type=\"" + escaped(QString::fromLatin1(cotType)) + "\" how=\"m-g";
+      entity.m_tail = "\"/><contact callsign=\"" + escaped(name) + "\"/></detail></event>";
+    }
+
+    Due entityDue;
+    entityDue.m_time = due(m_random);
+    entityDue.m_entity = m_entities.size();
+    m_schedule.push_back(entityDue);
+    m_entities.append(entity);
+  }
+
+  return true;
+}
+
+void ScenarioMessageGenerator::moveEntity(Entity& entity, double now)
+{
+  const Group& group = m_groups.at(entity.m_group);
+  if (group.m_motionModel == MotionModel::RandomWalk)
+  {
+    std::uniform_real_distribution<double> turn(-group.m_turn, group.m_turn);
+    entity.m_heading = std::fmod(entity.m_heading + turn(m_random) + 360.0, 360.0);
+
+    const double distance = group.m_speed * (now - entity.m_lastUpdate);
+    const double radians = entity.m_heading * s_pi / 180.0;
+    entity.m_x += distance * std::sin(radians) / metersPerDegreeX(entity.m_y);
+    entity.m_y += distance * std::cos(radians) / s_metersPerDegree;
+
+    // walkers turn back at the edges of the area
+    if (entity.m_x < m_xMin || entity.m_x > m_xMax)
+    {
+      entity.m_x = std::min(std::max(entity.m_x, m_xMin), m_xMax);
+      entity.m_heading = 360.0 - entity.m_heading;
+    }
+    if (entity.m_y < m_yMin || entity.m_y > m_yMax)
+    {
+      entity.m_y = std::min(std::max(entity.m_y, m_yMin), m_yMax);
+      entity.m_heading = std::fmod(540.0 - entity.m_heading, 360.0);
+    }
+  }
+  else
+  {
+    routePosition(group, entity.m_routeStart + group.m_speed * now, entity.m_x, entity.m_y, entity.m_heading);
+  }
+
+  entity.m_lastUpdate = now;
+}
+
+// Routes are closed, so the distance wraps around from the last waypoint to the first
+void ScenarioMessageGenerator::routePosition(const Group& group, double distance, double& x, double& y, double& heading) const
+{
+  distance = std::fmod(distance, group.m_routeLength);
+  if (distance < 0.0)
+    distance += group.m_routeLength;
+
+  const QVector<Waypoint>& route = group.m_route;
+  const auto next = std::upper_bound(route.cbegin(), route.cend(), distance,
+                                     [](double value, const Waypoint& waypoint)
+  {
+    return value < waypoint.m_distance;
+  });
+
+  const int index = static_cast<int>(std::distance(route.cbegin(), next)) - 1;
+  const Waypoint& from = route.at(index);
+  const Waypoint& to = route.at((index + 1) % route.size());
+  const double legEnd = index + 1 < route.size() ? to.m_distance : group.m_routeLength;
+  const double fraction = legEnd > from.m_distance ? (distance - from.m_distance) / (legEnd - from.m_distance) : 0.0;
+
+  x = from.m_x + (to.m_x - from.m_x) * fraction;
+  y = from.m_y + (to.m_y - from.m_y) * fraction;
+
+  const double dx = (to.m_x - from.m_x) * metersPerDegreeX(y);
+  const double dy = (to.m_y - from.m_y) * s_metersPerDegree;
+  heading = std::fmod(std::atan2(dx, dy) * 180.0 / s_pi + 360.0, 360.0);
+}
+
+// The time strings are only rebuilt once a second
+void ScenarioMessageGenerator::updateTimestamps()
+{
+  const QDateTime now = QDateTime::currentDateTimeUtc();
+  const qint64 second = now.toSecsSinceEpoch();
+  if (second == m_timestampSecond)
+    return;
+
+  m_timestampSecond = second;
+  const QString format = QStringLiteral("yyyy-MM-dd'T'HH:mm:ss'Z'");
+  m_time = now.toString(format).toLatin1();
+  m_stale = now.addSecs(m_staleSeconds).toString(format).toLatin1();
+}
+
+// Fills in the changing values between the entity's pre-built head and tail. The buffer
+// is reused once it is no longer shared with the last result
+QByteArray ScenarioMessageGenerator::encode(const Entity& entity)
+{
+  m_buffer.truncate(0);
+  m_buffer.append(entity.m_head);
+
+  if (m_format == Format::GeoMessage)
+  {
+    m_buffer.append(QByteArray::number(entity.m_x, 'f', 6));
+    m_buffer.append(',');
+    m_buffer.append(QByteArray::number(entity.m_y, 'f', 6));
+  }
+  else
+  {
+    m_buffer.append(s_cotTime).append(m_time);
+    m_buffer.append(s_cotStart).append(m_time);
+    m_buffer.append(s_cotStale).append(m_stale);
+    m_buffer.append(s_cotLat).append(QByteArray::number(entity.m_y, 'f', 6));
+    m_buffer.append(s_cotLon).append(QByteArray::number(entity.m_x, 'f', 6));
+    m_buffer.append(s_cotCourse).append(QByteArray::number(entity.m_heading, 'f', 1));
+    m_buffer.append(s_cotSpeed).append(QByteArray::number(m_groups.at(entity.m_group).m_speed, 'f', 1));
+  }
+
+  m_buffer.append(entity.m_tail);
+  return m_buffer;
+}
+
+// Returns the relative weights of the friendly, hostile, neutral and unknown
+// affiliations, which are equal when none are given
+QVector<double> ScenarioMessageGenerator::affiliationWeights(const QJsonObject& affiliationsJson)
+{
+  QVector<double> weights(s_affiliationCount, 0.0);
+  double total = 0.0;
+  for (int i = 0; i < s_affiliationCount; ++i)
+  {
+    weights[i] = std::max(affiliationsJson.value(s_affiliationNames[i]).toDouble(0.0), 0.0);
+    total += weights[i];
+  }
+
+  if (total <= 0.0)
+    weights.fill(1.0);
+
+  return weights;
+}
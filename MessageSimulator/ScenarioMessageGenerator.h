@@ -0,0 +1,140 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef SCENARIOMESSAGEGENERATOR_H
+#define SCENARIOMESSAGEGENERATOR_H
+
+// dsa app headers
+#include "AbstractMessageParser.h"
+
+// Qt headers
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QVector>
+
+// STL headers
+#include <random>
+#include <vector>
+
+class QJsonObject;
+
+class ScenarioMessageGenerator : public AbstractMessageParser
+{
+  Q_OBJECT
+
+public:
+  explicit ScenarioMessageGenerator(const QString& filePath, QObject* parent = nullptr);
+  ~ScenarioMessageGenerator();
+
+  static bool isScenarioFile(const QString& filePath);
+
+  QByteArray nextMessage() override;
+  void reset() override;
+  bool atEnd() const override;
+
+  int entityCount() const;
+
+protected:
+  QString messageElementName() const override;
+
+private:
+  Q_DISABLE_COPY(ScenarioMessageGenerator)
+  ScenarioMessageGenerator() = delete;
+
+  enum class Format
+  {
+    CoT = 0,
+    GeoMessage = 1
+  };
+
+  enum class MotionModel
+  {
+    RandomWalk = 0,
+    Route = 1,
+    Convoy = 2
+  };
+
+  struct Waypoint
+  {
+    double m_x = 0.0;
+    double m_y = 0.0;
+    double m_distance = 0.0; // along the route to this waypoint, in meters
+  };
+
+  struct Group
+  {
+    MotionModel m_motionModel = MotionModel::RandomWalk;
+    double m_speed = 0.0; // in m/s
+    double m_turn = 0.0; // the largest change of heading at each update, in degrees
+    double m_updateInterval = 0.0; // in seconds
+    QVector<Waypoint> m_route;
+    double m_routeLength = 0.0; // in meters, including the leg back to the first waypoint
+  };
+
+  struct Entity
+  {
+    int m_group = 0;
+    double m_x = 0.0;
+    double m_y = 0.0;
+    double m_heading = 0.0;
+    double m_routeStart = 0.0; // the distance along the route at the start of the scenario, in meters
+    double m_lastUpdate = 0.0; // in seconds since the start of the scenario
+
+    // the encoding of the entity either side of its changing values
+    QByteArray m_head;
+    QByteArray m_tail;
+  };
+
+  struct Due
+  {
+    double m_time = 0.0;
+    int m_entity = 0;
+
+    bool operator>(const Due& other) const { return m_time > other.m_time; }
+  };
+
+  bool loadScenario();
+  bool addGroup(const QJsonObject& groupJson, const QVector<double>& defaultAffiliations);
+  void moveEntity(Entity& entity, double now);
+  void routePosition(const Group& group, double distance, double& x, double& y, double& heading) const;
+  void updateTimestamps();
+  QByteArray encode(const Entity& entity);
+
+  static QVector<double> affiliationWeights(const QJsonObject& affiliationsJson);
+
+  bool m_loaded = false;
+  Format m_format = Format::CoT;
+  double m_xMin = 0.0;
+  double m_yMin = 0.0;
+  double m_xMax = 0.0;
+  double m_yMax = 0.0;
+  int m_staleSeconds = 0;
+
+  std::mt19937 m_random;
+  QVector<Group> m_groups;
+  QVector<Entity> m_entities;
+
+  // a min-heap of when each entity is next due, in shares of the aggregate rate
+  std::vector<Due> m_schedule;
+
+  QElapsedTimer m_clock;
+  qint64 m_timestampSecond = -1;
+  QByteArray m_time;
+  QByteArray m_stale;
+  QByteArray m_buffer;
+};
+
+#endif // SCENARIOMESSAGEGENERATOR_H
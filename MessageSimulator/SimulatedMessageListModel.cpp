@@ -17,14 +17,31 @@
 #include "SimulatedMessageListModel.h"
 #include "SimulatedMessage.h"
 
+#include <algorithm>
+
+namespace
+{
+// pending messages are inserted into the model at most once per interval, in ms
+constexpr int s_flushInterval = 100;
+}
+
 SimulatedMessageListModel::SimulatedMessageListModel(QObject* parent) :
   QAbstractListModel(parent)
 {
   setupRoles();
+
+  m_messages.fill(nullptr, m_capacity);
+
+  m_flushTimer.setSingleShot(true);
+  m_flushTimer.setInterval(s_flushInterval);
+  connect(&m_flushTimer, &QTimer::timeout, this, &SimulatedMessageListModel::flushPendingMessages);
 }
 
 SimulatedMessageListModel::~SimulatedMessageListModel()
 {
+  qDeleteAll(m_pendingMessages);
+  for (int row = 0; row < m_count; ++row)
+    delete messageAt(row);
 }
 
 void SimulatedMessageListModel::setupRoles()
@@ -40,24 +57,124 @@ void SimulatedMessageListModel::append(SimulatedMessage* message)
   if (!message)
     return;
 
-  beginInsertRows(QModelIndex(), rowCount(), rowCount());
-
-  m_messages.append(message);
+  // only keep as many pending messages as can be displayed
+  m_pendingMessages.append(message);
+  if (m_pendingMessages.size() > m_capacity)
+    delete m_pendingMessages.takeFirst();
 
-  endInsertRows();
+  if (!m_flushTimer.isActive())
+    m_flushTimer.start();
 }
 
 void SimulatedMessageListModel::clear()
 {
+  m_flushTimer.stop();
+  qDeleteAll(m_pendingMessages);
+  m_pendingMessages.clear();
+  m_sampleCounter = 0;
+
   if (rowCount() > 0)
   {
     beginRemoveRows(QModelIndex(), 0, rowCount() - 1);
 
-    qDeleteAll(m_messages);
-    m_messages.clear();
+    for (int row = 0; row < m_count; ++row)
+      delete messageAt(row);
+
+    m_messages.fill(nullptr);
+    m_head = 0;
+    m_count = 0;
+
+    endRemoveRows();
+  }
+}
+
+int SimulatedMessageListModel::capacity() const
+{
+  return m_capacity;
+}
+
+void SimulatedMessageListModel::setCapacity(int capacity)
+{
+  if (capacity <= 0 || m_capacity == capacity)
+    return;
+
+  // drop the oldest messages which no longer fit
+  const int excess = std::max(0, m_count - capacity);
+  if (excess > 0)
+    removeRows(0, excess);
+
+  QVector<SimulatedMessage*> messages(capacity, nullptr);
+  for (int row = 0; row < m_count; ++row)
+    messages[row] = messageAt(row);
+
+  m_messages = messages;
+  m_head = 0;
+  m_capacity = capacity;
+
+  while (m_pendingMessages.size() > m_capacity)
+    delete m_pendingMessages.takeFirst();
+}
+
+int SimulatedMessageListModel::sampleInterval() const
+{
+  return m_sampleInterval;
+}
+
+// Only one in every sampleInterval messages is displayed
+void SimulatedMessageListModel::setSampleInterval(int sampleInterval)
+{
+  if (sampleInterval <= 0)
+    return;
+
+  m_sampleInterval = sampleInterval;
+  m_sampleCounter = 0;
+}
+
+// Returns true if the next message should be appended, so skipped messages need not be created
+bool SimulatedMessageListModel::acceptNextMessage()
+{
+  const bool accepted = m_sampleCounter == 0;
+  m_sampleCounter = (m_sampleCounter + 1) % m_sampleInterval;
+  return accepted;
+}
+
+void SimulatedMessageListModel::flushPendingMessages()
+{
+  if (m_pendingMessages.isEmpty())
+    return;
+
+  const int insertCount = m_pendingMessages.size();
+  const int excess = std::max(0, m_count + insertCount - m_capacity);
+  if (excess > 0)
+  {
+    beginRemoveRows(QModelIndex(), 0, excess - 1);
+
+    for (int row = 0; row < excess; ++row)
+    {
+      delete m_messages[m_head];
+      m_messages[m_head] = nullptr;
+      m_head = (m_head + 1) % m_capacity;
+    }
+    m_count -= excess;
 
     endRemoveRows();
   }
+
+  beginInsertRows(QModelIndex(), m_count, m_count + insertCount - 1);
+
+  for (SimulatedMessage* message : qAsConst(m_pendingMessages))
+  {
+    m_messages[(m_head + m_count) % m_capacity] = message;
+    ++m_count;
+  }
+  m_pendingMessages.clear();
+
+  endInsertRows();
+}
+
+SimulatedMessage* SimulatedMessageListModel::messageAt(int row) const
+{
+  return m_messages.at((m_head + row) % m_capacity);
 }
 
 Qt::ItemFlags SimulatedMessageListModel::flags(const QModelIndex& index) const
@@ -73,7 +190,7 @@ int SimulatedMessageListModel::rowCount(const QModelIndex& parent) const
   if (parent.isValid())
     return 0;
 
-  return m_messages.size();
+  return m_count;
 }
 
 QVariant SimulatedMessageListModel::data(const QModelIndex& index, int role) const
@@ -83,7 +200,7 @@ QVariant SimulatedMessageListModel::data(const QModelIndex& index, int role) con
 
   QVariant retVal;
 
-  SimulatedMessage* message = m_messages.at(index.row());
+  SimulatedMessage* message = messageAt(index.row());
   if (message)
   {
     switch (role)
@@ -115,14 +232,21 @@ bool SimulatedMessageListModel::removeRows(int row, int count, const QModelIndex
 
   beginRemoveRows(QModelIndex(), row, row + count - 1);
 
-  for (int r = row; r < row + count; ++r)
+  QVector<SimulatedMessage*> messages(m_capacity, nullptr);
+  int remaining = 0;
+  for (int r = 0; r < m_count; ++r)
   {
-    SimulatedMessage* message = m_messages.at(r);
-    m_messages.removeAt(r);
-    if (message)
+    SimulatedMessage* message = messageAt(r);
+    if (r >= row && r < row + count)
       delete message;
+    else
+      messages[remaining++] = message;
   }
 
+  m_messages = messages;
+  m_head = 0;
+  m_count = remaining;
+
   endRemoveRows();
 
   return true;
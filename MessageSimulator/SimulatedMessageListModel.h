@@ -18,6 +18,8 @@
 #define SIMULATEDMESSAGELISTMODEL_H
 
 #include <QAbstractListModel>
+#include <QTimer>
+#include <QVector>
 
 class SimulatedMessage;
 
@@ -41,6 +43,14 @@ public:
 
   void clear();
 
+  int capacity() const;
+  void setCapacity(int capacity);
+
+  int sampleInterval() const;
+  void setSampleInterval(int sampleInterval);
+
+  bool acceptNextMessage();
+
   Qt::ItemFlags flags(const QModelIndex& index) const override;
 
   int rowCount(const QModelIndex& parent = QModelIndex()) const override;
@@ -56,9 +66,23 @@ private:
   Q_DISABLE_COPY(SimulatedMessageListModel)
 
   void setupRoles();
+  void flushPendingMessages();
+  SimulatedMessage* messageAt(int row) const;
 
   QHash<int, QByteArray> m_roles;
-  QList<SimulatedMessage*> m_messages;
+
+  // ring buffer of displayed messages, oldest at m_head
+  QVector<SimulatedMessage*> m_messages;
+  int m_head = 0;
+  int m_count = 0;
+  int m_capacity = 1000;
+
+  // messages received since the last UI tick
+  QList<SimulatedMessage*> m_pendingMessages;
+  QTimer m_flushTimer;
+
+  int m_sampleInterval = 1;
+  int m_sampleCounter = 0;
 };
 
 #endif // SIMULATEDMESSAGELISTMODEL_H
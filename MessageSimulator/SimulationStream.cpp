@@ -0,0 +1,295 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#include "SimulationStream.h"
+#include "AbstractMessageParser.h"
+#include "DataSender.h"
+#include "LatencyProbe.h"
+
+#include <QTcpSocket>
+#include <QUdpSocket>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+// the longest backlog, in seconds, which is caught up after a slow scheduler tick
+constexpr double s_maximumBacklog = 0.1;
+
+// whole messages which may be owed to a slow stream, to absorb timer jitter
+constexpr double s_minimumBacklogMessages = 2.0;
+}
+
+SimulationStream::SimulationStream(const QUrl& file, Protocol protocol, const QHostAddress& address, int port, QObject* parent) :
+  QObject(parent),
+  m_file(file),
+  m_protocol(protocol),
+  m_address(protocol == Protocol::Broadcast ? QHostAddress(QHostAddress::Broadcast) : address),
+  m_port(port),
+  m_dataSender(new Dsa::DataSender(this))
+{
+}
+
+SimulationStream::~SimulationStream()
+{
+  close();
+}
+
+QUrl SimulationStream::file() const
+{
+  return m_file;
+}
+
+SimulationStream::Protocol SimulationStream::protocol() const
+{
+  return m_protocol;
+}
+
+QHostAddress SimulationStream::address() const
+{
+  return m_address;
+}
+
+int SimulationStream::port() const
+{
+  return m_port;
+}
+
+double SimulationStream::messagesPerSecond() const
+{
+  return m_messagesPerSecond;
+}
+
+void SimulationStream::setMessagesPerSecond(double messagesPerSecond)
+{
+  if (messagesPerSecond > 0.0)
+    m_messagesPerSecond = messagesPerSecond;
+}
+
+bool SimulationStream::isLooped() const
+{
+  return m_looped;
+}
+
+void SimulationStream::setLooped(bool looped)
+{
+  m_looped = looped;
+}
+
+bool SimulationStream::isLatencyProbeEnabled() const
+{
+  return m_latencyProbeEnabled;
+}
+
+// Stamps each message with its send time and a sequence number. TCP streams are
+// not stamped, as receivers frame them on the end of each event
+void SimulationStream::setLatencyProbeEnabled(bool latencyProbeEnabled)
+{
+  m_latencyProbeEnabled = latencyProbeEnabled;
+  if (!m_latencyProbeEnabled)
+    m_latencyProbe.reset();
+  else if (isOpen() && m_protocol != Protocol::Tcp && !m_latencyProbe)
+    m_latencyProbe.reset(new Dsa::LatencyProbe());
+}
+
+bool SimulationStream::open()
+{
+  close();
+
+  m_messageParser = AbstractMessageParser::createMessageParser(m_file.toLocalFile(), this);
+  if (!m_messageParser)
+  {
+    emit errorOccurred(tr("Failed to create message parser with input file ") + m_file.toLocalFile());
+    return false;
+  }
+
+  connect(m_messageParser, &AbstractMessageParser::errorOccurred, this, &SimulationStream::errorOccurred);
+
+  if (m_protocol == Protocol::Tcp)
+  {
+    m_socket = new QTcpSocket(this);
+  }
+  else
+  {
+    auto udpSocket = new QUdpSocket(this);
+    if (m_protocol == Protocol::Multicast)
+      udpSocket->setSocketOption(QAbstractSocket::MulticastTtlOption, 1);
+
+    m_socket = udpSocket;
+  }
+
+  connect(m_socket, QOverload<QAbstractSocket::SocketError>::of(&QAbstractSocket::error), this, [this]()
+  {
+    emit errorOccurred(m_socket->errorString());
+  });
+
+  m_socket->connectToHost(m_address, m_port, QIODevice::WriteOnly);
+  m_dataSender->setDevice(m_socket);
+
+  // start half a message in credit so timer jitter does not skip a slow stream's ticks
+  m_sendTokens = 0.5;
+  m_messagesSent = 0;
+  m_finished = false;
+
+  // each run starts a new probe sequence
+  m_latencyProbe.reset(m_latencyProbeEnabled && m_protocol != Protocol::Tcp ? new Dsa::LatencyProbe() : nullptr);
+
+  return true;
+}
+
+void SimulationStream::close()
+{
+  m_dataSender->setDevice(nullptr);
+
+  if (m_socket)
+  {
+    if (m_socket->isOpen())
+      m_socket->close();
+
+    delete m_socket;
+    m_socket = nullptr;
+  }
+
+  delete m_messageParser;
+  m_messageParser = nullptr;
+}
+
+bool SimulationStream::isOpen() const
+{
+  return m_socket && m_messageParser;
+}
+
+bool SimulationStream::isFinished() const
+{
+  return m_finished;
+}
+
+// Adds the messages earned over elapsedSeconds and returns how many are due now
+int SimulationStream::takeDueMessages(double elapsedSeconds)
+{
+  if (!isOpen() || m_finished)
+    return 0;
+
+  const double maximumTokens = std::max(m_messagesPerSecond * s_maximumBacklog, s_minimumBacklogMessages);
+  m_sendTokens = std::min(m_sendTokens + elapsedSeconds * m_messagesPerSecond, maximumTokens);
+
+  const int dueMessages = static_cast<int>(std::floor(m_sendTokens));
+  m_sendTokens -= dueMessages;
+
+  return dueMessages;
+}
+
+// Returns the bytes sent, or -1 if no further messages should be sent in the current burst
+qint64 SimulationStream::sendNextMessage()
+{
+  if (!isOpen() || m_finished)
+    return -1;
+
+  // a TCP stream waits for its connection rather than dropping messages
+  if (m_socket->state() != QAbstractSocket::ConnectedState)
+    return -1;
+
+  if (m_messageParser->atEnd())
+  {
+    // reached end of the message parser
+    // check if simulation is looped, if not end the stream
+    if (m_looped && m_messagesSent > 0)
+    {
+      // reset the message parser to the beginning to continue
+      // looping through messages
+      m_messageParser->reset();
+    }
+    else
+    {
+      // if no messages have been sent and we've reached the end of the parser
+      // then the simulation contains no messages
+      if (m_messagesSent == 0)
+        emit errorOccurred(tr("Simulation file contains no messages"));
+
+      m_finished = true;
+      return -1;
+    }
+  }
+
+  auto messageBytes = m_messageParser->nextMessage();
+  if (messageBytes.isEmpty())
+  {
+    emit errorOccurred(tr("Message is empty"));
+    return -1;
+  }
+
+  // the stamp is appended to a copy, leaving the mapped simulation file untouched
+  if (m_latencyProbe)
+    m_latencyProbe->stamp(messageBytes);
+
+  const qint64 bytesSent = m_dataSender->sendData(messageBytes);
+  if (bytesSent == -1)
+  {
+    emit errorOccurred(tr("Failed to send message"));
+    return -1;
+  }
+
+  m_messagesSent++;
+
+  return bytesSent;
+}
+
+qint64 SimulationStream::sendData(const QByteArray& data)
+{
+  if (!m_socket)
+    return -1;
+
+  return m_dataSender->sendData(data);
+}
+
+qint64 SimulationStream::messagesSent() const
+{
+  return m_messagesSent;
+}
+
+Dsa::DataSender* SimulationStream::dataSender() const
+{
+  return m_dataSender;
+}
+
+SimulationStream::Protocol SimulationStream::toProtocol(const QString& protocol)
+{
+  if (protocol.compare("unicast", Qt::CaseInsensitive) == 0)
+    return Protocol::Unicast;
+  else if (protocol.compare("multicast", Qt::CaseInsensitive) == 0)
+    return Protocol::Multicast;
+  else if (protocol.compare("tcp", Qt::CaseInsensitive) == 0)
+    return Protocol::Tcp;
+
+  return Protocol::Broadcast;
+}
+
+QString SimulationStream::fromProtocol(Protocol protocol)
+{
+  switch (protocol)
+  {
+  case Protocol::Unicast:
+    return QStringLiteral("unicast");
+  case Protocol::Multicast:
+    return QStringLiteral("multicast");
+  case Protocol::Tcp:
+    return QStringLiteral("tcp");
+  case Protocol::Broadcast:
+  default:
+    return QStringLiteral("broadcast");
+  }
+}
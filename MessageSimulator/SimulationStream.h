@@ -0,0 +1,105 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef SIMULATIONSTREAM_H
+#define SIMULATIONSTREAM_H
+
+#include <QHostAddress>
+#include <QObject>
+#include <QUrl>
+
+#include <memory>
+
+namespace Dsa {
+class DataSender;
+class LatencyProbe;
+}
+
+class AbstractMessageParser;
+class QAbstractSocket;
+
+class SimulationStream : public QObject
+{
+  Q_OBJECT
+
+public:
+  enum class Protocol
+  {
+    Broadcast = 0,
+    Unicast = 1,
+    Multicast = 2,
+    Tcp = 3
+  };
+
+  SimulationStream(const QUrl& file, Protocol protocol, const QHostAddress& address, int port, QObject* parent = nullptr);
+  ~SimulationStream();
+
+  QUrl file() const;
+  Protocol protocol() const;
+  QHostAddress address() const;
+  int port() const;
+
+  double messagesPerSecond() const;
+  void setMessagesPerSecond(double messagesPerSecond);
+
+  bool isLooped() const;
+  void setLooped(bool looped);
+
+  bool isLatencyProbeEnabled() const;
+  void setLatencyProbeEnabled(bool latencyProbeEnabled);
+
+  bool open();
+  void close();
+  bool isOpen() const;
+  bool isFinished() const;
+
+  int takeDueMessages(double elapsedSeconds);
+  qint64 sendNextMessage();
+  qint64 sendData(const QByteArray& data);
+
+  qint64 messagesSent() const;
+
+  Dsa::DataSender* dataSender() const;
+
+  static Protocol toProtocol(const QString& protocol);
+  static QString fromProtocol(Protocol protocol);
+
+signals:
+  void errorOccurred(const QString& error);
+
+private:
+  Q_DISABLE_COPY(SimulationStream)
+  SimulationStream() = delete;
+
+  QUrl m_file;
+  Protocol m_protocol = Protocol::Broadcast;
+  QHostAddress m_address;
+  int m_port = -1;
+
+  Dsa::DataSender* m_dataSender = nullptr;
+  AbstractMessageParser* m_messageParser = nullptr;
+  std::unique_ptr<Dsa::LatencyProbe> m_latencyProbe;
+  QAbstractSocket* m_socket = nullptr;
+
+  double m_messagesPerSecond = 1.0;
+  double m_sendTokens = 0.0;
+  qint64 m_messagesSent = 0;
+  bool m_looped = true;
+  bool m_latencyProbeEnabled = false;
+  bool m_finished = false;
+};
+
+#endif // SIMULATIONSTREAM_H
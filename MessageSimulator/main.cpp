@@ -37,6 +37,11 @@ void printHelp()
          "                         minute, and hour; default is second" << endl;
   out << "  -l                     Simulation loops through simulation file" << endl;
   out << "  -s                     Silent mode; no verbose output" << endl;
+  out << "  -e                     Embed latency probes (send time and sequence" << endl <<
+         "                         number) in the messages of UDP streams" << endl;
+  out << "  -x <stream>            Additional stream, repeatable, given as" << endl <<
+         "                         file,protocol,address,port,messages per second;" << endl <<
+         "                         protocol is broadcast, unicast, multicast or tcp" << endl;
 }
 
 int main(int argc, char *argv[])
@@ -52,6 +57,8 @@ int main(int argc, char *argv[])
   QString timeUnit = "second";
   bool isLoop = false;
   bool isVerbose = true;
+  bool isLatencyProbe = false;
+  QStringList streams;
 
   for (int i = 1; i < argc; i++)
   {
@@ -114,6 +121,17 @@ int main(int argc, char *argv[])
     {
       isVerbose = false;
     }
+    else if (!strcmp(argv[i], "-e"))
+    {
+      isLatencyProbe = true;
+    }
+    else if (!strcmp(argv[i], "-x"))
+    {
+      if ((i + 1) < argc)
+      {
+        streams.append(QString(argv[++i]));
+      }
+    }
   }
 
   if (!isGui)
@@ -146,6 +164,20 @@ int main(int argc, char *argv[])
     controller.setTimeUnit(MessageSimulatorController::toTimeUnit(timeUnit));
     controller.setPort(port);
     controller.setSimulationLooped(isLoop);
+    controller.setLatencyProbeEnabled(isLatencyProbe);
+
+    for (const QString& stream : qAsConst(streams))
+    {
+      const QStringList fields = stream.split(',');
+      if (fields.size() != 5)
+      {
+        printHelp();
+        return 0;
+      }
+
+      controller.addStream(QUrl::fromLocalFile(fields.at(0)), fields.at(1), fields.at(2), fields.at(3).toInt(), fields.at(4).toDouble());
+    }
+
     controller.startSimulation(QUrl::fromLocalFile(simulationFile));
 
     if (isVerbose)
@@ -155,8 +187,12 @@ int main(int argc, char *argv[])
       out << "UDP port: " << controller.port() << "\n";
       out << "Sending " << controller.messageFrequency() << " message per " <<
                   MessageSimulatorController::fromTimeUnit(controller.timeUnit()) << "\n";
+      if (controller.streamCount() > 0)
+        out << "Additional streams: " << controller.streamCount() << "\n";
       if (isLoop)
         out << "Simulation loop mode enabled\n";
+      if (isLatencyProbe)
+        out << "Latency probes enabled\n";
     }
 
     return app.exec();
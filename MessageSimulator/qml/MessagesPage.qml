@@ -81,6 +81,15 @@ Rectangle {
                         font.bold: true
                         color: "white"
                     }
+
+                    Text {
+                        id: statisticsHeader
+                        text: messageSimulatorController.messagesSent + qsTr(" sent\n") +
+                              (messageSimulatorController.bytesPerSecond / 1024).toFixed(1) + qsTr(" KB/s")
+                        width: messagesList.width * 0.2
+                        font.bold: true
+                        color: "white"
+                    }
                 }
             }
         }
@@ -65,7 +65,7 @@ Rectangle {
                 }
                 height: chooseFileBtn.height
 
-                placeholderText: "please choose a message file (.xml)"
+                placeholderText: "please choose a message file (.xml), scenario file (.scenario) or capture file (.dsacap)"
                 text: loader.fileUrl.toString() !== "" ? loader.fileUrl : messageSimulatorController.simulationFile
                 readOnly: true
 
@@ -242,11 +242,95 @@ Rectangle {
                 }
             }
         }
+
+        Rectangle {
+            width: settingsPage.width
+            height: 50 * scaleFactor
+            color: "steelblue"
+            radius: 4 * scaleFactor
+
+            Label {
+                id: latencyProbeLabel
+                anchors {
+                    top: parent.top
+                    bottom: parent.bottom
+                    left: parent.left
+                    margins: 8 * scaleFactor
+                }
+                width: 64 * scaleFactor
+
+                text: "probe"
+                font.bold: true
+                color: "white"
+                horizontalAlignment: Text.AlignHCenter
+                verticalAlignment: Text.AlignVCenter
+            }
+
+            CheckBox {
+                id: latencyProbeCheckBox
+                anchors {
+                    top: parent.top
+                    bottom: parent.bottom
+                    left: latencyProbeLabel.right
+                    margins: 8 * scaleFactor
+                }
+
+                font.bold: true
+                checked: messageSimulatorController.latencyProbeEnabled
+
+                onCheckedChanged: {
+                    messageSimulatorController.latencyProbeEnabled = checked;
+                }
+            }
+        }
+
+        Rectangle {
+            width: settingsPage.width
+            height: 50 * scaleFactor
+            color: "steelblue"
+            radius: 4 * scaleFactor
+
+            Label {
+                id: captureSpeedLabel
+                anchors {
+                    top: parent.top
+                    bottom: parent.bottom
+                    left: parent.left
+                    margins: 8 * scaleFactor
+                }
+                width: 64 * scaleFactor
+
+                text: "capture\nspeed"
+                font.bold: true
+                color: "white"
+                horizontalAlignment: Text.AlignHCenter
+                verticalAlignment: Text.AlignVCenter
+            }
+
+            ComboBox {
+                id: captureSpeedOptions
+                anchors {
+                    left: captureSpeedLabel.right
+                    verticalCenter: parent.verticalCenter
+                    margins: 8 * scaleFactor
+                }
+                height: 30 * scaleFactor
+                width: 100 * scaleFactor
+
+                // the multiple of the original timing at which capture files are replayed
+                model: ["0.5x", "1x", "2x", "5x", "10x"]
+                currentIndex: 1
+
+                onCurrentTextChanged: {
+                    messageSimulatorController.captureReplaySpeed = parseFloat(currentText);
+                }
+            }
+        }
     }
 
     XmlLoader {
         id: loader
-        supportedExtensions: ["xml"]
+        supportedExtensions: ["xml", "scenario", "dsacap"]
     }
 }
 
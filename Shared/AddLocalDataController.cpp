@@ -23,6 +23,11 @@
 // dsa app headers
 #include "DataItemListModel.h"
 #include "DsaUtility.h"
+#include "ElevationSourceLoader.h"
+#include "KmlFeatureCache.h"
+#include "KmlFeatureLayer.h"
+#include "LocalDataCatalog.h"
+#include "LocalDataPreprocessor.h"
 #include "MarkupLayer.h"
 
 // toolkit headers
@@ -48,7 +53,6 @@
 #include "KmlLayer.h"
 #include "LayerListModel.h"
 #include "Raster.h"
-#include "RasterElevationSource.h"
 #include "RasterLayer.h"
 #include "Scene.h"
 #include "ShapefileFeatureTable.h"
@@ -60,15 +64,48 @@
 #include <QFileInfo>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QStandardPaths>
 #include <QTextStream>
 
+// STL headers
+#include <algorithm>
+
 using namespace Esri::ArcGISRuntime;
 
 namespace Dsa
 {
 
+namespace
+{
+/*!
+  \internal
+
+  Calls \a handler once \a dataset has loaded, loading it if necessary.
+  If the dataset has already loaded, \a handler is called immediately.
+ */
+template <typename Dataset, typename Handler>
+void whenLoaded(Dataset* dataset, QObject* context, Handler handler)
+{
+  if (dataset->loadStatus() == LoadStatus::Loaded)
+  {
+    handler(Error());
+    return;
+  }
+
+  if (dataset->loadStatus() == LoadStatus::FailedToLoad)
+  {
+    handler(dataset->loadError());
+    return;
+  }
+
+  QObject::connect(dataset, &Dataset::doneLoading, context, handler);
+  dataset->load();
+}
+}
+
 const QString AddLocalDataController::LOCAL_DATAPATHS_PROPERTYNAME = "LocalDataPaths";
 const QString AddLocalDataController::DEFAULT_ELEVATION_PROPERTYNAME = "DefaultElevationSource";
+const QString AddLocalDataController::CONVERT_KML_PROPERTYNAME = "ConvertKmlLayers";
 
 const QString AddLocalDataController::s_allData = QStringLiteral("All Data (*.geodatabase *.tpk *.shp *.gpkg *.slpk *.img *.tif *.tiff *.i1, *.dt0 *.dt1 *.dt2 *.tc2 *.geotiff *.hr1 *.jpg *.jpeg *.jp2 *.ntf *.png *.i21 *.ovr *.markup *.sid *.kml *.kmz)");
 const QString AddLocalDataController::s_rasterData = QStringLiteral("Raster Files (*.img *.tif *.tiff *.I1, *.dt0 *.dt1 *.dt2 *.tc2 *.geotiff *.hr1 *.jpg *.jpeg *.jp2 *.ntf *.png *.i21 *.ovr *.sid)");
@@ -93,8 +130,33 @@ const QString AddLocalDataController::s_kmlData = QStringLiteral("KML (*.kml *.k
  */
 AddLocalDataController::AddLocalDataController(QObject* parent /* = nullptr */):
   AbstractTool(parent),
-  m_localDataModel(new DataItemListModel(this))
+  m_localDataModel(new DataItemListModel(this)),
+  m_catalog(new LocalDataCatalog(QString("%1/LocalDataCatalog.json").arg(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation)), this)),
+  m_elevationSourceLoader(new ElevationSourceLoader(QString("%1/ElevationIndex.json").arg(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation)), this)),
+  m_preprocessor(new LocalDataPreprocessor(this))
 {
+  // the model is filtered from the catalogue, which is updated as the data paths change
+  connect(m_catalog, &LocalDataCatalog::catalogChanged, this, [this]()
+  {
+    refreshLocalDataModel(m_fileType);
+  });
+
+  connect(m_elevationSourceLoader, &ElevationSourceLoader::sourcesLoaded, this, &AddLocalDataController::addElevationSources);
+  connect(m_elevationSourceLoader, &ElevationSourceLoader::errorOccurred, this, &AddLocalDataController::errorOccurred);
+  connect(m_elevationSourceLoader, &ElevationSourceLoader::rastersRejected, this, [this](const QStringList& paths)
+  {
+    emit toolErrorOccurred(QString("Skipped %1 elevation raster(s)").arg(paths.size()),
+                           QString("Could not read %1").arg(paths.first()));
+  });
+
+  // shapefiles and rasters are prepared in the background as they are added
+  connect(m_preprocessor, &LocalDataPreprocessor::progressChanged, this, &AddLocalDataController::preprocessingChanged);
+  connect(m_preprocessor, &LocalDataPreprocessor::rasterWithoutOverviews, this, [this](const QString& path, qint64 size)
+  {
+    emit toolErrorOccurred(QString("%1 has no overviews").arg(QFileInfo(path).fileName()),
+                           QString("The %1 MB raster will draw slowly when zoomed out until pyramids are built for it").arg(size / (1024 * 1024)));
+  });
+
   // add the base path to the string list
   addPathToDirectoryList(DsaUtility::dataPath());
 
@@ -135,30 +197,55 @@ void AddLocalDataController::addPathToDirectoryList(const QString& path)
   }
 
   m_dataPaths << path;
+  m_catalog->addDirectory(path);
   emit propertyChanged(LOCAL_DATAPATHS_PROPERTYNAME, m_dataPaths);
 }
 
 /*!
  \brief Refreshes the local data model with a given \a fileType.
+
+ The model is filtered from the catalogue of the data paths, which is indexed in the
+ background, so this does not read the file system.
  */
 void AddLocalDataController::refreshLocalDataModel(const QString& fileType)
 {
-  QStringList fileFilters = determineFileFilters(fileType);
-  m_localDataModel->clear();
+  m_fileType = fileType;
 
-  for (const QString& path : m_dataPaths)
-  {
-    QDir localDir(path);
-
-    if (fileFilters.length() > 0)
-      localDir.setNameFilters(fileFilters);
+  // each filter is of the form "*.extension"
+  const QStringList fileFilters = determineFileFilters(fileType);
+  QStringList suffixes;
+  suffixes.reserve(fileFilters.size());
+  for (const QString& fileFilter : fileFilters)
+    suffixes.append(fileFilter.mid(1));
 
-    for (const QString& file : localDir.entryList(QDir::Files, QDir::Name))
+  QStringList dataItems;
+  for (const QString& path : qAsConst(m_dataPaths))
+  {
+    const QList<LocalDataCatalog::Entry> entries = m_catalog->entries(path);
+    for (const LocalDataCatalog::Entry& entry : entries)
     {
-      QFileInfo fileInfo(localDir, file);
-      m_localDataModel->addDataItem(fileInfo.absoluteFilePath());
+      const bool matches = std::any_of(suffixes.cbegin(), suffixes.cend(), [&entry](const QString& suffix)
+      {
+        return entry.m_path.endsWith(suffix, Qt::CaseInsensitive);
+      });
+
+      if (matches)
+        dataItems.append(entry.m_path);
     }
   }
+
+  m_localDataModel->setDataItems(dataItems);
+}
+
+/*!
+ \brief Lists only the local data whose file names contain \a nameFilter, ignoring case.
+
+ The filter is applied to the items already in the model, so it can be set as
+ each character is typed.
+ */
+void AddLocalDataController::setNameFilter(const QString& nameFilter)
+{
+  m_localDataModel->setNameFilter(nameFilter);
 }
 
 /*!
@@ -202,6 +289,7 @@ QStringList AddLocalDataController::determineFileFilters(const QString& fileType
  */
 void AddLocalDataController::addItemAsElevationSource(const QList<int>& indices)
 {
+  QStringList tilePackagePaths;
   QStringList dataPaths;
 
   for (const int index : indices)
@@ -211,7 +299,7 @@ void AddLocalDataController::addItemAsElevationSource(const QList<int>& indices)
 
     if (dataItemType == DataType::TilePackage)
     {
-      createElevationSourceFromTpk(dataItemPath);
+      tilePackagePaths << dataItemPath;
     }
     else if (dataItemType == DataType::Raster)
     {
@@ -222,60 +310,59 @@ void AddLocalDataController::addItemAsElevationSource(const QList<int>& indices)
       continue;
   }
 
+  // the packages and rasters are loaded together and added to the scene in one go
+  m_elevationSourceLoader->load(tilePackagePaths, dataPaths);
+
   if (dataPaths.isEmpty())
     return;
 
-  createElevationSourceFromRasters(dataPaths);
-
   emit propertyChanged(DEFAULT_ELEVATION_PROPERTYNAME, dataPaths);
 }
 
 /*!
  \brief Adds the provided TPK \a path as an elevation source.
+
+ The package is opened in the background and only used if its tiles are LERC encoded.
 */
 void AddLocalDataController::createElevationSourceFromTpk(const QString& path)
 {
-  TileCache* tileCache = new TileCache(path, this);
-
-  connect(tileCache, &TileCache::doneLoading, this, [this, tileCache](Error error)
-  {
-    if (!error.isEmpty())
-      return;
-
-    // Check if the tiles are LERC encoded
-    if (tileCache->tileInfo().format() == TileImageFormat::LERC)
-    {
-      // create the source from the tiled source
-      ArcGISTiledElevationSource* source = new ArcGISTiledElevationSource(tileCache, this);
-
-      connect(source, &ArcGISTiledElevationSource::errorOccurred, this, &AddLocalDataController::errorOccurred);
-
-      auto scene = ToolResourceProvider::instance()->scene();
-      if (scene)
-        scene->baseSurface()->elevationSources()->append(source);
-
-      emit elevationSourceSelected(source);
-      emit propertyChanged(DEFAULT_ELEVATION_PROPERTYNAME, tileCache->path());
-    }
-  });
-
-  tileCache->load();
+  m_elevationSourceLoader->load(QStringList{path}, QStringList());
 }
 
 /*!
  \brief Adds the provided Raster \a paths as an elevation source.
+
+ The rasters are validated and loaded in the background, see \l ElevationSourceLoader.
 */
 void AddLocalDataController::createElevationSourceFromRasters(const QStringList& paths)
 {
-  RasterElevationSource* source = new RasterElevationSource(paths, this);
-
-  connect(source, &RasterElevationSource::errorOccurred, this, &AddLocalDataController::errorOccurred);
+  m_elevationSourceLoader->load(QStringList(), paths);
+}
 
+/*!
+ \internal
+ \brief Adds the loaded \a sources to the scene's surface in a single pass.
+*/
+void AddLocalDataController::addElevationSources(const QList<ElevationSource*>& sources)
+{
   auto scene = ToolResourceProvider::instance()->scene();
-  if (scene)
-    scene->baseSurface()->elevationSources()->append(source);
 
-  emit elevationSourceSelected(source);
+  for (ElevationSource* source : sources)
+  {
+    connect(source, &ElevationSource::errorOccurred, this, &AddLocalDataController::errorOccurred);
+
+    if (scene)
+      scene->baseSurface()->elevationSources()->append(source);
+  }
+
+  for (ElevationSource* source : sources)
+  {
+    emit elevationSourceSelected(source);
+
+    auto tiledSource = qobject_cast<ArcGISTiledElevationSource*>(source);
+    if (tiledSource && tiledSource->tileCache())
+      emit propertyChanged(DEFAULT_ELEVATION_PROPERTYNAME, tiledSource->tileCache()->path());
+  }
 }
 
 /*!
@@ -294,7 +381,12 @@ void AddLocalDataController::createMarkupLayer(const QString& path, int layerInd
 {
   MarkupLayer* markupLayer = MarkupLayer::createFromPath(path, this);
   if (!markupLayer)
+  {
+    if (!autoAdd)
+      emit layerCreationFailed(layerIndex);
+
     return;
+  }
 
   markupLayer->setVisible(visible);
   connect(markupLayer, &MarkupLayer::errorOccurred, this, &AddLocalDataController::errorOccurred);
@@ -370,6 +462,9 @@ void AddLocalDataController::addLayerFromPath(const QString& path, int layerInde
   if (!fileInfo.exists())
   {
     emit toolErrorOccurred(QString("Failed to add %1").arg(fileInfo.fileName()), QString("File not found %1").arg(path));
+    if (!autoAdd)
+      emit layerCreationFailed(layerIndex);
+
     return;
   }
 
@@ -396,6 +491,8 @@ void AddLocalDataController::addLayerFromPath(const QString& path, int layerInde
     createKmlLayer(path, layerIndex, visible, autoAdd);
   else if (rasterExtensions.contains(fileExtension.toLower()))
     createRasterLayer(path, layerIndex, visible, autoAdd);
+  else if (!autoAdd)
+    emit layerCreationFailed(layerIndex);
 }
 
 /*!
@@ -403,12 +500,13 @@ void AddLocalDataController::addLayerFromPath(const QString& path, int layerInde
  */
 void AddLocalDataController::createFeatureLayerGeodatabase(const QString& path)
 {
-  Geodatabase* gdb = new Geodatabase(path, this);
-  connect(gdb, &Geodatabase::doneLoading, this, [this, gdb](Error e)
+  Geodatabase* gdb = acquireGeodatabase(path);
+  whenLoaded(gdb, this, [this, gdb, path](Error e)
   {
     if (!e.isEmpty())
     {
       emit errorOccurred(e);
+      releaseDataset(path);
       return;
     }
 
@@ -417,6 +515,7 @@ void AddLocalDataController::createFeatureLayerGeodatabase(const QString& path)
     for (FeatureTable* featureTable : gdb->geodatabaseFeatureTables())
     {
       FeatureLayer* featureLayer = new FeatureLayer(featureTable, this);
+      retainDataset(path, featureLayer);
 
       connect(featureLayer, &FeatureLayer::errorOccurred, this, &AddLocalDataController::errorOccurred);
 
@@ -434,8 +533,9 @@ void AddLocalDataController::createFeatureLayerGeodatabase(const QString& path)
 
       emit layerSelected(featureLayer);
     }
+
+    releaseDataset(path);
   });
-  gdb->load();
 }
 
 /*!
@@ -453,16 +553,24 @@ void AddLocalDataController::createFeatureLayerGeodatabase(const QString& path)
 */
 void AddLocalDataController::createFeatureLayerGeodatabaseWithId(const QString& path, int layerIndex, int serviceLayerId, bool visible, bool autoAdd)
 {
-  Geodatabase* gdb = new Geodatabase(path, this);
-  connect(gdb, &Geodatabase::doneLoading, this, [this, gdb, serviceLayerId, visible, autoAdd, layerIndex](Error e)
+  Geodatabase* gdb = acquireGeodatabase(path);
+  whenLoaded(gdb, this, [this, gdb, path, serviceLayerId, visible, autoAdd, layerIndex](Error e)
   {
-    if (!e.isEmpty())
+    if (!e.isEmpty() || !gdb->geodatabaseFeatureTable(serviceLayerId))
     {
-      emit errorOccurred(e);
+      if (!e.isEmpty())
+        emit errorOccurred(e);
+
+      if (!autoAdd)
+        emit layerCreationFailed(layerIndex);
+
+      releaseDataset(path);
       return;
     }
 
     FeatureLayer* featureLayer = new FeatureLayer(gdb->geodatabaseFeatureTable(serviceLayerId), this);
+    retainDataset(path, featureLayer);
+    releaseDataset(path);
     featureLayer->setVisible(visible);
     connect(featureLayer, &FeatureLayer::errorOccurred, this, &AddLocalDataController::errorOccurred);
 
@@ -488,7 +596,6 @@ void AddLocalDataController::createFeatureLayerGeodatabaseWithId(const QString&
       emit layerCreated(layerIndex, featureLayer);
     }
   });
-  gdb->load();
 }
 
 /*!
@@ -506,17 +613,25 @@ void AddLocalDataController::createFeatureLayerGeodatabaseWithId(const QString&
 */
 void AddLocalDataController::createFeatureLayerGeoPackage(const QString& path, int layerIndex, int id, bool visible, bool autoAdd)
 {
-  GeoPackage* geoPackage = new GeoPackage(path, this);
+  GeoPackage* geoPackage = acquireGeoPackage(path);
 
-  connect(geoPackage, &GeoPackage::doneLoading, this, [this, geoPackage, id, visible, autoAdd, layerIndex](Error e)
+  whenLoaded(geoPackage, this, [this, geoPackage, path, id, visible, autoAdd, layerIndex](Error e)
   {
-    if (!e.isEmpty())
+    if (!e.isEmpty() || id < 0 || id >= geoPackage->geoPackageFeatureTables().size())
     {
-      emit errorOccurred(e);
+      if (!e.isEmpty())
+        emit errorOccurred(e);
+
+      if (!autoAdd)
+        emit layerCreationFailed(layerIndex);
+
+      releaseDataset(path);
       return;
     }
 
     FeatureLayer* featureLayer = new FeatureLayer(geoPackage->geoPackageFeatureTables().at(id), this);
+    retainDataset(path, featureLayer);
+    releaseDataset(path);
     featureLayer->setVisible(visible);
     connect(featureLayer, &FeatureLayer::errorOccurred, this, &AddLocalDataController::errorOccurred);
 
@@ -540,8 +655,6 @@ void AddLocalDataController::createFeatureLayerGeoPackage(const QString& path, i
       emit layerCreated(layerIndex, featureLayer);
     }
   });
-
-  geoPackage->load();
 }
 
 /*!
@@ -559,17 +672,25 @@ void AddLocalDataController::createFeatureLayerGeoPackage(const QString& path, i
 */
 void AddLocalDataController::createRasterLayerGeoPackage(const QString& path, int layerIndex, int id, bool visible, bool autoAdd)
 {
-  GeoPackage* geoPackage = new GeoPackage(path, this);
+  GeoPackage* geoPackage = acquireGeoPackage(path);
 
-  connect(geoPackage, &GeoPackage::doneLoading, this, [this, geoPackage, id, visible, autoAdd, layerIndex](Error e)
+  whenLoaded(geoPackage, this, [this, geoPackage, path, id, visible, autoAdd, layerIndex](Error e)
   {
-    if (!e.isEmpty())
+    if (!e.isEmpty() || id < 0 || id >= geoPackage->geoPackageRasters().size())
     {
-      emit errorOccurred(e);
+      if (!e.isEmpty())
+        emit errorOccurred(e);
+
+      if (!autoAdd)
+        emit layerCreationFailed(layerIndex);
+
+      releaseDataset(path);
       return;
     }
 
     RasterLayer* rasterLayer = new RasterLayer(geoPackage->geoPackageRasters().at(id), this);
+    retainDataset(path, rasterLayer);
+    releaseDataset(path);
     connect(rasterLayer, &RasterLayer::errorOccurred, this, &AddLocalDataController::errorOccurred);
     rasterLayer->setVisible(visible);
 
@@ -587,8 +708,6 @@ void AddLocalDataController::createRasterLayerGeoPackage(const QString& path, in
       emit layerCreated(layerIndex, rasterLayer);
     }
   });
-
-  geoPackage->load();
 }
 
 /*!
@@ -596,13 +715,14 @@ void AddLocalDataController::createRasterLayerGeoPackage(const QString& path, in
  */
 void AddLocalDataController::createLayerGeoPackage(const QString& path)
 {
-  GeoPackage* geoPackage = new GeoPackage(path, this);
+  GeoPackage* geoPackage = acquireGeoPackage(path);
 
-  connect(geoPackage, &GeoPackage::doneLoading, this, [this, geoPackage](Error e)
+  whenLoaded(geoPackage, this, [this, geoPackage, path](Error e)
   {
     if (!e.isEmpty())
     {
       emit errorOccurred(e);
+      releaseDataset(path);
       return;
     }
 
@@ -611,6 +731,7 @@ void AddLocalDataController::createLayerGeoPackage(const QString& path)
     for (const auto& table : geoPackage->geoPackageFeatureTables())
     {
       FeatureLayer* featureLayer = new FeatureLayer(table, this);
+      retainDataset(path, featureLayer);
       connect(featureLayer, &FeatureLayer::errorOccurred, this, &AddLocalDataController::errorOccurred);
 
       connect(featureLayer, &FeatureLayer::doneLoading, this, [featureLayer](Error loadError)
@@ -631,15 +752,16 @@ void AddLocalDataController::createLayerGeoPackage(const QString& path)
     for (const auto& raster : geoPackage->geoPackageRasters())
     {
       RasterLayer* rasterLayer = new RasterLayer(raster, this);
+      retainDataset(path, rasterLayer);
       connect(rasterLayer, &RasterLayer::errorOccurred, this, &AddLocalDataController::errorOccurred);
       if (operationalLayers)
         operationalLayers->append(rasterLayer);
 
       emit layerSelected(rasterLayer);
     }
-  });
 
-  geoPackage->load();
+    releaseDataset(path);
+  });
 }
 
 /*!
@@ -660,6 +782,7 @@ void AddLocalDataController::createFeatureLayerShapefile(const QString& path, in
   FeatureLayer* featureLayer = new FeatureLayer(shpFt, this);
   featureLayer->setVisible(visible);
   connect(featureLayer, &FeatureLayer::errorOccurred, this, &AddLocalDataController::errorOccurred);
+  m_preprocessor->preprocessShapefile(featureLayer);
 
   connect(featureLayer, &FeatureLayer::doneLoading, this, [featureLayer](Error loadError)
   {
@@ -704,6 +827,7 @@ void AddLocalDataController::createRasterLayer(const QString& path, int layerInd
   RasterLayer* rasterLayer = new RasterLayer(raster, this);
   rasterLayer->setVisible(visible);
   connect(rasterLayer, &RasterLayer::errorOccurred, this, &AddLocalDataController::errorOccurred);
+  m_preprocessor->preprocessRaster(path);
 
   if (autoAdd)
   {
@@ -830,12 +954,46 @@ void AddLocalDataController::createTiledLayer(const QString& path, int layerInde
  \endlist
 */void AddLocalDataController::createKmlLayer(const QString& path, int layerIndex, bool visible, bool autoAdd)
 {
+  // a KML file which has been converted is drawn from the cache instead of being parsed again
+  QJsonObject cachedDocument;
+  if (m_convertKml && KmlFeatureCache::instance()->read(path, cachedDocument))
+  {
+    KmlFeatureLayer* kmlFeatureLayer = KmlFeatureLayer::createFromDocument(path, cachedDocument, this);
+    kmlFeatureLayer->setVisible(visible);
+    connect(kmlFeatureLayer, &KmlFeatureLayer::errorOccurred, this, &AddLocalDataController::errorOccurred);
+
+    if (autoAdd)
+    {
+      auto operationalLayers = ToolResourceProvider::instance()->operationalLayers();
+      if (operationalLayers)
+        operationalLayers->append(kmlFeatureLayer);
+
+      emit layerSelected(kmlFeatureLayer);
+    }
+    else
+    {
+      emit layerCreated(layerIndex, kmlFeatureLayer);
+    }
+
+    return;
+  }
+
   KmlDataset* kmlDataset = new KmlDataset(QUrl::fromLocalFile(path), this);
   connect(kmlDataset, &KmlDataset::errorOccurred, this, &AddLocalDataController::errorOccurred);
   KmlLayer* kmlLayer = new KmlLayer(kmlDataset, this);
   kmlLayer->setVisible(visible);
   connect(kmlLayer, &KmlLayer::errorOccurred, this, &AddLocalDataController::errorOccurred);
 
+  // convert the placemarks once they have been parsed, for the next launch
+  if (m_convertKml)
+  {
+    connect(kmlDataset, &KmlDataset::doneLoading, this, [kmlDataset, path](Error loadError)
+    {
+      if (loadError.isEmpty())
+        KmlFeatureCache::instance()->store(path, kmlDataset);
+    });
+  }
+
   if (autoAdd)
   {
     auto operationalLayers = ToolResourceProvider::instance()->operationalLayers();
@@ -850,6 +1008,103 @@ void AddLocalDataController::createTiledLayer(const QString& path, int layerInde
   }
 }
 
+/*!
+ \internal
+
+ Returns the Geodatabase at \a path, opening it if no layer is using it already,
+ and adds a reference to it.
+
+ Every layer created from a geodatabase shares the one instance, so the file is
+ opened and loaded once. Call \l releaseDataset once the reference is no longer needed.
+*/
+Geodatabase* AddLocalDataController::acquireGeodatabase(const QString& path)
+{
+  SharedDataset& sharedDataset = m_sharedDatasets[QFileInfo(path).absoluteFilePath()];
+  if (!sharedDataset.m_dataset)
+    sharedDataset.m_dataset = new Geodatabase(path, this);
+
+  sharedDataset.m_referenceCount++;
+  return static_cast<Geodatabase*>(sharedDataset.m_dataset);
+}
+
+/*!
+ \internal
+
+ Returns the GeoPackage at \a path, opening it if no layer is using it already,
+ and adds a reference to it.
+
+ Call \l releaseDataset once the reference is no longer needed.
+*/
+GeoPackage* AddLocalDataController::acquireGeoPackage(const QString& path)
+{
+  SharedDataset& sharedDataset = m_sharedDatasets[QFileInfo(path).absoluteFilePath()];
+  if (!sharedDataset.m_dataset)
+    sharedDataset.m_dataset = new GeoPackage(path, this);
+
+  sharedDataset.m_referenceCount++;
+  return static_cast<GeoPackage*>(sharedDataset.m_dataset);
+}
+
+/*!
+ \internal
+
+ Adds a reference to the shared dataset at \a path which is held until \a layer,
+ which uses one of its tables or rasters, is deleted.
+*/
+void AddLocalDataController::retainDataset(const QString& path, Layer* layer)
+{
+  auto findIt = m_sharedDatasets.find(QFileInfo(path).absoluteFilePath());
+  if (findIt == m_sharedDatasets.end())
+    return;
+
+  findIt.value().m_referenceCount++;
+  connect(layer, &QObject::destroyed, this, [this, path]()
+  {
+    releaseDataset(path);
+  });
+}
+
+/*!
+ \internal
+
+ Releases a reference to the shared dataset at \a path.
+
+ The dataset is closed when the last reference is released, so it is opened again
+ by the next layer requested from it. This also lets a dataset which failed to load
+ be retried.
+*/
+void AddLocalDataController::releaseDataset(const QString& path)
+{
+  auto findIt = m_sharedDatasets.find(QFileInfo(path).absoluteFilePath());
+  if (findIt == m_sharedDatasets.end())
+    return;
+
+  if (--findIt.value().m_referenceCount > 0)
+    return;
+
+  // may be released from the dataset's own doneLoading signal
+  findIt.value().m_dataset->deleteLater();
+  m_sharedDatasets.erase(findIt);
+}
+
+/*!
+ \property AddLocalDataController::preprocessing
+ \brief Returns whether added shapefiles or rasters are being prepared in the background.
+ */
+bool AddLocalDataController::isPreprocessing() const
+{
+  return m_preprocessor->isProcessing();
+}
+
+/*!
+ \property AddLocalDataController::preprocessingProgress
+ \brief Returns the fraction of the background preparation which has completed, from 0 to 1.
+ */
+double AddLocalDataController::preprocessingProgress() const
+{
+  return m_preprocessor->progress();
+}
+
 /*!
  \brief Returns the tool's name.
 */
@@ -863,6 +1118,9 @@ QString AddLocalDataController::toolName() const
 */
 void AddLocalDataController::setProperties(const QVariantMap& properties)
 {
+  if (properties.contains(CONVERT_KML_PROPERTYNAME))
+    m_convertKml = properties.value(CONVERT_KML_PROPERTYNAME).toBool();
+
   const QStringList filePaths = properties[LOCAL_DATAPATHS_PROPERTYNAME].toStringList();
   if (filePaths.empty())
     return;
@@ -908,6 +1166,12 @@ void AddLocalDataController::setProperties(const QVariantMap& properties)
   \brief Signal emitted when an elevation \a source is selected.
  */
 
+/*!
+  \fn void AddLocalDataController::preprocessingChanged();
+
+  \brief Signal emitted when the background preparation of added data starts, progresses or finishes.
+ */
+
 /*!
   \fn void AddLocalDataController::layerCreated(int i, Esri::ArcGISRuntime::Layer* layer);
 
@@ -916,6 +1180,14 @@ void AddLocalDataController::setProperties(const QVariantMap& properties)
   The index of the layer in the operational layer list is passed through as \a i.
  */
 
+/*!
+  \fn void AddLocalDataController::layerCreationFailed(int layerIndex);
+
+  \brief Signal emitted when a layer requested with \c autoAdd set to \c false could not be created.
+
+  The \a layerIndex the layer was requested for is passed through as a parameter.
+ */
+
 /*!
   \fn void AddLocalDataController::toolErrorOccurred(const QString& errorMessage, const QString& additionalMessage);
 
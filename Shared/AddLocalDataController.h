@@ -22,18 +22,24 @@
 
 // Qt headers
 #include <QAbstractListModel>
+#include <QHash>
 #include <QStringList>
 
 namespace Esri {
 namespace ArcGISRuntime {
   class Layer;
   class ElevationSource;
+  class GeoPackage;
+  class Geodatabase;
 }
 }
 
 namespace Dsa {
 
 class DataItemListModel;
+class ElevationSourceLoader;
+class LocalDataCatalog;
+class LocalDataPreprocessor;
 
 class AddLocalDataController : public AbstractTool
 {
@@ -41,17 +47,24 @@ class AddLocalDataController : public AbstractTool
 
   Q_PROPERTY(QAbstractListModel* localDataModel READ localDataModel NOTIFY localDataModelChanged)
   Q_PROPERTY(QStringList fileFilterList READ fileFilterList NOTIFY fileFilterListChanged)
+  Q_PROPERTY(bool preprocessing READ isPreprocessing NOTIFY preprocessingChanged)
+  Q_PROPERTY(double preprocessingProgress READ preprocessingProgress NOTIFY preprocessingChanged)
 
 public:
+  static const QString CONVERT_KML_PROPERTYNAME;
+
   explicit AddLocalDataController(QObject* parent = nullptr);
   ~AddLocalDataController() = default;
 
   Q_INVOKABLE void addPathToDirectoryList(const QString& path);
   Q_INVOKABLE void refreshLocalDataModel(const QString& fileType = "All");
+  Q_INVOKABLE void setNameFilter(const QString& nameFilter);
   Q_INVOKABLE void addItemAsLayer(const QList<int>& index);
   Q_INVOKABLE void addLayerFromPath(const QString& path, int layerIndex = -1, bool visible = true, bool autoAdd = true);
   Q_INVOKABLE void addItemAsElevationSource(const QList<int>& indices);
   QAbstractListModel* localDataModel() const;
+  bool isPreprocessing() const;
+  double preprocessingProgress() const;
 
   QString toolName() const override;
   void setProperties(const QVariantMap& properties) override;
@@ -78,11 +91,18 @@ signals:
   void layerSelected(Esri::ArcGISRuntime::Layer* layer);
   void elevationSourceSelected(Esri::ArcGISRuntime::ElevationSource* source);
   void fileFilterListChanged();
+  void preprocessingChanged();
   void layerCreated(int i, Esri::ArcGISRuntime::Layer* layer);
+  void layerCreationFailed(int layerIndex);
   void toolErrorOccurred(const QString& errorMessage, const QString& additionalMessage);
 
 private:
   QStringList determineFileFilters(const QString& fileType);
+  void addElevationSources(const QList<Esri::ArcGISRuntime::ElevationSource*>& sources);
+  Esri::ArcGISRuntime::Geodatabase* acquireGeodatabase(const QString& path);
+  Esri::ArcGISRuntime::GeoPackage* acquireGeoPackage(const QString& path);
+  void retainDataset(const QString& path, Esri::ArcGISRuntime::Layer* layer);
+  void releaseDataset(const QString& path);
   QStringList fileFilterList() const { return m_fileFilterList; }
   static const QString allData() { return s_allData; }
   static const QString rasterData() { return s_rasterData; }
@@ -99,6 +119,20 @@ private:
   DataItemListModel* m_localDataModel;
   QStringList m_dataPaths;
   QStringList m_fileFilterList;
+  LocalDataCatalog* m_catalog = nullptr;
+  ElevationSourceLoader* m_elevationSourceLoader = nullptr;
+  LocalDataPreprocessor* m_preprocessor = nullptr;
+  QString m_fileType = QStringLiteral("All");
+  bool m_convertKml = false;
+
+  // the geodatabases and geopackages shared by the layers created from them, keyed by path
+  struct SharedDataset
+  {
+    QObject* m_dataset = nullptr;
+    int m_referenceCount = 0;
+  };
+  QHash<QString, SharedDataset> m_sharedDatasets;
+
   static const QString s_allData;
   static const QString s_rasterData;
   static const QString s_geodatabaseData;
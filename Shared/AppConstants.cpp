@@ -29,5 +29,18 @@ const QString AppConstants::LAYERS_PROPERTYNAME = QStringLiteral("Layers");
 const QString AppConstants::CURRENTSCENE_PROPERTYNAME = QStringLiteral("CurrentPackage");
 const QString AppConstants::SCENEINDEX_PROPERTYNAME = QStringLiteral("SceneIndex");
 const QString AppConstants::INITIALLOCATION_PROPERTYNAME = QStringLiteral("InitialLocation");
+const QString AppConstants::STARTUP_TRACE_PROPERTYNAME = QStringLiteral("StartupTracePath");
+const QString AppConstants::PERFORMANCE_HUD_PROPERTYNAME = QStringLiteral("ShowPerformanceHud");
+const QString AppConstants::PERFORMANCE_TRACING_PROPERTYNAME = QStringLiteral("PerformanceTracing");
+const QString AppConstants::MEMORY_BUDGET_PROPERTYNAME = QStringLiteral("MemoryBudget");
+const QString AppConstants::SCENE_LAYER_QUALITY_PROPERTYNAME = QStringLiteral("SceneLayerQuality");
+const QString AppConstants::SCENE_MEMORY_BUDGET_PROPERTYNAME = QStringLiteral("SceneMemoryBudget");
+const QString AppConstants::STALL_THRESHOLD_PROPERTYNAME = QStringLiteral("StallThreshold");
+const QString AppConstants::METRICS_EXPORT_PROPERTYNAME = QStringLiteral("MetricsExport");
+const QString AppConstants::IDLE_FRAME_RATE_PROPERTYNAME = QStringLiteral("IdleFrameRate");
+const QString AppConstants::PERFORMANCE_PROFILE_PROPERTYNAME = QStringLiteral("PerformanceProfile");
+const QString AppConstants::VIEW_MODE_PROPERTYNAME = QStringLiteral("ViewMode");
+const QString AppConstants::VIEW_MODE_2D = QStringLiteral("2D");
+const QString AppConstants::VIEW_MODE_3D = QStringLiteral("3D");
 
 } // Dsa
@@ -32,6 +32,19 @@ public:
   static const QString CURRENTSCENE_PROPERTYNAME;
   static const QString SCENEINDEX_PROPERTYNAME;
   static const QString INITIALLOCATION_PROPERTYNAME;
+  static const QString STARTUP_TRACE_PROPERTYNAME;
+  static const QString PERFORMANCE_HUD_PROPERTYNAME;
+  static const QString PERFORMANCE_TRACING_PROPERTYNAME;
+  static const QString MEMORY_BUDGET_PROPERTYNAME;
+  static const QString SCENE_LAYER_QUALITY_PROPERTYNAME;
+  static const QString SCENE_MEMORY_BUDGET_PROPERTYNAME;
+  static const QString STALL_THRESHOLD_PROPERTYNAME;
+  static const QString METRICS_EXPORT_PROPERTYNAME;
+  static const QString IDLE_FRAME_RATE_PROPERTYNAME;
+  static const QString PERFORMANCE_PROFILE_PROPERTYNAME;
+  static const QString VIEW_MODE_PROPERTYNAME;
+  static const QString VIEW_MODE_2D;
+  static const QString VIEW_MODE_3D;
 };
 
 } // Dsa
@@ -21,6 +21,8 @@
 #include "BasemapPickerController.h"
 
 // dsa app headers
+#include "DataItemListModel.h"
+#include "LocalDataCatalog.h"
 #include "TileCacheListModel.h"
 
 // toolkit headers
@@ -30,9 +32,13 @@
 // C++ API headers
 #include "ArcGISTiledLayer.h"
 #include "Basemap.h"
+#include "LayerListModel.h"
+#include "TileCache.h"
 
 // Qt headers
 #include <QDir>
+#include <QFileInfo>
+#include <QStandardPaths>
 
 using namespace Esri::ArcGISRuntime;
 
@@ -47,6 +53,15 @@ const QString BasemapPickerController::BASEMAP_DIRECTORY_PROPERTYNAME = "Basemap
   \inherits Dsa::AbstractTool
   \brief Tool controller for setting a basemap for the app.
 
+  The basemap directory is indexed on a background thread by a \l LocalDataCatalog,
+  whose saved entries let the basemaps be listed as soon as the app starts. The list
+  is updated when the directory changes.
+
+  A selected basemap is only set once its layer has loaded, so the previous basemap
+  keeps drawing in the meantime. Once a basemap is shown, the one most likely to be
+  chosen next - the previous basemap, or else the next in the list - is loaded in
+  the background so that switching to it is immediate.
+
   \sa Esri::ArcGISRuntime::Basemap
  */
 
@@ -55,9 +70,25 @@ const QString BasemapPickerController::BASEMAP_DIRECTORY_PROPERTYNAME = "Basemap
  */
 BasemapPickerController::BasemapPickerController(QObject* parent /* = nullptr */):
   AbstractTool(parent),
-  m_tileCacheModel(new TileCacheListModel(this))
+  m_tileCacheModel(new TileCacheListModel(this)),
+  m_catalog(new LocalDataCatalog(QString("%1/BasemapCatalog.json").arg(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation)), this))
 {
   connect(this, &BasemapPickerController::basemapsDataPathChanged, this, &BasemapPickerController::onBasemapDataPathChanged);
+  connect(m_catalog, &LocalDataCatalog::catalogChanged, this, &BasemapPickerController::updateBasemaps);
+
+  // the errors for an empty directory or a missing default wait for it to be indexed
+  connect(m_catalog, &LocalDataCatalog::indexingChanged, this, [this]()
+  {
+    if (m_catalog->isIndexing())
+      return;
+
+    updateBasemaps();
+
+    if (m_tileCachePaths.isEmpty())
+      emit toolErrorOccurred(QString("Empty Basemaps dir %1").arg(QDir(m_catalogDirectory).dirName()), QString("No .tpk files in %1").arg(m_catalogDirectory));
+    else if (!m_foundDefaultBasemap)
+      emit toolErrorOccurred(QString("Default Basemap not found: %1").arg(m_defaultBasemap), QString("Failed to find %1").arg(m_defaultBasemap));
+  });
 
   ToolManager::instance().addTool(this);
 }
@@ -97,12 +128,18 @@ void BasemapPickerController::setDefaultBasemap(const QString& defaultBasemap)
 /*!
   \brief Handle changes to the basemap data path.
 
-  When the path is changed, a list of tile cache files (.tpk) located
-  in the directory is built up.
+  When the path is changed, the directory is indexed in the background and the
+  tile cache files (.tpk) already known to be in it are listed.
  */
 void BasemapPickerController::onBasemapDataPathChanged()
 {
-  m_tileCacheModel->clear();
+  if (m_catalogDirectory != m_basemapDataPath)
+  {
+    m_catalog->removeDirectory(m_catalogDirectory);
+    m_catalogDirectory = m_basemapDataPath;
+    m_tileCachePaths.clear();
+    m_tileCacheModel->clear();
+  }
 
   QDir basemapsDir(m_basemapDataPath);
   if (!basemapsDir.exists())
@@ -111,34 +148,51 @@ void BasemapPickerController::onBasemapDataPathChanged()
     return;
   }
 
-  basemapsDir.setFilter(QDir::Files | QDir::Hidden | QDir::NoSymLinks);
-  basemapsDir.setNameFilters(QStringList{"*.tpk"});
+  m_catalog->addDirectory(m_basemapDataPath);
+  updateBasemaps();
+}
+
+/*!
+  \internal
 
-  QFileInfoList list = basemapsDir.entryInfoList();
-  if (list.isEmpty())
+  Lists the tile caches catalogued in the basemap directory, if they have changed,
+  and shows the initial basemap if it was requested before any were known.
+ */
+void BasemapPickerController::updateBasemaps()
+{
+  QStringList tileCachePaths;
+  const QList<LocalDataCatalog::Entry> entries = m_catalog->entries(m_catalogDirectory);
+  for (const LocalDataCatalog::Entry& entry : entries)
   {
-    emit toolErrorOccurred(QString("Empty Basemaps dir %1").arg(basemapsDir.dirName()), QString("No .tpk files in %1").arg(m_basemapDataPath));
-    return;
+    if (entry.m_dataType == DataType::TilePackage)
+      tileCachePaths.append(entry.m_path);
   }
 
+  if (tileCachePaths == m_tileCachePaths)
+    return;
+
+  m_tileCachePaths = tileCachePaths;
+  m_tileCacheModel->clear();
+
   int index = -1;
-  bool foundDefault = false;
-  for (const QFileInfo& fInfo : list)
+  m_foundDefaultBasemap = false;
+  for (const QString& tileCachePath : qAsConst(tileCachePaths))
   {
-    if (m_tileCacheModel->append(fInfo.filePath()))
+    if (m_tileCacheModel->append(tileCachePath))
       index++;
 
-    if(!foundDefault && fInfo.completeBaseName().compare(m_defaultBasemap, Qt::CaseInsensitive) == 0)
+    if(!m_foundDefaultBasemap && QFileInfo(tileCachePath).completeBaseName().compare(m_defaultBasemap, Qt::CaseInsensitive) == 0)
     {
       m_defaultBasemapIndex = index;
-      foundDefault = true;
+      m_foundDefaultBasemap = true;
     }
   }
 
-  if (!foundDefault)
-    emit toolErrorOccurred(QString("Default Basemap not found: %1").arg(m_defaultBasemap), QString("Failed to find %1").arg(m_defaultBasemap));
-
   emit tileCacheModelChanged();
+
+  // wait for the whole directory if the default basemap may still be found
+  if (m_initialBasemapRequested && (m_foundDefaultBasemap || !m_catalog->isIndexing()))
+    selectInitialBasemap();
 }
 
 /*!
@@ -153,7 +207,7 @@ QAbstractListModel* BasemapPickerController::tileCacheModel() const
 
 /*!
   \brief Selects the basemap at index \a row in the \l tileCacheModel and
-  sets it on the view.
+  sets it on the view once it has loaded.
  */
 void BasemapPickerController::basemapSelected(int row)
 {
@@ -161,25 +215,138 @@ void BasemapPickerController::basemapSelected(int row)
   if (!tileCache)
     return;
 
-  Basemap* selectedBasemap = new Basemap(new ArcGISTiledLayer(tileCache, this), this);
-  connect(selectedBasemap, &Basemap::errorOccurred, this, &BasemapPickerController::errorOccurred);
+  const QString basemapName = m_tileCacheModel->tileCacheNameAt(row);
+  setDefaultBasemap(basemapName);
 
-  ToolResourceProvider::instance()->setBasemap(selectedBasemap);
+  // a later selection replaces one which is still loading
+  discardBasemap(m_pendingBasemap);
 
-  const QString basemapName = m_tileCacheModel->tileCacheNameAt(row);
+  if (m_preloadedBasemap.m_path == tileCache->path())
+  {
+    m_pendingBasemap = m_preloadedBasemap;
+    m_preloadedBasemap = WarmBasemap();
+  }
+  else
+  {
+    m_pendingBasemap = createBasemap(tileCache);
+  }
 
-  setDefaultBasemap(basemapName);
-  emit basemapChanged(selectedBasemap, basemapName);
+  ArcGISTiledLayer* layer = m_pendingBasemap.m_layer;
+  if (layer->loadStatus() == LoadStatus::Loaded || layer->loadStatus() == LoadStatus::FailedToLoad)
+  {
+    showBasemap(basemapName);
+    return;
+  }
+
+  // a failed layer is still shown, so that its error is reported as before
+  connect(layer, &ArcGISTiledLayer::doneLoading, this, [this, layer, basemapName](Error)
+  {
+    if (m_pendingBasemap.m_layer == layer)
+      showBasemap(basemapName);
+  });
+  layer->load();
 }
 
 /*!
   \brief Selects the initial basemap.
+
+  If the basemap directory has not been indexed yet, the basemap is selected once it has.
  */
 void BasemapPickerController::selectInitialBasemap()
 {
+  if (m_tileCacheModel->rowCount(QModelIndex()) == 0)
+  {
+    m_initialBasemapRequested = true;
+    return;
+  }
+
+  m_initialBasemapRequested = false;
   basemapSelected(m_defaultBasemapIndex);
 }
 
+/*!
+  \internal
+
+  Returns a new basemap drawing \a tileCache.
+ */
+BasemapPickerController::WarmBasemap BasemapPickerController::createBasemap(TileCache* tileCache)
+{
+  WarmBasemap warmBasemap;
+  warmBasemap.m_path = tileCache->path();
+  warmBasemap.m_layer = new ArcGISTiledLayer(tileCache, this);
+  warmBasemap.m_basemap = new Basemap(warmBasemap.m_layer, this);
+  connect(warmBasemap.m_basemap, &Basemap::errorOccurred, this, &BasemapPickerController::errorOccurred);
+
+  return warmBasemap;
+}
+
+/*!
+  \internal
+
+  Sets the pending basemap, called \a name, on the view and starts loading the next.
+ */
+void BasemapPickerController::showBasemap(const QString& name)
+{
+  Basemap* basemap = m_pendingBasemap.m_basemap;
+  if (m_currentPath != m_pendingBasemap.m_path)
+  {
+    m_previousPath = m_currentPath;
+    m_currentPath = m_pendingBasemap.m_path;
+  }
+  m_pendingBasemap = WarmBasemap();
+
+  ToolResourceProvider::instance()->setBasemap(basemap);
+  emit basemapChanged(basemap, name);
+
+  preloadNextBasemap();
+}
+
+/*!
+  \internal
+
+  Loads the basemap most likely to be selected next: the previous basemap, or
+  the one after the current basemap in the list.
+ */
+void BasemapPickerController::preloadNextBasemap()
+{
+  const int rowCount = m_tileCacheModel->rowCount(QModelIndex());
+  if (rowCount < 2)
+    return;
+
+  int currentRow = -1;
+  int previousRow = -1;
+  for (int row = 0; row < rowCount; ++row)
+  {
+    const QString path = m_tileCacheModel->tileCacheAt(row)->path();
+    if (path == m_currentPath)
+      currentRow = row;
+    else if (path == m_previousPath)
+      previousRow = row;
+  }
+
+  const int nextRow = previousRow >= 0 ? previousRow : (currentRow + 1) % rowCount;
+  TileCache* tileCache = m_tileCacheModel->tileCacheAt(nextRow);
+  if (!tileCache || tileCache->path() == m_currentPath || tileCache->path() == m_preloadedBasemap.m_path)
+    return;
+
+  discardBasemap(m_preloadedBasemap);
+  m_preloadedBasemap = createBasemap(tileCache);
+  m_preloadedBasemap.m_layer->load();
+}
+
+/*!
+  \internal
+
+  Deletes \a warmBasemap, which has not been set on the view.
+ */
+void BasemapPickerController::discardBasemap(WarmBasemap& warmBasemap)
+{
+  if (warmBasemap.m_basemap)
+    warmBasemap.m_basemap->deleteLater();
+
+  warmBasemap = WarmBasemap();
+}
+
 /*!
   \brief Returns the name of this tool - \c "basemap picker".
  */
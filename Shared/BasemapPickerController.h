@@ -26,7 +26,9 @@
 
 namespace Esri {
 namespace ArcGISRuntime {
+  class ArcGISTiledLayer;
   class Basemap;
+  class TileCache;
 }
 }
 
@@ -34,6 +36,7 @@ class QStringListModel;
 
 namespace Dsa {
 
+class LocalDataCatalog;
 class TileCacheListModel;
 
 class BasemapPickerController : public AbstractTool
@@ -72,13 +75,34 @@ signals:
   void toolErrorOccurred(const QString& errorMessage, const QString& additionalMessage);
 
 private:
+  // a basemap which is loading, or has loaded, before it is shown
+  struct WarmBasemap
+  {
+    QString                                   m_path;
+    Esri::ArcGISRuntime::Basemap*             m_basemap = nullptr;
+    Esri::ArcGISRuntime::ArcGISTiledLayer*    m_layer = nullptr;
+  };
+
   TileCacheListModel* m_tileCacheModel;
+  LocalDataCatalog*   m_catalog = nullptr;
   int                 m_defaultBasemapIndex = 0;
+  bool                m_foundDefaultBasemap = false;
   QString             m_basemapDataPath;
+  QString             m_catalogDirectory;
   QString             m_defaultBasemap = "topographic";
+  QStringList         m_tileCachePaths;
+  bool                m_initialBasemapRequested = false;
+  QString             m_currentPath;
+  QString             m_previousPath;
+  WarmBasemap         m_pendingBasemap;
+  WarmBasemap         m_preloadedBasemap;
 
 private:
-  void findBasemaps();
+  void updateBasemaps();
+  WarmBasemap createBasemap(Esri::ArcGISRuntime::TileCache* tileCache);
+  void showBasemap(const QString& name);
+  void preloadNextBasemap();
+  void discardBasemap(WarmBasemap& warmBasemap);
 };
 
 } // Dsa
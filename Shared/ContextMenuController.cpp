@@ -24,9 +24,8 @@
 #include "CoordinateConversionToolProxy.h"
 #include "ObservationReportController.h"
 #include "FollowPositionController.h"
-#include "GraphicsOverlaysResultsManager.h"
+#include "GraphicsOverlayHitTester.h"
 #include "IdentifyController.h"
-#include "LayerResultsManager.h"
 #include "LineOfSightController.h"
 #include "ViewshedController.h"
 #include "GeoElementUtils.h"
@@ -37,8 +36,10 @@
 // Toolkit headers
 #include "Esri/ArcGISRuntime/Toolkit/CoordinateConversionController.h"
 // C++ API headers
+#include "Camera.h"
 #include "MapView.h"
 #include "SceneView.h"
+#include "Viewpoint.h"
 
 // STL headers
 #include <cmath>
@@ -63,7 +64,8 @@ const QString ContextMenuController::OBSERVATION_REPORT_OPTION = "Observation";
 
   When the user presses and holds the mouse, a number of tasks are started
   to discover the current context for the app. Based on the result of these
-  operations a set of context specific operations are presented. For example,
+  operations a set of context specific operations are presented as each
+  task completes, so the menu appears with the first result. For example,
   the tool offers options such as:
 
   \list
@@ -75,6 +77,10 @@ const QString ContextMenuController::OBSERVATION_REPORT_OPTION = "Observation";
     \li Line of sight.
   \endlist
 
+  The results for the last context are reused for a few seconds if the view is
+  pressed and held again at almost the same screen position, without the view
+  having moved.
+
   \sa ObservationReportController
   \sa IdentifyController
   \sa ViewshedController
@@ -87,21 +93,14 @@ const QString ContextMenuController::OBSERVATION_REPORT_OPTION = "Observation";
  */
 ContextMenuController::ContextMenuController(QObject* parent /* = nullptr */):
   AbstractTool(parent),
-  m_options(new QStringListModel(this))
+  m_options(new QStringListModel(this)),
+  m_hitTester(new GraphicsOverlayHitTester(this))
 {
   ToolResourceProvider* resourceProvider = ToolResourceProvider::instance();
   // setup connection to handle mouse-clicking in the view (used to trigger the identify tasks)
   connect(resourceProvider, &ToolResourceProvider::mousePressedAndHeld,
           this, &ContextMenuController::onMousePressedAndHeld);
 
-  // setup connection to handle the results of an Identify Layers task
-  connect(resourceProvider, &ToolResourceProvider::identifyLayersCompleted,
-          this, &ContextMenuController::onIdentifyLayersCompleted);
-
-  // setup connection to handle the results of an Identify Graphic Overlays task
-  connect(resourceProvider, &ToolResourceProvider::identifyGraphicsOverlaysCompleted,
-          this, &ContextMenuController::onIdentifyGraphicsOverlaysCompleted);
-
   // setup connection to handle the results of a screen to location task
   connect(resourceProvider, &ToolResourceProvider::screenToLocationCompleted,
           this, &ContextMenuController::onScreenToLocationCompleted);
@@ -146,17 +145,38 @@ void ContextMenuController::onMousePressedAndHeld(QMouseEvent& event)
   if (event.button() != Qt::MouseButton::LeftButton)
     return;
 
+  GeoView* geoView = ToolResourceProvider::instance()->geoView();
+
+  // show the options for the last context again rather than repeating its tasks
+  if (isCachedContext(geoView, event.pos()))
+  {
+    clearOptions();
+    setContextScreenPosition(event.pos());
+    setContextLocation(m_contextLocation);
+    processGeoElements();
+    event.accept();
+    return;
+  }
+
   cancelTasks();
   clearOptions();
   for(const auto& feats : qAsConst(m_contextFeatures))
     qDeleteAll(feats);
   m_contextFeatures.clear();
 
-  for(const auto& graphics : qAsConst(m_contextGraphics))
-    qDeleteAll(graphics);
+  // only the graphics from an identify task are owned by the tool; the rest belong to their overlays
+  // the list keeps its storage for the next context
+  qDeleteAll(m_identifiedGraphics);
+  m_identifiedGraphics.erase(m_identifiedGraphics.begin(), m_identifiedGraphics.end());
+  for (const QMetaObject::Connection& connection : qAsConst(m_contextGraphicConnections))
+    disconnect(connection);
+  m_contextGraphicConnections.clear();
   m_contextGraphics.clear();
+  m_pointGraphicsCount = 0;
+  m_hasPointFeatures = false;
+  m_contextLocation = Point();
+  m_contextTimer.invalidate();
 
-  GeoView* geoView = ToolResourceProvider::instance()->geoView();
   if (!geoView)
     return;
 
@@ -180,9 +200,36 @@ void ContextMenuController::onMousePressedAndHeld(QMouseEvent& event)
     }
   }
 
-  // start tasks to determine whether a GeoElement was clicked on
-  m_identifyGraphicsTask = geoView->identifyGraphicsOverlays(m_contextScreenPosition.x(), m_contextScreenPosition.y(), 5.0, false, 1);
-  m_identifyFeaturesTask = geoView->identifyLayers(m_contextScreenPosition.x(), m_contextScreenPosition.y(), 5.0, false, 1);
+  // find any graphics which were clicked on from the spatial index of each overlay
+  m_contextGraphics = m_hitTester->identify(geoView, m_contextScreenPosition.x(), m_contextScreenPosition.y(), 5.0, 1);
+  for (const auto& geoElements : qAsConst(m_contextGraphics))
+  {
+    m_pointGraphicsCount += pointCount(geoElements);
+    for (GeoElement* geoElement : geoElements)
+      watchContextGraphic(geoElement);
+  }
+
+  // start tasks to determine whether any other GeoElement was clicked on
+  ToolResourceProvider* resourceProvider = ToolResourceProvider::instance();
+  if (m_hitTester->requiresRuntimeIdentify(geoView))
+  {
+    m_identifyGraphicsTaskId = resourceProvider->identifyGraphicsOverlays(this, m_contextScreenPosition.x(), m_contextScreenPosition.y(), 5.0, false, 1,
+                                                                          [this](const QList<IdentifyGraphicsOverlayResult*>& identifyResults)
+    {
+      onIdentifyGraphicsOverlaysCompleted(identifyResults);
+    });
+  }
+  m_identifyFeaturesTaskId = resourceProvider->identifyLayers(this, m_contextScreenPosition.x(), m_contextScreenPosition.y(), 5.0, false, 1,
+                                                              [this](const QList<IdentifyLayerResult*>& identifyResults)
+  {
+    onIdentifyLayersCompleted(identifyResults);
+  });
+
+  m_contextViewpoint = viewpointSignature(geoView);
+  m_contextTimer.start();
+
+  // offer the options for the graphics which have already been found
+  processGeoElements();
 
   // accept the event to prevent it being used by other tools etc.
   event.accept();
@@ -193,18 +240,13 @@ void ContextMenuController::onMousePressedAndHeld(QMouseEvent& event)
 
   Handle the result of an identify layers task.
  */
-void ContextMenuController::onIdentifyLayersCompleted(const QUuid& taskId, const QList<IdentifyLayerResult*>& identifyResults)
+void ContextMenuController::onIdentifyLayersCompleted(const QList<IdentifyLayerResult*>& identifyResults)
 {
-  if (taskId != m_identifyFeaturesTask.taskId())
-    return;
-
-  LayerResultsManager resultsManager(identifyResults);
-
-  m_identifyFeaturesTask = TaskWatcher();
+  m_identifyFeaturesTaskId = QUuid();
 
   // iterate over the results and if we find a GeoElement use it for the current context
-  auto it = resultsManager.m_results.begin();
-  auto itEnd = resultsManager.m_results.end();
+  auto it = identifyResults.cbegin();
+  auto itEnd = identifyResults.cend();
   for (; it != itEnd; ++it)
   {
     IdentifyLayerResult* res = *it;
@@ -217,6 +259,7 @@ void ContextMenuController::onIdentifyLayersCompleted(const QUuid& taskId, const
 
     // add the geoElements to the context hash using the layer name as the key
     m_contextFeatures.insert(res->layerContent()->name(), geoElements);
+    m_hasPointFeatures = m_hasPointFeatures || pointCount(geoElements) > 0;
   }
 
   processGeoElements();
@@ -227,39 +270,40 @@ void ContextMenuController::onIdentifyLayersCompleted(const QUuid& taskId, const
 
   Handle the result of an identify graphics overlays task.
  */
-void ContextMenuController::onIdentifyGraphicsOverlaysCompleted(const QUuid& taskId, const QList<IdentifyGraphicsOverlayResult*>& identifyResults)
+void ContextMenuController::onIdentifyGraphicsOverlaysCompleted(const QList<IdentifyGraphicsOverlayResult*>& identifyResults)
 {
-  if (taskId != m_identifyGraphicsTask.taskId())
-    return;
-
-  GraphicsOverlaysResultsManager resultsManager(identifyResults);
+  m_identifyGraphicsTaskId = QUuid();
 
-  m_identifyGraphicsTask = TaskWatcher();
+  GeoView* geoView = ToolResourceProvider::instance()->geoView();
 
-  auto it = resultsManager.m_results.begin();
-  auto itEnd = resultsManager.m_results.end();
+  auto it = identifyResults.cbegin();
+  auto itEnd = identifyResults.cend();
   for (; it != itEnd; ++it)
   {
     IdentifyGraphicsOverlayResult* res = *it;
     if (!res)
       continue;
 
+    // graphics from these overlays were already found when the view was pressed
+    if (GraphicsOverlayHitTester::canHitTest(geoView, res->graphicsOverlay()))
+      continue;
+
     const QList<Graphic*> graphics = res->graphics();
     if (graphics.isEmpty())
       continue;
 
-    QList<GeoElement*> geoElements;
-    auto gIt = graphics.begin();
-    auto gEnd = graphics.end();
-    for(; gIt != gEnd; ++gIt)
+    // add the geoElements to the context hash using the overlay id as the key
+    QList<GeoElement*>& overlayGeoElements = m_contextGraphics[res->graphicsOverlay()->overlayId()];
+    overlayGeoElements.reserve(overlayGeoElements.size() + graphics.size());
+    m_identifiedGraphics.reserve(m_identifiedGraphics.size() + graphics.size());
+    for (Graphic* graphic : graphics)
     {
-      GeoElement* geoElement = *gIt;
-      GeoElementUtils::setParent(geoElement, this); // set the GeoElements to be managed by the tool
-      geoElements.append(geoElement);
+      GeoElementUtils::setParent(graphic, this); // set the GeoElements to be managed by the tool
+      overlayGeoElements.append(graphic);
+      m_identifiedGraphics.append(graphic);
+      if (graphic->geometry().geometryType() == GeometryType::Point)
+        m_pointGraphicsCount++;
     }
-
-    // add the geoElements to the context hash using the overlay id as the key
-    m_contextGraphics.insert(res->graphicsOverlay()->overlayId(), geoElements);
   }
 
   processGeoElements();
@@ -388,59 +432,125 @@ void ContextMenuController::cancelTasks()
  */
 void ContextMenuController::cancelIdentifyTasks()
 {
-  m_identifyFeaturesTask.cancel();
-  m_identifyFeaturesTask = TaskWatcher();
-  m_identifyGraphicsTask.cancel();
-  m_identifyGraphicsTask = TaskWatcher();
+  ToolResourceProvider::instance()->cancelIdentify(this);
+  m_identifyFeaturesTaskId = QUuid();
+  m_identifyGraphicsTaskId = QUuid();
 }
 
 /*!
   \internal
+
+  Adds the options for the GeoElements found so far. This is called as each
+  identify task completes, using the point counts kept as results arrive.
  */
 void ContextMenuController::processGeoElements()
 {
-  // if either of the identify tasks is still in progress, return.
-  if ((m_identifyFeaturesTask.isValid() && !m_identifyFeaturesTask.isDone()) ||
-      (m_identifyGraphicsTask.isValid() && !m_identifyGraphicsTask.isDone()))
-    return;
-
   if (m_contextFeatures.isEmpty() && m_contextGraphics.isEmpty())
     return;
 
   // if we have at least 1 GeoElement, we can identify
   addOption(IDENTIFY_OPTION);
 
-  int pointGraphicsCount = 0;
-  for (const auto& geoElements : qAsConst(m_contextGraphics))
+  // if we have exactly 1 point graphic, we can follow it - which is only known once all graphics are found
+  if (m_pointGraphicsCount == 1 && m_identifyGraphicsTaskId.isNull())
+    addOption(FOLLOW_OPTION);
+
+  // if we have at least 1 point geometry, we can perform LOS
+  if (m_pointGraphicsCount > 0 || m_hasPointFeatures)
+    addOption(LINE_OF_SIGHT_OPTION);
+}
+
+/*!
+  \internal
+
+  Returns whether the tasks for the last context have completed, recently enough,
+  at a screen position within a few pixels of \a screenPosition, and \a geoView has
+  not moved since.
+ */
+bool ContextMenuController::isCachedContext(GeoView* geoView, const QPoint& screenPosition) const
+{
+  if (!geoView || !m_contextTimer.isValid() || m_contextTimer.hasExpired(s_cacheLifetimeMsecs))
+    return false;
+
+  if (!m_identifyFeaturesTaskId.isNull() || !m_identifyGraphicsTaskId.isNull() || !m_screenToLocationTask.taskId().isNull())
+    return false;
+
+  if ((screenPosition - m_contextScreenPosition).manhattanLength() > s_cacheTolerancePixels)
+    return false;
+
+  return viewpointSignature(geoView) == m_contextViewpoint;
+}
+
+/*!
+  \internal
+
+  Returns the values which describe the current viewpoint of \a geoView.
+ */
+QVector<double> ContextMenuController::viewpointSignature(GeoView* geoView)
+{
+  if (SceneView* sceneView = dynamic_cast<SceneView*>(geoView))
   {
-    for (GeoElement* geoElement : geoElements)
-    {
-      if (geoElement->geometry().geometryType() == GeometryType::Point)
-        pointGraphicsCount++;
-    }
+    const Camera camera = sceneView->currentViewpointCamera();
+    const Point location = camera.location();
+    return QVector<double>{location.x(), location.y(), location.z(), camera.heading(), camera.pitch(), camera.roll()};
   }
 
-  if (pointGraphicsCount == 1) // if we have exactly 1 point graphic, we can follow it
-    addOption(FOLLOW_OPTION);
-
-  if (pointGraphicsCount > 0) // if we have at least 1 point geometry, we can perform LOS
+  if (MapView* mapView = dynamic_cast<MapView*>(geoView))
   {
-    addOption(LINE_OF_SIGHT_OPTION);
-    return;
+    const Viewpoint viewpoint = mapView->currentViewpoint(ViewpointType::CenterAndScale);
+    const Point center = viewpoint.targetGeometry();
+    return QVector<double>{center.x(), center.y(), viewpoint.targetScale(), viewpoint.rotation()};
   }
 
-  // if were have 0 point graphics, check whether we have any point features
-  for (const auto& geoElements : qAsConst(m_contextFeatures))
+  return QVector<double>();
+}
+
+/*!
+  \internal
+
+  Drops \a geoElement from the context when it is destroyed. Graphics found
+  from the spatial index belong to their overlays, and a message feed deletes
+  its graphics once they are removed.
+ */
+void ContextMenuController::watchContextGraphic(GeoElement* geoElement)
+{
+  QObject* object = GeoElementUtils::toQObject(geoElement);
+  if (!object)
+    return;
+
+  m_contextGraphicConnections.append(connect(object, &QObject::destroyed, this, [this, geoElement]()
   {
-    for (GeoElement* geoElement : geoElements)
+    m_pointGraphicsCount = 0;
+    for (auto it = m_contextGraphics.begin(); it != m_contextGraphics.end();)
     {
-      if (geoElement && geoElement->geometry().geometryType() == GeometryType::Point)
+      it.value().removeAll(geoElement);
+      if (it.value().isEmpty())
       {
-        addOption(LINE_OF_SIGHT_OPTION);
-        return;
+        it = m_contextGraphics.erase(it);
+        continue;
       }
+
+      m_pointGraphicsCount += pointCount(it.value());
+      ++it;
     }
+  }));
+}
+
+/*!
+  \internal
+
+  Returns the number of \a geoElements with a point geometry.
+ */
+int ContextMenuController::pointCount(const QList<GeoElement*>& geoElements)
+{
+  int count = 0;
+  for (GeoElement* geoElement : geoElements)
+  {
+    if (geoElement && geoElement->geometry().geometryType() == GeometryType::Point)
+      count++;
   }
+
+  return count;
 }
 
 /*!
@@ -25,12 +25,16 @@
 #include "TaskWatcher.h"
 
 // Qt headers
+#include <QElapsedTimer>
 #include <QMouseEvent>
 #include <QStringListModel>
+#include <QUuid>
+#include <QVector>
 
 namespace Esri {
 namespace ArcGISRuntime {
   class GeoElement;
+  class GeoView;
   class IdentifyGraphicsOverlayResult;
   class IdentifyLayerResult;
 }
@@ -38,6 +42,8 @@ namespace ArcGISRuntime {
 
 namespace Dsa {
 
+class GraphicsOverlayHitTester;
+
 class ContextMenuController : public AbstractTool
 {
   Q_OBJECT
@@ -87,11 +93,11 @@ signals:
 
 private slots:
   void onMousePressedAndHeld(QMouseEvent& event);
-  void onIdentifyLayersCompleted(const QUuid& taskId, const QList<Esri::ArcGISRuntime::IdentifyLayerResult*>& identifyResults);
-  void onIdentifyGraphicsOverlaysCompleted(const QUuid& taskId, const QList<Esri::ArcGISRuntime::IdentifyGraphicsOverlayResult*>& identifyResults);
   void onScreenToLocationCompleted(QUuid taskId, const Esri::ArcGISRuntime::Point& location);
 
 private:
+  void onIdentifyLayersCompleted(const QList<Esri::ArcGISRuntime::IdentifyLayerResult*>& identifyResults);
+  void onIdentifyGraphicsOverlaysCompleted(const QList<Esri::ArcGISRuntime::IdentifyGraphicsOverlayResult*>& identifyResults);
   void addOption(const QString& option);
   void clearOptions();
   void setResult(const QString& result);
@@ -99,6 +105,13 @@ private:
   void cancelTasks();
   void cancelIdentifyTasks();
   void processGeoElements();
+  bool isCachedContext(Esri::ArcGISRuntime::GeoView* geoView, const QPoint& screenPosition) const;
+  void watchContextGraphic(Esri::ArcGISRuntime::GeoElement* geoElement);
+  static QVector<double> viewpointSignature(Esri::ArcGISRuntime::GeoView* geoView);
+  static int pointCount(const QList<Esri::ArcGISRuntime::GeoElement*>& geoElements);
+
+  static constexpr int s_cacheTolerancePixels = 3;
+  static constexpr qint64 s_cacheLifetimeMsecs = 5000;
 
   bool m_contextActive = false;
   QPoint m_contextScreenPosition{0, 0};
@@ -107,11 +120,18 @@ private:
   QString m_resultTitle;
   Esri::ArcGISRuntime::Point m_contextLocation;
   Esri::ArcGISRuntime::Point m_contextBaseSurfaceLocation;
-  Esri::ArcGISRuntime::TaskWatcher m_identifyFeaturesTask;
-  Esri::ArcGISRuntime::TaskWatcher m_identifyGraphicsTask;
+  QUuid m_identifyFeaturesTaskId;
+  QUuid m_identifyGraphicsTaskId;
   Esri::ArcGISRuntime::TaskWatcher m_screenToLocationTask;
   QHash<QString, QList<Esri::ArcGISRuntime::GeoElement*>> m_contextFeatures;
   QHash<QString, QList<Esri::ArcGISRuntime::GeoElement*>> m_contextGraphics;
+  QList<Esri::ArcGISRuntime::GeoElement*> m_identifiedGraphics;
+  QList<QMetaObject::Connection> m_contextGraphicConnections;
+  int m_pointGraphicsCount = 0;
+  bool m_hasPointFeatures = false;
+  QElapsedTimer m_contextTimer;
+  QVector<double> m_contextViewpoint;
+  GraphicsOverlayHitTester* m_hitTester = nullptr;
 };
 
 } // Dsa
@@ -16,6 +16,7 @@
  ******************************************************************************/
 #include "CoordinateConversionToolProxy.h"
 
+#include "CoordinateFormatUtils.h"
 #include "ToolManager.h"
 #include "ToolResourceProvider.h"
 
@@ -23,8 +24,12 @@
 #include "Esri/ArcGISRuntime/Toolkit/CoordinateConversionConstants.h"
 #include "Esri/ArcGISRuntime/Toolkit/CoordinateConversionResult.h"
 
+#include <MapQuickView.h>
+#include <Point.h>
 #include <SceneQuickView.h>
 
+#include <QVariantMap>
+
 using namespace Esri::ArcGISRuntime;
 using namespace Esri::ArcGISRuntime::Toolkit;
 
@@ -41,6 +46,9 @@ using namespace Esri::ArcGISRuntime::Toolkit;
  * a json configuration, which helps track the user selected format in the
  * CoordinateConversion view's input format.
  *
+ * The proxy can also format batches of points, for example the positions of a
+ * track, in the configured coordinate notation. See \l formatPoints.
+ *
  * Finally, this links up the ToolManager geoViewChanged signals. So that the
  * GeoView of the CoordinateConversionController always matches what the
  * ToolManager claims is the current GeoView.
@@ -126,6 +134,8 @@ void CoordinateConversionToolProxy::setProperties(const QVariantMap& properties)
   auto findFormatIt = properties.find("CoordinateFormat");
   if (findFormatIt != properties.end())
   {
+    m_coordinateFormat = findFormatIt.value().toString();
+
     const auto size = formats->rowCount();
     for (int i = 0; i < size; ++i)
     {
@@ -140,6 +150,66 @@ void CoordinateConversionToolProxy::setProperties(const QVariantMap& properties)
   }
 }
 
+/*!
+ * \brief Returns the name of the coordinate notation from the configuration,
+ * for example "MGRS" or "DMS".
+ */
+QString CoordinateConversionToolProxy::coordinateFormat() const
+{
+  return m_coordinateFormat;
+}
+
+/*!
+ * \brief Returns each of \a points formatted in the configured coordinate notation.
+ * \sa coordinateFormat
+ */
+QStringList CoordinateConversionToolProxy::formatPoints(const QList<Point>& points) const
+{
+  return formatPoints(points, m_coordinateFormat);
+}
+
+/*!
+ * \brief Returns each of \a points formatted in the notation named \a format.
+ *
+ * The points are formatted in parallel chunks, so this is suitable for annotating
+ * large numbers of positions such as the points of a track. Empty points are
+ * returned as empty strings.
+ */
+QStringList CoordinateConversionToolProxy::formatPoints(const QList<Point>& points, const QString& format) const
+{
+  return CoordinateFormatUtils::formatPoints(points, format);
+}
+
+/*!
+ * \brief Returns each of \a points formatted in the notation named \a format, or
+ * in the configured notation if \a format is empty.
+ *
+ * This is the QML counterpart of \l formatPoints. Each of the \a points is an
+ * object with \c x and \c y properties and an optional \c wkid, which defaults
+ * to WGS84.
+ */
+QStringList CoordinateConversionToolProxy::formatCoordinates(const QVariantList& points, const QString& format) const
+{
+  QList<Point> geometries;
+  geometries.reserve(points.size());
+  for (const QVariant& point : points)
+  {
+    const QVariantMap pointMap = point.toMap();
+    if (!pointMap.contains(QStringLiteral("x")) || !pointMap.contains(QStringLiteral("y")))
+    {
+      geometries.append(Point());
+      continue;
+    }
+
+    const int wkid = pointMap.value(QStringLiteral("wkid"), 4326).toInt();
+    geometries.append(Point(pointMap.value(QStringLiteral("x")).toDouble(),
+                            pointMap.value(QStringLiteral("y")).toDouble(),
+                            SpatialReference(wkid)));
+  }
+
+  return formatPoints(geometries, format.isEmpty() ? m_coordinateFormat : format);
+}
+
 /*!
  * \brief Returns a controller that is fed with DSA and GeoView updates when
  * applicable.
@@ -172,7 +242,10 @@ CoordinateConversionResult* CoordinateConversionToolProxy::inputFormat() const
 void CoordinateConversionToolProxy::connectController()
 {
   auto geoView = ToolResourceProvider::instance()->geoView();
-  m_controller->setGeoView(static_cast<SceneQuickView*>(geoView));
+  if (auto mapView = dynamic_cast<MapQuickView*>(geoView))
+    m_controller->setGeoView(mapView);
+  else
+    m_controller->setGeoView(dynamic_cast<SceneQuickView*>(geoView));
 
   connect(ToolResourceProvider::instance(), &ToolResourceProvider::locationChanged,
     m_controller,
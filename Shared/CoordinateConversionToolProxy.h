@@ -19,10 +19,15 @@
 
 #include "AbstractTool.h"
 
+#include <QStringList>
+#include <QVariantList>
+
 namespace Esri
 {
 namespace ArcGISRuntime
 {
+class Point;
+
 namespace Toolkit
 {
 class CoordinateConversionController;
@@ -58,10 +63,17 @@ public:
   void setInInputMode(bool mode);
   Q_SIGNAL void inInputModeChanged();
 
+  QString coordinateFormat() const;
+
+  QStringList formatPoints(const QList<Esri::ArcGISRuntime::Point>& points) const;
+  QStringList formatPoints(const QList<Esri::ArcGISRuntime::Point>& points, const QString& format) const;
+  Q_INVOKABLE QStringList formatCoordinates(const QVariantList& points, const QString& format = QString()) const;
+
 private:
   void connectController();
 
   bool m_inInputMode;
+  QString m_coordinateFormat;
   Esri::ArcGISRuntime::Toolkit::CoordinateConversionController* m_controller = nullptr;
   Esri::ArcGISRuntime::Toolkit::CoordinateConversionResult* m_inputFormat = nullptr;
 };
@@ -54,6 +54,11 @@ namespace Dsa {
         \li QString
         \li The file name of the data item.
   \endtable
+
+  The rows can be filtered by a \l nameFilter, which is matched against a
+  lower-case copy of each file name made when the item is added. Changes to the
+  filter or to the items remove and insert only the rows affected, so typing a
+  filter narrows the list without the view being reset.
  */
 
 /*!
@@ -79,11 +84,198 @@ void DataItemListModel::setupRoles()
  */
 void DataItemListModel::addDataItem(const QString& fullPath)
 {
-  beginInsertRows(QModelIndex(), rowCount(), rowCount());
   m_dataItems.append(fullPath);
+  if (!matchesNameFilter(m_dataItems.last()))
+    return;
+
+  beginInsertRows(QModelIndex(), rowCount(), rowCount());
+  m_rows.append(m_dataItems.size() - 1);
   endInsertRows();
 }
 
+/*!
+  \brief Replaces the items in the model with the local data located at \a fullPaths.
+
+  Items which remain keep their rows, so only the rows for removed and added
+  items change, provided the remaining items keep their order.
+ */
+void DataItemListModel::setDataItems(const QStringList& fullPaths)
+{
+  QHash<QString, int> newIndices;
+  newIndices.reserve(fullPaths.size());
+  for (int i = 0; i < fullPaths.size(); ++i)
+    newIndices.insert(fullPaths.at(i), i);
+
+  QHash<QString, int> oldIndices;
+  oldIndices.reserve(m_dataItems.size());
+  bool ordered = true;
+  int lastNewIndex = -1;
+  for (int i = 0; i < m_dataItems.size(); ++i)
+  {
+    const QString& fullPath = m_dataItems.at(i).fullPath;
+    oldIndices.insert(fullPath, i);
+
+    const int newIndex = newIndices.value(fullPath, -1);
+    if (newIndex == -1)
+      continue;
+
+    ordered = ordered && newIndex > lastNewIndex;
+    lastNewIndex = newIndex;
+  }
+
+  // existing items are reused rather than inspecting their paths again
+  QList<DataItem> dataItems;
+  dataItems.reserve(fullPaths.size());
+  for (const QString& fullPath : fullPaths)
+  {
+    const int oldIndex = oldIndices.value(fullPath, -1);
+    if (oldIndex == -1)
+      dataItems.append(fullPath);
+    else
+      dataItems.append(m_dataItems.at(oldIndex));
+  }
+
+  // reordered items cannot be reported as removals and insertions alone
+  if (!ordered)
+  {
+    beginResetModel();
+    m_dataItems.swap(dataItems);
+    m_rows.clear();
+    for (int i = 0; i < m_dataItems.size(); ++i)
+    {
+      if (matchesNameFilter(m_dataItems.at(i)))
+        m_rows.append(i);
+    }
+    endResetModel();
+    return;
+  }
+
+  removeRowsWhere([&newIndices](const DataItem& dataItem)
+  {
+    return !newIndices.contains(dataItem.fullPath);
+  });
+
+  for (int& index : m_rows)
+    index = newIndices.value(m_dataItems.at(index).fullPath);
+
+  m_dataItems.swap(dataItems);
+  insertMatchingRows();
+}
+
+/*!
+  \brief Returns the text which the file names of the listed items contain.
+ */
+QString DataItemListModel::nameFilter() const
+{
+  return m_nameFilter;
+}
+
+/*!
+  \brief Lists only the items whose file names contain \a nameFilter, ignoring case.
+
+  When the filter is extended, only the rows which no longer match are
+  removed, and when it is shortened, only the rows which now match are inserted.
+ */
+void DataItemListModel::setNameFilter(const QString& nameFilter)
+{
+  const QString lowerNameFilter = nameFilter.toLower();
+  if (lowerNameFilter == m_nameFilter)
+    return;
+
+  const bool narrowed = lowerNameFilter.contains(m_nameFilter);
+  const bool widened = m_nameFilter.contains(lowerNameFilter);
+  m_nameFilter = lowerNameFilter;
+
+  if (!widened)
+  {
+    removeRowsWhere([this](const DataItem& dataItem)
+    {
+      return !matchesNameFilter(dataItem);
+    });
+  }
+
+  if (!narrowed)
+    insertMatchingRows();
+}
+
+/*!
+  \internal
+
+  Returns whether the file name of \a dataItem contains the name filter.
+ */
+bool DataItemListModel::matchesNameFilter(const DataItem& dataItem) const
+{
+  return m_nameFilter.isEmpty() || dataItem.lowerFileName.contains(m_nameFilter);
+}
+
+/*!
+  \internal
+
+  Removes the rows whose items match \a predicate, reporting each run of adjacent
+  rows as one removal. The rows are visited from the end, so the rows still to be
+  visited keep their positions.
+ */
+void DataItemListModel::removeRowsWhere(const std::function<bool(const DataItem&)>& predicate)
+{
+  int row = m_rows.size() - 1;
+  while (row >= 0)
+  {
+    if (!predicate(m_dataItems.at(m_rows.at(row))))
+    {
+      --row;
+      continue;
+    }
+
+    const int last = row;
+    while (row > 0 && predicate(m_dataItems.at(m_rows.at(row - 1))))
+      --row;
+
+    beginRemoveRows(QModelIndex(), row, last);
+    m_rows.remove(row, last - row + 1);
+    endRemoveRows();
+    --row;
+  }
+}
+
+/*!
+  \internal
+
+  Inserts rows for the items which match the name filter but are not listed,
+  reporting each run of adjacent rows as one insertion. Both the items and the
+  rows are in the same order, so they are walked together.
+ */
+void DataItemListModel::insertMatchingRows()
+{
+  int row = 0;
+  int index = 0;
+  const int itemCount = m_dataItems.size();
+  while (index < itemCount)
+  {
+    if (row < m_rows.size() && m_rows.at(row) == index)
+    {
+      ++row;
+      ++index;
+      continue;
+    }
+
+    if (!matchesNameFilter(m_dataItems.at(index)))
+    {
+      ++index;
+      continue;
+    }
+
+    QVector<int> indices;
+    while (index < itemCount && (row >= m_rows.size() || m_rows.at(row) != index) && matchesNameFilter(m_dataItems.at(index)))
+      indices.append(index++);
+
+    beginInsertRows(QModelIndex(), row, row + indices.size() - 1);
+    for (int i = 0; i < indices.size(); ++i)
+      m_rows.insert(row + i, indices.at(i));
+    endInsertRows();
+    row += indices.size();
+  }
+}
+
 /*!
   \brief Returns the number of data items in the model.
 
@@ -94,7 +286,7 @@ void DataItemListModel::addDataItem(const QString& fullPath)
 int DataItemListModel::rowCount(const QModelIndex& parent) const
 {
   Q_UNUSED(parent);
-  return m_dataItems.count();
+  return m_rows.count();
 }
 
 /*!
@@ -104,10 +296,10 @@ int DataItemListModel::rowCount(const QModelIndex& parent) const
  */
 QVariant DataItemListModel::data(const QModelIndex& index, int role) const
 {
-  if (index.row() < 0 || index.row() >= m_dataItems.count())
+  if (index.row() < 0 || index.row() >= m_rows.count())
     return QVariant();
 
-  DataItem dataItem = m_dataItems[index.row()];
+  const DataItem& dataItem = m_dataItems.at(m_rows.at(index.row()));
 
   QVariant retVal;
 
@@ -143,6 +335,7 @@ void DataItemListModel::clear()
 {
   beginResetModel();
   m_dataItems.clear();
+  m_rows.clear();
   endResetModel();
 }
 
@@ -151,10 +344,10 @@ void DataItemListModel::clear()
  */
 DataType DataItemListModel::getDataItemType(int index)
 {
-  if (index >= m_dataItems.size())
+  if (index < 0 || index >= m_rows.size())
     return DataType::Unknown;
 
-  return m_dataItems.at(index).dataType;
+  return m_dataItems.at(m_rows.at(index)).dataType;
 }
 
 /*!
@@ -162,46 +355,53 @@ DataType DataItemListModel::getDataItemType(int index)
  */
 QString DataItemListModel::getDataItemPath(int index) const
 {
-  if (index >= m_dataItems.size())
+  if (index < 0 || index >= m_rows.size())
     return QString();
 
-  return m_dataItems.at(index).fullPath;
+  return m_dataItems.at(m_rows.at(index)).fullPath;
 }
 
 /*!
-  \internal
-  c'tor for DataItem struct
+  \brief Returns the \l DataType of the local data located at \a fullPath, based on its extension.
  */
-DataItemListModel::DataItem::DataItem(const QString& fullPath):
-  fullPath(fullPath)
+DataType DataItemListModel::dataTypeFromPath(const QString& fullPath)
 {
-  // set the file name
-  QFileInfo fileInfo(fullPath);
-  fileName = fileInfo.fileName();
+  static const QStringList rasterExtensions{"img", "tif", "tiff", "i1", "dt0", "dt1", "dt2", "tc2", "geotiff", "hr1", "jpg", "jpeg", "jp2", "ntf", "png", "i21", "sid"};
 
   // determine the layer type
-  QString fileExtension = fileInfo.completeSuffix();
-  QStringList rasterExtensions{"img", "tif", "tiff", "i1", "dt0", "dt1", "dt2", "tc2", "geotiff", "hr1", "jpg", "jpeg", "jp2", "ntf", "png", "i21", "sid"};
+  const QString fileExtension = QFileInfo(fullPath).completeSuffix();
   if (fileExtension == "geodatabase")
-    dataType = DataType::Geodatabase;
+    return DataType::Geodatabase;
   else if (fileExtension.compare("tpk", Qt::CaseInsensitive) == 0)
-    dataType = DataType::TilePackage;
+    return DataType::TilePackage;
   else if (fileExtension.compare("shp", Qt::CaseInsensitive) == 0)
-    dataType = DataType::Shapefile;
+    return DataType::Shapefile;
   else if (fileExtension.compare("gpkg", Qt::CaseInsensitive) == 0)
-    dataType = DataType::GeoPackage;
+    return DataType::GeoPackage;
   else if (fileExtension.compare("slpk", Qt::CaseInsensitive) == 0)
-    dataType = DataType::SceneLayerPackage;
+    return DataType::SceneLayerPackage;
   else if (fileExtension.compare("vtpk", Qt::CaseInsensitive) == 0)
-    dataType = DataType::VectorTilePackage;
+    return DataType::VectorTilePackage;
   else if (fileExtension.compare("markup", Qt::CaseInsensitive) == 0)
-    dataType = DataType::Markup;
+    return DataType::Markup;
   else if ((fileExtension.compare("kml", Qt::CaseInsensitive) == 0) || (fileExtension.compare("kmz", Qt::CaseInsensitive) == 0))
-    dataType = DataType::Kml;
+    return DataType::Kml;
   else if (rasterExtensions.contains(fileExtension.toLower()))
-    dataType = DataType::Raster;
-  else
-    dataType = DataType::Unknown;
+    return DataType::Raster;
+
+  return DataType::Unknown;
+}
+
+/*!
+  \internal
+  c'tor for DataItem struct
+ */
+DataItemListModel::DataItem::DataItem(const QString& fullPath):
+  fullPath(fullPath),
+  fileName(QFileInfo(fullPath).fileName()),
+  lowerFileName(fileName.toLower()),
+  dataType(dataTypeFromPath(fullPath))
+{
 }
 
 } // Dsa
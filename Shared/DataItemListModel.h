@@ -23,6 +23,10 @@
 #include <QFileInfo>
 #include <QHash>
 #include <QList>
+#include <QVector>
+
+// STL headers
+#include <functional>
 
 namespace Dsa {
 
@@ -55,12 +59,18 @@ public:
   explicit DataItemListModel(QObject* parent = nullptr);
   ~DataItemListModel() = default;
 
+  static DataType dataTypeFromPath(const QString& fullPath);
+
   DataType getDataItemType(int index);
   QString getDataItemPath(int index) const;
   void addDataItem(const QString& fullPath);
+  void setDataItems(const QStringList& fullPaths);
   void clear();
   void setupRoles();
-  int size() { return m_dataItems.size(); }
+  int size() { return m_rows.size(); }
+
+  QString nameFilter() const;
+  void setNameFilter(const QString& nameFilter);
 
   // QAbstractItemModel interface
   int rowCount(const QModelIndex& parent = QModelIndex()) const override;
@@ -79,11 +89,18 @@ private:
 
     QString fullPath;
     QString fileName;
+    QString lowerFileName;
     DataType dataType;
   };
 
+  bool matchesNameFilter(const DataItem& dataItem) const;
+  void removeRowsWhere(const std::function<bool(const DataItem&)>& predicate);
+  void insertMatchingRows();
+
   QHash<int, QByteArray> m_roles;
   QList<DataItem> m_dataItems;
+  QVector<int> m_rows;
+  QString m_nameFilter;
 };
 
 } // Dsa
@@ -14,6 +14,7 @@
  *  limitations under the License.
  ******************************************************************************/
 
+
 // PCH header
 #include "pch.hpp"
 
@@ -24,9 +25,14 @@ namespace Dsa {
 /*!
   \class Dsa::DrawOrderLayerListModel
   \inmodule Dsa
-  \inherits QSortFilterProxyModel
+  \inherits QAbstractProxyModel
   \brief A proxy model responsible for presenting layers in the
   app in their draw order. The top layer is first in the list.
+
+  The draw order is the reverse of the order of the source model, so each
+  row is mapped with a subtraction in either direction. Changes to the
+  source model are forwarded with their rows reversed, rather than sorting
+  the rows again when layers are added or moved.
  */
 
 /*!
@@ -34,9 +40,8 @@ namespace Dsa {
  */
 
 DrawOrderLayerListModel::DrawOrderLayerListModel(QObject* parent):
-  QSortFilterProxyModel(parent)
+  QAbstractProxyModel(parent)
 {
-  sort(0);
 }
 
 /*!
@@ -48,11 +53,165 @@ DrawOrderLayerListModel::~DrawOrderLayerListModel()
 }
 
 /*!
-  \brief Returns whether \a sourceLeft should be listed before \a sourceRight.
+  \brief Sets the list of layers presented in draw order to \a sourceModel.
+ */
+void DrawOrderLayerListModel::setSourceModel(QAbstractItemModel* sourceModel)
+{
+  beginResetModel();
+
+  for (const auto& connection : qAsConst(m_sourceConnections))
+    disconnect(connection);
+  m_sourceConnections.clear();
+
+  QAbstractProxyModel::setSourceModel(sourceModel);
+
+  if (sourceModel)
+  {
+    // the row counts are read before the source model changes
+    m_sourceConnections.append(connect(sourceModel, &QAbstractItemModel::rowsAboutToBeInserted, this,
+                                       [this](const QModelIndex&, int first, int last)
+    {
+      const int row = rowCount() - first;
+      beginInsertRows(QModelIndex(), row, row + last - first);
+    }));
+    m_sourceConnections.append(connect(sourceModel, &QAbstractItemModel::rowsInserted, this, [this]()
+    {
+      endInsertRows();
+    }));
+    m_sourceConnections.append(connect(sourceModel, &QAbstractItemModel::rowsAboutToBeRemoved, this,
+                                       [this](const QModelIndex&, int first, int last)
+    {
+      beginRemoveRows(QModelIndex(), drawOrderRow(last), drawOrderRow(first));
+    }));
+    m_sourceConnections.append(connect(sourceModel, &QAbstractItemModel::rowsRemoved, this, [this]()
+    {
+      endRemoveRows();
+    }));
+    m_sourceConnections.append(connect(sourceModel, &QAbstractItemModel::rowsAboutToBeMoved, this,
+                                       [this](const QModelIndex&, int first, int last, const QModelIndex&, int destination)
+    {
+      // the rows move to before the source row at destination, which is after its draw order row
+      beginMoveRows(QModelIndex(), drawOrderRow(last), drawOrderRow(first), QModelIndex(), rowCount() - destination);
+    }));
+    m_sourceConnections.append(connect(sourceModel, &QAbstractItemModel::rowsMoved, this, [this]()
+    {
+      endMoveRows();
+    }));
+    m_sourceConnections.append(connect(sourceModel, &QAbstractItemModel::dataChanged, this,
+                                       [this](const QModelIndex& topLeft, const QModelIndex& bottomRight, const QVector<int>& roles)
+    {
+      emit dataChanged(mapFromSource(bottomRight), mapFromSource(topLeft), roles);
+    }));
+    m_sourceConnections.append(connect(sourceModel, &QAbstractItemModel::modelAboutToBeReset, this, [this]()
+    {
+      beginResetModel();
+    }));
+    m_sourceConnections.append(connect(sourceModel, &QAbstractItemModel::modelReset, this, [this]()
+    {
+      endResetModel();
+    }));
+
+    // a flat list of layers is re-read in full if its layout changes
+    m_sourceConnections.append(connect(sourceModel, &QAbstractItemModel::layoutAboutToBeChanged, this, [this]()
+    {
+      beginResetModel();
+    }));
+    m_sourceConnections.append(connect(sourceModel, &QAbstractItemModel::layoutChanged, this, [this]()
+    {
+      endResetModel();
+    }));
+  }
+
+  endResetModel();
+}
+
+/*!
+  \brief Returns the source model row of the layer at \a row in draw order, or \c -1
+  if there is no such row.
+ */
+int DrawOrderLayerListModel::sourceRow(int row) const
+{
+  const int count = rowCount();
+  if (row < 0 || row >= count)
+    return -1;
+
+  return count - 1 - row;
+}
+
+/*!
+  \brief Returns the draw order row of the layer at \a sourceRow in the source model,
+  or \c -1 if there is no such row.
+ */
+int DrawOrderLayerListModel::drawOrderRow(int sourceRow) const
+{
+  const int count = rowCount();
+  if (sourceRow < 0 || sourceRow >= count)
+    return -1;
+
+  return count - 1 - sourceRow;
+}
+
+/*!
+  \brief Returns the index of the item at \a row and \a column.
+ */
+QModelIndex DrawOrderLayerListModel::index(int row, int column, const QModelIndex& parent) const
+{
+  if (parent.isValid() || row < 0 || row >= rowCount() || column < 0 || column >= columnCount())
+    return QModelIndex();
+
+  return createIndex(row, column);
+}
+
+/*!
+  \brief Returns an invalid index, as the layers form a flat list.
+ */
+QModelIndex DrawOrderLayerListModel::parent(const QModelIndex&) const
+{
+  return QModelIndex();
+}
+
+/*!
+  \brief Returns the number of layers in the source model.
+ */
+int DrawOrderLayerListModel::rowCount(const QModelIndex& parent) const
+{
+  if (parent.isValid() || !sourceModel())
+    return 0;
+
+  return sourceModel()->rowCount();
+}
+
+/*!
+  \brief Returns the number of columns in the source model.
  */
-bool DrawOrderLayerListModel::lessThan(const QModelIndex& sourceLeft, const QModelIndex& sourceRight) const
+int DrawOrderLayerListModel::columnCount(const QModelIndex& parent) const
 {
-  return sourceLeft.row() > sourceRight.row();
+  if (parent.isValid() || !sourceModel())
+    return 0;
+
+  return sourceModel()->columnCount();
+}
+
+/*!
+  \brief Returns the source model index of \a proxyIndex.
+ */
+QModelIndex DrawOrderLayerListModel::mapToSource(const QModelIndex& proxyIndex) const
+{
+  if (!proxyIndex.isValid() || !sourceModel())
+    return QModelIndex();
+
+  return sourceModel()->index(sourceRow(proxyIndex.row()), proxyIndex.column());
+}
+
+/*!
+  \brief Returns the draw order index of \a sourceIndex.
+ */
+QModelIndex DrawOrderLayerListModel::mapFromSource(const QModelIndex& sourceIndex) const
+{
+  if (!sourceIndex.isValid())
+    return QModelIndex();
+
+  return index(drawOrderRow(sourceIndex.row()), sourceIndex.column());
 }
 
 } // Dsa
@@ -14,15 +14,18 @@
  *  limitations under the License.
  ******************************************************************************/
 
+
 #ifndef DRAWORDERLAYERLISTMODEL_H
 #define DRAWORDERLAYERLISTMODEL_H
 
 // Qt headers
-#include <QSortFilterProxyModel>
+#include <QAbstractProxyModel>
+#include <QList>
+#include <QMetaObject>
 
 namespace Dsa {
 
-class DrawOrderLayerListModel : public QSortFilterProxyModel
+class DrawOrderLayerListModel : public QAbstractProxyModel
 {
   Q_OBJECT
 
@@ -30,8 +33,23 @@ public:
   explicit DrawOrderLayerListModel(QObject* parent = nullptr);
   ~DrawOrderLayerListModel();
 
-protected:
-  bool lessThan(const QModelIndex& sourceLeft, const QModelIndex& sourceRight) const override;
+  void setSourceModel(QAbstractItemModel* sourceModel) override;
+
+  int sourceRow(int row) const;
+  int drawOrderRow(int sourceRow) const;
+
+  // QAbstractItemModel interface
+  QModelIndex index(int row, int column, const QModelIndex& parent = QModelIndex()) const override;
+  QModelIndex parent(const QModelIndex& child) const override;
+  int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+  int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+
+  // QAbstractProxyModel interface
+  QModelIndex mapToSource(const QModelIndex& proxyIndex) const override;
+  QModelIndex mapFromSource(const QModelIndex& sourceIndex) const override;
+
+private:
+  QList<QMetaObject::Connection> m_sourceConnections;
 };
 
 } // Dsa
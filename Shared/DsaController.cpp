@@ -27,9 +27,18 @@
 #include "BasemapPickerController.h"
 #include "ContextMenuController.h"
 #include "DsaUtility.h"
+#include "FrameAnimationDriver.h"
 #include "LayerCacheManager.h"
+#include "MemoryBudget.h"
 #include "MessageFeedConstants.h"
+#include "MetricsExporter.h"
 #include "OpenMobileScenePackageController.h"
+#include "PerformanceMonitor.h"
+#include "PerformanceProfile.h"
+#include "SceneContentBudget.h"
+#include "StallWatchdog.h"
+#include "StartupProfiler.h"
+#include "TraceRecorder.h"
 
 #include "ToolManager.h"
 #include "ToolResourceProvider.h"
@@ -39,15 +48,26 @@
 
 // C++ API headers
 #include "GeoView.h"
+#include "Map.h"
+#include "MapView.h"
 #include "Scene.h"
 
 // Qt headers
+#include <QCborMap>
+#include <QCborValue>
+#include <QCryptographicHash>
+#include <QDateTime>
 #include <QDir>
 #include <QFileInfo>
 #include <QHostInfo>
 #include <QJsonArray>
 #include <QJsonDocument>
+#include <QPointer>
+#include <QSaveFile>
 #include <QSettings>
+#include <QStandardPaths>
+#include <QThreadPool>
+#include <QTimer>
 
 using namespace Esri::ArcGISRuntime;
 
@@ -56,9 +76,18 @@ namespace Dsa {
 namespace
 {
 
+// increment when the layout of the settings snapshot changes
+constexpr int s_settingsSnapshotVersion = 1;
+
+// the UI thread is treated as stalled after this many ms without processing events
+constexpr int s_defaultStallThreshold = 500;
+
 bool readJsonFile(QIODevice& device, QSettings::SettingsMap& map);
 bool writeJsonFile(QIODevice& device, const QSettings::SettingsMap& map);
+bool readSettingsSnapshot(const QString& snapshotFilePath, const QString& configFilePath, QVariantMap& settings, bool& isTouched);
+void writeSettingsSnapshot(const QString& snapshotFilePath, const QString& configFilePath, const QVariantMap& settings);
 Viewpoint viewpointFromJson(const QJsonObject& initialLocation);
+Viewpoint mapViewpointFromJson(const QJsonObject& initialLocation);
 QJsonObject defaultViewpoint();
 
 } // namespace
@@ -77,6 +106,11 @@ QJsonObject defaultViewpoint();
   This type is also responsible for reading and writing app configuration details to
   a JSON settings file. Information in the JSON file is sent to each tool as a set of
   properties.
+
+  The JSON file remains the editable source of truth, but a binary CBOR snapshot of its
+  parsed contents is kept in the app's cache location. At startup the snapshot is used
+  instead of parsing the JSON, as long as it was taken from the same file with the same
+  size and modification time, or with the same content hash.
  */
 
 /*!
@@ -89,13 +123,56 @@ DsaController::DsaController(QObject* parent):
   m_conflictingToolNames{QStringLiteral("Alert Conditions"),
                          QStringLiteral("Markup Tool"),
                          QStringLiteral("viewshed"),
-                         QStringLiteral("Observation Report")}
+                         QStringLiteral("Observation Report")},
+  m_criticalToolNames{QStringLiteral("basemap picker"),
+                      QStringLiteral("location"),
+                      QStringLiteral("Location Text"),
+                      QStringLiteral("NavigationController"),
+                      QStringLiteral("follow position"),
+                      QStringLiteral("context menu"),
+                      QStringLiteral("Layer Cache Manager")},
+  m_saveThreadPool(new QThreadPool(this)),
+  m_saveTimer(new QTimer(this))
 {
+  StartupProfiler::Phase phase(QStringLiteral("settings"));
+
+  // settings are written in the order they are saved
+  m_saveThreadPool->setMaxThreadCount(1);
+
+  // changes are coalesced and written behind, so bursts of property changes
+  // result in a single write of the config file
+  m_saveTimer->setSingleShot(true);
+  m_saveTimer->setInterval(500);
+  connect(m_saveTimer, &QTimer::timeout, this, &DsaController::writeSettings);
+
   // setup config settings
   setupConfig();
   m_scene->setInitialViewpoint(viewpointFromJson(defaultViewpoint()));
   m_dataPath = m_dsaSettings["RootDataDirectory"].toString();
 
+  // runtime tracing is recorded from here on so that the rest of startup is included
+  TraceRecorder::instance()->setEnabled(!qEnvironmentVariable("DSA_TRACE").isEmpty() ||
+                                        m_dsaSettings.value(AppConstants::PERFORMANCE_TRACING_PROPERTYNAME).toBool());
+  PerformanceMonitor::instance()->setEnabled(m_dsaSettings.value(AppConstants::PERFORMANCE_HUD_PROPERTYNAME).toBool());
+
+  // stalls of the UI thread are logged for field diagnostics
+  StallWatchdog::instance()->setLogPath(m_dataPath + QStringLiteral("/Logs/dsa-stalls.log"));
+  StallWatchdog::instance()->setThreshold(m_dsaSettings.value(AppConstants::STALL_THRESHOLD_PROPERTYNAME, s_defaultStallThreshold).toInt());
+
+  // metrics are published for monitoring the fleet, if a collector or local endpoint is configured
+  const QString userName = m_dsaSettings.value(AppConstants::USERNAME_PROPERTYNAME).toString();
+  if (!userName.isEmpty())
+    MetricsExporter::instance()->setNodeName(userName);
+  MetricsExporter::instance()->setProperties(m_dsaSettings.value(AppConstants::METRICS_EXPORT_PROPERTYNAME).toMap());
+
+  // the budget is configured in megabytes
+  MemoryBudget::instance()->setBudget(m_dsaSettings.value(AppConstants::MEMORY_BUDGET_PROPERTYNAME).toLongLong() * 1024 * 1024);
+  SceneContentBudget::instance()->setQuality(m_dsaSettings.value(AppConstants::SCENE_LAYER_QUALITY_PROPERTYNAME, SceneContentBudget::QUALITY_HIGH).toString());
+  SceneContentBudget::instance()->setBudget(m_dsaSettings.value(AppConstants::SCENE_MEMORY_BUDGET_PROPERTYNAME).toLongLong() * 1024 * 1024);
+
+  if (m_dsaSettings.contains(AppConstants::IDLE_FRAME_RATE_PROPERTYNAME))
+    FrameAnimationDriver::instance()->setIdleFrameRate(m_dsaSettings.value(AppConstants::IDLE_FRAME_RATE_PROPERTYNAME).toInt());
+
   connect(m_scene, &Scene::errorOccurred, this, &DsaController::onError);
 
   connect(ToolResourceProvider::instance(), &ToolResourceProvider::sceneChanged, this, [this, firstLoad{true}]() mutable
@@ -119,8 +196,25 @@ DsaController::DsaController(QObject* parent):
  */
 DsaController::~DsaController()
 {
-  // save the settings
-  saveSettings();
+  // take any layer changes which are still batched, without updating the other tools
+  if (m_cacheManager)
+  {
+    disconnect(m_cacheManager, &AbstractTool::propertyChanged, this, &DsaController::onPropertyChanged);
+    connect(m_cacheManager, &AbstractTool::propertyChanged, this, [this](const QString& propertyName, const QVariant& propertyValue)
+    {
+      m_dsaSettings.insert(propertyName, propertyValue);
+    });
+    m_cacheManager->flush();
+  }
+
+  // write any pending settings and wait for them to reach the disk
+  m_saveTimer->stop();
+  writeSettings();
+  m_saveThreadPool->waitForDone();
+
+  const QString tracePath = qEnvironmentVariable("DSA_TRACE");
+  if (!tracePath.isEmpty() && !TraceRecorder::instance()->writeTrace(tracePath))
+    qDebug() << "Failed to write trace to" << tracePath;
 }
 
 /*!
@@ -131,120 +225,237 @@ Scene* DsaController::scene() const
   return m_scene;
 }
 
+/*!
+  \brief Returns the Esri::ArcGISRuntime::Map used by the app when it is shown in a
+  2D map view, or \c nullptr.
+ */
+Map* DsaController::map() const
+{
+  return m_map;
+}
+
+/*!
+  \brief Returns whether the app is configured to show a 2D map rather than a 3D scene.
+
+  This is set by the \c ViewMode setting, which is \c 3D by default. A map is much
+  lighter to render, but has no elevation and cannot show scene packages, viewsheds or
+  line of sight. The view created for the app should be a \l Esri::ArcGISRuntime::MapView
+  when this is \c true.
+ */
+bool DsaController::isMapViewMode() const
+{
+  return m_dsaSettings.value(AppConstants::VIEW_MODE_PROPERTYNAME).toString().compare(AppConstants::VIEW_MODE_2D, Qt::CaseInsensitive) == 0;
+}
+
 /*!
   \brief Initialize the app with the Esri::ArcGISRuntime::GeoView \a geoView.
 
-  When this method is called, the various tools in the app are initialized.
+  When this method is called, the various tools in the app are initialized in phases.
+  The scene, or the map if \a geoView is a \l Esri::ArcGISRuntime::MapView, and the tools
+  needed to show the map and current location are initialized immediately, and the remaining tools once control returns to the event loop. Tools
+  which are created later, for example through \l ToolManager::acquireTool, are
+  initialized as they are added.
+
+  The time taken by each phase and tool is recorded by \l StartupProfiler, and written
+  as a trace if \c StartupTracePath is set or the \c DSA_STARTUP_TRACE environment
+  variable is set.
+
+  If \c PerformanceTracing is set, or the \c DSA_TRACE environment variable is set to
+  a file path, the work done from here on is also recorded by \l TraceRecorder. With
+  \c DSA_TRACE, the trace is written to that path when the controller is destroyed.
  */
 void DsaController::init(GeoView* geoView)
 {
-  ToolResourceProvider::instance()->setGeoView(geoView);
+  DSA_TRACE_SCOPE("DsaController::init");
 
-  bool hasActiveScene = false;
-  auto openScenePackageTool = ToolManager::instance().tool<OpenMobileScenePackageController>();
-  if (openScenePackageTool)
   {
-    openScenePackageTool->setProperties(m_dsaSettings);
-    hasActiveScene = openScenePackageTool->hasActiveScene();
+    StartupProfiler::Phase phase(QStringLiteral("scene"));
+
+    ToolResourceProvider::instance()->setGeoView(geoView);
+
+    // a map view has no scene, so scene packages are not opened
+    const bool isMapView = dynamic_cast<MapView*>(geoView) != nullptr;
+
+    bool hasActiveScene = false;
+    OpenMobileScenePackageController* openScenePackageTool = isMapView ? nullptr : ToolManager::instance().tool<OpenMobileScenePackageController>();
+    if (openScenePackageTool)
+    {
+      openScenePackageTool->setProperties(m_dsaSettings);
+      hasActiveScene = openScenePackageTool->hasActiveScene();
+    }
+
+    m_cacheManager = new LayerCacheManager(this);
+    if (openScenePackageTool && !openScenePackageTool->packageDataPath().isEmpty())
+      m_cacheManager->addExcludedPath(openScenePackageTool->packageDataPath());
+
+    // Only set the default scene if the scene package tool hasn't set a scene.
+    if (!hasActiveScene)
+    {
+      if (!m_dsaSettings.contains(AppConstants::INITIALLOCATION_PROPERTYNAME))
+      {
+        // While a scene change would normally write out the viewpoint
+        // to config if/when it is missing, this here is a special case. We
+        // want the config file to contain a nice human-editable initial location
+        // using a distance measure. Extracting the viewpoint from the scene
+        // will give us a calculated viewpoint with no distance measure, so we have
+        // to set this manually.
+        m_dsaSettings[AppConstants::INITIALLOCATION_PROPERTYNAME] = defaultViewpoint();
+      }
+
+      if (isMapView)
+        setupMap();
+      else
+        ToolResourceProvider::instance()->setScene(m_scene);
+    }
+    // set the selection color for graphics and features
+    geoView->setSelectionProperties(SelectionProperties(Qt::red));
   }
 
-  m_cacheManager = new LayerCacheManager(this);
-  if (openScenePackageTool && !openScenePackageTool->packageDataPath().isEmpty())
-    m_cacheManager->addExcludedPath(openScenePackageTool->packageDataPath());
+  // tools which are created later, for example when their view is first shown, are
+  // configured once their construction has completed
+  connect(&ToolManager::instance(), &ToolManager::toolAdded, this, [this](AbstractTool* abstractTool)
+  {
+    QPointer<AbstractTool> addedTool(abstractTool);
+    QTimer::singleShot(0, this, [this, addedTool]()
+    {
+      if (addedTool)
+        configureTool(addedTool);
+    });
+  });
 
-  // Only set the default scene if the scene package tool hasn't set a scene.
-  if (!hasActiveScene)
+  // the tools needed to show the map and the current location are configured straight away
   {
-    if (!m_dsaSettings.contains(AppConstants::INITIALLOCATION_PROPERTYNAME))
+    StartupProfiler::Phase phase(QStringLiteral("critical tools"));
+    for (AbstractTool* abstractTool : ToolManager::instance())
     {
-      // While a scene change would normally write out the viewpoint
-      // to config if/when it is missing, this here is a special case. We
-      // want the config file to contain a nice human-editable initial location
-      // using a distance measure. Extracting the viewpoint from the scene
-      // will give us a calculated viewpoint with no distance measure, so we have
-      // to set this manually.
-      m_dsaSettings[AppConstants::INITIALLOCATION_PROPERTYNAME] = defaultViewpoint();
+      if (abstractTool && m_criticalToolNames.contains(abstractTool->toolName()))
+        configureTool(abstractTool);
     }
-
-    ToolResourceProvider::instance()->setScene(m_scene);
   }
-  // set the selection color for graphics and features
-  geoView->setSelectionProperties(SelectionProperties(Qt::red));
 
-  // connect all tool signals
-  for(AbstractTool* abstractTool : ToolManager::instance())
+  // the remaining tools are configured once the app has had a chance to draw
+  QTimer::singleShot(0, this, [this]()
   {
-    if (!abstractTool)
-      continue;
+    {
+      DSA_TRACE_SCOPE("DsaController::configureSecondaryTools");
+      StartupProfiler::Phase phase(QStringLiteral("secondary tools"));
+      for (AbstractTool* abstractTool : ToolManager::instance())
+      {
+        if (abstractTool)
+          configureTool(abstractTool);
+      }
+    }
 
-    abstractTool->setProperties(m_dsaSettings);
+    StartupProfiler::instance()->mark(QStringLiteral("startup complete"));
+    writeStartupTrace();
+  });
+}
 
-    connect(abstractTool, &AbstractTool::errorOccurred, this, &DsaController::onError);
-    connect(abstractTool, &AbstractTool::propertyChanged, this, &DsaController::onPropertyChanged);
+/*!
+  \internal
 
-    if (abstractTool->metaObject()->indexOfSignal("toolErrorOccurred(QString,QString)") != -1)
-      connect(abstractTool, SIGNAL(toolErrorOccurred(QString,QString)), this, SLOT(onToolError(QString, QString)));
+  Applies the settings to \a abstractTool and connects its signals, unless this
+  has already been done.
+ */
+void DsaController::configureTool(AbstractTool* abstractTool)
+{
+  if (!abstractTool || m_configuredTools.contains(abstractTool))
+    return;
 
-    // certain tools can conflict - for example, those which interact directly with the view
-    if (!isConflictingTool(abstractTool->toolName()))
-      continue;
+  StartupProfiler::Phase phase(QString("tool: %1").arg(abstractTool->toolName()));
+
+  m_configuredTools.insert(abstractTool);
+  connect(abstractTool, &QObject::destroyed, this, [this, abstractTool]()
+  {
+    m_configuredTools.remove(abstractTool);
+  });
 
-    // whenever a conflciting tool is activated, deactivate all of the other conflicting tools
-    connect(abstractTool, &AbstractTool::activeChanged, this, [this, abstractTool]()
+  abstractTool->setProperties(m_dsaSettings);
+
+  connect(abstractTool, &AbstractTool::errorOccurred, this, &DsaController::onError);
+  connect(abstractTool, &AbstractTool::propertyChanged, this, &DsaController::onPropertyChanged);
+
+  if (abstractTool->metaObject()->indexOfSignal("toolErrorOccurred(QString,QString)") != -1)
+    connect(abstractTool, SIGNAL(toolErrorOccurred(QString,QString)), this, SLOT(onToolError(QString, QString)));
+
+  // certain tools can conflict - for example, those which interact directly with the view
+  if (!isConflictingTool(abstractTool->toolName()))
+    return;
+
+  // whenever a conflciting tool is activated, deactivate all of the other conflicting tools
+  connect(abstractTool, &AbstractTool::activeChanged, this, [this, abstractTool]()
+  {
+    bool anyActive = false;
+
+    // if this tool is becoming active, deactivate all conflicting tools
+    if (abstractTool->isActive())
     {
-      bool anyActive = false;
+      anyActive = true;
+      auto toolsIt = ToolManager::instance().begin();
+      auto toolsEnd = ToolManager::instance().end();
+      for (; toolsIt != toolsEnd; ++toolsIt)
+      {
+        AbstractTool* candidateTool = *toolsIt;
+        if (!candidateTool)
+          continue;
+
+        if (candidateTool->toolName() == abstractTool->toolName())
+          continue;
+
+        if (!isConflictingTool(candidateTool->toolName()))
+          continue;
 
-      // if this tool is becoming active, deactivate all conflicting tools
-      if (abstractTool->isActive())
+        if (candidateTool->isActive())
+          candidateTool->setActive(false);
+      }
+    }
+    // otherwise, if this tool is becoming deactivated, check if any of the conflicting tools are now active
+    else
+    {
+
+      auto toolsIt = ToolManager::instance().begin();
+      auto toolsEnd = ToolManager::instance().end();
+      for (; toolsIt != toolsEnd; ++toolsIt)
       {
+        AbstractTool* candidateTool = *toolsIt;
+        if (!candidateTool)
+          continue;
+
+        if (!isConflictingTool(candidateTool->toolName()))
+          continue;
+
+        if (!candidateTool->isActive())
+          continue;
+
         anyActive = true;
-        auto toolsIt = ToolManager::instance().begin();
-        auto toolsEnd = ToolManager::instance().end();
-        for (; toolsIt != toolsEnd; ++toolsIt)
-        {
-          AbstractTool* candidateTool = *toolsIt;
-          if (!candidateTool)
-            continue;
-
-          if (candidateTool->toolName() == abstractTool->toolName())
-            continue;
-
-          if (!isConflictingTool(candidateTool->toolName()))
-            continue;
-
-          if (candidateTool->isActive())
-            candidateTool->setActive(false);
-        }
+        break;
       }
-      // otherwise, if this tool is becoming deactivated, check if any of the conflicting tools are now active
-      else
-      {
+    }
 
-        auto toolsIt = ToolManager::instance().begin();
-        auto toolsEnd = ToolManager::instance().end();
-        for (; toolsIt != toolsEnd; ++toolsIt)
-        {
-          AbstractTool* candidateTool = *toolsIt;
-          if (!candidateTool)
-            continue;
+    // The context menu should only be active when the other tools which interact with the view are not
+    ContextMenuController* contextMenu = ToolManager::instance().tool<ContextMenuController>();
+    if (contextMenu && contextMenu->isActive() == anyActive)
+      contextMenu->setActive(!anyActive);
+  });
+}
 
-          if (!isConflictingTool(candidateTool->toolName()))
-            continue;
+/*!
+  \internal
 
-          if (!candidateTool->isActive())
-            continue;
+  Writes the startup trace to the path given by the \c DSA_STARTUP_TRACE environment
+  variable or, if that is not set, the \c StartupTracePath setting.
+ */
+void DsaController::writeStartupTrace()
+{
+  QString tracePath = qEnvironmentVariable("DSA_STARTUP_TRACE");
+  if (tracePath.isEmpty())
+    tracePath = m_dsaSettings.value(AppConstants::STARTUP_TRACE_PROPERTYNAME).toString();
 
-          anyActive = true;
-          break;
-        }
-      }
+  if (tracePath.isEmpty())
+    return;
 
-      // The context menu should only be active when the other tools which interact with the view are not
-      ContextMenuController* contextMenu = ToolManager::instance().tool<ContextMenuController>();
-      if (contextMenu && contextMenu->isActive() == anyActive)
-        contextMenu->setActive(!anyActive);
-    });
-  }
+  if (!StartupProfiler::instance()->writeTrace(tracePath))
+    qDebug() << "Failed to write startup trace to" << tracePath;
 }
 
 /*!
@@ -273,7 +484,12 @@ void DsaController::onPropertyChanged(const QString& propertyName, const QVarian
   if (m_dsaSettings.value(propertyName) == propertyValue)
     return;
 
-  m_dsaSettings.insert(propertyName, propertyValue);
+  // a performance profile changes the settings of several tools at once
+  if (propertyName == AppConstants::PERFORMANCE_PROFILE_PROPERTYNAME)
+    applyPerformanceProfile(propertyValue.toString());
+  else
+    m_dsaSettings.insert(propertyName, propertyValue);
+
   // save the settings
   saveSettings();
 
@@ -302,6 +518,21 @@ void DsaController::resetToDefaultScene()
   if (!basemapTool)
     return;
 
+  // a 2D map view is given a new map with the default basemap, since a map has no surface
+  if (m_map)
+  {
+    m_map = new Map(this);
+    connect(m_map, &Map::errorOccurred, this, &DsaController::onError);
+    m_map->setInitialViewpoint(mapViewpointFromJson(defaultViewpoint()));
+
+    ToolResourceProvider::instance()->setMap(m_map);
+    basemapTool->selectInitialBasemap();
+
+    onPropertyChanged(AppConstants::LAYERS_PROPERTYNAME, QJsonArray().toVariantList());
+    m_cacheManager->setProperties(m_dsaSettings);
+    return;
+  }
+
   // create scene
   Scene* newScene = new Scene(this);
   newScene->setInitialViewpoint(viewpointFromJson(defaultViewpoint()));
@@ -343,10 +574,26 @@ void DsaController::setupConfig()
   // get the app config
   m_configFilePath = QString("%1/%2").arg(m_dsaSettings["RootDataDirectory"].toString(), QStringLiteral("DsaAppConfig.json"));
 
+  m_snapshotFilePath = QString("%1/%2").arg(QStandardPaths::writableLocation(QStandardPaths::CacheLocation), QStringLiteral("DsaAppConfig.cbor"));
+
   // If the config file does not exist, create it, and set all of the defaults
   if (!QFileInfo::exists(m_configFilePath))
   {
     saveSettings();
+    return;
+  }
+
+  // use the snapshot of the config file if it is still current
+  QVariantMap snapshotSettings;
+  bool isTouched = false;
+  if (readSettingsSnapshot(m_snapshotFilePath, m_configFilePath, snapshotSettings, isTouched))
+  {
+    for (auto it = snapshotSettings.cbegin(); it != snapshotSettings.cend(); ++it)
+      m_dsaSettings[it.key()] = it.value();
+
+    // a file which was touched but not changed is re-stamped, so it is not hashed again
+    if (!isTouched)
+      return;
   }
   else
   {
@@ -356,8 +603,20 @@ void DsaController::setupConfig()
 
     // get the values from the config, and write to the settings map
     for (const QString& key : allKeys)
-      m_dsaSettings[key] = settings.value(key);
+    {
+      const QVariant value = settings.value(key);
+      m_dsaSettings[key] = value;
+      snapshotSettings[key] = value;
+    }
   }
+
+  // refresh the snapshot for the next startup
+  const QString snapshotFilePath = m_snapshotFilePath;
+  const QString configFilePath = m_configFilePath;
+  m_saveThreadPool->start([snapshotFilePath, configFilePath, snapshotSettings]()
+  {
+    writeSettingsSnapshot(snapshotFilePath, configFilePath, snapshotSettings);
+  });
 }
 
 /*! \brief internal
@@ -511,19 +770,65 @@ void DsaController::createDefaultSettings()
   m_dsaSettings[QStringLiteral("MarkupConfig")] = markupJson;
   writeDefaultConditions();
   m_dsaSettings[OpenMobileScenePackageController::PACKAGE_DIRECTORY_PROPERTYNAME] = QString("%1/Packages").arg(m_dsaSettings["RootDataDirectory"].toString());
+  m_dsaSettings[OpenMobileScenePackageController::PRELOAD_PACKAGES_PROPERTYNAME] = QStringLiteral("true");
 }
 
 /*!
- * \brief Save the app properties to a custom JSON QSettings file.
+ * \brief Schedule the app properties to be saved to the JSON config file.
+ *
+ * Saves are written behind: the settings are marked as modified and written
+ * once no further changes have been made for a short interval.
  */
 void DsaController::saveSettings()
 {
-  QSettings settings(m_configFilePath, m_jsonFormat);
+  m_settingsModified = true;
+  m_saveTimer->start();
+}
+
+/*!
+ * \internal
+ *
+ * Write a snapshot of the app properties to the JSON config file in the background.
+ *
+ * The file is written with \c QSaveFile, so the new contents are written to a
+ * temporary file which replaces the config file only once it has been completely
+ * written. A failed or interrupted write leaves the previous config file intact.
+ */
+void DsaController::writeSettings()
+{
+  if (!m_settingsModified)
+    return;
+
+  m_settingsModified = false;
+
+  // if further writes are queued behind this one, it is skipped since the
+  // later snapshot supersedes it
+  const int generation = ++m_saveGeneration;
+  const QVariantMap dsaSettings = m_dsaSettings;
+  const QString configFilePath = m_configFilePath;
+  const QString snapshotFilePath = m_snapshotFilePath;
+
+  m_saveThreadPool->start([this, generation, dsaSettings, configFilePath, snapshotFilePath]()
+  {
+    if (generation != m_saveGeneration)
+      return;
+
+    QDir().mkpath(QFileInfo(configFilePath).absolutePath());
 
-  auto it = m_dsaSettings.cbegin();
-  auto itEnd = m_dsaSettings.cend();
-  for (; it != itEnd; ++it)
-    settings.setValue(it.key(), it.value());
+    QSaveFile configFile(configFilePath);
+    if (configFile.open(QIODevice::WriteOnly) && writeJsonFile(configFile, dsaSettings) && configFile.commit())
+    {
+      writeSettingsSnapshot(snapshotFilePath, configFilePath, dsaSettings);
+      return;
+    }
+
+    const QString errorString = configFile.errorString();
+    configFile.cancelWriting();
+    QMetaObject::invokeMethod(this, [this, configFilePath, errorString]()
+    {
+      emit errorOccurred(QStringLiteral("Failed to save settings"), QString("%1: %2").arg(configFilePath, errorString));
+    }, Qt::QueuedConnection);
+  });
 }
 
 void DsaController::writeInitialLocation(const Viewpoint& viewpoint)
@@ -545,6 +850,7 @@ void DsaController::writeInitialLocation(const Viewpoint& viewpoint)
   initialLocationJson.insert( QStringLiteral("roll"), initialCamera.roll());
 
   m_dsaSettings[AppConstants::INITIALLOCATION_PROPERTYNAME] = initialLocationJson.toVariantMap();
+  saveSettings();
 }
 
 Viewpoint DsaController::readInitialLocation()
@@ -552,6 +858,54 @@ Viewpoint DsaController::readInitialLocation()
   return viewpointFromJson(m_dsaSettings[AppConstants::INITIALLOCATION_PROPERTYNAME].toJsonObject());
 }
 
+/*!
+  \internal
+
+  Merges the settings of the performance profile \a profileName into the app's
+  settings, and applies those which are not owned by a tool. The tools are then
+  given all of the changes in a single pass.
+
+  \sa PerformanceProfile
+ */
+void DsaController::applyPerformanceProfile(const QString& profileName)
+{
+  const QVariantMap profileSettings = PerformanceProfile::settings(profileName, m_dsaSettings);
+  if (profileSettings.isEmpty())
+    return;
+
+  for (auto it = profileSettings.cbegin(); it != profileSettings.cend(); ++it)
+    m_dsaSettings.insert(it.key(), it.value());
+
+  if (profileSettings.contains(AppConstants::IDLE_FRAME_RATE_PROPERTYNAME))
+    FrameAnimationDriver::instance()->setIdleFrameRate(profileSettings.value(AppConstants::IDLE_FRAME_RATE_PROPERTYNAME).toInt());
+
+  if (profileSettings.contains(AppConstants::MEMORY_BUDGET_PROPERTYNAME))
+    MemoryBudget::instance()->setBudget(profileSettings.value(AppConstants::MEMORY_BUDGET_PROPERTYNAME).toLongLong() * 1024 * 1024);
+
+  if (profileSettings.contains(AppConstants::SCENE_LAYER_QUALITY_PROPERTYNAME))
+    SceneContentBudget::instance()->setQuality(profileSettings.value(AppConstants::SCENE_LAYER_QUALITY_PROPERTYNAME).toString());
+
+  if (profileSettings.contains(AppConstants::SCENE_MEMORY_BUDGET_PROPERTYNAME))
+    SceneContentBudget::instance()->setBudget(profileSettings.value(AppConstants::SCENE_MEMORY_BUDGET_PROPERTYNAME).toLongLong() * 1024 * 1024);
+}
+
+/*!
+  \internal
+
+  Creates the map shown by a 2D map view, starting at the configured initial location.
+ */
+void DsaController::setupMap()
+{
+  if (!m_map)
+  {
+    m_map = new Map(this);
+    connect(m_map, &Map::errorOccurred, this, &DsaController::onError);
+  }
+
+  m_map->setInitialViewpoint(mapViewpointFromJson(m_dsaSettings[AppConstants::INITIALLOCATION_PROPERTYNAME].toJsonObject()));
+  ToolResourceProvider::instance()->setMap(m_map);
+}
+
 void DsaController::updateInitialLocationOnSceneChange(bool isInitialization)
 {
   if (!m_scene)
@@ -637,6 +991,106 @@ bool writeJsonFile(QIODevice& device, const QSettings::SettingsMap& map)
   return writtenBytes != -1;
 }
 
+/*! \brief Returns the SHA-1 hash of the contents of the file at \a filePath.
+ *
+ * Returns an empty array if the file cannot be read.
+ */
+QByteArray fileHash(const QString& filePath)
+{
+  QFile file(filePath);
+  if (!file.open(QIODevice::ReadOnly))
+    return QByteArray();
+
+  QCryptographicHash hash(QCryptographicHash::Sha1);
+  if (!hash.addData(&file))
+    return QByteArray();
+
+  return hash.result();
+}
+
+/*! \brief Reads the settings snapshot at \a snapshotFilePath into \a settings.
+ *
+ * The snapshot is memory mapped and decoded from CBOR. It is only used if it was
+ * taken from the config file at \a configFilePath, and that file still has the
+ * recorded size and modification time. If only the modification time differs, the
+ * contents of the config file are hashed instead and \a isTouched is set to \c true
+ * when the hash still matches.
+ *
+ * Returns \c true if the snapshot is current and \c false if the config file must
+ * be parsed.
+ */
+bool readSettingsSnapshot(const QString& snapshotFilePath, const QString& configFilePath, QVariantMap& settings, bool& isTouched)
+{
+  QFile snapshotFile(snapshotFilePath);
+  if (!snapshotFile.open(QIODevice::ReadOnly) || snapshotFile.size() == 0)
+    return false;
+
+  uchar* mapped = snapshotFile.map(0, snapshotFile.size());
+  if (!mapped)
+    return false;
+
+  const QByteArray data = QByteArray::fromRawData(reinterpret_cast<const char*>(mapped), static_cast<int>(snapshotFile.size()));
+  QCborParserError parserError;
+  const QCborMap snapshot = QCborValue::fromCbor(data, &parserError).toMap();
+  if (parserError.error != QCborError::NoError ||
+      snapshot.value(QStringLiteral("version")).toInteger() != s_settingsSnapshotVersion ||
+      snapshot.value(QStringLiteral("path")).toString() != configFilePath)
+    return false;
+
+  const QFileInfo configInfo(configFilePath);
+  if (snapshot.value(QStringLiteral("size")).toInteger() != configInfo.size())
+    return false;
+
+  if (snapshot.value(QStringLiteral("modified")).toInteger() != configInfo.lastModified().toMSecsSinceEpoch())
+  {
+    if (snapshot.value(QStringLiteral("hash")).toByteArray() != fileHash(configFilePath))
+      return false;
+
+    isTouched = true;
+  }
+
+  // decoding copies the values, so the map can be released
+  settings = snapshot.value(QStringLiteral("settings")).toMap().toVariantMap();
+  return !settings.isEmpty();
+}
+
+/*! \brief Writes a snapshot of \a settings, as read from or written to the config file
+ * at \a configFilePath, to \a snapshotFilePath.
+ *
+ * The snapshot records the size, modification time and hash of the config file so that
+ * it can be validated by \l readSettingsSnapshot. A failure to write only means that the
+ * JSON is parsed at the next startup, so it is not reported.
+ */
+void writeSettingsSnapshot(const QString& snapshotFilePath, const QString& configFilePath, const QVariantMap& settings)
+{
+  const QFileInfo configInfo(configFilePath);
+  const QByteArray hash = fileHash(configFilePath);
+  if (hash.isEmpty())
+    return;
+
+  QCborMap snapshot;
+  snapshot.insert(QStringLiteral("version"), s_settingsSnapshotVersion);
+  snapshot.insert(QStringLiteral("path"), configFilePath);
+  snapshot.insert(QStringLiteral("size"), configInfo.size());
+  snapshot.insert(QStringLiteral("modified"), configInfo.lastModified().toMSecsSinceEpoch());
+  snapshot.insert(QStringLiteral("hash"), hash);
+  snapshot.insert(QStringLiteral("settings"), QCborMap::fromVariantMap(settings));
+
+  QDir().mkpath(QFileInfo(snapshotFilePath).absolutePath());
+
+  QSaveFile snapshotFile(snapshotFilePath);
+  if (!snapshotFile.open(QIODevice::WriteOnly))
+    return;
+
+  if (snapshotFile.write(QCborValue(snapshot).toCbor()) == -1)
+  {
+    snapshotFile.cancelWriting();
+    return;
+  }
+
+  snapshotFile.commit();
+}
+
 Viewpoint viewpointFromJson(const QJsonObject& initialLocation)
 {
   if (initialLocation.isEmpty())
@@ -677,6 +1131,20 @@ Viewpoint viewpointFromJson(const QJsonObject& initialLocation)
   return initViewpoint;
 }
 
+Viewpoint mapViewpointFromJson(const QJsonObject& initialLocation)
+{
+  // a map has no camera, so the center is shown north up at the scale which roughly
+  // covers the same ground as the camera distance on a handheld sized view
+  constexpr double distanceToScale = 10.0;
+
+  const Viewpoint sceneViewpoint = viewpointFromJson(initialLocation);
+  if (sceneViewpoint.isEmpty())
+    return Viewpoint{};
+
+  const double distance = initialLocation.value(QStringLiteral("distance")).toDouble();
+  return Viewpoint(Point(sceneViewpoint.targetGeometry()), distance * distanceToScale);
+}
+
 QJsonObject defaultViewpoint()
 {
   QJsonObject defaultViewpoint;
@@ -20,13 +20,21 @@
 // Qt headers
 #include <QJsonArray>
 #include <QObject>
+#include <QSet>
 #include <QSettings>
 #include <QStringList>
 #include <QVariantMap>
 
+// STL headers
+#include <atomic>
+
+class QThreadPool;
+class QTimer;
+
 namespace Esri {
 namespace ArcGISRuntime {
   class Error;
+  class Map;
   class Scene;
   class GeoView;
   class Layer;
@@ -36,6 +44,7 @@ namespace ArcGISRuntime {
 
 namespace Dsa {
 
+class AbstractTool;
 class LayerCacheManager;
 
 class DsaController : public QObject
@@ -47,6 +56,9 @@ public:
   ~DsaController();
 
   Esri::ArcGISRuntime::Scene* scene() const;
+  Esri::ArcGISRuntime::Map* map() const;
+
+  bool isMapViewMode() const;
 
   void init(Esri::ArcGISRuntime::GeoView* geoView);
 
@@ -66,23 +78,36 @@ private:
   void setupConfig();
   void createDefaultSettings();
   void saveSettings();
+  void writeSettings();
   void writeDefaultLocalDataPaths();
   void writeDefaultConditions();
   void writeDefaultMessageFeeds();
   bool isConflictingTool(const QString& toolName) const;
+  void configureTool(AbstractTool* abstractTool);
+  void writeStartupTrace();
   void updateInitialLocationOnSceneChange(bool isInitialization);
+  void setupMap();
+  void applyPerformanceProfile(const QString& profileName);
 
   void writeInitialLocation(const Esri::ArcGISRuntime::Viewpoint& viewpoint);
   Esri::ArcGISRuntime::Viewpoint readInitialLocation();
 
   Esri::ArcGISRuntime::Scene* m_scene = nullptr;
+  Esri::ArcGISRuntime::Map* m_map = nullptr;
   LayerCacheManager* m_cacheManager = nullptr;
 
   QString m_dataPath;
   QVariantMap m_dsaSettings;
   QString m_configFilePath;
+  QString m_snapshotFilePath;
   QSettings::Format m_jsonFormat;
   QStringList m_conflictingToolNames;
+  QStringList m_criticalToolNames;
+  QSet<AbstractTool*> m_configuredTools;
+  QThreadPool* m_saveThreadPool = nullptr;
+  std::atomic<int> m_saveGeneration{0};
+  QTimer* m_saveTimer = nullptr;
+  bool m_settingsModified = false;
 };
 
 } // Dsa
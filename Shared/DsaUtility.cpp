@@ -37,9 +37,16 @@ namespace Dsa {
 
 /*!
   \brief Returns the platform independent data path to \c [HOME]/ArcGIS/Runtime/Data/DSA.
+
+  The path can be replaced with the \c DSA_DATA_PATH environment variable, for
+  example to run the app against a prepared workspace.
  */
 QString DsaUtility::dataPath()
 {
+  const QString overridePath = qEnvironmentVariable("DSA_DATA_PATH");
+  if (!overridePath.isEmpty())
+    return QDir(overridePath).absolutePath();
+
   QDir dataDir;
 #ifdef Q_OS_ANDROID
   dataDir = QDir(QStringLiteral("/sdcard"));
@@ -0,0 +1,412 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "ElevationSampleCache.h"
+
+// C++ API headers
+#include "ElevationSourceListModel.h"
+#include "GeometryEngine.h"
+#include "Surface.h"
+
+// STL headers
+#include <algorithm>
+#include <cmath>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+namespace
+{
+// the size of each tile in degrees, roughly 550m of latitude
+constexpr double s_tileSize = 0.005;
+
+// the number of elevation posts along each side of a tile
+constexpr int s_postCount = 9;
+
+// the number of tiles which are kept in the cache
+constexpr int s_maximumTiles = 32;
+
+// the number of elevation samples requested from the surface at once
+constexpr int s_maximumSampleRequests = 64;
+
+// the distance from the edge of a tile, as a fraction of the tile, at which the
+// neighbouring tile is prefetched
+constexpr double s_prefetchMargin = 0.25;
+
+constexpr quint64 s_indexOffset = 1u << 31;
+
+quint64 tileKey(qint64 column, qint64 row)
+{
+  return (static_cast<quint64>(row + s_indexOffset) << 32) | static_cast<quint64>(column + s_indexOffset);
+}
+
+qint64 tileColumn(quint64 key)
+{
+  return static_cast<qint64>(key & 0xFFFFFFFF) - static_cast<qint64>(s_indexOffset);
+}
+
+qint64 tileRow(quint64 key)
+{
+  return static_cast<qint64>(key >> 32) - static_cast<qint64>(s_indexOffset);
+}
+
+Point toWgs84(const Point& location)
+{
+  if (location.isEmpty() || location.spatialReference() == SpatialReference::wgs84())
+    return location;
+
+  return geometry_cast<Point>(GeometryEngine::project(location, SpatialReference::wgs84()));
+}
+}
+
+/*!
+  \class Dsa::ElevationSampleCache
+  \inmodule Dsa
+  \inherits QObject
+  \brief A cache of elevation samples from the scene's base
+  \l Esri::ArcGISRuntime::Surface, which is shared by the app's tools.
+
+  The cache divides the world into tiles of fixed size in WGS84 degrees. When the
+  elevation of a location is requested, the elevation of a grid of posts across the
+  tile containing the location is sampled asynchronously from the surface. Once
+  the tile is complete, the elevation of any location within it is bilinearly
+  interpolated from the posts without issuing further surface requests.
+
+  \l tileLoaded is emitted whenever a tile has been sampled, so that callers whose
+  request could not be answered can try again. The cache is cleared when the
+  elevation sources of the surface change.
+ */
+
+/*!
+  \brief Returns the singleton instance of the cache.
+ */
+ElevationSampleCache* ElevationSampleCache::instance()
+{
+  static ElevationSampleCache s_instance;
+
+  return &s_instance;
+}
+
+/*!
+  \internal
+ */
+ElevationSampleCache::ElevationSampleCache(QObject* parent):
+  QObject(parent)
+{
+}
+
+/*!
+  \brief Destructor.
+ */
+ElevationSampleCache::~ElevationSampleCache()
+{
+  for (const QMetaObject::Connection& connection : qAsConst(m_surfaceConnections))
+    disconnect(connection);
+}
+
+/*!
+  \brief Returns the surface which elevation is sampled from.
+ */
+Surface* ElevationSampleCache::surface() const
+{
+  return m_surface;
+}
+
+/*!
+  \brief Sets the \a surface which elevation is sampled from.
+
+  Changing the surface clears the cache.
+ */
+void ElevationSampleCache::setSurface(Surface* surface)
+{
+  if (surface == m_surface)
+    return;
+
+  for (const QMetaObject::Connection& connection : qAsConst(m_surfaceConnections))
+    disconnect(connection);
+  m_surfaceConnections.clear();
+
+  m_surface = surface;
+  clear();
+
+  if (!m_surface)
+    return;
+
+  m_surfaceConnections.append(connect(m_surface, &Surface::locationToElevationCompleted,
+                                      this, &ElevationSampleCache::handleElevation));
+
+  // samples taken from the previous elevation sources are no longer valid
+  ElevationSourceListModel* elevationSources = m_surface->elevationSources();
+  if (!elevationSources)
+    return;
+
+  m_surfaceConnections.append(connect(elevationSources, &QAbstractItemModel::rowsInserted, this, &ElevationSampleCache::clear));
+  m_surfaceConnections.append(connect(elevationSources, &QAbstractItemModel::rowsRemoved, this, &ElevationSampleCache::clear));
+  m_surfaceConnections.append(connect(elevationSources, &QAbstractItemModel::modelReset, this, &ElevationSampleCache::clear));
+}
+
+/*!
+  \brief Sets \a elevation to the cached elevation of \a location.
+
+  Returns \c true if the tile containing \a location has been sampled. Otherwise the
+  tile is requested from the surface, \a elevation is unchanged and \c false is returned.
+ */
+bool ElevationSampleCache::elevation(const Point& location, double& elevation)
+{
+  return lookUpElevation(location, elevation, true);
+}
+
+/*!
+  \brief Sets \a elevation to the cached elevation of \a location, without requesting
+  its tile from the surface.
+
+  Returns \c true if the tile containing \a location has been sampled. This suits
+  callers with many locations spread over a wide area, which request tiles a few at a
+  time, see \l pendingTileCount.
+ */
+bool ElevationSampleCache::cachedElevation(const Point& location, double& elevation)
+{
+  return lookUpElevation(location, elevation, false);
+}
+
+/*!
+  \internal
+ */
+bool ElevationSampleCache::lookUpElevation(const Point& location, double& elevation, bool requestMissingTile)
+{
+  const Point wgs84 = toWgs84(location);
+  if (wgs84.isEmpty())
+    return false;
+
+  const double column = wgs84.x() / s_tileSize;
+  const double row = wgs84.y() / s_tileSize;
+  const qint64 tileColumn = static_cast<qint64>(std::floor(column));
+  const qint64 tileRow = static_cast<qint64>(std::floor(row));
+  const quint64 key = tileKey(tileColumn, tileRow);
+
+  const auto findIt = m_tiles.constFind(key);
+  if (findIt == m_tiles.constEnd())
+  {
+    if (requestMissingTile)
+      requestTile(key);
+
+    return false;
+  }
+
+  if (findIt.value().m_remainingSamples > 0)
+    return false;
+
+  touchTile(key);
+
+  // bilinear interpolation between the four posts surrounding the location
+  const QVector<float>& posts = findIt.value().m_posts;
+  const double x = (column - tileColumn) * (s_postCount - 1);
+  const double y = (row - tileRow) * (s_postCount - 1);
+  const int x0 = qBound(0, static_cast<int>(x), s_postCount - 2);
+  const int y0 = qBound(0, static_cast<int>(y), s_postCount - 2);
+  const double fx = x - x0;
+  const double fy = y - y0;
+
+  const double south = posts[y0 * s_postCount + x0] * (1.0 - fx) + posts[y0 * s_postCount + x0 + 1] * fx;
+  const double north = posts[(y0 + 1) * s_postCount + x0] * (1.0 - fx) + posts[(y0 + 1) * s_postCount + x0 + 1] * fx;
+  elevation = south * (1.0 - fy) + north * fy;
+
+  return true;
+}
+
+/*!
+  \brief Requests the tile containing \a location, and any neighbouring tile which
+  \a location is close to, so that they are ready before they are needed.
+ */
+void ElevationSampleCache::prefetch(const Point& location)
+{
+  const Point wgs84 = toWgs84(location);
+  if (wgs84.isEmpty())
+    return;
+
+  const double column = wgs84.x() / s_tileSize;
+  const double row = wgs84.y() / s_tileSize;
+  const qint64 minColumn = static_cast<qint64>(std::floor(column - s_prefetchMargin));
+  const qint64 maxColumn = static_cast<qint64>(std::floor(column + s_prefetchMargin));
+  const qint64 minRow = static_cast<qint64>(std::floor(row - s_prefetchMargin));
+  const qint64 maxRow = static_cast<qint64>(std::floor(row + s_prefetchMargin));
+
+  for (qint64 tileRow = minRow; tileRow <= maxRow; ++tileRow)
+  {
+    for (qint64 tileColumn = minColumn; tileColumn <= maxColumn; ++tileColumn)
+    {
+      if (!m_tiles.contains(tileKey(tileColumn, tileRow)))
+        requestTile(tileKey(tileColumn, tileRow));
+    }
+  }
+}
+
+/*!
+  \brief Removes every tile from the cache.
+
+  Samples which are still in progress are discarded when they complete.
+ */
+void ElevationSampleCache::clear()
+{
+  m_tiles.clear();
+  m_recentTiles.clear();
+  m_pendingSamples.clear();
+  m_sampleTasks.clear();
+}
+
+/*!
+  \brief Returns the number of tiles in the cache, including those still being sampled.
+ */
+int ElevationSampleCache::tileCount() const
+{
+  return m_tiles.size();
+}
+
+/*!
+  \brief Returns the number of tiles which are still being sampled.
+ */
+int ElevationSampleCache::pendingTileCount() const
+{
+  return static_cast<int>(std::count_if(m_tiles.cbegin(), m_tiles.cend(), [](const Tile& tile)
+  {
+    return tile.m_remainingSamples > 0;
+  }));
+}
+
+/*!
+  \internal
+
+  Adds the tile \a tileKey to the cache and queues the sampling of its posts.
+ */
+void ElevationSampleCache::requestTile(quint64 tileKey)
+{
+  if (!m_surface || m_tiles.contains(tileKey))
+    return;
+
+  const int postCount = s_postCount * s_postCount;
+
+  Tile tile;
+  tile.m_posts.fill(0.0f, postCount);
+  tile.m_remainingSamples = postCount;
+  m_tiles.insert(tileKey, tile);
+  m_recentTiles.append(tileKey);
+
+  for (int post = 0; post < postCount; ++post)
+    m_pendingSamples.append(qMakePair(tileKey, post));
+
+  evictTiles();
+  requestSamples();
+}
+
+/*!
+  \internal
+
+  Requests further samples from the surface, limiting the number of requests which
+  are in progress at once.
+ */
+void ElevationSampleCache::requestSamples()
+{
+  if (!m_surface)
+    return;
+
+  while (m_sampleTasks.size() < s_maximumSampleRequests && !m_pendingSamples.isEmpty())
+  {
+    const QPair<quint64, int> sample = m_pendingSamples.takeFirst();
+    const double x = (tileColumn(sample.first) + static_cast<double>(sample.second % s_postCount) / (s_postCount - 1)) * s_tileSize;
+    const double y = (tileRow(sample.first) + static_cast<double>(sample.second / s_postCount) / (s_postCount - 1)) * s_tileSize;
+
+    m_sampleTasks.insert(m_surface->locationToElevation(Point(x, y, SpatialReference::wgs84())).taskId(), sample);
+  }
+}
+
+/*!
+  \internal
+
+  Stores the \a elevation sampled by \a taskId, emitting \l tileLoaded once every
+  post of its tile has been sampled.
+ */
+void ElevationSampleCache::handleElevation(QUuid taskId, double elevation)
+{
+  auto findIt = m_sampleTasks.find(taskId);
+  if (findIt == m_sampleTasks.end())
+    return;
+
+  const QPair<quint64, int> sample = findIt.value();
+  m_sampleTasks.erase(findIt);
+
+  auto tileIt = m_tiles.find(sample.first);
+  if (tileIt != m_tiles.end())
+  {
+    tileIt.value().m_posts[sample.second] = static_cast<float>(elevation);
+    if (--tileIt.value().m_remainingSamples == 0)
+      emit tileLoaded();
+  }
+
+  requestSamples();
+}
+
+/*!
+  \internal
+
+  Marks \a tileKey as the most recently used tile.
+ */
+void ElevationSampleCache::touchTile(quint64 tileKey)
+{
+  if (!m_recentTiles.isEmpty() && m_recentTiles.last() == tileKey)
+    return;
+
+  m_recentTiles.removeOne(tileKey);
+  m_recentTiles.append(tileKey);
+}
+
+/*!
+  \internal
+
+  Removes the least recently used tiles which have been completely sampled,
+  until the cache is within its limit.
+ */
+void ElevationSampleCache::evictTiles()
+{
+  auto it = m_recentTiles.begin();
+  while (m_tiles.size() > s_maximumTiles && it != m_recentTiles.end())
+  {
+    auto tileIt = m_tiles.find(*it);
+    if (tileIt != m_tiles.end() && tileIt.value().m_remainingSamples > 0)
+    {
+      ++it;
+      continue;
+    }
+
+    if (tileIt != m_tiles.end())
+      m_tiles.erase(tileIt);
+
+    it = m_recentTiles.erase(it);
+  }
+}
+
+} // Dsa
+
+// Signal Documentation
+
+/*!
+  \fn void ElevationSampleCache::tileLoaded();
+
+  \brief Signal emitted when every elevation post of a tile has been sampled.
+ */
@@ -0,0 +1,88 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef ELEVATIONSAMPLECACHE_H
+#define ELEVATIONSAMPLECACHE_H
+
+// Qt headers
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QPair>
+#include <QPointer>
+#include <QUuid>
+#include <QVector>
+
+namespace Esri {
+namespace ArcGISRuntime {
+class Point;
+class Surface;
+}
+}
+
+namespace Dsa {
+
+class ElevationSampleCache : public QObject
+{
+  Q_OBJECT
+
+public:
+  static ElevationSampleCache* instance();
+
+  ~ElevationSampleCache();
+
+  Esri::ArcGISRuntime::Surface* surface() const;
+  void setSurface(Esri::ArcGISRuntime::Surface* surface);
+
+  bool elevation(const Esri::ArcGISRuntime::Point& location, double& elevation);
+  bool cachedElevation(const Esri::ArcGISRuntime::Point& location, double& elevation);
+  void prefetch(const Esri::ArcGISRuntime::Point& location);
+  void clear();
+
+  int tileCount() const;
+  int pendingTileCount() const;
+
+signals:
+  void tileLoaded();
+
+private:
+  explicit ElevationSampleCache(QObject* parent = nullptr);
+  Q_DISABLE_COPY(ElevationSampleCache)
+
+  struct Tile
+  {
+    QVector<float> m_posts;
+    int m_remainingSamples = 0;
+  };
+
+  bool lookUpElevation(const Esri::ArcGISRuntime::Point& location, double& elevation, bool requestMissingTile);
+  void requestTile(quint64 tileKey);
+  void requestSamples();
+  void handleElevation(QUuid taskId, double elevation);
+  void touchTile(quint64 tileKey);
+  void evictTiles();
+
+  QPointer<Esri::ArcGISRuntime::Surface> m_surface;
+  QList<QMetaObject::Connection> m_surfaceConnections;
+  QHash<quint64, Tile> m_tiles;
+  QList<quint64> m_recentTiles;
+  QList<QPair<quint64, int>> m_pendingSamples;
+  QHash<QUuid, QPair<quint64, int>> m_sampleTasks;
+};
+
+} // Dsa
+
+#endif // ELEVATIONSAMPLECACHE_H
@@ -0,0 +1,469 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "ElevationSourceLoader.h"
+
+// C++ API headers
+#include "ArcGISTiledElevationSource.h"
+#include "RasterElevationSource.h"
+#include "TileCache.h"
+
+// Qt headers
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QThread>
+#include <QThreadPool>
+
+// STL headers
+#include <algorithm>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+namespace
+{
+const QString s_rastersKey = QStringLiteral("rasters");
+const QString s_pathKey = QStringLiteral("path");
+const QString s_sizeKey = QStringLiteral("size");
+const QString s_modifiedKey = QStringLiteral("modified");
+const QString s_validKey = QStringLiteral("valid");
+
+// rasters validated by one background task
+const int s_validationChunkSize = 32;
+
+// rasters mosaicked by one RasterElevationSource, so that large folders load in parallel
+const int s_rastersPerSource = 64;
+}
+
+/*!
+  \class Dsa::ElevationSourceLoader
+  \inmodule Dsa
+  \inherits QObject
+  \brief Builds elevation sources from tile packages and rasters in the background.
+
+  Rasters are validated on a pool of background threads: files which are
+  missing, empty or do not start with a DTED or TIFF header are rejected
+  before the runtime tries to open them, and reported through
+  \l rastersRejected. The valid rasters are split into groups, each
+  mosaicked by its own RasterElevationSource, and all sources of a call to
+  \l load are loaded at once. Once every one of them has finished,
+  \l sourcesLoaded hands over the loaded sources together, so that the scene
+  surface can be updated in a single pass.
+
+  The outcome of each validation is kept in a mosaic index, a JSON file
+  recording the size, modification time and validity of every raster seen.
+  Rasters which are unchanged since they were indexed are not read again.
+  The index can be built in advance and deployed with the data.
+ */
+
+/*!
+  \brief Constructor taking the \a indexPath of the mosaic index and an optional \a parent.
+
+  An empty \a indexPath keeps the index in memory only.
+ */
+ElevationSourceLoader::ElevationSourceLoader(const QString& indexPath, QObject* parent) :
+  QObject(parent),
+  m_indexPath(indexPath),
+  m_index(readIndex(indexPath)),
+  m_threadPool(new QThreadPool(this)),
+  m_indexThreadPool(new QThreadPool(this))
+{
+  m_threadPool->setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
+
+  // index writes are run one at a time, in the order they were started
+  m_indexThreadPool->setMaxThreadCount(1);
+}
+
+/*!
+  \brief Destructor.
+ */
+ElevationSourceLoader::~ElevationSourceLoader()
+{
+  m_threadPool->clear();
+  m_threadPool->waitForDone();
+  m_indexThreadPool->waitForDone();
+}
+
+/*!
+  \brief Validates \a rasterPaths and builds elevation sources from them and
+  from the tile packages in \a tilePackagePaths.
+
+  This returns immediately. \l sourcesLoaded is emitted once all of the
+  sources have loaded.
+ */
+void ElevationSourceLoader::load(const QStringList& tilePackagePaths, const QStringList& rasterPaths)
+{
+  if (tilePackagePaths.isEmpty() && rasterPaths.isEmpty())
+    return;
+
+  const int batchId = ++m_nextBatchId;
+  Batch& batch = m_batches[batchId];
+  batch.m_tilePackagePaths = tilePackagePaths;
+
+  for (int i = 0; i < rasterPaths.size(); i += s_validationChunkSize)
+  {
+    const QStringList paths = rasterPaths.mid(i, s_validationChunkSize);
+
+    Index knownEntries;
+    for (const QString& path : paths)
+    {
+      auto it = m_index.constFind(path);
+      if (it != m_index.constEnd())
+        knownEntries.insert(path, it.value());
+    }
+
+    ++batch.m_pendingValidations;
+    m_threadPool->start([this, batchId, paths, knownEntries]()
+    {
+      const QList<IndexEntry> entries = validateRasters(paths, knownEntries);
+
+      QMetaObject::invokeMethod(this, [this, batchId, entries]()
+      {
+        handleValidated(batchId, entries);
+      }, Qt::QueuedConnection);
+    });
+  }
+
+  if (batch.m_pendingValidations == 0)
+    createSources(batchId);
+}
+
+/*!
+  \brief Returns whether any sources are still being validated or loaded.
+ */
+bool ElevationSourceLoader::isLoading() const
+{
+  return !m_batches.isEmpty();
+}
+
+/*!
+  \internal
+
+  Returns the index entries of \a paths, reading the header of each raster
+  unless it is unchanged from its entry in \a knownEntries.
+ */
+QList<ElevationSourceLoader::IndexEntry> ElevationSourceLoader::validateRasters(const QStringList& paths, const Index& knownEntries)
+{
+  QList<IndexEntry> entries;
+  entries.reserve(paths.size());
+
+  for (const QString& path : paths)
+  {
+    const QFileInfo fileInfo(path);
+
+    IndexEntry entry;
+    entry.m_path = path;
+    entry.m_size = fileInfo.size();
+    entry.m_lastModified = fileInfo.lastModified().toMSecsSinceEpoch();
+
+    const IndexEntry known = knownEntries.value(path);
+    if (!known.m_path.isEmpty() && known.m_size == entry.m_size && known.m_lastModified == entry.m_lastModified)
+      entry.m_valid = known.m_valid;
+    else
+      entry.m_valid = fileInfo.isFile() && entry.m_size > 0 && hasElevationHeader(path, fileInfo.suffix());
+
+    entries.append(entry);
+  }
+
+  return entries;
+}
+
+/*!
+  \internal
+
+  Returns whether the raster at \a path can be read and, for DTED and TIFF
+  files as given by \a suffix, starts with the header of its format.
+ */
+bool ElevationSourceLoader::hasElevationHeader(const QString& path, const QString& suffix)
+{
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly))
+    return false;
+
+  const QByteArray header = file.read(4);
+  if (header.size() < 4)
+    return false;
+
+  const QString format = suffix.toLower();
+  if (format.startsWith(QStringLiteral("dt")))
+    return header.startsWith("UHL");
+
+  if (format == QStringLiteral("tif") || format == QStringLiteral("tiff") || format == QStringLiteral("geotiff"))
+  {
+    // classic and BigTIFF, in either byte order
+    return header == QByteArray("II*\0", 4) || header == QByteArray("MM\0*", 4) ||
+           header == QByteArray("II+\0", 4) || header == QByteArray("MM\0+", 4);
+  }
+
+  return true;
+}
+
+/*!
+  \internal
+
+  Returns the mosaic index saved at \a indexPath.
+ */
+ElevationSourceLoader::Index ElevationSourceLoader::readIndex(const QString& indexPath)
+{
+  Index index;
+
+  QFile indexFile(indexPath);
+  if (indexPath.isEmpty() || !indexFile.open(QIODevice::ReadOnly))
+    return index;
+
+  const QJsonArray rasters = QJsonDocument::fromJson(indexFile.readAll()).object().value(s_rastersKey).toArray();
+  for (const QJsonValue& value : rasters)
+  {
+    const QJsonObject entryJson = value.toObject();
+    IndexEntry entry;
+    entry.m_path = entryJson.value(s_pathKey).toString();
+    entry.m_size = static_cast<qint64>(entryJson.value(s_sizeKey).toDouble());
+    entry.m_lastModified = static_cast<qint64>(entryJson.value(s_modifiedKey).toDouble());
+    entry.m_valid = entryJson.value(s_validKey).toBool();
+    if (!entry.m_path.isEmpty())
+      index.insert(entry.m_path, entry);
+  }
+
+  return index;
+}
+
+/*!
+  \internal
+
+  Saves \a index to \a indexPath, replacing any previous index.
+ */
+void ElevationSourceLoader::writeIndex(const QString& indexPath, const Index& index)
+{
+  QStringList paths = index.keys();
+  std::sort(paths.begin(), paths.end());
+
+  QJsonArray rasters;
+  for (const QString& path : paths)
+  {
+    const IndexEntry& entry = index[path];
+    QJsonObject entryJson;
+    entryJson.insert(s_pathKey, entry.m_path);
+    entryJson.insert(s_sizeKey, static_cast<double>(entry.m_size));
+    entryJson.insert(s_modifiedKey, static_cast<double>(entry.m_lastModified));
+    entryJson.insert(s_validKey, entry.m_valid);
+    rasters.append(entryJson);
+  }
+
+  QJsonObject indexJson;
+  indexJson.insert(s_rastersKey, rasters);
+
+  QDir().mkpath(QFileInfo(indexPath).absolutePath());
+
+  QSaveFile indexFile(indexPath);
+  if (!indexFile.open(QIODevice::WriteOnly))
+    return;
+
+  indexFile.write(QJsonDocument(indexJson).toJson(QJsonDocument::Compact));
+  indexFile.commit();
+}
+
+/*!
+  \internal
+
+  Records the validated \a entries of the batch \a batchId, and creates its
+  sources once all of its rasters have been validated.
+ */
+void ElevationSourceLoader::handleValidated(int batchId, const QList<IndexEntry>& entries)
+{
+  auto batchIt = m_batches.find(batchId);
+  if (batchIt == m_batches.end())
+    return;
+
+  for (const IndexEntry& entry : entries)
+  {
+    const IndexEntry previous = m_index.value(entry.m_path);
+    if (previous.m_path.isEmpty() || previous.m_size != entry.m_size ||
+        previous.m_lastModified != entry.m_lastModified || previous.m_valid != entry.m_valid)
+    {
+      m_index.insert(entry.m_path, entry);
+      m_indexChanged = true;
+    }
+
+    if (entry.m_valid)
+      batchIt->m_validRasters.append(entry.m_path);
+    else
+      batchIt->m_rejectedRasters.append(entry.m_path);
+  }
+
+  if (--batchIt->m_pendingValidations > 0)
+    return;
+
+  saveIndex();
+  createSources(batchId);
+}
+
+/*!
+  \internal
+
+  Creates and starts loading the sources of the batch \a batchId.
+ */
+void ElevationSourceLoader::createSources(int batchId)
+{
+  Batch& batch = m_batches[batchId];
+
+  if (!batch.m_rejectedRasters.isEmpty())
+    emit rastersRejected(batch.m_rejectedRasters);
+
+  // neighbouring tiles share a source, as they sort together by folder and name
+  QStringList rasters = batch.m_validRasters;
+  std::sort(rasters.begin(), rasters.end());
+
+  for (int i = 0; i < rasters.size(); i += s_rastersPerSource)
+  {
+    ++batch.m_pendingLoads;
+    loadSource(batchId, new RasterElevationSource(rasters.mid(i, s_rastersPerSource), this));
+  }
+
+  for (const QString& path : qAsConst(batch.m_tilePackagePaths))
+  {
+    ++batch.m_pendingLoads;
+    createTiledSource(batchId, path);
+  }
+
+  if (batch.m_pendingLoads == 0)
+    m_batches.remove(batchId);
+}
+
+/*!
+  \internal
+
+  Opens the tile package at \a path for the batch \a batchId, and loads an
+  elevation source from it if its tiles are LERC encoded.
+ */
+void ElevationSourceLoader::createTiledSource(int batchId, const QString& path)
+{
+  TileCache* tileCache = new TileCache(path, this);
+
+  connect(tileCache, &TileCache::doneLoading, this, [this, batchId, tileCache](Error error)
+  {
+    if (!error.isEmpty() || tileCache->tileInfo().format() != TileImageFormat::LERC)
+    {
+      tileCache->deleteLater();
+      handleSourceLoaded(batchId);
+      return;
+    }
+
+    loadSource(batchId, new ArcGISTiledElevationSource(tileCache, this));
+  });
+
+  tileCache->load();
+}
+
+/*!
+  \internal
+
+  Loads \a source as part of the batch \a batchId.
+ */
+template <typename Source>
+void ElevationSourceLoader::loadSource(int batchId, Source* source)
+{
+  m_batches[batchId].m_sources.append(source);
+
+  connect(source, &Source::doneLoading, this, [this, batchId, source](Error error)
+  {
+    if (!error.isEmpty())
+    {
+      m_batches[batchId].m_failedSources.insert(source);
+      emit errorOccurred(error);
+    }
+
+    handleSourceLoaded(batchId);
+  });
+
+  source->load();
+}
+
+/*!
+  \internal
+
+  Counts one source of the batch \a batchId as done, and hands over the
+  loaded sources once all of them are.
+ */
+void ElevationSourceLoader::handleSourceLoaded(int batchId)
+{
+  auto batchIt = m_batches.find(batchId);
+  if (batchIt == m_batches.end() || --batchIt->m_pendingLoads > 0)
+    return;
+
+  const Batch batch = m_batches.take(batchId);
+
+  QList<ElevationSource*> sources;
+  for (ElevationSource* source : batch.m_sources)
+  {
+    if (batch.m_failedSources.contains(source))
+      source->deleteLater();
+    else
+      sources.append(source);
+  }
+
+  if (!sources.isEmpty())
+    emit sourcesLoaded(sources);
+}
+
+/*!
+  \internal
+
+  Writes the mosaic index in the background if it has changed.
+ */
+void ElevationSourceLoader::saveIndex()
+{
+  if (m_indexPath.isEmpty() || !m_indexChanged)
+    return;
+
+  m_indexChanged = false;
+
+  const QString indexPath = m_indexPath;
+  const Index index = m_index;
+  m_indexThreadPool->start([indexPath, index]()
+  {
+    writeIndex(indexPath, index);
+  });
+}
+
+} // Dsa
+
+// Signal Documentation
+/*!
+  \fn void ElevationSourceLoader::sourcesLoaded(const QList<Esri::ArcGISRuntime::ElevationSource*>& sources);
+  \brief Signal emitted when all \a sources requested by one call to \l load have loaded.
+
+  Sources which failed to load are left out.
+ */
+
+/*!
+  \fn void ElevationSourceLoader::rastersRejected(const QStringList& paths);
+  \brief Signal emitted when the rasters at \a paths fail validation and are left out.
+ */
+
+/*!
+  \fn void ElevationSourceLoader::errorOccurred(const Esri::ArcGISRuntime::Error& error);
+  \brief Signal emitted when an elevation source fails to load with \a error.
+ */
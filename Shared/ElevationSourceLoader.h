@@ -0,0 +1,104 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef ELEVATIONSOURCELOADER_H
+#define ELEVATIONSOURCELOADER_H
+
+// Qt headers
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+
+namespace Esri {
+namespace ArcGISRuntime {
+  class ElevationSource;
+  class Error;
+}
+}
+
+class QThreadPool;
+
+namespace Dsa {
+
+class ElevationSourceLoader : public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit ElevationSourceLoader(const QString& indexPath, QObject* parent = nullptr);
+  ~ElevationSourceLoader();
+
+  void load(const QStringList& tilePackagePaths, const QStringList& rasterPaths);
+
+  bool isLoading() const;
+
+signals:
+  void sourcesLoaded(const QList<Esri::ArcGISRuntime::ElevationSource*>& sources);
+  void rastersRejected(const QStringList& paths);
+  void errorOccurred(const Esri::ArcGISRuntime::Error& error);
+
+private:
+  Q_DISABLE_COPY(ElevationSourceLoader)
+
+  struct IndexEntry
+  {
+    QString m_path;
+    qint64 m_size = 0;
+    qint64 m_lastModified = 0;
+    bool m_valid = false;
+  };
+
+  using Index = QHash<QString, IndexEntry>;
+
+  // the sources of one call to load, which are handed over together
+  struct Batch
+  {
+    QStringList m_tilePackagePaths;
+    QStringList m_validRasters;
+    QStringList m_rejectedRasters;
+    int m_pendingValidations = 0;
+    int m_pendingLoads = 0;
+    QList<Esri::ArcGISRuntime::ElevationSource*> m_sources;
+    QSet<Esri::ArcGISRuntime::ElevationSource*> m_failedSources;
+  };
+
+  static QList<IndexEntry> validateRasters(const QStringList& paths, const Index& knownEntries);
+  static bool hasElevationHeader(const QString& path, const QString& suffix);
+  static Index readIndex(const QString& indexPath);
+  static void writeIndex(const QString& indexPath, const Index& index);
+
+  void handleValidated(int batchId, const QList<IndexEntry>& entries);
+  void createSources(int batchId);
+  void createTiledSource(int batchId, const QString& path);
+  template <typename Source>
+  void loadSource(int batchId, Source* source);
+  void handleSourceLoaded(int batchId);
+  void saveIndex();
+
+  QString m_indexPath;
+  Index m_index;
+  bool m_indexChanged = false;
+  QThreadPool* m_threadPool = nullptr;
+  QThreadPool* m_indexThreadPool = nullptr;
+  QHash<int, Batch> m_batches;
+  int m_nextBatchId = 0;
+};
+
+} // Dsa
+
+#endif // ELEVATIONSOURCELOADER_H
@@ -0,0 +1,592 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "EnvelopeRTree.h"
+
+// STL headers
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace Dsa {
+
+// the maximum and minimum number of entries in each node of the tree
+static constexpr int s_maxEntries = 16;
+static constexpr int s_minEntries = 6;
+
+namespace
+{
+using Box = EnvelopeRTree::Box;
+
+// returns the smallest box containing both boxes, with the id of the first
+Box unite(const Box& box1, const Box& box2)
+{
+  Box result = box1;
+  result.m_xMin = std::min(box1.m_xMin, box2.m_xMin);
+  result.m_xMax = std::max(box1.m_xMax, box2.m_xMax);
+  result.m_yMin = std::min(box1.m_yMin, box2.m_yMin);
+  result.m_yMax = std::max(box1.m_yMax, box2.m_yMax);
+  return result;
+}
+
+double area(const Box& box)
+{
+  return (box.m_xMax - box.m_xMin) * (box.m_yMax - box.m_yMin);
+}
+
+double margin(const Box& box)
+{
+  return (box.m_xMax - box.m_xMin) + (box.m_yMax - box.m_yMin);
+}
+
+double overlapArea(const Box& box1, const Box& box2)
+{
+  const double width = std::min(box1.m_xMax, box2.m_xMax) - std::max(box1.m_xMin, box2.m_xMin);
+  const double height = std::min(box1.m_yMax, box2.m_yMax) - std::max(box1.m_yMin, box2.m_yMin);
+  return (width > 0.0 && height > 0.0) ? width * height : 0.0;
+}
+
+// returns whether the two boxes overlap or touch
+bool intersects(const Box& box1, const Box& box2)
+{
+  return (box1.m_xMin <= box2.m_xMax &&
+          box1.m_xMax >= box2.m_xMin &&
+          box1.m_yMin <= box2.m_yMax &&
+          box1.m_yMax >= box2.m_yMin);
+}
+
+bool contains(const Box& outer, const Box& inner)
+{
+  return (inner.m_xMin >= outer.m_xMin &&
+          inner.m_xMax <= outer.m_xMax &&
+          inner.m_yMin >= outer.m_yMin &&
+          inner.m_yMax <= outer.m_yMax);
+}
+}
+
+/*!
+  \class Dsa::EnvelopeRTree
+  \inmodule Dsa
+  \brief An R*-tree of bounding boxes, each identified by an integer id.
+
+  Unlike a quadtree, each box is held by exactly one leaf of the tree, whatever
+  its size, and the nodes of the tree are sized to the boxes they hold rather than
+  to a fixed subdivision of space. This makes the tree well suited to extended
+  geometries such as large polygons and long polylines, which would otherwise be
+  recorded in many cells of a quadtree.
+
+  The tree is bulk loaded with the Sort-Tile-Recursive algorithm. Boxes inserted
+  afterwards choose the subtree which needs the least overlap (at the level above
+  the leaves) or area enlargement, and full nodes are split along the axis with the
+  smallest total margin, using the R*-tree split. Forced re-insertion is not used.
+  Removing a box which leaves a node under-full re-inserts the remaining boxes of
+  that node.
+
+  The tree is not thread-safe, although it can be queried from several threads
+  while it is not being modified.
+ */
+
+/*!
+  \brief Constructor for an empty tree.
+ */
+EnvelopeRTree::EnvelopeRTree()
+{
+  clear();
+}
+
+/*!
+  \brief Destructor.
+ */
+EnvelopeRTree::~EnvelopeRTree()
+{
+}
+
+/*!
+  \brief Replaces the contents of the tree with \a boxes.
+
+  This is much faster than inserting each box in turn and produces a tree with
+  less overlap between its nodes. The id of each box must be unique.
+ */
+void EnvelopeRTree::load(const QVector<Box>& boxes)
+{
+  clear();
+  m_boxes.reserve(boxes.size());
+  for (const Box& box : boxes)
+    m_boxes.insert(box.m_id, box);
+
+  // each level is tiled into vertical slices, then each slice is packed into nodes
+  QVector<Box> level = boxes;
+  int height = 0;
+  while (level.size() > s_maxEntries)
+  {
+    const int nodeCount = (level.size() + s_maxEntries - 1) / s_maxEntries;
+    const int sliceSize = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(nodeCount)))) * s_maxEntries;
+
+    std::sort(level.begin(), level.end(), [](const Box& box1, const Box& box2)
+    {
+      return (box1.m_xMin + box1.m_xMax) < (box2.m_xMin + box2.m_xMax);
+    });
+
+    QVector<Box> parents;
+    parents.reserve(nodeCount);
+    for (int sliceBegin = 0; sliceBegin < level.size(); sliceBegin += sliceSize)
+    {
+      const int sliceEnd = std::min(level.size(), sliceBegin + sliceSize);
+      std::sort(level.begin() + sliceBegin, level.begin() + sliceEnd, [](const Box& box1, const Box& box2)
+      {
+        return (box1.m_yMin + box1.m_yMax) < (box2.m_yMin + box2.m_yMax);
+      });
+
+      for (int begin = sliceBegin; begin < sliceEnd; begin += s_maxEntries)
+      {
+        const int nodeIndex = createNode(height);
+        m_nodes[nodeIndex].m_entries = level.mid(begin, std::min(s_maxEntries, sliceEnd - begin));
+        parents.append(nodeBox(nodeIndex));
+      }
+    }
+
+    level.swap(parents);
+    ++height;
+  }
+
+  m_nodes[m_root].m_height = height;
+  m_nodes[m_root].m_entries = level;
+}
+
+/*!
+  \brief Inserts \a box into the tree, replacing any existing box with the same id.
+ */
+void EnvelopeRTree::insert(const Box& box)
+{
+  remove(box.m_id);
+  m_boxes.insert(box.m_id, box);
+  insertElement(box);
+}
+
+/*!
+  \brief Removes the box with \a id from the tree.
+
+  Returns \c false if there was no box with \a id.
+ */
+bool EnvelopeRTree::remove(int id)
+{
+  const auto findIt = m_boxes.find(id);
+  if (findIt == m_boxes.end())
+    return false;
+
+  const Box box = findIt.value();
+  m_boxes.erase(findIt);
+
+  QVector<int> orphans;
+  remove(m_root, box, orphans);
+
+  // a root with a single child is replaced by that child
+  while (m_nodes.at(m_root).m_height > 0 && m_nodes.at(m_root).m_entries.size() <= 1)
+  {
+    if (m_nodes.at(m_root).m_entries.isEmpty())
+    {
+      m_nodes[m_root].m_height = 0;
+      break;
+    }
+
+    const int previousRoot = m_root;
+    m_root = m_nodes.at(previousRoot).m_entries.first().m_id;
+    m_nodes[previousRoot].m_entries.clear();
+    m_freeNodes.append(previousRoot);
+  }
+
+  // the boxes held by under-full nodes are re-inserted
+  QVector<Box> orphanedBoxes;
+  for (const int orphan : orphans)
+  {
+    collectElements(orphan, orphanedBoxes);
+    releaseNode(orphan);
+  }
+
+  for (const Box& orphanedBox : orphanedBoxes)
+    insertElement(orphanedBox);
+
+  return true;
+}
+
+/*!
+  \brief Removes every box from the tree.
+ */
+void EnvelopeRTree::clear()
+{
+  m_nodes.clear();
+  m_freeNodes.clear();
+  m_boxes.clear();
+  m_root = createNode(0);
+}
+
+/*!
+  \brief Appends the id of every box which overlaps or touches \a query to \a results.
+ */
+void EnvelopeRTree::intersecting(const Box& query, QVector<int>& results) const
+{
+  intersecting(m_root, query, results);
+}
+
+/*!
+  \brief Returns the number of boxes in the tree.
+ */
+int EnvelopeRTree::size() const
+{
+  return m_boxes.size();
+}
+
+/*!
+  \brief Returns the number of levels in the tree.
+ */
+int EnvelopeRTree::height() const
+{
+  return m_nodes.at(m_root).m_height + 1;
+}
+
+/*!
+  \internal
+
+  Adds a node at \a height to the node array, re-using a released slot if there is one.
+  Returns the index of the node.
+ */
+int EnvelopeRTree::createNode(int height)
+{
+  Node node;
+  node.m_height = height;
+
+  if (!m_freeNodes.isEmpty())
+  {
+    const int nodeIndex = m_freeNodes.takeLast();
+    m_nodes[nodeIndex] = node;
+    return nodeIndex;
+  }
+
+  m_nodes.append(node);
+  return m_nodes.size() - 1;
+}
+
+/*!
+  \internal
+
+  Releases the node at \a nodeIndex, and all of its children, for re-use.
+ */
+void EnvelopeRTree::releaseNode(int nodeIndex)
+{
+  if (m_nodes.at(nodeIndex).m_height > 0)
+  {
+    for (const Box& entry : m_nodes.at(nodeIndex).m_entries)
+      releaseNode(entry.m_id);
+  }
+
+  m_nodes[nodeIndex].m_entries.clear();
+  m_freeNodes.append(nodeIndex);
+}
+
+/*!
+  \internal
+
+  Returns the box covering every entry of the node at \a nodeIndex, with the
+  index of the node as its id.
+ */
+EnvelopeRTree::Box EnvelopeRTree::nodeBox(int nodeIndex) const
+{
+  const QVector<Box>& entries = m_nodes.at(nodeIndex).m_entries;
+  Box result;
+  if (!entries.isEmpty())
+  {
+    result = entries.first();
+    for (const Box& entry : entries)
+      result = unite(result, entry);
+  }
+
+  result.m_id = nodeIndex;
+  return result;
+}
+
+/*!
+  \internal
+
+  Inserts the element \a box, which is already recorded in the box lookup, into a
+  leaf of the tree, growing a new root if the old root is split.
+ */
+void EnvelopeRTree::insertElement(const Box& box)
+{
+  const int sibling = insert(m_root, box);
+  if (sibling == -1)
+    return;
+
+  const int newRoot = createNode(m_nodes.at(m_root).m_height + 1);
+  m_nodes[newRoot].m_entries.append(nodeBox(m_root));
+  m_nodes[newRoot].m_entries.append(nodeBox(sibling));
+  m_root = newRoot;
+}
+
+/*!
+  \internal
+
+  Inserts \a box below the node at \a nodeIndex. If the node overflows it is split and
+  the index of the new sibling node is returned, otherwise \c -1 is returned.
+ */
+int EnvelopeRTree::insert(int nodeIndex, const Box& box)
+{
+  if (m_nodes.at(nodeIndex).m_height == 0)
+  {
+    m_nodes[nodeIndex].m_entries.append(box);
+  }
+  else
+  {
+    const int position = chooseSubtree(nodeIndex, box);
+    const int child = m_nodes.at(nodeIndex).m_entries.at(position).m_id;
+
+    // splitting may re-allocate the node array, so do not hold references across this call
+    const int sibling = insert(child, box);
+    if (sibling == -1)
+    {
+      Box& entry = m_nodes[nodeIndex].m_entries[position];
+      entry = unite(entry, box);
+    }
+    else
+    {
+      m_nodes[nodeIndex].m_entries[position] = nodeBox(child);
+      m_nodes[nodeIndex].m_entries.append(nodeBox(sibling));
+    }
+  }
+
+  if (m_nodes.at(nodeIndex).m_entries.size() > s_maxEntries)
+    return split(nodeIndex);
+
+  return -1;
+}
+
+/*!
+  \internal
+
+  Returns the position of the entry of the node at \a nodeIndex which \a box should be
+  inserted below. Above the leaves this is the entry needing the least overlap enlargement,
+  then the least area enlargement, then with the smallest area. Higher in the tree the
+  overlap is not considered.
+ */
+int EnvelopeRTree::chooseSubtree(int nodeIndex, const Box& box) const
+{
+  const QVector<Box>& entries = m_nodes.at(nodeIndex).m_entries;
+  const bool childrenAreLeaves = m_nodes.at(nodeIndex).m_height == 1;
+
+  int bestPosition = 0;
+  double bestOverlap = std::numeric_limits<double>::max();
+  double bestEnlargement = std::numeric_limits<double>::max();
+  double bestArea = std::numeric_limits<double>::max();
+  for (int i = 0; i < entries.size(); ++i)
+  {
+    const Box& entry = entries.at(i);
+    const Box enlarged = unite(entry, box);
+    const double entryArea = area(entry);
+    const double enlargement = area(enlarged) - entryArea;
+
+    double overlap = 0.0;
+    if (childrenAreLeaves)
+    {
+      for (int j = 0; j < entries.size(); ++j)
+      {
+        if (j != i)
+          overlap += overlapArea(enlarged, entries.at(j)) - overlapArea(entry, entries.at(j));
+      }
+    }
+
+    if (overlap > bestOverlap)
+      continue;
+
+    if (overlap == bestOverlap &&
+        (enlargement > bestEnlargement || (enlargement == bestEnlargement && entryArea >= bestArea)))
+      continue;
+
+    bestPosition = i;
+    bestOverlap = overlap;
+    bestEnlargement = enlargement;
+    bestArea = entryArea;
+  }
+
+  return bestPosition;
+}
+
+/*!
+  \internal
+
+  Splits the over-full node at \a nodeIndex, moving some of its entries to a new sibling
+  node whose index is returned.
+
+  The split axis is the one whose candidate distributions have the smallest total margin.
+  Along that axis, the distribution with the least overlap, then the least area, is used.
+ */
+int EnvelopeRTree::split(int nodeIndex)
+{
+  const QVector<Box> entries = m_nodes.at(nodeIndex).m_entries;
+  const int count = entries.size();
+
+  QVector<Box> bestEntries;
+  int bestSplit = s_minEntries;
+  double bestMarginSum = std::numeric_limits<double>::max();
+  QVector<Box> sorted;
+  QVector<Box> prefix(count);
+  QVector<Box> suffix(count);
+  for (int axis = 0; axis < 2; ++axis)
+  {
+    QVector<Box> axisEntries;
+    int axisSplit = s_minEntries;
+    double axisOverlap = std::numeric_limits<double>::max();
+    double axisArea = std::numeric_limits<double>::max();
+    double marginSum = 0.0;
+
+    // the entries are sorted by both their lower and their upper values along the axis
+    for (int bound = 0; bound < 2; ++bound)
+    {
+      sorted = entries;
+      std::sort(sorted.begin(), sorted.end(), [axis, bound](const Box& box1, const Box& box2)
+      {
+        if (axis == 0)
+          return bound == 0 ? box1.m_xMin < box2.m_xMin : box1.m_xMax < box2.m_xMax;
+
+        return bound == 0 ? box1.m_yMin < box2.m_yMin : box1.m_yMax < box2.m_yMax;
+      });
+
+      prefix[0] = sorted.first();
+      for (int i = 1; i < count; ++i)
+        prefix[i] = unite(prefix.at(i - 1), sorted.at(i));
+
+      suffix[count - 1] = sorted.last();
+      for (int i = count - 2; i >= 0; --i)
+        suffix[i] = unite(suffix.at(i + 1), sorted.at(i));
+
+      for (int firstCount = s_minEntries; firstCount <= count - s_minEntries; ++firstCount)
+      {
+        const Box& first = prefix.at(firstCount - 1);
+        const Box& second = suffix.at(firstCount);
+        marginSum += margin(first) + margin(second);
+
+        const double overlap = overlapArea(first, second);
+        const double splitArea = area(first) + area(second);
+        if (overlap < axisOverlap || (overlap == axisOverlap && splitArea < axisArea))
+        {
+          axisOverlap = overlap;
+          axisArea = splitArea;
+          axisEntries = sorted;
+          axisSplit = firstCount;
+        }
+      }
+    }
+
+    if (marginSum < bestMarginSum)
+    {
+      bestMarginSum = marginSum;
+      bestEntries = axisEntries;
+      bestSplit = axisSplit;
+    }
+  }
+
+  const int sibling = createNode(m_nodes.at(nodeIndex).m_height);
+  m_nodes[nodeIndex].m_entries = bestEntries.mid(0, bestSplit);
+  m_nodes[sibling].m_entries = bestEntries.mid(bestSplit);
+  return sibling;
+}
+
+/*!
+  \internal
+
+  Removes the element \a box from below the node at \a nodeIndex, returning whether it
+  was found. Child nodes left under-full are detached and appended to \a orphans.
+ */
+bool EnvelopeRTree::remove(int nodeIndex, const Box& box, QVector<int>& orphans)
+{
+  QVector<Box>& entries = m_nodes[nodeIndex].m_entries;
+  if (m_nodes.at(nodeIndex).m_height == 0)
+  {
+    for (int i = 0; i < entries.size(); ++i)
+    {
+      if (entries.at(i).m_id != box.m_id)
+        continue;
+
+      entries.remove(i);
+      return true;
+    }
+
+    return false;
+  }
+
+  for (int i = 0; i < entries.size(); ++i)
+  {
+    if (!contains(entries.at(i), box))
+      continue;
+
+    const int child = entries.at(i).m_id;
+    if (!remove(child, box, orphans))
+      continue;
+
+    if (m_nodes.at(child).m_entries.size() < s_minEntries)
+    {
+      orphans.append(child);
+      entries.remove(i);
+    }
+    else
+    {
+      entries[i] = nodeBox(child);
+    }
+
+    return true;
+  }
+
+  return false;
+}
+
+/*!
+  \internal
+
+  Appends the element boxes held below the node at \a nodeIndex to \a results.
+ */
+void EnvelopeRTree::collectElements(int nodeIndex, QVector<Box>& results) const
+{
+  const Node& node = m_nodes.at(nodeIndex);
+  if (node.m_height == 0)
+  {
+    results += node.m_entries;
+    return;
+  }
+
+  for (const Box& entry : node.m_entries)
+    collectElements(entry.m_id, results);
+}
+
+/*!
+  \internal
+ */
+void EnvelopeRTree::intersecting(int nodeIndex, const Box& query, QVector<int>& results) const
+{
+  const Node& node = m_nodes.at(nodeIndex);
+  for (const Box& entry : node.m_entries)
+  {
+    if (!intersects(entry, query))
+      continue;
+
+    if (node.m_height == 0)
+      results.append(entry.m_id);
+    else
+      intersecting(entry.m_id, query, results);
+  }
+}
+
+} // Dsa
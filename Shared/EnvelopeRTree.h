@@ -0,0 +1,78 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef ENVELOPERTREE_H
+#define ENVELOPERTREE_H
+
+// Qt headers
+#include <QHash>
+#include <QVector>
+
+namespace Dsa {
+
+class EnvelopeRTree
+{
+public:
+  struct Box
+  {
+    double m_xMin = 0.0;
+    double m_xMax = 0.0;
+    double m_yMin = 0.0;
+    double m_yMax = 0.0;
+    int m_id = -1;
+  };
+
+  EnvelopeRTree();
+  ~EnvelopeRTree();
+
+  void load(const QVector<Box>& boxes);
+  void insert(const Box& box);
+  bool remove(int id);
+  void clear();
+
+  void intersecting(const Box& query, QVector<int>& results) const;
+
+  int size() const;
+  int height() const;
+
+private:
+  // for a leaf the id of each entry is an element, otherwise it is a child node
+  struct Node
+  {
+    int m_height = 0;
+    QVector<Box> m_entries;
+  };
+
+  int createNode(int height);
+  void releaseNode(int nodeIndex);
+  Box nodeBox(int nodeIndex) const;
+  void insertElement(const Box& box);
+  int insert(int nodeIndex, const Box& box);
+  int chooseSubtree(int nodeIndex, const Box& box) const;
+  int split(int nodeIndex);
+  bool remove(int nodeIndex, const Box& box, QVector<int>& orphans);
+  void collectElements(int nodeIndex, QVector<Box>& results) const;
+  void intersecting(int nodeIndex, const Box& query, QVector<int>& results) const;
+
+  QVector<Node> m_nodes;
+  QVector<int> m_freeNodes;
+  QHash<int, Box> m_boxes; // the box of each element, needed to find it for removal
+  int m_root = -1;
+};
+
+} // Dsa
+
+#endif // ENVELOPERTREE_H
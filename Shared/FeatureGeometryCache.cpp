@@ -0,0 +1,637 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "FeatureGeometryCache.h"
+
+// dsa app headers
+#include "FeatureGeometryStore.h"
+#include "FeatureQueryResultManager.h"
+#include "MemoryBudget.h"
+
+// C++ API headers
+#include "ArcGISFeatureTable.h"
+#include "AttributeListModel.h"
+#include "Feature.h"
+#include "FeatureQueryResult.h"
+#include "FeatureTable.h"
+#include "Field.h"
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+/*!
+  \class Dsa::FeatureGeometryCache
+  \inmodule Dsa
+  \inherits QObject
+  \brief A cache of the geometry of every feature in an
+  \l Esri::ArcGISRuntime::FeatureTable, shared between all of the tools which
+  need it.
+
+  Each table is queried at most once: callers which request the geometry of a
+  table while its query is running wait for the same result. Only the geometry
+  of each feature is stored, so callers needing a \l Esri::ArcGISRuntime::GeoElement
+  should create a lightweight \l Esri::ArcGISRuntime::Graphic from it.
+
+  The ID of each feature is kept with its geometry. Edits made through \l addFeature,
+  \l updateFeature and \l deleteFeature are applied to the cached geometry one feature
+  at a time, without querying the table again, and \l featureEdited is emitted so that
+  users can update their own copies in the same way. The completion signals of the
+  table do not identify the edited feature, so the cached geometry for a table is
+  discarded when it is edited in any other way, and \l invalidated is emitted so that
+  users can request it again.
+
+  The geometry of tables read from local files is also kept in the \l FeatureGeometryStore.
+  On later runs of the app it is read from there, without querying the table, until the
+  dataset changes.
+
+  The cache is registered with the \l MemoryBudget. As its users keep their own
+  copies of the geometry, in spatial indexes for example, it is the first cache
+  emptied when memory is short. Tables are queried again on their next request.
+ */
+
+/*!
+  \brief Returns the singleton instance of the cache.
+ */
+FeatureGeometryCache* FeatureGeometryCache::instance()
+{
+  static FeatureGeometryCache s_instance;
+
+  return &s_instance;
+}
+
+/*!
+  \internal
+ */
+FeatureGeometryCache::FeatureGeometryCache(QObject* parent):
+  QObject(parent)
+{
+  MemoryBudget::instance()->registerCache(this, QStringLiteral("Feature geometry"), MemoryBudget::RedundantCopyPriority,
+                                          [this]() { return footprint(); },
+                                          [this]() { return release(); });
+}
+
+/*!
+  \brief Destructor.
+ */
+FeatureGeometryCache::~FeatureGeometryCache()
+{
+  const auto featureTables = m_entries.keys();
+  for (FeatureTable* featureTable : featureTables)
+    removeEntry(featureTable);
+}
+
+/*!
+  \brief Requests the geometry of every feature in \a featureTable.
+
+  \a callback is called once the geometry is available. If the geometry is already cached the call is still queued, so
+  \a callback is never called before this function returns. If the query fails,
+  \a callback is called with an empty list and the next request queries the
+  table again.
+
+  \a callback is not called if \a context has been destroyed.
+ */
+void FeatureGeometryCache::requestGeometries(FeatureTable* featureTable, QObject* context, GeometriesCallback callback)
+{
+  if (!featureTable || !context || !callback)
+    return;
+
+  auto findIt = m_entries.find(featureTable);
+  if (findIt != m_entries.end() && findIt.value().m_loaded)
+  {
+    const QList<Geometry> geometries = findIt.value().m_geometries;
+    QMetaObject::invokeMethod(context, [callback, geometries]()
+    {
+      callback(geometries);
+    }, Qt::QueuedConnection);
+    return;
+  }
+
+  Request request;
+  request.m_context = context;
+  request.m_callback = std::move(callback);
+
+  ensureEntry(featureTable);
+
+  Entry& entry = m_entries[featureTable];
+  entry.m_requests.append(request);
+
+  // wait for a query which is already running
+  if (!entry.m_taskId.isNull())
+    return;
+
+  queryFeatureTable(featureTable);
+}
+
+/*!
+  \brief Returns whether the geometry of \a featureTable is cached.
+ */
+bool FeatureGeometryCache::isCached(FeatureTable* featureTable) const
+{
+  const auto findIt = m_entries.constFind(featureTable);
+  return findIt != m_entries.constEnd() && findIt.value().m_loaded;
+}
+
+/*!
+  \brief Returns the IDs of the features in \a featureTable, in the same order as
+  the geometries passed to the callbacks of \l requestGeometries.
+
+  The list is empty if the geometry of the table is not cached. An ID is \c -1
+  if it could not be read.
+
+  \sa featureIdFieldName
+ */
+QList<qint64> FeatureGeometryCache::featureIds(FeatureTable* featureTable) const
+{
+  const auto findIt = m_entries.constFind(featureTable);
+  return findIt != m_entries.constEnd() && findIt.value().m_loaded ? findIt.value().m_featureIds : QList<qint64>();
+}
+
+/*!
+  \brief Discards the cached geometry of \a featureTable.
+
+  Any query which is running is restarted, so waiting callers receive the
+  up-to-date geometry. Emits \l invalidated.
+ */
+void FeatureGeometryCache::invalidate(FeatureTable* featureTable)
+{
+  auto findIt = m_entries.find(featureTable);
+  if (findIt == m_entries.end())
+    return;
+
+  Entry& entry = findIt.value();
+  entry.m_loaded = false;
+  entry.m_geometries.clear();
+  entry.m_featureIds.clear();
+  entry.m_estimatedBytes = 0;
+
+  // an edit may not change the size or modification time of the dataset straight away
+  FeatureGeometryStore::instance()->remove(FeatureGeometryStore::datasetKey(featureTable));
+
+  if (!entry.m_taskId.isNull())
+    queryFeatureTable(featureTable);
+
+  emit invalidated(featureTable);
+}
+
+/*!
+  \brief Adds \a feature to \a featureTable, returning the ID of the task.
+
+  Once the edit has completed the geometry of \a feature is added to the cache and
+  \l featureEdited is emitted.
+ */
+QUuid FeatureGeometryCache::addFeature(FeatureTable* featureTable, Feature* feature)
+{
+  if (!featureTable || !feature)
+    return QUuid();
+
+  // the feature is only given its ID once it has been added
+  Edit edit;
+  edit.m_type = EditType::Added;
+  edit.m_feature = feature;
+
+  return recordEdit(featureTable, featureTable->addFeature(feature).taskId(), edit);
+}
+
+/*!
+  \brief Updates \a feature in \a featureTable, returning the ID of the task.
+
+  Once the edit has completed the cached geometry of \a feature is replaced and
+  \l featureEdited is emitted.
+ */
+QUuid FeatureGeometryCache::updateFeature(FeatureTable* featureTable, Feature* feature)
+{
+  if (!featureTable || !feature)
+    return QUuid();
+
+  Edit edit;
+  edit.m_type = EditType::Updated;
+  edit.m_feature = feature;
+  edit.m_featureId = featureId(featureTable, feature);
+  edit.m_geometry = feature->geometry();
+
+  return recordEdit(featureTable, featureTable->updateFeature(feature).taskId(), edit);
+}
+
+/*!
+  \brief Deletes \a feature from \a featureTable, returning the ID of the task.
+
+  Once the edit has completed the geometry of \a feature is removed from the cache and
+  \l featureEdited is emitted.
+ */
+QUuid FeatureGeometryCache::deleteFeature(FeatureTable* featureTable, Feature* feature)
+{
+  if (!featureTable || !feature)
+    return QUuid();
+
+  Edit edit;
+  edit.m_type = EditType::Deleted;
+  edit.m_featureId = featureId(featureTable, feature);
+
+  return recordEdit(featureTable, featureTable->deleteFeature(feature).taskId(), edit);
+}
+
+/*!
+  \brief Returns the name of the field holding the ID of each feature in \a featureTable,
+  or an empty string if it has none.
+ */
+QString FeatureGeometryCache::featureIdFieldName(FeatureTable* featureTable)
+{
+  if (!featureTable)
+    return QString();
+
+  if (ArcGISFeatureTable* agsFeatureTable = qobject_cast<ArcGISFeatureTable*>(featureTable))
+    return agsFeatureTable->objectIdField();
+
+  const QList<Field> fields = featureTable->fields();
+  for (const Field& field : fields)
+  {
+    if (field.fieldType() == FieldType::OID)
+      return field.name();
+  }
+
+  return QString();
+}
+
+/*!
+  \brief Returns the ID of \a feature in \a featureTable, or \c -1 if it has none.
+ */
+qint64 FeatureGeometryCache::featureId(FeatureTable* featureTable, Feature* feature)
+{
+  const QString fieldName = featureIdFieldName(featureTable);
+  if (fieldName.isEmpty() || !feature || !feature->attributes() || !feature->attributes()->containsAttribute(fieldName))
+    return -1;
+
+  bool ok = false;
+  const qint64 id = feature->attributes()->attributeValue(fieldName).toLongLong(&ok);
+  return ok ? id : -1;
+}
+
+/*!
+  \internal
+
+  Responds to queries of, edits to and the destruction of \a featureTable.
+ */
+void FeatureGeometryCache::connectFeatureTable(FeatureTable* featureTable)
+{
+  Entry& entry = m_entries[featureTable];
+
+  entry.m_connections.append(connect(featureTable, &FeatureTable::queryFeaturesCompleted, this,
+                                     [this, featureTable](QUuid taskId, FeatureQueryResult* featureQueryResult)
+  {
+    handleQueryFeaturesCompleted(featureTable, taskId, featureQueryResult);
+  }));
+
+  auto handleEdit = [this, featureTable](QUuid taskId, bool success)
+  {
+    handleEditCompleted(featureTable, taskId, success);
+  };
+
+  entry.m_connections.append(connect(featureTable, &FeatureTable::addFeatureCompleted, this, handleEdit));
+  entry.m_connections.append(connect(featureTable, &FeatureTable::updateFeatureCompleted, this, handleEdit));
+  entry.m_connections.append(connect(featureTable, &FeatureTable::deleteFeatureCompleted, this, handleEdit));
+
+  entry.m_connections.append(connect(featureTable, &FeatureTable::destroyed, this, [this, featureTable]()
+  {
+    removeEntry(featureTable);
+  }));
+}
+
+/*!
+  \internal
+
+  Adds an entry for \a featureTable, if it does not have one.
+ */
+void FeatureGeometryCache::ensureEntry(FeatureTable* featureTable)
+{
+  if (m_entries.contains(featureTable))
+    return;
+
+  m_entries.insert(featureTable, Entry());
+  connectFeatureTable(featureTable);
+}
+
+/*!
+  \internal
+
+  Records \a edit of \a featureTable until the task \a taskId completes, returning \a taskId.
+ */
+QUuid FeatureGeometryCache::recordEdit(FeatureTable* featureTable, const QUuid& taskId, const Edit& edit)
+{
+  if (taskId.isNull())
+    return taskId;
+
+  // edits are tracked whether or not the geometry of the table is cached, so that the
+  // other copies of it can be kept up to date
+  ensureEntry(featureTable);
+  m_entries[featureTable].m_pendingEdits.insert(taskId, edit);
+
+  return taskId;
+}
+
+/*!
+  \internal
+
+  Applies the edit of \a featureTable made by the task \a taskId, if it was a \a success.
+  The cached geometry is discarded if the edit was not made through this cache.
+ */
+void FeatureGeometryCache::handleEditCompleted(FeatureTable* featureTable, QUuid taskId, bool success)
+{
+  auto findIt = m_entries.find(featureTable);
+  if (findIt == m_entries.end())
+    return;
+
+  auto editIt = findIt.value().m_pendingEdits.find(taskId);
+  if (editIt == findIt.value().m_pendingEdits.end())
+  {
+    invalidate(featureTable);
+    return;
+  }
+
+  const Edit edit = editIt.value();
+  findIt.value().m_pendingEdits.erase(editIt);
+
+  if (success && !applyEdit(featureTable, edit))
+    invalidate(featureTable);
+}
+
+/*!
+  \internal
+
+  Applies \a edit to the cached geometry of \a featureTable and emits \l featureEdited.
+
+  Returns \c false if the edited feature could not be identified.
+ */
+bool FeatureGeometryCache::applyEdit(FeatureTable* featureTable, const Edit& edit)
+{
+  Edit applied = edit;
+  if (applied.m_type != EditType::Deleted)
+  {
+    // an added feature is only given its ID once it is in the table
+    if (applied.m_feature)
+    {
+      applied.m_featureId = featureId(featureTable, applied.m_feature);
+      applied.m_geometry = applied.m_feature->geometry();
+    }
+    else if (applied.m_type == EditType::Added)
+    {
+      return false;
+    }
+  }
+
+  if (applied.m_featureId < 0)
+    return false;
+
+  Entry& entry = m_entries[featureTable];
+  if (entry.m_loaded)
+  {
+    if (entry.m_featureIds.size() != entry.m_geometries.size())
+      return false;
+
+    const int row = entry.m_featureIds.indexOf(applied.m_featureId);
+    if (row >= 0)
+    {
+      entry.m_estimatedBytes -= MemoryBudget::estimatedSize(entry.m_geometries.at(row));
+      if (applied.m_type == EditType::Deleted)
+      {
+        entry.m_geometries.removeAt(row);
+        entry.m_featureIds.removeAt(row);
+      }
+      else
+      {
+        entry.m_geometries[row] = applied.m_geometry;
+      }
+    }
+    else if (applied.m_type != EditType::Deleted)
+    {
+      entry.m_geometries.append(applied.m_geometry);
+      entry.m_featureIds.append(applied.m_featureId);
+    }
+
+    if (applied.m_type != EditType::Deleted)
+      entry.m_estimatedBytes += MemoryBudget::estimatedSize(applied.m_geometry);
+  }
+
+  // an edit may not change the size or modification time of the dataset straight away
+  FeatureGeometryStore::instance()->remove(FeatureGeometryStore::datasetKey(featureTable));
+
+  // a query which is running may have started before the edit
+  if (!entry.m_taskId.isNull())
+    queryFeatureTable(featureTable);
+
+  emit featureEdited(featureTable, applied.m_type, applied.m_featureId, applied.m_geometry);
+  return true;
+}
+
+/*!
+  \internal
+
+  Starts a query for every feature in \a featureTable, unless its geometry can be
+  read from the \l FeatureGeometryStore. The result of any previous query is ignored.
+ */
+void FeatureGeometryCache::queryFeatureTable(FeatureTable* featureTable)
+{
+  if (loadStoredGeometries(featureTable))
+    return;
+
+  QueryParameters allFeaturesQuery;
+  allFeaturesQuery.setWhereClause(QStringLiteral("1=1"));
+  allFeaturesQuery.setReturnGeometry(true);
+
+  m_entries[featureTable].m_taskId = featureTable->queryFeatures(allFeaturesQuery).taskId();
+}
+
+/*!
+  \internal
+
+  Stores the geometry of the features in \a featureQueryResult for \a featureTable
+  and passes it to every waiting caller.
+ */
+void FeatureGeometryCache::handleQueryFeaturesCompleted(FeatureTable* featureTable,
+                                                        QUuid taskId,
+                                                        FeatureQueryResult* featureQueryResult)
+{
+  auto findIt = m_entries.find(featureTable);
+  if (findIt == m_entries.end())
+    return;
+
+  // other users of the feature table may also be querying it
+  if (findIt.value().m_taskId != taskId)
+    return;
+
+  // Store the results in a RAII manager to ensure they are cleaned up
+  FeatureQueryResultManager results(featureQueryResult);
+
+  findIt.value().m_taskId = QUuid();
+
+  QList<Geometry> geometries;
+  QList<qint64> featureIds;
+  if (results.m_results)
+  {
+    // the features are only required within the scope of this method
+    QObject localParent;
+    const QList<Feature*> features = results.m_results->iterator().features(&localParent);
+    geometries.reserve(features.size());
+    featureIds.reserve(features.size());
+    for (Feature* feature : features)
+    {
+      if (!feature)
+        continue;
+
+      geometries.append(feature->geometry());
+      featureIds.append(featureId(featureTable, feature));
+    }
+
+    FeatureGeometryStore::instance()->store(FeatureGeometryStore::datasetKey(featureTable), geometries, featureIds);
+  }
+
+  completeRequests(featureTable, geometries, featureIds, results.m_results != nullptr);
+}
+
+/*!
+  \internal
+
+  Reads the geometry of \a featureTable from the \l FeatureGeometryStore, returning
+  \c false if it has not been stored for the current version of the dataset.
+
+  The waiting callers are called once control returns to the event loop.
+ */
+bool FeatureGeometryCache::loadStoredGeometries(FeatureTable* featureTable)
+{
+  QList<Geometry> geometries;
+  QList<qint64> featureIds;
+  if (!FeatureGeometryStore::instance()->load(FeatureGeometryStore::datasetKey(featureTable), geometries, featureIds))
+    return false;
+
+  // the load stands in for a query, so that later requests wait for it
+  const QUuid taskId = QUuid::createUuid();
+  m_entries[featureTable].m_taskId = taskId;
+
+  QMetaObject::invokeMethod(this, [this, featureTable, taskId, geometries, featureIds]()
+  {
+    auto findIt = m_entries.find(featureTable);
+    if (findIt == m_entries.end() || findIt.value().m_taskId != taskId)
+      return;
+
+    findIt.value().m_taskId = QUuid();
+    completeRequests(featureTable, geometries, featureIds, true);
+  }, Qt::QueuedConnection);
+
+  return true;
+}
+
+/*!
+  \internal
+
+  Caches \a geometries and the \a featureIds of their features for \a featureTable if
+  they were \a loaded, and passes the geometries to every waiting caller.
+ */
+void FeatureGeometryCache::completeRequests(FeatureTable* featureTable, const QList<Geometry>& geometries,
+                                            const QList<qint64>& featureIds, bool loaded)
+{
+  Entry& entry = m_entries[featureTable];
+  if (loaded)
+  {
+    entry.m_loaded = true;
+    entry.m_geometries = geometries;
+    entry.m_featureIds = featureIds;
+    entry.m_estimatedBytes = 0;
+    for (const Geometry& geometry : geometries)
+      entry.m_estimatedBytes += MemoryBudget::estimatedSize(geometry);
+  }
+
+  const QList<Request> requests = entry.m_requests;
+  entry.m_requests.clear();
+
+  for (const Request& request : requests)
+  {
+    if (request.m_context)
+      request.m_callback(geometries);
+  }
+}
+
+/*!
+  \internal
+ */
+void FeatureGeometryCache::removeEntry(FeatureTable* featureTable)
+{
+  auto findIt = m_entries.find(featureTable);
+  if (findIt == m_entries.end())
+    return;
+
+  const Entry entry = findIt.value();
+  m_entries.erase(findIt);
+
+  for (const auto& connection : entry.m_connections)
+    disconnect(connection);
+}
+
+/*!
+  \internal
+
+  Returns the estimated number of bytes of cached geometry.
+ */
+qint64 FeatureGeometryCache::footprint() const
+{
+  qint64 bytes = 0;
+  for (const Entry& entry : m_entries)
+    bytes += entry.m_estimatedBytes;
+
+  return bytes;
+}
+
+/*!
+  \internal
+
+  Discards all of the cached geometry, returning the estimated number of bytes
+  released. The tables stay connected, so that they are queried again on
+  their next request.
+ */
+qint64 FeatureGeometryCache::release()
+{
+  qint64 bytes = 0;
+  for (Entry& entry : m_entries)
+  {
+    if (!entry.m_loaded)
+      continue;
+
+    bytes += entry.m_estimatedBytes;
+    entry.m_loaded = false;
+    entry.m_geometries.clear();
+    entry.m_featureIds.clear();
+    entry.m_estimatedBytes = 0;
+  }
+
+  return bytes;
+}
+
+} // Dsa
+
+// Signal Documentation
+/*!
+  \fn void FeatureGeometryCache::invalidated(Esri::ArcGISRuntime::FeatureTable* featureTable);
+  \brief Signal emitted when the cached geometry of \a featureTable is discarded.
+ */
+
+/*!
+  \fn void FeatureGeometryCache::featureEdited(Esri::ArcGISRuntime::FeatureTable* featureTable, Dsa::FeatureGeometryCache::EditType editType, qint64 featureId, const Esri::ArcGISRuntime::Geometry& geometry);
+  \brief Signal emitted when the feature with the ID \a featureId in \a featureTable has been
+  edited through the cache. \a editType is the kind of edit and \a geometry the new geometry
+  of the feature, which is empty when it has been deleted.
+ */
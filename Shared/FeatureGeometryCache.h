@@ -0,0 +1,130 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef FEATUREGEOMETRYCACHE_H
+#define FEATUREGEOMETRYCACHE_H
+
+// C++ API headers
+#include "Geometry.h"
+
+// Qt headers
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QUuid>
+
+// STL headers
+#include <functional>
+
+namespace Esri {
+namespace ArcGISRuntime {
+class Feature;
+class FeatureQueryResult;
+class FeatureTable;
+}
+}
+
+namespace Dsa {
+
+class FeatureGeometryCache : public QObject
+{
+  Q_OBJECT
+
+public:
+  enum class EditType
+  {
+    Added,
+    Updated,
+    Deleted
+  };
+  Q_ENUM(EditType)
+
+  using GeometriesCallback = std::function<void(const QList<Esri::ArcGISRuntime::Geometry>& geometries)>;
+
+  static FeatureGeometryCache* instance();
+
+  ~FeatureGeometryCache();
+
+  void requestGeometries(Esri::ArcGISRuntime::FeatureTable* featureTable, QObject* context, GeometriesCallback callback);
+  bool isCached(Esri::ArcGISRuntime::FeatureTable* featureTable) const;
+  QList<qint64> featureIds(Esri::ArcGISRuntime::FeatureTable* featureTable) const;
+  void invalidate(Esri::ArcGISRuntime::FeatureTable* featureTable);
+
+  QUuid addFeature(Esri::ArcGISRuntime::FeatureTable* featureTable, Esri::ArcGISRuntime::Feature* feature);
+  QUuid updateFeature(Esri::ArcGISRuntime::FeatureTable* featureTable, Esri::ArcGISRuntime::Feature* feature);
+  QUuid deleteFeature(Esri::ArcGISRuntime::FeatureTable* featureTable, Esri::ArcGISRuntime::Feature* feature);
+
+  static QString featureIdFieldName(Esri::ArcGISRuntime::FeatureTable* featureTable);
+  static qint64 featureId(Esri::ArcGISRuntime::FeatureTable* featureTable, Esri::ArcGISRuntime::Feature* feature);
+
+signals:
+  void invalidated(Esri::ArcGISRuntime::FeatureTable* featureTable);
+  void featureEdited(Esri::ArcGISRuntime::FeatureTable* featureTable, Dsa::FeatureGeometryCache::EditType editType,
+                     qint64 featureId, const Esri::ArcGISRuntime::Geometry& geometry);
+
+private:
+  explicit FeatureGeometryCache(QObject* parent = nullptr);
+  Q_DISABLE_COPY(FeatureGeometryCache)
+
+  struct Request
+  {
+    QPointer<QObject> m_context;
+    GeometriesCallback m_callback;
+  };
+
+  struct Edit
+  {
+    EditType m_type = EditType::Added;
+    QPointer<Esri::ArcGISRuntime::Feature> m_feature;
+    qint64 m_featureId = -1;
+    Esri::ArcGISRuntime::Geometry m_geometry;
+  };
+
+  struct Entry
+  {
+    bool m_loaded = false;
+    QUuid m_taskId;
+    QList<Esri::ArcGISRuntime::Geometry> m_geometries;
+    QList<qint64> m_featureIds;
+    QHash<QUuid, Edit> m_pendingEdits;
+    qint64 m_estimatedBytes = 0;
+    QList<Request> m_requests;
+    QList<QMetaObject::Connection> m_connections;
+  };
+
+  void connectFeatureTable(Esri::ArcGISRuntime::FeatureTable* featureTable);
+  void ensureEntry(Esri::ArcGISRuntime::FeatureTable* featureTable);
+  QUuid recordEdit(Esri::ArcGISRuntime::FeatureTable* featureTable, const QUuid& taskId, const Edit& edit);
+  void handleEditCompleted(Esri::ArcGISRuntime::FeatureTable* featureTable, QUuid taskId, bool success);
+  bool applyEdit(Esri::ArcGISRuntime::FeatureTable* featureTable, const Edit& edit);
+  void queryFeatureTable(Esri::ArcGISRuntime::FeatureTable* featureTable);
+  void handleQueryFeaturesCompleted(Esri::ArcGISRuntime::FeatureTable* featureTable,
+                                    QUuid taskId,
+                                    Esri::ArcGISRuntime::FeatureQueryResult* featureQueryResult);
+  bool loadStoredGeometries(Esri::ArcGISRuntime::FeatureTable* featureTable);
+  void completeRequests(Esri::ArcGISRuntime::FeatureTable* featureTable, const QList<Esri::ArcGISRuntime::Geometry>& geometries,
+                        const QList<qint64>& featureIds, bool loaded);
+  void removeEntry(Esri::ArcGISRuntime::FeatureTable* featureTable);
+  qint64 footprint() const;
+  qint64 release();
+
+  QHash<Esri::ArcGISRuntime::FeatureTable*, Entry> m_entries;
+};
+
+} // Dsa
+
+#endif // FEATUREGEOMETRYCACHE_H
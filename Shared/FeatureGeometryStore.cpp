@@ -0,0 +1,374 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "FeatureGeometryStore.h"
+
+// C++ API headers
+#include "FeatureTable.h"
+#include "GeodatabaseFeatureTable.h"
+#include "GeoPackage.h"
+#include "GeoPackageFeatureTable.h"
+#include "Geodatabase.h"
+#include "Point.h"
+#include "ShapefileFeatureTable.h"
+#include "SpatialReference.h"
+
+// Qt headers
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThreadPool>
+
+// STL headers
+#include <algorithm>
+#include <cstring>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+namespace
+{
+// "DSAG", the version of the file layout and a marker of the byte order it was written in
+constexpr quint32 s_magic = 0x44534147;
+constexpr quint32 s_version = 2;
+constexpr quint32 s_byteOrder = 0x01020304;
+
+// the ways in which a geometry record is packed
+enum RecordType : quint32
+{
+  EmptyRecord = 0,
+  PointRecord,
+  PointZRecord,
+  JsonRecord
+};
+
+// the file starts with a header, followed by an index with a fixed size record for each
+// geometry and then the packed geometries. Every field is 4 or 8 bytes wide and aligned,
+// so the header and index can be read in place from a mapping of the file
+struct FileHeader
+{
+  quint32 m_magic = s_magic;
+  quint32 m_version = s_version;
+  quint32 m_byteOrder = s_byteOrder;
+  quint32 m_wkid = 0;
+  quint64 m_count = 0;
+};
+
+struct RecordIndex
+{
+  quint64 m_offset = 0;
+  qint64 m_featureId = -1;
+  quint32 m_size = 0;
+  quint32 m_type = EmptyRecord;
+};
+
+// returns the record of geometry, appended to data, using the packed point layout if the
+// geometry is a point in the spatial reference of the file
+RecordIndex appendRecord(const Geometry& geometry, int wkid, QByteArray& data)
+{
+  RecordIndex record;
+  record.m_offset = static_cast<quint64>(data.size());
+  if (geometry.isEmpty())
+    return record;
+
+  if (geometry.geometryType() == GeometryType::Point && geometry.spatialReference().wkid() == wkid)
+  {
+    const Point point = geometry_cast<Point>(geometry);
+    const double coordinates[3] = {point.x(), point.y(), point.z()};
+    record.m_type = point.hasZ() ? PointZRecord : PointRecord;
+    record.m_size = static_cast<quint32>((point.hasZ() ? 3 : 2) * sizeof(double));
+    data.append(reinterpret_cast<const char*>(coordinates), static_cast<int>(record.m_size));
+    return record;
+  }
+
+  const QByteArray json = geometry.toJson().toUtf8();
+  record.m_type = JsonRecord;
+  record.m_size = static_cast<quint32>(json.size());
+  data.append(json);
+  return record;
+}
+
+// returns the geometry packed in record, whose bytes start at data
+Geometry readRecord(const RecordIndex& record, const uchar* data, const SpatialReference& spatialReference)
+{
+  switch (record.m_type)
+  {
+  case PointRecord:
+  case PointZRecord:
+  {
+    double coordinates[3] = {0.0, 0.0, 0.0};
+    std::memcpy(coordinates, data, std::min<size_t>(record.m_size, sizeof(coordinates)));
+    return record.m_type == PointZRecord ? Point(coordinates[0], coordinates[1], coordinates[2], spatialReference)
+                                         : Point(coordinates[0], coordinates[1], spatialReference);
+  }
+  case JsonRecord:
+    return Geometry::fromJson(QString::fromUtf8(reinterpret_cast<const char*>(data), static_cast<int>(record.m_size)));
+  default:
+    return Geometry();
+  }
+}
+}
+
+/*!
+  \class Dsa::FeatureGeometryStore
+  \inmodule Dsa
+  \inherits QObject
+  \brief A disk store of the geometry of every feature in local feature tables, so that
+  they do not need to be queried again when the app is restarted.
+
+  The geometries of a table are stored in one file, named from the path, size and
+  modification time of its dataset (a mobile geodatabase, GeoPackage or shapefile) and
+  the name of the table. A store is therefore not used once its source dataset changes,
+  and is replaced when the table is next queried.
+
+  Each file has a fixed size index record for each geometry, holding the ID of its
+  feature, and points are packed as their coordinates, so files are read from a memory mapping without parsing. Other
+  geometry is kept as its JSON. Files are written on a background thread.
+
+  \sa FeatureGeometryCache
+ */
+
+/*!
+  \brief Returns the singleton instance of the store.
+ */
+FeatureGeometryStore* FeatureGeometryStore::instance()
+{
+  static FeatureGeometryStore s_instance;
+
+  return &s_instance;
+}
+
+/*!
+  \internal
+ */
+FeatureGeometryStore::FeatureGeometryStore(QObject* parent):
+  QObject(parent),
+  m_storeDirectory(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/feature_geometry"),
+  m_threadPool(new QThreadPool(this))
+{
+  // files are written one at a time so that they do not compete with the app for cores
+  m_threadPool->setMaxThreadCount(1);
+}
+
+/*!
+  \brief Destructor.
+ */
+FeatureGeometryStore::~FeatureGeometryStore()
+{
+  m_threadPool->waitForDone();
+}
+
+/*!
+  \brief Returns the key identifying the current version of the dataset of \a featureTable,
+  or an empty string if the table is not read from a local file.
+ */
+QString FeatureGeometryStore::datasetKey(FeatureTable* featureTable)
+{
+  if (!featureTable)
+    return QString();
+
+  QString datasetPath;
+  if (auto gdbFeatureTable = dynamic_cast<GeodatabaseFeatureTable*>(featureTable))
+    datasetPath = gdbFeatureTable->geodatabase() ? gdbFeatureTable->geodatabase()->path() : QString();
+  else if (auto gpkgFeatureTable = dynamic_cast<GeoPackageFeatureTable*>(featureTable))
+    datasetPath = gpkgFeatureTable->geoPackage() ? gpkgFeatureTable->geoPackage()->path() : QString();
+  else if (auto shpFeatureTable = dynamic_cast<ShapefileFeatureTable*>(featureTable))
+    datasetPath = shpFeatureTable->path();
+
+  const QFileInfo datasetInfo(datasetPath);
+  if (datasetPath.isEmpty() || !datasetInfo.isFile())
+    return QString();
+
+  return QString("%1|%2|%3|%4").arg(datasetInfo.absoluteFilePath(),
+                                    featureTable->tableName(),
+                                    QString::number(datasetInfo.size()),
+                                    QString::number(datasetInfo.lastModified().toMSecsSinceEpoch()));
+}
+
+/*!
+  \brief Reads the stored geometries for \a datasetKey into \a geometries, and the
+  IDs of their features into \a featureIds.
+
+  Returns \c false if there is no complete store for the key, or it is still being written.
+ */
+bool FeatureGeometryStore::load(const QString& datasetKey, QList<Geometry>& geometries, QList<qint64>& featureIds) const
+{
+  const QString path = storePath(datasetKey);
+  if (path.isEmpty() || m_pendingPaths.contains(path))
+    return false;
+
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly))
+    return false;
+
+  const qint64 fileSize = file.size();
+  if (fileSize < static_cast<qint64>(sizeof(FileHeader)))
+    return false;
+
+  const uchar* data = file.map(0, fileSize);
+  if (!data)
+    return false;
+
+  FileHeader header;
+  std::memcpy(&header, data, sizeof(header));
+
+  const quint64 indexEnd = sizeof(FileHeader) + (header.m_count * sizeof(RecordIndex));
+  if (header.m_magic != s_magic || header.m_version != s_version || header.m_byteOrder != s_byteOrder ||
+      header.m_count > static_cast<quint64>(fileSize) || indexEnd > static_cast<quint64>(fileSize))
+  {
+    file.unmap(const_cast<uchar*>(data));
+    return false;
+  }
+
+  const SpatialReference spatialReference = header.m_wkid > 0 ? SpatialReference(static_cast<int>(header.m_wkid))
+                                                              : SpatialReference();
+  const uchar* records = data + indexEnd;
+  const quint64 recordsSize = static_cast<quint64>(fileSize) - indexEnd;
+
+  QList<Geometry> stored;
+  QList<qint64> storedIds;
+  stored.reserve(static_cast<int>(header.m_count));
+  storedIds.reserve(static_cast<int>(header.m_count));
+  for (quint64 i = 0; i < header.m_count; ++i)
+  {
+    RecordIndex record;
+    std::memcpy(&record, data + sizeof(FileHeader) + (i * sizeof(RecordIndex)), sizeof(record));
+    if (record.m_offset + record.m_size > recordsSize)
+    {
+      file.unmap(const_cast<uchar*>(data));
+      return false;
+    }
+
+    stored.append(readRecord(record, records + record.m_offset, spatialReference));
+    storedIds.append(record.m_featureId);
+  }
+
+  file.unmap(const_cast<uchar*>(data));
+  geometries.swap(stored);
+  featureIds.swap(storedIds);
+  return true;
+}
+
+/*!
+  \brief Writes \a geometries, and the IDs of their features in \a featureIds, as the
+  store for \a datasetKey on a background thread, replacing any previous store.
+
+  An ID of \c -1 is stored for any geometry without an entry in \a featureIds.
+ */
+void FeatureGeometryStore::store(const QString& datasetKey, const QList<Geometry>& geometries, const QList<qint64>& featureIds)
+{
+  const QString path = storePath(datasetKey);
+  if (path.isEmpty() || m_pendingPaths.contains(path))
+    return;
+
+  m_pendingPaths.insert(path);
+
+  const QString storeDirectory = m_storeDirectory;
+  m_threadPool->start([this, geometries, featureIds, path, storeDirectory]()
+  {
+    // points in the spatial reference of the first geometry are packed
+    FileHeader header;
+    header.m_count = static_cast<quint64>(geometries.size());
+    for (const Geometry& geometry : geometries)
+    {
+      if (!geometry.isEmpty())
+      {
+        header.m_wkid = static_cast<quint32>(std::max(0, geometry.spatialReference().wkid()));
+        break;
+      }
+    }
+
+    QByteArray index;
+    QByteArray records;
+    index.reserve(static_cast<int>(geometries.size() * sizeof(RecordIndex)));
+    for (int i = 0; i < geometries.size(); ++i)
+    {
+      RecordIndex record = appendRecord(geometries.at(i), static_cast<int>(header.m_wkid), records);
+      record.m_featureId = featureIds.value(i, -1);
+      index.append(reinterpret_cast<const char*>(&record), sizeof(record));
+    }
+
+    if (QDir().mkpath(storeDirectory))
+    {
+      QSaveFile file(path);
+      if (file.open(QIODevice::WriteOnly))
+      {
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(index);
+        file.write(records);
+        file.commit();
+      }
+    }
+
+    QMetaObject::invokeMethod(this, [this, path]()
+    {
+      m_pendingPaths.remove(path);
+    }, Qt::QueuedConnection);
+  });
+}
+
+/*!
+  \brief Removes the store for \a datasetKey, for example when its table has been edited.
+ */
+void FeatureGeometryStore::remove(const QString& datasetKey)
+{
+  const QString path = storePath(datasetKey);
+  if (!path.isEmpty())
+    QFile::remove(path);
+}
+
+/*!
+  \brief Returns the directory where the geometries are stored.
+
+  By default, this is the \c feature_geometry folder in the app's cache location.
+ */
+QString FeatureGeometryStore::storeDirectory() const
+{
+  return m_storeDirectory;
+}
+
+/*!
+  \brief Sets the directory where the geometries are stored to \a storeDirectory.
+ */
+void FeatureGeometryStore::setStoreDirectory(const QString& storeDirectory)
+{
+  m_storeDirectory = storeDirectory;
+}
+
+/*!
+  \internal
+
+  Returns the file the geometries for \a datasetKey are stored in, or an empty string
+  if the key is empty.
+ */
+QString FeatureGeometryStore::storePath(const QString& datasetKey) const
+{
+  if (datasetKey.isEmpty())
+    return QString();
+
+  const QByteArray hash = QCryptographicHash::hash(datasetKey.toUtf8(), QCryptographicHash::Sha1).toHex();
+  return QString("%1/%2.geom").arg(m_storeDirectory, QString::fromLatin1(hash));
+}
+
+} // Dsa
@@ -0,0 +1,70 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef FEATUREGEOMETRYSTORE_H
+#define FEATUREGEOMETRYSTORE_H
+
+// C++ API headers
+#include "Geometry.h"
+
+// Qt headers
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QString>
+
+class QThreadPool;
+
+namespace Esri {
+namespace ArcGISRuntime {
+class FeatureTable;
+}
+}
+
+namespace Dsa {
+
+class FeatureGeometryStore : public QObject
+{
+  Q_OBJECT
+
+public:
+  static FeatureGeometryStore* instance();
+
+  ~FeatureGeometryStore();
+
+  static QString datasetKey(Esri::ArcGISRuntime::FeatureTable* featureTable);
+
+  bool load(const QString& datasetKey, QList<Esri::ArcGISRuntime::Geometry>& geometries, QList<qint64>& featureIds) const;
+  void store(const QString& datasetKey, const QList<Esri::ArcGISRuntime::Geometry>& geometries, const QList<qint64>& featureIds);
+  void remove(const QString& datasetKey);
+
+  QString storeDirectory() const;
+  void setStoreDirectory(const QString& storeDirectory);
+
+private:
+  explicit FeatureGeometryStore(QObject* parent = nullptr);
+  Q_DISABLE_COPY(FeatureGeometryStore)
+
+  QString storePath(const QString& datasetKey) const;
+
+  QString m_storeDirectory;
+  QThreadPool* m_threadPool = nullptr;
+  QSet<QString> m_pendingPaths;
+};
+
+} // Dsa
+
+#endif // FEATUREGEOMETRYSTORE_H
@@ -20,25 +20,51 @@
 
 #include "FollowPositionController.h"
 
+// dsa app headers
+#include "FrameAnimationDriver.h"
+#include "LocationController.h"
+#include "LocationSampler.h"
+
 // toolkit headers
 #include "ToolManager.h"
 #include "ToolResourceProvider.h"
 
 // C++ API headers
+#include "AttributeListModel.h"
 #include "GlobeCameraController.h"
+#include "Graphic.h"
+#include "GraphicListModel.h"
+#include "GraphicsOverlay.h"
 #include "MapView.h"
 #include "OrbitGeoElementCameraController.h"
+#include "Point.h"
 #include "SceneView.h"
+#include "SimpleMarkerSceneSymbol.h"
+#include "SimpleRenderer.h"
 
 using namespace Esri::ArcGISRuntime;
 
 namespace Dsa {
 
+static const QString s_locationOverlayId{"SCENEVIEWLOCATIONOVERLAY"};
+static const QString s_headingAttribute{"heading"};
+
+// positions are not extrapolated further than this past the last fix, in ms,
+// so that the camera stops if the fixes stop
+static const qint64 s_maxPredictionInterval = 2000;
+
 /*!
   \class Dsa::FollowPositionController
   \inmodule Dsa
   \inherits AbstractTool
   \brief Tool controller for managing the follow navigation modes.
+
+  In a scene, the camera follows the location graphic, so it moves once per
+  position fix. In predictive mode the camera instead follows an invisible
+  graphic whose position is extrapolated from the last two fixes on every
+  frame, giving smooth movement without updating the location graphic at the
+  frame rate. When a new fix arrives, the difference from the prediction is
+  blended out over the following interval rather than jumped.
  */
 
 /*!
@@ -68,6 +94,25 @@ FollowPositionController::~FollowPositionController()
  */
 void FollowPositionController::init(GeoView* geoView)
 {
+  if (m_geoView != geoView)
+  {
+    // the cached graphics belong to the previous view
+    stopPrediction();
+
+    if (m_geoView && m_predictionOverlay)
+    {
+      GraphicsOverlayListModel* graphicsOverlays = m_geoView->graphicsOverlays();
+      const int index = graphicsOverlays->indexOf(m_predictionOverlay);
+      if (index != -1)
+        graphicsOverlays->removeAt(index);
+    }
+
+    delete m_predictionOverlay;
+    delete m_predictedGraphic;
+    m_locationOverlay.clear();
+    m_locationGraphic.clear();
+  }
+
   m_geoView = geoView;
 
   handleNewMode();
@@ -83,6 +128,11 @@ void FollowPositionController::setFollowMode(FollowPositionController::FollowMod
 
   m_mode = followMode;
   handleNewMode();
+
+  // the camera moves with every position update while following
+  LocationController* locationController = ToolManager::instance().tool<LocationController>();
+  if (locationController)
+    locationController->locationSampler()->setConsumerActive(this, m_mode != FollowMode::Disabled);
 }
 
 /*!
@@ -94,6 +144,31 @@ FollowPositionController::FollowMode FollowPositionController::followMode() cons
   return m_mode;
 }
 
+/*!
+  \property FollowPositionController::predictive
+  \brief Returns whether the camera follows a position predicted at the frame
+  rate rather than each position fix.
+ */
+bool FollowPositionController::isPredictive() const
+{
+  return m_predictive;
+}
+
+/*!
+  \brief Sets whether the camera follows a predicted position to \a predictive.
+ */
+void FollowPositionController::setPredictive(bool predictive)
+{
+  if (m_predictive == predictive)
+    return;
+
+  m_predictive = predictive;
+  emit predictiveChanged();
+
+  if (m_mode != FollowMode::Disabled)
+    handleNewMode();
+}
+
 /*!
   \brief Returns the name of the tool - c "follow position".
  */
@@ -170,19 +245,26 @@ bool FollowPositionController::handleFollowInScene()
 
   if (m_mode == FollowMode::Disabled)
   {
+    stopPrediction();
     sceneView->setCameraController(new GlobeCameraController(this));
   }
   else
   {
-    GraphicListModel* graphics = locationGraphicsModel();
-    if (!graphics || graphics->rowCount() != 1)
+    Graphic* targetGraphic = locationGraphic();
+    if (!targetGraphic)
       return true;
 
-    Graphic* locationGraphic = graphics->at(0);
-    if (!locationGraphic)
-      return true;
+    if (m_predictive && predictedGraphic())
+    {
+      startPrediction();
+      targetGraphic = m_predictedGraphic;
+    }
+    else
+    {
+      stopPrediction();
+    }
 
-    OrbitGeoElementCameraController* followController = new OrbitGeoElementCameraController(locationGraphic, 2000., this);
+    OrbitGeoElementCameraController* followController = new OrbitGeoElementCameraController(targetGraphic, 2000., this);
 
     if (m_mode == FollowMode::NorthUp)
     {
@@ -198,32 +280,202 @@ bool FollowPositionController::handleFollowInScene()
 
 /*!
   \internal
+
+  Returns the location graphic, searching the overlays of the view only if it
+  has not already been found.
  */
-GraphicListModel* FollowPositionController::locationGraphicsModel() const
+Graphic* FollowPositionController::locationGraphic()
 {
+  if (m_locationGraphic && m_locationOverlay)
+    return m_locationGraphic;
+
   if (!m_geoView)
     return nullptr;
 
+  m_locationOverlay.clear();
+  m_locationGraphic.clear();
+
   GraphicsOverlayListModel* overlays = m_geoView->graphicsOverlays();
   if (overlays->isEmpty())
     return nullptr;
 
-  QString locationOverlayId("SCENEVIEWLOCATIONOVERLAY");
   for (int i = 0; i < overlays->rowCount(); ++i)
   {
     GraphicsOverlay* candidateOverlay = overlays->at(i);
     if (!candidateOverlay)
       continue;
 
-    if (candidateOverlay->overlayId() != locationOverlayId)
+    if (candidateOverlay->overlayId() != s_locationOverlayId)
       continue;
 
-    return candidateOverlay->graphics();
+    GraphicListModel* graphics = candidateOverlay->graphics();
+    if (!graphics || graphics->rowCount() != 1)
+      return nullptr;
+
+    m_locationOverlay = candidateOverlay;
+    m_locationGraphic = graphics->at(0);
+    return m_locationGraphic;
   }
 
   return nullptr;
 }
 
+/*!
+  \internal
+
+  Returns the invisible graphic which is moved to the predicted position,
+  creating it if needed.
+ */
+Graphic* FollowPositionController::predictedGraphic()
+{
+  if (m_predictedGraphic)
+    return m_predictedGraphic;
+
+  if (!m_geoView || !m_locationOverlay)
+    return nullptr;
+
+  // a transparent symbol with the same heading expression as the location display,
+  // so that the camera can follow the heading in track up mode
+  auto symbol = new SimpleMarkerSceneSymbol(SimpleMarkerSceneSymbolStyle::Sphere, Qt::transparent,
+                                            1.0, 1.0, 1.0, SceneSymbolAnchorPosition::Center, this);
+  auto renderer = new SimpleRenderer(symbol, this);
+  RendererSceneProperties renderProperties = renderer->sceneProperties();
+  renderProperties.setHeadingExpression(QString("[%1]").arg(s_headingAttribute));
+  renderer->setSceneProperties(renderProperties);
+
+  m_predictionOverlay = new GraphicsOverlay(this);
+  m_predictionOverlay->setSceneProperties(m_locationOverlay->sceneProperties());
+  m_predictionOverlay->setRenderer(renderer);
+
+  m_predictedGraphic = new Graphic(m_locationGraphic->geometry(), this);
+  m_predictedGraphic->attributes()->insertAttribute(s_headingAttribute,
+                                                   m_locationGraphic->attributes()->attributeValue(s_headingAttribute));
+  m_predictionOverlay->graphics()->append(m_predictedGraphic);
+  m_geoView->graphicsOverlays()->append(m_predictionOverlay);
+
+  return m_predictedGraphic;
+}
+
+/*!
+  \internal
+ */
+void FollowPositionController::startPrediction()
+{
+  if (FrameAnimationDriver::instance()->hasAnimation(this) || !m_locationGraphic)
+    return;
+
+  m_fixConnection = connect(m_locationGraphic, &Graphic::geometryChanged, this, &FollowPositionController::handleLocationFix);
+
+  m_clock.start();
+  m_lastFixTime = -1;
+  handleLocationFix();
+
+  // the camera follows the predicted position, so it is moved smoothly at the full frame rate
+  FrameAnimationDriver::instance()->addAnimation(this, [this](qint64)
+  {
+    return updatePrediction();
+  }, FrameAnimationDriver::FrameRate::Full);
+}
+
+/*!
+  \internal
+ */
+void FollowPositionController::stopPrediction()
+{
+  FrameAnimationDriver::instance()->removeAnimation(this);
+
+  if (m_fixConnection)
+    disconnect(m_fixConnection);
+}
+
+/*!
+  \internal
+
+  Records a new position fix of the location graphic and the velocity since the previous one.
+ */
+void FollowPositionController::handleLocationFix()
+{
+  if (!m_locationGraphic)
+    return;
+
+  const Point fix(m_locationGraphic->geometry());
+  if (fix.isEmpty())
+    return;
+
+  const qint64 now = m_clock.elapsed();
+  const qint64 interval = now - m_lastFixTime;
+
+  if (m_lastFixTime < 0 || interval <= 0 || interval > s_maxPredictionInterval)
+  {
+    // without a recent fix there is no velocity to extrapolate
+    m_velocityX = m_velocityY = m_velocityZ = 0.0;
+    m_correctionX = m_correctionY = m_correctionZ = 0.0;
+    m_fixInterval = 0;
+    m_lastPredictedX = fix.x();
+    m_lastPredictedY = fix.y();
+    m_lastPredictedZ = fix.z();
+  }
+  else
+  {
+    m_velocityX = (fix.x() - m_fixX) / interval;
+    m_velocityY = (fix.y() - m_fixY) / interval;
+    m_velocityZ = (fix.z() - m_fixZ) / interval;
+    m_correctionX = m_lastPredictedX - fix.x();
+    m_correctionY = m_lastPredictedY - fix.y();
+    m_correctionZ = m_lastPredictedZ - fix.z();
+    m_fixInterval = interval;
+  }
+
+  m_fixX = fix.x();
+  m_fixY = fix.y();
+  m_fixZ = fix.z();
+  m_lastFixTime = now;
+
+  // the next frame starts from the last predicted position, which may differ from the fix
+  m_predictionChanged = true;
+
+  if (m_predictedGraphic)
+  {
+    const QVariant heading = m_locationGraphic->attributes()->attributeValue(s_headingAttribute);
+    if (m_predictedGraphic->attributes()->attributeValue(s_headingAttribute) != heading)
+      m_predictedGraphic->attributes()->replaceAttribute(s_headingAttribute, heading);
+  }
+}
+
+/*!
+  \internal
+
+  Moves the predicted graphic for the current frame. Returns \c false once
+  prediction is no longer possible, which ends the animation.
+ */
+bool FollowPositionController::updatePrediction()
+{
+  if (!m_predictedGraphic || !m_locationGraphic || m_lastFixTime < 0)
+    return false;
+
+  // extrapolate for at most one fix interval, so that the camera settles if the device stops
+  const qint64 sinceFix = qMin(m_clock.elapsed() - m_lastFixTime, qMin(m_fixInterval, s_maxPredictionInterval));
+  const double blend = m_fixInterval > 0 ? 1.0 - (static_cast<double>(sinceFix) / m_fixInterval) : 0.0;
+
+  const double x = m_fixX + (m_velocityX * sinceFix) + (m_correctionX * blend);
+  const double y = m_fixY + (m_velocityY * sinceFix) + (m_correctionY * blend);
+  const double z = m_fixZ + (m_velocityZ * sinceFix) + (m_correctionZ * blend);
+
+  // once the prediction has settled there is nothing to move until the next fix
+  if (!m_predictionChanged && x == m_lastPredictedX && y == m_lastPredictedY && z == m_lastPredictedZ)
+    return true;
+
+  m_lastPredictedX = x;
+  m_lastPredictedY = y;
+  m_lastPredictedZ = z;
+  m_predictionChanged = false;
+
+  const SpatialReference spatialReference = m_locationGraphic->geometry().spatialReference();
+  m_predictedGraphic->setGeometry(Point(m_lastPredictedX, m_lastPredictedY, m_lastPredictedZ, spatialReference));
+
+  return true;
+}
+
 } // Dsa
 
 // Signal Documentation
@@ -233,3 +485,9 @@ GraphicListModel* FollowPositionController::locationGraphicsModel() const
 
   \brief Signal emitted when the follow mode changes.
  */
+
+/*!
+  \fn void FollowPositionController::predictiveChanged();
+
+  \brief Signal emitted when the predictive mode changes.
+ */
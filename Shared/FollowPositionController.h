@@ -20,12 +20,18 @@
 // toolkit headers
 #include "AbstractTool.h"
 
+// Qt headers
+#include <QElapsedTimer>
+#include <QMetaObject>
+#include <QPointer>
+
 namespace Esri {
 namespace ArcGISRuntime {
   class CameraController;
   class GeoElement;
   class GeoView;
-  class GraphicListModel;
+  class Graphic;
+  class GraphicsOverlay;
 }}
 
 namespace Dsa {
@@ -35,6 +41,7 @@ class FollowPositionController : public AbstractTool
   Q_OBJECT
 
   Q_PROPERTY(FollowMode followMode READ followMode WRITE setFollowMode NOTIFY followModeChanged)
+  Q_PROPERTY(bool predictive READ isPredictive WRITE setPredictive NOTIFY predictiveChanged)
 
 public:
 
@@ -55,6 +62,9 @@ public:
   FollowMode followMode() const;
   void setFollowMode(FollowMode followMode);
 
+  bool isPredictive() const;
+  void setPredictive(bool predictive);
+
   // AbstractTool interface
   QString toolName() const override;
 
@@ -62,6 +72,7 @@ public:
 
 signals:
   void followModeChanged();
+  void predictiveChanged();
 
 private slots:
   void updateGeoView();
@@ -71,10 +82,43 @@ private:
   void handleNewMode();
   bool handleFollowInMap();
   bool handleFollowInScene();
-  Esri::ArcGISRuntime::GraphicListModel* locationGraphicsModel() const;
+  Esri::ArcGISRuntime::Graphic* locationGraphic();
+  Esri::ArcGISRuntime::Graphic* predictedGraphic();
+  void startPrediction();
+  void stopPrediction();
+  void handleLocationFix();
+  bool updatePrediction();
 
   FollowMode m_mode = FollowMode::Disabled;
   Esri::ArcGISRuntime::GeoView* m_geoView = nullptr;
+
+  // the location overlay and graphic, resolved once per geo view
+  QPointer<Esri::ArcGISRuntime::GraphicsOverlay> m_locationOverlay;
+  QPointer<Esri::ArcGISRuntime::Graphic> m_locationGraphic;
+
+  // an invisible graphic followed by the camera in predictive mode
+  bool m_predictive = false;
+  QPointer<Esri::ArcGISRuntime::GraphicsOverlay> m_predictionOverlay;
+  QPointer<Esri::ArcGISRuntime::Graphic> m_predictedGraphic;
+  QMetaObject::Connection m_fixConnection;
+  QElapsedTimer m_clock;
+  qint64 m_lastFixTime = -1;
+  qint64 m_fixInterval = 0;
+  double m_fixX = 0.0;
+  double m_fixY = 0.0;
+  double m_fixZ = 0.0;
+  double m_velocityX = 0.0;
+  double m_velocityY = 0.0;
+  double m_velocityZ = 0.0;
+
+  // the difference between the prediction and the fix when it arrived, blended out over the next interval
+  double m_correctionX = 0.0;
+  double m_correctionY = 0.0;
+  double m_correctionZ = 0.0;
+  double m_lastPredictedX = 0.0;
+  double m_lastPredictedY = 0.0;
+  double m_lastPredictedZ = 0.0;
+  bool m_predictionChanged = false;
 };
 
 } // Dsa
@@ -0,0 +1,399 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "FrameAnimationDriver.h"
+
+// toolkit headers
+#include "ToolResourceProvider.h"
+
+// C++ API headers
+#include "GeoView.h"
+
+// Qt headers
+#include <QQuickItem>
+#include <QQuickWindow>
+#include <QTimer>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+/*!
+  \class Dsa::FrameAnimationDriver
+  \inmodule Dsa
+  \inherits QObject
+  \brief Drives animations of graphics in the geo view, such as highlights and
+  flashing alerts, in step with the frames drawn by the view.
+
+  Each animation is a callback which is called once per frame. All of the
+  callbacks are called together, just before the window draws the frame, so
+  that their updates to the scene are drawn in a single frame instead of
+  triggering one redraw each.
+
+  Frames are only requested while there are animations. While the window
+  showing the geo view is hidden or minimized, the animations are paused.
+
+  If the geo view is not shown in a Qt Quick window, a timer with an interval of
+  \c s_fallbackFrameInterval milliseconds is used instead.
+
+  While the user is not interacting with the view, the animations are
+  throttled to \l idleFrameRate frames per second, so that a pulsing highlight
+  or flashing alerts do not keep the view redrawing at the full display rate.
+  The view still draws other changes, such as updated graphics, as they happen,
+  and the animations are stepped on those frames too. Interacting with the
+  view, by moving the mouse or touching it or by the viewpoint changing, lifts
+  the cap for \c s_interactionTimeout milliseconds. Animations added with
+  \c FrameRate::Full, such as following the current position, are never
+  throttled.
+ */
+
+/*!
+  \brief Returns the singleton instance of the driver.
+ */
+FrameAnimationDriver* FrameAnimationDriver::instance()
+{
+  static FrameAnimationDriver s_instance;
+
+  return &s_instance;
+}
+
+/*!
+  \internal
+ */
+FrameAnimationDriver::FrameAnimationDriver(QObject* parent):
+  QObject(parent),
+  m_fallbackTimer(new QTimer(this)),
+  m_throttleTimer(new QTimer(this))
+{
+  m_clock.start();
+
+  m_fallbackTimer->setInterval(s_fallbackFrameInterval);
+  connect(m_fallbackTimer, &QTimer::timeout, this, &FrameAnimationDriver::onFrame);
+
+  m_throttleTimer->setSingleShot(true);
+  connect(m_throttleTimer, &QTimer::timeout, this, &FrameAnimationDriver::onThrottleTimeout);
+
+  // any use of the mouse or touch in the view counts as interaction
+  auto* provider = ToolResourceProvider::instance();
+  connect(provider, &ToolResourceProvider::mousePressed, this, [this](QMouseEvent&) { onInteraction(); });
+  connect(provider, &ToolResourceProvider::mouseMoved, this, [this](QMouseEvent&) { onInteraction(); });
+  connect(provider, &ToolResourceProvider::mouseReleased, this, [this](QMouseEvent&) { onInteraction(); });
+
+  connect(ToolResourceProvider::instance(), &ToolResourceProvider::geoViewChanged,
+          this, &FrameAnimationDriver::onGeoViewChanged);
+
+  onGeoViewChanged();
+}
+
+/*!
+  \brief Destructor.
+ */
+FrameAnimationDriver::~FrameAnimationDriver()
+{
+}
+
+/*!
+  \brief Adds an animation for \a owner, calling \a callback once per frame
+  until it returns \c false, \l removeAnimation is called or \a owner is destroyed.
+
+  With \a frameRate \c FrameRate::Capped, the animation is slowed to the
+  \l idleFrameRate while the view is idle. \c FrameRate::Full keeps every
+  frame at the full rate while the animation runs.
+
+  Any existing animation for \a owner is replaced.
+ */
+void FrameAnimationDriver::addAnimation(QObject* owner, FrameCallback callback, FrameRate frameRate)
+{
+  if (!owner || !callback)
+    return;
+
+  removeAnimation(owner);
+
+  Animation animation;
+  animation.m_callback = std::move(callback);
+  animation.m_startTime = m_clock.elapsed();
+  animation.m_frameRate = frameRate;
+  animation.m_destroyedConnection = connect(owner, &QObject::destroyed, this, [this, owner]()
+  {
+    removeAnimation(owner);
+  });
+
+  m_animations.insert(owner, animation);
+  if (frameRate == FrameRate::Full)
+    ++m_fullRateAnimations;
+
+  requestFrame();
+}
+
+/*!
+  \brief Removes the animation for \a owner, if there is one.
+ */
+void FrameAnimationDriver::removeAnimation(QObject* owner)
+{
+  auto findIt = m_animations.find(owner);
+  if (findIt == m_animations.end())
+    return;
+
+  disconnect(findIt.value().m_destroyedConnection);
+  if (findIt.value().m_frameRate == FrameRate::Full)
+    --m_fullRateAnimations;
+
+  m_animations.erase(findIt);
+
+  if (m_animations.isEmpty())
+  {
+    m_fallbackTimer->stop();
+    m_throttleTimer->stop();
+  }
+}
+
+/*!
+  \brief Returns whether there is an animation for \a owner.
+ */
+bool FrameAnimationDriver::hasAnimation(QObject* owner) const
+{
+  return m_animations.contains(owner);
+}
+
+/*!
+  \brief Returns whether the animations are paused because the geo view is not visible.
+ */
+bool FrameAnimationDriver::isPaused() const
+{
+  return m_paused;
+}
+
+/*!
+  \brief Returns the frame rate the capped animations are slowed to while the view is idle.
+
+  \c 0 means that the animations are never throttled. The default is
+  \c s_defaultIdleFrameRate.
+ */
+int FrameAnimationDriver::idleFrameRate() const
+{
+  return m_idleFrameRate;
+}
+
+/*!
+  \brief Sets the frame rate the capped animations are slowed to while the view
+  is idle to \a idleFrameRate frames per second.
+
+  Pass \c 0 to never throttle the animations.
+ */
+void FrameAnimationDriver::setIdleFrameRate(int idleFrameRate)
+{
+  idleFrameRate = qMax(0, idleFrameRate);
+  if (idleFrameRate == m_idleFrameRate)
+    return;
+
+  m_idleFrameRate = idleFrameRate;
+
+  // a frame which is waiting for the old cap is requested again with the new one
+  if (m_throttleTimer->isActive())
+  {
+    m_throttleTimer->stop();
+    requestFrame();
+  }
+}
+
+/*!
+  \brief Returns whether the animations are currently slowed to the \l idleFrameRate.
+
+  This is the case when there is a cap, no full rate animation is running and
+  there has been no interaction with the view for \c s_interactionTimeout milliseconds.
+ */
+bool FrameAnimationDriver::isThrottled() const
+{
+  if (m_idleFrameRate <= 0 || m_fullRateAnimations > 0)
+    return false;
+
+  return m_lastInteractionTime < 0 || m_clock.elapsed() - m_lastInteractionTime > s_interactionTimeout;
+}
+
+/*!
+  \internal
+  Follows the window showing the current geo view.
+ */
+void FrameAnimationDriver::onGeoViewChanged()
+{
+  for (const auto& connection : m_windowConnections)
+    disconnect(connection);
+
+  m_windowConnections.clear();
+  m_window.clear();
+
+  auto* geoViewItem = dynamic_cast<QQuickItem*>(ToolResourceProvider::instance()->geoView());
+  if (geoViewItem)
+  {
+    // the item is only given a window once it is added to the scene
+    m_windowConnections.append(connect(geoViewItem, &QQuickItem::windowChanged, this, &FrameAnimationDriver::onGeoViewChanged));
+    m_window = geoViewItem->window();
+
+    // navigating the view, whether by touch, keys or a controller, counts as interaction
+    m_windowConnections.append(connect(geoViewItem, SIGNAL(viewpointChanged()), this, SLOT(onInteraction())));
+  }
+
+  if (m_window)
+  {
+    m_fallbackTimer->stop();
+
+    // afterAnimating is emitted on the GUI thread before each frame is synchronized with the scene graph
+    m_windowConnections.append(connect(m_window.data(), &QQuickWindow::afterAnimating, this, &FrameAnimationDriver::onFrame));
+    m_windowConnections.append(connect(m_window.data(), &QWindow::visibilityChanged, this, &FrameAnimationDriver::updatePaused));
+  }
+
+  m_frameRequested = false;
+  updatePaused();
+}
+
+/*!
+  \internal
+  Calls each animation for the frame which is about to be drawn.
+ */
+void FrameAnimationDriver::onFrame()
+{
+  m_frameRequested = false;
+
+  if (m_paused || m_animations.isEmpty())
+    return;
+
+  const qint64 now = m_clock.elapsed();
+  m_lastFrameTime = now;
+
+  // the callbacks may add or remove animations, so iterate over a copy
+  const auto animations = m_animations;
+  for (auto it = animations.cbegin(); it != animations.cend(); ++it)
+  {
+    if (!m_animations.contains(it.key()))
+      continue;
+
+    if (!it.value().m_callback(now - it.value().m_startTime))
+      removeAnimation(it.key());
+  }
+
+  requestFrame();
+}
+
+/*!
+  \internal
+  Asks for another frame to be drawn if there are animations and the view is visible.
+ */
+void FrameAnimationDriver::requestFrame()
+{
+  if (m_paused || m_animations.isEmpty())
+    return;
+
+  // while idle, the next frame waits until the capped interval has passed since the last one
+  if (isThrottled())
+  {
+    if (m_throttleTimer->isActive())
+      return;
+
+    const qint64 wait = 1000 / m_idleFrameRate - (m_clock.elapsed() - m_lastFrameTime);
+    if (m_lastFrameTime >= 0 && wait > 0)
+    {
+      m_fallbackTimer->stop();
+      m_throttleTimer->start(static_cast<int>(wait));
+      return;
+    }
+  }
+  else
+  {
+    m_throttleTimer->stop();
+  }
+
+  if (!m_window)
+  {
+    if (!m_fallbackTimer->isActive())
+      m_fallbackTimer->start();
+
+    return;
+  }
+
+  if (m_frameRequested)
+    return;
+
+  m_frameRequested = true;
+  m_window->update();
+}
+
+/*!
+  \internal
+  Lifts the frame rate cap for a while, since the user is interacting with the view.
+ */
+void FrameAnimationDriver::onInteraction()
+{
+  const bool wasThrottled = isThrottled();
+  m_lastInteractionTime = m_clock.elapsed();
+
+  // a frame which is waiting for the cap is drawn straight away
+  if (wasThrottled && m_throttleTimer->isActive())
+  {
+    m_throttleTimer->stop();
+    requestFrame();
+  }
+}
+
+/*!
+  \internal
+  Requests the frame which was delayed by the frame rate cap.
+ */
+void FrameAnimationDriver::onThrottleTimeout()
+{
+  if (m_paused || m_animations.isEmpty())
+    return;
+
+  if (!m_window)
+  {
+    onFrame();
+    return;
+  }
+
+  if (m_frameRequested)
+    return;
+
+  m_frameRequested = true;
+  m_window->update();
+}
+
+/*!
+  \internal
+  Pauses the animations while the window is hidden or minimized and resumes them
+  when it is shown again.
+ */
+void FrameAnimationDriver::updatePaused()
+{
+  const bool paused = m_window && (!m_window->isVisible() || m_window->visibility() == QWindow::Minimized);
+  if (paused == m_paused)
+    return;
+
+  m_paused = paused;
+  if (m_paused)
+  {
+    m_fallbackTimer->stop();
+    m_throttleTimer->stop();
+    m_frameRequested = false;
+  }
+  else
+  {
+    requestFrame();
+  }
+}
+
+} // Dsa
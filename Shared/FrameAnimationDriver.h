@@ -0,0 +1,105 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef FRAMEANIMATIONDRIVER_H
+#define FRAMEANIMATIONDRIVER_H
+
+// Qt headers
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+
+// STL headers
+#include <functional>
+
+class QQuickWindow;
+class QTimer;
+
+namespace Dsa {
+
+class FrameAnimationDriver : public QObject
+{
+  Q_OBJECT
+
+public:
+  // called once per frame with the time since the animation was added. Returning false ends the animation
+  using FrameCallback = std::function<bool(qint64 elapsedMs)>;
+
+  // whether an animation may be slowed to the idle frame rate
+  enum class FrameRate
+  {
+    Capped,
+    Full
+  };
+
+  static FrameAnimationDriver* instance();
+
+  ~FrameAnimationDriver();
+
+  void addAnimation(QObject* owner, FrameCallback callback, FrameRate frameRate = FrameRate::Capped);
+  void removeAnimation(QObject* owner);
+  bool hasAnimation(QObject* owner) const;
+
+  bool isPaused() const;
+
+  int idleFrameRate() const;
+  void setIdleFrameRate(int idleFrameRate);
+
+  bool isThrottled() const;
+
+  static constexpr int s_fallbackFrameInterval = 16;
+  static constexpr int s_defaultIdleFrameRate = 10;
+  static constexpr qint64 s_interactionTimeout = 2000;
+
+private slots:
+  void onGeoViewChanged();
+  void onFrame();
+  void onInteraction();
+  void onThrottleTimeout();
+
+private:
+  explicit FrameAnimationDriver(QObject* parent = nullptr);
+  Q_DISABLE_COPY(FrameAnimationDriver)
+
+  struct Animation
+  {
+    FrameCallback m_callback;
+    qint64 m_startTime = 0;
+    FrameRate m_frameRate = FrameRate::Capped;
+    QMetaObject::Connection m_destroyedConnection;
+  };
+
+  void requestFrame();
+  void updatePaused();
+
+  QHash<QObject*, Animation> m_animations;
+  QElapsedTimer m_clock;
+  QPointer<QQuickWindow> m_window;
+  QList<QMetaObject::Connection> m_windowConnections;
+  QTimer* m_fallbackTimer = nullptr;
+  QTimer* m_throttleTimer = nullptr;
+  int m_idleFrameRate = s_defaultIdleFrameRate;
+  int m_fullRateAnimations = 0;
+  qint64 m_lastFrameTime = -1;
+  qint64 m_lastInteractionTime = -1;
+  bool m_paused = false;
+  bool m_frameRequested = false;
+};
+
+} // Dsa
+
+#endif // FRAMEANIMATIONDRIVER_H
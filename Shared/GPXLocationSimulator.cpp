@@ -20,21 +20,27 @@
 #include "GPXLocationSimulator.h"
 
 // Qt headers
+#include <QDateTime>
 #include <QTimer>
-#include <QXmlStreamReader>
-
-// STL headers
-#include <cmath>
-
-using namespace Esri::ArcGISRuntime;
 
 namespace Dsa {
 
+namespace
+{
+constexpr qint64 s_msecsPerDay = 24 * 60 * 60 * 1000;
+}
+
 /*!
   \class Dsa::GPXLocationSimulator
   \inmodule Dsa
   \inherits QGeoPositionInfoSource
   \brief Position source simulator that reads from a GPX file.
+
+  The track points of the GPX file are parsed once, when the file is set, into a
+  \l GPXTrack holding a packed array of timestamps, coordinates, segment headings
+  and great-circle parameters. Playback walks
+  through the array, so its cost does not depend on the length of the track or
+  the \l playbackMultiplier.
  */
 
 /*!
@@ -44,9 +50,7 @@ namespace Dsa {
  */
 GPXLocationSimulator::GPXLocationSimulator(QObject* parent) :
   QGeoPositionInfoSource(parent),
-  m_gpxReader(new QXmlStreamReader()),
-  m_timer(new QTimer(this)),
-  m_angleOffset(0.0, -90.0, 0.0, 90.0)
+  m_timer(new QTimer(this))
 {
   connectSignals();
   setUpdateInterval(500);
@@ -63,7 +67,6 @@ GPXLocationSimulator::GPXLocationSimulator(QObject* parent) :
  */
 GPXLocationSimulator::GPXLocationSimulator(const QString& gpxFileName, int updateInterval, QObject* parent) :
   QGeoPositionInfoSource(parent),
-  m_gpxReader(new QXmlStreamReader()),
   m_timer(new QTimer(this))
 {
   connectSignals();
@@ -94,81 +97,6 @@ void GPXLocationSimulator::connectSignals()
           this, static_cast<void (QGeoPositionInfoSource::*)(QGeoPositionInfoSource::Error)>(&QGeoPositionInfoSource::error));
 }
 
-/*!
-  \internal
- */
-bool GPXLocationSimulator::gotoNextPositionElement()
-{
-  while (!m_gpxReader->atEnd() && !m_gpxReader->hasError())
-  {
-    if (m_gpxReader->isStartElement())
-    {
-      if (m_gpxReader->name().compare(QString("trkpt"), Qt::CaseInsensitive) == 0)
-      {
-        return true;
-      }
-    }
-
-    m_gpxReader->readNext();
-  }
-
-  return false;
-}
-
-/*!
-  \internal
- */
-Point GPXLocationSimulator::getNextPoint(QTime& time)
-{
-  // Convert the current gpx position to Point and QTime parmeters.
-  if (!gotoNextPositionElement())
-  {
-    return Point();
-  }
-
-  // fetch the lat and lon attributes from the trkpt element
-  const QXmlStreamAttributes attrs = m_gpxReader->attributes();
-  const double x = attrs.value("lon").toString().toDouble();
-  const double y = attrs.value("lat").toString().toDouble();
-  double z = NAN;
-  // if the new point is the same as the old point then trash it and try to get another.
-  if (x == m_latestPoint.x() && y == m_latestPoint.y())
-  {
-    m_gpxReader->readNext();
-    return getNextPoint(time);
-  }
-
-  // goto the start of the time child element
-  m_gpxReader->readNextStartElement();
-
-  while (m_gpxReader->name().compare(QString("trkpt"), Qt::CaseInsensitive) != 0 && !m_gpxReader->atEnd())
-  {
-    if (m_gpxReader->isStartElement())
-    {
-      if (m_gpxReader->name().compare(QString("ele"), Qt::CaseInsensitive) == 0)
-      {
-        z = m_gpxReader->readElementText().toDouble();
-      }
-      else if (m_gpxReader->name().compare(QString("time"), Qt::CaseInsensitive) == 0)
-      {
-        const QString timeString = m_gpxReader->readElementText();
-        const int hours = timeString.section(":", 0, 0).right(2).toInt();
-        const int minutes = timeString.section(":", 1, 1).toInt();
-        const int seconds = timeString.section(":", 2, 2).left(2).toInt();
-        time.setHMS(hours ,minutes, seconds, 0);
-      }
-    }
-
-    m_gpxReader->readNext();
-  }
-
-  m_latestPoint = std::isnan(z) ?
-        Point(x, y, SpatialReference::wgs84()) :
-        Point(x, y, z, SpatialReference::wgs84());
-
-  return m_latestPoint;
-}
-
 /*!
   \brief Starts position updates.
 
@@ -254,6 +182,20 @@ QGeoPositionInfoSource::Error GPXLocationSimulator::error() const
   return m_lastError;
 }
 
+/*!
+  \brief Sets the update interval to \a msec milliseconds.
+
+  A running simulation is moved on at the new interval, so that the simulated time
+  still passes at the playback rate.
+ */
+void GPXLocationSimulator::setUpdateInterval(int msec)
+{
+  QGeoPositionInfoSource::setUpdateInterval(msec);
+
+  if (m_timer->isActive())
+    m_timer->start(updateInterval());
+}
+
 /*!
   \brief Returns the minimum update interval in milliseconds.
  */
@@ -271,38 +213,52 @@ int GPXLocationSimulator::minimumUpdateInterval() const
  */
 void GPXLocationSimulator::handleTimerEvent()
 {
+  if (!m_track.isValid())
+    return;
+
   // update the current time
-  m_currentTime = m_currentTime.addMSecs(m_timer->interval() * m_playbackMultiplier);
+  m_currentTime += static_cast<qint64>(m_timer->interval()) * m_playbackMultiplier;
 
-  // determine if a new position needs to be obtained from the gpx
-  if (m_currentTime > m_segmentEndTime)
+  // move on to the segment containing the current time. If the end of the
+  // track has been reached, the simulation starts over
+  if (m_currentTime > m_track.at(m_currentSegment + 1).m_time)
   {
-    if (!updateInterpolationParameters())
+    m_currentSegment = m_track.segmentAt(m_currentTime, m_currentSegment);
+    if (m_currentSegment < 0)
     {
-      m_gpxReader->clear();
-      m_gpxReader->addData(m_gpxData);
       initializeInterpolationValues();
-
       return;
     }
   }
 
   // normalize the time across the current segment
-  const double val1 = static_cast<double>(m_segmentStartTime.msecsTo(m_currentTime));
-  const double val2 = static_cast<double>(m_segmentStartTime.msecsTo(m_segmentEndTime));
-  const double normalizedTime = val1 / val2;
-
-  // get the interpolated position and orientation on the current
-  // segment based on the normalized time.
-  const Point currentPosition = normalizedTime <= 0.5 ? m_currentSegment.startPoint() : m_currentSegment.endPoint();
-  const double currentHeading = getInterpolatedHeading(currentPosition, normalizedTime);
+  const double normalizedTime = m_track.segmentFraction(m_currentSegment, m_currentTime);
+
+  // get the position and heading on the current segment based on the normalized time
+  double latitude = 0.0;
+  double longitude = 0.0;
+  double elevation = 0.0;
+  double currentHeading = 0.0;
+  if (m_interpolationEnabled)
+  {
+    m_track.interpolate(m_currentSegment, normalizedTime, latitude, longitude, elevation);
+    currentHeading = m_track.interpolatedHeading(m_currentSegment, normalizedTime);
+  }
+  else
+  {
+    const GPXTrack::TrackPoint& currentPosition = m_track.at(normalizedTime <= 0.5 ? m_currentSegment : m_currentSegment + 1);
+    latitude = currentPosition.m_latitude;
+    longitude = currentPosition.m_longitude;
+    elevation = currentPosition.m_elevation;
+    currentHeading = m_track.at(m_currentSegment).m_heading;
+  }
 
   QGeoPositionInfo qtPosition;
   auto timeStamp = QDateTime::currentDateTime();
-  timeStamp.setTime(m_currentTime);
+  timeStamp.setTime(QTime::fromMSecsSinceStartOfDay(static_cast<int>(m_currentTime % s_msecsPerDay)));
   qtPosition.setTimestamp(timeStamp);
 
-  qtPosition.setCoordinate(QGeoCoordinate(currentPosition.y(), currentPosition.x(), currentPosition.z()));
+  qtPosition.setCoordinate(QGeoCoordinate(latitude, longitude, elevation));
 
   m_lastKnownPosition = qtPosition;
   emit positionUpdated(qtPosition);
@@ -314,82 +270,13 @@ void GPXLocationSimulator::handleTimerEvent()
  */
 bool GPXLocationSimulator::initializeInterpolationValues()
 {
-  // fetch the first 3 points from the gpx feed to populate the
-  // initial interpolation components.
-  const Point pt1 = getNextPoint(m_segmentStartTime);
-  const Point pt2 = getNextPoint(m_segmentEndTime);
-  const Point pt3 = getNextPoint(m_nextSegmentEndTime);
-
-  if (pt1.isEmpty() || pt2.isEmpty() || pt3.isEmpty())
-  {
-    return false;
-  }
-
-  // define the interpolation segments
-  m_currentSegment = LineSegment(pt1, pt2, SpatialReference::wgs84());
-  m_nextSegment = LineSegment(pt2, pt3, SpatialReference::wgs84());
-  m_startHeadingDelta = 0;
-  m_endHeadingDelta = heading(m_currentSegment);
-
-  // define the current time as the first timestamp extracted from the gpx file
-  m_currentTime = m_segmentStartTime;
-
-  return true;
-}
-
-/*!
-  \internal
- */
-double GPXLocationSimulator::getInterpolatedHeading(const Point& currentPosition, double normalizedTime)
-{
-  // implementation for smooth orientation transfer between segments.
-  // the smoothing is spread across the final 10% of the current segment
-  // and the first 10% of the next segment.
-
-  LineSegment segment;
-
-  // interpolation of the first 10% of the segment
-  if (normalizedTime < 0.1)
-  {
-    segment = LineSegment(m_currentSegment.startPoint(), currentPosition, SpatialReference::wgs84());
-    return heading(m_currentSegment);
-  }
-  // interpolation of the last 10% of the segment
-  else if (normalizedTime > 0.9)
-  {
-    segment = LineSegment(m_currentSegment.endPoint(), currentPosition, SpatialReference::wgs84());
-    return heading(m_currentSegment);
-  }
-
-  // no orientation interpolation needed, use the current segments angle
-  return heading(m_currentSegment);
-}
-
-/*!
-  \internal
- */
-bool GPXLocationSimulator::updateInterpolationParameters()
-{
-  // fetch the next coordinate in the gpx file and updates all the
-  // internal interpolation vars
-
-  m_segmentStartTime = m_segmentEndTime;
-  m_segmentEndTime = m_nextSegmentEndTime;
-  Point newPt = getNextPoint(m_nextSegmentEndTime);
-
-  // if there are no more points to get then notify simulation to start over
-  if (newPt.isEmpty())
-  {
+  // the track needs at least 3 points to interpolate on
+  if (!m_track.isValid())
     return false;
-  }
 
-  // discard the oldest segment and populate the newest segment.
-  m_currentSegment = m_nextSegment;
-  m_nextSegment = LineSegment(m_currentSegment.endPoint(), newPt, SpatialReference::wgs84());
-
-  // discard the oldest orientation delta and populate the newest
-  m_startHeadingDelta = m_endHeadingDelta;
-  m_endHeadingDelta = heading(m_currentSegment);
+  // define the current time as the first timestamp of the track
+  m_currentSegment = 0;
+  m_currentTime = m_track.startTime();
 
   return true;
 }
@@ -424,10 +311,9 @@ bool GPXLocationSimulator::setGpxFile(const QString& fileName)
   if (!m_gpxFile.open(QFile::ReadOnly | QFile::Text))
     return false;
 
-  m_gpxData = m_gpxFile.readAll();
-  m_gpxReader->clear();
-  m_gpxReader->addData(m_gpxData);
+  m_track = GPXTrack(m_gpxFile.readAll());
   m_gpxFile.close();
+  initializeInterpolationValues();
 
   m_isStarted = false;
 
@@ -453,13 +339,26 @@ void GPXLocationSimulator::setPlaybackMultiplier(int val)
 }
 
 /*!
-  \brief Returns the heading in degrees of the supplied \a segment.
+  \brief Returns whether positions are interpolated along the track.
+ */
+bool GPXLocationSimulator::isInterpolationEnabled() const
+{
+  return m_interpolationEnabled;
+}
+
+/*!
+  \brief Sets whether positions are interpolated along the track to \a enabled.
+
+  When enabled, each update reports the position along the great circle between
+  the track points, and the heading turns smoothly between segments. This gives
+  smooth movement at high update rates. When disabled, each update reports the
+  nearest track point and the heading of the current segment.
+
+  The default is \c true.
  */
-double GPXLocationSimulator::heading(const Esri::ArcGISRuntime::LineSegment& segment) const
+void GPXLocationSimulator::setInterpolationEnabled(bool enabled)
 {
-  const auto startPoint = segment.startPoint();
-  const auto endPoint = segment.endPoint();
-  return m_angleOffset.angleTo(QLineF(startPoint.x(), startPoint.y(), endPoint.x(), endPoint.y()));
+  m_interpolationEnabled = enabled;
 }
 
 } // Dsa
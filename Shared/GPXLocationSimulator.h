@@ -17,21 +17,13 @@
 #ifndef GPXLOCATIONSIMULATOR_H
 #define GPXLOCATIONSIMULATOR_H
 
-// C++ API headers
-#include "LineSegment.h"
-#include "Point.h"
+// dsa app headers
+#include "GPXTrack.h"
 
 // Qt headers
 #include <QFile>
 #include <QGeoPositionInfoSource>
-#include <QLineF>
-#include <QPointF>
-#include <QTime>
 
-// STL headers
-#include <memory>
-
-class QXmlStreamReader;
 class QTimer;
 
 namespace Dsa {
@@ -48,6 +40,7 @@ public:
   QGeoPositionInfo lastKnownPosition(bool fromSatellitePositioningMethodsOnly = false) const override;
   PositioningMethods supportedPositioningMethods() const override;
   int minimumUpdateInterval() const override;
+  void setUpdateInterval(int msec) override;
 
   bool isActive();
   bool isStarted();
@@ -58,6 +51,9 @@ public:
   int playbackMultiplier();
   void setPlaybackMultiplier(int multiplier);
 
+  bool isInterpolationEnabled() const;
+  void setInterpolationEnabled(bool enabled);
+
   QGeoPositionInfoSource::Error error() const override;
 
 public slots:
@@ -75,32 +71,18 @@ private:
   void pauseSimulation();
   void resumeSimulation();
 
-  bool gotoNextPositionElement();
-  Esri::ArcGISRuntime::Point getNextPoint(QTime& time);
-  bool updateInterpolationParameters();
   bool initializeInterpolationValues();
-  double heading(const Esri::ArcGISRuntime::LineSegment& segment) const;
-
-  double getInterpolatedHeading(const Esri::ArcGISRuntime::Point& currentPosition, double normalizedTime);
 
   void connectSignals();
 
   QFile m_gpxFile;
-  QByteArray m_gpxData;
-  std::unique_ptr<QXmlStreamReader> m_gpxReader;
+  GPXTrack m_track;
   QTimer* m_timer = nullptr;
   int m_playbackMultiplier = 1;
-  Esri::ArcGISRuntime::LineSegment m_currentSegment;
-  Esri::ArcGISRuntime::LineSegment m_nextSegment;
-  Esri::ArcGISRuntime::Point m_latestPoint;
-  double m_startHeadingDelta;
-  double m_endHeadingDelta;
-  QTime m_currentTime;
-  QTime m_segmentStartTime;
-  QTime m_segmentEndTime;
-  QTime m_nextSegmentEndTime;
+  bool m_interpolationEnabled = true;
+  int m_currentSegment = 0;
+  qint64 m_currentTime = 0;
   bool m_isStarted = false;
-  const QLineF m_angleOffset;
   QGeoPositionInfo m_lastKnownPosition;
   QGeoPositionInfoSource::Error m_lastError = QGeoPositionInfoSource::NoError;
 
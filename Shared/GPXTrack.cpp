@@ -0,0 +1,410 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "GPXTrack.h"
+
+// Qt headers
+#include <QFile>
+#include <QLineF>
+#include <QXmlStreamReader>
+
+// STL headers
+#include <algorithm>
+#include <cmath>
+
+namespace Dsa {
+
+namespace
+{
+constexpr qint64 s_msecsPerDay = 24 * 60 * 60 * 1000;
+
+// a timestamp which is this far before the previous one is taken to be the next day
+constexpr qint64 s_dayRolloverThreshold = s_msecsPerDay / 2;
+
+// the fraction of a segment at each end over which the heading turns onto the next segment
+constexpr double s_headingBlendFraction = 0.1;
+
+// segments shorter than this angle, in radians, are interpolated linearly
+constexpr double s_minimumSegmentAngle = 1e-9;
+
+constexpr double s_degreesToRadians = M_PI / 180.0;
+constexpr double s_radiansToDegrees = 180.0 / M_PI;
+
+// Returns the heading part way from heading1 to heading2, turning through the smaller angle
+double blendHeading(double heading1, double heading2, double fraction)
+{
+  double delta = std::fmod(heading2 - heading1, 360.0);
+  if (delta > 180.0)
+    delta -= 360.0;
+  else if (delta < -180.0)
+    delta += 360.0;
+
+  double heading = heading1 + delta * fraction;
+  if (heading < 0.0)
+    heading += 360.0;
+  else if (heading >= 360.0)
+    heading -= 360.0;
+
+  return heading;
+}
+
+// Returns the time of day of a GPX timestamp such as 2020-01-01T12:34:56Z in milliseconds
+qint64 timeOfDay(const QStringRef& timeString)
+{
+  const int timeIndex = timeString.indexOf(QLatin1Char('T'));
+  const QStringRef time = timeIndex == -1 ? timeString : timeString.mid(timeIndex + 1);
+
+  const int hours = time.mid(0, 2).toInt();
+  const int minutes = time.mid(3, 2).toInt();
+  const int seconds = time.mid(6, 2).toInt();
+  return ((hours * 60 + minutes) * 60 + seconds) * 1000;
+}
+}
+
+/*!
+  \class Dsa::GPXTrack
+  \inmodule Dsa
+  \brief The track points of a GPX file, parsed into a packed array.
+
+  Each track point holds its timestamp, coordinates and elevation, along with the
+  heading of the segment which starts at it. Consecutive points at the same location
+  are discarded. Timestamps are the time of day in milliseconds, and tracks which
+  run past midnight continue into the next day. Points without an elevation have
+  an elevation of \c NaN.
+
+  For each segment the great-circle parameters are precomputed when the track is
+  parsed, so \l interpolate only needs a few trigonometric operations to find a
+  position part way along a segment.
+
+  Copies of a track share its points.
+ */
+
+/*!
+  \brief Constructs an empty track.
+ */
+GPXTrack::GPXTrack()
+{
+}
+
+/*!
+  \brief Constructs a track from the GPX document \a gpxData.
+ */
+GPXTrack::GPXTrack(const QByteArray& gpxData)
+{
+  parse(gpxData);
+}
+
+/*!
+  \brief Destructor.
+ */
+GPXTrack::~GPXTrack()
+{
+}
+
+/*!
+  \brief Returns the track read from the GPX file \a fileName, or an empty
+  track if the file cannot be read.
+ */
+GPXTrack GPXTrack::fromFile(const QString& fileName)
+{
+  QFile gpxFile(fileName);
+  if (!gpxFile.open(QFile::ReadOnly | QFile::Text))
+    return GPXTrack();
+
+  return GPXTrack(gpxFile.readAll());
+}
+
+/*!
+  \brief Returns whether the track has no points.
+ */
+bool GPXTrack::isEmpty() const
+{
+  return m_trackPoints.isEmpty();
+}
+
+/*!
+  \brief Returns whether the track has enough points to be simulated.
+ */
+bool GPXTrack::isValid() const
+{
+  return m_trackPoints.size() >= 3;
+}
+
+/*!
+  \brief Returns the number of points in the track.
+ */
+int GPXTrack::size() const
+{
+  return m_trackPoints.size();
+}
+
+/*!
+  \brief Returns the track point at \a index.
+ */
+const GPXTrack::TrackPoint& GPXTrack::at(int index) const
+{
+  return m_trackPoints.at(index);
+}
+
+/*!
+  \brief Returns the points of the track.
+ */
+const QVector<GPXTrack::TrackPoint>& GPXTrack::trackPoints() const
+{
+  return m_trackPoints;
+}
+
+/*!
+  \brief Returns the time of the first point of the track.
+ */
+qint64 GPXTrack::startTime() const
+{
+  return m_trackPoints.isEmpty() ? 0 : m_trackPoints.first().m_time;
+}
+
+/*!
+  \brief Returns the time of the last point of the track.
+ */
+qint64 GPXTrack::endTime() const
+{
+  return m_trackPoints.isEmpty() ? 0 : m_trackPoints.last().m_time;
+}
+
+/*!
+  \brief Returns the duration of the track in milliseconds.
+ */
+qint64 GPXTrack::duration() const
+{
+  return endTime() - startTime();
+}
+
+/*!
+  \brief Returns the index of the segment, at or after \a fromSegment, whose end time is
+  the first at or after \a time, or \c -1 if \a time is after the end of the track.
+
+  Segment \c i runs from point \c i to point \c {i + 1}. When playing a track back, the
+  result is usually \a fromSegment or the segment after it, so those are checked before
+  falling back to a binary search over the remaining points.
+ */
+int GPXTrack::segmentAt(qint64 time, int fromSegment) const
+{
+  const int lastSegment = m_trackPoints.size() - 2;
+  if (fromSegment < 0 || fromSegment > lastSegment)
+    return -1;
+
+  if (time <= m_trackPoints.at(fromSegment + 1).m_time)
+    return fromSegment;
+
+  if (fromSegment < lastSegment && time <= m_trackPoints.at(fromSegment + 2).m_time)
+    return fromSegment + 1;
+
+  const auto begin = m_trackPoints.cbegin() + fromSegment + 1;
+  const auto findIt = std::lower_bound(begin, m_trackPoints.cend(), time, [](const TrackPoint& trackPoint, qint64 value)
+  {
+    return trackPoint.m_time < value;
+  });
+
+  if (findIt == m_trackPoints.cend())
+    return -1;
+
+  return static_cast<int>(findIt - m_trackPoints.cbegin()) - 1;
+}
+
+/*!
+  \brief Returns how far \a time is along \a segment, from \c 0.0 at its start to
+  \c 1.0 at its end.
+ */
+double GPXTrack::segmentFraction(int segment, qint64 time) const
+{
+  const TrackPoint& start = m_trackPoints.at(segment);
+  const qint64 segmentDuration = m_trackPoints.at(segment + 1).m_time - start.m_time;
+  if (segmentDuration <= 0)
+    return 1.0;
+
+  return qBound(0.0, static_cast<double>(time - start.m_time) / segmentDuration, 1.0);
+}
+
+/*!
+  \brief Sets \a latitude, \a longitude and \a elevation to the position at \a fraction
+  along the great circle of \a segment.
+
+  The elevation is interpolated linearly, and is \c NaN if either end of the
+  segment has no elevation.
+ */
+void GPXTrack::interpolate(int segment, double fraction, double& latitude, double& longitude, double& elevation) const
+{
+  const TrackPoint& start = m_trackPoints.at(segment);
+  const TrackPoint& end = m_trackPoints.at(segment + 1);
+
+  elevation = start.m_elevation + (end.m_elevation - start.m_elevation) * fraction;
+
+  if (start.m_segmentAngle < s_minimumSegmentAngle)
+  {
+    latitude = start.m_latitude + (end.m_latitude - start.m_latitude) * fraction;
+    longitude = start.m_longitude + (end.m_longitude - start.m_longitude) * fraction;
+    return;
+  }
+
+  // spherical linear interpolation between the unit vectors of the end points
+  const double startWeight = std::sin((1.0 - fraction) * start.m_segmentAngle) * start.m_inverseSinSegmentAngle;
+  const double endWeight = std::sin(fraction * start.m_segmentAngle) * start.m_inverseSinSegmentAngle;
+  const double x = startWeight * start.m_unitX + endWeight * end.m_unitX;
+  const double y = startWeight * start.m_unitY + endWeight * end.m_unitY;
+  const double z = startWeight * start.m_unitZ + endWeight * end.m_unitZ;
+
+  latitude = std::atan2(z, std::sqrt(x * x + y * y)) * s_radiansToDegrees;
+  longitude = std::atan2(y, x) * s_radiansToDegrees;
+}
+
+/*!
+  \brief Returns the heading in degrees at \a fraction along \a segment.
+
+  Near each end of the segment, the heading turns smoothly onto that of the
+  neighbouring segment.
+ */
+double GPXTrack::interpolatedHeading(int segment, double fraction) const
+{
+  const double heading = m_trackPoints.at(segment).m_heading;
+
+  if (fraction > 1.0 - s_headingBlendFraction && segment + 1 < m_trackPoints.size() - 1)
+  {
+    const double blend = (fraction - (1.0 - s_headingBlendFraction)) / (2.0 * s_headingBlendFraction);
+    return blendHeading(heading, m_trackPoints.at(segment + 1).m_heading, blend);
+  }
+
+  if (fraction < s_headingBlendFraction && segment > 0)
+  {
+    const double blend = (fraction + s_headingBlendFraction) / (2.0 * s_headingBlendFraction);
+    return blendHeading(m_trackPoints.at(segment - 1).m_heading, heading, blend);
+  }
+
+  return heading;
+}
+
+/*!
+  \brief Returns the heading in degrees of the segment from \a start to \a end.
+ */
+double GPXTrack::heading(const TrackPoint& start, const TrackPoint& end)
+{
+  static const QLineF s_angleOffset(0.0, -90.0, 0.0, 90.0);
+  return s_angleOffset.angleTo(QLineF(start.m_longitude, start.m_latitude, end.m_longitude, end.m_latitude));
+}
+
+/*!
+  \internal
+
+  Parses every track point of \a gpxData, along with the heading of the segment
+  which starts at each point.
+ */
+void GPXTrack::parse(const QByteArray& gpxData)
+{
+  QXmlStreamReader gpxReader(gpxData);
+  TrackPoint trackPoint;
+  bool inTrackPoint = false;
+  qint64 dayOffset = 0;
+  qint64 previousTime = 0;
+
+  while (!gpxReader.atEnd() && !gpxReader.hasError())
+  {
+    gpxReader.readNext();
+
+    if (gpxReader.isStartElement())
+    {
+      if (gpxReader.name().compare(QLatin1String("trkpt"), Qt::CaseInsensitive) == 0)
+      {
+        // points without a time take that of the previous point
+        const QXmlStreamAttributes attrs = gpxReader.attributes();
+        trackPoint.m_longitude = attrs.value(QLatin1String("lon")).toDouble();
+        trackPoint.m_latitude = attrs.value(QLatin1String("lat")).toDouble();
+        trackPoint.m_elevation = NAN;
+        inTrackPoint = true;
+      }
+      else if (inTrackPoint && gpxReader.name().compare(QLatin1String("ele"), Qt::CaseInsensitive) == 0)
+      {
+        trackPoint.m_elevation = gpxReader.readElementText().toDouble();
+      }
+      else if (inTrackPoint && gpxReader.name().compare(QLatin1String("time"), Qt::CaseInsensitive) == 0)
+      {
+        const QString timeString = gpxReader.readElementText();
+        const qint64 time = timeOfDay(QStringRef(&timeString));
+        if (!m_trackPoints.isEmpty() && previousTime - (time + dayOffset) > s_dayRolloverThreshold)
+          dayOffset += s_msecsPerDay;
+
+        trackPoint.m_time = time + dayOffset;
+      }
+    }
+    else if (inTrackPoint && gpxReader.isEndElement() &&
+             gpxReader.name().compare(QLatin1String("trkpt"), Qt::CaseInsensitive) == 0)
+    {
+      inTrackPoint = false;
+
+      if (!m_trackPoints.isEmpty())
+      {
+        const TrackPoint& previousPoint = m_trackPoints.last();
+        if (trackPoint.m_longitude == previousPoint.m_longitude && trackPoint.m_latitude == previousPoint.m_latitude)
+          continue;
+
+        m_trackPoints.last().m_heading = heading(previousPoint, trackPoint);
+      }
+
+      previousTime = trackPoint.m_time;
+      m_trackPoints.append(trackPoint);
+    }
+  }
+
+  // the final point continues on the heading of the last segment
+  if (m_trackPoints.size() > 1)
+    m_trackPoints.last().m_heading = m_trackPoints.at(m_trackPoints.size() - 2).m_heading;
+
+  m_trackPoints.squeeze();
+  prepareSegments();
+}
+
+/*!
+  \internal
+
+  Computes the unit vector of every point, and the great-circle angle of the
+  segment which starts at each point.
+ */
+void GPXTrack::prepareSegments()
+{
+  for (TrackPoint& trackPoint : m_trackPoints)
+  {
+    const double latitude = trackPoint.m_latitude * s_degreesToRadians;
+    const double longitude = trackPoint.m_longitude * s_degreesToRadians;
+    trackPoint.m_unitX = std::cos(latitude) * std::cos(longitude);
+    trackPoint.m_unitY = std::cos(latitude) * std::sin(longitude);
+    trackPoint.m_unitZ = std::sin(latitude);
+  }
+
+  for (int i = 0; i < m_trackPoints.size() - 1; ++i)
+  {
+    TrackPoint& start = m_trackPoints[i];
+    const TrackPoint& end = m_trackPoints.at(i + 1);
+    // the chord length gives an accurate angle for the short segments of a GPS track
+    const double dx = end.m_unitX - start.m_unitX;
+    const double dy = end.m_unitY - start.m_unitY;
+    const double dz = end.m_unitZ - start.m_unitZ;
+    const double chord = std::sqrt(dx * dx + dy * dy + dz * dz);
+    start.m_segmentAngle = 2.0 * std::asin(std::min(chord * 0.5, 1.0));
+    start.m_inverseSinSegmentAngle = start.m_segmentAngle < s_minimumSegmentAngle ? 0.0 : 1.0 / std::sin(start.m_segmentAngle);
+  }
+}
+
+} // Dsa
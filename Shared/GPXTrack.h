@@ -0,0 +1,80 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef GPXTRACK_H
+#define GPXTRACK_H
+
+// Qt headers
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+namespace Dsa {
+
+class GPXTrack
+{
+public:
+  struct TrackPoint
+  {
+    qint64 m_time = 0;
+    double m_latitude = 0.0;
+    double m_longitude = 0.0;
+    double m_elevation = 0.0;
+    double m_heading = 0.0;
+
+    // great-circle parameters of the segment which starts at this point
+    double m_unitX = 0.0;
+    double m_unitY = 0.0;
+    double m_unitZ = 0.0;
+    double m_segmentAngle = 0.0;
+    double m_inverseSinSegmentAngle = 0.0;
+  };
+
+  GPXTrack();
+  explicit GPXTrack(const QByteArray& gpxData);
+  ~GPXTrack();
+
+  static GPXTrack fromFile(const QString& fileName);
+
+  bool isEmpty() const;
+  bool isValid() const;
+  int size() const;
+
+  const TrackPoint& at(int index) const;
+  const QVector<TrackPoint>& trackPoints() const;
+
+  qint64 startTime() const;
+  qint64 endTime() const;
+  qint64 duration() const;
+
+  int segmentAt(qint64 time, int fromSegment = 0) const;
+  double segmentFraction(int segment, qint64 time) const;
+
+  void interpolate(int segment, double fraction, double& latitude, double& longitude, double& elevation) const;
+  double interpolatedHeading(int segment, double fraction) const;
+
+  static double heading(const TrackPoint& start, const TrackPoint& end);
+
+private:
+  void parse(const QByteArray& gpxData);
+  void prepareSegments();
+
+  QVector<TrackPoint> m_trackPoints;
+};
+
+} // Dsa
+
+#endif // GPXTRACK_H
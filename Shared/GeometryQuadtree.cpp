@@ -19,53 +19,357 @@
 #include "pch.hpp"
 
 #include "GeometryQuadtree.h"
+#include "EnvelopeRTree.h"
+#include "GeoElementChangeAggregator.h"
 #include "GeoElementUtils.h"
+#include "GeodesicKernels.h"
+#include "MemoryBudget.h"
+#include "PerformanceMonitor.h"
+#include "PreparedPolygon.h"
+#include "TraceRecorder.h"
 
 // C++ API headers
 #include "Envelope.h"
 #include "GeoElement.h"
 #include "GeometryEngine.h"
 #include "Point.h"
+#include "Polygon.h"
 
 // Qt headers
-#include <QSet>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <QtMath>
+
+// STL headers
+#include <algorithm>
+#include <cmath>
+#include <vector>
 
 using namespace Esri::ArcGISRuntime;
 
 namespace Dsa {
 
-struct GeometryQuadtree::QuadTree
+// number of incremental changes after which empty nodes are pruned from the tree
+static constexpr int s_pruneInterval = 64;
+
+// minimum number of elements outside of the tree's extent before the tree is re-built
+static constexpr int s_minimumOutsideElements = 16;
+
+// the spherical approximation can under-estimate the extent covered by a distance
+// on the ellipsoid by around 0.5%, so distance search extents are enlarged by this factor
+static constexpr double s_searchExtentScale = 1.01;
+
+// minimum number of elements projected by each worker when the tree is built
+static constexpr int s_minimumProjectionChunkSize = 256;
+
+// the maximum speed of the elements is the fastest movement seen over the current
+// and the previous window of this many milliseconds
+static constexpr qint64 s_speedWindowMsecs = 60000;
+
+// minimum number of elements for the quadrants of the root to be built in parallel
+static constexpr int s_minimumParallelBulkLoad = 4096;
+
+// number of elements a cell can hold before it is split into quadrants
+static constexpr int s_maxCellElements = 16;
+
+// number of elements at or below which the children of a cell are merged back into it
+static constexpr int s_mergeCellElements = s_maxCellElements / 2;
+
+namespace
+{
+// projects the geometry to WGS84, unless it is already in WGS84
+template <typename T>
+T toWgs84(const T& geometry)
+{
+  if (geometry.spatialReference() == SpatialReference::wgs84())
+    return geometry;
+
+  return GeometryEngine::project(geometry, SpatialReference::wgs84());
+}
+
+// returns the longitude moved by whole turns into the range [start, start + 360)
+double wrapLongitude(double longitude, double start)
+{
+  return longitude - (std::floor((longitude - start) / 360.0) * 360.0);
+}
+
+// returns whether the two ranges of longitude overlap or touch, allowing
+// for either range extending beyond the antimeridian
+bool longitudesIntersect(double xMin1, double xMax1, double xMin2, double xMax2)
+{
+  if (xMin1 <= xMax2 && xMax1 >= xMin2)
+    return true;
+
+  if (xMax1 - xMin1 >= 360.0 || xMax2 - xMin2 >= 360.0)
+    return true;
+
+  // the first range is narrower than a turn, so it can only meet the copy of the second
+  // range starting just below it or the copy one turn above that
+  const double shiftedMin2 = wrapLongitude(xMin2, xMin1 - 360.0);
+  const double shiftedMax2 = shiftedMin2 + (xMax2 - xMin2);
+  return (xMin1 <= shiftedMax2 && xMax1 >= shiftedMin2) ||
+         (xMin1 <= shiftedMax2 + 360.0 && xMax1 >= shiftedMin2 + 360.0);
+}
+
+// returns whether the two WGS84 envelopes overlap or touch, allowing for the antimeridian
+bool envelopesIntersect(const Envelope& extent1, const Envelope& extent2)
+{
+  return extent1.yMin() <= extent2.yMax() && extent1.yMax() >= extent2.yMin() &&
+         longitudesIntersect(extent1.xMin(), extent1.xMax(), extent2.xMin(), extent2.xMax());
+}
+
+// returns the extent as plain values
+EnvelopeRTree::Box toBounds(const Envelope& extent, int id = -1)
+{
+  EnvelopeRTree::Box bounds;
+  bounds.m_xMin = extent.xMin();
+  bounds.m_xMax = extent.xMax();
+  bounds.m_yMin = extent.yMin();
+  bounds.m_yMax = extent.yMax();
+  bounds.m_id = id;
+  return bounds;
+}
+
+// returns the bounds moved into the range of longitude [cut, cut + 360) used by the tree.
+// Bounds which would cross the end of that range cover all of it instead
+EnvelopeRTree::Box wrapBounds(const EnvelopeRTree::Box& bounds, double cut)
+{
+  EnvelopeRTree::Box result = bounds;
+  const double width = bounds.m_xMax - bounds.m_xMin;
+  result.m_xMin = wrapLongitude(bounds.m_xMin, cut);
+  result.m_xMax = result.m_xMin + width;
+  if (width >= 360.0 || result.m_xMax > cut + 360.0)
+  {
+    result.m_xMin = cut;
+    result.m_xMax = cut + 360.0;
+  }
+
+  return result;
+}
+
+// splits the query bounds into the range of longitude [cut, cut + 360) used by the tree.
+// Returns the number of pieces, which is two if the query crosses the end of the range
+int wrapQueryBounds(const EnvelopeRTree::Box& query, double cut, EnvelopeRTree::Box pieces[2])
+{
+  const double width = query.m_xMax - query.m_xMin;
+  pieces[0] = query;
+  if (width >= 360.0)
+  {
+    pieces[0].m_xMin = cut;
+    pieces[0].m_xMax = cut + 360.0;
+    return 1;
+  }
+
+  pieces[0].m_xMin = wrapLongitude(query.m_xMin, cut);
+  pieces[0].m_xMax = pieces[0].m_xMin + width;
+  if (pieces[0].m_xMax <= cut + 360.0)
+    return 1;
+
+  pieces[1] = pieces[0];
+  pieces[0].m_xMax = cut + 360.0;
+  pieces[1].m_xMin = cut;
+  pieces[1].m_xMax -= 360.0;
+  return 2;
+}
+
+// returns the longitude at which the range of longitude used by the tree starts. This is the
+// antimeridian unless elements straddle it, in which case it is the middle of the widest range
+// of longitude which no element covers, so that elements either side of the antimeridian
+// are close together in the tree
+double longitudeCut(const QVector<EnvelopeRTree::Box>& bounds)
+{
+  std::vector<std::pair<double, double>> ranges;
+  ranges.reserve(bounds.size());
+  for (const EnvelopeRTree::Box& elementBounds : bounds)
+  {
+    // elements covering every longitude do not affect the choice
+    const double width = elementBounds.m_xMax - elementBounds.m_xMin;
+    if (width >= 360.0)
+      continue;
+
+    const double start = wrapLongitude(elementBounds.m_xMin, -180.0);
+    ranges.emplace_back(start, start + width);
+  }
+
+  if (ranges.empty())
+    return -180.0;
+
+  std::sort(ranges.begin(), ranges.end());
+
+  double coveredEnd = ranges.front().second;
+  double widestGap = 0.0;
+  double cut = -180.0;
+  for (size_t i = 1; i < ranges.size(); ++i)
+  {
+    const double gap = ranges[i].first - coveredEnd;
+    if (gap > widestGap)
+    {
+      widestGap = gap;
+      cut = coveredEnd + (gap * 0.5);
+    }
+
+    coveredEnd = std::max(coveredEnd, ranges[i].second);
+  }
+
+  // the gap which runs from the last range around to the first
+  const double wrappedGap = ranges.front().first + 360.0 - coveredEnd;
+  if (wrappedGap < widestGap)
+    return cut;
+
+  if (coveredEnd <= 180.0 || wrappedGap <= 0.0)
+    return -180.0;
+
+  return wrapLongitude(coveredEnd + (wrappedGap * 0.5), -180.0);
+}
+
+// returns a lower bound, in meters on the sphere, of the distance from the WGS84 location
+// to any point within the WGS84 extent. Each point of the extent is at least as far in
+// latitude, and at least as far from the meridian of the nearest edge of the extent
+double extentDistanceLowerBound(const Point& wgs84, const Envelope& extent)
+{
+  const double latDelta = std::max({0.0, extent.yMin() - wgs84.y(), wgs84.y() - extent.yMax()});
+
+  double lonDelta = 0.0;
+  if (!longitudesIntersect(extent.xMin(), extent.xMax(), wgs84.x(), wgs84.x()))
+    lonDelta = std::min({90.0, wrapLongitude(extent.xMin() - wgs84.x(), 0.0), wrapLongitude(wgs84.x() - extent.xMax(), 0.0)});
+
+  const double meridianAngle = std::asin(std::sin(qDegreesToRadians(lonDelta)) * std::cos(qDegreesToRadians(wgs84.y())));
+  return Geodesic::s_earthRadius * std::max(qDegreesToRadians(latDelta), meridianAngle);
+}
+
+// returns whether the outer envelope wholly contains the inner envelope
+bool envelopeContains(const Envelope& outer, const Envelope& inner)
+{
+  return inner.xMin() >= outer.xMin() && inner.xMax() <= outer.xMax() &&
+         inner.yMin() >= outer.yMin() && inner.yMax() <= outer.yMax();
+}
+
+// returns a conservative WGS84 search extent around the WGS84 location. The longitude range
+// may extend beyond the antimeridian, and covers every longitude if the search includes a pole
+Envelope distanceSearchExtent(const Point& wgs84, double meters)
+{
+  const double angle = (meters / Geodesic::s_earthRadius) * s_searchExtentScale;
+  const double latDelta = qRadiansToDegrees(angle);
+  const double cosLat = std::cos(qDegreesToRadians(wgs84.y()));
+
+  // the widest longitude of a circle on the sphere is asin(sin(angle) / cos(lat)), unless it includes a pole
+  const bool includesPole = (wgs84.y() + latDelta >= 90.0) || (wgs84.y() - latDelta <= -90.0);
+  const double sinAngle = std::sin(std::min(angle, M_PI_2));
+  const double lonDelta = (includesPole || angle >= M_PI_2 || sinAngle >= cosLat) ? 180.0
+                                                                                   : qRadiansToDegrees(std::asin(sinAngle / cosLat));
+  return Envelope(wgs84.x() - lonDelta, std::max(-90.0, wgs84.y() - latDelta),
+                  wgs84.x() + lonDelta, std::min(90.0, wgs84.y() + latDelta),
+                  SpatialReference::wgs84());
+}
+
+// returns whether the WGS84 geometry, with the given WGS84 extent, lies within meters of the WGS84 location.
+// The geodesic buffer is only created the first time a non-point geometry is tested
+bool isWithinDistance(const Point& wgs84, double meters, const Geometry& geometry, const Envelope& extent, Geometry& buffer)
+{
+  // the extent of a point is the point itself
+  if (geometry.geometryType() == GeometryType::Point)
+    return Geodesic::haversineDistance(wgs84.y(), wgs84.x(), extent.yMin(), extent.xMin()) <= meters;
+
+  if (buffer.isEmpty())
+    buffer = GeometryEngine::bufferGeodetic(wgs84, meters, LinearUnit::meters(), 1.0, GeodeticCurveType::Geodesic);
+
+  return GeometryEngine::intersects(buffer, geometry);
+}
+}
+
+// the structure holding the ids of the elements, which is either a quadtree
+// or an R-tree depending on the index type
+struct GeometryQuadtree::SpatialTree
 {
-  explicit QuadTree(int level, double xMin, double xMax, double yMin, double yMax);
-  ~QuadTree();
+  // the extent of an element as plain values, used when bulk loading the tree
+  using Bounds = EnvelopeRTree::Box;
+
+  // a location as plain values
+  struct Location
+  {
+    double m_x = 0.0;
+    double m_y = 0.0;
+  };
+
+  virtual ~SpatialTree() = default;
+
+  virtual void assign(const Bounds& bounds, int maxLevels) = 0;
+  virtual void bulkLoad(const QVector<Bounds>& bounds, int maxLevels) = 0;
+  virtual void prune() = 0;
+  virtual void removeId(int geomId) = 0;
+
+  virtual void intersectingIds(const Bounds& query, QVector<int>& results) const = 0;
+  virtual void intersectingIds(const Location& location, QVector<int>& results) const = 0;
 
-  QuadTree* createTopLeft(int maxLevels);
-  QuadTree* createTopRight(int maxLevels);
-  QuadTree* createBottomLeft(int maxLevels);
-  QuadTree* createBottomRight(int maxLevels);
+  virtual bool contains(const Bounds& bounds) const = 0;
+};
 
-  bool assign(const Envelope& extent, int geomId, int maxLevels);
-  void prune();
+// the tree is stored as a contiguous array of cells, with each cell
+// holding the ids of the elements which intersect it in a packed vector
+struct GeometryQuadtree::QuadTree : public SpatialTree
+{
+  struct Node
+  {
+    Node childNode(int quadrant) const;
+    bool isLeaf() const;
+    bool intersects(const Bounds& bounds) const;
+    bool isCoveredBy(const Bounds& bounds) const;
+    bool intersects(const Location& location) const;
+
+    int m_level = 0;
+    double m_xMin = 0.0;
+    double m_xMax = 0.0;
+    double m_yMin = 0.0;
+    double m_yMax = 0.0;
+    int m_children[4] = {-1, -1, -1, -1}; // top left, top right, bottom left, bottom right
+    QVector<int> m_geometryIds;
+  };
+
+  explicit QuadTree(double xMin, double xMax, double yMin, double yMax);
+
+  void assign(const Bounds& bounds, int maxLevels) override;
+  void bulkLoad(const QVector<Bounds>& bounds, int maxLevels) override;
+  void prune() override;
+  void removeId(int geomId) override;
+
+  void intersectingIds(const Bounds& query, QVector<int>& results) const override;
+  void intersectingIds(const Location& location, QVector<int>& results) const override;
+
+  bool contains(const Bounds& bounds) const override;
+
+  int createNode(const Node& node);
+  void releaseNode(int nodeIndex);
+  bool assign(int nodeIndex, const Bounds& bounds, int maxLevels);
+  void bulkLoad(int nodeIndex, const QVector<Bounds>& bounds, int maxLevels);
+  void split(int nodeIndex, const QVector<Bounds>& bounds, int maxLevels);
+  static bool isSplitRequired(const Node& node, const QVector<Bounds>& bounds, int maxLevels);
+  void appendSubtree(int nodeIndex, int quadrant, const QuadTree& subtree);
+  void prune(int nodeIndex);
+  void removeId(int nodeIndex, int geomId);
+
+  template <typename T>
+  void intersectingIds(int nodeIndex, const T& query, QVector<int>& results) const;
+
+  QVector<Node> m_nodes; // the root node is always the first node
+  QVector<int> m_freeNodes;
+  QHash<int, Bounds> m_elementBounds; // needed to split a cell when an element is added to it
+};
 
-  QSet<int> intersectingIds(const Envelope& extent) const;
-  QSet<int> intersectingIds(const Point& location) const;
+// an R-tree records each element once, in a node sized to the extents it holds,
+// so large polygons and long polylines are not repeated across many cells
+struct GeometryQuadtree::RTree : public SpatialTree
+{
+  void assign(const Bounds& bounds, int maxLevels) override;
+  void bulkLoad(const QVector<Bounds>& bounds, int maxLevels) override;
+  void prune() override;
+  void removeId(int geomId) override;
 
-  bool contains(const Envelope& extent) const;
-  bool intersects(const Envelope& extent) const;
-  bool intersects(const Point& location) const;
+  void intersectingIds(const Bounds& query, QVector<int>& results) const override;
+  void intersectingIds(const Location& location, QVector<int>& results) const override;
 
-  void removeId(int geomId);
+  bool contains(const Bounds& bounds) const override;
 
-  int m_level = 0;
-  double m_xMin = 0.0;
-  double m_xMax = 0.0;
-  double m_yMin = 0.0;
-  double m_yMax = 0.0;
-  QuadTree* m_tl = nullptr; // top left
-  QuadTree* m_tr = nullptr; // top right
-  QuadTree* m_bl = nullptr; // bottom left
-  QuadTree* m_br = nullptr; // bottom right
-  QSet<int> m_geometryIds;
+  EnvelopeRTree m_tree;
 };
 
 /*!
@@ -77,6 +381,51 @@ struct GeometryQuadtree::QuadTree
 
   The tree then allows geometric tests for candidate intersections against
   query geometries.
+
+  When the geometry of an element changes, the element is moved from its old
+  cells to its new cells rather than re-building the tree. Elements which move
+  outside of the tree's extent are tracked separately and the tree is only
+  re-built once a significant proportion of them lie outside. Empty cells are
+  pruned lazily. Changes are watched by a single \l GeoElementChangeAggregator
+  and applied in batches, so \l treeChanged is emitted once for all of the elements
+  which moved since control last returned to the event loop.
+
+  Longitudes are indexed in a range of 360 degrees which starts at the antimeridian,
+  unless the elements straddle it. In that case the range starts in the widest span of
+  longitude which holds no elements, so that elements either side of the antimeridian
+  (for example in the Pacific) are close together in the tree rather than at its opposite
+  edges. Query extents which cross the end of the range are split, and the extent tests
+  used to filter candidates allow for extents which extend beyond the antimeridian. Distance
+  searches which include a pole cover every longitude.
+
+  The tree also records how fast point elements move, so that users can predict how
+  soon a moving element could come within a distance of a location. \l maximumSpeed is
+  the fastest movement seen recently and \l unpredictableChangeCount counts the changes
+  which such a prediction cannot account for, such as an element moving faster than that,
+  elements being added or other geometry changing.
+
+  The depth of the tree adapts to the density of the elements. A cell is only split
+  into quadrants when it holds more elements than it can separate, and the children
+  of a cell are merged back into it when enough elements are removed. The maximum
+  number of levels limits how far dense clusters are subdivided.
+
+  Large polygons and long polylines are recorded in every cell they cross. For sets
+  of such extended geometries, the index can instead be built as an R-tree by passing
+  \l {GeometryQuadtree::IndexType} {IndexType::RTree}. An R-tree records each element
+  once and has no fixed extent, so no elements lie outside of it and it is never re-built
+  because elements have moved. The queries and their results are the same for both types.
+
+  When the tree is built or re-built, the elements are projected to WGS84 in
+  parallel on the global thread pool and the tree is bulk loaded: each cell
+  partitions the extents it holds between its quadrants, rather than each element
+  being assigned from the root in turn. For large sets of elements the quadrants of
+  the root are built in parallel. The finished tree replaces the previous one in a
+  single step, so queries never see a partially built tree.
+
+  The WGS84 geometry and extent of each element is cached when it is assigned to
+  the tree and refreshed when its geometry changes. The candidate geometries
+  returned by queries are these cached WGS84 geometries, so callers do not need to
+  project them again. Query extents which are already in WGS84 are not re-projected.
  */
 
 /*!
@@ -87,14 +436,42 @@ GeometryQuadtree::GeometryQuadtree(const Envelope& extent,
                                    const QList<GeoElement*>& geoElements,
                                    int maxLevels,
                                    QObject* parent):
+  GeometryQuadtree(extent, geoElements, maxLevels, IndexType::Quadtree, parent)
+{
+}
+
+/*!
+  \brief Constructor taking the \a extent of the index, the list of \a geoElements
+  which it should include, the \a maxLevels for a quadtree, the \a indexType and an
+  optional \a parent.
+
+  The \a extent and \a maxLevels are not used by an R-tree.
+ */
+GeometryQuadtree::GeometryQuadtree(const Envelope& extent,
+                                   const QList<GeoElement*>& geoElements,
+                                   int maxLevels,
+                                   IndexType indexType,
+                                   QObject* parent):
   QObject(parent),
-  m_maxLevels(maxLevels)
+  m_indexType(indexType),
+  m_maxLevels(maxLevels),
+  m_changeAggregator(new GeoElementChangeAggregator(this))
 {
-  // connect to the geometryChanged signal of individual GeoElements
+  m_clock.start();
+
+  connect(m_changeAggregator, &GeoElementChangeAggregator::geometriesChanged, this, &GeometryQuadtree::handleGeometryChanges);
+  connect(m_changeAggregator, &GeoElementChangeAggregator::elementDestroyed, this, &GeometryQuadtree::handleElementDestroyed);
+
+  // watch the geometry of the individual GeoElements
   for (const auto& element : geoElements)
     handleNewGeoElement(element);
 
   buildTree(extent);
+
+  // prepared polygons are rebuilt the next time they are needed
+  MemoryBudget::instance()->registerCache(this, QStringLiteral("Prepared polygons"), MemoryBudget::RecomputePriority,
+                                          [this]() { return preparedPolygonFootprint(); },
+                                          [this]() { return releasePreparedPolygons(); });
 }
 
 /*!
@@ -106,8 +483,6 @@ GeometryQuadtree::~GeometryQuadtree()
 
 /*!
   \brief Adds the \a newGeoElement into the quadtree.
-
-  \note The tree will be re-built.
  */
 void GeometryQuadtree::appendGeoElment(GeoElement* newGeoElement)
 {
@@ -118,9 +493,119 @@ void GeometryQuadtree::appendGeoElment(GeoElement* newGeoElement)
   handleGeometryChange(newKey);
 }
 
+/*!
+  \brief Adds all of the \a newGeoElements into the quadtree.
+
+  The elements are assigned to the existing tree. If too many of them lie outside of
+  its extent, the tree is re-built once for the whole set. \l treeChanged is emitted once.
+ */
+void GeometryQuadtree::appendGeoElements(const QList<GeoElement*>& newGeoElements)
+{
+  bool changed = false;
+  for (GeoElement* element : newGeoElements)
+  {
+    const int newKey = handleNewGeoElement(element);
+    if (newKey == -1)
+      continue;
+
+    m_tree->removeId(newKey);
+    m_outsideExtents.remove(newKey);
+    m_wgs84Elements.remove(newKey);
+    assignElement(newKey, wgs84Element(newKey).m_extent);
+    changed = true;
+  }
+
+  if (!changed)
+    return;
+
+  ++m_unpredictableChangeCount;
+
+  // if too many geometries lie outside of the existing tree, rebuild once for all elements
+  if (isRebuildRequired())
+  {
+    rebuildForAllElements();
+    return;
+  }
+
+  pruneIfRequired();
+  emit treeChanged();
+}
+
+/*!
+  \brief Removes the \a geoElement from the quadtree.
+
+  This should be called when an element is removed from its container without being
+  deleted. Deleted elements are removed automatically.
+ */
+void GeometryQuadtree::removeGeoElement(GeoElement* geoElement)
+{
+  const int key = m_elementKeys.value(geoElement, -1);
+  if (key == -1)
+    return;
+
+  removeElement(key);
+
+  pruneIfRequired();
+  emit treeChanged();
+}
+
+/*!
+  \brief Removes all of the \a geoElements from the quadtree.
+
+  Each element is taken out of the cells it was assigned to, without re-building
+  the tree. \l treeChanged is emitted once.
+ */
+void GeometryQuadtree::removeGeoElements(const QList<GeoElement*>& geoElements)
+{
+  bool changed = false;
+  for (GeoElement* geoElement : geoElements)
+  {
+    const int key = m_elementKeys.value(geoElement, -1);
+    if (key == -1)
+      continue;
+
+    removeElement(key);
+    changed = true;
+  }
+
+  if (!changed)
+    return;
+
+  pruneIfRequired();
+  emit treeChanged();
+}
+
+/*!
+  \brief Returns whether the index is a quadtree or an R-tree.
+ */
+GeometryQuadtree::IndexType GeometryQuadtree::indexType() const
+{
+  return m_indexType;
+}
+
+/*!
+  \brief Replaces the contents of the quadtree with \a geoElements and re-builds it for \a extent.
+
+  Unlike creating a new quadtree, users of this tree keep a valid pointer to it.
+ */
+void GeometryQuadtree::reset(const Envelope& extent, const QList<GeoElement*>& geoElements)
+{
+  m_changeAggregator->clear();
+  m_elementStorage.clear();
+  m_elementKeys.clear();
+  m_wgs84Elements.clear();
+
+  for (const auto& element : geoElements)
+    handleNewGeoElement(element);
+
+  buildTree(extent);
+}
+
 /*!
   \brief Returns the list of \l Geometry objects which are in quadtree cells which intersect \a geometry
 
+  The returned geometries are in WGS84.
+
   \note No intersection test is carried out between the supplied Geometry and the results. For exact results,
   you should perform the desired geometry tests on the list of \l Geometry objects returned.
  */
@@ -132,342 +617,1136 @@ QList<Geometry> GeometryQuadtree::candidateIntersections(const Geometry& geometr
 /*!
   \brief Returns the list of \l Geometry objects which are in quadtree cells which intersect \a extent
 
+  The returned geometries are in WGS84.
+
   \note No intersection test is carried out between the supplied Envelope and the results. For exact results,
   you should perform the desired geometry tests on the list of \l Geometry objects returned.
  */
 QList<Geometry> GeometryQuadtree::candidateIntersections(const Envelope& extent) const
 {
-  // ensure the extent is in WGS84
-  const Envelope wgs84 = GeometryEngine::project(extent, SpatialReference::wgs84());
-
-  // obtain the indices of Geometry objects from quadtree nodes which intersect the extent
-  QSet<int> geomIds = m_tree->intersectingIds(wgs84);
-
-  // collect the Geometry objects with an intersecting Id
   QList<Geometry> results;
-  for(const int id: geomIds)
-  {
-    // attempt to find the element Id in the lookup. If the element has been removed it may not be found
-    auto findIt = m_elementStorage.find(id);
-    if (findIt != m_elementStorage.end())
-    {
-      GeoElementSignaler* element = findIt.value();
-      if (element)
-        results.push_back(element->geoElement()->geometry());
-    }
-  }
-
+  candidateIntersections(extent, results);
   return results;
 }
 
 /*!
   \brief Returns the list of \l Geometry objects which are in quadtree cells which intersect \a location
 
+  The returned geometries are in WGS84.
+
   \note No intersection test is carried out between the supplied point and the results. For exact results,
   you should perform the desired geometry tests on the list of \l Geometry objects returned.
  */
 QList<Geometry> GeometryQuadtree::candidateIntersections(const Point& location) const
+{
+  QList<Geometry> results;
+  candidateIntersections(location, results);
+  return results;
+}
+
+/*!
+  \brief Appends the \l Geometry objects which are in quadtree cells which intersect \a extent
+  to \a results.
+
+  Re-using \a results between queries avoids allocating a new list for each query.
+  If \a extent is already in WGS84 it is not re-projected. The appended geometries are in WGS84.
+
+  \note No intersection test is carried out between the supplied Envelope and the results.
+ */
+void GeometryQuadtree::candidateIntersections(const Envelope& extent, QList<Geometry>& results) const
 {
   // ensure the extent is in WGS84
-  const Point wgs84 = GeometryEngine::project(location, SpatialReference::wgs84());
+  const Envelope wgs84 = toWgs84(extent);
 
-  // obtain the indices of Geometry objects from quadtree nodes which contain the location
-  QSet<int> geomIds = m_tree->intersectingIds(wgs84);
+  gatherQueryIds(wgs84);
+  appendQueryGeometries(results);
+}
 
-  // collect the Geometry objects with an intersecting Id
-  QList<Geometry> results;
-  for(const int id: geomIds)
+/*!
+  \brief Appends the \l Geometry objects which are in quadtree cells which intersect \a location
+  to \a results.
+
+  Re-using \a results between queries avoids allocating a new list for each query.
+  If \a location is already in WGS84 it is not re-projected. The appended geometries are in WGS84.
+
+  \note No intersection test is carried out between the supplied point and the results.
+ */
+void GeometryQuadtree::candidateIntersections(const Point& location, QList<Geometry>& results) const
+{
+  // ensure the location is in WGS84
+  const Point wgs84 = toWgs84(location);
+
+  // obtain the indices of Geometry objects from quadtree nodes which contain the location
+  SpatialTree::Location treeLocation;
+  treeLocation.m_x = wrapLongitude(wgs84.x(), m_longitudeCut);
+  treeLocation.m_y = wgs84.y();
+  m_queryIds.resize(0);
+  m_tree->intersectingIds(treeLocation, m_queryIds);
+
+  // include any elements lying outside of the tree which contain the location
+  for (auto it = m_outsideExtents.cbegin(); it != m_outsideExtents.cend(); ++it)
   {
-    // attempt to find the element Id in the lookup. If the element has been removed it may not be found
-    auto findIt = m_elementStorage.find(id);
-    if (findIt != m_elementStorage.end())
+    const Envelope& outsideExtent = it.value();
+    if (outsideExtent.yMin() <= wgs84.y() && outsideExtent.yMax() >= wgs84.y() &&
+        longitudesIntersect(outsideExtent.xMin(), outsideExtent.xMax(), wgs84.x(), wgs84.x()))
     {
-      GeoElementSignaler* element = findIt.value();
-      if (element)
-        results.push_back(element->geoElement()->geometry());
+      m_queryIds.append(it.key());
     }
   }
 
-  return results;
+  std::sort(m_queryIds.begin(), m_queryIds.end());
+  m_queryIds.erase(std::unique(m_queryIds.begin(), m_queryIds.end()), m_queryIds.end());
+
+  appendQueryGeometries(results);
+}
+
+/*!
+  \brief Returns the list of \l Geometry objects which intersect \a geometry.
+
+  Unlike \l candidateIntersections, the results are exact. The stored WGS84 extent of
+  each candidate is tested against the extent of \a geometry first and the geometry
+  engine is only used for candidates whose extents overlap and which cannot be
+  resolved from their extents alone.
+
+  If \a maximumResults is positive, the query stops once that many results are found.
+  The returned geometries are in WGS84.
+ */
+QList<Geometry> GeometryQuadtree::intersecting(const Geometry& geometry, int maximumResults) const
+{
+  QList<Geometry> results;
+  if (geometry.isEmpty())
+    return results;
+
+  const Geometry wgs84 = toWgs84(geometry);
+  const Envelope queryExtent = wgs84.extent();
+  const bool queryIsEnvelope = wgs84.geometryType() == GeometryType::Envelope;
+  const bool queryIsPoint = wgs84.geometryType() == GeometryType::Point;
+
+  gatherQueryIds(queryExtent);
+
+  for (const int id : m_queryIds)
+  {
+    auto findIt = m_wgs84Elements.constFind(id);
+    if (findIt == m_wgs84Elements.constEnd())
+      continue;
+
+    const Wgs84Element& element = findIt.value();
+    if (!envelopesIntersect(element.m_extent, queryExtent))
+      continue;
+
+    const bool elementIsPoint = element.m_geometry.geometryType() == GeometryType::Point;
+
+    bool matches = false;
+    // a point which passes the envelope test lies within an envelope query
+    // as does any element whose extent is wholly within it
+    if (queryIsEnvelope && (elementIsPoint || envelopeContains(queryExtent, element.m_extent)))
+      matches = true;
+    // a point query intersects a point element which passes the envelope test
+    else if (queryIsPoint && elementIsPoint)
+      matches = true;
+    else
+      matches = GeometryEngine::intersects(wgs84, element.m_geometry);
+
+    if (!matches)
+      continue;
+
+    results.append(element.m_geometry);
+    if (maximumResults > 0 && results.size() >= maximumResults)
+      break;
+  }
+
+  return results;
+}
+
+/*!
+  \brief Returns the list of \l Geometry objects which lie within \a meters of \a location.
+
+  The stored WGS84 extent of each candidate is first tested against a search extent
+  around \a location. Point geometries are then tested with a closed-form great-circle
+  approximation of the geodesic distance, which is accurate to around 0.5%. Other
+  geometries are tested against a geodesic buffer of \a location, which is only
+  created if there is such a candidate.
+
+  If \a maximumResults is positive, the query stops once that many results are found.
+  The returned geometries are in WGS84.
+ */
+QList<Geometry> GeometryQuadtree::withinDistance(const Point& location, double meters, int maximumResults) const
+{
+  QList<Geometry> results;
+  if (location.isEmpty() || meters < 0.0)
+    return results;
+
+  const Point wgs84 = toWgs84(location);
+  const Envelope searchExtent = distanceSearchExtent(wgs84, meters);
+
+  gatherQueryIds(searchExtent);
+
+  Geometry buffer;
+  for (const int id : m_queryIds)
+  {
+    auto findIt = m_wgs84Elements.constFind(id);
+    if (findIt == m_wgs84Elements.constEnd())
+      continue;
+
+    const Wgs84Element& element = findIt.value();
+    if (!envelopesIntersect(element.m_extent, searchExtent))
+      continue;
+
+    if (!isWithinDistance(wgs84, meters, element.m_geometry, element.m_extent, buffer))
+      continue;
+
+    results.append(element.m_geometry);
+    if (maximumResults > 0 && results.size() >= maximumResults)
+      break;
+  }
+
+  return results;
+}
+
+/*!
+  \brief Returns a lower bound, in meters, of the distance from \a location to the nearest
+  element, or \a maximumMeters if no element lies within that distance.
+
+  The distance to a point is its distance on the sphere and the distance to other geometry
+  is bounded using its extent. The result is reduced by the same margin as the distance
+  search extents, so it does not exceed the geodesic distance on the ellipsoid.
+ */
+double GeometryQuadtree::distanceLowerBound(const Point& location, double maximumMeters) const
+{
+  if (location.isEmpty())
+    return 0.0;
+
+  const Point wgs84 = toWgs84(location);
+  gatherQueryIds(distanceSearchExtent(wgs84, maximumMeters));
+
+  double nearest = maximumMeters;
+  for (const int id : m_queryIds)
+  {
+    auto findIt = m_wgs84Elements.constFind(id);
+    if (findIt == m_wgs84Elements.constEnd() || findIt.value().m_extent.isEmpty())
+      continue;
+
+    const Wgs84Element& element = findIt.value();
+    const double meters = element.m_geometry.geometryType() == GeometryType::Point
+                            ? Geodesic::haversineDistance(wgs84.y(), wgs84.x(), element.m_extent.yMin(), element.m_extent.xMin())
+                            : extentDistanceLowerBound(wgs84, element.m_extent);
+    nearest = std::min(nearest, meters / s_searchExtentScale);
+  }
+
+  return nearest;
+}
+
+/*!
+  \brief Returns the fastest speed, in meters per second, at which a point element
+  has recently been seen to move between updates.
+ */
+double GeometryQuadtree::maximumSpeed() const
+{
+  return std::max(m_windowSpeed, m_previousWindowSpeed);
+}
+
+/*!
+  \brief Returns the number of changes to the elements which could not be predicted from
+  \l maximumSpeed.
+
+  This is incremented when a point moves faster than the maximum speed, when an element
+  other than a point changes, when elements are added and when the tree is re-built.
+ */
+int GeometryQuadtree::unpredictableChangeCount() const
+{
+  return m_unpredictableChangeCount;
+}
+
+/*!
+  \brief Returns the list of \l Geometry objects which may lie within \a meters of \a location.
+
+  Only the stored WGS84 extent of each candidate is tested against a search extent
+  around \a location. The candidates can be tested exactly with \l isAnyWithinDistance,
+  which does not use the tree and so can be run on another thread.
+
+  The returned geometries are in WGS84.
+ */
+QList<Geometry> GeometryQuadtree::withinDistanceCandidates(const Point& location, double meters) const
+{
+  QList<Geometry> results;
+  if (location.isEmpty() || meters < 0.0)
+    return results;
+
+  const Envelope searchExtent = distanceSearchExtent(toWgs84(location), meters);
+
+  gatherQueryIds(searchExtent);
+
+  results.reserve(m_queryIds.size());
+  for (const int id : m_queryIds)
+  {
+    auto findIt = m_wgs84Elements.constFind(id);
+    if (findIt == m_wgs84Elements.constEnd())
+      continue;
+
+    const Wgs84Element& element = findIt.value();
+    if (envelopesIntersect(element.m_extent, searchExtent))
+      results.append(element.m_geometry);
+  }
+
+  return results;
+}
+
+/*!
+  \brief Returns the prepared form of each polygon whose extent contains \a location.
+
+  Each polygon is prepared the first time it is returned, and the prepared polygon is
+  kept until the geometry of its element changes or memory is short. Prepared polygons are immutable and
+  are in WGS84, so they can be tested against the WGS84 \a location on any thread.
+
+  \sa PreparedPolygon
+ */
+QList<std::shared_ptr<const PreparedPolygon>> GeometryQuadtree::candidatePolygons(const Point& location) const
+{
+  QList<std::shared_ptr<const PreparedPolygon>> results;
+  if (location.isEmpty())
+    return results;
+
+  const Point wgs84 = toWgs84(location);
+  const Envelope pointExtent = wgs84.extent();
+
+  gatherQueryIds(pointExtent);
+
+  for (const int id : m_queryIds)
+  {
+    auto findIt = m_wgs84Elements.constFind(id);
+    if (findIt == m_wgs84Elements.constEnd())
+      continue;
+
+    const Wgs84Element& element = findIt.value();
+    if (element.m_geometry.geometryType() != GeometryType::Polygon || !envelopesIntersect(element.m_extent, pointExtent))
+      continue;
+
+    if (!element.m_preparedPolygon)
+      element.m_preparedPolygon = std::make_shared<const PreparedPolygon>(geometry_cast<Polygon>(element.m_geometry));
+
+    results.append(element.m_preparedPolygon);
+  }
+
+  return results;
+}
+
+/*!
+  \internal
+
+  Returns the approximate number of bytes used by the prepared polygons.
+ */
+qint64 GeometryQuadtree::preparedPolygonFootprint() const
+{
+  qint64 bytes = 0;
+  for (const Wgs84Element& element : m_wgs84Elements)
+  {
+    if (element.m_preparedPolygon)
+      bytes += element.m_preparedPolygon->memoryUsage();
+  }
+
+  return bytes;
+}
+
+/*!
+  \internal
+
+  Discards the prepared polygons, returning the approximate number of bytes
+  released. Callers still holding a prepared polygon keep it alive.
+ */
+qint64 GeometryQuadtree::releasePreparedPolygons()
+{
+  const qint64 bytes = preparedPolygonFootprint();
+  for (Wgs84Element& element : m_wgs84Elements)
+    element.m_preparedPolygon.reset();
+
+  return bytes;
+}
+
+/*!
+  \brief Returns each element, with its WGS84 geometry, whose extent intersects \a extent.
+
+  Unlike \l candidateIntersections, the \l Esri::ArcGISRuntime::GeoElement the geometry
+  belongs to is also returned, so that the caller can act on the elements which pass an
+  exact test. If \a extent is already in WGS84 it is not re-projected.
+ */
+QList<GeometryQuadtree::GeoElementCandidate> GeometryQuadtree::candidateGeoElements(const Envelope& extent) const
+{
+  QList<GeoElementCandidate> results;
+  candidateGeoElements(extent, results);
+  return results;
+}
+
+/*!
+  \brief Appends each element, with its WGS84 geometry, whose extent intersects \a extent
+  to \a results.
+
+  Re-using \a results between queries avoids allocating a new list for each query.
+  If \a extent is already in WGS84 it is not re-projected.
+ */
+void GeometryQuadtree::candidateGeoElements(const Envelope& extent, QList<GeoElementCandidate>& results) const
+{
+  if (extent.isEmpty())
+    return;
+
+  const Envelope wgs84 = toWgs84(extent);
+  gatherQueryIds(wgs84);
+
+  results.reserve(results.size() + m_queryIds.size());
+  for (const int id : m_queryIds)
+  {
+    auto findIt = m_wgs84Elements.constFind(id);
+    GeoElement* geoElement = m_elementStorage.value(id);
+    if (findIt == m_wgs84Elements.constEnd() || !geoElement || !envelopesIntersect(findIt.value().m_extent, wgs84))
+      continue;
+
+    GeoElementCandidate candidate;
+    candidate.m_geoElement = geoElement;
+    candidate.m_geometry = findIt.value().m_geometry;
+    results.append(candidate);
+  }
+}
+
+/*!
+  \brief Returns whether any of the WGS84 \a candidates lie within \a meters of \a location.
+
+  The candidates are tested in the same way as \l withinDistance. If \a wgs84Buffer is
+  not empty, it is used as the geodesic buffer of \a location rather than creating a new
+  one. This function only uses its arguments, so it is safe to call from any thread.
+
+  \sa withinDistanceCandidates
+ */
+bool GeometryQuadtree::isAnyWithinDistance(const Point& location, double meters, const QList<Geometry>& candidates,
+                                           const Geometry& wgs84Buffer)
+{
+  if (location.isEmpty() || meters < 0.0)
+    return false;
+
+  const Point wgs84 = toWgs84(location);
+
+  // point candidates are gathered into contiguous arrays and tested together by the
+  // distance mask kernel, before any other geometry needs the geodesic buffer
+  std::vector<double> pointLats;
+  std::vector<double> pointLons;
+  pointLats.reserve(candidates.size());
+  pointLons.reserve(candidates.size());
+  for (const Geometry& candidate : candidates)
+  {
+    if (candidate.geometryType() != GeometryType::Point)
+      continue;
+
+    const Point point = geometry_cast<Point>(candidate);
+    pointLats.push_back(point.y());
+    pointLons.push_back(point.x());
+  }
+
+  std::vector<unsigned char> pointMask(pointLats.size());
+  if (Geodesic::withinDistanceMask(wgs84.y(), wgs84.x(), pointLats.data(), pointLons.data(), pointLats.size(), meters, pointMask.data()) > 0)
+    return true;
+
+  if (static_cast<int>(pointLats.size()) == candidates.size())
+    return false;
+
+  Geometry buffer = wgs84Buffer;
+  for (const Geometry& candidate : candidates)
+  {
+    if (candidate.geometryType() == GeometryType::Point)
+      continue;
+
+    if (isWithinDistance(wgs84, meters, candidate, candidate.extent(), buffer))
+      return true;
+  }
+
+  return false;
+}
+
+/*!
+  \internal
+
+  Fills the query buffer with the de-duplicated ids of elements in cells which intersect
+  \a wgs84Extent, along with any elements outside of the tree whose extents intersect it.
+ */
+void GeometryQuadtree::gatherQueryIds(const Envelope& wgs84Extent) const
+{
+  // obtain the indices of Geometry objects from quadtree nodes which intersect the extent,
+  // querying each side of the end of the tree's range of longitude separately
+  SpatialTree::Bounds pieces[2];
+  const int pieceCount = wrapQueryBounds(toBounds(wgs84Extent), m_longitudeCut, pieces);
+  m_queryIds.resize(0);
+  for (int piece = 0; piece < pieceCount; ++piece)
+    m_tree->intersectingIds(pieces[piece], m_queryIds);
+
+  // include any elements lying outside of the tree which intersect the extent
+  for (auto it = m_outsideExtents.cbegin(); it != m_outsideExtents.cend(); ++it)
+  {
+    if (envelopesIntersect(it.value(), wgs84Extent))
+      m_queryIds.append(it.key());
+  }
+
+  // an element spanning several cells appears once for each cell
+  std::sort(m_queryIds.begin(), m_queryIds.end());
+  m_queryIds.erase(std::unique(m_queryIds.begin(), m_queryIds.end()), m_queryIds.end());
+}
+
+/*!
+  \internal
+
+  Appends the cached WGS84 geometry of each element in the query buffer to \a results.
+ */
+void GeometryQuadtree::appendQueryGeometries(QList<Geometry>& results) const
+{
+
+  results.reserve(results.size() + m_queryIds.size());
+  for (const int id : m_queryIds)
+  {
+    // attempt to find the element Id in the lookup. If the element has been removed it may not be found
+    auto findIt = m_wgs84Elements.constFind(id);
+    if (findIt != m_wgs84Elements.constEnd())
+      results.push_back(findIt.value().m_geometry);
+  }
+}
+
+/*!
+  \internal
+ */
+void GeometryQuadtree::buildTree(const Envelope& extent)
+{
+  DSA_TRACE_SCOPE("GeometryQuadtree::buildTree");
+  PerformanceMonitor::recordQuadtreeRebuild();
+
+  // project any elements which are not yet cached
+  cacheWgs84Elements();
+
+  // gather the extent of each element
+  QVector<SpatialTree::Bounds> bounds;
+  bounds.reserve(m_elementStorage.size());
+  auto it = m_elementStorage.cbegin();
+  auto itEnd = m_elementStorage.cend();
+  for (; it != itEnd; ++it)
+  {
+    if (!it.value())
+      continue;
+
+    const Envelope& wgs84Extent = wgs84Element(it.key()).m_extent;
+    if (!wgs84Extent.isEmpty())
+      bounds.append(toBounds(wgs84Extent, it.key()));
+  }
+
+  // choose the range of longitude for the tree so that it does not divide elements
+  // which straddle the antimeridian, and move the elements into that range
+  const double cut = longitudeCut(bounds);
+  for (SpatialTree::Bounds& elementBounds : bounds)
+    elementBounds = wrapBounds(elementBounds, cut);
+
+  std::unique_ptr<SpatialTree> tree;
+  if (m_indexType == IndexType::RTree)
+  {
+    tree.reset(new RTree());
+  }
+  else
+  {
+    // ensure the tree's extent is in WGS84, or cover the elements if their longitudes were moved
+    const Envelope extentWgs84 = toWgs84(extent);
+    SpatialTree::Bounds rootBounds = toBounds(extentWgs84);
+    if (cut != -180.0)
+    {
+      bool first = true;
+      for (const SpatialTree::Bounds& elementBounds : bounds)
+      {
+        if (elementBounds.m_xMax - elementBounds.m_xMin >= 360.0)
+          continue;
+
+        if (first)
+          rootBounds = elementBounds;
+
+        rootBounds.m_xMin = std::min(rootBounds.m_xMin, elementBounds.m_xMin);
+        rootBounds.m_xMax = std::max(rootBounds.m_xMax, elementBounds.m_xMax);
+        rootBounds.m_yMin = std::min(rootBounds.m_yMin, elementBounds.m_yMin);
+        rootBounds.m_yMax = std::max(rootBounds.m_yMax, elementBounds.m_yMax);
+        first = false;
+      }
+    }
+
+    tree.reset(new QuadTree(rootBounds.m_xMin, rootBounds.m_xMax, rootBounds.m_yMin, rootBounds.m_yMax));
+  }
+
+  // record the elements which are not wholly within the tree
+  QHash<int, Envelope> outsideExtents;
+  for (const SpatialTree::Bounds& elementBounds : bounds)
+  {
+    if (!tree->contains(elementBounds))
+      outsideExtents.insert(elementBounds.m_id, wgs84Element(elementBounds.m_id).m_extent);
+  }
+
+  // the bulk loaded tree contains no empty nodes, so it does not need to be pruned
+  tree->bulkLoad(bounds, m_maxLevels);
+
+  m_tree = std::move(tree);
+  m_longitudeCut = cut;
+  m_outsideExtents.swap(outsideExtents);
+  m_pendingPruneCount = 0;
+  ++m_unpredictableChangeCount;
+
+  emit treeChanged();
+}
+
+/*!
+  \internal
+ */
+void GeometryQuadtree::handleGeometryChange(int changedId)
+{
+  handleGeometryChanges(QVector<int>{changedId});
+}
+
+/*!
+  \internal
+
+  Moves each of the elements with \a changedKeys to the cells for its new geometry. The
+  tree is checked for a rebuild and \l treeChanged is emitted once for the whole batch.
+ */
+void GeometryQuadtree::handleGeometryChanges(const QVector<int>& changedKeys)
+{
+  bool changed = false;
+  for (const int changedId : changedKeys)
+  {
+    if (!m_elementStorage.value(changedId))
+      continue;
+
+    // refresh the cached WGS84 geometry and move the element from its old cells to its new cells
+    const Wgs84Element previous = m_wgs84Elements.take(changedId);
+    m_tree->removeId(changedId);
+    m_outsideExtents.remove(changedId);
+    const Wgs84Element& current = wgs84Element(changedId);
+    assignElement(changedId, current.m_extent);
+    recordElementMove(previous, current);
+    changed = true;
+  }
+
+  if (!changed)
+    return;
+
+  // if too many elements now lie outside of the tree, calculate the new extent and rebuild it
+  if (isRebuildRequired())
+  {
+    rebuildForAllElements();
+    return;
+  }
+
+  pruneIfRequired();
+  emit treeChanged();
+}
+
+/*!
+  \internal
+
+  Removes the element with \a key from the tree and from the storage.
+ */
+void GeometryQuadtree::removeElement(int key)
+{
+  GeoElement* geoElement = m_elementStorage.take(key);
+  if (geoElement)
+    m_elementKeys.remove(geoElement);
+
+  m_changeAggregator->unwatch(key);
+
+  m_tree->removeId(key);
+  m_outsideExtents.remove(key);
+  m_wgs84Elements.remove(key);
+}
+
+/*!
+  \internal
+
+  Returns the cached WGS84 geometry and extent of the element with \a key,
+  projecting and caching them if they are not yet known.
+ */
+const GeometryQuadtree::Wgs84Element& GeometryQuadtree::wgs84Element(int key)
+{
+  auto findIt = m_wgs84Elements.find(key);
+  if (findIt != m_wgs84Elements.end())
+    return findIt.value();
+
+  Wgs84Element wgs84;
+  GeoElement* geoElement = m_elementStorage.value(key);
+  if (geoElement)
+  {
+    wgs84.m_geometry = toWgs84(geoElement->geometry());
+    wgs84.m_extent = wgs84.m_geometry.extent();
+  }
+
+  // a zero update time means that the element has not been seen
+  wgs84.m_updateTime = m_clock.elapsed() + 1;
+  return m_wgs84Elements.insert(key, wgs84).value();
+}
+
+/*!
+  \internal
+
+  Records the movement of an element from its \a previous to its \a current WGS84 geometry.
+
+  The speed of a point which has been seen before is included in \l maximumSpeed. If it
+  is faster than the maximum speed, or the element is not a point or is new, the change
+  could not have been predicted and \l unpredictableChangeCount is incremented.
+ */
+void GeometryQuadtree::recordElementMove(const Wgs84Element& previous, const Wgs84Element& current)
+{
+  if (previous.m_updateTime == 0 ||
+      previous.m_geometry.geometryType() != GeometryType::Point ||
+      current.m_geometry.geometryType() != GeometryType::Point)
+  {
+    ++m_unpredictableChangeCount;
+    return;
+  }
+
+  // start a new window, keeping the speed from the last one if it has only just ended
+  const qint64 now = current.m_updateTime;
+  if (now - m_speedWindowStart >= s_speedWindowMsecs)
+  {
+    m_previousWindowSpeed = (now - m_speedWindowStart < 2 * s_speedWindowMsecs) ? m_windowSpeed : 0.0;
+    m_windowSpeed = 0.0;
+    m_speedWindowStart = now;
+  }
+
+  // the extent of a point is the point itself
+  const double meters = Geodesic::haversineDistance(previous.m_extent.yMin(), previous.m_extent.xMin(),
+                                                    current.m_extent.yMin(), current.m_extent.xMin());
+  const double seconds = std::max<qint64>(1, now - previous.m_updateTime) / 1000.0;
+  const double speed = meters / seconds;
+  if (speed > maximumSpeed())
+    ++m_unpredictableChangeCount;
+
+  m_windowSpeed = std::max(m_windowSpeed, speed);
+}
+
+/*!
+  \internal
+
+  Projects the geometry of every element which is not yet in the WGS84 cache,
+  splitting the elements into chunks which are projected in parallel on the global
+  thread pool. The geometries are read from the elements on the calling thread and
+  the results are added to the cache on the calling thread; the workers only project
+  the geometries and calculate their extents.
+ */
+void GeometryQuadtree::cacheWgs84Elements()
+{
+  QVector<int> keys;
+  QVector<Wgs84Element> projected;
+  for (auto it = m_elementStorage.cbegin(); it != m_elementStorage.cend(); ++it)
+  {
+    GeoElement* geoElement = it.value();
+    if (!geoElement || m_wgs84Elements.contains(it.key()))
+      continue;
+
+    Wgs84Element wgs84;
+    wgs84.m_geometry = geoElement->geometry();
+    keys.append(it.key());
+    projected.append(wgs84);
+  }
+
+  if (projected.isEmpty())
+    return;
+
+  auto projectRange = [&projected](int begin, int end)
+  {
+    for (int i = begin; i < end; ++i)
+    {
+      Wgs84Element& wgs84 = projected[i];
+      wgs84.m_geometry = toWgs84(wgs84.m_geometry);
+      wgs84.m_extent = wgs84.m_geometry.extent();
+    }
+  };
+
+  QThreadPool* threadPool = QThreadPool::globalInstance();
+  const int chunkCount = std::max(1, std::min(threadPool->maxThreadCount(), projected.size() / s_minimumProjectionChunkSize));
+  const int chunkSize = (projected.size() + chunkCount - 1) / chunkCount;
+
+  // each worker writes only to its own range of the results
+  QSemaphore finishedChunks;
+  for (int chunk = 1; chunk < chunkCount; ++chunk)
+  {
+    const int begin = chunk * chunkSize;
+    const int end = std::min(projected.size(), begin + chunkSize);
+    threadPool->start([&projectRange, &finishedChunks, begin, end]()
+    {
+      projectRange(begin, end);
+      finishedChunks.release();
+    });
+  }
+
+  projectRange(0, std::min(projected.size(), chunkSize));
+  finishedChunks.acquire(chunkCount - 1);
+
+  for (int i = 0; i < keys.size(); ++i)
+  {
+    projected[i].m_updateTime = m_clock.elapsed() + 1;
+    m_wgs84Elements.insert(keys.at(i), projected.at(i));
+  }
+}
+
+/*!
+  \internal
+
+  Assigns the element with \a key and the given \a wgs84Extent to the tree.
+
+  Elements which are not wholly within the extent of the tree are also recorded
+  as outside elements, so that they can be returned by queries beyond the tree.
+  Returns \c false if the element lies outside of the tree.
+ */
+bool GeometryQuadtree::assignElement(int key, const Envelope& wgs84Extent)
+{
+  if (wgs84Extent.isEmpty())
+    return true;
+
+  const SpatialTree::Bounds bounds = wrapBounds(toBounds(wgs84Extent, key), m_longitudeCut);
+  m_tree->assign(bounds, m_maxLevels);
+
+  if (m_tree->contains(bounds))
+    return true;
+
+  m_outsideExtents.insert(key, wgs84Extent);
+  return false;
+}
+
+/*!
+  \internal
+
+  Returns \c true if a significant proportion of the elements lie outside of the tree.
+ */
+bool GeometryQuadtree::isRebuildRequired() const
+{
+  const int outsideCount = m_outsideExtents.size();
+  return outsideCount > s_minimumOutsideElements &&
+         outsideCount > (m_elementStorage.size() / 8);
+}
+
+/*!
+  \internal
+
+  Prunes empty nodes from the tree once enough incremental changes have been made.
+  Empty nodes do not affect the results of queries, so this work can be deferred.
+ */
+void GeometryQuadtree::pruneIfRequired()
+{
+  if (++m_pendingPruneCount < s_pruneInterval)
+    return;
+
+  m_tree->prune();
+  m_pendingPruneCount = 0;
+}
+
+/*!
+  \internal
+
+  Calculates the extent of all elements and rebuilds the tree.
+ */
+void GeometryQuadtree::rebuildForAllElements()
+{
+  QList<Geometry> allGeom;
+  for(auto it = m_elementStorage.begin(); it != m_elementStorage.end(); ++it)
+  {
+    if (!it.value())
+      continue;
+
+    const Geometry& wgs84Geom = wgs84Element(it.key()).m_geometry;
+    if (wgs84Geom.isEmpty())
+      continue;
+
+    allGeom.append(wgs84Geom);
+  }
+
+  const Geometry newExtent = GeometryEngine::combineExtents(allGeom);
+  buildTree(newExtent);
+}
+
+/*!
+  \internal
+
+  Attempts to add the new \a geoElement into the storage QHash and connects to changes.
+
+  Returns the key in the storage or \c -1 if unsuccesful.
+ */
+int GeometryQuadtree::handleNewGeoElement(GeoElement* geoElement)
+{
+  if (!geoElement)
+    return -1;
+
+  // the element is already in the tree
+  const auto existingIt = m_elementKeys.constFind(geoElement);
+  if (existingIt != m_elementKeys.constEnd())
+    return existingIt.value();
+
+  if (!GeoElementUtils::toQObject(geoElement))
+    return -1;
+
+  const int insertedKey = m_nextKey;
+  m_nextKey++;
+
+  m_elementStorage.insert(insertedKey, geoElement);
+  m_elementKeys.insert(geoElement, insertedKey);
+  m_changeAggregator->watch(geoElement, insertedKey);
+
+  return insertedKey;
 }
 
 /*!
   \internal
+
+  Removes the element with \a key, which is being destroyed, from the tree.
  */
-void GeometryQuadtree::buildTree(const Envelope& extent)
+void GeometryQuadtree::handleElementDestroyed(int key)
 {
-  // ensure the tree's extent is in WGS84
-  const Envelope extentWgs84 = GeometryEngine::project(extent, SpatialReference::wgs84());
-
-  // build the (currently empty) tree to the desired depth
-  m_tree.reset(new QuadTree(0, extentWgs84.xMin(), extentWgs84.xMax(), extentWgs84.yMin(), extentWgs84.yMax()));
-
-  // assign the geometry of each element to the tree, along with its id in the lookup
-  auto it = m_elementStorage.cbegin();
-  auto itEnd = m_elementStorage.cend();
-  for (; it != itEnd; ++it)
-  {
-    GeoElementSignaler* element = it.value();
-    if (!element)
-      continue;
-
-    const Geometry wgs84 = GeometryEngine::project(element->geoElement()->geometry(), SpatialReference::wgs84());
-    m_tree->assign(wgs84.extent(), it.key(), m_maxLevels);
-  }
-
-  // remove any nodes from the tree which contain no geometry
-  m_tree->prune();
+  // the element is being destroyed so only use the stored element pointer as a key
+  GeoElement* geoElement = m_elementStorage.take(key);
+  if (!geoElement)
+    return;
 
+  m_elementKeys.remove(geoElement);
+  m_tree->removeId(key);
+  m_outsideExtents.remove(key);
+  m_wgs84Elements.remove(key);
+  pruneIfRequired();
   emit treeChanged();
 }
 
 /*!
   \internal
  */
-void GeometryQuadtree::handleGeometryChange(int changedId)
+GeometryQuadtree::QuadTree::QuadTree(double xMin, double xMax, double yMin, double yMax)
 {
-  const GeoElementSignaler* changedElement = m_elementStorage.value(changedId);
-  if (!changedElement)
-    return;
-
-  const Geometry wgs84Geom = GeometryEngine::project(changedElement->geoElement()->geometry(), SpatialReference::wgs84());
-  const Envelope wgs84Extent = wgs84Geom.extent();
-
-  // if the extent of the changed geom is the same or smaller than the existing tree, it can still be used
-  if (m_tree->m_xMin <= wgs84Extent.xMin() &&
-      m_tree->m_xMax >= wgs84Extent.xMax() &&
-      m_tree->m_yMin <= wgs84Extent.yMin() &&
-      m_tree->m_yMax >= wgs84Extent.yMax())
-  {
-    m_tree->removeId(changedId);
-    m_tree->assign(wgs84Geom.extent(), changedId, m_maxLevels);
-    m_tree->prune();
-    emit treeChanged();
-  }
-  // otherwise calculate the new extent and rebuild the tree
-  else
-  {
-    QList<Geometry> allGeom;
-    for(auto it = m_elementStorage.begin(); it != m_elementStorage.end(); ++it)
-    {
-      GeoElementSignaler* element = it.value();
-      if (!element)
-        continue;
-
-      if (element->geoElement()->geometry().isEmpty())
-        continue;
-
-      allGeom.append(GeometryEngine::project(element->geoElement()->geometry(), SpatialReference::wgs84()));
-    }
+  Node root;
+  root.m_xMin = xMin;
+  root.m_xMax = xMax;
+  root.m_yMin = yMin;
+  root.m_yMax = yMax;
+  m_nodes.append(root);
+}
 
-    const Geometry newExtent = GeometryEngine::combineExtents(allGeom);
-    buildTree(newExtent);
-  }
+/*!
+  \internal
+ */
+void GeometryQuadtree::QuadTree::assign(const Bounds& bounds, int maxLevels)
+{
+  if (assign(0, bounds, maxLevels))
+    m_elementBounds.insert(bounds.m_id, bounds);
 }
 
 /*!
   \internal
 
-  Attempts to add the new \a geoElement into the storage QHash and connects to changes.
+  Loads the elements with the given \a bounds into this empty tree, splitting cells
+  which hold too many elements, down to \a maxLevels.
 
-  Returns the key in the storage or \c -1 if unsuccesful.
+  For large sets of elements, each quadrant of the root is built as a separate tree
+  on the global thread pool and then appended to this tree.
  */
-int GeometryQuadtree::handleNewGeoElement(GeoElement* geoElement)
+void GeometryQuadtree::QuadTree::bulkLoad(const QVector<Bounds>& bounds, int maxLevels)
 {
-  if (!geoElement)
-    return -1;
+  const Node root = m_nodes.at(0);
+  QVector<Bounds> rootBounds;
+  rootBounds.reserve(bounds.size());
+  m_elementBounds.reserve(bounds.size());
+  for (const Bounds& elementBounds : bounds)
+  {
+    if (!root.intersects(elementBounds))
+      continue;
 
-  GeoElementSignaler* signaler = new GeoElementSignaler(geoElement, GeoElementUtils::toQObject(geoElement));
+    rootBounds.append(elementBounds);
+    m_elementBounds.insert(elementBounds.m_id, elementBounds);
+  }
 
-  m_elementStorage.insert(m_nextKey, signaler);
-  const int insertedKey = m_nextKey;
-  m_nextKey++;
+  if (rootBounds.size() < s_minimumParallelBulkLoad || !isSplitRequired(root, rootBounds, maxLevels))
+  {
+    bulkLoad(0, rootBounds, maxLevels);
+    return;
+  }
 
-  connect(signaler, &GeoElementSignaler::geometryChanged, this, [this, signaler]()
+  QVector<int>& rootIds = m_nodes[0].m_geometryIds;
+  rootIds.reserve(rootBounds.size());
+  for (const Bounds& elementBounds : rootBounds)
+    rootIds.append(elementBounds.m_id);
+
+  std::unique_ptr<QuadTree> subtrees[4];
+  for (int quadrant = 0; quadrant < 4; ++quadrant)
   {
-    auto it = m_elementStorage.cbegin();
-    auto itEnd = m_elementStorage.cend();
-    for (; it != itEnd; ++it)
-    {
-      GeoElementSignaler* testElement = it.value();
-      if (!testElement)
-        continue;
+    const Node childNode = root.childNode(quadrant);
+    subtrees[quadrant].reset(new QuadTree(childNode.m_xMin, childNode.m_xMax, childNode.m_yMin, childNode.m_yMax));
+    subtrees[quadrant]->m_nodes[0].m_level = childNode.m_level;
+  }
 
-      if (testElement == signaler)
-      {
-        handleGeometryChange(it.key());
-        return;
-      }
+  // each worker reads the shared bounds and writes only to its own subtree
+  auto loadSubtree = [&rootBounds, &subtrees, maxLevels](int quadrant)
+  {
+    QuadTree* subtree = subtrees[quadrant].get();
+    const Node& subtreeRoot = subtree->m_nodes.at(0);
+    QVector<Bounds> subtreeBounds;
+    for (const Bounds& elementBounds : rootBounds)
+    {
+      if (subtreeRoot.intersects(elementBounds))
+        subtreeBounds.append(elementBounds);
     }
-  });
 
-  connect(signaler, &GeoElementSignaler::destroyed, this, [this, signaler]()
+    if (!subtreeBounds.isEmpty())
+      subtree->bulkLoad(0, subtreeBounds, maxLevels);
+  };
+
+  QSemaphore finishedSubtrees;
+  for (int quadrant = 1; quadrant < 4; ++quadrant)
   {
-    auto it = m_elementStorage.cbegin();
-    auto itEnd = m_elementStorage.cend();
-    for (; it != itEnd; ++it)
+    QThreadPool::globalInstance()->start([&loadSubtree, &finishedSubtrees, quadrant]()
     {
-      GeoElementSignaler* testElement = it.value();
-      if (!testElement)
-        continue;
+      loadSubtree(quadrant);
+      finishedSubtrees.release();
+    });
+  }
 
-      if (testElement == signaler)
-      {
-        m_tree->removeId(it.key());
-        m_tree->prune();
-        m_elementStorage.remove(it.key());
-        emit treeChanged();
-        return;
-      }
-    }
-  });
+  loadSubtree(0);
+  finishedSubtrees.acquire(3);
 
-  return insertedKey;
+  for (int quadrant = 0; quadrant < 4; ++quadrant)
+  {
+    if (!subtrees[quadrant]->m_nodes.at(0).m_geometryIds.isEmpty())
+      appendSubtree(0, quadrant, *subtrees[quadrant]);
+  }
 }
 
 /*!
   \internal
  */
-GeometryQuadtree::QuadTree::QuadTree(int level, double xMin, double xMax, double yMin, double yMax):
-  m_level(level),
-  m_xMin(xMin),
-  m_xMax(xMax),
-  m_yMin(yMin),
-  m_yMax(yMax)
+void GeometryQuadtree::QuadTree::prune()
 {
+  prune(0);
 }
 
 /*!
   \internal
  */
-GeometryQuadtree::QuadTree::~QuadTree()
+void GeometryQuadtree::QuadTree::removeId(int geomId)
 {
-  if (m_tl)
-    delete m_tl;
-
-  if (m_tr)
-    delete m_tr;
-
-  if (m_bl)
-    delete m_bl;
+  if (m_elementBounds.remove(geomId) == 0)
+    return;
 
-  if (m_br)
-    delete m_br;
+  removeId(0, geomId);
 }
 
-GeometryQuadtree::QuadTree* GeometryQuadtree::QuadTree::createTopLeft(int maxLevels)
+/*!
+  \internal
+ */
+void GeometryQuadtree::QuadTree::intersectingIds(const Bounds& query, QVector<int>& results) const
 {
-  // if we have not reached the max depth of the tree, add the child nodes
-  if (m_level > maxLevels)
-    return nullptr;
-
-  const double xMid = ((m_xMax - m_xMin) * 0.5) + m_xMin;
-  const double yMid = ((m_yMax - m_yMin) * 0.5) + m_yMin;
-
-  return new QuadTree(m_level +1, m_xMin, xMid, yMid, m_yMax);
+  intersectingIds(0, query, results);
 }
 
-GeometryQuadtree::QuadTree* GeometryQuadtree::QuadTree::createTopRight(int maxLevels)
+/*!
+  \internal
+ */
+void GeometryQuadtree::QuadTree::intersectingIds(const Location& location, QVector<int>& results) const
 {
-  // if we have not reached the max depth of the tree, add the child nodes
-  if (m_level > maxLevels)
-    return nullptr;
-
-  const double xMid = ((m_xMax - m_xMin) * 0.5) + m_xMin;
-  const double yMid = ((m_yMax - m_yMin) * 0.5) + m_yMin;
-
-  return new QuadTree(m_level + 1, xMid, m_xMax, yMid, m_yMax);
+  intersectingIds(0, location, results);
 }
 
-GeometryQuadtree::QuadTree* GeometryQuadtree::QuadTree::createBottomLeft(int maxLevels)
+/*!
+  \internal
+ */
+bool GeometryQuadtree::QuadTree::contains(const Bounds& bounds) const
 {
-  // if we have not reached the max depth of the tree, add the child nodes
-  if (m_level > maxLevels)
-    return nullptr;
+  const Node& root = m_nodes.at(0);
+  return (bounds.m_xMin >= root.m_xMin &&
+          bounds.m_xMax <= root.m_xMax &&
+          bounds.m_yMin >= root.m_yMin &&
+          bounds.m_yMax <= root.m_yMax);
+}
 
-  const double xMid = ((m_xMax - m_xMin) * 0.5) + m_xMin;
-  const double yMid = ((m_yMax - m_yMin) * 0.5) + m_yMin;
+/*!
+  \internal
+
+  Adds \a node to the node array, re-using a released slot if there is one.
+  Returns the index of the node.
+ */
+int GeometryQuadtree::QuadTree::createNode(const Node& node)
+{
+  if (!m_freeNodes.isEmpty())
+  {
+    const int nodeIndex = m_freeNodes.takeLast();
+    m_nodes[nodeIndex] = node;
+    return nodeIndex;
+  }
 
-  return new QuadTree(m_level + 1, m_xMin, xMid, m_yMin, yMid);
+  m_nodes.append(node);
+  return m_nodes.size() - 1;
 }
 
-GeometryQuadtree::QuadTree* GeometryQuadtree::QuadTree::createBottomRight(int maxLevels)
+/*!
+  \internal
+
+  Releases the node at \a nodeIndex, and all of its children, for re-use.
+ */
+void GeometryQuadtree::QuadTree::releaseNode(int nodeIndex)
 {
-  // if we have not reached the max depth of the tree, add the child nodes
-  if (m_level > maxLevels)
-    return nullptr;
+  Node& node = m_nodes[nodeIndex];
+  for (int& child : node.m_children)
+  {
+    if (child == -1)
+      continue;
 
-  const double xMid = ((m_xMax - m_xMin) * 0.5) + m_xMin;
-  const double yMid = ((m_yMax - m_yMin) * 0.5) + m_yMin;
+    releaseNode(child);
+    child = -1;
+  }
 
-  return new QuadTree(m_level + 1, xMid, m_xMax, m_yMin, yMid);
+  node.m_geometryIds.clear();
+  m_freeNodes.append(nodeIndex);
 }
 
 /*!
   \internal
+
+  Assigns the element with \a bounds to the node at \a nodeIndex and its children.
+  A leaf node which then holds too many elements is split.
  */
-bool GeometryQuadtree::QuadTree::assign(const Envelope& extent, int geomIndex, int maxLevels)
+bool GeometryQuadtree::QuadTree::assign(int nodeIndex, const Bounds& bounds, int maxLevels)
 {
   // if the extent of the incoming geometry does not lie within this node, return
-  if (!intersects(extent))
+  if (!m_nodes.at(nodeIndex).intersects(bounds))
     return false;
 
   // record this geometry index
-  m_geometryIds.insert(geomIndex);
+  m_nodes[nodeIndex].m_geometryIds.append(bounds.m_id);
 
-  // (recursively) attempt to assign the geomeytry to each child node
-  // if the node already exists, just assign
-  if (m_tl)
+  if (m_nodes.at(nodeIndex).isLeaf())
   {
-    m_tl->assign(extent, geomIndex, maxLevels);
-  }
-  // otherwise, create a temporary node and only keep it if it will contain this geometry
-  else
-  {
-    QuadTree* temp = createTopLeft(maxLevels);
-    if (temp && temp->assign(extent, geomIndex, maxLevels))
-      m_tl = temp;
-    else
-      delete temp;
-  }
+    if (m_nodes.at(nodeIndex).m_geometryIds.size() <= s_maxCellElements)
+      return true;
 
-  if (m_tr)
-  {
-    m_tr->assign(extent, geomIndex, maxLevels);
-  }
-  else
-  {
-    QuadTree* temp = createTopRight(maxLevels);
-    if (temp && temp->assign(extent, geomIndex, maxLevels))
-      m_tr = temp;
-    else
-      delete temp;
-  }
+    // the element is not yet in the bounds lookup, so it is added separately
+    QVector<Bounds> nodeBounds;
+    nodeBounds.reserve(m_nodes.at(nodeIndex).m_geometryIds.size());
+    for (const int geometryId : m_nodes.at(nodeIndex).m_geometryIds)
+      nodeBounds.append(geometryId == bounds.m_id ? bounds : m_elementBounds.value(geometryId));
 
-  if (m_bl)
-  {
-    m_bl->assign(extent, geomIndex, maxLevels);
-  }
-  else
-  {
-    QuadTree* temp = createBottomLeft(maxLevels);
-    if (temp && temp->assign(extent, geomIndex, maxLevels))
-      m_bl = temp;
-    else
-      delete temp;
-  }
+    if (isSplitRequired(m_nodes.at(nodeIndex), nodeBounds, maxLevels))
+      split(nodeIndex, nodeBounds, maxLevels);
 
-  if (m_br)
-  {
-    m_br->assign(extent, geomIndex, maxLevels);
+    return true;
   }
-  else
+
+  // (recursively) attempt to assign the geometry to each child node
+  for (int quadrant = 0; quadrant < 4; ++quadrant)
   {
-    QuadTree* temp = createBottomRight(maxLevels);
-    if (temp && temp->assign(extent, geomIndex, maxLevels))
-      m_br = temp;
-    else
-      delete temp;
+    // if the node already exists, just assign
+    const int child = m_nodes.at(nodeIndex).m_children[quadrant];
+    if (child != -1)
+    {
+      assign(child, bounds, maxLevels);
+      continue;
+    }
+
+    // otherwise, only create the node if it will contain this geometry
+    const Node childNode = m_nodes.at(nodeIndex).childNode(quadrant);
+    if (!childNode.intersects(bounds))
+      continue;
+
+    // creating the node may re-allocate the node array, so do not hold references across this call
+    const int newChild = createNode(childNode);
+    m_nodes[nodeIndex].m_children[quadrant] = newChild;
+    assign(newChild, bounds, maxLevels);
   }
 
   return true;
@@ -475,61 +1754,153 @@ bool GeometryQuadtree::QuadTree::assign(const Envelope& extent, int geomIndex, i
 
 /*!
   \internal
+
+  Records the elements with \a bounds, which all intersect the node at \a nodeIndex,
+  and splits the node if it holds too many of them.
  */
-void GeometryQuadtree::QuadTree::prune()
+void GeometryQuadtree::QuadTree::bulkLoad(int nodeIndex, const QVector<Bounds>& bounds, int maxLevels)
 {
-  // for each existing child node remove the node (and any children if they are empty)
-  if (m_tl)
+  QVector<int>& geometryIds = m_nodes[nodeIndex].m_geometryIds;
+  geometryIds.reserve(bounds.size());
+  for (const Bounds& elementBounds : bounds)
+    geometryIds.append(elementBounds.m_id);
+
+  if (isSplitRequired(m_nodes.at(nodeIndex), bounds, maxLevels))
+    split(nodeIndex, bounds, maxLevels);
+}
+
+/*!
+  \internal
+
+  Partitions the elements with \a bounds, which are already recorded in the leaf node
+  at \a nodeIndex, between the quadrants of the node. A child node is only created
+  for a quadrant which contains at least one element.
+ */
+void GeometryQuadtree::QuadTree::split(int nodeIndex, const QVector<Bounds>& bounds, int maxLevels)
+{
+  QVector<Bounds> childBounds;
+  for (int quadrant = 0; quadrant < 4; ++quadrant)
   {
-    // remove the node (and all of it's children) if it is empty
-    if (m_tl->m_geometryIds.empty())
-    {
-      delete m_tl;
-      m_tl = nullptr;
-    }
-    // (recursively) call prune on the child
-    else
+    const Node childNode = m_nodes.at(nodeIndex).childNode(quadrant);
+    childBounds.clear();
+    for (const Bounds& elementBounds : bounds)
     {
-      m_tl->prune();
+      if (childNode.intersects(elementBounds))
+        childBounds.append(elementBounds);
     }
+
+    if (childBounds.isEmpty())
+      continue;
+
+    // creating the node may re-allocate the node array, so do not hold references across this call
+    const int newChild = createNode(childNode);
+    m_nodes[nodeIndex].m_children[quadrant] = newChild;
+    bulkLoad(newChild, childBounds, maxLevels);
+  }
+}
+
+/*!
+  \internal
+
+  Returns whether the \a node, which holds the elements with \a bounds, should be
+  split into quadrants. Nodes at \a maxLevels are never split, and elements which
+  cover the whole node would be recorded in every quadrant, so they are not counted.
+ */
+bool GeometryQuadtree::QuadTree::isSplitRequired(const Node& node, const QVector<Bounds>& bounds, int maxLevels)
+{
+  if (node.m_level > maxLevels || bounds.size() <= s_maxCellElements)
+    return false;
+
+  int separableCount = 0;
+  for (const Bounds& elementBounds : bounds)
+  {
+    if (!node.isCoveredBy(elementBounds) && ++separableCount > s_maxCellElements)
+      return true;
   }
 
-  if (m_tr)
+  return false;
+}
+
+/*!
+  \internal
+
+  Appends the nodes of \a subtree to this tree as the child in \a quadrant of the
+  node at \a nodeIndex. The root of the subtree must cover that quadrant.
+ */
+void GeometryQuadtree::QuadTree::appendSubtree(int nodeIndex, int quadrant, const QuadTree& subtree)
+{
+  const int offset = m_nodes.size();
+  m_nodes.reserve(offset + subtree.m_nodes.size());
+  for (Node node : subtree.m_nodes)
   {
-    if (m_tr->m_geometryIds.empty())
+    for (int& child : node.m_children)
     {
-      delete m_tr;
-      m_tr = nullptr;
-    }
-    else
-    {
-      m_tr->prune();
+      if (child != -1)
+        child += offset;
     }
+
+    m_nodes.append(node);
   }
 
-  if (m_bl)
+  m_nodes[nodeIndex].m_children[quadrant] = offset;
+}
+
+/*!
+  \internal
+ */
+void GeometryQuadtree::QuadTree::prune(int nodeIndex)
+{
+  // for each existing child node remove the node (and any children if they are empty)
+  for (int quadrant = 0; quadrant < 4; ++quadrant)
   {
-    if (m_bl->m_geometryIds.empty())
+    const int child = m_nodes.at(nodeIndex).m_children[quadrant];
+    if (child == -1)
+      continue;
+
+    // remove the node (and all of it's children) if it is empty
+    if (m_nodes.at(child).m_geometryIds.isEmpty())
     {
-      delete m_bl;
-      m_bl = nullptr;
+      releaseNode(child);
+      m_nodes[nodeIndex].m_children[quadrant] = -1;
     }
+    // (recursively) call prune on the child
     else
     {
-      m_bl->prune();
+      prune(child);
     }
   }
+}
+
+/*!
+  \internal
+ */
+void GeometryQuadtree::QuadTree::removeId(int nodeIndex, int geomId)
+{
+  QVector<int>& geometryIds = m_nodes[nodeIndex].m_geometryIds;
+  const int position = geometryIds.indexOf(geomId);
+  if (position == -1)
+    return;
 
-  if (m_br)
+  // the order of ids within a cell is not significant
+  geometryIds[position] = geometryIds.last();
+  geometryIds.removeLast();
+
+  // a node holds the ids of all of its children, so once it holds few enough
+  // elements the children are merged back into it
+  const bool merge = geometryIds.size() <= s_mergeCellElements;
+  for (int& child : m_nodes[nodeIndex].m_children)
   {
-    if (m_br->m_geometryIds.empty())
+    if (child == -1)
+      continue;
+
+    if (merge)
     {
-      delete m_br;
-      m_br = nullptr;
+      releaseNode(child);
+      child = -1;
     }
     else
     {
-      m_br->prune();
+      removeId(child, geomId);
     }
   }
 }
@@ -537,122 +1908,167 @@ void GeometryQuadtree::QuadTree::prune()
 /*!
   \internal
  */
-QSet<int> GeometryQuadtree::QuadTree::intersectingIds(const Envelope& extent) const
+template <typename T>
+void GeometryQuadtree::QuadTree::intersectingIds(int nodeIndex, const T& query, QVector<int>& results) const
 {
+  const Node& node = m_nodes.at(nodeIndex);
+
   // if this node contains no geometry indices there is no intersection
-  if (m_geometryIds.empty())
-    return QSet<int>();
+  if (node.m_geometryIds.isEmpty())
+    return;
 
-  // if this node does not intersect with the supplied extent, there is no intersection
-  if (!intersects(extent))
-    return QSet<int>();
+  // if this node does not intersect with the supplied query, there is no intersection
+  if (!node.intersects(query))
+    return;
 
   // if this node intersects but has no children, it must be a leaf node: return all geometry indices
-  if (!m_tl && !m_tr && !m_bl && !m_br)
-    return m_geometryIds;
-
-  // for each existing child node, (recursively) build up the set of intersecting indices
-  QSet<int> result;
-  if (m_tl)
-    result += m_tl->intersectingIds(extent);
+  if (node.isLeaf())
+  {
+    results += node.m_geometryIds;
+    return;
+  }
 
-  if (m_tr)
-    result += m_tr->intersectingIds(extent);
+  // for each existing child node, (recursively) build up the intersecting indices
+  for (const int child : node.m_children)
+  {
+    if (child != -1)
+      intersectingIds(child, query, results);
+  }
+}
 
-  if (m_bl)
-    result += m_bl->intersectingIds(extent);
+/*!
+  \internal
 
-  if (m_br)
-    result += m_br->intersectingIds(extent);
+  Returns a node covering the given \a quadrant (top left, top right, bottom left
+  or bottom right) of this node, at the next level of the tree.
+ */
+GeometryQuadtree::QuadTree::Node GeometryQuadtree::QuadTree::Node::childNode(int quadrant) const
+{
+  const double xMid = ((m_xMax - m_xMin) * 0.5) + m_xMin;
+  const double yMid = ((m_yMax - m_yMin) * 0.5) + m_yMin;
 
-  return result;
+  Node child;
+  child.m_level = m_level + 1;
+  child.m_xMin = (quadrant == 0 || quadrant == 2) ? m_xMin : xMid;
+  child.m_xMax = (quadrant == 0 || quadrant == 2) ? xMid : m_xMax;
+  child.m_yMin = (quadrant == 0 || quadrant == 1) ? yMid : m_yMin;
+  child.m_yMax = (quadrant == 0 || quadrant == 1) ? m_yMax : yMid;
+  return child;
 }
 
 /*!
   \internal
  */
-QSet<int> GeometryQuadtree::QuadTree::intersectingIds(const Point& location) const
+bool GeometryQuadtree::QuadTree::Node::isLeaf() const
 {
-  // if this node contains no geometry indices, there is no intersection
-  if (m_geometryIds.empty())
-    return QSet<int>();
+  return std::all_of(std::begin(m_children), std::end(m_children), [](int child)
+  {
+    return child == -1;
+  });
+}
 
-  // if this node does not intersect with the supplied extent, there is no intersection
-  if (!intersects(location))
-    return QSet<int>();
+/*!
+  \internal
+ */
+bool GeometryQuadtree::QuadTree::Node::intersects(const Bounds& bounds) const
+{
+  // return whether the supplied bounds overlap this cell
+  return (bounds.m_xMin < m_xMax &&
+          bounds.m_xMax > m_xMin &&
+          bounds.m_yMin < m_yMax &&
+          bounds.m_yMax > m_yMin);
+}
 
-  // if this node intesects but has no children, it must be a leaf node: return all geometry indices
-  if (!m_tl && !m_tr && !m_bl && !m_br)
-    return m_geometryIds;
+/*!
+  \internal
+ */
+bool GeometryQuadtree::QuadTree::Node::isCoveredBy(const Bounds& bounds) const
+{
+  // return whether the supplied bounds contain the whole of this cell
+  return (bounds.m_xMin <= m_xMin &&
+          bounds.m_xMax >= m_xMax &&
+          bounds.m_yMin <= m_yMin &&
+          bounds.m_yMax >= m_yMax);
+}
 
-  // for each existing child node, (recursively) build up the set of intersecting indices
-  QSet<int> result;
-  if (m_tl)
-    result += m_tl->intersectingIds(location);
+/*!
+  \internal
+ */
+bool GeometryQuadtree::QuadTree::Node::intersects(const Location& location) const
+{
+  // return whether the supplied location lies within this cell
+  return (location.m_x <= m_xMax &&
+          location.m_x >= m_xMin &&
+          location.m_y <= m_yMax &&
+          location.m_y >= m_yMin);
+}
 
-  if (m_tr)
-    result += m_tr->intersectingIds(location);
+/*!
+  \internal
+ */
+void GeometryQuadtree::RTree::assign(const Bounds& bounds, int maxLevels)
+{
+  Q_UNUSED(maxLevels)
 
-  if (m_bl)
-    result += m_bl->intersectingIds(location);
+  m_tree.insert(bounds);
+}
 
-  if (m_br)
-    result += m_br->intersectingIds(location);
+/*!
+  \internal
+ */
+void GeometryQuadtree::RTree::bulkLoad(const QVector<Bounds>& bounds, int maxLevels)
+{
+  Q_UNUSED(maxLevels)
 
-  return result;
+  m_tree.load(bounds);
 }
 
 /*!
   \internal
+
+  The R-tree is condensed as elements are removed, so there is nothing to prune.
  */
-bool GeometryQuadtree::QuadTree::contains(const Envelope& extent) const
+void GeometryQuadtree::RTree::prune()
 {
-  return (extent.xMin() >= m_xMin &&
-          extent.xMax() <= m_xMax &&
-          extent.yMin() >= m_yMin &&
-          extent.yMax() <= m_yMax);
 }
 
 /*!
   \internal
  */
-bool GeometryQuadtree::QuadTree::intersects(const Envelope& extent) const
+void GeometryQuadtree::RTree::removeId(int geomId)
 {
-  // return whether the supplied extent overlaps this cell
-  return (extent.xMin() < m_xMax &&
-          extent.xMax() > m_xMin &&
-          extent.yMin() < m_yMax &&
-          extent.yMax() > m_yMin);
+  m_tree.remove(geomId);
 }
 
 /*!
   \internal
  */
-bool GeometryQuadtree::QuadTree::intersects(const Point& location) const
+void GeometryQuadtree::RTree::intersectingIds(const Bounds& query, QVector<int>& results) const
 {
-  // return whether the supplied location lies within this cell
-  return (location.x() <= m_xMax &&
-          location.x() >= m_xMin &&
-          location.y() <= m_yMax &&
-          location.y() >= m_yMin);
+  m_tree.intersecting(query, results);
 }
 
-void GeometryQuadtree::QuadTree::removeId(int index)
+/*!
+  \internal
+ */
+void GeometryQuadtree::RTree::intersectingIds(const Location& location, QVector<int>& results) const
 {
-  if (m_geometryIds.remove(index))
-  {
-    if (m_tl)
-      m_tl->removeId(index);
+  Bounds query;
+  query.m_xMin = query.m_xMax = location.m_x;
+  query.m_yMin = query.m_yMax = location.m_y;
+  m_tree.intersecting(query, results);
+}
 
-    if (m_tr)
-      m_tr->removeId(index);
+/*!
+  \internal
 
-    if (m_bl)
-      m_bl->removeId(index);
+  The R-tree grows to contain every element.
+ */
+bool GeometryQuadtree::RTree::contains(const Bounds& bounds) const
+{
+  Q_UNUSED(bounds)
 
-    if (m_br)
-      m_br->removeId(index);
-  }
+  return true;
 }
 
 } // Dsa
@@ -17,17 +17,22 @@
 #ifndef GEOMETRYQUADTREE_H
 #define GEOMETRYQUADTREE_H
 
+// C++ API headers
+#include "Envelope.h"
+#include "Geometry.h"
+
 // Qt headers
+#include <QElapsedTimer>
 #include <QHash>
 #include <QList>
 #include <QObject>
+#include <QVector>
 
 // STL headers
 #include <memory>
 
 namespace Esri {
 namespace ArcGISRuntime {
-class Envelope;
 class GeoElement;
 class Geometry;
 class Point;
@@ -36,39 +41,122 @@ class Point;
 
 namespace Dsa {
 
-class GeoElementSignaler;
+class GeoElementChangeAggregator;
+class PreparedPolygon;
 
 class GeometryQuadtree : public QObject
 {
   Q_OBJECT
 
 public:
+  enum class IndexType
+  {
+    Quadtree,
+    RTree
+  };
+
   GeometryQuadtree(const Esri::ArcGISRuntime::Envelope& extent,
                    const QList<Esri::ArcGISRuntime::GeoElement*>& geoElements,
                    int maxLevels,
                    QObject* parent = nullptr);
+  GeometryQuadtree(const Esri::ArcGISRuntime::Envelope& extent,
+                   const QList<Esri::ArcGISRuntime::GeoElement*>& geoElements,
+                   int maxLevels,
+                   IndexType indexType,
+                   QObject* parent = nullptr);
   ~GeometryQuadtree();
 
   void appendGeoElment(Esri::ArcGISRuntime::GeoElement* newGeoElement);
+  void appendGeoElements(const QList<Esri::ArcGISRuntime::GeoElement*>& newGeoElements);
+  void removeGeoElement(Esri::ArcGISRuntime::GeoElement* geoElement);
+  void removeGeoElements(const QList<Esri::ArcGISRuntime::GeoElement*>& geoElements);
+  void reset(const Esri::ArcGISRuntime::Envelope& extent,
+             const QList<Esri::ArcGISRuntime::GeoElement*>& geoElements);
+
+  IndexType indexType() const;
 
   QList<Esri::ArcGISRuntime::Geometry> candidateIntersections(const Esri::ArcGISRuntime::Geometry& geometry) const;
   QList<Esri::ArcGISRuntime::Geometry> candidateIntersections(const Esri::ArcGISRuntime::Envelope& extent) const;
   QList<Esri::ArcGISRuntime::Geometry> candidateIntersections(const Esri::ArcGISRuntime::Point& location) const;
+  void candidateIntersections(const Esri::ArcGISRuntime::Envelope& extent, QList<Esri::ArcGISRuntime::Geometry>& results) const;
+  void candidateIntersections(const Esri::ArcGISRuntime::Point& location, QList<Esri::ArcGISRuntime::Geometry>& results) const;
+
+  QList<Esri::ArcGISRuntime::Geometry> intersecting(const Esri::ArcGISRuntime::Geometry& geometry, int maximumResults = -1) const;
+  QList<Esri::ArcGISRuntime::Geometry> withinDistance(const Esri::ArcGISRuntime::Point& location, double meters, int maximumResults = -1) const;
+  QList<Esri::ArcGISRuntime::Geometry> withinDistanceCandidates(const Esri::ArcGISRuntime::Point& location, double meters) const;
+  double distanceLowerBound(const Esri::ArcGISRuntime::Point& location, double maximumMeters) const;
+
+  double maximumSpeed() const;
+  int unpredictableChangeCount() const;
+
+  QList<std::shared_ptr<const PreparedPolygon>> candidatePolygons(const Esri::ArcGISRuntime::Point& location) const;
+
+  struct GeoElementCandidate
+  {
+    Esri::ArcGISRuntime::GeoElement* m_geoElement = nullptr;
+    Esri::ArcGISRuntime::Geometry m_geometry;
+  };
+
+  QList<GeoElementCandidate> candidateGeoElements(const Esri::ArcGISRuntime::Envelope& extent) const;
+  void candidateGeoElements(const Esri::ArcGISRuntime::Envelope& extent, QList<GeoElementCandidate>& results) const;
+
+  static bool isAnyWithinDistance(const Esri::ArcGISRuntime::Point& location,
+                                  double meters,
+                                  const QList<Esri::ArcGISRuntime::Geometry>& candidates,
+                                  const Esri::ArcGISRuntime::Geometry& wgs84Buffer = Esri::ArcGISRuntime::Geometry());
 
 signals:
   void treeChanged();
 
 private:
   void buildTree(const Esri::ArcGISRuntime::Envelope& extent);
+  void cacheWgs84Elements();
   void handleGeometryChange(int changedIndex);
+  void handleGeometryChanges(const QVector<int>& changedKeys);
+  void handleElementDestroyed(int key);
+  void rebuildForAllElements();
   int handleNewGeoElement(Esri::ArcGISRuntime::GeoElement* geoElement);
-
+  void removeElement(int key);
+  bool assignElement(int key, const Esri::ArcGISRuntime::Envelope& wgs84Extent);
+  bool isRebuildRequired() const;
+  void pruneIfRequired();
+  void appendQueryGeometries(QList<Esri::ArcGISRuntime::Geometry>& results) const;
+  void gatherQueryIds(const Esri::ArcGISRuntime::Envelope& wgs84Extent) const;
+  qint64 preparedPolygonFootprint() const;
+  qint64 releasePreparedPolygons();
+
+  struct Wgs84Element
+  {
+    Esri::ArcGISRuntime::Geometry m_geometry;
+    Esri::ArcGISRuntime::Envelope m_extent;
+    mutable std::shared_ptr<const PreparedPolygon> m_preparedPolygon;
+    qint64 m_updateTime = 0;
+  };
+
+  const Wgs84Element& wgs84Element(int key);
+  void recordElementMove(const Wgs84Element& previous, const Wgs84Element& current);
+
+  struct SpatialTree;
   struct QuadTree;
+  struct RTree;
 
+  IndexType m_indexType = IndexType::Quadtree;
   int m_maxLevels;
-  std::unique_ptr<QuadTree> m_tree;
-  QHash<int, GeoElementSignaler*> m_elementStorage;
+  double m_longitudeCut = -180.0;
+  std::unique_ptr<SpatialTree> m_tree;
+  GeoElementChangeAggregator* m_changeAggregator = nullptr;
+  QHash<int, Esri::ArcGISRuntime::GeoElement*> m_elementStorage;
+  QHash<Esri::ArcGISRuntime::GeoElement*, int> m_elementKeys;
+  QHash<int, Esri::ArcGISRuntime::Envelope> m_outsideExtents;
+  QHash<int, Wgs84Element> m_wgs84Elements;
+  int m_pendingPruneCount = 0;
+  mutable QVector<int> m_queryIds;
   int m_nextKey = 0;
+  QElapsedTimer m_clock;
+  qint64 m_speedWindowStart = 0;
+  double m_windowSpeed = 0.0;
+  double m_previousWindowSpeed = 0.0;
+  int m_unpredictableChangeCount = 0;
 };
 
 } // Dsa
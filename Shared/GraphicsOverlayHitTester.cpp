@@ -0,0 +1,345 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "GraphicsOverlayHitTester.h"
+
+// dsa app headers
+#include "GeometryQuadtree.h"
+#include "SpatialIndexRegistry.h"
+
+// C++ API headers
+#include "GeometryEngine.h"
+#include "GeoView.h"
+#include "Graphic.h"
+#include "GraphicsOverlay.h"
+#include "GraphicsOverlayListModel.h"
+#include "MapView.h"
+#include "Point.h"
+#include "SceneView.h"
+
+// Qt headers
+#include <QtMath>
+
+// STL headers
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+// half of the on-screen size of a typical point symbol, in device independent pixels
+static constexpr double s_symbolRadius = 16.0;
+
+/*!
+  \class Dsa::GraphicsOverlayHitTester
+  \inmodule Dsa
+  \inherits QObject
+  \brief Finds the graphics at a screen position without an asynchronous identify task.
+
+  The graphics of each overlay in the view are looked up in the shared
+  \l GeometryQuadtree for the overlay (see \l SpatialIndexRegistry), using the
+  area covered by the tap on the ground. The candidates are then tested exactly
+  against that area, so a tap on a busy overlay is answered on the GUI thread
+  in a few microseconds rather than after a round trip through the runtime.
+
+  Graphics which are drawn away from the surface in a scene (that is, overlays
+  with \c Absolute or \c Relative placement) do not appear where their ground
+  position suggests, so those overlays still need \l
+  Esri::ArcGISRuntime::GeoView::identifyGraphicsOverlays. See \l canHitTest and
+  \l requiresRuntimeIdentify.
+
+  The graphics returned are the graphics of the overlay, and are not owned by
+  the caller.
+ */
+
+/*!
+  \brief Constructor taking an optional \a parent.
+ */
+GraphicsOverlayHitTester::GraphicsOverlayHitTester(QObject* parent /* = nullptr */):
+  QObject(parent)
+{
+}
+
+/*!
+  \brief Destructor.
+
+  Releases the spatial indexes acquired for the graphics overlays.
+ */
+GraphicsOverlayHitTester::~GraphicsOverlayHitTester()
+{
+  const QList<GraphicsOverlay*> overlays = m_overlays.keys();
+  for (GraphicsOverlay* graphicsOverlay : overlays)
+    releaseOverlay(graphicsOverlay);
+}
+
+/*!
+  \brief Returns the visible graphics within \a tolerance pixels of the screen
+  position \a x, \a y in \a geoView, keyed by the id of their overlay.
+
+  Only overlays which pass \l canHitTest are searched. Point graphics are
+  returned nearest first, followed by any lines or polygons which intersect the
+  tap. When \a maximumResults is greater than 0, at most that many graphics are
+  returned for each overlay.
+ */
+QHash<QString, QList<GeoElement*>> GraphicsOverlayHitTester::identify(GeoView* geoView,
+                                                                     double x,
+                                                                     double y,
+                                                                     double tolerance,
+                                                                     int maximumResults /* = -1 */)
+{
+  QHash<QString, QList<GeoElement*>> results;
+  if (!geoView || !geoView->graphicsOverlays())
+    return results;
+
+  updateOverlays(geoView);
+
+  const Envelope extent = tapExtent(geoView, x, y, tolerance + s_symbolRadius);
+  if (extent.isEmpty())
+    return results;
+
+  const Point center = extent.center();
+  const double xScale = std::cos(qDegreesToRadians(center.y()));
+
+  // overlays later in the list are drawn on top, so are searched first
+  GraphicsOverlayListModel* overlays = geoView->graphicsOverlays();
+  for (int i = overlays->rowCount() - 1; i >= 0; --i)
+  {
+    GraphicsOverlay* graphicsOverlay = overlays->at(i);
+    if (!graphicsOverlay || !graphicsOverlay->isVisible() || !m_overlays.contains(graphicsOverlay))
+      continue;
+
+    GeometryQuadtree* index = SpatialIndexRegistry::instance()->spatialIndex(graphicsOverlay);
+    if (!index)
+      continue;
+
+    // the working lists keep their storage between overlays and taps
+    m_candidates.erase(m_candidates.begin(), m_candidates.end());
+    m_hits.resize(0);
+
+    index->candidateGeoElements(extent, m_candidates);
+    for (const GeometryQuadtree::GeoElementCandidate& candidate : qAsConst(m_candidates))
+    {
+      Graphic* graphic = dynamic_cast<Graphic*>(candidate.m_geoElement);
+      if (!graphic || !graphic->isVisible() || candidate.m_geometry.isEmpty())
+        continue;
+
+      Hit hit;
+      hit.m_geoElement = graphic;
+
+      if (candidate.m_geometry.geometryType() == GeometryType::Point)
+      {
+        const Point point = geometry_cast<Point>(candidate.m_geometry);
+        if (point.x() < extent.xMin() || point.x() > extent.xMax() ||
+            point.y() < extent.yMin() || point.y() > extent.yMax())
+          continue;
+
+        const double dx = (point.x() - center.x()) * xScale;
+        const double dy = point.y() - center.y();
+        hit.m_distance = dx * dx + dy * dy;
+      }
+      else
+      {
+        if (!GeometryEngine::intersects(extent, candidate.m_geometry))
+          continue;
+
+        // lines and polygons follow the points, which are more likely to be the target of a tap
+        hit.m_distance = std::numeric_limits<double>::max();
+      }
+
+      m_hits.append(hit);
+    }
+
+    if (m_hits.isEmpty())
+      continue;
+
+    std::stable_sort(m_hits.begin(), m_hits.end(), [](const Hit& hit1, const Hit& hit2)
+    {
+      return hit1.m_distance < hit2.m_distance;
+    });
+
+    QList<GeoElement*>& overlayResults = results[graphicsOverlay->overlayId()];
+    for (const Hit& hit : qAsConst(m_hits))
+    {
+      if (maximumResults > 0 && overlayResults.size() >= maximumResults)
+        break;
+
+      overlayResults.append(hit.m_geoElement);
+    }
+  }
+
+  // release the candidate geometry until the next tap
+  m_candidates.erase(m_candidates.begin(), m_candidates.end());
+
+  return results;
+}
+
+/*!
+  \brief Returns whether \a geoView has any visible graphics overlays which
+  cannot be searched by \l identify.
+
+  When this is \c true, \l Esri::ArcGISRuntime::GeoView::identifyGraphicsOverlays
+  is needed to find the graphics of those overlays.
+ */
+bool GraphicsOverlayHitTester::requiresRuntimeIdentify(GeoView* geoView) const
+{
+  if (!geoView || !geoView->graphicsOverlays())
+    return false;
+
+  GraphicsOverlayListModel* overlays = geoView->graphicsOverlays();
+  for (int i = 0; i < overlays->rowCount(); ++i)
+  {
+    GraphicsOverlay* graphicsOverlay = overlays->at(i);
+    if (graphicsOverlay && graphicsOverlay->isVisible() && !canHitTest(geoView, graphicsOverlay))
+      return true;
+  }
+
+  return false;
+}
+
+/*!
+  \brief Returns whether the graphics of \a graphicsOverlay in \a geoView can be
+  found from their ground position.
+
+  This is the case for every overlay in a map, and for draped overlays in a scene.
+ */
+bool GraphicsOverlayHitTester::canHitTest(GeoView* geoView, GraphicsOverlay* graphicsOverlay)
+{
+  if (!graphicsOverlay)
+    return false;
+
+  if (!dynamic_cast<SceneView*>(geoView))
+    return true;
+
+  const SurfacePlacement placement = graphicsOverlay->sceneProperties().surfacePlacement();
+  return placement != SurfacePlacement::Absolute && placement != SurfacePlacement::Relative;
+}
+
+/*!
+  \internal
+
+  Returns the WGS84 extent on the ground of the square \a radius pixels either
+  side of \a x, \a y. Corners of the square which do not reach the ground (for
+  example, which are in the sky of a scene) are left out.
+ */
+Envelope GraphicsOverlayHitTester::tapExtent(GeoView* geoView, double x, double y, double radius) const
+{
+  SceneView* sceneView = dynamic_cast<SceneView*>(geoView);
+  MapView* mapView = sceneView ? nullptr : dynamic_cast<MapView*>(geoView);
+  if (!sceneView && !mapView)
+    return Envelope();
+
+  const double screenPoints[5][2] = { { x, y },
+                                      { x - radius, y - radius },
+                                      { x + radius, y - radius },
+                                      { x + radius, y + radius },
+                                      { x - radius, y + radius } };
+
+  bool anyPoint = false;
+  double xMin = 0.0;
+  double yMin = 0.0;
+  double xMax = 0.0;
+  double yMax = 0.0;
+  for (const auto& screenPoint : screenPoints)
+  {
+    Point location = sceneView ? sceneView->screenToBaseSurface(screenPoint[0], screenPoint[1])
+                               : mapView->screenToLocation(screenPoint[0], screenPoint[1]);
+    if (location.isEmpty())
+      continue;
+
+    if (location.spatialReference() != SpatialReference::wgs84())
+      location = geometry_cast<Point>(GeometryEngine::project(location, SpatialReference::wgs84()));
+
+    if (!anyPoint)
+    {
+      xMin = xMax = location.x();
+      yMin = yMax = location.y();
+      anyPoint = true;
+      continue;
+    }
+
+    xMin = std::min(xMin, location.x());
+    yMin = std::min(yMin, location.y());
+    xMax = std::max(xMax, location.x());
+    yMax = std::max(yMax, location.y());
+  }
+
+  if (!anyPoint)
+    return Envelope();
+
+  return Envelope(xMin, yMin, xMax, yMax, SpatialReference::wgs84());
+}
+
+/*!
+  \internal
+
+  Acquires a spatial index for each overlay in \a geoView which can be hit-tested,
+  and releases the indexes of overlays which have left the view.
+ */
+void GraphicsOverlayHitTester::updateOverlays(GeoView* geoView)
+{
+  QList<GraphicsOverlay*> current;
+  GraphicsOverlayListModel* overlays = geoView->graphicsOverlays();
+  for (int i = 0; i < overlays->rowCount(); ++i)
+  {
+    GraphicsOverlay* graphicsOverlay = overlays->at(i);
+    if (canHitTest(geoView, graphicsOverlay))
+      current.append(graphicsOverlay);
+  }
+
+  const QList<GraphicsOverlay*> previous = m_overlays.keys();
+  for (GraphicsOverlay* graphicsOverlay : previous)
+  {
+    if (!current.contains(graphicsOverlay))
+      releaseOverlay(graphicsOverlay);
+  }
+
+  for (GraphicsOverlay* graphicsOverlay : qAsConst(current))
+  {
+    if (m_overlays.contains(graphicsOverlay))
+      continue;
+
+    SpatialIndexRegistry::instance()->acquire(graphicsOverlay);
+
+    // the registry drops the index of a destroyed overlay itself
+    m_overlays.insert(graphicsOverlay, connect(graphicsOverlay, &QObject::destroyed, this, [this, graphicsOverlay]()
+    {
+      m_overlays.remove(graphicsOverlay);
+    }));
+  }
+}
+
+/*!
+  \internal
+
+  Releases the spatial index acquired for \a graphicsOverlay.
+ */
+void GraphicsOverlayHitTester::releaseOverlay(GraphicsOverlay* graphicsOverlay)
+{
+  auto findIt = m_overlays.find(graphicsOverlay);
+  if (findIt == m_overlays.end())
+    return;
+
+  disconnect(findIt.value());
+  m_overlays.erase(findIt);
+  SpatialIndexRegistry::instance()->release(graphicsOverlay);
+}
+
+} // Dsa
@@ -0,0 +1,81 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef GRAPHICSOVERLAYHITTESTER_H
+#define GRAPHICSOVERLAYHITTESTER_H
+
+// dsa app headers
+#include "GeometryQuadtree.h"
+
+// C++ API headers
+#include "Envelope.h"
+
+// Qt headers
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QVector>
+
+namespace Esri {
+namespace ArcGISRuntime {
+class GeoElement;
+class GeoView;
+class GraphicsOverlay;
+}
+}
+
+namespace Dsa {
+
+class GraphicsOverlayHitTester : public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit GraphicsOverlayHitTester(QObject* parent = nullptr);
+  ~GraphicsOverlayHitTester();
+
+  QHash<QString, QList<Esri::ArcGISRuntime::GeoElement*>> identify(Esri::ArcGISRuntime::GeoView* geoView,
+                                                                   double x,
+                                                                   double y,
+                                                                   double tolerance,
+                                                                   int maximumResults = -1);
+
+  bool requiresRuntimeIdentify(Esri::ArcGISRuntime::GeoView* geoView) const;
+  static bool canHitTest(Esri::ArcGISRuntime::GeoView* geoView, Esri::ArcGISRuntime::GraphicsOverlay* graphicsOverlay);
+
+private:
+  Q_DISABLE_COPY(GraphicsOverlayHitTester)
+
+  Esri::ArcGISRuntime::Envelope tapExtent(Esri::ArcGISRuntime::GeoView* geoView, double x, double y, double radius) const;
+  void updateOverlays(Esri::ArcGISRuntime::GeoView* geoView);
+  void releaseOverlay(Esri::ArcGISRuntime::GraphicsOverlay* graphicsOverlay);
+
+  struct Hit
+  {
+    Esri::ArcGISRuntime::GeoElement* m_geoElement = nullptr;
+    double m_distance = 0.0;
+  };
+
+  QHash<Esri::ArcGISRuntime::GraphicsOverlay*, QMetaObject::Connection> m_overlays;
+
+  // working storage, re-used by each identify
+  QList<GeometryQuadtree::GeoElementCandidate> m_candidates;
+  QVector<Hit> m_hits;
+};
+
+} // Dsa
+
+#endif // GRAPHICSOVERLAYHITTESTER_H
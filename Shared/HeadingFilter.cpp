@@ -0,0 +1,255 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "HeadingFilter.h"
+
+// Qt headers
+#include <QCompass>
+#include <QTimer>
+
+// STL headers
+#include <cmath>
+
+namespace Dsa {
+
+namespace
+{
+// returns heading in the range [0, 360)
+double normalizedHeading(double heading)
+{
+  const double normalized = std::fmod(heading, 360.0);
+  return normalized < 0.0 ? normalized + 360.0 : normalized;
+}
+
+// returns the signed shortest turn from one heading to another, in the range [-180, 180)
+double headingDifference(double to, double from)
+{
+  return normalizedHeading(to - from + 180.0) - 180.0;
+}
+}
+
+/*!
+  \class Dsa::HeadingFilter
+  \inmodule Dsa
+  \inherits QObject
+  \brief Smooths and rate limits the readings of a compass.
+
+  A compass may report its azimuth 50 to 100 times a second. The filter is the
+  single subscriber to the compass readings and passes on a heading with
+  \l headingChanged when:
+
+  \list
+    \li The low-pass filtered heading has turned by at least \l deadband degrees since
+    the last heading was passed on.
+    \li At least \l minimumInterval milliseconds have passed since then, which
+    defaults to roughly one display frame. A turn which arrives sooner is passed on
+    once the interval has elapsed.
+  \endlist
+
+  Headings are filtered along the shortest turn, so readings either side of north
+  do not average to south.
+ */
+
+/*!
+  \brief Constructor taking an optional \a parent.
+ */
+HeadingFilter::HeadingFilter(QObject* parent) :
+  QObject(parent),
+  m_pendingTimer(new QTimer(this))
+{
+  m_pendingTimer->setSingleShot(true);
+  connect(m_pendingTimer, &QTimer::timeout, this, &HeadingFilter::deliver);
+  m_clock.start();
+}
+
+/*!
+  \brief Destructor.
+ */
+HeadingFilter::~HeadingFilter()
+{
+}
+
+/*!
+  \brief Returns the compass whose readings are filtered.
+ */
+QCompass* HeadingFilter::compass() const
+{
+  return m_compass;
+}
+
+/*!
+  \brief Sets the compass whose readings are filtered to \a compass.
+
+  The filter does not take ownership of the compass. Passing \c nullptr stops
+  filtering readings, for example before the compass is deleted.
+ */
+void HeadingFilter::setCompass(QCompass* compass)
+{
+  if (m_compass == compass)
+    return;
+
+  if (m_readingConnection)
+    disconnect(m_readingConnection);
+
+  m_compass = compass;
+  reset();
+
+  if (m_compass)
+    m_readingConnection = connect(m_compass, &QCompass::readingChanged, this, &HeadingFilter::handleReading);
+}
+
+/*!
+  \brief Returns the weight between \c 0 and \c 1 given to each new reading.
+ */
+double HeadingFilter::smoothingFactor() const
+{
+  return m_smoothingFactor;
+}
+
+/*!
+  \brief Sets the weight given to each new reading to \a smoothingFactor.
+
+  \c 1 disables smoothing and lower values smooth more heavily.
+ */
+void HeadingFilter::setSmoothingFactor(double smoothingFactor)
+{
+  m_smoothingFactor = qBound(0.01, smoothingFactor, 1.0);
+}
+
+/*!
+  \brief Returns the turn in degrees below which the heading is not passed on.
+ */
+double HeadingFilter::deadband() const
+{
+  return m_deadband;
+}
+
+/*!
+  \brief Sets the turn in degrees below which the heading is not passed on to \a deadband.
+ */
+void HeadingFilter::setDeadband(double deadband)
+{
+  m_deadband = qMax(0.0, deadband);
+}
+
+/*!
+  \brief Returns the shortest time in milliseconds between headings being passed on.
+ */
+int HeadingFilter::minimumInterval() const
+{
+  return m_minimumInterval;
+}
+
+/*!
+  \brief Sets the shortest time in milliseconds between headings being passed on to
+  \a minimumInterval.
+ */
+void HeadingFilter::setMinimumInterval(int minimumInterval)
+{
+  m_minimumInterval = qMax(0, minimumInterval);
+}
+
+/*!
+  \brief Returns the filtered heading in degrees.
+ */
+double HeadingFilter::heading() const
+{
+  return m_filteredHeading;
+}
+
+/*!
+  \brief Adds a new \a heading in degrees to the filter.
+
+  This is called for each compass reading, but can also be used for
+  other heading sources.
+ */
+void HeadingFilter::addHeading(double heading)
+{
+  if (!std::isfinite(heading))
+    return;
+
+  if (!m_hasHeading)
+  {
+    m_filteredHeading = normalizedHeading(heading);
+    m_hasHeading = true;
+  }
+  else
+  {
+    m_filteredHeading = normalizedHeading(m_filteredHeading + (m_smoothingFactor * headingDifference(heading, m_filteredHeading)));
+  }
+
+  if (m_hasDelivered && std::abs(headingDifference(m_filteredHeading, m_deliveredHeading)) < m_deadband)
+    return;
+
+  const qint64 remaining = m_hasDelivered ? m_minimumInterval - (m_clock.elapsed() - m_lastDeliveryTime) : 0;
+  if (remaining <= 0)
+  {
+    m_pendingTimer->stop();
+    deliver();
+    return;
+  }
+
+  if (!m_pendingTimer->isActive())
+    m_pendingTimer->start(static_cast<int>(remaining));
+}
+
+/*!
+  \brief Discards the filtered heading, so that the next reading is passed on immediately.
+ */
+void HeadingFilter::reset()
+{
+  m_pendingTimer->stop();
+  m_hasHeading = false;
+  m_hasDelivered = false;
+}
+
+/*!
+  \internal
+ */
+void HeadingFilter::handleReading()
+{
+  if (!m_compass)
+    return;
+
+  QCompassReading* reading = m_compass->reading();
+  if (!reading)
+    return;
+
+  addHeading(static_cast<double>(reading->azimuth()));
+}
+
+/*!
+  \internal
+ */
+void HeadingFilter::deliver()
+{
+  m_deliveredHeading = m_filteredHeading;
+  m_lastDeliveryTime = m_clock.elapsed();
+  m_hasDelivered = true;
+
+  emit headingChanged(m_deliveredHeading);
+}
+
+// Signal Documentation
+/*!
+  \fn void HeadingFilter::headingChanged(double heading);
+  \brief Signals that the filtered \a heading has changed.
+ */
+
+} // Dsa
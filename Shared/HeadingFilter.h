@@ -0,0 +1,82 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef HEADINGFILTER_H
+#define HEADINGFILTER_H
+
+// Qt headers
+#include <QElapsedTimer>
+#include <QMetaObject>
+#include <QObject>
+
+class QCompass;
+class QTimer;
+
+namespace Dsa {
+
+class HeadingFilter : public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit HeadingFilter(QObject* parent = nullptr);
+  ~HeadingFilter();
+
+  QCompass* compass() const;
+  void setCompass(QCompass* compass);
+
+  double smoothingFactor() const;
+  void setSmoothingFactor(double smoothingFactor);
+
+  double deadband() const;
+  void setDeadband(double deadband);
+
+  int minimumInterval() const;
+  void setMinimumInterval(int minimumInterval);
+
+  double heading() const;
+
+  void addHeading(double heading);
+  void reset();
+
+signals:
+  void headingChanged(double heading);
+
+private:
+  Q_DISABLE_COPY(HeadingFilter)
+
+  void handleReading();
+  void deliver();
+
+  QCompass* m_compass = nullptr;
+  QMetaObject::Connection m_readingConnection;
+
+  double m_smoothingFactor = 0.3;
+  double m_deadband = 1.0;
+  int m_minimumInterval = 16;
+
+  QElapsedTimer m_clock;
+  QTimer* m_pendingTimer = nullptr;
+  double m_filteredHeading = 0.0;
+  double m_deliveredHeading = 0.0;
+  qint64 m_lastDeliveryTime = 0;
+  bool m_hasHeading = false;
+  bool m_hasDelivered = false;
+};
+
+} // Dsa
+
+#endif // HEADINGFILTER_H
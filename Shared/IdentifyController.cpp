@@ -21,8 +21,9 @@
 #include "IdentifyController.h"
 
 // dsa app headers
-#include "GraphicsOverlaysResultsManager.h"
-#include "LayerResultsManager.h"
+#include "GeoElementUtils.h"
+#include "GraphicsOverlayHitTester.h"
+#include "TraceRecorder.h"
 
 // toolkit headers
 #include "ToolManager.h"
@@ -44,26 +45,23 @@ namespace Dsa {
   \inmodule Dsa
   \inherits AbstractTool
   \brief Tool controller for identifying GeoElements.
+
+  Graphics are found straight away from the spatial index of their overlay (see
+  \l GraphicsOverlayHitTester). The runtime's identify tasks are only used for
+  layers, and for any graphics overlays in a scene which are not draped.
  */
 
 /*!
   \brief Constructor accepting an optional \a parent.
  */
 IdentifyController::IdentifyController(QObject* parent /* = nullptr */):
-  AbstractTool(parent)
+  AbstractTool(parent),
+  m_hitTester(new GraphicsOverlayHitTester(this))
 {
   // setup connection to handle mouse-clicking in the view (used to trigger the identify tasks)
   connect(ToolResourceProvider::instance(), &ToolResourceProvider::mouseClicked,
           this, &IdentifyController::onMouseClicked);
 
-  // setup connection to handle the results of an Identify Layers task
-  connect(ToolResourceProvider::instance(), &ToolResourceProvider::identifyLayersCompleted,
-          this, &IdentifyController::onIdentifyLayersCompleted);
-
-  // setup connection to handle the results of an Identify Graphic Overlays task
-  connect(ToolResourceProvider::instance(), &ToolResourceProvider::identifyGraphicsOverlaysCompleted,
-          this, &IdentifyController::onIdentifyGraphicsOverlaysCompleted);
-
   ToolManager::instance().addTool(this);
 }
 
@@ -96,8 +94,10 @@ void IdentifyController::setActive(bool active)
   // if the tool is busy (identify tasks are in-progress), cancel those tasks and start new ones
   if (busy())
   {
-    m_layersWatcher.cancel();
-    m_graphicsOverlaysWatcher.cancel();
+    ToolResourceProvider::instance()->cancelIdentify(this);
+    m_layersTaskId = QUuid();
+    m_graphicsOverlaysTaskId = QUuid();
+    emit busyChanged();
   }
 
   m_active = active;
@@ -110,29 +110,105 @@ void IdentifyController::setActive(bool active)
  */
 bool IdentifyController::busy() const
 {
-  return (m_layersWatcher.isValid() && !m_layersWatcher.isDone() && !m_layersWatcher.isCanceled()) ||
-      (m_graphicsOverlaysWatcher.isValid() && !m_graphicsOverlaysWatcher.isDone() && !m_graphicsOverlaysWatcher.isCanceled());
+  return !m_layersTaskId.isNull() || !m_graphicsOverlaysTaskId.isNull();
 }
 
 /*!
   \property IdentifyController::popupManagers
-  \brief Returns a QVariantList of \l Esri::ArcGISRuntime::PopupManager which can be displayed in the view.
+  \brief Returns a QVariantList of the \l Esri::ArcGISRuntime::PopupManager objects
+  created so far for the identified GeoElements.
 
-  For example, this can be passed to a \l PopupView or \l PopupStackView for display.
+  A PopupManager is only created when its popup is viewed (see \l currentPopupIndex),
+  so this list can be shorter than \l popupCount.
  */
 QVariantList IdentifyController::popupManagers() const
 {
   QVariantList res;
 
-  for (PopupManager* mgr : m_popupManagers)
+  for (const IdentifiedPopup& popup : m_popups)
   {
-    QVariant v = QVariant::fromValue(mgr);
-    res.push_back(v);
+    if (popup.m_popupManager)
+      res.push_back(QVariant::fromValue(popup.m_popupManager));
   }
 
   return res;
 }
 
+/*!
+  \property IdentifyController::popupCount
+  \brief Returns the number of popups which can be paged through.
+ */
+int IdentifyController::popupCount() const
+{
+  return m_popups.size();
+}
+
+/*!
+  \property IdentifyController::currentPopupIndex
+  \brief Returns the index of the popup being viewed.
+ */
+int IdentifyController::currentPopupIndex() const
+{
+  return m_currentPopupIndex;
+}
+
+/*!
+  \brief Sets the index of the popup being viewed to \a currentPopupIndex.
+
+  The \l Esri::ArcGISRuntime::PopupManager for the popup is created if this
+  is the first time it has been viewed.
+ */
+void IdentifyController::setCurrentPopupIndex(int currentPopupIndex)
+{
+  if (currentPopupIndex < 0 || currentPopupIndex >= m_popups.size() || currentPopupIndex == m_currentPopupIndex)
+    return;
+
+  m_currentPopupIndex = currentPopupIndex;
+  createCurrentPopupManager();
+  emit currentPopupIndexChanged();
+}
+
+/*!
+  \property IdentifyController::currentPopupManager
+  \brief Returns the \l Esri::ArcGISRuntime::PopupManager for the popup being viewed.
+
+  This is \c nullptr if there are no popups, or if the GeoElement of the
+  popup has since been deleted (for example, a track which has expired).
+ */
+QObject* IdentifyController::currentPopupManager() const
+{
+  if (m_currentPopupIndex < 0 || m_currentPopupIndex >= m_popups.size())
+    return nullptr;
+
+  return m_popups.at(m_currentPopupIndex).m_popupManager;
+}
+
+/*!
+  \property IdentifyController::maximumResults
+  \brief Returns the maximum number of results retrieved for each layer or graphics overlay.
+
+  The default is 25.
+ */
+int IdentifyController::maximumResults() const
+{
+  return m_maximumResults;
+}
+
+/*!
+  \brief Sets the maximum number of results retrieved for each layer or graphics overlay
+  to \a maximumResults.
+
+  A value less than 1 retrieves every result.
+ */
+void IdentifyController::setMaximumResults(int maximumResults)
+{
+  if (maximumResults == m_maximumResults)
+    return;
+
+  m_maximumResults = maximumResults;
+  emit maximumResultsChanged();
+}
+
 /*!
   \brief Show the popup for \a geoElement with the title \a popupTitle.
  */
@@ -141,16 +217,17 @@ void IdentifyController::showPopup(GeoElement* geoElement, const QString& popupT
   if (!geoElement)
     return;
 
-  m_popupManagers.clear();
-  emit popupManagersChanged();
+  clearPopups();
   addGeoElementPopup(geoElement, popupTitle);
+  createCurrentPopupManager();
   emit popupManagersChanged();
+  emit currentPopupIndexChanged();
 }
 
 /*!
   \brief Show popups for all of the \a geoElementsByTitle.
 
-  A popup will be created for each \l Esri::ArcGISRuntime::GeoElement in the QHash,
+  A popup will be available for each \l Esri::ArcGISRuntime::GeoElement in the QHash,
   with the string key as the title.
  */
 void IdentifyController::showPopups(const QHash<QString, QList<GeoElement*>>& geoElementsByTitle)
@@ -158,8 +235,7 @@ void IdentifyController::showPopups(const QHash<QString, QList<GeoElement*>>& ge
   if (geoElementsByTitle.isEmpty())
     return;
 
-  m_popupManagers.clear();
-  emit popupManagersChanged();
+  clearPopups();
 
   for (auto it = geoElementsByTitle.cbegin(); it != geoElementsByTitle.cend(); ++it)
   {
@@ -168,7 +244,9 @@ void IdentifyController::showPopups(const QHash<QString, QList<GeoElement*>>& ge
       addGeoElementPopup(geoElement, popupTitle);
   }
 
+  createCurrentPopupManager();
   emit popupManagersChanged();
+  emit currentPopupIndexChanged();
 }
 
 /*!
@@ -176,6 +254,8 @@ void IdentifyController::showPopups(const QHash<QString, QList<GeoElement*>>& ge
  */
 void IdentifyController::onMouseClicked(QMouseEvent& event)
 {
+  DSA_TRACE_SCOPE("IdentifyController::onMouseClicked");
+
   // ignore the event if the tool is not active.
   if (!isActive())
     return;
@@ -192,35 +272,65 @@ void IdentifyController::onMouseClicked(QMouseEvent& event)
   if (!geoView)
     return;
 
-  // start new identifyLayers and identifyGraphicsOverlays tasks at the x and y position of the event and using the
+  clearPopups();
+  emit popupManagersChanged();
+  emit currentPopupIndexChanged();
+
+  // find the graphics at the x and y position of the event from the spatial index of each overlay
+  const auto localGraphics = m_hitTester->identify(geoView, event.pos().x(), event.pos().y(), m_tolerance, m_maximumResults);
+  bool anyAdded = false;
+  for (auto it = localGraphics.cbegin(); it != localGraphics.cend(); ++it)
+  {
+    for (GeoElement* geoElement : it.value())
+    {
+      if (addGeoElementPopup(geoElement, it.key()))
+        anyAdded = true;
+    }
+  }
+
+  if (anyAdded)
+  {
+    createCurrentPopupManager();
+    emit popupManagersChanged();
+    emit currentPopupIndexChanged();
+  }
+
+  // start a new identifyLayers task (and an identifyGraphicsOverlays task for any overlays which
+  // cannot be found locally) at the x and y position of the event and using the
   // specifed tolerance (m_tolerance) to determine how accurate a hit-test to perform.
-  // create a TaskWatcher to store the progress/state of the task.
-  m_layersWatcher = geoView->identifyLayers(event.pos().x(), event.pos().y(), m_tolerance, false);
-  m_graphicsOverlaysWatcher = geoView->identifyGraphicsOverlays(event.pos().x(), event.pos().y(), m_tolerance, false);
-  emit busyChanged();
+  // the tasks are shared with any other tool which identifies at the same position.
+  ToolResourceProvider* resourceProvider = ToolResourceProvider::instance();
+  m_layersTaskId = resourceProvider->identifyLayers(this, event.pos().x(), event.pos().y(), m_tolerance, false, m_maximumResults,
+                                                    [this](const QList<IdentifyLayerResult*>& identifyResults)
+  {
+    onIdentifyLayersCompleted(identifyResults);
+  });
 
-  m_popupManagers.clear();
-  emit popupManagersChanged();
+  if (m_hitTester->requiresRuntimeIdentify(geoView))
+  {
+    m_graphicsOverlaysTaskId = resourceProvider->identifyGraphicsOverlays(this, event.pos().x(), event.pos().y(), m_tolerance, false, m_maximumResults,
+                                                                          [this](const QList<IdentifyGraphicsOverlayResult*>& identifyResults)
+    {
+      onIdentifyGraphicsOverlaysCompleted(identifyResults);
+    });
+  }
+  emit busyChanged();
 
   // accept the event to prevent it being used by other tools etc.
   event.accept();
 }
 
 /*!
-  \brief Handles the output of an IdentifyLayers task with Id \a taskId and results \l identifyResults.
+  \brief Handles the output of an IdentifyLayers task with results \l identifyResults.
 
-  Creates a new \l Esri::ArcGISRuntime::PopupManager objects for every valid feature with attributes
+  Adds a popup for every valid feature with attributes. The features are kept by the
+  tool, since their \l Esri::ArcGISRuntime::PopupManager is only created when viewed.
  */
-void IdentifyController::onIdentifyLayersCompleted(const QUuid& taskId, QList<IdentifyLayerResult*> identifyResults)
+void IdentifyController::onIdentifyLayersCompleted(const QList<IdentifyLayerResult*>& identifyResults)
 {
-  // if the task Id does not match the one we are tracking, ignore it
-  if (taskId != m_layersWatcher.taskId())
-    return;
+  DSA_TRACE_SCOPE("IdentifyController::onIdentifyLayersCompleted");
 
-  // Create a RAII helper to ensure we clean up the results
-  LayerResultsManager resultsManager(identifyResults);
-
-  m_layersWatcher = TaskWatcher();
+  m_layersTaskId = QUuid();
   emit busyChanged();
 
   if (!isActive())
@@ -228,8 +338,8 @@ void IdentifyController::onIdentifyLayersCompleted(const QUuid& taskId, QList<Id
 
   // iterate over the results and add a new PopupManager for any valid features, with attributes
   bool anyAdded = false;
-  auto it = resultsManager.m_results.begin();
-  auto itEnd = resultsManager.m_results.end();
+  auto it = identifyResults.cbegin();
+  auto itEnd = identifyResults.cend();
   for (; it != itEnd; ++it)
   {
     IdentifyLayerResult* res = *it;
@@ -240,64 +350,81 @@ void IdentifyController::onIdentifyLayersCompleted(const QUuid& taskId, QList<Id
     const QList<GeoElement*> geoElements = res->geoElements();
     for(GeoElement* g : geoElements)
     {
-      if (addGeoElementPopup(g, resTitle))
+      if (addGeoElementPopup(g, resTitle, true))
         anyAdded = true;
     }
   }
 
   if (anyAdded)
+  {
+    const bool firstPopups = !currentPopupManager();
+    createCurrentPopupManager();
     emit popupManagersChanged();
+    if (firstPopups)
+      emit currentPopupIndexChanged();
+  }
 }
 
 /*!
-  \brief Handles the output of an IdentifyGraphicsOverlays task with Id \a taskId and results \l identifyResults.
+  \brief Handles the output of an IdentifyGraphicsOverlays task with results \l identifyResults.
 
-  Creates a new \l Esri::ArcGISRumtime::PopupManager objects for every valid graphic with attributes
+  Adds a popup for every valid graphic with attributes.
  */
-void IdentifyController::onIdentifyGraphicsOverlaysCompleted(const QUuid& taskId, QList<IdentifyGraphicsOverlayResult*> identifyResults)
+void IdentifyController::onIdentifyGraphicsOverlaysCompleted(const QList<IdentifyGraphicsOverlayResult*>& identifyResults)
 {
-  // if the task Id does not match the one we are tracking, ignore it
-  if (taskId != m_graphicsOverlaysWatcher.taskId())
-    return;
-
-  // Create a RAII helper to ensure we clean up the results
-  GraphicsOverlaysResultsManager resultsManager(identifyResults);
+  DSA_TRACE_SCOPE("IdentifyController::onIdentifyGraphicsOverlaysCompleted");
 
-  m_graphicsOverlaysWatcher = TaskWatcher();
+  m_graphicsOverlaysTaskId = QUuid();
   emit busyChanged();
 
   if (!isActive())
     return;
 
+  GeoView* geoView = ToolResourceProvider::instance()->geoView();
+
   // iterate over the results and add a new PopupManager for any valid graphics, with attributes
   bool anyAdded = false;
-  auto it = resultsManager.m_results.begin();
-  auto itEnd = resultsManager.m_results.end();
+  auto it = identifyResults.cbegin();
+  auto itEnd = identifyResults.cend();
   for (; it != itEnd; ++it)
   {
     IdentifyGraphicsOverlayResult* res = *it;
     if (!res)
       continue;
 
+    // graphics from these overlays were already found when the view was clicked
+    if (GraphicsOverlayHitTester::canHitTest(geoView, res->graphicsOverlay()))
+      continue;
+
     const QString resTitle = res->graphicsOverlay()->overlayId();
     const QList<Graphic*> graphics = res->graphics();
 
     for(Graphic* g : graphics)
     {
-      if (addGeoElementPopup(g, resTitle))
+      if (addGeoElementPopup(g, resTitle, true))
         anyAdded = true;
     }
   }
 
   if (anyAdded)
+  {
+    const bool firstPopups = !currentPopupManager();
+    createCurrentPopupManager();
     emit popupManagersChanged();
+    if (firstPopups)
+      emit currentPopupIndexChanged();
+  }
 }
 
 /*!
-  \brief Helper method to create a new PopupManager with the title \a popupTitle,
+  \brief Helper method to add a popup with the title \a popupTitle,
   if \a geoElement is valid and has attributes.
+
+  No more than \l maximumResults popups are added for each title. If
+  \a takeOwnership is \c true, \a geoElement is re-parented to the tool and
+  deleted along with its popup.
  */
-bool IdentifyController::addGeoElementPopup(GeoElement* geoElement, const QString& popupTitle)
+bool IdentifyController::addGeoElementPopup(GeoElement* geoElement, const QString& popupTitle, bool takeOwnership)
 {
   if (!geoElement)
     return false;
@@ -305,13 +432,48 @@ bool IdentifyController::addGeoElementPopup(GeoElement* geoElement, const QStrin
   if (!geoElement->attributes() || geoElement->attributes()->isEmpty())
     return false;
 
+  int& titleCount = m_popupCountsByTitle[popupTitle];
+  if (m_maximumResults > 0 && titleCount >= m_maximumResults)
+    return false;
+
+  ++titleCount;
+
+  if (takeOwnership)
+    GeoElementUtils::setParent(geoElement, this);
+
+  IdentifiedPopup popup;
+  popup.m_geoElement = geoElement;
+  popup.m_geoElementObject = GeoElementUtils::toQObject(geoElement);
+  popup.m_title = popupTitle;
+  popup.m_ownsGeoElement = takeOwnership;
+  m_popups.append(popup);
+
+  return true;
+}
+
+/*!
+  \internal
+
+  Creates the \l Esri::ArcGISRuntime::PopupManager for the popup at the current
+  index, unless it already exists or its GeoElement has been deleted.
+ */
+void IdentifyController::createCurrentPopupManager()
+{
+  if (m_currentPopupIndex < 0 || m_currentPopupIndex >= m_popups.size())
+    return;
+
+  IdentifiedPopup& popup = m_popups[m_currentPopupIndex];
+  if (popup.m_popupManager || !popup.m_geoElementObject)
+    return;
+
   // create a new Popup from the geoElement
-  Popup* newPopup = new Popup(geoElement, this);
-  newPopup->popupDefinition()->setTitle(popupTitle);
+  Popup* newPopup = new Popup(popup.m_geoElement, this);
+  newPopup->popupDefinition()->setTitle(popup.m_title);
   PopupManager* newManager = new PopupManager(newPopup, this);
+  newPopup->setParent(newManager);
 
   for (auto popupfield : newManager->displayedFields()->popupFields())
-  {    
+  {
     if (!popupfield->format())
     {
       auto format = new PopupFieldFormat(newManager);
@@ -321,9 +483,35 @@ bool IdentifyController::addGeoElementPopup(GeoElement* geoElement, const QStrin
     }
   }
 
-  m_popupManagers.push_back(newManager);
+  popup.m_popupManager = newManager;
+}
 
-  return true;
+/*!
+  \internal
+
+  Removes all of the popups, deleting the popup managers which were created and
+  the GeoElements owned by the tool.
+
+  The objects are deleted later, since the view may still refer to them.
+ */
+void IdentifyController::clearPopups()
+{
+  for (const IdentifiedPopup& popup : qAsConst(m_popups))
+  {
+    if (popup.m_popupManager)
+      popup.m_popupManager->deleteLater();
+
+    if (popup.m_ownsGeoElement && popup.m_geoElementObject)
+      popup.m_geoElementObject->deleteLater();
+  }
+
+  // the same layers and overlays tend to be identified on every tap, so the
+  // storage of the popups and the counts for each title are kept
+  m_popups.erase(m_popups.begin(), m_popups.end());
+  for (int& titleCount : m_popupCountsByTitle)
+    titleCount = 0;
+
+  m_currentPopupIndex = 0;
 }
 
 } // Dsa
@@ -336,6 +524,16 @@ bool IdentifyController::addGeoElementPopup(GeoElement* geoElement, const QStrin
 
 /*!
   \fn void IdentifyController::popupManagersChanged();
-  \brief Signal emitted when the popup managers change.
+  \brief Signal emitted when the popups change.
+ */
+
+/*!
+  \fn void IdentifyController::currentPopupIndexChanged();
+  \brief Signal emitted when the popup being viewed changes.
+ */
+
+/*!
+  \fn void IdentifyController::maximumResultsChanged();
+  \brief Signal emitted when the maximumResults property changes.
  */
 
@@ -20,12 +20,12 @@
 // toolkit headers
 #include "AbstractTool.h"
 
-// C++ API headers
-#include "TaskWatcher.h"
-
 // Qt headers
+#include <QHash>
 #include <QMouseEvent>
 #include <QObject>
+#include <QPointer>
+#include <QUuid>
 
 namespace Esri {
 namespace ArcGISRuntime {
@@ -38,12 +38,18 @@ class PopupManager;
 
 namespace Dsa {
 
+class GraphicsOverlayHitTester;
+
 class IdentifyController : public AbstractTool
 {
   Q_OBJECT
 
   Q_PROPERTY(bool busy READ busy NOTIFY busyChanged)
   Q_PROPERTY(QVariantList popupManagers READ popupManagers NOTIFY popupManagersChanged)
+  Q_PROPERTY(int popupCount READ popupCount NOTIFY popupManagersChanged)
+  Q_PROPERTY(int currentPopupIndex READ currentPopupIndex WRITE setCurrentPopupIndex NOTIFY currentPopupIndexChanged)
+  Q_PROPERTY(QObject* currentPopupManager READ currentPopupManager NOTIFY currentPopupIndexChanged)
+  Q_PROPERTY(int maximumResults READ maximumResults WRITE setMaximumResults NOTIFY maximumResultsChanged)
 
 public:
 
@@ -56,26 +62,51 @@ public:
 
   bool busy() const;
   QVariantList popupManagers() const;
+  int popupCount() const;
+
+  int currentPopupIndex() const;
+  void setCurrentPopupIndex(int currentPopupIndex);
+  QObject* currentPopupManager() const;
+
+  int maximumResults() const;
+  void setMaximumResults(int maximumResults);
 
   void showPopup(Esri::ArcGISRuntime::GeoElement* geoElement, const QString& popupTitle);
   void showPopups(const QHash<QString, QList<Esri::ArcGISRuntime::GeoElement*>>& geoElementsByTitle);
 
 private slots:
   void onMouseClicked(QMouseEvent& event);
-  void onIdentifyLayersCompleted(const QUuid& taskId, QList<Esri::ArcGISRuntime::IdentifyLayerResult*> identifyResults);
-  void onIdentifyGraphicsOverlaysCompleted(const QUuid& taskId, QList<Esri::ArcGISRuntime::IdentifyGraphicsOverlayResult*> identifyResults);
 
 signals:
   void busyChanged();
   void popupManagersChanged();
+  void currentPopupIndexChanged();
+  void maximumResultsChanged();
 
 private:
-  bool addGeoElementPopup(Esri::ArcGISRuntime::GeoElement* geoElement, const QString& popupTitle);
+  void onIdentifyLayersCompleted(const QList<Esri::ArcGISRuntime::IdentifyLayerResult*>& identifyResults);
+  void onIdentifyGraphicsOverlaysCompleted(const QList<Esri::ArcGISRuntime::IdentifyGraphicsOverlayResult*>& identifyResults);
+  bool addGeoElementPopup(Esri::ArcGISRuntime::GeoElement* geoElement, const QString& popupTitle, bool takeOwnership = false);
+  void createCurrentPopupManager();
+  void clearPopups();
+
+  struct IdentifiedPopup
+  {
+    Esri::ArcGISRuntime::GeoElement* m_geoElement = nullptr;
+    QPointer<QObject> m_geoElementObject;
+    QString m_title;
+    bool m_ownsGeoElement = false;
+    Esri::ArcGISRuntime::PopupManager* m_popupManager = nullptr;
+  };
 
   double m_tolerance = 5.0;
-  Esri::ArcGISRuntime::TaskWatcher m_layersWatcher;
-  Esri::ArcGISRuntime::TaskWatcher m_graphicsOverlaysWatcher;
-  QList<Esri::ArcGISRuntime::PopupManager*> m_popupManagers;
+  int m_maximumResults = 25;
+  int m_currentPopupIndex = 0;
+  GraphicsOverlayHitTester* m_hitTester = nullptr;
+  QUuid m_layersTaskId;
+  QUuid m_graphicsOverlaysTaskId;
+  QList<IdentifiedPopup> m_popups;
+  QHash<QString, int> m_popupCountsByTitle;
 };
 
 } // Dsa
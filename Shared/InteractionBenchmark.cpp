@@ -0,0 +1,598 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+
+// PCH header
+#include "pch.hpp"
+
+#include "InteractionBenchmark.h"
+
+// dsa app headers
+#include "MessageFeedStats.h"
+#include "MessageFeedsController.h"
+
+// toolkit headers
+#include "ToolManager.h"
+
+// C++ API headers
+#include "GeoView.h"
+
+// Qt headers
+#include <QCoreApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QMouseEvent>
+#include <QQuickItem>
+#include <QQuickWindow>
+#include <QTimer>
+#include <QUdpSocket>
+
+// STL headers
+#include <algorithm>
+#include <cmath>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+namespace {
+
+using MouseEventType = ToolResourceProvider::MouseEventType;
+
+const QList<QPair<MouseEventType, QString>> s_typeNames
+{
+  {MouseEventType::Clicked, QStringLiteral("clicked")},
+  {MouseEventType::Pressed, QStringLiteral("pressed")},
+  {MouseEventType::Moved, QStringLiteral("moved")},
+  {MouseEventType::Released, QStringLiteral("released")},
+  {MouseEventType::PressedAndHeld, QStringLiteral("pressedAndHeld")},
+  {MouseEventType::DoubleClicked, QStringLiteral("doubleClicked")}
+};
+
+QString typeName(MouseEventType eventType)
+{
+  for (const auto& typeName : s_typeNames)
+  {
+    if (typeName.first == eventType)
+      return typeName.second;
+  }
+
+  return QString();
+}
+
+bool typeFromName(const QString& name, MouseEventType& eventType)
+{
+  for (const auto& typeName : s_typeNames)
+  {
+    if (typeName.second == name)
+    {
+      eventType = typeName.first;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// the events which are sent to the window; clicks and presses and holds are
+// recognized by the geo view from these, as they were when recorded
+QEvent::Type windowEventType(MouseEventType eventType)
+{
+  switch (eventType)
+  {
+  case MouseEventType::Pressed:
+    return QEvent::MouseButtonPress;
+  case MouseEventType::Moved:
+    return QEvent::MouseMove;
+  case MouseEventType::Released:
+    return QEvent::MouseButtonRelease;
+  case MouseEventType::DoubleClicked:
+    return QEvent::MouseButtonDblClick;
+  default:
+    return QEvent::None;
+  }
+}
+
+// the interval at which the datagrams of the feed capture are sent, in ms
+constexpr int s_feedInterval = 10;
+
+// an event without a frame presented this long after it is counted as unanswered, in nsecs
+constexpr qint64 s_responseTimeout = 1000LL * 1000 * 1000;
+
+constexpr double s_nsecsPerMsec = 1000000.0;
+
+const QString s_timeKey = QStringLiteral("t");
+const QString s_typeKey = QStringLiteral("type");
+const QString s_xKey = QStringLiteral("x");
+const QString s_yKey = QStringLiteral("y");
+const QString s_buttonKey = QStringLiteral("button");
+const QString s_buttonsKey = QStringLiteral("buttons");
+const QString s_modifiersKey = QStringLiteral("modifiers");
+
+} // namespace
+
+const QString InteractionBenchmark::RESULT_PREFIX = QStringLiteral("DSA_INTERACTION_RESULT ");
+
+/*!
+  \class Dsa::InteractionBenchmark
+  \inmodule Dsa
+  \inherits QObject
+  \brief Records the mouse input of a session and replays it, optionally with a
+  capture of the message feeds, to measure how quickly the app responds.
+
+  While \l {startRecording}{recording}, every mouse event seen by the
+  \l ToolResourceProvider, whichever tool consumes it, is appended to a file as a line
+  of JSON with its time since the recording started, its type, its position in the
+  geo view and its buttons and modifiers.
+
+  A recording is replayed by sending its presses, moves, releases and double clicks
+  to the window at their recorded times, so that the geo view pans and zooms and
+  recognizes clicks and presses and holds as it did when recorded, and the tools
+  (markup sketching, identify, the context menu and navigation) receive them through
+  the \l ToolResourceProvider. A capture written with \c MessageFeedCaptureFile can be
+  replayed at the same time, its datagrams sent to the feed ports on the loopback
+  interface at their captured times, so the interaction is measured under load.
+
+  For each replayed event the latency to the next frame presented is measured, and
+  for each click or press and hold the latency to the next completed identify. The
+  time taken to render each frame and the interval between frames are also recorded.
+  Once the last event has been replayed and the \l settleTime has passed,
+  \l finished is emitted with the percentiles of each, in milliseconds, so that
+  builds can be compared.
+ */
+
+/*!
+  \brief Constructor taking the \a window whose frames are measured and an optional \a parent.
+ */
+InteractionBenchmark::InteractionBenchmark(QQuickWindow* window, QObject* parent) :
+  QObject(parent),
+  m_window(window),
+  m_replayTimer(new QTimer(this)),
+  m_feedTimer(new QTimer(this))
+{
+  m_clock.start();
+
+  m_replayTimer->setSingleShot(true);
+  m_replayTimer->setTimerType(Qt::PreciseTimer);
+  connect(m_replayTimer, &QTimer::timeout, this, &InteractionBenchmark::replayNext);
+
+  m_feedTimer->setInterval(s_feedInterval);
+  connect(m_feedTimer, &QTimer::timeout, this, &InteractionBenchmark::replayFeed);
+
+  ToolResourceProvider* toolResourceProvider = ToolResourceProvider::instance();
+  toolResourceProvider->setMouseEventObserver([this](MouseEventType eventType, const QMouseEvent& mouseEvent)
+  {
+    if (m_recordFile.isOpen())
+      recordEvent(eventType, mouseEvent);
+
+    if (m_running)
+      observeEvent(eventType);
+  });
+
+  connect(toolResourceProvider, &ToolResourceProvider::identifyLayersCompleted,
+          this, &InteractionBenchmark::observeIdentifyCompleted);
+  connect(toolResourceProvider, &ToolResourceProvider::identifyGraphicsOverlaysCompleted,
+          this, &InteractionBenchmark::observeIdentifyCompleted);
+
+  if (!m_window)
+    return;
+
+  // with the threaded render loop these are emitted on the render thread
+  m_windowConnections.append(connect(m_window, &QQuickWindow::beforeSynchronizing, this, [this]()
+  {
+    QMutexLocker locker(&m_frameMutex);
+    if (m_collectingFrames)
+      m_frameStart = m_clock.nsecsElapsed();
+  }, Qt::DirectConnection));
+
+  m_windowConnections.append(connect(m_window, &QQuickWindow::frameSwapped, this, [this]()
+  {
+    const qint64 now = m_clock.nsecsElapsed();
+    QMutexLocker locker(&m_frameMutex);
+    if (!m_collectingFrames)
+      return;
+
+    m_frameSwaps.append(now);
+    if (m_frameStart >= 0)
+      m_frameTimes.append(now - m_frameStart);
+
+    m_frameStart = -1;
+  }, Qt::DirectConnection));
+}
+
+/*!
+  \brief Destructor.
+ */
+InteractionBenchmark::~InteractionBenchmark()
+{
+  for (const auto& connection : qAsConst(m_windowConnections))
+    disconnect(connection);
+
+  ToolResourceProvider::instance()->setMouseEventObserver(ToolResourceProvider::MouseEventObserver());
+}
+
+/*!
+  \brief Starts recording the mouse input to the file at \a inputPath, replacing it.
+
+  Returns \c false if the file could not be created.
+ */
+bool InteractionBenchmark::startRecording(const QString& inputPath)
+{
+  stopRecording();
+
+  m_recordFile.setFileName(inputPath);
+  if (!m_recordFile.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+    return false;
+
+  m_recordClock.start();
+  return true;
+}
+
+/*!
+  \brief Stops recording the mouse input.
+ */
+void InteractionBenchmark::stopRecording()
+{
+  if (m_recordFile.isOpen())
+    m_recordFile.close();
+}
+
+/*!
+  \brief Returns whether the mouse input is being recorded.
+ */
+bool InteractionBenchmark::isRecording() const
+{
+  return m_recordFile.isOpen();
+}
+
+/*!
+  \brief Loads the mouse input recorded at \a inputPath for replay.
+
+  Returns \c false if the file could not be read or holds no events.
+ */
+bool InteractionBenchmark::loadInput(const QString& inputPath)
+{
+  QFile file(inputPath);
+  if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    return false;
+
+  m_inputEvents.clear();
+  while (!file.atEnd())
+  {
+    const QJsonObject eventJson = QJsonDocument::fromJson(file.readLine()).object();
+    InputEvent event;
+    if (eventJson.isEmpty() || !typeFromName(eventJson.value(s_typeKey).toString(), event.m_type))
+      continue;
+
+    event.m_time = static_cast<qint64>(eventJson.value(s_timeKey).toDouble());
+    event.m_position = QPointF(eventJson.value(s_xKey).toDouble(), eventJson.value(s_yKey).toDouble());
+    event.m_button = static_cast<Qt::MouseButton>(eventJson.value(s_buttonKey).toInt());
+    event.m_buttons = static_cast<Qt::MouseButtons>(eventJson.value(s_buttonsKey).toInt());
+    event.m_modifiers = static_cast<Qt::KeyboardModifiers>(eventJson.value(s_modifiersKey).toInt());
+    m_inputEvents.append(event);
+  }
+
+  m_inputPath = inputPath;
+  return !m_inputEvents.isEmpty();
+}
+
+/*!
+  \brief Loads the message feed capture at \a capturePath to replay with the input.
+
+  Returns \c false if the capture could not be opened.
+ */
+bool InteractionBenchmark::loadFeedCapture(const QString& capturePath)
+{
+  if (!m_captureReader.open(capturePath))
+    return false;
+
+  m_hasNextRecord = m_captureReader.readNext(m_nextRecord);
+  return true;
+}
+
+/*!
+  \brief Returns the time, in milliseconds, measured after the last event is replayed.
+ */
+int InteractionBenchmark::settleTime() const
+{
+  return m_settleTime;
+}
+
+/*!
+  \brief Sets the time, in milliseconds, measured after the last event is replayed
+  to \a settleTime, so that the responses to the last events are included.
+
+  The default is 2000.
+ */
+void InteractionBenchmark::setSettleTime(int settleTime)
+{
+  m_settleTime = qMax(0, settleTime);
+}
+
+/*!
+  \brief Starts replaying the loaded input and feed capture.
+ */
+void InteractionBenchmark::start()
+{
+  if (m_running || m_inputEvents.isEmpty())
+    return;
+
+  m_running = true;
+  m_nextEvent = 0;
+  m_replayedEvents.clear();
+  m_identifyLatencies.clear();
+  m_identifyStart = -1;
+  m_datagramsSent = 0;
+
+  {
+    QMutexLocker locker(&m_frameMutex);
+    m_frameSwaps.clear();
+    m_frameTimes.clear();
+    m_frameStart = -1;
+    m_collectingFrames = true;
+  }
+
+  m_replayStart = m_clock.elapsed();
+
+  if (m_hasNextRecord)
+  {
+    m_captureSocket = new QUdpSocket(this);
+    m_feedTimer->start();
+  }
+
+  m_replayTimer->start(static_cast<int>(m_inputEvents.constFirst().m_time));
+}
+
+/*!
+  \brief Returns whether the input is being replayed.
+ */
+bool InteractionBenchmark::isRunning() const
+{
+  return m_running;
+}
+
+/*!
+  \internal
+ */
+void InteractionBenchmark::recordEvent(MouseEventType eventType, const QMouseEvent& mouseEvent)
+{
+  QJsonObject eventJson;
+  eventJson.insert(s_timeKey, static_cast<double>(m_recordClock.elapsed()));
+  eventJson.insert(s_typeKey, typeName(eventType));
+  eventJson.insert(s_xKey, mouseEvent.localPos().x());
+  eventJson.insert(s_yKey, mouseEvent.localPos().y());
+  eventJson.insert(s_buttonKey, static_cast<int>(mouseEvent.button()));
+  eventJson.insert(s_buttonsKey, static_cast<int>(mouseEvent.buttons()));
+  eventJson.insert(s_modifiersKey, static_cast<int>(mouseEvent.modifiers()));
+
+  // one event per line, flushed so that a recording survives the app being killed
+  m_recordFile.write(QJsonDocument(eventJson).toJson(QJsonDocument::Compact) + '\n');
+  m_recordFile.flush();
+}
+
+/*!
+  \internal
+  \brief Notes the clicks and presses and holds recognized by the geo view, which
+  start an identify in most tools.
+ */
+void InteractionBenchmark::observeEvent(MouseEventType eventType)
+{
+  if (eventType == MouseEventType::Clicked || eventType == MouseEventType::PressedAndHeld)
+    m_identifyStart = m_clock.nsecsElapsed();
+}
+
+/*!
+  \internal
+  \brief Records the latency of the identify started by the last click, if any.
+ */
+void InteractionBenchmark::observeIdentifyCompleted()
+{
+  if (!m_running || m_identifyStart < 0)
+    return;
+
+  m_identifyLatencies.append(m_clock.nsecsElapsed() - m_identifyStart);
+  m_identifyStart = -1;
+}
+
+/*!
+  \internal
+  \brief Sends the next recorded event to the window and schedules the one after it.
+ */
+void InteractionBenchmark::replayNext()
+{
+  if (!m_running || m_nextEvent >= m_inputEvents.size())
+    return;
+
+  const InputEvent& event = m_inputEvents.at(m_nextEvent++);
+  const QEvent::Type type = windowEventType(event.m_type);
+  auto geoViewItem = dynamic_cast<QQuickItem*>(ToolResourceProvider::instance()->geoView());
+  if (type != QEvent::None && m_window && geoViewItem)
+  {
+    const QPointF windowPosition = geoViewItem->mapToScene(event.m_position);
+    const QPointF screenPosition = m_window->mapToGlobal(windowPosition.toPoint());
+    QMouseEvent mouseEvent(type, windowPosition, windowPosition, screenPosition,
+                           event.m_button, event.m_buttons, event.m_modifiers);
+
+    m_replayedEvents.append({event.m_type, m_clock.nsecsElapsed()});
+    QCoreApplication::sendEvent(m_window, &mouseEvent);
+  }
+
+  if (m_nextEvent < m_inputEvents.size())
+  {
+    const qint64 due = m_replayStart + m_inputEvents.at(m_nextEvent).m_time;
+    m_replayTimer->start(static_cast<int>(qMax(qint64(0), due - m_clock.elapsed())));
+  }
+  else
+  {
+    QTimer::singleShot(m_settleTime, this, &InteractionBenchmark::finish);
+  }
+}
+
+/*!
+  \internal
+  \brief Sends the datagrams of the feed capture which are due to the feed ports.
+ */
+void InteractionBenchmark::replayFeed()
+{
+  const qint64 playbackTime = (m_clock.elapsed() - m_replayStart) * 1000;
+  while (m_hasNextRecord && m_nextRecord.m_timestamp <= playbackTime)
+  {
+    if (m_captureSocket->writeDatagram(m_nextRecord.m_datagram, QHostAddress::LocalHost, m_nextRecord.m_port) != -1)
+      ++m_datagramsSent;
+
+    m_hasNextRecord = m_captureReader.readNext(m_nextRecord);
+  }
+
+  if (!m_hasNextRecord)
+    m_feedTimer->stop();
+}
+
+/*!
+  \internal
+ */
+void InteractionBenchmark::finish()
+{
+  if (!m_running)
+    return;
+
+  m_running = false;
+  m_feedTimer->stop();
+  delete m_captureSocket;
+  m_captureSocket = nullptr;
+
+  QVector<qint64> frameSwaps;
+  QVector<qint64> frameTimes;
+  {
+    QMutexLocker locker(&m_frameMutex);
+    m_collectingFrames = false;
+    frameSwaps = m_frameSwaps;
+    frameTimes = m_frameTimes;
+  }
+
+  QJsonObject result;
+  result.insert(QStringLiteral("input"), m_inputPath);
+  result.insert(QStringLiteral("events"), m_replayedEvents.size());
+  result.insert(QStringLiteral("duration"), static_cast<double>(m_clock.elapsed() - m_replayStart));
+  result.insert(QStringLiteral("datagrams"), static_cast<double>(m_datagramsSent));
+
+  QVector<qint64> eventTimestamps;
+  eventTimestamps.reserve(m_replayedEvents.size());
+  for (const ReplayedEvent& event : qAsConst(m_replayedEvents))
+    eventTimestamps.append(event.m_timestamp);
+
+  const QVector<qint64> latencies = responseLatencies(eventTimestamps, frameSwaps);
+  QVector<qint64> answeredLatencies;
+  for (const qint64 latency : latencies)
+  {
+    if (latency >= 0)
+      answeredLatencies.append(latency);
+  }
+
+  result.insert(QStringLiteral("latency"), percentiles(answeredLatencies));
+  result.insert(QStringLiteral("unanswered"), latencies.size() - answeredLatencies.size());
+
+  QJsonObject latencyByType;
+  for (const auto& type : s_typeNames)
+  {
+    QVector<qint64> typeLatencies;
+    for (int i = 0; i < m_replayedEvents.size(); ++i)
+    {
+      if (m_replayedEvents.at(i).m_type == type.first && latencies.at(i) >= 0)
+        typeLatencies.append(latencies.at(i));
+    }
+
+    if (!typeLatencies.isEmpty())
+      latencyByType.insert(type.second, percentiles(typeLatencies));
+  }
+  result.insert(QStringLiteral("latencyByType"), latencyByType);
+  result.insert(QStringLiteral("identifyLatency"), percentiles(m_identifyLatencies));
+
+  QVector<qint64> frameIntervals;
+  for (int i = 1; i < frameSwaps.size(); ++i)
+    frameIntervals.append(frameSwaps.at(i) - frameSwaps.at(i - 1));
+
+  result.insert(QStringLiteral("frames"), frameSwaps.size());
+  result.insert(QStringLiteral("frameTime"), percentiles(frameTimes));
+  result.insert(QStringLiteral("frameInterval"), percentiles(frameIntervals));
+
+  MessageFeedsController* messageFeeds = ToolManager::instance().tool<MessageFeedsController>();
+  auto ingestStats = messageFeeds ? qobject_cast<MessageFeedStats*>(messageFeeds->ingestStats()) : nullptr;
+  if (ingestStats)
+    result.insert(QStringLiteral("messagesReceived"), static_cast<double>(ingestStats->receivedCount()));
+
+  emit finished(result);
+}
+
+/*!
+  \internal
+  \brief Returns, for each of the sorted \a eventTimestamps, the time to the first of
+  the sorted \a frameSwaps after it, or \c -1 if there was none in time.
+ */
+QVector<qint64> InteractionBenchmark::responseLatencies(const QVector<qint64>& eventTimestamps, const QVector<qint64>& frameSwaps) const
+{
+  QVector<qint64> latencies;
+  latencies.reserve(eventTimestamps.size());
+  for (const qint64 eventTimestamp : eventTimestamps)
+  {
+    const auto swapIt = std::upper_bound(frameSwaps.cbegin(), frameSwaps.cend(), eventTimestamp);
+    if (swapIt == frameSwaps.cend() || *swapIt - eventTimestamp > s_responseTimeout)
+      latencies.append(-1);
+    else
+      latencies.append(*swapIt - eventTimestamp);
+  }
+
+  return latencies;
+}
+
+/*!
+  \brief Returns the count, mean, median, 90th, 95th and 99th percentiles and maximum
+  of \a nsecs, in milliseconds.
+ */
+QJsonObject InteractionBenchmark::percentiles(QVector<qint64> nsecs)
+{
+  QJsonObject result;
+  result.insert(QStringLiteral("count"), nsecs.size());
+  if (nsecs.isEmpty())
+    return result;
+
+  std::sort(nsecs.begin(), nsecs.end());
+
+  double total = 0.0;
+  for (const qint64 value : qAsConst(nsecs))
+    total += value;
+
+  auto percentile = [&nsecs](double fraction)
+  {
+    const int index = qBound(0, static_cast<int>(std::ceil(fraction * nsecs.size())) - 1, nsecs.size() - 1);
+    return nsecs.at(index) / s_nsecsPerMsec;
+  };
+
+  result.insert(QStringLiteral("mean"), total / nsecs.size() / s_nsecsPerMsec);
+  result.insert(QStringLiteral("p50"), percentile(0.50));
+  result.insert(QStringLiteral("p90"), percentile(0.90));
+  result.insert(QStringLiteral("p95"), percentile(0.95));
+  result.insert(QStringLiteral("p99"), percentile(0.99));
+  result.insert(QStringLiteral("max"), nsecs.constLast() / s_nsecsPerMsec);
+  return result;
+}
+
+} // Dsa
+
+// Signal Documentation
+/*!
+  \fn void InteractionBenchmark::finished(const QJsonObject& result);
+  \brief Signal emitted with the \a result once the replay has finished.
+ */
@@ -0,0 +1,135 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+
+#ifndef INTERACTIONBENCHMARK_H
+#define INTERACTIONBENCHMARK_H
+
+// dsa app headers
+#include "DatagramCaptureReader.h"
+#include "ToolResourceProvider.h"
+
+// Qt headers
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonObject>
+#include <QMutex>
+#include <QObject>
+#include <QPointer>
+#include <QVector>
+
+class QQuickWindow;
+class QTimer;
+class QUdpSocket;
+
+namespace Dsa {
+
+class InteractionBenchmark : public QObject
+{
+  Q_OBJECT
+
+public:
+  // a mouse event as seen by the ToolResourceProvider, in the coordinates of the geo view
+  struct InputEvent
+  {
+    qint64 m_time = 0; // msecs since the recording started
+    ToolResourceProvider::MouseEventType m_type = ToolResourceProvider::MouseEventType::Pressed;
+    QPointF m_position;
+    Qt::MouseButton m_button = Qt::NoButton;
+    Qt::MouseButtons m_buttons = Qt::NoButton;
+    Qt::KeyboardModifiers m_modifiers = Qt::NoModifier;
+  };
+
+  explicit InteractionBenchmark(QQuickWindow* window, QObject* parent = nullptr);
+  ~InteractionBenchmark();
+
+  static const QString RESULT_PREFIX;
+
+  bool startRecording(const QString& inputPath);
+  void stopRecording();
+  bool isRecording() const;
+
+  bool loadInput(const QString& inputPath);
+  bool loadFeedCapture(const QString& capturePath);
+
+  int settleTime() const;
+  void setSettleTime(int settleTime);
+
+  void start();
+  bool isRunning() const;
+
+  static QJsonObject percentiles(QVector<qint64> nsecs);
+
+signals:
+  void finished(const QJsonObject& result);
+
+private:
+  Q_DISABLE_COPY(InteractionBenchmark)
+
+  struct ReplayedEvent
+  {
+    ToolResourceProvider::MouseEventType m_type = ToolResourceProvider::MouseEventType::Pressed;
+    qint64 m_timestamp = 0; // nsecs on m_clock
+  };
+
+  void recordEvent(ToolResourceProvider::MouseEventType eventType, const QMouseEvent& mouseEvent);
+  void observeEvent(ToolResourceProvider::MouseEventType eventType);
+  void observeIdentifyCompleted();
+  void replayNext();
+  void replayFeed();
+  void finish();
+  QVector<qint64> responseLatencies(const QVector<qint64>& eventTimestamps, const QVector<qint64>& frameSwaps) const;
+
+  QPointer<QQuickWindow> m_window;
+  QList<QMetaObject::Connection> m_windowConnections;
+  QElapsedTimer m_clock;
+
+  // recording
+  QFile m_recordFile;
+  QElapsedTimer m_recordClock;
+
+  // replay
+  QString m_inputPath;
+  QVector<InputEvent> m_inputEvents;
+  int m_nextEvent = 0;
+  QTimer* m_replayTimer = nullptr;
+  qint64 m_replayStart = 0;
+  int m_settleTime = 2000;
+  bool m_running = false;
+
+  DatagramCaptureReader m_captureReader;
+  DatagramCaptureReader::Record m_nextRecord;
+  bool m_hasNextRecord = false;
+  QUdpSocket* m_captureSocket = nullptr;
+  QTimer* m_feedTimer = nullptr;
+  qint64 m_datagramsSent = 0;
+
+  // written on the GUI thread while replaying
+  QVector<ReplayedEvent> m_replayedEvents;
+  qint64 m_identifyStart = -1;
+  QVector<qint64> m_identifyLatencies;
+
+  // written on the render thread while replaying
+  mutable QMutex m_frameMutex;
+  bool m_collectingFrames = false;
+  qint64 m_frameStart = -1;
+  QVector<qint64> m_frameSwaps;
+  QVector<qint64> m_frameTimes;
+};
+
+} // Dsa
+
+#endif // INTERACTIONBENCHMARK_H
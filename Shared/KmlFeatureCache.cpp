@@ -0,0 +1,255 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "KmlFeatureCache.h"
+
+// C++ API headers
+#include "KmlContainer.h"
+#include "KmlDataset.h"
+#include "KmlGeometry.h"
+#include "KmlNode.h"
+#include "KmlPlacemark.h"
+
+// Qt headers
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThreadPool>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+const QString KmlFeatureCache::NAME_KEY = QStringLiteral("name");
+const QString KmlFeatureCache::DESCRIPTION_KEY = QStringLiteral("description");
+const QString KmlFeatureCache::GEOMETRY_KEY = QStringLiteral("geometry");
+const QString KmlFeatureCache::PLACEMARKS_KEY = QStringLiteral("placemarks");
+
+/*!
+  \class Dsa::KmlFeatureCache
+  \inmodule Dsa
+  \inherits QObject
+  \brief A cache of the placemarks of large KML files, so that they can be restored
+  as features without parsing the KML again.
+
+  Once a KML dataset has loaded it can be \l {store}{stored}: the name, description
+  and geometry of each of its placemarks are written to a JSON document on a background
+  thread. On later launches the document is \l {read} instead, and drawn by a
+  \l KmlFeatureLayer, whose tables are indexed by the runtime.
+
+  The placemarks are drawn without their KML styles, so only datasets with at least
+  1000 placemarks, where parsing is slow, are stored. Datasets with network links or
+  overlays are never stored, as those cannot be drawn as features.
+
+  Each document is keyed by the path, size and modification time of its KML file,
+  so a file which is changed is converted again.
+ */
+
+/*!
+  \brief Returns the singleton instance of the cache.
+ */
+KmlFeatureCache* KmlFeatureCache::instance()
+{
+  static KmlFeatureCache s_instance;
+
+  return &s_instance;
+}
+
+/*!
+  \internal
+ */
+KmlFeatureCache::KmlFeatureCache(QObject* parent):
+  QObject(parent),
+  m_cacheDirectory(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/kml_features"),
+  m_threadPool(new QThreadPool(this))
+{
+  // files are written one at a time so that they do not compete with the app for cores
+  m_threadPool->setMaxThreadCount(1);
+}
+
+/*!
+  \brief Destructor.
+ */
+KmlFeatureCache::~KmlFeatureCache()
+{
+  m_threadPool->waitForDone();
+}
+
+/*!
+  \brief Reads the cached placemarks of the KML file at \a kmlPath into \a document.
+
+  Returns \c false if the file has not been cached, it has changed since, or its
+  document is still being written.
+ */
+bool KmlFeatureCache::read(const QString& kmlPath, QJsonObject& document) const
+{
+  const QString path = cachePath(kmlPath);
+  if (path.isEmpty() || m_pendingPaths.contains(path))
+    return false;
+
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly))
+    return false;
+
+  const QJsonObject cached = QJsonDocument::fromJson(file.readAll()).object();
+  if (!cached.value(PLACEMARKS_KEY).isArray())
+    return false;
+
+  document = cached;
+  return true;
+}
+
+/*!
+  \brief Stores the placemarks of \a kmlDataset, which was loaded from \a kmlPath.
+
+  The dataset must have loaded. The document is written on a background thread.
+
+  Returns \c false if the dataset is not worth converting or cannot be converted.
+ */
+bool KmlFeatureCache::store(const QString& kmlPath, KmlDataset* kmlDataset)
+{
+  const QString path = cachePath(kmlPath);
+  if (path.isEmpty() || !kmlDataset || m_pendingPaths.contains(path) || QFileInfo::exists(path))
+    return false;
+
+  QJsonArray placemarks;
+  for (KmlNode* node : kmlDataset->rootNodes())
+  {
+    if (!appendPlacemarks(node, placemarks))
+      return false;
+  }
+
+  if (placemarks.size() < s_minimumPlacemarks)
+    return false;
+
+  QJsonObject document;
+  document.insert(NAME_KEY, QFileInfo(kmlPath).completeBaseName());
+  document.insert(PLACEMARKS_KEY, placemarks);
+
+  m_pendingPaths.insert(path);
+
+  const QByteArray json = QJsonDocument(document).toJson(QJsonDocument::Compact);
+  const QString cacheDirectory = m_cacheDirectory;
+  m_threadPool->start([this, json, path, cacheDirectory]()
+  {
+    if (QDir().mkpath(cacheDirectory))
+    {
+      QSaveFile file(path);
+      if (file.open(QIODevice::WriteOnly))
+      {
+        file.write(json);
+        file.commit();
+      }
+    }
+
+    QMetaObject::invokeMethod(this, [this, path]()
+    {
+      m_pendingPaths.remove(path);
+    }, Qt::QueuedConnection);
+  });
+
+  return true;
+}
+
+/*!
+  \brief Returns the directory where the placemarks are cached.
+ */
+QString KmlFeatureCache::cacheDirectory() const
+{
+  return m_cacheDirectory;
+}
+
+/*!
+  \brief Sets the directory where the placemarks are cached to \a cacheDirectory.
+ */
+void KmlFeatureCache::setCacheDirectory(const QString& cacheDirectory)
+{
+  m_cacheDirectory = cacheDirectory;
+}
+
+/*!
+  \internal
+
+  Returns the file the placemarks of the KML file at \a kmlPath are cached in, or an
+  empty string if there is no such file.
+ */
+QString KmlFeatureCache::cachePath(const QString& kmlPath) const
+{
+  const QFileInfo kmlInfo(kmlPath);
+  if (!kmlInfo.isFile())
+    return QString();
+
+  const QString key = QString("%1|%2|%3").arg(kmlInfo.absoluteFilePath(),
+                                              QString::number(kmlInfo.size()),
+                                              QString::number(kmlInfo.lastModified().toMSecsSinceEpoch()));
+  const QByteArray hash = QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1).toHex();
+  return QString("%1/%2.json").arg(m_cacheDirectory, QString::fromLatin1(hash));
+}
+
+/*!
+  \internal
+
+  Appends the placemarks in \a node and its children to \a placemarks.
+
+  Returns \c false if \a node holds content which cannot be drawn as features.
+ */
+bool KmlFeatureCache::appendPlacemarks(KmlNode* node, QJsonArray& placemarks)
+{
+  if (!node)
+    return true;
+
+  if (auto placemark = dynamic_cast<KmlPlacemark*>(node))
+  {
+    for (const KmlGeometry& kmlGeometry : placemark->geometries())
+    {
+      const Geometry geometry = kmlGeometry.geometry();
+      if (geometry.isEmpty())
+        continue;
+
+      QJsonObject placemarkJson;
+      placemarkJson.insert(NAME_KEY, placemark->name());
+      placemarkJson.insert(DESCRIPTION_KEY, placemark->description());
+      placemarkJson.insert(GEOMETRY_KEY, QJsonDocument::fromJson(geometry.toJson().toUtf8()).object());
+      placemarks.append(placemarkJson);
+    }
+
+    return true;
+  }
+
+  if (auto container = dynamic_cast<KmlContainer*>(node))
+  {
+    for (KmlNode* childNode : container->childNodes())
+    {
+      if (!appendPlacemarks(childNode, placemarks))
+        return false;
+    }
+
+    return true;
+  }
+
+  // network links, overlays and tours
+  return false;
+}
+
+} // Dsa
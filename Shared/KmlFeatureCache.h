@@ -0,0 +1,74 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef KMLFEATURECACHE_H
+#define KMLFEATURECACHE_H
+
+// Qt headers
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QObject>
+#include <QSet>
+#include <QString>
+
+class QThreadPool;
+
+namespace Esri {
+namespace ArcGISRuntime {
+class KmlDataset;
+class KmlNode;
+}
+}
+
+namespace Dsa {
+
+class KmlFeatureCache : public QObject
+{
+  Q_OBJECT
+
+public:
+  static KmlFeatureCache* instance();
+
+  ~KmlFeatureCache();
+
+  bool read(const QString& kmlPath, QJsonObject& document) const;
+  bool store(const QString& kmlPath, Esri::ArcGISRuntime::KmlDataset* kmlDataset);
+
+  QString cacheDirectory() const;
+  void setCacheDirectory(const QString& cacheDirectory);
+
+  static const QString NAME_KEY;
+  static const QString DESCRIPTION_KEY;
+  static const QString GEOMETRY_KEY;
+  static const QString PLACEMARKS_KEY;
+
+private:
+  explicit KmlFeatureCache(QObject* parent = nullptr);
+  Q_DISABLE_COPY(KmlFeatureCache)
+
+  QString cachePath(const QString& kmlPath) const;
+  static bool appendPlacemarks(Esri::ArcGISRuntime::KmlNode* node, QJsonArray& placemarks);
+
+  static constexpr int s_minimumPlacemarks = 1000;
+
+  QString m_cacheDirectory;
+  QThreadPool* m_threadPool = nullptr;
+  QSet<QString> m_pendingPaths;
+};
+
+} // Dsa
+
+#endif // KMLFEATURECACHE_H
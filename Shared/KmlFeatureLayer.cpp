@@ -0,0 +1,148 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "KmlFeatureLayer.h"
+
+// dsa app headers
+#include "KmlFeatureCache.h"
+
+// C++ API headers
+#include "Feature.h"
+#include "FeatureCollection.h"
+#include "FeatureCollectionTable.h"
+#include "FeatureCollectionTableListModel.h"
+#include "Field.h"
+#include "SimpleFillSymbol.h"
+#include "SimpleLineSymbol.h"
+#include "SimpleMarkerSymbol.h"
+#include "SimpleRenderer.h"
+
+// Qt headers
+#include <QJsonArray>
+#include <QJsonDocument>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+/*!
+  \class Dsa::KmlFeatureLayer
+  \inmodule Dsa
+  \inherits Esri::ArcGISRuntime::FeatureCollectionLayer
+  \brief A layer drawing the placemarks of a KML file from the \l KmlFeatureCache.
+
+  The placemarks are held in one table for each type of geometry, with the name and
+  description of each placemark as attributes, and are drawn with simple symbols.
+  The layer keeps the path of its KML file, so that it is saved and restored as the
+  KML file.
+ */
+
+/*!
+ \internal
+ \brief Constructor that takes the \a path of the KML file, a \a featureCollection and an optional \a parent.
+ */
+KmlFeatureLayer::KmlFeatureLayer(const QString& path, FeatureCollection* featureCollection, QObject* parent) :
+  FeatureCollectionLayer(featureCollection, parent),
+  m_path(path)
+{
+}
+
+/*!
+ \brief Destructor
+ */
+KmlFeatureLayer::~KmlFeatureLayer()
+{
+}
+
+/*!
+ \brief Creates a layer for the KML file at \a path from its cached \a document, with an optional \a parent.
+ */
+KmlFeatureLayer* KmlFeatureLayer::createFromDocument(const QString& path, const QJsonObject& document, QObject* parent)
+{
+  const QList<GeometryType> geometryTypes{GeometryType::Point, GeometryType::Polyline, GeometryType::Polygon};
+
+  // group the placemarks by the type of their geometry
+  QHash<GeometryType, QList<QPair<QVariantMap, Geometry>>> placemarks;
+  QHash<GeometryType, bool> hasZ;
+  const QJsonArray placemarksJson = document.value(KmlFeatureCache::PLACEMARKS_KEY).toArray();
+  for (const QJsonValue& placemarkValue : placemarksJson)
+  {
+    const QJsonObject placemarkJson = placemarkValue.toObject();
+    const QString geometryJson = QJsonDocument(placemarkJson.value(KmlFeatureCache::GEOMETRY_KEY).toObject()).toJson(QJsonDocument::Compact);
+    const Geometry geometry = Geometry::fromJson(geometryJson);
+    if (geometry.isEmpty() || !geometryTypes.contains(geometry.geometryType()))
+      continue;
+
+    QVariantMap attributes;
+    attributes.insert(KmlFeatureCache::NAME_KEY, placemarkJson.value(KmlFeatureCache::NAME_KEY).toString());
+    attributes.insert(KmlFeatureCache::DESCRIPTION_KEY, placemarkJson.value(KmlFeatureCache::DESCRIPTION_KEY).toString());
+    placemarks[geometry.geometryType()].append(qMakePair(attributes, geometry));
+    hasZ[geometry.geometryType()] = hasZ.value(geometry.geometryType()) || geometry.hasZ();
+  }
+
+  const QList<Field> fields{Field::createText(KmlFeatureCache::NAME_KEY, KmlFeatureCache::NAME_KEY, 256),
+                            Field::createText(KmlFeatureCache::DESCRIPTION_KEY, KmlFeatureCache::DESCRIPTION_KEY, 4096)};
+
+  QList<FeatureCollectionTable*> tables;
+  for (GeometryType geometryType : geometryTypes)
+  {
+    const auto& typePlacemarks = placemarks.value(geometryType);
+    if (typePlacemarks.isEmpty())
+      continue;
+
+    FeatureCollectionTable* table = new FeatureCollectionTable(fields, geometryType, SpatialReference::wgs84(),
+                                                               hasZ.value(geometryType), false, parent);
+
+    SimpleRenderer* renderer = new SimpleRenderer(table);
+    if (geometryType == GeometryType::Point)
+      renderer->setSymbol(new SimpleMarkerSymbol(SimpleMarkerSymbolStyle::Circle, QColor("yellow"), 8.0f, renderer));
+    else if (geometryType == GeometryType::Polyline)
+      renderer->setSymbol(new SimpleLineSymbol(SimpleLineSymbolStyle::Solid, QColor("yellow"), 2.0f, renderer));
+    else
+      renderer->setSymbol(new SimpleFillSymbol(SimpleFillSymbolStyle::Solid, QColor(255, 255, 0, 64),
+                                               new SimpleLineSymbol(SimpleLineSymbolStyle::Solid, QColor("yellow"), 1.0f, renderer), renderer));
+    table->setRenderer(renderer);
+
+    // add the features of each table in one call
+    QList<Feature*> features;
+    features.reserve(typePlacemarks.size());
+    for (const auto& placemark : typePlacemarks)
+      features.append(table->createFeature(placemark.first, placemark.second, table));
+
+    table->addFeatures(features);
+    tables.append(table);
+  }
+
+  FeatureCollection* featureCollection = new FeatureCollection(tables, parent);
+
+  KmlFeatureLayer* kmlFeatureLayer = new KmlFeatureLayer(path, featureCollection, parent);
+  kmlFeatureLayer->setName(document.value(KmlFeatureCache::NAME_KEY).toString());
+
+  return kmlFeatureLayer;
+}
+
+/*!
+ \brief Returns the path of the KML file the layer draws.
+*/
+QString KmlFeatureLayer::path() const
+{
+  return m_path;
+}
+
+} // Dsa
@@ -0,0 +1,54 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef KMLFEATURELAYER_H
+#define KMLFEATURELAYER_H
+
+// C++ API headers
+#include "FeatureCollectionLayer.h"
+
+// Qt headers
+#include <QJsonObject>
+
+namespace Esri {
+namespace ArcGISRuntime {
+class FeatureCollection;
+class FeatureCollectionTable;
+}
+}
+
+namespace Dsa {
+
+class KmlFeatureLayer : public Esri::ArcGISRuntime::FeatureCollectionLayer
+{
+  Q_OBJECT
+
+public:
+  ~KmlFeatureLayer();
+
+  static KmlFeatureLayer* createFromDocument(const QString& path, const QJsonObject& document, QObject* parent = nullptr);
+
+  QString path() const;
+
+private:
+  KmlFeatureLayer(const QString& path, Esri::ArcGISRuntime::FeatureCollection* featureCollection, QObject* parent = nullptr);
+
+  QString m_path;
+};
+
+} // Dsa
+
+#endif // KMLFEATURELAYER_H
@@ -22,8 +22,11 @@
 
 // dsa app headers
 #include "AddLocalDataController.h"
+#include "AllocationCounter.h"
+#include "KmlFeatureLayer.h"
 #include "OpenMobileScenePackageController.h"
 #include "MarkupLayer.h"
+#include "TraceRecorder.h"
 
 // toolkit headers
 #include "AbstractTool.h"
@@ -51,6 +54,10 @@
 #include <QDir>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QTimer>
+
+// STL headers
+#include <algorithm>
 
 namespace Dsa {
 
@@ -71,14 +78,25 @@ using namespace Esri::ArcGISRuntime;
   \inmodule Dsa
   \inherits AbstractTool
   \brief Tool controller responsible for managing the layers in the app.
+
+  Layers saved in the app properties are restored concurrently: every dataset is
+  opened and every layer is loaded at once, and each layer is added to the scene as
+  soon as it has loaded. Layers are inserted relative to the layers already restored,
+  so the saved draw order is kept whichever layer finishes first. Progress is reported
+  through \l restoreProgressChanged until \l restoreCompleted is emitted.
  */
 
 /*!
  \brief Constructor that takes an optional \a parent.
  */
 LayerCacheManager::LayerCacheManager(QObject* parent) :
-  AbstractTool(parent)
+  AbstractTool(parent),
+  m_persistTimer(new QTimer(this))
 {
+  m_persistTimer->setSingleShot(true);
+  m_persistTimer->setInterval(s_persistInterval);
+  connect(m_persistTimer, &QTimer::timeout, this, &LayerCacheManager::persistLayers);
+
   // obtain Add Local Data Controller
   m_localDataController = ToolManager::instance().tool<AddLocalDataController>();
 
@@ -87,8 +105,9 @@ LayerCacheManager::LayerCacheManager(QObject* parent) :
   {
     m_scene = ToolResourceProvider::instance()->scene();
     m_layers = QJsonArray();
+    m_layerJsonCache.clear();
     m_inputLayerJsonArray = QJsonArray();
-    m_initialLayerCache.clear();
+    m_restoredLayers.clear();
     connectSignals();
 
     // only add initial layers on initial load. Once the user selects a new scene, the layer list will be cleared
@@ -175,6 +194,22 @@ void LayerCacheManager::jsonToLayer(const QJsonObject& jsonObject, const int lay
  Obtain the updated JSON from \l layerJson() after layerJsonChanged() emits.
  */
 void LayerCacheManager::layerToJson(Layer* layer)
+{
+  const QJsonObject layerJson = createLayerJson(layer);
+  if (layerJson.isEmpty())
+    return;
+
+  m_layers.append(layerJson);
+
+  emit layerJsonChanged();
+}
+
+/*!
+ \internal
+
+ Returns the JSON for \a layer, or an empty object if the layer should not be saved.
+ */
+QJsonObject LayerCacheManager::createLayerJson(Layer* layer) const
 {
   QString layerPath;
   QString layerType;
@@ -255,12 +290,17 @@ void LayerCacheManager::layerToJson(Layer* layer)
     layerPath = kmlUrl.isLocalFile() ? kmlUrl.toLocalFile() : kmlUrl.toString();
   }
 
+  // KML files drawn from the KmlFeatureCache are saved as the KML file
+  auto kmlFeatureLayer = dynamic_cast<KmlFeatureLayer*>(layer);
+  if (kmlFeatureLayer)
+    layerPath = kmlFeatureLayer->path();
+
   // Don't serialize invalid layers or local files that don't actually exist in the file system.
   auto isMissing = QUrl::fromUserInput(layerPath, QDir::currentPath(), QUrl::AssumeLocalFile).isLocalFile()
                  && !QFileInfo(layerPath).exists();
   if (layerPath.isEmpty() || isMissing)
   {
-    return;
+    return QJsonObject();
   }
 
   // Don't serialize data in excluded path locations
@@ -270,7 +310,7 @@ void LayerCacheManager::layerToJson(Layer* layer)
       continue;
 
     if (layerPath.startsWith(excludedPath))
-      return;
+      return QJsonObject();
   }
 
   // add the layer to the layer list for caching
@@ -282,34 +322,97 @@ void LayerCacheManager::layerToJson(Layer* layer)
   if (layerType.length() > 0)
     layerJson.insert(layerTypeKey, layerType);
 
-  m_layers.append(layerJson);
-
-  emit layerJsonChanged();
+  return layerJson;
 }
 
 /*!
- \brief Resets and recreates the layer JSON array and writes it to the app properties.
+ \brief Schedules the layer JSON array to be recreated and written to the app properties.
+
+ Changes are batched, so the layer list is written at most once per second however
+ many changes are made.
 */
 void LayerCacheManager::onLayerListChanged()
+{
+  DSA_TRACE_SCOPE("LayerCacheManager::onLayerListChanged");
+  DSA_ALLOCATION_SCOPE(Layers);
+
+  if (!m_persistTimer->isActive())
+    m_persistTimer->start();
+}
+
+/*!
+ \brief Writes any batched changes to the layer list immediately.
+*/
+void LayerCacheManager::flush()
+{
+  if (!m_persistTimer->isActive())
+    return;
+
+  m_persistTimer->stop();
+  persistLayers();
+}
+
+/*!
+ \internal
+
+ Discards the cached JSON for the layers from \a firstRow to \a lastRow,
+ so that they are serialized again when the layer list is next written.
+*/
+void LayerCacheManager::invalidateLayers(int firstRow, int lastRow)
 {
   m_scene = ToolResourceProvider::instance()->scene();
-  if (!m_initialLoadCompleted)
+  if (!m_scene)
     return;
 
-  // clear the JSON
-  m_layers = QJsonArray();
+  const auto operationalLayers = m_scene->operationalLayers();
+  for (int i = std::max(0, firstRow); i <= lastRow && i < operationalLayers->size(); i++)
+    m_layerJsonCache.remove(operationalLayers->at(i));
+}
+
+/*!
+ \internal
+
+ Recreates the layer JSON array, serializing only the layers which are not cached,
+ and writes it to the app properties if it has changed.
+*/
+void LayerCacheManager::persistLayers()
+{
+  DSA_TRACE_SCOPE("LayerCacheManager::persistLayers");
+  DSA_ALLOCATION_SCOPE(Layers);
+
+  m_scene = ToolResourceProvider::instance()->scene();
+
+  // a partially restored layer list is not written until the restore completes
+  if (!m_initialLoadCompleted || isRestoring() || !m_scene)
+    return;
 
   const auto operationalLayers = m_scene->operationalLayers();
   if (!operationalLayers)
     return;
 
-  // update the JSON array
+  // update the JSON array, keeping only the cached JSON of layers still in the list
+  QJsonArray layers;
+  QHash<Layer*, QJsonObject> layerJsonCache;
   const int count = operationalLayers->size();
   for (int i = 0; i < count; i++)
   {
-    layerToJson(operationalLayers->at(i));
+    Layer* layer = operationalLayers->at(i);
+    const auto findIt = m_layerJsonCache.constFind(layer);
+    const QJsonObject layerJson = findIt != m_layerJsonCache.constEnd() ? findIt.value() : createLayerJson(layer);
+    layerJsonCache.insert(layer, layerJson);
+
+    if (!layerJson.isEmpty())
+      layers.append(layerJson);
   }
 
+  m_layerJsonCache = layerJsonCache;
+
+  if (layers == m_layers)
+    return;
+
+  m_layers = layers;
+  emit layerJsonChanged();
+
   // write to the config file
   emit propertyChanged(LAYERS_PROPERTYNAME, m_layers.toVariantList());
 }
@@ -329,6 +432,10 @@ void LayerCacheManager::addExcludedPath(const QString& exludedPath)
 
 void LayerCacheManager::addElevation(const QVariantMap& properties)
 {
+  // a 2D map has no surface, so the elevation sources are not loaded at all
+  if (ToolResourceProvider::instance()->map())
+    return;
+
   const QVariant elevationData = properties.value(ELEVATION_PROPERTYNAME);
   const QStringList pathList = elevationData.toStringList();
 
@@ -354,10 +461,25 @@ void LayerCacheManager::addElevation(const QVariantMap& properties)
 
 void LayerCacheManager::addLayers(const QVariantMap& properties)
 {
+  DSA_TRACE_SCOPE("LayerCacheManager::addLayers");
+  DSA_ALLOCATION_SCOPE(Layers);
+
   const QVariant layersData = properties.value(LAYERS_PROPERTYNAME);
   const auto layersList = layersData.toList();
   m_inputLayerJsonArray = QJsonArray::fromVariantList(layersList);
+  m_restoredLayers.clear();
+  m_restoredLayerCount = 0;
+  m_restoreLayerCount = 0;
+
+  for (const QJsonValue& jsonVal : qAsConst(m_inputLayerJsonArray))
+  {
+    if (!jsonVal.toObject().isEmpty())
+      m_restoreLayerCount++;
+  }
 
+  emit restoreProgressChanged();
+
+  // every layer is requested at once, and is inserted as soon as it has loaded
   auto it = m_inputLayerJsonArray.constBegin();
   auto itEnd = m_inputLayerJsonArray.constEnd();
   int layerIndex = 0;
@@ -401,11 +523,32 @@ void LayerCacheManager::connectSignals()
     disconnect(m_modelResetConnection);
 
   // connect signals
-  m_dataChangedConnection = connect(m_scene->operationalLayers(), &LayerListModel::dataChanged, this, &LayerCacheManager::onLayerListChanged); // layer objects have been added or changed
-  m_layerAddedConnection = connect(m_scene->operationalLayers(), &LayerListModel::layerAdded, this, &LayerCacheManager::onLayerListChanged); // layer objects have been added
-  m_layerRemovedConnection = connect(m_scene->operationalLayers(), &LayerListModel::layerRemoved, this, &LayerCacheManager::onLayerListChanged); // layer has been removed
+  m_layerJsonCache.clear();
+  m_dataChangedConnection = connect(m_scene->operationalLayers(), &LayerListModel::dataChanged, this, [this](const QModelIndex& topLeft, const QModelIndex& bottomRight)
+  {
+    // layer objects have been added or changed
+    invalidateLayers(topLeft.row(), bottomRight.row());
+    onLayerListChanged();
+  });
+  m_layerAddedConnection = connect(m_scene->operationalLayers(), &LayerListModel::layerAdded, this, [this](Layer* layer)
+  {
+    // layer objects have been added
+    m_layerJsonCache.remove(layer);
+    onLayerListChanged();
+  });
+  m_layerRemovedConnection = connect(m_scene->operationalLayers(), &LayerListModel::layerRemoved, this, [this](Layer* layer)
+  {
+    // layer has been removed
+    m_layerJsonCache.remove(layer);
+    onLayerListChanged();
+  });
   m_layoutChangedConnection = connect(m_scene->operationalLayers(), &LayerListModel::layoutChanged, this, &LayerCacheManager::onLayerListChanged); // order changed
-  m_modelResetConnection = connect(m_scene->operationalLayers(), &LayerListModel::modelReset, this, &LayerCacheManager::onLayerListChanged); // order changed
+  m_modelResetConnection = connect(m_scene->operationalLayers(), &LayerListModel::modelReset, this, [this]()
+  {
+    // order changed
+    m_layerJsonCache.clear();
+    onLayerListChanged();
+  });
 
   if (!m_localDataController)
     return;
@@ -414,28 +557,122 @@ void LayerCacheManager::connectSignals()
   if (m_layerCreatedConnection)
     disconnect(m_layerCreatedConnection);
 
-  m_initialLayerCache.clear();
+  if (m_layerCreationFailedConnection)
+    disconnect(m_layerCreationFailedConnection);
+
+  m_restoredLayers.clear();
+
+  // restore the created layers
+  m_layerCreatedConnection = connect(m_localDataController, &AddLocalDataController::layerCreated, this, &LayerCacheManager::handleLayerCreated);
+  m_layerCreationFailedConnection = connect(m_localDataController, &AddLocalDataController::layerCreationFailed, this, &LayerCacheManager::finishRestoredLayer);
+}
+
+/*!
+ \brief Returns the number of saved layers being restored.
+*/
+int LayerCacheManager::restoreLayerCount() const
+{
+  return m_restoreLayerCount;
+}
+
+/*!
+ \brief Returns the number of saved layers which have been restored, or have failed to restore.
+*/
+int LayerCacheManager::restoredLayerCount() const
+{
+  return m_restoredLayerCount;
+}
+
+/*!
+ \brief Returns whether saved layers are still being restored.
+*/
+bool LayerCacheManager::isRestoring() const
+{
+  return m_restoredLayerCount < m_restoreLayerCount;
+}
+
+/*!
+ \internal
 
-  // cache the created layers
-  m_layerCreatedConnection = connect(m_localDataController, &AddLocalDataController::layerCreated, this, [this](int layerIndex, Layer* layer)
+ Starts loading the \a layer created for the saved entry at \a layerIndex, so that
+ it can be added as soon as it has loaded.
+*/
+void LayerCacheManager::handleLayerCreated(int layerIndex, Layer* layer)
+{
+  emit jsonToLayerCompleted(layer);
+
+  if (!layer)
   {
-    m_scene = ToolResourceProvider::instance()->scene();
-    m_initialLayerCache.insert(layerIndex, layer);
-    const int layerCount = m_inputLayerJsonArray.size();
-    emit jsonToLayerCompleted(layer);
+    finishRestoredLayer();
+    return;
+  }
 
-    // once all the layers are created, add them in the proper order
-    if (m_initialLayerCache.size() == layerCount)
-    {
-      if (!m_scene)
-        return;
+  if (layer->loadStatus() == LoadStatus::Loaded || layer->loadStatus() == LoadStatus::FailedToLoad)
+  {
+    insertRestoredLayer(layerIndex, layer);
+    return;
+  }
 
-      for (int i = 0; i < layerCount; i++)
-      {
-        m_scene->operationalLayers()->append(m_initialLayerCache.value(i));
-      }
-    }
+  // layers which fail to load are still added, so that the error is shown to the user
+  connect(layer, &Layer::doneLoading, this, [this, layerIndex, layer](Error)
+  {
+    insertRestoredLayer(layerIndex, layer);
   });
+
+  layer->load();
+}
+
+/*!
+ \internal
+
+ Adds the restored \a layer below the restored layer with the next highest \a layerIndex,
+ or on top if there is none.
+*/
+void LayerCacheManager::insertRestoredLayer(int layerIndex, Layer* layer)
+{
+  DSA_TRACE_SCOPE("LayerCacheManager::insertRestoredLayer");
+  DSA_ALLOCATION_SCOPE(Layers);
+
+  // the layer is only inserted once, even if it is loaded again
+  if (m_restoredLayers.contains(layerIndex))
+    return;
+
+  m_scene = ToolResourceProvider::instance()->scene();
+  if (m_scene)
+  {
+    auto operationalLayers = m_scene->operationalLayers();
+    const auto nextIt = m_restoredLayers.upperBound(layerIndex);
+    const int position = nextIt != m_restoredLayers.end() ? operationalLayers->indexOf(nextIt.value()) : -1;
+
+    if (position < 0)
+      operationalLayers->append(layer);
+    else
+      operationalLayers->insert(position, layer);
+  }
+
+  m_restoredLayers.insert(layerIndex, layer);
+  finishRestoredLayer();
+}
+
+/*!
+ \internal
+
+ Records that one more saved layer has been restored, and writes the layer list
+ once they all have.
+*/
+void LayerCacheManager::finishRestoredLayer()
+{
+  if (!isRestoring())
+    return;
+
+  m_restoredLayerCount++;
+  emit restoreProgressChanged();
+
+  if (isRestoring())
+    return;
+
+  emit restoreCompleted();
+  persistLayers();
 }
 
 } // Dsa
@@ -453,3 +690,15 @@ void LayerCacheManager::connectSignals()
   The resulting \a layer is passed through as a parameter.
  */
 
+/*!
+  \fn void LayerCacheManager::restoreProgressChanged();
+  \brief Signal emitted when another saved layer has been restored.
+
+  \sa restoredLayerCount, restoreLayerCount
+ */
+
+/*!
+  \fn void LayerCacheManager::restoreCompleted();
+  \brief Signal emitted when every saved layer has been restored.
+ */
+
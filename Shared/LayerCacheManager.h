@@ -21,7 +21,12 @@
 #include "AbstractTool.h"
 
 // Qt headers
+#include <QHash>
 #include <QJsonArray>
+#include <QJsonObject>
+#include <QMap>
+
+class QTimer;
 
 namespace Esri {
 namespace ArcGISRuntime {
@@ -55,15 +60,29 @@ public:
   void addElevation(const QVariantMap& properties);
   void addLayers(const QVariantMap& properties);
 
+  int restoreLayerCount() const;
+  int restoredLayerCount() const;
+  bool isRestoring() const;
+
+  void flush();
+
 signals:
   void layerJsonChanged();
   void jsonToLayerCompleted(Esri::ArcGISRuntime::Layer* layer);
+  void restoreProgressChanged();
+  void restoreCompleted();
 
 private slots:
   void onLayerListChanged();
 
 private:
   void connectSignals();
+  QJsonObject createLayerJson(Esri::ArcGISRuntime::Layer* layer) const;
+  void invalidateLayers(int firstRow, int lastRow);
+  void persistLayers();
+  void handleLayerCreated(int layerIndex, Esri::ArcGISRuntime::Layer* layer);
+  void insertRestoredLayer(int layerIndex, Esri::ArcGISRuntime::Layer* layer);
+  void finishRestoredLayer();
 
   static const QString LAYERS_PROPERTYNAME;
   static const QString ELEVATION_PROPERTYNAME;
@@ -79,7 +98,9 @@ private:
   bool m_initialLoadCompleted = false;
   AddLocalDataController* m_localDataController = nullptr;
   Esri::ArcGISRuntime::Scene* m_scene = nullptr;
-  QHash<int, Esri::ArcGISRuntime::Layer*> m_initialLayerCache;
+  QMap<int, Esri::ArcGISRuntime::Layer*> m_restoredLayers;
+  int m_restoreLayerCount = 0;
+  int m_restoredLayerCount = 0;
   QStringList m_excludedPaths;
   QVariantMap m_initialSettings;
   QMetaObject::Connection m_layerAddedConnection;
@@ -88,6 +109,11 @@ private:
   QMetaObject::Connection m_layoutChangedConnection;
   QMetaObject::Connection m_modelResetConnection;
   QMetaObject::Connection m_layerCreatedConnection;
+  QMetaObject::Connection m_layerCreationFailedConnection;
+
+  static constexpr int s_persistInterval = 1000;
+  QTimer* m_persistTimer = nullptr;
+  QHash<Esri::ArcGISRuntime::Layer*, QJsonObject> m_layerJsonCache;
 };
 
 } // Dsa
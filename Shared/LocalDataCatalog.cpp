@@ -0,0 +1,370 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "LocalDataCatalog.h"
+
+// Qt headers
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QThreadPool>
+#include <QTimer>
+
+// STL headers
+#include <algorithm>
+
+namespace Dsa {
+
+namespace
+{
+const QString s_directoriesKey = QStringLiteral("directories");
+const QString s_pathKey = QStringLiteral("path");
+const QString s_sizeKey = QStringLiteral("size");
+const QString s_modifiedKey = QStringLiteral("modified");
+const QString s_typeKey = QStringLiteral("type");
+
+bool isSameEntry(const LocalDataCatalog::Entry& a, const LocalDataCatalog::Entry& b)
+{
+  return a.m_path == b.m_path && a.m_size == b.m_size &&
+         a.m_lastModified == b.m_lastModified && a.m_dataType == b.m_dataType;
+}
+}
+
+/*!
+  \class Dsa::LocalDataCatalog
+  \inmodule Dsa
+  \inherits QObject
+  \brief A catalogue of the files in a set of local data directories.
+
+  Each directory is indexed on a background thread, recording the size, modification
+  time and \l DataType of every file. The directories are watched, and re-indexed
+  shortly after they change, so that the catalogue can be read from memory at any time
+  without touching the file system.
+
+  The catalogue is saved to a JSON file, so that it is available as soon as the app
+  starts while the directories are re-indexed in the background.
+ */
+
+/*!
+  \brief Constructor taking the \a catalogPath of the saved catalogue and an optional \a parent.
+ */
+LocalDataCatalog::LocalDataCatalog(const QString& catalogPath, QObject* parent):
+  QObject(parent),
+  m_catalogPath(catalogPath),
+  m_catalog(readCatalog(catalogPath)),
+  m_watcher(new QFileSystemWatcher(this)),
+  m_rescanTimer(new QTimer(this)),
+  m_threadPool(new QThreadPool(this))
+{
+  // scans and writes are run one at a time, in the order they were started
+  m_threadPool->setMaxThreadCount(1);
+
+  m_rescanTimer->setSingleShot(true);
+  m_rescanTimer->setInterval(s_rescanDelay);
+  connect(m_rescanTimer, &QTimer::timeout, this, &LocalDataCatalog::startScans);
+  connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, &LocalDataCatalog::scheduleScan);
+}
+
+/*!
+  \brief Destructor.
+ */
+LocalDataCatalog::~LocalDataCatalog()
+{
+  m_threadPool->clear();
+  m_threadPool->waitForDone();
+}
+
+/*!
+  \brief Adds \a directory to the catalogue and starts indexing it.
+
+  Any previously saved entries for \a directory are available immediately.
+ */
+void LocalDataCatalog::addDirectory(const QString& directory)
+{
+  if (m_directories.contains(directory))
+    return;
+
+  m_directories.append(directory);
+  m_watcher->addPath(directory);
+
+  m_pendingScans.insert(directory);
+  startScans();
+}
+
+/*!
+  \brief Stops watching \a directory for changes.
+
+  The saved entries for \a directory are kept, so they are available immediately
+  if it is added again.
+ */
+void LocalDataCatalog::removeDirectory(const QString& directory)
+{
+  if (!m_directories.removeOne(directory))
+    return;
+
+  m_watcher->removePath(directory);
+  m_pendingScans.remove(directory);
+}
+
+/*!
+  \brief Returns the directories in the catalogue.
+ */
+QStringList LocalDataCatalog::directories() const
+{
+  return m_directories;
+}
+
+/*!
+  \brief Returns the files in \a directory, ordered by name.
+ */
+QList<LocalDataCatalog::Entry> LocalDataCatalog::entries(const QString& directory) const
+{
+  return m_catalog.value(directory);
+}
+
+/*!
+  \brief Returns whether any directory is being indexed.
+ */
+bool LocalDataCatalog::isIndexing() const
+{
+  return m_runningScans > 0 || !m_pendingScans.isEmpty();
+}
+
+/*!
+  \internal
+
+  Returns the files in \a directory. The data type of files which are unchanged
+  since \a previousEntries is not detected again.
+
+  This only uses its arguments, so it can be run on a worker thread.
+ */
+QList<LocalDataCatalog::Entry> LocalDataCatalog::scanDirectory(const QString& directory, const QList<Entry>& previousEntries)
+{
+  QHash<QString, Entry> previous;
+  for (const Entry& entry : previousEntries)
+    previous.insert(entry.m_path, entry);
+
+  QList<Entry> entries;
+  const QFileInfoList fileInfos = QDir(directory).entryInfoList(QDir::Files, QDir::Name);
+  entries.reserve(fileInfos.size());
+  for (const QFileInfo& fileInfo : fileInfos)
+  {
+    Entry entry;
+    entry.m_path = fileInfo.absoluteFilePath();
+    entry.m_size = fileInfo.size();
+    entry.m_lastModified = fileInfo.lastModified().toMSecsSinceEpoch();
+
+    const auto findIt = previous.constFind(entry.m_path);
+    if (findIt != previous.constEnd() && findIt->m_size == entry.m_size && findIt->m_lastModified == entry.m_lastModified)
+      entry.m_dataType = findIt->m_dataType;
+    else
+      entry.m_dataType = DataItemListModel::dataTypeFromPath(entry.m_path);
+
+    entries.append(entry);
+  }
+
+  return entries;
+}
+
+/*!
+  \internal
+
+  Returns the catalogue saved at \a catalogPath, or an empty catalogue if there is none.
+ */
+LocalDataCatalog::Catalog LocalDataCatalog::readCatalog(const QString& catalogPath)
+{
+  Catalog catalog;
+
+  QFile catalogFile(catalogPath);
+  if (!catalogFile.open(QIODevice::ReadOnly))
+    return catalog;
+
+  const QJsonObject directories = QJsonDocument::fromJson(catalogFile.readAll()).object().value(s_directoriesKey).toObject();
+  for (auto it = directories.constBegin(); it != directories.constEnd(); ++it)
+  {
+    QList<Entry>& entries = catalog[it.key()];
+    for (const QJsonValue& value : it.value().toArray())
+    {
+      const QJsonObject entryJson = value.toObject();
+      Entry entry;
+      entry.m_path = entryJson.value(s_pathKey).toString();
+      entry.m_size = static_cast<qint64>(entryJson.value(s_sizeKey).toDouble());
+      entry.m_lastModified = static_cast<qint64>(entryJson.value(s_modifiedKey).toDouble());
+      entry.m_dataType = static_cast<DataType>(entryJson.value(s_typeKey).toInt(static_cast<int>(DataType::Unknown)));
+      entries.append(entry);
+    }
+  }
+
+  return catalog;
+}
+
+/*!
+  \internal
+
+  Saves \a catalog to \a catalogPath, replacing any previous catalogue.
+ */
+void LocalDataCatalog::writeCatalog(const QString& catalogPath, const Catalog& catalog)
+{
+  QJsonObject directories;
+  for (auto it = catalog.constBegin(); it != catalog.constEnd(); ++it)
+  {
+    QJsonArray entries;
+    for (const Entry& entry : it.value())
+    {
+      QJsonObject entryJson;
+      entryJson.insert(s_pathKey, entry.m_path);
+      entryJson.insert(s_sizeKey, static_cast<double>(entry.m_size));
+      entryJson.insert(s_modifiedKey, static_cast<double>(entry.m_lastModified));
+      entryJson.insert(s_typeKey, static_cast<int>(entry.m_dataType));
+      entries.append(entryJson);
+    }
+
+    directories.insert(it.key(), entries);
+  }
+
+  QJsonObject catalogJson;
+  catalogJson.insert(s_directoriesKey, directories);
+
+  QDir().mkpath(QFileInfo(catalogPath).absolutePath());
+
+  QSaveFile catalogFile(catalogPath);
+  if (!catalogFile.open(QIODevice::WriteOnly))
+    return;
+
+  catalogFile.write(QJsonDocument(catalogJson).toJson(QJsonDocument::Compact));
+  catalogFile.commit();
+}
+
+/*!
+  \internal
+
+  Re-indexes \a directory once it has stopped changing.
+ */
+void LocalDataCatalog::scheduleScan(const QString& directory)
+{
+  const bool wasIndexing = isIndexing();
+  m_pendingScans.insert(directory);
+
+  // a directory which is removed and re-created is no longer watched
+  if (!m_watcher->directories().contains(directory) && QFileInfo::exists(directory))
+    m_watcher->addPath(directory);
+
+  if (!m_rescanTimer->isActive())
+    m_rescanTimer->start();
+
+  if (!wasIndexing)
+    emit indexingChanged();
+}
+
+/*!
+  \internal
+
+  Starts indexing each directory which is waiting to be indexed.
+ */
+void LocalDataCatalog::startScans()
+{
+  const bool wasIndexing = isIndexing();
+
+  for (const QString& directory : qAsConst(m_pendingScans))
+  {
+    const QList<Entry> previousEntries = m_catalog.value(directory);
+    ++m_runningScans;
+
+    m_threadPool->start([this, directory, previousEntries]()
+    {
+      const QList<Entry> entries = scanDirectory(directory, previousEntries);
+
+      QMetaObject::invokeMethod(this, [this, directory, entries]()
+      {
+        handleScanCompleted(directory, entries);
+      }, Qt::QueuedConnection);
+    });
+  }
+
+  m_pendingScans.clear();
+
+  if (wasIndexing != isIndexing())
+    emit indexingChanged();
+}
+
+/*!
+  \internal
+
+  Replaces the entries for \a directory with \a entries, saving the catalogue if they changed.
+ */
+void LocalDataCatalog::handleScanCompleted(const QString& directory, const QList<Entry>& entries)
+{
+  --m_runningScans;
+
+  const QList<Entry>& previousEntries = m_catalog[directory];
+  const bool changed = previousEntries.size() != entries.size() ||
+                       !std::equal(previousEntries.cbegin(), previousEntries.cend(), entries.cbegin(), &isSameEntry);
+
+  if (changed)
+  {
+    m_catalog.insert(directory, entries);
+    saveCatalog();
+    emit catalogChanged();
+  }
+
+  if (!isIndexing())
+    emit indexingChanged();
+}
+
+/*!
+  \internal
+
+  Writes the entries of the catalogued directories in the background.
+ */
+void LocalDataCatalog::saveCatalog()
+{
+  if (m_catalogPath.isEmpty())
+    return;
+
+  Catalog catalog;
+  for (const QString& directory : qAsConst(m_directories))
+    catalog.insert(directory, m_catalog.value(directory));
+
+  const QString catalogPath = m_catalogPath;
+  m_threadPool->start([catalogPath, catalog]()
+  {
+    writeCatalog(catalogPath, catalog);
+  });
+}
+
+} // Dsa
+
+// Signal Documentation
+/*!
+  \fn void LocalDataCatalog::catalogChanged();
+  \brief Signal emitted when the files in any catalogued directory change.
+ */
+
+/*!
+  \fn void LocalDataCatalog::indexingChanged();
+  \brief Signal emitted when indexing starts or finishes.
+
+  \sa isIndexing
+ */
@@ -0,0 +1,91 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef LOCALDATACATALOG_H
+#define LOCALDATACATALOG_H
+
+// dsa app headers
+#include "DataItemListModel.h"
+
+// Qt headers
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+
+class QFileSystemWatcher;
+class QThreadPool;
+class QTimer;
+
+namespace Dsa {
+
+class LocalDataCatalog : public QObject
+{
+  Q_OBJECT
+
+public:
+  struct Entry
+  {
+    QString m_path;
+    qint64 m_size = 0;
+    qint64 m_lastModified = 0;
+    DataType m_dataType = DataType::Unknown;
+  };
+
+  explicit LocalDataCatalog(const QString& catalogPath, QObject* parent = nullptr);
+  ~LocalDataCatalog();
+
+  void addDirectory(const QString& directory);
+  void removeDirectory(const QString& directory);
+  QStringList directories() const;
+  QList<Entry> entries(const QString& directory) const;
+
+  bool isIndexing() const;
+
+signals:
+  void catalogChanged();
+  void indexingChanged();
+
+private:
+  Q_DISABLE_COPY(LocalDataCatalog)
+
+  using Catalog = QHash<QString, QList<Entry>>;
+
+  static QList<Entry> scanDirectory(const QString& directory, const QList<Entry>& previousEntries);
+  static Catalog readCatalog(const QString& catalogPath);
+  static void writeCatalog(const QString& catalogPath, const Catalog& catalog);
+
+  void scheduleScan(const QString& directory);
+  void startScans();
+  void handleScanCompleted(const QString& directory, const QList<Entry>& entries);
+  void saveCatalog();
+
+  static constexpr int s_rescanDelay = 500;
+
+  QString m_catalogPath;
+  QStringList m_directories;
+  Catalog m_catalog;
+  QFileSystemWatcher* m_watcher = nullptr;
+  QTimer* m_rescanTimer = nullptr;
+  QThreadPool* m_threadPool = nullptr;
+  QSet<QString> m_pendingScans;
+  int m_runningScans = 0;
+};
+
+} // Dsa
+
+#endif // LOCALDATACATALOG_H
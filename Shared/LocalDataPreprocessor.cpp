@@ -0,0 +1,371 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "LocalDataPreprocessor.h"
+
+// dsa app headers
+#include "FeatureGeometryCache.h"
+
+// C++ API headers
+#include "FeatureLayer.h"
+#include "FeatureTable.h"
+
+// Qt headers
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QThreadPool>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+/*!
+  \class Dsa::LocalDataPreprocessor
+  \inmodule Dsa
+  \inherits QObject
+  \brief Prepares local data which is added to the scene so that it can be queried
+  and drawn quickly.
+
+  \list
+    \li Shapefiles have the geometry of every feature read into the
+        \l FeatureGeometryCache as soon as they load, which also writes it to the
+        \l FeatureGeometryStore. The spatial indexes used by alerts and identify are
+        built from this side cache, so later queries and restarts do not scan the
+        whole file.
+    \li Large rasters are checked on a background thread for overviews, either in an
+        external \c .ovr or \c .rrd file or as reduced resolution images inside a TIFF.
+        The runtime cannot build overviews, so \l rasterWithoutOverviews is emitted
+        for each raster which has none so that the user can be told to build them.
+  \endlist
+
+  Each file is processed once for each version of it. \l progress reports how much
+  of the work started since the preprocessor was last idle has completed.
+ */
+
+/*!
+  \brief Constructor taking an optional \a parent.
+ */
+LocalDataPreprocessor::LocalDataPreprocessor(QObject* parent /* = nullptr */):
+  QObject(parent),
+  m_threadPool(new QThreadPool(this))
+{
+  // the checks read the file headers, so are run one at a time to avoid competing for the disk
+  m_threadPool->setMaxThreadCount(1);
+}
+
+/*!
+  \brief Destructor.
+ */
+LocalDataPreprocessor::~LocalDataPreprocessor()
+{
+  m_threadPool->clear();
+  m_threadPool->waitForDone();
+}
+
+/*!
+  \brief Reads the geometry of every feature in the shapefile of \a featureLayer
+  into the side cache once the layer has loaded.
+ */
+void LocalDataPreprocessor::preprocessShapefile(FeatureLayer* featureLayer)
+{
+  if (!featureLayer || !featureLayer->featureTable())
+    return;
+
+  FeatureTable* featureTable = featureLayer->featureTable();
+  if (m_pendingTables.contains(featureTable))
+    return;
+
+  m_pendingTables.insert(featureTable);
+  startTask();
+
+  connect(featureTable, &QObject::destroyed, this, [this, featureTable]()
+  {
+    finishFeatureTable(featureTable);
+  });
+
+  if (featureTable->loadStatus() == LoadStatus::Loaded)
+  {
+    indexFeatureTable(featureTable);
+    return;
+  }
+
+  connect(featureTable, &FeatureTable::doneLoading, this, [this, featureTable](Error loadError)
+  {
+    if (!m_pendingTables.contains(featureTable))
+      return;
+
+    if (loadError.isEmpty())
+      indexFeatureTable(featureTable);
+    else
+      finishFeatureTable(featureTable);
+  });
+}
+
+/*!
+  \brief Checks whether the raster at \a path has overviews on a background thread.
+
+  Rasters smaller than 64 MB are not checked, as they draw quickly without overviews.
+ */
+void LocalDataPreprocessor::preprocessRaster(const QString& path)
+{
+  const QFileInfo rasterInfo(path);
+  if (!rasterInfo.isFile() || rasterInfo.size() < s_minimumRasterBytes)
+    return;
+
+  const QString rasterKey = QString("%1|%2|%3").arg(rasterInfo.absoluteFilePath(),
+                                                    QString::number(rasterInfo.size()),
+                                                    QString::number(rasterInfo.lastModified().toMSecsSinceEpoch()));
+  if (m_checkedRasters.contains(rasterKey))
+    return;
+
+  m_checkedRasters.insert(rasterKey);
+  startTask();
+
+  const qint64 size = rasterInfo.size();
+  m_threadPool->start([this, path, size]()
+  {
+    const bool overviews = hasOverviews(path);
+
+    QMetaObject::invokeMethod(this, [this, path, size, overviews]()
+    {
+      if (!overviews)
+        emit rasterWithoutOverviews(path, size);
+
+      finishTask();
+    }, Qt::QueuedConnection);
+  });
+}
+
+/*!
+  \brief Returns whether any data is being processed.
+ */
+bool LocalDataPreprocessor::isProcessing() const
+{
+  return m_completedCount < m_taskCount;
+}
+
+/*!
+  \brief Returns the fraction of the data processed since the preprocessor was last
+  idle, from \c 0.0 to \c 1.0.
+ */
+double LocalDataPreprocessor::progress() const
+{
+  return m_taskCount > 0 ? static_cast<double>(m_completedCount) / m_taskCount : 1.0;
+}
+
+/*!
+  \brief Returns whether the raster at \a path has overviews.
+
+  Formats which are always stored at multiple resolutions, such as MrSID and
+  JPEG 2000, and those which cannot be inspected, are treated as having overviews.
+ */
+bool LocalDataPreprocessor::hasOverviews(const QString& path)
+{
+  const QFileInfo rasterInfo(path);
+  if (QFileInfo::exists(path + QStringLiteral(".ovr")) ||
+      QFileInfo::exists(rasterInfo.dir().filePath(rasterInfo.completeBaseName() + QStringLiteral(".rrd"))))
+  {
+    return true;
+  }
+
+  const QString suffix = rasterInfo.suffix().toLower();
+  if (suffix == QStringLiteral("tif") || suffix == QStringLiteral("tiff") || suffix == QStringLiteral("geotiff"))
+    return hasTiffOverviews(path);
+
+  // these formats only hold overviews in external files
+  return !(suffix == QStringLiteral("png") || suffix == QStringLiteral("jpg") || suffix == QStringLiteral("jpeg"));
+}
+
+/*!
+  \internal
+
+  Returns whether the TIFF at \a path holds a reduced resolution image, found by
+  walking its image file directories for a \c NewSubfileType with the reduced
+  resolution bit set. Both classic TIFF and BigTIFF are read.
+ */
+bool LocalDataPreprocessor::hasTiffOverviews(const QString& path)
+{
+  constexpr quint16 newSubfileTypeTag = 254;
+  constexpr quint32 reducedResolutionBit = 0x1;
+
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly))
+    return true;
+
+  QDataStream stream(&file);
+  const QByteArray byteOrder = file.read(2);
+  if (byteOrder == "II")
+    stream.setByteOrder(QDataStream::LittleEndian);
+  else if (byteOrder == "MM")
+    stream.setByteOrder(QDataStream::BigEndian);
+  else
+    return true;
+
+  quint16 version = 0;
+  stream >> version;
+  const bool bigTiff = version == 43;
+  if (!bigTiff && version != 42)
+    return true;
+
+  quint64 directoryOffset = 0;
+  if (bigTiff)
+  {
+    quint16 offsetSize = 0;
+    quint16 reserved = 0;
+    stream >> offsetSize >> reserved >> directoryOffset;
+  }
+  else
+  {
+    quint32 offset = 0;
+    stream >> offset;
+    directoryOffset = offset;
+  }
+
+  for (int directory = 0; directory < s_maximumTiffDirectories && directoryOffset != 0; ++directory)
+  {
+    if (!file.seek(static_cast<qint64>(directoryOffset)))
+      break;
+
+    quint64 entryCount = 0;
+    if (bigTiff)
+    {
+      stream >> entryCount;
+    }
+    else
+    {
+      quint16 count = 0;
+      stream >> count;
+      entryCount = count;
+    }
+
+    const qint64 entrySize = bigTiff ? 20 : 12;
+    const qint64 entriesStart = file.pos();
+    for (quint64 entry = 0; entry < entryCount; ++entry)
+    {
+      quint16 tag = 0;
+      stream >> tag;
+      if (tag != newSubfileTypeTag)
+      {
+        file.seek(file.pos() + entrySize - 2);
+        continue;
+      }
+
+      // skip the type and count; the value is left justified in the entry in both byte orders
+      file.seek(file.pos() + (bigTiff ? 10 : 6));
+      quint32 subfileType = 0;
+      stream >> subfileType;
+      if (subfileType & reducedResolutionBit)
+        return true;
+
+      file.seek(entriesStart + static_cast<qint64>(entry + 1) * entrySize);
+    }
+
+    if (stream.status() != QDataStream::Ok)
+      break;
+
+    file.seek(entriesStart + static_cast<qint64>(entryCount) * entrySize);
+    if (bigTiff)
+    {
+      stream >> directoryOffset;
+    }
+    else
+    {
+      quint32 offset = 0;
+      stream >> offset;
+      directoryOffset = offset;
+    }
+
+    if (stream.status() != QDataStream::Ok)
+      break;
+  }
+
+  return false;
+}
+
+/*!
+  \internal
+ */
+void LocalDataPreprocessor::indexFeatureTable(FeatureTable* featureTable)
+{
+  if (FeatureGeometryCache::instance()->isCached(featureTable))
+  {
+    finishFeatureTable(featureTable);
+    return;
+  }
+
+  FeatureGeometryCache::instance()->requestGeometries(featureTable, this, [this, featureTable](const QList<Geometry>&)
+  {
+    finishFeatureTable(featureTable);
+  });
+}
+
+/*!
+  \internal
+
+  Completes the processing of \a featureTable, if it has not already completed.
+ */
+void LocalDataPreprocessor::finishFeatureTable(FeatureTable* featureTable)
+{
+  if (!m_pendingTables.remove(featureTable))
+    return;
+
+  finishTask();
+}
+
+/*!
+  \internal
+ */
+void LocalDataPreprocessor::startTask()
+{
+  // start counting again once the previous work has all completed
+  if (!isProcessing())
+  {
+    m_taskCount = 0;
+    m_completedCount = 0;
+  }
+
+  ++m_taskCount;
+  emit progressChanged();
+}
+
+/*!
+  \internal
+ */
+void LocalDataPreprocessor::finishTask()
+{
+  ++m_completedCount;
+  emit progressChanged();
+}
+
+} // Dsa
+
+// Signal Documentation
+/*!
+  \fn void LocalDataPreprocessor::progressChanged();
+  \brief Signal emitted when data starts or finishes being processed.
+ */
+
+/*!
+  \fn void LocalDataPreprocessor::rasterWithoutOverviews(const QString& path, qint64 size);
+  \brief Signal emitted when the raster at \a path, of \a size bytes, is found to
+  have no overviews.
+ */
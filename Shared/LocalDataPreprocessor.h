@@ -0,0 +1,78 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef LOCALDATAPREPROCESSOR_H
+#define LOCALDATAPREPROCESSOR_H
+
+// Qt headers
+#include <QObject>
+#include <QSet>
+#include <QString>
+
+class QThreadPool;
+
+namespace Esri {
+namespace ArcGISRuntime {
+class FeatureLayer;
+class FeatureTable;
+}
+}
+
+namespace Dsa {
+
+class LocalDataPreprocessor : public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit LocalDataPreprocessor(QObject* parent = nullptr);
+  ~LocalDataPreprocessor();
+
+  void preprocessShapefile(Esri::ArcGISRuntime::FeatureLayer* featureLayer);
+  void preprocessRaster(const QString& path);
+
+  bool isProcessing() const;
+  double progress() const;
+
+  static bool hasOverviews(const QString& path);
+
+signals:
+  void progressChanged();
+  void rasterWithoutOverviews(const QString& path, qint64 size);
+
+private:
+  Q_DISABLE_COPY(LocalDataPreprocessor)
+
+  static bool hasTiffOverviews(const QString& path);
+
+  void indexFeatureTable(Esri::ArcGISRuntime::FeatureTable* featureTable);
+  void finishFeatureTable(Esri::ArcGISRuntime::FeatureTable* featureTable);
+  void startTask();
+  void finishTask();
+
+  static constexpr qint64 s_minimumRasterBytes = 64 * 1024 * 1024;
+  static constexpr int s_maximumTiffDirectories = 64;
+
+  QThreadPool* m_threadPool = nullptr;
+  QSet<Esri::ArcGISRuntime::FeatureTable*> m_pendingTables;
+  QSet<QString> m_checkedRasters;
+  int m_taskCount = 0;
+  int m_completedCount = 0;
+};
+
+} // Dsa
+
+#endif // LOCALDATAPREPROCESSOR_H
@@ -20,15 +20,23 @@
 #include "LocationBroadcast.h"
 
 // dsa app headers
-#include "DataSender.h"
+#include "CompactMessageCodec.h"
+#include "GeoMessageTemplate.h"
+#include "OutboundTransport.h"
+#include "TakProtocolCodec.h"
 
 // toolkit headers
 #include "ToolResourceProvider.h"
 
+// C++ API headers
+#include "GeometryEngine.h"
+
 // Qt headers
 #include <QHostInfo>
 #include <QTimer>
-#include <QUdpSocket>
+
+// STL headers
+#include <cmath>
 
 using namespace Esri::ArcGISRuntime;
 
@@ -37,6 +45,25 @@ namespace Dsa {
 // friendly symbol ID for our location broadcast
 static const QString s_locationBroadcastSic{QStringLiteral("SFGPEVAL-------")};
 
+// movement below this distance, in meters, is treated as GPS jitter when deriving a heading
+static constexpr double s_minimumHeadingDistance = 2.0;
+
+// attempts after a failed write of an update while in distress
+static const int s_distressRetries = 3;
+
+// TAK broadcasts go stale after this many update intervals without an update
+static const int s_takStaleUpdates = 3;
+
+namespace
+{
+// returns the absolute difference, in degrees, between two headings
+double headingDifference(double heading1, double heading2)
+{
+  const double difference = std::fmod(std::fabs(heading1 - heading2), 360.0);
+  return difference > 180.0 ? 360.0 - difference : difference;
+}
+}
+
 /*!
   \class Dsa::LocationBroadcast
   \inmodule Dsa
@@ -49,6 +76,13 @@ static const QString s_locationBroadcastSic{QStringLiteral("SFGPEVAL-------")};
   The broadcast should typically be configured with an existing message feed type
   over an existing message feed UDP port.
 
+  By default a location update is sent every \l frequency milliseconds. When
+  \l isAdaptive is \c true, the location is still sampled at that rate but an
+  update is only sent when the position or heading has drifted beyond
+  \l distanceThreshold or \l headingThreshold since the last update, when the
+  distress status changes, or when \l heartbeatInterval has elapsed. Stationary
+  units then only send a slow heartbeat.
+
   \sa MessageFeedsController
   \sa setMessageType
   \sa setUdpPort
@@ -213,6 +247,29 @@ void LocationBroadcast::setUdpPort(int port)
     update();
 }
 
+/*!
+   \brief Returns the UDP transport used by the location broadcast.
+ */
+UdpTransport LocationBroadcast::transport() const
+{
+  return m_transport;
+}
+
+/*!
+   \brief Sets the UDP transport used by the location broadcast to \a transport,
+   e.g. to send to a multicast group or unicast peers instead of broadcasting.
+
+   Setting a new transport will update and start the location broadcast if enabled.
+ */
+void LocationBroadcast::setTransport(const UdpTransport& transport)
+{
+  if (m_transport == transport)
+    return;
+
+  m_transport = transport;
+  update();
+}
+
 /*!
    \brief Returns the frequency of broadcasted location updates.
 
@@ -260,7 +317,8 @@ bool LocationBroadcast::isInDistress() const
    message status as being in distress to \a inDistress.
 
    Setting \a inDistress to \c true will enable the
-   location broadcast if disabled.
+   location broadcast if disabled. The change is broadcast straight
+   away rather than on the next tick.
  */
 void LocationBroadcast::setInDistress(bool inDistress)
 {
@@ -271,6 +329,173 @@ void LocationBroadcast::setInDistress(bool inDistress)
 
   if (m_inDistress && !isEnabled())
     setEnabled(true);
+
+  broadcastLocation();
+}
+
+/*!
+   \brief Returns the format in which location updates are broadcast.
+
+   The default is \c WireFormat::GeoMessage.
+ */
+LocationBroadcast::WireFormat LocationBroadcast::wireFormat() const
+{
+  return m_wireFormat;
+}
+
+/*!
+   \brief Sets the format in which location updates are broadcast to \a wireFormat.
+
+   The compact binary format uses a fraction of the bandwidth of GeoMessages
+   but is only understood by other DSA apps. The TAK protocol format is
+   protobuf CoT, which TAK clients and other DSA apps understand; receivers show
+   the broadcast in their CoT feed.
+
+   \sa CompactMessageCodec, TakProtocolCodec
+ */
+void LocationBroadcast::setWireFormat(WireFormat wireFormat)
+{
+  if (m_wireFormat == wireFormat)
+    return;
+
+  m_wireFormat = wireFormat;
+
+  // the next compact message starts from a new key frame
+  m_compactCodec.reset();
+  resetAdaptiveState();
+}
+
+/*!
+   \brief Static method to convert a \a wireFormat string (\c "geomessage", \c "compact"
+   or \c "tak") to a WireFormat enum value.
+
+   Unrecognized values map to \c WireFormat::GeoMessage.
+ */
+LocationBroadcast::WireFormat LocationBroadcast::toWireFormat(const QString& wireFormat)
+{
+  if (wireFormat.compare("compact", Qt::CaseInsensitive) == 0)
+    return WireFormat::Compact;
+
+  if (wireFormat.compare("tak", Qt::CaseInsensitive) == 0)
+    return WireFormat::Tak;
+
+  return WireFormat::GeoMessage;
+}
+
+/*!
+   \brief Returns \c true if location updates are only sent when
+   the position or heading has changed significantly.
+
+   The default is \c false.
+ */
+bool LocationBroadcast::isAdaptive() const
+{
+  return m_adaptive;
+}
+
+/*!
+   \brief Sets whether location updates are only sent when the position
+   or heading has changed significantly to \a adaptive.
+
+   When \a adaptive is \c false, an update is sent every \l frequency milliseconds.
+
+   \sa distanceThreshold
+   \sa headingThreshold
+   \sa heartbeatInterval
+ */
+void LocationBroadcast::setAdaptive(bool adaptive)
+{
+  if (m_adaptive == adaptive)
+    return;
+
+  m_adaptive = adaptive;
+
+  resetAdaptiveState();
+}
+
+/*!
+   \brief Returns the distance, in meters, the location must move from the
+   last broadcast position before an adaptive update is sent.
+
+   The default is \c 25 meters.
+ */
+double LocationBroadcast::distanceThreshold() const
+{
+  return m_distanceThreshold;
+}
+
+/*!
+   \brief Sets the distance, in meters, the location must move from the
+   last broadcast position before an adaptive update is sent to \a distanceThreshold.
+ */
+void LocationBroadcast::setDistanceThreshold(double distanceThreshold)
+{
+  m_distanceThreshold = distanceThreshold;
+}
+
+/*!
+   \brief Returns the change in heading, in degrees, which triggers an adaptive update.
+
+   The heading is derived from successive location samples. The default is \c 20 degrees.
+ */
+double LocationBroadcast::headingThreshold() const
+{
+  return m_headingThreshold;
+}
+
+/*!
+   \brief Sets the change in heading, in degrees, which triggers an adaptive update
+   to \a headingThreshold.
+ */
+void LocationBroadcast::setHeadingThreshold(double headingThreshold)
+{
+  m_headingThreshold = headingThreshold;
+}
+
+/*!
+   \brief Returns the maximum interval, in milliseconds, between adaptive updates.
+
+   An update is always sent once this interval has elapsed, even if the location has
+   not changed, so that receivers know the unit is still present. The default is
+   \c 30000 milliseconds.
+ */
+int LocationBroadcast::heartbeatInterval() const
+{
+  return m_heartbeatInterval;
+}
+
+/*!
+   \brief Sets the maximum interval, in milliseconds, between adaptive updates
+   to \a heartbeatInterval.
+ */
+void LocationBroadcast::setHeartbeatInterval(int heartbeatInterval)
+{
+  m_heartbeatInterval = heartbeatInterval;
+}
+
+/*!
+   \brief Returns \c true if GeoMessage updates are stamped by a \l LatencyProbe.
+
+   The default is \c false.
+ */
+bool LocationBroadcast::isLatencyProbeEnabled() const
+{
+  return static_cast<bool>(m_latencyProbe);
+}
+
+/*!
+   \brief Sets whether GeoMessage updates are stamped with their send time and a
+   sequence number to \a latencyProbeEnabled.
+
+   Each time the probe is enabled it starts a new sequence. Updates superseded on a
+   congested link are counted as lost by the receivers.
+ */
+void LocationBroadcast::setLatencyProbeEnabled(bool latencyProbeEnabled)
+{
+  if (isLatencyProbeEnabled() == latencyProbeEnabled)
+    return;
+
+  m_latencyProbe.reset(latencyProbeEnabled ? new LatencyProbe() : nullptr);
 }
 
 /*!
@@ -297,20 +522,10 @@ void LocationBroadcast::update()
   if (m_messageType.isEmpty() || m_udpPort == -1)
     return;
 
-  if (m_dataSender)
-  {
-    delete m_dataSender;
-    m_dataSender = nullptr;
-    m_timer = nullptr;
-  }
-
-  m_dataSender = new DataSender(this);
-
-  QUdpSocket* udpSocket = new QUdpSocket(m_dataSender);
-  udpSocket->connectToHost(QHostAddress::Broadcast, m_udpPort, QIODevice::WriteOnly);
-  m_dataSender->setDevice(udpSocket);
+  delete m_timer;
+  m_compactCodec.reset();
 
-  m_timer = new QTimer(m_dataSender);
+  m_timer = new QTimer(this);
   connect(m_timer, &QTimer::timeout, this, [this]
   {
     broadcastLocation();
@@ -342,7 +557,10 @@ void LocationBroadcast::update()
  */
 void LocationBroadcast::broadcastLocation()
 {
-  if (!m_enabled || !m_dataSender || m_location.isEmpty())
+  if (!m_enabled || !m_timer || m_location.isEmpty())
+    return;
+
+  if (m_adaptive && !isBroadcastRequired())
     return;
 
   if (m_message.isEmpty())
@@ -364,16 +582,142 @@ void LocationBroadcast::broadcastLocation()
   {
     m_message.setGeometry(m_location);
 
-    QVariantMap attribs = m_message.attributes();
-
+    // the attributes are only copied when the distress status changes
     const int status911 = m_inDistress ? 1 : 0;
-    attribs.insert(Message::GEOMESSAGE_STATUS_911_NAME, status911);
-    m_message.setAttributes(attribs);
+    if (m_message.attributeValue(Message::GEOMESSAGE_STATUS_911_NAME).toInt() != status911)
+    {
+      MessageAttributes attribs = m_message.messageAttributes();
+      attribs.insert(Message::GEOMESSAGE_STATUS_911_NAME, status911);
+      m_message.setMessageAttributes(attribs);
+    }
   }
 
   emit messageChanged();
 
-  m_dataSender->sendData(m_message.toGeoMessage());
+  sendMessage(m_message);
+}
+
+/*!
+   \internal
+   \brief Returns \c true if an adaptive location update should be sent.
+
+   The heading is estimated from the movement since the previous sample. Receivers
+   display the last reported position, so the drift is measured against the last
+   broadcast location rather than an extrapolated one.
+ */
+bool LocationBroadcast::isBroadcastRequired()
+{
+  // estimate the current heading, ignoring jitter while stationary
+  if (!m_previousLocation.isEmpty())
+  {
+    const GeodeticDistanceResult movement = GeometryEngine::distanceGeodetic(m_previousLocation, m_location,
+                                                                             LinearUnit::meters(), AngularUnit::degrees(),
+                                                                             GeodeticCurveType::Geodesic);
+    if (movement.distance() >= s_minimumHeadingDistance)
+    {
+      m_currentHeading = movement.azimuth1() < 0.0 ? movement.azimuth1() + 360.0 : movement.azimuth1();
+      m_previousLocation = m_location;
+    }
+  }
+  else
+  {
+    m_previousLocation = m_location;
+  }
+
+  bool required = m_message.isEmpty() || m_lastBroadcastLocation.isEmpty() ||
+                  !m_lastBroadcastTimer.isValid() ||
+                  m_lastBroadcastInDistress != m_inDistress ||
+                  m_lastBroadcastTimer.elapsed() >= m_heartbeatInterval;
+
+  if (!required)
+  {
+    const GeodeticDistanceResult drift = GeometryEngine::distanceGeodetic(m_lastBroadcastLocation, m_location,
+                                                                          LinearUnit::meters(), AngularUnit::degrees(),
+                                                                          GeodeticCurveType::Geodesic);
+    required = drift.distance() >= m_distanceThreshold;
+  }
+
+  if (!required && m_currentHeading >= 0.0 && m_lastBroadcastHeading >= 0.0)
+    required = headingDifference(m_currentHeading, m_lastBroadcastHeading) >= m_headingThreshold;
+
+  if (!required)
+    return false;
+
+  m_lastBroadcastTimer.start();
+  m_lastBroadcastLocation = m_location;
+  m_lastBroadcastHeading = m_currentHeading;
+  m_lastBroadcastInDistress = m_inDistress;
+
+  return true;
+}
+
+/*!
+   \internal
+   \brief Encodes \a message in the current \l wireFormat and sends it.
+
+   Messages which cannot be expressed in the compact or TAK format, such as those
+   without a point geometry, are sent as GeoMessages.
+
+   Updates go out at routine priority, or ahead of other traffic while in
+   distress. An update still queued on a congested link is superseded by the next.
+ */
+void LocationBroadcast::sendMessage(const Message& message)
+{
+  OutboundTransport::SendOptions options;
+  options.m_coalesceKey = message.messageId();
+  if (m_inDistress)
+  {
+    options.m_priority = OutboundTransport::Priority::Distress;
+    options.m_retries = s_distressRetries;
+  }
+
+  if (m_wireFormat == WireFormat::Compact)
+  {
+    if (!m_compactCodec)
+      m_compactCodec.reset(new CompactMessageCodec());
+
+    const QByteArray data = m_compactCodec->encode(message);
+    if (!data.isEmpty())
+    {
+      OutboundTransport::instance()->send(m_transport, m_udpPort, data, options);
+      return;
+    }
+  }
+  else if (m_wireFormat == WireFormat::Tak)
+  {
+    // stay current until a few updates have been missed
+    const int updateInterval = m_adaptive ? qMax(m_frequency, m_heartbeatInterval) : m_frequency;
+    const QByteArray data = TakProtocolCodec::encode(message, static_cast<qint64>(updateInterval) * s_takStaleUpdates);
+    if (!data.isEmpty())
+    {
+      OutboundTransport::instance()->send(m_transport, m_udpPort, data, options);
+      return;
+    }
+  }
+
+  // only the location and distress status of the broadcast change between ticks
+  if (!m_geoMessageTemplate)
+    m_geoMessageTemplate.reset(new GeoMessageTemplate());
+
+  QByteArray data = m_geoMessageTemplate->encode(message);
+  if (m_latencyProbe)
+    m_latencyProbe->stamp(data);
+
+  OutboundTransport::instance()->send(m_transport, m_udpPort, data, options);
+}
+
+/*!
+   \internal
+   \brief Clears the record of the last adaptive update so that the
+   next sample is broadcast.
+ */
+void LocationBroadcast::resetAdaptiveState()
+{
+  m_lastBroadcastTimer.invalidate();
+  m_lastBroadcastLocation = Point();
+  m_previousLocation = Point();
+  m_lastBroadcastHeading = -1.0;
+  m_currentHeading = -1.0;
 }
 
 /*!
@@ -391,8 +735,8 @@ void LocationBroadcast::removeBroadcast()
 
     emit messageChanged();
 
-    if (m_dataSender)
-      m_dataSender->sendData(m_message.toGeoMessage());
+    if (m_timer)
+      sendMessage(m_message);
   }
 }
 
@@ -416,9 +760,9 @@ void LocationBroadcast::setUserName(const QString& userName)
 
   if (!m_message.isEmpty())
   {
-    QVariantMap attribs = m_message.attributes();
+    MessageAttributes attribs = m_message.messageAttributes();
     attribs.insert(Message::GEOMESSAGE_UNIQUE_DESIGNATION_NAME, m_userName);
-    m_message.setAttributes(attribs);
+    m_message.setMessageAttributes(attribs);
   }
 }
 
@@ -18,25 +18,39 @@
 #define LOCATIONBROADCAST_H
 
 // dsa app headers
+#include "LatencyProbe.h"
 #include "Message.h"
+#include "UdpTransport.h"
 
 // C++ API headers
 #include "Point.h"
 
 // Qt headers
+#include <QElapsedTimer>
 #include <QObject>
 
+// STL headers
+#include <memory>
+
 class QTimer;
 
 namespace Dsa {
 
-class DataSender;
+class CompactMessageCodec;
+class GeoMessageTemplate;
 
 class LocationBroadcast : public QObject
 {
   Q_OBJECT
 
 public:
+  enum class WireFormat
+  {
+    GeoMessage = 0,
+    Compact,
+    Tak
+  };
+
   explicit LocationBroadcast(QObject* parent = nullptr);
   LocationBroadcast(const QString& messageType, int udpPort, QObject* parent = nullptr);
   ~LocationBroadcast();
@@ -56,12 +70,35 @@ public:
   int udpPort() const;
   void setUdpPort(int port);
 
+  UdpTransport transport() const;
+  void setTransport(const UdpTransport& transport);
+
   int frequency() const;
   void setFrequency(int frequency);
 
   bool isInDistress() const;
   void setInDistress(bool inDistress);
 
+  WireFormat wireFormat() const;
+  void setWireFormat(WireFormat wireFormat);
+
+  static WireFormat toWireFormat(const QString& wireFormat);
+
+  bool isAdaptive() const;
+  void setAdaptive(bool adaptive);
+
+  double distanceThreshold() const;
+  void setDistanceThreshold(double distanceThreshold);
+
+  double headingThreshold() const;
+  void setHeadingThreshold(double headingThreshold);
+
+  int heartbeatInterval() const;
+  void setHeartbeatInterval(int heartbeatInterval);
+
+  bool isLatencyProbeEnabled() const;
+  void setLatencyProbeEnabled(bool latencyProbeEnabled);
+
   Message message() const;
 
   QString userName() const;
@@ -76,6 +113,9 @@ private:
   void update();
   void broadcastLocation();
   void removeBroadcast();
+  bool isBroadcastRequired();
+  void resetAdaptiveState();
+  void sendMessage(const Message& message);
 
   QString m_userName;
   bool m_enabled = true;
@@ -83,10 +123,26 @@ private:
   bool m_useCurrentLocation = true;
   QString m_messageType;
   int m_udpPort = -1;
+  UdpTransport m_transport;
   int m_frequency = 3000;
   bool m_inDistress = false;
-
-  DataSender* m_dataSender = nullptr;
+  WireFormat m_wireFormat = WireFormat::GeoMessage;
+
+  // adaptive (dead-reckoning) broadcast state
+  bool m_adaptive = false;
+  double m_distanceThreshold = 25.0;
+  double m_headingThreshold = 20.0;
+  int m_heartbeatInterval = 30000;
+  QElapsedTimer m_lastBroadcastTimer;
+  Esri::ArcGISRuntime::Point m_lastBroadcastLocation;
+  Esri::ArcGISRuntime::Point m_previousLocation;
+  double m_lastBroadcastHeading = -1.0;
+  double m_currentHeading = -1.0;
+  bool m_lastBroadcastInDistress = false;
+
+  std::unique_ptr<CompactMessageCodec> m_compactCodec;
+  std::unique_ptr<GeoMessageTemplate> m_geoMessageTemplate;
+  std::unique_ptr<LatencyProbe> m_latencyProbe;
   Message m_message;
   QTimer* m_timer = nullptr;
 
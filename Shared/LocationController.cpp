@@ -22,7 +22,11 @@
 
 // dsa app headers
 #include "GPXLocationSimulator.h"
+#include "HeadingFilter.h"
 #include "LocationDisplay3d.h"
+#include "LocationDistributor.h"
+#include "LocationSampler.h"
+#include "TravelPrefetcher.h"
 
 // toolkit headers
 #include "ToolManager.h"
@@ -30,9 +34,12 @@
 
 // C++ API headers
 #include "GraphicsOverlay.h"
+#include "MapView.h"
 #include "ModelSceneSymbol.h"
 #include "Point.h"
 #include "SceneQuickView.h"
+#include "SimpleLineSymbol.h"
+#include "SimpleMarkerSymbol.h"
 #include "SimpleRenderer.h"
 
 // Qt headers
@@ -49,13 +56,34 @@ namespace Dsa {
 
 const QString LocationController::SIMULATE_LOCATION_PROPERTYNAME = "SimulateLocation";
 const QString LocationController::GPX_FILE_PROPERTYNAME = "GpxFile";
+const QString LocationController::SIMULATION_UPDATE_INTERVAL_PROPERTYNAME = "SimulationUpdateInterval";
 const QString LocationController::RESOURCE_DIRECTORY_PROPERTYNAME = "ResourceDirectory";
+const QString LocationController::LOCATION_MINIMUM_DISTANCE_PROPERTYNAME = "LocationMinimumDistance";
+const QString LocationController::LOCATION_UPDATE_INTERVAL_PROPERTYNAME = "LocationUpdateInterval";
+const QString LocationController::LOCATION_SMOOTHING_PROPERTYNAME = "LocationSmoothing";
+const QString LocationController::PREFETCH_AHEAD_PROPERTYNAME = "PrefetchAhead";
+const QString LocationController::ADAPTIVE_LOCATION_SAMPLING_PROPERTYNAME = "AdaptiveLocationSampling";
+const QString LocationController::LOCATION_IDLE_INTERVAL_PROPERTYNAME = "LocationIdleInterval";
+
+// movement below this many meters is treated as GPS jitter by default
+static const double s_defaultMinimumDistance = 0.5;
 
 /*!
   \class Dsa::LocationController
   \inmodule Dsa
   \inherits AbstractTool
   \brief Tool controller for handling the current location.
+
+  Position updates are passed through a \l LocationDistributor before
+  \l locationChanged is emitted, so that jitter below a minimum distance is
+  dropped and consumers are updated at a limited rate.
+
+  The location and heading also drive a \l TravelPrefetcher, which prefetches the
+  elevation of the area ahead while moving at speed.
+
+  The update interval of the position source is set by a \l LocationSampler, which
+  samples less often while the location is stationary or no tool, such as following
+  the location, needs a high rate of updates.
  */
 
 /*!
@@ -63,9 +91,39 @@ const QString LocationController::RESOURCE_DIRECTORY_PROPERTYNAME = "ResourceDir
  */
 LocationController::LocationController(QObject* parent) :
   AbstractTool(parent),
-  m_locationDisplay3d(new LocationDisplay3d(this))
+  m_locationDisplay3d(new LocationDisplay3d(this)),
+  m_locationDistributor(new LocationDistributor(0, s_defaultMinimumDistance, this)),
+  m_locationSampler(new LocationSampler(this)),
+  m_headingFilter(new HeadingFilter(this)),
+  m_travelPrefetcher(new TravelPrefetcher(this))
 {
   connect(this, &LocationController::locationChanged, ToolResourceProvider::instance(), &ToolResourceProvider::onLocationChanged);
+  connect(m_locationDistributor, &LocationDistributor::locationChanged, this, [this](const Point& location)
+  {
+    m_currentLocation = location;
+    m_travelPrefetcher->setLocation(m_currentLocation);
+    emit locationChanged(m_currentLocation);
+  });
+
+  connect(m_locationSampler, &LocationSampler::updateIntervalChanged, this, [this](int updateInterval)
+  {
+    if (m_positionSource)
+      m_positionSource->setUpdateInterval(updateInterval);
+  });
+
+  // compass and simulated headings are filtered once for both the controller and the location display
+  m_locationDisplay3d->setHeadingFilter(m_headingFilter);
+  connect(m_headingFilter, &HeadingFilter::headingChanged, this, [this](double heading)
+  {
+    if (m_lastKnownHeading == heading)
+      return;
+
+    m_lastKnownHeading = heading;
+    m_travelPrefetcher->setHeading(heading);
+
+    emit headingChanged(heading);
+    emit relativeHeadingChanged(heading - m_lastViewHeading);
+  });
   connect(ToolResourceProvider::instance(), &ToolResourceProvider::geoViewChanged, this, &LocationController::updateGeoView);
 
   updateGeoView();
@@ -89,45 +147,36 @@ void LocationController::initPositionInfoSource()
     return;
 
   clearPositionInfoSource();
+  m_locationDistributor->reset();
+  m_locationSampler->reset();
+  m_headingFilter->reset();
+  m_travelPrefetcher->reset();
 
   if (isSimulationEnabled())
   {
     auto gpxLocationSimulator = new GPXLocationSimulator(this);
+    gpxLocationSimulator->setUpdateInterval(m_simulationUpdateInterval);
 
     if (!m_gpxFilePath.isEmpty())
       gpxLocationSimulator->setGpxFile(m_gpxFilePath);
 
     m_positionSource = gpxLocationSimulator;
 
-    connect(gpxLocationSimulator, &GPXLocationSimulator::headingChanged, this,
-    [this](double heading)
-    {
-      if (m_lastKnownHeading == heading)
-        return;
-
-      m_lastKnownHeading = heading;
+    // simulated positions are interpolated, so the configured interval is the active rate
+    m_locationSampler->setActiveInterval(m_simulationUpdateInterval);
 
-      emit headingChanged(heading);
-      emit relativeHeadingChanged(heading - m_lastViewHeading);
-    });
+    connect(gpxLocationSimulator, &GPXLocationSimulator::headingChanged, m_headingFilter, &HeadingFilter::addHeading);
   }
   else
   {
     m_positionSource = QGeoPositionInfoSource::createDefaultSource(this);
 
-    m_compass = new QCompass(this);
-
-    connect(m_compass, &QCompass::readingChanged, this, [this]()
-    {
-      if (!m_compass)
-        return;
+    // the device's own interval is the active rate
+    m_locationSampler->setActiveInterval(0);
 
-      QCompassReading* reading = m_compass->reading();
-      if (!reading)
-        return;
-
-      emit headingChanged(static_cast<double>(reading->azimuth()));
-    });
+    // the heading filter is the only subscriber to the compass readings
+    m_compass = new QCompass(this);
+    m_headingFilter->setCompass(m_compass);
   }
 
   connect(m_positionSource, &QGeoPositionInfoSource::positionUpdated, this,
@@ -141,25 +190,33 @@ void LocationController::initPositionInfoSource()
     if (!pos.isValid())
       return;
 
+    Point location;
     switch (pos.type())
     {
       case QGeoCoordinate::Coordinate2D:
-        m_currentLocation = Point(pos.longitude(), pos.latitude(), SpatialReference::wgs84());
+        location = Point(pos.longitude(), pos.latitude(), SpatialReference::wgs84());
         break;
       case QGeoCoordinate::Coordinate3D:
-        m_currentLocation = Point(pos.longitude(), pos.latitude(), pos.altitude(), SpatialReference::wgs84());
+        location = Point(pos.longitude(), pos.latitude(), pos.altitude(), SpatialReference::wgs84());
         break;
       case QGeoCoordinate::InvalidCoordinate:
       default:
         return;
     }
 
-    emit locationChanged(m_currentLocation);
+    const double accuracy = update.hasAttribute(QGeoPositionInfo::HorizontalAccuracy) ?
+          update.attribute(QGeoPositionInfo::HorizontalAccuracy) : -1.0;
+    const double speed = update.hasAttribute(QGeoPositionInfo::GroundSpeed) ?
+          update.attribute(QGeoPositionInfo::GroundSpeed) : -1.0;
+
+    m_locationSampler->addLocation(location, speed);
+    m_locationDistributor->addLocation(location, accuracy);
   });
 
-  // apply position source and compass to the location display
+  m_positionSource->setUpdateInterval(m_locationSampler->updateInterval());
+
+  // apply position source to the location display
   m_locationDisplay3d->setPositionSource(m_positionSource);
-  m_locationDisplay3d->setCompass(m_compass);
 }
 
 /*!
@@ -176,6 +233,7 @@ void LocationController::clearPositionInfoSource()
 
   if (m_compass)
   {
+    m_headingFilter->setCompass(nullptr);
     m_compass->stop();
     delete m_compass;
     m_compass = nullptr;
@@ -198,14 +256,45 @@ QString LocationController::toolName() const
  *  \li \c SimulateLocation - Whether the app's location should be simulated.
  *  \li \c GpxFile - The path of the GPX file for simulated positions.
  *  \li \c ResourceDirectory - The directory containing icons for the location display.
+ *  \li \c LocationMinimumDistance - The movement in meters below which position updates are ignored.
+ *  \li \c LocationUpdateInterval - The shortest time in milliseconds between location updates.
+ *  \li \c LocationSmoothing - Whether positions are smoothed before being used.
+ *  \li \c PrefetchAhead - Whether the elevation of the area ahead is prefetched while moving.
+ *  \li \c AdaptiveLocationSampling - Whether the position source is sampled less often while
+ *      stationary or while no tool needs a high rate of updates.
+ *  \li \c LocationIdleInterval - The time in milliseconds between position updates while
+ *      sampling less often.
  * \endlist
  */
 void LocationController::setProperties(const QVariantMap& properties)
 {
   const bool simulate = QString::compare(properties[SIMULATE_LOCATION_PROPERTYNAME].toString(), QString("true"), Qt::CaseInsensitive) == 0;
+  // simulated positions are interpolated, so a short interval, for example 33ms,
+  // gives smooth movement
+  const int updateInterval = properties.value(SIMULATION_UPDATE_INTERVAL_PROPERTYNAME, m_simulationUpdateInterval).toInt();
+  if (updateInterval > 0)
+    m_simulationUpdateInterval = updateInterval;
+
   setGpxFilePath(properties[GPX_FILE_PROPERTYNAME].toString());
   setSimulationEnabled(simulate);
   setIconDataPath(properties[RESOURCE_DIRECTORY_PROPERTYNAME].toString());
+
+  m_locationDistributor->setMinimumDistance(properties.value(LOCATION_MINIMUM_DISTANCE_PROPERTYNAME, m_locationDistributor->minimumDistance()).toDouble());
+  m_locationDistributor->setMinimumInterval(properties.value(LOCATION_UPDATE_INTERVAL_PROPERTYNAME, m_locationDistributor->minimumInterval()).toInt());
+
+  const auto smoothing = properties.value(LOCATION_SMOOTHING_PROPERTYNAME);
+  if (smoothing.isValid())
+    m_locationDistributor->setSmoothingEnabled(QString::compare(smoothing.toString(), QString("true"), Qt::CaseInsensitive) == 0);
+
+  const auto prefetchAhead = properties.value(PREFETCH_AHEAD_PROPERTYNAME);
+  if (prefetchAhead.isValid())
+    m_travelPrefetcher->setEnabled(QString::compare(prefetchAhead.toString(), QString("true"), Qt::CaseInsensitive) == 0);
+
+  const auto adaptiveSampling = properties.value(ADAPTIVE_LOCATION_SAMPLING_PROPERTYNAME);
+  if (adaptiveSampling.isValid())
+    m_locationSampler->setAdaptive(QString::compare(adaptiveSampling.toString(), QString("true"), Qt::CaseInsensitive) == 0);
+
+  m_locationSampler->setIdleInterval(properties.value(LOCATION_IDLE_INTERVAL_PROPERTYNAME, m_locationSampler->idleInterval()).toInt());
 }
 
 /*!
@@ -317,6 +406,44 @@ LocationDisplay3d* LocationController::locationDisplay() const
   return m_locationDisplay3d;
 }
 
+/*!
+  \brief Returns the distributor which filters the position updates before
+  \l locationChanged is emitted.
+ */
+LocationDistributor* LocationController::locationDistributor() const
+{
+  return m_locationDistributor;
+}
+
+/*!
+  \brief Returns the sampler which sets the update interval of the position source.
+
+  Tools which need a high rate of updates, such as following the location, mark
+  themselves as active consumers with \l LocationSampler::setConsumerActive.
+ */
+LocationSampler* LocationController::locationSampler() const
+{
+  return m_locationSampler;
+}
+
+/*!
+  \brief Returns the filter which smooths and rate limits the headings before
+  \l headingChanged is emitted.
+ */
+HeadingFilter* LocationController::headingFilter() const
+{
+  return m_headingFilter;
+}
+
+/*!
+  \brief Returns the prefetcher which loads the elevation of the area ahead
+  while moving.
+ */
+TravelPrefetcher* LocationController::travelPrefetcher() const
+{
+  return m_travelPrefetcher;
+}
+
 /*!
   \property LocationController::gpxFilePath
   \brief Returns the file path of the GPX file.
@@ -389,6 +516,15 @@ void LocationController::updateGeoView()
 
     constexpr float symbolSize = 25.0;
 
+    // a 2D map view cannot draw the 3D model, so a marker pointing along the heading is used instead
+    if (dynamic_cast<MapView*>(geoView))
+    {
+      SimpleMarkerSymbol* markerSymbol = new SimpleMarkerSymbol(SimpleMarkerSymbolStyle::Triangle, QColor("steelblue"), symbolSize, this);
+      markerSymbol->setOutline(new SimpleLineSymbol(SimpleLineSymbolStyle::Solid, Qt::white, 2.0, this));
+      m_locationDisplay3d->setDefaultSymbol(markerSymbol);
+      return;
+    }
+
     ModelSceneSymbol* modelSceneSymbol = new ModelSceneSymbol(modelSymbolPath(), this);
     modelSceneSymbol->setWidth(symbolSize);
     modelSceneSymbol->setDepth(symbolSize);
@@ -38,7 +38,11 @@ class QCompass;
 namespace Dsa {
 
 class GPXLocationSimulator;
+class HeadingFilter;
 class LocationDisplay3d;
+class LocationDistributor;
+class LocationSampler;
+class TravelPrefetcher;
 
 class LocationController : public AbstractTool
 {
@@ -52,7 +56,14 @@ class LocationController : public AbstractTool
 public:
   static const QString SIMULATE_LOCATION_PROPERTYNAME;
   static const QString GPX_FILE_PROPERTYNAME;
+  static const QString SIMULATION_UPDATE_INTERVAL_PROPERTYNAME;
   static const QString RESOURCE_DIRECTORY_PROPERTYNAME;
+  static const QString LOCATION_MINIMUM_DISTANCE_PROPERTYNAME;
+  static const QString LOCATION_UPDATE_INTERVAL_PROPERTYNAME;
+  static const QString LOCATION_SMOOTHING_PROPERTYNAME;
+  static const QString PREFETCH_AHEAD_PROPERTYNAME;
+  static const QString ADAPTIVE_LOCATION_SAMPLING_PROPERTYNAME;
+  static const QString LOCATION_IDLE_INTERVAL_PROPERTYNAME;
 
   explicit LocationController(QObject* parent = nullptr);
   ~LocationController();
@@ -72,6 +83,10 @@ public:
   Esri::ArcGISRuntime::Point currentLocation() const;
 
   LocationDisplay3d* locationDisplay() const;
+  LocationDistributor* locationDistributor() const;
+  LocationSampler* locationSampler() const;
+  HeadingFilter* headingFilter() const;
+  TravelPrefetcher* travelPrefetcher() const;
 
   QString gpxFilePath() const;
   void setGpxFilePath(const QString& gpxFilePath);
@@ -111,12 +126,17 @@ private:
   QGeoPositionInfoSource* m_positionSource = nullptr;
   QCompass* m_compass = nullptr;
   LocationDisplay3d* m_locationDisplay3d = nullptr;
+  LocationDistributor* m_locationDistributor = nullptr;
+  LocationSampler* m_locationSampler = nullptr;
+  HeadingFilter* m_headingFilter = nullptr;
+  TravelPrefetcher* m_travelPrefetcher = nullptr;
   bool m_enabled = false;
   bool m_simulated = false;
   double m_lastViewHeading = 0.0;
   double m_lastKnownHeading = 0.0;
   Esri::ArcGISRuntime::Point m_currentLocation;
   QString m_gpxFilePath;
+  int m_simulationUpdateInterval = 500;
   QString m_iconDataPath;
 };
 
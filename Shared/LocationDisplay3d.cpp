@@ -20,14 +20,15 @@
 #include "LocationDisplay3d.h"
 
 // dsa app headers
-#include "GPXLocationSimulator.h"
+#include "HeadingFilter.h"
 
 // C++ API headers
 #include "GraphicsOverlay.h"
+#include "MarkerSceneSymbol.h"
 #include "SimpleRenderer.h"
 
 // Qt headers
-#include <QCompass>
+#include <QGeoPositionInfoSource>
 
 // STL headers
 #include <cmath>
@@ -156,58 +157,40 @@ void LocationDisplay3d::setPositionSource(QGeoPositionInfoSource* positionSource
     emit locationChanged(m_lastKnownLocation);
   });
 
-  auto* gpxLocationSimulator = dynamic_cast<GPXLocationSimulator*>(m_geoPositionInfoSource);
-  if (gpxLocationSimulator)
-  {
-    if (m_headingConnection)
-      disconnect(m_headingConnection);
-
-    m_headingConnection = connect(gpxLocationSimulator, &GPXLocationSimulator::headingChanged, this, [this](double heading)
-    {
-      m_locationGraphic->attributes()->replaceAttribute(s_headingAttribute, heading);
-    });
-  }
-
   if (isStarted())
     m_geoPositionInfoSource->startUpdates();
 }
 
 /*!
-  \brief Returns the compass for the location display.
+  \brief Returns the heading filter for the location display.
  */
-QCompass* LocationDisplay3d::compass() const
+HeadingFilter* LocationDisplay3d::headingFilter() const
 {
-  return m_compass;
+  return m_headingFilter;
 }
 
 /*!
-  \brief Sets the compass for the location display to \a compass.
+  \brief Sets the heading filter for the location display to \a headingFilter.
+
+  The heading of the location graphic is only updated with the filtered
+  headings, since every change re-renders the location symbol.
  */
-void LocationDisplay3d::setCompass(QCompass* compass)
+void LocationDisplay3d::setHeadingFilter(HeadingFilter* headingFilter)
 {
-  m_compass = compass;
-
-  if (!m_compass)
-    return;
-
   if (m_headingConnection)
     disconnect(m_headingConnection);
 
-  m_headingConnection = connect(m_compass, &QCompass::readingChanged, this, [this]()
-  {
-    if (!m_compass)
-      return;
+  m_headingFilter = headingFilter;
 
-    QCompassReading* reading = m_compass->reading();
-    if (!reading)
-      return;
+  if (!m_headingFilter)
+    return;
 
-    m_locationGraphic->attributes()->replaceAttribute(s_headingAttribute, static_cast<double>(reading->azimuth()));
+  m_headingConnection = connect(m_headingFilter, &HeadingFilter::headingChanged, this, [this](double heading)
+  {
+    m_locationGraphic->attributes()->replaceAttribute(s_headingAttribute, heading);
 
     emit headingChanged();
   });
-
-  m_compass->start();
 }
 
 /*!
@@ -248,6 +231,7 @@ void LocationDisplay3d::setDefaultSymbol(Symbol* defaultSymbol)
     RendererSceneProperties renderProperties = m_locationRenderer->sceneProperties();
     renderProperties.setHeadingExpression(QString("[%1]").arg(s_headingAttribute));
     m_locationRenderer->setSceneProperties(renderProperties);
+    m_locationRenderer->setRotationType(RotationType::Geographic);
 
     m_locationOverlay->setRenderer(m_locationRenderer);
   }
@@ -255,6 +239,10 @@ void LocationDisplay3d::setDefaultSymbol(Symbol* defaultSymbol)
   {
     m_locationRenderer->setSymbol(defaultSymbol);
   }
+
+  // the heading expression only applies to scene symbols, so markers drawn in a 2D map are rotated instead
+  const bool isSceneSymbol = qobject_cast<MarkerSceneSymbol*>(defaultSymbol) != nullptr;
+  m_locationRenderer->setRotationExpression(isSceneSymbol ? QString() : QString("[%1]").arg(s_headingAttribute));
 }
 
 /*!
@@ -32,10 +32,11 @@ namespace ArcGISRuntime {
 }}
 
 class QGeoPositionInfoSource;
-class QCompass;
 
 namespace Dsa {
 
+class HeadingFilter;
+
 class LocationDisplay3d : public QObject
 {
   Q_OBJECT
@@ -51,8 +52,8 @@ public:
   QGeoPositionInfoSource* positionSource() const;
   void setPositionSource(QGeoPositionInfoSource* positionSource);
 
-  QCompass* compass() const;
-  void setCompass(QCompass* compass);
+  HeadingFilter* headingFilter() const;
+  void setHeadingFilter(HeadingFilter* headingFilter);
 
   Esri::ArcGISRuntime::GraphicsOverlay* locationOverlay() const;
 
@@ -75,7 +76,7 @@ private:
   Esri::ArcGISRuntime::Graphic* m_locationGraphic = nullptr;
   Esri::ArcGISRuntime::Symbol* m_defaultSymbol = nullptr;
   QGeoPositionInfoSource* m_geoPositionInfoSource = nullptr;
-  QCompass* m_compass = nullptr;
+  HeadingFilter* m_headingFilter = nullptr;
   Esri::ArcGISRuntime::Point m_lastKnownLocation;
   bool m_isStarted = false;
 
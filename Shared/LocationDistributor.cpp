@@ -0,0 +1,324 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "LocationDistributor.h"
+
+// dsa app headers
+#include "GeodesicKernels.h"
+
+// toolkit headers
+#include "ToolResourceProvider.h"
+
+// Qt headers
+#include <QTimer>
+
+// STL headers
+#include <cmath>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+// accuracy assumed for locations which do not report one, in meters
+static const double s_defaultAccuracy = 5.0;
+
+/*!
+  \class Dsa::LocationDistributor
+  \inmodule Dsa
+  \inherits QObject
+  \brief Passes on location updates at a limited rate, dropping positional jitter.
+
+  A GPS receiver may report several times a second with sub-meter jitter, and every
+  report would otherwise be handled by every consumer of the location. Locations
+  given to \l addLocation are passed on by \l locationChanged when:
+
+  \list
+    \li They are at least \l minimumDistance meters from the last location passed on.
+    \li At least \l minimumInterval milliseconds have passed since the last location
+    was passed on. Locations which arrive sooner are held back and the latest one is
+    passed on when the interval has elapsed, so the last position is never lost.
+  \endlist
+
+  When smoothing is enabled, locations are first passed through a Kalman filter which
+  weights each fix by its reported horizontal accuracy and assumes the device moves
+  at up to \l smoothingSpeed meters per second.
+
+  \l LocationController uses a distributor for the device location. A consumer which
+  needs the location less often can create its own distributor with
+  \l subscribeToDeviceLocation and connect to it instead of
+  \l ToolResourceProvider::locationChanged.
+ */
+
+/*!
+  \brief Constructor taking an optional \a parent.
+
+  By default every location is passed on.
+ */
+LocationDistributor::LocationDistributor(QObject* parent) :
+  QObject(parent),
+  m_pendingTimer(new QTimer(this))
+{
+  m_pendingTimer->setSingleShot(true);
+  connect(m_pendingTimer, &QTimer::timeout, this, &LocationDistributor::deliverPending);
+  m_clock.start();
+}
+
+/*!
+  \brief Constructor taking a \a minimumInterval in milliseconds, a \a minimumDistance
+  in meters and an optional \a parent.
+ */
+LocationDistributor::LocationDistributor(int minimumInterval, double minimumDistance, QObject* parent) :
+  LocationDistributor(parent)
+{
+  setMinimumInterval(minimumInterval);
+  setMinimumDistance(minimumDistance);
+}
+
+/*!
+  \brief Destructor.
+ */
+LocationDistributor::~LocationDistributor()
+{
+}
+
+/*!
+  \brief Receives the device location from \l ToolResourceProvider::locationChanged.
+ */
+void LocationDistributor::subscribeToDeviceLocation()
+{
+  connect(ToolResourceProvider::instance(), &ToolResourceProvider::locationChanged, this, [this](const Point& location)
+  {
+    addLocation(location);
+  });
+}
+
+/*!
+  \brief Returns the distance in meters which a location must move to be passed on.
+ */
+double LocationDistributor::minimumDistance() const
+{
+  return m_minimumDistance;
+}
+
+/*!
+  \brief Sets the distance in meters which a location must move to be passed on to
+  \a minimumDistance. \c 0 passes on every location.
+ */
+void LocationDistributor::setMinimumDistance(double minimumDistance)
+{
+  m_minimumDistance = qMax(0.0, minimumDistance);
+}
+
+/*!
+  \brief Returns the shortest time in milliseconds between locations being passed on.
+ */
+int LocationDistributor::minimumInterval() const
+{
+  return m_minimumInterval;
+}
+
+/*!
+  \brief Sets the shortest time in milliseconds between locations being passed on to
+  \a minimumInterval. \c 0 does not limit the rate.
+ */
+void LocationDistributor::setMinimumInterval(int minimumInterval)
+{
+  m_minimumInterval = qMax(0, minimumInterval);
+}
+
+/*!
+  \brief Returns whether locations are smoothed before being passed on.
+ */
+bool LocationDistributor::isSmoothingEnabled() const
+{
+  return m_smoothingEnabled;
+}
+
+/*!
+  \brief Sets whether locations are smoothed before being passed on to \a smoothingEnabled.
+ */
+void LocationDistributor::setSmoothingEnabled(bool smoothingEnabled)
+{
+  if (m_smoothingEnabled == smoothingEnabled)
+    return;
+
+  m_smoothingEnabled = smoothingEnabled;
+  m_variance = -1.0;
+}
+
+/*!
+  \brief Returns the speed in meters per second which the smoothing expects the
+  device to move at.
+ */
+double LocationDistributor::smoothingSpeed() const
+{
+  return m_smoothingSpeed;
+}
+
+/*!
+  \brief Sets the speed in meters per second which the smoothing expects the device
+  to move at to \a smoothingSpeed.
+
+  Higher speeds follow the reported locations more closely.
+ */
+void LocationDistributor::setSmoothingSpeed(double smoothingSpeed)
+{
+  if (smoothingSpeed > 0.0)
+    m_smoothingSpeed = smoothingSpeed;
+}
+
+/*!
+  \brief Returns the last location which was passed on.
+ */
+Point LocationDistributor::location() const
+{
+  return m_deliveredLocation;
+}
+
+/*!
+  \brief Adds a new \a location with an optional \a horizontalAccuracy in meters.
+
+  The location is passed on immediately, held back until the minimum interval
+  has elapsed or dropped, as described above.
+ */
+void LocationDistributor::addLocation(const Point& location, double horizontalAccuracy)
+{
+  if (location.isEmpty())
+    return;
+
+  const Point filtered = m_smoothingEnabled ? smooth(location, horizontalAccuracy) : location;
+  if (!hasMoved(filtered))
+  {
+    // a newer location inside the threshold replaces any held back one
+    m_pendingTimer->stop();
+    return;
+  }
+
+  const qint64 remaining = m_hasDelivered ? m_minimumInterval - (m_clock.elapsed() - m_lastDeliveryTime) : 0;
+  if (remaining <= 0)
+  {
+    m_pendingTimer->stop();
+    deliver(filtered);
+    return;
+  }
+
+  m_pendingLocation = filtered;
+  if (!m_pendingTimer->isActive())
+    m_pendingTimer->start(static_cast<int>(remaining));
+}
+
+/*!
+  \brief Discards any held back location and the smoothing state, so that the next
+  location is passed on immediately.
+ */
+void LocationDistributor::reset()
+{
+  m_pendingTimer->stop();
+  m_hasDelivered = false;
+  m_variance = -1.0;
+}
+
+/*!
+  \internal
+
+  Returns the smoothed estimate after adding \a location.
+ */
+Point LocationDistributor::smooth(const Point& location, double horizontalAccuracy)
+{
+  const double accuracy = horizontalAccuracy > 0.0 ? horizontalAccuracy : s_defaultAccuracy;
+  const double measurementVariance = accuracy * accuracy;
+  const qint64 now = m_clock.elapsed();
+
+  if (m_variance < 0.0)
+  {
+    m_estimateX = location.x();
+    m_estimateY = location.y();
+    m_estimateZ = location.z();
+    m_variance = measurementVariance;
+  }
+  else
+  {
+    // the uncertainty of the estimate grows with the time since the last fix
+    const double seconds = (now - m_lastEstimateTime) / 1000.0;
+    if (seconds > 0.0)
+      m_variance += seconds * m_smoothingSpeed * m_smoothingSpeed;
+
+    const double gain = m_variance / (m_variance + measurementVariance);
+    m_estimateX += gain * (location.x() - m_estimateX);
+    m_estimateY += gain * (location.y() - m_estimateY);
+    if (location.hasZ())
+      m_estimateZ += gain * (location.z() - m_estimateZ);
+
+    m_variance *= (1.0 - gain);
+  }
+
+  m_lastEstimateTime = now;
+
+  return location.hasZ() ?
+        Point(m_estimateX, m_estimateY, m_estimateZ, location.spatialReference()) :
+        Point(m_estimateX, m_estimateY, location.spatialReference());
+}
+
+/*!
+  \internal
+
+  Returns whether \a location is far enough from the last location passed on.
+ */
+bool LocationDistributor::hasMoved(const Point& location) const
+{
+  if (!m_hasDelivered || m_minimumDistance <= 0.0)
+    return true;
+
+  // locations are in WGS84 degrees
+  const double distance = Geodesic::haversineDistance(m_deliveredLocation.y(), m_deliveredLocation.x(),
+                                                      location.y(), location.x());
+  if (distance >= m_minimumDistance)
+    return true;
+
+  // altitude changes, for example while flying, are also movement
+  return location.hasZ() && std::abs(location.z() - m_deliveredLocation.z()) >= m_minimumDistance;
+}
+
+/*!
+  \internal
+ */
+void LocationDistributor::deliver(const Point& location)
+{
+  m_deliveredLocation = location;
+  m_lastDeliveryTime = m_clock.elapsed();
+  m_hasDelivered = true;
+
+  emit locationChanged(location);
+}
+
+/*!
+  \internal
+ */
+void LocationDistributor::deliverPending()
+{
+  deliver(m_pendingLocation);
+}
+
+// Signal Documentation
+/*!
+  \fn void LocationDistributor::locationChanged(const Esri::ArcGISRuntime::Point& location);
+  \brief Signals that the distributed \a location has changed.
+ */
+
+} // Dsa
@@ -0,0 +1,92 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef LOCATIONDISTRIBUTOR_H
+#define LOCATIONDISTRIBUTOR_H
+
+// C++ API headers
+#include "Point.h"
+
+// Qt headers
+#include <QElapsedTimer>
+#include <QObject>
+
+class QTimer;
+
+namespace Dsa {
+
+class LocationDistributor : public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit LocationDistributor(QObject* parent = nullptr);
+  LocationDistributor(int minimumInterval, double minimumDistance, QObject* parent = nullptr);
+  ~LocationDistributor();
+
+  void subscribeToDeviceLocation();
+
+  double minimumDistance() const;
+  void setMinimumDistance(double minimumDistance);
+
+  int minimumInterval() const;
+  void setMinimumInterval(int minimumInterval);
+
+  bool isSmoothingEnabled() const;
+  void setSmoothingEnabled(bool smoothingEnabled);
+
+  double smoothingSpeed() const;
+  void setSmoothingSpeed(double smoothingSpeed);
+
+  Esri::ArcGISRuntime::Point location() const;
+
+  void addLocation(const Esri::ArcGISRuntime::Point& location, double horizontalAccuracy = -1.0);
+  void reset();
+
+signals:
+  void locationChanged(const Esri::ArcGISRuntime::Point& location);
+
+private:
+  Q_DISABLE_COPY(LocationDistributor)
+
+  Esri::ArcGISRuntime::Point smooth(const Esri::ArcGISRuntime::Point& location, double horizontalAccuracy);
+  bool hasMoved(const Esri::ArcGISRuntime::Point& location) const;
+  void deliver(const Esri::ArcGISRuntime::Point& location);
+  void deliverPending();
+
+  double m_minimumDistance = 0.0;
+  int m_minimumInterval = 0;
+  bool m_smoothingEnabled = false;
+  double m_smoothingSpeed = 3.0;
+
+  QElapsedTimer m_clock;
+  QTimer* m_pendingTimer = nullptr;
+  Esri::ArcGISRuntime::Point m_pendingLocation;
+  Esri::ArcGISRuntime::Point m_deliveredLocation;
+  qint64 m_lastDeliveryTime = 0;
+  bool m_hasDelivered = false;
+
+  // the smoothed estimate and its variance in square meters
+  double m_estimateX = 0.0;
+  double m_estimateY = 0.0;
+  double m_estimateZ = 0.0;
+  double m_variance = -1.0;
+  qint64 m_lastEstimateTime = 0;
+};
+
+} // Dsa
+
+#endif // LOCATIONDISTRIBUTOR_H
@@ -0,0 +1,254 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+
+// PCH header
+#include "pch.hpp"
+
+#include "LocationSampler.h"
+
+// dsa app headers
+#include "GeodesicKernels.h"
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+namespace
+{
+
+// a reported speed above this, in meters per second, is movement
+constexpr double s_movingSpeed = 1.0;
+
+// without a reported speed, moving this far from where the last movement was seen is
+// movement, so that GPS jitter while standing still is not
+constexpr double s_movementDistance = 15.0;
+
+// the location is only taken to be stationary once it has not moved for this long, in ms,
+// which is longer than walking pace takes to cover the movement distance
+constexpr qint64 s_stationaryDelay = 30000;
+
+}
+
+/*!
+  \class Dsa::LocationSampler
+  \inmodule Dsa
+  \inherits QObject
+  \brief Chooses how often the position source is sampled, from whether the location
+  is moving and whether any tool needs a high rate of updates.
+
+  The \l {activeInterval}{active interval} is used while the location is moving and at
+  least one consumer, such as following the location or a viewshed on the location, is
+  \l {setConsumerActive}{active}. Otherwise, when the location has been stationary for
+  30 seconds or nothing needs a high rate, the longer \l {idleInterval}{idle interval}
+  is used, saving battery and the processing of each position downstream.
+
+  A location is moving when its reported speed is above 1 m/s or, without a speed, when
+  it is 15 m from where movement was last seen. Movement seen at the idle interval
+  restores the active interval at once.
+ */
+
+/*!
+  \brief Constructor taking an optional \a parent.
+ */
+LocationSampler::LocationSampler(QObject* parent) :
+  QObject(parent)
+{
+  m_lastMovement.start();
+}
+
+/*!
+  \brief Destructor.
+ */
+LocationSampler::~LocationSampler()
+{
+}
+
+/*!
+  \brief Returns whether the update interval adapts to the movement and the consumers.
+
+  When not adaptive the \l activeInterval is always used. The default is \c true.
+ */
+bool LocationSampler::isAdaptive() const
+{
+  return m_adaptive;
+}
+
+/*!
+  \brief Sets whether the update interval adapts to the movement and the consumers to \a adaptive.
+ */
+void LocationSampler::setAdaptive(bool adaptive)
+{
+  if (m_adaptive == adaptive)
+    return;
+
+  m_adaptive = adaptive;
+  updateRate();
+}
+
+/*!
+  \brief Returns the update interval in milliseconds used while the location is
+  moving and a consumer is active.
+
+  \c 0 is the position source's own default. The default is \c 0.
+ */
+int LocationSampler::activeInterval() const
+{
+  return m_activeInterval;
+}
+
+/*!
+  \brief Sets the update interval in milliseconds used while the location is moving
+  and a consumer is active to \a activeInterval.
+ */
+void LocationSampler::setActiveInterval(int activeInterval)
+{
+  m_activeInterval = qMax(0, activeInterval);
+  updateRate();
+}
+
+/*!
+  \brief Returns the update interval in milliseconds used while the location is
+  stationary or no consumer is active.
+
+  The default is \c 5000.
+ */
+int LocationSampler::idleInterval() const
+{
+  return m_idleInterval;
+}
+
+/*!
+  \brief Sets the update interval in milliseconds used while the location is
+  stationary or no consumer is active to \a idleInterval.
+ */
+void LocationSampler::setIdleInterval(int idleInterval)
+{
+  m_idleInterval = qMax(0, idleInterval);
+  updateRate();
+}
+
+/*!
+  \brief Sets whether \a consumer needs a high rate of updates to \a active.
+
+  A consumer which is destroyed is no longer active.
+ */
+void LocationSampler::setConsumerActive(QObject* consumer, bool active)
+{
+  if (!consumer || m_consumers.contains(consumer) == active)
+    return;
+
+  if (active)
+  {
+    m_consumers.insert(consumer);
+    connect(consumer, &QObject::destroyed, this, [this, consumer]()
+    {
+      m_consumers.remove(consumer);
+      updateRate();
+    });
+  }
+  else
+  {
+    m_consumers.remove(consumer);
+    disconnect(consumer, &QObject::destroyed, this, nullptr);
+  }
+
+  updateRate();
+}
+
+/*!
+  \brief Returns whether any consumer needs a high rate of updates.
+ */
+bool LocationSampler::hasActiveConsumer() const
+{
+  return !m_consumers.isEmpty();
+}
+
+/*!
+  \brief Returns whether the location has moved within the last 30 seconds.
+ */
+bool LocationSampler::isMoving() const
+{
+  return m_moving;
+}
+
+/*!
+  \brief Returns the update interval in milliseconds the position source should use.
+ */
+int LocationSampler::updateInterval() const
+{
+  return m_updateInterval;
+}
+
+/*!
+  \brief Adds a \a location, in WGS84, with the \a speed in meters per second
+  reported with it, or \c -1 if no speed was reported.
+ */
+void LocationSampler::addLocation(const Point& location, double speed /* = -1.0 */)
+{
+  if (location.isEmpty())
+    return;
+
+  bool moved = speed >= s_movingSpeed;
+  if (!moved)
+  {
+    moved = m_anchor.isEmpty() ||
+            Geodesic::haversineDistance(m_anchor.y(), m_anchor.x(), location.y(), location.x()) >= s_movementDistance;
+  }
+
+  if (moved)
+  {
+    m_anchor = location;
+    m_lastMovement.restart();
+  }
+
+  m_moving = m_lastMovement.elapsed() < s_stationaryDelay;
+  updateRate();
+}
+
+/*!
+  \brief Forgets the locations added so far, so that the location is taken to be
+  moving until it has been seen to be stationary.
+ */
+void LocationSampler::reset()
+{
+  m_anchor = Point();
+  m_lastMovement.restart();
+  m_moving = true;
+  updateRate();
+}
+
+/*!
+  \internal
+ */
+void LocationSampler::updateRate()
+{
+  const bool active = !m_adaptive || (m_moving && !m_consumers.isEmpty());
+  const int updateInterval = active ? m_activeInterval : qMax(m_activeInterval, m_idleInterval);
+  if (m_updateInterval == updateInterval)
+    return;
+
+  m_updateInterval = updateInterval;
+  emit updateIntervalChanged(m_updateInterval);
+}
+
+} // Dsa
+
+// Signal Documentation
+/*!
+  \fn void LocationSampler::updateIntervalChanged(int updateInterval);
+  \brief Signal emitted when the \a updateInterval the position source should use changes.
+ */
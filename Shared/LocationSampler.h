@@ -0,0 +1,77 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+
+#ifndef LOCATIONSAMPLER_H
+#define LOCATIONSAMPLER_H
+
+// C++ API headers
+#include "Point.h"
+
+// Qt headers
+#include <QElapsedTimer>
+#include <QObject>
+#include <QSet>
+
+namespace Dsa {
+
+class LocationSampler : public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit LocationSampler(QObject* parent = nullptr);
+  ~LocationSampler();
+
+  bool isAdaptive() const;
+  void setAdaptive(bool adaptive);
+
+  int activeInterval() const;
+  void setActiveInterval(int activeInterval);
+
+  int idleInterval() const;
+  void setIdleInterval(int idleInterval);
+
+  void setConsumerActive(QObject* consumer, bool active);
+  bool hasActiveConsumer() const;
+
+  bool isMoving() const;
+  int updateInterval() const;
+
+  void addLocation(const Esri::ArcGISRuntime::Point& location, double speed = -1.0);
+  void reset();
+
+signals:
+  void updateIntervalChanged(int updateInterval);
+
+private:
+  Q_DISABLE_COPY(LocationSampler)
+
+  void updateRate();
+
+  bool m_adaptive = true;
+  int m_activeInterval = 0;
+  int m_idleInterval = 5000;
+  int m_updateInterval = 0;
+  bool m_moving = true;
+  QSet<QObject*> m_consumers;
+  Esri::ArcGISRuntime::Point m_anchor;
+  QElapsedTimer m_lastMovement;
+};
+
+} // Dsa
+
+#endif // LOCATIONSAMPLER_H
@@ -20,12 +20,16 @@
 
 #include "LocationTextController.h"
 
+// dsa app headers
+#include "CoordinateFormatUtils.h"
+#include "ElevationSampleCache.h"
+#include "LocationDistributor.h"
+
 // toolkit headers
 #include "ToolManager.h"
 #include "ToolResourceProvider.h"
 
 // C++ API headers
-#include "CoordinateFormatter.h"
 #include "Scene.h"
 #include "Surface.h"
 
@@ -50,6 +54,9 @@ const QString LocationTextController::Gars = QStringLiteral("GARS");
 const QString LocationTextController::Meters = QStringLiteral("meters");
 const QString LocationTextController::Feet = QStringLiteral("feet");
 
+// the shortest time between updates of the location text, in ms
+static const int s_textUpdateInterval = 250;
+
 /*!
   \class Dsa::LocationTextController
   \inmodule Dsa
@@ -68,9 +75,19 @@ LocationTextController::LocationTextController(QObject* parent) :
   connect(ToolResourceProvider::instance(), &ToolResourceProvider::geoViewChanged,
           this, &LocationTextController::onGeoViewChanged);
 
-  connect(ToolResourceProvider::instance(), &ToolResourceProvider::locationChanged,
+  // the text is only read by the user, so it does not need every position update
+  auto locationDistributor = new LocationDistributor(s_textUpdateInterval, 0.0, this);
+  locationDistributor->subscribeToDeviceLocation();
+  connect(locationDistributor, &LocationDistributor::locationChanged,
           this, &LocationTextController::onLocationChanged);
 
+  // update the elevation once the tile containing the location has been sampled
+  connect(ElevationSampleCache::instance(), &ElevationSampleCache::tileLoaded, this, [this]()
+  {
+    if (!m_useGpsForElevation && !m_location.isEmpty())
+      updateElevationFromCache();
+  });
+
   ToolManager::instance().addTool(this);
 }
 
@@ -108,7 +125,7 @@ QString LocationTextController::currentElevationText() const
 }
 
 /*!
- \brief Slot for ToolResourceProvider::locationChanged.
+ \brief Slot for the throttled ToolResourceProvider::locationChanged.
 
  Uses the provided \a pt to update the location and elevation text.
  */
@@ -124,16 +141,32 @@ void LocationTextController::onLocationChanged(const Point& pt)
   m_currentLocationText = QString("%1 (%2)").arg(formatCoordinate(pt), m_coordinateFormat);
   emit currentLocationTextChanged();
 
+  m_location = pt;
+
   // update the elevation text
   if (m_useGpsForElevation)
     formatElevationText(pt.z());
   else
-  {
-    if (!m_surface)
-      return;
+    updateElevationFromCache();
+}
 
-    m_surface->locationToElevation(pt);
-  }
+/*!
+ \internal
+
+ Updates the elevation text from the \l ElevationSampleCache. If the elevation of the
+ current location has not been sampled yet, the text is updated once it has been.
+ */
+void LocationTextController::updateElevationFromCache()
+{
+  ElevationSampleCache* cache = ElevationSampleCache::instance();
+  if (!cache->surface())
+    return;
+
+  double elevation = 0.0;
+  if (cache->elevation(m_location, elevation))
+    formatElevationText(elevation);
+
+  cache->prefetch(m_location);
 }
 
 /*!
@@ -143,16 +176,7 @@ void LocationTextController::onGeoViewChanged()
 {
   Scene* scene = ToolResourceProvider::instance()->scene();
   if (scene)
-  {
-    m_surface = scene->baseSurface();
-
-    // connect the Surface::locationToElevationCompleted signal
-    connect(m_surface, &Surface::locationToElevationCompleted, this, [this](QUuid, double elevation)
-    {
-      // format the elevation for display in QML
-      formatElevationText(elevation);
-    });
-  }
+    ElevationSampleCache::instance()->setSurface(scene->baseSurface());
 }
 
 /*!
@@ -178,71 +202,7 @@ void LocationTextController::setCoordinateFormat(const QString& format)
   emit coordinateFormatChanged();
 
   // use std::function to change the lambda that the formatCoordinate member points to
-  // Decimal Degrees
-  const QString currentFormat = coordinateFormat();
-  if (currentFormat == DD)
-  {
-    formatCoordinate = [](const Point& p)
-    {
-      return CoordinateFormatter::toLatitudeLongitude(p, LatitudeLongitudeFormat::DecimalDegrees, 5);
-    };
-  }
-  // Degrees Decimal Minutes
-  else if (currentFormat == DDM)
-  {
-    formatCoordinate = [](const Point& p)
-    {
-      return CoordinateFormatter::toLatitudeLongitude(p, LatitudeLongitudeFormat::DegreesDecimalMinutes, 5);
-    };
-  }
-  // UTM
-  else if (currentFormat == UTM)
-  {
-    formatCoordinate = [](const Point& p)
-    {
-      return CoordinateFormatter::toUtm(p, UtmConversionMode::NorthSouthIndicators, true);
-    };
-  }
-  // MGRS
-  else if (currentFormat == MGRS)
-  {
-    formatCoordinate = [](const Point& p)
-    {
-      return CoordinateFormatter::toMgrs(p, MgrsConversionMode::Automatic, 5, true);
-    };
-  }
-  // USNG
-  else if (currentFormat == USNG)
-  {
-    formatCoordinate = [](const Point& p)
-    {
-      return CoordinateFormatter::toUsng(p, 5, true);
-    };
-  }
-  // GEOREF
-  else if (currentFormat == GeoRef)
-  {
-    formatCoordinate = [](const Point& p)
-    {
-      return CoordinateFormatter::toGeoRef(p, 5);
-    };
-  }
-  // GARS
-  else if (currentFormat == Gars)
-  {
-    formatCoordinate = [](const Point& p)
-    {
-      return CoordinateFormatter::toGars(p);
-    };
-  }
-  // DMS
-  else
-  {
-    formatCoordinate = [](const Point& p)
-    {
-      return CoordinateFormatter::toLatitudeLongitude(p, LatitudeLongitudeFormat::DegreesMinutesSeconds, 3);
-    };
-  }
+  formatCoordinate = CoordinateFormatUtils::formatter(coordinateFormat());
 }
 
 /*!
@@ -20,12 +20,8 @@
 // toolkit headers
 #include "AbstractTool.h"
 
-namespace Esri {
-namespace ArcGISRuntime {
-class Point;
-class Surface;
-}
-}
+// C++ API headers
+#include "Point.h"
 
 namespace Dsa {
 
@@ -66,6 +62,7 @@ private:
   QString currentLocationText() const;
   QString currentElevationText() const;
   void formatElevationText(double elevation);
+  void updateElevationFromCache();
 
   static const QString COORDINATE_FORMAT_PROPERTYNAME;
   static const QString USE_GPS_PROPERTYNAME;
@@ -81,7 +78,7 @@ private:
   static const QString Meters;
   static const QString Feet;
 
-  Esri::ArcGISRuntime::Surface* m_surface = nullptr;
+  Esri::ArcGISRuntime::Point m_location;
   QString m_currentLocationText = "Location Unavailable";
   QString m_currentElevationText = "Elevation Unavailable";
   QString m_coordinateFormat;
@@ -0,0 +1,473 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "MemoryBudget.h"
+
+// dsa app headers
+#include "TraceRecorder.h"
+
+// C++ API headers
+#include "Geometry.h"
+#include "ImmutablePart.h"
+#include "ImmutablePartCollection.h"
+#include "ImmutablePointCollection.h"
+#include "Multipart.h"
+#include "Multipoint.h"
+#include "Polygon.h"
+#include "Polyline.h"
+
+// Qt headers
+#include <QFile>
+#include <QGuiApplication>
+#include <QStringList>
+#include <QTimer>
+#include <QVariantMap>
+
+// STL headers
+#include <algorithm>
+#include <limits>
+#include <memory>
+
+#if defined(Q_OS_WIN)
+#include <Windows.h>
+#include <psapi.h>
+#elif defined(Q_OS_MACOS) || defined(Q_OS_IOS)
+#include <mach/mach.h>
+#if defined(Q_OS_IOS)
+#include <os/proc.h>
+#endif
+#elif defined(Q_OS_LINUX) || defined(Q_OS_ANDROID)
+#include <unistd.h>
+#endif
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+namespace
+{
+constexpr int s_checkInterval = 5000;
+
+// below this much memory available to the app, every cache is emptied
+constexpr qint64 s_lowAvailableMemory = 64 * 1024 * 1024;
+
+// rough costs of geometry held in memory, used for the estimated footprints
+constexpr qint64 s_geometryOverhead = 64;
+constexpr qint64 s_bytesPerPoint = 32;
+
+qint64 meminfoBytes(const QByteArray& meminfo, const QByteArray& field)
+{
+  const int fieldIndex = meminfo.indexOf(field);
+  if (fieldIndex < 0)
+    return -1;
+
+  const int valueIndex = fieldIndex + field.size();
+  const int endIndex = meminfo.indexOf('\n', valueIndex);
+  const QByteArray value = meminfo.mid(valueIndex, endIndex - valueIndex).trimmed();
+
+  // values are in kB, followed by the unit
+  bool ok = false;
+  const qint64 kilobytes = value.left(value.indexOf(' ')).toLongLong(&ok);
+  return ok ? kilobytes * 1024 : -1;
+}
+
+qint64 multipartPointCount(const Multipart& multipart)
+{
+  std::unique_ptr<ImmutablePartCollection> parts(multipart.parts());
+  const int partCount = parts ? parts->size() : 0;
+
+  qint64 count = 0;
+  for (int partIndex = 0; partIndex < partCount; ++partIndex)
+  {
+    std::unique_ptr<ImmutablePart> part(parts->part(partIndex));
+    if (part)
+      count += part->pointCount();
+  }
+
+  return count;
+}
+}
+
+/*!
+  \class Dsa::MemoryBudget
+  \inmodule Dsa
+  \inherits QObject
+  \brief Asks the app's caches to give back memory when memory is short.
+
+  Caches are added with \l registerCache, giving an estimate of their current
+  footprint and a function which releases what they can. When memory is short
+  the caches are asked to shrink in order of their \c ShrinkPriority, so data
+  which is cheapest to get again is released first:
+
+  \list
+    \li \c RedundantCopyPriority - copies of data which is also held elsewhere.
+    \li \c RecomputePriority - data which is recalculated when next needed.
+    \li \c RequeryPriority - data which has to be queried for again.
+  \endlist
+
+  Every cache is emptied, and \l lowMemory is emitted, when:
+
+  \list
+    \li the app is suspended, as a suspended app is the first to be
+        terminated by Android and iOS when the device runs low on memory;
+    \li the memory still available to the app falls below 64 MB;
+    \li \l handleLowMemory is called, for example from a platform's
+        low-memory notification.
+  \endlist
+
+  When a \l budget is set, caches are also shrunk in priority order whenever
+  the resident memory of the app exceeds it, until their estimated footprints
+  account for the excess.
+
+  Memory is checked every five seconds.
+ */
+
+/*!
+  \brief Returns the singleton instance of the budget.
+ */
+MemoryBudget* MemoryBudget::instance()
+{
+  static MemoryBudget s_instance;
+  return &s_instance;
+}
+
+/*!
+  \internal
+ */
+MemoryBudget::MemoryBudget(QObject* parent):
+  QObject(parent),
+  m_checkTimer(new QTimer(this))
+{
+  m_checkTimer->setInterval(s_checkInterval);
+  connect(m_checkTimer, &QTimer::timeout, this, &MemoryBudget::checkMemory);
+  m_checkTimer->start();
+
+  if (qGuiApp)
+  {
+    connect(qGuiApp, &QGuiApplication::applicationStateChanged, this, [this](Qt::ApplicationState state)
+    {
+      if (state == Qt::ApplicationSuspended)
+        handleLowMemory();
+    });
+  }
+}
+
+/*!
+  \brief Destructor.
+ */
+MemoryBudget::~MemoryBudget()
+{
+}
+
+/*!
+  \brief Returns the resident memory of the process in bytes, or -1 if it is not known.
+ */
+qint64 MemoryBudget::residentMemory()
+{
+#if defined(Q_OS_WIN)
+  PROCESS_MEMORY_COUNTERS counters;
+  if (K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    return static_cast<qint64>(counters.WorkingSetSize);
+#elif defined(Q_OS_MACOS) || defined(Q_OS_IOS)
+  mach_task_basic_info info;
+  mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+  if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) == KERN_SUCCESS)
+    return static_cast<qint64>(info.resident_size);
+#elif defined(Q_OS_LINUX) || defined(Q_OS_ANDROID)
+  // the second field is the number of resident pages
+  QFile statm(QStringLiteral("/proc/self/statm"));
+  if (statm.open(QIODevice::ReadOnly))
+  {
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    bool ok = false;
+    const qint64 residentPages = fields.size() > 1 ? fields.at(1).toLongLong(&ok) : 0;
+    if (ok)
+      return residentPages * sysconf(_SC_PAGESIZE);
+  }
+#endif
+
+  return -1;
+}
+
+/*!
+  \brief Returns how many more bytes of memory the app can use before the
+  system runs short, or -1 if it is not known.
+
+  On iOS this is the memory left before the app would be terminated. Elsewhere
+  it is the physical memory available to all processes.
+ */
+qint64 MemoryBudget::availableMemory()
+{
+#if defined(Q_OS_WIN)
+  MEMORYSTATUSEX status;
+  status.dwLength = sizeof(status);
+  if (GlobalMemoryStatusEx(&status))
+    return static_cast<qint64>(status.ullAvailPhys);
+#elif defined(Q_OS_IOS)
+  if (__builtin_available(iOS 13.0, *))
+    return static_cast<qint64>(os_proc_available_memory());
+#elif defined(Q_OS_LINUX) || defined(Q_OS_ANDROID)
+  QFile meminfo(QStringLiteral("/proc/meminfo"));
+  if (meminfo.open(QIODevice::ReadOnly))
+    return meminfoBytes(meminfo.readAll(), QByteArrayLiteral("MemAvailable:"));
+#endif
+
+  return -1;
+}
+
+/*!
+  \brief Returns a rough estimate of the bytes used to hold \a geometry.
+
+  The estimate is proportional to the number of vertices in the geometry.
+ */
+qint64 MemoryBudget::estimatedSize(const Geometry& geometry)
+{
+  if (geometry.isEmpty())
+    return s_geometryOverhead;
+
+  qint64 pointCount = 1;
+  switch (geometry.geometryType())
+  {
+  case GeometryType::Polygon:
+    pointCount = multipartPointCount(geometry_cast<Polygon>(geometry));
+    break;
+  case GeometryType::Polyline:
+    pointCount = multipartPointCount(geometry_cast<Polyline>(geometry));
+    break;
+  case GeometryType::Multipoint:
+  {
+    std::unique_ptr<ImmutablePointCollection> points(geometry_cast<Multipoint>(geometry).points());
+    pointCount = points ? points->size() : 0;
+    break;
+  }
+  case GeometryType::Envelope:
+    pointCount = 2;
+    break;
+  default:
+    break;
+  }
+
+  return s_geometryOverhead + pointCount * s_bytesPerPoint;
+}
+
+/*!
+  \brief Registers the cache \a name owned by \a owner.
+
+  \a footprint returns the estimated number of bytes the cache holds. \a shrink
+  releases everything the cache can do without, returning the estimated number
+  of bytes released. Caches with a lower \a priority are shrunk first.
+
+  Several caches can share a \a name, in which case their footprints are
+  reported together. The cache is unregistered when \a owner is destroyed.
+ */
+void MemoryBudget::registerCache(QObject* owner, const QString& name, int priority,
+                                 FootprintFunction footprint, ShrinkFunction shrink)
+{
+  if (!owner || !footprint || !shrink)
+    return;
+
+  unregisterCache(owner);
+
+  Cache cache;
+  cache.m_owner = owner;
+  cache.m_name = name;
+  cache.m_priority = priority;
+  cache.m_footprint = std::move(footprint);
+  cache.m_shrink = std::move(shrink);
+
+  // keep the caches in shrink order, latest registered last within a priority
+  auto insertIt = std::upper_bound(m_caches.begin(), m_caches.end(), priority, [](int value, const Cache& other)
+  {
+    return value < other.m_priority;
+  });
+  cache.m_destroyedConnection = connect(owner, &QObject::destroyed, this, [this, owner]()
+  {
+    unregisterCache(owner);
+  });
+
+  m_caches.insert(insertIt, cache);
+}
+
+/*!
+  \brief Unregisters the cache owned by \a owner.
+ */
+void MemoryBudget::unregisterCache(QObject* owner)
+{
+  for (auto it = m_caches.begin(); it != m_caches.end(); ++it)
+  {
+    if (it->m_owner != owner)
+      continue;
+
+    disconnect(it->m_destroyedConnection);
+    m_caches.erase(it);
+    return;
+  }
+}
+
+/*!
+  \brief Returns the resident memory, in bytes, above which caches are shrunk.
+
+  \c 0 means there is no budget.
+ */
+qint64 MemoryBudget::budget() const
+{
+  return m_budget;
+}
+
+/*!
+  \brief Sets the resident memory, in bytes, above which caches are shrunk to \a budget.
+ */
+void MemoryBudget::setBudget(qint64 budget)
+{
+  m_budget = std::max(budget, static_cast<qint64>(0));
+}
+
+/*!
+  \brief Returns the estimated number of bytes held by all of the registered caches.
+ */
+qint64 MemoryBudget::footprint() const
+{
+  qint64 total = 0;
+  for (const Cache& cache : m_caches)
+    total += cache.m_footprint();
+
+  return total;
+}
+
+/*!
+  \brief Returns the estimated footprint of each named cache, in shrink order.
+
+  Each entry is a map with a \c name and the number of \c megabytes it holds.
+ */
+QVariantList MemoryBudget::footprints() const
+{
+  QStringList names;
+  QList<qint64> bytes;
+  for (const Cache& cache : m_caches)
+  {
+    int index = names.indexOf(cache.m_name);
+    if (index < 0)
+    {
+      index = names.size();
+      names.append(cache.m_name);
+      bytes.append(0);
+    }
+
+    bytes[index] += cache.m_footprint();
+  }
+
+  QVariantList footprints;
+  footprints.reserve(names.size());
+  for (int i = 0; i < names.size(); ++i)
+  {
+    QVariantMap footprint;
+    footprint.insert(QStringLiteral("name"), names.at(i));
+    footprint.insert(QStringLiteral("megabytes"), bytes.at(i) / (1024.0 * 1024.0));
+    footprints.append(footprint);
+  }
+
+  return footprints;
+}
+
+/*!
+  \brief Shrinks caches, in priority order, until at least \a bytes are released.
+
+  Returns the estimated number of bytes released.
+ */
+qint64 MemoryBudget::reduce(qint64 bytes)
+{
+  DSA_TRACE_SCOPE("MemoryBudget::reduce");
+
+  // a cache may unregister other caches as it shrinks
+  QList<QObject*> owners;
+  owners.reserve(m_caches.size());
+  for (const Cache& cache : m_caches)
+    owners.append(cache.m_owner);
+
+  qint64 released = 0;
+  for (QObject* owner : owners)
+  {
+    if (released >= bytes)
+      break;
+
+    auto cacheIt = std::find_if(m_caches.cbegin(), m_caches.cend(), [owner](const Cache& cache)
+    {
+      return cache.m_owner == owner;
+    });
+
+    if (cacheIt != m_caches.cend())
+    {
+      // copy the function, as shrinking may register caches
+      const ShrinkFunction shrink = cacheIt->m_shrink;
+      released += shrink();
+    }
+  }
+
+  return released;
+}
+
+/*!
+  \brief Empties every cache and emits \l lowMemory.
+ */
+void MemoryBudget::handleLowMemory()
+{
+  reduce(std::numeric_limits<qint64>::max());
+  emit lowMemory();
+}
+
+/*!
+  \internal
+
+  Handles low available memory once each time it falls below the threshold,
+  and otherwise keeps the resident memory within the budget.
+ */
+void MemoryBudget::checkMemory()
+{
+  const qint64 available = availableMemory();
+  const bool lowMemory = available >= 0 && available < s_lowAvailableMemory;
+  if (lowMemory != m_lowMemory)
+  {
+    m_lowMemory = lowMemory;
+    if (m_lowMemory)
+    {
+      handleLowMemory();
+      return;
+    }
+  }
+
+  if (m_budget == 0)
+    return;
+
+  const qint64 resident = residentMemory();
+  if (resident > m_budget)
+    reduce(resident - m_budget);
+}
+
+} // Dsa
+
+// Signal Documentation
+
+/*!
+  \fn void MemoryBudget::lowMemory();
+
+  \brief Signal emitted when memory is short and every cache has been emptied.
+
+  Objects which are not registered caches, such as QML panels which are not
+  shown, can respond by releasing what they can.
+ */
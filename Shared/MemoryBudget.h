@@ -0,0 +1,106 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef MEMORYBUDGET_H
+#define MEMORYBUDGET_H
+
+// Qt headers
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QVariantList>
+
+// STL headers
+#include <functional>
+
+namespace Esri {
+namespace ArcGISRuntime {
+class Geometry;
+}
+}
+
+class QTimer;
+
+namespace Dsa {
+
+class MemoryBudget : public QObject
+{
+  Q_OBJECT
+
+public:
+  // the order in which caches are asked to shrink, cheapest to rebuild first
+  enum ShrinkPriority
+  {
+    RedundantCopyPriority = 0,
+    RecomputePriority = 10,
+    RequeryPriority = 20
+  };
+
+  // both return a number of bytes; the shrink function returns how many it released
+  using FootprintFunction = std::function<qint64()>;
+  using ShrinkFunction = std::function<qint64()>;
+
+  static MemoryBudget* instance();
+
+  ~MemoryBudget();
+
+  static qint64 residentMemory();
+  static qint64 availableMemory();
+  static qint64 estimatedSize(const Esri::ArcGISRuntime::Geometry& geometry);
+
+  void registerCache(QObject* owner, const QString& name, int priority,
+                     FootprintFunction footprint, ShrinkFunction shrink);
+  void unregisterCache(QObject* owner);
+
+  qint64 budget() const;
+  void setBudget(qint64 budget);
+
+  qint64 footprint() const;
+  QVariantList footprints() const;
+
+  qint64 reduce(qint64 bytes);
+
+public slots:
+  void handleLowMemory();
+
+signals:
+  void lowMemory();
+
+private:
+  explicit MemoryBudget(QObject* parent = nullptr);
+  Q_DISABLE_COPY(MemoryBudget)
+
+  void checkMemory();
+
+  struct Cache
+  {
+    QObject* m_owner = nullptr;
+    QString m_name;
+    int m_priority = 0;
+    FootprintFunction m_footprint;
+    ShrinkFunction m_shrink;
+    QMetaObject::Connection m_destroyedConnection;
+  };
+
+  QList<Cache> m_caches;
+  QTimer* m_checkTimer = nullptr;
+  qint64 m_budget = 0;
+  bool m_lowMemory = false;
+};
+
+} // Dsa
+
+#endif // MEMORYBUDGET_H
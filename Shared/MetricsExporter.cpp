@@ -0,0 +1,529 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+
+// PCH header
+#include "pch.hpp"
+
+#include "MetricsExporter.h"
+
+// dsa app headers
+#include "AlertEvaluationScheduler.h"
+#include "AlertEvaluationStats.h"
+#include "MemoryBudget.h"
+#include "MessageFeedStats.h"
+#include "MessageFeedsController.h"
+#include "OutboundTransport.h"
+#include "PerformanceMonitor.h"
+
+// toolkit headers
+#include "ToolManager.h"
+
+// Qt headers
+#include <QDateTime>
+#include <QHostInfo>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QUdpSocket>
+#include <QtEndian>
+
+// STL headers
+#include <cstring>
+
+namespace Dsa {
+
+namespace {
+
+// "DSAM", version, node name, sequence, timestamp and the metric count, big endian
+constexpr char s_magic[] = {'D', 'S', 'A', 'M'};
+constexpr quint8 s_version = 1;
+
+// the metrics are split across datagrams of at most this size, to fit the link MTU
+constexpr int s_maximumDatagramSize = 1200;
+
+constexpr int s_defaultInterval = 10;
+
+// a client of the text endpoint which sends no request, such as netcat, is answered after this long, in ms
+constexpr int s_requestTimeout = 200;
+
+constexpr double s_bytesPerMegabyte = 1024.0 * 1024.0;
+
+QString metricName(const QString& name)
+{
+  QString metric = name.toLower();
+  for (QChar& c : metric)
+  {
+    if (!c.isLetterOrNumber())
+      c = QLatin1Char('_');
+  }
+
+  return metric;
+}
+
+void appendHistogram(QVector<MetricsExporter::Metric>& metrics, const QString& prefix,
+                     const QVariantList& bounds, const QVariantList& counts)
+{
+  for (int i = 0; i < counts.size(); ++i)
+  {
+    const QString bound = i < bounds.size() ? metricName(bounds.at(i).toString()) : QStringLiteral("inf");
+    metrics.append({QString("%1_le_%2").arg(prefix, bound), counts.at(i).toDouble()});
+  }
+}
+
+} // namespace
+
+const QString MetricsExporter::COLLECTOR_KEY = QStringLiteral("collector");
+const QString MetricsExporter::INTERVAL_KEY = QStringLiteral("interval");
+const QString MetricsExporter::LOCAL_PORT_KEY = QStringLiteral("localPort");
+
+/*!
+  \class Dsa::MetricsExporter
+  \inmodule Dsa
+  \inherits QObject
+  \brief Publishes the performance metrics of the app, so that the nodes of a fleet
+  can be monitored from one place and overloaded nodes spotted early.
+
+  The \l metrics gather the frame times of the \l PerformanceMonitor, the ingest
+  rates, counts and latency histogram of the \l MessageFeedsController, the
+  evaluation rate, latency, backlog and frame budget usage of the
+  \l AlertEvaluationScheduler, the resident memory, the footprint of each cache of
+  the \l MemoryBudget and the heap of each subsystem where allocations are counted,
+  and the sends of the \l OutboundTransport.
+
+  Every \l interval seconds the metrics are sent to the UDP \l collector as compact
+  datagrams: the magic bytes \c DSAM, a version byte, the node name as a length byte
+  and UTF-8, a 32 bit sequence number, the time in milliseconds since the epoch as
+  64 bits, and a 16 bit count of the metrics which follow, each a length byte and
+  the UTF-8 name followed by its value as a 32 bit float. All numbers are big
+  endian. Metrics which do not fit in one datagram are sent in further datagrams
+  with the same header and sequence number.
+
+  For use on the bench, the metrics can also be read as text from \l localPort on
+  the loopback interface, as one \c {dsa_<name> <value>} line per metric. An HTTP
+  \c GET is answered with an HTTP response, so the endpoint can be scraped.
+
+  While exporting, the \l PerformanceMonitor samples in the background.
+ */
+
+/*!
+  \brief Returns the singleton instance of the exporter.
+ */
+MetricsExporter* MetricsExporter::instance()
+{
+  static MetricsExporter s_instance;
+  return &s_instance;
+}
+
+/*!
+  \internal
+ */
+MetricsExporter::MetricsExporter(QObject* parent) :
+  QObject(parent),
+  m_nodeName(QHostInfo::localHostName()),
+  m_publishTimer(new QTimer(this))
+{
+  m_publishTimer->setInterval(s_defaultInterval * 1000);
+  connect(m_publishTimer, &QTimer::timeout, this, &MetricsExporter::publish);
+}
+
+/*!
+  \brief Destructor.
+ */
+MetricsExporter::~MetricsExporter()
+{
+  if (m_lookupId >= 0)
+    QHostInfo::abortHostLookup(m_lookupId);
+}
+
+/*!
+  \brief Configures the exporter from \a exportConfig, with the optional keys
+  \c collector (\c host:port), \c interval (seconds) and \c localPort.
+ */
+void MetricsExporter::setProperties(const QVariantMap& exportConfig)
+{
+  if (exportConfig.contains(INTERVAL_KEY))
+    setInterval(exportConfig.value(INTERVAL_KEY).toInt());
+
+  setCollector(exportConfig.value(COLLECTOR_KEY).toString());
+  setLocalPort(exportConfig.value(LOCAL_PORT_KEY).toUInt());
+}
+
+/*!
+  \brief Returns the name identifying this node in the datagrams.
+
+  The default is the host name.
+ */
+QString MetricsExporter::nodeName() const
+{
+  return m_nodeName;
+}
+
+/*!
+  \brief Sets the name identifying this node in the datagrams to \a nodeName.
+ */
+void MetricsExporter::setNodeName(const QString& nodeName)
+{
+  m_nodeName = nodeName;
+}
+
+/*!
+  \brief Returns the \c host:port the metrics are sent to, or an empty string if
+  they are not sent.
+ */
+QString MetricsExporter::collector() const
+{
+  return m_collector;
+}
+
+/*!
+  \brief Sets the \c host:port the metrics are sent to to \a collector.
+
+  A host name is looked up before the first metrics are sent. An empty string stops
+  sending. Returns \c false if \a collector is not valid.
+ */
+bool MetricsExporter::setCollector(const QString& collector)
+{
+  if (m_collector == collector)
+    return true;
+
+  if (m_lookupId >= 0)
+  {
+    QHostInfo::abortHostLookup(m_lookupId);
+    m_lookupId = -1;
+  }
+
+  m_collector.clear();
+  m_collectorAddress.clear();
+  m_collectorPort = 0;
+
+  if (!collector.isEmpty())
+  {
+    const int separator = collector.lastIndexOf(QLatin1Char(':'));
+    bool portOk = false;
+    const QString host = collector.left(separator);
+    const quint16 port = collector.mid(separator + 1).toUShort(&portOk);
+    if (separator <= 0 || !portOk || port == 0)
+    {
+      updateExporting();
+      return false;
+    }
+
+    m_collector = collector;
+    m_collectorPort = port;
+
+    if (!m_collectorAddress.setAddress(host))
+    {
+      m_lookupId = QHostInfo::lookupHost(host, this, [this](const QHostInfo& hostInfo)
+      {
+        m_lookupId = -1;
+        if (!hostInfo.addresses().isEmpty())
+          m_collectorAddress = hostInfo.addresses().constFirst();
+      });
+    }
+  }
+
+  updateExporting();
+  return true;
+}
+
+/*!
+  \brief Returns the seconds between the metrics being sent to the \l collector.
+ */
+int MetricsExporter::interval() const
+{
+  return m_publishTimer->interval() / 1000;
+}
+
+/*!
+  \brief Sets the seconds between the metrics being sent to the \l collector to \a interval.
+
+  The default is 10.
+ */
+void MetricsExporter::setInterval(int interval)
+{
+  if (interval <= 0)
+    return;
+
+  m_publishTimer->setInterval(interval * 1000);
+}
+
+/*!
+  \brief Returns the port of the local text endpoint, or \c 0 if it is not listening.
+ */
+quint16 MetricsExporter::localPort() const
+{
+  return m_server ? m_server->serverPort() : 0;
+}
+
+/*!
+  \brief Listens for readers of the text endpoint on the loopback \a localPort,
+  or stops listening if \a localPort is \c 0.
+
+  Returns \c false if the port could not be bound.
+ */
+bool MetricsExporter::setLocalPort(quint16 localPort)
+{
+  if (localPort == this->localPort())
+    return true;
+
+  delete m_server;
+  m_server = nullptr;
+
+  bool listening = true;
+  if (localPort != 0)
+  {
+    m_server = new QTcpServer(this);
+    connect(m_server, &QTcpServer::newConnection, this, &MetricsExporter::handleConnection);
+    if (!m_server->listen(QHostAddress::LocalHost, localPort))
+    {
+      delete m_server;
+      m_server = nullptr;
+      listening = false;
+    }
+  }
+
+  updateExporting();
+  return listening;
+}
+
+/*!
+  \brief Returns whether the metrics are being sent to a collector or served locally.
+ */
+bool MetricsExporter::isExporting() const
+{
+  return m_collectorPort != 0 || m_server;
+}
+
+/*!
+  \brief Returns the current metrics.
+
+  Rates, frame times and memory are those of the last sample of the
+  \l PerformanceMonitor and the statistics it reads; counts are since startup.
+ */
+QVector<MetricsExporter::Metric> MetricsExporter::metrics() const
+{
+  QVector<Metric> metrics;
+
+  const PerformanceMonitor* performanceMonitor = PerformanceMonitor::instance();
+  metrics.append({QStringLiteral("frame_fps"), performanceMonitor->framesPerSecond()});
+  metrics.append({QStringLiteral("frame_time_ms"), performanceMonitor->frameTime()});
+  metrics.append({QStringLiteral("frame_time_max_ms"), performanceMonitor->maximumFrameTime()});
+  metrics.append({QStringLiteral("quadtree_rebuilds_per_s"), performanceMonitor->quadtreeRebuildsPerSecond()});
+
+  MessageFeedsController* messageFeeds = ToolManager::instance().tool<MessageFeedsController>();
+  const MessageFeedStats* ingestStats = messageFeeds ? qobject_cast<MessageFeedStats*>(messageFeeds->ingestStats()) : nullptr;
+  if (ingestStats)
+  {
+    metrics.append({QStringLiteral("ingest_messages_per_s"), ingestStats->messagesPerSecond()});
+    metrics.append({QStringLiteral("ingest_received"), static_cast<double>(ingestStats->receivedCount())});
+    metrics.append({QStringLiteral("ingest_dropped"), static_cast<double>(ingestStats->droppedCount())});
+    metrics.append({QStringLiteral("ingest_socket_dropped"), static_cast<double>(ingestStats->socketDroppedCount())});
+    metrics.append({QStringLiteral("ingest_decode_failures"), static_cast<double>(ingestStats->decodeFailureCount())});
+    metrics.append({QStringLiteral("ingest_rejected"), static_cast<double>(ingestStats->rejectedCount())});
+    metrics.append({QStringLiteral("ingest_latency_ms"), ingestStats->averageLatency()});
+    metrics.append({QStringLiteral("ingest_latency_max_ms"), ingestStats->maximumLatency()});
+    appendHistogram(metrics, QStringLiteral("ingest_latency_ms"),
+                    MessageFeedStats::latencyHistogramBuckets(), ingestStats->latencyHistogram());
+  }
+
+  const AlertEvaluationScheduler* scheduler = AlertEvaluationScheduler::instance();
+  const AlertEvaluationStats* alertStats = scheduler->stats();
+  metrics.append({QStringLiteral("alerts_evaluations_per_s"), alertStats->evaluationsPerSecond()});
+  metrics.append({QStringLiteral("alerts_backlog"), static_cast<double>(scheduler->backlogCount())});
+  metrics.append({QStringLiteral("alerts_budget_usage"), alertStats->budgetUsage()});
+  metrics.append({QStringLiteral("alerts_over_budget"), static_cast<double>(alertStats->overBudgetCount())});
+  metrics.append({QStringLiteral("alerts_latency_ms"), alertStats->averageLatency()});
+  metrics.append({QStringLiteral("alerts_latency_p95_ms"), alertStats->latencyPercentile(95.0)});
+  metrics.append({QStringLiteral("alerts_latency_max_ms"), alertStats->maximumLatency()});
+  appendHistogram(metrics, QStringLiteral("alerts_latency_ms"),
+                  AlertEvaluationStats::latencyHistogramBuckets(), alertStats->latencyHistogram());
+
+  const qint64 residentMemory = MemoryBudget::residentMemory();
+  if (residentMemory >= 0)
+    metrics.append({QStringLiteral("memory_resident_mb"), residentMemory / s_bytesPerMegabyte});
+
+  const QVariantList footprints = MemoryBudget::instance()->footprints();
+  for (const QVariant& footprint : footprints)
+  {
+    const QVariantMap footprintMap = footprint.toMap();
+    metrics.append({QString("memory_cache_%1_mb").arg(metricName(footprintMap.value(QStringLiteral("name")).toString())),
+                    footprintMap.value(QStringLiteral("megabytes")).toDouble()});
+  }
+
+  const QVariantList allocationStats = performanceMonitor->allocationStats();
+  for (const QVariant& subsystemStats : allocationStats)
+  {
+    const QVariantMap subsystemMap = subsystemStats.toMap();
+    const double liveMegabytes = subsystemMap.value(QStringLiteral("liveMegabytes")).toDouble();
+    if (liveMegabytes >= 0.0)
+      metrics.append({QString("memory_heap_%1_mb").arg(metricName(subsystemMap.value(QStringLiteral("name")).toString())), liveMegabytes});
+  }
+
+  const OutboundTransport* outboundTransport = OutboundTransport::instance();
+  metrics.append({QStringLiteral("outbound_sent"), static_cast<double>(outboundTransport->sentCount())});
+  metrics.append({QStringLiteral("outbound_failed"), static_cast<double>(outboundTransport->failedCount())});
+  metrics.append({QStringLiteral("outbound_coalesced"), static_cast<double>(outboundTransport->coalescedCount())});
+
+  return metrics;
+}
+
+/*!
+  \brief Returns the current metrics as text, one \c {dsa_<name> <value>} line each.
+ */
+QString MetricsExporter::metricsText() const
+{
+  QString text = QString("# dsa metrics of %1 at %2\n").arg(m_nodeName, QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+  const QVector<Metric> currentMetrics = metrics();
+  for (const Metric& metric : currentMetrics)
+    text += QString("dsa_%1 %2\n").arg(metric.m_name, QString::number(metric.m_value, 'g', 10));
+
+  return text;
+}
+
+/*!
+  \brief Returns the datagrams carrying \a metrics to the \l collector.
+ */
+QVector<QByteArray> MetricsExporter::encodeDatagrams(const QVector<Metric>& metrics) const
+{
+  const QByteArray nodeName = m_nodeName.toUtf8().left(255);
+  const int headerSize = 4 + 1 + 1 + nodeName.size() + 4 + 8 + 2;
+  const qint64 timestamp = QDateTime::currentMSecsSinceEpoch();
+
+  QVector<QByteArray> datagrams;
+  int index = 0;
+  while (index < metrics.size())
+  {
+    QByteArray datagram(headerSize, Qt::Uninitialized);
+    char* data = datagram.data();
+    memcpy(data, s_magic, sizeof(s_magic));
+    data[4] = static_cast<char>(s_version);
+    data[5] = static_cast<char>(nodeName.size());
+    memcpy(data + 6, nodeName.constData(), static_cast<size_t>(nodeName.size()));
+    qToBigEndian<quint32>(m_sequence, data + 6 + nodeName.size());
+    qToBigEndian<qint64>(timestamp, data + 10 + nodeName.size());
+
+    quint16 count = 0;
+    while (index < metrics.size())
+    {
+      const QByteArray name = metrics.at(index).m_name.toUtf8().left(255);
+      const int metricSize = 1 + name.size() + 4;
+      if (count > 0 && datagram.size() + metricSize > s_maximumDatagramSize)
+        break;
+
+      const float floatValue = static_cast<float>(metrics.at(index).m_value);
+      quint32 bits = 0;
+      memcpy(&bits, &floatValue, sizeof(bits));
+      char value[4];
+      qToBigEndian<quint32>(bits, value);
+      datagram.append(static_cast<char>(name.size()));
+      datagram.append(name);
+      datagram.append(value, sizeof(value));
+      ++count;
+      ++index;
+    }
+
+    qToBigEndian<quint16>(count, datagram.data() + headerSize - 2);
+    datagrams.append(datagram);
+  }
+
+  return datagrams;
+}
+
+/*!
+  \internal
+  \brief Starts or stops publishing, and the background sampling of the
+  \l PerformanceMonitor, as the collector and the local endpoint are set.
+ */
+void MetricsExporter::updateExporting()
+{
+  PerformanceMonitor::instance()->setBackgroundSampling(isExporting());
+
+  if (m_collectorPort == 0)
+  {
+    m_publishTimer->stop();
+    delete m_socket;
+    m_socket = nullptr;
+    return;
+  }
+
+  if (!m_socket)
+    m_socket = new QUdpSocket(this);
+
+  if (!m_publishTimer->isActive())
+    m_publishTimer->start();
+}
+
+/*!
+  \internal
+  \brief Sends the current metrics to the collector, once its address is known.
+ */
+void MetricsExporter::publish()
+{
+  if (!m_socket || m_collectorAddress.isNull())
+    return;
+
+  const QVector<QByteArray> datagrams = encodeDatagrams(metrics());
+  for (const QByteArray& datagram : datagrams)
+    m_socket->writeDatagram(datagram, m_collectorAddress, m_collectorPort);
+
+  ++m_sequence;
+}
+
+/*!
+  \internal
+ */
+void MetricsExporter::handleConnection()
+{
+  while (m_server && m_server->hasPendingConnections())
+  {
+    QTcpSocket* socket = m_server->nextPendingConnection();
+    connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+    connect(socket, &QTcpSocket::readyRead, this, [this, socket]()
+    {
+      respond(socket);
+    });
+
+    QTimer::singleShot(s_requestTimeout, socket, [this, socket]()
+    {
+      respond(socket);
+    });
+  }
+}
+
+/*!
+  \internal
+  \brief Writes the metrics text to \a socket, as an HTTP response if it sent a
+  \c GET request, and closes it.
+ */
+void MetricsExporter::respond(QTcpSocket* socket)
+{
+  // answered once, whichever of the request and the timeout comes first
+  if (socket->state() != QAbstractSocket::ConnectedState)
+    return;
+
+  const QByteArray body = metricsText().toUtf8();
+  if (socket->peek(3) == "GET")
+  {
+    socket->write(QByteArray("HTTP/1.0 200 OK\r\nContent-Type: text/plain; charset=utf-8\r\nContent-Length: ") +
+                  QByteArray::number(body.size()) + "\r\nConnection: close\r\n\r\n");
+  }
+
+  socket->write(body);
+  socket->disconnectFromHost();
+}
+
+} // Dsa
@@ -0,0 +1,98 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+
+#ifndef METRICSEXPORTER_H
+#define METRICSEXPORTER_H
+
+// Qt headers
+#include <QByteArray>
+#include <QHostAddress>
+#include <QObject>
+#include <QString>
+#include <QVariantMap>
+#include <QVector>
+
+class QTcpServer;
+class QTcpSocket;
+class QTimer;
+class QUdpSocket;
+
+namespace Dsa {
+
+class MetricsExporter : public QObject
+{
+  Q_OBJECT
+
+public:
+  struct Metric
+  {
+    QString m_name;
+    double m_value = 0.0;
+  };
+
+  static MetricsExporter* instance();
+
+  ~MetricsExporter();
+
+  void setProperties(const QVariantMap& exportConfig);
+
+  QString nodeName() const;
+  void setNodeName(const QString& nodeName);
+
+  QString collector() const;
+  bool setCollector(const QString& collector);
+
+  int interval() const;
+  void setInterval(int interval);
+
+  quint16 localPort() const;
+  bool setLocalPort(quint16 localPort);
+
+  bool isExporting() const;
+
+  QVector<Metric> metrics() const;
+  QString metricsText() const;
+  QVector<QByteArray> encodeDatagrams(const QVector<Metric>& metrics) const;
+
+  static const QString COLLECTOR_KEY;
+  static const QString INTERVAL_KEY;
+  static const QString LOCAL_PORT_KEY;
+
+private:
+  explicit MetricsExporter(QObject* parent = nullptr);
+  Q_DISABLE_COPY(MetricsExporter)
+
+  void updateExporting();
+  void publish();
+  void handleConnection();
+  void respond(QTcpSocket* socket);
+
+  QString m_nodeName;
+  QString m_collector;
+  QHostAddress m_collectorAddress;
+  quint16 m_collectorPort = 0;
+  int m_lookupId = -1;
+  quint32 m_sequence = 0;
+
+  QTimer* m_publishTimer = nullptr;
+  QUdpSocket* m_socket = nullptr;
+  QTcpServer* m_server = nullptr;
+};
+
+} // Dsa
+
+#endif // METRICSEXPORTER_H
@@ -0,0 +1,235 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "MultiPointHighlighter.h"
+
+// dsa app headers
+#include "FrameAnimationDriver.h"
+
+// toolkit headers
+#include "ToolResourceProvider.h"
+
+// C++ API headers
+#include "GeometryEngine.h"
+#include "GeoView.h"
+#include "Graphic.h"
+#include "GraphicListModel.h"
+#include "GraphicsOverlay.h"
+#include "MultipointBuilder.h"
+#include "PointCollection.h"
+#include "SimpleLineSymbol.h"
+#include "SimpleMarkerSymbol.h"
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+/*!
+  \class Dsa::MultiPointHighlighter
+  \inmodule Dsa
+  \inherits QObject
+  \brief Manager for a highlight drawn at many points at once.
+
+  All of the points are drawn by a single multipoint graphic in an overlay of its
+  own, so showing or hiding the highlight is a single change to the overlay however
+  many points there are. Points are keyed by the object they belong to, such as an
+  alert, and changes to them are written to the graphic in one batch on the next
+  frame drawn by the view.
+
+  \sa PointHighlighter
+ */
+
+/*!
+  \brief Constructor taking an optional \a parent.
+ */
+MultiPointHighlighter::MultiPointHighlighter(QObject* parent):
+  QObject(parent)
+{
+  connect(ToolResourceProvider::instance(), &ToolResourceProvider::geoViewChanged,
+          this, &MultiPointHighlighter::onGeoViewChanged);
+
+  onGeoViewChanged();
+}
+
+/*!
+  \brief Destructor.
+ */
+MultiPointHighlighter::~MultiPointHighlighter()
+{
+}
+
+/*!
+  \brief Sets the highlighted \a point for \a key, adding it if needed.
+ */
+void MultiPointHighlighter::setPoint(QObject* key, const Point& point)
+{
+  if (!key)
+    return;
+
+  if (point.isEmpty())
+  {
+    removePoint(key);
+    return;
+  }
+
+  m_points.insert(key, point);
+  requestUpdate();
+}
+
+/*!
+  \brief Removes the highlighted point for \a key.
+ */
+void MultiPointHighlighter::removePoint(QObject* key)
+{
+  if (m_points.remove(key) > 0)
+    requestUpdate();
+}
+
+/*!
+  \brief Removes all of the highlighted points.
+ */
+void MultiPointHighlighter::clear()
+{
+  if (m_points.isEmpty())
+    return;
+
+  m_points.clear();
+  requestUpdate();
+}
+
+/*!
+  \brief Returns whether there is a highlighted point for \a key.
+ */
+bool MultiPointHighlighter::contains(QObject* key) const
+{
+  return m_points.contains(key);
+}
+
+/*!
+  \brief Returns the number of highlighted points.
+ */
+int MultiPointHighlighter::count() const
+{
+  return m_points.size();
+}
+
+/*!
+  \brief Returns whether the highlight is shown.
+ */
+bool MultiPointHighlighter::isVisible() const
+{
+  return m_visible;
+}
+
+/*!
+  \brief Sets whether the highlight is shown to \a visible.
+ */
+void MultiPointHighlighter::setVisible(bool visible)
+{
+  if (m_visible == visible)
+    return;
+
+  m_visible = visible;
+
+  if (m_highlightOverlay)
+    m_highlightOverlay->setVisible(m_visible);
+}
+
+/*!
+  \internal
+
+  Writes the points to the graphic on the next frame, once however often they change before it.
+ */
+void MultiPointHighlighter::requestUpdate()
+{
+  FrameAnimationDriver* driver = FrameAnimationDriver::instance();
+  if (driver->hasAnimation(this))
+    return;
+
+  driver->addAnimation(this, [this](qint64)
+  {
+    updateGraphic();
+    return false;
+  }, FrameAnimationDriver::FrameRate::Full);
+}
+
+/*!
+  \internal
+ */
+void MultiPointHighlighter::updateGraphic()
+{
+  if (!m_highlightGraphic)
+    return;
+
+  MultipointBuilder builder(SpatialReference::wgs84());
+  PointCollection* points = builder.points();
+  for (auto it = m_points.cbegin(); it != m_points.cend(); ++it)
+  {
+    const Point& point = it.value();
+    const SpatialReference spatialReference = point.spatialReference();
+    if (spatialReference.isEmpty() || spatialReference == SpatialReference::wgs84())
+      points->addPoint(point);
+    else
+      points->addPoint(geometry_cast<Point>(GeometryEngine::project(point, SpatialReference::wgs84())));
+  }
+
+  m_highlightGraphic->setGeometry(builder.toGeometry());
+}
+
+/*!
+  \brief Handle changes to the geoView for highlighting.
+ */
+void MultiPointHighlighter::onGeoViewChanged()
+{
+  FrameAnimationDriver::instance()->removeAnimation(this);
+
+  if (m_highlightOverlay)
+  {
+    delete m_highlightOverlay;
+    m_highlightOverlay = nullptr;
+    m_highlightGraphic = nullptr;
+  }
+
+  if (m_highlightSymbol)
+  {
+    delete m_highlightSymbol;
+    m_highlightSymbol = nullptr;
+  }
+
+  GeoView* geoview = ToolResourceProvider::instance()->geoView();
+  if (!geoview)
+    return;
+
+  if (!geoview->graphicsOverlays())
+    return;
+
+  m_highlightOverlay = new GraphicsOverlay(this);
+  m_highlightOverlay->setVisible(m_visible);
+  geoview->graphicsOverlays()->append(m_highlightOverlay);
+
+  m_highlightSymbol = new SimpleMarkerSymbol(SimpleMarkerSymbolStyle::Circle, Qt::transparent, 32.0f, this);
+  m_highlightSymbol->setOutline(new SimpleLineSymbol(SimpleLineSymbolStyle::Solid, Qt::red, 4.0f, m_highlightSymbol));
+
+  m_highlightGraphic = new Graphic(Geometry(), m_highlightSymbol, m_highlightOverlay);
+  m_highlightOverlay->graphics()->append(m_highlightGraphic);
+
+  requestUpdate();
+}
+
+} // Dsa
@@ -0,0 +1,71 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef MULTIPOINTHIGHLIGHTER_H
+#define MULTIPOINTHIGHLIGHTER_H
+
+// C++ API headers
+#include "Point.h"
+
+// Qt headers
+#include <QHash>
+#include <QObject>
+
+namespace Esri {
+namespace ArcGISRuntime {
+class Graphic;
+class GraphicsOverlay;
+class SimpleMarkerSymbol;
+}
+}
+
+namespace Dsa {
+
+class MultiPointHighlighter : public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit MultiPointHighlighter(QObject* parent = nullptr);
+  ~MultiPointHighlighter();
+
+  void setPoint(QObject* key, const Esri::ArcGISRuntime::Point& point);
+  void removePoint(QObject* key);
+  void clear();
+
+  bool contains(QObject* key) const;
+  int count() const;
+
+  bool isVisible() const;
+  void setVisible(bool visible);
+
+private slots:
+  void onGeoViewChanged();
+
+private:
+  void requestUpdate();
+  void updateGraphic();
+
+  Esri::ArcGISRuntime::GraphicsOverlay* m_highlightOverlay = nullptr;
+  Esri::ArcGISRuntime::SimpleMarkerSymbol* m_highlightSymbol = nullptr;
+  Esri::ArcGISRuntime::Graphic* m_highlightGraphic = nullptr;
+  QHash<QObject*, Esri::ArcGISRuntime::Point> m_points;
+  bool m_visible = false;
+};
+
+} // Dsa
+
+#endif // MULTIPOINTHIGHLIGHTER_H
@@ -35,6 +35,7 @@
 #include "OrbitGeoElementCameraController.h"
 #include "OrbitLocationCameraController.h"
 #include "Scene.h"
+#include "SceneQuickView.h"
 #include "SceneView.h"
 
 // Qt headers
@@ -47,11 +48,23 @@ using namespace Esri::ArcGISRuntime;
 
 namespace Dsa {
 
+// viewpoint changes are treated as caused by the controller's own camera moves until
+// this long after the move's animation, in ms
+static const qint64 s_viewpointChangeMargin = 250;
+
 /*!
   \class Dsa::NavigationController
   \inmodule Dsa
   \inherits AbstractTool
   \brief Tool controller for handling navigation for the app.
+
+  Zooming, rotating and tilting operate around the location at the center of the
+  screen, which is resolved with an asynchronous screen to location task. The
+  navigation operations all keep that location at the center of the screen, so it
+  is reused until the viewpoint is moved by something else, such as the user or
+  another tool, and repeated commands execute immediately. Commands issued while
+  the location is being resolved are coalesced: only the latest one is executed
+  when the task completes.
  */
 
 /*!
@@ -62,6 +75,9 @@ NavigationController::NavigationController(QObject* parent) :
 {
   connect(ToolResourceProvider::instance(), &ToolResourceProvider::geoViewChanged, this, &NavigationController::updateGeoView);
   connect(ToolResourceProvider::instance(), &ToolResourceProvider::screenToLocationCompleted, this, &NavigationController::screenToLocationCompleted);
+  connect(ToolResourceProvider::instance(), &ToolResourceProvider::screenToLocationCompleted, this, &NavigationController::onScreenToLocationCompleted);
+
+  m_clock.start();
 
   updateGeoView();
 
@@ -99,35 +115,20 @@ void NavigationController::updateGeoView()
   if (!m_geoView)
     return;
 
+  if (m_viewpointConnection)
+    disconnect(m_viewpointConnection);
+
+  m_screenToLocationTask = TaskWatcher();
+  m_pendingTaskCurrent = false;
+  m_centerValid = false;
+
   m_sceneView = dynamic_cast<SceneView*>(m_geoView);
   if (m_sceneView)
   {
     m_is3d = true;
 
-    connect(this, &NavigationController::screenToLocationCompleted, this, [this](QUuid, Point location)
-    {
-      // check if called from the navigation controls
-      if (!m_enabled)
-        return;
-
-      m_currentCenter = location;
-
-      if (m_currentMode == Mode::Zoom)
-      {
-        zoom();
-      }
-      else if (m_currentMode == Mode::Rotate)
-      {
-        setRotationInternal();
-      }
-      else if(m_currentMode == Mode::Tilt)
-      {
-        set2DInternal();
-      }
-
-      // reset
-      m_enabled = false;
-    });
+    if (auto sceneQuickView = dynamic_cast<SceneQuickView*>(m_sceneView))
+      m_viewpointConnection = connect(sceneQuickView, &SceneQuickView::viewpointChanged, this, &NavigationController::onViewpointChanged);
   }
   else
   {
@@ -204,6 +205,73 @@ void NavigationController::setRotation()
   center();
 }
 
+/*!
+  \internal
+
+  Resolves the center of the screen from the latest screen to location task and
+  executes the latest navigation command.
+ */
+void NavigationController::onScreenToLocationCompleted(QUuid taskId, const Point& location)
+{
+  // results of superseded tasks, or of tasks from other tools, are ignored
+  if (!m_screenToLocationTask.isValid() || taskId != m_screenToLocationTask.taskId())
+    return;
+
+  m_screenToLocationTask = TaskWatcher();
+  m_currentCenter = location;
+
+  // the viewpoint may have been moved while the task was running
+  m_centerValid = m_pendingTaskCurrent;
+  m_pendingTaskCurrent = false;
+
+  applyCurrentMode();
+}
+
+/*!
+  \internal
+
+  Invalidates the resolved screen center when the viewpoint is moved by anything
+  other than the controller's own camera moves.
+ */
+void NavigationController::onViewpointChanged()
+{
+  if (m_clock.elapsed() <= m_ownViewpointChangeEnd)
+    return;
+
+  m_centerValid = false;
+  m_pendingTaskCurrent = false;
+}
+
+/*!
+  \internal
+ */
+void NavigationController::applyCurrentMode()
+{
+  if (m_currentMode == Mode::Zoom)
+  {
+    zoom();
+  }
+  else if (m_currentMode == Mode::Rotate)
+  {
+    setRotationInternal();
+  }
+  else if(m_currentMode == Mode::Tilt)
+  {
+    set2DInternal();
+  }
+}
+
+/*!
+  \internal
+
+  Marks the viewpoint changes of a camera move lasting \a durationSeconds as the
+  controller's own, which keep the screen center in place.
+ */
+void NavigationController::beginOwnViewpointChange(double durationSeconds)
+{
+  m_ownViewpointChangeEnd = m_clock.elapsed() + static_cast<qint64>(durationSeconds * 1000.0) + s_viewpointChangeMargin;
+}
+
 /*!
   \internal
  */
@@ -230,6 +298,7 @@ void NavigationController::zoom()
     if (m_currentCenter.x() == 0 && m_currentCenter.y() == 0 && m_currentCenter.z() == 0)
     {
       Camera newCam = currentCamera.moveForward(m_cameraMoveDistance);
+      beginOwnViewpointChange(0.0);
       m_sceneView->setViewpointCamera(newCam);
     }
     else
@@ -237,6 +306,7 @@ void NavigationController::zoom()
       // zoom in/out using the zoom factor
       Camera newCamera = currentCamera.zoomToward(m_currentCenter, m_zoomFactor);
       // set the sceneview to the new camera
+      beginOwnViewpointChange(0.5);
       m_sceneView->setViewpointCamera(newCamera, 0.5);
     }
   }
@@ -305,6 +375,7 @@ void NavigationController::setRotationInternal()
   OrbitLocationCameraController* orbitController = new OrbitLocationCameraController(m_currentCenter, distance, this);
   orbitController->setCameraPitchOffset(currentCamera.pitch());
   orbitController->setCameraHeadingOffset(currentCamera.heading());
+  beginOwnViewpointChange(0.0);
   m_sceneView->setCameraController(orbitController);
 }
 
@@ -324,6 +395,7 @@ void NavigationController::set2DInternal()
     // rotate the camera using the delta pitch value
     const Camera newCamera = currentCamera.rotateAround(m_currentCenter, 0., -currentCamera.pitch(), 0.);
     // set the sceneview to the new camera
+    beginOwnViewpointChange(2.0);
     m_sceneView->setViewpointCamera(newCamera, 2.0);
   }
 }
@@ -336,9 +408,22 @@ void NavigationController::center()
   if (!m_sceneView)
     return;
 
-  m_enabled = true;
+  if (m_centerValid)
+  {
+    applyCurrentMode();
+    return;
+  }
+
+  // a task for the current viewpoint is already running and will execute the latest command
+  if (m_screenToLocationTask.isValid() && !m_screenToLocationTask.isDone() && m_pendingTaskCurrent)
+    return;
+
+  // otherwise only the result of the new task is honored
+  if (m_screenToLocationTask.isValid() && !m_screenToLocationTask.isDone())
+    m_screenToLocationTask.cancel();
 
-  m_sceneView->screenToLocation(m_sceneView->widthInPixels() * 0.5, m_sceneView->heightInPixels() * 0.5);
+  m_screenToLocationTask = m_sceneView->screenToLocation(m_sceneView->widthInPixels() * 0.5, m_sceneView->heightInPixels() * 0.5);
+  m_pendingTaskCurrent = true;
 }
 
 /*!
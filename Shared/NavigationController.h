@@ -22,8 +22,11 @@
 
 // C++ API headers
 #include "Point.h"
+#include "TaskWatcher.h"
 
 // Qt headers
+#include <QElapsedTimer>
+#include <QMetaObject>
 #include <QUuid>
 
 namespace Esri {
@@ -73,6 +76,8 @@ signals:
 
 private slots:
   void updateGeoView();
+  void onScreenToLocationCompleted(QUuid taskId, const Esri::ArcGISRuntime::Point& location);
+  void onViewpointChanged();
 
 private:
   enum class Mode
@@ -84,6 +89,8 @@ private:
   };
 
   void center();
+  void applyCurrentMode();
+  void beginOwnViewpointChange(double durationSeconds);
   void zoom();
   void setRotationInternal();
   void set2DInternal();
@@ -96,9 +103,16 @@ private:
   double m_zoomFactor = 1.0;
   Esri::ArcGISRuntime::Point m_currentCenter;
   Mode m_currentMode;
-  bool m_enabled = false;
   bool m_isZoomIn = false;
   double m_cameraMoveDistance = 1000.0;
+
+  // the screen center is resolved once and reused until the viewpoint is moved by something else
+  Esri::ArcGISRuntime::TaskWatcher m_screenToLocationTask;
+  bool m_pendingTaskCurrent = false;
+  bool m_centerValid = false;
+  QElapsedTimer m_clock;
+  qint64 m_ownViewpointChangeEnd = 0;
+  QMetaObject::Connection m_viewpointConnection;
 };
 
 } // Dsa
@@ -22,11 +22,16 @@
 
 // dsa app headers
 #include "AppConstants.h"
+#include "FrameAnimationDriver.h"
 #include "LocationTextController.h"
 #include "MessageFeed.h"
 #include "MessageFeedListModel.h"
 #include "MessageFeedsController.h"
 #include "MessagesOverlay.h"
+#include "PerformanceMonitor.h"
+#include "PerformanceProfile.h"
+#include "SceneContentBudget.h"
+#include "TraceRecorder.h"
 
 #include "ToolManager.h"
 #include "ToolResourceProvider.h"
@@ -38,6 +43,9 @@
 #include "DictionaryRenderer.h"
 #include "DictionarySymbolStyleConfiguration.h"
 
+// Qt headers
+#include <QDateTime>
+
 using namespace Esri::ArcGISRuntime;
 
 namespace Dsa {
@@ -163,10 +171,23 @@ void OptionsController::setProperties(const QVariantMap& properties)
   m_initialFormatIndex = m_coordinateFormatOptions.indexOf(m_coordinateFormat);
   emit initialFormatIndex();
 
+  m_rootDataDirectory = properties.value(QStringLiteral("RootDataDirectory")).toString();
+
   auto userNameFindIt = properties.find(AppConstants::USERNAME_PROPERTYNAME);
   if (userNameFindIt != properties.end())
     setUserName(userNameFindIt.value().toString());
 
+  const QString profile = properties.value(AppConstants::PERFORMANCE_PROFILE_PROPERTYNAME, PerformanceProfile::CUSTOM).toString();
+  if (profile != m_performanceProfile)
+  {
+    m_performanceProfile = profile;
+    emit performanceProfileChanged();
+  }
+
+  // the profile may have changed the idle frame rate and scene layer quality
+  emit idleFrameRateChanged();
+  emit sceneLayerQualityChanged();
+
   // get access to the various tool controllers
   getUpdatedTools();
 }
@@ -256,6 +277,176 @@ void OptionsController::setUserName(const QString& userName)
   emit propertyChanged(AppConstants::USERNAME_PROPERTYNAME, m_userName);
 }
 
+/*!
+  \property OptionsController::showPerformanceHud
+  \brief Returns whether the performance heads-up display is shown.
+
+  \sa PerformanceMonitor
+ */
+bool OptionsController::showPerformanceHud() const
+{
+  return PerformanceMonitor::instance()->isEnabled();
+}
+
+/*!
+  \brief Sets whether the performance heads-up display is shown to \a show.
+ */
+void OptionsController::setShowPerformanceHud(bool show)
+{
+  if (show == showPerformanceHud())
+    return;
+
+  PerformanceMonitor::instance()->setEnabled(show);
+  emit showPerformanceHudChanged();
+  emit propertyChanged(AppConstants::PERFORMANCE_HUD_PROPERTYNAME, show);
+}
+
+/*!
+  \property OptionsController::performanceTracing
+  \brief Returns whether a trace of where the app spends its time is being recorded.
+
+  \sa TraceRecorder
+ */
+bool OptionsController::performanceTracing() const
+{
+  return TraceRecorder::instance()->isEnabled();
+}
+
+/*!
+  \brief Sets whether a trace of where the app spends its time is recorded to \a tracing.
+ */
+void OptionsController::setPerformanceTracing(bool tracing)
+{
+  if (tracing == performanceTracing())
+    return;
+
+  TraceRecorder::instance()->setEnabled(tracing);
+  emit performanceTracingChanged();
+  emit propertyChanged(AppConstants::PERFORMANCE_TRACING_PROPERTYNAME, tracing);
+}
+
+/*!
+  \property OptionsController::idleFrameRate
+  \brief Returns the frame rate animations such as highlights and flashing alerts are
+  slowed to while the view is idle. \c 0 means they are never slowed.
+
+  \sa FrameAnimationDriver
+ */
+int OptionsController::idleFrameRate() const
+{
+  return FrameAnimationDriver::instance()->idleFrameRate();
+}
+
+/*!
+  \brief Sets the frame rate animations are slowed to while the view is idle to \a idleFrameRate.
+ */
+void OptionsController::setIdleFrameRate(int idleFrameRate)
+{
+  if (idleFrameRate == this->idleFrameRate())
+    return;
+
+  FrameAnimationDriver::instance()->setIdleFrameRate(idleFrameRate);
+  emit idleFrameRateChanged();
+  emit propertyChanged(AppConstants::IDLE_FRAME_RATE_PROPERTYNAME, this->idleFrameRate());
+
+  // the settings no longer match a profile
+  setPerformanceProfile(PerformanceProfile::CUSTOM);
+}
+
+/*!
+  \property OptionsController::sceneLayerQualities
+  \brief Returns the names of the qualities scene layers can be drawn at.
+
+  \sa SceneContentBudget
+ */
+QStringList OptionsController::sceneLayerQualities() const
+{
+  return SceneContentBudget::qualities();
+}
+
+/*!
+  \property OptionsController::sceneLayerQuality
+  \brief Returns how far out scene layers, integrated meshes and point clouds are drawn
+  while memory allows.
+ */
+QString OptionsController::sceneLayerQuality() const
+{
+  return SceneContentBudget::instance()->quality();
+}
+
+/*!
+  \brief Sets how far out 3D content is drawn while memory allows to \a sceneLayerQuality.
+ */
+void OptionsController::setSceneLayerQuality(const QString& sceneLayerQuality)
+{
+  if (sceneLayerQuality == this->sceneLayerQuality() || !sceneLayerQualities().contains(sceneLayerQuality))
+    return;
+
+  SceneContentBudget::instance()->setQuality(sceneLayerQuality);
+  emit sceneLayerQualityChanged();
+  emit propertyChanged(AppConstants::SCENE_LAYER_QUALITY_PROPERTYNAME, this->sceneLayerQuality());
+
+  // the settings no longer match a profile
+  setPerformanceProfile(PerformanceProfile::CUSTOM);
+}
+
+/*!
+  \property OptionsController::performanceProfiles
+  \brief Returns the names of the performance profiles which can be selected.
+
+  \sa PerformanceProfile
+ */
+QStringList OptionsController::performanceProfiles() const
+{
+  return PerformanceProfile::names();
+}
+
+/*!
+  \property OptionsController::performanceProfile
+  \brief Returns the name of the selected performance profile.
+
+  This is \c Custom unless a profile was selected and its settings have not been changed since.
+ */
+QString OptionsController::performanceProfile() const
+{
+  return m_performanceProfile;
+}
+
+/*!
+  \brief Selects the performance profile \a performanceProfile.
+
+  The profile's settings are pushed to all of the tools in one pass and persisted along
+  with the name of the profile. Selecting \c Custom keeps the current settings.
+ */
+void OptionsController::setPerformanceProfile(const QString& performanceProfile)
+{
+  if (performanceProfile == m_performanceProfile || !performanceProfiles().contains(performanceProfile))
+    return;
+
+  m_performanceProfile = performanceProfile;
+  emit performanceProfileChanged();
+  emit propertyChanged(AppConstants::PERFORMANCE_PROFILE_PROPERTYNAME, m_performanceProfile);
+}
+
+/*!
+ \brief Writes the recorded performance trace to the \c Traces folder of the root data
+ directory, so that it can be sent for analysis.
+
+ Returns the path of the trace file, or an empty string if the trace could not be written.
+ */
+QString OptionsController::writePerformanceTrace()
+{
+  const QString tracePath = QString("%1/Traces/dsa-trace-%2.json").arg(m_rootDataDirectory,
+                                                                        QDateTime::currentDateTime().toString(QStringLiteral("yyyyMMdd-HHmmss")));
+  if (!TraceRecorder::instance()->writeTrace(tracePath))
+  {
+    emit toolErrorOccurred(QStringLiteral("Failed to write performance trace"), tracePath);
+    return QString();
+  }
+
+  return tracePath;
+}
+
 /*!
   \property OptionsController::initialFormatIndex
  \brief Returns the initial index.
@@ -371,3 +562,36 @@ QList<DictionaryRenderer*> OptionsController::friendlyTracksOverlayRenderers() c
   \fn void OptionsController::userNameChanged();
   \brief Signal emitted when the userName property changes.
  */
+
+/*!
+  \fn void OptionsController::showPerformanceHudChanged();
+  \brief Signal emitted when the showPerformanceHud property changes.
+ */
+
+/*!
+  \fn void OptionsController::performanceTracingChanged();
+  \brief Signal emitted when the performanceTracing property changes.
+ */
+
+/*!
+  \fn void OptionsController::idleFrameRateChanged();
+  \brief Signal emitted when the idleFrameRate property changes.
+ */
+
+/*!
+  \fn void OptionsController::sceneLayerQualityChanged();
+  \brief Signal emitted when the sceneLayerQuality property changes.
+ */
+
+/*!
+  \fn void OptionsController::performanceProfileChanged();
+  \brief Signal emitted when the performanceProfile property changes.
+ */
+
+/*!
+  \fn void OptionsController::toolErrorOccurred(const QString& errorMessage, const QString& additionalMessage);
+  \brief Signal emitted when an error occurs.
+
+  An \a errorMessage and \a additionalMessage are passed through as parameters, describing
+  the error that occurred.
+ */
@@ -44,6 +44,13 @@ class OptionsController : public AbstractTool
   Q_PROPERTY(int initialUnitIndex READ initialUnitIndex NOTIFY initialUnitIndexChanged)
   Q_PROPERTY(bool showFriendlyTracksLabels READ showFriendlyTracksLabels WRITE setShowFriendlyTracksLabels NOTIFY showFriendlyTracksLabelsChanged)
   Q_PROPERTY(QString userName READ userName WRITE setUserName NOTIFY userNameChanged)
+  Q_PROPERTY(bool showPerformanceHud READ showPerformanceHud WRITE setShowPerformanceHud NOTIFY showPerformanceHudChanged)
+  Q_PROPERTY(bool performanceTracing READ performanceTracing WRITE setPerformanceTracing NOTIFY performanceTracingChanged)
+  Q_PROPERTY(int idleFrameRate READ idleFrameRate WRITE setIdleFrameRate NOTIFY idleFrameRateChanged)
+  Q_PROPERTY(QStringList sceneLayerQualities READ sceneLayerQualities CONSTANT)
+  Q_PROPERTY(QString sceneLayerQuality READ sceneLayerQuality WRITE setSceneLayerQuality NOTIFY sceneLayerQualityChanged)
+  Q_PROPERTY(QStringList performanceProfiles READ performanceProfiles CONSTANT)
+  Q_PROPERTY(QString performanceProfile READ performanceProfile WRITE setPerformanceProfile NOTIFY performanceProfileChanged)
 
 public:
   explicit OptionsController(QObject* parent = nullptr);
@@ -57,6 +64,25 @@ public:
   QString userName() const;
   void setUserName(const QString &userName);
 
+  bool showPerformanceHud() const;
+  void setShowPerformanceHud(bool show);
+
+  bool performanceTracing() const;
+  void setPerformanceTracing(bool tracing);
+
+  int idleFrameRate() const;
+  void setIdleFrameRate(int idleFrameRate);
+
+  QStringList sceneLayerQualities() const;
+  QString sceneLayerQuality() const;
+  void setSceneLayerQuality(const QString& sceneLayerQuality);
+
+  QStringList performanceProfiles() const;
+  QString performanceProfile() const;
+  void setPerformanceProfile(const QString& performanceProfile);
+
+  Q_INVOKABLE QString writePerformanceTrace();
+
 signals:
   void coordinateFormatsChanged();
   void useGpsForElevationChanged();
@@ -65,6 +91,12 @@ signals:
   void initialFormatIndexChanged();
   void showFriendlyTracksLabelsChanged();
   void userNameChanged();
+  void showPerformanceHudChanged();
+  void performanceTracingChanged();
+  void idleFrameRateChanged();
+  void sceneLayerQualityChanged();
+  void performanceProfileChanged();
+  void toolErrorOccurred(const QString& errorMessage, const QString& additionalMessage);
 
 private:
   LocationTextController* m_locationTextController = nullptr;
@@ -75,6 +107,8 @@ private:
   QStringList m_coordinateFormatOptions;
   QStringList m_units;
   QString m_userName;
+  QString m_rootDataDirectory;
+  QString m_performanceProfile;
 
   void getUpdatedTools();
   QStringList coordinateFormats() const;
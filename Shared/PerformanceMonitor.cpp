@@ -0,0 +1,435 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "PerformanceMonitor.h"
+
+// dsa app headers
+#include "AlertEvaluationScheduler.h"
+#include "AlertEvaluationStats.h"
+#include "MemoryBudget.h"
+#include "MessageFeedStats.h"
+#include "MessageFeedsController.h"
+#include "TraceRecorder.h"
+
+#include "ToolManager.h"
+
+// Qt headers
+#include <QQuickWindow>
+#include <QTimer>
+
+// STL headers
+#include <algorithm>
+
+namespace Dsa {
+
+namespace
+{
+constexpr int s_sampleInterval = 1000;
+constexpr double s_nsecsPerMsec = 1000000.0;
+constexpr double s_bytesPerMegabyte = 1024.0 * 1024.0;
+
+// trace counter names, indexed by AllocationCounter::Subsystem
+constexpr const char* s_allocationRateCounters[AllocationCounter::SubsystemCount] =
+{
+  "Allocations/s (other)",
+  "Allocations/s (messages)",
+  "Allocations/s (alerts)",
+  "Allocations/s (analysis)",
+  "Allocations/s (markup)",
+  "Allocations/s (layers)"
+};
+
+constexpr const char* s_liveBytesCounters[AllocationCounter::SubsystemCount] =
+{
+  "Heap bytes (other)",
+  "Heap bytes (messages)",
+  "Heap bytes (alerts)",
+  "Heap bytes (analysis)",
+  "Heap bytes (markup)",
+  "Heap bytes (layers)"
+};
+}
+
+std::atomic<qint64> PerformanceMonitor::s_quadtreeRebuildCount{0};
+
+/*!
+  \class Dsa::PerformanceMonitor
+  \inmodule Dsa
+  \inherits QObject
+  \brief Samples runtime performance statistics for display in a heads-up display.
+
+  While \l enabled, the statistics are sampled once a second:
+
+  \list
+    \li The frame rate, and the average and maximum time taken to synchronize and
+        render a frame of the window passed to \l setWindow.
+    \li The message ingest rate of the \l MessageFeedsController.
+    \li The evaluation rate of the \l AlertEvaluationScheduler.
+    \li The rate at which \l GeometryQuadtree objects rebuild their trees.
+    \li The resident memory of the app, and the estimated footprint of each
+        cache registered with the \l MemoryBudget.
+    \li When the app is built with \c {CONFIG+=dsa_count_allocations}, the
+        allocation rate and heap usage of each \l {AllocationCounter::Subsystem}
+        {subsystem}. These are also recorded as counters by the \l TraceRecorder
+        while it is enabled.
+  \endlist
+
+  Nothing is measured while the monitor is disabled, apart from counting quadtree
+  rebuilds, unless \l {setBackgroundSampling}{background sampling} has been turned on,
+  for example by the \l MetricsExporter, without showing the statistics.
+ */
+
+/*!
+  \brief Returns the singleton instance of the monitor.
+ */
+PerformanceMonitor* PerformanceMonitor::instance()
+{
+  static PerformanceMonitor s_instance;
+  return &s_instance;
+}
+
+/*!
+  \internal
+ */
+PerformanceMonitor::PerformanceMonitor(QObject* parent):
+  QObject(parent),
+  m_sampleTimer(new QTimer(this))
+{
+  m_sampleTimer->setInterval(s_sampleInterval);
+  connect(m_sampleTimer, &QTimer::timeout, this, &PerformanceMonitor::sample);
+}
+
+/*!
+  \brief Destructor.
+ */
+PerformanceMonitor::~PerformanceMonitor()
+{
+}
+
+/*!
+  \brief Records that a quadtree has been rebuilt.
+
+  This can be called from any thread.
+ */
+void PerformanceMonitor::recordQuadtreeRebuild()
+{
+  s_quadtreeRebuildCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+/*!
+  \brief Sets the \a window whose frames are timed.
+ */
+void PerformanceMonitor::setWindow(QQuickWindow* window)
+{
+  if (m_window == window)
+    return;
+
+  for (const auto& connection : qAsConst(m_windowConnections))
+    disconnect(connection);
+
+  m_windowConnections.clear();
+  m_window = window;
+
+  if (!m_window)
+    return;
+
+  // with the threaded render loop these are emitted on the render thread
+  m_windowConnections.append(connect(m_window, &QQuickWindow::beforeSynchronizing, this, [this]()
+  {
+    m_frameClock.start();
+  }, Qt::DirectConnection));
+
+  m_windowConnections.append(connect(m_window, &QQuickWindow::frameSwapped, this, [this]()
+  {
+    if (!m_frameClock.isValid() || !m_sampleTimer->isActive())
+      return;
+
+    const qint64 frameNsecs = m_frameClock.nsecsElapsed();
+    m_frameCount.fetch_add(1, std::memory_order_relaxed);
+    m_totalFrameNsecs.fetch_add(frameNsecs, std::memory_order_relaxed);
+    if (frameNsecs > m_maximumFrameNsecs.load(std::memory_order_relaxed))
+      m_maximumFrameNsecs.store(frameNsecs, std::memory_order_relaxed);
+  }, Qt::DirectConnection));
+}
+
+/*!
+  \property PerformanceMonitor::enabled
+  \brief Returns whether the statistics are being sampled and shown.
+
+  The default is \c false.
+ */
+bool PerformanceMonitor::isEnabled() const
+{
+  return m_enabled;
+}
+
+/*!
+  \brief Sets whether the statistics are being sampled and shown to \a enabled.
+ */
+void PerformanceMonitor::setEnabled(bool enabled)
+{
+  if (m_enabled == enabled)
+    return;
+
+  m_enabled = enabled;
+  updateSampling();
+
+  emit enabledChanged();
+}
+
+/*!
+  \brief Returns whether the statistics are sampled while the monitor is not \l enabled.
+
+  The default is \c false.
+ */
+bool PerformanceMonitor::isBackgroundSampling() const
+{
+  return m_backgroundSampling;
+}
+
+/*!
+  \brief Sets whether the statistics are sampled while the monitor is not \l enabled
+  to \a backgroundSampling.
+ */
+void PerformanceMonitor::setBackgroundSampling(bool backgroundSampling)
+{
+  if (m_backgroundSampling == backgroundSampling)
+    return;
+
+  m_backgroundSampling = backgroundSampling;
+  updateSampling();
+}
+
+/*!
+  \property PerformanceMonitor::framesPerSecond
+  \brief Returns the number of frames rendered over the last second.
+ */
+double PerformanceMonitor::framesPerSecond() const
+{
+  return m_framesPerSecond;
+}
+
+/*!
+  \property PerformanceMonitor::frameTime
+  \brief Returns the average time in milliseconds taken to synchronize and render
+  a frame over the last second.
+ */
+double PerformanceMonitor::frameTime() const
+{
+  return m_frameTime;
+}
+
+/*!
+  \property PerformanceMonitor::maximumFrameTime
+  \brief Returns the longest time in milliseconds taken to synchronize and render
+  a frame over the last second.
+ */
+double PerformanceMonitor::maximumFrameTime() const
+{
+  return m_maximumFrameTime;
+}
+
+/*!
+  \property PerformanceMonitor::messagesPerSecond
+  \brief Returns the rate at which messages were received over the last second.
+ */
+double PerformanceMonitor::messagesPerSecond() const
+{
+  return m_messagesPerSecond;
+}
+
+/*!
+  \property PerformanceMonitor::alertEvaluationsPerSecond
+  \brief Returns the rate at which alert condition data were evaluated over the last second.
+ */
+double PerformanceMonitor::alertEvaluationsPerSecond() const
+{
+  return m_alertEvaluationsPerSecond;
+}
+
+/*!
+  \property PerformanceMonitor::quadtreeRebuildsPerSecond
+  \brief Returns the rate at which quadtrees were rebuilt over the last second.
+ */
+double PerformanceMonitor::quadtreeRebuildsPerSecond() const
+{
+  return m_quadtreeRebuildsPerSecond;
+}
+
+/*!
+  \property PerformanceMonitor::memoryUsage
+  \brief Returns the resident memory of the app in megabytes, or \c -1 if it is not
+  known on this platform.
+ */
+double PerformanceMonitor::memoryUsage() const
+{
+  return m_memoryUsage;
+}
+
+/*!
+  \property PerformanceMonitor::memoryFootprints
+  \brief Returns the estimated footprint of each cache registered with the
+  \l MemoryBudget.
+
+  Each entry is a map with the \c name of the cache and the number of
+  \c megabytes it holds.
+ */
+QVariantList PerformanceMonitor::memoryFootprints() const
+{
+  return m_memoryFootprints;
+}
+
+/*!
+  \property PerformanceMonitor::allocationStats
+  \brief Returns the heap allocations of each subsystem over the last second, or
+  an empty list if allocations are not being counted.
+
+  Each entry is a map with the \c name of the subsystem, its
+  \c allocationsPerSecond, and the \c liveMegabytes and \c peakMegabytes it has
+  allocated. The megabytes are \c -1 where they are not tracked.
+
+  \sa AllocationCounter
+ */
+QVariantList PerformanceMonitor::allocationStats() const
+{
+  return m_allocationStats;
+}
+
+/*!
+  \brief Returns a one line summary of the statistics, for example for logging.
+ */
+QString PerformanceMonitor::summary() const
+{
+  return QString("%1 fps, frame %2 ms (max %3 ms), %4 messages/s, %5 alert evaluations/s, %6 quadtree rebuilds/s, %7 MB")
+      .arg(QString::number(m_framesPerSecond, 'f', 1),
+           QString::number(m_frameTime, 'f', 2),
+           QString::number(m_maximumFrameTime, 'f', 2),
+           QString::number(m_messagesPerSecond, 'f', 1),
+           QString::number(m_alertEvaluationsPerSecond, 'f', 1),
+           QString::number(m_quadtreeRebuildsPerSecond, 'f', 1),
+           m_memoryUsage < 0.0 ? QStringLiteral("-") : QString::number(m_memoryUsage, 'f', 0));
+}
+
+/*!
+  \internal
+  \brief Starts or stops sampling as the monitor is enabled or sampled in the background.
+ */
+void PerformanceMonitor::updateSampling()
+{
+  const bool sampling = m_enabled || m_backgroundSampling;
+  if (m_sampleTimer->isActive() == sampling)
+    return;
+
+  if (sampling)
+  {
+    m_frameCount = 0;
+    m_totalFrameNsecs = 0;
+    m_maximumFrameNsecs = 0;
+    m_lastQuadtreeRebuildCount = s_quadtreeRebuildCount.load(std::memory_order_relaxed);
+    for (int i = 0; i < AllocationCounter::SubsystemCount; ++i)
+      m_lastAllocationCounts[i] = AllocationCounter::subsystemStats(static_cast<AllocationCounter::Subsystem>(i)).m_allocationCount;
+    m_sampleClock.start();
+    m_sampleTimer->start();
+  }
+  else
+  {
+    m_sampleTimer->stop();
+  }
+}
+
+/*!
+  \internal
+ */
+void PerformanceMonitor::sample()
+{
+  const double seconds = std::max(m_sampleClock.restart(), qint64(1)) / 1000.0;
+
+  const qint64 frameCount = m_frameCount.exchange(0, std::memory_order_relaxed);
+  const qint64 totalFrameNsecs = m_totalFrameNsecs.exchange(0, std::memory_order_relaxed);
+  const qint64 maximumFrameNsecs = m_maximumFrameNsecs.exchange(0, std::memory_order_relaxed);
+  m_framesPerSecond = frameCount / seconds;
+  m_frameTime = frameCount == 0 ? 0.0 : totalFrameNsecs / s_nsecsPerMsec / frameCount;
+  m_maximumFrameTime = maximumFrameNsecs / s_nsecsPerMsec;
+
+  m_messagesPerSecond = 0.0;
+  MessageFeedsController* messageFeeds = ToolManager::instance().tool<MessageFeedsController>();
+  if (messageFeeds)
+  {
+    auto ingestStats = qobject_cast<MessageFeedStats*>(messageFeeds->ingestStats());
+    if (ingestStats)
+      m_messagesPerSecond = ingestStats->messagesPerSecond();
+  }
+
+  m_alertEvaluationsPerSecond = AlertEvaluationScheduler::instance()->stats()->evaluationsPerSecond();
+
+  const qint64 quadtreeRebuildCount = s_quadtreeRebuildCount.load(std::memory_order_relaxed);
+  m_quadtreeRebuildsPerSecond = (quadtreeRebuildCount - m_lastQuadtreeRebuildCount) / seconds;
+  m_lastQuadtreeRebuildCount = quadtreeRebuildCount;
+
+  const qint64 memory = MemoryBudget::residentMemory();
+  m_memoryUsage = memory < 0 ? -1.0 : memory / s_bytesPerMegabyte;
+  m_memoryFootprints = MemoryBudget::instance()->footprints();
+
+  sampleAllocations(seconds);
+
+  emit statsChanged();
+}
+
+/*!
+  \internal
+ */
+void PerformanceMonitor::sampleAllocations(double seconds)
+{
+  m_allocationStats.clear();
+  if (!AllocationCounter::isEnabled())
+    return;
+
+  TraceRecorder* traceRecorder = TraceRecorder::instance();
+  for (int i = 0; i < AllocationCounter::SubsystemCount; ++i)
+  {
+    const auto subsystem = static_cast<AllocationCounter::Subsystem>(i);
+    const AllocationCounter::SubsystemStats stats = AllocationCounter::subsystemStats(subsystem);
+    const double allocationsPerSecond = (stats.m_allocationCount - m_lastAllocationCounts[i]) / seconds;
+    m_lastAllocationCounts[i] = stats.m_allocationCount;
+
+    QVariantMap subsystemStats;
+    subsystemStats.insert(QStringLiteral("name"), QString::fromLatin1(AllocationCounter::subsystemName(subsystem)));
+    subsystemStats.insert(QStringLiteral("allocationsPerSecond"), allocationsPerSecond);
+    subsystemStats.insert(QStringLiteral("liveMegabytes"), stats.m_liveBytes < 0 ? -1.0 : stats.m_liveBytes / s_bytesPerMegabyte);
+    subsystemStats.insert(QStringLiteral("peakMegabytes"), stats.m_peakBytes < 0 ? -1.0 : stats.m_peakBytes / s_bytesPerMegabyte);
+    m_allocationStats.append(subsystemStats);
+
+    traceRecorder->counter(s_allocationRateCounters[i], static_cast<qint64>(allocationsPerSecond));
+    if (stats.m_liveBytes >= 0)
+      traceRecorder->counter(s_liveBytesCounters[i], stats.m_liveBytes);
+  }
+}
+
+} // Dsa
+
+// Signal Documentation
+/*!
+  \fn void PerformanceMonitor::enabledChanged();
+  \brief Signal emitted when the \l enabled property changes.
+ */
+
+/*!
+  \fn void PerformanceMonitor::statsChanged();
+  \brief Signal emitted when the statistics are sampled.
+ */
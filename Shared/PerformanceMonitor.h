@@ -0,0 +1,120 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef PERFORMANCEMONITOR_H
+#define PERFORMANCEMONITOR_H
+
+// dsa app headers
+#include "AllocationCounter.h"
+
+// Qt headers
+#include <QElapsedTimer>
+#include <QObject>
+#include <QPointer>
+#include <QVariantList>
+
+// STL headers
+#include <atomic>
+
+class QQuickWindow;
+class QTimer;
+
+namespace Dsa {
+
+class PerformanceMonitor : public QObject
+{
+  Q_OBJECT
+
+  Q_PROPERTY(bool enabled READ isEnabled WRITE setEnabled NOTIFY enabledChanged)
+  Q_PROPERTY(double framesPerSecond READ framesPerSecond NOTIFY statsChanged)
+  Q_PROPERTY(double frameTime READ frameTime NOTIFY statsChanged)
+  Q_PROPERTY(double maximumFrameTime READ maximumFrameTime NOTIFY statsChanged)
+  Q_PROPERTY(double messagesPerSecond READ messagesPerSecond NOTIFY statsChanged)
+  Q_PROPERTY(double alertEvaluationsPerSecond READ alertEvaluationsPerSecond NOTIFY statsChanged)
+  Q_PROPERTY(double quadtreeRebuildsPerSecond READ quadtreeRebuildsPerSecond NOTIFY statsChanged)
+  Q_PROPERTY(double memoryUsage READ memoryUsage NOTIFY statsChanged)
+  Q_PROPERTY(QVariantList memoryFootprints READ memoryFootprints NOTIFY statsChanged)
+  Q_PROPERTY(QVariantList allocationStats READ allocationStats NOTIFY statsChanged)
+
+public:
+  static PerformanceMonitor* instance();
+  ~PerformanceMonitor();
+
+  static void recordQuadtreeRebuild();
+
+  void setWindow(QQuickWindow* window);
+
+  bool isEnabled() const;
+  void setEnabled(bool enabled);
+
+  bool isBackgroundSampling() const;
+  void setBackgroundSampling(bool backgroundSampling);
+
+  double framesPerSecond() const;
+  double frameTime() const;
+  double maximumFrameTime() const;
+  double messagesPerSecond() const;
+  double alertEvaluationsPerSecond() const;
+  double quadtreeRebuildsPerSecond() const;
+  double memoryUsage() const;
+  QVariantList memoryFootprints() const;
+  QVariantList allocationStats() const;
+
+  Q_INVOKABLE QString summary() const;
+
+signals:
+  void enabledChanged();
+  void statsChanged();
+
+private:
+  explicit PerformanceMonitor(QObject* parent = nullptr);
+  Q_DISABLE_COPY(PerformanceMonitor)
+
+  void updateSampling();
+  void sample();
+  void sampleAllocations(double seconds);
+
+  static std::atomic<qint64> s_quadtreeRebuildCount;
+
+  QPointer<QQuickWindow> m_window;
+  QList<QMetaObject::Connection> m_windowConnections;
+  QTimer* m_sampleTimer = nullptr;
+  bool m_enabled = false;
+  bool m_backgroundSampling = false;
+  QElapsedTimer m_sampleClock;
+
+  // written on the render thread
+  QElapsedTimer m_frameClock;
+  std::atomic<qint64> m_frameCount{0};
+  std::atomic<qint64> m_totalFrameNsecs{0};
+  std::atomic<qint64> m_maximumFrameNsecs{0};
+
+  qint64 m_lastQuadtreeRebuildCount = 0;
+  double m_framesPerSecond = 0.0;
+  double m_frameTime = 0.0;
+  double m_maximumFrameTime = 0.0;
+  double m_messagesPerSecond = 0.0;
+  double m_alertEvaluationsPerSecond = 0.0;
+  double m_quadtreeRebuildsPerSecond = 0.0;
+  double m_memoryUsage = -1.0;
+  QVariantList m_memoryFootprints;
+  QVariantList m_allocationStats;
+  qint64 m_lastAllocationCounts[AllocationCounter::SubsystemCount] = {};
+};
+
+} // Dsa
+
+#endif // PERFORMANCEMONITOR_H
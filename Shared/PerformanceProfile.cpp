@@ -0,0 +1,155 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "PerformanceProfile.h"
+
+// dsa app headers
+#include "AppConstants.h"
+#include "LocationController.h"
+#include "MessageFeedConstants.h"
+
+namespace Dsa {
+
+/*!
+  \class Dsa::PerformanceProfile
+  \inmodule Dsa
+  \brief Static helper class with presets of the settings which trade rendering,
+  location and network load against battery life.
+
+  A profile changes several settings owned by different tools at once:
+
+  \list
+    \li \c LocationUpdateInterval and \c LocationMinimumDistance, which limit how
+        often the location is passed on to the tools.
+    \li The \c adaptive, \c distanceThreshold, \c headingThreshold and
+        \c heartbeatInterval keys of \c LocationBroadcastConfig, which limit how
+        often the location is broadcast.
+    \li The \c interestManaged, \c clusterScale and \c trailLength keys of each
+        of the \c MessageFeeds. These take effect when the feeds are next created,
+        at startup.
+    \li \c IdleFrameRate and \c MemoryBudget.
+    \li \c SceneLayerQuality and \c SceneMemoryBudget, which limit the 3D content
+        held for scene layers, integrated meshes and point clouds.
+  \endlist
+
+  Any other settings, such as ports and message types, are kept. The \c Custom
+  profile leaves all of the settings as they are.
+ */
+
+const QString PerformanceProfile::CUSTOM = QStringLiteral("Custom");
+const QString PerformanceProfile::VEHICLE_HIGH = QStringLiteral("Vehicle high");
+const QString PerformanceProfile::HANDHELD_BALANCED = QStringLiteral("Handheld balanced");
+const QString PerformanceProfile::HANDHELD_BATTERY_SAVER = QStringLiteral("Handheld battery saver");
+
+namespace
+{
+
+struct ProfileValues
+{
+  int m_locationUpdateInterval;
+  double m_locationMinimumDistance;
+  bool m_adaptiveBroadcast;
+  double m_broadcastDistanceThreshold;
+  double m_broadcastHeadingThreshold;
+  int m_broadcastHeartbeatInterval;
+  bool m_feedInterestManaged;
+  double m_feedClusterScale;
+  int m_feedTrailLength;
+  int m_idleFrameRate;
+  int m_memoryBudget;
+  const char* m_sceneLayerQuality;
+  int m_sceneMemoryBudget;
+};
+
+// a vehicle has power and a capable GPU, so everything is shown and sent as it happens
+constexpr ProfileValues s_vehicleHigh{0, 0.0, false, 25.0, 20.0, 30000, false, 0.0, 100, 0, 0, "High", 0};
+
+constexpr ProfileValues s_handheldBalanced{1000, 2.0, true, 25.0, 20.0, 30000, true, 0.0, 50, 10, 512, "Medium", 768};
+
+// updates are spread out and distant tracks are clustered, at the cost of the picture being less current
+constexpr ProfileValues s_handheldBatterySaver{5000, 10.0, true, 50.0, 45.0, 60000, true, 250000.0, 0, 2, 256, "Low", 384};
+
+} // namespace
+
+/*!
+  \brief Returns the names of the profiles, starting with \c Custom.
+ */
+QStringList PerformanceProfile::names()
+{
+  return QStringList{CUSTOM, VEHICLE_HIGH, HANDHELD_BALANCED, HANDHELD_BATTERY_SAVER};
+}
+
+/*!
+  \brief Returns the settings which change when the profile \a name is applied to
+  \a currentSettings.
+
+  The returned settings include \c PerformanceProfile itself, so that the profile is
+  persisted along with them. Nested settings, such as \c LocationBroadcastConfig,
+  are returned whole with the profile merged into the current values.
+
+  Returns an empty map if \a name is not a known profile.
+ */
+QVariantMap PerformanceProfile::settings(const QString& name, const QVariantMap& currentSettings)
+{
+  QVariantMap settings;
+
+  const ProfileValues* values = nullptr;
+  if (name == VEHICLE_HIGH)
+    values = &s_vehicleHigh;
+  else if (name == HANDHELD_BALANCED)
+    values = &s_handheldBalanced;
+  else if (name == HANDHELD_BATTERY_SAVER)
+    values = &s_handheldBatterySaver;
+  else if (name != CUSTOM)
+    return settings;
+
+  settings.insert(AppConstants::PERFORMANCE_PROFILE_PROPERTYNAME, name);
+  if (!values)
+    return settings;
+
+  settings.insert(LocationController::LOCATION_UPDATE_INTERVAL_PROPERTYNAME, values->m_locationUpdateInterval);
+  settings.insert(LocationController::LOCATION_MINIMUM_DISTANCE_PROPERTYNAME, values->m_locationMinimumDistance);
+
+  QVariantMap broadcastConfig = currentSettings.value(MessageFeedConstants::LOCATION_BROADCAST_CONFIG_PROPERTYNAME).toMap();
+  broadcastConfig.insert(MessageFeedConstants::LOCATION_BROADCAST_CONFIG_ADAPTIVE, values->m_adaptiveBroadcast);
+  broadcastConfig.insert(MessageFeedConstants::LOCATION_BROADCAST_CONFIG_DISTANCE_THRESHOLD, values->m_broadcastDistanceThreshold);
+  broadcastConfig.insert(MessageFeedConstants::LOCATION_BROADCAST_CONFIG_HEADING_THRESHOLD, values->m_broadcastHeadingThreshold);
+  broadcastConfig.insert(MessageFeedConstants::LOCATION_BROADCAST_CONFIG_HEARTBEAT_INTERVAL, values->m_broadcastHeartbeatInterval);
+  settings.insert(MessageFeedConstants::LOCATION_BROADCAST_CONFIG_PROPERTYNAME, broadcastConfig);
+
+  QVariantList messageFeeds = currentSettings.value(MessageFeedConstants::MESSAGE_FEEDS_PROPERTYNAME).toList();
+  for (QVariant& messageFeed : messageFeeds)
+  {
+    QVariantMap messageFeedMap = messageFeed.toMap();
+    messageFeedMap.insert(MessageFeedConstants::MESSAGE_FEEDS_INTEREST_MANAGED, values->m_feedInterestManaged);
+    messageFeedMap.insert(MessageFeedConstants::MESSAGE_FEEDS_CLUSTER_SCALE, values->m_feedClusterScale);
+    messageFeedMap.insert(MessageFeedConstants::MESSAGE_FEEDS_TRAIL_LENGTH, values->m_feedTrailLength);
+    messageFeed = messageFeedMap;
+  }
+  settings.insert(MessageFeedConstants::MESSAGE_FEEDS_PROPERTYNAME, messageFeeds);
+
+  settings.insert(AppConstants::IDLE_FRAME_RATE_PROPERTYNAME, values->m_idleFrameRate);
+  settings.insert(AppConstants::MEMORY_BUDGET_PROPERTYNAME, values->m_memoryBudget);
+  settings.insert(AppConstants::SCENE_LAYER_QUALITY_PROPERTYNAME, QString::fromLatin1(values->m_sceneLayerQuality));
+  settings.insert(AppConstants::SCENE_MEMORY_BUDGET_PROPERTYNAME, values->m_sceneMemoryBudget);
+
+  return settings;
+}
+
+} // Dsa
@@ -0,0 +1,41 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef PERFORMANCEPROFILE_H
+#define PERFORMANCEPROFILE_H
+
+// Qt headers
+#include <QString>
+#include <QStringList>
+#include <QVariantMap>
+
+namespace Dsa {
+
+class PerformanceProfile
+{
+public:
+  static const QString CUSTOM;
+  static const QString VEHICLE_HIGH;
+  static const QString HANDHELD_BALANCED;
+  static const QString HANDHELD_BATTERY_SAVER;
+
+  static QStringList names();
+  static QVariantMap settings(const QString& name, const QVariantMap& currentSettings);
+};
+
+} // Dsa
+
+#endif // PERFORMANCEPROFILE_H
@@ -19,6 +19,9 @@
 
 #include "PointHighlighter.h"
 
+// dsa app headers
+#include "FrameAnimationDriver.h"
+
 // toolkit headers
 #include "ToolResourceProvider.h"
 
@@ -30,9 +33,6 @@
 #include "Point.h"
 #include "SimpleMarkerSceneSymbol.h"
 
-// Qt headers
-#include <QTimer>
-
 using namespace Esri::ArcGISRuntime;
 
 namespace Dsa {
@@ -42,6 +42,10 @@ namespace Dsa {
   \inmodule Dsa
   \inherits QObject
   \brief Manager for an animated highlight graphic centered on a point.
+
+  The highlight pulses outwards from the point, fading as it grows. It is
+  animated by the \l FrameAnimationDriver, so the symbol is updated once per
+  frame drawn by the view. The graphic is only moved when the point changes.
  */
 
 /*!
@@ -70,6 +74,9 @@ PointHighlighter::~PointHighlighter()
 void PointHighlighter::onPointChanged(const Point& point)
 {
   m_point = point;
+
+  // the graphic is moved in the next frame, so a point which changes several times per frame is only written once
+  m_pointChanged = true;
 }
 
 /*!
@@ -83,65 +90,16 @@ void PointHighlighter::startHighlight()
   if (!m_highlightOverlay || !m_highlightSymbol)
     return;
 
-  Graphic* highlightGraphic = new Graphic(m_point, m_highlightSymbol, this);
-  m_highlightOverlay->graphics()->append(highlightGraphic);
+  stopHighlight();
 
-  if (m_highlightTimer)
-  {
-    disconnect(m_timerConnection);
-    m_highlightTimer->stop();
-    delete m_highlightTimer;
-    m_highlightTimer = nullptr;
-  }
+  m_highlightGraphic = new Graphic(m_point, m_highlightSymbol, this);
+  m_highlightOverlay->graphics()->append(m_highlightGraphic);
+  m_pointChanged = false;
 
-  m_highlightTimer = new QTimer(this);
-  m_timerConnection = connect(m_highlightTimer, &QTimer::timeout, this, [this]()
+  FrameAnimationDriver::instance()->addAnimation(this, [this](qint64 elapsedMs)
   {
-    if (!m_highlightSymbol)
-    {
-      m_highlightTimer->stop();
-      return;
-    }
-
-    if (!m_highlightOverlay || !m_highlightOverlay->graphics() || m_highlightOverlay->graphics()->isEmpty())
-    {
-      m_highlightTimer->stop();
-      return;
-    }
-
-    Graphic* graphic = m_highlightOverlay->graphics()->first();
-    if (!graphic)
-    {
-      m_highlightTimer->stop();
-      return;
-    }
-
-    graphic->setGeometry(m_point);
-
-    const int currDim = m_highlightSymbol->width();
-    constexpr int maxDimension = 1000;
-    int newDimension = currDim;
-    float newOpacity = m_highlightOverlay->opacity();
-    if (currDim < maxDimension)
-    {
-      newDimension += 10;
-      newOpacity -= 0.01f;
-    }
-    else
-    {
-      newDimension = 1;
-    }
-
-    if (currDim > 10 && currDim < 30)
-      newOpacity = 1.0f;
-
-    m_highlightSymbol->setWidth(newDimension);
-    m_highlightSymbol->setHeight(newDimension);
-    m_highlightSymbol->setDepth(newDimension);
-    m_highlightOverlay->setOpacity(newOpacity);
+    return updateHighlight(elapsedMs);
   });
-
-  m_highlightTimer->start(10);
 }
 
 /*!
@@ -149,23 +107,45 @@ void PointHighlighter::startHighlight()
  */
 void PointHighlighter::stopHighlight()
 {
-  if (!m_highlightOverlay || !m_highlightOverlay->graphics() || m_highlightOverlay->graphics()->isEmpty())
+  FrameAnimationDriver::instance()->removeAnimation(this);
+
+  if (!m_highlightGraphic)
     return;
 
-  Graphic* graphic = m_highlightOverlay->graphics()->first();
-  if (graphic)
-  {
-    delete graphic;
-    m_highlightOverlay->graphics()->clear();
-  }
+  if (m_highlightOverlay && m_highlightOverlay->graphics())
+    m_highlightOverlay->graphics()->removeOne(m_highlightGraphic);
 
-  if (m_highlightTimer)
+  delete m_highlightGraphic;
+  m_highlightGraphic = nullptr;
+}
+
+/*!
+  \internal
+  Updates the highlight for the frame \a elapsedMs milliseconds after it started.
+
+  Returns \c false if the highlight can no longer be shown.
+ */
+bool PointHighlighter::updateHighlight(qint64 elapsedMs)
+{
+  if (!m_highlightSymbol || !m_highlightOverlay || !m_highlightGraphic)
+    return false;
+
+  if (m_pointChanged)
   {
-    disconnect(m_timerConnection);
-    m_highlightTimer->stop();
-    delete m_highlightTimer;
-    m_highlightTimer = nullptr;
+    m_highlightGraphic->setGeometry(m_point);
+    m_pointChanged = false;
   }
+
+  // each pulse grows the symbol from 1 to s_maxDimension while fading it out
+  const double progress = static_cast<double>(elapsedMs % s_pulseDuration) / s_pulseDuration;
+  const double newDimension = 1.0 + progress * (s_maxDimension - 1.0);
+
+  m_highlightSymbol->setWidth(newDimension);
+  m_highlightSymbol->setHeight(newDimension);
+  m_highlightSymbol->setDepth(newDimension);
+  m_highlightOverlay->setOpacity(static_cast<float>(1.0 - progress));
+
+  return true;
 }
 
 /*!
@@ -173,6 +153,8 @@ void PointHighlighter::stopHighlight()
  */
 void PointHighlighter::onGeoViewChanged()
 {
+  stopHighlight();
+
   if (m_highlightOverlay)
   {
     delete m_highlightOverlay;
@@ -25,13 +25,12 @@
 
 namespace Esri {
 namespace ArcGISRuntime {
+class Graphic;
 class GraphicsOverlay;
 class SimpleMarkerSceneSymbol;
 }
 }
 
-class QTimer;
-
 namespace Dsa {
 
 class PointHighlighter : public QObject
@@ -52,11 +51,16 @@ private slots:
   void onGeoViewChanged();
 
 private:
+  bool updateHighlight(qint64 elapsedMs);
+
+  static constexpr qint64 s_pulseDuration = 1000;
+  static constexpr double s_maxDimension = 1000.0;
+
   Esri::ArcGISRuntime::GraphicsOverlay* m_highlightOverlay = nullptr;
   Esri::ArcGISRuntime::SimpleMarkerSceneSymbol* m_highlightSymbol = nullptr;
+  Esri::ArcGISRuntime::Graphic* m_highlightGraphic = nullptr;
   Esri::ArcGISRuntime::Point m_point;
-  QTimer* m_highlightTimer = nullptr;
-  QMetaObject::Connection m_timerConnection;
+  bool m_pointChanged = false;
 };
 
 } // Dsa
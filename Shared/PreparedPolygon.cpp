@@ -0,0 +1,313 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "PreparedPolygon.h"
+
+// C++ API headers
+#include "GeometryEngine.h"
+#include "ImmutablePart.h"
+#include "ImmutablePartCollection.h"
+#include "Point.h"
+#include "Polygon.h"
+
+// STL headers
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+// bounds on the number of grid cells along each side of the polygon's extent
+static constexpr int s_minimumGridSize = 8;
+static constexpr int s_maximumGridSize = 64;
+
+/*!
+  \class Dsa::PreparedPolygon
+  \inmodule Dsa
+  \brief A polygon which has been prepared for repeated point in polygon tests.
+
+  The extent of the polygon is divided into a grid of cells. Each cell which is
+  crossed by an edge of the polygon is a boundary cell, and every other cell is
+  classified once as wholly inside or wholly outside the polygon. Points which fall
+  in an inside or outside cell are resolved with a single lookup.
+
+  Points in a boundary cell are resolved with an even-odd crossing test against only
+  the edges which span the point's row of the grid, rather than every edge of the polygon.
+  Holes are handled by the even-odd rule. Points which lie exactly on an edge may be
+  reported as either inside or outside.
+
+  A prepared polygon is not modified after it is constructed, so it can be shared
+  and tested from any thread.
+ */
+
+/*!
+  \brief Constructor taking the \a polygon to prepare.
+
+  Points passed to \l contains as coordinates are expected to be in the spatial
+  reference of \a polygon.
+ */
+PreparedPolygon::PreparedPolygon(const Polygon& polygon):
+  m_spatialReference(polygon.spatialReference())
+{
+  if (polygon.isEmpty())
+    return;
+
+  std::unique_ptr<ImmutablePartCollection> parts(polygon.parts());
+  if (!parts)
+    return;
+
+  const int partCount = parts->size();
+  for (int partIndex = 0; partIndex < partCount; ++partIndex)
+  {
+    std::unique_ptr<ImmutablePart> part(parts->part(partIndex));
+    if (!part)
+      continue;
+
+    const int pointCount = part->pointCount();
+    if (pointCount < 3)
+      continue;
+
+    // each ring is implicitly closed from its last point back to its first
+    Point previous = part->point(pointCount - 1);
+    for (int pointIndex = 0; pointIndex < pointCount; ++pointIndex)
+    {
+      const Point current = part->point(pointIndex);
+
+      Edge edge;
+      edge.m_x1 = previous.x();
+      edge.m_y1 = previous.y();
+      edge.m_x2 = current.x();
+      edge.m_y2 = current.y();
+      m_edges.append(edge);
+
+      previous = current;
+    }
+  }
+
+  if (m_edges.isEmpty())
+    return;
+
+  m_xMin = m_xMax = m_edges.first().m_x1;
+  m_yMin = m_yMax = m_edges.first().m_y1;
+  for (const Edge& edge : m_edges)
+  {
+    m_xMin = std::min(m_xMin, edge.m_x1);
+    m_xMax = std::max(m_xMax, edge.m_x1);
+    m_yMin = std::min(m_yMin, edge.m_y1);
+    m_yMax = std::max(m_yMax, edge.m_y1);
+  }
+
+  // a polygon without area cannot contain any point
+  if (m_xMax <= m_xMin || m_yMax <= m_yMin)
+  {
+    m_edges.clear();
+    return;
+  }
+
+  buildGrid();
+}
+
+/*!
+  \brief Destructor.
+ */
+PreparedPolygon::~PreparedPolygon()
+{
+}
+
+/*!
+  \brief Returns whether the polygon has no area.
+ */
+bool PreparedPolygon::isEmpty() const
+{
+  return m_cells.isEmpty();
+}
+
+/*!
+  \brief Returns whether the location \a x, \a y lies within the polygon.
+
+  The coordinates must be in the spatial reference of the polygon.
+ */
+bool PreparedPolygon::contains(double x, double y) const
+{
+  if (isEmpty())
+    return false;
+
+  if (x < m_xMin || x > m_xMax || y < m_yMin || y > m_yMax)
+    return false;
+
+  switch (m_cells.at((rowOf(y) * m_gridSize) + columnOf(x)))
+  {
+  case CellState::Inside:
+    return true;
+  case CellState::Outside:
+    return false;
+  case CellState::Boundary:
+    break;
+  }
+
+  return crossingTest(x, y);
+}
+
+/*!
+  \brief Returns whether \a point lies within the polygon.
+
+  \a point is projected to the spatial reference of the polygon if required.
+ */
+bool PreparedPolygon::contains(const Point& point) const
+{
+  if (point.isEmpty() || isEmpty())
+    return false;
+
+  if (point.spatialReference() == m_spatialReference)
+    return contains(point.x(), point.y());
+
+  const Point projected = geometry_cast<Point>(GeometryEngine::project(point, m_spatialReference));
+  return contains(projected.x(), projected.y());
+}
+
+/*!
+  \brief Returns the approximate number of bytes used by the prepared polygon.
+ */
+qint64 PreparedPolygon::memoryUsage() const
+{
+  qint64 bytes = sizeof(PreparedPolygon);
+  bytes += m_edges.capacity() * static_cast<qint64>(sizeof(Edge));
+  bytes += m_cells.capacity() * static_cast<qint64>(sizeof(CellState));
+  for (const QVector<int>& rowEdges : m_rowEdges)
+    bytes += sizeof(QVector<int>) + rowEdges.capacity() * static_cast<qint64>(sizeof(int));
+
+  return bytes;
+}
+
+/*!
+  \internal
+
+  Assigns the edges to the rows of the grid they span and classifies each cell.
+ */
+void PreparedPolygon::buildGrid()
+{
+  const int edgeCount = m_edges.size();
+  m_gridSize = std::max(s_minimumGridSize, std::min(s_maximumGridSize, static_cast<int>(std::ceil(std::sqrt(edgeCount)))));
+  m_cellWidth = (m_xMax - m_xMin) / m_gridSize;
+  m_cellHeight = (m_yMax - m_yMin) / m_gridSize;
+
+  m_rowEdges.fill(QVector<int>(), m_gridSize);
+  m_cells.fill(CellState::Outside, m_gridSize * m_gridSize);
+
+  QVector<bool> isBoundary(m_gridSize * m_gridSize, false);
+
+  for (int edgeIndex = 0; edgeIndex < edgeCount; ++edgeIndex)
+  {
+    const Edge& edge = m_edges.at(edgeIndex);
+    const double edgeYMin = std::min(edge.m_y1, edge.m_y2);
+    const double edgeYMax = std::max(edge.m_y1, edge.m_y2);
+    const int firstRow = rowOf(edgeYMin);
+    const int lastRow = rowOf(edgeYMax);
+
+    for (int row = firstRow; row <= lastRow; ++row)
+    {
+      m_rowEdges[row].append(edgeIndex);
+
+      // clip the edge to the row to find the columns it crosses
+      double xLow = std::min(edge.m_x1, edge.m_x2);
+      double xHigh = std::max(edge.m_x1, edge.m_x2);
+      if (edge.m_y1 != edge.m_y2)
+      {
+        const double rowYMin = std::max(edgeYMin, m_yMin + (row * m_cellHeight));
+        const double rowYMax = std::min(edgeYMax, m_yMin + ((row + 1) * m_cellHeight));
+        const double slope = (edge.m_x2 - edge.m_x1) / (edge.m_y2 - edge.m_y1);
+        const double xAtMin = edge.m_x1 + ((rowYMin - edge.m_y1) * slope);
+        const double xAtMax = edge.m_x1 + ((rowYMax - edge.m_y1) * slope);
+        xLow = std::min(xAtMin, xAtMax);
+        xHigh = std::max(xAtMin, xAtMax);
+      }
+
+      const int lastColumn = columnOf(xHigh);
+      for (int column = columnOf(xLow); column <= lastColumn; ++column)
+        isBoundary[(row * m_gridSize) + column] = true;
+    }
+  }
+
+  // cells which no edge crosses are wholly inside or outside, so test their centres
+  for (int row = 0; row < m_gridSize; ++row)
+  {
+    const double centreY = m_yMin + ((row + 0.5) * m_cellHeight);
+    for (int column = 0; column < m_gridSize; ++column)
+    {
+      const int cell = (row * m_gridSize) + column;
+      if (isBoundary.at(cell))
+      {
+        m_cells[cell] = CellState::Boundary;
+        continue;
+      }
+
+      const double centreX = m_xMin + ((column + 0.5) * m_cellWidth);
+      m_cells[cell] = crossingTest(centreX, centreY) ? CellState::Inside : CellState::Outside;
+    }
+  }
+}
+
+/*!
+  \internal
+
+  Returns the row of the grid containing \a y.
+ */
+int PreparedPolygon::rowOf(double y) const
+{
+  return std::max(0, std::min(m_gridSize - 1, static_cast<int>((y - m_yMin) / m_cellHeight)));
+}
+
+/*!
+  \internal
+
+  Returns the column of the grid containing \a x.
+ */
+int PreparedPolygon::columnOf(double x) const
+{
+  return std::max(0, std::min(m_gridSize - 1, static_cast<int>((x - m_xMin) / m_cellWidth)));
+}
+
+/*!
+  \internal
+
+  Returns whether \a x, \a y lies within the polygon, by counting the crossings of a ray
+  cast in the positive x direction with the edges which span its row.
+ */
+bool PreparedPolygon::crossingTest(double x, double y) const
+{
+  bool inside = false;
+  for (const int edgeIndex : m_rowEdges.at(rowOf(y)))
+  {
+    const Edge& edge = m_edges.at(edgeIndex);
+
+    // the half-open test counts a vertex on the ray once and ignores horizontal edges
+    if ((edge.m_y1 > y) == (edge.m_y2 > y))
+      continue;
+
+    const double crossingX = edge.m_x1 + ((y - edge.m_y1) * (edge.m_x2 - edge.m_x1) / (edge.m_y2 - edge.m_y1));
+    if (x < crossingX)
+      inside = !inside;
+  }
+
+  return inside;
+}
+
+} // Dsa
@@ -0,0 +1,84 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef PREPAREDPOLYGON_H
+#define PREPAREDPOLYGON_H
+
+// C++ API headers
+#include "SpatialReference.h"
+
+// Qt headers
+#include <QVector>
+
+namespace Esri {
+namespace ArcGISRuntime {
+class Point;
+class Polygon;
+}
+}
+
+namespace Dsa {
+
+class PreparedPolygon
+{
+public:
+  explicit PreparedPolygon(const Esri::ArcGISRuntime::Polygon& polygon);
+  ~PreparedPolygon();
+
+  bool isEmpty() const;
+
+  bool contains(double x, double y) const;
+  bool contains(const Esri::ArcGISRuntime::Point& point) const;
+
+  qint64 memoryUsage() const;
+
+private:
+  enum class CellState : unsigned char
+  {
+    Outside = 0,
+    Inside,
+    Boundary
+  };
+
+  struct Edge
+  {
+    double m_x1 = 0.0;
+    double m_y1 = 0.0;
+    double m_x2 = 0.0;
+    double m_y2 = 0.0;
+  };
+
+  void buildGrid();
+  int rowOf(double y) const;
+  int columnOf(double x) const;
+  bool crossingTest(double x, double y) const;
+
+  Esri::ArcGISRuntime::SpatialReference m_spatialReference;
+  QVector<Edge> m_edges;
+  QVector<QVector<int>> m_rowEdges;
+  QVector<CellState> m_cells;
+  double m_xMin = 0.0;
+  double m_yMin = 0.0;
+  double m_xMax = 0.0;
+  double m_yMax = 0.0;
+  double m_cellWidth = 0.0;
+  double m_cellHeight = 0.0;
+  int m_gridSize = 0;
+};
+
+} // Dsa
+
+#endif // PREPAREDPOLYGON_H
@@ -0,0 +1,296 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "SceneContentBudget.h"
+
+// dsa app headers
+#include "MemoryBudget.h"
+
+// toolkit headers
+#include "ToolResourceProvider.h"
+
+// C++ API headers
+#include "Layer.h"
+#include "LayerListModel.h"
+
+// Qt headers
+#include <QTimer>
+
+// STL headers
+#include <algorithm>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+const QString SceneContentBudget::QUALITY_HIGH = QStringLiteral("High");
+const QString SceneContentBudget::QUALITY_MEDIUM = QStringLiteral("Medium");
+const QString SceneContentBudget::QUALITY_LOW = QStringLiteral("Low");
+
+namespace
+{
+
+constexpr int s_checkInterval = 5000;
+
+// the smallest scale at which 3D content is drawn for each level of detail, 0 meaning
+// no limit. The last level is only reached under memory pressure
+constexpr double s_maximumScales[] = {0.0, 50000.0, 20000.0, 5000.0};
+constexpr int s_lowestDetailLevel = static_cast<int>(sizeof(s_maximumScales) / sizeof(s_maximumScales[0])) - 1;
+
+// detail is only given back once the resident memory is this far below the budget,
+// so that it does not flip between levels
+constexpr double s_restoreFraction = 0.75;
+
+bool isSceneContent(Layer* layer)
+{
+  if (!layer)
+    return false;
+
+  const LayerType layerType = layer->layerType();
+  return layerType == LayerType::ArcGISSceneLayer ||
+         layerType == LayerType::IntegratedMeshLayer ||
+         layerType == LayerType::PointCloudLayer;
+}
+
+}
+
+/*!
+  \class Dsa::SceneContentBudget
+  \inmodule Dsa
+  \inherits QObject
+  \brief Limits the detail of scene layers, integrated meshes and point clouds so that
+  they do not push everything else out of memory.
+
+  The runtime holds the 3D content of these layers for everything in view, out to
+  the horizon. The budget caps how far out the content is drawn by setting the
+  minimum scale of each layer, so that far content is released:
+
+  \list
+    \li \c High - no limit beyond what each layer was authored with.
+    \li \c Medium - content is drawn at scales larger than 1:50,000.
+    \li \c Low - content is drawn at scales larger than 1:20,000.
+  \endlist
+
+  The \l quality sets the level used while memory allows. When a \l budget is set and
+  the resident memory of the app exceeds it, the detail is lowered one level at a time,
+  down to 1:5,000, and raised again once the memory has fallen well below the budget.
+  The lowest level is used at once when the \l MemoryBudget reports low memory.
+
+  Layers added to the operational layers of the scene, whether from local data or
+  from a mobile scene package, are picked up automatically.
+ */
+
+/*!
+  \brief Returns the singleton instance of the budget.
+ */
+SceneContentBudget* SceneContentBudget::instance()
+{
+  static SceneContentBudget s_instance;
+
+  return &s_instance;
+}
+
+/*!
+  \internal
+ */
+SceneContentBudget::SceneContentBudget(QObject* parent):
+  QObject(parent),
+  m_checkTimer(new QTimer(this))
+{
+  m_checkTimer->setInterval(s_checkInterval);
+  connect(m_checkTimer, &QTimer::timeout, this, &SceneContentBudget::checkMemory);
+
+  connect(MemoryBudget::instance(), &MemoryBudget::lowMemory, this, [this]()
+  {
+    setDetailLevel(s_lowestDetailLevel);
+  });
+
+  connect(ToolResourceProvider::instance(), &ToolResourceProvider::sceneChanged, this, &SceneContentBudget::connectOperationalLayers);
+  connectOperationalLayers();
+}
+
+/*!
+  \brief Destructor.
+ */
+SceneContentBudget::~SceneContentBudget()
+{
+}
+
+/*!
+  \brief Returns the names of the quality settings, from the most detailed.
+ */
+QStringList SceneContentBudget::qualities()
+{
+  return QStringList{QUALITY_HIGH, QUALITY_MEDIUM, QUALITY_LOW};
+}
+
+/*!
+  \brief Returns the quality of the 3D content while memory allows.
+ */
+QString SceneContentBudget::quality() const
+{
+  return qualities().at(m_qualityLevel);
+}
+
+/*!
+  \brief Sets the quality of the 3D content while memory allows to \a quality.
+
+  Unknown names are treated as \c High.
+ */
+void SceneContentBudget::setQuality(const QString& quality)
+{
+  m_qualityLevel = std::max(qualities().indexOf(quality), 0);
+
+  // a new quality starts afresh, and any pressure lowers it again at the next check
+  setDetailLevel(m_qualityLevel);
+}
+
+/*!
+  \brief Returns the resident memory, in bytes, above which the detail is lowered.
+
+  \c 0 means there is no budget.
+ */
+qint64 SceneContentBudget::budget() const
+{
+  return m_budget;
+}
+
+/*!
+  \brief Sets the resident memory, in bytes, above which the detail is lowered to \a budget.
+ */
+void SceneContentBudget::setBudget(qint64 budget)
+{
+  m_budget = std::max(budget, static_cast<qint64>(0));
+
+  if (m_budget > 0)
+    m_checkTimer->start();
+  else
+    m_checkTimer->stop();
+}
+
+/*!
+  \brief Returns the current level of detail, from \c 0 for the most detailed.
+ */
+int SceneContentBudget::detailLevel() const
+{
+  return m_detailLevel;
+}
+
+/*!
+  \brief Returns the smallest scale at which 3D content is currently drawn, or \c 0 for no limit.
+ */
+double SceneContentBudget::maximumScale() const
+{
+  return s_maximumScales[m_detailLevel];
+}
+
+/*!
+  \brief Limits the detail of \a layer, if it holds 3D content.
+
+  Layers added to the scene's operational layers are added automatically.
+ */
+void SceneContentBudget::addLayer(Layer* layer)
+{
+  if (!isSceneContent(layer) || m_layers.contains(layer))
+    return;
+
+  m_layers.insert(layer, layer->minScale());
+  connect(layer, &QObject::destroyed, this, [this, layer]()
+  {
+    m_layers.remove(layer);
+  });
+
+  applyDetailLevel(layer);
+}
+
+/*!
+  \internal
+ */
+void SceneContentBudget::connectOperationalLayers()
+{
+  disconnect(m_layerAddedConnection);
+
+  LayerListModel* operationalLayers = ToolResourceProvider::instance()->operationalLayers();
+  if (!operationalLayers)
+    return;
+
+  m_layerAddedConnection = connect(operationalLayers, &LayerListModel::layerAdded, this, &SceneContentBudget::addLayer);
+
+  const int layerCount = operationalLayers->rowCount();
+  for (int i = 0; i < layerCount; ++i)
+    addLayer(operationalLayers->at(i));
+}
+
+/*!
+  \internal
+
+  Lowers the detail one level while the resident memory is over the budget, and
+  raises it back towards the quality once it is well below.
+ */
+void SceneContentBudget::checkMemory()
+{
+  if (m_budget == 0 || m_layers.isEmpty())
+    return;
+
+  const qint64 resident = MemoryBudget::residentMemory();
+  if (resident < 0)
+    return;
+
+  if (resident > m_budget)
+    setDetailLevel(std::min(m_detailLevel + 1, s_lowestDetailLevel));
+  else if (resident < m_budget * s_restoreFraction && m_detailLevel > m_qualityLevel)
+    setDetailLevel(m_detailLevel - 1);
+}
+
+/*!
+  \internal
+ */
+void SceneContentBudget::setDetailLevel(int detailLevel)
+{
+  if (m_detailLevel == detailLevel)
+    return;
+
+  m_detailLevel = detailLevel;
+
+  for (auto it = m_layers.cbegin(); it != m_layers.cend(); ++it)
+    applyDetailLevel(it.key());
+
+  emit detailLevelChanged();
+}
+
+/*!
+  \internal
+
+  Sets the minimum scale of \a layer to the tighter of its authored scale and the
+  current level of detail.
+ */
+void SceneContentBudget::applyDetailLevel(Layer* layer) const
+{
+  const double authoredScale = m_layers.value(layer);
+  const double detailScale = maximumScale();
+
+  if (authoredScale <= 0.0)
+    layer->setMinScale(detailScale);
+  else if (detailScale <= 0.0)
+    layer->setMinScale(authoredScale);
+  else
+    layer->setMinScale(std::min(authoredScale, detailScale));
+}
+
+} // Dsa
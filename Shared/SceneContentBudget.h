@@ -0,0 +1,84 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef SCENECONTENTBUDGET_H
+#define SCENECONTENTBUDGET_H
+
+// Qt headers
+#include <QHash>
+#include <QObject>
+#include <QStringList>
+
+namespace Esri {
+namespace ArcGISRuntime {
+class Layer;
+}
+}
+
+class QTimer;
+
+namespace Dsa {
+
+class SceneContentBudget : public QObject
+{
+  Q_OBJECT
+
+public:
+  static const QString QUALITY_HIGH;
+  static const QString QUALITY_MEDIUM;
+  static const QString QUALITY_LOW;
+
+  static SceneContentBudget* instance();
+
+  ~SceneContentBudget();
+
+  static QStringList qualities();
+
+  QString quality() const;
+  void setQuality(const QString& quality);
+
+  qint64 budget() const;
+  void setBudget(qint64 budget);
+
+  int detailLevel() const;
+  double maximumScale() const;
+
+  void addLayer(Esri::ArcGISRuntime::Layer* layer);
+
+signals:
+  void detailLevelChanged();
+
+private:
+  explicit SceneContentBudget(QObject* parent = nullptr);
+  Q_DISABLE_COPY(SceneContentBudget)
+
+  void connectOperationalLayers();
+  void checkMemory();
+  void setDetailLevel(int detailLevel);
+  void applyDetailLevel(Esri::ArcGISRuntime::Layer* layer) const;
+
+  QTimer* m_checkTimer = nullptr;
+  QMetaObject::Connection m_layerAddedConnection;
+  // the scale authored for each layer, which is never loosened
+  QHash<Esri::ArcGISRuntime::Layer*, double> m_layers;
+  int m_qualityLevel = 0;
+  int m_detailLevel = 0;
+  qint64 m_budget = 0;
+};
+
+} // Dsa
+
+#endif // SCENECONTENTBUDGET_H
@@ -0,0 +1,569 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "SpatialIndexRegistry.h"
+
+// dsa app headers
+#include "GeoElementUtils.h"
+#include "GeometryQuadtree.h"
+#include "MessagesOverlay.h"
+
+// C++ API headers
+#include "FeatureLayer.h"
+#include "FeatureTable.h"
+#include "GeoElement.h"
+#include "Graphic.h"
+#include "GraphicListModel.h"
+#include "GraphicsOverlay.h"
+
+// Qt headers
+#include <QSet>
+
+// STL headers
+#include <algorithm>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+// the maximum depth of the quadtrees built by the registry; cells are only split
+// where the elements are dense, so this limits how finely clusters are divided
+static constexpr int s_maxLevels = 16;
+
+namespace
+{
+// polygons and polylines are indexed with an R-tree, other geometry with a quadtree
+bool isExtendedGeometryType(GeometryType geometryType)
+{
+  return geometryType == GeometryType::Polygon ||
+         geometryType == GeometryType::Polyline ||
+         geometryType == GeometryType::Envelope;
+}
+
+GeometryQuadtree::IndexType indexType(const QList<GeoElement*>& elements)
+{
+  int extendedCount = 0;
+  for (GeoElement* element : elements)
+  {
+    if (element && isExtendedGeometryType(element->geometry().geometryType()))
+      ++extendedCount;
+  }
+
+  return extendedCount * 2 > elements.size() ? GeometryQuadtree::IndexType::RTree : GeometryQuadtree::IndexType::Quadtree;
+}
+}
+
+/*!
+  \class Dsa::SpatialIndexRegistry
+  \inmodule Dsa
+  \inherits QObject
+  \brief A registry of \l GeometryQuadtree spatial indexes which are shared
+  between all users of the same \l Esri::ArcGISRuntime::GraphicsOverlay or
+  \l Esri::ArcGISRuntime::FeatureLayer.
+
+  Each index is reference counted: the first call to \l acquire for a source
+  builds the index and subsequent calls share it. The index is deleted once every
+  user has called \l release, or when the source itself is destroyed.
+
+  For a graphics overlay, the registry keeps the index up to date as graphics are
+  added to and removed from the overlay, so the cost of maintaining the index scales
+  with the number of overlays rather than the number of users. For a feature layer,
+  edits made through the \l FeatureGeometryCache are applied to the index one feature
+  at a time. The index is only re-built when the cached geometry of the layer's table
+  is invalidated.
+
+  Sources whose geometry is mostly polygons or polylines are indexed with an R-tree,
+  which suits extended geometries, and all other sources with a quadtree. For a feature
+  layer this is decided by the geometry type of its table, and for a graphics overlay by
+  its graphics when the index is first built. Message feed overlays, whose graphics move
+  constantly, always use a quadtree.
+ */
+
+/*!
+  \brief Returns the singleton instance of the registry.
+ */
+SpatialIndexRegistry* SpatialIndexRegistry::instance()
+{
+  static SpatialIndexRegistry s_instance;
+
+  return &s_instance;
+}
+
+/*!
+  \internal
+ */
+SpatialIndexRegistry::SpatialIndexRegistry(QObject* parent):
+  QObject(parent)
+{
+}
+
+/*!
+  \brief Destructor.
+ */
+SpatialIndexRegistry::~SpatialIndexRegistry()
+{
+  const auto sources = m_entries.keys();
+  for (QObject* source : sources)
+    removeEntry(source);
+}
+
+/*!
+  \brief Returns the shared spatial index for \a graphicsOverlay, building it if required.
+
+  The reference count for the index is incremented. Call \l release when
+  the index is no longer needed.
+ */
+GeometryQuadtree* SpatialIndexRegistry::acquire(GraphicsOverlay* graphicsOverlay)
+{
+  if (!graphicsOverlay)
+    return nullptr;
+
+  auto findIt = m_entries.find(graphicsOverlay);
+  if (findIt != m_entries.end())
+  {
+    findIt.value().m_referenceCount++;
+    return findIt.value().m_index;
+  }
+
+  Entry entry;
+  entry.m_referenceCount = 1;
+  const QList<GeoElement*> elements = graphicsOverlayElements(graphicsOverlay, entry.m_graphics);
+  const GeometryQuadtree::IndexType type = MessagesOverlay::fromGraphicsOverlay(graphicsOverlay) ? GeometryQuadtree::IndexType::Quadtree
+                                                                                                  : indexType(elements);
+  entry.m_index = new GeometryQuadtree(graphicsOverlay->extent(), elements, s_maxLevels, type, this);
+  m_entries.insert(graphicsOverlay, entry);
+
+  connectGraphicsOverlay(graphicsOverlay);
+
+  return entry.m_index;
+}
+
+/*!
+  \brief Returns the shared spatial index for \a featureLayer, building it from \a geometries if required.
+
+  \a geometries should be the geometry of every feature in the layer, from the
+  \l FeatureGeometryCache. If an index already exists for \a featureLayer, it is
+  shared and \a geometries are ignored. Edits to single features are applied to the
+  index as they complete, and the index is re-built if the cached geometry of the
+  layer's feature table is invalidated.
+
+  The reference count for the index is incremented. Call \l release when
+  the index is no longer needed.
+ */
+GeometryQuadtree* SpatialIndexRegistry::acquire(FeatureLayer* featureLayer, const QList<Geometry>& geometries)
+{
+  if (!featureLayer)
+    return nullptr;
+
+  auto findIt = m_entries.find(featureLayer);
+  if (findIt != m_entries.end())
+  {
+    findIt.value().m_referenceCount++;
+    return findIt.value().m_index;
+  }
+
+  Entry entry;
+  entry.m_referenceCount = 1;
+  FeatureTable* featureTable = featureLayer->featureTable();
+  const QList<GeoElement*> elements = featureLayerElements(geometries, FeatureGeometryCache::instance()->featureIds(featureTable),
+                                                           entry.m_featureGraphics);
+  const GeometryQuadtree::IndexType type = featureTable && isExtendedGeometryType(featureTable->geometryType()) ? GeometryQuadtree::IndexType::RTree
+                                                                                                               : GeometryQuadtree::IndexType::Quadtree;
+  entry.m_index = new GeometryQuadtree(featureLayer->fullExtent(), elements, s_maxLevels, type, this);
+
+  // the graphics are deleted along with the index
+  GeoElementUtils::setParent(elements, entry.m_index);
+
+  m_entries.insert(featureLayer, entry);
+
+  connectFeatureLayer(featureLayer);
+
+  return entry.m_index;
+}
+
+/*!
+  \brief Releases a reference to the spatial index for \a source.
+
+  The index is deleted when the last reference is released.
+ */
+void SpatialIndexRegistry::release(QObject* source)
+{
+  auto findIt = m_entries.find(source);
+  if (findIt == m_entries.end())
+    return;
+
+  if (--findIt.value().m_referenceCount > 0)
+    return;
+
+  removeEntry(source);
+}
+
+/*!
+  \brief Returns the spatial index for \a source, or \c nullptr if there is none.
+
+  The reference count of the index is not changed, so the index should not be
+  stored. This allows tools to use an existing index without keeping it alive.
+ */
+GeometryQuadtree* SpatialIndexRegistry::spatialIndex(QObject* source) const
+{
+  const auto findIt = m_entries.constFind(source);
+  return findIt != m_entries.constEnd() ? findIt.value().m_index : nullptr;
+}
+
+/*!
+  \brief Returns the number of references held to the spatial index for \a source.
+ */
+int SpatialIndexRegistry::referenceCount(QObject* source) const
+{
+  const auto findIt = m_entries.constFind(source);
+  return findIt != m_entries.constEnd() ? findIt.value().m_referenceCount : 0;
+}
+
+/*!
+  \internal
+
+  Keeps the index for \a graphicsOverlay up to date as graphics are added and removed.
+ */
+void SpatialIndexRegistry::connectGraphicsOverlay(GraphicsOverlay* graphicsOverlay)
+{
+  Entry& entry = m_entries[graphicsOverlay];
+
+  // a message feed is indexed a block of graphics at a time
+  MessagesOverlay* messagesOverlay = MessagesOverlay::fromGraphicsOverlay(graphicsOverlay);
+  if (messagesOverlay)
+  {
+    entry.m_connections.append(connect(messagesOverlay, &MessagesOverlay::graphicsAdded, this,
+                                       [this, graphicsOverlay](int index, int count)
+    {
+      auto findIt = m_entries.find(graphicsOverlay);
+      if (findIt == m_entries.end())
+        return;
+
+      QList<GeoElement*> newElements;
+      newElements.reserve(count);
+      for (int i = index; i < index + count; ++i)
+      {
+        Graphic* graphic = graphicsOverlay->graphics()->at(i);
+        findIt.value().m_graphics.insert(i, graphic);
+        if (graphic)
+          newElements.append(graphic);
+      }
+
+      findIt.value().m_index->appendGeoElements(newElements);
+    }));
+
+    // a message feed reports its removed graphics as a block
+    entry.m_connections.append(connect(messagesOverlay, &MessagesOverlay::graphicsRemoved, this,
+                                       [this, graphicsOverlay](const QList<Graphic*>& removedGraphics)
+    {
+      handleGraphicsRemoved(graphicsOverlay, removedGraphics);
+    }));
+  }
+  else
+  {
+    // respond to graphics being added to the overlay
+    entry.m_connections.append(connect(graphicsOverlay->graphics(), &GraphicListModel::graphicAdded, this,
+                                       [this, graphicsOverlay](int index)
+    {
+      auto findIt = m_entries.find(graphicsOverlay);
+      if (findIt == m_entries.end())
+        return;
+
+      Graphic* graphic = graphicsOverlay->graphics()->at(index);
+      findIt.value().m_graphics.insert(index, graphic);
+      findIt.value().m_index->appendGeoElment(graphic);
+    }));
+
+    // respond to graphics being removed from the overlay
+    entry.m_connections.append(connect(graphicsOverlay->graphics(), &GraphicListModel::graphicRemoved, this,
+                                       [this, graphicsOverlay](int index)
+    {
+      handleGraphicRemoved(graphicsOverlay, index);
+    }));
+  }
+
+  entry.m_connections.append(connect(graphicsOverlay, &GraphicsOverlay::destroyed, this, [this, graphicsOverlay]()
+  {
+    removeEntry(graphicsOverlay);
+  }));
+}
+
+/*!
+  \internal
+
+  Removes the graphic at \a index of \a graphicsOverlay from its index.
+
+  A record of the graphics in the overlay is kept so that the removed graphic
+  can be found. If that record is out of step with the overlay, the index
+  is re-built.
+ */
+void SpatialIndexRegistry::handleGraphicRemoved(GraphicsOverlay* graphicsOverlay, int index)
+{
+  auto findIt = m_entries.find(graphicsOverlay);
+  if (findIt == m_entries.end())
+    return;
+
+  Entry& entry = findIt.value();
+  const GraphicListModel* graphics = graphicsOverlay->graphics();
+  if (!graphics || index < 0 || index >= entry.m_graphics.size() ||
+      entry.m_graphics.size() != graphics->rowCount() + 1)
+  {
+    rebuildGraphicsOverlayIndex(graphicsOverlay);
+    return;
+  }
+
+  Graphic* graphic = entry.m_graphics.takeAt(index);
+  if (graphic)
+    entry.m_index->removeGeoElement(graphic);
+}
+
+/*!
+  \internal
+
+  Removes the block of \a removedGraphics of \a graphicsOverlay from its index, so that
+  the index changes once for the whole block. Only the removed elements are taken out
+  of the index, which is not re-built.
+ */
+void SpatialIndexRegistry::handleGraphicsRemoved(GraphicsOverlay* graphicsOverlay, const QList<Graphic*>& removedGraphics)
+{
+  auto findIt = m_entries.find(graphicsOverlay);
+  if (findIt == m_entries.end() || removedGraphics.isEmpty())
+    return;
+
+  Entry& entry = findIt.value();
+
+  const QSet<Graphic*> removedSet(removedGraphics.cbegin(), removedGraphics.cend());
+  entry.m_graphics.erase(std::remove_if(entry.m_graphics.begin(), entry.m_graphics.end(), [&removedSet](Graphic* graphic)
+  {
+    return removedSet.contains(graphic);
+  }), entry.m_graphics.end());
+
+  QList<GeoElement*> removedElements;
+  removedElements.reserve(removedGraphics.size());
+  for (Graphic* graphic : removedGraphics)
+    removedElements.append(graphic);
+
+  entry.m_index->removeGeoElements(removedElements);
+}
+
+/*!
+  \internal
+
+  Re-builds the index for all of the graphics in \a graphicsOverlay.
+ */
+void SpatialIndexRegistry::rebuildGraphicsOverlayIndex(GraphicsOverlay* graphicsOverlay)
+{
+  auto findIt = m_entries.find(graphicsOverlay);
+  if (findIt == m_entries.end())
+    return;
+
+  Entry& entry = findIt.value();
+  const QList<GeoElement*> elements = graphicsOverlayElements(graphicsOverlay, entry.m_graphics);
+  entry.m_index->reset(graphicsOverlay->extent(), elements);
+}
+
+/*!
+  \internal
+
+  Keeps the index for \a featureLayer up to date as the features of its table are edited.
+ */
+void SpatialIndexRegistry::connectFeatureLayer(FeatureLayer* featureLayer)
+{
+  Entry& entry = m_entries[featureLayer];
+
+  entry.m_connections.append(connect(FeatureGeometryCache::instance(), &FeatureGeometryCache::featureEdited, this,
+                                     [this, featureLayer](FeatureTable* featureTable, FeatureGeometryCache::EditType editType,
+                                                          qint64 featureId, const Geometry& geometry)
+  {
+    if (featureLayer->featureTable() == featureTable)
+      handleFeatureEdited(featureLayer, editType, featureId, geometry);
+  }));
+
+  entry.m_connections.append(connect(FeatureGeometryCache::instance(), &FeatureGeometryCache::invalidated, this,
+                                     [this, featureLayer](FeatureTable* featureTable)
+  {
+    if (featureLayer->featureTable() == featureTable)
+      rebuildFeatureLayerIndex(featureLayer);
+  }));
+
+  entry.m_connections.append(connect(featureLayer, &FeatureLayer::destroyed, this, [this, featureLayer]()
+  {
+    removeEntry(featureLayer);
+  }));
+}
+
+/*!
+  \internal
+
+  Applies the edit of the feature \a featureId in the table of \a featureLayer to its index.
+  An added feature becomes a new element, an updated feature's element is given the new
+  \a geometry and a deleted feature's element is removed. The index is only re-built if
+  the edited feature cannot be found.
+ */
+void SpatialIndexRegistry::handleFeatureEdited(FeatureLayer* featureLayer, FeatureGeometryCache::EditType editType,
+                                               qint64 featureId, const Geometry& geometry)
+{
+  auto findIt = m_entries.find(featureLayer);
+  if (findIt == m_entries.end())
+    return;
+
+  Entry& entry = findIt.value();
+  Graphic* graphic = entry.m_featureGraphics.value(featureId, nullptr);
+  if (!graphic && editType != FeatureGeometryCache::EditType::Added && entry.m_featureGraphics.isEmpty())
+  {
+    // the index was built without the IDs of its features
+    rebuildFeatureLayerIndex(featureLayer);
+    return;
+  }
+
+  if (editType == FeatureGeometryCache::EditType::Deleted || geometry.isEmpty())
+  {
+    if (!graphic)
+      return;
+
+    entry.m_featureGraphics.remove(featureId);
+    entry.m_index->removeGeoElement(graphic);
+    delete graphic;
+    return;
+  }
+
+  // the index responds to the change of geometry by moving the element
+  if (graphic)
+  {
+    graphic->setGeometry(geometry);
+    return;
+  }
+
+  graphic = new Graphic(geometry, entry.m_index);
+  entry.m_featureGraphics.insert(featureId, graphic);
+  entry.m_index->appendGeoElment(graphic);
+}
+
+/*!
+  \internal
+
+  Re-builds the index for \a featureLayer from the geometry of its feature table.
+ */
+void SpatialIndexRegistry::rebuildFeatureLayerIndex(FeatureLayer* featureLayer)
+{
+  if (!m_entries.contains(featureLayer))
+    return;
+
+  FeatureTable* featureTable = featureLayer->featureTable();
+  FeatureGeometryCache::instance()->requestGeometries(featureTable, this, [this, featureLayer, featureTable](const QList<Geometry>& geometries)
+  {
+    auto findIt = m_entries.find(featureLayer);
+    if (findIt == m_entries.end())
+      return;
+
+    Entry& entry = findIt.value();
+    GeometryQuadtree* index = entry.m_index;
+    const QList<GeoElement*> elements = featureLayerElements(geometries, FeatureGeometryCache::instance()->featureIds(featureTable),
+                                                             entry.m_featureGraphics);
+
+    // the previous graphics are deleted once the index no longer refers to them
+    const QList<Graphic*> previousGraphics = index->findChildren<Graphic*>(QString(), Qt::FindDirectChildrenOnly);
+    index->reset(featureLayer->fullExtent(), elements);
+    qDeleteAll(previousGraphics);
+
+    GeoElementUtils::setParent(elements, index);
+  });
+}
+
+/*!
+  \internal
+
+  Returns a new graphic for each of \a geometries, recording the graphic for each
+  of the \a featureIds, which are in the same order, in \a featureGraphics. No
+  graphics are recorded if \a featureIds does not match \a geometries.
+ */
+QList<GeoElement*> SpatialIndexRegistry::featureLayerElements(const QList<Geometry>& geometries, const QList<qint64>& featureIds,
+                                                              QHash<qint64, Graphic*>& featureGraphics) const
+{
+  featureGraphics.clear();
+  const bool hasFeatureIds = featureIds.size() == geometries.size();
+
+  QList<GeoElement*> elements;
+  elements.reserve(geometries.size());
+  for (int i = 0; i < geometries.size(); ++i)
+  {
+    const Geometry& geometry = geometries.at(i);
+    if (geometry.isEmpty())
+      continue;
+
+    Graphic* graphic = new Graphic(geometry);
+    elements.append(graphic);
+    if (hasFeatureIds && featureIds.at(i) >= 0)
+      featureGraphics.insert(featureIds.at(i), graphic);
+  }
+
+  return elements;
+}
+
+/*!
+  \internal
+
+  Returns the graphics in \a graphicsOverlay as GeoElements and records
+  the graphics, in overlay order, in \a graphics.
+ */
+QList<GeoElement*> SpatialIndexRegistry::graphicsOverlayElements(GraphicsOverlay* graphicsOverlay,
+                                                                 QList<Graphic*>& graphics) const
+{
+  graphics.clear();
+
+  QList<GeoElement*> elements;
+  GraphicListModel* graphicListModel = graphicsOverlay->graphics();
+  if (!graphicListModel)
+    return elements;
+
+  const int count = graphicListModel->rowCount();
+  graphics.reserve(count);
+  elements.reserve(count);
+  for (int i = 0; i < count; ++i)
+  {
+    Graphic* graphic = graphicListModel->at(i);
+    graphics.append(graphic);
+    if (graphic)
+      elements.append(graphic);
+  }
+
+  return elements;
+}
+
+/*!
+  \internal
+
+  Disconnects from \a source and deletes its index.
+ */
+void SpatialIndexRegistry::removeEntry(QObject* source)
+{
+  auto findIt = m_entries.find(source);
+  if (findIt == m_entries.end())
+    return;
+
+  Entry entry = findIt.value();
+  m_entries.erase(findIt);
+
+  for (const auto& connection : entry.m_connections)
+    disconnect(connection);
+
+  delete entry.m_index;
+}
+
+} // Dsa
@@ -0,0 +1,94 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef SPATIALINDEXREGISTRY_H
+#define SPATIALINDEXREGISTRY_H
+
+// dsa app headers
+#include "FeatureGeometryCache.h"
+
+// Qt headers
+#include <QHash>
+#include <QList>
+#include <QObject>
+
+namespace Esri {
+namespace ArcGISRuntime {
+class FeatureLayer;
+class FeatureTable;
+class GeoElement;
+class Geometry;
+class Graphic;
+class GraphicsOverlay;
+}
+}
+
+namespace Dsa {
+
+class GeometryQuadtree;
+
+class SpatialIndexRegistry : public QObject
+{
+  Q_OBJECT
+
+public:
+  static SpatialIndexRegistry* instance();
+
+  ~SpatialIndexRegistry();
+
+  GeometryQuadtree* acquire(Esri::ArcGISRuntime::GraphicsOverlay* graphicsOverlay);
+  GeometryQuadtree* acquire(Esri::ArcGISRuntime::FeatureLayer* featureLayer,
+                            const QList<Esri::ArcGISRuntime::Geometry>& geometries);
+  void release(QObject* source);
+
+  GeometryQuadtree* spatialIndex(QObject* source) const;
+  int referenceCount(QObject* source) const;
+
+private:
+  explicit SpatialIndexRegistry(QObject* parent = nullptr);
+  Q_DISABLE_COPY(SpatialIndexRegistry)
+
+  struct Entry
+  {
+    GeometryQuadtree* m_index = nullptr;
+    int m_referenceCount = 0;
+    QList<Esri::ArcGISRuntime::Graphic*> m_graphics;
+    QHash<qint64, Esri::ArcGISRuntime::Graphic*> m_featureGraphics;
+    QList<QMetaObject::Connection> m_connections;
+  };
+
+  void connectGraphicsOverlay(Esri::ArcGISRuntime::GraphicsOverlay* graphicsOverlay);
+  void handleGraphicRemoved(Esri::ArcGISRuntime::GraphicsOverlay* graphicsOverlay, int index);
+  void handleGraphicsRemoved(Esri::ArcGISRuntime::GraphicsOverlay* graphicsOverlay,
+                             const QList<Esri::ArcGISRuntime::Graphic*>& removedGraphics);
+  void rebuildGraphicsOverlayIndex(Esri::ArcGISRuntime::GraphicsOverlay* graphicsOverlay);
+  void connectFeatureLayer(Esri::ArcGISRuntime::FeatureLayer* featureLayer);
+  void handleFeatureEdited(Esri::ArcGISRuntime::FeatureLayer* featureLayer, FeatureGeometryCache::EditType editType,
+                           qint64 featureId, const Esri::ArcGISRuntime::Geometry& geometry);
+  void rebuildFeatureLayerIndex(Esri::ArcGISRuntime::FeatureLayer* featureLayer);
+  QList<Esri::ArcGISRuntime::GeoElement*> featureLayerElements(const QList<Esri::ArcGISRuntime::Geometry>& geometries,
+                                                               const QList<qint64>& featureIds,
+                                                               QHash<qint64, Esri::ArcGISRuntime::Graphic*>& featureGraphics) const;
+  QList<Esri::ArcGISRuntime::GeoElement*> graphicsOverlayElements(Esri::ArcGISRuntime::GraphicsOverlay* graphicsOverlay,
+                                                                  QList<Esri::ArcGISRuntime::Graphic*>& graphics) const;
+  void removeEntry(QObject* source);
+
+  QHash<QObject*, Entry> m_entries;
+};
+
+} // Dsa
+
+#endif // SPATIALINDEXREGISTRY_H
@@ -0,0 +1,359 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "StallWatchdog.h"
+
+// Qt headers
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QThread>
+#include <QTimer>
+
+namespace Dsa {
+
+namespace {
+// the interval, in ms, at which the UI thread shows it is responsive
+constexpr int s_heartbeatInterval = 100;
+
+// the most recent stalls kept in memory
+constexpr int s_maximumStalls = 50;
+
+// the log is rolled over to a single backup once it reaches this size, in bytes
+constexpr qint64 s_maximumLogSize = 256 * 1024;
+}
+
+/*!
+  \class Dsa::StallWatchdog
+  \inmodule Dsa
+  \inherits QObject
+  \brief Detects when the UI thread stops processing events for longer than
+  \l threshold and records where it was busy.
+
+  A timer on the UI thread beats every 100 ms, while a separate watch thread checks
+  that the beats keep coming. When they stop, the watch thread takes a snapshot of
+  the \c DSA_TRACE_SCOPE sections being executed on the UI thread, such as
+  \c MessagesOverlay::addMessages or \c AlertConditionData::handleDataChanged. Once
+  the UI thread recovers, the stall is recorded with its duration and sections:
+  in \l stalls, in the trace of the \l TraceRecorder if it is enabled, and in the
+  file at \l logPath so that it can be collected from the field.
+
+  A stall inside code without a trace section is recorded with the innermost
+  enclosing section, or with none.
+ */
+
+/*!
+  \brief Returns the singleton instance of the watchdog, which must first be used
+  on the UI thread.
+ */
+StallWatchdog* StallWatchdog::instance()
+{
+  static StallWatchdog s_instance;
+  return &s_instance;
+}
+
+/*!
+  \internal
+ */
+StallWatchdog::StallWatchdog(QObject* parent) :
+  QObject(parent),
+  m_heartbeatTimer(new QTimer(this))
+{
+  m_clock.start();
+  m_heartbeatTimer->setInterval(s_heartbeatInterval);
+  connect(m_heartbeatTimer, &QTimer::timeout, this, &StallWatchdog::beat);
+
+  TraceRecorder::watchCurrentThread(&m_sections);
+}
+
+/*!
+  \brief Destructor.
+ */
+StallWatchdog::~StallWatchdog()
+{
+  stop();
+  TraceRecorder::watchCurrentThread(nullptr);
+}
+
+/*!
+  \property StallWatchdog::threshold
+  \brief Returns the time, in milliseconds, for which the UI thread can be busy
+  before it is treated as stalled.
+
+  \c 0 means stalls are not detected, which is the default.
+ */
+int StallWatchdog::threshold() const
+{
+  return m_threshold.load(std::memory_order_relaxed);
+}
+
+/*!
+  \brief Sets the \a threshold, in milliseconds, beyond which the UI thread is
+  treated as stalled. \c 0 stops detecting stalls.
+ */
+void StallWatchdog::setThreshold(int threshold)
+{
+  threshold = qMax(threshold, 0);
+  if (threshold == this->threshold())
+    return;
+
+  m_threshold.store(threshold, std::memory_order_relaxed);
+  if (threshold > 0)
+    start();
+  else
+    stop();
+
+  emit thresholdChanged();
+}
+
+/*!
+  \brief Returns the path of the file which stalls are appended to.
+
+  An empty path, the default, means stalls are only kept in memory.
+ */
+QString StallWatchdog::logPath() const
+{
+  return m_logPath;
+}
+
+/*!
+  \brief Sets the path of the file which stalls are appended to to \a logPath.
+ */
+void StallWatchdog::setLogPath(const QString& logPath)
+{
+  m_logPath = logPath;
+}
+
+/*!
+  \property StallWatchdog::stallCount
+  \brief Returns the number of stalls detected since the app started.
+ */
+qint64 StallWatchdog::stallCount() const
+{
+  return m_stallCount;
+}
+
+/*!
+  \property StallWatchdog::stalls
+  \brief Returns the most recent stalls, oldest first.
+
+  Each stall is a map of its \c time, its \c duration in milliseconds and the
+  \c sections being executed, outermost first.
+ */
+QVariantList StallWatchdog::stalls() const
+{
+  QVariantList stalls;
+  for (const Stall& stall : m_stalls)
+  {
+    stalls.append(QVariantMap{{QStringLiteral("time"), stall.m_time},
+                              {QStringLiteral("duration"), stall.m_duration},
+                              {QStringLiteral("sections"), stall.m_sections}});
+  }
+
+  return stalls;
+}
+
+/*!
+  \brief Returns a single line summary of the stalls, suitable for logging.
+ */
+QString StallWatchdog::summary() const
+{
+  qint64 longest = 0;
+  for (const Stall& stall : m_stalls)
+    longest = qMax(longest, stall.m_duration);
+
+  return QString("%1 stalls over %2 ms, longest recent %3 ms%4")
+      .arg(QString::number(m_stallCount),
+           QString::number(threshold()),
+           QString::number(longest),
+           m_stalls.isEmpty() ? QString() : QStringLiteral(", last in ") + m_stalls.constLast().m_sections.join(QStringLiteral(" > ")));
+}
+
+/*!
+  \internal
+ */
+void StallWatchdog::start()
+{
+  if (m_watchThread)
+    return;
+
+  {
+    QMutexLocker locker(&m_mutex);
+    m_stopping = false;
+  }
+
+  m_lastBeat.store(m_clock.elapsed(), std::memory_order_relaxed);
+  m_heartbeatTimer->start();
+
+  m_watchThread = QThread::create([this]() { watch(); });
+  m_watchThread->setObjectName(QStringLiteral("StallWatchdog"));
+  m_watchThread->start(QThread::HighPriority);
+}
+
+/*!
+  \internal
+ */
+void StallWatchdog::stop()
+{
+  m_heartbeatTimer->stop();
+  if (!m_watchThread)
+    return;
+
+  {
+    QMutexLocker locker(&m_mutex);
+    m_stopping = true;
+    m_stopCondition.wakeAll();
+  }
+
+  m_watchThread->wait();
+  delete m_watchThread;
+  m_watchThread = nullptr;
+}
+
+/*!
+  \internal
+  \brief Marks the UI thread as responsive, and records a stall if the previous
+  beat was too long ago.
+ */
+void StallWatchdog::beat()
+{
+  const qint64 now = m_clock.elapsed();
+  const qint64 stalled = now - m_lastBeat.load(std::memory_order_relaxed) - s_heartbeatInterval;
+  const quint64 beat = m_beatCount.load(std::memory_order_relaxed);
+
+  m_lastBeat.store(now, std::memory_order_relaxed);
+  m_beatCount.store(beat + 1, std::memory_order_release);
+
+  if (stalled < threshold())
+    return;
+
+  QStringList sections;
+  {
+    QMutexLocker locker(&m_mutex);
+    if (m_capturedBeat == beat + 1)
+      sections = m_capturedSections;
+  }
+
+  recordStall(stalled, sections);
+}
+
+/*!
+  \internal
+  \brief Runs on the watch thread, taking a snapshot of the sections being
+  executed when the UI thread misses its beats.
+ */
+void StallWatchdog::watch()
+{
+  QMutexLocker locker(&m_mutex);
+  while (!m_stopping)
+  {
+    // check several times within the threshold so the snapshot is taken well inside the stall
+    const int threshold = this->threshold();
+    m_stopCondition.wait(&m_mutex, static_cast<unsigned long>(qBound(10, threshold / 4, s_heartbeatInterval)));
+    if (m_stopping)
+      break;
+
+    const quint64 beat = m_beatCount.load(std::memory_order_acquire);
+    const qint64 sinceBeat = m_clock.elapsed() - m_lastBeat.load(std::memory_order_relaxed);
+
+    // the captured beat is offset by one so that 0 means none has been captured
+    if (sinceBeat - s_heartbeatInterval >= threshold && m_capturedBeat != beat + 1)
+    {
+      m_capturedBeat = beat + 1;
+      m_capturedSections = m_sections.sections();
+    }
+  }
+}
+
+/*!
+  \internal
+ */
+void StallWatchdog::recordStall(qint64 duration, const QStringList& sections)
+{
+  Stall stall;
+  stall.m_time = QDateTime::currentDateTime().addMSecs(-duration);
+  stall.m_duration = duration;
+  stall.m_sections = sections;
+
+  ++m_stallCount;
+  if (m_stalls.size() >= s_maximumStalls)
+    m_stalls.removeFirst();
+  m_stalls.append(stall);
+
+  TraceRecorder* recorder = TraceRecorder::instance();
+  recorder->record("StallWatchdog::stall", recorder->timestamp() - duration * 1000, duration * 1000);
+
+  const QString section = sections.join(QStringLiteral(" > "));
+  qWarning() << "UI thread stalled for" << duration << "ms in" << (section.isEmpty() ? QStringLiteral("unknown") : section);
+
+  appendToLog(stall);
+
+  emit stallDetected(duration, section);
+  emit stallsChanged();
+}
+
+/*!
+  \internal
+ */
+void StallWatchdog::appendToLog(const Stall& stall)
+{
+  if (m_logPath.isEmpty())
+    return;
+
+  const QFileInfo logInfo(m_logPath);
+  if (logInfo.size() >= s_maximumLogSize)
+  {
+    const QString backupPath = m_logPath + QStringLiteral(".1");
+    QFile::remove(backupPath);
+    QFile::rename(m_logPath, backupPath);
+  }
+  else if (!logInfo.exists())
+  {
+    QDir().mkpath(logInfo.absolutePath());
+  }
+
+  QFile log(m_logPath);
+  if (!log.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text))
+    return;
+
+  const QString line = QString("%1\t%2 ms\t%3\n").arg(stall.m_time.toString(Qt::ISODateWithMs),
+                                                      QString::number(stall.m_duration),
+                                                      stall.m_sections.join(QStringLiteral(" > ")));
+  log.write(line.toUtf8());
+}
+
+} // Dsa
+
+// Signal Documentation
+/*!
+  \fn void StallWatchdog::thresholdChanged();
+  \brief Signal emitted when the \l threshold changes.
+ */
+
+/*!
+  \fn void StallWatchdog::stallsChanged();
+  \brief Signal emitted when a stall has been added to \l stalls.
+ */
+
+/*!
+  \fn void StallWatchdog::stallDetected(qint64 duration, const QString& section);
+  \brief Signal emitted when the UI thread has recovered from a stall lasting
+  \a duration milliseconds, in the trace \a section.
+ */
@@ -0,0 +1,109 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef STALLWATCHDOG_H
+#define STALLWATCHDOG_H
+
+// dsa app headers
+#include "TraceRecorder.h"
+
+// Qt headers
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QObject>
+#include <QVariantList>
+#include <QVector>
+#include <QWaitCondition>
+
+// STL headers
+#include <atomic>
+
+class QThread;
+class QTimer;
+
+namespace Dsa {
+
+class StallWatchdog : public QObject
+{
+  Q_OBJECT
+
+  Q_PROPERTY(int threshold READ threshold WRITE setThreshold NOTIFY thresholdChanged)
+  Q_PROPERTY(qint64 stallCount READ stallCount NOTIFY stallsChanged)
+  Q_PROPERTY(QVariantList stalls READ stalls NOTIFY stallsChanged)
+
+public:
+  static StallWatchdog* instance();
+  ~StallWatchdog();
+
+  int threshold() const;
+  void setThreshold(int threshold);
+
+  QString logPath() const;
+  void setLogPath(const QString& logPath);
+
+  qint64 stallCount() const;
+  QVariantList stalls() const;
+
+  Q_INVOKABLE QString summary() const;
+
+signals:
+  void thresholdChanged();
+  void stallsChanged();
+  void stallDetected(qint64 duration, const QString& section);
+
+private:
+  explicit StallWatchdog(QObject* parent = nullptr);
+  Q_DISABLE_COPY(StallWatchdog)
+
+  struct Stall
+  {
+    QDateTime m_time;
+    qint64 m_duration = 0; // in msecs
+    QStringList m_sections;
+  };
+
+  void start();
+  void stop();
+  void beat();
+  void watch();
+  void recordStall(qint64 duration, const QStringList& sections);
+  void appendToLog(const Stall& stall);
+
+  QTimer* m_heartbeatTimer = nullptr;
+  QThread* m_watchThread = nullptr;
+  QElapsedTimer m_clock;
+  TraceRecorder::SectionStack m_sections;
+
+  std::atomic<int> m_threshold{0};
+  std::atomic<qint64> m_lastBeat{0};
+  std::atomic<quint64> m_beatCount{0};
+
+  // guards the stop flag and the sections captured by the watch thread
+  mutable QMutex m_mutex;
+  QWaitCondition m_stopCondition;
+  bool m_stopping = false;
+  quint64 m_capturedBeat = 0;
+  QStringList m_capturedSections;
+
+  QString m_logPath;
+  qint64 m_stallCount = 0;
+  QVector<Stall> m_stalls;
+};
+
+} // Dsa
+
+#endif // STALLWATCHDOG_H
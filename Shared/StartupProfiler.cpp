@@ -0,0 +1,197 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "StartupProfiler.h"
+
+// Qt headers
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+
+// STL headers
+#include <algorithm>
+
+namespace Dsa {
+
+/*!
+  \class Dsa::StartupProfiler
+  \inmodule Dsa
+  \brief Records the time taken by each phase of the app's startup.
+
+  Times are measured in microseconds from the first use of the profiler. The
+  recorded phases can be written with \l writeTrace in the Chrome trace event
+  format, which can be opened in \c chrome://tracing or Perfetto, or compared
+  between builds to catch regressions in cold-start time.
+ */
+
+/*!
+  \class Dsa::StartupProfiler::Phase
+  \inmodule Dsa
+  \brief Records the enclosing scope as a startup phase.
+ */
+
+/*!
+  \brief Starts the phase called \a name.
+ */
+StartupProfiler::Phase::Phase(const QString& name):
+  m_name(name)
+{
+  StartupProfiler::instance()->beginPhase(m_name);
+}
+
+/*!
+  \brief Ends the phase.
+ */
+StartupProfiler::Phase::~Phase()
+{
+  StartupProfiler::instance()->endPhase(m_name);
+}
+
+/*!
+  \brief Returns the singleton instance of the profiler.
+ */
+StartupProfiler* StartupProfiler::instance()
+{
+  static StartupProfiler s_instance;
+  return &s_instance;
+}
+
+/*!
+  \internal
+ */
+StartupProfiler::StartupProfiler()
+{
+  m_timer.start();
+}
+
+/*!
+  \brief Records the start of the phase called \a name.
+ */
+void StartupProfiler::beginPhase(const QString& name)
+{
+  Event event;
+  event.m_name = name;
+  event.m_start = elapsed();
+
+  m_openPhases.insert(name, m_events.size());
+  m_events.append(event);
+}
+
+/*!
+  \brief Records the end of the phase called \a name.
+ */
+void StartupProfiler::endPhase(const QString& name)
+{
+  const auto findIt = m_openPhases.find(name);
+  if (findIt == m_openPhases.end())
+    return;
+
+  Event& event = m_events[findIt.value()];
+  event.m_duration = elapsed() - event.m_start;
+  m_openPhases.erase(findIt);
+}
+
+/*!
+  \brief Records an instant event called \a name, such as the app becoming interactive.
+ */
+void StartupProfiler::mark(const QString& name)
+{
+  Event event;
+  event.m_name = name;
+  event.m_start = elapsed();
+  m_events.append(event);
+}
+
+/*!
+  \brief Returns the time in microseconds since the profiler was first used.
+ */
+qint64 StartupProfiler::elapsed() const
+{
+  return m_timer.nsecsElapsed() / 1000;
+}
+
+/*!
+  \brief Returns the total time in microseconds spent in the phases called \a name
+  which have ended, or \c -1 if there are none.
+ */
+qint64 StartupProfiler::phaseDuration(const QString& name) const
+{
+  qint64 duration = -1;
+  for (const Event& event : m_events)
+  {
+    if (event.m_name == name && event.m_duration >= 0)
+      duration = std::max(duration, qint64(0)) + event.m_duration;
+  }
+
+  return duration;
+}
+
+/*!
+  \brief Writes the recorded events to \a tracePath in the Chrome trace event format.
+
+  Returns \c false if the trace could not be written.
+ */
+bool StartupProfiler::writeTrace(const QString& tracePath) const
+{
+  if (tracePath.isEmpty())
+    return false;
+
+  QJsonArray traceEvents;
+  for (const Event& event : m_events)
+  {
+    QJsonObject traceEvent;
+    traceEvent.insert(QStringLiteral("name"), event.m_name);
+    traceEvent.insert(QStringLiteral("cat"), QStringLiteral("startup"));
+    traceEvent.insert(QStringLiteral("ts"), static_cast<double>(event.m_start));
+    traceEvent.insert(QStringLiteral("pid"), 1);
+    traceEvent.insert(QStringLiteral("tid"), 1);
+
+    // phases which have not ended are written as instant events
+    if (event.m_duration >= 0)
+    {
+      traceEvent.insert(QStringLiteral("ph"), QStringLiteral("X"));
+      traceEvent.insert(QStringLiteral("dur"), static_cast<double>(event.m_duration));
+    }
+    else
+    {
+      traceEvent.insert(QStringLiteral("ph"), QStringLiteral("i"));
+      traceEvent.insert(QStringLiteral("s"), QStringLiteral("g"));
+    }
+
+    traceEvents.append(traceEvent);
+  }
+
+  QJsonObject trace;
+  trace.insert(QStringLiteral("traceEvents"), traceEvents);
+  trace.insert(QStringLiteral("displayTimeUnit"), QStringLiteral("ms"));
+
+  QDir().mkpath(QFileInfo(tracePath).absolutePath());
+
+  QSaveFile traceFile(tracePath);
+  if (!traceFile.open(QIODevice::WriteOnly))
+    return false;
+
+  traceFile.write(QJsonDocument(trace).toJson());
+  return traceFile.commit();
+}
+
+} // Dsa
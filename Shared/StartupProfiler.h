@@ -0,0 +1,72 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef STARTUPPROFILER_H
+#define STARTUPPROFILER_H
+
+// Qt headers
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QString>
+
+namespace Dsa {
+
+class StartupProfiler
+{
+public:
+  // Times the enclosing scope as a phase
+  class Phase
+  {
+  public:
+    explicit Phase(const QString& name);
+    ~Phase();
+
+  private:
+    Q_DISABLE_COPY(Phase)
+
+    QString m_name;
+  };
+
+  static StartupProfiler* instance();
+
+  void beginPhase(const QString& name);
+  void endPhase(const QString& name);
+  void mark(const QString& name);
+
+  qint64 elapsed() const;
+  qint64 phaseDuration(const QString& name) const;
+  bool writeTrace(const QString& tracePath) const;
+
+private:
+  StartupProfiler();
+  Q_DISABLE_COPY(StartupProfiler)
+
+  struct Event
+  {
+    QString m_name;
+    qint64 m_start = 0;
+    qint64 m_duration = -1;
+  };
+
+  QElapsedTimer m_timer;
+  QList<Event> m_events;
+  QHash<QString, int> m_openPhases;
+};
+
+} // Dsa
+
+#endif // STARTUPPROFILER_H
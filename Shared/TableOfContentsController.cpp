@@ -38,6 +38,8 @@
 
 // Qt headers
 #include <QFileInfo>
+#include <QTimer>
+#include <QVector>
 
 using namespace Esri::ArcGISRuntime;
 
@@ -49,6 +51,16 @@ namespace Dsa {
   \inherits AbstractTool
   \brief Tool controller for managing the table of contents for operational layers.
 
+  Layers are moved in the list model straight away. The 3D view does not follow
+  the new order for \c FeatureCollectionLayer layers, such as markups. These
+  layers are removed and re-inserted in one pass once control returns to the
+  event loop, so several moves in a row cost a single refresh. Only layers whose
+  position relative to the other layers has changed are re-inserted.
+
+  The alternate name and geometry type shown for each layer are found once and
+  cached. The cache entry for a layer is dropped when it finishes loading, its
+  row in the list changes, or it is added to or removed from the list.
+
   \sa Esri::ArcGISRuntime::LayerListModel
  */
 
@@ -56,8 +68,13 @@ namespace Dsa {
   \brief Constructor taking an optional \a parent.
  */
 TableOfContentsController::TableOfContentsController(QObject* parent /* = nullptr */):
-  AbstractTool(parent)
+  AbstractTool(parent),
+  m_refreshOrderTimer(new QTimer(this))
 {
+  m_refreshOrderTimer->setSingleShot(true);
+  m_refreshOrderTimer->setInterval(0);
+  connect(m_refreshOrderTimer, &QTimer::timeout, this, &TableOfContentsController::refreshLayerOrder);
+
   connect(ToolResourceProvider::instance(), &ToolResourceProvider::mapChanged,
           this, &TableOfContentsController::updateLayerListModel);
   connect(ToolResourceProvider::instance(), &ToolResourceProvider::sceneChanged,
@@ -141,9 +158,8 @@ void TableOfContentsController::moveDown(int layerIndex)
   if (modelIndex <= 0)
     return;
 
+  scheduleLayerOrderRefresh();
   m_layerListModel->move(modelIndex, modelIndex - 1);
-
-  refreshLayerOrder();
 }
 
 /*!
@@ -159,9 +175,8 @@ void TableOfContentsController::moveUp(int layerIndex)
   if (modelIndex >= m_layerListModel->rowCount())
     return;
 
+  scheduleLayerOrderRefresh();
   m_layerListModel->move(modelIndex, modelIndex + 1);
-
-  refreshLayerOrder();
 }
 
 /*!
@@ -178,9 +193,8 @@ void TableOfContentsController::moveFromTo(int fromIndex, int toIndex)
   if (modelFromIndex == -1 || modelToIndex == -1)
     return;
 
+  scheduleLayerOrderRefresh();
   m_layerListModel->move(modelFromIndex, modelToIndex);
-
-  refreshLayerOrder();
 }
 
 /*!
@@ -188,34 +202,11 @@ void TableOfContentsController::moveFromTo(int fromIndex, int toIndex)
  */
 QString TableOfContentsController::alternateName(int layerIndex)
 {
-  const QString unknownName("????");
-  if (!m_layerListModel)
-    return QString(unknownName);
-
-  const int modelIndex = mappedIndex(layerIndex);
-
-  if (modelIndex >= m_layerListModel->rowCount())
-    return QString(unknownName);
-
-  Layer* layer = m_layerListModel->at(modelIndex);
+  Layer* layer = layerAt(layerIndex);
   if (!layer)
-    return QString(unknownName);
+    return QStringLiteral("????");
 
-  QString layerName = layer->name();
-  if (!layerName.isEmpty())
-    return layerName;
-
-  RasterLayer* rasterLayer = qobject_cast<RasterLayer*>(layer);
-  if (!rasterLayer)
-    return QString(unknownName);
-
-  Raster* raster = rasterLayer->raster();
-  if (!raster || raster->path().isEmpty())
-    return QString(unknownName);
-
-  QFileInfo rasterFile(raster->path());
-
-  return rasterFile.baseName();
+  return layerMetadata(layer).alternateName;
 }
 
 /*!
@@ -223,17 +214,43 @@ QString TableOfContentsController::alternateName(int layerIndex)
  */
 TableOfContentsController::LayerGeometryType TableOfContentsController::layerGeometryType(int layerIndex)
 {
-  if (!m_layerListModel)
+  Layer* layer = layerAt(layerIndex);
+  if (!layer)
     return LayerGeometryType::Unknown;
 
+  return layerMetadata(layer).geometryType;
+}
+
+/*!
+  \internal
+
+  Returns the layer at \a layerIndex in the list, or \c nullptr if there is none.
+ */
+Layer* TableOfContentsController::layerAt(int layerIndex) const
+{
+  if (!m_layerListModel)
+    return nullptr;
+
   const int modelIndex = mappedIndex(layerIndex);
+  if (modelIndex < 0 || modelIndex >= m_layerListModel->rowCount())
+    return nullptr;
 
-  if (modelIndex >= m_layerListModel->rowCount())
-    return LayerGeometryType::Unknown;
+  return m_layerListModel->at(modelIndex);
+}
 
-  Layer* layer = m_layerListModel->at(modelIndex);
-  if (!layer)
-    return LayerGeometryType::Unknown;
+/*!
+  \internal
+
+  Returns the cached metadata for \a layer, finding it first if needed.
+
+  A layer which has not finished loading is watched, so that its metadata is
+  found again once it has.
+ */
+const TableOfContentsController::LayerMetadata& TableOfContentsController::layerMetadata(Layer* layer)
+{
+  auto it = m_layerMetadata.find(layer);
+  if (it != m_layerMetadata.end())
+    return it.value();
 
   if (layer->loadStatus() != LoadStatus::Loaded && layer->loadStatus() != LoadStatus::FailedToLoad)
   {
@@ -242,6 +259,7 @@ TableOfContentsController::LayerGeometryType TableOfContentsController::layerGeo
       m_layerConnections.insert(layer, connect(layer, &Layer::doneLoading, this, [this, layer](const Error& loadError)
       {
         m_layerConnections.remove(layer);
+        m_layerMetadata.remove(layer);
 
         if (!loadError.isEmpty())
           emit errorOccurred(loadError);
@@ -251,6 +269,45 @@ TableOfContentsController::LayerGeometryType TableOfContentsController::layerGeo
     }
   }
 
+  LayerMetadata metadata;
+  metadata.alternateName = findAlternateName(layer);
+  metadata.geometryType = findGeometryType(layer);
+  return m_layerMetadata.insert(layer, metadata).value();
+}
+
+/*!
+  \internal
+
+  Returns the name of \a layer, or the name of the file of a raster layer without a name.
+ */
+QString TableOfContentsController::findAlternateName(Layer* layer)
+{
+  const QString unknownName("????");
+
+  QString layerName = layer->name();
+  if (!layerName.isEmpty())
+    return layerName;
+
+  RasterLayer* rasterLayer = qobject_cast<RasterLayer*>(layer);
+  if (!rasterLayer)
+    return QString(unknownName);
+
+  Raster* raster = rasterLayer->raster();
+  if (!raster || raster->path().isEmpty())
+    return QString(unknownName);
+
+  QFileInfo rasterFile(raster->path());
+
+  return rasterFile.baseName();
+}
+
+/*!
+  \internal
+
+  Returns the geometry type shown for \a layer.
+ */
+TableOfContentsController::LayerGeometryType TableOfContentsController::findGeometryType(Layer* layer)
+{
   switch (layer->layerType())
   {
   case LayerType::FeatureLayer:
@@ -296,6 +353,21 @@ TableOfContentsController::LayerGeometryType TableOfContentsController::layerGeo
   }
 }
 
+/*!
+  \internal
+
+  Drops the cached metadata of the layers from \a first to \a last in the
+  operational layers, such as when a layer is renamed, added or removed.
+ */
+void TableOfContentsController::invalidateLayerMetadata(int first, int last)
+{
+  if (!m_layerListModel)
+    return;
+
+  for (int i = first; i <= last; ++i)
+    m_layerMetadata.remove(m_layerListModel->at(i));
+}
+
 /*!
   \brief Return the name of the tool - \c "table of contents".
  */
@@ -314,6 +386,37 @@ void TableOfContentsController::updateLayerListModel()
     return;
 
   m_layerListModel = operationalLayers;
+
+  // pending moves belong to the previous list of layers
+  m_refreshOrderTimer->stop();
+  m_committedLayerOrder.clear();
+
+  for (const auto& connection : qAsConst(m_layerListConnections))
+    disconnect(connection);
+  m_layerListConnections.clear();
+  m_layerMetadata.clear();
+
+  if (m_layerListModel)
+  {
+    m_layerListConnections.append(connect(m_layerListModel, &QAbstractItemModel::dataChanged, this,
+                                          [this](const QModelIndex& topLeft, const QModelIndex& bottomRight)
+    {
+      invalidateLayerMetadata(topLeft.row(), bottomRight.row());
+    }));
+
+    // layers are only cached while they are in the list, so that a new layer never finds a stale entry
+    m_layerListConnections.append(connect(m_layerListModel, &QAbstractItemModel::rowsInserted, this,
+                                          [this](const QModelIndex&, int first, int last)
+    {
+      invalidateLayerMetadata(first, last);
+    }));
+    m_layerListConnections.append(connect(m_layerListModel, &QAbstractItemModel::rowsAboutToBeRemoved, this,
+                                          [this](const QModelIndex&, int first, int last)
+    {
+      invalidateLayerMetadata(first, last);
+    }));
+  }
+
   if (m_drawOrderModel)
   {
     delete m_drawOrderModel;
@@ -337,25 +440,86 @@ int TableOfContentsController::mappedIndex(int index) const
   if (!m_layerListModel || !m_drawOrderModel)
     return -1;
 
-  const QModelIndex sourceIndex = m_drawOrderModel->mapToSource(m_drawOrderModel->index(index, 0));
-  return sourceIndex.row();
+  return m_drawOrderModel->sourceRow(index);
 }
 
 /*!
   \internal
+  Records the layer order before the first of a batch of moves and schedules
+  the draw order to be refreshed once the batch is complete.
+ */
+void TableOfContentsController::scheduleLayerOrderRefresh()
+{
+  if (m_refreshOrderTimer->isActive())
+    return;
+
+  m_committedLayerOrder.clear();
+  const int layerCount = m_layerListModel->rowCount();
+  m_committedLayerOrder.reserve(layerCount);
+  for (int i = 0; i < layerCount; ++i)
+    m_committedLayerOrder.append(m_layerListModel->at(i));
+
+  m_refreshOrderTimer->start();
+}
+
+/*!
+  \internal
+  Re-inserts the \c FeatureCollectionLayer layers whose position relative to the
+  other layers has changed since the order was recorded.
  */
 void TableOfContentsController::refreshLayerOrder()
 {
+  if (!m_layerListModel)
+    return;
+
+  QList<Layer*> currentLayerOrder;
+  const int layerCount = m_layerListModel->rowCount();
+  currentLayerOrder.reserve(layerCount);
+  for (int i = 0; i < layerCount; ++i)
+    currentLayerOrder.append(m_layerListModel->at(i));
+
+  const QList<Layer*> committedLayerOrder = m_committedLayerOrder;
+  m_committedLayerOrder.clear();
+
+  // if layers were added or removed during the batch, every layer is treated as moved
+  const bool sameLayers = committedLayerOrder.size() == layerCount;
+
+  // samePrefix[i] is true when the first i layers are the same set in both orders,
+  // found by counting layers which are in one prefix but not yet in the other
+  QVector<bool> samePrefix(layerCount + 1, false);
+  samePrefix[0] = true;
+  if (sameLayers)
+  {
+    QHash<Layer*, int> prefixBalance;
+    int unmatchedLayers = 0;
+    for (int i = 0; i < layerCount; ++i)
+    {
+      int& currentBalance = prefixBalance[currentLayerOrder.at(i)];
+      unmatchedLayers += (currentBalance == 0) ? 1 : (currentBalance == -1 ? -1 : 0);
+      ++currentBalance;
+
+      int& committedBalance = prefixBalance[committedLayerOrder.at(i)];
+      unmatchedLayers += (committedBalance == 0) ? 1 : (committedBalance == 1 ? -1 : 0);
+      --committedBalance;
+
+      samePrefix[i + 1] = unmatchedLayers == 0;
+    }
+  }
+
   // To avoid a re-ordering issue which affects FeatureCollectionLayers in 3D view
   // these types of layers are removed and re-added at the desired index
-  const int layerCount = m_layerListModel->rowCount();
   for (int i = 0; i < layerCount; ++i)
   {
-    Layer* layer = m_layerListModel->at(i);
+    Layer* layer = currentLayerOrder.at(i);
     FeatureCollectionLayer* featCollectionLyr = qobject_cast<FeatureCollectionLayer*>(layer);
     if (!featCollectionLyr)
       continue;
 
+    // a layer keeps its place relative to every other layer when it has the same
+    // index and the same set of layers beneath it
+    if (sameLayers && committedLayerOrder.at(i) == layer && samePrefix.at(i))
+      continue;
+
     m_layerListModel->removeAt(i);
     m_layerListModel->insert(i, layer);
   }
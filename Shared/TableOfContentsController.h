@@ -23,6 +23,7 @@
 // Qt headers
 #include <QAbstractItemModel>
 #include <QHash>
+#include <QList>
 
 namespace Esri {
 namespace ArcGISRuntime {
@@ -31,6 +32,8 @@ namespace ArcGISRuntime {
 }
 }
 
+class QTimer;
+
 namespace Dsa {
 
 class DrawOrderLayerListModel;
@@ -79,12 +82,28 @@ public slots:
   void updateLayerListModel();
 
 private:
+  struct LayerMetadata
+  {
+    QString alternateName;
+    LayerGeometryType geometryType = LayerGeometryType::Unknown;
+  };
+
   int mappedIndex(int index) const;
+  Esri::ArcGISRuntime::Layer* layerAt(int layerIndex) const;
+  const LayerMetadata& layerMetadata(Esri::ArcGISRuntime::Layer* layer);
+  static QString findAlternateName(Esri::ArcGISRuntime::Layer* layer);
+  static LayerGeometryType findGeometryType(Esri::ArcGISRuntime::Layer* layer);
+  void invalidateLayerMetadata(int first, int last);
+  void scheduleLayerOrderRefresh();
   void refreshLayerOrder();
 
   Esri::ArcGISRuntime::LayerListModel* m_layerListModel = nullptr;
   QHash<Esri::ArcGISRuntime::Layer*, QMetaObject::Connection> m_layerConnections;
+  QHash<Esri::ArcGISRuntime::Layer*, LayerMetadata> m_layerMetadata;
+  QList<QMetaObject::Connection> m_layerListConnections;
   DrawOrderLayerListModel* m_drawOrderModel = nullptr;
+  QTimer* m_refreshOrderTimer = nullptr;
+  QList<Esri::ArcGISRuntime::Layer*> m_committedLayerOrder;
 };
 
 } // Dsa
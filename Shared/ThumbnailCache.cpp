@@ -0,0 +1,178 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "ThumbnailCache.h"
+
+// Qt headers
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QImage>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThreadPool>
+
+namespace Dsa {
+
+/*!
+  \class Dsa::ThumbnailCache
+  \inmodule Dsa
+  \inherits QObject
+  \brief A disk cache of downscaled thumbnails for local data, such as tile caches
+  and mobile scene packages.
+
+  Each thumbnail is stored as a PNG no larger than \c s_maxThumbnailSize pixels,
+  named from the path, size and modification time of its source file and an optional
+  key (for sources with more than one thumbnail). A thumbnail is therefore replaced
+  automatically when its source changes, and on later runs of the app it is
+  available without loading the source at all.
+
+  Images are scaled and written on a background thread, and \l thumbnailReady is
+  emitted once the file can be used.
+ */
+
+/*!
+  \brief Returns the singleton instance of the cache.
+ */
+ThumbnailCache* ThumbnailCache::instance()
+{
+  static ThumbnailCache s_instance;
+
+  return &s_instance;
+}
+
+/*!
+  \internal
+ */
+ThumbnailCache::ThumbnailCache(QObject* parent):
+  QObject(parent),
+  m_cacheDirectory(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/thumbnails"),
+  m_threadPool(new QThreadPool(this))
+{
+  // thumbnails are written one at a time so that they do not compete with the app for cores
+  m_threadPool->setMaxThreadCount(1);
+}
+
+/*!
+  \brief Destructor.
+ */
+ThumbnailCache::~ThumbnailCache()
+{
+  m_threadPool->clear();
+  m_threadPool->waitForDone();
+}
+
+/*!
+  \brief Returns the path of the cached thumbnail for \a sourcePath and \a key, or an
+  empty string if there is no thumbnail for the current version of the source.
+ */
+QString ThumbnailCache::cachedThumbnailPath(const QString& sourcePath, const QString& key) const
+{
+  const QString path = thumbnailPath(sourcePath, key);
+  if (path.isEmpty() || m_pendingPaths.contains(path) || !QFileInfo::exists(path))
+    return QString();
+
+  return path;
+}
+
+/*!
+  \brief Scales \a image and stores it as the thumbnail for \a sourcePath and \a key.
+
+  \l thumbnailReady is emitted when the thumbnail has been written.
+ */
+void ThumbnailCache::storeThumbnail(const QString& sourcePath, const QString& key, const QImage& image)
+{
+  const QString path = thumbnailPath(sourcePath, key);
+  if (path.isEmpty() || image.isNull() || m_pendingPaths.contains(path))
+    return;
+
+  m_pendingPaths.insert(path);
+
+  const QString cacheDirectory = m_cacheDirectory;
+  m_threadPool->start([this, sourcePath, key, image, path, cacheDirectory]()
+  {
+    QImage thumbnail = image;
+    if (thumbnail.width() > s_maxThumbnailSize || thumbnail.height() > s_maxThumbnailSize)
+      thumbnail = thumbnail.scaled(s_maxThumbnailSize, s_maxThumbnailSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+
+    bool written = false;
+    if (QDir().mkpath(cacheDirectory))
+    {
+      QSaveFile file(path);
+      written = file.open(QIODevice::WriteOnly) && thumbnail.save(&file, "PNG") && file.commit();
+    }
+
+    QMetaObject::invokeMethod(this, [this, sourcePath, key, path, written]()
+    {
+      m_pendingPaths.remove(path);
+      if (written)
+        emit thumbnailReady(sourcePath, key, path);
+    }, Qt::QueuedConnection);
+  });
+}
+
+/*!
+  \brief Returns the directory where thumbnails are stored.
+
+  By default, this is the \c thumbnails folder in the app's cache location.
+ */
+QString ThumbnailCache::cacheDirectory() const
+{
+  return m_cacheDirectory;
+}
+
+/*!
+  \brief Sets the directory where thumbnails are stored to \a cacheDirectory.
+ */
+void ThumbnailCache::setCacheDirectory(const QString& cacheDirectory)
+{
+  m_cacheDirectory = cacheDirectory;
+}
+
+/*!
+  \internal
+
+  Returns the file the thumbnail for the current version of \a sourcePath and
+  \a key is stored in, or an empty string if \a sourcePath does not exist.
+ */
+QString ThumbnailCache::thumbnailPath(const QString& sourcePath, const QString& key) const
+{
+  const QFileInfo sourceInfo(sourcePath);
+  if (!sourceInfo.exists())
+    return QString();
+
+  // an unpacked package is a directory, so its modification time is used on its own
+  const QString version = QString("%1|%2|%3|%4").arg(sourceInfo.absoluteFilePath(),
+                                                     key,
+                                                     QString::number(sourceInfo.isDir() ? 0 : sourceInfo.size()),
+                                                     QString::number(sourceInfo.lastModified().toMSecsSinceEpoch()));
+
+  const QByteArray hash = QCryptographicHash::hash(version.toUtf8(), QCryptographicHash::Sha1).toHex();
+  return QString("%1/%2.png").arg(m_cacheDirectory, QString::fromLatin1(hash));
+}
+
+} // Dsa
+
+// Signal Documentation
+/*!
+  \fn void ThumbnailCache::thumbnailReady(const QString& sourcePath, const QString& key, const QString& thumbnailPath);
+  \brief Signal emitted when the thumbnail for \a sourcePath and \a key has been
+  written to \a thumbnailPath.
+ */
@@ -0,0 +1,63 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef THUMBNAILCACHE_H
+#define THUMBNAILCACHE_H
+
+// Qt headers
+#include <QObject>
+#include <QSet>
+#include <QString>
+
+class QImage;
+class QThreadPool;
+
+namespace Dsa {
+
+class ThumbnailCache : public QObject
+{
+  Q_OBJECT
+
+public:
+  static ThumbnailCache* instance();
+
+  ~ThumbnailCache();
+
+  QString cachedThumbnailPath(const QString& sourcePath, const QString& key = QString()) const;
+  void storeThumbnail(const QString& sourcePath, const QString& key, const QImage& image);
+
+  QString cacheDirectory() const;
+  void setCacheDirectory(const QString& cacheDirectory);
+
+  static constexpr int s_maxThumbnailSize = 256;
+
+signals:
+  void thumbnailReady(const QString& sourcePath, const QString& key, const QString& thumbnailPath);
+
+private:
+  explicit ThumbnailCache(QObject* parent = nullptr);
+  Q_DISABLE_COPY(ThumbnailCache)
+
+  QString thumbnailPath(const QString& sourcePath, const QString& key) const;
+
+  QString m_cacheDirectory;
+  QThreadPool* m_threadPool = nullptr;
+  QSet<QString> m_pendingPaths;
+};
+
+} // Dsa
+
+#endif // THUMBNAILCACHE_H
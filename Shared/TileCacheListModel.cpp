@@ -19,18 +19,27 @@
 
 #include "TileCacheListModel.h"
 
+// dsa app headers
+#include "ThumbnailCache.h"
+
 // C++ API headers
 #include "TileCache.h"
 
 // Qt headers
 #include <QFileInfo>
-#include <QTemporaryFile>
+#include <QTimer>
 #include <QUrl>
 
 using namespace Esri::ArcGISRuntime;
 
 namespace Dsa {
 
+namespace
+{
+// shown until the thumbnail of a tile cache is ready
+const QUrl s_placeholderThumbnailUrl(QStringLiteral("qrc:/Resources/AppIcon.png"));
+}
+
 /*!
   \class Dsa::TileCacheListModel
   \inmodule Dsa
@@ -58,6 +67,10 @@ namespace Dsa {
         \li QUrl
         \li The URL to the thumbnail of the tile cache.
   \endtable
+
+  Thumbnails are taken from the \l ThumbnailCache when possible. Otherwise the
+  tile caches are loaded in the background, a few at a time, and their thumbnails
+  are added to the cache; a placeholder URL is returned until then.
  */
 
 /*!
@@ -69,6 +82,13 @@ TileCacheListModel::TileCacheListModel(QObject* parent):
   m_roles[TileCacheTitleRole] = "title";
   m_roles[TileCachePathRole] = "path";
   m_roles[TileCacheThumbnaulUrlRole] = "thumbnailUrl";
+
+  connect(ThumbnailCache::instance(), &ThumbnailCache::thumbnailReady, this,
+          [this](const QString& sourcePath, const QString& key, const QString& thumbnailPath)
+  {
+    if (key.isEmpty())
+      handleThumbnailReady(sourcePath, thumbnailPath);
+  });
 }
 
 /*!
@@ -101,35 +121,21 @@ bool TileCacheListModel::append(const QString& pathToTileCache)
 
   connect(tileCache, &TileCache::loadStatusChanged, this, [this, tileCache](LoadStatus loadStatus)
   {
-    if (loadStatus != LoadStatus::Loaded)
-      return;
-
-    QImage image = tileCache->thumbnail();
-    if (image.isNull())
-      return;
-
-    QTemporaryFile* tempImgFile = new QTemporaryFile("TileCacheXXXXXX.png", tileCache);
-    if (!tempImgFile->open())
-      return;
-
-    if (!image.save(tempImgFile->fileName()))
-      return;
-
-    m_thumbnailUrls.insert(tileCache->path(), QUrl::fromLocalFile(tempImgFile->fileName()));
-
-    for (int i = 0; i < m_tileCacheData.size(); ++i)
-    {
-      const TileCache* testCache = m_tileCacheData.at(i);
-      if (!testCache || testCache->path() != tileCache->path())
-        continue;
-
-      QModelIndex index = createIndex(i, 0);
-      emit dataChanged(index, index);
-
-      break;
-    }
+    if (loadStatus == LoadStatus::Loaded || loadStatus == LoadStatus::FailedToLoad)
+      handleTileCacheLoaded(tileCache);
   });
 
+  // use the thumbnail from an earlier run if the tile cache has not changed since
+  const QString thumbnailPath = ThumbnailCache::instance()->cachedThumbnailPath(pathToTileCache);
+  if (!thumbnailPath.isEmpty())
+  {
+    m_thumbnailUrls.insert(pathToTileCache, QUrl::fromLocalFile(thumbnailPath));
+  }
+  else
+  {
+    m_pendingThumbnails.append(tileCache);
+    QTimer::singleShot(0, this, &TileCacheListModel::startThumbnailLoads);
+  }
 
   beginInsertRows(QModelIndex(), size, size);
   m_tileCacheData.append(tileCache);
@@ -185,12 +191,7 @@ QVariant TileCacheListModel::data(const QModelIndex& index, int role) const
     return tileCache->path();
     break;
   case TileCacheThumbnaulUrlRole:
-  {
-    if (tileCache->loadStatus() == LoadStatus::NotLoaded)
-      tileCache->load();
-
-    return m_thumbnailUrls.value(tileCache->path(), QUrl());
-  }
+    return m_thumbnailUrls.value(tileCache->path(), s_placeholderThumbnailUrl);
   default:
     break;
   }
@@ -227,7 +228,74 @@ void TileCacheListModel::clear()
   beginResetModel();
   m_thumbnailUrls.clear();
   m_tileCacheData.clear();
+  m_pendingThumbnails.clear();
+  m_loadingThumbnails.clear();
   endResetModel();
 }
 
+/*!
+  \internal
+
+  Loads the next tile caches which are waiting for a thumbnail, keeping no more
+  than \c s_maxThumbnailLoads loading at once.
+ */
+void TileCacheListModel::startThumbnailLoads()
+{
+  while (!m_pendingThumbnails.isEmpty() && m_loadingThumbnails.size() < s_maxThumbnailLoads)
+  {
+    TileCache* tileCache = m_pendingThumbnails.takeFirst();
+    if (!m_tileCacheData.contains(tileCache))
+      continue;
+
+    if (tileCache->loadStatus() == LoadStatus::Loaded)
+    {
+      handleTileCacheLoaded(tileCache);
+      continue;
+    }
+
+    m_loadingThumbnails.insert(tileCache);
+    if (tileCache->loadStatus() != LoadStatus::Loading)
+      tileCache->load();
+  }
+}
+
+/*!
+  \internal
+
+  Passes the thumbnail of the loaded \a tileCache to the \l ThumbnailCache to be
+  scaled and stored, then continues with the next tile cache.
+ */
+void TileCacheListModel::handleTileCacheLoaded(TileCache* tileCache)
+{
+  m_loadingThumbnails.remove(tileCache);
+
+  if (tileCache->loadStatus() == LoadStatus::Loaded && !m_thumbnailUrls.contains(tileCache->path()))
+    ThumbnailCache::instance()->storeThumbnail(tileCache->path(), QString(), tileCache->thumbnail());
+
+  startThumbnailLoads();
+}
+
+/*!
+  \internal
+
+  Updates the thumbnail of the tile cache at \a tileCachePath to the stored
+  file at \a thumbnailPath.
+ */
+void TileCacheListModel::handleThumbnailReady(const QString& tileCachePath, const QString& thumbnailPath)
+{
+  for (int i = 0; i < m_tileCacheData.size(); ++i)
+  {
+    const TileCache* testCache = m_tileCacheData.at(i);
+    if (!testCache || testCache->path() != tileCachePath)
+      continue;
+
+    m_thumbnailUrls.insert(tileCachePath, QUrl::fromLocalFile(thumbnailPath));
+
+    QModelIndex index = createIndex(i, 0);
+    emit dataChanged(index, index);
+
+    break;
+  }
+}
+
 } // Dsa
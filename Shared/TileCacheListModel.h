@@ -21,6 +21,7 @@
 #include <QAbstractListModel>
 #include <QList>
 #include <QMap>
+#include <QSet>
 
 namespace Esri {
 namespace ArcGISRuntime {
@@ -59,9 +60,17 @@ protected:
   QHash<int, QByteArray> roleNames() const override;
 
 private:
+  void startThumbnailLoads();
+  void handleTileCacheLoaded(Esri::ArcGISRuntime::TileCache* tileCache);
+  void handleThumbnailReady(const QString& tileCachePath, const QString& thumbnailPath);
+
+  static constexpr int s_maxThumbnailLoads = 2;
+
   QHash<int, QByteArray>                  m_roles;
   QList<Esri::ArcGISRuntime::TileCache*>  m_tileCacheData;
   QMap<QString, QUrl>                     m_thumbnailUrls;
+  QList<Esri::ArcGISRuntime::TileCache*>  m_pendingThumbnails;
+  QSet<Esri::ArcGISRuntime::TileCache*>   m_loadingThumbnails;
 };
 
 } // Dsa
@@ -65,6 +65,8 @@ void ToolManager::addTool(AbstractTool* tool)
   });
 
   m_tools.insert(tool->toolName(), tool);
+  m_toolsByName.insert(tool->toolName(), tool);
+  m_toolsByType.clear();
   emit toolAdded(tool);
 }
 
@@ -73,6 +75,8 @@ void ToolManager::addTool(AbstractTool* tool)
 void ToolManager::removeTool(const QString& toolName)
 {
   m_tools.remove(toolName);
+  m_toolsByName.remove(toolName);
+  m_toolsByType.clear();
 }
 
 /*! \brief Removes the \l AbstractTool \a tool from the manager.
@@ -88,8 +92,11 @@ void ToolManager::removeTool(AbstractTool* tool)
   {
     if (it.value() == tool)
     {
-      emit toolRemoved(it.key());
+      const QString toolName = it.key();
       m_tools.erase(it);
+      m_toolsByName.remove(toolName);
+      m_toolsByType.clear();
+      emit toolRemoved(toolName);
       return;
     }
   }
@@ -100,6 +107,8 @@ void ToolManager::removeTool(AbstractTool* tool)
 void ToolManager::clearTools()
 {
   m_tools.clear();
+  m_toolsByName.clear();
+  m_toolsByType.clear();
 }
 
 /*! \brief Retrieve the \l AbsgtractTool with the name \a toolName.
@@ -108,9 +117,86 @@ void ToolManager::clearTools()
  */
 AbstractTool* ToolManager::tool(const QString& toolName) const
 {
-  return m_tools[toolName];
+  return m_toolsByName.value(toolName);
 }
 
+/*! \internal
+ *
+ * Returns the first tool which inherits \a metaObject, or \c nullptr.
+ *
+ * Lookups are cached by type, so only the first lookup for each type after
+ * a tool is added or removed searches the tools.
+ */
+AbstractTool* ToolManager::findToolByType(const QMetaObject* metaObject) const
+{
+  auto cachedIt = m_toolsByType.constFind(metaObject);
+  if (cachedIt != m_toolsByType.constEnd())
+    return cachedIt.value();
+
+  AbstractTool* foundTool = nullptr;
+  for (AbstractTool* absTool : m_tools)
+  {
+    if (absTool && absTool->metaObject()->inherits(metaObject))
+    {
+      foundTool = absTool;
+      break;
+    }
+  }
+
+  // misses are cached too, since they are common for tools which are not in use
+  m_toolsByType.insert(metaObject, foundTool);
+  return foundTool;
+}
+
+/*! \brief Registers a \a factory which creates the tool called \a toolName.
+ *
+ * The tool is not created until it is first requested with \l acquireTool,
+ * so that tools which are not needed at startup do not delay it.
+ */
+void ToolManager::registerToolFactory(const QString& toolName, ToolFactory factory)
+{
+  m_toolFactories.insert(toolName, factory);
+}
+
+/*! \brief Retrieve the \l AbstractTool with the name \a toolName, creating it
+ * with its registered factory if it does not exist yet.
+ *
+ * The created tool is added to the manager, emitting \l toolAdded.
+ * return \c nullptr if the tool cannot be found or created.
+ */
+AbstractTool* ToolManager::acquireTool(const QString& toolName)
+{
+  AbstractTool* existingTool = m_tools.value(toolName);
+  if (existingTool)
+    return existingTool;
+
+  const ToolFactory factory = m_toolFactories.value(toolName);
+  if (!factory)
+    return nullptr;
+
+  AbstractTool* createdTool = factory();
+  if (createdTool && !m_tools.contains(createdTool->toolName()))
+    addTool(createdTool);
+
+  return createdTool;
+}
+
+/*! \fn template<class T> T* ToolManager::tool() const
+ * \brief Retrieve the first \l AbstractTool of type \c T, or \c nullptr if
+ * there is none.
+ */
+
+/*! \fn template<class T> void ToolManager::registerToolFactory(const QString& toolName, ToolFactory factory)
+ * \brief Registers a \a factory which creates the tool of type \c T called \a toolName.
+ *
+ * The tool can then be created on first use with \l acquireTool by type.
+ */
+
+/*! \fn template<class T> T* ToolManager::acquireTool()
+ * \brief Retrieve the \l AbstractTool of type \c T, creating it with its
+ * registered factory if it does not exist yet.
+ */
+
 /*! \brief Returns a begin iterator to the list of tools.
  *
  */
@@ -18,7 +18,9 @@
 #define TOOL_MANAGER_H
 
 #include <QObject>
+#include <QHash>
 #include <QMap>
+#include <functional>
 #include <memory>
 
 namespace Dsa
@@ -33,6 +35,7 @@ class ToolManager : public QObject
   using ToolsList = QMap<QString, AbstractTool*>;
 
 public:
+  using ToolFactory = std::function<AbstractTool*()>;
 
   static ToolManager& instance(); // singleton
 
@@ -48,9 +51,18 @@ public:
 
   AbstractTool* tool(const QString& toolName) const;
 
+  void registerToolFactory(const QString& toolName, ToolFactory factory);
+  AbstractTool* acquireTool(const QString& toolName);
+
   template<class T>
   T* tool() const;
 
+  template<class T>
+  void registerToolFactory(const QString& toolName, ToolFactory factory);
+
+  template<class T>
+  T* acquireTool();
+
   ToolsList::iterator begin();
   ToolsList::iterator end();
 
@@ -64,26 +76,41 @@ signals:
 private:
   ToolManager();
 
+  AbstractTool* findToolByType(const QMetaObject* metaObject) const;
+
   ToolsList m_tools;
+  QHash<QString, AbstractTool*> m_toolsByName;
+  mutable QHash<const QMetaObject*, AbstractTool*> m_toolsByType;
+  QMap<QString, ToolFactory> m_toolFactories;
+  QHash<const QMetaObject*, QString> m_factoryNamesByType;
 };
 
 template<class T>
 T* ToolManager::tool() const
 {
-  auto it = begin();
-  const auto itEnd = end();
-  for (; it != itEnd; ++it)
-  {
-    AbstractTool* absTool = it.value();
-    if (!absTool)
-      continue;
-
-    T* tool = qobject_cast<T*>(absTool);
-    if (tool)
-      return tool;
-  }
-
-  return nullptr;
+  // the tool found for each type is cached until the set of tools changes
+  return static_cast<T*>(findToolByType(&T::staticMetaObject));
+}
+
+template<class T>
+void ToolManager::registerToolFactory(const QString& toolName, ToolFactory factory)
+{
+  m_factoryNamesByType.insert(&T::staticMetaObject, toolName);
+  registerToolFactory(toolName, std::move(factory));
+}
+
+template<class T>
+T* ToolManager::acquireTool()
+{
+  T* existingTool = tool<T>();
+  if (existingTool)
+    return existingTool;
+
+  const QString toolName = m_factoryNamesByType.value(&T::staticMetaObject);
+  if (toolName.isEmpty())
+    return nullptr;
+
+  return qobject_cast<T*>(acquireTool(toolName));
 }
 
 } // Toolkit
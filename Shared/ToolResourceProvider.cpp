@@ -21,16 +21,29 @@
 #include "MapView.h"
 #include "SceneView.h"
 #include "IdentifyGraphicsOverlayResult.h"
+#include "IdentifyLayerResult.h"
 
 #include "ToolResourceProvider.h"
 
+#include "GraphicsOverlaysResultsManager.h"
+#include "LayerResultsManager.h"
+
+#include <QMetaMethod>
 #include <QUuid>
 
+#include <algorithm>
+
 using namespace Esri::ArcGISRuntime;
 
 namespace Dsa
 {
 
+// identical identify requests started within this many ms of each other share one task
+static constexpr int s_identifyShareWindow = 250;
+
+// cancelled identify tasks which never complete are forgotten after this many ms
+static constexpr int s_cancelledIdentifyLifetime = 30000;
+
 ToolResourceProvider::ToolResourceProvider(QObject* parent /*= nullptr*/):
   QObject(parent)
 {
@@ -183,106 +196,195 @@ void ToolResourceProvider::setMouseCursor(const QCursor& cursor)
   emit setMouseCursorRequested(cursor);
 }
 
-void ToolResourceProvider::onMouseClicked(QMouseEvent& mouseEvent)
+/*! \brief Gives \a owner the mouse focus for the \a eventTypes, calling \a handler
+ * for each of those events until \l clearMouseFocus is called or \a owner is destroyed.
+ *
+ * Tools with the focus receive events before the mouse signals are emitted, in order
+ * of \a priority, then most recent first. A handler which returns \c true consumes the
+ * event: it is not passed to any other handler and the mouse signals are not emitted.
+ *
+ * Tools should only hold the focus while they are using the mouse, for example while
+ * sketching, so that other tools are not called for every mouse move.
+ */
+void ToolResourceProvider::setMouseFocus(QObject* owner, MouseEventTypes eventTypes, int priority, MouseEventHandler handler)
 {
-  emit mouseClicked(mouseEvent);
-
-  if (!m_geoView)
+  if (!owner || !handler)
     return;
 
-  if (m_scene)
-    emit mouseClickedPoint(static_cast<SceneView*>(m_geoView)->screenToBaseSurface(mouseEvent.x(), mouseEvent.y()));
-  else if (m_map)
-    emit mouseClickedPoint(static_cast<MapView*>(m_geoView)->screenToLocation(mouseEvent.x(), mouseEvent.y()));
-  else if (dynamic_cast<SceneView*>(m_geoView))
-    emit mouseClickedPoint(static_cast<SceneView*>(m_geoView)->screenToBaseSurface(mouseEvent.x(), mouseEvent.y()));
-  else if (dynamic_cast<MapView*>(m_geoView))
-    emit mouseClickedPoint(static_cast<MapView*>(m_geoView)->screenToLocation(mouseEvent.x(), mouseEvent.y()));
+  clearMouseFocus(owner);
+
+  MouseFocus focus;
+  focus.m_owner = owner;
+  focus.m_eventTypes = eventTypes;
+  focus.m_priority = priority;
+  focus.m_handler = std::move(handler);
+  focus.m_destroyedConnection = connect(owner, &QObject::destroyed, this, [this, owner]()
+  {
+    clearMouseFocus(owner);
+  });
+
+  auto insertIt = std::find_if(m_mouseFocus.begin(), m_mouseFocus.end(), [priority](const MouseFocus& existingFocus)
+  {
+    return existingFocus.m_priority <= priority;
+  });
+  m_mouseFocus.insert(insertIt, focus);
 }
 
-void ToolResourceProvider::onMousePressed(QMouseEvent &mouseEvent)
+/*! \brief Removes the mouse focus of \a owner, if it has it.
+ */
+void ToolResourceProvider::clearMouseFocus(QObject* owner)
 {
-  emit mousePressed(mouseEvent);
+  // an owner which is being destroyed has already been cleared from its QPointer
+  for (auto it = m_mouseFocus.begin(); it != m_mouseFocus.end();)
+  {
+    if (it->m_owner && it->m_owner.data() != owner)
+    {
+      ++it;
+      continue;
+    }
 
-  if (!m_geoView)
-    return;
+    disconnect(it->m_destroyedConnection);
+    it = m_mouseFocus.erase(it);
+  }
+}
 
-  if (m_scene)
-    emit mousePressedPoint(static_cast<SceneView*>(m_geoView)->screenToBaseSurface(mouseEvent.x(), mouseEvent.y()));
-  else if (m_map)
-    emit mousePressedPoint(static_cast<MapView*>(m_geoView)->screenToLocation(mouseEvent.x(), mouseEvent.y()));
-  else if (dynamic_cast<SceneView*>(m_geoView))
-    emit mousePressedPoint(static_cast<SceneView*>(m_geoView)->screenToBaseSurface(mouseEvent.x(), mouseEvent.y()));
-  else if (dynamic_cast<MapView*>(m_geoView))
-    emit mousePressedPoint(static_cast<MapView*>(m_geoView)->screenToLocation(mouseEvent.x(), mouseEvent.y()));
+/*! \brief Returns whether \a owner has the mouse focus.
+ */
+bool ToolResourceProvider::hasMouseFocus(QObject* owner) const
+{
+  return std::any_of(m_mouseFocus.cbegin(), m_mouseFocus.cend(), [owner](const MouseFocus& focus)
+  {
+    return focus.m_owner == owner;
+  });
 }
 
-void ToolResourceProvider::onMouseMoved(QMouseEvent &mouseEvent)
+/*! \brief Sets the \a observer which sees every mouse event, whichever tool
+ * consumes it, before the event is dispatched. Pass an empty function to remove it.
+ */
+void ToolResourceProvider::setMouseEventObserver(MouseEventObserver observer)
 {
-  emit mouseMoved(mouseEvent);
+  m_mouseEventObserver = std::move(observer);
+}
 
-  if (!m_geoView)
-    return;
+/*! \internal
+ *
+ * Passes \a mouseEvent to the tools with the focus for \a eventType, returning
+ * whether one of them consumed it.
+ */
+bool ToolResourceProvider::dispatchMouseEvent(MouseEventType eventType, QMouseEvent& mouseEvent)
+{
+  if (m_mouseEventObserver)
+    m_mouseEventObserver(eventType, mouseEvent);
+
+  if (m_mouseFocus.isEmpty())
+    return false;
 
+  // handlers may change the focus, so work on a copy
+  const QList<MouseFocus> mouseFocus = m_mouseFocus;
+  for (const MouseFocus& focus : mouseFocus)
+  {
+    if (!focus.m_owner || !focus.m_eventTypes.testFlag(eventType))
+      continue;
+
+    if (focus.m_handler(eventType, mouseEvent))
+      return true;
+  }
+
+  return false;
+}
+
+/*! \internal
+ *
+ * Returns whether anything is connected to the point \a signal, so that the
+ * screen position is only converted to a location when it is needed.
+ */
+bool ToolResourceProvider::isPointSignalConnected(void (ToolResourceProvider::*signal)(const Point&)) const
+{
+  return m_geoView && isSignalConnected(QMetaMethod::fromSignal(signal));
+}
+
+/*! \internal
+ *
+ * Returns the location in the geoView at the position of \a mouseEvent.
+ */
+Point ToolResourceProvider::screenToPoint(const QMouseEvent& mouseEvent) const
+{
   if (m_scene)
-    emit mouseMovedPoint(static_cast<SceneView*>(m_geoView)->screenToBaseSurface(mouseEvent.x(), mouseEvent.y()));
+    return static_cast<SceneView*>(m_geoView)->screenToBaseSurface(mouseEvent.x(), mouseEvent.y());
   else if (m_map)
-    emit mouseMovedPoint(static_cast<MapView*>(m_geoView)->screenToLocation(mouseEvent.x(), mouseEvent.y()));
+    return static_cast<MapView*>(m_geoView)->screenToLocation(mouseEvent.x(), mouseEvent.y());
   else if (dynamic_cast<SceneView*>(m_geoView))
-    emit mouseMovedPoint(static_cast<SceneView*>(m_geoView)->screenToBaseSurface(mouseEvent.x(), mouseEvent.y()));
+    return static_cast<SceneView*>(m_geoView)->screenToBaseSurface(mouseEvent.x(), mouseEvent.y());
   else if (dynamic_cast<MapView*>(m_geoView))
-    emit mouseMovedPoint(static_cast<MapView*>(m_geoView)->screenToLocation(mouseEvent.x(), mouseEvent.y()));
+    return static_cast<MapView*>(m_geoView)->screenToLocation(mouseEvent.x(), mouseEvent.y());
+
+  return Point();
 }
 
-void ToolResourceProvider::onMouseReleased(QMouseEvent &mouseEvent)
+void ToolResourceProvider::onMouseClicked(QMouseEvent& mouseEvent)
 {
-  emit mouseReleased(mouseEvent);
+  if (dispatchMouseEvent(MouseEventType::Clicked, mouseEvent))
+    return;
+
+  emit mouseClicked(mouseEvent);
+
+  if (isPointSignalConnected(&ToolResourceProvider::mouseClickedPoint))
+    emit mouseClickedPoint(screenToPoint(mouseEvent));
+}
 
-  if (!m_geoView)
+void ToolResourceProvider::onMousePressed(QMouseEvent& mouseEvent)
+{
+  if (dispatchMouseEvent(MouseEventType::Pressed, mouseEvent))
     return;
 
-  if (m_scene)
-    emit mouseReleasedPoint(static_cast<SceneView*>(m_geoView)->screenToBaseSurface(mouseEvent.x(), mouseEvent.y()));
-  else if (m_map)
-    emit mouseReleasedPoint(static_cast<MapView*>(m_geoView)->screenToLocation(mouseEvent.x(), mouseEvent.y()));
-  else if (dynamic_cast<SceneView*>(m_geoView))
-    emit mouseReleasedPoint(static_cast<SceneView*>(m_geoView)->screenToBaseSurface(mouseEvent.x(), mouseEvent.y()));
-  else if (dynamic_cast<MapView*>(m_geoView))
-    emit mouseReleasedPoint(static_cast<MapView*>(m_geoView)->screenToLocation(mouseEvent.x(), mouseEvent.y()));
+  emit mousePressed(mouseEvent);
+
+  if (isPointSignalConnected(&ToolResourceProvider::mousePressedPoint))
+    emit mousePressedPoint(screenToPoint(mouseEvent));
 }
 
-void ToolResourceProvider::onMousePressedAndHeld(QMouseEvent &mouseEvent)
+void ToolResourceProvider::onMouseMoved(QMouseEvent& mouseEvent)
 {
-  emit mousePressedAndHeld(mouseEvent);
+  if (dispatchMouseEvent(MouseEventType::Moved, mouseEvent))
+    return;
+
+  emit mouseMoved(mouseEvent);
 
-  if (!m_geoView)
+  if (isPointSignalConnected(&ToolResourceProvider::mouseMovedPoint))
+    emit mouseMovedPoint(screenToPoint(mouseEvent));
+}
+
+void ToolResourceProvider::onMouseReleased(QMouseEvent& mouseEvent)
+{
+  if (dispatchMouseEvent(MouseEventType::Released, mouseEvent))
     return;
 
-  if (m_scene)
-    emit mousePressedAndHeldPoint(static_cast<SceneView*>(m_geoView)->screenToBaseSurface(mouseEvent.x(), mouseEvent.y()));
-  else if (m_map)
-    emit mousePressedAndHeldPoint(static_cast<MapView*>(m_geoView)->screenToLocation(mouseEvent.x(), mouseEvent.y()));
-  else if (dynamic_cast<SceneView*>(m_geoView))
-    emit mousePressedAndHeldPoint(static_cast<SceneView*>(m_geoView)->screenToBaseSurface(mouseEvent.x(), mouseEvent.y()));
-  else if (dynamic_cast<MapView*>(m_geoView))
-    emit mousePressedAndHeldPoint(static_cast<MapView*>(m_geoView)->screenToLocation(mouseEvent.x(), mouseEvent.y()));
+  emit mouseReleased(mouseEvent);
+
+  if (isPointSignalConnected(&ToolResourceProvider::mouseReleasedPoint))
+    emit mouseReleasedPoint(screenToPoint(mouseEvent));
 }
 
-void ToolResourceProvider::onMouseDoubleClicked(QMouseEvent &mouseEvent)
+void ToolResourceProvider::onMousePressedAndHeld(QMouseEvent& mouseEvent)
 {
-  emit mouseDoubleClicked(mouseEvent);
+  if (dispatchMouseEvent(MouseEventType::PressedAndHeld, mouseEvent))
+    return;
+
+  emit mousePressedAndHeld(mouseEvent);
+
+  if (isPointSignalConnected(&ToolResourceProvider::mousePressedAndHeldPoint))
+    emit mousePressedAndHeldPoint(screenToPoint(mouseEvent));
+}
 
-  if (!m_geoView)
+void ToolResourceProvider::onMouseDoubleClicked(QMouseEvent& mouseEvent)
+{
+  if (dispatchMouseEvent(MouseEventType::DoubleClicked, mouseEvent))
     return;
 
-  if (m_scene)
-    emit mouseDoubleClickedPoint(static_cast<SceneView*>(m_geoView)->screenToBaseSurface(mouseEvent.x(), mouseEvent.y()));
-  else if (m_map)
-    emit mouseDoubleClickedPoint(static_cast<MapView*>(m_geoView)->screenToLocation(mouseEvent.x(), mouseEvent.y()));
-  else if (dynamic_cast<SceneView*>(m_geoView))
-    emit mouseDoubleClickedPoint(static_cast<SceneView*>(m_geoView)->screenToBaseSurface(mouseEvent.x(), mouseEvent.y()));
-  else if (dynamic_cast<MapView*>(m_geoView))
-    emit mouseDoubleClickedPoint(static_cast<MapView*>(m_geoView)->screenToLocation(mouseEvent.x(), mouseEvent.y()));
+  emit mouseDoubleClicked(mouseEvent);
+
+  if (isPointSignalConnected(&ToolResourceProvider::mouseDoubleClickedPoint))
+    emit mouseDoubleClickedPoint(screenToPoint(mouseEvent));
 }
 
 void ToolResourceProvider::onIdentifyGraphicsOverlayCompleted(QUuid id, IdentifyGraphicsOverlayResult* identifyResult)
@@ -292,7 +394,23 @@ void ToolResourceProvider::onIdentifyGraphicsOverlayCompleted(QUuid id, Identify
 
 void ToolResourceProvider::onIdentifyGraphicsOverlaysCompleted(QUuid taskId, QList<IdentifyGraphicsOverlayResult *> identifyResults)
 {
-  emit identifyGraphicsOverlaysCompleted(taskId, identifyResults);
+  auto findIt = m_identifyRequests.find(taskId);
+  if (findIt == m_identifyRequests.end())
+  {
+    emit identifyGraphicsOverlaysCompleted(taskId, identifyResults);
+    return;
+  }
+
+  // the request is removed first so that the callbacks can start new requests
+  const QList<IdentifyRequester> requesters = std::move(findIt.value().m_requesters);
+  m_identifyRequests.erase(findIt);
+
+  GraphicsOverlaysResultsManager resultsManager(std::move(identifyResults));
+  for (const IdentifyRequester& requester : requesters)
+  {
+    if (requester.m_requester && requester.m_graphicsOverlaysCallback)
+      requester.m_graphicsOverlaysCallback(resultsManager.m_results);
+  }
 }
 
 void ToolResourceProvider::onIdentifyLayerCompleted(QUuid taskId, IdentifyLayerResult* identifyResult)
@@ -302,7 +420,23 @@ void ToolResourceProvider::onIdentifyLayerCompleted(QUuid taskId, IdentifyLayerR
 
 void ToolResourceProvider::onIdentifyLayersCompleted(QUuid taskId, QList<IdentifyLayerResult*> identifyResults)
 {
-  emit identifyLayersCompleted(taskId, identifyResults);
+  auto findIt = m_identifyRequests.find(taskId);
+  if (findIt == m_identifyRequests.end())
+  {
+    emit identifyLayersCompleted(taskId, identifyResults);
+    return;
+  }
+
+  // the request is removed first so that the callbacks can start new requests
+  const QList<IdentifyRequester> requesters = std::move(findIt.value().m_requesters);
+  m_identifyRequests.erase(findIt);
+
+  LayerResultsManager resultsManager(std::move(identifyResults));
+  for (const IdentifyRequester& requester : requesters)
+  {
+    if (requester.m_requester && requester.m_layersCallback)
+      requester.m_layersCallback(resultsManager.m_results);
+  }
 }
 
 void ToolResourceProvider::onScreenToLocationCompleted(QUuid taskId, const Point& location)
@@ -315,6 +449,139 @@ void ToolResourceProvider::onLocationChanged(const Point& location)
   emit locationChanged(location);
 }
 
+/*! \brief Starts an identify layers task at \a x, \a y in the geoView on behalf of \a requester.
+ *
+ * Returns the id of the task, or a null id if there is no geoView. When the task
+ * completes, \a callback is called with the results, rather than
+ * \l identifyLayersCompleted being emitted. The results are deleted once the
+ * callback returns, so any GeoElements which are kept must be re-parented.
+ *
+ * A request starts a new task unless an identical request (the same position,
+ * \a tolerance, \a returnPopupsOnly and \a maximumResults) was made in the last
+ * 250 ms and is still running, in which case the task is shared. A new request
+ * supersedes any identify layers request which \a requester already has running,
+ * and a task is cancelled once none of its requesters want the results.
+ *
+ * \sa cancelIdentify
+ */
+QUuid ToolResourceProvider::identifyLayers(QObject* requester, double x, double y, double tolerance, bool returnPopupsOnly,
+                                           int maximumResults, IdentifyLayersCallback callback)
+{
+  IdentifyRequester callbacks;
+  callbacks.m_layersCallback = std::move(callback);
+  return startIdentify(IdentifyKind::Layers, requester, x, y, tolerance, returnPopupsOnly, maximumResults, callbacks);
+}
+
+/*! \brief Starts an identify graphics overlays task at \a x, \a y in the geoView on behalf of \a requester.
+ *
+ * This behaves in the same way as \l identifyLayers, calling \a callback
+ * rather than emitting \l identifyGraphicsOverlaysCompleted.
+ *
+ * \sa cancelIdentify
+ */
+QUuid ToolResourceProvider::identifyGraphicsOverlays(QObject* requester, double x, double y, double tolerance, bool returnPopupsOnly,
+                                                     int maximumResults, IdentifyGraphicsOverlaysCallback callback)
+{
+  IdentifyRequester callbacks;
+  callbacks.m_graphicsOverlaysCallback = std::move(callback);
+  return startIdentify(IdentifyKind::GraphicsOverlays, requester, x, y, tolerance, returnPopupsOnly, maximumResults, callbacks);
+}
+
+/*! \brief Cancels the identify requests of \a requester.
+ *
+ * The callbacks for those requests will not be called. A task shared with
+ * another requester keeps running for that requester.
+ */
+void ToolResourceProvider::cancelIdentify(QObject* requester)
+{
+  removeIdentifyRequester(requester, IdentifyKind::Layers);
+  removeIdentifyRequester(requester, IdentifyKind::GraphicsOverlays);
+}
+
+QUuid ToolResourceProvider::startIdentify(IdentifyKind kind, QObject* requester, double x, double y, double tolerance,
+                                          bool returnPopupsOnly, int maximumResults, const IdentifyRequester& callbacks)
+{
+  if (!m_geoView || !requester)
+    return QUuid();
+
+  removeIdentifyRequester(requester, kind);
+
+  IdentifyRequester newRequester = callbacks;
+  newRequester.m_requester = requester;
+
+  // join a running task for the same request, such as one started by another tool for the same tap
+  for (auto it = m_identifyRequests.begin(); it != m_identifyRequests.end(); ++it)
+  {
+    IdentifyRequest& request = it.value();
+    if (request.m_requesters.isEmpty() || request.m_kind != kind || request.m_geoView != m_geoView ||
+        request.m_x != x || request.m_y != y || request.m_tolerance != tolerance ||
+        request.m_returnPopupsOnly != returnPopupsOnly || request.m_maximumResults != maximumResults ||
+        request.m_started.elapsed() > s_identifyShareWindow)
+    {
+      continue;
+    }
+
+    request.m_requesters.append(newRequester);
+    return it.key();
+  }
+
+  IdentifyRequest request;
+  request.m_kind = kind;
+  request.m_geoView = m_geoView;
+  request.m_x = x;
+  request.m_y = y;
+  request.m_tolerance = tolerance;
+  request.m_returnPopupsOnly = returnPopupsOnly;
+  request.m_maximumResults = maximumResults;
+  request.m_started.start();
+  request.m_watcher = kind == IdentifyKind::Layers
+      ? m_geoView->identifyLayers(x, y, tolerance, returnPopupsOnly, maximumResults)
+      : m_geoView->identifyGraphicsOverlays(x, y, tolerance, returnPopupsOnly, maximumResults);
+  request.m_requesters.append(newRequester);
+
+  const QUuid taskId = request.m_watcher.taskId();
+  m_identifyRequests.insert(taskId, request);
+
+  return taskId;
+}
+
+/*
+ * Removes \a requester (and any requesters which have been destroyed) from the
+ * requests of type \a kind. Tasks which no longer have any requesters are cancelled,
+ * but are remembered so that the results are deleted if they still complete.
+ */
+void ToolResourceProvider::removeIdentifyRequester(QObject* requester, IdentifyKind kind)
+{
+  for (auto it = m_identifyRequests.begin(); it != m_identifyRequests.end();)
+  {
+    IdentifyRequest& request = it.value();
+    if (request.m_requesters.isEmpty())
+    {
+      if (request.m_started.elapsed() > s_cancelledIdentifyLifetime)
+        it = m_identifyRequests.erase(it);
+      else
+        ++it;
+
+      continue;
+    }
+
+    if (request.m_kind == kind)
+    {
+      auto removeIt = std::remove_if(request.m_requesters.begin(), request.m_requesters.end(),
+                                     [requester](const IdentifyRequester& r)
+      {
+        return !r.m_requester || r.m_requester == requester;
+      });
+      request.m_requesters.erase(removeIt, request.m_requesters.end());
+
+      if (request.m_requesters.isEmpty())
+        request.m_watcher.cancel();
+    }
+
+    ++it;
+  }
+}
+
 void ToolResourceProvider::clear()
 {
   m_map = nullptr;
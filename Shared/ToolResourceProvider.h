@@ -20,10 +20,16 @@
 #include <QObject>
 
 #include "Point.h"
+#include "TaskWatcher.h"
+#include <QElapsedTimer>
+#include <QHash>
 #include <QMouseEvent>
+#include <QPointer>
 #include <QUuid>
 #include <QCursor>
 
+#include <functional>
+
 namespace Esri
 {
 namespace ArcGISRuntime
@@ -49,6 +55,34 @@ class ToolResourceProvider : public QObject
 
 public:
 
+  using IdentifyLayersCallback = std::function<void(const QList<Esri::ArcGISRuntime::IdentifyLayerResult*>&)>;
+  using IdentifyGraphicsOverlaysCallback = std::function<void(const QList<Esri::ArcGISRuntime::IdentifyGraphicsOverlayResult*>&)>;
+
+  enum class MouseEventType
+  {
+    Clicked = 0x01,
+    Pressed = 0x02,
+    Moved = 0x04,
+    Released = 0x08,
+    PressedAndHeld = 0x10,
+    DoubleClicked = 0x20
+  };
+  Q_DECLARE_FLAGS(MouseEventTypes, MouseEventType)
+
+  // higher priorities receive mouse events first
+  enum MouseFocusPriority
+  {
+    DefaultMousePriority = 0,
+    PickMousePriority = 50,
+    SketchMousePriority = 100
+  };
+
+  // returns true if the event was consumed, in which case it is not passed on
+  using MouseEventHandler = std::function<bool(MouseEventType, QMouseEvent&)>;
+
+  // sees every mouse event before it is dispatched, for recording interactions
+  using MouseEventObserver = std::function<void(MouseEventType, const QMouseEvent&)>;
+
   static ToolResourceProvider* instance();
 
   ~ToolResourceProvider() override;
@@ -72,6 +106,18 @@ public:
 
   void clear();
 
+  QUuid identifyLayers(QObject* requester, double x, double y, double tolerance, bool returnPopupsOnly,
+                       int maximumResults, IdentifyLayersCallback callback);
+  QUuid identifyGraphicsOverlays(QObject* requester, double x, double y, double tolerance, bool returnPopupsOnly,
+                                 int maximumResults, IdentifyGraphicsOverlaysCallback callback);
+  void cancelIdentify(QObject* requester);
+
+  void setMouseFocus(QObject* owner, MouseEventTypes eventTypes, int priority, MouseEventHandler handler);
+  void clearMouseFocus(QObject* owner);
+  bool hasMouseFocus(QObject* owner) const;
+
+  void setMouseEventObserver(MouseEventObserver observer);
+
 public slots:
   void onMouseClicked(QMouseEvent& mouseEvent);
   void onMousePressed(QMouseEvent& mouseEvent);
@@ -116,11 +162,60 @@ signals:
 private:
   explicit ToolResourceProvider(QObject* parent = nullptr);
 
+  enum class IdentifyKind
+  {
+    Layers,
+    GraphicsOverlays
+  };
+
+  struct IdentifyRequester
+  {
+    QPointer<QObject> m_requester;
+    IdentifyLayersCallback m_layersCallback;
+    IdentifyGraphicsOverlaysCallback m_graphicsOverlaysCallback;
+  };
+
+  struct IdentifyRequest
+  {
+    IdentifyKind m_kind = IdentifyKind::Layers;
+    Esri::ArcGISRuntime::GeoView* m_geoView = nullptr;
+    double m_x = 0.0;
+    double m_y = 0.0;
+    double m_tolerance = 0.0;
+    bool m_returnPopupsOnly = false;
+    int m_maximumResults = -1;
+    QElapsedTimer m_started;
+    Esri::ArcGISRuntime::TaskWatcher m_watcher;
+    QList<IdentifyRequester> m_requesters;
+  };
+
+  struct MouseFocus
+  {
+    QPointer<QObject> m_owner;
+    MouseEventTypes m_eventTypes;
+    int m_priority = DefaultMousePriority;
+    MouseEventHandler m_handler;
+    QMetaObject::Connection m_destroyedConnection;
+  };
+
+  bool dispatchMouseEvent(MouseEventType eventType, QMouseEvent& mouseEvent);
+  bool isPointSignalConnected(void (ToolResourceProvider::*signal)(const Esri::ArcGISRuntime::Point&)) const;
+  Esri::ArcGISRuntime::Point screenToPoint(const QMouseEvent& mouseEvent) const;
+
+  QUuid startIdentify(IdentifyKind kind, QObject* requester, double x, double y, double tolerance,
+                      bool returnPopupsOnly, int maximumResults, const IdentifyRequester& callbacks);
+  void removeIdentifyRequester(QObject* requester, IdentifyKind kind);
+
+  QHash<QUuid, IdentifyRequest> m_identifyRequests;
+  QList<MouseFocus> m_mouseFocus;
+  MouseEventObserver m_mouseEventObserver;
   Esri::ArcGISRuntime::GeoView* m_geoView = nullptr;
   Esri::ArcGISRuntime::Map* m_map = nullptr;
   Esri::ArcGISRuntime::Scene* m_scene = nullptr;
 };
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(ToolResourceProvider::MouseEventTypes)
+
 } // Dsa
 
 #endif // TOOL_RESOURCE_PROVIDER_H
@@ -0,0 +1,366 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "TraceRecorder.h"
+
+// Qt headers
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QThread>
+
+namespace Dsa {
+
+namespace {
+// the sections entered on the calling thread, if it is watched
+thread_local TraceRecorder::SectionStack* t_sections = nullptr;
+}
+
+/*!
+  \class Dsa::TraceRecorder
+  \inmodule Dsa
+  \brief Records timed events from any thread while the app is running.
+
+  Where \l StartupProfiler covers the app's startup, this recorder covers the
+  work done afterwards, such as applying messages, evaluating alert conditions
+  and restoring layers. Scopes are recorded with the \c DSA_TRACE_SCOPE macro,
+  which costs a single atomic load while recording is disabled.
+
+  The most recent 100000 events are kept. They can be written with \l writeTrace
+  in the Chrome trace event format, which can be opened in \c chrome://tracing
+  or Perfetto, so that operators can send traces from the field.
+
+  Times are measured in microseconds from the first use of the recorder.
+
+  Sampled values, such as the heap usage reported by the \l PerformanceMonitor,
+  can be recorded with \l counter and are shown as graphs alongside the events.
+
+  Whether or not recording is enabled, the scopes entered on a thread which is
+  watched with \l watchCurrentThread are kept in a \l SectionStack, so that
+  another thread, such as the \l StallWatchdog, can tell where it is busy.
+ */
+
+/*!
+  \class Dsa::TraceRecorder::SectionStack
+  \inmodule Dsa
+  \brief Holds the names of the scopes which a watched thread is executing.
+
+  The stack is written by the watched thread and may be read from any thread.
+  At most 16 nested scopes are named.
+ */
+
+/*!
+  \brief Constructor.
+ */
+TraceRecorder::SectionStack::SectionStack()
+{
+  for (auto& name : m_names)
+    name.store(nullptr, std::memory_order_relaxed);
+}
+
+/*!
+  \brief Returns the names of the scopes being executed, outermost first.
+
+  As the watched thread keeps running, the result is a snapshot which may already
+  be out of date.
+ */
+QStringList TraceRecorder::SectionStack::sections() const
+{
+  const int depth = qMin(m_depth.load(std::memory_order_acquire), s_maximumDepth);
+
+  QStringList sections;
+  for (int i = 0; i < depth; ++i)
+  {
+    const char* name = m_names[i].load(std::memory_order_relaxed);
+    if (name)
+      sections.append(QString::fromLatin1(name));
+  }
+
+  return sections;
+}
+
+/*!
+  \class Dsa::TraceRecorder::Scope
+  \inmodule Dsa
+  \brief Records the enclosing scope as an event, if recording is enabled when
+  the scope is entered.
+ */
+
+/*!
+  \brief Starts the scope called \a name, which must be a string literal.
+ */
+TraceRecorder::Scope::Scope(const char* name):
+  m_name(name),
+  m_sections(t_sections)
+{
+  if (m_sections)
+  {
+    const int depth = m_sections->m_depth.load(std::memory_order_relaxed);
+    if (depth < SectionStack::s_maximumDepth)
+      m_sections->m_names[depth].store(name, std::memory_order_relaxed);
+
+    m_sections->m_depth.store(depth + 1, std::memory_order_release);
+  }
+
+  TraceRecorder* recorder = TraceRecorder::instance();
+  if (recorder->isEnabled())
+    m_start = recorder->timestamp();
+}
+
+/*!
+  \brief Ends the scope.
+ */
+TraceRecorder::Scope::~Scope()
+{
+  if (m_sections)
+    m_sections->m_depth.store(m_sections->m_depth.load(std::memory_order_relaxed) - 1, std::memory_order_release);
+
+  if (m_start < 0)
+    return;
+
+  TraceRecorder* recorder = TraceRecorder::instance();
+  recorder->record(m_name, m_start, recorder->timestamp() - m_start);
+}
+
+/*!
+  \brief Returns the singleton instance of the recorder.
+ */
+TraceRecorder* TraceRecorder::instance()
+{
+  static TraceRecorder s_instance;
+  return &s_instance;
+}
+
+/*!
+  \brief Keeps the scopes entered on the calling thread in \a sections from now on.
+
+  The \a sections must outlive the thread, or be unwatched by passing \c nullptr
+  on the same thread.
+ */
+void TraceRecorder::watchCurrentThread(SectionStack* sections)
+{
+  t_sections = sections;
+}
+
+/*!
+  \internal
+ */
+TraceRecorder::TraceRecorder()
+{
+  m_timer.start();
+}
+
+/*!
+  \brief Returns whether events are being recorded.
+
+  The default is \c false.
+ */
+bool TraceRecorder::isEnabled() const
+{
+  return m_enabled.load(std::memory_order_relaxed);
+}
+
+/*!
+  \brief Sets whether events are being recorded to \a enabled.
+
+  Events recorded before recording was disabled are kept until \l clear is called.
+ */
+void TraceRecorder::setEnabled(bool enabled)
+{
+  m_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+/*!
+  \brief Records an event called \a name which started at \a start and lasted
+  \a duration microseconds, on the calling thread.
+
+  Once the maximum number of events is reached, the oldest event is replaced.
+ */
+void TraceRecorder::record(const char* name, qint64 start, qint64 duration)
+{
+  if (!isEnabled())
+    return;
+
+  Event event;
+  event.m_name = name;
+  event.m_start = start;
+  event.m_duration = duration;
+  event.m_threadId = reinterpret_cast<quintptr>(QThread::currentThreadId());
+
+  append(event);
+}
+
+/*!
+  \brief Records an instant event called \a name, which must be a string literal.
+ */
+void TraceRecorder::mark(const char* name)
+{
+  record(name, timestamp(), -1);
+}
+
+/*!
+  \brief Records \a value as the current value of the counter called \a name,
+  which must be a string literal.
+ */
+void TraceRecorder::counter(const char* name, qint64 value)
+{
+  if (!isEnabled())
+    return;
+
+  Event event;
+  event.m_name = name;
+  event.m_start = timestamp();
+  event.m_value = value;
+  event.m_threadId = reinterpret_cast<quintptr>(QThread::currentThreadId());
+  event.m_isCounter = true;
+
+  append(event);
+}
+
+/*!
+  \internal
+
+  Once the maximum number of events is reached, the oldest event is replaced.
+ */
+void TraceRecorder::append(const Event& event)
+{
+  QMutexLocker locker(&m_mutex);
+  if (m_events.isEmpty())
+    m_events.resize(s_maximumEvents);
+
+  m_events[m_nextEvent] = event;
+  if (++m_nextEvent == s_maximumEvents)
+  {
+    m_nextEvent = 0;
+    m_isFull = true;
+  }
+}
+
+/*!
+  \brief Returns the time in microseconds since the recorder was first used.
+ */
+qint64 TraceRecorder::timestamp() const
+{
+  return m_timer.nsecsElapsed() / 1000;
+}
+
+/*!
+  \brief Returns the number of events which have been kept.
+ */
+int TraceRecorder::eventCount() const
+{
+  QMutexLocker locker(&m_mutex);
+  return m_isFull ? s_maximumEvents : m_nextEvent;
+}
+
+/*!
+  \brief Discards all of the recorded events.
+ */
+void TraceRecorder::clear()
+{
+  QMutexLocker locker(&m_mutex);
+  m_events.clear();
+  m_nextEvent = 0;
+  m_isFull = false;
+}
+
+/*!
+  \brief Writes the recorded events, oldest first, to \a tracePath in the Chrome
+  trace event format.
+
+  Threads are numbered in the order in which they first appear in the trace.
+
+  Returns \c false if the trace could not be written.
+ */
+bool TraceRecorder::writeTrace(const QString& tracePath) const
+{
+  if (tracePath.isEmpty())
+    return false;
+
+  QVector<Event> events;
+  {
+    QMutexLocker locker(&m_mutex);
+    if (m_isFull)
+    {
+      events.reserve(s_maximumEvents);
+      events.append(m_events.mid(m_nextEvent));
+      events.append(m_events.mid(0, m_nextEvent));
+    }
+    else
+    {
+      events = m_events.mid(0, m_nextEvent);
+    }
+  }
+
+  QHash<quintptr, int> threadIds;
+  QJsonArray traceEvents;
+  for (const Event& event : qAsConst(events))
+  {
+    auto threadIt = threadIds.find(event.m_threadId);
+    if (threadIt == threadIds.end())
+      threadIt = threadIds.insert(event.m_threadId, threadIds.size() + 1);
+
+    QJsonObject traceEvent;
+    traceEvent.insert(QStringLiteral("name"), QString::fromLatin1(event.m_name));
+    traceEvent.insert(QStringLiteral("cat"), QStringLiteral("runtime"));
+    traceEvent.insert(QStringLiteral("ts"), static_cast<double>(event.m_start));
+    traceEvent.insert(QStringLiteral("pid"), 1);
+    traceEvent.insert(QStringLiteral("tid"), threadIt.value());
+
+    if (event.m_isCounter)
+    {
+      QJsonObject args;
+      args.insert(QStringLiteral("value"), static_cast<double>(event.m_value));
+      traceEvent.insert(QStringLiteral("ph"), QStringLiteral("C"));
+      traceEvent.insert(QStringLiteral("args"), args);
+    }
+    else if (event.m_duration >= 0)
+    {
+      traceEvent.insert(QStringLiteral("ph"), QStringLiteral("X"));
+      traceEvent.insert(QStringLiteral("dur"), static_cast<double>(event.m_duration));
+    }
+    else
+    {
+      traceEvent.insert(QStringLiteral("ph"), QStringLiteral("i"));
+      traceEvent.insert(QStringLiteral("s"), QStringLiteral("t"));
+    }
+
+    traceEvents.append(traceEvent);
+  }
+
+  QJsonObject trace;
+  trace.insert(QStringLiteral("traceEvents"), traceEvents);
+  trace.insert(QStringLiteral("displayTimeUnit"), QStringLiteral("ms"));
+
+  QDir().mkpath(QFileInfo(tracePath).absolutePath());
+
+  QSaveFile traceFile(tracePath);
+  if (!traceFile.open(QIODevice::WriteOnly))
+    return false;
+
+  traceFile.write(QJsonDocument(trace).toJson(QJsonDocument::Compact));
+  return traceFile.commit();
+}
+
+} // Dsa
@@ -0,0 +1,119 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef TRACERECORDER_H
+#define TRACERECORDER_H
+
+// Qt headers
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// STL headers
+#include <atomic>
+
+#define DSA_TRACE_CONCAT_IMPL(a, b) a##b
+#define DSA_TRACE_CONCAT(a, b) DSA_TRACE_CONCAT_IMPL(a, b)
+
+// Records the enclosing scope as a trace event. The name must be a string literal.
+#define DSA_TRACE_SCOPE(name) Dsa::TraceRecorder::Scope DSA_TRACE_CONCAT(dsaTraceScope, __LINE__)(name)
+
+namespace Dsa {
+
+class TraceRecorder
+{
+public:
+  // The scopes entered on a watched thread, which can be read from any other thread
+  class SectionStack
+  {
+  public:
+    SectionStack();
+
+    QStringList sections() const;
+
+  private:
+    Q_DISABLE_COPY(SectionStack)
+    friend class TraceRecorder;
+
+    static constexpr int s_maximumDepth = 16;
+
+    std::atomic<int> m_depth{0};
+    std::atomic<const char*> m_names[s_maximumDepth];
+  };
+
+  // Records the enclosing scope as a complete event
+  class Scope
+  {
+  public:
+    explicit Scope(const char* name);
+    ~Scope();
+
+  private:
+    Q_DISABLE_COPY(Scope)
+
+    const char* m_name = nullptr;
+    qint64 m_start = -1;
+    SectionStack* m_sections = nullptr;
+  };
+
+  static TraceRecorder* instance();
+
+  static void watchCurrentThread(SectionStack* sections);
+
+  bool isEnabled() const;
+  void setEnabled(bool enabled);
+
+  void record(const char* name, qint64 start, qint64 duration);
+  void mark(const char* name);
+  void counter(const char* name, qint64 value);
+
+  qint64 timestamp() const;
+  int eventCount() const;
+  void clear();
+
+  bool writeTrace(const QString& tracePath) const;
+
+private:
+  TraceRecorder();
+  Q_DISABLE_COPY(TraceRecorder)
+
+  struct Event
+  {
+    const char* m_name = nullptr;
+    qint64 m_start = 0;
+    qint64 m_duration = -1;
+    quintptr m_threadId = 0;
+    bool m_isCounter = false;
+    qint64 m_value = 0;
+  };
+
+  static constexpr int s_maximumEvents = 100000;
+
+  void append(const Event& event);
+
+  std::atomic<bool> m_enabled{false};
+  QElapsedTimer m_timer;
+  mutable QMutex m_mutex;
+  QVector<Event> m_events;
+  int m_nextEvent = 0;
+  bool m_isFull = false;
+};
+
+} // Dsa
+
+#endif // TRACERECORDER_H
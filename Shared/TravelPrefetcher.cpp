@@ -0,0 +1,204 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "TravelPrefetcher.h"
+
+// dsa app headers
+#include "ElevationSampleCache.h"
+#include "GeodesicKernels.h"
+
+// Qt headers
+#include <QTimer>
+
+// STL headers
+#include <algorithm>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+namespace
+{
+
+// the area ahead is looked at once a second, so that it never competes with rendering
+constexpr int s_prefetchInterval = 1000;
+
+// below walking pace the view keeps up on its own
+constexpr double s_minimumSpeed = 3.0;
+
+// the seconds ahead at which the elevation is prefetched
+constexpr double s_horizons[] = {15.0, 30.0, 60.0};
+
+// nothing further than this is prefetched, however fast the vehicle is going
+constexpr double s_maximumDistance = 5000.0;
+
+// the area ahead is only looked at again once the vehicle has moved this far
+constexpr double s_minimumMovement = 100.0;
+
+// a gap between two locations longer than this restarts the estimate of the speed
+constexpr qint64 s_maximumGap = 10000;
+
+// the weight given to the latest speed, so that the estimate is not thrown by GPS jitter
+constexpr double s_speedSmoothing = 0.3;
+
+double distanceBetween(const Point& from, const Point& to)
+{
+  return Geodesic::haversineDistance(from.y(), from.x(), to.y(), to.x());
+}
+
+}
+
+/*!
+  \class Dsa::TravelPrefetcher
+  \inmodule Dsa
+  \inherits QObject
+  \brief Prefetches the elevation of the area ahead of a moving location.
+
+  The speed is estimated from the successive locations passed to \l setLocation.
+  Once a second, while the location moves faster than walking pace, the locations
+  15, 30 and 60 seconds ahead along the \l {setHeading}{heading} are passed to
+  \l ElevationSampleCache::prefetch, up to 5 km ahead. Those tiles are then sampled
+  from the scene's surface, which loads the surface's elevation tiles for them, before
+  the camera reaches them.
+
+  Nothing is prefetched again until the location has moved 100 m, and the cache limits
+  how many samples are in flight, so the prefetching does not compete with rendering.
+ */
+
+/*!
+  \brief Constructor taking an optional \a parent.
+ */
+TravelPrefetcher::TravelPrefetcher(QObject* parent) :
+  QObject(parent),
+  m_timer(new QTimer(this))
+{
+  m_timer->setInterval(s_prefetchInterval);
+  connect(m_timer, &QTimer::timeout, this, &TravelPrefetcher::prefetchAhead);
+  m_timer->start();
+}
+
+/*!
+  \brief Destructor.
+ */
+TravelPrefetcher::~TravelPrefetcher()
+{
+}
+
+/*!
+  \brief Returns whether the area ahead is prefetched.
+ */
+bool TravelPrefetcher::isEnabled() const
+{
+  return m_enabled;
+}
+
+/*!
+  \brief Sets whether the area ahead is prefetched to \a enabled.
+ */
+void TravelPrefetcher::setEnabled(bool enabled)
+{
+  if (m_enabled == enabled)
+    return;
+
+  m_enabled = enabled;
+
+  if (m_enabled)
+    m_timer->start();
+  else
+    m_timer->stop();
+}
+
+/*!
+  \brief Returns the estimated speed in meters per second.
+ */
+double TravelPrefetcher::speed() const
+{
+  return m_speed;
+}
+
+/*!
+  \brief Sets the current \a location, in WGS84, and updates the estimate of the speed.
+ */
+void TravelPrefetcher::setLocation(const Point& location)
+{
+  if (location.isEmpty())
+    return;
+
+  const qint64 elapsed = m_locationTimer.isValid() ? m_locationTimer.restart() : -1;
+  if (elapsed < 0)
+    m_locationTimer.start();
+
+  if (!m_location.isEmpty() && elapsed > 0 && elapsed < s_maximumGap)
+  {
+    const double latestSpeed = distanceBetween(m_location, location) * 1000.0 / elapsed;
+    m_speed += s_speedSmoothing * (latestSpeed - m_speed);
+  }
+  else
+  {
+    m_speed = 0.0;
+  }
+
+  m_location = location;
+}
+
+/*!
+  \brief Sets the current \a heading, in degrees clockwise from north.
+ */
+void TravelPrefetcher::setHeading(double heading)
+{
+  m_heading = heading;
+}
+
+/*!
+  \brief Forgets the location and the speed, for example when the position source changes.
+ */
+void TravelPrefetcher::reset()
+{
+  m_locationTimer.invalidate();
+  m_location = Point();
+  m_lastPrefetchLocation = Point();
+  m_speed = 0.0;
+}
+
+/*!
+  \internal
+ */
+void TravelPrefetcher::prefetchAhead()
+{
+  if (m_location.isEmpty() || m_speed < s_minimumSpeed)
+    return;
+
+  if (!m_lastPrefetchLocation.isEmpty() && distanceBetween(m_lastPrefetchLocation, m_location) < s_minimumMovement)
+    return;
+
+  m_lastPrefetchLocation = m_location;
+
+  ElevationSampleCache* cache = ElevationSampleCache::instance();
+  for (double horizon : s_horizons)
+  {
+    const double distance = std::min(m_speed * horizon, s_maximumDistance);
+
+    double latitude = 0.0;
+    double longitude = 0.0;
+    Geodesic::destinationPoint(m_location.y(), m_location.x(), m_heading, distance, latitude, longitude);
+    cache->prefetch(Point(longitude, latitude, SpatialReference::wgs84()));
+  }
+}
+
+} // Dsa
@@ -0,0 +1,62 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef TRAVELPREFETCHER_H
+#define TRAVELPREFETCHER_H
+
+// C++ API headers
+#include "Point.h"
+
+// Qt headers
+#include <QElapsedTimer>
+#include <QObject>
+
+class QTimer;
+
+namespace Dsa {
+
+class TravelPrefetcher : public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit TravelPrefetcher(QObject* parent = nullptr);
+  ~TravelPrefetcher();
+
+  bool isEnabled() const;
+  void setEnabled(bool enabled);
+
+  double speed() const;
+
+  void setLocation(const Esri::ArcGISRuntime::Point& location);
+  void setHeading(double heading);
+  void reset();
+
+private:
+  void prefetchAhead();
+
+  QTimer* m_timer = nullptr;
+  QElapsedTimer m_locationTimer;
+  Esri::ArcGISRuntime::Point m_location;
+  Esri::ArcGISRuntime::Point m_lastPrefetchLocation;
+  double m_heading = 0.0;
+  double m_speed = 0.0;
+  bool m_enabled = true;
+};
+
+} // Dsa
+
+#endif // TRAVELPREFETCHER_H
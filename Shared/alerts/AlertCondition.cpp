@@ -20,13 +20,19 @@
 #include "AlertCondition.h"
 
 // dsa app headers
+#include "AlertConditionAggregate.h"
 #include "AlertConditionData.h"
+#include "AlertConstants.h"
 #include "GraphicAlertSource.h"
+#include "MessagesOverlay.h"
 
 // C++ API headers
 #include "GraphicListModel.h"
 #include "GraphicsOverlay.h"
 
+// Qt headers
+#include <QSet>
+
 using namespace Esri::ArcGISRuntime;
 
 namespace Dsa {
@@ -89,6 +95,10 @@ void AlertCondition::init(AlertSource* source, AlertTarget* target, const QStrin
 
   A new \l AlertConditionData will be created for each \l Esri::ArcGISRuntime::Graphic
   in the source feed, to track changes to the source and target.
+
+  If \l isAggregate is \c true, the source feed is a message feed and the condition
+  supports it, the whole feed is instead evaluated by an \l AlertConditionAggregate and
+  condition data are only created for graphics which meet the condition.
  */
 void AlertCondition::init(GraphicsOverlay* sourceFeed, const QString& sourceDescription, AlertTarget* target, const QString& targetDescription)
 {
@@ -102,6 +112,27 @@ void AlertCondition::init(GraphicsOverlay* sourceFeed, const QString& sourceDesc
   if (!graphics)
     return;
 
+  // message feeds can be evaluated as a whole, without per-graphic condition data
+  MessagesOverlay* messagesOverlay = MessagesOverlay::fromGraphicsOverlay(sourceFeed);
+  if (m_aggregate && messagesOverlay && isAggregateSupported())
+  {
+    m_aggregateData = new AlertConditionAggregate(this, messagesOverlay, target, this);
+    m_aggregateData->setEnabled(m_enabled);
+
+    // the results evaluated here are what peers sharing the condition are sent
+    connect(m_aggregateData, &AlertConditionAggregate::rowActiveChanged, this, [this, messagesOverlay](Graphic* graphic, bool active)
+    {
+      if (m_aggregateData->isRemote())
+        return;
+
+      // a graphic which has just been removed from the feed no longer has an ID
+      const QString sourceId = messagesOverlay->messageId(graphic);
+      if (!sourceId.isEmpty())
+        emit sourceResultChanged(sourceId, active);
+    });
+    return;
+  }
+
   // process a new graphic from the source feed to create a new AlertConditionData
   auto handleGraphicAt = [this, graphics, target](int index)
   {
@@ -117,8 +148,39 @@ void AlertCondition::init(GraphicsOverlay* sourceFeed, const QString& sourceDesc
     addData(newData);
   };
 
-  // connect to the graphicAdded to add condition data for any new graphics
-  connect(graphics, &GraphicListModel::graphicAdded, this, handleGraphicAt);
+  // message feeds add new graphics in blocks with a single notification
+  if (messagesOverlay)
+  {
+    connect(messagesOverlay, &MessagesOverlay::graphicsAdded, this, [handleGraphicAt](int index, int count)
+    {
+      for (int i = index; i < index + count; ++i)
+        handleGraphicAt(i);
+    });
+
+    // drop the condition data for graphics which have left the feed
+    connect(messagesOverlay, &MessagesOverlay::graphicsRemoved, this, [this](const QList<Graphic*>& removedGraphics)
+    {
+      const QSet<Graphic*> removed = QSet<Graphic*>::fromList(removedGraphics);
+      const QList<AlertConditionData*> data = m_data;
+      for (AlertConditionData* conditionData : data)
+      {
+        GraphicAlertSource* source = qobject_cast<GraphicAlertSource*>(conditionData->source());
+        if (!source || !removed.contains(source->graphic()))
+          continue;
+
+        removeData(conditionData);
+
+        // the condition data reports that it is no longer valid once its source is gone
+        delete source;
+        conditionData->deleteLater();
+      }
+    });
+  }
+  else
+  {
+    // connect to the graphicAdded to add condition data for any new graphics
+    connect(graphics, &GraphicListModel::graphicAdded, this, handleGraphicAt);
+  }
 
   // add condition data for all of the graphics which are in the overlay to begin with
   const int count = graphics->rowCount();
@@ -208,10 +270,72 @@ void AlertCondition::addData(AlertConditionData* newData)
   if (!newData)
     return;
 
+  newData->setHysteresis(m_hysteresis);
   m_data.append(newData);
   emit newConditionData(newData);
 }
 
+/*!
+  \brief Removes \a data from the list of data being tracked for this condition.
+
+  The condition data is not deleted.
+ */
+void AlertCondition::removeData(AlertConditionData* data)
+{
+  m_data.removeOne(data);
+}
+
+/*!
+  \brief Returns whether this condition can evaluate a whole source feed with
+  \l createAggregateQueryTask.
+
+  The default implementation returns \c false.
+ */
+bool AlertCondition::isAggregateSupported() const
+{
+  return false;
+}
+
+/*!
+  \brief Returns a function which tests the source \a graphic, at \a location, against
+  the \a target.
+
+  This is used to evaluate a whole source feed without creating a condition data for
+  each graphic. \a active is whether the graphic currently meets the condition, so that
+  the \l hysteresis can be applied. The default implementation returns an empty function.
+
+  \sa isAggregateSupported
+ */
+AlertConditionData::QueryTask AlertCondition::createAggregateQueryTask(Graphic* graphic, const Point& location, AlertTarget* target, bool active) const
+{
+  Q_UNUSED(graphic)
+  Q_UNUSED(location)
+  Q_UNUSED(target)
+  Q_UNUSED(active)
+
+  return AlertConditionData::QueryTask();
+}
+
+/*!
+  \brief Returns whether source feeds are evaluated as a whole, where supported.
+
+  The default is \c true.
+ */
+bool AlertCondition::isAggregate() const
+{
+  return m_aggregate;
+}
+
+/*!
+  \brief Sets whether source feeds are evaluated as a whole, where supported, to \a aggregate.
+
+  This must be set before the condition is initialized with a source feed.
+ */
+void AlertCondition::setAggregate(bool aggregate)
+{
+  m_aggregate = aggregate;
+}
+
 /*!
   \brief Returns the name of the condition source.
  */
@@ -256,6 +380,10 @@ void AlertCondition::setConditionEnabled(bool enabled)
   if (enabled == m_enabled)
     return;
 
+  // disabling the aggregate destroys its condition data, so do this first
+  if (m_aggregateData)
+    m_aggregateData->setEnabled(enabled);
+
   for (auto it = m_data.cbegin(); it != m_data.cend(); ++it)
   {
     AlertConditionData* data = *it;
@@ -267,6 +395,118 @@ void AlertCondition::setConditionEnabled(bool enabled)
   emit conditionEnabledChanged();
 }
 
+/*!
+  \brief Returns the hysteresis applied to the data of this condition.
+
+  By default there are no bands and no minimum dwell time.
+ */
+AlertConditionData::Hysteresis AlertCondition::hysteresis() const
+{
+  return m_hysteresis;
+}
+
+/*!
+  \brief Sets the \a hysteresis applied to the data of this condition.
+
+  The bands only apply to spatial conditions. The minimum dwell time applies to
+  all condition types.
+ */
+void AlertCondition::setHysteresis(const AlertConditionData::Hysteresis& hysteresis)
+{
+  m_hysteresis = hysteresis;
+
+  for (auto it = m_data.cbegin(); it != m_data.cend(); ++it)
+  {
+    AlertConditionData* data = *it;
+    if (data)
+      data->setHysteresis(m_hysteresis);
+  }
+
+  // the graphics of an aggregate are tested again with the new bands
+  if (m_aggregateData)
+    m_aggregateData->markAllDirty();
+
+  emit conditionChanged();
+}
+
+/*!
+  \brief Returns whether the results of this condition can be evaluated by one node and
+  shared with its peers.
+
+  This is the case for a whole message feed evaluated against a target other than the
+  node's own location, since every node has the same feeds but its own location.
+
+  \sa AlertResultSharing
+ */
+bool AlertCondition::isShareable() const
+{
+  return m_aggregateData && m_targetDescription != AlertConstants::MY_LOCATION;
+}
+
+/*!
+  \brief Returns whether the results of this condition are taken from a peer rather
+  than being evaluated on this node.
+ */
+bool AlertCondition::isEvaluatedRemotely() const
+{
+  return m_aggregateData && m_aggregateData->isRemote();
+}
+
+/*!
+  \brief Sets whether the results of this condition are taken from a peer, rather than
+  being evaluated on this node, to \a evaluatedRemotely.
+
+  This has no effect unless the condition \l isShareable.
+ */
+void AlertCondition::setEvaluatedRemotely(bool evaluatedRemotely)
+{
+  if (isShareable())
+    m_aggregateData->setRemote(evaluatedRemotely);
+}
+
+/*!
+  \brief Applies the \a results of the peer which evaluates this condition, giving
+  whether the source with each message ID meets the condition.
+
+  If \a fullState is \c true, every other source does not meet it.
+
+  \sa setEvaluatedRemotely
+ */
+void AlertCondition::applyRemoteResults(const QHash<QString, bool>& results, bool fullState)
+{
+  if (m_aggregateData)
+    m_aggregateData->applyRemoteResults(results, fullState);
+}
+
+/*!
+  \brief Returns the message IDs of the sources in the feed which currently meet a
+  shareable condition.
+ */
+QStringList AlertCondition::activeSourceIds() const
+{
+  return m_aggregateData ? m_aggregateData->activeSourceIds() : QStringList();
+}
+
+/*!
+  \brief Marks the query results of every condition data, and of every graphic in an
+  aggregate source feed, as out-of-date.
+
+  Conditions call this when data used by their queries, other than the source and
+  target, has changed.
+ */
+void AlertCondition::invalidateQueries()
+{
+  for (auto it = m_data.cbegin(); it != m_data.cend(); ++it)
+  {
+    AlertConditionData* data = *it;
+    if (data)
+      data->invalidateQuery();
+  }
+
+  if (m_aggregateData)
+    m_aggregateData->markAllDirty();
+}
+
 } // Dsa
 
 // Signal Documentation
@@ -289,3 +529,9 @@ void AlertCondition::setConditionEnabled(bool enabled)
   \fn void AlertCondition::conditionEnabledChanged();
   \brief Signal emitted when conditionEnabled property changes.
  */
+
+/*!
+  \fn void AlertCondition::sourceResultChanged(const QString& sourceId, bool active);
+  \brief Signal emitted when the source with the message ID \a sourceId of a shareable
+  condition starts or stops meeting it on this node, according to \a active.
+ */
@@ -18,24 +18,29 @@
 #define ALERTCONDITION_H
 
 // dsa app headers
+#include "AlertConditionData.h"
 #include "AlertLevel.h"
 
 // Qt headers
+#include <QHash>
 #include <QList>
 #include <QObject>
+#include <QStringList>
 #include <QVariantMap>
 
 namespace Esri
 {
 namespace ArcGISRuntime
 {
+class Graphic;
 class GraphicsOverlay;
+class Point;
 }
 }
 
 namespace Dsa {
 
-class AlertConditionData;
+class AlertConditionAggregate;
 class AlertSource;
 class AlertTarget;
 
@@ -62,11 +67,21 @@ public:
   QString newConditionDataName() const;
 
   void addData(AlertConditionData* newData);
+  void removeData(AlertConditionData* data);
 
   virtual QString queryString() const = 0;
   virtual QVariantMap queryComponents() const = 0;
   virtual AlertConditionData* createData(AlertSource* source, AlertTarget* target) = 0;
 
+  virtual bool isAggregateSupported() const;
+  virtual AlertConditionData::QueryTask createAggregateQueryTask(Esri::ArcGISRuntime::Graphic* graphic,
+                                                                 const Esri::ArcGISRuntime::Point& location,
+                                                                 AlertTarget* target,
+                                                                 bool active) const;
+
+  bool isAggregate() const;
+  void setAggregate(bool aggregate);
+
   QString sourceDescription() const;
   QString targetDescription() const;
   QString description() const;
@@ -74,19 +89,35 @@ public:
   bool isConditionEnabled() const;
   void setConditionEnabled(bool enabled);
 
+  AlertConditionData::Hysteresis hysteresis() const;
+  void setHysteresis(const AlertConditionData::Hysteresis& hysteresis);
+
+  bool isShareable() const;
+  bool isEvaluatedRemotely() const;
+  void setEvaluatedRemotely(bool evaluatedRemotely);
+  void applyRemoteResults(const QHash<QString, bool>& results, bool fullState);
+  QStringList activeSourceIds() const;
+
 signals:
   void noLongerValid();
   void newConditionData(Dsa::AlertConditionData* newConditionData);
   void conditionChanged();
   void conditionEnabledChanged();
+  void sourceResultChanged(const QString& sourceId, bool active);
+
+protected:
+  void invalidateQueries();
 
 private:
   bool m_enabled = true;
+  bool m_aggregate = true;
+  AlertConditionAggregate* m_aggregateData = nullptr;
   AlertLevel m_level;
   QString m_name;
   QList<AlertConditionData*> m_data;
   QString m_sourceDescription;
   QString m_targetDescription;
+  AlertConditionData::Hysteresis m_hysteresis;
 };
 
 } // Dsa
@@ -0,0 +1,543 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "AlertConditionAggregate.h"
+
+// dsa app headers
+#include "AlertCondition.h"
+#include "AlertConditionData.h"
+#include "AlertEvaluationScheduler.h"
+#include "AlertTarget.h"
+#include "GraphicAlertSource.h"
+#include "MessagesOverlay.h"
+
+// C++ API headers
+#include "Graphic.h"
+#include "GraphicListModel.h"
+#include "GraphicsOverlay.h"
+
+// Qt headers
+#include <QElapsedTimer>
+#include <QTimer>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+/*!
+  \class Dsa::AlertConditionAggregate
+  \inmodule Dsa
+  \inherits QObject
+  \brief Evaluates an \l AlertCondition for every graphic of a message feed without
+  creating an \l AlertConditionData for each graphic.
+
+  The graphics of the feed are held as rows of parallel arrays, recording whether each
+  row needs to be evaluated and whether it is active. Changes are tracked through the block
+  signals of the \l MessagesOverlay, so there are no per-graphic objects or connections.
+
+  Dirty rows are evaluated with the query returned by
+  \l AlertCondition::createAggregateQueryTask, within the \l AlertEvaluationScheduler
+  frame budget. Only rows which become active are materialized as an
+  \l AlertConditionData, which is added to the condition and so shown in the alert list.
+  The condition data is destroyed again once the row is no longer active.
+
+  While \l isRemote, the rows are not evaluated. Their active state is instead set by
+  \l applyRemoteResults from the results of the peer which evaluates the condition;
+  see \l AlertResultSharing.
+
+  The bands of the condition's \l AlertConditionData::Hysteresis are applied through the
+  query, according to whether each row is active. A row whose state changed less than the
+  minimum dwell time ago keeps that state, and is evaluated again once the dwell time is up.
+ */
+
+/*!
+  \brief Constructor taking the \a condition to evaluate, the \a sourceFeed whose graphics
+  are the sources, the \a target and an optional \a parent.
+ */
+AlertConditionAggregate::AlertConditionAggregate(AlertCondition* condition,
+                                                 MessagesOverlay* sourceFeed,
+                                                 AlertTarget* target,
+                                                 QObject* parent):
+  QObject(parent),
+  m_condition(condition),
+  m_sourceFeed(sourceFeed),
+  m_target(target),
+  m_timer(new QTimer(this)),
+  m_dwellTimer(new QTimer(this))
+{
+  m_clock.start();
+
+  m_timer->setSingleShot(true);
+  connect(m_timer, &QTimer::timeout, this, &AlertConditionAggregate::evaluatePending);
+
+  m_dwellTimer->setSingleShot(true);
+  connect(m_dwellTimer, &QTimer::timeout, this, &AlertConditionAggregate::releaseHeldRows);
+
+  GraphicListModel* graphics = m_sourceFeed->graphicsOverlay()->graphics();
+
+  connect(m_sourceFeed.data(), &MessagesOverlay::graphicsAdded, this, [this, graphics](int index, int count)
+  {
+    for (int i = index; i < index + count; ++i)
+      appendGraphic(graphics->at(i));
+  });
+
+  connect(m_sourceFeed.data(), &MessagesOverlay::graphicsUpdated, this, [this](const QList<Graphic*>& updatedGraphics)
+  {
+    for (Graphic* graphic : updatedGraphics)
+    {
+      auto findIt = m_rows.constFind(graphic);
+      if (findIt != m_rows.constEnd())
+        markDirty(findIt.value());
+    }
+  });
+
+  connect(m_sourceFeed.data(), &MessagesOverlay::graphicsRemoved, this, [this](const QList<Graphic*>& removedGraphics)
+  {
+    for (Graphic* graphic : removedGraphics)
+      removeGraphic(graphic);
+  });
+
+  connect(m_target.data(), &AlertTarget::dataChanged, this, &AlertConditionAggregate::markAllDirty);
+  connect(m_target.data(), &AlertTarget::destroyed, this, &AlertConditionAggregate::deactivateAll);
+
+  const int count = graphics->rowCount();
+  m_graphics.reserve(count);
+  m_dirty.reserve(count);
+  m_active.reserve(count);
+  m_materialized.reserve(count);
+  m_changedTimes.reserve(count);
+  for (int i = 0; i < count; ++i)
+    appendGraphic(graphics->at(i));
+}
+
+/*!
+  \brief Destructor.
+ */
+AlertConditionAggregate::~AlertConditionAggregate()
+{
+}
+
+/*!
+  \brief Returns the number of source graphics being evaluated.
+ */
+int AlertConditionAggregate::graphicCount() const
+{
+  return m_graphics.size();
+}
+
+/*!
+  \brief Returns the number of source graphics which currently meet the condition.
+ */
+int AlertConditionAggregate::activeCount() const
+{
+  return m_activeCount;
+}
+
+/*!
+  \brief Returns whether the condition is evaluated.
+ */
+bool AlertConditionAggregate::isEnabled() const
+{
+  return m_enabled;
+}
+
+/*!
+  \brief Sets whether the condition is evaluated to \a enabled.
+
+  Disabling the aggregate destroys any materialized condition data. Re-enabling it
+  re-evaluates every row.
+ */
+void AlertConditionAggregate::setEnabled(bool enabled)
+{
+  if (m_enabled == enabled)
+    return;
+
+  m_enabled = enabled;
+
+  if (m_enabled)
+  {
+    markAllDirty();
+    return;
+  }
+
+  m_timer->stop();
+  m_dwellTimer->stop();
+  m_heldRows.clear();
+  deactivateAll();
+}
+
+/*!
+  \brief Returns whether the rows take their state from a peer rather than being evaluated.
+ */
+bool AlertConditionAggregate::isRemote() const
+{
+  return m_remote;
+}
+
+/*!
+  \brief Sets whether the rows take their state from a peer, rather than being evaluated, to \a remote.
+
+  The rows keep their state when this changes. Once they are evaluated locally again,
+  every row is re-evaluated.
+ */
+void AlertConditionAggregate::setRemote(bool remote)
+{
+  if (m_remote == remote)
+    return;
+
+  m_remote = remote;
+
+  if (m_remote)
+  {
+    m_timer->stop();
+    m_dwellTimer->stop();
+    m_heldRows.clear();
+    for (const int row : qAsConst(m_dirtyRows))
+    {
+      if (row < m_dirty.size())
+        m_dirty[row] = 0;
+    }
+    m_dirtyRows.clear();
+    m_nextDirtyRow = 0;
+    return;
+  }
+
+  m_remoteActiveIds.clear();
+  markAllDirty();
+}
+
+/*!
+  \brief Applies the \a results of a peer, giving whether the source with each message
+  ID is active.
+
+  If \a fullState is \c true, the results list every active source and any other
+  source is inactive. Sources which have not arrived yet take their state once they do.
+  Nothing is applied unless the aggregate is \l isRemote.
+ */
+void AlertConditionAggregate::applyRemoteResults(const QHash<QString, bool>& results, bool fullState)
+{
+  if (!m_remote || !m_sourceFeed)
+    return;
+
+  if (fullState)
+    m_remoteActiveIds.clear();
+
+  for (auto it = results.constBegin(); it != results.constEnd(); ++it)
+  {
+    if (it.value())
+      m_remoteActiveIds.insert(it.key());
+    else
+      m_remoteActiveIds.remove(it.key());
+  }
+
+  if (!m_enabled || !m_target)
+    return;
+
+  if (fullState)
+  {
+    for (int row = 0; row < m_graphics.size(); ++row)
+      setRowActive(row, m_remoteActiveIds.contains(m_sourceFeed->messageId(m_graphics.at(row))));
+
+    return;
+  }
+
+  for (auto it = results.constBegin(); it != results.constEnd(); ++it)
+  {
+    const int row = m_rows.value(m_sourceFeed->graphicForMessageId(it.key()), -1);
+    if (row != -1)
+      setRowActive(row, it.value());
+  }
+}
+
+/*!
+  \brief Returns the message IDs of the sources which currently meet the condition.
+ */
+QStringList AlertConditionAggregate::activeSourceIds() const
+{
+  QStringList sourceIds;
+  if (!m_sourceFeed)
+    return sourceIds;
+
+  for (int row = 0; row < m_graphics.size(); ++row)
+  {
+    if (m_active.at(row))
+      sourceIds.append(m_sourceFeed->messageId(m_graphics.at(row)));
+  }
+
+  return sourceIds;
+}
+
+/*!
+  \brief Evaluates dirty rows until the \l AlertEvaluationScheduler frame budget is used.
+
+  Any remaining rows are evaluated after the scheduler's frame interval.
+ */
+void AlertConditionAggregate::evaluatePending()
+{
+  if (!m_enabled || m_remote || !m_target)
+    return;
+
+  const AlertEvaluationScheduler* scheduler = AlertEvaluationScheduler::instance();
+  const qint64 minimumDwell = m_condition->hysteresis().m_minimumDwellMsecs;
+  const qint64 now = m_clock.elapsed();
+
+  QElapsedTimer frameTimer;
+  frameTimer.start();
+
+  int evaluatedCount = 0;
+  while (m_nextDirtyRow < m_dirtyRows.size())
+  {
+    // always make progress, even if a single evaluation exceeds the budget
+    if (evaluatedCount > 0 && frameTimer.elapsed() >= scheduler->frameBudget())
+      break;
+
+    const int row = m_dirtyRows.at(m_nextDirtyRow++);
+
+    // rows can be listed more than once, or removed since they were listed
+    if (row >= m_graphics.size() || !m_dirty.at(row))
+      continue;
+
+    m_dirty[row] = 0;
+    ++evaluatedCount;
+
+    Graphic* graphic = m_graphics.at(row);
+    const bool active = m_active.at(row);
+    const AlertConditionData::QueryTask task =
+        m_condition->createAggregateQueryTask(graphic, GraphicAlertSource::graphicLocation(graphic), m_target, active);
+
+    const bool result = task && task();
+    if (result == active)
+      continue;
+
+    // keep the current state until it has lasted the minimum dwell time
+    const qint64 changedTime = m_changedTimes.at(row);
+    if (changedTime >= 0 && now - changedTime < minimumDwell)
+    {
+      holdRow(row, minimumDwell - (now - changedTime));
+      continue;
+    }
+
+    setRowActive(row, result);
+  }
+
+  if (m_nextDirtyRow < m_dirtyRows.size())
+  {
+    m_timer->start(scheduler->frameInterval());
+    return;
+  }
+
+  m_dirtyRows.clear();
+  m_nextDirtyRow = 0;
+}
+
+/*!
+  \internal
+
+  Adds a new row for \a graphic and marks it for evaluation.
+ */
+void AlertConditionAggregate::appendGraphic(Graphic* graphic)
+{
+  if (!graphic || m_rows.contains(graphic))
+    return;
+
+  const int row = m_graphics.size();
+  m_graphics.append(graphic);
+  m_dirty.append(0);
+  m_active.append(0);
+  m_materialized.append(nullptr);
+  m_changedTimes.append(-1);
+  m_rows.insert(graphic, row);
+
+  // a source the peer reported before it arrived here
+  if (m_remote)
+  {
+    if (m_enabled && m_target && m_sourceFeed && m_remoteActiveIds.contains(m_sourceFeed->messageId(graphic)))
+      setRowActive(row, true);
+
+    return;
+  }
+
+  markDirty(row);
+}
+
+/*!
+  \internal
+
+  Removes the row for \a graphic, by moving the last row into its place.
+ */
+void AlertConditionAggregate::removeGraphic(Graphic* graphic)
+{
+  auto findIt = m_rows.find(graphic);
+  if (findIt == m_rows.end())
+    return;
+
+  const int row = findIt.value();
+  m_rows.erase(findIt);
+
+  setRowActive(row, false);
+
+  const int lastRow = m_graphics.size() - 1;
+  if (row != lastRow)
+  {
+    m_graphics[row] = m_graphics.at(lastRow);
+    m_dirty[row] = m_dirty.at(lastRow);
+    m_active[row] = m_active.at(lastRow);
+    m_materialized[row] = m_materialized.at(lastRow);
+    m_changedTimes[row] = m_changedTimes.at(lastRow);
+    m_rows[m_graphics.at(row)] = row;
+
+    // the moved row is listed under its old position
+    if (m_dirty.at(row))
+      m_dirtyRows.append(row);
+  }
+
+  m_graphics.removeLast();
+  m_dirty.removeLast();
+  m_active.removeLast();
+  m_materialized.removeLast();
+  m_changedTimes.removeLast();
+}
+
+/*!
+  \internal
+
+  Marks \a row for evaluation once control returns to the event loop.
+ */
+void AlertConditionAggregate::markDirty(int row)
+{
+  if (!m_enabled || m_remote || m_dirty.at(row))
+    return;
+
+  m_dirty[row] = 1;
+  m_dirtyRows.append(row);
+
+  if (!m_timer->isActive())
+    m_timer->start(0);
+}
+
+/*!
+  \brief Marks every row for evaluation, for example when the target or the
+  hysteresis of the condition changes.
+ */
+void AlertConditionAggregate::markAllDirty()
+{
+  for (int row = 0; row < m_graphics.size(); ++row)
+    markDirty(row);
+}
+
+/*!
+  \internal
+
+  Sets the active state of \a row to \a active, materializing or destroying its
+  condition data.
+ */
+void AlertConditionAggregate::setRowActive(int row, bool active)
+{
+  if (static_cast<bool>(m_active.at(row)) == active)
+    return;
+
+  m_active[row] = active ? 1 : 0;
+  m_changedTimes[row] = m_clock.elapsed();
+
+  emit rowActiveChanged(m_graphics.at(row), active);
+
+  if (active)
+  {
+    ++m_activeCount;
+
+    // only active rows are given a condition data for the alert list
+    GraphicAlertSource* source = new GraphicAlertSource(m_graphics.at(row));
+    AlertConditionData* conditionData = m_condition->createData(source, m_target);
+    m_condition->addData(conditionData);
+    conditionData->applyQueryResult(true, conditionData->changeCount());
+    m_materialized[row] = conditionData;
+    return;
+  }
+
+  --m_activeCount;
+
+  AlertConditionData* conditionData = m_materialized.at(row);
+  m_materialized[row] = nullptr;
+  if (!conditionData)
+    return;
+
+  AlertSource* source = conditionData->source();
+  m_condition->removeData(conditionData);
+  delete conditionData;
+  delete source;
+}
+
+/*!
+  \internal
+
+  Holds the state of \a row for \a remaining milliseconds before it is evaluated again.
+ */
+void AlertConditionAggregate::holdRow(int row, qint64 remaining)
+{
+  m_heldRows.append(row);
+
+  const int delay = static_cast<int>(remaining);
+  if (!m_dwellTimer->isActive() || m_dwellTimer->remainingTime() > delay)
+    m_dwellTimer->start(delay);
+}
+
+/*!
+  \internal
+
+  Marks the held rows for evaluation. Rows which are still within their dwell time
+  are held again when they are evaluated.
+ */
+void AlertConditionAggregate::releaseHeldRows()
+{
+  QVector<int> heldRows;
+  heldRows.swap(m_heldRows);
+
+  for (const int row : heldRows)
+  {
+    // rows can be removed while they are held
+    if (row < m_graphics.size())
+      markDirty(row);
+  }
+}
+
+/*!
+  \internal
+
+  Clears the active state of every row.
+ */
+void AlertConditionAggregate::deactivateAll()
+{
+  for (int row = 0; row < m_graphics.size(); ++row)
+  {
+    setRowActive(row, false);
+    m_dirty[row] = 0;
+  }
+
+  m_dirtyRows.clear();
+  m_nextDirtyRow = 0;
+}
+
+} // Dsa
+
+// Signal Documentation
+/*!
+  \fn void AlertConditionAggregate::rowActiveChanged(Esri::ArcGISRuntime::Graphic* graphic, bool active);
+  \brief Signal emitted when the source \a graphic starts or stops meeting the condition,
+  according to \a active.
+ */
@@ -0,0 +1,117 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef ALERTCONDITIONAGGREGATE_H
+#define ALERTCONDITIONAGGREGATE_H
+
+// Qt headers
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class QTimer;
+
+namespace Esri {
+namespace ArcGISRuntime {
+class Graphic;
+}
+}
+
+namespace Dsa {
+
+class AlertCondition;
+class AlertConditionData;
+class AlertTarget;
+class MessagesOverlay;
+
+class AlertConditionAggregate : public QObject
+{
+  Q_OBJECT
+
+public:
+  AlertConditionAggregate(AlertCondition* condition,
+                          MessagesOverlay* sourceFeed,
+                          AlertTarget* target,
+                          QObject* parent = nullptr);
+  ~AlertConditionAggregate();
+
+  int graphicCount() const;
+  int activeCount() const;
+
+  bool isEnabled() const;
+  void setEnabled(bool enabled);
+
+  void evaluatePending();
+  void markAllDirty();
+
+  bool isRemote() const;
+  void setRemote(bool remote);
+  void applyRemoteResults(const QHash<QString, bool>& results, bool fullState);
+  QStringList activeSourceIds() const;
+
+signals:
+  void rowActiveChanged(Esri::ArcGISRuntime::Graphic* graphic, bool active);
+
+private:
+  Q_DISABLE_COPY(AlertConditionAggregate)
+
+  void appendGraphic(Esri::ArcGISRuntime::Graphic* graphic);
+  void removeGraphic(Esri::ArcGISRuntime::Graphic* graphic);
+  void markDirty(int row);
+  void holdRow(int row, qint64 remaining);
+  void releaseHeldRows();
+  void setRowActive(int row, bool active);
+  void deactivateAll();
+
+  AlertCondition* m_condition = nullptr;
+  QPointer<MessagesOverlay> m_sourceFeed;
+  QPointer<AlertTarget> m_target;
+  QTimer* m_timer = nullptr;
+  QTimer* m_dwellTimer = nullptr;
+  QElapsedTimer m_clock;
+  bool m_enabled = true;
+  bool m_remote = false;
+  int m_activeCount = 0;
+
+  // the message IDs of the sources a peer reports as active, while the peer evaluates
+  QSet<QString> m_remoteActiveIds;
+
+  // one row per source graphic, stored as parallel arrays
+  QVector<Esri::ArcGISRuntime::Graphic*> m_graphics;
+  QVector<unsigned char> m_dirty;
+  QVector<unsigned char> m_active;
+  QVector<AlertConditionData*> m_materialized;
+
+  // the time each row last changed its active state, or -1 if it never has
+  QVector<qint64> m_changedTimes;
+  QHash<Esri::ArcGISRuntime::Graphic*, int> m_rows;
+
+  QVector<int> m_dirtyRows;
+  int m_nextDirtyRow = 0;
+
+  // rows whose change of state is held for the minimum dwell time
+  QVector<int> m_heldRows;
+};
+
+} // Dsa
+
+#endif // ALERTCONDITIONAGGREGATE_H
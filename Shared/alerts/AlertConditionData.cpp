@@ -21,8 +21,15 @@
 
 // dsa app headers
 #include "AlertCondition.h"
+#include "AlertEvaluationScheduler.h"
+#include "AlertEvaluationStats.h"
 #include "AlertSource.h"
 #include "AlertTarget.h"
+#include "AllocationCounter.h"
+#include "TraceRecorder.h"
+
+// Qt headers
+#include <QTimer>
 
 using namespace Esri::ArcGISRuntime;
 
@@ -45,6 +52,11 @@ namespace Dsa {
   When either the source or target is changed for a given data element, the condition can be
   re-tested using an \l AlertQuery to determine whether an alert should be triggered.
 
+  To stop sources which hover around a boundary from toggling the alert, a \l Hysteresis can
+  be set. Spatial queries then only become active once the source is inside the threshold by
+  the entry band, and only stop being active once it is outside by the exit band. A change
+  of the active state is also held until the current state has lasted the minimum dwell time.
+
   \note This is an abstract base type.
 
   \sa AlertSource
@@ -96,6 +108,7 @@ AlertConditionData::AlertConditionData(const QString& name,
  */
 AlertConditionData::~AlertConditionData()
 {
+  AlertEvaluationScheduler::instance()->unschedule(this);
   emit noLongerValid();
 }
 
@@ -212,6 +225,23 @@ void AlertConditionData::setActive(bool active)
     return;
 
   m_active = active;
+  m_stateTimer.start();
+
+  emit activeChanged();
+}
+
+/*!
+  \internal
+
+  Returns the number of milliseconds until the current active state has lasted the
+  minimum dwell time. The state reached by the first query is not held.
+ */
+qint64 AlertConditionData::remainingDwell() const
+{
+  if (!m_stateTimer.isValid())
+    return 0;
+
+  return m_hysteresis.m_minimumDwellMsecs - m_stateTimer.elapsed();
 }
 
 /*!
@@ -260,17 +290,112 @@ bool AlertConditionData::isQueryOutOfDate() const
   \brief Internal.
 
   Respond to changes to the underlying source or target data.
+
+  The query is marked as out-of-date and the condition data is scheduled
+  to be evaluated by the \l AlertEvaluationScheduler, unless the query is
+  up-to-date and \l isChangeRelevant reports that the change cannot alter its result.
  */
 void AlertConditionData::handleDataChanged()
 {
+  DSA_TRACE_SCOPE("AlertConditionData::handleDataChanged");
+  DSA_ALLOCATION_SCOPE(Alerts);
+
   if (!isConditionEnabled())
     return;
 
+  if (!m_queryOutOfDate && !isChangeRelevant())
+  {
+    AlertEvaluationScheduler::instance()->stats()->recordDeferred();
+    return;
+  }
+
   // set the query flag to out-of-date to force a new query to be run
   m_queryOutOfDate = true;
 
+  // any query result which is still being calculated is now stale
+  ++m_changeCount;
+
+  AlertEvaluationScheduler::instance()->schedule(this);
+}
+
+/*!
+  \brief Returns whether the current source and target data could give a different
+  result from the last query.
+
+  This is called when the source or target data changes while the last query result
+  is still up-to-date. Condition data which can predict that a change cannot alter
+  the result (for example, because the source is still far from every target) can
+  return \c false so that no evaluation is scheduled. The default returns \c true.
+ */
+bool AlertConditionData::isChangeRelevant() const
+{
+  return true;
+}
+
+/*!
+  \brief Returns a function which runs the query for this condition data
+  against a snapshot of the current source and target data.
+
+  The snapshot is taken on the calling thread. The returned function only
+  uses the snapshot, so it can be run on a worker thread by the
+  \l AlertEvaluationScheduler and its result passed to \l applyQueryResult.
+
+  The default implementation returns an empty function, meaning that the
+  query should be run on the calling thread with \l evaluate.
+ */
+AlertConditionData::QueryTask AlertConditionData::queryTask() const
+{
+  return QueryTask();
+}
+
+/*!
+  \brief Runs the query for this condition data if it is out-of-date and
+  updates the active state.
+
+  This is normally called by the \l AlertEvaluationScheduler.
+ */
+void AlertConditionData::evaluate()
+{
+  if (!isEvaluationRequired())
+    return;
+
   // run the query and cache whether this condition has now been met
-  m_cachedQueryResult = matchesQuery();
+  applyQueryResult(matchesQuery(), m_changeCount);
+}
+
+/*!
+  \brief Returns whether the query for this condition data is out-of-date and can be run.
+ */
+bool AlertConditionData::isEvaluationRequired() const
+{
+  // the source or target may have been destroyed since this was scheduled
+  return isConditionEnabled() && m_queryOutOfDate && m_source && m_target;
+}
+
+/*!
+  \brief Returns the number of times the source or target data has changed.
+
+  This identifies the data a query was run against, so that results which
+  arrive after a further change can be discarded.
+ */
+int AlertConditionData::changeCount() const
+{
+  return m_changeCount;
+}
+
+/*!
+  \brief Updates the active state from the query \a result.
+
+  \a changeCount is the \l changeCount when the query was run. If the source
+  or target data has changed since then, the result is discarded and the
+  query remains out-of-date.
+ */
+void AlertConditionData::applyQueryResult(bool result, int changeCount)
+{
+  if (changeCount != m_changeCount || !isConditionEnabled())
+    return;
+
+  m_cachedQueryResult = result;
 
   // the query is now up-to-date
   m_queryOutOfDate = false;
@@ -279,6 +404,25 @@ void AlertConditionData::handleDataChanged()
   if (m_active == m_cachedQueryResult)
     return;
 
+  // hold the current state for the minimum dwell time, and then apply the latest result
+  const qint64 remaining = remainingDwell();
+  if (remaining > 0)
+  {
+    if (m_dwellPending)
+      return;
+
+    m_dwellPending = true;
+    QTimer::singleShot(static_cast<int>(remaining), this, [this]()
+    {
+      m_dwellPending = false;
+
+      // an out-of-date result is applied once the new query has run
+      if (!m_queryOutOfDate)
+        applyQueryResult(m_cachedQueryResult, m_changeCount);
+    });
+    return;
+  }
+
   // update the new active state
   setActive(m_cachedQueryResult);
 
@@ -325,6 +469,82 @@ void AlertConditionData::setConditionEnabled(bool enabled)
   emit dataChanged();
 }
 
+/*!
+  \class Dsa::AlertConditionData::Hysteresis
+  \inmodule Dsa
+  \brief The bands and dwell time which stop a condition data from toggling when its
+  source hovers around a boundary.
+
+  \list
+    \li \c m_entryMeters. How far inside the threshold a source must be to become active.
+    \li \c m_exitMeters. How far outside the threshold an active source must be to stop being active.
+    \li \c m_minimumDwellMsecs. How long the active state is held before it can change again.
+  \endlist
+ */
+
+/*!
+  \brief Returns the offset, in meters, to apply to a spatial threshold for a condition
+  data which is \a active.
+
+  This is negative by the entry band when not active and positive by the exit band when active.
+ */
+double AlertConditionData::Hysteresis::thresholdOffset(bool active) const
+{
+  return active ? m_exitMeters : -m_entryMeters;
+}
+
+/*!
+  \brief Returns the hysteresis applied to this condition data.
+ */
+AlertConditionData::Hysteresis AlertConditionData::hysteresis() const
+{
+  return m_hysteresis;
+}
+
+/*!
+  \brief Sets the \a hysteresis applied to this condition data.
+
+  The query is re-evaluated with the new bands.
+ */
+void AlertConditionData::setHysteresis(const Hysteresis& hysteresis)
+{
+  if (hysteresis.m_entryMeters == m_hysteresis.m_entryMeters &&
+      hysteresis.m_exitMeters == m_hysteresis.m_exitMeters &&
+      hysteresis.m_minimumDwellMsecs == m_hysteresis.m_minimumDwellMsecs)
+  {
+    return;
+  }
+
+  m_hysteresis = hysteresis;
+
+  // the last result used the old bands, so it cannot be deferred
+  invalidateQuery();
+}
+
+/*!
+  \brief Marks the last query result as out-of-date and schedules a new query.
+
+  This is for changes to the data which a query uses other than the source and
+  target, such as a cached analysis result. Unlike a change to the source or
+  target, it is never deferred by \l isChangeRelevant.
+ */
+void AlertConditionData::invalidateQuery()
+{
+  m_queryOutOfDate = true;
+  handleDataChanged();
+}
+
+/*!
+  \brief Returns the offset, in meters, which spatial queries add to their threshold
+  for the current active state.
+
+  \sa Hysteresis::thresholdOffset
+ */
+double AlertConditionData::thresholdOffset() const
+{
+  return m_hysteresis.thresholdOffset(m_active);
+}
+
 /*!
   \brief Returns the active state of this conditiom data.
   
@@ -332,8 +552,9 @@ void AlertConditionData::setConditionEnabled(bool enabled)
  */
 bool AlertConditionData::isActive() const
 {
-  if (m_queryOutOfDate)
-    const_cast<AlertConditionData*>(this)->handleDataChanged();
+  // make sure an out-of-date query is evaluated, without discarding one which is already running
+  if (m_queryOutOfDate && isConditionEnabled())
+    AlertEvaluationScheduler::instance()->schedule(const_cast<AlertConditionData*>(this));
 
   return m_active;
 }
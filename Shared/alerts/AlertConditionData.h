@@ -24,10 +24,14 @@
 #include "Point.h"
 
 // Qt headers
+#include <QElapsedTimer>
 #include <QObject>
 #include <QString>
 #include <QUuid>
 
+// STL headers
+#include <functional>
+
 namespace Dsa {
 
 class AlertSource;
@@ -38,6 +42,17 @@ class AlertConditionData : public QObject
   Q_OBJECT
 
 public:
+  using QueryTask = std::function<bool()>;
+
+  struct Hysteresis
+  {
+    double m_entryMeters = 0.0;
+    double m_exitMeters = 0.0;
+    int m_minimumDwellMsecs = 0;
+
+    double thresholdOffset(bool active) const;
+  };
+
   AlertConditionData(const QString& name, AlertLevel level, AlertSource* source, AlertTarget* target, QObject* parent = nullptr);
   ~AlertConditionData();
 
@@ -63,6 +78,12 @@ public:
   AlertTarget* target() const;
 
   virtual bool matchesQuery() const = 0;
+  virtual QueryTask queryTask() const;
+  void evaluate();
+
+  bool isEvaluationRequired() const;
+  int changeCount() const;
+  void applyQueryResult(bool result, int changeCount);
 
   bool cachedQueryResult() const;
   bool isQueryOutOfDate() const;
@@ -70,6 +91,11 @@ public:
   bool isConditionEnabled() const;
   void setConditionEnabled(bool isConditionEnabled);
 
+  Hysteresis hysteresis() const;
+  void setHysteresis(const Hysteresis& hysteresis);
+
+  void invalidateQuery();
+
 signals:
   void statusChanged();
   void viewedChanged();
@@ -77,11 +103,16 @@ signals:
   void activeChanged();
   void noLongerValid();
 
-private slots:
+protected slots:
   void handleDataChanged();
 
+protected:
+  virtual bool isChangeRelevant() const;
+  double thresholdOffset() const;
+
 private:
   void setActive(bool active);
+  qint64 remainingDwell() const;
 
   QString m_name;
   AlertLevel m_level = AlertLevel::Unknown;
@@ -92,7 +123,11 @@ private:
   bool m_viewed = false;
   bool m_active = false;
   bool m_queryOutOfDate = true;
+  int m_changeCount = 0;
   mutable bool m_cachedQueryResult = false;
+  Hysteresis m_hysteresis;
+  QElapsedTimer m_stateTimer;
+  bool m_dwellPending = false;
 };
 
 } // Dsa
@@ -25,18 +25,20 @@
 #include "AlertConditionListModel.h"
 #include "AlertConstants.h"
 #include "AlertListModel.h"
+#include "AlertResultSharing.h"
 #include "AttributeEqualsAlertCondition.h"
 #include "FeatureLayerAlertTarget.h"
 #include "FixedValueAlertTarget.h"
 #include "GeoElementAlertTarget.h"
 #include "GraphicsOverlayAlertTarget.h"
-#include "GraphicsOverlaysResultsManager.h"
-#include "LayerResultsManager.h"
 #include "LocationAlertSource.h"
+#include "LayerCacheManager.h"
 #include "LocationAlertTarget.h"
 #include "MessageFeedConstants.h"
+#include "UdpTransport.h"
 #include "WithinAreaAlertCondition.h"
 #include "WithinDistanceAlertCondition.h"
+#include "WithinViewAlertCondition.h"
 
 // toolkit headers
 #include "ToolManager.h"
@@ -56,10 +58,60 @@
 #include <QJsonArray>
 #include <QJsonObject>
 
+// STL headers
+#include <algorithm>
+
 using namespace Esri::ArcGISRuntime;
 
 namespace Dsa {
 
+namespace
+{
+// the name of the layer or overlay in a target description such as "Tracks [3]"
+QString targetLayerName(const QString& targetDescription)
+{
+  if (targetDescription.contains('[') && targetDescription.endsWith(']'))
+    return targetDescription.left(targetDescription.indexOf('[')).trimmed();
+
+  return targetDescription;
+}
+
+// edits the rows of model into names with inserts and removals rather than a reset
+void updateStringListModel(QStringListModel* model, const QStringList& names)
+{
+  for (int row = 0; row < names.size(); ++row)
+  {
+    const QString& name = names.at(row);
+    if (row < model->rowCount() && model->index(row).data().toString() == name)
+      continue;
+
+    // drop the rows up to a later match, or else insert the new name
+    int match = -1;
+    for (int i = row + 1; i < model->rowCount(); ++i)
+    {
+      if (model->index(i).data().toString() == name)
+      {
+        match = i;
+        break;
+      }
+    }
+
+    if (match != -1)
+    {
+      model->removeRows(row, match - row);
+    }
+    else
+    {
+      model->insertRows(row, 1);
+      model->setData(model->index(row), name);
+    }
+  }
+
+  if (model->rowCount() > names.size())
+    model->removeRows(names.size(), model->rowCount() - names.size());
+}
+}
+
 /*!
   \class Dsa::AlertConditionsController
   \inmodule Dsa
@@ -73,9 +125,20 @@ namespace Dsa {
 
   This tool allows new \l AlertConditions of various types to be created.
 
+  Conditions stored in the app properties stay dormant until the layer or
+  overlay they watch, and the feed they use as a source, have been added to
+  the view and loaded. Each condition is then created as soon as the last of
+  them appears, without revisiting the others.
+
+  The source and target name models are edited row by row as layers and
+  overlays come and go. While the \l LayerCacheManager restores saved layers,
+  the models and stored conditions are brought up to date once, when the
+  restore completes.
+
   \sa AlertConditionListModel
   \sa WithinAreaAlertCondition
   \sa WithinDistanceAlertCondition
+  \sa WithinViewAlertCondition
  */
 
 /*!
@@ -93,10 +156,30 @@ AlertConditionsController::AlertConditionsController(QObject* parent /* = nullpt
   connect(ToolResourceProvider::instance(), &ToolResourceProvider::geoViewChanged,
           this, &AlertConditionsController::onGeoviewChanged);
 
-  connect(m_conditions, &AlertConditionListModel::rowsInserted, this, &AlertConditionsController::onConditionsChanged);
-  connect(m_conditions, &AlertConditionListModel::rowsRemoved, this, &AlertConditionsController::onConditionsChanged);
-  connect(m_conditions, &AlertConditionListModel::modelReset, this, &AlertConditionsController::onConditionsChanged);
-  connect(m_conditions, &AlertConditionListModel::dataChanged, this, &AlertConditionsController::onConditionsChanged);
+  // only the conditions which have changed are serialized again, once per pass of the event loop
+  connect(m_conditions, &AlertConditionListModel::rowsInserted, this, [this](const QModelIndex&, int first, int last)
+  {
+    markConditionsChanged(first, last);
+  });
+  connect(m_conditions, &AlertConditionListModel::rowsRemoved, this, &AlertConditionsController::scheduleConditionsChanged);
+  connect(m_conditions, &AlertConditionListModel::modelReset, this, [this]()
+  {
+    m_conditionsJson.clear();
+    scheduleConditionsChanged();
+  });
+  connect(m_conditions, &AlertConditionListModel::dataChanged, this, [this](const QModelIndex& topLeft, const QModelIndex& bottomRight)
+  {
+    markConditionsChanged(topLeft.row(), bottomRight.row());
+  });
+
+  connect(m_conditions, &AlertConditionListModel::rowsInserted, this, [this](const QModelIndex&, int first, int last)
+  {
+    if (!m_resultSharing)
+      return;
+
+    for (int row = first; row <= last; ++row)
+      m_resultSharing->addCondition(m_conditions->conditionAt(row));
+  });
 
   onGeoviewChanged();
 
@@ -125,6 +208,8 @@ QString AlertConditionsController::toolName() const
  * \list
  *  \li Conditions. A list of JSON objects describing alert conditions to be added to the map.
  *  \li MessageFeeds. A list of real-time feeds to be used as condition sources.
+ *  \li AlertResultSharingPort. The UDP port on which the results of conditions are
+ *      shared with peers; see \l AlertResultSharing.
  * \endlist
  */
 void AlertConditionsController::setProperties(const QVariantMap& properties)
@@ -148,9 +233,11 @@ void AlertConditionsController::setProperties(const QVariantMap& properties)
       m_messageFeedTypesToNames.insert(feedType, feedName);
     }
 
-    onLayersChanged();
+    updateNames();
   }
 
+  setupResultSharing(properties);
+
   if (conditionsData.isNull())
     return;
 
@@ -194,8 +281,9 @@ void AlertConditionsController::setActive(bool active)
   if (active == m_active)
     return;
 
-  if (m_identifyLayersWatcher.isValid() && !m_identifyLayersWatcher.isDone() && !m_identifyLayersWatcher.isCanceled())
-    m_identifyLayersWatcher.cancel();
+  ToolResourceProvider::instance()->cancelIdentify(this);
+  m_identifyLayersTaskId = QUuid();
+  m_identifyGraphicsTaskId = QUuid();
 
   m_active = active;
   emit activeChanged();
@@ -280,6 +368,84 @@ bool AlertConditionsController::addWithinDistanceAlert(const QString& conditionN
   return m_conditions->addAlertCondition(condition);
 }
 
+/*!
+  \brief Adds a \l WithinViewAlertCondition to the list of conditions.
+
+  \list
+    \li \a conditionName. The name for the condition.
+    \li \a levelIndex. The \l AlertLevel for the condition.
+    \li \a sourceFeedName. The name of the source feed (e.g. "My Location" or the
+      name of a \l Esri::ArcGISRuntime::GraphicsOverlay) used to create an \l AlertSource.
+    \li \a range. The range in meters which the observers of the target can see.
+    \li \a itemId. The item id for the target. If \c -1, then all items in the target will be used.
+      In the case where the target is a \l Esri::ArcGISRuntime::GraphicsOverlay, the  id should be the
+      index of the graphic. In the case where the target is a \l Esri::ArcGISRuntime::FeatureLayer, the
+      id should be the primary key value (e.g. the OID).
+    \li \a targetOverlayIndex. The index of the target for the condition in the \l targetNames list. A target can be either
+    a \l Esri::ArcGISRuntime::GraphicsOverlay or a \l Esri::ArcGISRuntime::FeatureLayer.
+  \endlist
+
+  The observers are the point geometries of the target, which can see a source when
+  it lies in their viewshed.
+
+  Returns \c true if the condition was successfully added.
+ */
+bool AlertConditionsController::addWithinViewAlert(const QString& conditionName,
+                                                   int levelIndex,
+                                                   const QString& sourceFeedName,
+                                                   double range,
+                                                   int itemId,
+                                                   int targetOverlayIndex)
+{
+  if (levelIndex < 0 ||
+      sourceFeedName.isEmpty() ||
+      range <= 0.0 ||
+      targetOverlayIndex < 0)
+  {
+    emit toolErrorOccurred(QStringLiteral("Failed to create Condition"), QStringLiteral("Invalid inputs"));
+    return false;
+  }
+
+  AlertLevel level = static_cast<AlertLevel>(levelIndex);
+  if (level > AlertLevel::Critical)
+  {
+    emit toolErrorOccurred(QStringLiteral("Failed to create Condition"), QStringLiteral("Invalid Alert Level"));
+    return false;
+  }
+
+  QString targetDescription;
+  AlertTarget* target = targetFromItemIdAndIndex(itemId, targetOverlayIndex, targetDescription);
+  if (!target)
+  {
+    emit toolErrorOccurred(QStringLiteral("Failed to create Condition"), QStringLiteral("Invalid Target"));
+    return false;
+  }
+
+  WithinViewAlertCondition* condition = new WithinViewAlertCondition(level, conditionName, range, this);
+  connect(condition, &WithinViewAlertCondition::newConditionData, this, &AlertConditionsController::handleNewAlertConditionData);
+
+  if (sourceFeedName == AlertConstants::MY_LOCATION)
+  {
+    condition->init(m_locationSource, target, AlertConstants::MY_LOCATION, targetDescription);
+  }
+  else
+  {
+    GraphicsOverlay* sourceOverlay = graphicsOverlayFromName(sourceFeedName);
+    if (sourceOverlay)
+    {
+      condition->init(sourceOverlay, sourceFeedName, target, targetDescription);
+    }
+    else
+    {
+      emit toolErrorOccurred(QStringLiteral("Failed to create Condition"), QString("Could not find source feed: %1").arg(sourceFeedName));
+      delete condition;
+      return false;
+    }
+  }
+
+  return m_conditions->addAlertCondition(condition);
+}
+
 /*!
   \brief Adds a \l WithinAreaAlertCondition to the list of conditions.
 
@@ -430,20 +596,21 @@ void AlertConditionsController::togglePickMode()
 
   if (m_pickMode)
   {
-    m_mouseClickConnection = connect(ToolResourceProvider::instance(), &ToolResourceProvider::mouseClicked,
-                                     this, &AlertConditionsController::onMouseClicked);
-
-    m_identifyLayersConnection =  connect(ToolResourceProvider::instance(), &ToolResourceProvider::identifyLayersCompleted,
-                                          this, &AlertConditionsController::onIdentifyLayersCompleted);
-
-    m_identifyGraphicsConnection =  connect(ToolResourceProvider::instance(), &ToolResourceProvider::identifyGraphicsOverlaysCompleted,
-                                            this, &AlertConditionsController::onIdentifyGraphicsOverlaysCompleted);
+    ToolResourceProvider::instance()->setMouseFocus(this, ToolResourceProvider::MouseEventType::Clicked,
+                                                    ToolResourceProvider::PickMousePriority,
+                                                    [this](ToolResourceProvider::MouseEventType, QMouseEvent& event)
+    {
+      return onMouseClicked(event);
+    });
   }
   else
   {
-    disconnect(m_mouseClickConnection);
-    disconnect(m_identifyLayersConnection);
-    disconnect(m_identifyGraphicsConnection);
+    ToolResourceProvider::instance()->clearMouseFocus(this);
+
+    // any pick which is still running is no longer wanted
+    ToolResourceProvider::instance()->cancelIdentify(this);
+    m_identifyLayersTaskId = QUuid();
+    m_identifyGraphicsTaskId = QUuid();
   }
 
   emit pickModeChanged();
@@ -548,28 +715,163 @@ void AlertConditionsController::onGeoviewChanged()
   LayerListModel* operationalLayers = ToolResourceProvider::instance()->operationalLayers();
   if (operationalLayers)
   {
-    connect(operationalLayers, &LayerListModel::layerAdded, this, &AlertConditionsController::onLayersChanged);
-    connect(operationalLayers, &LayerListModel::layerRemoved, this, &AlertConditionsController::onLayersChanged);
+    connect(operationalLayers, &LayerListModel::layerAdded, this, &AlertConditionsController::onLayerAdded, Qt::UniqueConnection);
+    connect(operationalLayers, &LayerListModel::layerRemoved, this, &AlertConditionsController::onLayerRemoved, Qt::UniqueConnection);
+
+    // layers which are still loading become targets once they have loaded
+    const int opLayersCount = operationalLayers->rowCount();
+    for (int i = 0; i < opLayersCount; ++i)
+    {
+      FeatureLayer* featLayer = qobject_cast<FeatureLayer*>(operationalLayers->at(i));
+      if (featLayer && featLayer->loadStatus() != LoadStatus::Loaded)
+        connect(featLayer, &FeatureLayer::doneLoading, this, &AlertConditionsController::onFeatureLayerLoaded, Qt::UniqueConnection);
+    }
   }
 
   GraphicsOverlayListModel* graphicsOverlays = geoView->graphicsOverlays();
   if (graphicsOverlays)
   {
-    connect(graphicsOverlays, &GraphicsOverlayListModel::graphicsOverlayAdded, this, &AlertConditionsController::onLayersChanged);
-    connect(graphicsOverlays, &GraphicsOverlayListModel::graphicsOverlayRemoved, this, &AlertConditionsController::onLayersChanged);
+    connect(graphicsOverlays, &GraphicsOverlayListModel::graphicsOverlayAdded, this, &AlertConditionsController::onGraphicsOverlayAdded, Qt::UniqueConnection);
+    connect(graphicsOverlays, &GraphicsOverlayListModel::graphicsOverlayRemoved, this, &AlertConditionsController::onGraphicsOverlayRemoved, Qt::UniqueConnection);
   }
 
-  onLayersChanged();
+  updateNames();
+  addStoredConditions();
+}
+
+/*!
+  \brief internal
+
+  Handle \a layer being added to the operational layers. A feature layer
+  becomes a target once it has loaded.
+ */
+void AlertConditionsController::onLayerAdded(Layer* layer)
+{
+  FeatureLayer* featLayer = qobject_cast<FeatureLayer*>(layer);
+  if (!featLayer)
+    return;
+
+  if (featLayer->loadStatus() != LoadStatus::Loaded)
+  {
+    connect(featLayer, &FeatureLayer::doneLoading, this, &AlertConditionsController::onFeatureLayerLoaded, Qt::UniqueConnection);
+    return;
+  }
+
+  onNameAvailable(featLayer->name());
+}
+
+/*!
+  \brief internal
+
+  Handle a layer being removed from the operational layers.
+ */
+void AlertConditionsController::onLayerRemoved(Layer*)
+{
+  if (deferUntilLayersRestored())
+    return;
+
+  updateNames();
+}
+
+/*!
+  \brief internal
+
+  Handle a feature layer which was added while loading finishing loading with \a error.
+ */
+void AlertConditionsController::onFeatureLayerLoaded(const Error& error)
+{
+  FeatureLayer* featLayer = qobject_cast<FeatureLayer*>(sender());
+  if (!featLayer || !error.isEmpty())
+    return;
+
+  onNameAvailable(featLayer->name());
+}
+
+/*!
+  \brief internal
+
+  Handle the graphics overlay at \a index being added to the geoView.
+ */
+void AlertConditionsController::onGraphicsOverlayAdded(int index)
+{
+  GeoView* geoView = ToolResourceProvider::instance()->geoView();
+  if (!geoView || !geoView->graphicsOverlays())
+    return;
+
+  GraphicsOverlay* overlay = geoView->graphicsOverlays()->at(index);
+  if (!overlay || overlay->overlayId().isEmpty())
+    return;
+
+  if (overlay->overlayId() == QStringLiteral("SCENEVIEWLOCATIONOVERLAY"))
+    onNameAvailable(AlertConstants::MY_LOCATION);
+  else
+    onNameAvailable(m_messageFeedTypesToNames.value(overlay->overlayId(), overlay->overlayId()));
+}
+
+/*!
+  \brief internal
+
+  Handle a graphics overlay being removed from the geoView.
+ */
+void AlertConditionsController::onGraphicsOverlayRemoved(int)
+{
+  if (deferUntilLayersRestored())
+    return;
+
+  updateNames();
 }
 
 /*!
   \brief internal
 
-  Handle changes to the list of layers and graphics overlays in the geoView.
+  Handle the layer or overlay called \a name becoming available as a source
+  or target, activating only the stored conditions which depend on it.
+ */
+void AlertConditionsController::onNameAvailable(const QString& name)
+{
+  if (deferUntilLayersRestored())
+    return;
+
+  updateNames();
+  addStoredConditions(name);
+}
+
+/*!
+  \brief internal
+
+  Returns whether saved layers are being restored, in which case the names
+  are updated by \l onLayersRestored once the restore completes.
+ */
+bool AlertConditionsController::deferUntilLayersRestored()
+{
+  LayerCacheManager* cacheManager = ToolManager::instance().tool<LayerCacheManager>();
+  if (!cacheManager || !cacheManager->isRestoring())
+    return false;
+
+  connect(cacheManager, &LayerCacheManager::restoreCompleted, this, &AlertConditionsController::onLayersRestored, Qt::UniqueConnection);
+  return true;
+}
+
+/*!
+  \brief internal
+
+  Handle the saved layers having been restored, updating the names and
+  stored conditions once for all of them.
+ */
+void AlertConditionsController::onLayersRestored()
+{
+  updateNames();
+  addStoredConditions();
+}
+
+/*!
+  \brief internal
+
+  Update the source and target names from the layers and graphics overlays in the geoView.
 
   These data types are the underlying data for \l AlertSource and \l AlertTarget.
  */
-void AlertConditionsController::onLayersChanged()
+void AlertConditionsController::updateNames()
 {
   GeoView* geoView = ToolResourceProvider::instance()->geoView();
   if (!geoView)
@@ -595,9 +897,7 @@ void AlertConditionsController::onLayersChanged()
       if (!featLayer)
         continue;
 
-      if (featLayer->loadStatus() != LoadStatus::Loaded)
-        connect(featLayer, &FeatureLayer::doneLoading, this, &AlertConditionsController::onLayersChanged);
-      else
+      if (featLayer->loadStatus() == LoadStatus::Loaded)
       {
         newTargetList.append(featLayer->name());
         existingLayerIds.append(featLayer->name());
@@ -653,40 +953,46 @@ void AlertConditionsController::onLayersChanged()
 
   setSourceNames(newSourceList);
   setTargetNames(newTargetList);
-  addStoredConditions();
 }
 
 /*!
   \brief internal
 
   Handle mouse click events in the view. If active, this will attenpt to pick
-  graphics or features.
+  graphics or features. Returns whether the click was used for the pick.
  */
-void AlertConditionsController::onMouseClicked(QMouseEvent &event)
+bool AlertConditionsController::onMouseClicked(QMouseEvent &event)
 {
   if (!isActive())
-    return;
+    return false;
 
   if (event.button() != Qt::MouseButton::LeftButton)
-    return;
+    return false;
 
   if (!m_pickMode)
-    return;
-
-  if (m_identifyLayersWatcher.isValid() && !m_identifyLayersWatcher.isDone())
-    return;
+    return false;
 
-  if (m_identifyGraphicsWatcher.isValid() && !m_identifyGraphicsWatcher.isDone())
-    return;
+  // a click while a pick is running is still part of picking
+  if (!m_identifyLayersTaskId.isNull() || !m_identifyGraphicsTaskId.isNull())
+    return true;
 
-  GeoView* geoView = ToolResourceProvider::instance()->geoView();
-  if (!geoView)
-    return;
+  ToolResourceProvider* resourceProvider = ToolResourceProvider::instance();
+  if (!resourceProvider->geoView())
+    return false;
 
-  m_identifyLayersWatcher = geoView->identifyLayers(event.pos().x(), event.pos().y(), m_tolerance, false);
-  m_identifyGraphicsWatcher = geoView->identifyGraphicsOverlays(event.pos().x(), event.pos().y(), m_tolerance, false);
+  m_identifyLayersTaskId = resourceProvider->identifyLayers(this, event.pos().x(), event.pos().y(), m_tolerance, false, -1,
+                                                            [this](const QList<IdentifyLayerResult*>& identifyResults)
+  {
+    onIdentifyLayersCompleted(identifyResults);
+  });
+  m_identifyGraphicsTaskId = resourceProvider->identifyGraphicsOverlays(this, event.pos().x(), event.pos().y(), m_tolerance, false, -1,
+                                                                        [this](const QList<IdentifyGraphicsOverlayResult*>& identifyResults)
+  {
+    onIdentifyGraphicsOverlaysCompleted(identifyResults);
+  });
 
   event.accept();
+  return true;
 }
 
 /*!
@@ -694,20 +1000,15 @@ void AlertConditionsController::onMouseClicked(QMouseEvent &event)
 
   Handle the result of an identify layers task.
  */
-void AlertConditionsController::onIdentifyLayersCompleted(const QUuid& taskId, QList<IdentifyLayerResult*> identifyResults)
+void AlertConditionsController::onIdentifyLayersCompleted(const QList<IdentifyLayerResult*>& identifyResults)
 {
-  if (taskId != m_identifyLayersWatcher.taskId())
-    return;
-
-  LayerResultsManager resultsManager(identifyResults);
+  m_identifyLayersTaskId = QUuid();
 
   if (!isActive())
     return;
 
-  m_identifyLayersWatcher = TaskWatcher();
-
-  auto it = resultsManager.m_results.begin();
-  auto itEnd = resultsManager.m_results.end();
+  auto it = identifyResults.cbegin();
+  auto itEnd = identifyResults.cend();
   for (; it != itEnd; ++it)
   {
     IdentifyLayerResult* res = *it;
@@ -745,15 +1046,15 @@ void AlertConditionsController::onIdentifyLayersCompleted(const QUuid& taskId, Q
       if (!atts->containsAttribute(primaryKeyField))
         continue;
 
-      m_identifyGraphicsWatcher.cancel();
-      m_identifyGraphicsWatcher = TaskWatcher();
+      ToolResourceProvider::instance()->cancelIdentify(this);
+      m_identifyGraphicsTaskId = QUuid();
       emit pickedElement(layerName, atts->attributeValue(primaryKeyField).toInt());
 
       break;
     }
   }
 
-  if (!m_identifyGraphicsWatcher.isValid() || m_identifyGraphicsWatcher.isDone() || m_identifyGraphicsWatcher.isCanceled())
+  if (m_identifyGraphicsTaskId.isNull())
     togglePickMode();
 }
 
@@ -762,20 +1063,15 @@ void AlertConditionsController::onIdentifyLayersCompleted(const QUuid& taskId, Q
 
   Handle the result of an identify graphic overlays task.
  */
-void AlertConditionsController::onIdentifyGraphicsOverlaysCompleted(const QUuid& taskId, QList<IdentifyGraphicsOverlayResult*> identifyResults)
+void AlertConditionsController::onIdentifyGraphicsOverlaysCompleted(const QList<IdentifyGraphicsOverlayResult*>& identifyResults)
 {
-  if (taskId != m_identifyGraphicsWatcher.taskId())
-    return;
-
-  GraphicsOverlaysResultsManager resultsManager(identifyResults);
+  m_identifyGraphicsTaskId = QUuid();
 
   if (!isActive())
     return;
 
-  m_identifyGraphicsWatcher = TaskWatcher();
-
-  auto it = resultsManager.m_results.begin();
-  auto itEnd = resultsManager.m_results.end();
+  auto it = identifyResults.cbegin();
+  auto itEnd = identifyResults.cend();
   for (; it != itEnd; ++it)
   {
     IdentifyGraphicsOverlayResult* res = *it;
@@ -795,15 +1091,15 @@ void AlertConditionsController::onIdentifyGraphicsOverlaysCompleted(const QUuid&
 
       const int index = graphic->graphicsOverlay()->graphics()->indexOf(graphic);
 
-      m_identifyLayersWatcher.cancel();
-      m_identifyLayersWatcher = TaskWatcher();
+      ToolResourceProvider::instance()->cancelIdentify(this);
+      m_identifyLayersTaskId = QUuid();
       emit pickedElement(overlayName, index);
 
       break;
     }
   }
 
-  if (!m_identifyLayersWatcher.isValid() || m_identifyLayersWatcher.isDone() || m_identifyLayersWatcher.isCanceled())
+  if (m_identifyLayersTaskId.isNull())
     togglePickMode();
 }
 
@@ -815,33 +1111,83 @@ void AlertConditionsController::handleNewAlertConditionData(AlertConditionData*
   AlertListModel::instance()->addAlertConditionData(newConditionData);
 }
 
+/*!
+  \brief internal
+
+  Discards the cached JSON of the conditions in the rows \a first to \a last
+  and schedules \l onConditionsChanged.
+ */
+void AlertConditionsController::markConditionsChanged(int first, int last)
+{
+  for (int row = first; row <= last; ++row)
+  {
+    AlertCondition* condition = m_conditions->conditionAt(row);
+    if (condition)
+      m_conditionsJson.remove(condition);
+  }
+
+  scheduleConditionsChanged();
+}
+
+/*!
+  \brief internal
+
+  Calls \l onConditionsChanged once control returns to the event loop, so that
+  many changes to the conditions, such as restoring them at startup, are
+  reported together.
+ */
+void AlertConditionsController::scheduleConditionsChanged()
+{
+  if (m_conditionsChangeScheduled)
+    return;
+
+  m_conditionsChangeScheduled = true;
+  QMetaObject::invokeMethod(this, [this]()
+  {
+    onConditionsChanged();
+  }, Qt::QueuedConnection);
+}
+
 /*!
   \brief internal
 
   Reports that conditions have changed and emits a JSON representation of all
   active conditions.
 
+  The JSON of each condition is cached, so only the conditions which have changed
+  since the last call are serialized again.
+
   /sa AbstractTool::propertyChanged
  */
 void AlertConditionsController::onConditionsChanged()
 {
+  m_conditionsChangeScheduled = false;
+
   emit conditionsListChanged();
 
   QJsonArray allConditionsJson;
+  QHash<AlertCondition*, QJsonObject> conditionsJson;
   const int conditionsCount = m_conditions->rowCount();
+  conditionsJson.reserve(conditionsCount);
   for(int i = 0; i < conditionsCount; ++i)
   {
     AlertCondition* condition = m_conditions->conditionAt(i);
     if (condition == nullptr)
       continue;
 
-    const QJsonObject conditionJson = conditionToJson(condition);
+    const auto cachedIt = m_conditionsJson.constFind(condition);
+    const QJsonObject conditionJson = cachedIt != m_conditionsJson.constEnd() ? cachedIt.value()
+                                                                              : conditionToJson(condition);
+    conditionsJson.insert(condition, conditionJson);
     if (conditionJson.isEmpty())
       continue;
 
     allConditionsJson.append(conditionJson);
   }
 
+  // removed conditions are dropped from the cache
+  m_conditionsJson.swap(conditionsJson);
+
   for (const QJsonObject& unadded : m_storedConditions)
     allConditionsJson.append(unadded);
 
@@ -862,7 +1208,7 @@ void AlertConditionsController::setTargetNames(const QStringList& targetNames)
   if (existingNames == targetNames)
     return;
 
-  m_targetNames->setStringList(targetNames);
+  updateStringListModel(m_targetNames, targetNames);
   emit targetNamesChanged();
 }
 
@@ -880,10 +1226,38 @@ void AlertConditionsController::setSourceNames(const QStringList& sourceNames)
   if (existingNames == sourceNames)
     return;
 
-  m_sourceNames->setStringList(sourceNames);
+  updateStringListModel(m_sourceNames, sourceNames);
   emit sourceNamesChanged();
 }
 
+/*!
+  \brief internal
+
+  Starts sharing the results of the conditions with peers, if \a properties set a port.
+  This is only done once.
+ */
+void AlertConditionsController::setupResultSharing(const QVariantMap& properties)
+{
+  if (m_resultSharing)
+    return;
+
+  const quint16 port = properties.value(AlertConstants::ALERT_RESULT_SHARING_PORT_PROPERTYNAME).toUInt();
+  if (port == 0)
+    return;
+
+  m_resultSharing = new AlertResultSharing(this);
+  if (!m_resultSharing->start(UdpTransport::fromProperties(properties), port))
+  {
+    delete m_resultSharing;
+    m_resultSharing = nullptr;
+    emit toolErrorOccurred(QStringLiteral("Failed to listen for shared alert results"), QString::number(port));
+    return;
+  }
+
+  for (int row = 0; row < m_conditions->rowCount(); ++row)
+    m_resultSharing->addCondition(m_conditions->conditionAt(row));
+}
+
 /*!
   \brief internal
 
@@ -903,6 +1277,15 @@ QJsonObject AlertConditionsController::conditionToJson(AlertCondition* condition
   conditionJson.insert( AlertConstants::CONDITION_QUERY, queryObject);
   conditionJson.insert( AlertConstants::CONDITION_TARGET, condition->targetDescription());
 
+  // the hysteresis is only written when it is set, so that other conditions are unchanged
+  const AlertConditionData::Hysteresis hysteresis = condition->hysteresis();
+  if (hysteresis.m_entryMeters > 0.0)
+    conditionJson.insert( AlertConstants::CONDITION_ENTRY_BAND, hysteresis.m_entryMeters);
+  if (hysteresis.m_exitMeters > 0.0)
+    conditionJson.insert( AlertConstants::CONDITION_EXIT_BAND, hysteresis.m_exitMeters);
+  if (hysteresis.m_minimumDwellMsecs > 0)
+    conditionJson.insert( AlertConstants::CONDITION_MINIMUM_DWELL, hysteresis.m_minimumDwellMsecs);
+
   return conditionJson;
 }
 
@@ -934,8 +1317,9 @@ bool AlertConditionsController::addConditionFromJson(const QJsonObject& json)
   const bool isAttributeEquals = conditionType == AlertConstants::attributeEqualsAlertConditionType();
   const bool isWithinArea = conditionType == AlertConstants::withinAreaAlertConditionType();
   const bool isWithinDistance = conditionType == AlertConstants::withinDistanceAlertConditionType();
+  const bool isWithinView = conditionType == AlertConstants::withinViewAlertConditionType();
 
-  if (!isAttributeEquals && !isWithinArea && !isWithinDistance)
+  if (!isAttributeEquals && !isWithinArea && !isWithinDistance && !isWithinView)
     return false;
 
   auto levelIt = json.constFind(AlertConstants::CONDITION_LEVEL);
@@ -959,15 +1343,29 @@ bool AlertConditionsController::addConditionFromJson(const QJsonObject& json)
   QJsonObject queryObject = json.value(AlertConstants::CONDITION_QUERY).toObject();
   const QVariantMap queryComponents = queryObject.toVariantMap();
 
+  // the optional hysteresis is applied to the condition once it has been added
+  AlertConditionData::Hysteresis hysteresis;
+  hysteresis.m_entryMeters = std::max(0.0, json.value(AlertConstants::CONDITION_ENTRY_BAND).toDouble(0.0));
+  hysteresis.m_exitMeters = std::max(0.0, json.value(AlertConstants::CONDITION_EXIT_BAND).toDouble(0.0));
+  hysteresis.m_minimumDwellMsecs = std::max(0, json.value(AlertConstants::CONDITION_MINIMUM_DWELL).toInt(0));
+
+  auto applyHysteresis = [this, hysteresis](bool added)
+  {
+    if (added)
+      m_conditions->conditionAt(m_conditions->rowCount() - 1)->setHysteresis(hysteresis);
+
+    return added;
+  };
+
   if (isAttributeEquals)
   {
     const QString attributeName = AttributeEqualsAlertCondition::attributeNameFromQueryComponents(queryComponents);
     if (attributeName.isEmpty())
       return false;
 
-    return addAttributeEqualsAlert(conditionName, level, sourceString, attributeName, targetString );
+    return applyHysteresis(addAttributeEqualsAlert(conditionName, level, sourceString, attributeName, targetString));
   }
-  else if (isWithinArea || isWithinDistance)
+  else if (isWithinArea || isWithinDistance || isWithinView)
   {
     QString targetOverlayName = targetString;
     int itemId = -1;
@@ -988,14 +1386,10 @@ bool AlertConditionsController::addConditionFromJson(const QJsonObject& json)
     if (targetOverlayIndex == -1)
       return false;
 
-    QString targetDescription;
-    AlertTarget* target = targetFromItemIdAndIndex(itemId, targetOverlayIndex, targetDescription);
-    if (!target)
-      return false;
-
+    // the target is looked up, and for a single feature queried, when the condition is added
     if (isWithinArea)
     {
-      return addWithinAreaAlert(conditionName, level, sourceString, itemId, targetOverlayIndex );
+      return applyHysteresis(addWithinAreaAlert(conditionName, level, sourceString, itemId, targetOverlayIndex));
     }
     else if (isWithinDistance)
     {
@@ -1003,7 +1397,15 @@ bool AlertConditionsController::addConditionFromJson(const QJsonObject& json)
       if (distance == -1.0)
         return false;
 
-      return addWithinDistanceAlert(conditionName, level, sourceString, distance, itemId, targetOverlayIndex);
+      return applyHysteresis(addWithinDistanceAlert(conditionName, level, sourceString, distance, itemId, targetOverlayIndex));
+    }
+    else if (isWithinView)
+    {
+      const double range = WithinViewAlertCondition::getRangeFromQueryComponents(queryComponents);
+      if (range <= 0.0)
+        return false;
+
+      return applyHysteresis(addWithinViewAlert(conditionName, level, sourceString, range, itemId, targetOverlayIndex));
     }
   }
 
@@ -1013,19 +1415,39 @@ bool AlertConditionsController::addConditionFromJson(const QJsonObject& json)
 /*!
   \brief internal
 
-  Attempt to add any stored Conditions serialized as JSON.
+  Attempt to add the stored Conditions serialized as JSON whose source and
+  target are both available.
+
+  If \a availableName is set, only the conditions using the source or target
+  of that name are attempted; the others stay dormant.
  */
-void AlertConditionsController::addStoredConditions()
+void AlertConditionsController::addStoredConditions(const QString& availableName)
 {
+  if (m_storedConditions.isEmpty())
+    return;
+
+  const QStringList sourceNames = m_sourceNames->stringList();
+  const QStringList targetNames = m_targetNames->stringList();
+
   QList<QJsonObject> addedConditions;
   auto it = m_storedConditions.constBegin();
   auto itEnd = m_storedConditions.constEnd();
   for (; it != itEnd; ++it)
   {
+    const QJsonObject& stored = *it;
+    const QString sourceName = stored.value(AlertConstants::CONDITION_SOURCE).toString();
+    const bool hasLayerTarget = stored.value(AlertConstants::CONDITION_TYPE).toString() != AlertConstants::attributeEqualsAlertConditionType();
+    const QString targetName = hasLayerTarget ? targetLayerName(stored.value(AlertConstants::CONDITION_TARGET).toString()) : QString();
+
+    if (!availableName.isEmpty() && sourceName != availableName && targetName != availableName)
+      continue;
+
+    if (!sourceNames.contains(sourceName) || (hasLayerTarget && !targetNames.contains(targetName)))
+      continue;
+
     // block signals while we are adding each stored condition
     QSignalBlocker blocker(this);
     Q_UNUSED(blocker)
-    const QJsonObject& stored = *it;
     if (addConditionFromJson(stored))
       addedConditions.append(stored);
   }
@@ -1034,7 +1456,8 @@ void AlertConditionsController::addStoredConditions()
     m_storedConditions.removeOne(added);
 
   // emit once for all conditions (including stored)
-  onConditionsChanged();
+  if (availableName.isEmpty() || !addedConditions.isEmpty())
+    scheduleConditionsChanged();
 }
 
 /*!
@@ -21,12 +21,12 @@
 #include "AbstractTool.h"
 
 // C++ API headers
-#include "TaskWatcher.h"
 
 // Qt headers
 #include <QHash>
 #include <QJsonObject>
 #include <QStringListModel>
+#include <QUuid>
 
 class QMouseEvent;
 class QStringList;
@@ -35,9 +35,11 @@ namespace Esri {
 namespace ArcGISRuntime {
 class IdentifyLayerResult;
 class IdentifyGraphicsOverlayResult;
+class Error;
 class FeatureLayer;
 class FeatureTable;
 class GraphicsOverlay;
+class Layer;
 }
 }
 
@@ -46,6 +48,7 @@ namespace Dsa {
 class AlertCondition;
 class AlertConditionData;
 class AlertConditionListModel;
+class AlertResultSharing;
 class AlertTarget;
 class LocationAlertSource;
 class LocationAlertTarget;
@@ -72,6 +75,7 @@ public:
   void setActive(bool active) override;
 
   Q_INVOKABLE bool addWithinDistanceAlert(const QString& conditionName, int levelIndex, const QString& sourceFeedname, double distance, int itemId, int targetOverlayIndex);
+  Q_INVOKABLE bool addWithinViewAlert(const QString& conditionName, int levelIndex, const QString& sourceFeedname, double range, int itemId, int targetOverlayIndex);
   Q_INVOKABLE bool addWithinAreaAlert(const QString& conditionName, int levelIndex, const QString& sourceFeedname, int itemId, int targetOverlayIndex);
   Q_INVOKABLE bool addAttributeEqualsAlert(const QString& conditionName, int levelIndex, const QString& sourceFeedname, const QString& attributeName, const QVariant& targetValue);
   Q_INVOKABLE void removeConditionAt(int rowIndex);
@@ -95,19 +99,30 @@ signals:
 
 private slots:
   void onGeoviewChanged();
-  void onLayersChanged();
-  void onMouseClicked(QMouseEvent& event);
-  void onIdentifyLayersCompleted(const QUuid& taskId, QList<Esri::ArcGISRuntime::IdentifyLayerResult*> identifyResults);
-  void onIdentifyGraphicsOverlaysCompleted(const QUuid& taskId, QList<Esri::ArcGISRuntime::IdentifyGraphicsOverlayResult*> identifyResults);
+  void onLayerAdded(Esri::ArcGISRuntime::Layer* layer);
+  void onLayerRemoved(Esri::ArcGISRuntime::Layer* layer);
+  void onGraphicsOverlayAdded(int index);
+  void onGraphicsOverlayRemoved(int index);
+  void onLayersRestored();
   void handleNewAlertConditionData(AlertConditionData* newConditionData);
   void onConditionsChanged();
 
 private:
+  bool onMouseClicked(QMouseEvent& event);
+  void onFeatureLayerLoaded(const Esri::ArcGISRuntime::Error& error);
+  void onIdentifyLayersCompleted(const QList<Esri::ArcGISRuntime::IdentifyLayerResult*>& identifyResults);
+  void onIdentifyGraphicsOverlaysCompleted(const QList<Esri::ArcGISRuntime::IdentifyGraphicsOverlayResult*>& identifyResults);
   void setTargetNames(const QStringList& targetNames);
   void setSourceNames(const QStringList& sourceNames);
   QJsonObject conditionToJson(AlertCondition* condition) const;
   bool addConditionFromJson(const QJsonObject& json);
-  void addStoredConditions();
+  void addStoredConditions(const QString& availableName = QString());
+  void onNameAvailable(const QString& name);
+  bool deferUntilLayersRestored();
+  void updateNames();
+  void setupResultSharing(const QVariantMap& properties);
+  void markConditionsChanged(int first, int last);
+  void scheduleConditionsChanged();
 
   AlertTarget* targetFromItemIdAndIndex(int itemId, int targetOverlayIndex, QString& targetDescription) const;
   AlertTarget* targetFromFeatureLayer(Esri::ArcGISRuntime::FeatureLayer* featureLayer, int itemId) const;
@@ -126,16 +141,16 @@ private:
   double m_tolerance = 5;
   LocationAlertSource* m_locationSource = nullptr;
   LocationAlertTarget* m_locationTarget = nullptr;
-  Esri::ArcGISRuntime::TaskWatcher m_identifyLayersWatcher;
-  Esri::ArcGISRuntime::TaskWatcher m_identifyGraphicsWatcher;
+  AlertResultSharing* m_resultSharing = nullptr;
+  QUuid m_identifyLayersTaskId;
+  QUuid m_identifyGraphicsTaskId;
   mutable QHash<QString,AlertTarget*> m_layerTargets;
   mutable QHash<QString,AlertTarget*> m_overlayTargets;
   QList<QJsonObject> m_storedConditions;
+  QHash<AlertCondition*, QJsonObject> m_conditionsJson;
+  bool m_conditionsChangeScheduled = false;
   QHash<QString,QString> m_messageFeedTypesToNames;
 
-  QMetaObject::Connection m_mouseClickConnection;
-  QMetaObject::Connection m_identifyLayersConnection;
-  QMetaObject::Connection m_identifyGraphicsConnection;
 };
 
 } // Dsa
@@ -23,10 +23,17 @@
 #include "AttributeEqualsAlertCondition.h"
 #include "WithinAreaAlertCondition.h"
 #include "WithinDistanceAlertCondition.h"
+#include "WithinViewAlertCondition.h"
 
 namespace Dsa {
 
 const QString AlertConstants::ALERT_CONDITIONS_PROPERTYNAME = "Conditions";
+const QString AlertConstants::ALERT_HISTORY_CAPACITY_PROPERTYNAME = "AlertHistoryCapacity";
+const QString AlertConstants::ALERT_HISTORY_MAXIMUM_AGE_PROPERTYNAME = "AlertHistoryMaximumAge";
+const QString AlertConstants::ALERT_HISTORY_LOG_PROPERTYNAME = "AlertHistoryLog";
+const QString AlertConstants::ALERT_RESULT_SHARING_PORT_PROPERTYNAME = "AlertResultSharingPort";
+const QString AlertConstants::ALERT_STATE_BROADCAST_CONFIG_PROPERTYNAME = "AlertStateBroadcastConfig";
+const QString AlertConstants::ALERT_STATE_BROADCAST_CONFIG_PORT = "port";
 const QString AlertConstants::ATTRIBUTE_NAME = "attribute_name";
 const QString AlertConstants::CONDITION_TYPE = "condition_type";
 const QString AlertConstants::CONDITION_NAME = "name";
@@ -34,6 +41,9 @@ const QString AlertConstants::CONDITION_LEVEL = "level";
 const QString AlertConstants::CONDITION_SOURCE = "source";
 const QString AlertConstants::CONDITION_QUERY = "query";
 const QString AlertConstants::CONDITION_TARGET = "target";
+const QString AlertConstants::CONDITION_ENTRY_BAND = "entry_band_meters";
+const QString AlertConstants::CONDITION_EXIT_BAND = "exit_band_meters";
+const QString AlertConstants::CONDITION_MINIMUM_DWELL = "minimum_dwell_msecs";
 const QString AlertConstants::METERS = "meters";
 const QString AlertConstants::MY_LOCATION = "My Location";
 
@@ -52,4 +62,9 @@ QString AlertConstants::withinDistanceAlertConditionType()
   return WithinDistanceAlertCondition::staticMetaObject.className();
 }
 
+QString AlertConstants::withinViewAlertConditionType()
+{
+  return WithinViewAlertCondition::staticMetaObject.className();
+}
+
 } // Dsa
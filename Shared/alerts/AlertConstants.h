@@ -25,6 +25,12 @@ namespace Dsa {
 class AlertConstants {
 public:
   static const QString ALERT_CONDITIONS_PROPERTYNAME;
+  static const QString ALERT_HISTORY_CAPACITY_PROPERTYNAME;
+  static const QString ALERT_HISTORY_MAXIMUM_AGE_PROPERTYNAME;
+  static const QString ALERT_HISTORY_LOG_PROPERTYNAME;
+  static const QString ALERT_RESULT_SHARING_PORT_PROPERTYNAME;
+  static const QString ALERT_STATE_BROADCAST_CONFIG_PROPERTYNAME;
+  static const QString ALERT_STATE_BROADCAST_CONFIG_PORT;
   static const QString ATTRIBUTE_NAME;
   static const QString CONDITION_TYPE;
   static const QString CONDITION_NAME;
@@ -32,12 +38,16 @@ public:
   static const QString CONDITION_SOURCE;
   static const QString CONDITION_QUERY;
   static const QString CONDITION_TARGET;
+  static const QString CONDITION_ENTRY_BAND;
+  static const QString CONDITION_EXIT_BAND;
+  static const QString CONDITION_MINIMUM_DWELL;
   static const QString METERS;
   static const QString MY_LOCATION;
 
   static QString attributeEqualsAlertConditionType();
   static QString withinAreaAlertConditionType();
   static QString withinDistanceAlertConditionType();
+  static QString withinViewAlertConditionType();
 };
 
 } // Dsa
@@ -0,0 +1,493 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "AlertEvaluationScheduler.h"
+
+// dsa app headers
+#include "AlertConditionData.h"
+#include "AlertEvaluationStats.h"
+#include "AlertLevel.h"
+#include "AllocationCounter.h"
+#include "MessageFeedStats.h"
+
+// Qt headers
+#include <QElapsedTimer>
+#include <QThread>
+#include <QThreadPool>
+#include <QTimer>
+
+// STL headers
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+namespace Dsa {
+
+// the minimum number of queries given to each worker thread in a batch
+static constexpr int s_minimumChunkSize = 4;
+
+// the queries for a batch of condition data and their results. Each worker thread
+// writes the results for its own range of queries
+struct AlertEvaluationScheduler::QueryBatch
+{
+  int m_id = 0;
+  std::vector<AlertConditionData::QueryTask> m_tasks;
+  std::vector<char> m_results;
+  std::vector<qint64> m_queryNsecs;
+  std::atomic<int> m_remainingChunks{0};
+};
+
+/*!
+  \class Dsa::AlertEvaluationScheduler
+  \inmodule Dsa
+  \inherits QObject
+  \brief Defers and batches the evaluation of \l AlertConditionData queries.
+
+  When the source or target of a condition changes, the condition data is only
+  marked as needing evaluation. The set of pending condition data is evaluated
+  once control returns to the event loop, so that many changes in a single feed
+  update result in one evaluation of each affected condition data.
+
+  Evaluation of a batch stops once \l frameBudget milliseconds have been spent.
+  Any remaining condition data are carried over and evaluated after
+  \l frameInterval milliseconds, so that alerts lag behind under heavy load rather
+  than blocking the UI. The backlog is evaluated in order of \l AlertLevel, from
+  Critical down to Low, and in the order in which they were scheduled within a level.
+  Under load, critical conditions therefore keep a low latency while lower levels wait.
+
+  If \l isParallel is \c true, only a snapshot of the source and target data for each
+  condition data is taken within the batch (see \l AlertConditionData::queryTask).
+  The queries themselves are run across a pool of worker threads and the results are
+  applied on the scheduler's thread once the whole batch has finished. A result is
+  discarded if its condition data has changed or been destroyed in the meantime.
+
+  The throughput, query time and latency of the evaluations are recorded in \l stats.
+
+  \sa AlertConditionData::evaluate
+ */
+
+/*!
+  \brief Returns the singleton instance of the scheduler.
+ */
+AlertEvaluationScheduler* AlertEvaluationScheduler::instance()
+{
+  static AlertEvaluationScheduler s_instance;
+
+  return &s_instance;
+}
+
+/*!
+  \internal
+ */
+AlertEvaluationScheduler::AlertEvaluationScheduler(QObject* parent):
+  QObject(parent),
+  m_timer(new QTimer(this)),
+  m_threadPool(new QThreadPool(this)),
+  m_stats(new AlertEvaluationStats(this)),
+  m_parallel(QThread::idealThreadCount() > 1)
+{
+  m_pending.resize(alertLevelCount);
+
+  // leave a core free for the UI thread
+  m_threadPool->setMaxThreadCount(std::max(1, QThread::idealThreadCount() - 1));
+
+  m_timer->setSingleShot(true);
+  connect(m_timer, &QTimer::timeout, this, &AlertEvaluationScheduler::evaluatePending);
+}
+
+/*!
+  \brief Destructor.
+ */
+AlertEvaluationScheduler::~AlertEvaluationScheduler()
+{
+  m_threadPool->waitForDone();
+}
+
+/*!
+  \brief Schedules \a conditionData to be evaluated.
+
+  If the condition data is already pending, it keeps its place in the backlog.
+  It is placed in the backlog for its current \l AlertLevel.
+  If \l isDeferred is \c false, the condition data is evaluated immediately.
+ */
+void AlertEvaluationScheduler::schedule(AlertConditionData* conditionData)
+{
+  if (!conditionData)
+    return;
+
+  if (!m_deferred)
+  {
+    evaluateNow(conditionData, MessageFeedStats::timestamp());
+    return;
+  }
+
+  if (m_pendingTimestamps.contains(conditionData))
+    return;
+
+  const int level = qBound(0, static_cast<int>(conditionData->level()), alertLevelCount - 1);
+  m_pendingTimestamps.insert(conditionData, MessageFeedStats::timestamp());
+  m_pending[level].append(conditionData);
+
+  if (!m_timer->isActive())
+    m_timer->start(0);
+
+  emit backlogChanged();
+}
+
+/*!
+  \brief Removes \a conditionData from the backlog, for example when it is destroyed.
+ */
+void AlertEvaluationScheduler::unschedule(AlertConditionData* conditionData)
+{
+  // the entry is left in the ordered list and skipped when it is reached
+  if (m_pendingTimestamps.remove(conditionData) > 0)
+    emit backlogChanged();
+}
+
+/*!
+  \brief Returns whether evaluation is deferred and batched.
+
+  The default is \c true.
+ */
+bool AlertEvaluationScheduler::isDeferred() const
+{
+  return m_deferred;
+}
+
+/*!
+  \brief Sets whether evaluation is deferred and batched to \a deferred.
+
+  When \a deferred is \c false, condition data are evaluated as soon as they change and
+  any pending backlog is evaluated immediately.
+ */
+void AlertEvaluationScheduler::setDeferred(bool deferred)
+{
+  if (m_deferred == deferred)
+    return;
+
+  m_deferred = deferred;
+
+  if (m_deferred)
+    return;
+
+  m_timer->stop();
+
+  while (hasPending())
+  {
+    AlertConditionData* conditionData = takeNextPending();
+    auto findIt = m_pendingTimestamps.find(conditionData);
+    if (findIt == m_pendingTimestamps.end())
+      continue;
+
+    const qint64 scheduledTimestamp = findIt.value();
+    m_pendingTimestamps.erase(findIt);
+    evaluateNow(conditionData, scheduledTimestamp);
+  }
+
+  emit backlogChanged();
+}
+
+/*!
+  \brief Returns the maximum time, in milliseconds, spent evaluating condition data in one batch.
+
+  The default is \c 8 milliseconds.
+ */
+int AlertEvaluationScheduler::frameBudget() const
+{
+  return m_frameBudget;
+}
+
+/*!
+  \brief Sets the maximum time, in milliseconds, spent evaluating condition data in one batch
+  to \a frameBudget.
+
+  At least one condition data is evaluated in each batch.
+ */
+void AlertEvaluationScheduler::setFrameBudget(int frameBudget)
+{
+  m_frameBudget = frameBudget;
+}
+
+/*!
+  \brief Returns the delay, in milliseconds, before a remaining backlog is evaluated.
+
+  The default is \c 16 milliseconds.
+ */
+int AlertEvaluationScheduler::frameInterval() const
+{
+  return m_frameInterval;
+}
+
+/*!
+  \brief Sets the delay, in milliseconds, before a remaining backlog is evaluated
+  to \a frameInterval.
+ */
+void AlertEvaluationScheduler::setFrameInterval(int frameInterval)
+{
+  m_frameInterval = frameInterval;
+}
+
+/*!
+  \brief Returns whether queries are run on a pool of worker threads.
+
+  The default is \c true if more than one processor core is available.
+ */
+bool AlertEvaluationScheduler::isParallel() const
+{
+  return m_parallel;
+}
+
+/*!
+  \brief Sets whether queries are run on a pool of worker threads to \a parallel.
+
+  Queries which are already running are not affected.
+ */
+void AlertEvaluationScheduler::setParallel(bool parallel)
+{
+  m_parallel = parallel;
+}
+
+/*!
+  \brief Returns the number of condition data waiting to be evaluated.
+ */
+int AlertEvaluationScheduler::backlogCount() const
+{
+  return m_pendingTimestamps.size();
+}
+
+/*!
+  \brief Returns the number of condition data whose queries are running on worker threads.
+ */
+int AlertEvaluationScheduler::runningCount() const
+{
+  return m_runningCount;
+}
+
+/*!
+  \brief Returns the evaluation statistics of the scheduler.
+ */
+AlertEvaluationStats* AlertEvaluationScheduler::stats() const
+{
+  return m_stats;
+}
+
+/*!
+  \brief Evaluates pending condition data until the \l frameBudget is used.
+
+  Any remaining backlog is evaluated after \l frameInterval milliseconds.
+ */
+void AlertEvaluationScheduler::evaluatePending()
+{
+  DSA_ALLOCATION_SCOPE(Alerts);
+
+  QElapsedTimer frameTimer;
+  frameTimer.start();
+
+  std::shared_ptr<QueryBatch> batch;
+  RunningBatch runningBatch;
+
+  int evaluatedCount = 0;
+  while (hasPending())
+  {
+    // always make progress, even if a single evaluation exceeds the budget
+    if (evaluatedCount > 0 && frameTimer.elapsed() >= m_frameBudget)
+      break;
+
+    AlertConditionData* conditionData = takeNextPending();
+
+    // skip entries which have been unscheduled
+    auto findIt = m_pendingTimestamps.find(conditionData);
+    if (findIt == m_pendingTimestamps.end())
+      continue;
+
+    const qint64 scheduledTimestamp = findIt.value();
+    m_pendingTimestamps.erase(findIt);
+
+    ++evaluatedCount;
+
+    // condition data without a query task are evaluated on this thread
+    AlertConditionData::QueryTask task;
+    if (m_parallel && conditionData->isEvaluationRequired())
+      task = conditionData->queryTask();
+
+    if (!task)
+    {
+      evaluateNow(conditionData, scheduledTimestamp);
+      continue;
+    }
+
+    if (!batch)
+      batch = std::make_shared<QueryBatch>();
+
+    batch->m_tasks.push_back(std::move(task));
+    runningBatch.m_conditionData.append(conditionData);
+    runningBatch.m_changeCounts.append(conditionData->changeCount());
+    runningBatch.m_scheduledTimestamps.append(scheduledTimestamp);
+  }
+
+  if (batch)
+    startBatch(batch, runningBatch);
+
+  if (hasPending())
+    m_timer->start(m_frameInterval);
+
+  if (evaluatedCount > 0)
+  {
+    m_stats->recordPass(frameTimer.nsecsElapsed(), m_frameBudget);
+    emit backlogChanged();
+  }
+}
+
+/*!
+  \internal
+
+  Runs the queries in \a batch across the worker threads. \a runningBatch holds the
+  condition data the results are applied to.
+ */
+void AlertEvaluationScheduler::startBatch(const std::shared_ptr<QueryBatch>& batch, const RunningBatch& runningBatch)
+{
+  const int taskCount = static_cast<int>(batch->m_tasks.size());
+  const int chunkCount = std::max(1, std::min(taskCount / s_minimumChunkSize, m_threadPool->maxThreadCount()));
+
+  batch->m_id = m_nextBatchId++;
+  batch->m_results.assign(batch->m_tasks.size(), 0);
+  batch->m_queryNsecs.assign(batch->m_tasks.size(), 0);
+  batch->m_remainingChunks = chunkCount;
+
+  m_runningBatches.insert(batch->m_id, runningBatch);
+  m_runningCount += taskCount;
+
+  for (int chunk = 0; chunk < chunkCount; ++chunk)
+  {
+    const int begin = (taskCount * chunk) / chunkCount;
+    const int end = (taskCount * (chunk + 1)) / chunkCount;
+
+    m_threadPool->start([this, batch, begin, end]()
+    {
+      DSA_ALLOCATION_SCOPE(Alerts);
+
+      for (int i = begin; i < end; ++i)
+      {
+        const qint64 queryStart = MessageFeedStats::timestamp();
+        batch->m_results[i] = batch->m_tasks[i]() ? 1 : 0;
+        batch->m_queryNsecs[i] = MessageFeedStats::timestamp() - queryStart;
+      }
+
+      // the last chunk to finish hands the results back to the scheduler's thread
+      if (--batch->m_remainingChunks == 0)
+        QMetaObject::invokeMethod(this, [this, batch]() { applyBatch(batch); }, Qt::QueuedConnection);
+    });
+  }
+}
+
+/*!
+  \internal
+
+  Applies the results of the finished \a batch to any condition data which still exist.
+ */
+void AlertEvaluationScheduler::applyBatch(const std::shared_ptr<QueryBatch>& batch)
+{
+  DSA_ALLOCATION_SCOPE(Alerts);
+
+  auto findIt = m_runningBatches.find(batch->m_id);
+  if (findIt == m_runningBatches.end())
+    return;
+
+  const RunningBatch runningBatch = findIt.value();
+  m_runningBatches.erase(findIt);
+  m_runningCount -= runningBatch.m_conditionData.size();
+
+  qint64 latestScheduledTimestamp = 0;
+  for (int i = 0; i < runningBatch.m_conditionData.size(); ++i)
+  {
+    AlertConditionData* conditionData = runningBatch.m_conditionData.at(i);
+    const int changeCount = runningBatch.m_changeCounts.at(i);
+    if (!conditionData || conditionData->changeCount() != changeCount)
+    {
+      m_stats->recordDiscarded();
+      continue;
+    }
+
+    conditionData->applyQueryResult(batch->m_results[i] != 0, changeCount);
+    m_stats->recordEvaluation(runningBatch.m_scheduledTimestamps.at(i), batch->m_queryNsecs[i], conditionData->level());
+    latestScheduledTimestamp = qMax(latestScheduledTimestamp, runningBatch.m_scheduledTimestamps.at(i));
+  }
+
+  if (latestScheduledTimestamp > 0)
+    MessageFeedStats::recordAlertsEvaluated(latestScheduledTimestamp);
+
+  emit backlogChanged();
+}
+
+/*!
+  \internal
+
+  Evaluates \a conditionData on this thread and records the evaluation, which was
+  scheduled at \a scheduledTimestamp.
+ */
+void AlertEvaluationScheduler::evaluateNow(AlertConditionData* conditionData, qint64 scheduledTimestamp)
+{
+  // evaluate does nothing for condition data which are already up-to-date
+  if (!conditionData->isEvaluationRequired())
+    return;
+
+  const qint64 queryStart = MessageFeedStats::timestamp();
+  conditionData->evaluate();
+  m_stats->recordEvaluation(scheduledTimestamp, MessageFeedStats::timestamp() - queryStart, conditionData->level());
+  MessageFeedStats::recordAlertsEvaluated(scheduledTimestamp);
+}
+
+/*!
+  \internal
+
+  Returns whether any backlog entries remain, including ones which have been unscheduled.
+ */
+bool AlertEvaluationScheduler::hasPending() const
+{
+  return std::any_of(m_pending.cbegin(), m_pending.cend(), [](const QList<AlertConditionData*>& levelPending)
+  {
+    return !levelPending.isEmpty();
+  });
+}
+
+/*!
+  \internal
+
+  Removes and returns the first backlog entry of the highest \l AlertLevel, or
+  \c nullptr if the backlog is empty.
+ */
+AlertConditionData* AlertEvaluationScheduler::takeNextPending()
+{
+  for (int level = alertLevelCount - 1; level >= 0; --level)
+  {
+    if (!m_pending.at(level).isEmpty())
+      return m_pending[level].takeFirst();
+  }
+
+  return nullptr;
+}
+
+} // Dsa
+
+// Signal Documentation
+/*!
+  \fn void AlertEvaluationScheduler::backlogChanged();
+  \brief Signal emitted when the number of condition data waiting to be evaluated,
+  or running on worker threads, changes.
+ */
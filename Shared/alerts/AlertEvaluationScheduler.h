@@ -0,0 +1,109 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef ALERTEVALUATIONSCHEDULER_H
+#define ALERTEVALUATIONSCHEDULER_H
+
+// Qt headers
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QVector>
+
+// STL headers
+#include <memory>
+
+class QThreadPool;
+class QTimer;
+
+namespace Dsa {
+
+class AlertConditionData;
+class AlertEvaluationStats;
+
+class AlertEvaluationScheduler : public QObject
+{
+  Q_OBJECT
+
+public:
+  static AlertEvaluationScheduler* instance();
+
+  ~AlertEvaluationScheduler();
+
+  void schedule(AlertConditionData* conditionData);
+  void unschedule(AlertConditionData* conditionData);
+
+  bool isDeferred() const;
+  void setDeferred(bool deferred);
+
+  int frameBudget() const;
+  void setFrameBudget(int frameBudget);
+
+  int frameInterval() const;
+  void setFrameInterval(int frameInterval);
+
+  bool isParallel() const;
+  void setParallel(bool parallel);
+
+  int backlogCount() const;
+  int runningCount() const;
+
+  AlertEvaluationStats* stats() const;
+
+public slots:
+  void evaluatePending();
+
+signals:
+  void backlogChanged();
+
+private:
+  explicit AlertEvaluationScheduler(QObject* parent = nullptr);
+  Q_DISABLE_COPY(AlertEvaluationScheduler)
+
+  struct QueryBatch;
+
+  struct RunningBatch
+  {
+    QVector<QPointer<AlertConditionData>> m_conditionData;
+    QVector<int> m_changeCounts;
+    QVector<qint64> m_scheduledTimestamps;
+  };
+
+  void startBatch(const std::shared_ptr<QueryBatch>& batch, const RunningBatch& runningBatch);
+  void applyBatch(const std::shared_ptr<QueryBatch>& batch);
+  void evaluateNow(AlertConditionData* conditionData, qint64 scheduledTimestamp);
+  bool hasPending() const;
+  AlertConditionData* takeNextPending();
+
+  // the backlog, in the order in which it was scheduled, for each AlertLevel
+  QVector<QList<AlertConditionData*>> m_pending;
+  QHash<AlertConditionData*, qint64> m_pendingTimestamps;
+  QHash<int, RunningBatch> m_runningBatches;
+  QTimer* m_timer = nullptr;
+  QThreadPool* m_threadPool = nullptr;
+  AlertEvaluationStats* m_stats = nullptr;
+  bool m_deferred = true;
+  bool m_parallel = false;
+  int m_nextBatchId = 0;
+  int m_runningCount = 0;
+  int m_frameBudget = 8;
+  int m_frameInterval = 16;
+};
+
+} // Dsa
+
+#endif // ALERTEVALUATIONSCHEDULER_H
@@ -0,0 +1,419 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "AlertEvaluationStats.h"
+
+// dsa app headers
+#include "MessageFeedStats.h"
+
+// Qt headers
+#include <QTimer>
+
+namespace Dsa {
+
+namespace {
+// upper bounds, in milliseconds, of the latency histogram buckets. A final
+// bucket holds all latencies above the last bound
+const QVector<double> s_latencyBucketBounds{0.1, 0.25, 0.5, 1, 2.5, 5, 10, 25, 50, 100, 250, 500, 1000};
+
+// interval at which the evaluation rate is computed and statsChanged is emitted
+constexpr int s_updateInterval = 1000;
+
+constexpr double s_nsecsPerMsec = 1000000.0;
+}
+
+/*!
+  \class Dsa::AlertEvaluationStats
+  \inmodule Dsa
+  \inherits QObject
+  \brief Collects evaluation statistics for the \l AlertEvaluationScheduler.
+
+  Each condition data evaluation records the time spent running its query and the
+  latency from the condition data being scheduled to its result being applied. The
+  latencies are kept in a histogram, from which \l latencyPercentile estimates
+  percentiles without storing every sample. The latency is also recorded for each
+  \l AlertLevel, to show how well the scheduler protects the higher levels under load.
+
+  Each pass of the scheduler over its backlog records the time it took against its
+  frame budget, from which \l budgetUsage gives the share of the budget used over
+  the last second.
+
+  The statistics can be compared between builds, feeds or devices to catch
+  regressions in alert evaluation and to size hardware for a given load.
+
+  To avoid signal storms under load, \l statsChanged is emitted at most once per second.
+ */
+
+/*!
+  \brief Constructor taking an optional \a parent.
+ */
+AlertEvaluationStats::AlertEvaluationStats(QObject* parent) :
+  QObject(parent),
+  m_updateTimer(new QTimer(this)),
+  m_latencyHistogram(s_latencyBucketBounds.size() + 1, 0),
+  m_levelLatencies(alertLevelCount),
+  m_lastRateTimestamp(MessageFeedStats::timestamp())
+{
+  connect(m_updateTimer, &QTimer::timeout, this, &AlertEvaluationStats::updateRate);
+  m_updateTimer->start(s_updateInterval);
+}
+
+/*!
+  \brief Destructor.
+ */
+AlertEvaluationStats::~AlertEvaluationStats()
+{
+}
+
+/*!
+  \brief Returns the upper bounds, in milliseconds, of the buckets in \l latencyHistogram.
+
+  The histogram contains one more bucket than there are bounds, for all latencies
+  above the last bound.
+ */
+QVariantList AlertEvaluationStats::latencyHistogramBuckets()
+{
+  QVariantList buckets;
+  for (const double bound : s_latencyBucketBounds)
+    buckets.append(bound);
+
+  return buckets;
+}
+
+/*!
+  \property AlertEvaluationStats::evaluationCount
+  \brief Returns the number of condition data evaluations whose results were applied.
+ */
+qint64 AlertEvaluationStats::evaluationCount() const
+{
+  return m_evaluationCount;
+}
+
+/*!
+  \property AlertEvaluationStats::discardedCount
+  \brief Returns the number of query results which were discarded because their
+  condition data changed, or was destroyed, while the query was running.
+ */
+qint64 AlertEvaluationStats::discardedCount() const
+{
+  return m_discardedCount;
+}
+
+/*!
+  \property AlertEvaluationStats::deferredCount
+  \brief Returns the number of source or target changes which did not need an evaluation,
+  because the condition data predicted that they could not change its result.
+ */
+qint64 AlertEvaluationStats::deferredCount() const
+{
+  return m_deferredCount;
+}
+
+/*!
+  \property AlertEvaluationStats::evaluationsPerSecond
+  \brief Returns the rate at which condition data were evaluated over the last second.
+ */
+double AlertEvaluationStats::evaluationsPerSecond() const
+{
+  return m_evaluationsPerSecond;
+}
+
+/*!
+  \property AlertEvaluationStats::averageQueryTime
+  \brief Returns the average time, in milliseconds, spent running the query of a condition data.
+ */
+double AlertEvaluationStats::averageQueryTime() const
+{
+  if (m_evaluationCount == 0)
+    return 0.0;
+
+  return m_totalQueryNsecs / s_nsecsPerMsec / m_evaluationCount;
+}
+
+/*!
+  \property AlertEvaluationStats::averageLatency
+  \brief Returns the average time, in milliseconds, from a condition data being
+  scheduled to its result being applied.
+ */
+double AlertEvaluationStats::averageLatency() const
+{
+  if (m_latencyCount == 0)
+    return 0.0;
+
+  return m_totalLatencyNsecs / s_nsecsPerMsec / m_latencyCount;
+}
+
+/*!
+  \property AlertEvaluationStats::maximumLatency
+  \brief Returns the maximum time, in milliseconds, from a condition data being
+  scheduled to its result being applied.
+ */
+double AlertEvaluationStats::maximumLatency() const
+{
+  return m_maximumLatencyNsecs / s_nsecsPerMsec;
+}
+
+/*!
+  \property AlertEvaluationStats::latencyHistogram
+  \brief Returns the number of evaluations in each latency bucket.
+
+  \sa latencyHistogramBuckets
+ */
+QVariantList AlertEvaluationStats::latencyHistogram() const
+{
+  QVariantList histogram;
+  for (const qint64 count : m_latencyHistogram)
+    histogram.append(count);
+
+  return histogram;
+}
+
+/*!
+  \property AlertEvaluationStats::budgetUsage
+  \brief Returns the time spent by the evaluation passes over the last second, as a
+  fraction of their frame budgets.
+
+  A value near or above \c 1 means the scheduler is falling behind its backlog.
+ */
+double AlertEvaluationStats::budgetUsage() const
+{
+  return m_budgetUsage;
+}
+
+/*!
+  \property AlertEvaluationStats::overBudgetCount
+  \brief Returns the number of evaluation passes which took longer than their frame budget.
+ */
+qint64 AlertEvaluationStats::overBudgetCount() const
+{
+  return m_overBudgetCount;
+}
+
+/*!
+  \brief Returns an estimate of the latency, in milliseconds, below which
+  \a percentile percent of evaluations were applied.
+
+  The estimate is the upper bound of the histogram bucket holding the percentile,
+  or \l maximumLatency for the final bucket. Returns \c 0 if no latencies were recorded.
+ */
+double AlertEvaluationStats::latencyPercentile(double percentile) const
+{
+  if (m_latencyCount == 0)
+    return 0.0;
+
+  const double rank = qBound(0.0, percentile, 100.0) / 100.0 * m_latencyCount;
+  qint64 cumulative = 0;
+  for (int bucket = 0; bucket < s_latencyBucketBounds.size(); ++bucket)
+  {
+    cumulative += m_latencyHistogram.at(bucket);
+    if (cumulative > 0 && cumulative >= rank)
+      return qMin(s_latencyBucketBounds.at(bucket), maximumLatency());
+  }
+
+  return maximumLatency();
+}
+
+/*!
+  \brief Returns the number of evaluations with a recorded latency for the \l AlertLevel \a level.
+ */
+qint64 AlertEvaluationStats::levelEvaluationCount(int level) const
+{
+  if (level < 0 || level >= alertLevelCount)
+    return 0;
+
+  return m_levelLatencies.at(level).m_count;
+}
+
+/*!
+  \brief Returns the average time, in milliseconds, from a condition data of the
+  \l AlertLevel \a level being scheduled to its result being applied.
+ */
+double AlertEvaluationStats::levelAverageLatency(int level) const
+{
+  if (level < 0 || level >= alertLevelCount || m_levelLatencies.at(level).m_count == 0)
+    return 0.0;
+
+  const LevelLatency& latency = m_levelLatencies.at(level);
+  return latency.m_totalNsecs / s_nsecsPerMsec / latency.m_count;
+}
+
+/*!
+  \brief Returns the maximum time, in milliseconds, from a condition data of the
+  \l AlertLevel \a level being scheduled to its result being applied.
+ */
+double AlertEvaluationStats::levelMaximumLatency(int level) const
+{
+  if (level < 0 || level >= alertLevelCount)
+    return 0.0;
+
+  return m_levelLatencies.at(level).m_maximumNsecs / s_nsecsPerMsec;
+}
+
+/*!
+  \brief Records that the result of a condition data has been applied.
+
+  \a scheduledTimestamp is the time, obtained from \l MessageFeedStats::timestamp, at which
+  the condition data was scheduled. If it is \c 0, no latency is recorded. \a queryNsecs is
+  the time spent running the query and \a level is the \l AlertLevel of the condition data.
+ */
+void AlertEvaluationStats::recordEvaluation(qint64 scheduledTimestamp, qint64 queryNsecs, AlertLevel level)
+{
+  ++m_evaluationCount;
+  m_totalQueryNsecs += queryNsecs;
+  m_changed = true;
+
+  if (scheduledTimestamp <= 0)
+    return;
+
+  const qint64 latencyNsecs = MessageFeedStats::timestamp() - scheduledTimestamp;
+  ++m_latencyCount;
+  m_totalLatencyNsecs += latencyNsecs;
+  m_maximumLatencyNsecs = qMax(m_maximumLatencyNsecs, latencyNsecs);
+
+  LevelLatency& levelLatency = m_levelLatencies[qBound(0, static_cast<int>(level), alertLevelCount - 1)];
+  ++levelLatency.m_count;
+  levelLatency.m_totalNsecs += latencyNsecs;
+  levelLatency.m_maximumNsecs = qMax(levelLatency.m_maximumNsecs, latencyNsecs);
+
+  const double latencyMsecs = latencyNsecs / s_nsecsPerMsec;
+  int bucket = 0;
+  while (bucket < s_latencyBucketBounds.size() && latencyMsecs >= s_latencyBucketBounds.at(bucket))
+    ++bucket;
+
+  ++m_latencyHistogram[bucket];
+}
+
+/*!
+  \brief Records that \a count query results were discarded.
+ */
+void AlertEvaluationStats::recordDiscarded(int count)
+{
+  m_discardedCount += count;
+  m_changed = true;
+}
+
+/*!
+  \brief Records that a change to a condition data's source or target was not evaluated.
+ */
+void AlertEvaluationStats::recordDeferred()
+{
+  ++m_deferredCount;
+  m_changed = true;
+}
+
+/*!
+  \brief Records a pass of the scheduler over its backlog which took \a passNsecs,
+  with a budget of \a frameBudget milliseconds.
+ */
+void AlertEvaluationStats::recordPass(qint64 passNsecs, int frameBudget)
+{
+  const qint64 budgetNsecs = static_cast<qint64>(frameBudget) * 1000000;
+  m_passNsecs += passNsecs;
+  m_passBudgetNsecs += budgetNsecs;
+  if (passNsecs > budgetNsecs)
+    ++m_overBudgetCount;
+
+  m_changed = true;
+}
+
+/*!
+  \brief Returns a single line summary of the statistics, suitable for logging.
+ */
+QString AlertEvaluationStats::summary() const
+{
+  return QString("%1 evaluations/s, evaluated %2, discarded %3, deferred %10, query %4 ms, "
+                 "latency avg %5 ms p50 %6 ms p95 %7 ms p99 %8 ms max %9 ms")
+      .arg(QString::number(m_evaluationsPerSecond, 'f', 1),
+           QString::number(m_evaluationCount),
+           QString::number(m_discardedCount),
+           QString::number(averageQueryTime(), 'f', 3),
+           QString::number(averageLatency(), 'f', 3),
+           QString::number(latencyPercentile(50.0), 'f', 3),
+           QString::number(latencyPercentile(95.0), 'f', 3),
+           QString::number(latencyPercentile(99.0), 'f', 3),
+           QString::number(maximumLatency(), 'f', 3))
+      .arg(m_deferredCount) +
+      QString(", latency by level critical %1 ms high %2 ms medium %3 ms low %4 ms")
+      .arg(QString::number(levelAverageLatency(static_cast<int>(AlertLevel::Critical)), 'f', 3),
+           QString::number(levelAverageLatency(static_cast<int>(AlertLevel::High)), 'f', 3),
+           QString::number(levelAverageLatency(static_cast<int>(AlertLevel::Medium)), 'f', 3),
+           QString::number(levelAverageLatency(static_cast<int>(AlertLevel::Low)), 'f', 3));
+}
+
+/*!
+  \brief Resets all of the statistics.
+ */
+void AlertEvaluationStats::reset()
+{
+  m_evaluationCount = 0;
+  m_discardedCount = 0;
+  m_deferredCount = 0;
+  m_totalQueryNsecs = 0;
+  m_latencyCount = 0;
+  m_totalLatencyNsecs = 0;
+  m_maximumLatencyNsecs = 0;
+  m_latencyHistogram.fill(0);
+  m_levelLatencies.fill(LevelLatency());
+  m_lastEvaluationCount = 0;
+  m_lastRateTimestamp = MessageFeedStats::timestamp();
+  m_evaluationsPerSecond = 0.0;
+  m_passNsecs = 0;
+  m_passBudgetNsecs = 0;
+  m_overBudgetCount = 0;
+  m_budgetUsage = 0.0;
+
+  emit statsChanged();
+}
+
+/*!
+  \internal
+ */
+void AlertEvaluationStats::updateRate()
+{
+  const qint64 now = MessageFeedStats::timestamp();
+  const qint64 elapsed = now - m_lastRateTimestamp;
+  if (elapsed <= 0)
+    return;
+
+  const double rate = (m_evaluationCount - m_lastEvaluationCount) * 1000000000.0 / elapsed;
+  m_lastEvaluationCount = m_evaluationCount;
+  m_lastRateTimestamp = now;
+
+  const double budgetUsage = m_passBudgetNsecs > 0 ? static_cast<double>(m_passNsecs) / m_passBudgetNsecs : 0.0;
+  m_passNsecs = 0;
+  m_passBudgetNsecs = 0;
+
+  if (!m_changed && qFuzzyCompare(rate + 1.0, m_evaluationsPerSecond + 1.0) &&
+      qFuzzyCompare(budgetUsage + 1.0, m_budgetUsage + 1.0))
+    return;
+
+  m_evaluationsPerSecond = rate;
+  m_budgetUsage = budgetUsage;
+  m_changed = false;
+
+  emit statsChanged();
+}
+
+} // Dsa
+
+// Signal Documentation
+/*!
+  \fn void AlertEvaluationStats::statsChanged();
+  \brief Signal emitted, at most once per second, when the statistics change.
+ */
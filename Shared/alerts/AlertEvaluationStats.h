@@ -0,0 +1,119 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef ALERTEVALUATIONSTATS_H
+#define ALERTEVALUATIONSTATS_H
+
+// dsa app headers
+#include "AlertLevel.h"
+
+// Qt headers
+#include <QObject>
+#include <QVariantList>
+#include <QVector>
+
+class QTimer;
+
+namespace Dsa {
+
+class AlertEvaluationStats : public QObject
+{
+  Q_OBJECT
+
+  Q_PROPERTY(qint64 evaluationCount READ evaluationCount NOTIFY statsChanged)
+  Q_PROPERTY(qint64 discardedCount READ discardedCount NOTIFY statsChanged)
+  Q_PROPERTY(qint64 deferredCount READ deferredCount NOTIFY statsChanged)
+  Q_PROPERTY(double evaluationsPerSecond READ evaluationsPerSecond NOTIFY statsChanged)
+  Q_PROPERTY(double averageQueryTime READ averageQueryTime NOTIFY statsChanged)
+  Q_PROPERTY(double averageLatency READ averageLatency NOTIFY statsChanged)
+  Q_PROPERTY(double maximumLatency READ maximumLatency NOTIFY statsChanged)
+  Q_PROPERTY(QVariantList latencyHistogram READ latencyHistogram NOTIFY statsChanged)
+  Q_PROPERTY(double budgetUsage READ budgetUsage NOTIFY statsChanged)
+  Q_PROPERTY(qint64 overBudgetCount READ overBudgetCount NOTIFY statsChanged)
+
+public:
+  explicit AlertEvaluationStats(QObject* parent = nullptr);
+  ~AlertEvaluationStats();
+
+  static QVariantList latencyHistogramBuckets();
+
+  qint64 evaluationCount() const;
+  qint64 discardedCount() const;
+  qint64 deferredCount() const;
+  double evaluationsPerSecond() const;
+  double averageQueryTime() const;
+  double averageLatency() const;
+  double maximumLatency() const;
+  QVariantList latencyHistogram() const;
+  double budgetUsage() const;
+  qint64 overBudgetCount() const;
+
+  Q_INVOKABLE double latencyPercentile(double percentile) const;
+
+  Q_INVOKABLE qint64 levelEvaluationCount(int level) const;
+  Q_INVOKABLE double levelAverageLatency(int level) const;
+  Q_INVOKABLE double levelMaximumLatency(int level) const;
+
+  void recordEvaluation(qint64 scheduledTimestamp, qint64 queryNsecs, AlertLevel level = AlertLevel::Unknown);
+  void recordDiscarded(int count = 1);
+  void recordDeferred();
+  void recordPass(qint64 passNsecs, int frameBudget);
+
+  Q_INVOKABLE QString summary() const;
+  Q_INVOKABLE void reset();
+
+signals:
+  void statsChanged();
+
+private:
+  Q_DISABLE_COPY(AlertEvaluationStats)
+
+  void updateRate();
+
+  struct LevelLatency
+  {
+    qint64 m_count = 0;
+    qint64 m_totalNsecs = 0;
+    qint64 m_maximumNsecs = 0;
+  };
+
+  QTimer* m_updateTimer = nullptr;
+  bool m_changed = false;
+
+  qint64 m_evaluationCount = 0;
+  qint64 m_discardedCount = 0;
+  qint64 m_deferredCount = 0;
+  qint64 m_totalQueryNsecs = 0;
+  qint64 m_latencyCount = 0;
+  qint64 m_totalLatencyNsecs = 0;
+  qint64 m_maximumLatencyNsecs = 0;
+  QVector<qint64> m_latencyHistogram;
+  QVector<LevelLatency> m_levelLatencies;
+
+  qint64 m_lastEvaluationCount = 0;
+  qint64 m_lastRateTimestamp = 0;
+  double m_evaluationsPerSecond = 0.0;
+
+  // the evaluation passes since the last update, against their frame budgets
+  qint64 m_passNsecs = 0;
+  qint64 m_passBudgetNsecs = 0;
+  qint64 m_overBudgetCount = 0;
+  double m_budgetUsage = 0.0;
+};
+
+} // Dsa
+
+#endif // ALERTEVALUATIONSTATS_H
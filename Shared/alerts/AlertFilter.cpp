@@ -48,6 +48,19 @@ AlertFilter::~AlertFilter()
 
 }
 
+/*!
+  \brief Adds the tests of this filter to \a spec, returning whether the filter
+  could be expressed that way.
+
+  Filters which can be composed are applied by \l AlertListProxyModel as part of
+  a single test against a packed record of each condition data. The default
+  implementation returns \c false, in which case \l passesFilter is called instead.
+ */
+bool AlertFilter::composeInto(AlertFilterSpec&) const
+{
+  return false;
+}
+
 
 } // Dsa
 
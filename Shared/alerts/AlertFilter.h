@@ -17,13 +17,25 @@
 #ifndef ALERTFILTER_H
 #define ALERTFILTER_H
 
+// dsa app headers
+#include "AlertLevel.h"
+
 // Qt headers
 #include <QObject>
+#include <QUuid>
+#include <QVector>
 
 namespace Dsa {
 
 class AlertConditionData;
 
+// the tests of several filters folded together, so that they can be applied without virtual calls
+struct AlertFilterSpec
+{
+  AlertLevel m_minLevel = AlertLevel::Unknown;
+  QVector<QUuid> m_excludedIds; // sorted and unique once composition is finished
+};
+
 class AlertFilter : public QObject
 {
   Q_OBJECT
@@ -33,6 +45,7 @@ public:
   ~AlertFilter();
 
   virtual bool passesFilter(AlertConditionData* alertData) const = 0;
+  virtual bool composeInto(AlertFilterSpec& spec) const;
 
 signals:
   void filterChanged();
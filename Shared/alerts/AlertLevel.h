@@ -28,6 +28,9 @@ enum class AlertLevel : unsigned int
   Critical
 };
 
+// the number of AlertLevel values, for arrays indexed by level
+constexpr int alertLevelCount = static_cast<int>(AlertLevel::Critical) + 1;
+
 } // Dsa
 
 #endif // ALERTLEVEL_H
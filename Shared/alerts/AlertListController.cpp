@@ -22,11 +22,16 @@
 
 // dsa app headers
 #include "AlertConditionData.h"
+#include "AlertConstants.h"
+#include "AlertEvaluationScheduler.h"
+#include "AlertEvaluationStats.h"
 #include "AlertListModel.h"
 #include "AlertListProxyModel.h"
 #include "AlertSource.h"
 #include "DsaUtility.h"
+#include "FrameAnimationDriver.h"
 #include "IdsAlertFilter.h"
+#include "MultiPointHighlighter.h"
 #include "PointHighlighter.h"
 #include "StatusAlertFilter.h"
 
@@ -42,6 +47,7 @@
 #include "SimpleRenderer.h"
 
 // Qt headers
+#include <QSet>
 #include <QTimer>
 
 using namespace Esri::ArcGISRuntime;
@@ -61,6 +67,15 @@ namespace Dsa {
 
   It also allows individual alerts to highlighted, zoomed to and marked as viewed.
 
+  While \l flashing is set, the active alerts are flashed on and off every
+  \c s_flashInterval milliseconds. The flashing is driven by the
+  \l FrameAnimationDriver, which pauses it while the view is not visible.
+
+  The locations of the flashing alerts are drawn together by a
+  \l MultiPointHighlighter, which follows their sources as they move. Each flash
+  shows or hides that one highlight, so flashing many alerts costs about the same
+  as flashing one.
+
   \sa AlertListModel
   \sa AlertListProxyModel
   \sa AlertConditionData
@@ -74,7 +89,8 @@ AlertListController::AlertListController(QObject* parent /* = nullptr */):
   m_alertsProxyModel(new AlertListProxyModel(AlertListModel::instance(), this)),
   m_statusAlertFilter(new StatusAlertFilter(this)),
   m_idsAlertFilter(new IdsAlertFilter(this)),
-  m_highlighter(new PointHighlighter(this))
+  m_highlighter(new PointHighlighter(this)),
+  m_flashHighlighter(new MultiPointHighlighter(this))
 {
   m_filters.append(m_statusAlertFilter);
   m_filters.append(m_idsAlertFilter);
@@ -82,9 +98,7 @@ AlertListController::AlertListController(QObject* parent /* = nullptr */):
   // sets the initial set of filters for condition data
   m_alertsProxyModel->applyFilter(m_filters);
 
-  connect(AlertListModel::instance(), &AlertListModel::dataChanged, this, &AlertListController::allAlertsCountChanged);
-  connect(AlertListModel::instance(), &AlertListModel::rowsInserted, this, &AlertListController::allAlertsCountChanged);
-  connect(AlertListModel::instance(), &AlertListModel::rowsRemoved, this, &AlertListController::allAlertsCountChanged);
+  connect(AlertListModel::instance(), &AlertListModel::activeCountChanged, this, &AlertListController::allAlertsCountChanged);
   emit allAlertsCountChanged();
 
   ToolManager::instance().addTool(this);
@@ -116,24 +130,7 @@ int AlertListController::allAlertsCount() const
   if (!model)
     return 0;
 
-  int count = 0;
-  const int alertsCount = model->rowCount();
-  for (int i = 0; i < alertsCount; ++i)
-  {
-    AlertConditionData* alert = model->alertAt(i);
-    if (!alert)
-      continue;
-
-    if (!alert->isActive())
-      continue;
-
-    if (!alert->isConditionEnabled())
-      continue;
-
-    count++;
-  }
-
-  return count;
+  return model->activeCount();
 }
 
 /*!
@@ -144,6 +141,36 @@ QString AlertListController::toolName() const
   return "Alert List";
 }
 
+/*! \brief Sets any values in \a properties which are relevant for the alert list controller.
+ *
+ * This tool will use the following key/value pairs in the \a properties map if they are set:
+ *
+ * \list
+ *  \li AlertHistoryCapacity. The maximum number of inactive alerts kept in the list.
+ *  \li AlertHistoryMaximumAge. The number of seconds inactive alerts are kept in the list.
+ *  \li AlertHistoryLog. The path of a log which alerts evicted from the list are appended to.
+ * \endlist
+ */
+void AlertListController::setProperties(const QVariantMap& properties)
+{
+  AlertListModel* model = AlertListModel::instance();
+  if (!model)
+    return;
+
+  bool ok = false;
+  const int capacity = properties.value(AlertConstants::ALERT_HISTORY_CAPACITY_PROPERTYNAME).toInt(&ok);
+  if (ok)
+    model->setHistoryCapacity(capacity);
+
+  const int maximumAge = properties.value(AlertConstants::ALERT_HISTORY_MAXIMUM_AGE_PROPERTYNAME).toInt(&ok);
+  if (ok)
+    model->setHistoryMaximumAge(maximumAge);
+
+  const auto logPath = properties.value(AlertConstants::ALERT_HISTORY_LOG_PROPERTYNAME);
+  if (!logPath.isNull())
+    model->setHistoryLogPath(logPath.toString());
+}
+
 /*!
   \brief Sets the highlight state for the active condition data at \a rowIndex in the filtered model to \a showHighlight.
 
@@ -277,6 +304,36 @@ void AlertListController::dismiss(int rowIndex)
   m_alertsProxyModel->applyFilter(m_filters);
 }
 
+/*!
+  \brief Dismiss all of the active alerts in the filtered model.
+
+  The IDs of the alert condition data are added to the current \l IdsAlertFilter
+  together, so that the alerts are only filtered once.
+ */
+void AlertListController::dismissAll()
+{
+  AlertListModel* model = AlertListModel::instance();
+  if (!model)
+    return;
+
+  const int rowCount = m_alertsProxyModel->rowCount();
+  if (rowCount == 0)
+    return;
+
+  QList<QUuid> ids;
+  ids.reserve(rowCount);
+  for (int rowIndex = 0; rowIndex < rowCount; ++rowIndex)
+  {
+    const QModelIndex sourceIndex = m_alertsProxyModel->mapToSource(m_alertsProxyModel->index(rowIndex, 0));
+    AlertConditionData* alert = model->alertAt(sourceIndex.row());
+    if (alert)
+      ids.append(alert->id());
+  }
+
+  m_idsAlertFilter->addIds(ids);
+  m_alertsProxyModel->applyFilter(m_filters);
+}
+
 /*!
   \brief Sets the minimum \l AlertLevel for the current \l StatusAlertFilter to \a level.
  */
@@ -308,13 +365,31 @@ void AlertListController::clearAllFilters()
 
 /*!
   \brief Sets the highlight state for all currently active condition data to \a highlight.
+
+  The highlight is drawn at the location of each active alert's source.
  */
 void AlertListController::flashAll(bool highlight)
+{
+  if (highlight)
+    updateFlashedAlerts();
+
+  m_flashHighlighter->setVisible(highlight);
+}
+
+/*!
+  \internal
+
+  Brings the alerts drawn by the flash highlight in line with the active alerts.
+  Alerts which stay active are left as they are, their locations being followed
+  as their sources change.
+ */
+void AlertListController::updateFlashedAlerts()
 {
   AlertListModel* model = AlertListModel::instance();
   if (!model)
     return;
 
+  QSet<AlertConditionData*> activeAlerts;
   const int modelSize = model->rowCount();
   for (int i = 0; i < modelSize; ++i)
   {
@@ -322,10 +397,120 @@ void AlertListController::flashAll(bool highlight)
     if (!alert || !alert->isActive() || !alert->isConditionEnabled())
       continue;
 
-    alert->highlight(highlight);
+    activeAlerts.insert(alert);
+    if (m_flashConnections.contains(alert))
+      continue;
+
+    m_flashHighlighter->setPoint(alert, alert->sourceLocation());
+
+    QList<QMetaObject::Connection> connections;
+    connections.append(connect(alert->source(), &AlertSource::dataChanged, this, [this, alert]()
+    {
+      m_flashHighlighter->setPoint(alert, alert->sourceLocation());
+    }));
+    connections.append(connect(alert, &AlertConditionData::noLongerValid, this, [this, alert]()
+    {
+      removeFlashedAlert(alert);
+    }));
+    connections.append(connect(alert, &QObject::destroyed, this, [this, alert]()
+    {
+      removeFlashedAlert(alert);
+    }));
+    m_flashConnections.insert(alert, connections);
+  }
+
+  const QList<AlertConditionData*> flashedAlerts = m_flashConnections.keys();
+  for (AlertConditionData* alert : flashedAlerts)
+  {
+    if (!activeAlerts.contains(alert))
+      removeFlashedAlert(alert);
   }
 }
 
+/*!
+  \internal
+ */
+void AlertListController::removeFlashedAlert(AlertConditionData* alert)
+{
+  const QList<QMetaObject::Connection> connections = m_flashConnections.take(alert);
+  for (const auto& connection : connections)
+    disconnect(connection);
+
+  m_flashHighlighter->removePoint(alert);
+}
+
+/*!
+  \internal
+ */
+void AlertListController::clearFlashedAlerts()
+{
+  for (const auto& connections : qAsConst(m_flashConnections))
+  {
+    for (const auto& connection : connections)
+      disconnect(connection);
+  }
+
+  m_flashConnections.clear();
+  m_flashHighlighter->clear();
+}
+
+/*!
+  \property AlertListController::flashing
+  \brief Whether the active alerts are flashing.
+ */
+bool AlertListController::isFlashing() const
+{
+  return m_flashing;
+}
+
+/*!
+  \brief Sets whether the active alerts are flashing to \a flashing.
+
+  When the flashing stops, the highlight is removed from all of the active alerts.
+ */
+void AlertListController::setFlashing(bool flashing)
+{
+  if (flashing == m_flashing)
+    return;
+
+  m_flashing = flashing;
+
+  if (m_flashing)
+  {
+    m_flashHighlighted = false;
+    FrameAnimationDriver::instance()->addAnimation(this, [this](qint64 elapsedMs)
+    {
+      // the alerts are only updated on the frames where the flash changes state
+      const bool flashHighlighted = (elapsedMs / s_flashInterval) % 2 == 1;
+      if (flashHighlighted != m_flashHighlighted)
+      {
+        m_flashHighlighted = flashHighlighted;
+        flashAll(m_flashHighlighted);
+      }
+
+      return true;
+    });
+  }
+  else
+  {
+    FrameAnimationDriver::instance()->removeAnimation(this);
+    m_flashHighlighted = false;
+    flashAll(false);
+    clearFlashedAlerts();
+  }
+
+  emit flashingChanged();
+}
+
+/*!
+  \property AlertListController::evaluationStats
+  \brief Returns the \l AlertEvaluationStats for the evaluation of all alert conditions.
+ */
+QObject* AlertListController::evaluationStats() const
+{
+  return AlertEvaluationScheduler::instance()->stats();
+}
+
 } // Dsa
 
 // Signal Documentation
@@ -343,3 +528,8 @@ void AlertListController::flashAll(bool highlight)
   \fn void AlertListController::highlightStopped();
   \brief Signal emitted highlighting has stopped.
  */
+
+/*!
+  \fn void AlertListController::flashingChanged();
+  \brief Signal emitted when the \l flashing property changes.
+ */
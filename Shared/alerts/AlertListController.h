@@ -22,6 +22,7 @@
 
 // Qt headers
 #include <QAbstractListModel>
+#include <QHash>
 
 namespace Esri {
 namespace ArcGISRuntime
@@ -32,8 +33,10 @@ namespace ArcGISRuntime
 
 namespace Dsa {
 
+class MultiPointHighlighter;
 class PointHighlighter;
 
+class AlertConditionData;
 class AlertFilter;
 class AlertListProxyModel;
 class IdsAlertFilter;
@@ -45,6 +48,8 @@ class AlertListController : public AbstractTool
 
   Q_PROPERTY(QAbstractItemModel* alertListModel READ alertListModel NOTIFY alertListModelChanged)
   Q_PROPERTY(int allAlertsCount READ allAlertsCount NOTIFY allAlertsCountChanged)
+  Q_PROPERTY(bool flashing READ isFlashing WRITE setFlashing NOTIFY flashingChanged)
+  Q_PROPERTY(QObject* evaluationStats READ evaluationStats CONSTANT)
 
 public:
   explicit AlertListController(QObject* parent = nullptr);
@@ -55,22 +60,36 @@ public:
 
   // AbstractTool interface
   QString toolName() const override;
+  void setProperties(const QVariantMap& properties) override;
 
   Q_INVOKABLE void highlight(int rowIndex, bool showHighlight);
   Q_INVOKABLE void zoomTo(int rowIndex);
   Q_INVOKABLE void setViewed(int rowIndex);
   Q_INVOKABLE void dismiss(int rowIndex);
+  Q_INVOKABLE void dismissAll();
   Q_INVOKABLE void setMinLevel(int level);
   Q_INVOKABLE void clearAllFilters();
 
   Q_INVOKABLE void flashAll(bool highlight);
 
+  bool isFlashing() const;
+  void setFlashing(bool flashing);
+
+  QObject* evaluationStats() const;
+
+  static constexpr qint64 s_flashInterval = 500;
+
 signals:
   void alertListModelChanged();
   void allAlertsCountChanged();
   void highlightStopped();
+  void flashingChanged();
 
 private:
+  void updateFlashedAlerts();
+  void removeFlashedAlert(AlertConditionData* alert);
+  void clearFlashedAlerts();
+
   AlertListProxyModel* m_alertsProxyModel = nullptr;
   StatusAlertFilter* m_statusAlertFilter = nullptr;
   IdsAlertFilter* m_idsAlertFilter = nullptr;
@@ -78,6 +97,12 @@ private:
   PointHighlighter* m_highlighter = nullptr;
 
   QList<QMetaObject::Connection> m_highlightConnections;
+
+  // the active alerts are flashed together by a single highlight which follows their sources
+  MultiPointHighlighter* m_flashHighlighter = nullptr;
+  QHash<AlertConditionData*, QList<QMetaObject::Connection>> m_flashConnections;
+  bool m_flashing = false;
+  bool m_flashHighlighted = false;
 };
 
 } // Dsa
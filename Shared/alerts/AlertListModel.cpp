@@ -23,7 +23,14 @@
 #include "AlertConditionData.h"
 
 // Qt headers
+#include <QDateTime>
+#include <QFile>
+#include <QTextStream>
 #include <QUuid>
+#include <QVector>
+
+// STL headers
+#include <algorithm>
 
 using namespace Esri::ArcGISRuntime;
 
@@ -59,6 +66,20 @@ namespace Dsa {
         \li bool
         \li Whether the alert condition has been viewed.
   \endtable
+
+  Condition data which are inactive, and which have either been viewed or
+  have never been active, form the alert history. The history is limited to
+  \l historyCapacity entries and, optionally, to entries younger than
+  \l historyMaximumAge. The oldest entries beyond these limits are evicted
+  from the model and, if a \l historyLogPath is set, appended to that log.
+  Evicted condition data are restored to the model if they become active
+  again. Active condition data are never evicted.
+
+  The rows are kept in priority order: active condition data come first, then
+  those with the highest level, then those which most recently became active
+  or inactive. New condition data are inserted at their row with a binary
+  search, and condition data whose order changes are moved to their new row,
+  so the order is never re-sorted as a whole.
  */
 
 /*!
@@ -82,6 +103,14 @@ AlertListModel::AlertListModel(QObject* parent):
   m_roles[AlertListRoles::Name] = "name";
   m_roles[AlertListRoles::Level] = "level";
   m_roles[AlertListRoles::Viewed] = "viewed";
+
+  // changes to condition data are reported in batches once per event-loop tick
+  m_flushTimer.setSingleShot(true);
+  m_flushTimer.setInterval(0);
+  connect(&m_flushTimer, &QTimer::timeout, this, &AlertListModel::flushChangedRows);
+
+  // expired history is checked periodically when a maximum age is set
+  connect(&m_historyTimer, &QTimer::timeout, this, &AlertListModel::evictHistory);
 }
 
 /*!
@@ -105,31 +134,12 @@ bool AlertListModel::addAlertConditionData(AlertConditionData* newConditionData)
   if (!newConditionData->id().isNull())
     return false;
 
-  const int size = m_alerts.size();
-  const int insertIdx = size == 0 ? 0 : size;
   const QUuid id = QUuid::createUuid();
   newConditionData->setId(id);
 
   auto handleDataChanged = [this, newConditionData]()
   {
-    if (newConditionData->id().isNull())
-      return;
-
-    auto it = m_alerts.cbegin();
-    auto itEnd = m_alerts.cend();
-    int currRow = 0;
-    for (; it != itEnd; ++it, ++currRow)
-    {
-      AlertConditionData* testAlert = *it;
-      if (!testAlert)
-        continue;
-
-      if (testAlert->id() == newConditionData->id())
-      {
-        const QModelIndex changedIndex = index(currRow, 0);
-        emit dataChanged(changedIndex, changedIndex);
-      }
-    }
+    handleAlertChanged(newConditionData);
   };
 
   connect(newConditionData, &AlertConditionData::viewedChanged, this, handleDataChanged);
@@ -140,11 +150,129 @@ bool AlertListModel::addAlertConditionData(AlertConditionData* newConditionData)
     removeAlert(newConditionData);
   });
 
+  insertAlert(newConditionData);
+
+  return true;
+}
+
+/*!
+  \internal
+
+  Inserts the row for \a alert, which may be new or restored from the evicted history,
+  in priority order.
+ */
+void AlertListModel::insertAlert(AlertConditionData* alert)
+{
+  updateActiveCount(alert);
+
+  const SortKey key = sortKey(alert);
+  const int insertIdx = sortedRow(key, 0, m_alerts.size());
+
   beginInsertRows(QModelIndex(), insertIdx, insertIdx);
-  m_alerts.append(newConditionData);
+  m_alerts.insert(insertIdx, alert);
+  m_sortKeys.insert(alert, key);
+  updateRows(insertIdx);
   endInsertRows();
 
-  return true;
+  updateHistory(alert);
+}
+
+/*!
+  \internal
+
+  Returns the key which orders \a alert from its current state. The time of the
+  key only moves on when \a alert is added or changes active state.
+ */
+AlertListModel::SortKey AlertListModel::sortKey(AlertConditionData* alert) const
+{
+  SortKey key;
+  key.active = m_activeAlerts.contains(alert);
+  key.level = static_cast<int>(alert->level());
+
+  auto it = m_sortKeys.constFind(alert);
+  key.time = (it != m_sortKeys.constEnd() && it.value().active == key.active) ? it.value().time
+                                                                               : QDateTime::currentMSecsSinceEpoch();
+  return key;
+}
+
+/*!
+  \internal
+
+  Returns the row, between \a first and \a last, before which a condition data
+  with \a key belongs. The rows in that range must be in order.
+ */
+int AlertListModel::sortedRow(const SortKey& key, int first, int last) const
+{
+  auto it = std::upper_bound(m_alerts.constBegin() + first, m_alerts.constBegin() + last, key,
+                             [this](const SortKey& rowKey, AlertConditionData* alert)
+  {
+    return rowKey.precedes(m_sortKeys.value(alert));
+  });
+
+  return static_cast<int>(it - m_alerts.constBegin());
+}
+
+/*!
+  \internal
+
+  Moves the row for \a alert if its state has changed its order.
+
+  The other rows are still in order, so only its neighbours are compared before
+  the new row is found with a binary search.
+ */
+void AlertListModel::updateSortOrder(AlertConditionData* alert)
+{
+  auto rowIt = m_rows.constFind(alert);
+  if (rowIt == m_rows.constEnd())
+    return;
+
+  const SortKey key = sortKey(alert);
+  if (key == m_sortKeys.value(alert))
+    return;
+
+  m_sortKeys.insert(alert, key);
+
+  const int row = rowIt.value();
+  int newRow = row;
+  if (row > 0 && key.precedes(m_sortKeys.value(m_alerts.at(row - 1))))
+    newRow = sortedRow(key, 0, row);
+  else if (row + 1 < m_alerts.size() && m_sortKeys.value(m_alerts.at(row + 1)).precedes(key))
+    newRow = sortedRow(key, row + 1, m_alerts.size()) - 1;
+
+  if (newRow == row)
+    return;
+
+  // the destination of a move is given as a row before the move
+  beginMoveRows(QModelIndex(), row, row, QModelIndex(), newRow > row ? newRow + 1 : newRow);
+  m_alerts.move(row, newRow);
+  updateRows(std::min(row, newRow));
+  endMoveRows();
+}
+
+/*!
+  \internal
+
+  Returns whether the two keys order condition data the same.
+ */
+bool AlertListModel::SortKey::operator==(const SortKey& other) const
+{
+  return active == other.active && level == other.level && time == other.time;
+}
+
+/*!
+  \internal
+
+  Returns whether condition data with this key come before those with \a other.
+ */
+bool AlertListModel::SortKey::precedes(const SortKey& other) const
+{
+  if (active != other.active)
+    return active;
+
+  if (level != other.level)
+    return level > other.level;
+
+  return time > other.time;
 }
 
 /*!
@@ -158,20 +286,14 @@ void AlertListModel::removeAlert(AlertConditionData* conditionData)
   if (conditionData->id().isNull())
     return;
 
-  const QUuid theId = conditionData->id();
-
-  for (int i = 0; i < m_alerts.size(); ++i)
-  {
-    AlertConditionData* testAlert = m_alerts.at(i);
-    if (!testAlert)
-      continue;
+  if (m_evictedAlerts.remove(conditionData))
+    return;
 
-    if (testAlert->id() != theId)
-      continue;
+  auto it = m_rows.constFind(conditionData);
+  if (it == m_rows.constEnd())
+    return;
 
-    removeAt(i);
-    break;
-  }
+  removeAt(it.value());
 }
 
 /*!
@@ -194,7 +316,320 @@ void AlertListModel::removeAt(int rowIndex)
 
   beginRemoveRows(QModelIndex(), rowIndex, rowIndex);
   m_alerts.removeAt(rowIndex);
+  m_rows.remove(alert);
+  m_sortKeys.remove(alert);
+  m_changedAlerts.remove(alert);
+  m_raisedAlerts.remove(alert);
+  m_historyTimes.remove(alert);
+  updateRows(rowIndex);
   endRemoveRows();
+
+  if (m_activeAlerts.remove(alert))
+    emit activeCountChanged();
+}
+
+/*!
+  \brief Returns the number of condition data objects in the model which are
+  both enabled and active.
+
+  The count is maintained as condition data are added, removed or change, so
+  it is cheap to query.
+ */
+int AlertListModel::activeCount() const
+{
+  return m_activeAlerts.size();
+}
+
+/*!
+  \internal
+
+  Records that \a alert has changed. The active count is updated immediately,
+  but the \c dataChanged notification for its row is deferred so that all
+  of the changes which occur in one event-loop tick are reported together.
+ */
+void AlertListModel::handleAlertChanged(AlertConditionData* alert)
+{
+  if (m_evictedAlerts.contains(alert))
+  {
+    if (alert->isConditionEnabled() && alert->isActive())
+    {
+      m_evictedAlerts.remove(alert);
+      insertAlert(alert);
+    }
+    return;
+  }
+
+  if (!m_rows.contains(alert))
+    return;
+
+  updateActiveCount(alert);
+  updateHistory(alert);
+
+  m_changedAlerts.insert(alert);
+  if (!m_flushTimer.isActive())
+    m_flushTimer.start();
+}
+
+/*!
+  \internal
+
+  Adds or removes \a alert from the set of active condition data and emits
+  \l activeCountChanged if the count has changed.
+ */
+void AlertListModel::updateActiveCount(AlertConditionData* alert)
+{
+  const bool active = alert->isConditionEnabled() && alert->isActive();
+  const bool changed = active ? !m_activeAlerts.contains(alert) : m_activeAlerts.contains(alert);
+  if (!changed)
+    return;
+
+  if (active)
+    m_activeAlerts.insert(alert);
+  else
+    m_activeAlerts.remove(alert);
+
+  emit activeCountChanged();
+}
+
+/*!
+  \internal
+
+  Adds \a alert to the history if it is inactive and has either been viewed or
+  never been active. Otherwise, removes it from the history.
+ */
+void AlertListModel::updateHistory(AlertConditionData* alert)
+{
+  const bool active = m_activeAlerts.contains(alert);
+  if (active)
+    m_raisedAlerts.insert(alert);
+
+  const bool inHistory = !active && (alert->viewed() || !m_raisedAlerts.contains(alert));
+  if (!inHistory)
+  {
+    // any entry left in the queue is skipped when it reaches the front
+    m_historyTimes.remove(alert);
+    return;
+  }
+
+  if (m_historyTimes.contains(alert))
+    return;
+
+  HistoryEntry entry;
+  entry.alert = alert;
+  entry.time = QDateTime::currentMSecsSinceEpoch();
+  m_historyTimes.insert(alert, entry.time);
+  m_history.enqueue(entry);
+
+  // drop skipped entries if alerts repeatedly leave and re-enter the history
+  if (m_history.size() > 2 * m_historyTimes.size() + s_defaultHistoryCapacity)
+  {
+    QQueue<HistoryEntry> history;
+    for (const HistoryEntry& queued : qAsConst(m_history))
+    {
+      if (m_historyTimes.value(queued.alert, -1) == queued.time)
+        history.enqueue(queued);
+    }
+    m_history.swap(history);
+  }
+
+  if (m_historyCapacity >= 0 && m_historyTimes.size() > m_historyCapacity && !m_flushTimer.isActive())
+    m_flushTimer.start();
+}
+
+/*!
+  \internal
+
+  Refreshes the cached row of each condition data from \a firstRow onwards.
+ */
+void AlertListModel::updateRows(int firstRow)
+{
+  for (int i = firstRow; i < m_alerts.size(); ++i)
+    m_rows[m_alerts.at(i)] = i;
+}
+
+/*!
+  \internal
+
+  Moves the rows which have changed since the last flush to their new order and
+  emits \c dataChanged for them, merging adjacent rows into a single range, then
+  evicts any history beyond the configured limits.
+ */
+void AlertListModel::flushChangedRows()
+{
+  for (AlertConditionData* alert : qAsConst(m_changedAlerts))
+    updateSortOrder(alert);
+
+  QVector<int> changedRows;
+  changedRows.reserve(m_changedAlerts.size());
+  for (AlertConditionData* alert : qAsConst(m_changedAlerts))
+  {
+    auto it = m_rows.constFind(alert);
+    if (it != m_rows.constEnd())
+      changedRows.append(it.value());
+  }
+  m_changedAlerts.clear();
+
+  std::sort(changedRows.begin(), changedRows.end());
+
+  int rangeStart = 0;
+  for (int i = 1; i <= changedRows.size(); ++i)
+  {
+    if (i < changedRows.size() && changedRows.at(i) == changedRows.at(i - 1) + 1)
+      continue;
+
+    emit dataChanged(index(changedRows.at(rangeStart), 0), index(changedRows.at(i - 1), 0));
+    rangeStart = i;
+  }
+
+  // rows are evicted once their changes have been reported
+  evictHistory();
+}
+
+/*!
+  \internal
+
+  Evicts the oldest history entries beyond the \l historyCapacity and any
+  entries older than the \l historyMaximumAge.
+ */
+void AlertListModel::evictHistory()
+{
+  const qint64 expiryTime = QDateTime::currentMSecsSinceEpoch() - static_cast<qint64>(m_historyMaximumAge) * 1000;
+
+  QList<AlertConditionData*> evicted;
+  while (!m_history.isEmpty())
+  {
+    const HistoryEntry& entry = m_history.head();
+    if (m_historyTimes.value(entry.alert, -1) != entry.time)
+    {
+      m_history.dequeue();
+      continue;
+    }
+
+    const bool overCapacity = m_historyCapacity >= 0 && m_historyTimes.size() > m_historyCapacity;
+    const bool expired = m_historyMaximumAge > 0 && entry.time <= expiryTime;
+    if (!overCapacity && !expired)
+      break;
+
+    m_historyTimes.remove(entry.alert);
+    evicted.append(m_history.dequeue().alert);
+  }
+
+  if (evicted.isEmpty())
+    return;
+
+  for (AlertConditionData* alert : qAsConst(evicted))
+  {
+    removeAt(m_rows.value(alert, -1));
+    m_evictedAlerts.insert(alert);
+  }
+
+  writeHistoryLog(evicted);
+}
+
+/*!
+  \internal
+
+  Appends a line for each of the evicted \a alerts to the \l historyLogPath.
+ */
+void AlertListModel::writeHistoryLog(const QList<AlertConditionData*>& alerts) const
+{
+  if (m_historyLogPath.isEmpty())
+    return;
+
+  QFile logFile(m_historyLogPath);
+  if (!logFile.open(QIODevice::Append | QIODevice::Text))
+    return;
+
+  const QString evictedTime = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+
+  QTextStream stream(&logFile);
+  for (AlertConditionData* alert : alerts)
+  {
+    stream << evictedTime << '\t'
+           << alert->id().toString() << '\t'
+           << static_cast<int>(alert->level()) << '\t'
+           << alert->name() << '\n';
+  }
+}
+
+/*!
+  \brief Returns the maximum number of entries in the alert history.
+
+  A negative value means that the history is not limited by size. The default is 1000.
+ */
+int AlertListModel::historyCapacity() const
+{
+  return m_historyCapacity;
+}
+
+/*!
+  \brief Sets the maximum number of entries in the alert history to \a capacity.
+
+  Older entries beyond this are evicted from the model. A negative value means
+  that the history is not limited by size.
+ */
+void AlertListModel::setHistoryCapacity(int capacity)
+{
+  if (capacity == m_historyCapacity)
+    return;
+
+  m_historyCapacity = capacity;
+  evictHistory();
+}
+
+/*!
+  \brief Returns the maximum age, in seconds, of entries in the alert history.
+
+  A value of \c 0 means that the history is not limited by age. This is the default.
+ */
+int AlertListModel::historyMaximumAge() const
+{
+  return m_historyMaximumAge;
+}
+
+/*!
+  \brief Sets the maximum age of entries in the alert history to \a seconds.
+
+  Entries which have been in the history for longer are evicted from the model.
+  A value of \c 0 means that the history is not limited by age.
+ */
+void AlertListModel::setHistoryMaximumAge(int seconds)
+{
+  if (seconds < 0)
+    seconds = 0;
+
+  if (seconds == m_historyMaximumAge)
+    return;
+
+  m_historyMaximumAge = seconds;
+
+  if (m_historyMaximumAge > 0)
+    m_historyTimer.start(std::min(m_historyMaximumAge * 1000, s_maximumHistoryInterval));
+  else
+    m_historyTimer.stop();
+
+  evictHistory();
+}
+
+/*!
+  \brief Returns the path of the log which evicted history entries are appended to.
+
+  An empty path means that evicted entries are not logged. This is the default.
+ */
+QString AlertListModel::historyLogPath() const
+{
+  return m_historyLogPath;
+}
+
+/*!
+  \brief Sets the path of the log which evicted history entries are appended to, to \a path.
+
+  Each entry is written as a tab-separated line of the eviction time, the alert
+  ID, the alert level and the alert name.
+ */
+void AlertListModel::setHistoryLogPath(const QString& path)
+{
+  m_historyLogPath = path;
 }
 
 
@@ -286,6 +721,11 @@ bool AlertListModel::setData(const QModelIndex& index, const QVariant& value, in
   return valueSet;
 }
 
+/*!
+  \fn void AlertListModel::activeCountChanged();
+  \brief Signal emitted when the \l activeCount changes.
+ */
+
 /*!
   \brief Returns the hash of role names used by the model.
 
@@ -21,6 +21,9 @@
 #include <QAbstractListModel>
 #include <QHash>
 #include <QList>
+#include <QQueue>
+#include <QSet>
+#include <QTimer>
 
 namespace Dsa {
 
@@ -51,19 +54,77 @@ public:
 
   void removeAt(int rowIndex);
 
+  int activeCount() const;
+
+  int historyCapacity() const;
+  void setHistoryCapacity(int capacity);
+
+  int historyMaximumAge() const;
+  void setHistoryMaximumAge(int seconds);
+
+  QString historyLogPath() const;
+  void setHistoryLogPath(const QString& path);
+
   // QAbstractItemModel interface
   int rowCount(const QModelIndex& parent = QModelIndex()) const override;
   QVariant data(const QModelIndex& index, int role) const override;
   bool setData(const QModelIndex& index, const QVariant& value, int role) override;
 
+signals:
+  void activeCountChanged();
+
 protected:
   QHash<int, QByteArray> roleNames() const override;
 
 private:
   AlertListModel(QObject* parent = nullptr);
 
+  struct HistoryEntry
+  {
+    AlertConditionData* alert = nullptr;
+    qint64 time = 0;
+  };
+
+  struct SortKey
+  {
+    bool active = false;
+    int level = 0;
+    qint64 time = 0;
+
+    bool operator==(const SortKey& other) const;
+    bool precedes(const SortKey& other) const;
+  };
+
+  void insertAlert(AlertConditionData* alert);
+  SortKey sortKey(AlertConditionData* alert) const;
+  int sortedRow(const SortKey& key, int first, int last) const;
+  void updateSortOrder(AlertConditionData* alert);
+  void handleAlertChanged(AlertConditionData* alert);
+  void updateActiveCount(AlertConditionData* alert);
+  void updateHistory(AlertConditionData* alert);
+  void updateRows(int firstRow);
+  void flushChangedRows();
+  void evictHistory();
+  void writeHistoryLog(const QList<AlertConditionData*>& alerts) const;
+
+  static constexpr int s_defaultHistoryCapacity = 1000;
+  static constexpr int s_maximumHistoryInterval = 60000;
+
   QHash<int, QByteArray>  m_roles;
   QList<AlertConditionData*>   m_alerts;
+  QHash<AlertConditionData*, int> m_rows;
+  QHash<AlertConditionData*, SortKey> m_sortKeys;
+  QSet<AlertConditionData*> m_changedAlerts;
+  QSet<AlertConditionData*> m_activeAlerts;
+  QSet<AlertConditionData*> m_raisedAlerts;
+  QHash<AlertConditionData*, qint64> m_historyTimes;
+  QQueue<HistoryEntry> m_history;
+  QSet<AlertConditionData*> m_evictedAlerts;
+  QTimer m_flushTimer;
+  QTimer m_historyTimer;
+  int m_historyCapacity = s_defaultHistoryCapacity;
+  int m_historyMaximumAge = 0;
+  QString m_historyLogPath;
 };
 
 } // Dsa
@@ -24,8 +24,22 @@
 #include "AlertFilter.h"
 #include "AlertListModel.h"
 
+// STL headers
+#include <algorithm>
+
 namespace Dsa {
 
+// the cached filter state of a source row
+static constexpr signed char s_unknownState = -1;
+static constexpr signed char s_failState = 0;
+static constexpr signed char s_passState = 1;
+
+// the flags of a packed alert record
+static constexpr unsigned char s_validFlag = 0x01;
+static constexpr unsigned char s_enabledFlag = 0x02;
+static constexpr unsigned char s_activeFlag = 0x04;
+static constexpr unsigned char s_requiredFlags = s_validFlag | s_enabledFlag | s_activeFlag;
+
 /*!
   \class Dsa::AlertListProxyModel
   \inmodule Dsa
@@ -36,48 +50,76 @@ namespace Dsa {
 
 /*!
   \brief Constructor for a new proxy model taking a \a sourceModel and an optional \a parent.
+
+  The pass or fail state of each source row is cached. Only the rows named by a change
+  notification from the source model are re-tested, and the tests use the cached
+  active state of each condition data rather than re-running its query.
+
+  The values needed to filter each row (its ID, level, and enabled and active
+  states) are also kept in a contiguous list of packed records, which is updated
+  with the row states. Filters which support \l AlertFilter::composeInto are
+  folded into a single \l AlertFilterSpec, so re-filtering every row when the
+  filters change is a loop over the records, without touching the condition data.
  */
 AlertListProxyModel::AlertListProxyModel(AlertListModel* sourceModel, QObject* parent):
   QSortFilterProxyModel(parent),
   m_sourceModel(sourceModel)
 {
-  setSourceModel(m_sourceModel);
+  // these connections are made before the source model is set, so that the cached
+  // row states are updated before QSortFilterProxyModel handles the same changes
 
-  // handle changes to a given condition data in the underlying AlertListModel
-  connect(m_sourceModel, &AlertListModel::dataChanged, this, [this](const QModelIndex& topLeft)
+  // handle changes to condition data in the underlying AlertListModel
+  connect(m_sourceModel, &AlertListModel::dataChanged, this, [this](const QModelIndex& topLeft, const QModelIndex& bottomRight)
   {
-    // check whether the changed condition data is currently included in the filtered model
-    const bool inModel = m_rowsInModel.value(topLeft.row(), false);
+    updateRowStates(topLeft.row(), bottomRight.row());
+  });
 
-    // check whether the changed condition should now be included
-    const bool shouldBeInModel = passesAllQueries(topLeft.row());
+  // the state of new condition data is found when they are first filtered
+  connect(m_sourceModel, &AlertListModel::rowsInserted, this, [this](const QModelIndex&, int first, int last)
+  {
+    m_rowStates.insert(first, last - first + 1, s_unknownState);
+    m_records.insert(first, last - first + 1, AlertRecord());
+    for (int row = first; row <= last; ++row)
+      m_records[row] = createRecord(row);
+  });
 
-    // if the condition data has changed state, cache the new state and re-run the filter
-    if (inModel != shouldBeInModel)
+  // handle condition data being removed from the underlying AlertListModel
+  connect(m_sourceModel, &AlertListModel::rowsRemoved, this, [this](const QModelIndex&, int first, int last)
+  {
+    m_rowStates.remove(first, last - first + 1);
+    m_records.remove(first, last - first + 1);
+  });
+
+  // the underlying AlertListModel moves a row when its priority order changes
+  connect(m_sourceModel, &AlertListModel::rowsMoved, this, [this](const QModelIndex&, int first, int last, const QModelIndex&, int destination)
+  {
+    const int count = last - first + 1;
+    const int newFirst = destination > first ? destination - count : destination;
+    const QVector<signed char> rowStates = m_rowStates.mid(first, count);
+    const QVector<AlertRecord> records = m_records.mid(first, count);
+    m_rowStates.remove(first, count);
+    m_records.remove(first, count);
+    for (int i = 0; i < count; ++i)
     {
-      m_rowsInModel.insert(topLeft.row(), shouldBeInModel);
-      invalidate();
+      m_rowStates.insert(newFirst + i, rowStates.at(i));
+      m_records.insert(newFirst + i, records.at(i));
     }
   });
 
-  // handle the addition of a new condition data in the underlying AlertListModel
-  connect(m_sourceModel, &AlertListModel::rowsInserted, this, [this](const QModelIndex&, int first, int)
+  auto resetRecords = [this]()
   {
-    // only clear the cache if this is an insert rather than an append
-    if (m_rowsInModel.contains(first))
-      m_rowsInModel.clear();
+    const int rowCount = m_sourceModel->rowCount();
+    m_rowStates.fill(s_unknownState, rowCount);
+    m_records.resize(rowCount);
+    for (int row = 0; row < rowCount; ++row)
+      m_records[row] = createRecord(row);
+  };
 
-    // re-run the filter
-    invalidate();
-  });
+  connect(m_sourceModel, &AlertListModel::modelReset, this, resetRecords);
 
-  // handle condition data being removed from the underlying AlertListModel
-  connect(m_sourceModel, &AlertListModel::rowsRemoved, this, [this]()
-  {
-    m_rowsInModel.clear();
-    invalidate();
-  });
+  resetRecords();
 
+  setSourceModel(m_sourceModel);
 }
 
 /*!
@@ -93,9 +135,28 @@ AlertListProxyModel::~AlertListProxyModel()
  */
 void AlertListProxyModel::applyFilter(const QList<AlertFilter*>& filters)
 {
+  for (const auto& connection : m_filterConnections)
+    disconnect(connection);
+
+  m_filterConnections.clear();
+
   m_filters = filters;
-  m_rowsInModel.clear();
-  invalidate();
+
+  // a filter which changes is composed again before the next row is tested
+  for (AlertFilter* filter : m_filters)
+  {
+    if (!filter)
+      continue;
+
+    m_filterConnections.append(connect(filter, &AlertFilter::filterChanged, this, [this]()
+    {
+      m_filterSpecDirty = true;
+    }));
+  }
+
+  m_filterSpecDirty = true;
+  m_rowStates.fill(s_unknownState);
+  invalidateFilter();
 }
 
 
@@ -105,11 +166,76 @@ void AlertListProxyModel::applyFilter(const QList<AlertFilter*>& filters)
  */
 bool AlertListProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex&) const
 {
+  if (sourceRow < 0 || sourceRow >= m_rowStates.size())
+    return passesAllQueries(sourceRow);
+
   // if required, update the cache to record the filter state for the condition data
-  if (!m_rowsInModel.contains(sourceRow))
-    m_rowsInModel.insert(sourceRow, passesAllQueries(sourceRow));
+  if (m_rowStates.at(sourceRow) == s_unknownState)
+    m_rowStates[sourceRow] = passesAllQueries(sourceRow) ? s_passState : s_failState;
 
-  return m_rowsInModel.value(sourceRow);
+  return m_rowStates.at(sourceRow) == s_passState;
+}
+
+/*!
+  \internal
+
+  Re-tests the cached state of the source rows from \a first to \a last.
+ */
+void AlertListProxyModel::updateRowStates(int first, int last)
+{
+  const int lastRow = std::min(last, m_rowStates.size() - 1);
+  for (int row = std::max(0, first); row <= lastRow; ++row)
+  {
+    m_records[row] = createRecord(row);
+    m_rowStates[row] = passesAllQueries(row) ? s_passState : s_failState;
+  }
+}
+
+/*!
+  \internal
+
+  Returns a packed record of the values of the condition data at \a sourceRow
+  which are used for filtering.
+ */
+AlertListProxyModel::AlertRecord AlertListProxyModel::createRecord(int sourceRow) const
+{
+  AlertRecord record;
+
+  AlertConditionData* conditionData = m_sourceModel->alertAt(sourceRow);
+  if (!conditionData)
+    return record;
+
+  record.m_id = conditionData->id();
+  record.m_level = static_cast<unsigned char>(conditionData->level());
+  record.m_flags = s_validFlag |
+                   (conditionData->isConditionEnabled() ? s_enabledFlag : 0) |
+                   (conditionData->isActive() ? s_activeFlag : 0);
+
+  return record;
+}
+
+/*!
+  \internal
+
+  Folds the current filters into \c m_filterSpec. Filters which cannot be folded
+  are kept to be tested individually.
+ */
+void AlertListProxyModel::composeFilters() const
+{
+  m_filterSpec = AlertFilterSpec();
+  m_uncomposedFilters.clear();
+
+  for (AlertFilter* filter : m_filters)
+  {
+    if (filter && !filter->composeInto(m_filterSpec))
+      m_uncomposedFilters.append(filter);
+  }
+
+  auto& excludedIds = m_filterSpec.m_excludedIds;
+  std::sort(excludedIds.begin(), excludedIds.end());
+  excludedIds.erase(std::unique(excludedIds.begin(), excludedIds.end()), excludedIds.end());
+
+  m_filterSpecDirty = false;
 }
 
 /*!
@@ -119,32 +245,37 @@ bool AlertListProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex&) co
  */
 bool AlertListProxyModel::passesAllQueries(int sourceRow) const
 {
-  // if the condition data is invalid, stop
-  AlertConditionData* conditionData = m_sourceModel->alertAt(sourceRow);
-  if (!conditionData)
+  if (m_filterSpecDirty)
+    composeFilters();
+
+  const AlertRecord record = (sourceRow >= 0 && sourceRow < m_records.size()) ? m_records.at(sourceRow)
+                                                                              : createRecord(sourceRow);
+
+  // the condition data must be valid and enabled, and - as the cached active state is
+  // used, since queries are run by the AlertEvaluationScheduler - currently satisfy its
+  // underlying condition. It must also meet the minimum level of the filters
+  const bool passesFlags = (record.m_flags & s_requiredFlags) == s_requiredFlags;
+  const bool passesLevel = record.m_level >= static_cast<unsigned char>(m_filterSpec.m_minLevel);
+  if (!(passesFlags & passesLevel))
     return false;
 
-  // skip conditions data which is disabled
-  if (!conditionData->isConditionEnabled())
+  const auto& excludedIds = m_filterSpec.m_excludedIds;
+  if (!excludedIds.isEmpty() && std::binary_search(excludedIds.cbegin(), excludedIds.cend(), record.m_id))
     return false;
 
-  // check whether and of the active AlertFilters exclude this condition data
-  auto filterIt = m_filters.cbegin();
-  auto filterEnd = m_filters.cend();
-  for (; filterIt != filterEnd; ++filterIt)
-  {
-    const auto rule = *filterIt;
-    if (!rule)
-      continue;
+  if (m_uncomposedFilters.isEmpty())
+    return true;
 
+  // check whether any of the filters which could not be composed exclude this condition data
+  AlertConditionData* conditionData = m_sourceModel->alertAt(sourceRow);
+  for (const auto rule : m_uncomposedFilters)
+  {
     // if a rule excludes the condition data, it should not be in the model
     if (!rule->passesFilter(conditionData))
       return false;
   }
 
-  // if the condition data passes all filters, it should be in the filtered model
-  // if it currently satisfies its underlying condition
-  return conditionData->matchesQuery();
+  return true;
 }
 
 } // Dsa
@@ -17,14 +17,16 @@
 #ifndef ALERTLISTPROXYMODEL_H
 #define ALERTLISTPROXYMODEL_H
 
+// dsa app headers
+#include "AlertFilter.h"
+
 // Qt headers
-#include <QHash>
 #include <QList>
 #include <QSortFilterProxyModel>
+#include <QVector>
 
 namespace Dsa {
 
-class AlertFilter;
 class AlertListModel;
 
 class AlertListProxyModel : public QSortFilterProxyModel
@@ -43,11 +45,27 @@ protected:
   bool filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const override;
 
 private:
+  // the values of a condition data which are needed to filter it
+  struct AlertRecord
+  {
+    QUuid m_id;
+    unsigned char m_flags = 0;
+    unsigned char m_level = 0;
+  };
+
   bool passesAllQueries(int sourceRow) const;
+  void updateRowStates(int first, int last);
+  AlertRecord createRecord(int sourceRow) const;
+  void composeFilters() const;
 
   AlertListModel* m_sourceModel;
   QList<AlertFilter*> m_filters;
-  mutable QHash<int, bool> m_rowsInModel;
+  QList<QMetaObject::Connection> m_filterConnections;
+  mutable QVector<signed char> m_rowStates;
+  QVector<AlertRecord> m_records;
+  mutable AlertFilterSpec m_filterSpec;
+  mutable QList<AlertFilter*> m_uncomposedFilters;
+  mutable bool m_filterSpecDirty = true;
 };
 
 } // Dsa
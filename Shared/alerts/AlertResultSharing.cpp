@@ -0,0 +1,728 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "AlertResultSharing.h"
+
+// dsa app headers
+#include "AlertCondition.h"
+
+// Qt headers
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkDatagram>
+#include <QRandomGenerator>
+#include <QTimer>
+#include <QUdpSocket>
+#include <QtEndian>
+
+// STL headers
+#include <algorithm>
+#include <cstring>
+
+namespace Dsa {
+
+namespace {
+
+// "DSAN" heartbeat or "DSAR" results, version, node ID
+constexpr char s_heartbeatMagic[] = {'D', 'S', 'A', 'N'};
+constexpr char s_resultsMagic[] = {'D', 'S', 'A', 'R'};
+constexpr quint8 s_version = 1;
+constexpr int s_headerSize = 4 + 1 + 8;
+
+// key, flags and count
+constexpr int s_resultsHeaderSize = s_headerSize + 8 + 1 + 2;
+
+constexpr quint8 s_fullStateFlag = 0x01;
+
+// peers which miss three heartbeats no longer own any condition, in ms
+constexpr int s_heartbeatInterval = 2000;
+constexpr int s_peerTimeout = 3 * s_heartbeatInterval + 500;
+
+// a new owner sends its results once its first evaluation has had time to run, in ms
+constexpr int s_fullStateDelay = 1000;
+
+// results evaluated within this long of each other share a datagram, in ms
+constexpr int s_flushInterval = 100;
+
+// keep the datagrams within a typical MTU
+constexpr int s_maxDatagramSize = 1200;
+constexpr int s_maxSourceIdSize = 255;
+constexpr int s_sendRetries = 1;
+
+quint64 createNodeId()
+{
+  quint64 nodeId = 0;
+  while (nodeId == 0)
+    nodeId = QRandomGenerator::global()->generate64();
+
+  return nodeId;
+}
+
+QByteArray createHeader(const char* magic, quint64 nodeId)
+{
+  QByteArray header(s_headerSize, Qt::Uninitialized);
+  char* data = header.data();
+  memcpy(data, magic, 4);
+  data[4] = static_cast<char>(s_version);
+  qToBigEndian<quint64>(nodeId, data + 5);
+  return header;
+}
+
+} // namespace
+
+/*!
+  \class Dsa::AlertResultSharing
+  \inmodule Dsa
+  \inherits QObject
+  \brief Shares the results of alert conditions between the nodes on the net, so that
+  each shared condition is evaluated by one node only.
+
+  Every node holds the same message feeds, so a condition such as "any hostile within
+  2 km of any friendly feed" gives the same results wherever it is evaluated. Conditions
+  which are \l {AlertCondition::isShareable}{shareable} are identified across the nodes
+  by a \l conditionKey computed from their type, source, query, target and hysteresis,
+  so conditions configured the same way on different nodes share a key whatever their
+  name and level.
+
+  Every two seconds each node sends a heartbeat listing the keys of its enabled
+  shareable conditions. For each key, the owner is elected from this node and the peers
+  heard recently which list it, by rendezvous hashing of the node IDs with the key. All
+  of the nodes elect the same owner without any further messages, and the conditions
+  are spread across the nodes. A node which misses three heartbeats is dropped, and its
+  conditions are evaluated by the next node in the ranking.
+
+  The owner evaluates the condition and sends each change of a source's result as a
+  delta: the condition key, the message ID of the source and whether it is active, with
+  the deltas of each condition batched over a tenth of a second. The target of a
+  condition is part of its key. Every other node stops evaluating the condition and
+  applies the deltas of the owner instead, so its alerts are raised as if it had
+  evaluated them. A node which becomes the owner, or hears a peer newly sharing a key it
+  owns, sends the full list of active sources.
+
+  A heartbeat is a datagram of the magic bytes \c DSAN, a version byte, the random 64 bit
+  ID of the node, a 16 bit count and the 64 bit keys. Results start with \c DSAR, the
+  version, the node ID and the condition key, followed by a flags byte (\c 1 for a full
+  state), a 16 bit count and, for each source, an active byte, a length byte and the
+  UTF-8 message ID. All values are big endian.
+ */
+
+/*!
+  \brief Constructor taking an optional \a parent.
+ */
+AlertResultSharing::AlertResultSharing(QObject* parent) :
+  QObject(parent),
+  m_nodeId(createNodeId()),
+  m_heartbeatTimer(new QTimer(this)),
+  m_flushTimer(new QTimer(this))
+{
+  m_clock.start();
+
+  m_heartbeatTimer->setInterval(s_heartbeatInterval);
+  connect(m_heartbeatTimer, &QTimer::timeout, this, [this]()
+  {
+    expirePeers();
+    sendHeartbeat();
+  });
+
+  m_flushTimer->setSingleShot(true);
+  m_flushTimer->setInterval(s_flushInterval);
+  connect(m_flushTimer, &QTimer::timeout, this, &AlertResultSharing::flushResults);
+}
+
+/*!
+  \brief Destructor.
+ */
+AlertResultSharing::~AlertResultSharing()
+{
+}
+
+/*!
+  \brief Starts sharing results on \a port with \a transport.
+
+  Returns \c false if the port could not be bound.
+ */
+bool AlertResultSharing::start(const UdpTransport& transport, quint16 port)
+{
+  if (m_socket || port == 0)
+    return false;
+
+  m_transport = transport;
+  m_port = port;
+  m_socket = m_transport.createListener(m_port, this);
+  if (m_socket->state() != QAbstractSocket::BoundState)
+  {
+    delete m_socket;
+    m_socket = nullptr;
+    return false;
+  }
+
+  connect(m_socket, &QUdpSocket::readyRead, this, &AlertResultSharing::readDatagrams);
+
+  electOwners();
+  sendHeartbeat();
+  m_heartbeatTimer->start();
+  return true;
+}
+
+/*!
+  \brief Returns the port results are shared on, or \c 0 if not started.
+ */
+quint16 AlertResultSharing::port() const
+{
+  return m_socket ? m_port : 0;
+}
+
+/*!
+  \brief Shares the results of \a condition with the peers, if it is shareable.
+
+  The condition is evaluated here until a peer is elected to own it.
+ */
+void AlertResultSharing::addCondition(AlertCondition* condition)
+{
+  if (!condition || findCondition(condition))
+    return;
+
+  SharedCondition sharedCondition;
+  sharedCondition.m_condition = condition;
+  sharedCondition.m_key = conditionKey(condition);
+  m_conditions.append(sharedCondition);
+
+  connect(condition, &AlertCondition::sourceResultChanged, this, [this, condition](const QString& sourceId, bool active)
+  {
+    queueResult(condition, sourceId, active);
+  });
+
+  // the hysteresis is part of the key, and is set once the condition has been added
+  connect(condition, &AlertCondition::conditionChanged, this, [this, condition]()
+  {
+    updateKey(condition);
+  });
+
+  connect(condition, &AlertCondition::conditionEnabledChanged, this, [this]()
+  {
+    electOwners();
+    sendHeartbeat();
+  });
+
+  connect(condition, &QObject::destroyed, this, [this, condition]()
+  {
+    removeCondition(condition);
+  });
+
+  electOwners();
+  sendHeartbeat();
+}
+
+/*!
+  \brief Stops sharing the results of \a condition.
+ */
+void AlertResultSharing::removeCondition(AlertCondition* condition)
+{
+  const int countBefore = m_conditions.size();
+
+  // a condition being destroyed has already cleared its pointer
+  auto it = m_conditions.begin();
+  while (it != m_conditions.end())
+  {
+    if (it->m_condition.isNull() || it->m_condition == condition)
+      it = m_conditions.erase(it);
+    else
+      ++it;
+  }
+
+  if (m_conditions.size() != countBefore)
+    sendHeartbeat();
+}
+
+/*!
+  \brief Returns the random ID of this node, which is chosen for each run of the app.
+ */
+quint64 AlertResultSharing::nodeId() const
+{
+  return m_nodeId;
+}
+
+/*!
+  \brief Returns the number of peers heard recently.
+ */
+int AlertResultSharing::peerCount() const
+{
+  return m_peers.size();
+}
+
+/*!
+  \brief Returns whether \a condition is evaluated by this node. This is the case for
+  conditions which are not shared.
+ */
+bool AlertResultSharing::isOwner(AlertCondition* condition) const
+{
+  const SharedCondition* sharedCondition = findCondition(condition);
+  return !sharedCondition || sharedCondition->m_owner == 0 || sharedCondition->m_owner == m_nodeId;
+}
+
+/*!
+  \brief Returns the key identifying \a condition across the nodes.
+
+  The key is taken from a hash of the parts of the condition which decide its results,
+  so it does not change with the name or level of the condition.
+ */
+quint64 AlertResultSharing::conditionKey(const AlertCondition* condition)
+{
+  if (!condition)
+    return 0;
+
+  const AlertConditionData::Hysteresis hysteresis = condition->hysteresis();
+
+  QJsonObject definition;
+  definition.insert(QStringLiteral("type"), condition->metaObject()->className());
+  definition.insert(QStringLiteral("source"), condition->sourceDescription());
+  definition.insert(QStringLiteral("query"), QJsonObject::fromVariantMap(condition->queryComponents()));
+  definition.insert(QStringLiteral("target"), condition->targetDescription());
+  definition.insert(QStringLiteral("entry"), hysteresis.m_entryMeters);
+  definition.insert(QStringLiteral("exit"), hysteresis.m_exitMeters);
+  definition.insert(QStringLiteral("dwell"), hysteresis.m_minimumDwellMsecs);
+
+  const QByteArray hash = QCryptographicHash::hash(QJsonDocument(definition).toJson(QJsonDocument::Compact),
+                                                   QCryptographicHash::Sha1);
+  const quint64 key = qFromBigEndian<quint64>(hash.constData());
+
+  // 0 marks a condition which is not shared
+  return key != 0 ? key : 1;
+}
+
+/*!
+  \internal
+ */
+void AlertResultSharing::readDatagrams()
+{
+  while (m_socket->hasPendingDatagrams())
+  {
+    const QByteArray datagram = m_socket->receiveDatagram().data();
+    if (datagram.size() < s_headerSize || static_cast<quint8>(datagram.at(4)) != s_version)
+      continue;
+
+    const bool isHeartbeat = memcmp(datagram.constData(), s_heartbeatMagic, sizeof(s_heartbeatMagic)) == 0;
+    const bool isResults = memcmp(datagram.constData(), s_resultsMagic, sizeof(s_resultsMagic)) == 0;
+    if (!isHeartbeat && !isResults)
+      continue;
+
+    // broadcasts are heard by the node which sent them
+    const quint64 nodeId = qFromBigEndian<quint64>(datagram.constData() + 5);
+    if (nodeId == m_nodeId)
+      continue;
+
+    QDataStream stream(datagram);
+    stream.skipRawData(s_headerSize);
+
+    if (isHeartbeat)
+      handleHeartbeat(stream, nodeId);
+    else
+      handleResults(stream, nodeId);
+  }
+}
+
+/*!
+  \internal
+  \brief Records the keys listed in the heartbeat \a stream of the peer \a nodeId.
+
+  The owners are elected again if they changed, and the full state of any condition
+  this node owns is sent if the peer has just started sharing it.
+ */
+void AlertResultSharing::handleHeartbeat(QDataStream& stream, quint64 nodeId)
+{
+  quint16 count = 0;
+  stream >> count;
+
+  QSet<quint64> keys;
+  keys.reserve(count);
+  for (int i = 0; i < count; ++i)
+  {
+    quint64 key = 0;
+    stream >> key;
+    keys.insert(key);
+  }
+
+  if (stream.status() != QDataStream::Ok)
+    return;
+
+  Peer& peer = m_peers[nodeId];
+  peer.m_lastHeard = m_clock.elapsed();
+  if (peer.m_keys == keys)
+    return;
+
+  const QSet<quint64> newKeys = keys - peer.m_keys;
+  peer.m_keys = keys;
+
+  electOwners();
+
+  for (const SharedCondition& sharedCondition : qAsConst(m_conditions))
+  {
+    if (sharedCondition.m_owner == m_nodeId && newKeys.contains(sharedCondition.m_key))
+      sendFullState(sharedCondition.m_key);
+  }
+}
+
+/*!
+  \internal
+  \brief Applies the results in \a stream to the conditions owned by the peer \a nodeId.
+
+  Results from a node which is not the owner elected here are ignored.
+ */
+void AlertResultSharing::handleResults(QDataStream& stream, quint64 nodeId)
+{
+  quint64 key = 0;
+  quint8 flags = 0;
+  quint16 count = 0;
+  stream >> key >> flags >> count;
+
+  QHash<QString, bool> results;
+  results.reserve(count);
+  for (int i = 0; i < count; ++i)
+  {
+    quint8 active = 0;
+    quint8 length = 0;
+    stream >> active >> length;
+
+    QByteArray sourceId(length, Qt::Uninitialized);
+    if (stream.readRawData(sourceId.data(), length) != length)
+      return;
+
+    results.insert(QString::fromUtf8(sourceId), active != 0);
+  }
+
+  if (stream.status() != QDataStream::Ok)
+    return;
+
+  auto peerIt = m_peers.find(nodeId);
+  if (peerIt != m_peers.end())
+    peerIt.value().m_lastHeard = m_clock.elapsed();
+
+  const bool fullState = (flags & s_fullStateFlag) != 0;
+  for (const SharedCondition& sharedCondition : qAsConst(m_conditions))
+  {
+    if (sharedCondition.m_condition && sharedCondition.m_key == key && sharedCondition.m_owner == nodeId)
+      sharedCondition.m_condition->applyRemoteResults(results, fullState);
+  }
+}
+
+/*!
+  \internal
+  \brief Sends the keys of the conditions this node can evaluate.
+ */
+void AlertResultSharing::sendHeartbeat()
+{
+  if (!m_socket)
+    return;
+
+  const QSet<quint64> keys = candidateKeys();
+
+  QByteArray heartbeat = createHeader(s_heartbeatMagic, m_nodeId);
+  QDataStream stream(&heartbeat, QIODevice::Append);
+  stream << static_cast<quint16>(keys.size());
+  for (const quint64 key : keys)
+    stream << key;
+
+  sendData(heartbeat, OutboundTransport::Priority::Routine);
+}
+
+/*!
+  \internal
+  \brief Drops the peers which have not been heard for three heartbeats.
+ */
+void AlertResultSharing::expirePeers()
+{
+  const qint64 now = m_clock.elapsed();
+  bool expired = false;
+
+  auto it = m_peers.begin();
+  while (it != m_peers.end())
+  {
+    if (now - it.value().m_lastHeard > s_peerTimeout)
+    {
+      it = m_peers.erase(it);
+      expired = true;
+    }
+    else
+    {
+      ++it;
+    }
+  }
+
+  if (expired)
+    electOwners();
+}
+
+/*!
+  \internal
+  \brief Elects the owner of each shared condition, from this node and the peers
+  which share its key.
+
+  Conditions owned by a peer take their results from it, the others are evaluated here.
+ */
+void AlertResultSharing::electOwners()
+{
+  if (!m_socket)
+    return;
+
+  bool changed = false;
+  for (SharedCondition& sharedCondition : m_conditions)
+  {
+    if (!sharedCondition.m_condition)
+      continue;
+
+    quint64 owner = 0;
+    if (isCandidate(sharedCondition))
+    {
+      owner = m_nodeId;
+      quint64 bestScore = ownerScore(m_nodeId, sharedCondition.m_key);
+      for (auto it = m_peers.constBegin(); it != m_peers.constEnd(); ++it)
+      {
+        if (!it.value().m_keys.contains(sharedCondition.m_key))
+          continue;
+
+        const quint64 score = ownerScore(it.key(), sharedCondition.m_key);
+        if (score > bestScore)
+        {
+          bestScore = score;
+          owner = it.key();
+        }
+      }
+    }
+
+    if (owner == sharedCondition.m_owner)
+      continue;
+
+    sharedCondition.m_owner = owner;
+    changed = true;
+
+    const bool remote = owner != 0 && owner != m_nodeId;
+    sharedCondition.m_condition->setEvaluatedRemotely(remote);
+
+    if (owner == m_nodeId)
+    {
+      const quint64 key = sharedCondition.m_key;
+      QTimer::singleShot(s_fullStateDelay, this, [this, key]()
+      {
+        sendFullState(key);
+      });
+    }
+  }
+
+  if (changed)
+    emit ownersChanged();
+}
+
+/*!
+  \internal
+  \brief Updates the key of \a condition, which changes with its definition.
+ */
+void AlertResultSharing::updateKey(AlertCondition* condition)
+{
+  const quint64 key = conditionKey(condition);
+  for (SharedCondition& sharedCondition : m_conditions)
+  {
+    if (sharedCondition.m_condition != condition || sharedCondition.m_key == key)
+      continue;
+
+    m_pendingResults.remove(sharedCondition.m_key);
+    sharedCondition.m_key = key;
+
+    electOwners();
+    sendHeartbeat();
+    return;
+  }
+}
+
+/*!
+  \internal
+  \brief Queues the \a active result of the source \a sourceId of \a condition, if this
+  node owns the condition and a peer shares it.
+ */
+void AlertResultSharing::queueResult(AlertCondition* condition, const QString& sourceId, bool active)
+{
+  const SharedCondition* sharedCondition = findCondition(condition);
+  if (!m_socket || !sharedCondition || sharedCondition->m_owner != m_nodeId)
+    return;
+
+  const quint64 key = sharedCondition->m_key;
+  const bool isShared = std::any_of(m_peers.cbegin(), m_peers.cend(), [key](const Peer& peer)
+  {
+    return peer.m_keys.contains(key);
+  });
+
+  if (!isShared)
+    return;
+
+  m_pendingResults[key].insert(sourceId, active);
+  if (!m_flushTimer->isActive())
+    m_flushTimer->start();
+}
+
+/*!
+  \internal
+  \brief Sends the queued results.
+ */
+void AlertResultSharing::flushResults()
+{
+  QHash<quint64, QHash<QString, bool>> pendingResults;
+  pendingResults.swap(m_pendingResults);
+
+  for (auto it = pendingResults.constBegin(); it != pendingResults.constEnd(); ++it)
+    sendResults(it.key(), it.value(), false);
+}
+
+/*!
+  \internal
+  \brief Sends every active source of the condition with \a key, if this node owns it.
+ */
+void AlertResultSharing::sendFullState(quint64 key)
+{
+  for (const SharedCondition& sharedCondition : qAsConst(m_conditions))
+  {
+    if (!sharedCondition.m_condition || sharedCondition.m_key != key || sharedCondition.m_owner != m_nodeId)
+      continue;
+
+    QHash<QString, bool> results;
+    const QStringList sourceIds = sharedCondition.m_condition->activeSourceIds();
+    for (const QString& sourceId : sourceIds)
+      results.insert(sourceId, true);
+
+    // the full state replaces any deltas which are still queued
+    m_pendingResults.remove(key);
+    sendResults(key, results, true);
+    return;
+  }
+}
+
+/*!
+  \internal
+  \brief Sends the \a results of the condition with \a key in as many datagrams as they need.
+
+  Only the first datagram of a \a fullState is flagged as such, so that the others add to it.
+ */
+void AlertResultSharing::sendResults(quint64 key, const QHash<QString, bool>& results, bool fullState)
+{
+  if (!m_socket)
+    return;
+
+  auto it = results.constBegin();
+  bool first = true;
+  while (first || it != results.constEnd())
+  {
+    QByteArray entries;
+    quint16 count = 0;
+    for (; it != results.constEnd(); ++it)
+    {
+      const QByteArray sourceId = it.key().toUtf8().left(s_maxSourceIdSize);
+      if (count > 0 && s_resultsHeaderSize + entries.size() + 2 + sourceId.size() > s_maxDatagramSize)
+        break;
+
+      entries.append(static_cast<char>(it.value() ? 1 : 0));
+      entries.append(static_cast<char>(sourceId.size()));
+      entries.append(sourceId);
+      ++count;
+    }
+
+    QByteArray datagram = createHeader(s_resultsMagic, m_nodeId);
+    QDataStream stream(&datagram, QIODevice::Append);
+    stream << key << static_cast<quint8>(first && fullState ? s_fullStateFlag : 0) << count;
+    stream.writeRawData(entries.constData(), entries.size());
+
+    sendData(datagram, OutboundTransport::Priority::Report);
+    first = false;
+  }
+}
+
+/*!
+  \internal
+  \brief Queues \a data on the shared outbound transport with \a priority.
+ */
+void AlertResultSharing::sendData(const QByteArray& data, OutboundTransport::Priority priority)
+{
+  OutboundTransport::SendOptions options;
+  options.m_priority = priority;
+  options.m_retries = s_sendRetries;
+  OutboundTransport::instance()->send(m_transport, m_port, data, options);
+}
+
+/*!
+  \internal
+  \brief Returns the keys of the conditions which this node can evaluate.
+ */
+QSet<quint64> AlertResultSharing::candidateKeys() const
+{
+  QSet<quint64> keys;
+  for (const SharedCondition& sharedCondition : m_conditions)
+  {
+    if (isCandidate(sharedCondition))
+      keys.insert(sharedCondition.m_key);
+  }
+
+  return keys;
+}
+
+/*!
+  \internal
+ */
+const AlertResultSharing::SharedCondition* AlertResultSharing::findCondition(AlertCondition* condition) const
+{
+  for (const SharedCondition& sharedCondition : m_conditions)
+  {
+    if (sharedCondition.m_condition == condition)
+      return &sharedCondition;
+  }
+
+  return nullptr;
+}
+
+/*!
+  \internal
+  \brief Returns whether the condition of \a sharedCondition can be evaluated by this
+  node on behalf of its peers.
+ */
+bool AlertResultSharing::isCandidate(const SharedCondition& sharedCondition)
+{
+  AlertCondition* condition = sharedCondition.m_condition;
+  return condition && sharedCondition.m_key != 0 && condition->isShareable() && condition->isConditionEnabled();
+}
+
+/*!
+  \internal
+  \brief Returns the rank of \a nodeId for owning the condition with \a key. The node
+  with the highest rank owns the condition.
+ */
+quint64 AlertResultSharing::ownerScore(quint64 nodeId, quint64 key)
+{
+  // splitmix64, so that each key ranks the nodes in a different order
+  quint64 score = nodeId ^ key;
+  score += 0x9e3779b97f4a7c15ULL;
+  score = (score ^ (score >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  score = (score ^ (score >> 27)) * 0x94d049bb133111ebULL;
+  return score ^ (score >> 31);
+}
+
+} // Dsa
+
+// Signal Documentation
+/*!
+  \fn void AlertResultSharing::ownersChanged();
+  \brief Signal emitted when the node elected to evaluate a shared condition changes.
+ */
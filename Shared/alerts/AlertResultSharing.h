@@ -0,0 +1,114 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef ALERTRESULTSHARING_H
+#define ALERTRESULTSHARING_H
+
+// dsa app headers
+#include "OutboundTransport.h"
+#include "UdpTransport.h"
+
+// Qt headers
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QSet>
+
+class QDataStream;
+class QTimer;
+class QUdpSocket;
+
+namespace Dsa {
+
+class AlertCondition;
+
+class AlertResultSharing : public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit AlertResultSharing(QObject* parent = nullptr);
+  ~AlertResultSharing();
+
+  bool start(const UdpTransport& transport, quint16 port);
+  quint16 port() const;
+
+  void addCondition(AlertCondition* condition);
+  void removeCondition(AlertCondition* condition);
+
+  quint64 nodeId() const;
+  int peerCount() const;
+  bool isOwner(AlertCondition* condition) const;
+
+  static quint64 conditionKey(const AlertCondition* condition);
+
+signals:
+  void ownersChanged();
+
+private:
+  Q_DISABLE_COPY(AlertResultSharing)
+
+  struct SharedCondition
+  {
+    QPointer<AlertCondition> m_condition;
+    quint64 m_key = 0;
+    quint64 m_owner = 0;
+  };
+
+  struct Peer
+  {
+    qint64 m_lastHeard = 0;
+    QSet<quint64> m_keys;
+  };
+
+  void readDatagrams();
+  void handleHeartbeat(QDataStream& stream, quint64 nodeId);
+  void handleResults(QDataStream& stream, quint64 nodeId);
+  void sendHeartbeat();
+  void expirePeers();
+  void electOwners();
+  void updateKey(AlertCondition* condition);
+  void queueResult(AlertCondition* condition, const QString& sourceId, bool active);
+  void flushResults();
+  void sendFullState(quint64 key);
+  void sendResults(quint64 key, const QHash<QString, bool>& results, bool fullState);
+  void sendData(const QByteArray& data, OutboundTransport::Priority priority);
+  QSet<quint64> candidateKeys() const;
+  const SharedCondition* findCondition(AlertCondition* condition) const;
+
+  static bool isCandidate(const SharedCondition& sharedCondition);
+  static quint64 ownerScore(quint64 nodeId, quint64 key);
+
+  UdpTransport m_transport;
+  quint16 m_port = 0;
+  QUdpSocket* m_socket = nullptr;
+  quint64 m_nodeId = 0;
+  QTimer* m_heartbeatTimer = nullptr;
+  QTimer* m_flushTimer = nullptr;
+  QElapsedTimer m_clock;
+
+  QList<SharedCondition> m_conditions;
+  QHash<quint64, Peer> m_peers;
+
+  // results evaluated here, waiting to be sent in one datagram per condition
+  QHash<quint64, QHash<QString, bool>> m_pendingResults;
+};
+
+} // Dsa
+
+#endif // ALERTRESULTSHARING_H
@@ -0,0 +1,253 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "AlertStateBroadcast.h"
+
+// dsa app headers
+#include "AlertConditionData.h"
+#include "AlertConstants.h"
+#include "AlertLevel.h"
+#include "AlertListModel.h"
+#include "AppConstants.h"
+#include "OutboundTransport.h"
+
+// toolkit headers
+#include "ToolManager.h"
+
+// C++ API headers
+#include "Point.h"
+
+// Qt headers
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+namespace
+{
+
+// alerts which go active are resent, in case a datagram was lost
+constexpr int s_activeRepeats = 2;
+
+const QString s_alertStateKey = QStringLiteral("alertState");
+
+} // namespace
+
+/*!
+  \class Dsa::AlertStateBroadcast
+  \inmodule Dsa
+  \inherits AbstractTool
+  \brief Tool controller publishing changes to the state of alerts over UDP.
+
+  Every time an alert in the \l AlertListModel becomes active or inactive, a
+  JSON datagram is sent to the \c port of the \c AlertStateBroadcastConfig,
+  using the \c UdpTransport settings. Alerts which are no longer valid, for
+  example because their source expired, are published as inactive. The
+  datagram is of the form:
+
+  \code
+  {
+    "alertState": {
+      "id": "{8f4e...}",
+      "name": "Enemy near base",
+      "level": 4,
+      "active": true,
+      "x": -117.19,
+      "y": 34.05,
+      "wkid": 4326,
+      "time": "2021-03-01T12:00:00Z",
+      "sender": "gateway-1"
+    }
+  }
+  \endcode
+
+  This lets a node without a display, such as the \c Gateway app, evaluate the
+  alert conditions on behalf of the devices which receive the datagrams.
+  Nothing is sent unless a port is configured.
+
+  \sa OutboundTransport
+ */
+
+/*!
+  \brief Constructor taking an optional \a parent.
+ */
+AlertStateBroadcast::AlertStateBroadcast(QObject* parent):
+  AbstractTool(parent)
+{
+  AlertListModel* model = AlertListModel::instance();
+  connect(model, &AlertListModel::rowsInserted, this, [this](const QModelIndex&, int first, int last)
+  {
+    trackAlerts(first, last);
+  });
+
+  trackAlerts(0, model->rowCount() - 1);
+
+  ToolManager::instance().addTool(this);
+}
+
+/*!
+  \brief Destructor.
+ */
+AlertStateBroadcast::~AlertStateBroadcast()
+{
+}
+
+/*!
+  \brief Returns the name of this tool.
+ */
+QString AlertStateBroadcast::toolName() const
+{
+  return QStringLiteral("Alert State Broadcast");
+}
+
+/*!
+  \brief Sets the port, transport and user name of the broadcast from \a properties.
+ */
+void AlertStateBroadcast::setProperties(const QVariantMap& properties)
+{
+  auto userNameFindIt = properties.find(AppConstants::USERNAME_PROPERTYNAME);
+  if (userNameFindIt != properties.end())
+    m_userName = userNameFindIt.value().toString();
+
+  const auto config = properties.value(AlertConstants::ALERT_STATE_BROADCAST_CONFIG_PROPERTYNAME).toMap();
+  bool ok = false;
+  const int port = config.value(AlertConstants::ALERT_STATE_BROADCAST_CONFIG_PORT).toInt(&ok);
+  m_udpPort = ok ? port : -1;
+
+  m_transport = UdpTransport::fromProperties(properties);
+}
+
+/*!
+  \brief Returns the UDP port the alert states are sent to, or \c -1 if they are not sent.
+ */
+int AlertStateBroadcast::udpPort() const
+{
+  return m_udpPort;
+}
+
+/*!
+  \internal
+
+  Follows the alerts in rows \a firstRow to \a lastRow of the model. A row may be
+  an alert which was restored from the history, in which case it is already followed.
+ */
+void AlertStateBroadcast::trackAlerts(int firstRow, int lastRow)
+{
+  AlertListModel* model = AlertListModel::instance();
+  for (int row = firstRow; row <= lastRow; ++row)
+  {
+    AlertConditionData* alert = model->alertAt(row);
+    if (!alert)
+      continue;
+
+    const bool active = alert->isConditionEnabled() && alert->isActive();
+    if (!m_publishedStates.contains(alert))
+    {
+      m_publishedStates.insert(alert, false);
+
+      connect(alert, &AlertConditionData::activeChanged, this, [this, alert]()
+      {
+        publishState(alert, alert->isConditionEnabled() && alert->isActive());
+      });
+
+      connect(alert, &AlertConditionData::noLongerValid, this, [this, alert]()
+      {
+        publishState(alert, false);
+      });
+
+      connect(alert, &QObject::destroyed, this, [this, alert]()
+      {
+        m_publishedStates.remove(alert);
+      });
+    }
+
+    publishState(alert, active);
+  }
+}
+
+/*!
+  \internal
+
+  Sends the \a active state of \a alert if it differs from the one last sent.
+ */
+void AlertStateBroadcast::publishState(AlertConditionData* alert, bool active)
+{
+  auto findIt = m_publishedStates.find(alert);
+  if (findIt == m_publishedStates.end() || findIt.value() == active)
+    return;
+
+  findIt.value() = active;
+
+  if (m_udpPort < 0)
+    return;
+
+  const QByteArray data = encodeState(alert, active, m_userName);
+
+  OutboundTransport::SendOptions options;
+  options.m_coalesceKey = alert->id().toString();
+  if (active)
+  {
+    options.m_priority = alert->level() >= AlertLevel::High ? OutboundTransport::Priority::Report
+                                                            : OutboundTransport::Priority::Routine;
+    options.m_repeats = s_activeRepeats;
+  }
+
+  OutboundTransport::instance()->send(m_transport, static_cast<quint16>(m_udpPort), data, options);
+  emit alertStateSent(data);
+}
+
+/*!
+  \internal
+
+  Returns the datagram for \a alert changing to the \a active state, sent by \a userName.
+ */
+QByteArray AlertStateBroadcast::encodeState(AlertConditionData* alert, bool active, const QString& userName)
+{
+  QJsonObject state;
+  state.insert(QStringLiteral("id"), alert->id().toString());
+  state.insert(QStringLiteral("name"), alert->name());
+  state.insert(QStringLiteral("level"), static_cast<int>(alert->level()));
+  state.insert(QStringLiteral("active"), active);
+
+  const Point location = alert->sourceLocation();
+  if (!location.isEmpty())
+  {
+    state.insert(QStringLiteral("x"), location.x());
+    state.insert(QStringLiteral("y"), location.y());
+    state.insert(QStringLiteral("wkid"), location.spatialReference().wkid());
+  }
+
+  state.insert(QStringLiteral("time"), QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+  state.insert(QStringLiteral("sender"), userName);
+
+  QJsonObject message;
+  message.insert(s_alertStateKey, state);
+  return QJsonDocument(message).toJson(QJsonDocument::Compact);
+}
+
+} // Dsa
+
+// Signal Documentation
+/*!
+  \fn void AlertStateBroadcast::alertStateSent(const QByteArray& data);
+  \brief Signal emitted when the alert state datagram \a data has been queued to send.
+ */
@@ -0,0 +1,66 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef ALERTSTATEBROADCAST_H
+#define ALERTSTATEBROADCAST_H
+
+// dsa app headers
+#include "UdpTransport.h"
+
+// toolkit headers
+#include "AbstractTool.h"
+
+// Qt headers
+#include <QHash>
+
+namespace Dsa {
+
+class AlertConditionData;
+
+class AlertStateBroadcast : public AbstractTool
+{
+  Q_OBJECT
+
+public:
+  explicit AlertStateBroadcast(QObject* parent = nullptr);
+  ~AlertStateBroadcast();
+
+  QString toolName() const override;
+  void setProperties(const QVariantMap& properties) override;
+
+  int udpPort() const;
+
+signals:
+  void alertStateSent(const QByteArray& data);
+
+private:
+  Q_DISABLE_COPY(AlertStateBroadcast)
+
+  void trackAlerts(int firstRow, int lastRow);
+  void publishState(AlertConditionData* alert, bool active);
+
+  static QByteArray encodeState(AlertConditionData* alert, bool active, const QString& userName);
+
+  QString m_userName;
+  int m_udpPort = -1;
+  UdpTransport m_transport;
+  // the state last published for each alert, so that only changes are sent
+  QHash<AlertConditionData*, bool> m_publishedStates;
+};
+
+} // Dsa
+
+#endif // ALERTSTATEBROADCAST_H
@@ -47,6 +47,31 @@ AlertTarget::~AlertTarget()
   emit noLongerValid();
 }
 
+/*!
+  \brief Returns the spatial index of the target's geometry, or \c nullptr if there is none.
+
+  Conditions can use the exact queries of the index in preference to testing each of
+  the \l targetGeometries themselves. The default implementation returns \c nullptr.
+ */
+GeometryQuadtree* AlertTarget::spatialIndex() const
+{
+  return nullptr;
+}
+
+/*!
+  \brief Returns whether the geometries in \a targetArea are still being retrieved, so that
+  \l targetGeometries may not yet return all of them.
+
+  The \l dataChanged signal is emitted once they arrive. Conditions keep their current state
+  rather than testing an incomplete set of geometries. The default implementation returns \c false.
+ */
+bool AlertTarget::isLoading(const Esri::ArcGISRuntime::Envelope& targetArea) const
+{
+  Q_UNUSED(targetArea)
+
+  return false;
+}
+
 } // Dsa
 
 // Signal Documentation
@@ -32,6 +32,8 @@ namespace ArcGISRuntime
 
 namespace Dsa {
 
+class GeometryQuadtree;
+
 class AlertTarget : public QObject
 {
   Q_OBJECT
@@ -42,6 +44,8 @@ public:
 
   virtual QList<Esri::ArcGISRuntime::Geometry> targetGeometries(const Esri::ArcGISRuntime::Envelope& targetArea) const = 0;
   virtual QVariant targetValue() const = 0;
+  virtual GeometryQuadtree* spatialIndex() const;
+  virtual bool isLoading(const Esri::ArcGISRuntime::Envelope& targetArea) const;
 
 signals:
   void noLongerValid();
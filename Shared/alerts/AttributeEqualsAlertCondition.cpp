@@ -21,7 +21,15 @@
 
 // dsa app headers
 #include "AlertConstants.h"
+#include "AlertTarget.h"
 #include "AttributeEqualsAlertConditionData.h"
+#include "GraphicAlertSource.h"
+#include "GraphicAttributeIndex.h"
+#include "MessagesOverlay.h"
+
+// C++ API headers
+#include "AttributeListModel.h"
+#include "Graphic.h"
 
 using namespace Esri::ArcGISRuntime;
 
@@ -35,6 +43,10 @@ namespace Dsa {
   trigger an alert when a source object's attribute matches the target value.
 
   This condition will create new \l AttributeEqualsAlertConditionData to track source and target objects.
+
+  When the source objects are graphics from a \l MessagesOverlay, the condition watches its
+  attribute in the overlay's \l GraphicAttributeIndex. Condition data are then only
+  re-evaluated when the attribute of their graphic changes.
   */
 
 /*!
@@ -56,7 +68,11 @@ AttributeEqualsAlertCondition::AttributeEqualsAlertCondition(AlertLevel level,
  */
 AttributeEqualsAlertCondition::~AttributeEqualsAlertCondition()
 {
-
+  for (const QPointer<GraphicAttributeIndex>& attributeIndex : m_attributeIndexes)
+  {
+    if (attributeIndex)
+      attributeIndex->unwatchAttribute(m_attributeName);
+  }
 }
 
 /*!
@@ -64,7 +80,102 @@ AttributeEqualsAlertCondition::~AttributeEqualsAlertCondition()
  */
 AlertConditionData* AttributeEqualsAlertCondition::createData(AlertSource* source, AlertTarget* target)
 {
-  return new AttributeEqualsAlertConditionData(newConditionDataName(), level(), source, target, m_attributeName, this);
+  AttributeEqualsAlertConditionData* newData = new AttributeEqualsAlertConditionData(newConditionDataName(), level(), source, target, m_attributeName, this);
+
+  // graphics from a message feed can be tracked by the feed's attribute index
+  GraphicAlertSource* graphicSource = qobject_cast<GraphicAlertSource*>(source);
+  Graphic* graphic = graphicSource ? graphicSource->graphic() : nullptr;
+  GraphicAttributeIndex* attributeIndex = watchAttributeIndex(graphic);
+  if (!attributeIndex)
+    return newData;
+
+  newData->setAttributeIndex(attributeIndex, graphic);
+  m_indexedData.insert(graphic, newData);
+
+  connect(newData, &QObject::destroyed, this, [this, graphic, newData]()
+  {
+    if (m_indexedData.value(graphic) == newData)
+      m_indexedData.remove(graphic);
+  });
+
+  return newData;
+}
+
+/*!
+  \brief Returns \c true, as the attribute of every graphic in a source feed can be tested.
+ */
+bool AttributeEqualsAlertCondition::isAggregateSupported() const
+{
+  return true;
+}
+
+/*!
+  \brief Returns a function which tests whether the attribute of the source \a graphic
+  matches the value of \a target.
+
+  The test does not depend on \a location or on whether the graphic is \a active.
+ */
+AlertConditionData::QueryTask AttributeEqualsAlertCondition::createAggregateQueryTask(Graphic* graphic,
+                                                                                      const Point& location,
+                                                                                      AlertTarget* target,
+                                                                                      bool active) const
+{
+  Q_UNUSED(location)
+  Q_UNUSED(active)
+
+  if (!graphic || !graphic->attributes() || !target)
+    return AlertConditionData::QueryTask();
+
+  // the feed defers applying the attributes of graphics outside its area of interest,
+  // so the value is read from the feed's attribute index
+  GraphicAttributeIndex* attributeIndex = watchAttributeIndex(graphic);
+  const QVariant sourceValue = attributeIndex ? attributeIndex->value(graphic, m_attributeName)
+                                              : graphic->attributes()->attributeValue(m_attributeName);
+  const QVariant targetValue = target->targetValue();
+
+  return [sourceValue, targetValue]()
+  {
+    return AttributeEqualsAlertConditionData::isMatch(sourceValue, targetValue);
+  };
+}
+
+/*!
+  \internal
+
+  Returns the attribute index of the message feed which owns \a graphic, watching the
+  condition's attribute the first time the index is seen, or \c nullptr if \a graphic
+  is not from a message feed.
+ */
+GraphicAttributeIndex* AttributeEqualsAlertCondition::watchAttributeIndex(Graphic* graphic) const
+{
+  MessagesOverlay* messagesOverlay = MessagesOverlay::fromGraphic(graphic);
+  if (!messagesOverlay)
+    return nullptr;
+
+  GraphicAttributeIndex* attributeIndex = messagesOverlay->attributeIndex();
+  if (!m_attributeIndexes.contains(attributeIndex))
+  {
+    m_attributeIndexes.append(attributeIndex);
+    attributeIndex->watchAttribute(m_attributeName);
+    connect(attributeIndex, &GraphicAttributeIndex::attributeChanged, this, &AttributeEqualsAlertCondition::handleAttributeChanged);
+  }
+
+  return attributeIndex;
+}
+
+/*!
+  \internal
+
+  Re-evaluates the condition data for \a graphic when its \a attributeName has changed.
+ */
+void AttributeEqualsAlertCondition::handleAttributeChanged(Graphic* graphic, const QString& attributeName)
+{
+  if (attributeName != m_attributeName)
+    return;
+
+  AttributeEqualsAlertConditionData* conditionData = m_indexedData.value(graphic);
+  if (conditionData)
+    conditionData->handleAttributeChanged();
 }
 
 /*!
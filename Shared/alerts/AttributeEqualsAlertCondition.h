@@ -21,10 +21,22 @@
 #include "AlertCondition.h"
 
 // Qt headers
+#include <QHash>
+#include <QList>
 #include <QObject>
+#include <QPointer>
+
+namespace Esri {
+namespace ArcGISRuntime {
+class Graphic;
+}
+}
 
 namespace Dsa {
 
+class AttributeEqualsAlertConditionData;
+class GraphicAttributeIndex;
+
 class AttributeEqualsAlertCondition : public AlertCondition
 {
   Q_OBJECT
@@ -39,13 +51,25 @@ public:
 
   AlertConditionData* createData(AlertSource* source, AlertTarget* target) override;
 
+  bool isAggregateSupported() const override;
+  AlertConditionData::QueryTask createAggregateQueryTask(Esri::ArcGISRuntime::Graphic* graphic,
+                                                         const Esri::ArcGISRuntime::Point& location,
+                                                         AlertTarget* target,
+                                                         bool active) const override;
+
   QString queryString() const override;
   QVariantMap queryComponents() const override;
 
   static QString attributeNameFromQueryComponents(const QVariantMap& queryMap);
 
 private:
+  GraphicAttributeIndex* watchAttributeIndex(Esri::ArcGISRuntime::Graphic* graphic) const;
+  void handleAttributeChanged(Esri::ArcGISRuntime::Graphic* graphic, const QString& attributeName);
+
   QString m_attributeName;
+  // watched on first use, which may be from the const aggregate query
+  mutable QList<QPointer<GraphicAttributeIndex>> m_attributeIndexes;
+  QHash<Esri::ArcGISRuntime::Graphic*, AttributeEqualsAlertConditionData*> m_indexedData;
 };
 
 } // Dsa
@@ -22,6 +22,7 @@
 // dsa app headers
 #include "AlertSource.h"
 #include "AlertTarget.h"
+#include "GraphicAttributeIndex.h"
 
 using namespace Esri::ArcGISRuntime;
 
@@ -81,11 +82,23 @@ bool AttributeEqualsAlertConditionData::matchesQuery() const
   if (!isQueryOutOfDate())
     return cachedQueryResult();
 
-  const QVariant sourceValue = source()->value(attributeName());
+  // an indexed source value is a lookup rather than a search of the graphic's attributes
+  const QVariant sourceValue = m_attributeIndex ? m_attributeIndex->value(m_graphic, attributeName())
+                                                : source()->value(attributeName());
+
+  return isMatch(sourceValue, target()->targetValue());
+}
+
+/*!
+  \brief Returns whether \a sourceValue matches \a targetValue.
+
+  Null or invalid values never match.
+ */
+bool AttributeEqualsAlertConditionData::isMatch(const QVariant& sourceValue, const QVariant& targetValue)
+{
   if (sourceValue.isNull() || !sourceValue.isValid())
     return false;
 
-  const QVariant targetValue = target()->targetValue();
   if (targetValue.isNull() || !targetValue.isValid())
     return false;
 
@@ -100,4 +113,29 @@ QString AttributeEqualsAlertConditionData::attributeName() const
     return m_attributeName;
 }
 
+/*!
+  \brief Sets the \a attributeIndex which holds the attribute values of the source \a graphic.
+
+  Once set, the source value is read from the index and the query is only re-run when
+  the index reports that the attribute of \a graphic has changed (see
+  \l handleAttributeChanged), rather than on every change to the graphic's geometry or
+  attributes.
+ */
+void AttributeEqualsAlertConditionData::setAttributeIndex(GraphicAttributeIndex* attributeIndex, Graphic* graphic)
+{
+  m_attributeIndex = attributeIndex;
+  m_graphic = graphic;
+
+  if (m_attributeIndex && source())
+    disconnect(source(), &AlertSource::dataChanged, this, &AttributeEqualsAlertConditionData::handleDataChanged);
+}
+
+/*!
+  \brief Marks the query as out-of-date after the watched attribute of the source has changed.
+ */
+void AttributeEqualsAlertConditionData::handleAttributeChanged()
+{
+  handleDataChanged();
+}
+
 } // Dsa
@@ -20,6 +20,9 @@
 // dsa app headers
 #include "AlertConditionData.h"
 
+// Qt headers
+#include <QPointer>
+
 namespace Esri {
 namespace ArcGISRuntime {
 class GeoElement;
@@ -29,6 +32,8 @@ class Graphic;
 
 namespace Dsa {
 
+class GraphicAttributeIndex;
+
 class AttributeEqualsAlertConditionData : public AlertConditionData
 {
   Q_OBJECT
@@ -46,10 +51,17 @@ public:
 
   bool matchesQuery() const override;
 
+  static bool isMatch(const QVariant& sourceValue, const QVariant& targetValue);
+
   QString attributeName() const;
 
+  void setAttributeIndex(GraphicAttributeIndex* attributeIndex, Esri::ArcGISRuntime::Graphic* graphic);
+  void handleAttributeChanged();
+
 private:
   QString m_attributeName;
+  QPointer<GraphicAttributeIndex> m_attributeIndex;
+  Esri::ArcGISRuntime::Graphic* m_graphic = nullptr;
 };
 
 } // Dsa
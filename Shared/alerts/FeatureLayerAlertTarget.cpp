@@ -22,9 +22,17 @@
 // dsa app headers
 #include "FeatureQueryResultManager.h"
 #include "GeometryQuadtree.h"
+#include "MemoryBudget.h"
+#include "SpatialIndexRegistry.h"
 
 // C++ API headers
+#include "Feature.h"
 #include "FeatureLayer.h"
+#include "FeatureQueryResult.h"
+#include "GeometryEngine.h"
+
+// STL headers
+#include <cmath>
 
 using namespace Esri::ArcGISRuntime;
 
@@ -38,27 +46,61 @@ namespace Dsa {
   for an \l AlertCondition.
 
   Changes to any of the features in the layer will cause the \l AlertTarget::locationChanged
-  signal to be emitted.
+  signal to be emitted. The signal is emitted once the change has been applied to the
+  layer's spatial index, which is shared with other users via the \l SpatialIndexRegistry.
+
+  Layers with very many features are instead queried on demand (see \l isOnDemand).
+  Features are requested one tile of a WGS84 grid at a time, for the areas around
+  the alert sources being tested. Only the geometry of each feature is kept and the
+  least recently used tiles are discarded. Every loaded tile is discarded when the
+  \l MemoryBudget is short of memory. The \l AlertTarget::dataChanged signal is
+  emitted as each tile of results arrives. Until then \l isLoading is \c true for the
+  areas the tile covers, so conditions keep their state rather than being tested
+  against the partial results.
+
+  Edits made through the \l FeatureGeometryCache are applied one feature at a time,
+  to the shared spatial index or to the loaded tiles, so the table is not queried again.
   */
 
 /*!
   \brief Constructor taking an \l Esri::ArcGISRuntime::FeatureLayer (\a featureLayer).
 
-  All features will be retrieved from the underlying feature layer.
+  All features will be retrieved from the underlying feature layer, unless
+  there is already a spatial index for the layer or the layer has too many
+  features to hold in memory, in which case they are retrieved on demand.
  */
 FeatureLayerAlertTarget::FeatureLayerAlertTarget(FeatureLayer* featureLayer):
   AlertTarget(featureLayer),
   m_FeatureLayer(featureLayer)
 {
-  // assume no editing of feature table
+  // share an existing spatial index for the layer
+  if (SpatialIndexRegistry::instance()->spatialIndex(m_FeatureLayer))
+  {
+    setQuadtree(SpatialIndexRegistry::instance()->acquire(m_FeatureLayer, QList<Geometry>()));
+    return;
+  }
 
   FeatureTable* table = m_FeatureLayer->featureTable();
-  QueryParameters allFeaturesQuery;
-  allFeaturesQuery.setWhereClause("1=1");
-  allFeaturesQuery.setReturnGeometry(true);
 
-  connect(table, &FeatureTable::queryFeaturesCompleted, this, &FeatureLayerAlertTarget::handleQueryFeaturesCompleted);
-  table->queryFeatures(allFeaturesQuery);
+  // very large tables are queried a tile at a time, when required
+  if (table->numberOfFeatures() > s_onDemandFeatureThreshold)
+  {
+    m_onDemand = true;
+    connect(table, &FeatureTable::queryFeaturesCompleted, this, &FeatureLayerAlertTarget::handleQueryFeaturesCompleted);
+    connect(FeatureGeometryCache::instance(), &FeatureGeometryCache::featureEdited, this, &FeatureLayerAlertTarget::handleFeatureEdited);
+
+    // tiles are queried again when next needed
+    MemoryBudget::instance()->registerCache(this, QStringLiteral("Alert target tiles"), MemoryBudget::RequeryPriority,
+                                            [this]() { return tileFootprint(); },
+                                            [this]() { return releaseTiles(); });
+    return;
+  }
+
+  // the geometry of the table is shared with other tools which query all of its features
+  FeatureGeometryCache::instance()->requestGeometries(table, this, [this](const QList<Geometry>& geometries)
+  {
+    handleGeometriesReceived(geometries);
+  });
 }
 
 /*!
@@ -66,7 +108,8 @@ FeatureLayerAlertTarget::FeatureLayerAlertTarget(FeatureLayer* featureLayer):
  */
 FeatureLayerAlertTarget::~FeatureLayerAlertTarget()
 {
-
+  if (m_quadtree)
+    SpatialIndexRegistry::instance()->release(m_FeatureLayer);
 }
 
 /*!
@@ -80,23 +123,11 @@ QList<Geometry> FeatureLayerAlertTarget::targetGeometries(const Envelope& target
   if (m_quadtree)
     return m_quadtree->candidateIntersections(targetArea);
 
-  // if there is no quad-tree just return the cache of geoemtry
-  if (!m_geomCache.isEmpty())
-    return m_geomCache;
-
-  // if there is no cached geometry, get the geometry for all features
-  auto it = m_features.begin();
-  auto itEnd = m_features.end();
-  for (; it != itEnd; ++it)
-  {
-    Feature* feat = *it;
-    if (!feat)
-      continue;
+  if (m_onDemand)
+    return tileGeometries(targetArea);
 
-    m_geomCache.append(feat->geometry());
-  }
-
-  return m_geomCache;
+  // the features have not been retrieved yet
+  return QList<Geometry>();
 }
 
 /*!
@@ -108,63 +139,391 @@ QVariant FeatureLayerAlertTarget::targetValue() const
 }
 
 /*!
-  \brief internal.
+  \brief Returns the quadtree covering the target's geometry.
 
-  Handle the query to obtain all of the features in the layer.
+  The quadtree is shared with other users of the layer. This is \c nullptr until
+  the features of the layer have been retrieved, and always \c nullptr when the
+  features are retrieved on demand.
  */
-void FeatureLayerAlertTarget::handleQueryFeaturesCompleted(QUuid, FeatureQueryResult* queryResults)
+GeometryQuadtree* FeatureLayerAlertTarget::spatialIndex() const
 {
-  // Store the results in a RAII manager to ensure they are cleaned up
-  FeatureQueryResultManager results(queryResults);
-  if (!results.m_results)
+  return m_quadtree;
+}
+
+/*!
+  \brief Returns whether any of the tiles covering \a targetArea are still being queried,
+  or have not been requested yet.
+
+  This is always \c false unless features are retrieved on demand.
+ */
+bool FeatureLayerAlertTarget::isLoading(const Envelope& targetArea) const
+{
+  if (!m_onDemand || m_quadtree || !m_FeatureLayer)
+    return false;
+
+  const TileRange range = tileRange(targetArea);
+  for (int column = range.m_columnMin; column <= range.m_columnMax; ++column)
   {
-    emit dataChanged();
+    for (int row = range.m_rowMin; row <= range.m_rowMax; ++row)
+    {
+      auto tileIt = m_tiles.constFind(tileKey(range.m_level, column, row));
+      if (tileIt == m_tiles.constEnd() || !tileIt.value().m_loaded)
+        return true;
+    }
+  }
+
+  return false;
+}
+
+/*!
+  \brief Returns whether features are retrieved on demand, for the area around
+  each alert source, rather than all at once.
+
+  This is the case when the layer contains more than 50,000 features.
+ */
+bool FeatureLayerAlertTarget::isOnDemand() const
+{
+  return m_onDemand;
+}
+
+/*!
+  \brief internal.
+
+  Handle the query to obtain the features in a tile of the layer.
+ */
+void FeatureLayerAlertTarget::handleQueryFeaturesCompleted(QUuid taskId, FeatureQueryResult* queryResults)
+{
+  // other users of the feature table may also be querying it
+  auto tileIt = m_tileQueries.find(taskId);
+  if (tileIt == m_tileQueries.end())
+    return;
+
+  const TileKey key = tileIt.value();
+  m_tileQueries.erase(tileIt);
+  handleTileQueryCompleted(key, queryResults);
+}
+
+/*!
+  \brief internal.
+
+  Applies the edit of the feature \a featureId in \a featureTable to the loaded tiles.
+  The feature is removed from every tile holding it and, unless it has been deleted,
+  added to the tiles its new \a geometry intersects.
+ */
+void FeatureLayerAlertTarget::handleFeatureEdited(FeatureTable* featureTable, FeatureGeometryCache::EditType editType,
+                                                  qint64 featureId, const Geometry& geometry)
+{
+  if (!m_FeatureLayer || m_FeatureLayer->featureTable() != featureTable)
     return;
+
+  Geometry wgs84Geometry;
+  if (editType != FeatureGeometryCache::EditType::Deleted && !geometry.isEmpty())
+  {
+    wgs84Geometry = geometry.spatialReference() == SpatialReference::wgs84() ? geometry
+                                                                            : GeometryEngine::project(geometry, SpatialReference::wgs84());
   }
 
-  // cache all of the features
-  m_geomCache.clear();
-  m_features = results.m_results->iterator().features(this);
-  auto it = m_features.begin();
-  auto itEnd = m_features.end();
-  for (; it != itEnd; ++it)
+  const Envelope geometryExtent = wgs84Geometry.isEmpty() ? Envelope() : wgs84Geometry.extent();
+
+  bool changed = false;
+  for (Tile& tile : m_tiles)
   {
-    Feature* feature = *it;
-    if (!feature)
+    if (!tile.m_loaded)
       continue;
 
-    // for each feature, connect to the geometryChanged signal
-    connect(feature, &Feature::geometryChanged, this, [this]()
+    const int row = tile.m_featureIds.indexOf(featureId);
+    if (row >= 0)
     {
-      m_geomCache.clear();
-      rebuildQuadtree();
-      emit dataChanged();
-    });
+      tile.m_geometries.removeAt(row);
+      tile.m_extents.removeAt(row);
+      tile.m_featureIds.removeAt(row);
+      changed = true;
+    }
+
+    if (geometryExtent.isEmpty() ||
+        geometryExtent.xMin() > tile.m_extent.xMax() || geometryExtent.xMax() < tile.m_extent.xMin() ||
+        geometryExtent.yMin() > tile.m_extent.yMax() || geometryExtent.yMax() < tile.m_extent.yMin())
+      continue;
+
+    tile.m_geometries.append(wgs84Geometry);
+    tile.m_extents.append(geometryExtent);
+    tile.m_featureIds.append(featureId);
+    changed = true;
+  }
+
+  if (changed)
+    emit dataChanged();
+}
+
+/*!
+  \brief internal.
+
+  Handle the \a geometries of all of the features in the layer.
+ */
+void FeatureLayerAlertTarget::handleGeometriesReceived(const QList<Geometry>& geometries)
+{
+  // the query failed
+  if (geometries.isEmpty() && !FeatureGeometryCache::instance()->isCached(m_FeatureLayer->featureTable()))
+  {
+    emit dataChanged();
+    return;
   }
 
-  rebuildQuadtree();
+  // the registry keeps the shared index up to date with edits to the feature table
+  if (!m_quadtree)
+    setQuadtree(SpatialIndexRegistry::instance()->acquire(m_FeatureLayer, geometries));
+
   emit dataChanged();
 }
 
 /*!
   \brief internal.
 
-  Build the quadtree used to find intersections with feature geometry etc.
+  Use the shared \a quadtree to find intersections with feature geometry etc.
  */
-void FeatureLayerAlertTarget::rebuildQuadtree()
+void FeatureLayerAlertTarget::setQuadtree(GeometryQuadtree* quadtree)
 {
+  m_quadtree = quadtree;
   if (m_quadtree)
+    connect(m_quadtree, &GeometryQuadtree::treeChanged, this, &FeatureLayerAlertTarget::dataChanged);
+}
+
+/*!
+  \internal
+
+  Returns the tiles covering \a targetArea, from the finest grid level for which
+  \a targetArea covers no more than 4 tiles along each side. The range is empty
+  if \a targetArea is empty.
+ */
+FeatureLayerAlertTarget::TileRange FeatureLayerAlertTarget::tileRange(const Envelope& targetArea)
+{
+  TileRange range;
+  if (targetArea.isEmpty())
+    return range;
+
+  Envelope area = targetArea;
+  if (area.spatialReference() != SpatialReference::wgs84())
+    area = geometry_cast<Envelope>(GeometryEngine::project(area, SpatialReference::wgs84()));
+
+  if (area.isEmpty())
+    return range;
+
+  range.m_tileSize = s_tileSize;
+  while (range.m_level < s_maximumTileLevel &&
+         (area.width() > range.m_tileSize * (s_maximumTilesPerSide - 1) ||
+          area.height() > range.m_tileSize * (s_maximumTilesPerSide - 1)))
+  {
+    ++range.m_level;
+    range.m_tileSize *= 2.0;
+  }
+
+  range.m_columnMin = static_cast<int>(std::floor(area.xMin() / range.m_tileSize));
+  range.m_columnMax = static_cast<int>(std::floor(area.xMax() / range.m_tileSize));
+  range.m_rowMin = static_cast<int>(std::floor(area.yMin() / range.m_tileSize));
+  range.m_rowMax = static_cast<int>(std::floor(area.yMax() / range.m_tileSize));
+  return range;
+}
+
+/*!
+  \internal
+
+  Returns the WGS84 geometries from the loaded tiles whose extents intersect
+  \a targetArea, requesting any tiles which are not loaded yet.
+
+  \sa tileRange
+ */
+QList<Geometry> FeatureLayerAlertTarget::tileGeometries(const Envelope& targetArea) const
+{
+  if (!m_FeatureLayer || targetArea.isEmpty())
+    return QList<Geometry>();
+
+  Envelope area = targetArea;
+  if (area.spatialReference() != SpatialReference::wgs84())
+    area = geometry_cast<Envelope>(GeometryEngine::project(area, SpatialReference::wgs84()));
+
+  const TileRange range = tileRange(area);
+  const double tileSize = range.m_tileSize;
+
+  QList<Geometry> results;
+  for (int column = range.m_columnMin; column <= range.m_columnMax; ++column)
+  {
+    for (int row = range.m_rowMin; row <= range.m_rowMax; ++row)
+    {
+      const TileKey key = tileKey(range.m_level, column, row);
+      auto tileIt = m_tiles.constFind(key);
+      if (tileIt == m_tiles.constEnd())
+      {
+        requestTile(key, Envelope(column * tileSize, row * tileSize, (column + 1) * tileSize, (row + 1) * tileSize,
+                                  SpatialReference::wgs84()));
+        continue;
+      }
+
+      touchTile(key);
+
+      const Tile& tile = tileIt.value();
+      for (int i = 0; i < tile.m_geometries.size(); ++i)
+      {
+        const Envelope& extent = tile.m_extents.at(i);
+        if (extent.xMin() > area.xMax() || extent.xMax() < area.xMin() ||
+            extent.yMin() > area.yMax() || extent.yMax() < area.yMin())
+          continue;
+
+        results.append(tile.m_geometries.at(i));
+      }
+    }
+  }
+
+  return results;
+}
+
+/*!
+  \internal
+
+  Queries the features within \a tileExtent for the tile \a key, evicting the
+  least recently used tiles if there are too many.
+ */
+void FeatureLayerAlertTarget::requestTile(TileKey key, const Envelope& tileExtent) const
+{
+  FeatureTable* table = m_FeatureLayer->featureTable();
+  if (!table)
+    return;
+
+  Tile tile;
+  tile.m_extent = tileExtent;
+  m_tiles.insert(key, tile);
+  m_tileOrder.append(key);
+
+  while (m_tileOrder.size() > s_maximumTiles)
+    m_tiles.remove(m_tileOrder.takeFirst());
+
+  QueryParameters tileQuery;
+  tileQuery.setGeometry(tileExtent);
+  tileQuery.setSpatialRelationship(SpatialRelationship::Intersects);
+  tileQuery.setReturnGeometry(true);
+
+  m_tileQueries.insert(table->queryFeatures(tileQuery).taskId(), key);
+}
+
+/*!
+  \internal
+
+  Returns the estimated number of bytes held by the loaded tiles.
+ */
+qint64 FeatureLayerAlertTarget::tileFootprint() const
+{
+  qint64 bytes = 0;
+  for (const Tile& tile : m_tiles)
+  {
+    for (const Geometry& geometry : tile.m_geometries)
+      bytes += MemoryBudget::estimatedSize(geometry);
+
+    bytes += tile.m_extents.size() * MemoryBudget::estimatedSize(Envelope());
+  }
+
+  return bytes;
+}
+
+/*!
+  \internal
+
+  Discards the loaded tiles, returning the estimated number of bytes released.
+  Tiles which are still being queried are kept.
+ */
+qint64 FeatureLayerAlertTarget::releaseTiles()
+{
+  const qint64 bytes = tileFootprint();
+
+  for (auto it = m_tiles.begin(); it != m_tiles.end();)
+  {
+    if (!it.value().m_loaded)
+    {
+      ++it;
+      continue;
+    }
+
+    m_tileOrder.removeOne(it.key());
+    it = m_tiles.erase(it);
+  }
+
+  return bytes;
+}
+
+/*!
+  \internal
+
+  Marks the tile \a key as the most recently used.
+ */
+void FeatureLayerAlertTarget::touchTile(TileKey key) const
+{
+  if (!m_tileOrder.isEmpty() && m_tileOrder.last() == key)
+    return;
+
+  m_tileOrder.removeOne(key);
+  m_tileOrder.append(key);
+}
+
+/*!
+  \internal
+
+  Stores the WGS84 geometry and the ID of the features in \a queryResults for the
+  tile \a key. The features themselves are discarded.
+ */
+void FeatureLayerAlertTarget::handleTileQueryCompleted(TileKey key, FeatureQueryResult* queryResults)
+{
+  FeatureQueryResultManager results(queryResults);
+
+  // the tile may have been evicted while it was being queried
+  auto tileIt = m_tiles.find(key);
+  if (tileIt == m_tiles.end() || tileIt.value().m_loaded)
+    return;
+
+  Tile& tile = tileIt.value();
+  tile.m_loaded = true;
+
+  if (!results.m_results)
   {
-    delete m_quadtree;
-    m_quadtree = nullptr;
+    // allow the tile to be requested again
+    m_tiles.erase(tileIt);
+    m_tileOrder.removeOne(key);
+    return;
+  }
+
+  // the features are only required within the scope of this method
+  QObject localParent;
+  const QList<Feature*> features = results.m_results->iterator().features(&localParent);
+  tile.m_geometries.reserve(features.size());
+  tile.m_extents.reserve(features.size());
+  tile.m_featureIds.reserve(features.size());
+  for (Feature* feature : features)
+  {
+    if (!feature)
+      continue;
+
+    Geometry geometry = feature->geometry();
+    if (geometry.isEmpty())
+      continue;
+
+    if (geometry.spatialReference() != SpatialReference::wgs84())
+      geometry = GeometryEngine::project(geometry, SpatialReference::wgs84());
+
+    tile.m_geometries.append(geometry);
+    tile.m_extents.append(geometry.extent());
+    tile.m_featureIds.append(FeatureGeometryCache::featureId(m_FeatureLayer->featureTable(), feature));
   }
 
-  QList<GeoElement*> elements;
-  for (auto it = m_features.begin(); it != m_features.end(); ++it)
-    elements.append(*it);
+  emit dataChanged();
+}
+
+/*!
+  \internal
 
-  if (elements.size() > 1)
-    m_quadtree = new GeometryQuadtree(m_FeatureLayer->fullExtent(), elements, 8, this);
+  Returns a key for the tile at \a column and \a row of the grid \a level.
+ */
+FeatureLayerAlertTarget::TileKey FeatureLayerAlertTarget::tileKey(int level, int column, int row)
+{
+  return (static_cast<TileKey>(level) << 56) |
+         ((static_cast<TileKey>(column) & 0xFFFFFFF) << 28) |
+         (static_cast<TileKey>(row) & 0xFFFFFFF);
 }
 
 } // Dsa
@@ -19,14 +19,21 @@
 
 // dsa app headers
 #include "AlertTarget.h"
+#include "FeatureGeometryCache.h"
+
+// C++ API headers
+#include "Envelope.h"
+#include "FeatureLayer.h"
+#include "Geometry.h"
 
 // Qt headers
+#include <QHash>
+#include <QList>
+#include <QPointer>
 #include <QUuid>
 
 namespace Esri {
 namespace ArcGISRuntime {
-class Feature;
-class FeatureLayer;
 class FeatureQueryResult;
 }
 }
@@ -45,17 +52,62 @@ public:
 
   QList<Esri::ArcGISRuntime::Geometry> targetGeometries(const Esri::ArcGISRuntime::Envelope& targetArea) const override;
   QVariant targetValue() const override;
+  GeometryQuadtree* spatialIndex() const override;
+  bool isLoading(const Esri::ArcGISRuntime::Envelope& targetArea) const override;
+
+  bool isOnDemand() const;
 
 private slots:
   void handleQueryFeaturesCompleted(QUuid taskId, Esri::ArcGISRuntime::FeatureQueryResult* featureQueryResult);
+  void handleFeatureEdited(Esri::ArcGISRuntime::FeatureTable* featureTable, FeatureGeometryCache::EditType editType,
+                           qint64 featureId, const Esri::ArcGISRuntime::Geometry& geometry);
 
 private:
-  void rebuildQuadtree();
+  void handleGeometriesReceived(const QList<Esri::ArcGISRuntime::Geometry>& geometries);
+  using TileKey = qint64;
+
+  struct TileRange
+  {
+    int m_level = 0;
+    double m_tileSize = 0.0;
+    int m_columnMin = 0;
+    int m_columnMax = -1;
+    int m_rowMin = 0;
+    int m_rowMax = -1;
+  };
+
+  struct Tile
+  {
+    bool m_loaded = false;
+    Esri::ArcGISRuntime::Envelope m_extent;
+    QList<Esri::ArcGISRuntime::Geometry> m_geometries;
+    QList<Esri::ArcGISRuntime::Envelope> m_extents;
+    QList<qint64> m_featureIds;
+  };
+
+  void setQuadtree(GeometryQuadtree* quadtree);
+  QList<Esri::ArcGISRuntime::Geometry> tileGeometries(const Esri::ArcGISRuntime::Envelope& targetArea) const;
+  void requestTile(TileKey key, const Esri::ArcGISRuntime::Envelope& tileExtent) const;
+  void touchTile(TileKey key) const;
+  void handleTileQueryCompleted(TileKey key, Esri::ArcGISRuntime::FeatureQueryResult* featureQueryResult);
+  qint64 tileFootprint() const;
+  qint64 releaseTiles();
+
+  static TileKey tileKey(int level, int column, int row);
+  static TileRange tileRange(const Esri::ArcGISRuntime::Envelope& targetArea);
+
+  static constexpr quint64 s_onDemandFeatureThreshold = 50000;
+  static constexpr double s_tileSize = 0.05;
+  static constexpr int s_maximumTilesPerSide = 4;
+  static constexpr int s_maximumTileLevel = 12;
+  static constexpr int s_maximumTiles = 64;
 
-  Esri::ArcGISRuntime::FeatureLayer* m_FeatureLayer = nullptr;
-  GeometryQuadtree* m_quadtree = nullptr;
-  QList<Esri::ArcGISRuntime::Feature*> m_features;
-  mutable QList<Esri::ArcGISRuntime::Geometry> m_geomCache;
+  QPointer<Esri::ArcGISRuntime::FeatureLayer> m_FeatureLayer;
+  QPointer<GeometryQuadtree> m_quadtree;
+  bool m_onDemand = false;
+  mutable QHash<TileKey, Tile> m_tiles;
+  mutable QList<TileKey> m_tileOrder;
+  mutable QHash<QUuid, TileKey> m_tileQueries;
 };
 
 } // Dsa
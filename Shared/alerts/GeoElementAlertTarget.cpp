@@ -47,9 +47,13 @@ namespace Dsa {
  */
 GeoElementAlertTarget::GeoElementAlertTarget(GeoElement* geoElement):
   AlertTarget(GeoElementUtils::toQObject(geoElement)),
-  m_geoElementSignaler(new GeoElementSignaler(geoElement, this))
+  m_geoElement(geoElement)
 {
-  connect(m_geoElementSignaler, &GeoElementSignaler::geometryChanged, this, &GeoElementAlertTarget::dataChanged);
+  // the target is owned by the element so no separate signaler object is needed
+  GeoElementUtils::connectGeometryChanged(m_geoElement, this, [this]()
+  {
+    emit dataChanged();
+  });
 }
 
 /*!
@@ -66,7 +70,7 @@ GeoElementAlertTarget::~GeoElementAlertTarget()
  */
 QList<Geometry> GeoElementAlertTarget::targetGeometries(const Envelope&) const
 {
-  return QList<Geometry>{m_geoElementSignaler->geoElement()->geometry()};
+  return QList<Geometry>{m_geoElement->geometry()};
 }
 
 /*!
@@ -28,7 +28,6 @@ class GeoElement;
 
 namespace Dsa {
 
-class GeoElementSignaler;
 class GeoElementAlertTarget : public AlertTarget
 {
   Q_OBJECT
@@ -41,7 +40,7 @@ public:
   QVariant targetValue() const override;
 
 private:
-  GeoElementSignaler* m_geoElementSignaler = nullptr;
+  Esri::ArcGISRuntime::GeoElement* m_geoElement = nullptr;
 };
 
 } // Dsa
@@ -64,10 +64,7 @@ GraphicAlertSource::~GraphicAlertSource()
  */
 Point GraphicAlertSource::location() const
 {
-  if (m_graphic->geometry().geometryType() == GeometryType::Point)
-    return m_graphic->geometry();
-  else
-    return m_graphic->geometry().extent().center();
+  return graphicLocation(m_graphic);
 }
 
 /*!
@@ -90,4 +87,28 @@ void GraphicAlertSource::setSelected(bool selected)
   m_graphic->setSelected(selected);
 }
 
+/*!
+  \brief Returns the underlying \l Esri::ArcGISRuntime::Graphic.
+ */
+Graphic* GraphicAlertSource::graphic() const
+{
+  return m_graphic;
+}
+
+/*!
+  \brief Returns the location of \a graphic.
+
+  This is the graphic's point geometry, or the center of the extent of any other geometry.
+ */
+Point GraphicAlertSource::graphicLocation(Graphic* graphic)
+{
+  if (!graphic)
+    return Point();
+
+  if (graphic->geometry().geometryType() == GeometryType::Point)
+    return graphic->geometry();
+  else
+    return graphic->geometry().extent().center();
+}
+
 } // Dsa
@@ -41,6 +41,10 @@ public:
 
   void setSelected(bool selected) override;
 
+  Esri::ArcGISRuntime::Graphic* graphic() const;
+
+  static Esri::ArcGISRuntime::Point graphicLocation(Esri::ArcGISRuntime::Graphic* graphic);
+
 private:
   Esri::ArcGISRuntime::Graphic* m_graphic = nullptr;
 };
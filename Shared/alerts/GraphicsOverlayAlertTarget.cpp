@@ -21,6 +21,7 @@
 
 // dsa app headers
 #include "GeometryQuadtree.h"
+#include "SpatialIndexRegistry.h"
 
 // C++ API headers
 #include "GraphicListModel.h"
@@ -38,7 +39,11 @@ namespace Dsa {
   for an \l AlertCondition.
 
   Changes to any of the graphics in the overlay will cause the \l AlertTarget::locationChanged
-  signal to be emitted.
+  signal to be emitted. The signal is emitted once the change has been applied to the
+  overlay's spatial index, which is shared with other users via the \l SpatialIndexRegistry.
+  The index watches the graphics once, however many targets share it, and graphics which
+  are removed are taken out of it individually, so the number of connections does not grow
+  as a feed churns. A block of graphics removed from a message feed changes the index once.
   */
 
 /*!
@@ -51,28 +56,10 @@ GraphicsOverlayAlertTarget::GraphicsOverlayAlertTarget(GraphicsOverlay* graphics
   AlertTarget(graphicsOverlay),
   m_graphicsOverlay(graphicsOverlay)
 {
-  // respond to graphics being removed from the overlay
-  connect(m_graphicsOverlay->graphics(), &GraphicListModel::graphicRemoved, this, [this](int)
-  {
-    rebuildQuadtree();
-    emit dataChanged();
-  });
-
-  // respond to graphics being added to the overlay
-  connect(m_graphicsOverlay->graphics(), &GraphicListModel::graphicAdded, this, [this](int index)
-  {
-    Graphic* graphic = m_graphicsOverlay->graphics()->at(index);
-    setupGraphicConnections(graphic);
-    if (m_quadtree)
-      m_quadtree->appendGeoElment(graphic);
-    else
-      rebuildQuadtree();
-
-    emit dataChanged();
-  });
-
-  // build the quadtree for all graphics in the overlay to begin with
-  rebuildQuadtree();
+  // share the spatial index for the overlay, which is kept up to date as graphics are added, moved and removed
+  m_quadtree = SpatialIndexRegistry::instance()->acquire(m_graphicsOverlay);
+  if (m_quadtree)
+    connect(m_quadtree, &GeometryQuadtree::treeChanged, this, &GraphicsOverlayAlertTarget::dataChanged);
 }
 
 /*!
@@ -80,7 +67,8 @@ GraphicsOverlayAlertTarget::GraphicsOverlayAlertTarget(GraphicsOverlay* graphics
  */
 GraphicsOverlayAlertTarget::~GraphicsOverlayAlertTarget()
 {
-
+  if (m_quadtree)
+    SpatialIndexRegistry::instance()->release(m_graphicsOverlay);
 }
 
 /*!
@@ -96,6 +84,9 @@ QList<Geometry> GraphicsOverlayAlertTarget::targetGeometries(const Envelope& tar
 
   // otherwise, return all of the geometry in the overlay
   QList<Geometry> geomList;
+  if (!m_graphicsOverlay)
+    return geomList;
+
   const GraphicListModel* graphics = m_graphicsOverlay->graphics();
   if (!graphics)
     return geomList;
@@ -120,50 +111,13 @@ QVariant GraphicsOverlayAlertTarget::targetValue() const
 }
 
 /*!
-  \internal
-
-  Connect signals etc. for a new \a graphic.
- */
-void GraphicsOverlayAlertTarget::setupGraphicConnections(Graphic* graphic)
-{
-  if (!graphic)
-    return;
-
-  m_graphicConnections.append(connect(graphic, &Graphic::geometryChanged, this, &GraphicsOverlayAlertTarget::dataChanged));
-}
-
-/*!
-  \internal
+  \brief Returns the quadtree covering the target's geometry.
 
-  Build the quadtree.
+  The quadtree is shared with other users of the overlay.
  */
-void GraphicsOverlayAlertTarget::rebuildQuadtree()
+GeometryQuadtree* GraphicsOverlayAlertTarget::spatialIndex() const
 {
-  if (m_quadtree)
-  {
-    delete m_quadtree;
-    m_quadtree = nullptr;
-  }
-
-  const GraphicListModel* graphics = m_graphicsOverlay->graphics();
-  if (!graphics)
-    return;
-
-  const int count = graphics->rowCount();
-  QList<GeoElement*> elements;
-  for (int i = 0; i < count; ++i)
-  {
-    Graphic* g = m_graphicsOverlay->graphics()->at(i);
-    if (!g)
-      continue;
-
-    setupGraphicConnections(g);
-    elements.append(g);
-  }
-
-  // if there is more than 1 element in the overlay, build a quadtree
-  if (elements.size() > 1)
-    m_quadtree = new GeometryQuadtree(m_graphicsOverlay->extent(), elements, 8, this);
+  return m_quadtree;
 }
 
 } // Dsa
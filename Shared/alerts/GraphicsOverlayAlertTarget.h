@@ -20,12 +20,11 @@
 // dsa app headers
 #include "AlertTarget.h"
 
-namespace Esri {
-namespace ArcGISRuntime {
-class Graphic;
-class GraphicsOverlay;
-}
-}
+// C++ API headers
+#include "GraphicsOverlay.h"
+
+// Qt headers
+#include <QPointer>
 
 namespace Dsa {
 
@@ -41,14 +40,11 @@ public:
 
   QList<Esri::ArcGISRuntime::Geometry> targetGeometries(const Esri::ArcGISRuntime::Envelope& targetArea) const override;
   QVariant targetValue() const override;
+  GeometryQuadtree* spatialIndex() const override;
 
 private:
-  void setupGraphicConnections(Esri::ArcGISRuntime::Graphic* graphic);
-  void rebuildQuadtree();
-
-  Esri::ArcGISRuntime::GraphicsOverlay* m_graphicsOverlay = nullptr;
-  GeometryQuadtree* m_quadtree = nullptr;
-  QList<QMetaObject::Connection> m_graphicConnections;
+  QPointer<Esri::ArcGISRuntime::GraphicsOverlay> m_graphicsOverlay;
+  QPointer<GeometryQuadtree> m_quadtree;
 };
 
 } // Dsa
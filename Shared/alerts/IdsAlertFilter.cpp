@@ -62,6 +62,18 @@ bool IdsAlertFilter::passesFilter(AlertConditionData* conditionData) const
   return !m_ids.contains(conditionData->id());
 }
 
+/*!
+  \brief Adds the IDs excluded by this filter to \a spec.
+ */
+bool IdsAlertFilter::composeInto(AlertFilterSpec& spec) const
+{
+  spec.m_excludedIds.reserve(spec.m_excludedIds.size() + m_ids.size());
+  for (const QUuid& id : m_ids)
+    spec.m_excludedIds.append(id);
+
+  return true;
+}
+
 /*!
   \brief Adds \a id to the list of IDs to be excluded.
  */
@@ -74,6 +86,54 @@ void IdsAlertFilter::addId(const QUuid& id)
   emit filterChanged();
 }
 
+/*!
+  \brief Adds all of \a ids to the list of IDs to be excluded.
+
+  \l filterChanged is emitted once, if any of the IDs were not already excluded.
+ */
+void IdsAlertFilter::addIds(const QList<QUuid>& ids)
+{
+  const int oldSize = m_ids.size();
+  m_ids.reserve(oldSize + ids.size());
+  for (const QUuid& id : ids)
+    m_ids.insert(id);
+
+  if (m_ids.size() != oldSize)
+    emit filterChanged();
+}
+
+/*!
+  \brief Removes \a id from the list of IDs to be excluded.
+ */
+void IdsAlertFilter::removeId(const QUuid& id)
+{
+  if (m_ids.remove(id))
+    emit filterChanged();
+}
+
+/*!
+  \brief Removes all of \a ids from the list of IDs to be excluded.
+
+  \l filterChanged is emitted once, if any of the IDs were excluded.
+ */
+void IdsAlertFilter::removeIds(const QList<QUuid>& ids)
+{
+  const int oldSize = m_ids.size();
+  for (const QUuid& id : ids)
+    m_ids.remove(id);
+
+  if (m_ids.size() != oldSize)
+    emit filterChanged();
+}
+
+/*!
+  \brief Returns whether \a id is excluded by the filter.
+ */
+bool IdsAlertFilter::containsId(const QUuid& id) const
+{
+  return m_ids.contains(id);
+}
+
 /*!
   \brief Removes all IDs from the filter.
  */
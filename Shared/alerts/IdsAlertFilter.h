@@ -37,8 +37,13 @@ public:
   ~IdsAlertFilter();
 
   bool passesFilter(AlertConditionData* conditionData) const override;
+  bool composeInto(AlertFilterSpec& spec) const override;
 
   void addId(const QUuid& id);
+  void addIds(const QList<QUuid>& ids);
+  void removeId(const QUuid& id);
+  void removeIds(const QList<QUuid>& ids);
+  bool containsId(const QUuid& id) const;
   void clearIds();
 
 private:
@@ -19,9 +19,16 @@
 
 #include "LocationAlertSource.h"
 
+// dsa app headers
+#include "LocationGrid.h"
+
 // toolkit headers
 #include "ToolResourceProvider.h"
 
+// STL headers
+#include <algorithm>
+#include <cmath>
+
 using namespace Esri::ArcGISRuntime;
 
 namespace Dsa {
@@ -36,6 +43,10 @@ namespace Dsa {
   Changes to the device position will cause the \l AlertSource::locationChanged
   signal to be emitted.
 
+  Conditions which only need to be re-evaluated when the device has moved a
+  significant distance can instead watch a \l LocationGrid from
+  \l gridForDistance.
+
   /sa ToolResourceProvider
  */
 
@@ -53,6 +64,9 @@ LocationAlertSource::LocationAlertSource(QObject* parent):
 
     m_location = location;
     emit dataChanged();
+
+    for (LocationGrid* grid : qAsConst(m_grids))
+      grid->update(m_location);
   });
 }
 
@@ -88,5 +102,27 @@ void LocationAlertSource::setSelected(bool)
   // do not select the location display
 }
 
+/*!
+  \brief Returns a grid whose cells are small relative to \a meters.
+
+  The cell size is a power of two meters, no larger than 5% of \a meters and
+  at least 1 meter, so conditions with similar distances share a grid and
+  the grid is only checked once for each location update.
+ */
+LocationGrid* LocationAlertSource::gridForDistance(double meters)
+{
+  const int exponent = std::max(0, static_cast<int>(std::floor(std::log2(std::max(meters * s_cellSizeFactor, 1.0)))));
+
+  LocationGrid* grid = m_grids.value(exponent, nullptr);
+  if (grid)
+    return grid;
+
+  grid = new LocationGrid(std::ldexp(1.0, exponent), this);
+  grid->update(m_location);
+  m_grids.insert(exponent, grid);
+
+  return grid;
+}
+
 
 } // Dsa
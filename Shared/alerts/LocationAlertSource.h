@@ -20,8 +20,13 @@
 // dsa app headers
 #include "AlertSource.h"
 
+// Qt headers
+#include <QHash>
+
 namespace Dsa {
 
+class LocationGrid;
+
 class LocationAlertSource : public AlertSource
 {
   Q_OBJECT
@@ -34,9 +39,14 @@ public:
   QVariant value(const QString& key) const override;
 
   void setSelected(bool selected) override;
+
+  LocationGrid* gridForDistance(double meters);
+
 private:
-  Esri::ArcGISRuntime::Point m_location;
+  static constexpr double s_cellSizeFactor = 0.05;
 
+  Esri::ArcGISRuntime::Point m_location;
+  QHash<int, LocationGrid*> m_grids;
 };
 
 } // Dsa
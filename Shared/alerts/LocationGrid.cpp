@@ -0,0 +1,137 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "LocationGrid.h"
+
+// STL headers
+#include <algorithm>
+#include <cmath>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+/*!
+  \class Dsa::LocationGrid
+  \inmodule Dsa
+  \inherits QObject
+  \brief Tracks which cell of a uniform geodetic grid a WGS84 location lies in.
+
+  The grid has square cells which are \l cellSize meters along each side. The
+  \l cellChanged signal is only emitted when the location leaves its current
+  cell by more than a quarter of the cell size, so that a location which
+  jitters around a cell edge does not repeatedly change cell.
+
+  Conditions whose result cannot change noticeably over such small movements
+  can be re-evaluated on \l cellChanged rather than on every location update.
+
+  \sa LocationAlertSource
+ */
+
+/*!
+  \brief Constructor taking the \a cellSize in meters and an optional \a parent.
+ */
+LocationGrid::LocationGrid(double cellSize, QObject* parent):
+  QObject(parent),
+  m_cellSize(cellSize)
+{
+
+}
+
+/*!
+  \brief Destructor.
+ */
+LocationGrid::~LocationGrid()
+{
+
+}
+
+/*!
+  \brief Returns the size of the grid cells in meters.
+ */
+double LocationGrid::cellSize() const
+{
+  return m_cellSize;
+}
+
+/*!
+  \brief Updates the grid with the current \a location.
+
+  Emits \l cellChanged if the location has moved into a new cell.
+ */
+void LocationGrid::update(const Point& location)
+{
+  if (location.isEmpty())
+    return;
+
+  const double x = location.x();
+  const double y = location.y();
+  if (m_hasCell && isInCell(x, y))
+    return;
+
+  setCell(x, y);
+  emit cellChanged();
+}
+
+/*!
+  \internal
+
+  Returns whether \a x and \a y lie within the current cell, expanded by the hysteresis margin.
+ */
+bool LocationGrid::isInCell(double x, double y) const
+{
+  return x >= m_xMin - m_xMargin && x <= m_xMax + m_xMargin &&
+         y >= m_yMin - m_yMargin && y <= m_yMax + m_yMargin;
+}
+
+/*!
+  \internal
+
+  Sets the current cell to the one containing \a x and \a y.
+
+  Each row of cells is scaled for its latitude, so that cells are approximately
+  square in meters.
+ */
+void LocationGrid::setCell(double x, double y)
+{
+  const double yStep = m_cellSize / s_metersPerDegree;
+  const double row = std::floor(y / yStep);
+  const double rowLatitude = (row + 0.5) * yStep;
+
+  // avoid degenerate cells near the poles
+  const double cosLatitude = std::max(std::cos(rowLatitude * M_PI / 180.0), 0.01);
+  const double xStep = m_cellSize / (s_metersPerDegree * cosLatitude);
+  const double column = std::floor(x / xStep);
+
+  m_yMin = row * yStep;
+  m_yMax = m_yMin + yStep;
+  m_xMin = column * xStep;
+  m_xMax = m_xMin + xStep;
+  m_yMargin = yStep * s_hysteresisFraction;
+  m_xMargin = xStep * s_hysteresisFraction;
+  m_hasCell = true;
+}
+
+} // Dsa
+
+// Signal Documentation
+/*!
+  \fn void LocationGrid::cellChanged();
+  \brief Signal emitted when the location moves into a new cell.
+ */
@@ -0,0 +1,64 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef LOCATIONGRID_H
+#define LOCATIONGRID_H
+
+// Qt headers
+#include <QObject>
+
+// C++ API headers
+#include "Point.h"
+
+namespace Dsa {
+
+class LocationGrid : public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit LocationGrid(double cellSize, QObject* parent = nullptr);
+  ~LocationGrid();
+
+  double cellSize() const;
+
+  void update(const Esri::ArcGISRuntime::Point& location);
+
+signals:
+  void cellChanged();
+
+private:
+  Q_DISABLE_COPY(LocationGrid)
+
+  bool isInCell(double x, double y) const;
+  void setCell(double x, double y);
+
+  static constexpr double s_metersPerDegree = 111320.0;
+  static constexpr double s_hysteresisFraction = 0.25;
+
+  double m_cellSize = 0.0;
+  bool m_hasCell = false;
+  double m_xMin = 0.0;
+  double m_xMax = 0.0;
+  double m_yMin = 0.0;
+  double m_yMax = 0.0;
+  double m_xMargin = 0.0;
+  double m_yMargin = 0.0;
+};
+
+} // Dsa
+
+#endif // LOCATIONGRID_H
@@ -22,6 +22,9 @@
 // dsa app headers
 #include "AlertFilter.h"
 
+// STL headers
+#include <algorithm>
+
 namespace Dsa {
 
 /*!
@@ -61,6 +64,15 @@ bool StatusAlertFilter::passesFilter(AlertConditionData* connditionData) const
   return connditionData->level() >= m_minLevel;
 }
 
+/*!
+  \brief Raises the minimum level of \a spec to the minimum level of this filter.
+ */
+bool StatusAlertFilter::composeInto(AlertFilterSpec& spec) const
+{
+  spec.m_minLevel = std::max(spec.m_minLevel, m_minLevel);
+  return true;
+}
+
 /*!
   \brief The minimum \l AlertLevel for the filter.
 
@@ -34,6 +34,7 @@ public:
   ~StatusAlertFilter();
 
   bool passesFilter(AlertConditionData* alert) const override;
+  bool composeInto(AlertFilterSpec& spec) const override;
 
   AlertLevel minLevel() const;
   void setMinLevel(AlertLevel minLevel);
@@ -27,6 +27,9 @@
 // toolkit headers
 #include "ToolManager.h"
 
+// STL headers
+#include <algorithm>
+
 using namespace Esri::ArcGISRuntime;
 
 namespace Dsa {
@@ -42,6 +45,10 @@ namespace Dsa {
   This tool reports changes to the total number of alert condition data which are
   active but have not been marked as viwed.
 
+  The IDs of those condition data are kept in a set, which is updated for the
+  rows named by each change to the \l AlertListModel, so the count does not
+  need all of the condition data to be checked again.
+
   \sa AlertListModel
   \sa AlertConditionData
  */
@@ -55,9 +62,22 @@ ViewedAlertsController::ViewedAlertsController(QObject* parent /* = nullptr */):
   AlertListModel* model = AlertListModel::instance();
   if (model)
   {
-    connect(model, &AlertListModel::dataChanged, this, &ViewedAlertsController::handleDataChanged);
-    connect(model, &AlertListModel::rowsInserted, this, &ViewedAlertsController::handleDataChanged);
-    connect(model, &AlertListModel::rowsRemoved, this, &ViewedAlertsController::handleDataChanged);
+    connect(model, &AlertListModel::dataChanged, this, [this](const QModelIndex& topLeft, const QModelIndex& bottomRight)
+    {
+      updateRows(topLeft.row(), bottomRight.row());
+    });
+    connect(model, &AlertListModel::rowsInserted, this, [this](const QModelIndex&, int first, int last)
+    {
+      updateRows(first, last);
+    });
+    // the removed condition data are still available before they are removed
+    connect(model, &AlertListModel::rowsAboutToBeRemoved, this, [this](const QModelIndex&, int first, int last)
+    {
+      removeRows(first, last);
+    });
+    connect(model, &AlertListModel::modelReset, this, &ViewedAlertsController::resetRows);
+
+    resetRows();
     emit unviewedCountChanged();
   }
 
@@ -72,59 +92,93 @@ QString ViewedAlertsController::toolName() const
   return QString("viewed alerts");
 }
 
-void ViewedAlertsController::handleDataChanged()
-{
-  const int oldCount = m_cachedCount;
-  m_cachedCount = -1;
-  m_cachedCount = unviewedCount();
-
-  if (oldCount != m_cachedCount)
-    emit unviewedCountChanged();
-}
-
 /*!
-  \brief Destructor.
+  \internal
+  Updates whether each condition data in the rows from \a first to \a last is unviewed.
  */
-ViewedAlertsController::~ViewedAlertsController()
+void ViewedAlertsController::updateRows(int first, int last)
 {
+  AlertListModel* model = AlertListModel::instance();
+  if (!model)
+    return;
+
+  for (int i = std::max(0, first); i <= last; ++i)
+  {
+    AlertConditionData* alert = model->alertAt(i);
+    if (!alert)
+      continue;
+
+    if (alert->isActive() && alert->isConditionEnabled() && !alert->viewed())
+      m_unviewedIds.insert(alert->id());
+    else
+      m_unviewedIds.remove(alert->id());
+  }
+
+  updateCount();
 }
 
 /*!
-  \property ViewedAlertsController::unviewedCount
-  \brief Returns the number of alert condition data objects which are currently active
-  and which have not been marked as viewed.
+  \internal
+  Forgets the condition data in the rows from \a first to \a last, which are being removed.
  */
-int ViewedAlertsController::unviewedCount() const
+void ViewedAlertsController::removeRows(int first, int last)
 {
-  if (m_cachedCount != -1)
-    return m_cachedCount;
-
   AlertListModel* model = AlertListModel::instance();
   if (!model)
-    return 0;
+    return;
 
-  int count = 0;
-  const int alertsCount = model->rowCount();
-  for (int i = 0; i < alertsCount; ++i)
+  for (int i = std::max(0, first); i <= last; ++i)
   {
     AlertConditionData* alert = model->alertAt(i);
-    if (!alert)
-      continue;
+    if (alert)
+      m_unviewedIds.remove(alert->id());
+  }
 
-    if (!alert->isActive())
-      continue;
+  updateCount();
+}
 
-    if (!alert->isConditionEnabled())
-      continue;
+/*!
+  \internal
+  Finds the unviewed condition data among all of the rows of the model.
+ */
+void ViewedAlertsController::resetRows()
+{
+  m_unviewedIds.clear();
 
-    if (alert->viewed())
-      continue;
+  AlertListModel* model = AlertListModel::instance();
+  if (model)
+    updateRows(0, model->rowCount() - 1);
+  else
+    updateCount();
+}
 
-    count++;
-  }
+/*!
+  \internal
+  Emits \l unviewedCountChanged if the number of unviewed condition data has changed.
+ */
+void ViewedAlertsController::updateCount()
+{
+  if (m_cachedCount == m_unviewedIds.size())
+    return;
+
+  m_cachedCount = m_unviewedIds.size();
+  emit unviewedCountChanged();
+}
 
-  m_cachedCount = count;
+/*!
+  \brief Destructor.
+ */
+ViewedAlertsController::~ViewedAlertsController()
+{
+}
 
+/*!
+  \property ViewedAlertsController::unviewedCount
+  \brief Returns the number of alert condition data objects which are currently active
+  and which have not been marked as viewed.
+ */
+int ViewedAlertsController::unviewedCount() const
+{
   return m_cachedCount;
 }
 
@@ -23,6 +23,8 @@
 // Qt headers
 #include <QAbstractListModel>
 #include <QObject>
+#include <QSet>
+#include <QUuid>
 
 namespace Dsa {
 
@@ -47,11 +49,14 @@ public:
 signals:
   void unviewedCountChanged();
 
-private slots:
-  void handleDataChanged();
-
 private:
-  mutable int m_cachedCount = -1;
+  void updateRows(int first, int last);
+  void removeRows(int first, int last);
+  void resetRows();
+  void updateCount();
+
+  QSet<QUuid> m_unviewedIds;
+  int m_cachedCount = 0;
 };
 
 } // Dsa
@@ -71,6 +71,30 @@ AlertConditionData* WithinAreaAlertCondition::createData(AlertSource* source, Al
   return new WithinAreaAlertConditionData(newConditionDataName(), level(), source, target, this);
 }
 
+/*!
+  \brief Returns \c true, as a whole source feed can be tested against the target area.
+ */
+bool WithinAreaAlertCondition::isAggregateSupported() const
+{
+  return true;
+}
+
+/*!
+  \brief Returns a function which tests whether the source \a graphic, at \a location,
+  lies within the area of \a target.
+
+  The area is shrunk by the entry band of the \l hysteresis if the graphic is not
+  \a active, and grown by the exit band if it is. While the target is loading the
+  geometries around \a location, the graphic keeps its current state.
+ */
+AlertConditionData::QueryTask WithinAreaAlertCondition::createAggregateQueryTask(Graphic* graphic,
+                                                                                 const Point& location,
+                                                                                 AlertTarget* target,
+                                                                                 bool active) const
+{
+  return WithinAreaAlertConditionData::createQueryTask(graphic, location, target, hysteresis().thresholdOffset(active), active);
+}
+
 /*!
   \brief Returns the query string component for this condition - e.g. "is within".
  */
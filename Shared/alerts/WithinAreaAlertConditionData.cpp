@@ -22,16 +22,59 @@
 // dsa app headers
 #include "AlertSource.h"
 #include "AlertTarget.h"
+#include "GeometryQuadtree.h"
+#include "PreparedPolygon.h"
+#include "WithinDistanceAlertConditionData.h"
 
 // C++ API headers
 #include "GeoElement.h"
 #include "GeometryEngine.h"
 #include "Point.h"
 
+// STL headers
+#include <algorithm>
+
 using namespace Esri::ArcGISRuntime;
 
 namespace Dsa {
 
+namespace
+{
+// returns a function which tests whether the buffer of location by meters lies wholly
+// within one of the polygons of target
+AlertConditionData::QueryTask createInsideBandQueryTask(const Point& location, AlertTarget* target, double meters, bool loadingResult)
+{
+  const Point wgs84 = geometry_cast<Point>(GeometryEngine::project(location, SpatialReference::wgs84()));
+  const Geometry buffer = GeometryEngine::bufferGeodetic(wgs84, meters, LinearUnit::meters(), 1.0, GeodeticCurveType::Geodesic);
+  if (buffer.isEmpty())
+    return []() { return false; };
+
+  // only polygons whose extent reaches the source can contain the buffer
+  const GeometryQuadtree* spatialIndex = target->spatialIndex();
+  QList<Geometry> targetGeometries = spatialIndex ? spatialIndex->withinDistanceCandidates(wgs84, meters)
+                                                  : target->targetGeometries(buffer.extent());
+  if (!spatialIndex && target->isLoading(buffer.extent()))
+    return [loadingResult]() { return loadingResult; };
+
+  targetGeometries.erase(std::remove_if(targetGeometries.begin(), targetGeometries.end(), [](const Geometry& geometry)
+  {
+    return geometry.geometryType() != GeometryType::Polygon;
+  }), targetGeometries.end());
+
+  return [buffer, targetGeometries]()
+  {
+    return std::any_of(targetGeometries.cbegin(), targetGeometries.cend(), [&buffer](const Geometry& targetGeometry)
+    {
+      // geometries from a quadtree are already in WGS84
+      if (targetGeometry.spatialReference() == buffer.spatialReference())
+        return GeometryEngine::within(buffer, targetGeometry);
+
+      return GeometryEngine::within(buffer, GeometryEngine::project(targetGeometry, buffer.spatialReference()));
+    });
+  };
+}
+}
+
 /*!
   \class Dsa::WithinAreaAlertConditionData
   \inmodule Dsa
@@ -83,21 +126,102 @@ bool WithinAreaAlertConditionData::matchesQuery() const
   if (!isQueryOutOfDate())
     return cachedQueryResult();
 
-  Geometry sourceWgs84 = GeometryEngine::project(sourceLocation(), SpatialReference::wgs84());
-  const QList<Geometry> targetGeometries = target()->targetGeometries(sourceWgs84.extent());
+  const QueryTask task = queryTask();
+  return task();
+}
 
-  for (const Geometry& target : targetGeometries)
-  {
-    if (target.geometryType() != GeometryType::Polygon)
-      continue;
+/*!
+  \brief Returns a function which tests a snapshot of the source location against the
+  target polygons whose extents contain it.
 
-    const Geometry targetWgs84 = GeometryEngine::project(target, sourceWgs84.spatialReference());
-    if (GeometryEngine::instance()->intersects(sourceWgs84, targetWgs84))
-      return true;
-  }
+  If the target has a spatial index, its prepared polygons are used so that each test
+  is a grid lookup rather than a geometry engine intersection. Otherwise the
+  intersection tests are run by the returned function.
 
-  return false;
+  While this condition data is not active the source must be inside a polygon by the entry
+  band of the \l hysteresis, and while it is active it must be within the exit band of one.
+ */
+AlertConditionData::QueryTask WithinAreaAlertConditionData::queryTask() const
+{
+  return createQueryTask(source(), sourceLocation(), target(), thresholdOffset(), cachedQueryResult());
 }
 
+/*!
+  \brief Returns a function which tests whether \a location lies within the polygons of \a target.
+
+  A positive \a bandMeters grows the polygons, so that the function also returns \c true
+  when \a location is within that distance of one of them. A negative \a bandMeters shrinks
+  them, so that \a location must be at least that far inside a polygon. \a sourceObject
+  identifies the source of \a location when the test is made by distance.
+
+  If \a target is still loading the polygons around \a location, the function returns
+  \a loadingResult, which is normally the current result.
+
+  \sa WithinDistanceAlertConditionData::createQueryTask
+ */
+AlertConditionData::QueryTask WithinAreaAlertConditionData::createQueryTask(const QObject* sourceObject,
+                                                                            const Point& location,
+                                                                            AlertTarget* target,
+                                                                            double bandMeters,
+                                                                            bool loadingResult)
+{
+  if (location.isEmpty() || !target)
+    return []() { return false; };
+
+  if (bandMeters > 0.0)
+    return WithinDistanceAlertConditionData::createQueryTask(sourceObject, location, bandMeters, target, loadingResult);
+
+  if (bandMeters < 0.0)
+    return createInsideBandQueryTask(location, target, -bandMeters, loadingResult);
+
+  const Geometry sourceWgs84 = GeometryEngine::project(location, SpatialReference::wgs84());
+
+  // if the target has a spatial index, test its prepared polygons
+  const GeometryQuadtree* spatialIndex = target->spatialIndex();
+  if (spatialIndex)
+  {
+    const Point wgs84 = geometry_cast<Point>(sourceWgs84);
+    const QList<std::shared_ptr<const PreparedPolygon>> polygons = spatialIndex->candidatePolygons(wgs84);
+
+    return [wgs84, polygons]()
+    {
+      return std::any_of(polygons.cbegin(), polygons.cend(), [&wgs84](const std::shared_ptr<const PreparedPolygon>& polygon)
+      {
+        return polygon->contains(wgs84.x(), wgs84.y());
+      });
+    };
+  }
+
+  QList<Geometry> targetGeometries = target->targetGeometries(sourceWgs84.extent());
+  if (target->isLoading(sourceWgs84.extent()))
+    return [loadingResult]() { return loadingResult; };
+
+  // only polygons can contain the source
+  targetGeometries.erase(std::remove_if(targetGeometries.begin(), targetGeometries.end(), [](const Geometry& geometry)
+  {
+    return geometry.geometryType() != GeometryType::Polygon;
+  }), targetGeometries.end());
+
+  return [sourceWgs84, targetGeometries]()
+  {
+    for (const Geometry& targetGeometry : targetGeometries)
+    {
+      // geometries from a quadtree are already in WGS84
+      if (targetGeometry.spatialReference() == sourceWgs84.spatialReference())
+      {
+        if (GeometryEngine::intersects(sourceWgs84, targetGeometry))
+          return true;
+
+        continue;
+      }
+
+      const Geometry targetWgs84 = GeometryEngine::project(targetGeometry, sourceWgs84.spatialReference());
+      if (GeometryEngine::intersects(sourceWgs84, targetWgs84))
+        return true;
+    }
+
+    return false;
+  };
+}
 
 } // Dsa
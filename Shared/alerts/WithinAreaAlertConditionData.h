@@ -45,6 +45,13 @@ public:
   ~WithinAreaAlertConditionData();
 
   bool matchesQuery() const override;
+  QueryTask queryTask() const override;
+
+  static QueryTask createQueryTask(const QObject* sourceObject,
+                                   const Esri::ArcGISRuntime::Point& location,
+                                   AlertTarget* target,
+                                   double bandMeters = 0.0,
+                                   bool loadingResult = false);
 };
 
 } // Dsa
@@ -23,6 +23,9 @@
 #include "AlertConstants.h"
 #include "WithinDistanceAlertConditionData.h"
 
+// STL headers
+#include <algorithm>
+
 using namespace Esri::ArcGISRuntime;
 
 namespace Dsa {
@@ -69,6 +72,31 @@ AlertConditionData* WithinDistanceAlertCondition::createData(AlertSource* source
   return new WithinDistanceAlertConditionData(newConditionDataName(), level(), source, target, m_distance, this);
 }
 
+/*!
+  \brief Returns \c true, as a whole source feed can be tested against the distance threshold.
+ */
+bool WithinDistanceAlertCondition::isAggregateSupported() const
+{
+  return true;
+}
+
+/*!
+  \brief Returns a function which tests whether the source \a graphic, at \a location,
+  lies within the threshold distance of \a target.
+
+  The distance is reduced by the entry band of the \l hysteresis if the graphic is not
+  \a active, and increased by the exit band if it is. While the target is loading the
+  geometries around \a location, the graphic keeps its current state.
+ */
+AlertConditionData::QueryTask WithinDistanceAlertCondition::createAggregateQueryTask(Graphic* graphic,
+                                                                                     const Point& location,
+                                                                                     AlertTarget* target,
+                                                                                     bool active) const
+{
+  const double meters = std::max(0.0, m_distance + hysteresis().thresholdOffset(active));
+  return WithinDistanceAlertConditionData::createQueryTask(graphic, location, meters, target, active);
+}
+
 /*!
   \brief The threshold distance (in meters) for this condition.
  */
@@ -40,6 +40,12 @@ public:
 
   AlertConditionData* createData(AlertSource* source, AlertTarget* target) override;
 
+  bool isAggregateSupported() const override;
+  AlertConditionData::QueryTask createAggregateQueryTask(Esri::ArcGISRuntime::Graphic* graphic,
+                                                         const Esri::ArcGISRuntime::Point& location,
+                                                         AlertTarget* target,
+                                                         bool active) const override;
+
   QString queryString() const override;
   QVariantMap queryComponents() const override;
 
@@ -22,6 +22,10 @@
 // dsa app headers
 #include "AlertSource.h"
 #include "AlertTarget.h"
+#include "GeodesicKernels.h"
+#include "GeometryQuadtree.h"
+#include "LocationAlertSource.h"
+#include "LocationGrid.h"
 
 // C++ API headers
 #include "GeoElement.h"
@@ -29,13 +33,115 @@
 #include "Graphic.h"
 #include "Point.h"
 
+// Qt headers
+#include <QHash>
+#include <QtMath>
+
 // STL headers
+#include <algorithm>
 #include <cmath>
+#include <vector>
 
 using namespace Esri::ArcGISRuntime;
 
 namespace Dsa {
 
+namespace
+{
+// sources which have moved less than this distance in meters reuse their cached geometries
+constexpr double s_reuseTolerance = 0.1;
+
+// the spherical destination can fall short of the geodesic one on the ellipsoid by
+// around 0.5%, so the distance extent corners are moved further by this factor
+constexpr double s_extentScale = 1.01;
+
+// the clearance to the nearest target is searched for up to this far beyond the threshold
+// distance, or the threshold distance itself if it is further
+constexpr double s_minimumClearanceSearch = 10000.0;
+
+// returns an approximate distance in meters between two nearby WGS84 locations
+double approximateDistance(const Point& wgs84A, const Point& wgs84B)
+{
+  const double dy = qDegreesToRadians(wgs84B.y() - wgs84A.y());
+  const double dx = qDegreesToRadians(wgs84B.x() - wgs84A.x()) * std::cos(qDegreesToRadians((wgs84A.y() + wgs84B.y()) * 0.5));
+  return Geodesic::s_earthRadius * std::sqrt((dx * dx) + (dy * dy));
+}
+
+// caches the distance extent and the geodesic buffer for each source object and distance, so that
+// they are only re-created when the source moves by more than the tolerance. The cache is
+// shared by all condition data, so conditions with the same source and distance (for example
+// many targets tested against My Location) create them once between them
+class DistanceGeometryCache
+{
+public:
+  static DistanceGeometryCache& instance()
+  {
+    static DistanceGeometryCache s_instance;
+    return s_instance;
+  }
+
+  Envelope distanceExtent(const QObject* source, const Point& wgs84, double meters, double moveDistance)
+  {
+    Entry& cached = entry(source, wgs84, meters);
+    if (!cached.m_extent.isEmpty())
+      return cached.m_extent;
+
+    // get 2 new points by moving the source position in a NE and SW position
+    // moveDistance is the hypotenuse of the triangle with opposite and adjacent of distance
+    double southLat = 0.0;
+    double westLon = 0.0;
+    double northLat = 0.0;
+    double eastLon = 0.0;
+    Geodesic::destinationPoint(wgs84.y(), wgs84.x(), 225.0, moveDistance * s_extentScale, southLat, westLon);
+    Geodesic::destinationPoint(wgs84.y(), wgs84.x(), 45.0, moveDistance * s_extentScale, northLat, eastLon);
+
+    // form an Envelope from these 2 extreme points
+    cached.m_extent = Envelope(westLon, southLat, eastLon, northLat, SpatialReference::wgs84());
+    return cached.m_extent;
+  }
+
+  Geometry buffer(const QObject* source, const Point& wgs84, double meters)
+  {
+    Entry& cached = entry(source, wgs84, meters);
+    if (cached.m_buffer.isEmpty())
+      cached.m_buffer = GeometryEngine::bufferGeodetic(wgs84, meters, LinearUnit::meters(), 1.0, GeodeticCurveType::Geodesic);
+
+    return cached.m_buffer;
+  }
+
+private:
+  struct Entry
+  {
+    Point m_location;
+    Envelope m_extent;
+    Geometry m_buffer;
+  };
+
+  Entry& entry(const QObject* source, const Point& wgs84, double meters)
+  {
+    if (!m_entries.contains(source))
+    {
+      // stop caching for the source once it is destroyed
+      QObject::connect(source, &QObject::destroyed, [source]()
+      {
+        instance().m_entries.remove(source);
+      });
+    }
+
+    Entry& cached = m_entries[source][meters];
+    if (cached.m_location.isEmpty() || approximateDistance(cached.m_location, wgs84) > s_reuseTolerance)
+    {
+      cached = Entry();
+      cached.m_location = wgs84;
+    }
+
+    return cached;
+  }
+
+  QHash<const QObject*, QHash<double, Entry>> m_entries;
+};
+}
+
 /*!
   \class Dsa::WithinDistanceAlertConditionData
   \inmodule Dsa
@@ -44,6 +150,12 @@ namespace Dsa {
 
   This condition data allows a query to determine whether a source object is within a threshold
   distance of a target object, or objects.
+
+  When the target has a spatial index and no target is within the distance, the clearance
+  between the threshold and the nearest target is recorded. Later changes to the source or
+  target are not evaluated until the source could have moved, together with targets moving
+  at the \l GeometryQuadtree::maximumSpeed of the index, far enough to use the clearance
+  up. Any change which the index cannot predict forces a new evaluation.
  */
 
 /*!
@@ -59,6 +171,10 @@ namespace Dsa {
     \li \a distance. The threshold distance in meters.
     \li \a parent. The (optional) parent object.
   \endlist
+
+  When \a source is a \l LocationAlertSource, the query is only re-run when the
+  location moves into a new cell of a \l LocationGrid sized for \a distance,
+  or when the target changes.
  */
 WithinDistanceAlertConditionData::WithinDistanceAlertConditionData(const QString& name,
                                                                    AlertLevel level,
@@ -67,10 +183,18 @@ WithinDistanceAlertConditionData::WithinDistanceAlertConditionData(const QString
                                                                    double distance,
                                                                    QObject* parent):
   AlertConditionData(name, level, source, target, parent),
-  m_distance(distance),
-  m_moveDistance(std::sqrt((m_distance * m_distance) + (m_distance * m_distance)))
+  m_distance(distance)
 {
+  m_clock.start();
 
+  // the device location only triggers a new query when it moves a significant distance
+  LocationAlertSource* locationSource = qobject_cast<LocationAlertSource*>(source);
+  if (locationSource)
+  {
+    disconnect(source, &AlertSource::dataChanged, this, &WithinDistanceAlertConditionData::handleDataChanged);
+    connect(locationSource->gridForDistance(m_distance), &LocationGrid::cellChanged,
+            this, &WithinDistanceAlertConditionData::handleDataChanged);
+  }
 }
 
 /*!
@@ -98,38 +222,227 @@ bool WithinDistanceAlertConditionData::matchesQuery() const
   if (!isQueryOutOfDate())
     return cachedQueryResult();
 
-  // get 2 new points by moving the source position in a NE and SW position
-  // m_moveDistance is the hypotenuse of the triangle with opposite and adjacent of distance
-  const QList<Point> southWest = GeometryEngine::moveGeodetic(QList<Point>{sourceLocation()}, m_moveDistance,
-                                                              LinearUnit::meters(), 225.0, AngularUnit::degrees(),
-                                                              GeodeticCurveType::Geodesic);
-  const QList<Point> northEast = GeometryEngine::moveGeodetic(QList<Point>{sourceLocation()}, m_moveDistance,
-                                                              LinearUnit::meters(), 45.0, AngularUnit::degrees(),
-                                                              GeodeticCurveType::Geodesic);
+  const QueryTask task = queryTask();
+  return task();
+}
+
+/*!
+  \brief Returns a function which tests a snapshot of the source location against the
+  target geometries which lie within the extent of the threshold distance.
+
+  The distance extent and geodesic buffer of the source location are cached and shared
+  with other condition data with the same source and distance. They are reused until the
+  source moves by more than 10 centimeters. The intersection tests are run by the
+  returned function.
 
-  // form an Envelope from these 2 extreme points and check for target geometrties within this extent
-  const Envelope distanceExtent(southWest.first(), northEast.first());
-  const QList<Geometry> targetGeometries = target()->targetGeometries(distanceExtent);
+  If the target has a spatial index and the nearest target is further than the threshold
+  distance, the function returns \c false without any further tests and the clearance is
+  used to defer later changes.
+
+  The threshold distance is reduced by the entry band of the \l hysteresis while this
+  condition data is not active, and increased by the exit band while it is.
+ */
+AlertConditionData::QueryTask WithinDistanceAlertConditionData::queryTask() const
+{
+  updatePrediction();
+  if (m_prediction.m_valid)
+    return []() { return false; };
+
+  return createQueryTask(source(), sourceLocation(), thresholdDistance(), target(), cachedQueryResult());
+}
+
+/*!
+  \internal
+
+  Returns the distance, in meters, which the next query tests for the current active state.
+ */
+double WithinDistanceAlertConditionData::thresholdDistance() const
+{
+  return std::max(0.0, m_distance + thresholdOffset());
+}
+
+/*!
+  \brief Returns whether a change to the source or target could bring them within the
+  threshold distance, or take them out of it.
+
+  Returns \c false while the distance moved by the source since the last query, plus the
+  furthest that any target could have moved since then at the maximum speed of the spatial
+  index, is less than the clearance recorded by that query.
+ */
+bool WithinDistanceAlertConditionData::isChangeRelevant() const
+{
+  if (!m_prediction.m_valid)
+    return true;
+
+  AlertTarget* alertTarget = target();
+  const GeometryQuadtree* spatialIndex = alertTarget ? alertTarget->spatialIndex() : nullptr;
+  const Point location = sourceLocation();
+  if (!spatialIndex || spatialIndex != m_prediction.m_spatialIndex ||
+      spatialIndex->unpredictableChangeCount() != m_prediction.m_changeCount || location.isEmpty())
+  {
+    m_prediction.m_valid = false;
+    return true;
+  }
+
+  const Point wgs84 = location.spatialReference() == SpatialReference::wgs84()
+                        ? location
+                        : geometry_cast<Point>(GeometryEngine::project(location, SpatialReference::wgs84()));
+
+  // the target speed may have risen since the query without any target moving faster than it
+  const double seconds = (m_clock.elapsed() - m_prediction.m_time) / 1000.0;
+  const double speed = std::max(m_prediction.m_speed, spatialIndex->maximumSpeed());
+  const double used = Geodesic::haversineDistance(m_prediction.m_location.y(), m_prediction.m_location.x(), wgs84.y(), wgs84.x()) +
+                      (speed * seconds);
+  if (used < m_prediction.m_clearance)
+    return false;
+
+  m_prediction.m_valid = false;
+  return true;
+}
+
+/*!
+  \internal
+
+  Records the clearance between the threshold distance and the nearest geometry in the
+  spatial index of the target, if there is one, for the current source location.
+ */
+void WithinDistanceAlertConditionData::updatePrediction() const
+{
+  m_prediction = Prediction();
+
+  AlertTarget* alertTarget = target();
+  const GeometryQuadtree* spatialIndex = alertTarget ? alertTarget->spatialIndex() : nullptr;
+  const Point location = sourceLocation();
+  if (!spatialIndex || location.isEmpty())
+    return;
+
+  const Point wgs84 = location.spatialReference() == SpatialReference::wgs84()
+                        ? location
+                        : geometry_cast<Point>(GeometryEngine::project(location, SpatialReference::wgs84()));
+
+  const double meters = thresholdDistance();
+  const double searchMeters = meters + std::max(meters, s_minimumClearanceSearch);
+  const double clearance = spatialIndex->distanceLowerBound(wgs84, searchMeters) - meters;
+  if (clearance <= 0.0)
+    return;
+
+  m_prediction.m_valid = true;
+  m_prediction.m_location = wgs84;
+  m_prediction.m_time = m_clock.elapsed();
+  m_prediction.m_clearance = clearance;
+  m_prediction.m_speed = spatialIndex->maximumSpeed();
+  m_prediction.m_changeCount = spatialIndex->unpredictableChangeCount();
+  m_prediction.m_spatialIndex = spatialIndex;
+}
+
+/*!
+  \brief Returns a function which tests whether \a location lies within \a meters of the
+  geometries of \a target.
+
+  \a sourceObject identifies the source of \a location, for example an \l AlertSource or a
+  \l Esri::ArcGISRuntime::Graphic. It is used to share the cached distance extent and
+  geodesic buffer between queries for the same source.
+
+  Point geometries in WGS84 are tested together by distance, in the same way as the
+  points of a spatial index, and only the other geometries are tested against the buffer.
+
+  If \a target is still loading the geometries around \a location, the function returns
+  \a loadingResult, which is normally the current result. The target emits
+  \l AlertTarget::dataChanged once they arrive, and the query is run again.
+ */
+AlertConditionData::QueryTask WithinDistanceAlertConditionData::createQueryTask(const QObject* sourceObject,
+                                                                                const Point& location,
+                                                                                double meters,
+                                                                                AlertTarget* target,
+                                                                                bool loadingResult)
+{
+  if (location.isEmpty() || !target)
+    return []() { return false; };
+
+  const Point wgs84 = location.spatialReference() == SpatialReference::wgs84()
+                        ? location
+                        : geometry_cast<Point>(GeometryEngine::project(location, SpatialReference::wgs84()));
+
+  DistanceGeometryCache& cache = DistanceGeometryCache::instance();
+
+  // if the target has a spatial index, use its exact distance test
+  const GeometryQuadtree* spatialIndex = target->spatialIndex();
+  if (spatialIndex)
+  {
+    const QList<Geometry> candidates = spatialIndex->withinDistanceCandidates(wgs84, meters);
+
+    // point candidates are tested by distance, so the buffer is only needed for other geometries
+    const bool bufferRequired = std::any_of(candidates.cbegin(), candidates.cend(), [](const Geometry& candidate)
+    {
+      return candidate.geometryType() != GeometryType::Point;
+    });
+    const Geometry buffer = bufferRequired ? cache.buffer(sourceObject, wgs84, meters) : Geometry();
+
+    return [wgs84, meters, candidates, buffer]()
+    {
+      return GeometryQuadtree::isAnyWithinDistance(wgs84, meters, candidates, buffer);
+    };
+  }
+
+  // the extent corners are moved by the hypotenuse of the triangle with opposite and adjacent of distance
+  const double moveDistance = std::sqrt((meters * meters) + (meters * meters));
+
+  // check for target geometrties within the distance extent
+  const Envelope distanceExtent = cache.distanceExtent(sourceObject, wgs84, meters, moveDistance);
+  const QList<Geometry> targetGeometries = target->targetGeometries(distanceExtent);
+
+  // the geometries which have been retrieved so far cannot change the result
+  if (target->isLoading(distanceExtent))
+    return [loadingResult]() { return loadingResult; };
 
   // if there are no target geometries within the distance extent, stop
   if (targetGeometries.isEmpty())
-    return false;
+    return []() { return false; };
 
-  // buffer the source position by the distance for an accurate within distance test
-  const Geometry bufferGeom = GeometryEngine::bufferGeodetic(sourceLocation(), distance(), LinearUnit::meters(), 1.0,
-                                                             GeodeticCurveType::Geodesic);
-  const Geometry bufferWgs84 = GeometryEngine::project(bufferGeom, SpatialReference::wgs84());
+  // the buffer of the source position by the distance gives an accurate within distance test
+  const Geometry bufferWgs84 = cache.buffer(sourceObject, wgs84, meters);
 
-  // test the buffer against all the target geometries
-  for (const Geometry& target : targetGeometries)
+  return [wgs84, meters, bufferWgs84, targetGeometries]()
   {
-    Geometry targetWgs84 = GeometryEngine::project(target, SpatialReference::wgs84());
-    if (GeometryEngine::intersects(bufferWgs84, targetWgs84))
+    // WGS84 point targets are packed and tested together by the distance mask kernel
+    std::vector<double> pointLats;
+    std::vector<double> pointLons;
+    for (const Geometry& targetGeometry : targetGeometries)
+    {
+      if (targetGeometry.geometryType() != GeometryType::Point || targetGeometry.spatialReference() != bufferWgs84.spatialReference())
+        continue;
+
+      const Point point = geometry_cast<Point>(targetGeometry);
+      pointLats.push_back(point.y());
+      pointLons.push_back(point.x());
+    }
+
+    std::vector<unsigned char> pointMask(pointLats.size());
+    if (Geodesic::withinDistanceMask(wgs84.y(), wgs84.x(), pointLats.data(), pointLons.data(), pointLats.size(), meters, pointMask.data()) > 0)
       return true;
-  }
 
-  return false;
-}
+    // test the buffer against the other target geometries
+    for (const Geometry& targetGeometry : targetGeometries)
+    {
+      // geometries from a quadtree are already in WGS84
+      if (targetGeometry.spatialReference() == bufferWgs84.spatialReference())
+      {
+        if (targetGeometry.geometryType() == GeometryType::Point)
+          continue;
+
+        if (GeometryEngine::intersects(bufferWgs84, targetGeometry))
+          return true;
+
+        continue;
+      }
 
+      Geometry targetWgs84 = GeometryEngine::project(targetGeometry, SpatialReference::wgs84());
+      if (GeometryEngine::intersects(bufferWgs84, targetWgs84))
+        return true;
+    }
+
+    return false;
+  };
+}
 
 } // Dsa
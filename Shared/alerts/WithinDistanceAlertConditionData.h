@@ -22,9 +22,15 @@
 
 // C++ API headers
 #include "Geometry.h"
+#include "Point.h"
+
+// Qt headers
+#include <QElapsedTimer>
 
 namespace Dsa {
 
+class GeometryQuadtree;
+
 class WithinDistanceAlertConditionData : public AlertConditionData
 {
   Q_OBJECT
@@ -41,10 +47,35 @@ public:
   double distance() const;
 
   bool matchesQuery() const override;
+  QueryTask queryTask() const override;
+
+  static QueryTask createQueryTask(const QObject* sourceObject,
+                                   const Esri::ArcGISRuntime::Point& location,
+                                   double meters,
+                                   AlertTarget* target,
+                                   bool loadingResult = false);
+
+protected:
+  bool isChangeRelevant() const override;
 
 private:
+  struct Prediction
+  {
+    bool m_valid = false;
+    Esri::ArcGISRuntime::Point m_location;
+    qint64 m_time = 0;
+    double m_clearance = 0.0;
+    double m_speed = 0.0;
+    int m_changeCount = 0;
+    const GeometryQuadtree* m_spatialIndex = nullptr;
+  };
+
+  void updatePrediction() const;
+  double thresholdDistance() const;
+
   double m_distance = 0.0;
-  double m_moveDistance = 0.0;
+  QElapsedTimer m_clock;
+  mutable Prediction m_prediction;
 };
 
 } // Dsa
@@ -0,0 +1,249 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "WithinViewAlertCondition.h"
+
+// dsa app headers
+#include "AlertConstants.h"
+#include "AlertTarget.h"
+#include "ViewshedRasterCache.h"
+#include "WithinViewAlertConditionData.h"
+
+// toolkit headers
+#include "ToolResourceProvider.h"
+
+// C++ API headers
+#include "GeometryEngine.h"
+#include "Scene.h"
+#include "Surface.h"
+
+// STL headers
+#include <algorithm>
+#include <cmath>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+namespace
+{
+constexpr double s_metersPerDegree = 111320.0;
+
+// the search area for observers is enlarged by this factor to allow for the
+// approximate conversion from meters to degrees
+constexpr double s_searchScale = 1.01;
+}
+
+/*!
+  \class Dsa::WithinViewAlertCondition
+  \inmodule Dsa
+  \inherits AlertCondition
+  \brief Represents a spatial, "within view of", condition which will be continuously monitored
+  and will trigger an alert when a source object can be seen from any observer point of a
+  target, such as a known enemy position.
+
+  The viewshed of each observer within the range of a source is computed once by a
+  \l ViewshedRasterCache, from the elevation of the scene's base surface, and kept as
+  one bit per cell. Testing a source is then a lookup of the cell which contains it, so that
+  thousands of tracks can be tested for the cost of reading an array. Sources keep their
+  current state while the viewshed of a nearby observer is being computed, and every query
+  is run again once it has been cached.
+
+  Observers are the point geometries of the target. Other geometries are ignored. The
+  bands of the \l hysteresis do not apply to this condition, as they would change the range
+  of the cached viewsheds, but its minimum dwell time does.
+
+  This condition will create new \l WithinViewAlertConditionData to track source and target objects.
+  */
+
+/*!
+  \brief Constructor taking an \l AlertLevel (\a level) the \a name of the condition,
+  the \a range (in meters) which observers can see and an optional \a parent.
+ */
+WithinViewAlertCondition::WithinViewAlertCondition(AlertLevel level,
+                                                   const QString& name,
+                                                   double range,
+                                                   QObject* parent):
+  AlertCondition(level, name, parent),
+  m_range(range),
+  m_rasterCache(new ViewshedRasterCache(this))
+{
+  // several viewsheds computed close together only re-run the queries once
+  m_refreshTimer.setSingleShot(true);
+  m_refreshTimer.setInterval(s_refreshInterval);
+  connect(&m_refreshTimer, &QTimer::timeout, this, &WithinViewAlertCondition::invalidateQueries);
+  connect(m_rasterCache, &ViewshedRasterCache::rasterComputed, this, [this]()
+  {
+    if (!m_refreshTimer.isActive())
+      m_refreshTimer.start();
+  });
+}
+
+/*!
+  \brief Destructor.
+ */
+WithinViewAlertCondition::~WithinViewAlertCondition()
+{
+}
+
+/*!
+  \brief Creates a new \l WithinViewAlertConditionData to track \a source and \a target objects.
+ */
+AlertConditionData* WithinViewAlertCondition::createData(AlertSource* source, AlertTarget* target)
+{
+  return new WithinViewAlertConditionData(newConditionDataName(), level(), source, target, this, this);
+}
+
+/*!
+  \brief Returns \c true, as every graphic of a source feed can be looked up in the cached viewsheds.
+ */
+bool WithinViewAlertCondition::isAggregateSupported() const
+{
+  return true;
+}
+
+/*!
+  \brief Returns a function which returns whether the source \a graphic, at \a location,
+  can be seen from any observer of \a target.
+
+  While the viewshed of a nearby observer is being computed, the graphic keeps its
+  current state, given by \a active.
+ */
+AlertConditionData::QueryTask WithinViewAlertCondition::createAggregateQueryTask(Graphic* graphic,
+                                                                                 const Point& location,
+                                                                                 AlertTarget* target,
+                                                                                 bool active) const
+{
+  Q_UNUSED(graphic)
+
+  return createViewQueryTask(location, target, active);
+}
+
+/*!
+  \brief Returns a function which returns whether \a location can be seen from any observer
+  of \a target within the range of the condition.
+
+  The cached viewsheds are looked up when the function is created, so the function only
+  returns the result. The viewshed of any observer near \a location which has not been cached
+  is requested, and the function returns \a pendingResult until it has been.
+ */
+AlertConditionData::QueryTask WithinViewAlertCondition::createViewQueryTask(const Point& location,
+                                                                            AlertTarget* target,
+                                                                            bool pendingResult) const
+{
+  if (location.isEmpty() || !target || m_range <= 0.0)
+    return []() { return false; };
+
+  const Point wgs84 = location.spatialReference() == SpatialReference::wgs84()
+                        ? location
+                        : geometry_cast<Point>(GeometryEngine::project(location, SpatialReference::wgs84()));
+
+  const double halfHeight = m_range * s_searchScale / s_metersPerDegree;
+  const double halfWidth = halfHeight / std::max(std::cos(wgs84.y() * M_PI / 180.0), 0.01);
+  const Envelope searchArea(wgs84.x() - halfWidth, wgs84.y() - halfHeight,
+                            wgs84.x() + halfWidth, wgs84.y() + halfHeight, SpatialReference::wgs84());
+
+  if (target->isLoading(searchArea))
+    return [pendingResult]() { return pendingResult; };
+
+  QList<ViewshedRasterCache::Parameters> uncached;
+  const QList<Geometry> observers = target->targetGeometries(searchArea);
+  for (const Geometry& observer : observers)
+  {
+    if (observer.geometryType() != GeometryType::Point)
+      continue;
+
+    ViewshedRasterCache::Parameters parameters;
+    parameters.m_observer = geometry_cast<Point>(observer);
+    parameters.m_maxDistance = m_range;
+
+    bool visible = false;
+    if (!m_rasterCache->isVisible(parameters, wgs84, visible))
+      uncached.append(parameters);
+    else if (visible)
+      return []() { return true; };
+  }
+
+  if (uncached.isEmpty())
+    return []() { return false; };
+
+  Surface* elevationSurface = surface();
+  if (!elevationSurface)
+    return []() { return false; };
+
+  m_rasterCache->compute(elevationSurface, uncached);
+  return [pendingResult]() { return pendingResult; };
+}
+
+/*!
+  \brief The range (in meters) which observers can see for this condition.
+ */
+double WithinViewAlertCondition::range() const
+{
+  return m_range;
+}
+
+/*!
+  \brief Returns a map of the variable components that make up the query for this condition.
+
+  This condition type uses a query comprising the following components:
+
+  \list
+    \li meters. The range which observers can see in meters.
+  \endlist
+ */
+QVariantMap WithinViewAlertCondition::queryComponents() const
+{
+  QVariantMap queryMap;
+  queryMap.insert(AlertConstants::METERS, m_range);
+
+  return queryMap;
+}
+
+/*!
+  \brief Static method to get the range in meters from a \a queryComponents.
+
+  Returns \c -1.0 if unsuccessful
+ */
+double WithinViewAlertCondition::getRangeFromQueryComponents(const QVariantMap& queryComponents)
+{
+  return queryComponents.value(AlertConstants::METERS, -1.0).toDouble();
+}
+
+/*!
+  \brief Returns the query string component for this condition - e.g. "is within view (X meters) of".
+ */
+QString WithinViewAlertCondition::queryString() const
+{
+  return QString("is within view (%1 %2) of").arg(QString::number(m_range), AlertConstants::METERS);
+}
+
+/*!
+  \internal
+
+  Returns the base surface of the scene, which the viewsheds are computed from, or
+  \c nullptr if there is no scene.
+ */
+Surface* WithinViewAlertCondition::surface() const
+{
+  Scene* scene = ToolResourceProvider::instance()->scene();
+  return scene ? scene->baseSurface() : nullptr;
+}
+
+} // Dsa
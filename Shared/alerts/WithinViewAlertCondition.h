@@ -0,0 +1,80 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef WITHINVIEWALERTCONDITION_H
+#define WITHINVIEWALERTCONDITION_H
+
+// dsa app headers
+#include "AlertCondition.h"
+
+// Qt headers
+#include <QObject>
+#include <QTimer>
+
+namespace Esri {
+namespace ArcGISRuntime {
+class Surface;
+}
+}
+
+namespace Dsa {
+
+class ViewshedRasterCache;
+
+class WithinViewAlertCondition : public AlertCondition
+{
+  Q_OBJECT
+
+public:
+  WithinViewAlertCondition(AlertLevel level,
+                           const QString& name,
+                           double range,
+                           QObject* parent = nullptr);
+
+  ~WithinViewAlertCondition();
+
+  AlertConditionData* createData(AlertSource* source, AlertTarget* target) override;
+
+  bool isAggregateSupported() const override;
+  AlertConditionData::QueryTask createAggregateQueryTask(Esri::ArcGISRuntime::Graphic* graphic,
+                                                         const Esri::ArcGISRuntime::Point& location,
+                                                         AlertTarget* target,
+                                                         bool active) const override;
+
+  AlertConditionData::QueryTask createViewQueryTask(const Esri::ArcGISRuntime::Point& location,
+                                                    AlertTarget* target,
+                                                    bool pendingResult) const;
+
+  QString queryString() const override;
+  QVariantMap queryComponents() const override;
+
+  double range() const;
+
+  static double getRangeFromQueryComponents(const QVariantMap& queryComponents);
+
+private:
+  Esri::ArcGISRuntime::Surface* surface() const;
+
+  static constexpr int s_refreshInterval = 250;
+
+  double m_range;
+  ViewshedRasterCache* m_rasterCache = nullptr;
+  QTimer m_refreshTimer;
+};
+
+} // Dsa
+
+#endif // WITHINVIEWALERTCONDITION_H
@@ -0,0 +1,97 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "WithinViewAlertConditionData.h"
+
+// dsa app headers
+#include "WithinViewAlertCondition.h"
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+/*!
+  \class Dsa::WithinViewAlertConditionData
+  \inmodule Dsa
+  \inherits AlertConditionData
+  \brief Represents the data to be tested as part of a spatial, "within view of" condition.
+
+  This condition data allows a query to determine whether a source object can currently
+  be seen from any of the observer points of a target, using the viewsheds cached by its
+  \l WithinViewAlertCondition.
+ */
+
+/*!
+  \brief Constructor for a new within view condition data object.
+
+  \list
+    \li \a name. The name of the condition.
+    \li \a level. The \l AlertLevel for the condition.
+    \li \a source. The source data for the condition (for example
+      \l Esri::ArcGISRuntime::Graphic or a location).
+    \li \a target. The target data for the condition, whose point geometries are the observers.
+    \li \a condition. The condition which holds the cached viewsheds.
+    \li \a parent. The (optional) parent object.
+  \endlist
+ */
+WithinViewAlertConditionData::WithinViewAlertConditionData(const QString& name,
+                                                           AlertLevel level,
+                                                           AlertSource* source,
+                                                           AlertTarget* target,
+                                                           const WithinViewAlertCondition* condition,
+                                                           QObject* parent):
+  AlertConditionData(name, level, source, target, parent),
+  m_condition(condition)
+{
+}
+
+/*!
+  \brief Destructor.
+ */
+WithinViewAlertConditionData::~WithinViewAlertConditionData()
+{
+}
+
+/*!
+  \brief Returns whether the source can be seen from any observer of the target.
+ */
+bool WithinViewAlertConditionData::matchesQuery() const
+{
+  if (!isQueryOutOfDate())
+    return cachedQueryResult();
+
+  return queryTask()();
+}
+
+/*!
+  \brief Returns a function which returns whether the source can be seen from any observer
+  of the target.
+
+  While the viewshed of an observer near the source is still being computed, the
+  function returns the current result.
+ */
+AlertConditionData::QueryTask WithinViewAlertConditionData::queryTask() const
+{
+  if (!m_condition)
+    return []() { return false; };
+
+  return m_condition->createViewQueryTask(sourceLocation(), target(), cachedQueryResult());
+}
+
+} // Dsa
@@ -0,0 +1,49 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef WITHINVIEWALERTCONDITIONDATA_H
+#define WITHINVIEWALERTCONDITIONDATA_H
+
+// dsa app headers
+#include "AlertConditionData.h"
+
+namespace Dsa {
+
+class WithinViewAlertCondition;
+
+class WithinViewAlertConditionData : public AlertConditionData
+{
+  Q_OBJECT
+
+public:
+  WithinViewAlertConditionData(const QString& name,
+                               AlertLevel level,
+                               AlertSource* source,
+                               AlertTarget* target,
+                               const WithinViewAlertCondition* condition,
+                               QObject* parent = nullptr);
+  ~WithinViewAlertConditionData();
+
+  bool matchesQuery() const override;
+  QueryTask queryTask() const override;
+
+private:
+  const WithinViewAlertCondition* m_condition = nullptr;
+};
+
+} // Dsa
+
+#endif // WITHINVIEWALERTCONDITIONDATA_H
@@ -47,6 +47,12 @@ namespace Dsa {
   \sa Esri::ArcGISRuntime::AnalysisListModel
   \sa ViewshedListModel
 
+  Viewsheds are listed first, followed by lines of sight. The first combined row of
+  each source model is kept in an offset table which is updated as rows are inserted
+  into or removed from a source, so that mapping a row takes constant time. Row and
+  data changes in a source are forwarded as the equivalent fine-grained changes to the
+  combined list rather than as a reset.
+
   The model returns data for the following roles:
   \table
     \header
@@ -102,10 +108,8 @@ void CombinedAnalysisListModel::setViewshedModel(QAbstractItemModel* viewshedMod
   if (m_viewshedModel == castModel)
     return;
 
-  beginResetModel();
   m_viewshedModel = castModel;
-  connectAnalysisListModelSignals(m_viewshedModel);
-  endResetModel();
+  setSourceModel(s_viewshedSource, m_viewshedModel);
 }
 
 /*!
@@ -116,19 +120,26 @@ void CombinedAnalysisListModel::setLineOfSightModel(AnalysisListModel* lineOfSig
   if (m_lineOfSightModel == lineOfSightModel)
     return;
 
-  beginResetModel();
   m_lineOfSightModel = lineOfSightModel;
+  setSourceModel(s_lineOfSightSource, m_lineOfSightModel);
+
+  if (m_lineOfSightModel == nullptr)
+    return;
 
   // persist a unique index for each Line of sight as they are added - to be used to construct a name
   connect(m_lineOfSightModel, &AnalysisListModel::analysisAdded, this, [this](int index)
   {
     Analysis* addedAnalysis = m_lineOfSightModel->at(index);
-    if (addedAnalysis)
-      m_lineOfSightIndices.insert(addedAnalysis, m_lineOfSightIndices.count() + 1);
-  });
+    if (!addedAnalysis)
+      return;
 
-  connectAnalysisListModelSignals(m_lineOfSightModel);
-  endResetModel();
+    m_lineOfSightIndices.insert(addedAnalysis, m_lineOfSightIndices.count() + 1);
+
+    // the row may already be shown without its name
+    const int row = m_offsets.at(s_lineOfSightSource) + index;
+    if (row < rowCount())
+      emit dataChanged(this->index(row), this->index(row), QVector<int>{AnalysisNameRole});
+  });
 }
 
 /*!
@@ -206,7 +217,7 @@ Point CombinedAnalysisListModel::locationAt(int index)
  */
 int CombinedAnalysisListModel::rowCount(const QModelIndex&) const
 {
-  return viewshedCount() + lineOfSightCount();
+  return m_offsets.last();
 }
 
 /*!
@@ -287,26 +298,175 @@ QHash<int, QByteArray> CombinedAnalysisListModel::roleNames() const
 
 /*!
   \internal
+
+  Replaces the model for \a source with \a model, resetting the combined list.
  */
-void CombinedAnalysisListModel::handleUnderlyingDataChanged()
+void CombinedAnalysisListModel::setSourceModel(int source, QAbstractItemModel* model)
 {
   beginResetModel();
+
+  if (m_sources.at(source) != nullptr)
+    disconnect(m_sources.at(source), nullptr, this, nullptr);
+
+  m_sources[source] = model;
+  m_sourceCounts[source] = model == nullptr ? 0 : model->rowCount();
+  updateOffsets(source);
+  connectSourceModel(source);
+
   endResetModel();
 }
 
 /*!
   \internal
+
+  Forwards row and data changes in the model for \a source, translated to combined rows.
  */
-void CombinedAnalysisListModel::connectAnalysisListModelSignals(QAbstractItemModel* analysisList)
+void CombinedAnalysisListModel::connectSourceModel(int source)
 {
-  if (analysisList == nullptr)
+  QAbstractItemModel* model = m_sources.at(source);
+  if (model == nullptr)
     return;
 
-  // react to changes in the supplied model
-  connect(analysisList, &QAbstractItemModel::dataChanged, this, &CombinedAnalysisListModel::handleUnderlyingDataChanged);
-  connect(analysisList, &QAbstractItemModel::modelReset, this, &CombinedAnalysisListModel::handleUnderlyingDataChanged);
-  connect(analysisList, &QAbstractItemModel::rowsInserted, this, &CombinedAnalysisListModel::handleUnderlyingDataChanged);
-  connect(analysisList, &QAbstractItemModel::rowsRemoved, this, &CombinedAnalysisListModel::handleUnderlyingDataChanged);
+  connect(model, &QAbstractItemModel::rowsAboutToBeInserted, this, [this, source](const QModelIndex& parent, int first, int last)
+  {
+    if (parent.isValid())
+      return;
+
+    const int offset = m_offsets.at(source);
+    beginInsertRows(QModelIndex(), offset + first, offset + last);
+  });
+
+  connect(model, &QAbstractItemModel::rowsInserted, this, [this, source](const QModelIndex& parent, int first, int last)
+  {
+    if (parent.isValid())
+      return;
+
+    m_sourceCounts[source] += last - first + 1;
+    updateOffsets(source);
+    endInsertRows();
+  });
+
+  connect(model, &QAbstractItemModel::rowsAboutToBeRemoved, this, [this, source](const QModelIndex& parent, int first, int last)
+  {
+    if (parent.isValid())
+      return;
+
+    const int offset = m_offsets.at(source);
+    beginRemoveRows(QModelIndex(), offset + first, offset + last);
+  });
+
+  connect(model, &QAbstractItemModel::rowsRemoved, this, [this, source](const QModelIndex& parent, int first, int last)
+  {
+    if (parent.isValid())
+      return;
+
+    m_sourceCounts[source] -= last - first + 1;
+    updateOffsets(source);
+    endRemoveRows();
+  });
+
+  connect(model, &QAbstractItemModel::dataChanged, this, [this, source](const QModelIndex& topLeft, const QModelIndex& bottomRight, const QVector<int>& roles)
+  {
+    if (!topLeft.isValid() || !bottomRight.isValid())
+      return;
+
+    // changes to roles which are not exposed by the combined list are dropped
+    const QVector<int> changedRoles = combinedRoles(source, roles);
+    if (!roles.isEmpty() && changedRoles.isEmpty())
+      return;
+
+    const int offset = m_offsets.at(source);
+    emit dataChanged(index(offset + topLeft.row()), index(offset + bottomRight.row()), changedRoles);
+  });
+
+  connect(model, &QAbstractItemModel::modelAboutToBeReset, this, [this]()
+  {
+    beginResetModel();
+  });
+  connect(model, &QAbstractItemModel::modelReset, this, [this, source]()
+  {
+    m_sourceCounts[source] = m_sources.at(source)->rowCount();
+    updateOffsets(source);
+    endResetModel();
+  });
+
+  // reordering is rare, so the combined list is simply reset
+  connect(model, &QAbstractItemModel::layoutChanged, this, [this, source]()
+  {
+    resetSource(source);
+  });
+  connect(model, &QAbstractItemModel::rowsMoved, this, [this, source]()
+  {
+    resetSource(source);
+  });
+}
+
+/*!
+  \internal
+
+  Recomputes the first combined row of each source after \a fromSource.
+ */
+void CombinedAnalysisListModel::updateOffsets(int fromSource)
+{
+  for (int source = fromSource; source < s_sourceCount; ++source)
+    m_offsets[source + 1] = m_offsets.at(source) + m_sourceCounts.at(source);
+}
+
+/*!
+  \internal
+ */
+void CombinedAnalysisListModel::resetSource(int source)
+{
+  beginResetModel();
+  m_sourceCounts[source] = m_sources.at(source)->rowCount();
+  updateOffsets(source);
+  endResetModel();
+}
+
+/*!
+  \internal
+
+  Returns the \l CombinedAnalysisRoles matching \a sourceRoles of the model for \a source.
+  An empty list, meaning every role, is returned unchanged.
+ */
+QVector<int> CombinedAnalysisListModel::combinedRoles(int source, const QVector<int>& sourceRoles) const
+{
+  QVector<int> roles;
+  for (int sourceRole : sourceRoles)
+  {
+    if (source == s_viewshedSource)
+    {
+      if (sourceRole == ViewshedListModel::ViewshedRoles::ViewshedNameRole)
+        roles.append(AnalysisNameRole);
+      else if (sourceRole == ViewshedListModel::ViewshedRoles::ViewshedVisibleRole)
+        roles.append(AnalysisVisibleRole);
+    }
+    else if (sourceRole == AnalysisListModel::AnalysisRoles::AnalysisVisibleRole)
+    {
+      roles.append(AnalysisVisibleRole);
+    }
+  }
+
+  return roles;
+}
+
+/*!
+  \internal
+
+  Returns the source containing the combined \a row, or \c -1.
+ */
+int CombinedAnalysisListModel::sourceAt(int row) const
+{
+  if (row < 0)
+    return -1;
+
+  for (int source = 0; source < s_sourceCount; ++source)
+  {
+    if (row < m_offsets.at(source + 1))
+      return source;
+  }
+
+  return -1;
 }
 
 /*!
@@ -314,7 +474,7 @@ void CombinedAnalysisListModel::connectAnalysisListModelSignals(QAbstractItemMod
  */
 int CombinedAnalysisListModel::viewshedCount() const
 {
-  return m_viewshedModel == nullptr ? 0 : m_viewshedModel->rowCount();
+  return m_sourceCounts.at(s_viewshedSource);
 }
 
 /*!
@@ -322,7 +482,7 @@ int CombinedAnalysisListModel::viewshedCount() const
  */
 int CombinedAnalysisListModel::lineOfSightCount() const
 {
-  return m_lineOfSightModel == nullptr ? 0 : m_lineOfSightModel->rowCount();
+  return m_sourceCounts.at(s_lineOfSightSource);
 }
 
 /*!
@@ -331,7 +491,7 @@ int CombinedAnalysisListModel::lineOfSightCount() const
 bool CombinedAnalysisListModel::isViewshed(int row) const
 {
   // determine whether the supplied row is within the range of the viewshed model
-  return row < viewshedCount() && m_viewshedModel;
+  return m_viewshedModel && sourceAt(row) == s_viewshedSource;
 }
 
 /*!
@@ -340,7 +500,7 @@ bool CombinedAnalysisListModel::isViewshed(int row) const
 bool CombinedAnalysisListModel::isLineOfSight(int row) const
 {
   // determine whether the supplied row is within the range of the line of sight model
-  return row < (lineOfSightCount() + viewshedCount()) && m_lineOfSightModel;
+  return m_lineOfSightModel && sourceAt(row) == s_lineOfSightSource;
 }
 
 /*!
@@ -348,7 +508,7 @@ bool CombinedAnalysisListModel::isLineOfSight(int row) const
  */
 int CombinedAnalysisListModel::viewshedIndex(int row) const
 {
-  return row;
+  return row - m_offsets.at(s_viewshedSource);
 }
 
 /*!
@@ -356,7 +516,7 @@ int CombinedAnalysisListModel::viewshedIndex(int row) const
  */
 int CombinedAnalysisListModel::lineOfSightIndex(int row) const
 {
-  return row - viewshedCount();
+  return row - m_offsets.at(s_lineOfSightSource);
 }
 
 } // Dsa
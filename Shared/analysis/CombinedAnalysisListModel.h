@@ -22,6 +22,7 @@
 
 // Qt headers
 #include <QAbstractListModel>
+#include <QVector>
 
 namespace Esri {
 namespace ArcGISRuntime {
@@ -64,11 +65,17 @@ public:
 protected:
   QHash<int, QByteArray> roleNames() const override;
 
-private slots:
-  void handleUnderlyingDataChanged();
-
 private:
-  void connectAnalysisListModelSignals(QAbstractItemModel* analysisList);
+  static constexpr int s_viewshedSource = 0;
+  static constexpr int s_lineOfSightSource = 1;
+  static constexpr int s_sourceCount = 2;
+
+  void setSourceModel(int source, QAbstractItemModel* model);
+  void connectSourceModel(int source);
+  void updateOffsets(int fromSource);
+  void resetSource(int source);
+  QVector<int> combinedRoles(int source, const QVector<int>& sourceRoles) const;
+  int sourceAt(int row) const;
   int viewshedCount() const;
   int lineOfSightCount() const;
   bool isViewshed(int row) const;
@@ -77,6 +84,9 @@ private:
   int lineOfSightIndex(int row) const;
 
   QHash<int, QByteArray> m_roles;
+  QVector<QAbstractItemModel*> m_sources = QVector<QAbstractItemModel*>(s_sourceCount, nullptr);
+  QVector<int> m_sourceCounts = QVector<int>(s_sourceCount, 0);
+  QVector<int> m_offsets = QVector<int>(s_sourceCount + 1, 0);
   ViewshedListModel* m_viewshedModel = nullptr;
   Esri::ArcGISRuntime::AnalysisListModel* m_lineOfSightModel = nullptr;
   QHash<Esri::ArcGISRuntime::Analysis*, int> m_lineOfSightIndices;
@@ -21,14 +21,21 @@
 #include "GeoElementViewshed360.h"
 
 #include "GeoElementUtils.h"
+#include "ViewshedPool.h"
 
 // C++ API headers
-#include "AnalysisOverlay.h"
 #include "AttributeListModel.h"
 #include "GeoElementViewshed.h"
+#include "Graphic.h"
+
+// Qt headers
+#include <QMetaMethod>
+#include <QTimer>
 
 // STL headers
+#include <algorithm>
 #include <cmath>
+#include <limits>
 
 using namespace Esri::ArcGISRuntime;
 
@@ -38,6 +45,7 @@ constexpr double c_defaultHorizontalAngle = 360.0;
 constexpr double c_defaultVerticalAngle = 90.0;
 constexpr double c_defaultMinDistance = 0.0;
 constexpr double c_defaultMaxDistance = 500.0;
+constexpr double c_metersPerDegree = 111320.0;
 
 /*!
   \class Dsa::GeoElementViewshed360
@@ -45,6 +53,16 @@ constexpr double c_defaultMaxDistance = 500.0;
   \inherits Viewshed360
   \brief A 360 degree viewshed centered upon a GeoElement.
 
+  The viewshed is not attached to the GeoElement itself, which may be updated many
+  times a second, but to a copy of it which follows the GeoElement at a limited rate.
+  The copy is only moved once the GeoElement has moved by \l movementThreshold or turned
+  by \l headingThreshold, and no more often than every \l minimumUpdateInterval
+  milliseconds.
+
+  When a move is due, \l refreshRequested is emitted so that the owner can spread the
+  refreshes of many viewsheds over several frames by calling \l refresh. If nothing
+  is connected to \l refreshRequested, the viewshed refreshes itself immediately.
+
   \sa Esri::ArcGISRuntime::GeoElement
   */
 
@@ -53,19 +71,27 @@ constexpr double c_defaultMaxDistance = 500.0;
 
   \list
     \li \a geoElement - The \l Esri::ArcGISRuntime::GeoElement which the viewshed will be centered upon.
-    \li \a analysisOverlay - The \l Esri::ArcGISRuntime::AnalysisOverlay which contains the viewshed.
+    \li \a pool - The \l ViewshedPool from which the viewshed and its observer are acquired.
     \li \a headingAttribute - the name of the heading attribute.
     \li \a pitchAttribute - the name of the pitch attribute.
     \li \a parent - An optional parent.
   \endlist
  */
-GeoElementViewshed360::GeoElementViewshed360(GeoElement* geoElement, AnalysisOverlay* analysisOverlay,
+GeoElementViewshed360::GeoElementViewshed360(GeoElement* geoElement, ViewshedPool* pool,
                                              const QString& headingAttribute, const QString& pitchAttribute, QObject* parent) :
-  Viewshed360(new GeoElementViewshed(geoElement, c_defaultHorizontalAngle, c_defaultVerticalAngle, c_defaultMinDistance, c_defaultMaxDistance, 0.0, 0.0, parent), analysisOverlay, parent),
+  Viewshed360(pool->acquireGeoElementViewshed(geoElement ? geoElement->geometry() : Geometry(), c_defaultHorizontalAngle,
+                                              c_defaultVerticalAngle, c_defaultMinDistance, c_defaultMaxDistance), pool, parent),
   m_geoElementSignaler(new GeoElementSignaler(geoElement, GeoElementUtils::toQObject(geoElement))),
+  m_observer(static_cast<Graphic*>(static_cast<GeoElementViewshed*>(viewshed())->geoElement())),
   m_headingAttribute(headingAttribute),
-  m_pitchAttribute(pitchAttribute)
+  m_pitchAttribute(pitchAttribute),
+  m_updateTimer(new QTimer(this))
 {
+  m_updateTimer->setSingleShot(true);
+  connect(m_updateTimer, &QTimer::timeout, this, &GeoElementViewshed360::requestRefresh);
+  connect(m_geoElementSignaler, &GeoElementSignaler::geometryChanged, this, &GeoElementViewshed360::handleGeometryChanged);
+
+  refresh();
 }
 
 /*!
@@ -126,6 +152,8 @@ void GeoElementViewshed360::setHeading(double heading)
       attributes->replaceAttribute(m_headingAttribute, heading);
     else
       attributes->insertAttribute(m_headingAttribute, heading);
+
+    refresh();
   }
 
   emit headingChanged();
@@ -174,6 +202,8 @@ void GeoElementViewshed360::setPitch(double pitch)
       attributes->replaceAttribute(m_pitchAttribute, pitch);
     else
       attributes->insertAttribute(m_pitchAttribute, pitch);
+
+    refresh();
   }
 
   emit pitchChanged();
@@ -246,4 +276,189 @@ QString GeoElementViewshed360::pitchAttribute() const
   return m_pitchAttribute;
 }
 
+/*!
+  \brief Returns the minimum time in milliseconds between refreshes of the viewshed.
+ */
+int GeoElementViewshed360::minimumUpdateInterval() const
+{
+  return m_minimumUpdateInterval;
+}
+
+/*!
+  \brief Sets the minimum time between refreshes of the viewshed to \a milliseconds.
+
+  A value of \c 0 refreshes the viewshed as soon as the thresholds are exceeded.
+ */
+void GeoElementViewshed360::setMinimumUpdateInterval(int milliseconds)
+{
+  m_minimumUpdateInterval = std::max(0, milliseconds);
+}
+
+/*!
+  \brief Returns the distance in meters the GeoElement must move before the viewshed is refreshed.
+ */
+double GeoElementViewshed360::movementThreshold() const
+{
+  return m_movementThreshold;
+}
+
+/*!
+  \brief Sets the distance the GeoElement must move before the viewshed is refreshed to \a meters.
+ */
+void GeoElementViewshed360::setMovementThreshold(double meters)
+{
+  m_movementThreshold = std::max(0.0, meters);
+}
+
+/*!
+  \brief Returns the change in degrees of heading or pitch before the viewshed is refreshed.
+
+  This only applies when heading or pitch are read from attributes of the GeoElement.
+ */
+double GeoElementViewshed360::headingThreshold() const
+{
+  return m_headingThreshold;
+}
+
+/*!
+  \brief Sets the change in heading or pitch before the viewshed is refreshed to \a degrees.
+ */
+void GeoElementViewshed360::setHeadingThreshold(double degrees)
+{
+  m_headingThreshold = std::max(0.0, degrees);
+}
+
+/*!
+  \brief Returns whether the GeoElement has moved since the viewshed was last refreshed.
+ */
+bool GeoElementViewshed360::isRefreshPending() const
+{
+  return m_refreshPending;
+}
+
+/*!
+  \brief Moves the viewshed to the current position and orientation of the GeoElement.
+ */
+void GeoElementViewshed360::refresh()
+{
+  m_refreshPending = false;
+  m_refreshRequested = false;
+  m_updateTimer->stop();
+  m_lastRefresh.start();
+
+  GeoElement* trackedElement = geoElement();
+  if (!trackedElement || !m_observer)
+    return;
+
+  m_observer->setGeometry(trackedElement->geometry());
+
+  // without a renderer, the observer's orientation is applied through the offsets
+  auto geoElementViewshed = static_cast<GeoElementViewshed*>(viewshed());
+  if (!m_headingAttribute.isEmpty())
+    geoElementViewshed->setHeadingOffset(attributeValue(m_headingAttribute));
+
+  if (!m_pitchAttribute.isEmpty())
+    geoElementViewshed->setPitchOffset(attributeValue(m_pitchAttribute));
+}
+
+/*!
+  \internal
+
+  Returns the approximate distance in meters between the centers of \a from and \a to.
+ */
+double GeoElementViewshed360::distance(const Geometry& from, const Geometry& to)
+{
+  if (from.isEmpty() || to.isEmpty())
+    return std::numeric_limits<double>::infinity();
+
+  const Point fromCenter = from.extent().center();
+  const Point toCenter = to.extent().center();
+  double dx = toCenter.x() - fromCenter.x();
+  double dy = toCenter.y() - fromCenter.y();
+  if (toCenter.spatialReference().isGeographic())
+  {
+    dx *= c_metersPerDegree * std::cos(toCenter.y() * M_PI / 180.0);
+    dy *= c_metersPerDegree;
+  }
+
+  const double dz = (toCenter.hasZ() && fromCenter.hasZ()) ? toCenter.z() - fromCenter.z() : 0.0;
+  return std::sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+/*!
+  \internal
+ */
+double GeoElementViewshed360::attributeValue(const QString& attribute) const
+{
+  if (m_geoElementSignaler.isNull())
+    return 0.0;
+
+  return m_geoElementSignaler->geoElement()->attributes()->attributeValue(attribute).toDouble();
+}
+
+/*!
+  \internal
+
+  Defers refreshing the viewshed until the GeoElement has moved or turned far enough
+  and the minimum update interval has elapsed.
+ */
+void GeoElementViewshed360::handleGeometryChanged()
+{
+  GeoElement* trackedElement = geoElement();
+  if (!trackedElement || !m_observer)
+    return;
+
+  if (!m_refreshPending)
+  {
+    auto geoElementViewshed = static_cast<GeoElementViewshed*>(viewshed());
+    const bool moved = distance(m_observer->geometry(), trackedElement->geometry()) >= m_movementThreshold;
+    const bool turned = (!m_headingAttribute.isEmpty() &&
+                         std::abs(std::remainder(attributeValue(m_headingAttribute) - geoElementViewshed->headingOffset(), 360.0)) >= m_headingThreshold) ||
+                        (!m_pitchAttribute.isEmpty() &&
+                         std::abs(attributeValue(m_pitchAttribute) - geoElementViewshed->pitchOffset()) >= m_headingThreshold);
+
+    if (!moved && !turned)
+      return;
+
+    m_refreshPending = true;
+  }
+
+  if (m_refreshRequested || m_updateTimer->isActive())
+    return;
+
+  const qint64 elapsed = m_lastRefresh.isValid() ? m_lastRefresh.elapsed() : std::numeric_limits<qint64>::max();
+  if (elapsed >= m_minimumUpdateInterval)
+    requestRefresh();
+  else
+    m_updateTimer->start(static_cast<int>(m_minimumUpdateInterval - elapsed));
+}
+
+/*!
+  \internal
+
+  Asks the owner of the viewshed to refresh it, or refreshes it immediately if there is none.
+ */
+void GeoElementViewshed360::requestRefresh()
+{
+  if (!m_refreshPending || m_refreshRequested)
+    return;
+
+  if (!isSignalConnected(QMetaMethod::fromSignal(&GeoElementViewshed360::refreshRequested)))
+  {
+    refresh();
+    return;
+  }
+
+  m_refreshRequested = true;
+  emit refreshRequested();
+}
+
 } // Dsa
+
+// Signal Documentation
+/*!
+  \fn void GeoElementViewshed360::refreshRequested();
+  \brief Signal emitted when the GeoElement has moved far enough for the viewshed to be refreshed.
+
+  The viewshed is not moved until \l refresh is called.
+ */
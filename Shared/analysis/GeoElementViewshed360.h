@@ -20,9 +20,18 @@
 // dsa app headers
 #include "Viewshed360.h"
 
+// C++ API headers
+#include "Geometry.h"
+
+// Qt headers
+#include <QElapsedTimer>
+
+class QTimer;
+
 namespace Esri {
   namespace ArcGISRuntime {
     class GeoElement;
+    class Graphic;
   }
 }
 
@@ -34,7 +43,7 @@ class GeoElementViewshed360 : public Viewshed360
   Q_OBJECT
 
 public:
-  GeoElementViewshed360(Esri::ArcGISRuntime::GeoElement* geoElement, Esri::ArcGISRuntime::AnalysisOverlay* analysisOverlay,
+  GeoElementViewshed360(Esri::ArcGISRuntime::GeoElement* geoElement, ViewshedPool* pool,
                   const QString& headingAttribute, const QString& pitchAttribute, QObject* parent = nullptr);
   ~GeoElementViewshed360();
 
@@ -56,13 +65,43 @@ public:
   QString headingAttribute() const;
   QString pitchAttribute() const;
 
+  int minimumUpdateInterval() const;
+  void setMinimumUpdateInterval(int milliseconds);
+
+  double movementThreshold() const;
+  void setMovementThreshold(double meters);
+
+  double headingThreshold() const;
+  void setHeadingThreshold(double degrees);
+
+  bool isRefreshPending() const;
+  void refresh();
+
+signals:
+  void refreshRequested();
+
 private:
   Q_DISABLE_COPY(GeoElementViewshed360)
   GeoElementViewshed360() = delete;
 
+  static double distance(const Esri::ArcGISRuntime::Geometry& from, const Esri::ArcGISRuntime::Geometry& to);
+
+  double attributeValue(const QString& attribute) const;
+  void handleGeometryChanged();
+  void requestRefresh();
+
   QPointer<GeoElementSignaler> m_geoElementSignaler;
+  QPointer<Esri::ArcGISRuntime::Graphic> m_observer;
   QString m_headingAttribute;
   QString m_pitchAttribute;
+
+  int m_minimumUpdateInterval = 200;
+  double m_movementThreshold = 1.0;
+  double m_headingThreshold = 2.0;
+  QTimer* m_updateTimer = nullptr;
+  QElapsedTimer m_lastRefresh;
+  bool m_refreshPending = false;
+  bool m_refreshRequested = false;
 };
 
 } // Dsa
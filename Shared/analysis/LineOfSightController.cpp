@@ -21,7 +21,10 @@
 #include "LineOfSightController.h"
 
 // dsa app headers
-#include "FeatureQueryResultManager.h"
+#include "AllocationCounter.h"
+#include "FeatureGeometryCache.h"
+#include "GeoElementUtils.h"
+#include "GeodesicKernels.h"
 #include "LocationController.h"
 #include "LocationDisplay3d.h"
 
@@ -35,12 +38,19 @@
 #include "GeoElementLineOfSight.h"
 #include "GeoView.h"
 #include "GeometryEngine.h"
+#include "Graphic.h"
 #include "LayerListModel.h"
 #include "SceneView.h"
 
 // Qt headers
 #include <QStringListModel>
 
+// STL headers
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
 using namespace Esri::ArcGISRuntime;
 
 namespace Dsa {
@@ -57,8 +67,31 @@ namespace Dsa {
     \li From the objects in a feature layer to the current position.
     \li From the current position to a supplied GeoElement.
   \endlist
+
+  A layer with more than 16 features is analysed in a budgeted mode. Only the
+  16 features nearest to the current position, within 5 km, are used as observers.
+  The analyses are recycled for the new nearest features as the position moves.
  */
 
+namespace
+{
+// an approximate squared distance in meters between two WGS84 points, for ranking
+double squaredDistance(const Point& from, const Point& to)
+{
+  const double dx = (to.x() - from.x()) * std::cos(from.y() * M_PI / 180.0) * Geodesic::s_metersPerDegree;
+  const double dy = (to.y() - from.y()) * Geodesic::s_metersPerDegree;
+  return dx * dx + dy * dy;
+}
+
+Point toWgs84(const Geometry& geometry)
+{
+  if (geometry.spatialReference() == SpatialReference::wgs84())
+    return geometry_cast<Point>(geometry);
+
+  return geometry_cast<Point>(GeometryEngine::project(geometry, SpatialReference::wgs84()));
+}
+}
+
 /*!
   \internal
  */
@@ -81,6 +114,9 @@ int LineOfSightController::visibleByCount() const
 
 /*!
   \internal
+
+  Many analyses can change visibility in the same frame, so \l visibleByCountChanged
+  is emitted at most once per frame.
  */
 void LineOfSightController::setVisibleByCount(int visibleByCount)
 {
@@ -88,6 +124,21 @@ void LineOfSightController::setVisibleByCount(int visibleByCount)
     return;
 
   m_visibleByCount = visibleByCount;
+  if (!m_visibleByTimer.isActive())
+    m_visibleByTimer.start();
+}
+
+/*!
+  \internal
+
+  Emits \l visibleByCountChanged if the count has changed since it was last emitted.
+ */
+void LineOfSightController::notifyVisibleByCount()
+{
+  if (m_notifiedVisibleByCount == m_visibleByCount)
+    return;
+
+  m_notifiedVisibleByCount = m_visibleByCount;
   emit visibleByCountChanged();
 }
 
@@ -99,8 +150,13 @@ LineOfSightController::LineOfSightController(QObject* parent):
   m_overlayNames(new QStringListModel(this)),
   m_lineOfSightOverlay(new AnalysisOverlay(this))
 {
+  m_visibleByTimer.setSingleShot(true);
+  m_visibleByTimer.setInterval(s_visibleByInterval);
+  connect(&m_visibleByTimer, &QTimer::timeout, this, &LineOfSightController::notifyVisibleByCount);
+
   // connect to ToolResourceProvider signals
   auto resourecProvider = ToolResourceProvider::instance();
+  connect(resourecProvider, &ToolResourceProvider::locationChanged, this, &LineOfSightController::handleLocationChanged);
   connect(resourecProvider, &ToolResourceProvider::geoViewChanged, this, [this]()
   {
     onGeoViewChanged(ToolResourceProvider::instance()->geoView());
@@ -265,22 +321,13 @@ void LineOfSightController::onOperationalLayersChanged()
 }
 
 /*!
-  \brief Handle the set of features in \a featureQueryResult returned by task \a taskId.
+  \brief Handle the \a geometries of all of the features within the selected overlay.
 
-  This query is the set of all features within the selected overlay. The returned features will
-  be used as the targets for Line of Sight analysis.
+  A graphic at each geometry will be used as the observer for Line of Sight analysis.
  */
-void LineOfSightController::onQueryFeaturesCompleted(QUuid taskId, FeatureQueryResult* featureQueryResult)
+void LineOfSightController::handleFeatureGeometries(const QList<Geometry>& geometries)
 {
-  // if the task ID does not match, ignore this result
-  if (taskId != m_featuresTask.taskId())
-    return;
-
-  // reset query/task tracking
-  disconnect(m_queryFeaturesConnection);
-  m_featuresTask = TaskWatcher();
-
-  FeatureQueryResultManager resultsMgr(featureQueryResult);
+  DSA_ALLOCATION_SCOPE(Analysis);
 
   if (!m_locationGeoElement)
     getLocationGeoElement();
@@ -295,6 +342,7 @@ void LineOfSightController::onQueryFeaturesCompleted(QUuid taskId, FeatureQueryR
     disconnect(conn);
 
   m_visibleByConnections.clear();
+  m_targetVisible.clear();
   setVisibleByCount(0);
 
   // clear the QObject used as a parent for Line of Sight results
@@ -305,63 +353,157 @@ void LineOfSightController::onQueryFeaturesCompleted(QUuid taskId, FeatureQueryR
   }
   m_lineOfSightParent = new QObject(this);
 
-  // create a local QObject to as as the parent for returned features
-  // These are only required within the scope of this method
-  QObject localParent;
+  m_observerLocations.clear();
+  m_budgetAnalyses.clear();
+  m_budgetObservers.clear();
+  m_idleAnalyses.clear();
+  m_budgetLocation = Point();
 
-  // For each feature, obtain a point location and use it as the observer for a new
+  // too many features to analyse at once: recycle a fixed number of analyses for the nearest features
+  if (geometries.size() > s_maximumObservers)
+  {
+    m_observerLocations.reserve(geometries.size());
+    for (const Geometry& geometry : geometries)
+    {
+      if (!geometry.isEmpty())
+        m_observerLocations.append(toWgs84(geometry));
+    }
+
+    for (int i = 0; i < s_maximumObservers; ++i)
+    {
+      Graphic* observer = new Graphic(m_lineOfSightParent);
+      GeoElementLineOfSight* lineOfSight = addObserverLineOfSight(observer);
+      m_budgetAnalyses.append(lineOfSight);
+      m_budgetObservers.append(observer);
+      m_idleAnalyses.insert(lineOfSight);
+      lineOfSight->setVisible(false);
+    }
+
+    updateNearestObservers(toWgs84(m_locationGeoElement->geometry()));
+    return;
+  }
+
+  // For each feature, use a graphic at its point location as the observer for a new
   // GeoElementLineOfSight which will be added to the overlay.
-  QList<Feature*> features = resultsMgr.m_results->iterator().features(&localParent);
-  auto it = features.constBegin();
-  auto itEnd = features.constEnd();
+  auto it = geometries.constBegin();
+  auto itEnd = geometries.constEnd();
   for (; it != itEnd; ++it)
   {
-    Feature* feat = *it;
-    if (feat == nullptr)
+    if (it->isEmpty())
       continue;
 
-    // create a Line of sight from the feature to the current location
-    GeoElementLineOfSight * lineOfSight = new GeoElementLineOfSight(feat, m_locationGeoElement, m_lineOfSightParent);
-    lineOfSight->setVisible(m_analysisVisible);
-    m_lineOfSightOverlay->analyses()->append(lineOfSight);
+    addObserverLineOfSight(new Graphic(*it, m_lineOfSightParent));
+  }
+}
 
-    m_visibleByConnections.append(connect(lineOfSight, &GeoElementLineOfSight::targetVisibilityChanged, this, [this]()
-    {
-      int visibleCount = 0;
-      AnalysisListModel* losList = m_lineOfSightOverlay->analyses();
-      const int count = losList->rowCount();
-      for (int i = 0; i < count; ++i)
-      {
-        Analysis* analysis = losList->at(i);
-        if (!analysis)
-          continue;
+/*!
+  \internal
 
-        GeoElementLineOfSight* lineOfSight = qobject_cast<GeoElementLineOfSight*>(analysis);
-        if (!lineOfSight)
-          continue;
+  Creates a Line of sight from \a observer to the current location and adds it to the overlay.
+ */
+GeoElementLineOfSight* LineOfSightController::addObserverLineOfSight(Graphic* observer)
+{
+  GeoElementLineOfSight* lineOfSight = new GeoElementLineOfSight(observer, m_locationGeoElement, m_lineOfSightParent);
+  lineOfSight->setVisible(m_analysisVisible);
+  m_lineOfSightOverlay->analyses()->append(lineOfSight);
 
-        // don't count Line of Sight from the current location
-        if (lineOfSight->observerGeoElement() == m_locationGeoElement)
-          continue;
+  m_visibleByConnections.append(connect(lineOfSight, &GeoElementLineOfSight::targetVisibilityChanged, this, [this, lineOfSight]()
+  {
+    updateVisibleBy(lineOfSight);
+  }));
 
-        if (lineOfSight->targetVisibility() == LineOfSightTargetVisibility::Visible)
-          visibleCount += 1;
-      }
+  return lineOfSight;
+}
 
-      setVisibleByCount(visibleCount);
-    }));
+/*!
+  \internal
+
+  Recycles the budgeted analyses once the current \a location has moved far
+  enough that the nearest features may have changed.
+ */
+void LineOfSightController::handleLocationChanged(const Point& location)
+{
+  if (m_budgetAnalyses.isEmpty() || location.isEmpty())
+    return;
+
+  const Point wgs84 = toWgs84(location);
+  if (!m_budgetLocation.isEmpty() && squaredDistance(m_budgetLocation, wgs84) < s_recycleDistance * s_recycleDistance)
+    return;
+
+  updateNearestObservers(wgs84);
+}
+
+/*!
+  \internal
+
+  Moves the observers of the budgeted analyses to the features nearest to
+  \a location, within the maximum range. Analyses which are not needed are hidden.
+ */
+void LineOfSightController::updateNearestObservers(const Point& location)
+{
+  DSA_ALLOCATION_SCOPE(Analysis);
+
+  m_budgetLocation = location;
+  if (location.isEmpty())
+    return;
+
+  std::vector<std::pair<double, int>> candidates;
+  candidates.reserve(m_observerLocations.size());
+  const double maximumDistance = s_maximumRange * s_maximumRange;
+  for (int i = 0; i < m_observerLocations.size(); ++i)
+  {
+    const double distance = squaredDistance(location, m_observerLocations.at(i));
+    if (distance <= maximumDistance)
+      candidates.emplace_back(distance, i);
+  }
+
+  const int nearestCount = std::min(static_cast<int>(candidates.size()), static_cast<int>(m_budgetAnalyses.size()));
+  std::partial_sort(candidates.begin(), candidates.begin() + nearestCount, candidates.end());
+
+  for (int i = 0; i < m_budgetAnalyses.size(); ++i)
+  {
+    GeoElementLineOfSight* lineOfSight = m_budgetAnalyses.at(i);
+    if (i < nearestCount)
+    {
+      m_budgetObservers.at(i)->setGeometry(m_observerLocations.at(candidates[i].second));
+      m_idleAnalyses.remove(lineOfSight);
+      lineOfSight->setVisible(m_analysisVisible);
+    }
+    else
+    {
+      m_idleAnalyses.insert(lineOfSight);
+      lineOfSight->setVisible(false);
+    }
+
+    updateVisibleBy(lineOfSight);
   }
 }
 
+/*!
+  \internal
+
+  Updates the \l visibleByCount for a change to the target visibility of \a lineOfSight.
+ */
+void LineOfSightController::updateVisibleBy(GeoElementLineOfSight* lineOfSight)
+{
+  const bool targetVisible = !m_idleAnalyses.contains(lineOfSight) &&
+                             lineOfSight->targetVisibility() == LineOfSightTargetVisibility::Visible;
+  if (m_targetVisible.value(lineOfSight, false) == targetVisible)
+    return;
+
+  m_targetVisible.insert(lineOfSight, targetVisible);
+  setVisibleByCount(m_visibleByCount + (targetVisible ? 1 : -1));
+}
+
 /*!
   \brief Internal.
 
-  Cancel the current feature query task.
+  Ignore the result of the current feature request. The query itself may be
+  shared with other tools, so it is not cancelled.
  */
 void LineOfSightController::cancelTask()
 {
-  m_featuresTask.cancel();
-  disconnect(m_queryFeaturesConnection);
+  ++m_featuresRequest;
 }
 
 /*!
@@ -392,10 +534,28 @@ void LineOfSightController::lineOfSightFromLocationToGeoElement(GeoElement* geoE
     return;
   }
 
+  // the parent is deleted when the analysis is cleared
+  if (!m_lineOfSightParent)
+    m_lineOfSightParent = new QObject(this);
+
   // create a Line of sight from the feature to the current location
   GeoElementLineOfSight* lineOfSight = new GeoElementLineOfSight(m_locationGeoElement, geoElement, m_lineOfSightParent);
   lineOfSight->setVisible(true);
   m_lineOfSightOverlay->analyses()->append(lineOfSight);
+
+  // message feeds delete the graphics which leave them, so drop the line of sight with its target
+  if (QObject* target = GeoElementUtils::toQObject(geoElement))
+  {
+    connect(target, &QObject::destroyed, lineOfSight, [this, lineOfSight]()
+    {
+      AnalysisListModel* analyses = m_lineOfSightOverlay->analyses();
+      const int index = analyses->indexOf(lineOfSight);
+      if (index != -1)
+        analyses->removeAt(index);
+
+      lineOfSight->deleteLater();
+    });
+  }
 }
 
 /*!
@@ -433,7 +593,8 @@ void LineOfSightController::setAnalysisVisible(bool analysisVisible)
     if (!lineOfSight)
       continue;
 
-    lineOfSight->setVisible(m_analysisVisible);
+    // unused budgeted analyses stay hidden
+    lineOfSight->setVisible(m_analysisVisible && !m_idleAnalyses.contains(lineOfSight));
   }
 
   emit analysisVisibleChanged();
@@ -457,9 +618,8 @@ QAbstractItemModel* LineOfSightController::overlayNames() const
  */
 bool LineOfSightController::selectOverlayIndex(int selectOverlayIndex)
 {
-  // cancel any query tasks which are currently running
-  if (m_featuresTask.isValid() && !m_featuresTask.isCanceled() && !m_featuresTask.isDone())
-    cancelTask();
+  // ignore any feature requests which are still outstanding
+  cancelTask();
 
   // clear the results of any existing analysis
   clearAnalysis();
@@ -475,22 +635,16 @@ bool LineOfSightController::selectOverlayIndex(int selectOverlayIndex)
     return false;
   }
 
-  constexpr int maxFeatures = 16; // Due to performance reasons, limit the number of features which can be used in the analysis
-  const int featuresCount = overlay->featureTable()->numberOfFeatures();
-  if (featuresCount > maxFeatures)
+  // retrieve the geometry of all the features from the selected overlay. These will be the observers for Line of sight analysis.
+  const int request = ++m_featuresRequest;
+  FeatureGeometryCache::instance()->requestGeometries(overlay->featureTable(), this, [this, request](const QList<Geometry>& geometries)
   {
-    emit toolErrorOccurred(QString("There are too many points in this layer (%1).\n Please choose another one with %2 or fewer points.")
-                           .arg(QString::number(featuresCount), QString::number(maxFeatures)),
-                           QStringLiteral("For performance reasons, Line of Sight analysis is limited to a maximum number of features"));
-    return false;
-  }
+    // the request has been superseded or cancelled
+    if (request != m_featuresRequest)
+      return;
 
-  // perform a query to retrieve all the features from the selected overlay. These will be the target features for Line of sight analysis.
-  QueryParameters query;
-  query.setWhereClause(QStringLiteral("1=1"));
-  query.setReturnGeometry(true);
-  m_queryFeaturesConnection = connect(overlay->featureTable(), &FeatureTable::queryFeaturesCompleted, this, &LineOfSightController::onQueryFeaturesCompleted);
-  m_featuresTask = overlay->featureTable()->queryFeatures(query);
+    handleFeatureGeometries(geometries);
+  });
 
   return true;
 }
@@ -507,8 +661,15 @@ void LineOfSightController::clearAnalysis()
     disconnect(conn);
 
   m_visibleByConnections.clear();
+  m_targetVisible.clear();
   setVisibleByCount(0);
 
+  m_observerLocations.clear();
+  m_budgetAnalyses.clear();
+  m_budgetObservers.clear();
+  m_idleAnalyses.clear();
+  m_budgetLocation = Point();
+
   // delete the QObject used as the parent for the analysis
   if (m_lineOfSightParent)
   {
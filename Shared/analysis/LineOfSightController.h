@@ -22,10 +22,12 @@
 
 // C++ API headers
 #include "Point.h"
-#include "TaskWatcher.h"
 
 // Qt headers
 #include <QAbstractItemModel>
+#include <QHash>
+#include <QSet>
+#include <QTimer>
 
 namespace Esri {
 namespace ArcGISRuntime {
@@ -34,7 +36,9 @@ namespace ArcGISRuntime {
   class GeoView;
   class LayerListModel;
   class FeatureLayer;
-  class FeatureQueryResult;
+  class GeoElementLineOfSight;
+  class Geometry;
+  class Graphic;
 }
 }
 
@@ -82,10 +86,13 @@ public slots:
   void onGeoViewChanged(Esri::ArcGISRuntime::GeoView* geoView);
   void onOperationalLayersChanged();
 
-private slots:
-  void onQueryFeaturesCompleted(QUuid taskId, Esri::ArcGISRuntime::FeatureQueryResult* featureQueryResult);
-
 private:
+  void handleFeatureGeometries(const QList<Esri::ArcGISRuntime::Geometry>& geometries);
+  Esri::ArcGISRuntime::GeoElementLineOfSight* addObserverLineOfSight(Esri::ArcGISRuntime::Graphic* observer);
+  void handleLocationChanged(const Esri::ArcGISRuntime::Point& location);
+  void updateNearestObservers(const Esri::ArcGISRuntime::Point& location);
+  void updateVisibleBy(Esri::ArcGISRuntime::GeoElementLineOfSight* lineOfSight);
+  void notifyVisibleByCount();
   void cancelTask();
   void getLocationGeoElement();
   void setVisibleByCount(int visibleByCount);
@@ -95,12 +102,25 @@ private:
   QList<Esri::ArcGISRuntime::FeatureLayer*> m_overlays;
   Esri::ArcGISRuntime::AnalysisOverlay* m_lineOfSightOverlay = nullptr;
   QObject* m_lineOfSightParent = nullptr;
-  Esri::ArcGISRuntime::TaskWatcher m_featuresTask;
+  int m_featuresRequest = 0;
   Esri::ArcGISRuntime::GeoElement* m_locationGeoElement = nullptr;
-  QMetaObject::Connection m_queryFeaturesConnection;
   bool m_analysisVisible = true;
   int m_visibleByCount = 0;
+  int m_notifiedVisibleByCount = 0;
+  QTimer m_visibleByTimer;
   QList<QMetaObject::Connection> m_visibleByConnections;
+  QHash<Esri::ArcGISRuntime::GeoElementLineOfSight*, bool> m_targetVisible;
+
+  static constexpr int s_visibleByInterval = 16;
+  static constexpr int s_maximumObservers = 16;
+  static constexpr double s_maximumRange = 5000.0;
+  static constexpr double s_recycleDistance = 25.0;
+
+  QList<Esri::ArcGISRuntime::Point> m_observerLocations;
+  QList<Esri::ArcGISRuntime::GeoElementLineOfSight*> m_budgetAnalyses;
+  QList<Esri::ArcGISRuntime::Graphic*> m_budgetObservers;
+  QSet<Esri::ArcGISRuntime::GeoElementLineOfSight*> m_idleAnalyses;
+  Esri::ArcGISRuntime::Point m_budgetLocation;
 };
 
 } // Dsa
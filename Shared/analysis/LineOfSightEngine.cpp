@@ -0,0 +1,546 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "LineOfSightEngine.h"
+
+// dsa app headers
+#include "GeodesicKernels.h"
+
+// C++ API headers
+#include "ElevationSourceListModel.h"
+#include "GeometryEngine.h"
+#include "Surface.h"
+
+// Qt headers
+#include <QAtomicInt>
+#include <QThread>
+#include <QThreadPool>
+
+// STL headers
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+namespace
+{
+// the earth's radius, enlarged to allow for the usual atmospheric refraction coefficient of 0.13
+constexpr double s_effectiveEarthRadius = 6371008.8 / (1.0 - 0.13);
+
+// the number of samples taken along a ray in one pass of the batch kernels
+constexpr int s_samplesPerPass = 64;
+
+// the maximum number of samples taken along a ray
+constexpr int s_maximumSamples = 1024;
+
+double metersPerDegreeLongitude(double latitude)
+{
+  return Geodesic::s_metersPerDegree * std::max(std::cos(latitude * M_PI / 180.0), 0.01);
+}
+
+Point toWgs84(const Point& location)
+{
+  if (location.isEmpty() || location.spatialReference() == SpatialReference::wgs84())
+    return location;
+
+  return geometry_cast<Point>(GeometryEngine::project(location, SpatialReference::wgs84()));
+}
+
+// writes the bilinearly interpolated height of the posts at each of the count grid
+// locations in xs and ys into heights. The locations are clamped to the grid, so the
+// loop body has no branches and can be vectorized by the compiler
+void sampleHeights(const float* posts, int columns, int rows,
+                   const double* xs, const double* ys, int count, double* heights)
+{
+  const double maxX = columns - 1.000001;
+  const double maxY = rows - 1.000001;
+  for (int i = 0; i < count; ++i)
+  {
+    const double x = std::min(std::max(xs[i], 0.0), maxX);
+    const double y = std::min(std::max(ys[i], 0.0), maxY);
+    const int x0 = static_cast<int>(x);
+    const int y0 = static_cast<int>(y);
+    const double fx = x - x0;
+    const double fy = y - y0;
+    const int index = y0 * columns + x0;
+
+    const double south = posts[index] * (1.0 - fx) + posts[index + 1] * fx;
+    const double north = posts[index + columns] * (1.0 - fx) + posts[index + columns + 1] * fx;
+    heights[i] = south * (1.0 - fy) + north * fy;
+  }
+}
+
+// returns the largest height of the terrain above the line of sight for count samples
+// at the fractions ts of the ray, allowing for the curvature of the earth
+double maximumExcess(const double* heights, const double* ts, int count,
+                     double observerHeight, double targetHeight, double distanceSquared)
+{
+  const double bulgeScale = distanceSquared / (2.0 * s_effectiveEarthRadius);
+  double excess = -std::numeric_limits<double>::infinity();
+  for (int i = 0; i < count; ++i)
+  {
+    const double sight = observerHeight + (targetHeight - observerHeight) * ts[i];
+    const double bulge = ts[i] * (1.0 - ts[i]) * bulgeScale;
+    excess = std::max(excess, heights[i] + bulge - sight);
+  }
+
+  return excess;
+}
+}
+
+/*!
+  \class Dsa::LineOfSightEngine
+  \inmodule Dsa
+  \inherits QObject
+  \brief Computes whether each of a batch of targets can be seen from its observer,
+  without rendering the analysis in a scene.
+
+  Unlike \l Esri::ArcGISRuntime::GeoElementLineOfSight, the results do not depend on
+  the pairs being rendered or visible, so they are available for observers which are
+  off-screen and for thousands of pairs at once.
+
+  The elevation of a grid of posts covering every pair in a batch is sampled from an
+  \l Esri::ArcGISRuntime::Surface, such as the scene's base surface with the elevation
+  sources added by \l AddLocalDataController. The posts are spaced 30 meters apart,
+  or further apart for batches which cover a large area, and the grid is kept for
+  later batches which it covers until the elevation sources change.
+
+  Each ray is then marched from the observer to its target on a pool of worker threads.
+  The terrain is sampled along the ray in fixed size passes which interpolate the posts
+  and compare them against the line of sight with branch-free loops, so that the
+  compiler can vectorize them. The target is hidden if the terrain, raised for the
+  curvature of the earth and atmospheric refraction, rises above the line of sight.
+
+  \sa ViewshedRasterCache
+ */
+
+/*!
+  \brief Constructor taking an optional \a parent.
+ */
+LineOfSightEngine::LineOfSightEngine(QObject* parent):
+  QObject(parent),
+  m_threadPool(new QThreadPool(this))
+{
+  m_threadPool->setMaxThreadCount(std::max(1, QThread::idealThreadCount()));
+}
+
+/*!
+  \brief Destructor.
+ */
+LineOfSightEngine::~LineOfSightEngine()
+{
+  for (const QMetaObject::Connection& connection : qAsConst(m_surfaceConnections))
+    disconnect(connection);
+
+  // no result may be handed back once the engine has gone
+  m_threadPool->clear();
+  m_threadPool->waitForDone();
+}
+
+/*!
+  \brief Computes whether the target of each of the \a pairs can be seen from its
+  observer, using the elevation of \a surface.
+
+  Returns the id of the request, which is passed to \l visibilityComputed along with
+  one result for each of the \a pairs, in the same order. Pairs with an empty observer
+  or target are not visible. Requests are answered in the order in which they are made.
+
+  Returns a null id if \a surface is \c nullptr.
+ */
+QUuid LineOfSightEngine::computeVisibility(Surface* surface, const QList<Pair>& pairs)
+{
+  if (!surface)
+    return QUuid();
+
+  Request request;
+  request.m_id = QUuid::createUuid();
+  request.m_surface = surface;
+  request.m_rays.reserve(pairs.size());
+  request.m_xMin = std::numeric_limits<double>::max();
+  request.m_yMin = std::numeric_limits<double>::max();
+  request.m_xMax = std::numeric_limits<double>::lowest();
+  request.m_yMax = std::numeric_limits<double>::lowest();
+
+  for (const Pair& pair : pairs)
+  {
+    Ray ray;
+    const Point observer = toWgs84(pair.m_observer);
+    const Point target = toWgs84(pair.m_target);
+    if (!observer.isEmpty() && !target.isEmpty())
+    {
+      ray.m_observerX = observer.x();
+      ray.m_observerY = observer.y();
+      ray.m_targetX = target.x();
+      ray.m_targetY = target.y();
+      ray.m_observerOffset = pair.m_observerOffset;
+      ray.m_targetOffset = pair.m_targetOffset;
+      ray.m_valid = true;
+
+      request.m_xMin = std::min({request.m_xMin, ray.m_observerX, ray.m_targetX});
+      request.m_yMin = std::min({request.m_yMin, ray.m_observerY, ray.m_targetY});
+      request.m_xMax = std::max({request.m_xMax, ray.m_observerX, ray.m_targetX});
+      request.m_yMax = std::max({request.m_yMax, ray.m_observerY, ray.m_targetY});
+    }
+
+    request.m_rays.append(ray);
+  }
+
+  m_pendingRequests.append(request);
+
+  if (!m_sampling)
+    startNextRequest();
+
+  return request.m_id;
+}
+
+/*!
+  \brief Stops computing any requests which have not yet been answered.
+
+  \l visibilityComputed is not emitted for them.
+ */
+void LineOfSightEngine::cancel()
+{
+  // results which are still being computed are discarded when they arrive
+  ++m_generation;
+
+  m_pendingRequests.clear();
+  m_currentRequest = Request();
+  m_sampleTasks.clear();
+  m_sampling = false;
+  m_runningCount = 0;
+}
+
+/*!
+  \brief Stops computing any requests and discards the sampled elevation grid.
+ */
+void LineOfSightEngine::clear()
+{
+  cancel();
+  m_grid.reset();
+}
+
+/*!
+  \brief Returns whether any requests are still being computed.
+ */
+bool LineOfSightEngine::isComputing() const
+{
+  return m_sampling || !m_pendingRequests.isEmpty() || m_runningCount > 0;
+}
+
+/*!
+  \internal
+
+  Returns whether the grid covers the WGS84 extent from \a xMin, \a yMin to \a xMax, \a yMax.
+ */
+bool LineOfSightEngine::TerrainGrid::contains(double xMin, double yMin, double xMax, double yMax) const
+{
+  return xMin >= m_xMin && yMin >= m_yMin &&
+      xMax <= m_xMin + (m_columns - 1) * m_cellWidth &&
+      yMax <= m_yMin + (m_rows - 1) * m_cellHeight;
+}
+
+/*!
+  \internal
+
+  Returns whether the target of \a ray can be seen from its observer over the
+  terrain of \a grid.
+
+  This only uses its arguments, so it can be run on a worker thread.
+ */
+bool LineOfSightEngine::isVisible(const TerrainGrid& grid, const Ray& ray)
+{
+  const double latitude = (ray.m_observerY + ray.m_targetY) / 2.0;
+  const double east = (ray.m_targetX - ray.m_observerX) * metersPerDegreeLongitude(latitude);
+  const double north = (ray.m_targetY - ray.m_observerY) * Geodesic::s_metersPerDegree;
+  const double distanceSquared = east * east + north * north;
+
+  // the ray in grid units
+  const double startX = (ray.m_observerX - grid.m_xMin) / grid.m_cellWidth;
+  const double startY = (ray.m_observerY - grid.m_yMin) / grid.m_cellHeight;
+  const double endX = (ray.m_targetX - grid.m_xMin) / grid.m_cellWidth;
+  const double endY = (ray.m_targetY - grid.m_yMin) / grid.m_cellHeight;
+
+  const float* posts = grid.m_posts.constData();
+  double endHeights[2];
+  const double endXs[2] = {startX, endX};
+  const double endYs[2] = {startY, endY};
+  sampleHeights(posts, grid.m_columns, grid.m_rows, endXs, endYs, 2, endHeights);
+  const double observerHeight = endHeights[0] + ray.m_observerOffset;
+  const double targetHeight = endHeights[1] + ray.m_targetOffset;
+
+  // sample at least twice per cell crossed so that no post is stepped over
+  const double cellsCrossed = std::max(std::abs(endX - startX), std::abs(endY - startY));
+  const int sampleCount = std::min(s_maximumSamples, std::max(2, static_cast<int>(std::ceil(cellsCrossed * 2.0))));
+
+  double xs[s_samplesPerPass];
+  double ys[s_samplesPerPass];
+  double ts[s_samplesPerPass];
+  double heights[s_samplesPerPass];
+  for (int first = 1; first < sampleCount; first += s_samplesPerPass)
+  {
+    const int count = std::min(s_samplesPerPass, sampleCount - first);
+    for (int i = 0; i < count; ++i)
+    {
+      ts[i] = static_cast<double>(first + i) / sampleCount;
+      xs[i] = startX + (endX - startX) * ts[i];
+      ys[i] = startY + (endY - startY) * ts[i];
+    }
+
+    sampleHeights(posts, grid.m_columns, grid.m_rows, xs, ys, count, heights);
+
+    // stop at the first pass which finds an obstruction
+    if (maximumExcess(heights, ts, count, observerHeight, targetHeight, distanceSquared) > 0.0)
+      return false;
+  }
+
+  return true;
+}
+
+/*!
+  \internal
+
+  Samples elevation from \a surface and discards the grid when its elevation sources change.
+ */
+void LineOfSightEngine::setSurface(Surface* surface)
+{
+  if (surface == m_surface)
+    return;
+
+  for (const QMetaObject::Connection& connection : qAsConst(m_surfaceConnections))
+    disconnect(connection);
+  m_surfaceConnections.clear();
+
+  m_surface = surface;
+  m_grid.reset();
+
+  if (!m_surface)
+    return;
+
+  m_surfaceConnections.append(connect(m_surface, &Surface::locationToElevationCompleted,
+                                      this, &LineOfSightEngine::handleElevation));
+
+  // posts sampled from the previous elevation sources are no longer valid
+  ElevationSourceListModel* elevationSources = m_surface->elevationSources();
+  if (!elevationSources)
+    return;
+
+  auto resetGrid = [this]() { m_grid.reset(); };
+  m_surfaceConnections.append(connect(elevationSources, &QAbstractItemModel::rowsInserted, this, resetGrid));
+  m_surfaceConnections.append(connect(elevationSources, &QAbstractItemModel::rowsRemoved, this, resetGrid));
+  m_surfaceConnections.append(connect(elevationSources, &QAbstractItemModel::modelReset, this, resetGrid));
+}
+
+/*!
+  \internal
+
+  Evaluates pending requests which are covered by the current grid, until one
+  needs a new grid to be sampled.
+ */
+void LineOfSightEngine::startNextRequest()
+{
+  while (!m_pendingRequests.isEmpty())
+  {
+    const Request request = m_pendingRequests.takeFirst();
+    setSurface(request.m_surface);
+
+    const bool hasRays = request.m_xMin <= request.m_xMax;
+    if (!m_surface || !hasRays ||
+        (m_grid && m_grid->contains(request.m_xMin, request.m_yMin, request.m_xMax, request.m_yMax)))
+    {
+      evaluate(request);
+      continue;
+    }
+
+    sampleGrid(request);
+    return;
+  }
+}
+
+/*!
+  \internal
+
+  Starts sampling a grid of posts which covers every ray of \a request.
+ */
+void LineOfSightEngine::sampleGrid(const Request& request)
+{
+  const double latitude = (request.m_yMin + request.m_yMax) / 2.0;
+  const double minimumCellWidth = s_postSpacing / metersPerDegreeLongitude(latitude);
+  const double minimumCellHeight = s_postSpacing / Geodesic::s_metersPerDegree;
+
+  // pad the grid by one post so that the ends of every ray lie inside it
+  const double xMin = request.m_xMin - minimumCellWidth;
+  const double yMin = request.m_yMin - minimumCellHeight;
+  const double width = request.m_xMax + minimumCellWidth - xMin;
+  const double height = request.m_yMax + minimumCellHeight - yMin;
+
+  TerrainGrid grid;
+  grid.m_xMin = xMin;
+  grid.m_yMin = yMin;
+  grid.m_cellWidth = std::max(minimumCellWidth, width / (s_maximumPostsPerSide - 1));
+  grid.m_cellHeight = std::max(minimumCellHeight, height / (s_maximumPostsPerSide - 1));
+  grid.m_columns = std::min(s_maximumPostsPerSide, std::max(2, static_cast<int>(std::ceil(width / grid.m_cellWidth)) + 1));
+  grid.m_rows = std::min(s_maximumPostsPerSide, std::max(2, static_cast<int>(std::ceil(height / grid.m_cellHeight)) + 1));
+  grid.m_posts.fill(0.0f, grid.m_columns * grid.m_rows);
+
+  m_samplingGrid = grid;
+  m_currentRequest = request;
+  m_remainingSamples = grid.m_posts.size();
+  m_nextSample = 0;
+  m_sampleTasks.clear();
+  m_sampling = true;
+
+  requestSamples();
+}
+
+/*!
+  \internal
+
+  Requests the elevation of further posts of the grid, limiting the number of
+  requests which are in progress at once.
+ */
+void LineOfSightEngine::requestSamples()
+{
+  if (!m_surface)
+  {
+    cancel();
+    return;
+  }
+
+  const int postCount = m_samplingGrid.m_posts.size();
+  while (m_sampleTasks.size() < s_maximumSampleRequests && m_nextSample < postCount)
+  {
+    const int sample = m_nextSample++;
+    const Point location(m_samplingGrid.m_xMin + (sample % m_samplingGrid.m_columns) * m_samplingGrid.m_cellWidth,
+                         m_samplingGrid.m_yMin + (sample / m_samplingGrid.m_columns) * m_samplingGrid.m_cellHeight,
+                         SpatialReference::wgs84());
+
+    m_sampleTasks.insert(m_surface->locationToElevation(location).taskId(), sample);
+  }
+}
+
+/*!
+  \internal
+
+  Stores the \a elevation sampled by \a taskId. Once every post has been sampled,
+  the current request is evaluated and any further requests are started.
+ */
+void LineOfSightEngine::handleElevation(QUuid taskId, double elevation)
+{
+  auto findIt = m_sampleTasks.find(taskId);
+  if (findIt == m_sampleTasks.end())
+    return;
+
+  m_samplingGrid.m_posts[findIt.value()] = static_cast<float>(elevation);
+  m_sampleTasks.erase(findIt);
+
+  if (--m_remainingSamples > 0)
+  {
+    requestSamples();
+    return;
+  }
+
+  m_grid = std::make_shared<const TerrainGrid>(m_samplingGrid);
+  m_samplingGrid = TerrainGrid();
+  m_sampling = false;
+
+  const Request request = m_currentRequest;
+  m_currentRequest = Request();
+  evaluate(request);
+
+  startNextRequest();
+}
+
+/*!
+  \internal
+
+  Marches the rays of \a request over the current grid on the worker threads and
+  emits \l visibilityComputed once all of them have been evaluated.
+ */
+void LineOfSightEngine::evaluate(const Request& request)
+{
+  const int rayCount = request.m_rays.size();
+  const int taskCount = (rayCount + s_raysPerTask - 1) / s_raysPerTask;
+  const QUuid requestId = request.m_id;
+  if (taskCount == 0 || !m_grid)
+  {
+    const QVector<bool> hidden(rayCount, false);
+    QMetaObject::invokeMethod(this, [this, requestId, hidden]()
+    {
+      emit visibilityComputed(requestId, hidden);
+    }, Qt::QueuedConnection);
+    return;
+  }
+
+  // each task writes a separate range of the results
+  const std::shared_ptr<const TerrainGrid> grid = m_grid;
+  const auto rays = std::make_shared<const QVector<Ray>>(request.m_rays);
+  const auto results = std::make_shared<std::vector<char>>(rayCount, 0);
+  const auto remainingTasks = std::make_shared<QAtomicInt>(taskCount);
+  const int generation = m_generation;
+  ++m_runningCount;
+
+  for (int task = 0; task < taskCount; ++task)
+  {
+    const int first = task * s_raysPerTask;
+    const int last = std::min(rayCount, first + s_raysPerTask);
+
+    m_threadPool->start([this, grid, rays, results, remainingTasks, first, last, generation, requestId]()
+    {
+      for (int i = first; i < last; ++i)
+      {
+        const Ray& ray = rays->at(i);
+        (*results)[i] = ray.m_valid && isVisible(*grid, ray);
+      }
+
+      if (remainingTasks->fetchAndAddOrdered(-1) != 1)
+        return;
+
+      QMetaObject::invokeMethod(this, [this, results, generation, requestId]()
+      {
+        // the computation was cancelled
+        if (generation != m_generation)
+          return;
+
+        --m_runningCount;
+
+        QVector<bool> visible;
+        visible.reserve(static_cast<int>(results->size()));
+        for (const char result : *results)
+          visible.append(result != 0);
+
+        emit visibilityComputed(requestId, visible);
+      }, Qt::QueuedConnection);
+    });
+  }
+}
+
+} // Dsa
+
+// Signal Documentation
+/*!
+  \fn void LineOfSightEngine::visibilityComputed(const QUuid& requestId, const QVector<bool>& visible);
+  \brief Signal emitted when the request with \a requestId has been computed.
+
+  \a visible holds whether each target can be seen from its observer, in the
+  order in which the pairs were passed to \l computeVisibility.
+ */
@@ -0,0 +1,138 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef LINEOFSIGHTENGINE_H
+#define LINEOFSIGHTENGINE_H
+
+// C++ API headers
+#include "Point.h"
+
+// Qt headers
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QUuid>
+#include <QVector>
+
+// STL headers
+#include <memory>
+
+class QThreadPool;
+
+namespace Esri {
+  namespace ArcGISRuntime {
+    class Surface;
+  }
+}
+
+namespace Dsa {
+
+class LineOfSightEngine : public QObject
+{
+  Q_OBJECT
+
+public:
+  struct Pair
+  {
+    Esri::ArcGISRuntime::Point m_observer;
+    Esri::ArcGISRuntime::Point m_target;
+    double m_observerOffset = 2.0;
+    double m_targetOffset = 0.0;
+  };
+
+  explicit LineOfSightEngine(QObject* parent = nullptr);
+  ~LineOfSightEngine();
+
+  QUuid computeVisibility(Esri::ArcGISRuntime::Surface* surface, const QList<Pair>& pairs);
+  void cancel();
+  void clear();
+
+  bool isComputing() const;
+
+signals:
+  void visibilityComputed(const QUuid& requestId, const QVector<bool>& visible);
+
+private:
+  Q_DISABLE_COPY(LineOfSightEngine)
+
+  struct TerrainGrid
+  {
+    double m_xMin = 0.0;
+    double m_yMin = 0.0;
+    double m_cellWidth = 0.0;
+    double m_cellHeight = 0.0;
+    int m_columns = 0;
+    int m_rows = 0;
+    QVector<float> m_posts;
+
+    bool contains(double xMin, double yMin, double xMax, double yMax) const;
+  };
+
+  struct Ray
+  {
+    double m_observerX = 0.0;
+    double m_observerY = 0.0;
+    double m_targetX = 0.0;
+    double m_targetY = 0.0;
+    double m_observerOffset = 0.0;
+    double m_targetOffset = 0.0;
+    bool m_valid = false;
+  };
+
+  struct Request
+  {
+    QUuid m_id;
+    Esri::ArcGISRuntime::Surface* m_surface = nullptr;
+    QVector<Ray> m_rays;
+    double m_xMin = 0.0;
+    double m_yMin = 0.0;
+    double m_xMax = 0.0;
+    double m_yMax = 0.0;
+  };
+
+  static bool isVisible(const TerrainGrid& grid, const Ray& ray);
+
+  void setSurface(Esri::ArcGISRuntime::Surface* surface);
+  void startNextRequest();
+  void sampleGrid(const Request& request);
+  void requestSamples();
+  void handleElevation(QUuid taskId, double elevation);
+  void evaluate(const Request& request);
+
+  static constexpr int s_maximumPostsPerSide = 128;
+  static constexpr int s_maximumSampleRequests = 256;
+  static constexpr int s_raysPerTask = 64;
+  static constexpr double s_postSpacing = 30.0;
+
+  QThreadPool* m_threadPool = nullptr;
+  QPointer<Esri::ArcGISRuntime::Surface> m_surface;
+  QList<QMetaObject::Connection> m_surfaceConnections;
+  std::shared_ptr<const TerrainGrid> m_grid;
+  TerrainGrid m_samplingGrid;
+  int m_remainingSamples = 0;
+  int m_nextSample = 0;
+  bool m_sampling = false;
+  QHash<QUuid, int> m_sampleTasks;
+  QList<Request> m_pendingRequests;
+  Request m_currentRequest;
+  int m_runningCount = 0;
+  int m_generation = 0;
+};
+
+} // Dsa
+
+#endif // LINEOFSIGHTENGINE_H
@@ -22,9 +22,10 @@
 
 // dsa app headers
 #include "ViewshedController.h"
+#include "ViewshedPool.h"
 
 // C++ API headers
-#include "AnalysisOverlay.h"
+#include "AttributeListModel.h"
 #include "Graphic.h"
 #include "GraphicsOverlay.h"
 #include "LocationViewshed.h"
@@ -54,19 +55,30 @@ constexpr double c_defaultMaxDistance = 500.0;
   \list
     \li \a point - The \l Esri::ArcGISRuntime::Point which the viewshehd will be centered upon.
     \li \a graphicsOverlay - The \l Esri::ArcGISRuntime::GraphicsOverlay which will contains the viewshed direction graphic.
-    \li \a analysisOverlay - The \l Esri::ArcGISRuntime::AnalysisOverlay which contains the viewshed.
+    \li \a pool - The \l ViewshedPool from which the viewshed and its direction graphic are acquired.
     \li \a parent - An optional parent.
   \endlist
  */
-LocationViewshed360::LocationViewshed360(const Point& point, GraphicsOverlay* graphicsOverlay, AnalysisOverlay* analysisOverlay, QObject* parent) :
-  Viewshed360(new LocationViewshed(point, c_defaultHeading, c_defaultPitch, c_defaultHorizontalAngle,
-                                   c_defaultVerticalAngle, c_defaultMinDistance, c_defaultMaxDistance, parent), analysisOverlay, parent),
-  m_graphicsOverlay(graphicsOverlay)
+LocationViewshed360::LocationViewshed360(const Point& point, GraphicsOverlay* graphicsOverlay, ViewshedPool* pool, QObject* parent) :
+  Viewshed360(pool->acquireLocationViewshed(point, c_defaultHeading, c_defaultPitch, c_defaultHorizontalAngle,
+                                            c_defaultVerticalAngle, c_defaultMinDistance, c_defaultMaxDistance), pool, parent),
+  m_graphicsOverlay(graphicsOverlay),
+  m_locationViewshedGraphic(pool->acquireGraphic(point))
 {
-  m_locationViewshedGraphic = new Graphic(point, parent);
+  // a recycled graphic already has the attributes
   constexpr double headingOffset = -180.0;
-  m_locationViewshedGraphic->attributes()->insertAttribute(ViewshedController::VIEWSHED_HEADING_ATTRIBUTE, headingOffset);
-  m_locationViewshedGraphic->attributes()->insertAttribute(ViewshedController::VIEWSHED_PITCH_ATTRIBUTE, is360Mode() ? 180.0 : c_defaultPitch);
+  AttributeListModel* attributes = m_locationViewshedGraphic->attributes();
+  const double graphicPitch = is360Mode() ? 180.0 : c_defaultPitch;
+  if (attributes->containsAttribute(ViewshedController::VIEWSHED_HEADING_ATTRIBUTE))
+  {
+    attributes->replaceAttribute(ViewshedController::VIEWSHED_HEADING_ATTRIBUTE, headingOffset);
+    attributes->replaceAttribute(ViewshedController::VIEWSHED_PITCH_ATTRIBUTE, graphicPitch);
+  }
+  else
+  {
+    attributes->insertAttribute(ViewshedController::VIEWSHED_HEADING_ATTRIBUTE, headingOffset);
+    attributes->insertAttribute(ViewshedController::VIEWSHED_PITCH_ATTRIBUTE, graphicPitch);
+  }
   m_graphicsOverlay->graphics()->append(m_locationViewshedGraphic);
 
   connect(this, &Viewshed360::is360ModeChanged, this, [this]()
@@ -81,8 +93,14 @@ LocationViewshed360::LocationViewshed360(const Point& point, GraphicsOverlay* gr
  */
 LocationViewshed360::~LocationViewshed360()
 {
+  if (m_locationViewshedGraphic.isNull())
+    return;
+
   if (!m_graphicsOverlay.isNull())
     m_graphicsOverlay->graphics()->removeOne(m_locationViewshedGraphic);
+
+  if (pool())
+    pool()->releaseGraphic(m_locationViewshedGraphic);
 }
 
 /*!
@@ -37,7 +37,7 @@ class LocationViewshed360 : public Viewshed360
 public:
   LocationViewshed360(const Esri::ArcGISRuntime::Point& point,
                 Esri::ArcGISRuntime::GraphicsOverlay* graphicsOverlay,
-                Esri::ArcGISRuntime::AnalysisOverlay* analysisOverlay, QObject* parent = nullptr);
+                ViewshedPool* pool, QObject* parent = nullptr);
   ~LocationViewshed360();
 
   Esri::ArcGISRuntime::Point point() const;
@@ -56,7 +56,7 @@ private:
   LocationViewshed360() = delete;
 
   QPointer<Esri::ArcGISRuntime::GraphicsOverlay> m_graphicsOverlay;
-  Esri::ArcGISRuntime::Graphic* m_locationViewshedGraphic = nullptr;
+  QPointer<Esri::ArcGISRuntime::Graphic> m_locationViewshedGraphic;
 };
 
 } // Dsa
@@ -20,6 +20,9 @@
 
 #include "Viewshed360.h"
 
+// dsa app headers
+#include "ViewshedPool.h"
+
 // C++ API headers
 #include "AnalysisOverlay.h"
 #include "Viewshed.h"
@@ -36,6 +39,10 @@ namespace Dsa {
 
   When in 360 degree mode the \l horizontalAngle is set to 360 degrees.
 
+  The underlying \l Esri::ArcGISRuntime::Viewshed is acquired from a \l ViewshedPool,
+  which decides when it is in the analysis overlay, and is released back to the pool
+  when this object is destroyed.
+
   \sa Esri::ArcGISRuntime::Viewshed
   */
 
@@ -43,34 +50,39 @@ namespace Dsa {
   \brief Constructor for a 360 degree viewshed.
 
   \list
-    \li \a viewshed - The primary \l Esri::ArcGISRuntime::Viewshed.
-    \li \a analysisOverlay - The \l Esri::ArcGISRuntime::AnalysisOverlay which contains the viewshed(s).
+    \li \a viewshed - The primary \l Esri::ArcGISRuntime::Viewshed, acquired from \a pool.
+    \li \a pool - The \l ViewshedPool which owns the viewshed.
     \li \a parent - An optional parent.
   \endlist
  */
-Viewshed360::Viewshed360(Viewshed* viewshed, AnalysisOverlay* analysisOverlay, QObject* parent) :
+Viewshed360::Viewshed360(Viewshed* viewshed, ViewshedPool* pool, QObject* parent) :
   QObject(parent),
   m_viewshed(viewshed),
-  m_analysisOverlay(analysisOverlay)
+  m_pool(pool)
 {
 }
 
 /*!
   \brief Destructor.
+
+  The viewshed is released back to the pool for reuse.
  */
 Viewshed360::~Viewshed360()
 {
+  if (!m_pool.isNull() && !m_viewshed.isNull())
+    m_pool->release(m_viewshed);
 }
 
 /*!
-  \brief Removes the viewshed from the \l Esri::ArcGISRuntime::AnalysisOverlay.
+  \brief Removes the viewshed from the \l Esri::ArcGISRuntime::AnalysisOverlay,
+  or from the queue of viewsheds waiting to be added to it.
  */
 void Viewshed360::removeFromOverlay()
 {
-  if (m_analysisOverlay.isNull())
+  if (m_pool.isNull())
     return;
 
-  m_analysisOverlay->analyses()->removeOne(m_viewshed);
+  m_pool->withdraw(m_viewshed);
 }
 
 /*!
@@ -325,7 +337,15 @@ Viewshed* Viewshed360::viewshed() const
  */
 AnalysisOverlay* Viewshed360::analysisOverlay() const
 {
-  return m_analysisOverlay.data();
+  return m_pool.isNull() ? nullptr : m_pool->analysisOverlay();
+}
+
+/*!
+  \brief Returns the \l ViewshedPool which owns the viewshed.
+ */
+ViewshedPool* Viewshed360::pool() const
+{
+  return m_pool.data();
 }
 
 } // Dsa
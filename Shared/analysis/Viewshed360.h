@@ -30,6 +30,8 @@ namespace Esri {
 
 namespace Dsa {
 
+class ViewshedPool;
+
 class Viewshed360 : public QObject
 {
   Q_OBJECT
@@ -90,6 +92,7 @@ public:
   Esri::ArcGISRuntime::Viewshed* viewshed() const;
 
   Esri::ArcGISRuntime::AnalysisOverlay* analysisOverlay() const;
+  ViewshedPool* pool() const;
 
 signals:
   void visibleChanged();
@@ -108,7 +111,7 @@ signals:
 
 protected:
   Viewshed360(Esri::ArcGISRuntime::Viewshed* viewshed,
-                   Esri::ArcGISRuntime::AnalysisOverlay* analysisOverlay,
+                   ViewshedPool* pool,
                    QObject* parent = nullptr);
 
 private:
@@ -116,7 +119,7 @@ private:
   Viewshed360() = delete;
 
   QPointer<Esri::ArcGISRuntime::Viewshed> m_viewshed;
-  QPointer<Esri::ArcGISRuntime::AnalysisOverlay> m_analysisOverlay;
+  QPointer<ViewshedPool> m_pool;
 
   QString m_name;
   bool m_is360Mode = true;
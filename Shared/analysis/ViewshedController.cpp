@@ -21,13 +21,16 @@
 #include "ViewshedController.h"
 
 // dsa app headers
+#include "AllocationCounter.h"
 #include "DsaUtility.h"
 #include "GeoElementViewshed360.h"
-#include "GraphicsOverlaysResultsManager.h"
 #include "LocationController.h"
 #include "LocationDisplay3d.h"
+#include "LocationSampler.h"
 #include "LocationViewshed360.h"
 #include "ViewshedListModel.h"
+#include "ViewshedPool.h"
+#include "ViewshedRasterCache.h"
 #include "GeoElementUtils.h"
 
 // toolkit headers
@@ -37,12 +40,18 @@
 // C++ API headers
 #include "GeoElementViewshed.h"
 #include "GlobeCameraController.h"
+#include "ImageFrame.h"
+#include "ImageOverlay.h"
 #include "LocationViewshed.h"
 #include "OrbitLocationCameraController.h"
+#include "Scene.h"
 #include "SceneQuickView.h"
 #include "SimpleMarkerSceneSymbol.h"
 #include "SimpleRenderer.h"
 
+// Qt headers
+#include <QTimer>
+
 // STL headers
 #include <cmath>
 
@@ -82,20 +91,29 @@ constexpr double c_defaultIdentifyTolerance = 5.0;
 ViewshedController::ViewshedController(QObject* parent) :
   AbstractTool(parent),
   m_analysisOverlay(new AnalysisOverlay(this)),
-  m_viewsheds(new ViewshedListModel(this))
+  m_viewsheds(new ViewshedListModel(this)),
+  m_viewshedPool(new ViewshedPool(m_analysisOverlay, this)),
+  m_rasterCache(new ViewshedRasterCache(this)),
+  m_refreshTimer(new QTimer(this))
 {
+  m_viewshedPool->reserve(s_reservedViewsheds);
+
+  m_refreshTimer->setInterval(s_frameInterval);
+  connect(m_refreshTimer, &QTimer::timeout, this, &ViewshedController::refreshViewsheds);
+
   connect(ToolResourceProvider::instance(), &ToolResourceProvider::geoViewChanged, this, [this]
   {
     setSceneView(dynamic_cast<SceneView*>(ToolResourceProvider::instance()->geoView()));
   });
 
-  connectMouseSignals();
+  connect(this, &ViewshedController::activeChanged, this, &ViewshedController::updateMouseFocus);
+  connect(this, &ViewshedController::activeModeChanged, this, &ViewshedController::updateMouseFocus);
 
   connect(m_viewsheds, &ViewshedListModel::viewshedRemoved, this, [this](Viewshed360* viewshed)
   {
     std::unique_ptr<Viewshed360> viewshedPtr(viewshed);
 
-    // remove viewshed from analysis overlay and delete object
+    // remove viewshed from analysis overlay and return its analysis to the pool
     viewshedPtr->removeFromOverlay();
 
     if (viewshed == m_locationDisplayViewshed)
@@ -139,15 +157,30 @@ void ViewshedController::setSceneView(SceneView* sceneView)
 
 /*!
   \internal
+  Takes the mouse focus while the tool is active in a mode which places viewsheds,
+  and releases it otherwise.
  */
-void ViewshedController::connectMouseSignals()
+void ViewshedController::updateMouseFocus()
 {
-  connect(ToolResourceProvider::instance(), &ToolResourceProvider::mouseClicked, this, &ViewshedController::onMouseClicked);
-  connect(ToolResourceProvider::instance(), &ToolResourceProvider::mouseMoved, this, &ViewshedController::onMouseMoved);
+  const bool placingViewshed = m_activeMode == AddLocationViewshed360 || m_activeMode == AddGeoElementViewshed360;
+  if (!isActive() || !placingViewshed)
+  {
+    ToolResourceProvider::instance()->clearMouseFocus(this);
+    return;
+  }
+
+  using MouseEventType = ToolResourceProvider::MouseEventType;
+  ToolResourceProvider::instance()->setMouseFocus(this, MouseEventType::Clicked | MouseEventType::Moved,
+                                                  ToolResourceProvider::PickMousePriority,
+                                                  [this](MouseEventType eventType, QMouseEvent& event)
+  {
+    return eventType == MouseEventType::Clicked ? onMouseClicked(event) : onMouseMoved(event);
+  });
 }
 
 /*!
-  \brief Handler for the mouse click \a event.
+  \internal
+  Handler for the mouse click \a event. Returns whether the click was used.
 
   Depending on the active mode (e.g. type of viewshed that the tool is creating)
   the event will be handled differently.
@@ -157,10 +190,10 @@ void ViewshedController::connectMouseSignals()
   In \c AddGeoElementViewshed360 mode, an identify operation will be started to find a suitable graphic
   for the viewshed.
  */
-void ViewshedController::onMouseClicked(QMouseEvent& event)
+bool ViewshedController::onMouseClicked(QMouseEvent& event)
 {
   if (!isActive() || !m_sceneView)
-    return;
+    return false;
 
   switch (m_activeMode)
   {
@@ -168,72 +201,61 @@ void ViewshedController::onMouseClicked(QMouseEvent& event)
   {
     const Point pt = m_sceneView->screenToBaseSurface(event.x(), event.y());
     addLocationViewshed360(pt);
-    break;
+    return true;
   }
   case AddGeoElementViewshed360:
   {
-    if (!m_identifyConn)
+    // start an identify graphics overlays task at the clicked position.
+    ToolResourceProvider::instance()->identifyGraphicsOverlays(this, event.x(), event.y(), c_defaultIdentifyTolerance, false, 1,
+                                                               [this](const QList<IdentifyGraphicsOverlayResult*>& identifyResults)
     {
-      // connect to the completion of the identify operation.
-      m_identifyConn = connect(ToolResourceProvider::instance(), &ToolResourceProvider::identifyGraphicsOverlaysCompleted,
-                               this, [this](const QUuid& taskId, const QList<IdentifyGraphicsOverlayResult*>& identifyResults)
+      if (!isActive() || identifyResults.isEmpty() || identifyResults[0]->graphics().isEmpty())
       {
-        // if the task ID does not match the current task, return.
-        if (taskId != m_identifyTaskWatcher.taskId())
-          return;
-
-        m_identifyTaskWatcher = TaskWatcher();
-
-        // Create a RAII helper to ensure we clean up the results
-        GraphicsOverlaysResultsManager resultsManager(identifyResults);
-
-        if (!isActive() || resultsManager.m_results.isEmpty() || resultsManager.m_results[0]->graphics().isEmpty())
-        {
-          return;
-        }
-
-        // create a viewshed centered upon the 1st graphic retrieved.
-        auto graphic = resultsManager.m_results[0]->graphics()[0];
-        graphic->setParent(nullptr);
-        addGeoElementViewshed360(graphic);
-      });
-    }
-
-    // start an identify graphics overlays task at the clicked position.
-    m_identifyTaskWatcher = m_sceneView->identifyGraphicsOverlays(event.x(), event.y(), c_defaultIdentifyTolerance, false, 1);
-    break;
+        return;
+      }
+
+      // create a viewshed centered upon the 1st graphic retrieved.
+      auto graphic = identifyResults[0]->graphics()[0];
+      graphic->setParent(nullptr);
+      addGeoElementViewshed360(graphic);
+    });
+    return true;
   }
   default:
     break;
   }
+
+  return false;
 }
 
 /*!
-  \brief React to the mouse moved \a event.
+  \internal
+  React to the mouse moved \a event. Returns whether the event was used.
 
   This event will only be handled if the active mode is \c AddLocationViewshed360 mode.
   In this mode, when there is already an existing location viewshed, it's position will
   be updated to follow the current mouse position.
  */
-void ViewshedController::onMouseMoved(QMouseEvent& event)
+bool ViewshedController::onMouseMoved(QMouseEvent& event)
 {
   if (!isActive() || !m_sceneView)
-    return;
+    return false;
 
   if (m_activeMode != ViewshedActiveMode::AddLocationViewshed360)
-    return;
+    return false;
 
   if (!m_activeViewshed)
-    return;
+    return false;
 
   auto locViewshed = dynamic_cast<LocationViewshed360*>(m_activeViewshed);
   if (!locViewshed)
-    return;
+    return false;
 
   const Point point = m_sceneView->screenToBaseSurface(event.x(), event.y());
   locViewshed->setPoint(point);
 
   event.accept();
+  return true;
 }
 
 /*!
@@ -249,10 +271,14 @@ void ViewshedController::addLocationDisplayViewshed()
     return;
 
   Graphic* locationGraphic = locationController->locationDisplay()->locationGraphic();
-  m_locationDisplayViewshed = new GeoElementViewshed360(locationGraphic, m_analysisOverlay, VIEWSHED_HEADING_ATTRIBUTE, VIEWSHED_PITCH_ATTRIBUTE, this);
+  m_locationDisplayViewshed = new GeoElementViewshed360(locationGraphic, m_viewshedPool, VIEWSHED_HEADING_ATTRIBUTE, VIEWSHED_PITCH_ATTRIBUTE, this);
   m_locationDisplayViewshed->setName(QStringLiteral("Location Display Viewshed"));
   m_locationDisplayViewshed->setOffsetZ(c_defaultOffsetZ);
-  m_analysisOverlay->analyses()->append(m_locationDisplayViewshed->viewshed());
+  connectRefresh(m_locationDisplayViewshed);
+
+  // the viewshed follows every position update until it is removed
+  locationController->locationSampler()->setConsumerActive(m_locationDisplayViewshed, true);
+  m_viewshedPool->show(m_locationDisplayViewshed->viewshed(), s_locationDisplayPriority);
   m_viewsheds->append(m_locationDisplayViewshed);
 
   m_activeViewshed = m_locationDisplayViewshed;
@@ -265,6 +291,8 @@ void ViewshedController::addLocationDisplayViewshed()
  */
 void ViewshedController::addLocationViewshed360(const Esri::ArcGISRuntime::Point& point)
 {
+  DSA_ALLOCATION_SCOPE(Analysis);
+
   if (!m_graphicsOverlay)
   {
     if (!m_sceneView)
@@ -295,10 +323,10 @@ void ViewshedController::addLocationViewshed360(const Esri::ArcGISRuntime::Point
     }
   }
 
-  auto locationViewshed360 = new LocationViewshed360(point, m_graphicsOverlay, m_analysisOverlay, this);
+  auto locationViewshed360 = new LocationViewshed360(point, m_graphicsOverlay, m_viewshedPool, this);
   s_viewshedCount++;
   locationViewshed360->setName(QString("Viewshed %1").arg(QString::number(s_viewshedCount)));
-  m_analysisOverlay->analyses()->append(locationViewshed360->viewshed());
+  m_viewshedPool->show(locationViewshed360->viewshed(), s_defaultPriority);
   m_viewsheds->append(locationViewshed360);
 
   // clear any existing camera contollers.
@@ -332,16 +360,19 @@ void ViewshedController::addLocationViewshed360(const Esri::ArcGISRuntime::Point
  */
 void ViewshedController::addGeoElementViewshed360(GeoElement* geoElement)
 {
+  DSA_ALLOCATION_SCOPE(Analysis);
+
   removeActiveViewshed();
 
-  auto geoElementViewshed360 = new GeoElementViewshed360(geoElement, m_analysisOverlay, QString(), QString(), this);
+  auto geoElementViewshed360 = new GeoElementViewshed360(geoElement, m_viewshedPool, QString(), QString(), this);
   s_viewshedCount++;
   geoElementViewshed360->setName(QString("Viewshed %1").arg(QString::number(s_viewshedCount)));
   if (!GeoElementUtils::toQObject(geoElement)->parent())
     GeoElementUtils::setParent(geoElement, geoElementViewshed360);
 
   geoElementViewshed360->setOffsetZ(c_defaultOffsetZ);
-  m_analysisOverlay->analyses()->append(geoElementViewshed360->viewshed());
+  connectRefresh(geoElementViewshed360);
+  m_viewshedPool->show(geoElementViewshed360->viewshed(), s_defaultPriority);
   m_viewsheds->append(geoElementViewshed360);
 
   m_activeViewshed = geoElementViewshed360;
@@ -735,6 +766,196 @@ void ViewshedController::setActiveViewshed360Mode(bool is360Mode)
   m_activeViewshed->set360Mode(is360Mode);
 }
 
+/*!
+  \brief Computes viewsheds for each of the \a observers in the background.
+
+  The viewsheds use the distances, angle, heading and offset of the active viewshed,
+  or the defaults if there is none. Once computed, a viewshed can be shown instantly
+  with \l showPrecomputedViewshed.
+
+  Progress is reported by \l rasterCache.
+ */
+void ViewshedController::precomputeViewsheds(const QList<Point>& observers)
+{
+  DSA_ALLOCATION_SCOPE(Analysis);
+
+  if (!m_sceneView || !m_sceneView->arcGISScene())
+    return;
+
+  ViewshedRasterCache::Parameters parameters;
+  parameters.m_offsetZ = c_defaultOffsetZ;
+  if (m_activeViewshed)
+  {
+    parameters.m_minDistance = m_activeViewshed->minDistance();
+    parameters.m_maxDistance = m_activeViewshed->maxDistance();
+    parameters.m_horizontalAngle = m_activeViewshed->is360Mode() ? 360.0 : m_activeViewshed->horizontalAngle();
+    parameters.m_heading = m_activeViewshed->heading();
+    parameters.m_offsetZ = m_activeViewshed->offsetZ();
+  }
+
+  m_precomputeParameters = parameters;
+
+  QList<ViewshedRasterCache::Parameters> observerParameters;
+  observerParameters.reserve(observers.size());
+  for (const Point& observer : observers)
+  {
+    parameters.m_observer = observer;
+    observerParameters.append(parameters);
+  }
+
+  m_rasterCache->compute(m_sceneView->arcGISScene()->baseSurface(), observerParameters);
+}
+
+/*!
+  \brief Shows the precomputed viewshed for \a observer as an image draped on the scene.
+
+  Returns \c false if the viewshed for \a observer has not been computed by
+  \l precomputeViewsheds.
+ */
+bool ViewshedController::showPrecomputedViewshed(const Point& observer)
+{
+  if (!m_sceneView)
+    return false;
+
+  ViewshedRasterCache::Parameters parameters = m_precomputeParameters;
+  parameters.m_observer = observer;
+
+  const QImage image = m_rasterCache->image(parameters);
+  if (image.isNull())
+    return false;
+
+  if (!m_precomputedOverlay)
+  {
+    m_precomputedOverlay = new ImageOverlay(this);
+    m_sceneView->imageOverlays()->append(m_precomputedOverlay);
+  }
+  else if (!m_sceneView->imageOverlays()->contains(m_precomputedOverlay))
+  {
+    m_sceneView->imageOverlays()->append(m_precomputedOverlay);
+  }
+
+  ImageFrame* previousFrame = m_precomputedOverlay->imageFrame();
+  m_precomputedOverlay->setImageFrame(new ImageFrame(image, m_rasterCache->extent(parameters), m_precomputedOverlay));
+  delete previousFrame;
+  m_precomputedOverlay->setVisible(true);
+
+  return true;
+}
+
+/*!
+  \brief Hides the viewshed shown by \l showPrecomputedViewshed.
+ */
+void ViewshedController::hidePrecomputedViewshed()
+{
+  if (m_precomputedOverlay)
+    m_precomputedOverlay->setVisible(false);
+}
+
+/*!
+  \brief Returns the cache of viewsheds computed by \l precomputeViewsheds.
+ */
+ViewshedRasterCache* ViewshedController::rasterCache() const
+{
+  return m_rasterCache;
+}
+
+/*!
+  \property ViewshedController::analysisBudget
+  \brief Returns the maximum number of moving viewsheds which are refreshed each frame.
+
+  Viewsheds which are due to be refreshed beyond this budget wait for a later frame.
+  A value of \c 0 or less refreshes every viewshed as soon as it is due.
+ */
+int ViewshedController::analysisBudget() const
+{
+  return m_analysisBudget;
+}
+
+/*!
+  \brief Sets the maximum number of moving viewsheds which are refreshed each frame to \a analysisBudget.
+ */
+void ViewshedController::setAnalysisBudget(int analysisBudget)
+{
+  if (m_analysisBudget == analysisBudget)
+    return;
+
+  m_analysisBudget = analysisBudget;
+  emit analysisBudgetChanged();
+}
+
+/*!
+  \property ViewshedController::viewshedLimit
+  \brief Returns the maximum number of viewsheds which are analysed at once.
+
+  Viewsheds beyond this limit are queued and shown as others are removed. The
+  location display viewshed is shown first, then the active viewshed, and then the
+  others in the order they were added. A value of \c 0 or less shows every viewshed.
+
+  \sa ViewshedPool::concurrencyCap
+ */
+int ViewshedController::viewshedLimit() const
+{
+  return m_viewshedPool->concurrencyCap();
+}
+
+/*!
+  \brief Sets the maximum number of viewsheds which are analysed at once to \a viewshedLimit.
+ */
+void ViewshedController::setViewshedLimit(int viewshedLimit)
+{
+  if (m_viewshedPool->concurrencyCap() == viewshedLimit)
+    return;
+
+  m_viewshedPool->setConcurrencyCap(viewshedLimit);
+  emit viewshedLimitChanged();
+}
+
+/*!
+  \brief Returns the \l ViewshedPool from which the viewsheds are acquired.
+ */
+ViewshedPool* ViewshedController::viewshedPool() const
+{
+  return m_viewshedPool;
+}
+
+/*!
+  \internal
+
+  Queues \a viewshed to be refreshed within the analysis budget whenever it has moved.
+ */
+void ViewshedController::connectRefresh(GeoElementViewshed360* viewshed)
+{
+  connect(viewshed, &GeoElementViewshed360::refreshRequested, this, [this, viewshed]()
+  {
+    m_refreshQueue.append(viewshed);
+    if (!m_refreshTimer->isActive())
+      m_refreshTimer->start();
+  });
+}
+
+/*!
+  \internal
+
+  Refreshes the viewsheds which have waited longest, up to the analysis budget.
+ */
+void ViewshedController::refreshViewsheds()
+{
+  int refreshCount = 0;
+  while (!m_refreshQueue.isEmpty() && (m_analysisBudget <= 0 || refreshCount < m_analysisBudget))
+  {
+    // viewsheds removed while waiting do not use the budget
+    QPointer<GeoElementViewshed360> viewshed = m_refreshQueue.takeFirst();
+    if (!viewshed)
+      continue;
+
+    viewshed->refresh();
+    ++refreshCount;
+  }
+
+  if (m_refreshQueue.isEmpty())
+    m_refreshTimer->stop();
+}
+
 /*!
   \internal
  */
@@ -764,6 +985,17 @@ void ViewshedController::updateActiveViewshedSignals()
  */
 void ViewshedController::updateActiveViewshed()
 {
+  // the viewshed being edited is shown ahead of others waiting for a slot
+  if (m_prioritizedViewshed != m_activeViewshed)
+  {
+    if (m_prioritizedViewshed && m_prioritizedViewshed != m_locationDisplayViewshed)
+      m_viewshedPool->setPriority(m_prioritizedViewshed->viewshed(), s_defaultPriority);
+
+    m_prioritizedViewshed = m_activeViewshed;
+    if (m_activeViewshed && m_activeViewshed != m_locationDisplayViewshed)
+      m_viewshedPool->setPriority(m_activeViewshed->viewshed(), s_activeViewshedPriority);
+  }
+
   if (!m_activeViewshed)
   {
     disconnectActiveViewshedSignals();
@@ -890,6 +1122,16 @@ void ViewshedController::emitActiveViewshedSignals()
   \brief Signal emitted when currently active viewshed enabled changes.
  */
 
+/*!
+  \fn void ViewshedController::analysisBudgetChanged();
+  \brief Signal emitted when the analysis budget changes.
+ */
+
+/*!
+  \fn void ViewshedController::viewshedLimitChanged();
+  \brief Signal emitted when the viewshed limit changes.
+ */
+
 /*!
   \fn void ViewshedController::activeModeChanged();
   \brief Signal emitted when the active mode changes.
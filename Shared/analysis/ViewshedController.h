@@ -20,13 +20,15 @@
 // toolkit headers
 #include "AbstractTool.h"
 
-// C++ API headers
-#include "TaskWatcher.h"
+// dsa app headers
+#include "ViewshedRasterCache.h"
 
 // Qt headers
 #include <QAbstractListModel>
+#include <QPointer>
 
 class QMouseEvent;
+class QTimer;
 
 namespace Esri {
   namespace ArcGISRuntime {
@@ -35,6 +37,7 @@ namespace Esri {
     class GeoElement;
     class GlobeCameraController;
     class GraphicsOverlay;
+    class ImageOverlay;
     class OrbitLocationCameraController;
   }
 }
@@ -42,6 +45,7 @@ namespace Esri {
 namespace Dsa {
 
 class ViewshedListModel;
+class ViewshedPool;
 class Viewshed360;
 class GeoElementViewshed360;
 
@@ -68,6 +72,8 @@ class ViewshedController : public AbstractTool
   Q_PROPERTY(bool activeViewshedOffsetZEnabled READ isActiveViewshedOffsetZEnabled NOTIFY activeViewshedOffsetZEnabledChanged)
   Q_PROPERTY(bool activeViewshed360Mode READ isActiveViewshed360Mode WRITE setActiveViewshed360Mode NOTIFY activeViewshed360ModeChanged)
   Q_PROPERTY(bool locationDisplayViewshedActive READ isLocationDisplayViewshedActive NOTIFY locationDisplayViewshedActiveChanged)
+  Q_PROPERTY(int analysisBudget READ analysisBudget WRITE setAnalysisBudget NOTIFY analysisBudgetChanged)
+  Q_PROPERTY(int viewshedLimit READ viewshedLimit WRITE setViewshedLimit NOTIFY viewshedLimitChanged)
 
 signals:
   void activeModeChanged();
@@ -88,6 +94,8 @@ signals:
   void activeViewshedOffsetZEnabledChanged();
   void activeViewshed360ModeChanged();
   void locationDisplayViewshedActiveChanged();
+  void analysisBudgetChanged();
+  void viewshedLimitChanged();
 
 public:
   enum ViewshedActiveMode
@@ -159,18 +167,33 @@ public:
   bool isActiveViewshed360Mode() const;
   void setActiveViewshed360Mode(bool is360Mode);
 
-public slots:
-  void onMouseClicked(QMouseEvent& event);
-  void onMouseMoved(QMouseEvent& event);
+  // precomputed viewshed methods
+  void precomputeViewsheds(const QList<Esri::ArcGISRuntime::Point>& observers);
+  bool showPrecomputedViewshed(const Esri::ArcGISRuntime::Point& observer);
+  void hidePrecomputedViewshed();
+  ViewshedRasterCache* rasterCache() const;
+
+  int analysisBudget() const;
+  void setAnalysisBudget(int analysisBudget);
+
+  int viewshedLimit() const;
+  void setViewshedLimit(int viewshedLimit);
+
+  ViewshedPool* viewshedPool() const;
 
 private:
-  void connectMouseSignals();
+  void updateMouseFocus();
+  bool onMouseClicked(QMouseEvent& event);
+  bool onMouseMoved(QMouseEvent& event);
 
   void updateActiveViewshed();
   void updateActiveViewshedSignals();
   void disconnectActiveViewshedSignals();
   void emitActiveViewshedSignals();
 
+  void connectRefresh(GeoElementViewshed360* viewshed);
+  void refreshViewsheds();
+
   Esri::ArcGISRuntime::SceneView* m_sceneView = nullptr;
 
   Esri::ArcGISRuntime::AnalysisOverlay* m_analysisOverlay = nullptr;
@@ -179,15 +202,29 @@ private:
   Esri::ArcGISRuntime::GlobeCameraController* m_navCamCtrllr = nullptr;
 
   ViewshedListModel* m_viewsheds = nullptr;
+  ViewshedPool* m_viewshedPool = nullptr;
+  QPointer<Viewshed360> m_prioritizedViewshed;
   Viewshed360* m_activeViewshed = nullptr;
   GeoElementViewshed360* m_locationDisplayViewshed = nullptr;
 
   ViewshedActiveMode m_activeMode = ViewshedActiveMode::NoActiveMode;
 
-  Esri::ArcGISRuntime::TaskWatcher m_identifyTaskWatcher;
-  QMetaObject::Connection m_identifyConn;
 
   QList<QMetaObject::Connection> m_activeViewshedConns;
+
+  ViewshedRasterCache* m_rasterCache = nullptr;
+  ViewshedRasterCache::Parameters m_precomputeParameters;
+  Esri::ArcGISRuntime::ImageOverlay* m_precomputedOverlay = nullptr;
+
+  static constexpr int s_frameInterval = 16;
+  int m_analysisBudget = 4;
+  QTimer* m_refreshTimer = nullptr;
+  QList<QPointer<GeoElementViewshed360>> m_refreshQueue;
+
+  static constexpr int s_reservedViewsheds = 4;
+  static constexpr int s_defaultPriority = 0;
+  static constexpr int s_activeViewshedPriority = 1;
+  static constexpr int s_locationDisplayPriority = 2;
 };
 
 } // Dsa
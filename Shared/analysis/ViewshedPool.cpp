@@ -0,0 +1,507 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "ViewshedPool.h"
+
+// C++ API headers
+#include "AnalysisOverlay.h"
+#include "GeoElementViewshed.h"
+#include "Graphic.h"
+#include "LocationViewshed.h"
+#include "Point.h"
+
+// STL headers
+#include <algorithm>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+/*!
+  \class Dsa::ViewshedPool
+  \inmodule Dsa
+  \inherits QObject
+  \brief Manages a pool of viewshed analysis objects which share an
+  \l Esri::ArcGISRuntime::AnalysisOverlay.
+
+  Viewsheds are acquired from the pool and released back to it rather than being
+  created and deleted. Released viewsheds are taken out of the overlay and kept idle,
+  up to \l idleCapacity of each kind, so that they can be rebound to a new observer
+  without allocating any further analysis resources. The direction graphics used by
+  location viewsheds are recycled in the same way.
+
+  At most \l concurrencyCap viewsheds are in the overlay at any time. Viewsheds which
+  are shown beyond the cap are queued and added to the overlay, highest priority and
+  then oldest first, as slots become free. A viewshed of higher priority takes the slot
+  of the lowest priority viewshed currently shown.
+
+  The visibility of each viewshed is left untouched, so a queued viewshed which is
+  visible appears as soon as it is given a slot.
+ */
+
+/*!
+  \brief Constructor taking the \a analysisOverlay which will contain the viewsheds
+  and an optional \a parent.
+ */
+ViewshedPool::ViewshedPool(AnalysisOverlay* analysisOverlay, QObject* parent) :
+  QObject(parent),
+  m_analysisOverlay(analysisOverlay)
+{
+}
+
+/*!
+  \brief Destructor.
+ */
+ViewshedPool::~ViewshedPool()
+{
+  if (m_analysisOverlay.isNull())
+    return;
+
+  for (const Request& request : qAsConst(m_requests))
+  {
+    if (request.m_shown && !request.m_viewshed.isNull())
+      m_analysisOverlay->analyses()->removeOne(request.m_viewshed);
+  }
+}
+
+/*!
+  \brief Returns the \l Esri::ArcGISRuntime::AnalysisOverlay which contains the viewsheds.
+ */
+AnalysisOverlay* ViewshedPool::analysisOverlay() const
+{
+  return m_analysisOverlay;
+}
+
+/*!
+  \brief Returns a location viewshed observing from \a point.
+
+  An idle viewshed is reused if there is one, otherwise a new one is created. The
+  viewshed is set to \a heading, \a pitch, \a horizontalAngle, \a verticalAngle,
+  \a minDistance and \a maxDistance and is visible, but is not in the overlay until
+  it is passed to \l show.
+
+  The viewshed remains owned by the pool and should be passed to \l release once it
+  is no longer needed.
+ */
+LocationViewshed* ViewshedPool::acquireLocationViewshed(const Point& point, double heading, double pitch,
+                                                          double horizontalAngle, double verticalAngle,
+                                                          double minDistance, double maxDistance)
+{
+  LocationViewshed* viewshed = m_idleLocationViewsheds.isEmpty() ? createLocationViewshed()
+                                                                 : m_idleLocationViewsheds.takeLast();
+  viewshed->setLocation(point);
+  viewshed->setHeading(heading);
+  viewshed->setPitch(pitch);
+  viewshed->setHorizontalAngle(horizontalAngle);
+  viewshed->setVerticalAngle(verticalAngle);
+  viewshed->setMinDistance(minDistance);
+  viewshed->setMaxDistance(maxDistance);
+  viewshed->setVisible(true);
+
+  return viewshed;
+}
+
+/*!
+  \brief Returns a GeoElement viewshed whose observer is placed at \a observerGeometry.
+
+  The observer is a \l Esri::ArcGISRuntime::Graphic owned by the viewshed, which
+  callers move to follow their own GeoElement. An idle viewshed is reused if there is
+  one, otherwise a new one is created. The viewshed is set to \a horizontalAngle,
+  \a verticalAngle, \a minDistance and \a maxDistance with no offsets and is visible,
+  but is not in the overlay until it is passed to \l show.
+
+  The viewshed remains owned by the pool and should be passed to \l release once it
+  is no longer needed.
+ */
+GeoElementViewshed* ViewshedPool::acquireGeoElementViewshed(const Geometry& observerGeometry,
+                                                              double horizontalAngle, double verticalAngle,
+                                                              double minDistance, double maxDistance)
+{
+  GeoElementViewshed* viewshed = m_idleGeoElementViewsheds.isEmpty() ? createGeoElementViewshed()
+                                                                     : m_idleGeoElementViewsheds.takeLast();
+  static_cast<Graphic*>(viewshed->geoElement())->setGeometry(observerGeometry);
+  viewshed->setHorizontalAngle(horizontalAngle);
+  viewshed->setVerticalAngle(verticalAngle);
+  viewshed->setMinDistance(minDistance);
+  viewshed->setMaxDistance(maxDistance);
+  viewshed->setHeadingOffset(0.0);
+  viewshed->setPitchOffset(0.0);
+  viewshed->setOffsetZ(0.0);
+  viewshed->setVisible(true);
+
+  return viewshed;
+}
+
+/*!
+  \brief Returns a visible \l Esri::ArcGISRuntime::Graphic placed at \a point.
+
+  An idle graphic is reused if there is one. Attributes set by a previous user are
+  kept, so callers should replace rather than insert them. The graphic remains owned
+  by the pool and should be passed to \l releaseGraphic once it is no longer needed.
+ */
+Graphic* ViewshedPool::acquireGraphic(const Point& point)
+{
+  if (m_idleGraphics.isEmpty())
+    return new Graphic(point, this);
+
+  Graphic* graphic = m_idleGraphics.takeLast();
+  graphic->setGeometry(point);
+  graphic->setVisible(true);
+  return graphic;
+}
+
+/*!
+  \brief Returns \a viewshed to the pool.
+
+  The viewshed is withdrawn from the overlay or the queue. It is kept for reuse if
+  there is room among the idle viewsheds, and deleted otherwise.
+ */
+void ViewshedPool::release(Viewshed* viewshed)
+{
+  if (!viewshed)
+    return;
+
+  withdraw(viewshed);
+
+  if (auto locationViewshed = dynamic_cast<LocationViewshed*>(viewshed))
+  {
+    if (m_idleLocationViewsheds.size() < m_idleCapacity && !m_idleLocationViewsheds.contains(locationViewshed))
+    {
+      m_idleLocationViewsheds.append(locationViewshed);
+      return;
+    }
+  }
+  else if (auto geoElementViewshed = dynamic_cast<GeoElementViewshed*>(viewshed))
+  {
+    if (m_idleGeoElementViewsheds.size() < m_idleCapacity && !m_idleGeoElementViewsheds.contains(geoElementViewshed))
+    {
+      m_idleGeoElementViewsheds.append(geoElementViewshed);
+      return;
+    }
+  }
+
+  viewshed->deleteLater();
+}
+
+/*!
+  \brief Returns \a graphic to the pool.
+
+  The caller must already have removed the graphic from its overlay. The graphic is
+  kept for reuse if there is room among the idle graphics, and deleted otherwise.
+ */
+void ViewshedPool::releaseGraphic(Graphic* graphic)
+{
+  if (!graphic || m_idleGraphics.contains(graphic))
+    return;
+
+  if (m_idleGraphics.size() < m_idleCapacity)
+  {
+    m_idleGraphics.append(graphic);
+    return;
+  }
+
+  graphic->deleteLater();
+}
+
+/*!
+  \brief Requests a slot in the overlay for \a viewshed with the given \a priority.
+
+  The viewshed is added to the overlay straight away if a slot is free, or if it
+  outranks a viewshed which is already shown. Otherwise it is queued. Calling this for
+  a viewshed which is already shown or queued updates its priority.
+ */
+void ViewshedPool::show(Viewshed* viewshed, int priority)
+{
+  if (!viewshed)
+    return;
+
+  const int index = indexOf(viewshed);
+  if (index != -1)
+  {
+    setPriority(viewshed, priority);
+    return;
+  }
+
+  Request request;
+  request.m_viewshed = viewshed;
+  request.m_priority = priority;
+  request.m_order = m_nextOrder++;
+  m_requests.append(request);
+
+  schedule();
+}
+
+/*!
+  \brief Removes \a viewshed from the overlay or the queue without returning it to the pool.
+
+  If the viewshed was shown, the highest priority queued viewshed takes its slot.
+ */
+void ViewshedPool::withdraw(Viewshed* viewshed)
+{
+  const int index = indexOf(viewshed);
+  if (index == -1)
+    return;
+
+  const bool wasShown = m_requests.at(index).m_shown;
+  m_requests.removeAt(index);
+
+  if (wasShown)
+  {
+    if (!m_analysisOverlay.isNull())
+      m_analysisOverlay->analyses()->removeOne(viewshed);
+
+    emit shownChanged(viewshed);
+  }
+
+  schedule();
+}
+
+/*!
+  \brief Sets the \a priority of \a viewshed, which must already be shown or queued.
+
+  Viewsheds with a higher priority are given a slot in the overlay first.
+ */
+void ViewshedPool::setPriority(Viewshed* viewshed, int priority)
+{
+  const int index = indexOf(viewshed);
+  if (index == -1 || m_requests.at(index).m_priority == priority)
+    return;
+
+  m_requests[index].m_priority = priority;
+  schedule();
+}
+
+/*!
+  \brief Returns whether \a viewshed is currently in the overlay.
+
+  A viewshed which is queued waiting for a slot returns \c false.
+ */
+bool ViewshedPool::isShown(Viewshed* viewshed) const
+{
+  const int index = indexOf(viewshed);
+  return index != -1 && m_requests.at(index).m_shown;
+}
+
+/*!
+  \brief Returns the maximum number of viewsheds in the overlay at any time.
+
+  A value of \c 0 or less means that every viewshed is shown.
+
+  The default is \c 16.
+ */
+int ViewshedPool::concurrencyCap() const
+{
+  return m_concurrencyCap;
+}
+
+/*!
+  \brief Sets the maximum number of viewsheds in the overlay at any time to \a concurrencyCap.
+
+  Lowering the cap queues the lowest priority viewsheds which are shown. Raising it
+  shows queued viewsheds.
+ */
+void ViewshedPool::setConcurrencyCap(int concurrencyCap)
+{
+  if (m_concurrencyCap == concurrencyCap)
+    return;
+
+  m_concurrencyCap = concurrencyCap;
+  schedule();
+}
+
+/*!
+  \brief Returns the maximum number of idle viewsheds of each kind, and of idle
+  graphics, kept for reuse.
+
+  The default is \c 8.
+ */
+int ViewshedPool::idleCapacity() const
+{
+  return m_idleCapacity;
+}
+
+/*!
+  \brief Sets the maximum number of idle viewsheds of each kind, and of idle graphics,
+  kept for reuse to \a idleCapacity.
+
+  Idle objects beyond the new capacity are deleted.
+ */
+void ViewshedPool::setIdleCapacity(int idleCapacity)
+{
+  m_idleCapacity = std::max(idleCapacity, 0);
+  trimIdle();
+}
+
+/*!
+  \brief Creates idle viewsheds of each kind until there are at least \a count of them.
+
+  The idle capacity is raised to \a count if needed.
+ */
+void ViewshedPool::reserve(int count)
+{
+  if (count > m_idleCapacity)
+    m_idleCapacity = count;
+
+  while (m_idleLocationViewsheds.size() < count)
+    m_idleLocationViewsheds.append(createLocationViewshed());
+
+  while (m_idleGeoElementViewsheds.size() < count)
+    m_idleGeoElementViewsheds.append(createGeoElementViewshed());
+}
+
+/*!
+  \brief Returns the number of viewsheds which are in the overlay.
+ */
+int ViewshedPool::shownCount() const
+{
+  return static_cast<int>(std::count_if(m_requests.cbegin(), m_requests.cend(), [](const Request& request)
+  {
+    return request.m_shown;
+  }));
+}
+
+/*!
+  \brief Returns the number of viewsheds which are waiting for a slot in the overlay.
+ */
+int ViewshedPool::queuedCount() const
+{
+  return m_requests.size() - shownCount();
+}
+
+/*!
+  \internal
+ */
+LocationViewshed* ViewshedPool::createLocationViewshed()
+{
+  return new LocationViewshed(Point(), 0.0, 90.0, 360.0, 90.0, 0.0, 500.0, this);
+}
+
+/*!
+  \internal
+
+  The observer graphic is owned by the viewshed, which keeps a pointer to it.
+ */
+GeoElementViewshed* ViewshedPool::createGeoElementViewshed()
+{
+  Graphic* observer = new Graphic(Geometry());
+  auto viewshed = new GeoElementViewshed(observer, 360.0, 90.0, 0.0, 500.0, 0.0, 0.0, this);
+  observer->setParent(viewshed);
+  return viewshed;
+}
+
+/*!
+  \internal
+ */
+int ViewshedPool::indexOf(Viewshed* viewshed) const
+{
+  for (int i = 0; i < m_requests.size(); ++i)
+  {
+    if (m_requests.at(i).m_viewshed == viewshed)
+      return i;
+  }
+
+  return -1;
+}
+
+/*!
+  \internal
+
+  Ranks every request by priority and then age, and shows the first
+  \l concurrencyCap of them. Viewsheds losing their slot are removed from the overlay
+  before new ones are added, so the overlay never holds more than the cap.
+ */
+void ViewshedPool::schedule()
+{
+  // viewsheds deleted elsewhere no longer hold a slot
+  m_requests.erase(std::remove_if(m_requests.begin(), m_requests.end(), [](const Request& request)
+  {
+    return request.m_viewshed.isNull();
+  }), m_requests.end());
+
+  QList<int> ranking;
+  ranking.reserve(m_requests.size());
+  for (int i = 0; i < m_requests.size(); ++i)
+    ranking.append(i);
+
+  std::sort(ranking.begin(), ranking.end(), [this](int a, int b)
+  {
+    const Request& first = m_requests.at(a);
+    const Request& second = m_requests.at(b);
+    if (first.m_priority != second.m_priority)
+      return first.m_priority > second.m_priority;
+
+    return first.m_order < second.m_order;
+  });
+
+  QList<Viewshed*> hidden;
+  QList<Viewshed*> shown;
+  for (int rank = 0; rank < ranking.size(); ++rank)
+  {
+    Request& request = m_requests[ranking.at(rank)];
+    const bool show = m_concurrencyCap <= 0 || rank < m_concurrencyCap;
+    if (request.m_shown == show)
+      continue;
+
+    request.m_shown = show;
+    if (show)
+      shown.append(request.m_viewshed);
+    else
+      hidden.append(request.m_viewshed);
+  }
+
+  if (!m_analysisOverlay.isNull())
+  {
+    for (Viewshed* viewshed : qAsConst(hidden))
+      m_analysisOverlay->analyses()->removeOne(viewshed);
+
+    for (Viewshed* viewshed : qAsConst(shown))
+      m_analysisOverlay->analyses()->append(viewshed);
+  }
+
+  for (Viewshed* viewshed : qAsConst(hidden))
+    emit shownChanged(viewshed);
+
+  for (Viewshed* viewshed : qAsConst(shown))
+    emit shownChanged(viewshed);
+}
+
+/*!
+  \internal
+ */
+void ViewshedPool::trimIdle()
+{
+  while (m_idleLocationViewsheds.size() > m_idleCapacity)
+    delete m_idleLocationViewsheds.takeLast();
+
+  while (m_idleGeoElementViewsheds.size() > m_idleCapacity)
+    delete m_idleGeoElementViewsheds.takeLast();
+
+  while (m_idleGraphics.size() > m_idleCapacity)
+    delete m_idleGraphics.takeLast();
+}
+
+} // Dsa
+
+// Signal Documentation
+/*!
+  \fn void ViewshedPool::shownChanged(Esri::ArcGISRuntime::Viewshed* viewshed);
+  \brief Signal emitted when \a viewshed is added to or removed from the overlay.
+
+  \sa isShown
+ */
@@ -0,0 +1,109 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef VIEWSHEDPOOL_H
+#define VIEWSHEDPOOL_H
+
+// Qt headers
+#include <QList>
+#include <QObject>
+#include <QPointer>
+
+namespace Esri {
+  namespace ArcGISRuntime {
+    class AnalysisOverlay;
+    class GeoElementViewshed;
+    class Geometry;
+    class Graphic;
+    class LocationViewshed;
+    class Point;
+    class Viewshed;
+  }
+}
+
+namespace Dsa {
+
+class ViewshedPool : public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit ViewshedPool(Esri::ArcGISRuntime::AnalysisOverlay* analysisOverlay, QObject* parent = nullptr);
+  ~ViewshedPool();
+
+  Esri::ArcGISRuntime::AnalysisOverlay* analysisOverlay() const;
+
+  Esri::ArcGISRuntime::LocationViewshed* acquireLocationViewshed(const Esri::ArcGISRuntime::Point& point,
+                                                                 double heading, double pitch,
+                                                                 double horizontalAngle, double verticalAngle,
+                                                                 double minDistance, double maxDistance);
+  Esri::ArcGISRuntime::GeoElementViewshed* acquireGeoElementViewshed(const Esri::ArcGISRuntime::Geometry& observerGeometry,
+                                                                     double horizontalAngle, double verticalAngle,
+                                                                     double minDistance, double maxDistance);
+  Esri::ArcGISRuntime::Graphic* acquireGraphic(const Esri::ArcGISRuntime::Point& point);
+
+  void release(Esri::ArcGISRuntime::Viewshed* viewshed);
+  void releaseGraphic(Esri::ArcGISRuntime::Graphic* graphic);
+
+  void show(Esri::ArcGISRuntime::Viewshed* viewshed, int priority = 0);
+  void withdraw(Esri::ArcGISRuntime::Viewshed* viewshed);
+  void setPriority(Esri::ArcGISRuntime::Viewshed* viewshed, int priority);
+  bool isShown(Esri::ArcGISRuntime::Viewshed* viewshed) const;
+
+  int concurrencyCap() const;
+  void setConcurrencyCap(int concurrencyCap);
+
+  int idleCapacity() const;
+  void setIdleCapacity(int idleCapacity);
+  void reserve(int count);
+
+  int shownCount() const;
+  int queuedCount() const;
+
+signals:
+  void shownChanged(Esri::ArcGISRuntime::Viewshed* viewshed);
+
+private:
+  Q_DISABLE_COPY(ViewshedPool)
+  ViewshedPool() = delete;
+
+  struct Request
+  {
+    QPointer<Esri::ArcGISRuntime::Viewshed> m_viewshed;
+    int m_priority = 0;
+    quint64 m_order = 0;
+    bool m_shown = false;
+  };
+
+  Esri::ArcGISRuntime::LocationViewshed* createLocationViewshed();
+  Esri::ArcGISRuntime::GeoElementViewshed* createGeoElementViewshed();
+  int indexOf(Esri::ArcGISRuntime::Viewshed* viewshed) const;
+  void schedule();
+  void trimIdle();
+
+  QPointer<Esri::ArcGISRuntime::AnalysisOverlay> m_analysisOverlay;
+  QList<Request> m_requests;
+  QList<Esri::ArcGISRuntime::LocationViewshed*> m_idleLocationViewsheds;
+  QList<Esri::ArcGISRuntime::GeoElementViewshed*> m_idleGeoElementViewsheds;
+  QList<Esri::ArcGISRuntime::Graphic*> m_idleGraphics;
+  quint64 m_nextOrder = 0;
+  int m_concurrencyCap = 16;
+  int m_idleCapacity = 8;
+};
+
+} // Dsa
+
+#endif // VIEWSHEDPOOL_H
@@ -0,0 +1,557 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "ViewshedRasterCache.h"
+
+// dsa app headers
+#include "GeodesicKernels.h"
+
+// C++ API headers
+#include "GeometryEngine.h"
+#include "Surface.h"
+
+// Qt headers
+#include <QColor>
+#include <QSet>
+#include <QThread>
+#include <QThreadPool>
+
+// STL headers
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+namespace
+{
+double metersPerDegreeLongitude(double latitude)
+{
+  return Geodesic::s_metersPerDegree * std::max(std::cos(latitude * M_PI / 180.0), 0.01);
+}
+}
+
+/*!
+  \class Dsa::ViewshedRasterCache
+  \inmodule Dsa
+  \inherits QObject
+  \brief Computes viewsheds for a list of observers in the background and caches
+  the results as compact rasters.
+
+  Each viewshed covers a square grid of 64 x 64 cells centred on the observer and
+  extending \c m_maxDistance meters in each direction. The elevation of each cell is
+  sampled from an \l Esri::ArcGISRuntime::Surface, one observer at a time, and the
+  visibility of every cell is then computed on a pool of worker threads by tracing
+  a ray from the observer to the cell. The result is stored as one bit per cell,
+  keyed by the observer position, heading, horizontal angle, distances and offset.
+
+  Cached viewsheds can be displayed immediately with \l image and \l extent, without
+  running any further analysis. Visible cells are green and obstructed cells are red,
+  as for \l Esri::ArcGISRuntime::Viewshed.
+ */
+
+/*!
+  \brief Constructor taking an optional \a parent.
+ */
+ViewshedRasterCache::ViewshedRasterCache(QObject* parent):
+  QObject(parent),
+  m_threadPool(new QThreadPool(this))
+{
+  m_threadPool->setMaxThreadCount(std::max(1, QThread::idealThreadCount()));
+}
+
+/*!
+  \brief Destructor.
+ */
+ViewshedRasterCache::~ViewshedRasterCache()
+{
+  // no result may be handed back once the cache has gone
+  m_threadPool->clear();
+  m_threadPool->waitForDone();
+}
+
+/*!
+  \brief Computes the viewshed for each of the \a observers, using the elevation of \a surface.
+
+  Observers whose viewshed is already cached, or is already being computed, are skipped.
+  \l rasterComputed is emitted as each viewshed is cached and \l finished once all of
+  them have been.
+ */
+void ViewshedRasterCache::compute(Surface* surface, const QList<Parameters>& observers)
+{
+  if (!surface)
+    return;
+
+  if (surface != m_surface)
+  {
+    disconnect(m_elevationConnection);
+    m_surface = surface;
+    m_elevationConnection = connect(m_surface, &Surface::locationToElevationCompleted,
+                                    this, &ViewshedRasterCache::handleElevation);
+  }
+
+  QSet<QString> pendingKeys;
+  for (const Job& job : qAsConst(m_pendingJobs))
+    pendingKeys.insert(job.m_key);
+
+  if (m_sampling)
+    pendingKeys.insert(m_currentJob.m_key);
+
+  for (const Parameters& observer : observers)
+  {
+    Job job;
+    job.m_parameters = toWgs84(observer);
+    if (job.m_parameters.m_observer.isEmpty() || job.m_parameters.m_maxDistance <= 0.0)
+      continue;
+
+    job.m_key = key(job.m_parameters);
+    if (m_rasters.contains(job.m_key) || pendingKeys.contains(job.m_key))
+      continue;
+
+    pendingKeys.insert(job.m_key);
+    m_pendingJobs.append(job);
+    ++m_totalCount;
+  }
+
+  emit progressChanged();
+
+  if (!m_sampling)
+    startNextJob();
+}
+
+/*!
+  \brief Stops computing any viewsheds which have not yet been cached.
+ */
+void ViewshedRasterCache::cancel()
+{
+  // results which are still being computed are discarded when they arrive
+  ++m_generation;
+
+  m_pendingJobs.clear();
+  m_currentJob = Job();
+  m_sampleTasks.clear();
+  m_sampling = false;
+  m_runningCount = 0;
+  m_completedCount = 0;
+  m_totalCount = 0;
+
+  emit progressChanged();
+}
+
+/*!
+  \brief Returns the number of viewsheds cached since computation started.
+ */
+int ViewshedRasterCache::completedCount() const
+{
+  return m_completedCount;
+}
+
+/*!
+  \brief Returns the number of viewsheds requested since computation started.
+ */
+int ViewshedRasterCache::totalCount() const
+{
+  return m_totalCount;
+}
+
+/*!
+  \brief Returns whether any viewsheds are still being computed.
+ */
+bool ViewshedRasterCache::isComputing() const
+{
+  return m_sampling || !m_pendingJobs.isEmpty() || m_runningCount > 0;
+}
+
+/*!
+  \brief Returns whether the viewshed for \a parameters is cached.
+ */
+bool ViewshedRasterCache::contains(const Parameters& parameters) const
+{
+  return m_rasters.contains(key(toWgs84(parameters)));
+}
+
+/*!
+  \brief Sets \a visible to whether \a location can be seen in the cached viewshed
+  for \a parameters.
+
+  Locations outside of the observer's field of view or beyond its distances are not
+  visible. The test is a lookup of the cell containing \a location, so it is cheap
+  enough to be repeated for many locations.
+
+  Returns \c false, leaving \a visible unchanged, if the viewshed has not been computed.
+ */
+bool ViewshedRasterCache::isVisible(const Parameters& parameters, const Point& location, bool& visible) const
+{
+  const Parameters wgs84 = toWgs84(parameters);
+  const auto findIt = m_rasters.constFind(key(wgs84));
+  if (findIt == m_rasters.constEnd())
+    return false;
+
+  const Point wgs84Location = location.isEmpty() || location.spatialReference() == SpatialReference::wgs84()
+                                ? location
+                                : geometry_cast<Point>(GeometryEngine::project(location, SpatialReference::wgs84()));
+  visible = false;
+  if (wgs84Location.isEmpty())
+    return true;
+
+  const double cellSize = 2.0 * wgs84.m_maxDistance / s_rasterSize;
+  const double y = wgs84.m_observer.y();
+  const double east = (wgs84Location.x() - wgs84.m_observer.x()) * metersPerDegreeLongitude(y);
+  const double north = (wgs84Location.y() - y) * Geodesic::s_metersPerDegree;
+  const int column = static_cast<int>(std::floor(east / cellSize + s_rasterSize / 2.0));
+  const int row = static_cast<int>(std::floor(north / cellSize + s_rasterSize / 2.0));
+  if (column < 0 || column >= s_rasterSize || row < 0 || row >= s_rasterSize || !isInField(wgs84, column, row))
+    return true;
+
+  const int index = row * s_rasterSize + column;
+  visible = findIt.value().m_visible.at(index / 64) & (quint64(1) << (index % 64));
+  return true;
+}
+
+/*!
+  \brief Returns an image of the cached viewshed for \a parameters, or a null image if
+  it has not been computed.
+
+  The image covers \l extent, with north at the top. Cells outside of the observer's
+  field of view are transparent.
+ */
+QImage ViewshedRasterCache::image(const Parameters& parameters) const
+{
+  const auto findIt = m_rasters.constFind(key(toWgs84(parameters)));
+  if (findIt == m_rasters.constEnd())
+    return QImage();
+
+  const Raster& raster = findIt.value();
+  const QRgb visibleColor = QColor(0, 255, 0, 128).rgba();
+  const QRgb obstructedColor = QColor(255, 0, 0, 128).rgba();
+
+  QImage rasterImage(s_rasterSize, s_rasterSize, QImage::Format_ARGB32);
+  rasterImage.fill(Qt::transparent);
+  for (int row = 0; row < s_rasterSize; ++row)
+  {
+    for (int column = 0; column < s_rasterSize; ++column)
+    {
+      if (!isInField(raster.m_parameters, column, row))
+        continue;
+
+      const int index = row * s_rasterSize + column;
+      const bool visible = raster.m_visible.at(index / 64) & (quint64(1) << (index % 64));
+      rasterImage.setPixel(column, s_rasterSize - 1 - row, visible ? visibleColor : obstructedColor);
+    }
+  }
+
+  return rasterImage;
+}
+
+/*!
+  \brief Returns the WGS84 extent covered by the viewshed for \a parameters.
+ */
+Envelope ViewshedRasterCache::extent(const Parameters& parameters) const
+{
+  const Parameters wgs84 = toWgs84(parameters);
+  if (wgs84.m_observer.isEmpty())
+    return Envelope();
+
+  const double x = wgs84.m_observer.x();
+  const double y = wgs84.m_observer.y();
+  const double halfWidth = wgs84.m_maxDistance / metersPerDegreeLongitude(y);
+  const double halfHeight = wgs84.m_maxDistance / Geodesic::s_metersPerDegree;
+
+  return Envelope(x - halfWidth, y - halfHeight, x + halfWidth, y + halfHeight, SpatialReference::wgs84());
+}
+
+/*!
+  \brief Discards every cached viewshed and stops any computation.
+ */
+void ViewshedRasterCache::clear()
+{
+  cancel();
+  m_rasters.clear();
+}
+
+/*!
+  \internal
+
+  Returns the cache key for the WGS84 \a parameters.
+ */
+QString ViewshedRasterCache::key(const Parameters& parameters)
+{
+  return QString("%1,%2,%3,%4,%5,%6,%7")
+      .arg(parameters.m_observer.x(), 0, 'f', 6)
+      .arg(parameters.m_observer.y(), 0, 'f', 6)
+      .arg(parameters.m_heading, 0, 'f', 1)
+      .arg(parameters.m_horizontalAngle, 0, 'f', 1)
+      .arg(parameters.m_minDistance, 0, 'f', 1)
+      .arg(parameters.m_maxDistance, 0, 'f', 1)
+      .arg(parameters.m_offsetZ, 0, 'f', 1);
+}
+
+/*!
+  \internal
+
+  Returns \a parameters with the observer in WGS84. The heading is ignored
+  for 360 degree viewsheds.
+ */
+ViewshedRasterCache::Parameters ViewshedRasterCache::toWgs84(const Parameters& parameters)
+{
+  Parameters wgs84 = parameters;
+  if (!wgs84.m_observer.isEmpty() && wgs84.m_observer.spatialReference() != SpatialReference::wgs84())
+    wgs84.m_observer = geometry_cast<Point>(GeometryEngine::project(wgs84.m_observer, SpatialReference::wgs84()));
+
+  if (wgs84.m_horizontalAngle >= 360.0)
+  {
+    wgs84.m_horizontalAngle = 360.0;
+    wgs84.m_heading = 0.0;
+  }
+
+  return wgs84;
+}
+
+/*!
+  \internal
+
+  Returns the WGS84 location of the centre of the cell at \a column and \a row,
+  where row \c 0 is the most southerly.
+ */
+Point ViewshedRasterCache::cellCenter(const Parameters& parameters, int column, int row)
+{
+  const double cellSize = 2.0 * parameters.m_maxDistance / s_rasterSize;
+  const double east = (column + 0.5 - s_rasterSize / 2.0) * cellSize;
+  const double north = (row + 0.5 - s_rasterSize / 2.0) * cellSize;
+  const double y = parameters.m_observer.y();
+
+  return Point(parameters.m_observer.x() + east / metersPerDegreeLongitude(y),
+               y + north / Geodesic::s_metersPerDegree,
+               SpatialReference::wgs84());
+}
+
+/*!
+  \internal
+
+  Returns whether the cell at \a column and \a row is within the distances
+  and horizontal angle of the observer in \a parameters.
+ */
+bool ViewshedRasterCache::isInField(const Parameters& parameters, int column, int row)
+{
+  const double cellSize = 2.0 * parameters.m_maxDistance / s_rasterSize;
+  const double east = (column + 0.5 - s_rasterSize / 2.0) * cellSize;
+  const double north = (row + 0.5 - s_rasterSize / 2.0) * cellSize;
+  const double distance = std::hypot(east, north);
+  if (distance < parameters.m_minDistance || distance > parameters.m_maxDistance)
+    return false;
+
+  if (parameters.m_horizontalAngle >= 360.0)
+    return true;
+
+  const double bearing = std::atan2(east, north) * 180.0 / M_PI;
+  const double offset = std::fmod(bearing - parameters.m_heading + 540.0, 360.0) - 180.0;
+  return std::abs(offset) <= parameters.m_horizontalAngle / 2.0;
+}
+
+/*!
+  \internal
+
+  Returns one bit per cell for whether the cell can be seen from the observer in
+  \a parameters, given the sampled \a elevations. The last elevation is that of
+  the ground below the observer.
+
+  This only uses its arguments, so it can be run on a worker thread.
+ */
+QVector<quint64> ViewshedRasterCache::computeVisibility(const Parameters& parameters, const QVector<float>& elevations)
+{
+  constexpr int cellCount = s_rasterSize * s_rasterSize;
+  QVector<quint64> visible(cellCount / 64, 0);
+
+  const double cellSize = 2.0 * parameters.m_maxDistance / s_rasterSize;
+  const double observerHeight = elevations.at(cellCount) + std::max(parameters.m_offsetZ, s_minimumObserverHeight);
+  const double observerPosition = s_rasterSize / 2.0;
+
+  for (int row = 0; row < s_rasterSize; ++row)
+  {
+    for (int column = 0; column < s_rasterSize; ++column)
+    {
+      if (!isInField(parameters, column, row))
+        continue;
+
+      const double dx = column + 0.5 - observerPosition;
+      const double dy = row + 0.5 - observerPosition;
+      const double distance = std::hypot(dx, dy) * cellSize;
+      const int index = row * s_rasterSize + column;
+      const double targetSlope = (elevations.at(index) - observerHeight) / distance;
+
+      // the target is hidden if any cell between it and the observer rises above the line of sight
+      const int steps = static_cast<int>(std::ceil(std::max(std::abs(dx), std::abs(dy))));
+      double maximumSlope = -std::numeric_limits<double>::infinity();
+      for (int step = 1; step < steps; ++step)
+      {
+        const double fraction = static_cast<double>(step) / steps;
+        const int stepColumn = std::min(s_rasterSize - 1, std::max(0, static_cast<int>(std::floor(observerPosition + dx * fraction))));
+        const int stepRow = std::min(s_rasterSize - 1, std::max(0, static_cast<int>(std::floor(observerPosition + dy * fraction))));
+        if (stepColumn == column && stepRow == row)
+          break;
+
+        const double slope = (elevations.at(stepRow * s_rasterSize + stepColumn) - observerHeight) / (distance * fraction);
+        maximumSlope = std::max(maximumSlope, slope);
+      }
+
+      if (targetSlope >= maximumSlope)
+        visible[index / 64] |= quint64(1) << (index % 64);
+    }
+  }
+
+  return visible;
+}
+
+/*!
+  \internal
+
+  Starts sampling the elevations for the next pending viewshed.
+ */
+void ViewshedRasterCache::startNextJob()
+{
+  m_sampleTasks.clear();
+
+  if (m_pendingJobs.isEmpty() || !m_surface)
+  {
+    m_sampling = false;
+    m_currentJob = Job();
+    if (m_runningCount == 0)
+      emit finished();
+
+    return;
+  }
+
+  m_currentJob = m_pendingJobs.takeFirst();
+
+  // one sample for each cell and one for the ground below the observer
+  const int sampleCount = s_rasterSize * s_rasterSize + 1;
+  m_currentJob.m_elevations.fill(0.0f, sampleCount);
+  m_currentJob.m_remainingSamples = sampleCount;
+  m_currentJob.m_nextSample = 0;
+  m_sampling = true;
+
+  requestSamples();
+}
+
+/*!
+  \internal
+
+  Requests the elevation of further cells of the current viewshed, limiting the
+  number of requests which are in progress at once.
+ */
+void ViewshedRasterCache::requestSamples()
+{
+  if (!m_surface)
+  {
+    cancel();
+    return;
+  }
+
+  const int cellCount = s_rasterSize * s_rasterSize;
+  while (m_sampleTasks.size() < s_maximumSampleRequests && m_currentJob.m_nextSample <= cellCount)
+  {
+    const int sample = m_currentJob.m_nextSample++;
+    const Point location = sample == cellCount ? m_currentJob.m_parameters.m_observer
+                                               : cellCenter(m_currentJob.m_parameters, sample % s_rasterSize, sample / s_rasterSize);
+
+    m_sampleTasks.insert(m_surface->locationToElevation(location).taskId(), sample);
+  }
+}
+
+/*!
+  \internal
+
+  Stores the \a elevation sampled by \a taskId. Once every cell has been sampled,
+  the visibility is computed on a worker thread while the next viewshed is sampled.
+ */
+void ViewshedRasterCache::handleElevation(QUuid taskId, double elevation)
+{
+  auto findIt = m_sampleTasks.find(taskId);
+  if (findIt == m_sampleTasks.end())
+    return;
+
+  m_currentJob.m_elevations[findIt.value()] = static_cast<float>(elevation);
+  m_sampleTasks.erase(findIt);
+
+  if (--m_currentJob.m_remainingSamples > 0)
+  {
+    requestSamples();
+    return;
+  }
+
+  const Job job = m_currentJob;
+  const int generation = m_generation;
+  ++m_runningCount;
+
+  m_threadPool->start([this, job, generation]()
+  {
+    Raster raster;
+    raster.m_parameters = job.m_parameters;
+    raster.m_visible = computeVisibility(job.m_parameters, job.m_elevations);
+
+    QMetaObject::invokeMethod(this, [this, job, raster, generation]()
+    {
+      // the computation was cancelled
+      if (generation != m_generation)
+        return;
+
+      --m_runningCount;
+      handleRasterComputed(job.m_key, raster);
+    }, Qt::QueuedConnection);
+  });
+
+  startNextJob();
+}
+
+/*!
+  \internal
+
+  Caches the computed \a raster under \a key.
+ */
+void ViewshedRasterCache::handleRasterComputed(const QString& key, const Raster& raster)
+{
+  m_rasters.insert(key, raster);
+  ++m_completedCount;
+
+  emit progressChanged();
+  emit rasterComputed(raster.m_parameters.m_observer);
+
+  if (!isComputing())
+    emit finished();
+}
+
+} // Dsa
+
+// Signal Documentation
+/*!
+  \fn void ViewshedRasterCache::progressChanged();
+  \brief Signal emitted when the \l completedCount or \l totalCount changes.
+ */
+
+/*!
+  \fn void ViewshedRasterCache::rasterComputed(const Esri::ArcGISRuntime::Point& observer);
+  \brief Signal emitted when the viewshed for \a observer has been cached.
+ */
+
+/*!
+  \fn void ViewshedRasterCache::finished();
+  \brief Signal emitted when every requested viewshed has been cached.
+ */
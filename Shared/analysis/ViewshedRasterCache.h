@@ -0,0 +1,129 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef VIEWSHEDRASTERCACHE_H
+#define VIEWSHEDRASTERCACHE_H
+
+// C++ API headers
+#include "Envelope.h"
+#include "Point.h"
+
+// Qt headers
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QUuid>
+#include <QVector>
+
+class QThreadPool;
+
+namespace Esri {
+  namespace ArcGISRuntime {
+    class Surface;
+  }
+}
+
+namespace Dsa {
+
+class ViewshedRasterCache : public QObject
+{
+  Q_OBJECT
+
+public:
+  struct Parameters
+  {
+    Esri::ArcGISRuntime::Point m_observer;
+    double m_heading = 0.0;
+    double m_horizontalAngle = 360.0;
+    double m_minDistance = 0.0;
+    double m_maxDistance = 1000.0;
+    double m_offsetZ = 0.0;
+  };
+
+  explicit ViewshedRasterCache(QObject* parent = nullptr);
+  ~ViewshedRasterCache();
+
+  void compute(Esri::ArcGISRuntime::Surface* surface, const QList<Parameters>& observers);
+  void cancel();
+
+  int completedCount() const;
+  int totalCount() const;
+  bool isComputing() const;
+
+  bool contains(const Parameters& parameters) const;
+  bool isVisible(const Parameters& parameters, const Esri::ArcGISRuntime::Point& location, bool& visible) const;
+  QImage image(const Parameters& parameters) const;
+  Esri::ArcGISRuntime::Envelope extent(const Parameters& parameters) const;
+
+  void clear();
+
+signals:
+  void progressChanged();
+  void rasterComputed(const Esri::ArcGISRuntime::Point& observer);
+  void finished();
+
+private:
+  Q_DISABLE_COPY(ViewshedRasterCache)
+
+  struct Raster
+  {
+    Parameters m_parameters;
+    QVector<quint64> m_visible;
+  };
+
+  struct Job
+  {
+    Parameters m_parameters;
+    QString m_key;
+    QVector<float> m_elevations;
+    int m_remainingSamples = 0;
+    int m_nextSample = 0;
+  };
+
+  static QString key(const Parameters& parameters);
+  static Parameters toWgs84(const Parameters& parameters);
+  static Esri::ArcGISRuntime::Point cellCenter(const Parameters& parameters, int column, int row);
+  static bool isInField(const Parameters& parameters, int column, int row);
+  static QVector<quint64> computeVisibility(const Parameters& parameters, const QVector<float>& elevations);
+
+  void startNextJob();
+  void requestSamples();
+  void handleElevation(QUuid taskId, double elevation);
+  void handleRasterComputed(const QString& key, const Raster& raster);
+
+  static constexpr int s_rasterSize = 64;
+  static constexpr int s_maximumSampleRequests = 256;
+  static constexpr double s_minimumObserverHeight = 2.0;
+
+  QThreadPool* m_threadPool = nullptr;
+  QPointer<Esri::ArcGISRuntime::Surface> m_surface;
+  QMetaObject::Connection m_elevationConnection;
+  QList<Job> m_pendingJobs;
+  Job m_currentJob;
+  bool m_sampling = false;
+  QHash<QUuid, int> m_sampleTasks;
+  QHash<QString, Raster> m_rasters;
+  int m_runningCount = 0;
+  int m_completedCount = 0;
+  int m_totalCount = 0;
+  int m_generation = 0;
+};
+
+} // Dsa
+
+#endif // VIEWSHEDRASTERCACHE_H
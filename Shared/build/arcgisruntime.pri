@@ -16,6 +16,9 @@
 
 CONFIG(deployment): DEFINES += DEPLOYMENT_BUILD
 
+# qmake CONFIG+=dsa_count_allocations counts the heap allocations made while decoding messages
+CONFIG(dsa_count_allocations): DEFINES += DSA_COUNT_ALLOCATIONS
+
 # Run against the compiled toolkit.
 include($$PWD/../../arcgis-runtime-toolkit-qt/uitools/toolkitcpp.pri)
 
@@ -0,0 +1,127 @@
+################################################################################
+#  Copyright 2012-2018 Esri
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#  http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+################################################################################
+
+# Optional unity (jumbo) build of the Shared sources, enabled with:
+#
+#   qmake CONFIG+=dsa_unity
+#
+# The sources of each Shared directory are compiled in batches of
+# DSA_UNITY_BATCH_SIZE files (default 12), each batch as a single generated
+# translation unit, so the ArcGIS Runtime and Qt headers are parsed once per
+# batch. Batches never span directories. Include this file after SOURCES is set,
+# and rerun qmake after adding or removing Shared sources.
+#
+# Sources in a batch share one translation unit, so their file-local names must
+# not clash. The sources of each directory are batched in name order, and qmake
+# stops with an error naming both files if two sources in a batch define the
+# same file-local constant, that is an s_ name declared const or constexpr at the
+# start of a line. Give one of them a distinct name, move a shared value into a
+# header, or list the source in DSA_UNITY_EXCLUDE. Other file-local names, such
+# as helper functions in anonymous namespaces, are not checked. Sources which
+# include platform headers that define macros are also listed in
+# DSA_UNITY_EXCLUDE, and are compiled on their own.
+
+dsa_unity {
+  isEmpty(DSA_UNITY_BATCH_SIZE): DSA_UNITY_BATCH_SIZE = 12
+
+  DSA_SHARED_DIR = $$clean_path($$PWD/..)
+  DSA_UNITY_DIR = $$OUT_PWD/unity
+  DSA_UNITY_SOURCE_DIRS = . alerts analysis messages packages utilities markup
+
+  DSA_UNITY_EXCLUDE += \
+    pch.cpp \
+    GPXTrack.cpp \
+    LocalDataCatalog.cpp \
+    LocationDisplay3d.cpp \
+    MemoryBudget.cpp \
+    analysis/ViewshedRasterCache.cpp \
+    utilities/UdpReceiver.cpp
+
+  # writes the batch $$2 of the sources $$1 to the directory $$3
+  defineTest(dsaWriteUnityBatch) {
+    batchSources = $$1
+    isEmpty(batchSources): return(true)
+
+    batchFile = $$3/dsa_unity_$${2}.cpp
+    batchLines = "// Generated by Shared/build/unity.pri, do not edit."
+    for(batchSource, batchSources): batchLines += "$${LITERAL_HASH}include \"$$batchSource\""
+    !write_file($$batchFile, batchLines): error("Cannot write $$batchFile")
+
+    DSA_UNITY_SOURCES += $$batchFile
+    export(DSA_UNITY_SOURCES)
+    return(true)
+  }
+
+  # returns the file-local constants defined by the source $$1
+  defineReplace(dsaFileLocalNames) {
+    sourceNames =
+    sourceLines = $$cat($$1, lines)
+    for(sourceLine, sourceLines) {
+      contains(sourceLine, "^(static )?(constexpr|const) [^=(]*[ *&]s_[A-Za-z0-9_]+([^A-Za-z0-9_(].*)?$") {
+        sourceNames += $$replace(sourceLine, "^[^=(]*[ *&](s_[A-Za-z0-9_]+)([^A-Za-z0-9_(].*)?$", "\\1")
+      }
+    }
+    return($$unique(sourceNames))
+  }
+
+  # the Shared sources which are compiled in a batch
+  dsaBatchedSources =
+  dsaBatchIndex = 0
+
+  for(dsaSourceDir, DSA_UNITY_SOURCE_DIRS) {
+    dsaBatch =
+    dsaBatchNames =
+    dsaDirSources = $$files($$DSA_SHARED_DIR/$$dsaSourceDir/*.cpp)
+    dsaDirSources = $$sorted(dsaDirSources)
+
+    for(dsaSource, dsaDirSources) {
+      dsaSource = $$clean_path($$dsaSource)
+      contains(DSA_UNITY_EXCLUDE, $$relative_path($$dsaSource, $$DSA_SHARED_DIR)): next()
+
+      # file-local names must be unique within the batch
+      dsaSourceNames = $$dsaFileLocalNames($$dsaSource)
+      for(dsaName, dsaSourceNames) {
+        contains(dsaBatchNames, $$dsaName) {
+          error("Unity build: $$dsaName is defined by both $$relative_path($$eval(dsaNameSource.$${dsaName}), $$DSA_SHARED_DIR) and $$relative_path($$dsaSource, $$DSA_SHARED_DIR), which are in the same batch. Rename one of them or add a source to DSA_UNITY_EXCLUDE.")
+        }
+        dsaNameSource.$${dsaName} = $$dsaSource
+      }
+      dsaBatchNames += $$dsaSourceNames
+
+      dsaBatch += $$dsaSource
+      dsaBatchedSources += $$dsaSource
+
+      equals(DSA_UNITY_BATCH_SIZE, $$size(dsaBatch)) {
+        dsaWriteUnityBatch($$dsaBatch, $$dsaBatchIndex, $$DSA_UNITY_DIR)
+        dsaBatchIndex = $$num_add($$dsaBatchIndex, 1)
+        dsaBatch =
+        dsaBatchNames =
+      }
+    }
+
+    dsaWriteUnityBatch($$dsaBatch, $$dsaBatchIndex, $$DSA_UNITY_DIR)
+    !isEmpty(dsaBatch): dsaBatchIndex = $$num_add($$dsaBatchIndex, 1)
+  }
+
+  # replace the batched sources with the batches
+  dsaSources =
+  for(dsaSource, SOURCES) {
+    !contains(dsaBatchedSources, $$clean_path($$absolute_path($$dsaSource, $$_PRO_FILE_PWD_))): dsaSources += $$dsaSource
+  }
+  SOURCES = $$dsaSources $$DSA_UNITY_SOURCES
+
+  message("Unity build: $$size(dsaBatchedSources) Shared sources in $$dsaBatchIndex batches")
+}
@@ -33,10 +33,76 @@
 #include "PolylineBuilder.h"
 #include "SceneView.h"
 
+// Qt headers
+#include <QLineF>
+#include <QPair>
+#include <QTimer>
+
 using namespace Esri::ArcGISRuntime;
 
 namespace Dsa {
 
+namespace {
+
+// returns the distance from point p to the segment a-b
+double distanceToSegment(const QPointF& p, const QPointF& a, const QPointF& b)
+{
+  const QPointF ab = b - a;
+  const double lengthSquared = QPointF::dotProduct(ab, ab);
+  if (lengthSquared == 0.0)
+    return QLineF(p, a).length();
+
+  const double t = qBound(0.0, QPointF::dotProduct(p - a, ab) / lengthSquared, 1.0);
+  return QLineF(p, a + t * ab).length();
+}
+
+// marks the points kept by a Douglas-Peucker simplification within tolerance
+QVector<bool> douglasPeucker(const QVector<QPointF>& points, double tolerance)
+{
+  QVector<bool> keep(points.size(), false);
+  if (points.size() < 3)
+  {
+    keep.fill(true);
+    return keep;
+  }
+
+  keep.first() = true;
+  keep.last() = true;
+
+  // iterate rather than recurse, as freehand parts have tens of thousands of points
+  QVector<QPair<int, int>> ranges{qMakePair(0, points.size() - 1)};
+  while (!ranges.isEmpty())
+  {
+    const auto range = ranges.takeLast();
+
+    double maxDistance = 0.0;
+    int maxIndex = -1;
+    for (int i = range.first + 1; i < range.second; ++i)
+    {
+      const double distance = distanceToSegment(points.at(i), points.at(range.first), points.at(range.second));
+      if (distance > maxDistance)
+      {
+        maxDistance = distance;
+        maxIndex = i;
+      }
+    }
+
+    if (maxIndex == -1 || maxDistance <= tolerance)
+      continue;
+
+    keep[maxIndex] = true;
+    ranges.append(qMakePair(range.first, maxIndex));
+    ranges.append(qMakePair(maxIndex, range.second));
+  }
+
+  return keep;
+}
+
+// the sketch geometry is updated at most this often while drawing, in ms
+constexpr int s_sketchRefreshInterval = 33;
+
+} // namespace
+
 /*!
   \class Dsa::AbstractSketchTool
   \inmodule Dsa
@@ -49,9 +115,14 @@ namespace Dsa {
  */
 AbstractSketchTool::AbstractSketchTool(QObject* parent) :
   AbstractTool(parent),
-  m_sketchOverlay(new GraphicsOverlay(this))
+  m_sketchOverlay(new GraphicsOverlay(this)),
+  m_sketchRefreshTimer(new QTimer(this))
 {
   m_sketchOverlay->setOverlayId("Sketch overlay");
+
+  m_sketchRefreshTimer->setSingleShot(true);
+  m_sketchRefreshTimer->setInterval(s_sketchRefreshInterval);
+  connect(m_sketchRefreshTimer, &QTimer::timeout, this, &AbstractSketchTool::refreshSketch);
 }
 
 /*!
@@ -132,6 +203,119 @@ Point AbstractSketchTool::normalizedPoint(double x, double y)
   return Point(x, y);
 }
 
+/*!
+  \brief Returns the tolerance, in pixels, within which freehand sketches are
+  decimated while drawing and simplified once drawn.
+
+  The default is \c 2 pixels: finer detail than this is not visible beneath
+  the line width, but would cost rendering, JSON size and bandwidth.
+ */
+double AbstractSketchTool::sketchTolerance() const
+{
+  return m_sketchTolerance;
+}
+
+/*!
+  \brief Sets the sketch tolerance to \a sketchTolerance pixels.
+
+  A tolerance of \c 0 keeps every vertex.
+ */
+void AbstractSketchTool::setSketchTolerance(double sketchTolerance)
+{
+  m_sketchTolerance = qMax(0.0, sketchTolerance);
+}
+
+/*!
+  \brief Appends \a drawPoint, drawn at the screen coordinate (\a x, \a y),
+  to the end of the part at \a partIndex. Returns whether the point was added.
+
+  Points within the \l sketchTolerance of the last added point are skipped,
+  unless \a force is \c true, as high-rate touch screens report far more
+  points than can be seen. A forced point is still skipped if it is at the
+  same screen position as the last one.
+ */
+bool AbstractSketchTool::addSketchVertex(int partIndex, double x, double y, const Point& drawPoint, bool force)
+{
+  if (partIndex != m_sketchScreenPart)
+  {
+    m_sketchScreenPoints.clear();
+    m_sketchScreenPart = partIndex;
+  }
+
+  const QPointF screenPoint(x, y);
+  if (!m_sketchScreenPoints.isEmpty())
+  {
+    const double distance = QLineF(m_sketchScreenPoints.last(), screenPoint).length();
+    if (distance == 0.0 || (!force && distance < m_sketchTolerance))
+      return false;
+  }
+
+  m_sketchScreenPoints.append(screenPoint);
+  insertPointInPart(partIndex, -1, drawPoint);
+  return true;
+}
+
+/*!
+  \brief Simplifies the freehand part at \a partIndex with Douglas-Peucker
+  in screen space, removing vertices which deviate from the line by no more
+  than the \l sketchTolerance. Returns the number of vertices removed.
+
+  Only the part most recently drawn with \l addSketchVertex can be simplified,
+  as the screen positions of its vertices are known.
+ */
+int AbstractSketchTool::simplifySketchPart(int partIndex)
+{
+  if (partIndex != m_sketchScreenPart || m_sketchTolerance <= 0.0 || !isMultiPartBuilder())
+    return 0;
+
+  MultipartBuilder* multipartBuilder = static_cast<MultipartBuilder*>(m_geometryBuilder);
+  if (partIndex < 0 || partIndex >= multipartBuilder->parts()->size())
+    return 0;
+
+  Part* part = multipartBuilder->parts()->part(partIndex);
+  const int pointCount = part->pointCount();
+  if (pointCount != m_sketchScreenPoints.size() || pointCount < 3)
+    return 0;
+
+  const QVector<bool> keep = douglasPeucker(m_sketchScreenPoints, m_sketchTolerance);
+
+  QList<Point> keptPoints;
+  QVector<QPointF> keptScreenPoints;
+  for (int i = 0; i < pointCount; ++i)
+  {
+    if (!keep.at(i))
+      continue;
+
+    keptPoints.append(part->point(i));
+    keptScreenPoints.append(m_sketchScreenPoints.at(i));
+  }
+
+  const int removedCount = pointCount - keptPoints.size();
+  if (removedCount == 0)
+    return 0;
+
+  part->removeAll();
+  for (const auto& point : qAsConst(keptPoints))
+    part->addPoint(point);
+
+  m_sketchScreenPoints = keptScreenPoints;
+  refreshSketch();
+
+  return removedCount;
+}
+
+/*!
+  \brief Applies any pending changes of the geometry builder to the sketch now.
+
+  Points inserted with \l insertPointInPart are only applied to the sketch
+  at a capped rate, so that long strokes are not redrawn for every point.
+ */
+void AbstractSketchTool::refreshSketch()
+{
+  m_sketchRefreshTimer->stop();
+  updateSketch();
+}
+
 /*!
   \brief Selects the part in the current sketch geometry at \a partIndex.
  */
@@ -160,7 +344,7 @@ void AbstractSketchTool::selectPartByIndex(int partIndex)
 void AbstractSketchTool::replaceGeometry(Geometry geometry)
 {
   m_geometryBuilder->replaceGeometry(geometry);
-  updateSketch();
+  refreshSketch();
 }
 
 /*!
@@ -191,7 +375,9 @@ int AbstractSketchTool::addPart()
 
 /*!
   \brief Inserts a new \l Esri::ArcGISRuntime::Point \a drawPoint in the sketch at \a partIndex, \a pointIndex.
-  Returns the index of the added Part or \c -1 if this is an invalid operation.
+
+  The sketch is updated shortly afterwards, together with any other points
+  inserted meanwhile; call \l refreshSketch to update it immediately.
  */
 void AbstractSketchTool::insertPointInPart(int partIndex, int pointIndex, const Point& drawPoint)
 {
@@ -213,7 +399,8 @@ void AbstractSketchTool::insertPointInPart(int partIndex, int pointIndex, const
     }
   }
 
-  updateSketch();
+  if (!m_sketchRefreshTimer->isActive())
+    m_sketchRefreshTimer->start();
 }
 
 /*!
@@ -25,6 +25,10 @@
 
 // Qt headers
 #include <QList>
+#include <QPointF>
+#include <QVector>
+
+class QTimer;
 
 namespace Esri {
   namespace ArcGISRuntime {
@@ -61,6 +65,13 @@ public:
   void insertPointInPart(int partIndex, int pointIndex, const Esri::ArcGISRuntime::Point& drawPoint);
   Esri::ArcGISRuntime::Point normalizedPoint(double x, double y);
 
+  double sketchTolerance() const;
+  void setSketchTolerance(double sketchTolerance);
+  bool addSketchVertex(int partIndex, double x, double y, const Esri::ArcGISRuntime::Point& drawPoint, bool force = false);
+  int simplifySketchPart(int partIndex);
+
+  void refreshSketch();
+
   Esri::ArcGISRuntime::GraphicsOverlay* sketchOverlay() const;
 
   // Functions that should be from the SketchEditor
@@ -76,6 +87,14 @@ protected:
   Esri::ArcGISRuntime::GeoView* m_geoView = nullptr;
   int m_selectedPartIndex = 0;
 
+  // screen positions of the vertices of the part being drawn, in pixels
+  QVector<QPointF> m_sketchScreenPoints;
+  int m_sketchScreenPart = -1;
+  double m_sketchTolerance = 2.0;
+
+  // sketch updates are applied at a capped rate rather than once per point
+  QTimer* m_sketchRefreshTimer = nullptr;
+
   // members that should be from the SketchEditor
   Esri::ArcGISRuntime::Symbol* m_sketchSymbol = nullptr;
 };
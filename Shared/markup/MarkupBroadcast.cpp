@@ -21,16 +21,17 @@
 #include "MarkupBroadcast.h"
 
 // dsa app headers
+#include "AllocationCounter.h"
 #include "DataListener.h"
-#include "DataSender.h"
+#include "MarkupStore.h"
+#include "OutboundTransport.h"
 
 // Qt headers
-#include <QDateTime>
-#include <QFileInfo>
+#include <QCryptographicHash>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QString>
-#include <QUdpSocket>
+#include <QTimer>
 
 using namespace Esri::ArcGISRuntime;
 
@@ -43,6 +44,20 @@ const QString MarkupBroadcast::USERNAME_PROPERTYNAME = QStringLiteral("UserName"
 const QString MarkupBroadcast::NAMEKEY = QStringLiteral("name");
 const QString MarkupBroadcast::MARKUPKEY = QStringLiteral("markup");
 const QString MarkupBroadcast::SHAREDBYKEY = QStringLiteral("sharedBy");
+const QString MarkupBroadcast::ELEMENTSKEY = QStringLiteral("elements");
+const QString MarkupBroadcast::DELTAKEY = QStringLiteral("delta");
+const QString MarkupBroadcast::DELTABASEKEY = QStringLiteral("base");
+const QString MarkupBroadcast::DELTAKEEPKEY = QStringLiteral("keep");
+const QString MarkupBroadcast::CHUNKED_PROPERTYNAME = QStringLiteral("chunked");
+
+// chunks are spaced out so a large markup does not overrun the radio's queue, in ms
+static const int s_chunkInterval = 2;
+
+// after this many deltas in a row the whole markup is sent again, for teammates who missed one
+static const int s_maxDeltaCount = 4;
+
+// attempts after a failed write of a markup or chunk
+static const int s_sendRetries = 2;
 
 /*!
   \class Dsa::MarkupBroadcast
@@ -50,7 +65,18 @@ const QString MarkupBroadcast::SHAREDBYKEY = QStringLiteral("sharedBy");
   \inherits AbstractTool
   \brief Tool controller for broadcasting markups.
 
-  \sa DataSender
+  By default markups are compressed and sent in numbered chunks which fit
+  within the link MTU, and reassembled by \l MarkupChunker on receipt.
+  When a markup is sent again under the same name, only the elements added
+  since the last send go out, as a delta against it. Whole markups sent as a
+  single datagram, by older versions or with \c chunked set to \c false in
+  the \c MarkupConfig, are still received.
+
+  Received markups are saved by the \l MarkupStore, which writes them in the
+  background and keeps the parsed markup in memory for the layer created
+  from it.
+
+  \sa OutboundTransport
   \sa DataListener
  */
 
@@ -59,38 +85,13 @@ const QString MarkupBroadcast::SHAREDBYKEY = QStringLiteral("sharedBy");
  */
 MarkupBroadcast::MarkupBroadcast(QObject *parent) :
   AbstractTool(parent),
-  m_dataSender(new DataSender(parent)),
-  m_dataListener(new DataListener(parent))
+  m_dataListener(new DataListener(parent)),
+  m_chunkTimer(new QTimer(this))
 {
-  connect(m_dataListener, &DataListener::dataReceived, this, [this](const QByteArray& data)
-  {
-    QJsonDocument markupJson = QJsonDocument::fromJson(data);
-
-    // write the JSON to disk
-    const QJsonObject markupObject = markupJson.object();
-    const QString sharedBy = markupObject.value(SHAREDBYKEY).toString();
-
-    const QString markupName = markupObject.value(MARKUPKEY).toObject().value(NAMEKEY).toString();
-    const QString markupFolderName = QString("%1/OperationalData").arg(m_rootDataDirectory);
-    QString markupFileName = QString("%1/%2.markup").arg(markupFolderName, markupName);
-    QFileInfo fileInfo(markupFileName);
-    if (fileInfo.exists())
-      markupFileName = QString("%1/%2_%3.markup").arg(markupFolderName, markupName, QString::number(QDateTime::currentDateTime().currentMSecsSinceEpoch()));
-
-    QFile markupFile(markupFileName);
-    if (markupFile.open(QIODevice::ReadWrite))
-    {
-      QTextStream stream(&markupFile);
-      QString strJson(markupJson.toJson(QJsonDocument::Compact));
-      stream << strJson << Qt::endl;
-
-      // process the markup differently if it is the one that you sent
-      if (m_username == sharedBy)
-        emit this->markupSent(markupFileName);
-      else
-        emit this->markupReceived(markupFileName, sharedBy);
-    }
-  });
+  connect(m_dataListener, &DataListener::dataReceived, this, &MarkupBroadcast::handleDatagram);
+
+  m_chunkTimer->setInterval(s_chunkInterval);
+  connect(m_chunkTimer, &QTimer::timeout, this, &MarkupBroadcast::sendNextChunk);
 
   ToolManager::instance().addTool(this);
 }
@@ -128,7 +129,11 @@ void MarkupBroadcast::setProperties(const QVariantMap& properties)
     if (ok)
       m_udpPort = newPort;
   }
-  updateDataSender();
+
+  m_chunked = markupPortConfig.value(CHUNKED_PROPERTYNAME, true).toBool();
+
+  m_transport = UdpTransport::fromProperties(properties);
+
   updateDataListener();
 }
 
@@ -137,23 +142,181 @@ void MarkupBroadcast::setProperties(const QVariantMap& properties)
  */
 void MarkupBroadcast::broadcastMarkup(const QString& json)
 {
-  if (!m_dataSender)
+  DSA_ALLOCATION_SCOPE(Markup);
+
+  if (m_udpPort < 0)
+    return;
+
+  if (!m_chunked)
+  {
+    sendData(json.toUtf8());
     return;
+  }
+
+  const QJsonObject markupObject = QJsonDocument::fromJson(json.toUtf8()).object();
+  const QList<QByteArray> chunks = MarkupChunker::split(createPayload(markupObject));
+  if (chunks.isEmpty())
+    return;
+
+  m_pendingChunks.append(chunks);
+  if (!m_chunkTimer->isActive())
+    m_chunkTimer->start();
+}
+
+/*!
+  \internal
+  \brief Returns the payload to send for \a markupObject: a delta holding the
+  elements added since the markup of the same name was last sent, or else the
+  whole markup.
+ */
+QByteArray MarkupBroadcast::createPayload(const QJsonObject& markupObject)
+{
+  const QJsonArray elements = markupObject.value(MARKUPKEY).toObject().value(ELEMENTSKEY).toArray();
+  const QString markupName = markupObject.value(MARKUPKEY).toObject().value(NAMEKEY).toString();
+  const QString hash = markupHash(markupObject);
+
+  auto sentIt = m_sentMarkups.find(markupName);
+  if (sentIt == m_sentMarkups.end() || sentIt->m_deltaCount >= s_maxDeltaCount)
+  {
+    m_sentMarkups.insert(markupName, MarkupState{elements, hash, 0});
+    return QJsonDocument(markupObject).toJson(QJsonDocument::Compact);
+  }
+
+  // sketches grow by appending elements, so send what follows the common prefix
+  const QJsonArray& sentElements = sentIt->m_elements;
+  int keep = 0;
+  const int commonSize = qMin(sentElements.size(), elements.size());
+  while (keep < commonSize && sentElements.at(keep) == elements.at(keep))
+    ++keep;
 
-  m_dataSender->sendData(json.toUtf8());
+  if (keep == 0 && !elements.isEmpty())
+  {
+    m_sentMarkups.insert(markupName, MarkupState{elements, hash, 0});
+    return QJsonDocument(markupObject).toJson(QJsonDocument::Compact);
+  }
+
+  QJsonArray appended;
+  for (int i = keep; i < elements.size(); ++i)
+    appended.append(elements.at(i));
+
+  QJsonObject markup = markupObject.value(MARKUPKEY).toObject();
+  markup.insert(ELEMENTSKEY, appended);
+
+  QJsonObject deltaObject = markupObject;
+  deltaObject.insert(MARKUPKEY, markup);
+  deltaObject.insert(DELTAKEY, QJsonObject{{DELTABASEKEY, sentIt->m_hash}, {DELTAKEEPKEY, keep}});
+
+  *sentIt = MarkupState{elements, hash, sentIt->m_deltaCount + 1};
+  return QJsonDocument(deltaObject).toJson(QJsonDocument::Compact);
 }
 
 /*!
- \brief Updates the UDP Socket used for the DataSender.
+  \internal
+  \brief Sends the next queued chunk.
  */
-void MarkupBroadcast::updateDataSender()
+void MarkupBroadcast::sendNextChunk()
 {
-  if (!m_dataSender)
+  if (m_pendingChunks.isEmpty() || m_udpPort < 0)
+  {
+    m_chunkTimer->stop();
     return;
+  }
 
-  QUdpSocket* udpSocket = new QUdpSocket(m_dataSender);
-  udpSocket->connectToHost(QHostAddress::Broadcast, m_udpPort, QIODevice::WriteOnly);
-  m_dataSender->setDevice(udpSocket);
+  sendData(m_pendingChunks.takeFirst());
+}
+
+/*!
+  \internal
+  \brief Queues \a data to be sent on the shared outbound transport.
+ */
+void MarkupBroadcast::sendData(const QByteArray& data)
+{
+  OutboundTransport::SendOptions options;
+  options.m_priority = OutboundTransport::Priority::Bulk;
+  options.m_retries = s_sendRetries;
+  OutboundTransport::instance()->send(m_transport, m_udpPort, data, options);
+}
+
+/*!
+  \internal
+  \brief Handles a received datagram holding either a whole markup or a chunk of one.
+ */
+void MarkupBroadcast::handleDatagram(const QByteArray& data)
+{
+  DSA_ALLOCATION_SCOPE(Markup);
+
+  if (!MarkupChunker::isChunk(data))
+  {
+    processMarkup(data);
+    return;
+  }
+
+  QByteArray payload;
+  if (m_chunker.addChunk(data, payload))
+    processMarkup(payload);
+}
+
+/*!
+  \internal
+  \brief Stores the markup in \a data, first applying it to the markup
+  it is a delta of.
+ */
+void MarkupBroadcast::processMarkup(const QByteArray& data)
+{
+  QJsonObject markupObject = QJsonDocument::fromJson(data).object();
+  const QString sharedBy = markupObject.value(SHAREDBYKEY).toString();
+
+  QJsonObject markup = markupObject.value(MARKUPKEY).toObject();
+  const QString markupName = markup.value(NAMEKEY).toString();
+  const QString markupKey = QString("%1/%2").arg(sharedBy, markupName);
+
+  if (markupObject.contains(DELTAKEY))
+  {
+    // a delta can only be applied to the markup it was made against
+    const QJsonObject delta = markupObject.take(DELTAKEY).toObject();
+    auto receivedIt = m_receivedMarkups.constFind(markupKey);
+    if (receivedIt == m_receivedMarkups.constEnd() || receivedIt->m_hash != delta.value(DELTABASEKEY).toString())
+      return;
+
+    const int keep = delta.value(DELTAKEEPKEY).toInt();
+    if (keep < 0 || keep > receivedIt->m_elements.size())
+      return;
+
+    QJsonArray elements;
+    for (int i = 0; i < keep; ++i)
+      elements.append(receivedIt->m_elements.at(i));
+
+    const QJsonArray appended = markup.value(ELEMENTSKEY).toArray();
+    for (const auto& element : appended)
+      elements.append(element);
+
+    markup.insert(ELEMENTSKEY, elements);
+    markupObject.insert(MARKUPKEY, markup);
+  }
+
+  const QString hash = markupHash(markupObject);
+  m_receivedMarkups.insert(markupKey, MarkupState{markup.value(ELEMENTSKEY).toArray(), hash, 0});
+
+  // the file is written in the background, and a markup received again keeps its file
+  const QString markupFolderName = QString("%1/OperationalData").arg(m_rootDataDirectory);
+  const QString markupFileName = MarkupStore::instance()->store(markupFolderName, markupName, markupObject, hash);
+
+  // process the markup differently if it is the one that you sent
+  if (m_username == sharedBy)
+    emit this->markupSent(markupFileName);
+  else
+    emit this->markupReceived(markupFileName, sharedBy);
+}
+
+/*!
+  \internal
+  \brief Returns a hash identifying the content of \a markupObject, which
+  the sender and receivers of a markup compute alike.
+ */
+QString MarkupBroadcast::markupHash(const QJsonObject& markupObject)
+{
+  const QByteArray json = QJsonDocument(markupObject).toJson(QJsonDocument::Compact);
+  return QString::fromLatin1(QCryptographicHash::hash(json, QCryptographicHash::Sha1).toHex());
 }
 
 /*!
@@ -164,9 +327,7 @@ void MarkupBroadcast::updateDataListener()
   if (!m_dataListener)
     return;
 
-  QUdpSocket* udpSocket = new QUdpSocket(this);
-  udpSocket->bind(m_udpPort, QUdpSocket::DontShareAddress | QUdpSocket::ReuseAddressHint);
-  m_dataListener->setDevice(udpSocket);
+  m_dataListener->setDevice(m_transport.createListener(m_udpPort, this));
 }
 
 } // Dsa
@@ -17,16 +17,25 @@
 #ifndef MARKUPBROADCAST_H
 #define MARKUPBROADCAST_H
 
+// dsa app headers
+#include "MarkupChunker.h"
+#include "UdpTransport.h"
+
 // toolkit headers
 #include "AbstractTool.h"
 
+// Qt headers
+#include <QHash>
+#include <QJsonArray>
+#include <QList>
+
 class QJsonObject;
 class QJsonDocument;
+class QTimer;
 
 namespace Dsa
 {
 
-class DataSender;
 class DataListener;
 
 class MarkupBroadcast : public AbstractTool
@@ -47,8 +56,22 @@ signals:
   void markupSent(const QString& filePath);
 
 private:
-  void updateDataSender();
   void updateDataListener();
+  void handleDatagram(const QByteArray& data);
+  void processMarkup(const QByteArray& data);
+  QByteArray createPayload(const QJsonObject& markupObject);
+  void sendNextChunk();
+  void sendData(const QByteArray& data);
+
+  static QString markupHash(const QJsonObject& markupObject);
+
+  // the elements of a markup as last sent or received, to create or apply deltas
+  struct MarkupState
+  {
+    QJsonArray m_elements;
+    QString m_hash;
+    int m_deltaCount = 0;
+  };
 
   static const QString MARKUPCONFIG_PROPERTYNAME;
   static const QString ROOTDATA_PROPERTYNAME;
@@ -57,11 +80,24 @@ private:
   static const QString MARKUPKEY;
   static const QString NAMEKEY;
   static const QString SHAREDBYKEY;
+  static const QString ELEMENTSKEY;
+  static const QString DELTAKEY;
+  static const QString DELTABASEKEY;
+  static const QString DELTAKEEPKEY;
+  static const QString CHUNKED_PROPERTYNAME;
   QString m_username;
   QString m_rootDataDirectory;
-  DataSender* m_dataSender;
   DataListener* m_dataListener;
   int m_udpPort = -1;
+  UdpTransport m_transport;
+
+  // chunked transfer of compressed markups and deltas
+  bool m_chunked = true;
+  MarkupChunker m_chunker;
+  QList<QByteArray> m_pendingChunks;
+  QTimer* m_chunkTimer = nullptr;
+  QHash<QString, MarkupState> m_sentMarkups;
+  QHash<QString, MarkupState> m_receivedMarkups;
 };
 
 } // Dsa
@@ -0,0 +1,233 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "MarkupChunker.h"
+
+// Qt headers
+#include <QDateTime>
+#include <QRandomGenerator>
+#include <QtEndian>
+
+// STL headers
+#include <cstring>
+
+namespace Dsa {
+
+namespace {
+
+// "DSAM", version, transfer ID, sequence number, chunk count
+constexpr char s_magic[] = {'D', 'S', 'A', 'M'};
+constexpr quint8 s_version = 1;
+constexpr int s_headerSize = 4 + 1 + 4 + 2 + 2;
+
+// transfers missing chunks for this long are abandoned, in ms
+constexpr qint64 s_transferTimeout = 30000;
+
+// the most transfers reassembled at once, beyond which the oldest is abandoned
+constexpr int s_maxPendingTransfers = 16;
+
+constexpr int s_maxChunkCount = 0xFFFF;
+
+} // namespace
+
+/*!
+  \class Dsa::MarkupChunker
+  \inmodule Dsa
+  \brief Splits markup payloads into compressed, numbered datagrams and
+  reassembles them on receipt.
+
+  A markup sent as one datagram larger than the link MTU is fragmented by
+  IP, and the loss of any fragment loses the whole markup. Radios lose
+  fragments often. Instead, the payload is compressed with zlib and split
+  into chunks of at most \l defaultChunkSize bytes, each carrying a
+  13 byte header:
+
+  \list
+    \li the magic bytes \c DSAM and a version byte,
+    \li a random 32 bit transfer ID shared by the chunks of a payload,
+    \li the 16 bit sequence number of the chunk,
+    \li the 16 bit number of chunks in the transfer.
+  \endlist
+
+  All integers are big endian. Chunks may arrive in any order or more than
+  once; a payload is returned once all of its chunks have arrived.
+ */
+
+/*!
+  \brief Constructor.
+ */
+MarkupChunker::MarkupChunker()
+{
+}
+
+/*!
+  \brief Destructor.
+ */
+MarkupChunker::~MarkupChunker()
+{
+}
+
+/*!
+  \brief Returns whether \a datagram is a chunk rather than a whole markup.
+ */
+bool MarkupChunker::isChunk(const QByteArray& datagram)
+{
+  return datagram.size() >= s_headerSize &&
+      memcmp(datagram.constData(), s_magic, sizeof(s_magic)) == 0 &&
+      static_cast<quint8>(datagram.at(4)) == s_version;
+}
+
+/*!
+  \brief Compresses \a payload and splits it into datagrams of at most \a chunkSize bytes.
+
+  Returns an empty list if the payload needs more chunks than can be numbered.
+ */
+QList<QByteArray> MarkupChunker::split(const QByteArray& payload, int chunkSize)
+{
+  const QByteArray compressed = qCompress(payload);
+  const int dataSize = qMax(1, chunkSize - s_headerSize);
+  const int chunkCount = qMax(1, (compressed.size() + dataSize - 1) / dataSize);
+  if (chunkCount > s_maxChunkCount)
+    return QList<QByteArray>();
+
+  const quint32 transferId = QRandomGenerator::global()->generate();
+
+  QList<QByteArray> chunks;
+  chunks.reserve(chunkCount);
+  for (int sequence = 0; sequence < chunkCount; ++sequence)
+  {
+    const int offset = sequence * dataSize;
+    const int size = qMin(dataSize, compressed.size() - offset);
+
+    QByteArray chunk(s_headerSize + size, Qt::Uninitialized);
+    char* data = chunk.data();
+    memcpy(data, s_magic, sizeof(s_magic));
+    data[4] = static_cast<char>(s_version);
+    qToBigEndian<quint32>(transferId, data + 5);
+    qToBigEndian<quint16>(static_cast<quint16>(sequence), data + 9);
+    qToBigEndian<quint16>(static_cast<quint16>(chunkCount), data + 11);
+    memcpy(data + s_headerSize, compressed.constData() + offset, static_cast<size_t>(size));
+
+    chunks.append(chunk);
+  }
+
+  return chunks;
+}
+
+/*!
+  \brief Adds the chunk \a datagram to its transfer.
+
+  Returns \c true and sets \a payload to the decompressed payload when this
+  was the last missing chunk of the transfer.
+ */
+bool MarkupChunker::addChunk(const QByteArray& datagram, QByteArray& payload)
+{
+  if (!isChunk(datagram))
+    return false;
+
+  const char* data = datagram.constData();
+  const quint32 transferId = qFromBigEndian<quint32>(data + 5);
+  const int sequence = qFromBigEndian<quint16>(data + 9);
+  const int chunkCount = qFromBigEndian<quint16>(data + 11);
+  if (chunkCount == 0 || sequence >= chunkCount)
+    return false;
+
+  const qint64 now = QDateTime::currentMSecsSinceEpoch();
+  expireTransfers(now);
+
+  auto transferIt = m_transfers.find(transferId);
+  if (transferIt == m_transfers.end())
+  {
+    // a single chunk needs no reassembly
+    if (chunkCount == 1)
+    {
+      payload = qUncompress(datagram.mid(s_headerSize));
+      return !payload.isEmpty();
+    }
+
+    if (m_transfers.size() >= s_maxPendingTransfers)
+      removeOldestTransfer();
+
+    Transfer transfer;
+    transfer.m_chunks.resize(chunkCount);
+    transfer.m_started = now;
+    transferIt = m_transfers.insert(transferId, transfer);
+  }
+
+  Transfer& transfer = transferIt.value();
+  if (transfer.m_chunks.size() != chunkCount || !transfer.m_chunks.at(sequence).isNull())
+    return false;
+
+  transfer.m_chunks[sequence] = datagram.mid(s_headerSize);
+  if (++transfer.m_receivedCount < chunkCount)
+    return false;
+
+  QByteArray compressed;
+  for (const auto& chunk : qAsConst(transfer.m_chunks))
+    compressed.append(chunk);
+
+  m_transfers.erase(transferIt);
+
+  payload = qUncompress(compressed);
+  return !payload.isEmpty();
+}
+
+/*!
+  \brief Returns the number of transfers still missing chunks.
+ */
+int MarkupChunker::pendingTransferCount() const
+{
+  return m_transfers.size();
+}
+
+/*!
+  \internal
+  \brief Abandons the transfers which have been missing chunks for too long.
+ */
+void MarkupChunker::expireTransfers(qint64 now)
+{
+  for (auto it = m_transfers.begin(); it != m_transfers.end();)
+  {
+    if (now - it->m_started > s_transferTimeout)
+      it = m_transfers.erase(it);
+    else
+      ++it;
+  }
+}
+
+/*!
+  \internal
+  \brief Abandons the oldest transfer to make room for a new one.
+ */
+void MarkupChunker::removeOldestTransfer()
+{
+  if (m_transfers.isEmpty())
+    return;
+
+  auto oldestIt = m_transfers.begin();
+  for (auto it = m_transfers.begin(); it != m_transfers.end(); ++it)
+  {
+    if (it->m_started < oldestIt->m_started)
+      oldestIt = it;
+  }
+
+  m_transfers.erase(oldestIt);
+}
+
+} // Dsa
@@ -0,0 +1,60 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef MARKUPCHUNKER_H
+#define MARKUPCHUNKER_H
+
+// Qt headers
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QVector>
+
+namespace Dsa {
+
+class MarkupChunker
+{
+public:
+  MarkupChunker();
+  ~MarkupChunker();
+
+  static bool isChunk(const QByteArray& datagram);
+  static QList<QByteArray> split(const QByteArray& payload, int chunkSize = defaultChunkSize);
+
+  bool addChunk(const QByteArray& datagram, QByteArray& payload);
+
+  int pendingTransferCount() const;
+
+  // keeps datagrams, with IP and UDP headers, within a typical 1280 byte link MTU
+  static constexpr int defaultChunkSize = 1200;
+
+private:
+  struct Transfer
+  {
+    QVector<QByteArray> m_chunks;
+    int m_receivedCount = 0;
+    qint64 m_started = 0;
+  };
+
+  void expireTransfers(qint64 now);
+  void removeOldestTransfer();
+
+  QHash<quint32, Transfer> m_transfers;
+};
+
+} // Dsa
+
+#endif // MARKUPCHUNKER_H
@@ -38,6 +38,7 @@
 #include "Map.h"
 #include "MapQuickView.h"
 #include "MultipartBuilder.h"
+#include "Part.h"
 #include "PartCollection.h"
 #include "PolylineBuilder.h"
 #include "Scene.h"
@@ -52,7 +53,12 @@ using namespace Esri::ArcGISRuntime;
 
 namespace Dsa {
 
+// the stroke being drawn is committed as a static segment every this many points
+static const int s_strokeSegmentSize = 256;
+
 const QString MarkupController::USERNAME_PROPERTYNAME = "UserName";
+const QString MarkupController::MARKUPCONFIG_PROPERTYNAME = "MarkupConfig";
+const QString MarkupController::SKETCHTOLERANCE_PROPERTYNAME = "sketchTolerance";
 
 /*!
   \class Dsa::MarkupController
@@ -99,6 +105,10 @@ MarkupController::~MarkupController()
 void MarkupController::setProperties(const QVariantMap& properties)
 {
   m_username = properties.value(USERNAME_PROPERTYNAME).toString();
+
+  const auto markupConfig = properties.value(MARKUPCONFIG_PROPERTYNAME).toMap();
+  if (markupConfig.contains(SKETCHTOLERANCE_PROPERTYNAME))
+    setSketchTolerance(markupConfig.value(SKETCHTOLERANCE_PROPERTYNAME).toDouble());
 }
 
 /*!
@@ -113,6 +123,37 @@ void MarkupController::setActive(bool active)
   GraphicsOverlayListModel* graphicsOverlays = m_geoView->graphicsOverlays();
   if (active)
     graphicsOverlays->append(m_sketchOverlay);
+
+  // the tool only receives mouse events while it is active
+  if (active)
+  {
+    using MouseEventType = ToolResourceProvider::MouseEventType;
+    ToolResourceProvider::instance()->setMouseFocus(this,
+                                                    MouseEventType::Clicked | MouseEventType::Pressed |
+                                                    MouseEventType::Moved | MouseEventType::Released,
+                                                    ToolResourceProvider::SketchMousePriority,
+                                                    [this](MouseEventType eventType, QMouseEvent& mouseEvent)
+    {
+      switch (eventType)
+      {
+      case MouseEventType::Clicked:
+        return onMouseClicked(mouseEvent);
+      case MouseEventType::Pressed:
+        return onMousePressed(mouseEvent);
+      case MouseEventType::Moved:
+        return onMouseMoved(mouseEvent);
+      case MouseEventType::Released:
+        return onMouseReleased(mouseEvent);
+      default:
+        return false;
+      }
+    });
+  }
+  else
+  {
+    ToolResourceProvider::instance()->clearMouseFocus(this);
+  }
+
   emit activeChanged();
 }
 
@@ -235,6 +276,7 @@ void MarkupController::setDrawModeEnabled(bool enabled)
 void MarkupController::init()
 {
   initGeometryBuilder();
+  m_strokeBuilder = new PolylineBuilder(m_geoView->spatialReference(), this);
 
   if (m_is3d)
     m_sketchOverlay->setSceneProperties(LayerSceneProperties(SurfacePlacement::DrapedFlat));
@@ -249,84 +291,117 @@ void MarkupController::init()
     else
       m_sketchOverlay->unselectGraphics(m_sketchOverlay->selectedGraphics());
   });
+}
 
-  connect(ToolResourceProvider::instance(), &ToolResourceProvider::mouseClicked, this, [this](QMouseEvent& mouseEvent)
-  {
-    if (!m_active)
-      return;
+/*!
+ \internal
+ Selects the sketch graphic at the clicked position of \a mouseEvent.
 
-    if (!m_isDrawing)
-      m_geoView->identifyGraphicsOverlay(m_sketchOverlay, mouseEvent.x(), mouseEvent.y(), m_is3d ? 100 : 20, false, 1);
-  });
+ The click is not consumed, so that other tools can use it.
+ */
+bool MarkupController::onMouseClicked(QMouseEvent& mouseEvent)
+{
+  if (!m_active)
+    return false;
 
-  connect(ToolResourceProvider::instance(), &ToolResourceProvider::mousePressed, this, [this](QMouseEvent& mouseEvent)
-  {
-    // ignore right clicks
-    if (mouseEvent.button() == Qt::MouseButton::RightButton)
-      return;
+  if (!m_isDrawing)
+    m_geoView->identifyGraphicsOverlay(m_sketchOverlay, mouseEvent.x(), mouseEvent.y(), m_is3d ? 100 : 20, false, 1);
 
-    // do nothing if Tool is not active
-    if (!m_active || !m_drawModeEnabled)
-      return;
+  // other tools, such as identify, still receive the click
+  return false;
+}
 
-    // accept mouseEvent when using a mouse device to disable panning.
-    if (mouseEvent.button() == Qt::MouseButton::LeftButton)
-      mouseEvent.accept();
+/*!
+ \internal
+ Starts a new stroke at the position of \a mouseEvent, consuming it, if drawing is enabled.
+ */
+bool MarkupController::onMousePressed(QMouseEvent& mouseEvent)
+{
+  // ignore right clicks
+  if (mouseEvent.button() == Qt::MouseButton::RightButton)
+    return false;
 
-    // create a new graphic that corresponds to a new Part of the GeometryBuilder
-    clear();
-    m_currentPartIndex = 0;
-    Graphic* partGraphic = new Graphic(this);
-    partGraphic->setSymbol(updatedSymbol());
-    m_partOutlineGraphics.append(partGraphic);
-    m_sketchOverlay->graphics()->append(partGraphic);
-    m_currentPartIndex = addPart();
+  // do nothing if Tool is not active
+  if (!m_active || !m_drawModeEnabled)
+    return false;
 
-    Point pressedPoint(normalizedPoint(mouseEvent.x(), mouseEvent.y()));
-    if (m_sketchOverlay->sceneProperties().surfacePlacement() == SurfacePlacement::Relative)
-      pressedPoint = Point(pressedPoint.x(), pressedPoint.y(), m_drawingAltitude);
+  // accept mouseEvent when using a mouse device to disable panning.
+  if (mouseEvent.button() == Qt::MouseButton::LeftButton)
+    mouseEvent.accept();
 
-    insertPointInPart(m_currentPartIndex, -1, pressedPoint);
+  // create a new graphic that corresponds to a new Part of the GeometryBuilder
+  clear();
+  resetStroke();
+  m_currentPartIndex = 0;
+  Graphic* partGraphic = new Graphic(this);
+  partGraphic->setSymbol(updatedSymbol());
+  m_partOutlineGraphics.append(partGraphic);
+  m_sketchOverlay->graphics()->append(partGraphic);
+  m_currentPartIndex = addPart();
 
-    // for touch screen operation
-    mouseEvent.ignore();
+  Point pressedPoint(normalizedPoint(mouseEvent.x(), mouseEvent.y()));
+  if (m_sketchOverlay->sceneProperties().surfacePlacement() == SurfacePlacement::Relative)
+    pressedPoint = Point(pressedPoint.x(), pressedPoint.y(), m_drawingAltitude);
 
-    ToolResourceProvider::instance()->setMouseCursor(QCursor(Qt::PointingHandCursor));
-    m_isDrawing = true;
-  });
+  addSketchVertex(m_currentPartIndex, mouseEvent.x(), mouseEvent.y(), pressedPoint, true);
 
-  connect(ToolResourceProvider::instance(), &ToolResourceProvider::mouseMoved, this, [this](QMouseEvent& mouseEvent)
-  {
-    if (!m_active || !m_isDrawing)
-      return;
+  // for touch screen operation
+  mouseEvent.ignore();
 
-    mouseEvent.accept();
+  ToolResourceProvider::instance()->setMouseCursor(QCursor(Qt::PointingHandCursor));
+  m_isDrawing = true;
 
-    Point movedPoint(normalizedPoint(mouseEvent.x(), mouseEvent.y()));
-    if (m_sketchOverlay->sceneProperties().surfacePlacement() == SurfacePlacement::Relative)
-      movedPoint = Point(movedPoint.x(), movedPoint.y(), m_drawingAltitude);
+  return true;
+}
 
-    insertPointInPart(m_currentPartIndex, -1, movedPoint);
-  });
+/*!
+ \internal
+ Extends the current stroke to the position of \a mouseEvent, consuming it.
+ */
+bool MarkupController::onMouseMoved(QMouseEvent& mouseEvent)
+{
+  if (!m_active || !m_isDrawing)
+    return false;
 
-  connect(ToolResourceProvider::instance(), &ToolResourceProvider::mouseReleased, this, [this](QMouseEvent& mouseEvent)
-  {
-    if (!m_active || !m_isDrawing)
-      return;
+  mouseEvent.accept();
 
-    mouseEvent.accept();
+  Point movedPoint(normalizedPoint(mouseEvent.x(), mouseEvent.y()));
+  if (m_sketchOverlay->sceneProperties().surfacePlacement() == SurfacePlacement::Relative)
+    movedPoint = Point(movedPoint.x(), movedPoint.y(), m_drawingAltitude);
 
-    Point releasedPoint(normalizedPoint(mouseEvent.x(), mouseEvent.y()));
-    if (m_sketchOverlay->sceneProperties().surfacePlacement() == SurfacePlacement::Relative)
-      releasedPoint = Point(releasedPoint.x(), releasedPoint.y(), m_drawingAltitude);
+  // decimate as high-rate touch screens report many more points than can be seen
+  addSketchVertex(m_currentPartIndex, mouseEvent.x(), mouseEvent.y(), movedPoint);
 
-    insertPointInPart(m_currentPartIndex, -1, releasedPoint);
+  return true;
+}
 
-    ToolResourceProvider::instance()->setMouseCursor(QCursor(Qt::ArrowCursor));
-    m_isDrawing = false;
+/*!
+ \internal
+ Completes the current stroke at the position of \a mouseEvent, consuming it.
+ */
+bool MarkupController::onMouseReleased(QMouseEvent& mouseEvent)
+{
+  if (!m_active || !m_isDrawing)
+    return false;
 
-    emit sketchCompleted();
-  });
+  mouseEvent.accept();
+
+  Point releasedPoint(normalizedPoint(mouseEvent.x(), mouseEvent.y()));
+  if (m_sketchOverlay->sceneProperties().surfacePlacement() == SurfacePlacement::Relative)
+    releasedPoint = Point(releasedPoint.x(), releasedPoint.y(), m_drawingAltitude);
+
+  addSketchVertex(m_currentPartIndex, mouseEvent.x(), mouseEvent.y(), releasedPoint, true);
+  m_isDrawing = false;
+
+  // replace the stroke's segments with its whole, simplified geometry
+  if (simplifySketchPart(m_currentPartIndex) == 0)
+    refreshSketch();
+
+  ToolResourceProvider::instance()->setMouseCursor(QCursor(Qt::ArrowCursor));
+
+  emit sketchCompleted();
+
+  return true;
 }
 
 /*!
@@ -337,16 +412,89 @@ void MarkupController::updateSketch()
   // to be called whenever the GeometryBuilder is modified. It will update the Geometry of the Graphic being sketched
   MultipartBuilder* multipartBuilder = static_cast<MultipartBuilder*>(m_geometryBuilder);
 
-  // get simplified geometry
-  const Geometry simplifiedLine = GeometryEngine::simplify(multipartBuilder->toGeometry());
-  auto graphic = m_partOutlineGraphics.last();
+  auto graphic = m_partOutlineGraphics.isEmpty() ? nullptr : m_partOutlineGraphics.last();
   if (!graphic)
     return;
 
   graphic->setSymbol(m_sketchSymbol);
+
+  // while drawing only the latest segment of the stroke is rebuilt, so long strokes do not slow down
+  if (m_isDrawing && m_strokeBuilder && m_currentPartIndex >= 0 && m_currentPartIndex < multipartBuilder->parts()->size())
+  {
+    appendToStroke(multipartBuilder->parts()->part(m_currentPartIndex));
+    graphic->setGeometry(m_strokeBuilder->toGeometry());
+    return;
+  }
+
+  resetStroke();
+
+  // get simplified geometry
+  const Geometry simplifiedLine = GeometryEngine::simplify(multipartBuilder->toGeometry());
   graphic->setGeometry(simplifiedLine);
 }
 
+/*!
+ \internal
+ \brief Appends the points added to \a part since the last update to the stroke being drawn.
+ */
+void MarkupController::appendToStroke(const Part* part)
+{
+  const int pointCount = part->pointCount();
+
+  // the part was rebuilt, so start the stroke again
+  if (pointCount < m_strokePointCount)
+    resetStroke();
+
+  for (int i = m_strokePointCount; i < pointCount; ++i)
+  {
+    m_strokeBuilder->addPoint(part->point(i));
+    if (++m_strokeTailCount >= s_strokeSegmentSize)
+      commitStrokeSegment();
+  }
+
+  m_strokePointCount = pointCount;
+}
+
+/*!
+ \internal
+ \brief Draws the latest segment of the stroke as a static graphic and starts
+ a new segment from its last point.
+ */
+void MarkupController::commitStrokeSegment()
+{
+  const Geometry segment = m_strokeBuilder->toGeometry();
+  Graphic* segmentGraphic = new Graphic(segment, m_sketchSymbol, this);
+  m_strokeSegmentGraphics.append(segmentGraphic);
+  m_sketchOverlay->graphics()->append(segmentGraphic);
+
+  const Part* tail = m_strokeBuilder->parts()->part(m_strokeBuilder->parts()->size() - 1);
+  const Point lastPoint = tail->endPoint();
+
+  m_strokeBuilder->parts()->removeAll();
+  m_strokeBuilder->addPoint(lastPoint);
+  m_strokeTailCount = 1;
+}
+
+/*!
+ \internal
+ \brief Removes the segments of the stroke being drawn.
+ */
+void MarkupController::resetStroke()
+{
+  for (Graphic* segmentGraphic : qAsConst(m_strokeSegmentGraphics))
+  {
+    m_sketchOverlay->graphics()->removeOne(segmentGraphic);
+    delete segmentGraphic;
+  }
+  m_strokeSegmentGraphics.clear();
+
+  if (m_strokeBuilder)
+    m_strokeBuilder->parts()->removeAll();
+
+  m_strokePointCount = 0;
+  m_strokeTailCount = 0;
+}
+
 /*!
  \internal
  */
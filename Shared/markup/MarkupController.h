@@ -29,6 +29,15 @@
 // Qt headers
 #include <QColor>
 
+class QMouseEvent;
+
+namespace Esri {
+  namespace ArcGISRuntime {
+    class Part;
+    class PolylineBuilder;
+  }
+}
+
 namespace Dsa {
 
 class MarkupBroadcast;
@@ -83,9 +92,18 @@ private:
   void init();
   void updateSketch() override;
   Esri::ArcGISRuntime::Symbol* updatedSymbol();
+  void appendToStroke(const Esri::ArcGISRuntime::Part* part);
+  void commitStrokeSegment();
+  void resetStroke();
   QStringList colors() const;
+  bool onMouseClicked(QMouseEvent& mouseEvent);
+  bool onMousePressed(QMouseEvent& mouseEvent);
+  bool onMouseMoved(QMouseEvent& mouseEvent);
+  bool onMouseReleased(QMouseEvent& mouseEvent);
 
   static const QString USERNAME_PROPERTYNAME;
+  static const QString MARKUPCONFIG_PROPERTYNAME;
+  static const QString SKETCHTOLERANCE_PROPERTYNAME;
   int m_currentPartIndex = 0;
   double m_drawingAltitude = 10.0;
   bool m_isDrawing = false;
@@ -95,6 +113,13 @@ private:
   QString m_username;
   float m_width = 8.0f;
   MarkupBroadcast* m_markupBroadcast = nullptr;
+
+  // the stroke being drawn: finished segments are drawn as static graphics, and
+  // only the latest is rebuilt as points are appended
+  Esri::ArcGISRuntime::PolylineBuilder* m_strokeBuilder = nullptr;
+  QList<Esri::ArcGISRuntime::Graphic*> m_strokeSegmentGraphics;
+  int m_strokePointCount = 0;
+  int m_strokeTailCount = 0;
 };
 
 } // Dsa
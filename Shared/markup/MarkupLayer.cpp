@@ -21,6 +21,7 @@
 
 // dsa app headers
 #include "MarkupConstants.h"
+#include "MarkupStore.h"
 
 // C++ API headers
 #include "Feature.h"
@@ -29,7 +30,12 @@
 #include "FeatureCollectionTable.h"
 #include "Field.h"
 #include "GraphicsOverlay.h"
+#include "ImmutablePart.h"
+#include "ImmutablePartCollection.h"
+#include "Part.h"
+#include "PartCollection.h"
 #include "Polyline.h"
+#include "PolylineBuilder.h"
 #include "SimpleLineSymbol.h"
 #include "SimpleRenderer.h"
 
@@ -39,12 +45,123 @@
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QLocale>
 #include <QString>
 
+// STL headers
+#include <memory>
+
 using namespace Esri::ArcGISRuntime;
 
 namespace Dsa {
 
+namespace {
+
+// builds a polyline directly from its JSON object, avoiding a round trip through a JSON string
+Geometry polylineFromJson(const QJsonObject& geometryJson)
+{
+  const QJsonObject spatialReferenceJson = geometryJson.value(QStringLiteral("spatialReference")).toObject();
+  const QJsonValue wkid = spatialReferenceJson.value(QStringLiteral("wkid"));
+  const QJsonValue paths = geometryJson.value(QStringLiteral("paths"));
+  const bool hasZ = geometryJson.value(QStringLiteral("hasZ")).toBool();
+
+  // leave anything beyond simple polylines to the general parser
+  if (!wkid.isDouble() || !paths.isArray() || geometryJson.value(QStringLiteral("hasM")).toBool())
+    return Geometry::fromJson(QString::fromUtf8(QJsonDocument(geometryJson).toJson(QJsonDocument::Compact)));
+
+  const SpatialReference spatialReference(wkid.toInt());
+  PolylineBuilder builder(spatialReference);
+  PartCollection* parts = builder.parts();
+
+  const QJsonArray pathsJson = paths.toArray();
+  for (const auto& pathJson : pathsJson)
+  {
+    Part* part = new Part(spatialReference, &builder);
+
+    const QJsonArray verticesJson = pathJson.toArray();
+    for (const auto& vertexJson : verticesJson)
+    {
+      const QJsonArray coordinates = vertexJson.toArray();
+      if (coordinates.size() < 2)
+        continue;
+
+      if (hasZ && coordinates.size() > 2)
+        part->addPoint(Point(coordinates.at(0).toDouble(), coordinates.at(1).toDouble(), coordinates.at(2).toDouble(), spatialReference));
+      else
+        part->addPoint(Point(coordinates.at(0).toDouble(), coordinates.at(1).toDouble(), spatialReference));
+    }
+
+    parts->addPart(part);
+  }
+
+  return builder.toGeometry();
+}
+
+// appends value to buffer in the shortest form which reads back as the same value
+void appendNumber(QByteArray& buffer, double value)
+{
+  buffer.append(QByteArray::number(value, 'g', QLocale::FloatingPointShortest));
+}
+
+// appends text to buffer as a quoted and escaped JSON string
+void appendString(QByteArray& buffer, const QString& text)
+{
+  const QByteArray json = QJsonDocument(QJsonArray{text}).toJson(QJsonDocument::Compact);
+  buffer.append(json.constData() + 1, json.size() - 2);
+}
+
+// appends the JSON of geometry to buffer, writing simple polylines straight from their parts
+// in the layout which polylineFromJson reads back
+void appendGeometry(QByteArray& buffer, const Geometry& geometry)
+{
+  const int wkid = geometry.spatialReference().wkid();
+  if (geometry.geometryType() != GeometryType::Polyline || geometry.isEmpty() || geometry.hasM() || wkid <= 0)
+  {
+    buffer.append(geometry.toJson().toUtf8());
+    return;
+  }
+
+  const Polyline polyline = geometry_cast<Polyline>(geometry);
+  const bool hasZ = polyline.hasZ();
+  std::unique_ptr<ImmutablePartCollection> parts(polyline.parts());
+  const int partCount = parts ? parts->size() : 0;
+
+  buffer.append(hasZ ? "{\"hasZ\":true,\"paths\":[" : "{\"paths\":[");
+  for (int partIndex = 0; partIndex < partCount; ++partIndex)
+  {
+    if (partIndex > 0)
+      buffer.append(',');
+
+    buffer.append('[');
+    std::unique_ptr<ImmutablePart> part(parts->part(partIndex));
+    const int pointCount = part ? part->pointCount() : 0;
+    for (int pointIndex = 0; pointIndex < pointCount; ++pointIndex)
+    {
+      if (pointIndex > 0)
+        buffer.append(',');
+
+      const Point point = part->point(pointIndex);
+      buffer.append('[');
+      appendNumber(buffer, point.x());
+      buffer.append(',');
+      appendNumber(buffer, point.y());
+      if (hasZ)
+      {
+        buffer.append(',');
+        appendNumber(buffer, point.z());
+      }
+      buffer.append(']');
+    }
+    buffer.append(']');
+  }
+
+  buffer.append("],\"spatialReference\":{\"wkid\":");
+  buffer.append(QByteArray::number(wkid));
+  buffer.append("}}");
+}
+
+} // namespace
+
 /*!
   \class Dsa::MarkupLayer
   \inmodule Dsa
@@ -55,48 +172,52 @@ namespace Dsa {
 
 /*!
  \internal
- \brief Constructor that takes a \a featureCollection and an optional \a parent.
+ \brief Constructor that takes the \a json of the markup, its \a name, \a author and
+ \a elements, a \a featureCollection and an optional \a parent.
  */
-MarkupLayer::MarkupLayer(const QString& json, FeatureCollection* featureCollection, QObject* parent) :
+MarkupLayer::MarkupLayer(const QString& json, const QString& name, const QString& author, const QList<Element>& elements,
+                         FeatureCollection* featureCollection, QObject* parent) :
   FeatureCollectionLayer(featureCollection, parent),
   m_json(json),
+  m_author(author),
   m_featureCollection(featureCollection)
 {
-  const QJsonDocument markupDoc = QJsonDocument::fromJson(json.toUtf8());
-  const QJsonObject markupJson = markupDoc.object();
-
-  // Clear Hash to keep track of features/symbols added to the table
-  m_featureHash.clear();
-
   // Get the table
   auto table = m_featureCollection->tables()->at(0);
 
-  // Connect to know when addFeature successfully completes
-  connect(table, &FeatureCollectionTable::addFeatureCompleted, this, [this, table](QUuid id, bool success)
+  // Connect to know when the features have been added, to apply their colors
+  connect(table, &FeatureCollectionTable::addFeaturesCompleted, this, [this, table](QUuid id, bool success)
   {
-    if (!success || !m_featureHash.contains(id))
+    if (id != m_addFeaturesTaskId)
       return;
 
-    auto pair = m_featureHash.value(id);
-    table->setSymbolOverride(pair.first, pair.second);
+    const auto pendingSymbolOverrides = m_pendingSymbolOverrides;
+    m_pendingSymbolOverrides.clear();
+
+    if (!success)
+      return;
+
+    for (const auto& pair : pendingSymbolOverrides)
+      table->setSymbolOverride(pair.first, pair.second);
   });
 
-  // Loop through the markup elements and add them as Features to the table
-  QJsonArray markupElements = markupJson.value(MarkupConstants::MARKUP).toObject().value(MarkupConstants::ELEMENTS).toArray();
-  const int markupSize = markupElements.size();
-  for (int i = 0; i < markupSize; i++)
+  // Create a Feature for each of the markup elements and add them to the table in one call
+  QList<Feature*> features;
+  features.reserve(elements.size());
+  m_pendingSymbolOverrides.reserve(elements.size());
+
+  for (const Element& element : elements)
   {
-    const QJsonObject element = markupElements.at(i).toObject();
     Feature* feature = table->createFeature(table);
-    const QString geomString = QString(QJsonDocument(element.value(MarkupConstants::GEOMETRY).toObject()).toJson(QJsonDocument::Compact));
-    feature->setGeometry(Geometry::fromJson(geomString));
-    QUuid id = table->addFeature(feature).taskId();
-    SimpleLineSymbol* sls = new SimpleLineSymbol(SimpleLineSymbolStyle::Solid, QColor(MarkupLayer::colors().at(element.value(MarkupConstants::COLOR).toInt())), 12.0f, parent);
-    m_featureHash[id] = QPair<Feature*, SimpleLineSymbol*>(feature, sls);
+    feature->setGeometry(element.m_geometry);
+    features.append(feature);
+    m_pendingSymbolOverrides.append(qMakePair(feature, colorSymbol(element.m_color)));
   }
 
-  setName(markupJson.value(MarkupConstants::MARKUP).toObject().value(MarkupConstants::NAME).toString());
-  m_author = markupJson.value(MarkupConstants::SHAREDBY).toString();
+  if (!features.isEmpty())
+    m_addFeaturesTaskId = table->addFeatures(features).taskId();
+
+  setName(name);
 }
 
 /*!
@@ -106,6 +227,26 @@ MarkupLayer::~MarkupLayer()
 {
 }
 
+/*!
+ \internal
+ \brief Returns the shared symbol for the markup color at \a colorIndex.
+ */
+SimpleLineSymbol* MarkupLayer::colorSymbol(int colorIndex)
+{
+  static const QStringList markupColors = colors();
+  if (colorIndex < 0 || colorIndex >= markupColors.size())
+    colorIndex = 0;
+
+  if (m_colorSymbols.isEmpty())
+    m_colorSymbols.resize(markupColors.size());
+
+  SimpleLineSymbol*& symbol = m_colorSymbols[colorIndex];
+  if (!symbol)
+    symbol = new SimpleLineSymbol(SimpleLineSymbolStyle::Solid, QColor(markupColors.at(colorIndex)), 12.0f, this);
+
+  return symbol;
+}
+
 /*!
  \brief Sets the layer path to \a path.
 */
@@ -140,60 +281,147 @@ FeatureCollection* MarkupLayer::featureCollection()
 
 /*!
  \brief Converts the input \a graphicsOverlay to \c .markup JSON.
+
+ The JSON is written straight from the geometry of the graphics, and the features of
+ the layer are created from that geometry rather than by parsing the JSON again.
  */
 MarkupLayer* MarkupLayer::createFromGraphics(GraphicsOverlay* graphicsOverlay, const QString& authorName, QObject* parent)
 {
   // get the sceneview instance
   SceneView* sceneView = dynamic_cast<SceneView*>(ToolResourceProvider::instance()->geoView());
 
-  // create the markup
-  QJsonObject markup;
-  QJsonArray elements;
+  // the markup is written into one buffer, which keeps its capacity from one markup to the next
+  static QByteArray s_buffer;
   const int graphicCount = graphicsOverlay->graphics()->size();
+  s_buffer.resize(0);
+  s_buffer.reserve(graphicCount * 256);
+
+  // the keys are written in the same order as QJsonDocument would write them
+  s_buffer.append("{\"");
+  s_buffer.append(MarkupConstants::CENTER.toUtf8());
+  s_buffer.append("\":");
+  if (sceneView)
+    s_buffer.append(sceneView->currentViewpointCamera().location().toJson().toUtf8());
+  else
+    s_buffer.append("-1");
+
+  s_buffer.append(",\"");
+  s_buffer.append(MarkupConstants::MARKUP.toUtf8());
+  s_buffer.append("\":{\"");
+  s_buffer.append(MarkupConstants::ELEMENTS.toUtf8());
+  s_buffer.append("\":[");
+
+  // create the markup
+  QList<Element> elements;
+  elements.reserve(graphicCount);
   for (int i = 0; i < graphicCount; i++)
   {
     Graphic* graphic = graphicsOverlay->graphics()->at(i);
-    QJsonObject element;
-    QJsonDocument geomDoc = QJsonDocument::fromJson(graphic->geometry().toJson().toUtf8());
-    element[MarkupConstants::GEOMETRY] = QJsonValue(geomDoc.object());
-    element[MarkupConstants::FILLED] = false;
-    element[MarkupConstants::ARROW] = false;
     SimpleLineSymbol* sls = dynamic_cast<SimpleLineSymbol*>(graphic->symbol());
-    element[MarkupConstants::COLOR] = sls ? colors().indexOf(sls->color().name()) : 0;
-    QJsonValue value(element);
-    elements.append(value);
+
+    Element element;
+    element.m_geometry = graphic->geometry();
+    element.m_color = sls ? colors().indexOf(sls->color().name()) : 0;
+    elements.append(element);
+
+    if (i > 0)
+      s_buffer.append(',');
+
+    s_buffer.append("{\"");
+    s_buffer.append(MarkupConstants::ARROW.toUtf8());
+    s_buffer.append("\":false,\"");
+    s_buffer.append(MarkupConstants::COLOR.toUtf8());
+    s_buffer.append("\":");
+    s_buffer.append(QByteArray::number(element.m_color));
+    s_buffer.append(",\"");
+    s_buffer.append(MarkupConstants::FILLED.toUtf8());
+    s_buffer.append("\":false,\"");
+    s_buffer.append(MarkupConstants::GEOMETRY.toUtf8());
+    s_buffer.append("\":");
+    appendGeometry(s_buffer, element.m_geometry);
+    s_buffer.append('}');
   }
-  markup[MarkupConstants::ELEMENTS] = elements;
-  markup[MarkupConstants::VERSION] = MarkupConstants::VERSIONNUMBER;
-  markup[MarkupConstants::NAME] = graphicsOverlay->overlayId();
 
-  // create the markup item json
-  QJsonObject markupJson;
+  s_buffer.append("],\"");
+  s_buffer.append(MarkupConstants::NAME.toUtf8());
+  s_buffer.append("\":");
+  appendString(s_buffer, graphicsOverlay->overlayId());
+  s_buffer.append(",\"");
+  s_buffer.append(MarkupConstants::VERSION.toUtf8());
+  s_buffer.append("\":");
+  appendString(s_buffer, MarkupConstants::VERSIONNUMBER);
+
+  // set the scale, the name of the sharer and the version of the markup item
+  s_buffer.append("},\"");
+  s_buffer.append(MarkupConstants::SCALE.toUtf8());
+  s_buffer.append("\":");
+  s_buffer.append(QByteArray::number(sceneView ? static_cast<int>(sceneView->currentViewpointCamera().location().z()) : -1));
+  s_buffer.append(",\"");
+  s_buffer.append(MarkupConstants::SHAREDBY.toUtf8());
+  s_buffer.append("\":");
+  appendString(s_buffer, authorName);
+  s_buffer.append(",\"");
+  s_buffer.append(MarkupConstants::VERSION.toUtf8());
+  s_buffer.append("\":\"1.0\"}");
+
+  return createLayer(QString::fromUtf8(s_buffer), graphicsOverlay->overlayId(), authorName, elements, parent);
+}
 
-  // set center
-  markupJson[MarkupConstants::SCALE] = sceneView ? (int)sceneView->currentViewpointCamera().location().z() : -1;
-  markupJson[MarkupConstants::VERSION] = "1.0";
-  QJsonDocument centerDoc = sceneView ?
-        QJsonDocument::fromJson(sceneView->currentViewpointCamera().location().toJson().toUtf8()) :
-        QJsonDocument();
-  markupJson[MarkupConstants::CENTER] = sceneView ? QJsonValue(centerDoc.object()) : -1;
+/*!
+ \brief Returns a MarkupLayer for the input \a json.
+*/
+MarkupLayer* MarkupLayer::fromJson(const QString& json, QObject* parent)
+{
+  return createLayer(json, QJsonDocument::fromJson(json.toUtf8()).object(), parent);
+}
 
-  // add the markups to the markup item json
-  markupJson[MarkupConstants::MARKUP] = markup;
+/*!
+ \brief Returns a MarkupLayer for the already parsed \a markupJson.
+*/
+MarkupLayer* MarkupLayer::fromJson(const QJsonObject& markupJson, QObject* parent)
+{
+  return createLayer(QString::fromUtf8(QJsonDocument(markupJson).toJson(QJsonDocument::Compact)), markupJson, parent);
+}
+
+/*!
+ \internal
+ \brief Returns a MarkupLayer for \a json, parsed as \a markupJson.
+*/
+MarkupLayer* MarkupLayer::createLayer(const QString& json, const QJsonObject& markupJson, QObject* parent)
+{
+  const QJsonObject markup = markupJson.value(MarkupConstants::MARKUP).toObject();
+  const QJsonArray markupElements = markup.value(MarkupConstants::ELEMENTS).toArray();
 
-  // add the name of the sharer
-  markupJson[MarkupConstants::SHAREDBY] = authorName;
+  QList<Element> elements;
+  elements.reserve(markupElements.size());
+  for (const auto& markupElement : markupElements)
+  {
+    const QJsonObject elementJson = markupElement.toObject();
+
+    Element element;
+    element.m_geometry = polylineFromJson(elementJson.value(MarkupConstants::GEOMETRY).toObject());
+    element.m_color = elementJson.value(MarkupConstants::COLOR).toInt();
+    elements.append(element);
+  }
 
-  return MarkupLayer::fromJson(QJsonDocument(markupJson).toJson(QJsonDocument::Compact), parent);
+  return createLayer(json, markup.value(MarkupConstants::NAME).toString(), markupJson.value(MarkupConstants::SHAREDBY).toString(),
+                     elements, parent);
 }
 
 /*!
- \brief Returns a MarkupLayer for the input \a json.
+ \internal
+ \brief Returns a MarkupLayer for \a json, with the \a name, \a author and \a elements it describes.
 */
-MarkupLayer* MarkupLayer::fromJson(const QString& json, QObject* parent)
+MarkupLayer* MarkupLayer::createLayer(const QString& json, const QString& name, const QString& author,
+                                      const QList<Element>& elements, QObject* parent)
 {
-  bool useZ = json.contains(R"("hasZ":true)");
-  bool useM = json.contains(R"("hasM":true)");
+  bool useZ = false;
+  bool useM = false;
+  for (const Element& element : elements)
+  {
+    useZ = useZ || element.m_geometry.hasZ();
+    useM = useM || element.m_geometry.hasM();
+  }
 
   // Create the FeatureCollectionTable
   FeatureCollectionTable* table = new FeatureCollectionTable(QList<Field>{}, GeometryType::Polyline, SpatialReference(4326), useZ, useM, parent);
@@ -205,7 +433,7 @@ MarkupLayer* MarkupLayer::fromJson(const QString& json, QObject* parent)
   FeatureCollection* featureCollection = new FeatureCollection(QList<FeatureCollectionTable*>{table}, parent);
 
   // Create a MarkupLayer
-  MarkupLayer* markupLayer = new MarkupLayer(json, featureCollection, parent);
+  MarkupLayer* markupLayer = new MarkupLayer(json, name, author, elements, featureCollection, parent);
 
   return markupLayer;
 }
@@ -215,6 +443,15 @@ MarkupLayer* MarkupLayer::fromJson(const QString& json, QObject* parent)
 */
 MarkupLayer* MarkupLayer::createFromPath(const QString& path, QObject* parent)
 {
+  // a markup which has just been received does not need to be read back from its file
+  QJsonObject markupJson;
+  if (MarkupStore::instance()->document(path, markupJson))
+  {
+    MarkupLayer* markupLayer = MarkupLayer::fromJson(markupJson, parent);
+    markupLayer->setPath(path);
+    return markupLayer;
+  }
+
   // Read the input file
   QFile markupFile(path);
   if (!markupFile.open(QIODevice::ReadOnly))
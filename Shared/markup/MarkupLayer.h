@@ -19,10 +19,14 @@
 
 // C++ API headers
 #include "FeatureCollectionLayer.h"
+#include "Geometry.h"
 #include "JsonSerializable.h"
 
 // Qt headers
-#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QUuid>
+#include <QVector>
 
 namespace Esri {
 namespace ArcGISRuntime {
@@ -56,18 +60,37 @@ public:
 
   // JSON Serializable
   static MarkupLayer* fromJson(const QString& json, QObject* parent = nullptr);
+  static MarkupLayer* fromJson(const QJsonObject& markupJson, QObject* parent = nullptr);
   QString toJson() const override;
   QJsonObject unknownJson() const override;
   QJsonObject unsupportedJson() const override;
 
 private:
-  MarkupLayer(const QString& json, Esri::ArcGISRuntime::FeatureCollection* featureCollection, QObject* parent = nullptr);
+  // the geometry and color of one of the elements of a markup
+  struct Element
+  {
+    Esri::ArcGISRuntime::Geometry m_geometry;
+    int m_color = 0;
+  };
+
+  MarkupLayer(const QString& json, const QString& name, const QString& author, const QList<Element>& elements,
+              Esri::ArcGISRuntime::FeatureCollection* featureCollection, QObject* parent = nullptr);
+
+  static MarkupLayer* createLayer(const QString& json, const QJsonObject& markupJson, QObject* parent);
+  static MarkupLayer* createLayer(const QString& json, const QString& name, const QString& author,
+                                  const QList<Element>& elements, QObject* parent);
+
+  Esri::ArcGISRuntime::SimpleLineSymbol* colorSymbol(int colorIndex);
 
   QString m_path;
   QString m_json;
   QString m_author;
   Esri::ArcGISRuntime::FeatureCollection* m_featureCollection = nullptr;
-  QHash<QUuid, QPair<Esri::ArcGISRuntime::Feature*, Esri::ArcGISRuntime::SimpleLineSymbol*>> m_featureHash;
+  QUuid m_addFeaturesTaskId;
+  QList<QPair<Esri::ArcGISRuntime::Feature*, Esri::ArcGISRuntime::SimpleLineSymbol*>> m_pendingSymbolOverrides;
+
+  // one symbol per markup color, shared by all of the elements drawn in that color
+  QVector<Esri::ArcGISRuntime::SimpleLineSymbol*> m_colorSymbols;
 };
 
 } // Dsa
@@ -0,0 +1,170 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "MarkupStore.h"
+
+// Qt headers
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QThreadPool>
+
+namespace Dsa {
+
+/*!
+  \class Dsa::MarkupStore
+  \inmodule Dsa
+  \inherits QObject
+  \brief Writes received markups to \c .markup files on a background thread.
+
+  Each markup is identified by the hash of its content. A markup which has already
+  been stored in this session, such as one broadcast again for teammates who missed
+  it, is given the path of the existing file rather than a new one.
+
+  The most recently stored markups are also kept in memory, so that layers can be
+  created from them without reading their files back, or before the files have
+  been written.
+
+  \sa MarkupBroadcast
+  \sa MarkupLayer::createFromPath
+ */
+
+/*!
+  \brief Returns the singleton instance of the store.
+ */
+MarkupStore* MarkupStore::instance()
+{
+  static MarkupStore s_instance;
+
+  return &s_instance;
+}
+
+/*!
+  \internal
+ */
+MarkupStore::MarkupStore(QObject* parent):
+  QObject(parent),
+  m_threadPool(new QThreadPool(this))
+{
+  // files are written one at a time, in the order the markups were received
+  m_threadPool->setMaxThreadCount(1);
+}
+
+/*!
+  \brief Destructor.
+ */
+MarkupStore::~MarkupStore()
+{
+  m_threadPool->waitForDone();
+}
+
+/*!
+  \brief Stores \a markupObject, named \a markupName and with the content \a hash, in
+  \a directory and returns the path of its file.
+
+  The file is written on a background thread. If a markup with the same \a hash has
+  already been stored, no new file is written and the existing path is returned.
+  Otherwise the file is named after the markup, with a timestamp added if a markup
+  of that name already exists.
+ */
+QString MarkupStore::store(const QString& directory, const QString& markupName, const QJsonObject& markupObject, const QString& hash)
+{
+  const QString storedPath = m_hashPaths.value(hash);
+  if (!storedPath.isEmpty() && (m_pendingPaths.contains(storedPath) || QFileInfo::exists(storedPath)))
+  {
+    keepDocument(storedPath, markupObject);
+    return storedPath;
+  }
+
+  const QString path = uniquePath(directory, markupName);
+  m_hashPaths.insert(hash, path);
+  m_pendingPaths.insert(path);
+  keepDocument(path, markupObject);
+
+  const QByteArray json = QJsonDocument(markupObject).toJson(QJsonDocument::Compact) + '\n';
+  m_threadPool->start([this, json, path, directory]()
+  {
+    if (QDir().mkpath(directory))
+    {
+      QSaveFile file(path);
+      if (file.open(QIODevice::WriteOnly))
+      {
+        file.write(json);
+        file.commit();
+      }
+    }
+
+    QMetaObject::invokeMethod(this, [this, path]()
+    {
+      m_pendingPaths.remove(path);
+    }, Qt::QueuedConnection);
+  });
+
+  return path;
+}
+
+/*!
+  \brief Reads the markup stored at \a path into \a markupObject, if it is held in memory.
+
+  Returns \c false if the markup is not held, in which case it should be read from its file.
+ */
+bool MarkupStore::document(const QString& path, QJsonObject& markupObject) const
+{
+  const auto findIt = m_documents.constFind(QFileInfo(path).absoluteFilePath());
+  if (findIt == m_documents.constEnd())
+    return false;
+
+  markupObject = findIt.value();
+  return true;
+}
+
+/*!
+  \internal
+
+  Returns a path in \a directory for a new markup named \a markupName, which neither
+  exists nor is being written.
+ */
+QString MarkupStore::uniquePath(const QString& directory, const QString& markupName) const
+{
+  const QString path = QString("%1/%2.markup").arg(directory, markupName);
+  if (!QFileInfo::exists(path) && !m_pendingPaths.contains(path))
+    return path;
+
+  return QString("%1/%2_%3.markup").arg(directory, markupName, QString::number(QDateTime::currentMSecsSinceEpoch()));
+}
+
+/*!
+  \internal
+
+  Holds \a markupObject in memory for \a path, discarding the least recently stored markups.
+ */
+void MarkupStore::keepDocument(const QString& path, const QJsonObject& markupObject)
+{
+  const QString absolutePath = QFileInfo(path).absoluteFilePath();
+  m_documentOrder.removeOne(absolutePath);
+  m_documentOrder.append(absolutePath);
+  m_documents.insert(absolutePath, markupObject);
+
+  while (m_documentOrder.size() > s_maximumDocuments)
+    m_documents.remove(m_documentOrder.takeFirst());
+}
+
+} // Dsa
@@ -0,0 +1,62 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef MARKUPSTORE_H
+#define MARKUPSTORE_H
+
+// Qt headers
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QString>
+
+class QThreadPool;
+
+namespace Dsa {
+
+class MarkupStore : public QObject
+{
+  Q_OBJECT
+
+public:
+  static MarkupStore* instance();
+
+  ~MarkupStore();
+
+  QString store(const QString& directory, const QString& markupName, const QJsonObject& markupObject, const QString& hash);
+  bool document(const QString& path, QJsonObject& markupObject) const;
+
+private:
+  explicit MarkupStore(QObject* parent = nullptr);
+  Q_DISABLE_COPY(MarkupStore)
+
+  QString uniquePath(const QString& directory, const QString& markupName) const;
+  void keepDocument(const QString& path, const QJsonObject& markupObject);
+
+  static constexpr int s_maximumDocuments = 8;
+
+  QThreadPool* m_threadPool = nullptr;
+  QSet<QString> m_pendingPaths;
+  QHash<QString, QString> m_hashPaths;
+  QHash<QString, QJsonObject> m_documents;
+  QList<QString> m_documentOrder;
+};
+
+} // Dsa
+
+#endif // MARKUPSTORE_H
@@ -0,0 +1,341 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "CompactMessageCodec.h"
+
+// dsa app headers
+#include "MessageIdTable.h"
+
+// C++ API headers
+#include "GeometryEngine.h"
+
+// Qt headers
+#include <QDataStream>
+#include <QMutex>
+#include <QMutexLocker>
+
+// STL headers
+#include <cmath>
+#include <limits>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+namespace {
+
+enum CompactFlags : quint8
+{
+  DeltaFrame = 0x01,
+  HasZ = 0x02
+};
+
+// coordinates are stored as integers of 1e-7 degrees (~1 cm) and z in centimeters
+constexpr double s_coordinateScale = 1.0e7;
+constexpr double s_zScale = 100.0;
+
+// receivers only keep key frames for this many senders
+constexpr int s_maxReceivedKeyFrames = 10000;
+
+struct ReceivedKeyFrame
+{
+  quint16 sequence = 0;
+  qint32 x = 0;
+  qint32 y = 0;
+  qint32 z = 0;
+};
+
+QMutex s_receivedKeyFramesMutex;
+QHash<QString, ReceivedKeyFrame> s_receivedKeyFrames;
+
+void writeString(QDataStream& stream, const QString& value)
+{
+  QByteArray bytes = value.toUtf8();
+  if (bytes.size() > std::numeric_limits<quint8>::max())
+    bytes.truncate(std::numeric_limits<quint8>::max());
+
+  stream << static_cast<quint8>(bytes.size());
+  stream.writeRawData(bytes.constData(), bytes.size());
+}
+
+bool readString(QDataStream& stream, QString& value)
+{
+  quint8 length = 0;
+  stream >> length;
+
+  QByteArray bytes(length, Qt::Uninitialized);
+  if (stream.readRawData(bytes.data(), length) != length)
+    return false;
+
+  value = QString::fromUtf8(bytes);
+  return true;
+}
+
+qint32 toFixed(double value, double scale)
+{
+  return static_cast<qint32>(std::lround(value * scale));
+}
+
+bool fitsInDelta(qint32 value, qint32 base)
+{
+  const qint64 delta = static_cast<qint64>(value) - base;
+  return delta >= std::numeric_limits<qint16>::min() && delta <= std::numeric_limits<qint16>::max();
+}
+
+}
+
+const char CompactMessageCodec::MAGIC_BYTE = static_cast<char>(0xD5);
+const quint8 CompactMessageCodec::VERSION = 1;
+
+/*!
+  \class Dsa::CompactMessageCodec
+  \inmodule Dsa
+  \brief Encodes and decodes position messages in a compact, fixed-layout binary format.
+
+  The format is intended for broadcasting positions over low bandwidth networks.
+  The GeoMessage XML format remains the default, interoperable format.
+
+  Each encoded message starts with \l MAGIC_BYTE and the format \l VERSION, which
+  allows \l Message::create to detect the format. The layout (in network byte order) is:
+
+  \list
+    \li \c quint8 magic byte, \c quint8 version, \c quint8 flags, \c qint8 message action.
+    \li \c quint16 sequence number and \c quint16 key frame sequence number.
+    \li The message ID, message type, symbol ID and unique designation, each as a
+      \c quint8 length followed by UTF-8 bytes.
+    \li A key frame stores the WGS84 coordinates as \c qint32 values of 1e-7 degrees
+      and z in centimeters. A delta frame stores \c qint16 offsets from the coordinates
+      of the key frame it references.
+  \endlist
+
+  Delta frames always reference the most recent key frame rather than the previous
+  message, so a lost delta frame does not affect later messages. A key frame is sent
+  every \l keyFrameInterval messages, or whenever the position has moved too far to
+  be expressed as a delta.
+
+  \note Only the geometry, the symbol ID, the unique designation and the 911 status
+  of a message are encoded. Other attributes are not transmitted.
+ */
+
+/*!
+  \brief Constructor.
+ */
+CompactMessageCodec::CompactMessageCodec()
+{
+}
+
+/*!
+  \brief Destructor.
+ */
+CompactMessageCodec::~CompactMessageCodec()
+{
+}
+
+/*!
+  \brief Returns whether \a data is in the compact binary format.
+ */
+bool CompactMessageCodec::isCompactMessage(const QByteArray& data)
+{
+  return data.size() > 1 && data.at(0) == MAGIC_BYTE && static_cast<quint8>(data.at(1)) == VERSION;
+}
+
+/*!
+  \brief Returns the number of messages sent for an ID before a new key frame is sent.
+
+  The default is \c 10.
+ */
+int CompactMessageCodec::keyFrameInterval() const
+{
+  return m_keyFrameInterval;
+}
+
+/*!
+  \brief Sets the number of messages sent for an ID before a new key frame is sent to \a keyFrameInterval.
+ */
+void CompactMessageCodec::setKeyFrameInterval(int keyFrameInterval)
+{
+  m_keyFrameInterval = qMax(1, keyFrameInterval);
+}
+
+/*!
+  \brief Encodes the point \a message in the compact binary format.
+
+  Returns an empty byte array if the message does not have a point geometry.
+ */
+QByteArray CompactMessageCodec::encode(const Message& message)
+{
+  const Geometry geometry = message.geometry();
+  if (geometry.isEmpty() || geometry.geometryType() != GeometryType::Point)
+    return QByteArray();
+
+  const Point point = geometry_cast<Point>(geometry.spatialReference() == SpatialReference::wgs84() ?
+                                             geometry : GeometryEngine::project(geometry, SpatialReference::wgs84()));
+
+  const qint32 x = toFixed(point.x(), s_coordinateScale);
+  const qint32 y = toFixed(point.y(), s_coordinateScale);
+  const qint32 z = point.hasZ() ? toFixed(point.z(), s_zScale) : 0;
+
+  const quint16 sequence = m_nextSequence++;
+  const QString messageId = message.messageId();
+
+  // use a delta frame while the previous key frame is recent and close enough
+  quint8 flags = point.hasZ() ? HasZ : 0;
+  const quint32 generation = MessageIdTable::instance()->generation(message.messageKey());
+  auto keyFrameIt = m_keyFrames.find(message.messageKey());
+  if (message.messageAction() == Message::MessageAction::Update &&
+      keyFrameIt != m_keyFrames.end() &&
+      keyFrameIt->generation == generation &&
+      keyFrameIt->deltaCount < m_keyFrameInterval - 1 &&
+      fitsInDelta(x, keyFrameIt->x) && fitsInDelta(y, keyFrameIt->y) && fitsInDelta(z, keyFrameIt->z))
+  {
+    flags |= DeltaFrame;
+    ++keyFrameIt->deltaCount;
+  }
+  else if (message.messageAction() == Message::MessageAction::Remove)
+  {
+    m_keyFrames.remove(message.messageKey());
+  }
+  else
+  {
+    KeyFrame keyFrame;
+    keyFrame.generation = generation;
+    keyFrame.sequence = sequence;
+    keyFrame.x = x;
+    keyFrame.y = y;
+    keyFrame.z = z;
+    keyFrameIt = m_keyFrames.insert(message.messageKey(), keyFrame);
+  }
+
+  const MessageAttributes attributes = message.messageAttributes();
+
+  QByteArray data;
+  QDataStream stream(&data, QIODevice::WriteOnly);
+  stream << static_cast<quint8>(MAGIC_BYTE) << VERSION << flags << static_cast<qint8>(message.messageAction());
+  stream << sequence << ((flags & DeltaFrame) ? keyFrameIt->sequence : sequence);
+  writeString(stream, messageId);
+  writeString(stream, message.messageType());
+  writeString(stream, message.symbolId());
+  writeString(stream, attributes.value(Message::GEOMESSAGE_UNIQUE_DESIGNATION_NAME).toString());
+  stream << static_cast<quint8>(attributes.value(Message::GEOMESSAGE_STATUS_911_NAME).toInt());
+
+  if (flags & DeltaFrame)
+  {
+    stream << static_cast<qint16>(x - keyFrameIt->x)
+           << static_cast<qint16>(y - keyFrameIt->y)
+           << static_cast<qint16>(z - keyFrameIt->z);
+  }
+  else
+  {
+    stream << x << y << z;
+  }
+
+  return data;
+}
+
+/*!
+  \brief Decodes \a data in the compact binary format into a \l Message.
+
+  Returns an empty message if the data cannot be decoded, for example because
+  it is a delta frame whose key frame has not been received.
+
+  This method is thread-safe.
+ */
+Message CompactMessageCodec::decode(const QByteArray& data)
+{
+  if (!isCompactMessage(data))
+    return Message();
+
+  QDataStream stream(data);
+  quint8 magic = 0;
+  quint8 version = 0;
+  quint8 flags = 0;
+  qint8 action = 0;
+  quint16 sequence = 0;
+  quint16 keySequence = 0;
+  stream >> magic >> version >> flags >> action >> sequence >> keySequence;
+
+  QString messageId;
+  QString messageType;
+  QString symbolId;
+  QString uniqueDesignation;
+  if (!readString(stream, messageId) || !readString(stream, messageType) ||
+      !readString(stream, symbolId) || !readString(stream, uniqueDesignation))
+  {
+    return Message();
+  }
+
+  quint8 status911 = 0;
+  stream >> status911;
+
+  ReceivedKeyFrame keyFrame;
+  if (flags & DeltaFrame)
+  {
+    qint16 dx = 0;
+    qint16 dy = 0;
+    qint16 dz = 0;
+    stream >> dx >> dy >> dz;
+    if (stream.status() != QDataStream::Ok)
+      return Message();
+
+    QMutexLocker locker(&s_receivedKeyFramesMutex);
+    const auto keyFrameIt = s_receivedKeyFrames.constFind(messageId);
+    if (keyFrameIt == s_receivedKeyFrames.constEnd() || keyFrameIt->sequence != keySequence)
+      return Message();
+
+    keyFrame = keyFrameIt.value();
+    keyFrame.x += dx;
+    keyFrame.y += dy;
+    keyFrame.z += dz;
+  }
+  else
+  {
+    stream >> keyFrame.x >> keyFrame.y >> keyFrame.z;
+    if (stream.status() != QDataStream::Ok)
+      return Message();
+
+    keyFrame.sequence = sequence;
+
+    QMutexLocker locker(&s_receivedKeyFramesMutex);
+    if (static_cast<Message::MessageAction>(action) == Message::MessageAction::Remove)
+      s_receivedKeyFrames.remove(messageId);
+    else if (s_receivedKeyFrames.size() < s_maxReceivedKeyFrames || s_receivedKeyFrames.contains(messageId))
+      s_receivedKeyFrames.insert(messageId, keyFrame);
+  }
+
+  const Point point = (flags & HasZ) ?
+        Point(keyFrame.x / s_coordinateScale, keyFrame.y / s_coordinateScale, keyFrame.z / s_zScale, SpatialReference::wgs84()) :
+        Point(keyFrame.x / s_coordinateScale, keyFrame.y / s_coordinateScale, SpatialReference::wgs84());
+
+  // mirror the attributes which would be read from the equivalent GeoMessage
+  MessageAttributes attributes;
+  attributes.insert(Message::GEOMESSAGE_SIC_NAME, symbolId);
+  attributes.insert(Message::SIDC_NAME, symbolId);
+  attributes.insert(Message::GEOMESSAGE_UNIQUE_DESIGNATION_NAME, uniqueDesignation);
+  attributes.insert(Message::GEOMESSAGE_STATUS_911_NAME, QString::number(status911));
+
+  Message message(static_cast<Message::MessageAction>(action), point);
+  message.setMessageId(messageId);
+  message.setMessageType(messageType);
+  message.setSymbolId(symbolId);
+  message.setMessageAttributes(attributes);
+
+  return message;
+}
+
+} // Dsa
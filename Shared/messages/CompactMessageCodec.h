@@ -0,0 +1,67 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef COMPACTMESSAGECODEC_H
+#define COMPACTMESSAGECODEC_H
+
+// dsa app headers
+#include "Message.h"
+
+// Qt headers
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+
+namespace Dsa {
+
+class CompactMessageCodec
+{
+public:
+  static const char MAGIC_BYTE;
+  static const quint8 VERSION;
+
+  CompactMessageCodec();
+  ~CompactMessageCodec();
+
+  static bool isCompactMessage(const QByteArray& data);
+  static Message decode(const QByteArray& data);
+
+  QByteArray encode(const Message& message);
+
+  int keyFrameInterval() const;
+  void setKeyFrameInterval(int keyFrameInterval);
+
+private:
+  struct KeyFrame
+  {
+    // the key is not held, so a key frame from an earlier ID with the same key is ignored
+    quint32 generation = 0;
+    quint16 sequence = 0;
+    qint32 x = 0;
+    qint32 y = 0;
+    qint32 z = 0;
+    int deltaCount = 0;
+  };
+
+  int m_keyFrameInterval = 10;
+  quint16 m_nextSequence = 0;
+  // key frames sent, by interned message key
+  QHash<int, KeyFrame> m_keyFrames;
+};
+
+} // Dsa
+
+#endif // COMPACTMESSAGECODEC_H
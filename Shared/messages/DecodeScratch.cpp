@@ -0,0 +1,95 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "DecodeScratch.h"
+
+namespace Dsa {
+
+namespace {
+// coordinates kept between batches, enough for a control point list of a few thousand vertices
+constexpr int s_maximumPooledCoordinates = 3 * 4096;
+}
+
+/*!
+  \class Dsa::DecodeScratch
+  \inmodule Dsa
+  \brief Scratch objects which are reused by every message decoded on a thread.
+
+  Decoding a message needs an XML reader and temporary buffers which are
+  discarded as soon as the \l Message is built. Each thread has its own
+  scratch, obtained with \l local, so these are allocated once and reused
+  rather than allocated and freed for every message.
+
+  The scratch should be \l reset once a batch of messages has been decoded.
+  Only one message may be decoded from the scratch at a time.
+ */
+
+/*!
+  \internal
+ */
+DecodeScratch::DecodeScratch()
+{
+}
+
+/*!
+  \brief Returns the scratch of the calling thread.
+ */
+DecodeScratch* DecodeScratch::local()
+{
+  static thread_local DecodeScratch s_instance;
+  return &s_instance;
+}
+
+/*!
+  \brief Returns the XML reader of the thread, cleared and set to read \a data.
+
+  The reader reuses its internal buffers from the previous message. The \a data
+  is shared rather than copied, and held until the next message or \l reset.
+ */
+QXmlStreamReader& DecodeScratch::xmlReader(const QByteArray& data)
+{
+  m_xmlReader.clear();
+  m_xmlReader.addData(data);
+  return m_xmlReader;
+}
+
+/*!
+  \brief Returns an empty buffer of coordinates, keeping the capacity of the previous message.
+ */
+QVector<double>& DecodeScratch::coordinates()
+{
+  m_coordinates.clear();
+  return m_coordinates;
+}
+
+/*!
+  \brief Releases the data of the last message, and any buffer which has grown
+  unusually large, at the end of a batch.
+ */
+void DecodeScratch::reset()
+{
+  m_xmlReader.clear();
+
+  if (m_coordinates.capacity() > s_maximumPooledCoordinates)
+    m_coordinates = QVector<double>();
+  else
+    m_coordinates.clear();
+}
+
+} // Dsa
@@ -0,0 +1,47 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef DECODESCRATCH_H
+#define DECODESCRATCH_H
+
+// Qt headers
+#include <QByteArray>
+#include <QVector>
+#include <QXmlStreamReader>
+
+namespace Dsa {
+
+class DecodeScratch
+{
+public:
+  static DecodeScratch* local();
+
+  QXmlStreamReader& xmlReader(const QByteArray& data);
+  QVector<double>& coordinates();
+
+  void reset();
+
+private:
+  DecodeScratch();
+  Q_DISABLE_COPY(DecodeScratch)
+
+  QXmlStreamReader m_xmlReader;
+  QVector<double> m_coordinates;
+};
+
+} // Dsa
+
+#endif // DECODESCRATCH_H
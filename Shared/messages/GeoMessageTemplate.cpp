@@ -0,0 +1,225 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "GeoMessageTemplate.h"
+
+// dsa app headers
+#include "MessageAttributeSchema.h"
+
+// C++ API headers
+#include "Point.h"
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+namespace
+{
+// returns the opening and closing tags of the element called name
+QByteArray startTag(const QString& name)
+{
+  return QByteArray("<").append(name.toUtf8()).append('>');
+}
+
+QByteArray endTag(const QString& name)
+{
+  return QByteArray("</").append(name.toUtf8()).append('>');
+}
+}
+
+/*!
+  \class Dsa::GeoMessageTemplate
+  \inmodule Dsa
+  \brief Encodes repeated updates of the same point \l Message as GeoMessages.
+
+  Senders such as \l LocationBroadcast send the same message on every tick, with
+  only its location and \c status911 attribute changing. The first message is
+  rendered in full with \l Message::toGeoMessage and split around those two values.
+  Later messages which only differ in those values are encoded by copying the
+  rendered parts into a reused buffer and formatting the new values between them,
+  rather than building a new XML document.
+
+  The template is rebuilt whenever any other part of the message changes, so the
+  output is always the same as \l Message::toGeoMessage.
+ */
+
+/*!
+  \brief Constructor.
+ */
+GeoMessageTemplate::GeoMessageTemplate()
+{
+}
+
+/*!
+  \brief Destructor.
+ */
+GeoMessageTemplate::~GeoMessageTemplate()
+{
+}
+
+/*!
+  \brief Returns \a message encoded as a GeoMessage.
+
+  Messages without a point geometry are always rendered in full.
+ */
+QByteArray GeoMessageTemplate::encode(const Message& message)
+{
+  if (message.geometry().geometryType() != GeometryType::Point)
+    return message.toGeoMessage();
+
+  if (!matchesTemplate(message) && !buildTemplate(message))
+    return message.toGeoMessage();
+
+  const Point point = geometry_cast<Point>(message.geometry());
+
+  // the buffer keeps its capacity between messages once it is no longer shared with the last result
+  m_buffer.truncate(0);
+  m_buffer.append(m_prefix);
+  m_buffer.append(QByteArray::number(point.x(), 'g', 9));
+  m_buffer.append(',');
+  m_buffer.append(QByteArray::number(point.y(), 'g', 9));
+  if (point.hasZ())
+  {
+    m_buffer.append(',');
+    m_buffer.append(QByteArray::number(point.z(), 'g', 9));
+  }
+  m_buffer.append(m_middle);
+
+  if (m_hasStatus911)
+  {
+    const QString status911 = message.attributeValue(Message::GEOMESSAGE_STATUS_911_NAME).toString();
+    m_buffer.append(status911.toHtmlEscaped().toUtf8());
+    m_buffer.append(m_suffix);
+  }
+
+  return m_buffer;
+}
+
+/*!
+  \brief Discards the template, so that the next message is rendered in full.
+ */
+void GeoMessageTemplate::invalidate()
+{
+  m_valid = false;
+}
+
+/*!
+  \internal
+  \brief Returns whether \a message only differs from the template in its
+  control points and status911 values.
+ */
+bool GeoMessageTemplate::matchesTemplate(const Message& message) const
+{
+  if (!m_valid ||
+      message.messageAction() != m_messageAction ||
+      message.geometry().spatialReference().wkid() != m_wkid ||
+      message.messageId() != m_messageId ||
+      message.messageType() != m_messageType)
+  {
+    return false;
+  }
+
+  const MessageAttributes attributes = message.messageAttributes();
+  if (attributes.contains(Message::GEOMESSAGE_STATUS_911_NAME) != m_hasStatus911)
+    return false;
+
+  const int staticCount = attributes.size() - (m_hasStatus911 ? 1 : 0);
+  if (staticCount != m_staticAttributes.size())
+    return false;
+
+  // both sets are sorted by name index, so they can be compared in order
+  const int status911Index = MessageAttributeSchema::instance()->indexOf(Message::GEOMESSAGE_STATUS_911_NAME);
+  int staticIndex = 0;
+  for (int i = 0; i < attributes.size(); ++i)
+  {
+    if (attributes.keyIndexAt(i) == status911Index)
+      continue;
+
+    if (attributes.keyIndexAt(i) != m_staticAttributes.keyIndexAt(staticIndex) ||
+        attributes.valueAt(i) != m_staticAttributes.valueAt(staticIndex))
+    {
+      return false;
+    }
+
+    ++staticIndex;
+  }
+
+  return true;
+}
+
+/*!
+  \internal
+  \brief Renders \a message in full and splits it around its dynamic values.
+
+  Returns \c false if the rendered message could not be split.
+ */
+bool GeoMessageTemplate::buildTemplate(const Message& message)
+{
+  m_valid = false;
+
+  const QByteArray rendered = message.toGeoMessage();
+
+  const QByteArray controlPointsStart = startTag(Message::GEOMESSAGE_CONTROL_POINTS_NAME);
+  const QByteArray controlPointsEnd = endTag(Message::GEOMESSAGE_CONTROL_POINTS_NAME);
+  const int valueStart = rendered.indexOf(controlPointsStart);
+  if (valueStart == -1)
+    return false;
+
+  const int prefixSize = valueStart + controlPointsStart.size();
+  const int valueEnd = rendered.indexOf(controlPointsEnd, prefixSize);
+  if (valueEnd == -1)
+    return false;
+
+  const MessageAttributes attributes = message.messageAttributes();
+  const bool hasStatus911 = attributes.contains(Message::GEOMESSAGE_STATUS_911_NAME);
+
+  m_prefix = rendered.left(prefixSize);
+  if (hasStatus911)
+  {
+    // attributes are written after the control points
+    const QByteArray status911Start = startTag(Message::GEOMESSAGE_STATUS_911_NAME);
+    const int statusStart = rendered.indexOf(status911Start, valueEnd);
+    const int statusValueStart = statusStart + status911Start.size();
+    const int statusEnd = statusStart == -1 ? -1 : rendered.indexOf(endTag(Message::GEOMESSAGE_STATUS_911_NAME), statusValueStart);
+    if (statusEnd == -1)
+      return false;
+
+    m_middle = rendered.mid(valueEnd, statusValueStart - valueEnd);
+    m_suffix = rendered.mid(statusEnd);
+  }
+  else
+  {
+    m_middle = rendered.mid(valueEnd);
+    m_suffix.clear();
+  }
+
+  m_messageType = message.messageType();
+  m_messageAction = message.messageAction();
+  m_messageId = message.messageId();
+  m_wkid = message.geometry().spatialReference().wkid();
+  m_staticAttributes = attributes;
+  m_staticAttributes.remove(Message::GEOMESSAGE_STATUS_911_NAME);
+  m_hasStatus911 = hasStatus911;
+
+  m_buffer.reserve(rendered.size() + 32);
+  m_valid = true;
+  return true;
+}
+
+} // Dsa
@@ -0,0 +1,60 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef GEOMESSAGETEMPLATE_H
+#define GEOMESSAGETEMPLATE_H
+
+// dsa app headers
+#include "Message.h"
+
+// Qt headers
+#include <QByteArray>
+#include <QString>
+
+namespace Dsa {
+
+class GeoMessageTemplate
+{
+public:
+  GeoMessageTemplate();
+  ~GeoMessageTemplate();
+
+  QByteArray encode(const Message& message);
+  void invalidate();
+
+private:
+  bool matchesTemplate(const Message& message) const;
+  bool buildTemplate(const Message& message);
+
+  bool m_valid = false;
+  QString m_messageType;
+  Message::MessageAction m_messageAction = Message::MessageAction::Unknown;
+  QString m_messageId;
+  int m_wkid = 0;
+  MessageAttributes m_staticAttributes;
+  bool m_hasStatus911 = false;
+
+  // the rendered message, split around the control points and status911 values
+  QByteArray m_prefix;
+  QByteArray m_middle;
+  QByteArray m_suffix;
+
+  QByteArray m_buffer;
+};
+
+} // Dsa
+
+#endif // GEOMESSAGETEMPLATE_H
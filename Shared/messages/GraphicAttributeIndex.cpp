@@ -0,0 +1,237 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "GraphicAttributeIndex.h"
+
+// dsa app headers
+#include "MessageAttributes.h"
+
+// C++ API headers
+#include "AttributeListModel.h"
+#include "Graphic.h"
+#include "GraphicListModel.h"
+#include "GraphicsOverlay.h"
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+/*!
+  \class Dsa::GraphicAttributeIndex
+  \inmodule Dsa
+  \inherits QObject
+  \brief An inverted index from attribute values to the graphics of a \l MessagesOverlay.
+
+  Only attributes which have been watched with \l watchAttribute are indexed. For each
+  watched attribute, the index records the value of every graphic and the set of
+  graphics with each value, so that graphics can be found by value without scanning
+  the attributes of every graphic.
+
+  The index is kept up to date by the \l MessagesOverlay as messages are applied. The
+  \l attributeChanged signal is only emitted when the value of a watched attribute
+  actually changes, rather than on every update to a graphic.
+
+  Values are grouped by their string representation.
+ */
+
+/*!
+  \brief Constructor taking the \a graphicsOverlay to index and an optional \a parent.
+ */
+GraphicAttributeIndex::GraphicAttributeIndex(GraphicsOverlay* graphicsOverlay, QObject* parent):
+  QObject(parent),
+  m_graphicsOverlay(graphicsOverlay)
+{
+}
+
+/*!
+  \brief Destructor.
+ */
+GraphicAttributeIndex::~GraphicAttributeIndex()
+{
+}
+
+/*!
+  \brief Starts indexing the attribute \a attributeName.
+
+  The first time an attribute is watched, the index is built from the graphics currently
+  in the overlay. Each call should be matched by a call to \l unwatchAttribute.
+ */
+void GraphicAttributeIndex::watchAttribute(const QString& attributeName)
+{
+  AttributeEntry& entry = m_entries[attributeName];
+  if (entry.m_watchCount++ > 0)
+    return;
+
+  if (!m_graphicsOverlay)
+    return;
+
+  const GraphicListModel* graphics = m_graphicsOverlay->graphics();
+  if (!graphics)
+    return;
+
+  const int count = graphics->rowCount();
+  for (int i = 0; i < count; ++i)
+  {
+    Graphic* graphic = graphics->at(i);
+    if (!graphic || !graphic->attributes())
+      continue;
+
+    insertValue(entry, graphic, graphic->attributes()->attributeValue(attributeName));
+  }
+}
+
+/*!
+  \brief Stops indexing the attribute \a attributeName once it is no longer watched.
+ */
+void GraphicAttributeIndex::unwatchAttribute(const QString& attributeName)
+{
+  auto findIt = m_entries.find(attributeName);
+  if (findIt == m_entries.end())
+    return;
+
+  if (--findIt.value().m_watchCount <= 0)
+    m_entries.erase(findIt);
+}
+
+/*!
+  \brief Returns whether the attribute \a attributeName is indexed.
+ */
+bool GraphicAttributeIndex::isWatched(const QString& attributeName) const
+{
+  return m_entries.contains(attributeName);
+}
+
+/*!
+  \brief Returns the indexed value of the attribute \a attributeName for \a graphic.
+
+  Returns an invalid QVariant if the attribute is not watched or the graphic does not
+  have the attribute.
+ */
+QVariant GraphicAttributeIndex::value(Graphic* graphic, const QString& attributeName) const
+{
+  auto findIt = m_entries.constFind(attributeName);
+  if (findIt == m_entries.constEnd())
+    return QVariant();
+
+  return findIt.value().m_values.value(graphic);
+}
+
+/*!
+  \brief Returns the graphics whose attribute \a attributeName has \a value.
+
+  Returns an empty list if the attribute is not watched.
+ */
+QList<Graphic*> GraphicAttributeIndex::graphics(const QString& attributeName, const QVariant& value) const
+{
+  auto findIt = m_entries.constFind(attributeName);
+  if (findIt == m_entries.constEnd())
+    return QList<Graphic*>();
+
+  return findIt.value().m_graphicsByValue.value(valueKey(value)).values();
+}
+
+/*!
+  \brief Updates the index with the new \a attributes of \a graphic.
+
+  \l attributeChanged is emitted for each watched attribute whose value has changed.
+  No signal is emitted for a graphic which was not previously indexed.
+ */
+void GraphicAttributeIndex::updateGraphic(Graphic* graphic, const MessageAttributes& attributes)
+{
+  if (!graphic)
+    return;
+
+  for (auto it = m_entries.begin(); it != m_entries.end(); ++it)
+  {
+    AttributeEntry& entry = it.value();
+    const QVariant newValue = attributes.value(it.key());
+
+    auto valueIt = entry.m_values.constFind(graphic);
+    if (valueIt == entry.m_values.constEnd())
+    {
+      insertValue(entry, graphic, newValue);
+      continue;
+    }
+
+    if (valueIt.value() == newValue)
+      continue;
+
+    removeValue(entry, graphic);
+    insertValue(entry, graphic, newValue);
+
+    emit attributeChanged(graphic, it.key());
+  }
+}
+
+/*!
+  \brief Removes \a graphic from the index.
+ */
+void GraphicAttributeIndex::removeGraphic(Graphic* graphic)
+{
+  for (auto it = m_entries.begin(); it != m_entries.end(); ++it)
+    removeValue(it.value(), graphic);
+}
+
+/*!
+  \internal
+
+  Returns the key used to group graphics with \a value.
+ */
+QString GraphicAttributeIndex::valueKey(const QVariant& value)
+{
+  return value.toString();
+}
+
+/*!
+  \internal
+ */
+void GraphicAttributeIndex::insertValue(AttributeEntry& entry, Graphic* graphic, const QVariant& value)
+{
+  entry.m_values.insert(graphic, value);
+  entry.m_graphicsByValue[valueKey(value)].insert(graphic);
+}
+
+/*!
+  \internal
+ */
+void GraphicAttributeIndex::removeValue(AttributeEntry& entry, Graphic* graphic)
+{
+  auto valueIt = entry.m_values.find(graphic);
+  if (valueIt == entry.m_values.end())
+    return;
+
+  const QString key = valueKey(valueIt.value());
+  entry.m_values.erase(valueIt);
+
+  auto graphicsIt = entry.m_graphicsByValue.find(key);
+  if (graphicsIt == entry.m_graphicsByValue.end())
+    return;
+
+  graphicsIt.value().remove(graphic);
+  if (graphicsIt.value().isEmpty())
+    entry.m_graphicsByValue.erase(graphicsIt);
+}
+
+} // Dsa
+
+// Signal Documentation
+/*!
+  \fn void GraphicAttributeIndex::attributeChanged(Esri::ArcGISRuntime::Graphic* graphic, const QString& attributeName);
+  \brief Signal emitted when the value of the watched attribute \a attributeName of \a graphic changes.
+ */
@@ -0,0 +1,81 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef GRAPHICATTRIBUTEINDEX_H
+#define GRAPHICATTRIBUTEINDEX_H
+
+// Qt headers
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QVariant>
+
+namespace Esri
+{
+  namespace ArcGISRuntime
+  {
+    class Graphic;
+    class GraphicsOverlay;
+  }
+}
+
+namespace Dsa {
+
+class MessageAttributes;
+
+class GraphicAttributeIndex : public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit GraphicAttributeIndex(Esri::ArcGISRuntime::GraphicsOverlay* graphicsOverlay, QObject* parent = nullptr);
+  ~GraphicAttributeIndex();
+
+  void watchAttribute(const QString& attributeName);
+  void unwatchAttribute(const QString& attributeName);
+  bool isWatched(const QString& attributeName) const;
+
+  QVariant value(Esri::ArcGISRuntime::Graphic* graphic, const QString& attributeName) const;
+  QList<Esri::ArcGISRuntime::Graphic*> graphics(const QString& attributeName, const QVariant& value) const;
+
+  void updateGraphic(Esri::ArcGISRuntime::Graphic* graphic, const MessageAttributes& attributes);
+  void removeGraphic(Esri::ArcGISRuntime::Graphic* graphic);
+
+signals:
+  void attributeChanged(Esri::ArcGISRuntime::Graphic* graphic, const QString& attributeName);
+
+private:
+  Q_DISABLE_COPY(GraphicAttributeIndex)
+
+  struct AttributeEntry
+  {
+    int m_watchCount = 0;
+    QHash<Esri::ArcGISRuntime::Graphic*, QVariant> m_values;
+    QHash<QString, QSet<Esri::ArcGISRuntime::Graphic*>> m_graphicsByValue;
+  };
+
+  static QString valueKey(const QVariant& value);
+  static void insertValue(AttributeEntry& entry, Esri::ArcGISRuntime::Graphic* graphic, const QVariant& value);
+  static void removeValue(AttributeEntry& entry, Esri::ArcGISRuntime::Graphic* graphic);
+
+  Esri::ArcGISRuntime::GraphicsOverlay* m_graphicsOverlay = nullptr;
+  QHash<QString, AttributeEntry> m_entries;
+};
+
+} // Dsa
+
+#endif // GRAPHICATTRIBUTEINDEX_H
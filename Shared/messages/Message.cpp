@@ -19,6 +19,11 @@
 
 // dsa app headers
 #include "Message.h"
+#include "CompactMessageCodec.h"
+#include "DecodeScratch.h"
+#include "MessageAttributeSchema.h"
+#include "MessageIdTable.h"
+#include "TakProtocolCodec.h"
 
 // C++ API headers
 #include "Point.h"
@@ -26,15 +31,25 @@
 #include "PolylineBuilder.h"
 
 // Qt headers
-#include <QDomDocument>
+#include <QDate>
+#include <QDateTime>
+#include <QtNumeric>
+#include <QReadWriteLock>
+#include <QVarLengthArray>
+#include <QVector>
 #include <QXmlStreamReader>
 
+// STL headers
+#include <cstring>
+
 namespace Dsa {
 
 const QString Message::COT_ROOT_ELEMENT_NAME{QStringLiteral("events")};
 const QString Message::COT_ELEMENT_NAME{QStringLiteral("event")};
 const QString Message::COT_TYPE_NAME{QStringLiteral("type")};
 const QString Message::COT_UID_NAME{QStringLiteral("uid")};
+const QString Message::COT_TIME_NAME{QStringLiteral("time")};
+const QString Message::COT_STALE_NAME{QStringLiteral("stale")};
 const QString Message::COT_POINT_NAME{QStringLiteral("point")};
 const QString Message::COT_POINT_LAT_NAME{QStringLiteral("lat")};
 const QString Message::COT_POINT_LON_NAME{QStringLiteral("lon")};
@@ -56,6 +71,606 @@ const QString Message::SIDC_NAME{QStringLiteral("sidc")};
 
 using namespace Esri::ArcGISRuntime;
 
+namespace {
+
+bool isXmlSpace(char c)
+{
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+bool nameEquals(const char* name, int nameLength, const char* literal)
+{
+  return nameLength == static_cast<int>(qstrlen(literal)) && qstrncmp(name, literal, nameLength) == 0;
+}
+
+// returns whether the element tag (e.g. "<event") starts at the given position
+bool isStartTag(const QByteArray& message, int pos, const char* tag)
+{
+  const int tagLength = static_cast<int>(qstrlen(tag));
+  if (pos < 0 || pos + tagLength >= message.size())
+    return false;
+
+  if (qstrncmp(message.constData() + pos, tag, tagLength) != 0)
+    return false;
+
+  const char next = message.at(pos + tagLength);
+  return isXmlSpace(next) || next == '>' || next == '/';
+}
+
+// returns the position of the first element, skipping whitespace, the XML declaration
+// and comments, or -1 if anything else is found
+int skipProlog(const QByteArray& message)
+{
+  int pos = 0;
+  const int size = message.size();
+  while (pos < size)
+  {
+    const char c = message.at(pos);
+    if (isXmlSpace(c))
+    {
+      ++pos;
+      continue;
+    }
+
+    if (c != '<' || pos + 1 >= size)
+      return -1;
+
+    if (message.at(pos + 1) == '?')
+    {
+      const int end = message.indexOf("?>", pos + 2);
+      if (end == -1)
+        return -1;
+
+      pos = end + 2;
+      continue;
+    }
+
+    if (qstrncmp(message.constData() + pos, "<!--", 4) == 0)
+    {
+      const int end = message.indexOf("-->", pos + 4);
+      if (end == -1)
+        return -1;
+
+      pos = end + 3;
+      continue;
+    }
+
+    return pos;
+  }
+
+  return -1;
+}
+
+// scans the attributes of the start tag beginning at pos (just after the element name),
+// passing each name and value to the handler without copying them. Returns the position after
+// the end of the tag or -1 if the tag could not be scanned
+template <typename Handler>
+int scanAttributes(const QByteArray& message, int pos, bool& selfClosing, Handler handler)
+{
+  const char* data = message.constData();
+  const int size = message.size();
+  selfClosing = false;
+
+  while (pos < size)
+  {
+    while (pos < size && isXmlSpace(data[pos]))
+      ++pos;
+
+    if (pos >= size)
+      return -1;
+
+    if (data[pos] == '>')
+      return pos + 1;
+
+    if (data[pos] == '/')
+    {
+      if (pos + 1 >= size || data[pos + 1] != '>')
+        return -1;
+
+      selfClosing = true;
+      return pos + 2;
+    }
+
+    const int nameStart = pos;
+    while (pos < size && data[pos] != '=' && !isXmlSpace(data[pos]) && data[pos] != '>' && data[pos] != '/')
+      ++pos;
+
+    const int nameLength = pos - nameStart;
+    while (pos < size && isXmlSpace(data[pos]))
+      ++pos;
+
+    if (nameLength == 0 || pos >= size || data[pos] != '=')
+      return -1;
+
+    ++pos;
+    while (pos < size && isXmlSpace(data[pos]))
+      ++pos;
+
+    if (pos >= size || (data[pos] != '"' && data[pos] != '\''))
+      return -1;
+
+    const char quote = data[pos];
+    const int valueStart = ++pos;
+    while (pos < size && data[pos] != quote)
+      ++pos;
+
+    if (pos >= size)
+      return -1;
+
+    if (!handler(data + nameStart, nameLength, data + valueStart, pos - valueStart))
+      return -1;
+
+    ++pos;
+  }
+
+  return -1;
+}
+
+// returns the position after the name of the element whose tag starts at pos, or pos + 1 if
+// it has no name
+int scanElementName(const QByteArray& message, int pos)
+{
+  const char* data = message.constData();
+  const int size = message.size();
+  int nameEnd = pos + 1;
+  while (nameEnd < size && !isXmlSpace(data[nameEnd]) && data[nameEnd] != '>' && data[nameEnd] != '/')
+    ++nameEnd;
+
+  return nameEnd;
+}
+
+// scans the content of the root element from pos, just after its start tag, checking that the
+// elements within it are properly nested and closed. The handler is given the name, depth and
+// position of each start tag within the root, and can reject the document. Returns the position
+// after the end tag of the root or -1 if the content is malformed or needs the full parser, for
+// example because it has CDATA sections or processing instructions
+template <typename Handler>
+int scanElementContent(const QByteArray& message, int pos, const char* rootName, Handler handler)
+{
+  const char* data = message.constData();
+  const int size = message.size();
+
+  // the start and length of the name of each open element within the root
+  QVarLengthArray<QPair<int, int>, 8> openElements;
+
+  while (true)
+  {
+    const int tagPos = message.indexOf('<', pos);
+    if (tagPos == -1 || tagPos + 1 >= size)
+      return -1;
+
+    const char next = data[tagPos + 1];
+    if (next == '!')
+    {
+      if (qstrncmp(data + tagPos, "<!--", 4) != 0)
+        return -1;
+
+      const int commentEnd = message.indexOf("-->", tagPos + 4);
+      if (commentEnd == -1)
+        return -1;
+
+      pos = commentEnd + 3;
+      continue;
+    }
+
+    if (next == '?')
+      return -1;
+
+    if (next == '/')
+    {
+      const int nameStart = tagPos + 2;
+      const int nameEnd = scanElementName(message, tagPos + 1);
+      int tagEnd = nameEnd;
+      while (tagEnd < size && isXmlSpace(data[tagEnd]))
+        ++tagEnd;
+
+      if (tagEnd >= size || data[tagEnd] != '>')
+        return -1;
+
+      const int nameLength = nameEnd - nameStart;
+      if (openElements.isEmpty())
+        return nameEquals(data + nameStart, nameLength, rootName) ? tagEnd + 1 : -1;
+
+      const QPair<int, int> openElement = openElements.last();
+      if (openElement.second != nameLength || qstrncmp(data + openElement.first, data + nameStart, nameLength) != 0)
+        return -1;
+
+      openElements.removeLast();
+      pos = tagEnd + 1;
+      continue;
+    }
+
+    const int nameStart = tagPos + 1;
+    const int nameEnd = scanElementName(message, tagPos);
+    const int nameLength = nameEnd - nameStart;
+    if (nameLength == 0 || !handler(data + nameStart, nameLength, openElements.size() + 1, tagPos))
+      return -1;
+
+    bool selfClosing = false;
+    const int tagEnd = scanAttributes(message, nameEnd, selfClosing,
+                                      [](const char*, int, const char*, int) { return true; });
+    if (tagEnd == -1)
+      return -1;
+
+    if (!selfClosing)
+      openElements.append(qMakePair(nameStart, nameLength));
+
+    pos = tagEnd;
+  }
+}
+
+// returns whether only whitespace and comments follow pos
+bool isDocumentEnd(const QByteArray& message, int pos)
+{
+  const int size = message.size();
+  while (pos < size)
+  {
+    if (isXmlSpace(message.at(pos)))
+    {
+      ++pos;
+      continue;
+    }
+
+    if (qstrncmp(message.constData() + pos, "<!--", 4) != 0)
+      return false;
+
+    const int commentEnd = message.indexOf("-->", pos + 4);
+    if (commentEnd == -1)
+      return false;
+
+    pos = commentEnd + 3;
+  }
+
+  return true;
+}
+
+// values containing entity references need the full parser
+bool hasEntity(const char* value, int length)
+{
+  return std::memchr(value, '&', static_cast<size_t>(length)) != nullptr;
+}
+
+bool toDouble(const char* value, int length, double& result)
+{
+  bool ok = false;
+  result = QByteArray::fromRawData(value, length).toDouble(&ok);
+  return ok;
+}
+
+// returns the milliseconds since the epoch of a CoT time such as 2018-01-11T17:24:42.123Z,
+// or 0 if it cannot be parsed. The UTC form sent by almost every feed is decoded without
+// building a string; any other ISO 8601 form goes through QDateTime
+qint64 parseCoTTime(const char* value, int length)
+{
+  auto digits = [value](int pos, int count)
+  {
+    int result = 0;
+    for (int i = pos; i < pos + count; ++i)
+    {
+      if (value[i] < '0' || value[i] > '9')
+        return -1;
+
+      result = result * 10 + (value[i] - '0');
+    }
+    return result;
+  };
+
+  if (length >= 20 && value[4] == '-' && value[7] == '-' && value[10] == 'T' &&
+      value[13] == ':' && value[16] == ':' && value[length - 1] == 'Z' &&
+      (length == 20 || value[19] == '.'))
+  {
+    const QDate date(digits(0, 4), digits(5, 2), digits(8, 2));
+    const int hour = digits(11, 2);
+    const int minute = digits(14, 2);
+    const int second = digits(17, 2);
+
+    // only milliseconds are kept from the fraction
+    int msecs = 0;
+    int scale = 100;
+    bool fractionOk = true;
+    for (int i = 20; i < length - 1; ++i, scale /= 10)
+    {
+      const int digit = digits(i, 1);
+      if (digit < 0)
+        fractionOk = false;
+      else if (scale > 0)
+        msecs += digit * scale;
+    }
+
+    if (date.isValid() && fractionOk && hour >= 0 && hour < 24 && minute >= 0 && minute < 60 &&
+        second >= 0 && second < 61)
+    {
+      const qint64 days = date.toJulianDay() - QDate(1970, 1, 1).toJulianDay();
+      return ((days * 24 + hour) * 60 + minute) * 60000 + second * 1000 + msecs;
+    }
+  }
+
+  const QDateTime dateTime = QDateTime::fromString(QString::fromLatin1(value, length), Qt::ISODateWithMs);
+  return dateTime.isValid() ? dateTime.toMSecsSinceEpoch() : 0;
+}
+
+qint64 parseCoTTime(const QStringRef& value)
+{
+  const QByteArray bytes = value.toLatin1();
+  return parseCoTTime(bytes.constData(), bytes.size());
+}
+
+// returns the text of the first <name> element at or after pos, or a null string if it
+// is missing or needs the full parser
+QString peekElementText(const QByteArray& message, int pos, const char* name)
+{
+  const QByteArray startTag = QByteArray("<") + name + '>';
+  const QByteArray endTag = QByteArray("</") + name + '>';
+
+  const int start = message.indexOf(startTag, pos);
+  if (start == -1)
+    return QString();
+
+  const int valueStart = start + startTag.size();
+  const int end = message.indexOf(endTag, valueStart);
+  if (end == -1)
+    return QString();
+
+  const char* value = message.constData() + valueStart;
+  const int valueLength = end - valueStart;
+  if (hasEntity(value, valueLength) || std::memchr(value, '<', static_cast<size_t>(valueLength)))
+    return QString();
+
+  return QString::fromUtf8(value, valueLength).trimmed();
+}
+
+// feeds only use a few hundred distinct types, so this bounds the cache against garbage input
+constexpr int s_maxCachedCoTTypes = 4096;
+
+QString convertCoTTypeToSidc(const QString& cotType)
+{
+  // converts a CoT type to a sidc symbol id code
+  // For example: CoT type: a-f-S-C-A to sidc: SFSPCA---------
+  QString retVal;
+
+  // recognized affiliation types for converted between CoT type
+  // and sidc symbols
+  const QString recognizedAffiliations(QStringLiteral("fhupansjku"));
+
+  // recognized battle space types for converting between CoT type
+  // and sidc symbols
+  const QString recognizedBattleSpaces(QStringLiteral("PAGSUF"));
+
+  if (cotType.mid(0, 1) != "a")
+    return QString();
+
+  // Must be of the atom type or it is not supported
+  retVal += "S";
+
+  // Convert affiliation
+  if (!recognizedAffiliations.contains(cotType.mid(2, 1)))
+    return QString();
+
+  retVal += cotType.mid(2, 1).toUpper();
+
+  // Convert battle space dimension
+  if (!recognizedBattleSpaces.contains(cotType.mid(4, 1)))
+    return QString();
+
+  retVal += cotType.mid(4, 1);
+
+  // All CoT types assumed Present (as opposed to
+  // anticipated/planned)
+  retVal += "P";
+
+  // All remaining capital letters in the string are 1:1
+  // equivalents of CoT codes (although not all 2525b codes
+  // are used in CoT).
+  QString remainingChars = cotType.mid(6, cotType.length() - 6);
+  for (int i=0; i<remainingChars.length(); i=i+2)
+  {
+    retVal += remainingChars[i];
+  }
+
+  while (retVal.length() < 15)
+  {
+    retVal += "-";
+  }
+
+  return retVal;
+}
+
+// returns the SIDC for the CoT type, which may be raw data, from a thread-safe cache
+QString cachedCoTTypeToSidc(const QByteArray& cotType)
+{
+  static QReadWriteLock cacheLock;
+  static QHash<QByteArray, QString> cache;
+
+  {
+    QReadLocker locker(&cacheLock);
+    const auto it = cache.constFind(cotType);
+    if (it != cache.constEnd())
+      return it.value();
+  }
+
+  const QString sidc = convertCoTTypeToSidc(QString::fromLatin1(cotType));
+
+  QWriteLocker locker(&cacheLock);
+  if (cache.size() < s_maxCachedCoTTypes)
+  {
+    // deep copy the key as it may reference the raw message bytes
+    cache.insert(QByteArray(cotType.constData(), cotType.size()), sidc);
+  }
+
+  return sidc;
+}
+
+// Parses the GeoMessage control points "x,y[,z];x,y[,z];..." into triples of coordinates,
+// with a NaN z for 2D points, without splitting the text into temporary strings.
+void parseControlPoints(const QString& text, QVector<double>& coordinates)
+{
+  const int length = text.length();
+  int pointStart = 0;
+  while (pointStart < length)
+  {
+    int pointEnd = text.indexOf(QLatin1Char(';'), pointStart);
+    if (pointEnd == -1)
+      pointEnd = length;
+
+    double values[3] = {0.0, 0.0, 0.0};
+    int valueCount = 0;
+    int valueStart = pointStart;
+    while (valueStart <= pointEnd)
+    {
+      int valueEnd = text.indexOf(QLatin1Char(','), valueStart);
+      if (valueEnd == -1 || valueEnd > pointEnd)
+        valueEnd = pointEnd;
+
+      if (valueCount < 3)
+        values[valueCount] = text.midRef(valueStart, valueEnd - valueStart).toDouble();
+
+      ++valueCount;
+      valueStart = valueEnd + 1;
+    }
+
+    if (pointEnd > pointStart)
+    {
+      coordinates.append(values[0]);
+      coordinates.append(values[1]);
+      coordinates.append(valueCount == 2 ? qQNaN() : values[2]);
+    }
+
+    pointStart = pointEnd + 1;
+  }
+}
+
+// Decodes the common CoT shape of a single <event uid type> with a single <point lat lon hae/>
+// straight from the bytes. The elements are checked to be properly nested and closed up to the
+// end of the event, but the document is not otherwise validated, for example the text between
+// the elements is not checked. Returns false if the document is not of that shape, in which case
+// the general XML parser must be used instead.
+bool decodeCoTFastPath(const QByteArray& message, Message& cotMessage)
+{
+  const int eventPos = skipProlog(message);
+  if (!isStartTag(message, eventPos, "<event"))
+    return false;
+
+  const char* uid = nullptr;
+  int uidLength = 0;
+  const char* type = nullptr;
+  int typeLength = 0;
+  qint64 eventTime = 0;
+  qint64 staleTime = 0;
+  bool selfClosing = false;
+  const int eventEnd = scanAttributes(message, eventPos + 6, selfClosing,
+                                      [&](const char* name, int nameLength, const char* value, int valueLength)
+  {
+    if (nameEquals(name, nameLength, "uid"))
+    {
+      uid = value;
+      uidLength = valueLength;
+      return !hasEntity(value, valueLength);
+    }
+
+    if (nameEquals(name, nameLength, "type"))
+    {
+      type = value;
+      typeLength = valueLength;
+      return !hasEntity(value, valueLength);
+    }
+
+    if (nameEquals(name, nameLength, "time"))
+      eventTime = parseCoTTime(value, valueLength);
+    else if (nameEquals(name, nameLength, "stale"))
+      staleTime = parseCoTTime(value, valueLength);
+
+    return true;
+  });
+
+  if (eventEnd == -1 || selfClosing || !type)
+    return false;
+
+  // a single event containing a single point is expected
+  int pointPos = -1;
+  const int documentEnd = scanElementContent(message, eventEnd, "event",
+                                             [&](const char* name, int nameLength, int depth, int tagPos)
+  {
+    if (nameEquals(name, nameLength, "event"))
+      return false;
+
+    if (!nameEquals(name, nameLength, "point"))
+      return true;
+
+    if (depth != 1 || pointPos != -1)
+      return false;
+
+    pointPos = tagPos;
+    return true;
+  });
+
+  if (documentEnd == -1 || pointPos == -1 || !isDocumentEnd(message, documentEnd))
+    return false;
+
+  const char* lat = nullptr;
+  int latLength = 0;
+  const char* lon = nullptr;
+  int lonLength = 0;
+  const char* hae = nullptr;
+  int haeLength = 0;
+  const int pointEnd = scanAttributes(message, pointPos + 6, selfClosing,
+                                      [&](const char* name, int nameLength, const char* value, int valueLength)
+  {
+    if (nameEquals(name, nameLength, "lat"))
+    {
+      lat = value;
+      latLength = valueLength;
+    }
+    else if (nameEquals(name, nameLength, "lon"))
+    {
+      lon = value;
+      lonLength = valueLength;
+    }
+    else if (nameEquals(name, nameLength, "hae"))
+    {
+      hae = value;
+      haeLength = valueLength;
+    }
+
+    return true;
+  });
+
+  if (pointEnd == -1 || !lat || !lon)
+    return false;
+
+  double latValue = 0.0;
+  double lonValue = 0.0;
+  if (!toDouble(lat, latLength, latValue) || !toDouble(lon, lonLength, lonValue))
+    return false;
+
+  double haeValue = 0.0;
+  if (hae)
+    toDouble(hae, haeLength, haeValue);
+
+  // convert the CoT type to a sidc symbol code
+  const auto sidc = cachedCoTTypeToSidc(QByteArray::fromRawData(type, typeLength));
+  if (sidc.isEmpty())
+  {
+    cotMessage = Message();
+    return true;
+  }
+
+  MessageAttributes attributes;
+  attributes.insert(Message::SIDC_NAME, sidc);
+
+  // CoT is always an update action
+  cotMessage = Message(Message::MessageAction::Update, Point(lonValue, latValue, haeValue, SpatialReference::wgs84()));
+  cotMessage.setMessageType(QStringLiteral("cot"));
+  cotMessage.setSymbolId(sidc);
+  cotMessage.setMessageId(uid ? QString::fromUtf8(uid, uidLength) : QString());
+  cotMessage.setMessageAttributes(attributes);
+  cotMessage.setEventTime(eventTime);
+  cotMessage.setStaleTime(staleTime);
+
+  return true;
+}
+
+}
+
 /*!
   \class Dsa::Message
   \inmodule Dsa
@@ -133,7 +748,7 @@ Message& Message::operator=(Message&& other)
 bool Message::operator==(const Message& other) const
 {
   return messageAction() == other.messageAction() &&
-      attributes() == other.attributes() &&
+      d->attributes == other.d->attributes &&
       geometry() == other.geometry() &&
       messageId() == other.messageId() &&
       messageName() == other.messageName() &&
@@ -144,57 +759,69 @@ bool Message::operator==(const Message& other) const
 /*!
   \brief Static method to create a message from a QByteArray \a message.
 
-  Demetermines if the provided bytes contain a CoT event
-  or a GeoMessage and then forwards to the appropriate factory
+  Demetermines if the provided bytes contain a CoT event, a GeoMessage,
+  a TAK protocol message or a compact binary message and then forwards to
+  the appropriate factory
  */
 Message Message::create(const QByteArray& message)
 {
-  QDomDocument doc;
-  if (!doc.setContent(message))
-    return Message();
+  // the binary formats are identified by their leading magic bytes
+  if (CompactMessageCodec::isCompactMessage(message))
+    return createFromCompactMessage(message);
 
-  // check root element name
-  QDomElement parentElement = doc.firstChildElement(COT_ROOT_ELEMENT_NAME);
-  if (!parentElement.isNull())
-  {
-    return createFromCoTMessage(message);
-  }
+  if (TakProtocolCodec::isTakMessage(message))
+    return createFromTakMessage(message);
 
-  parentElement = doc.firstChildElement(GEOMESSAGE_ROOT_ELEMENT_NAME);
-  if (!parentElement.isNull())
-  {
-    return createFromGeoMessage(message);
-  }
+  // most traffic is simple CoT which can be decoded without a full XML parse
+  Message cotMessage;
+  if (decodeCoTFastPath(message, cotMessage))
+    return cotMessage;
 
-  // fall back to individual element name
-  parentElement = doc.firstChildElement(COT_ELEMENT_NAME);
-  if (!parentElement.isNull())
-  {
-    return createFromCoTMessage(message);
-  }
+  // check the root element name, either a collection or an individual element,
+  // without building a document; the parsers reject any malformed XML
+  const int rootPos = skipProlog(message);
+  if (isStartTag(message, rootPos, "<events") || isStartTag(message, rootPos, "<event"))
+    return parseCoTMessage(message);
 
-  parentElement = doc.firstChildElement(GEOMESSAGE_ELEMENT_NAME);
-  if (!parentElement.isNull())
-  {
+  if (isStartTag(message, rootPos, "<geomessages") || isStartTag(message, rootPos, "<geomessage"))
     return createFromGeoMessage(message);
-  }
 
   return Message();
 }
 
 /*!
   \brief Static method to create from a Cot (Cursor on Target) QByteArray \a message.
+
+  Messages consisting of a single \c event element with a single \c point element
+  are decoded directly from the bytes. Any other document is parsed with a
+  general XML parser.
  */
 Message Message::createFromCoTMessage(const QByteArray& message)
+{
+  // decode the common event shape directly from the bytes where possible
+  Message cotMessage;
+  if (decodeCoTFastPath(message, cotMessage))
+    return cotMessage;
+
+  return parseCoTMessage(message);
+}
+
+/*!
+  \internal
+  \brief Creates a message from the CoT \a message with the general XML parser,
+  without trying the fast path first.
+ */
+Message Message::parseCoTMessage(const QByteArray& message)
 {
   // parse CoT XML bytes and build up a Message object from the
   // supplied information
   Message cotMessage;
-  QVariantMap attributes;
+  MessageAttributes attributes;
 
   bool inCoTMessageElement = false;
 
-  QXmlStreamReader reader(message);
+  // the reader of the decoding thread is reused between messages
+  QXmlStreamReader& reader = DecodeScratch::local()->xmlReader(message);
 
   while (!reader.atEnd() && !reader.hasError())
   {
@@ -224,7 +851,19 @@ Message Message::createFromCoTMessage(const QByteArray& message)
         cotMessage.d->symbolId = sidc;
 
         // assign the unique message id
-        cotMessage.d->messageId = attrs.value(COT_UID_NAME).toString();
+        cotMessage.setMessageId(attrs.value(COT_UID_NAME).toString());
+
+        // keep the time the event was generated, e.g. for filtering stale events
+        const auto time = attrs.value(COT_TIME_NAME);
+        if (!time.isEmpty())
+        {
+          attributes.insert(COT_TIME_NAME, time.toString());
+          cotMessage.d->eventTime = parseCoTTime(time);
+        }
+
+        const auto stale = attrs.value(COT_STALE_NAME);
+        if (!stale.isEmpty())
+          cotMessage.d->staleTime = parseCoTTime(stale);
       }
 
       // before reading other element tags, make sure we are parsing a CoT element
@@ -261,6 +900,9 @@ Message Message::createFromCoTMessage(const QByteArray& message)
     reader.readNext();
   }
 
+  if (reader.hasError())
+    return Message();
+
   // assign the Message attributes
   cotMessage.d->attributes = attributes;
 
@@ -275,14 +917,15 @@ Message Message::createFromGeoMessage(const QByteArray& message)
   // parse GeoMessage XML bytes and build up a Message object from the
   // supplied information
   Message geoMessage;
-  QVariantMap attributes;
+  MessageAttributes attributes;
   QString wkidText;
   QString controlPointsText;
   QString environmentText;
 
   bool inGeoMessageElement = false;
 
-  QXmlStreamReader reader(message);
+  // the reader of the decoding thread is reused between messages
+  QXmlStreamReader& reader = DecodeScratch::local()->xmlReader(message);
 
   while (!reader.atEnd() && !reader.hasError())
   {
@@ -314,7 +957,7 @@ Message Message::createFromGeoMessage(const QByteArray& message)
       }
       else if (QStringRef::compare(reader.name(), GEOMESSAGE_ID_NAME, Qt::CaseInsensitive) == 0)
       {
-        geoMessage.d->messageId = reader.readElementText();
+        geoMessage.setMessageId(reader.readElementText());
       }
       else if (QStringRef::compare(reader.name(), GEOMESSAGE_WKID_NAME, Qt::CaseInsensitive) == 0)
       {
@@ -337,7 +980,9 @@ Message Message::createFromGeoMessage(const QByteArray& message)
       }
       else
       {
-        attributes.insert(reader.name().toString(), reader.readElementText());
+        // intern the name before reading the text invalidates it
+        const int keyIndex = MessageAttributeSchema::instance()->intern(reader.name());
+        attributes.insert(keyIndex, reader.readElementText());
       }
     }
     else if (reader.isEndElement())
@@ -351,6 +996,9 @@ Message Message::createFromGeoMessage(const QByteArray& message)
     reader.readNext();
   }
 
+  if (reader.hasError())
+    return Message();
+
   if (!environmentText.isEmpty())
   {
     geoMessage.d->messageType += QString("_%1").arg(environmentText);
@@ -360,13 +1008,18 @@ Message Message::createFromGeoMessage(const QByteArray& message)
   {
     const SpatialReference sr = wkidText.isEmpty() ? SpatialReference::wgs84() : SpatialReference(wkidText.toInt());
 
-    const QStringList controlPoints = controlPointsText.split(";");
-    bool isMultipart = controlPoints.size() > 1;
+    // the coordinates are parsed into the thread's scratch buffer, three per point
+    QVector<double>& coordinates = DecodeScratch::local()->coordinates();
+    parseControlPoints(controlPointsText, coordinates);
+    const int pointCount = coordinates.size() / 3;
+    bool isMultipart = pointCount > 1;
 
     if (isMultipart)
     {
       // if first and last points are equal, then this is a closed polygon geometry
-      bool isPolygon = controlPoints.first() == controlPoints.last();
+      const int last = (pointCount - 1) * 3;
+      bool isPolygon = coordinates[0] == coordinates[last] && coordinates[1] == coordinates[last + 1] &&
+          (coordinates[2] == coordinates[last + 2] || (qIsNaN(coordinates[2]) && qIsNaN(coordinates[last + 2])));
       QObject localParent;
       MultipartBuilder* multiPartBuilder = nullptr;
       if (isPolygon)
@@ -375,36 +1028,34 @@ Message Message::createFromGeoMessage(const QByteArray& message)
         multiPartBuilder = new PolylineBuilder(sr, &localParent);
 
       // multipart geometry
-      for (const QString& controlPoint : controlPoints)
+      for (int i = 0; i < coordinates.size(); i += 3)
       {
-        const auto controlPointValues = controlPoint.split(",");
-        if (controlPointValues.size() == 2)
+        if (qIsNaN(coordinates[i + 2]))
         {
           // 2D point
-          multiPartBuilder->addPoint(controlPointValues[0].toDouble(), controlPointValues[1].toDouble());
+          multiPartBuilder->addPoint(coordinates[i], coordinates[i + 1]);
         }
         else
         {
           // 3D point
-          multiPartBuilder->addPoint(controlPointValues[0].toDouble(), controlPointValues[1].toDouble(), controlPointValues[2].toDouble());
+          multiPartBuilder->addPoint(coordinates[i], coordinates[i + 1], coordinates[i + 2]);
         }
       }
 
       geoMessage.d->geometry = multiPartBuilder->toGeometry();
     }
-    else if (controlPoints.size() == 1)
+    else if (pointCount == 1)
     {
       // single point geometry
-      const QStringList controlPointValues = controlPoints[0].split(",");
-      if (controlPointValues.size() == 2)
+      if (qIsNaN(coordinates[2]))
       {
         // 2D point
-        geoMessage.d->geometry = Point(controlPointValues[0].toDouble(), controlPointValues[1].toDouble(), sr);
+        geoMessage.d->geometry = Point(coordinates[0], coordinates[1], sr);
       }
       else
       {
         // 3D point
-        geoMessage.d->geometry = Point(controlPointValues[0].toDouble(), controlPointValues[1].toDouble(), controlPointValues[2].toDouble(), sr);
+        geoMessage.d->geometry = Point(coordinates[0], coordinates[1], coordinates[2], sr);
       }
     }
   }
@@ -416,59 +1067,94 @@ Message Message::createFromGeoMessage(const QByteArray& message)
 }
 
 /*!
-  \brief Static method to convert a CoT type string \a cotType to a SIDC string.
+  \brief Static method to create from a compact binary QByteArray \a message.
+
+  \sa CompactMessageCodec
  */
-QString Message::cotTypeToSidc(const QString& cotType)
+Message Message::createFromCompactMessage(const QByteArray& message)
 {
-  // converts a CoT type to a sidc symbol id code
-  // For example: CoT type: a-f-S-C-A to sidc: SFSPCA---------
-  QString retVal;
+  return CompactMessageCodec::decode(message);
+}
 
-  // recognized affiliation types for converted between CoT type
-  // and sidc symbols
-  const QString recognizedAffiliations(QStringLiteral("fhupansjku"));
+/*!
+  \brief Static method to create from a TAK protocol (protobuf CoT) QByteArray \a message.
 
-  // recognized battle space types for converting between CoT type
-  // and sidc symbols
-  const QString recognizedBattleSpaces(QStringLiteral("PAGSUF"));
+  \sa TakProtocolCodec
+ */
+Message Message::createFromTakMessage(const QByteArray& message)
+{
+  return TakProtocolCodec::decode(message);
+}
 
-  if (cotType.mid(0, 1) != "a")
-    return QString();
+/*!
+  \brief Static method to read the \a messageType and \a messageId of the XML \a message
+  without decoding it. Returns whether both were found.
 
-  // Must be of the atom type or it is not supported
-  retVal += "S";
+  Only documents holding a single CoT event or a single GeoMessage can be peeked;
+  for anything else, including the binary formats, \c false is returned and the
+  message must be decoded with \l create.
+ */
+bool Message::peekTypeAndId(const QByteArray& message, QString& messageType, QString& messageId)
+{
+  const int pos = skipProlog(message);
+  if (pos == -1)
+    return false;
 
-  // Convert affiliation
-  if (!recognizedAffiliations.contains(cotType.mid(2, 1)))
-    return QString();
+  if (isStartTag(message, pos, "<event"))
+  {
+    const char* uid = nullptr;
+    int uidLength = 0;
+    bool selfClosing = false;
+    const int eventEnd = scanAttributes(message, pos + 6, selfClosing,
+                                        [&uid, &uidLength](const char* name, int nameLength, const char* value, int valueLength)
+    {
+      if (nameEquals(name, nameLength, "uid"))
+      {
+        uid = value;
+        uidLength = valueLength;
+        return !hasEntity(value, valueLength);
+      }
 
-  retVal += cotType.mid(2, 1).toUpper();
+      return true;
+    });
 
-  // Convert battle space dimension
-  if (!recognizedBattleSpaces.contains(cotType.mid(4, 1)))
-    return QString();
+    if (eventEnd == -1 || !uid || message.indexOf("<event", eventEnd) != -1)
+      return false;
 
-  retVal += cotType.mid(4, 1);
+    messageType = QStringLiteral("cot");
+    messageId = QString::fromUtf8(uid, uidLength);
+    return !messageId.isEmpty();
+  }
 
-  // All CoT types assumed Present (as opposed to
-  // anticipated/planned)
-  retVal += "P";
+  if (!isStartTag(message, pos, "<geomessages") && !isStartTag(message, pos, "<geomessage"))
+    return false;
 
-  // All remaining capital letters in the string are 1:1
-  // equivalents of CoT codes (although not all 2525b codes
-  // are used in CoT).
-  QString remainingChars = cotType.mid(6, cotType.length() - 6);
-  for (int i=0; i<remainingChars.length(); i=i+2)
+  // only a document with a single geomessage holds a single ID
+  int geoMessageCount = 0;
+  for (int elementPos = message.indexOf("<geomessage", pos); elementPos != -1;
+       elementPos = message.indexOf("<geomessage", elementPos + 11))
   {
-    retVal += remainingChars[i];
+    if (isStartTag(message, elementPos, "<geomessage") && ++geoMessageCount > 1)
+      return false;
   }
 
-  while (retVal.length() < 15)
-  {
-    retVal += "-";
-  }
+  if (geoMessageCount != 1)
+    return false;
 
-  return retVal;
+  messageType = peekElementText(message, pos, "_type");
+  messageId = peekElementText(message, pos, "_id");
+  return !messageType.isEmpty() && !messageId.isEmpty();
+}
+
+/*!
+  \brief Static method to convert a CoT type string \a cotType to a SIDC string.
+
+  Conversions are cached, so repeated calls for the same CoT type return
+  a shared copy of the same string. This method is thread-safe.
+ */
+QString Message::cotTypeToSidc(const QString& cotType)
+{
+  return cachedCoTTypeToSidc(cotType.toLatin1());
 }
 
 /*!
@@ -542,17 +1228,46 @@ void Message::setMessageAction(MessageAction messageAction)
  */
 QVariantMap Message::attributes() const
 {
-  return d->attributes;
+  return d->attributes.toVariantMap();
 }
 
 /*!
   \brief Sets the current message attributes to \a attributes.
  */
 void Message::setAttributes(const QVariantMap& attributes)
+{
+  d->attributes = MessageAttributes::fromVariantMap(attributes);
+}
+
+/*!
+  \brief Returns the current message attributes in their compact form.
+
+  Prefer this to \l attributes where the attributes are only read, since it does
+  not build a map.
+ */
+MessageAttributes Message::messageAttributes() const
+{
+  return d->attributes;
+}
+
+/*!
+  \brief Sets the current message attributes to \a attributes.
+ */
+void Message::setMessageAttributes(const MessageAttributes& attributes)
 {
   d->attributes = attributes;
 }
 
+/*!
+  \brief Returns the value of the message attribute called \a key.
+
+  Returns an invalid \c QVariant if the message has no such attribute.
+ */
+QVariant Message::attributeValue(const QString& key) const
+{
+  return d->attributes.value(key);
+}
+
 /*!
   \brief Returns the current message geometry.
  */
@@ -579,10 +1294,29 @@ QString Message::messageId() const
 
 /*!
   \brief Sets the current message ID to \a messageId.
+
+  The ID is interned in the MessageIdTable, so that it can be looked up by \l messageKey.
  */
 void Message::setMessageId(const QString& messageId)
 {
+  MessageIdTable* idTable = MessageIdTable::instance();
+  const int previousKey = d->messageKey;
   d->messageId = messageId;
+  d->messageKey = idTable->intern(messageId);
+  idTable->release(previousKey);
+}
+
+/*!
+  \brief Returns the integer key of the message ID, or \c -1 if the ID is empty.
+
+  Messages with the same ID have the same key while any of them, or a graphic
+  showing them, is alive. The message holds a reference to its key.
+
+  \sa MessageIdTable
+ */
+int Message::messageKey() const
+{
+  return d->messageKey;
 }
 
 /*!
@@ -633,6 +1367,113 @@ void Message::setSymbolId(const QString& symbolId)
   d->symbolId = symbolId;
 }
 
+/*!
+  \brief Returns the time at which the data for this message was received.
+
+  The timestamp is obtained from \l MessageFeedStats::timestamp and is \c 0 if
+  the time is unknown. It is not part of the message content and is ignored
+  when comparing messages.
+ */
+qint64 Message::receivedTimestamp() const
+{
+  return d->receivedTimestamp;
+}
+
+/*!
+  \brief Sets the time at which the data for this message was received to \a receivedTimestamp.
+ */
+void Message::setReceivedTimestamp(qint64 receivedTimestamp)
+{
+  d->receivedTimestamp = receivedTimestamp;
+}
+
+/*!
+  \brief Returns the time at which the sender generated this message, in milliseconds
+  since the epoch, or \c 0 if the time is unknown.
+
+  For a CoT event this is the \c time attribute. It is used to drop updates which
+  arrive after a newer one for the same message ID, and is ignored when comparing
+  messages.
+ */
+qint64 Message::eventTime() const
+{
+  return d->eventTime;
+}
+
+/*!
+  \brief Sets the time at which the sender generated this message to \a eventTime,
+  in milliseconds since the epoch.
+ */
+void Message::setEventTime(qint64 eventTime)
+{
+  d->eventTime = eventTime;
+}
+
+/*!
+  \brief Returns the time after which this message is no longer valid, in milliseconds
+  since the epoch, or \c 0 if it does not go stale.
+
+  For a CoT event this is the \c stale attribute. It is ignored when comparing messages.
+ */
+qint64 Message::staleTime() const
+{
+  return d->staleTime;
+}
+
+/*!
+  \brief Sets the time after which this message is no longer valid to \a staleTime,
+  in milliseconds since the epoch.
+ */
+void Message::setStaleTime(qint64 staleTime)
+{
+  d->staleTime = staleTime;
+}
+
+/*!
+  \brief Returns the time at which this message finished decoding.
+
+  Like \l receivedTimestamp, the timestamp is obtained from \l MessageFeedStats::timestamp.
+  It is only kept for messages which carry a \l latencyProbe, and is \c 0 otherwise.
+ */
+qint64 Message::decodedTimestamp() const
+{
+  return d->decodedTimestamp;
+}
+
+/*!
+  \brief Sets the time at which this message finished decoding to \a decodedTimestamp.
+ */
+void Message::setDecodedTimestamp(qint64 decodedTimestamp)
+{
+  d->decodedTimestamp = decodedTimestamp;
+}
+
+/*!
+  \brief Returns whether the data for this message was stamped by a \l LatencyProbe.
+ */
+bool Message::hasLatencyProbe() const
+{
+  return d->latencyProbe.isValid();
+}
+
+/*!
+  \brief Returns the \l LatencyProbe stamp read from the data for this message.
+
+  The stamp is not part of the message content and is ignored when comparing messages.
+ */
+LatencyProbe::Stamp Message::latencyProbe() const
+{
+  return d->latencyProbe;
+}
+
+/*!
+  \brief Sets the \l LatencyProbe stamp read from the data for this message to \a latencyProbe.
+ */
+void Message::setLatencyProbe(const LatencyProbe::Stamp& latencyProbe)
+{
+  d->latencyProbe = latencyProbe;
+}
+
 /*!
   \brief Returns the current message as QByteArray in the GeoMessage format.
  */
@@ -662,6 +1503,8 @@ QByteArray Message::toGeoMessage() const
   {
     Point pt = geometry_cast<Point>(geometry());
     controlPoints = QString("%1,%2").arg(QString::number(pt.x(), 'g', 9), QString::number(pt.y(), 'g', 9));
+    if (pt.hasZ())
+      controlPoints += QString(",%1").arg(QString::number(pt.z(), 'g', 9));
   }
   default:
     break;
@@ -676,6 +1519,15 @@ QByteArray Message::toGeoMessage() const
   streamWriter.writeEndElement();
 
   const auto attribs = attributes();
+
+  // messages decoded from other formats, e.g. CoT, keep their symbol ID in another attribute
+  if (!symbolId().isEmpty() && !attribs.contains(GEOMESSAGE_SIC_NAME))
+  {
+    streamWriter.writeStartElement(GEOMESSAGE_SIC_NAME);
+    streamWriter.writeCharacters(symbolId());
+    streamWriter.writeEndElement();
+  }
+
   for (QVariantMap::const_iterator iter = attribs.constBegin(); iter != attribs.constEnd(); ++iter)
   {
     const auto key = iter.key();
@@ -717,10 +1569,17 @@ MessageData::MessageData(const MessageData& other) :
   attributes(other.attributes),
   geometry(other.geometry),
   messageId(other.messageId),
+  messageKey(other.messageKey),
   messageName(other.messageName),
   messageType(other.messageType),
-  symbolId(other.symbolId)
+  symbolId(other.symbolId),
+  receivedTimestamp(other.receivedTimestamp),
+  eventTime(other.eventTime),
+  staleTime(other.staleTime),
+  decodedTimestamp(other.decodedTimestamp),
+  latencyProbe(other.latencyProbe)
 {
+  MessageIdTable::instance()->retain(messageKey);
 }
 
 /*!
@@ -728,6 +1587,7 @@ MessageData::MessageData(const MessageData& other) :
  */
 MessageData::~MessageData()
 {
+  MessageIdTable::instance()->release(messageKey);
 }
 
 } // Dsa
@@ -17,6 +17,10 @@
 #ifndef MESSAGE_H
 #define MESSAGE_H
 
+// dsa app headers
+#include "LatencyProbe.h"
+#include "MessageAttributes.h"
+
 // C++ API headers
 #include "Geometry.h"
 
@@ -35,6 +39,8 @@ public:
   static const QString COT_ELEMENT_NAME;
   static const QString COT_TYPE_NAME;
   static const QString COT_UID_NAME;
+  static const QString COT_TIME_NAME;
+  static const QString COT_STALE_NAME;
   static const QString COT_POINT_NAME;
   static const QString COT_POINT_LAT_NAME;
   static const QString COT_POINT_LON_NAME;
@@ -77,6 +83,9 @@ public:
   static Message create(const QByteArray& message);
   static Message createFromCoTMessage(const QByteArray& message);
   static Message createFromGeoMessage(const QByteArray& message);
+  static Message createFromCompactMessage(const QByteArray& message);
+  static Message createFromTakMessage(const QByteArray& message);
+  static bool peekTypeAndId(const QByteArray& message, QString& messageType, QString& messageId);
 
   static QString cotTypeToSidc(const QString& cotType);
   static MessageAction toMessageAction(const QString& action);
@@ -90,11 +99,16 @@ public:
   QVariantMap attributes() const;
   void setAttributes(const QVariantMap& attributes);
 
+  MessageAttributes messageAttributes() const;
+  void setMessageAttributes(const MessageAttributes& attributes);
+  QVariant attributeValue(const QString& key) const;
+
   Esri::ArcGISRuntime::Geometry geometry() const;
   void setGeometry(const Esri::ArcGISRuntime::Geometry& geometry);
 
   QString messageId() const;
   void setMessageId(const QString& messageId);
+  int messageKey() const;
 
   QString messageName() const;
   void setMessageName(const QString& messageName);
@@ -105,9 +119,27 @@ public:
   QString symbolId() const;
   void setSymbolId(const QString& symbolId);
 
+  qint64 receivedTimestamp() const;
+  void setReceivedTimestamp(qint64 receivedTimestamp);
+
+  qint64 eventTime() const;
+  void setEventTime(qint64 eventTime);
+
+  qint64 staleTime() const;
+  void setStaleTime(qint64 staleTime);
+
+  qint64 decodedTimestamp() const;
+  void setDecodedTimestamp(qint64 decodedTimestamp);
+
+  bool hasLatencyProbe() const;
+  LatencyProbe::Stamp latencyProbe() const;
+  void setLatencyProbe(const LatencyProbe::Stamp& latencyProbe);
+
   QByteArray toGeoMessage() const;
 
 private:
+  static Message parseCoTMessage(const QByteArray& message);
+
   QSharedDataPointer<MessageData> d;
 };
 
@@ -120,12 +152,18 @@ public:
   ~MessageData();
 
   Message::MessageAction messageAction = Message::MessageAction::Unknown;
-  QVariantMap attributes;
+  MessageAttributes attributes;
   Esri::ArcGISRuntime::Geometry geometry;
   QString messageId;
+  int messageKey = -1;
   QString messageName;
   QString messageType;
   QString symbolId;
+  qint64 receivedTimestamp = 0;
+  qint64 eventTime = 0;
+  qint64 staleTime = 0;
+  qint64 decodedTimestamp = 0;
+  LatencyProbe::Stamp latencyProbe;
 };
 
 } // Dsa
@@ -0,0 +1,151 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "MessageAttributeSchema.h"
+
+namespace Dsa {
+
+/*!
+  \class Dsa::MessageAttributeSchema
+  \inmodule Dsa
+  \brief Interns the attribute names of decoded messages.
+
+  Messages from a feed carry the same small set of attribute names over and over.
+  Each name is stored once by the schema and given a stable index, which is what
+  \l MessageAttributes stores for every value. Names can be looked up directly from
+  the \c QStringRef returned by an XML reader, so a known name costs a hash and a
+  comparison rather than a new string.
+
+  Messages are decoded before the feed they belong to is known, so one schema is
+  shared by all feeds. Indexes are never removed or reused.
+
+  This class is thread-safe.
+ */
+
+/*!
+  \brief Returns the schema shared by all message feeds.
+ */
+MessageAttributeSchema* MessageAttributeSchema::instance()
+{
+  static MessageAttributeSchema s_instance;
+  return &s_instance;
+}
+
+/*!
+  \internal
+ */
+MessageAttributeSchema::MessageAttributeSchema()
+{
+}
+
+/*!
+  \internal
+ */
+MessageAttributeSchema::~MessageAttributeSchema()
+{
+}
+
+/*!
+  \brief Returns the index of \a key, adding it to the schema if needed.
+ */
+int MessageAttributeSchema::intern(const QString& key)
+{
+  return intern(QStringRef(&key));
+}
+
+/*!
+  \overload
+
+  The name is only copied if it is not already in the schema.
+ */
+int MessageAttributeSchema::intern(const QStringRef& key)
+{
+  const uint hash = qHash(key);
+  {
+    QReadLocker locker(&m_lock);
+    const int index = find(key, hash);
+    if (index != -1)
+      return index;
+  }
+
+  QWriteLocker locker(&m_lock);
+
+  // another thread may have added the name while the lock was released
+  const int index = find(key, hash);
+  if (index != -1)
+    return index;
+
+  m_keys.append(key.toString());
+  m_indexes.insert(hash, m_keys.size() - 1);
+  return m_keys.size() - 1;
+}
+
+/*!
+  \brief Returns the index of \a key, or \c -1 if it is not in the schema.
+ */
+int MessageAttributeSchema::indexOf(const QString& key) const
+{
+  return indexOf(QStringRef(&key));
+}
+
+/*!
+  \overload
+ */
+int MessageAttributeSchema::indexOf(const QStringRef& key) const
+{
+  const uint hash = qHash(key);
+  QReadLocker locker(&m_lock);
+  return find(key, hash);
+}
+
+/*!
+  \brief Returns the attribute name with the given \a index.
+ */
+QString MessageAttributeSchema::key(int index) const
+{
+  QReadLocker locker(&m_lock);
+  return m_keys.value(index);
+}
+
+/*!
+  \brief Returns the number of names in the schema.
+ */
+int MessageAttributeSchema::size() const
+{
+  QReadLocker locker(&m_lock);
+  return m_keys.size();
+}
+
+/*!
+  \internal
+
+  Returns the index of \a key with the given \a hash. The lock must be held.
+ */
+int MessageAttributeSchema::find(const QStringRef& key, uint hash) const
+{
+  for (auto it = m_indexes.constFind(hash); it != m_indexes.constEnd() && it.key() == hash; ++it)
+  {
+    if (m_keys.at(it.value()) == key)
+      return it.value();
+  }
+
+  return -1;
+}
+
+} // Dsa
@@ -0,0 +1,57 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef MESSAGEATTRIBUTESCHEMA_H
+#define MESSAGEATTRIBUTESCHEMA_H
+
+// Qt headers
+#include <QMultiHash>
+#include <QReadWriteLock>
+#include <QString>
+#include <QVector>
+
+namespace Dsa {
+
+class MessageAttributeSchema
+{
+public:
+  static MessageAttributeSchema* instance();
+
+  int intern(const QString& key);
+  int intern(const QStringRef& key);
+
+  int indexOf(const QString& key) const;
+  int indexOf(const QStringRef& key) const;
+
+  QString key(int index) const;
+  int size() const;
+
+private:
+  MessageAttributeSchema();
+  ~MessageAttributeSchema();
+
+  Q_DISABLE_COPY(MessageAttributeSchema)
+
+  int find(const QStringRef& key, uint hash) const;
+
+  mutable QReadWriteLock m_lock;
+  QVector<QString> m_keys;
+  QMultiHash<uint, int> m_indexes;
+};
+
+} // Dsa
+
+#endif // MESSAGEATTRIBUTESCHEMA_H
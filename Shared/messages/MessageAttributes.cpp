@@ -0,0 +1,306 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "MessageAttributes.h"
+
+// dsa app headers
+#include "MessageAttributeSchema.h"
+
+// C++ API headers
+#include "AttributeListModel.h"
+
+// STL headers
+#include <algorithm>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+namespace
+{
+// hashes the common value types without converting them to strings
+uint valueHash(const QVariant& value, uint seed)
+{
+  switch (value.userType())
+  {
+  case QMetaType::QString:
+    return qHash(*static_cast<const QString*>(value.constData()), seed);
+  case QMetaType::Int:
+    return qHash(value.toInt(), seed);
+  case QMetaType::Double:
+    return qHash(value.toDouble(), seed);
+  case QMetaType::Bool:
+    return qHash(value.toBool(), seed);
+  default:
+    return qHash(value.toString(), seed);
+  }
+}
+}
+
+/*!
+  \class Dsa::MessageAttributes
+  \inmodule Dsa
+  \brief A compact set of \l Message attributes.
+
+  Attribute names are interned by \l MessageAttributeSchema, so each attribute is
+  stored as a name index and a value in a single flat vector, instead of as a node
+  of a map which owns its own copy of the name. The vector is kept sorted by name
+  index so that two sets of attributes can be compared entry by entry.
+
+  \l applyTo updates the attributes of a graphic in place, only touching the
+  attributes whose values have changed.
+ */
+
+/*!
+  \brief Constructs an empty set of attributes.
+ */
+MessageAttributes::MessageAttributes()
+{
+}
+
+/*!
+  \brief Returns a set of attributes with the contents of \a attributes.
+ */
+MessageAttributes MessageAttributes::fromVariantMap(const QVariantMap& attributes)
+{
+  MessageAttributes messageAttributes;
+  messageAttributes.m_entries.reserve(attributes.size());
+  for (auto it = attributes.constBegin(); it != attributes.constEnd(); ++it)
+    messageAttributes.insert(it.key(), it.value());
+
+  return messageAttributes;
+}
+
+/*!
+  \brief Returns the attributes as a \c QVariantMap.
+ */
+QVariantMap MessageAttributes::toVariantMap() const
+{
+  const MessageAttributeSchema* schema = MessageAttributeSchema::instance();
+
+  QVariantMap attributes;
+  for (const Entry& entry : m_entries)
+    attributes.insert(schema->key(entry.m_keyIndex), entry.m_value);
+
+  return attributes;
+}
+
+/*!
+  \brief Returns whether there are no attributes.
+ */
+bool MessageAttributes::isEmpty() const
+{
+  return m_entries.isEmpty();
+}
+
+/*!
+  \brief Returns the number of attributes.
+ */
+int MessageAttributes::size() const
+{
+  return m_entries.size();
+}
+
+/*!
+  \brief Returns the schema index of the name of the attribute at position \a i.
+ */
+int MessageAttributes::keyIndexAt(int i) const
+{
+  return m_entries.at(i).m_keyIndex;
+}
+
+/*!
+  \brief Returns the name of the attribute at position \a i.
+ */
+QString MessageAttributes::keyAt(int i) const
+{
+  return MessageAttributeSchema::instance()->key(m_entries.at(i).m_keyIndex);
+}
+
+/*!
+  \brief Returns the value of the attribute at position \a i.
+ */
+const QVariant& MessageAttributes::valueAt(int i) const
+{
+  return m_entries.at(i).m_value;
+}
+
+/*!
+  \brief Returns whether there is an attribute called \a key.
+ */
+bool MessageAttributes::contains(const QString& key) const
+{
+  return find(key) != -1;
+}
+
+/*!
+  \brief Returns the value of the attribute called \a key, or \a defaultValue if
+  there is no such attribute.
+ */
+QVariant MessageAttributes::value(const QString& key, const QVariant& defaultValue) const
+{
+  const int i = find(key);
+  return i == -1 ? defaultValue : m_entries.at(i).m_value;
+}
+
+/*!
+  \brief Sets the attribute called \a key to \a value.
+ */
+void MessageAttributes::insert(const QString& key, const QVariant& value)
+{
+  insert(MessageAttributeSchema::instance()->intern(key), value);
+}
+
+/*!
+  \overload
+
+  Sets the attribute with the schema index \a keyIndex to \a value.
+ */
+void MessageAttributes::insert(int keyIndex, const QVariant& value)
+{
+  const int i = lowerBound(keyIndex);
+  if (i < m_entries.size() && m_entries.at(i).m_keyIndex == keyIndex)
+  {
+    m_entries[i].m_value = value;
+    return;
+  }
+
+  Entry entry;
+  entry.m_keyIndex = keyIndex;
+  entry.m_value = value;
+  m_entries.insert(i, entry);
+}
+
+/*!
+  \brief Removes the attribute called \a key.
+ */
+void MessageAttributes::remove(const QString& key)
+{
+  const int i = find(key);
+  if (i != -1)
+    m_entries.remove(i);
+}
+
+/*!
+  \brief Updates \a attributes to match these attributes and returns the number of
+  attributes which were changed.
+
+  Attributes which already have the same value are left alone, so a graphic which
+  is updated with mostly unchanged attributes does not have its whole attribute
+  model reset as it would by \c AttributeListModel::setAttributesMap. Attributes
+  which are not in this set are removed.
+ */
+int MessageAttributes::applyTo(AttributeListModel* attributes) const
+{
+  if (!attributes)
+    return 0;
+
+  const MessageAttributeSchema* schema = MessageAttributeSchema::instance();
+
+  int changedCount = 0;
+  for (const Entry& entry : m_entries)
+  {
+    const QString key = schema->key(entry.m_keyIndex);
+    if (!attributes->containsAttribute(key))
+    {
+      attributes->insertAttribute(key, entry.m_value);
+      ++changedCount;
+    }
+    else if (attributes->attributeValue(key) != entry.m_value)
+    {
+      attributes->replaceAttribute(key, entry.m_value);
+      ++changedCount;
+    }
+  }
+
+  // every attribute in this set is now in the model, so any extra ones are stale
+  if (attributes->size() > m_entries.size())
+  {
+    const QStringList names = attributes->attributeNames();
+    for (const QString& name : names)
+    {
+      if (find(name) != -1)
+        continue;
+
+      attributes->removeAttribute(name);
+      ++changedCount;
+    }
+  }
+
+  return changedCount;
+}
+
+/*!
+  \brief Returns a hash of the names and values of the attributes, starting from \a seed.
+
+  Equal sets of attributes always have the same fingerprint.
+ */
+uint MessageAttributes::fingerprint(uint seed) const
+{
+  uint hash = seed;
+  for (const Entry& entry : m_entries)
+    hash = valueHash(entry.m_value, qHash(entry.m_keyIndex, hash));
+
+  return hash;
+}
+
+/*!
+  \brief Returns whether these attributes are equal to \a other.
+ */
+bool MessageAttributes::operator==(const MessageAttributes& other) const
+{
+  return m_entries == other.m_entries;
+}
+
+/*!
+  \brief Returns whether these attributes are not equal to \a other.
+ */
+bool MessageAttributes::operator!=(const MessageAttributes& other) const
+{
+  return !(*this == other);
+}
+
+/*!
+  \internal
+
+  Returns the position of the first entry whose key index is not less than \a keyIndex.
+ */
+int MessageAttributes::lowerBound(int keyIndex) const
+{
+  const auto it = std::lower_bound(m_entries.constBegin(), m_entries.constEnd(), keyIndex,
+                                   [](const Entry& entry, int index) { return entry.m_keyIndex < index; });
+  return static_cast<int>(it - m_entries.constBegin());
+}
+
+/*!
+  \internal
+
+  Returns the position of the attribute called \a key, or \c -1.
+ */
+int MessageAttributes::find(const QString& key) const
+{
+  const int keyIndex = MessageAttributeSchema::instance()->indexOf(key);
+  if (keyIndex == -1)
+    return -1;
+
+  const int i = lowerBound(keyIndex);
+  return i < m_entries.size() && m_entries.at(i).m_keyIndex == keyIndex ? i : -1;
+}
+
+} // Dsa
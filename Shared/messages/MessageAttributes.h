@@ -0,0 +1,85 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef MESSAGEATTRIBUTES_H
+#define MESSAGEATTRIBUTES_H
+
+// Qt headers
+#include <QString>
+#include <QVariant>
+#include <QVariantMap>
+#include <QVector>
+
+namespace Esri
+{
+  namespace ArcGISRuntime
+  {
+    class AttributeListModel;
+  }
+}
+
+namespace Dsa {
+
+class MessageAttributes
+{
+public:
+  MessageAttributes();
+
+  static MessageAttributes fromVariantMap(const QVariantMap& attributes);
+  QVariantMap toVariantMap() const;
+
+  bool isEmpty() const;
+  int size() const;
+
+  int keyIndexAt(int i) const;
+  QString keyAt(int i) const;
+  const QVariant& valueAt(int i) const;
+
+  bool contains(const QString& key) const;
+  QVariant value(const QString& key, const QVariant& defaultValue = QVariant()) const;
+
+  void insert(const QString& key, const QVariant& value);
+  void insert(int keyIndex, const QVariant& value);
+  void remove(const QString& key);
+
+  int applyTo(Esri::ArcGISRuntime::AttributeListModel* attributes) const;
+  uint fingerprint(uint seed = 0) const;
+
+  bool operator==(const MessageAttributes& other) const;
+  bool operator!=(const MessageAttributes& other) const;
+
+private:
+  struct Entry
+  {
+    int m_keyIndex = -1;
+    QVariant m_value;
+
+    bool operator==(const Entry& other) const
+    {
+      return m_keyIndex == other.m_keyIndex && m_value == other.m_value;
+    }
+  };
+
+  int lowerBound(int keyIndex) const;
+  int find(const QString& key) const;
+
+  // sorted by key index
+  QVector<Entry> m_entries;
+};
+
+} // Dsa
+
+#endif // MESSAGEATTRIBUTES_H
@@ -0,0 +1,501 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "MessageClusterOverlay.h"
+
+// dsa app headers
+#include "MessagesOverlay.h"
+#include "WebMercator.h"
+
+// C++ API headers
+#include "AttributeListModel.h"
+#include "GeometryEngine.h"
+#include "GraphicListModel.h"
+#include "GraphicsOverlay.h"
+#include "GraphicsOverlayListModel.h"
+#include "LabelDefinition.h"
+#include "LabelDefinitionListModel.h"
+#include "MapQuickView.h"
+#include "Renderer.h"
+#include "SceneQuickView.h"
+
+// Qt headers
+#include <QTimer>
+
+// STL headers
+#include <cmath>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+namespace {
+
+// cluster symbols are refreshed at most this often, in ms
+constexpr int s_clusterRefreshInterval = 250;
+
+const QString s_countAttributeName = QStringLiteral("count");
+
+// a circle sized by the number of tracks in the cluster
+const QString s_clusterRendererJson = QStringLiteral(
+  "{\"type\":\"simple\","
+  "\"symbol\":{\"type\":\"esriSMS\",\"style\":\"esriSMSCircle\",\"color\":[0,92,230,200],\"size\":18,"
+  "\"outline\":{\"type\":\"esriSLS\",\"style\":\"esriSLSSolid\",\"color\":[255,255,255,255],\"width\":1.5}},"
+  "\"visualVariables\":[{\"type\":\"sizeInfo\",\"field\":\"count\","
+  "\"minDataValue\":1,\"maxDataValue\":1000,\"minSize\":18,\"maxSize\":48}]}");
+
+const QString s_clusterLabelJson = QStringLiteral(
+  "{\"labelExpressionInfo\":{\"expression\":\"$feature.count\"},"
+  "\"labelPlacement\":\"esriServerPointLabelPlacementCenterCenter\","
+  "\"symbol\":{\"type\":\"esriTS\",\"color\":[255,255,255,255],"
+  "\"font\":{\"size\":10,\"weight\":\"bold\"}},"
+  "\"useCodedValues\":false}");
+
+bool geometryToWebMercator(const Geometry& geometry, double& x, double& y)
+{
+  if (geometry.isEmpty() || geometry.geometryType() != GeometryType::Point)
+    return false;
+
+  Point point(geometry);
+  if (point.spatialReference() != SpatialReference::wgs84())
+    point = Point(GeometryEngine::project(point, SpatialReference::wgs84()));
+
+  WebMercator::toWebMercator(point.x(), point.y(), x, y);
+  return true;
+}
+
+} // namespace
+
+/*!
+  \class Dsa::MessageClusterOverlay
+  \inmodule Dsa
+  \inherits QObject
+  \brief Aggregates the tracks of a \l MessagesOverlay into clusters drawn
+  as count symbols when zoomed out.
+
+  Thousands of dictionary symbols swamp rendering at small scales, while
+  telling little apart. Beyond the \l minScale, the tracks are counted in a
+  square grid whose cells are roughly \l cellSize pixels wide, and each
+  occupied cell is drawn as a single circle labelled with its count at the
+  centroid of its tracks. The messages overlay itself is hidden meanwhile.
+
+  The grids form a hierarchy: each level halves the cell size of the one
+  above, so clusters merge predictably when zooming out. Only the level for
+  the current scale is held, and it is updated incrementally as graphics
+  are added, moved and removed; a different level is built from the cached
+  track positions.
+ */
+
+/*!
+  \brief Constructor taking the \a messagesOverlay whose graphics are
+  clustered, and an optional \a parent.
+ */
+MessageClusterOverlay::MessageClusterOverlay(MessagesOverlay* messagesOverlay, QObject* parent) :
+  QObject(parent),
+  m_messagesOverlay(messagesOverlay),
+  m_geoView(messagesOverlay->geoView()),
+  m_graphicsOverlay(new GraphicsOverlay(this)),
+  m_refreshTimer(new QTimer(this))
+{
+  m_refreshTimer->setSingleShot(true);
+  m_refreshTimer->setInterval(s_clusterRefreshInterval);
+  connect(m_refreshTimer, &QTimer::timeout, this, &MessageClusterOverlay::refresh);
+
+  m_graphicsOverlay->setOverlayId(messagesOverlay->messageType() + QStringLiteral("_clusters"));
+  m_graphicsOverlay->setRenderingMode(GraphicsRenderingMode::Dynamic);
+  m_graphicsOverlay->setSceneProperties(LayerSceneProperties(messagesOverlay->surfacePlacement()));
+  m_graphicsOverlay->setRenderer(Renderer::fromJson(s_clusterRendererJson, this));
+  m_graphicsOverlay->labelDefinitions()->append(LabelDefinition::fromJson(s_clusterLabelJson, this));
+  m_graphicsOverlay->setLabelsEnabled(true);
+  m_graphicsOverlay->setVisible(false);
+  m_geoView->graphicsOverlays()->append(m_graphicsOverlay);
+
+  connect(messagesOverlay, &MessagesOverlay::graphicsAdded, this, &MessageClusterOverlay::handleGraphicsAdded);
+  connect(messagesOverlay, &MessagesOverlay::graphicsUpdated, this, &MessageClusterOverlay::handleGraphicsUpdated);
+  connect(messagesOverlay, &MessagesOverlay::graphicsRemoved, this, &MessageClusterOverlay::handleGraphicsRemoved);
+
+  if (auto sceneView = dynamic_cast<SceneQuickView*>(m_geoView))
+    connect(sceneView, &SceneQuickView::viewpointChanged, this, &MessageClusterOverlay::handleViewpointChanged);
+  else if (auto mapView = dynamic_cast<MapQuickView*>(m_geoView))
+    connect(mapView, &MapQuickView::viewpointChanged, this, &MessageClusterOverlay::handleViewpointChanged);
+
+  // start from the tracks already in the overlay
+  handleGraphicsAdded(0, messagesOverlay->graphicsOverlay()->graphics()->rowCount());
+}
+
+/*!
+  \brief Destructor.
+ */
+MessageClusterOverlay::~MessageClusterOverlay()
+{
+  GraphicsOverlayListModel* graphicsOverlays = m_geoView->graphicsOverlays();
+  const int index = graphicsOverlays->indexOf(m_graphicsOverlay);
+  if (index != -1)
+    graphicsOverlays->removeAt(index);
+}
+
+/*!
+  \brief Returns the graphics overlay holding the cluster graphics.
+
+  Each cluster graphic has a \c count attribute.
+ */
+GraphicsOverlay* MessageClusterOverlay::graphicsOverlay() const
+{
+  return m_graphicsOverlay;
+}
+
+/*!
+  \brief Returns the map scale beyond which tracks are clustered.
+
+  The default is \c 0, which never clusters.
+ */
+double MessageClusterOverlay::minScale() const
+{
+  return m_minScale;
+}
+
+/*!
+  \brief Sets the map scale beyond which tracks are clustered to \a minScale.
+ */
+void MessageClusterOverlay::setMinScale(double minScale)
+{
+  m_minScale = qMax(0.0, minScale);
+  handleViewpointChanged();
+}
+
+/*!
+  \brief Returns the approximate width, in pixels, of a cluster cell.
+
+  The default is \c 64 pixels.
+ */
+int MessageClusterOverlay::cellSize() const
+{
+  return m_cellSize;
+}
+
+/*!
+  \brief Sets the approximate width of a cluster cell to \a cellSize pixels.
+ */
+void MessageClusterOverlay::setCellSize(int cellSize)
+{
+  if (cellSize <= 0 || m_cellSize == cellSize)
+    return;
+
+  m_cellSize = cellSize;
+  handleViewpointChanged();
+}
+
+/*!
+  \brief Returns whether the view is zoomed out far enough for tracks to be clustered.
+ */
+bool MessageClusterOverlay::isClustering() const
+{
+  return m_level >= 0;
+}
+
+/*!
+  \brief Returns the grid level in use, or \c -1 when not clustering.
+
+  Cells at level \c n are 1/2^n the width of the web mercator world.
+ */
+int MessageClusterOverlay::level() const
+{
+  return m_level;
+}
+
+/*!
+  \brief Returns the number of clusters at the current level.
+ */
+int MessageClusterOverlay::clusterCount() const
+{
+  return m_cells.size();
+}
+
+/*!
+  \brief Updates the cluster graphics for the cells whose tracks have changed.
+
+  This is called shortly after tracks change, so that a burst of messages
+  updates each cluster once.
+ */
+void MessageClusterOverlay::refresh()
+{
+  m_refreshTimer->stop();
+
+  if (m_dirtyCells.isEmpty())
+    return;
+
+  QList<Graphic*> newGraphics;
+  GraphicListModel* graphics = m_graphicsOverlay->graphics();
+
+  for (const quint64 key : qAsConst(m_dirtyCells))
+  {
+    auto cellIt = m_cells.find(key);
+    if (cellIt == m_cells.end())
+      continue;
+
+    Cell& cell = cellIt.value();
+    if (cell.m_count <= 0)
+    {
+      if (cell.m_graphic)
+      {
+        graphics->removeOne(cell.m_graphic);
+        delete cell.m_graphic;
+      }
+      m_cells.erase(cellIt);
+      continue;
+    }
+
+    const Point centroid(cell.m_sumX / cell.m_count, cell.m_sumY / cell.m_count, SpatialReference::webMercator());
+    if (cell.m_graphic)
+    {
+      cell.m_graphic->setGeometry(centroid);
+      cell.m_graphic->attributes()->replaceAttribute(s_countAttributeName, cell.m_count);
+    }
+    else
+    {
+      cell.m_graphic = new Graphic(centroid, QVariantMap{{s_countAttributeName, cell.m_count}}, this);
+      newGraphics.append(cell.m_graphic);
+    }
+  }
+
+  m_dirtyCells.clear();
+
+  if (!newGraphics.isEmpty())
+    graphics->append(newGraphics);
+}
+
+/*!
+  \internal
+ */
+void MessageClusterOverlay::handleGraphicsAdded(int index, int count)
+{
+  GraphicListModel* graphics = m_messagesOverlay->graphicsOverlay()->graphics();
+  for (int i = index; i < index + count; ++i)
+    updateTrack(graphics->at(i));
+
+  if (isClustering() && !m_refreshTimer->isActive())
+    m_refreshTimer->start();
+}
+
+/*!
+  \internal
+ */
+void MessageClusterOverlay::handleGraphicsUpdated(const QList<Graphic*>& graphics)
+{
+  for (Graphic* graphic : graphics)
+    updateTrack(graphic);
+
+  if (isClustering() && !m_refreshTimer->isActive())
+    m_refreshTimer->start();
+}
+
+/*!
+  \internal
+ */
+void MessageClusterOverlay::handleGraphicsRemoved(const QList<Graphic*>& graphics)
+{
+  for (Graphic* graphic : graphics)
+  {
+    auto trackIt = m_tracks.find(graphic);
+    if (trackIt == m_tracks.end())
+      continue;
+
+    if (isClustering())
+      removeFromCell(trackIt.value());
+
+    m_tracks.erase(trackIt);
+  }
+
+  if (isClustering() && !m_refreshTimer->isActive())
+    m_refreshTimer->start();
+}
+
+/*!
+  \internal
+  \brief Switches to the grid level for the current scale of the view.
+
+  The viewpoint changes every frame while navigating, but the clusters are
+  only rebuilt when the level changes.
+ */
+void MessageClusterOverlay::handleViewpointChanged()
+{
+  int level = -1;
+  if (m_minScale > 0.0)
+  {
+    const double scale = m_geoView->currentViewpoint(ViewpointType::CenterAndScale).targetScale();
+    if (scale >= m_minScale)
+      level = levelForScale(scale);
+  }
+
+  setLevel(level);
+}
+
+/*!
+  \internal
+  \brief Records the position of \a graphic, moving it between cells while clustering.
+ */
+void MessageClusterOverlay::updateTrack(Graphic* graphic)
+{
+  if (!graphic)
+    return;
+
+  TrackPosition position;
+  if (!geometryToWebMercator(graphic->geometry(), position.m_x, position.m_y))
+    return;
+
+  auto trackIt = m_tracks.find(graphic);
+  if (trackIt != m_tracks.end())
+  {
+    if (trackIt->m_x == position.m_x && trackIt->m_y == position.m_y)
+      return;
+
+    if (isClustering())
+      removeFromCell(trackIt.value());
+  }
+  else
+  {
+    trackIt = m_tracks.insert(graphic, position);
+  }
+
+  if (isClustering())
+    position.m_cellKey = cellKey(position.m_x, position.m_y);
+
+  trackIt.value() = position;
+
+  if (isClustering())
+    addToCell(position);
+}
+
+/*!
+  \internal
+ */
+void MessageClusterOverlay::addToCell(const TrackPosition& position)
+{
+  Cell& cell = m_cells[position.m_cellKey];
+  ++cell.m_count;
+  cell.m_sumX += position.m_x;
+  cell.m_sumY += position.m_y;
+  m_dirtyCells.insert(position.m_cellKey);
+}
+
+/*!
+  \internal
+ */
+void MessageClusterOverlay::removeFromCell(const TrackPosition& position)
+{
+  auto cellIt = m_cells.find(position.m_cellKey);
+  if (cellIt == m_cells.end())
+    return;
+
+  --cellIt->m_count;
+  cellIt->m_sumX -= position.m_x;
+  cellIt->m_sumY -= position.m_y;
+  m_dirtyCells.insert(position.m_cellKey);
+}
+
+/*!
+  \internal
+  \brief Switches to the grid \a level.
+ */
+void MessageClusterOverlay::setLevel(int level)
+{
+  if (m_level == level)
+    return;
+
+  const bool wasClustering = isClustering();
+
+  m_level = level;
+  m_cellMeters = m_level >= 0 ? WebMercator::s_worldWidth / static_cast<double>(1 << m_level) : 0.0;
+
+  rebuildCells();
+
+  if (wasClustering != isClustering())
+    emit clusteringChanged();
+}
+
+/*!
+  \internal
+  \brief Counts every track into the cells of the current level.
+ */
+void MessageClusterOverlay::rebuildCells()
+{
+  clearClusterGraphics();
+
+  if (!isClustering())
+    return;
+
+  for (auto it = m_tracks.begin(); it != m_tracks.end(); ++it)
+  {
+    it->m_cellKey = cellKey(it->m_x, it->m_y);
+    addToCell(it.value());
+  }
+
+  refresh();
+}
+
+/*!
+  \internal
+ */
+void MessageClusterOverlay::clearClusterGraphics()
+{
+  m_refreshTimer->stop();
+  m_graphicsOverlay->graphics()->clear();
+
+  for (const auto& cell : qAsConst(m_cells))
+    delete cell.m_graphic;
+
+  m_cells.clear();
+  m_dirtyCells.clear();
+}
+
+/*!
+  \internal
+  \brief Returns the key of the cell at the current level containing \a x, \a y.
+ */
+quint64 MessageClusterOverlay::cellKey(double x, double y) const
+{
+  const int cells = 1 << m_level;
+  const double halfWidth = WebMercator::s_worldWidth / 2.0;
+  const int column = qBound(0, static_cast<int>((x + halfWidth) / m_cellMeters), cells - 1);
+  const int row = qBound(0, static_cast<int>((y + halfWidth) / m_cellMeters), cells - 1);
+
+  return (static_cast<quint64>(column) << 32) | static_cast<quint32>(row);
+}
+
+/*!
+  \internal
+  \brief Returns the finest level whose cells are at least \l cellSize pixels wide at \a scale.
+ */
+int MessageClusterOverlay::levelForScale(double scale) const
+{
+  const double cellMeters = m_cellSize * scale * WebMercator::s_metersPerPixel;
+  if (cellMeters <= 0.0)
+    return 0;
+
+  const int level = static_cast<int>(std::floor(std::log2(WebMercator::s_worldWidth / cellMeters)));
+  return qBound(0, level, WebMercator::s_maxLevel);
+}
+
+} // Dsa
+
+// Signal Documentation
+/*!
+  \fn void MessageClusterOverlay::clusteringChanged();
+  \brief Signal emitted when tracks start or stop being clustered.
+ */
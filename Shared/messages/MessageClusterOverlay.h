@@ -0,0 +1,117 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef MESSAGECLUSTEROVERLAY_H
+#define MESSAGECLUSTEROVERLAY_H
+
+// Qt headers
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QSet>
+
+class QTimer;
+
+namespace Esri
+{
+  namespace ArcGISRuntime
+  {
+    class GeoView;
+    class Graphic;
+    class GraphicsOverlay;
+  }
+}
+
+namespace Dsa {
+
+class MessagesOverlay;
+
+class MessageClusterOverlay : public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit MessageClusterOverlay(MessagesOverlay* messagesOverlay, QObject* parent = nullptr);
+  ~MessageClusterOverlay();
+
+  Esri::ArcGISRuntime::GraphicsOverlay* graphicsOverlay() const;
+
+  double minScale() const;
+  void setMinScale(double minScale);
+
+  int cellSize() const;
+  void setCellSize(int cellSize);
+
+  bool isClustering() const;
+  int level() const;
+  int clusterCount() const;
+
+  void refresh();
+
+signals:
+  void clusteringChanged();
+
+private:
+  Q_DISABLE_COPY(MessageClusterOverlay)
+
+  // a track's position in web mercator meters and the cell it is counted in
+  struct TrackPosition
+  {
+    double m_x = 0.0;
+    double m_y = 0.0;
+    quint64 m_cellKey = 0;
+  };
+
+  struct Cell
+  {
+    int m_count = 0;
+    double m_sumX = 0.0;
+    double m_sumY = 0.0;
+    Esri::ArcGISRuntime::Graphic* m_graphic = nullptr;
+  };
+
+  void handleGraphicsAdded(int index, int count);
+  void handleGraphicsUpdated(const QList<Esri::ArcGISRuntime::Graphic*>& graphics);
+  void handleGraphicsRemoved(const QList<Esri::ArcGISRuntime::Graphic*>& graphics);
+  void handleViewpointChanged();
+  void updateTrack(Esri::ArcGISRuntime::Graphic* graphic);
+  void addToCell(const TrackPosition& position);
+  void removeFromCell(const TrackPosition& position);
+  void setLevel(int level);
+  void rebuildCells();
+  void clearClusterGraphics();
+  quint64 cellKey(double x, double y) const;
+  int levelForScale(double scale) const;
+
+  MessagesOverlay* m_messagesOverlay = nullptr;
+  Esri::ArcGISRuntime::GeoView* m_geoView = nullptr;
+  Esri::ArcGISRuntime::GraphicsOverlay* m_graphicsOverlay = nullptr;
+  double m_minScale = 0.0;
+  int m_cellSize = 64;
+
+  // -1 while zoomed in past the minimum scale
+  int m_level = -1;
+  double m_cellMeters = 0.0;
+
+  QHash<Esri::ArcGISRuntime::Graphic*, TrackPosition> m_tracks;
+  QHash<quint64, Cell> m_cells;
+  QSet<quint64> m_dirtyCells;
+  QTimer* m_refreshTimer = nullptr;
+};
+
+} // Dsa
+
+#endif // MESSAGECLUSTEROVERLAY_H
@@ -0,0 +1,374 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "MessageDecoder.h"
+
+// dsa app headers
+#include "AllocationCounter.h"
+#include "DecodeScratch.h"
+#include "LatencyProbe.h"
+#include "MessageFeedStats.h"
+
+// Qt headers
+#include <QThread>
+
+namespace Dsa {
+
+namespace {
+// maximum number of raw datagrams waiting to be decoded
+constexpr std::size_t s_pendingDataCapacity = 8192;
+// maximum number of decoded messages waiting to be applied
+constexpr std::size_t s_decodedMessagesCapacity = 8192;
+// maximum number of message IDs held for each suspended message type
+constexpr int s_maxSuspendedIds = 20000;
+}
+
+/*!
+  \class Dsa::MessageDecoder
+  \inmodule Dsa
+  \inherits QObject
+  \brief Decodes raw message data into \l Message objects on a worker thread.
+
+  Raw data is handed to the decoder from the UI thread with \l enqueue.
+  The data is decoded on a dedicated worker thread and the resulting messages
+  are collected in a lock-free single-producer/single-consumer queue. Once
+  messages are available, \l messagesDecoded is emitted and the UI thread can
+  collect all of them at once with \l takeMessages.
+
+  Only one thread may call \l enqueue and \l takeMessages, which is typically
+  the thread the decoder lives in.
+
+  Decoding of a message type can be \l {setSuspended}{suspended}, e.g. while its
+  feed is hidden. The type and ID of each message are then peeked from the raw data
+  and only the latest data for each ID is kept, undecoded, until the type is resumed.
+ */
+
+/*!
+  \brief Constructor taking an optional \a parent.
+
+  The worker thread is started immediately.
+ */
+MessageDecoder::MessageDecoder(QObject* parent) :
+  QObject(parent),
+  m_thread(new QThread(this)),
+  m_worker(new QObject()),
+  m_pendingData(s_pendingDataCapacity),
+  m_decodedMessages(s_decodedMessagesCapacity)
+{
+  m_thread->setObjectName(QStringLiteral("MessageDecoder"));
+  m_worker->moveToThread(m_thread);
+  m_thread->start();
+}
+
+/*!
+  \brief Destructor.
+
+  Stops the worker thread. Any data which has not yet been decoded is discarded.
+ */
+MessageDecoder::~MessageDecoder()
+{
+  m_thread->quit();
+  m_thread->wait();
+  delete m_worker;
+}
+
+/*!
+  \brief Queues the raw \a data, received at \a receivedTimestamp, to be decoded on the worker thread.
+
+  The \a receivedTimestamp is assigned to the decoded message.
+
+  Returns \c false if the queue is full and the data was dropped.
+
+  \sa Message::receivedTimestamp
+ */
+bool MessageDecoder::enqueue(const QByteArray& data, qint64 receivedTimestamp)
+{
+  PendingData pending;
+  pending.data = data;
+  pending.receivedTimestamp = receivedTimestamp;
+  if (!m_pendingData.push(pending))
+    return false;
+
+  scheduleDecode();
+  return true;
+}
+
+/*!
+  \brief Removes and returns all of the messages which have been decoded so far.
+ */
+QList<Message> MessageDecoder::takeMessages()
+{
+  // reset before draining so that messages decoded while draining trigger a new notification
+  m_deliveryScheduled.store(false);
+
+  QList<Message> messages;
+  Message message;
+  while (m_decodedMessages.pop(message))
+    messages.append(message);
+
+  // decoding may have paused because the decoded queue was full
+  if (!m_pendingData.isEmpty() || m_resumePending.load())
+    scheduleDecode();
+
+  return messages;
+}
+
+/*!
+  \brief Returns the number of messages which have been decoded successfully.
+
+  This method is thread-safe.
+ */
+qint64 MessageDecoder::decodedCount() const
+{
+  return m_decodedCount.load();
+}
+
+/*!
+  \brief Returns the number of times data could not be decoded as a message.
+
+  This method is thread-safe.
+ */
+qint64 MessageDecoder::decodeFailureCount() const
+{
+  return m_decodeFailureCount.load();
+}
+
+/*!
+  \brief Returns the total time, in nanoseconds, spent decoding data.
+
+  This method is thread-safe.
+ */
+qint64 MessageDecoder::totalDecodeNsecs() const
+{
+  return m_totalDecodeNsecs.load();
+}
+
+/*!
+  \brief Returns the number of messages held undecoded because their type was suspended.
+
+  This method is thread-safe.
+ */
+qint64 MessageDecoder::suspendedCount() const
+{
+  return m_suspendedCount.load();
+}
+
+/*!
+  \brief Returns the number of heap allocations made while decoding messages,
+  or \c 0 unless allocations are counted.
+
+  This method is thread-safe.
+
+  \sa AllocationCounter
+ */
+qint64 MessageDecoder::decodeAllocationCount() const
+{
+  return m_decodeAllocationCount.load();
+}
+
+/*!
+  \brief Returns whether decoding of \a messageType is suspended.
+
+  This method is thread-safe.
+ */
+bool MessageDecoder::isSuspended(const QString& messageType) const
+{
+  QMutexLocker locker(&m_suspendedMutex);
+  return m_suspendedTypes.contains(messageType);
+}
+
+/*!
+  \brief Sets whether decoding of \a messageType is \a suspended.
+
+  While suspended, only the latest raw data for each message ID of the type is
+  kept. Messages which cannot be peeked without decoding, such as the binary
+  formats, are still decoded. On resuming, the data which was kept is decoded
+  ahead of any data received after it, including data which was already waiting
+  to be decoded, so the messages are delivered in one catch-up.
+ */
+void MessageDecoder::setSuspended(const QString& messageType, bool suspended)
+{
+  {
+    QMutexLocker locker(&m_suspendedMutex);
+    if (suspended)
+    {
+      m_suspendedTypes.insert(messageType);
+    }
+    else
+    {
+      m_suspendedTypes.remove(messageType);
+
+      // handed over with the type, so the worker cannot decode newer data for it first
+      const QHash<QString, PendingData> suspendedData = m_suspendedData.take(messageType);
+      for (const auto& pending : suspendedData)
+        m_resumedData.enqueue(pending);
+
+      if (!m_resumedData.isEmpty())
+        m_resumePending.store(true);
+    }
+
+    m_hasSuspendedTypes.store(!m_suspendedTypes.isEmpty());
+  }
+
+  if (m_resumePending.load())
+    scheduleDecode();
+}
+
+/*!
+  \internal
+  \brief Keeps \a pending in place of any older data for its message ID, and returns
+  \c true, if its message type is suspended. Called on the worker thread.
+ */
+bool MessageDecoder::holdSuspended(const PendingData& pending)
+{
+  QString messageType;
+  QString messageId;
+  if (!Message::peekTypeAndId(pending.data, messageType, messageId))
+    return false;
+
+  QMutexLocker locker(&m_suspendedMutex);
+  if (!m_suspendedTypes.contains(messageType))
+    return false;
+
+  // the time spent suspended is not ingest latency, so the held data has no received time
+  QHash<QString, PendingData>& suspendedData = m_suspendedData[messageType];
+  if (suspendedData.size() < s_maxSuspendedIds || suspendedData.contains(messageId))
+    suspendedData.insert(messageId, PendingData{pending.data, 0});
+
+  ++m_suspendedCount;
+  return true;
+}
+
+/*!
+  \internal
+  \brief Takes the next data held while suspended into \a pending, and returns
+  \c true, if any is waiting. Called on the worker thread.
+ */
+bool MessageDecoder::takeResumed(PendingData& pending)
+{
+  QMutexLocker locker(&m_suspendedMutex);
+  if (m_resumedData.isEmpty())
+    return false;
+
+  pending = m_resumedData.dequeue();
+  m_resumePending.store(!m_resumedData.isEmpty());
+  return true;
+}
+
+/*!
+  \internal
+  \brief Queues \a pending to be decoded after the data held while suspended.
+  Called on the worker thread.
+ */
+void MessageDecoder::deferBehindResumed(const PendingData& pending)
+{
+  QMutexLocker locker(&m_suspendedMutex);
+  m_resumedData.enqueue(pending);
+  m_resumePending.store(true);
+}
+
+/*!
+  \internal
+  \brief Wakes the worker thread unless it is already scheduled to decode.
+ */
+void MessageDecoder::scheduleDecode()
+{
+  if (m_decodeScheduled.exchange(true))
+    return;
+
+  QMetaObject::invokeMethod(m_worker, [this]
+  {
+    decodePending();
+  }, Qt::QueuedConnection);
+}
+
+/*!
+  \internal
+  \brief Decodes all pending data. Called on the worker thread.
+ */
+void MessageDecoder::decodePending()
+{
+  DSA_ALLOCATION_SCOPE(Messages);
+
+  m_decodeScheduled.store(false);
+
+  bool decoded = false;
+  PendingData pending;
+  while (!m_decodedMessages.isFull())
+  {
+    // data held while suspended is caught up first
+    if (!m_resumePending.load() || !takeResumed(pending))
+    {
+      if (!m_pendingData.pop(pending))
+        break;
+
+      if (m_hasSuspendedTypes.load() && holdSuspended(pending))
+        continue;
+
+      // a type was resumed after the check above, so its held data is older than this
+      if (m_resumePending.load())
+      {
+        deferBehindResumed(pending);
+        continue;
+      }
+    }
+
+    const qint64 decodeStart = MessageFeedStats::timestamp();
+    const qint64 allocationStart = AllocationCounter::threadAllocationCount();
+    Message message = Message::create(pending.data);
+    m_decodeAllocationCount += AllocationCounter::threadAllocationCount() - allocationStart;
+    const qint64 decodeEnd = MessageFeedStats::timestamp();
+    m_totalDecodeNsecs += decodeEnd - decodeStart;
+
+    if (message.isEmpty())
+    {
+      ++m_decodeFailureCount;
+      continue;
+    }
+
+    ++m_decodedCount;
+    message.setReceivedTimestamp(pending.receivedTimestamp);
+
+    // stamped messages carry their timings through to the overlays
+    LatencyProbe::Stamp probe;
+    if (LatencyProbe::read(pending.data, probe))
+    {
+      message.setLatencyProbe(probe);
+      message.setDecodedTimestamp(decodeEnd);
+    }
+
+    m_decodedMessages.push(message);
+    decoded = true;
+  }
+
+  // release the last message held by the scratch of the worker thread
+  DecodeScratch::local()->reset();
+
+  if (decoded && !m_deliveryScheduled.exchange(true))
+    emit messagesDecoded();
+}
+
+} // Dsa
+
+// Signal Documentation
+/*!
+  \fn void MessageDecoder::messagesDecoded();
+  \brief Signal emitted from the worker thread when decoded messages are ready
+  to be collected with \l takeMessages.
+ */
@@ -0,0 +1,108 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef MESSAGEDECODER_H
+#define MESSAGEDECODER_H
+
+// dsa app headers
+#include "Message.h"
+#include "SpscQueue.h"
+
+// Qt headers
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QQueue>
+#include <QSet>
+
+// STL headers
+#include <atomic>
+
+class QThread;
+
+namespace Dsa {
+
+class MessageDecoder : public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit MessageDecoder(QObject* parent = nullptr);
+  ~MessageDecoder();
+
+  bool enqueue(const QByteArray& data, qint64 receivedTimestamp = 0);
+  QList<Message> takeMessages();
+
+  qint64 decodedCount() const;
+  qint64 decodeFailureCount() const;
+  qint64 totalDecodeNsecs() const;
+  qint64 suspendedCount() const;
+  qint64 decodeAllocationCount() const;
+
+  bool isSuspended(const QString& messageType) const;
+  void setSuspended(const QString& messageType, bool suspended);
+
+signals:
+  void messagesDecoded();
+
+private:
+  Q_DISABLE_COPY(MessageDecoder)
+
+  void scheduleDecode();
+  void decodePending();
+
+  struct PendingData
+  {
+    QByteArray data;
+    qint64 receivedTimestamp = 0;
+  };
+
+  bool holdSuspended(const PendingData& pending);
+  bool takeResumed(PendingData& pending);
+  void deferBehindResumed(const PendingData& pending);
+
+  QThread* m_thread = nullptr;
+  QObject* m_worker = nullptr;
+
+  SpscQueue<PendingData> m_pendingData;
+  SpscQueue<Message> m_decodedMessages;
+
+  std::atomic<bool> m_decodeScheduled{false};
+  std::atomic<bool> m_deliveryScheduled{false};
+
+  std::atomic<qint64> m_decodedCount{0};
+  std::atomic<qint64> m_decodeFailureCount{0};
+  std::atomic<qint64> m_totalDecodeNsecs{0};
+  std::atomic<qint64> m_decodeAllocationCount{0};
+
+  // the latest raw data for each message ID of a suspended type, by type and then ID
+  mutable QMutex m_suspendedMutex;
+  QSet<QString> m_suspendedTypes;
+  QHash<QString, QHash<QString, PendingData>> m_suspendedData;
+  std::atomic<bool> m_hasSuspendedTypes{false};
+  std::atomic<qint64> m_suspendedCount{0};
+
+  // data held while suspended which is waiting to be decoded, in the order it is to
+  // be decoded, guarded by m_suspendedMutex
+  QQueue<PendingData> m_resumedData;
+  std::atomic<bool> m_resumePending{false};
+};
+
+} // Dsa
+
+#endif // MESSAGEDECODER_H
@@ -0,0 +1,230 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "MessageDecoderPool.h"
+
+// dsa app headers
+#include "MessageDecoder.h"
+
+// Qt headers
+#include <QThread>
+
+// STL headers
+#include <algorithm>
+
+namespace Dsa {
+
+namespace {
+// decoding beyond this many threads competes with rendering for the cores
+constexpr int s_maximumShards = 4;
+}
+
+/*!
+  \class Dsa::MessageDecoderPool
+  \inmodule Dsa
+  \inherits QObject
+  \brief Shares the decoding of raw message data between several \l MessageDecoder
+  shards, each with its own worker thread.
+
+  Data is queued with a shard key, such as the index of the listener which received
+  it, and all data with the same key is decoded in order by the same shard. As a
+  track reports on a single port, its updates stay in order while the tracks of
+  different feeds decode in parallel. Messages which do arrive out of order are
+  caught by their event time in the \l MessagesOverlay.
+
+  There is one shard per core, less one for the UI thread, up to four. A shard's
+  thread is only started once data is queued for it.
+
+  Like a single decoder, only one thread may call \l enqueue and \l takeMessages.
+ */
+
+/*!
+  \brief Constructor taking an optional \a parent.
+ */
+MessageDecoderPool::MessageDecoderPool(QObject* parent) :
+  QObject(parent),
+  m_shards(qBound(1, QThread::idealThreadCount() - 1, s_maximumShards), nullptr)
+{
+}
+
+/*!
+  \brief Destructor.
+
+  Stops the worker threads of the shards.
+ */
+MessageDecoderPool::~MessageDecoderPool()
+{
+}
+
+/*!
+  \brief Returns the number of shards data can be shared between.
+ */
+int MessageDecoderPool::maximumShardCount() const
+{
+  return m_shards.size();
+}
+
+/*!
+  \brief Returns the number of shards which have been started.
+ */
+int MessageDecoderPool::shardCount() const
+{
+  return static_cast<int>(std::count_if(m_shards.cbegin(), m_shards.cend(), [](const MessageDecoder* decoder)
+  {
+    return decoder != nullptr;
+  }));
+}
+
+/*!
+  \brief Queues the raw \a data, received at \a receivedTimestamp, to be decoded by the
+  shard for \a shardKey.
+
+  Returns \c false if the queue of the shard is full and the data was dropped.
+
+  \sa MessageDecoder::enqueue
+ */
+bool MessageDecoderPool::enqueue(const QByteArray& data, qint64 receivedTimestamp, uint shardKey)
+{
+  return shard(static_cast<int>(shardKey % static_cast<uint>(m_shards.size())))->enqueue(data, receivedTimestamp);
+}
+
+/*!
+  \brief Removes and returns all of the messages which have been decoded so far by every shard.
+
+  The messages of each shard are in the order they were decoded.
+ */
+QList<Message> MessageDecoderPool::takeMessages()
+{
+  QList<Message> messages;
+  for (MessageDecoder* decoder : qAsConst(m_shards))
+  {
+    if (decoder)
+      messages.append(decoder->takeMessages());
+  }
+
+  return messages;
+}
+
+/*!
+  \brief Returns the number of messages which have been decoded successfully by every shard.
+ */
+qint64 MessageDecoderPool::decodedCount() const
+{
+  qint64 count = 0;
+  for (const MessageDecoder* decoder : m_shards)
+    count += decoder ? decoder->decodedCount() : 0;
+
+  return count;
+}
+
+/*!
+  \brief Returns the number of times data could not be decoded by any shard.
+ */
+qint64 MessageDecoderPool::decodeFailureCount() const
+{
+  qint64 count = 0;
+  for (const MessageDecoder* decoder : m_shards)
+    count += decoder ? decoder->decodeFailureCount() : 0;
+
+  return count;
+}
+
+/*!
+  \brief Returns the total time, in nanoseconds, spent decoding by every shard.
+ */
+qint64 MessageDecoderPool::totalDecodeNsecs() const
+{
+  qint64 nsecs = 0;
+  for (const MessageDecoder* decoder : m_shards)
+    nsecs += decoder ? decoder->totalDecodeNsecs() : 0;
+
+  return nsecs;
+}
+
+/*!
+  \brief Returns the number of messages held undecoded by every shard because their type was suspended.
+ */
+qint64 MessageDecoderPool::suspendedCount() const
+{
+  qint64 count = 0;
+  for (const MessageDecoder* decoder : m_shards)
+    count += decoder ? decoder->suspendedCount() : 0;
+
+  return count;
+}
+
+/*!
+  \brief Returns the number of heap allocations made while decoding by every shard.
+ */
+qint64 MessageDecoderPool::decodeAllocationCount() const
+{
+  qint64 count = 0;
+  for (const MessageDecoder* decoder : m_shards)
+    count += decoder ? decoder->decodeAllocationCount() : 0;
+
+  return count;
+}
+
+/*!
+  \brief Sets whether decoding of \a messageType is \a suspended by every shard.
+
+  \sa MessageDecoder::setSuspended
+ */
+void MessageDecoderPool::setSuspended(const QString& messageType, bool suspended)
+{
+  if (suspended)
+    m_suspendedTypes.insert(messageType);
+  else
+    m_suspendedTypes.remove(messageType);
+
+  for (MessageDecoder* decoder : qAsConst(m_shards))
+  {
+    if (decoder)
+      decoder->setSuspended(messageType, suspended);
+  }
+}
+
+/*!
+  \internal
+  \brief Returns the decoder of the shard at \a index, starting it if needed.
+ */
+MessageDecoder* MessageDecoderPool::shard(int index)
+{
+  MessageDecoder*& decoder = m_shards[index];
+  if (decoder)
+    return decoder;
+
+  decoder = new MessageDecoder(this);
+  for (const auto& messageType : qAsConst(m_suspendedTypes))
+    decoder->setSuspended(messageType, true);
+
+  // emitted from the shard's worker thread
+  connect(decoder, &MessageDecoder::messagesDecoded, this, &MessageDecoderPool::messagesDecoded);
+
+  return decoder;
+}
+
+} // Dsa
+
+// Signal Documentation
+/*!
+  \fn void MessageDecoderPool::messagesDecoded();
+  \brief Signal emitted from a shard's worker thread when decoded messages are ready
+  to be collected with \l takeMessages.
+ */
@@ -0,0 +1,70 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef MESSAGEDECODERPOOL_H
+#define MESSAGEDECODERPOOL_H
+
+// dsa app headers
+#include "Message.h"
+
+// Qt headers
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QVector>
+
+namespace Dsa {
+
+class MessageDecoder;
+
+class MessageDecoderPool : public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit MessageDecoderPool(QObject* parent = nullptr);
+  ~MessageDecoderPool();
+
+  int maximumShardCount() const;
+  int shardCount() const;
+
+  bool enqueue(const QByteArray& data, qint64 receivedTimestamp, uint shardKey);
+  QList<Message> takeMessages();
+
+  qint64 decodedCount() const;
+  qint64 decodeFailureCount() const;
+  qint64 totalDecodeNsecs() const;
+  qint64 suspendedCount() const;
+  qint64 decodeAllocationCount() const;
+
+  void setSuspended(const QString& messageType, bool suspended);
+
+signals:
+  void messagesDecoded();
+
+private:
+  Q_DISABLE_COPY(MessageDecoderPool)
+
+  MessageDecoder* shard(int index);
+
+  // decoders are only started once data arrives for their shard
+  QVector<MessageDecoder*> m_shards;
+  QSet<QString> m_suspendedTypes;
+};
+
+} // Dsa
+
+#endif // MESSAGEDECODERPOOL_H
@@ -20,6 +20,7 @@
 #include "MessageFeed.h"
 
 // dsa app headers
+#include "MessageFeedStats.h"
 #include "MessagesOverlay.h"
 
 namespace Dsa {
@@ -100,9 +101,53 @@ void MessageFeed::setFeedVisible(bool feedVisible)
   if (m_feedVisible == feedVisible)
     return;
 
+  const bool wasSuspended = isSuspended();
   m_feedVisible = feedVisible;
 
   updateOverlay();
+
+  if (wasSuspended != isSuspended())
+    emit suspendedChanged();
+}
+
+/*!
+  \brief Returns whether decoding of this feed's messages is suspended while it is hidden.
+
+  Only the latest data for each track of a suspended feed is kept, and is applied
+  when the feed is shown again. Alert conditions on the feed are not evaluated while
+  it is suspended, so this is only suited to feeds which are just displayed.
+
+  The default is \c false.
+
+  \sa MessageDecoder::setSuspended
+ */
+bool MessageFeed::isSuspendedWhenHidden() const
+{
+  return m_suspendedWhenHidden;
+}
+
+/*!
+  \brief Sets whether decoding of this feed's messages is suspended while it is hidden
+  to \a suspendedWhenHidden.
+ */
+void MessageFeed::setSuspendedWhenHidden(bool suspendedWhenHidden)
+{
+  if (m_suspendedWhenHidden == suspendedWhenHidden)
+    return;
+
+  const bool wasSuspended = isSuspended();
+  m_suspendedWhenHidden = suspendedWhenHidden;
+
+  if (wasSuspended != isSuspended())
+    emit suspendedChanged();
+}
+
+/*!
+  \brief Returns whether decoding of this feed's messages is currently suspended.
+ */
+bool MessageFeed::isSuspended() const
+{
+  return m_suspendedWhenHidden && !m_feedVisible;
 }
 
 /*!
@@ -150,4 +195,21 @@ void MessageFeed::setThumbnailUrl(const QUrl& thumbnailUrl)
   m_thumbnailUrl = thumbnailUrl;
 }
 
+/*!
+  \property MessageFeed::stats
+  \brief Returns the ingest statistics for this feed, or \c nullptr if the feed has no overlay.
+ */
+MessageFeedStats* MessageFeed::stats() const
+{
+  return m_messagesOverlay ? m_messagesOverlay->stats() : nullptr;
+}
+
 } // Dsa
+
+// Signal Documentation
+/*!
+  \fn void MessageFeed::suspendedChanged();
+  \brief Signal emitted when decoding of the feed's messages is suspended or resumed.
+
+  \sa isSuspended
+ */
@@ -17,6 +17,9 @@
 #ifndef MESSAGEFEED_H
 #define MESSAGEFEED_H
 
+// dsa app headers
+#include "MessageFeedStats.h"
+
 // Qt headers
 #include <QObject>
 #include <QUrl>
@@ -29,6 +32,8 @@ class MessageFeed : public QObject
 {
   Q_OBJECT
 
+  Q_PROPERTY(Dsa::MessageFeedStats* stats READ stats CONSTANT)
+
 public:
   explicit MessageFeed(QObject* parent = nullptr);
   MessageFeed(const QString& name, const QString& type, MessagesOverlay* overlay, QObject* parent = nullptr);
@@ -43,12 +48,21 @@ public:
   bool isFeedVisible() const;
   void setFeedVisible(bool feedVisible);
 
+  bool isSuspendedWhenHidden() const;
+  void setSuspendedWhenHidden(bool suspendedWhenHidden);
+  bool isSuspended() const;
+
   MessagesOverlay* messagesOverlay() const;
   void setMessagesOverlay(MessagesOverlay* messagesOverlay);
 
   QUrl thumbnailUrl() const;
   void setThumbnailUrl(const QUrl& thumbnailUrl);
 
+  MessageFeedStats* stats() const;
+
+signals:
+  void suspendedChanged();
+
 private:
   Q_DISABLE_COPY(MessageFeed)
 
@@ -57,6 +71,7 @@ private:
   QString m_feedName;
   QString m_feedMessageType;
   bool m_feedVisible = true;
+  bool m_suspendedWhenHidden = false;
   MessagesOverlay* m_messagesOverlay = nullptr;
   QUrl m_thumbnailUrl;
 };
@@ -0,0 +1,819 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "MessageFeedArchive.h"
+
+// dsa app headers
+#include "MessageFeed.h"
+#include "MessageFeedListModel.h"
+#include "MessagesOverlay.h"
+
+// C++ API headers
+#include "Point.h"
+
+// Qt headers
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QThreadPool>
+#include <QTimer>
+
+// STL headers
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+namespace {
+
+// "DSAA" and the version of the archive partition files
+constexpr quint32 s_magic = 0x44534141;
+constexpr quint8 s_version = 1;
+constexpr QDataStream::Version s_streamVersion = QDataStream::Qt_5_12;
+
+// each partition file holds an hour of blocks
+constexpr qint64 s_partitionLength = 60 * 60 * 1000;
+
+// recorded updates are written as a block this often, in ms, or once there are this many
+constexpr int s_blockInterval = 5000;
+constexpr int s_maximumBlockRows = 8192;
+
+constexpr quint8 s_deltaBlock = 0;
+constexpr quint8 s_keyframeBlock = 1;
+
+const QString s_partitionPrefix = QStringLiteral("MessageFeedArchive-");
+const QString s_partitionSuffix = QStringLiteral(".dat");
+
+// the rows of one block, one vector per field. Strings are stored once per block
+// and referred to by their index in m_strings
+struct ArchiveColumns
+{
+  QStringList m_strings;
+  QVector<qint64> m_times;
+  QVector<quint8> m_actions;
+  QVector<quint32> m_types;
+  QVector<quint32> m_ids;
+  QVector<quint32> m_symbolIds;
+  QVector<qint32> m_wkids;
+  QVector<double> m_xs;
+  QVector<double> m_ys;
+  // NaN for points without z
+  QVector<double> m_zs;
+  QVector<QVariantMap> m_attributes;
+  QVector<qint64> m_eventTimes;
+  QVector<qint64> m_staleTimes;
+
+  Message message(int row) const
+  {
+    const SpatialReference spatialReference(m_wkids.at(row));
+    const double z = m_zs.at(row);
+    const Point point = std::isnan(z) ? Point(m_xs.at(row), m_ys.at(row), spatialReference)
+                                      : Point(m_xs.at(row), m_ys.at(row), z, spatialReference);
+
+    Message message(static_cast<Message::MessageAction>(m_actions.at(row)), point);
+    message.setMessageType(m_strings.at(m_types.at(row)));
+    message.setMessageId(m_strings.at(m_ids.at(row)));
+    message.setSymbolId(m_strings.at(m_symbolIds.at(row)));
+    message.setAttributes(m_attributes.at(row));
+    message.setEventTime(m_eventTimes.at(row));
+    message.setStaleTime(m_staleTimes.at(row));
+    return message;
+  }
+};
+
+QByteArray encodeColumns(const QList<Message>& messages, const QVector<qint64>& times)
+{
+  ArchiveColumns columns;
+  QHash<QString, quint32> stringIndices;
+  auto intern = [&columns, &stringIndices](const QString& value) -> quint32
+  {
+    auto it = stringIndices.find(value);
+    if (it != stringIndices.end())
+      return it.value();
+
+    const quint32 index = static_cast<quint32>(columns.m_strings.size());
+    columns.m_strings.append(value);
+    stringIndices.insert(value, index);
+    return index;
+  };
+
+  const int count = messages.size();
+  columns.m_times.reserve(count);
+  columns.m_actions.reserve(count);
+  columns.m_types.reserve(count);
+  columns.m_ids.reserve(count);
+  columns.m_symbolIds.reserve(count);
+  columns.m_wkids.reserve(count);
+  columns.m_xs.reserve(count);
+  columns.m_ys.reserve(count);
+  columns.m_zs.reserve(count);
+  columns.m_attributes.reserve(count);
+  columns.m_eventTimes.reserve(count);
+  columns.m_staleTimes.reserve(count);
+
+  // times are stored as the difference from the row before, which compresses well
+  qint64 previousTime = 0;
+  for (int i = 0; i < count; ++i)
+  {
+    const Message& message = messages.at(i);
+    columns.m_times.append(times.at(i) - previousTime);
+    previousTime = times.at(i);
+
+    columns.m_actions.append(static_cast<quint8>(message.messageAction()));
+    columns.m_types.append(intern(message.messageType()));
+    columns.m_ids.append(intern(message.messageId()));
+    columns.m_symbolIds.append(intern(message.symbolId()));
+
+    const Geometry geometry = message.geometry();
+    if (geometry.isEmpty())
+    {
+      columns.m_wkids.append(0);
+      columns.m_xs.append(0.0);
+      columns.m_ys.append(0.0);
+      columns.m_zs.append(std::numeric_limits<double>::quiet_NaN());
+    }
+    else
+    {
+      const Point point(geometry);
+      columns.m_wkids.append(point.spatialReference().wkid());
+      columns.m_xs.append(point.x());
+      columns.m_ys.append(point.y());
+      columns.m_zs.append(point.hasZ() ? point.z() : std::numeric_limits<double>::quiet_NaN());
+    }
+
+    columns.m_attributes.append(message.attributes());
+    columns.m_eventTimes.append(message.eventTime());
+    columns.m_staleTimes.append(message.staleTime());
+  }
+
+  QByteArray body;
+  QDataStream stream(&body, QIODevice::WriteOnly);
+  stream.setVersion(s_streamVersion);
+  stream << columns.m_strings << columns.m_times << columns.m_actions << columns.m_types
+         << columns.m_ids << columns.m_symbolIds << columns.m_wkids << columns.m_xs
+         << columns.m_ys << columns.m_zs << columns.m_attributes << columns.m_eventTimes
+         << columns.m_staleTimes;
+
+  return qCompress(body);
+}
+
+bool decodeColumns(const QByteArray& compressedBody, ArchiveColumns& columns)
+{
+  QDataStream stream(qUncompress(compressedBody));
+  stream.setVersion(s_streamVersion);
+  stream >> columns.m_strings >> columns.m_times >> columns.m_actions >> columns.m_types
+         >> columns.m_ids >> columns.m_symbolIds >> columns.m_wkids >> columns.m_xs
+         >> columns.m_ys >> columns.m_zs >> columns.m_attributes >> columns.m_eventTimes
+         >> columns.m_staleTimes;
+  if (stream.status() != QDataStream::Ok)
+    return false;
+
+  const int count = columns.m_times.size();
+  if (columns.m_actions.size() != count || columns.m_types.size() != count ||
+      columns.m_ids.size() != count || columns.m_symbolIds.size() != count ||
+      columns.m_wkids.size() != count || columns.m_xs.size() != count ||
+      columns.m_ys.size() != count || columns.m_zs.size() != count ||
+      columns.m_attributes.size() != count || columns.m_eventTimes.size() != count ||
+      columns.m_staleTimes.size() != count)
+  {
+    return false;
+  }
+
+  const quint32 stringCount = static_cast<quint32>(columns.m_strings.size());
+  for (int i = 0; i < count; ++i)
+  {
+    if (columns.m_types.at(i) >= stringCount || columns.m_ids.at(i) >= stringCount ||
+        columns.m_symbolIds.at(i) >= stringCount)
+    {
+      return false;
+    }
+  }
+
+  qint64 time = 0;
+  for (qint64& delta : columns.m_times)
+  {
+    time += delta;
+    delta = time;
+  }
+
+  return true;
+}
+
+bool readBlock(const QString& path, qint64 offset, ArchiveColumns& columns)
+{
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly) || !file.seek(offset))
+    return false;
+
+  QDataStream stream(&file);
+  stream.setVersion(s_streamVersion);
+  quint8 blockType = 0;
+  qint64 firstTime = 0;
+  qint64 lastTime = 0;
+  quint32 rowCount = 0;
+  QByteArray body;
+  stream >> blockType >> firstTime >> lastTime >> rowCount >> body;
+
+  return stream.status() == QDataStream::Ok && decodeColumns(body, columns) &&
+      static_cast<quint32>(columns.m_times.size()) == rowCount;
+}
+
+} // namespace
+
+/*!
+  \class Dsa::MessageFeedArchive
+  \inmodule Dsa
+  \inherits QObject
+  \brief Records the updates applied to the message feeds in a time partitioned
+  archive on disk, and reconstructs the tracks of the feeds at any time within it.
+
+  Updates are buffered as they are \l {record}{recorded} and written every few
+  seconds on a background thread as a compressed block. Each block stores its rows
+  column by column, with a string table for the types, IDs and symbol IDs, and a
+  header giving the first and last time it covers. Every \l keyframeInterval seconds
+  a keyframe block holding every track of the feeds is written as well, so that the
+  state at any time is the last keyframe before it plus a short run of updates.
+
+  Blocks are appended to one file per hour in \l directory. The headers of the
+  blocks form the time index of the archive, which is read once and then kept in
+  memory. Files older than the \l retention are deleted as new blocks are written.
+
+  \l seek reads the nearest keyframe before the requested time and the update
+  blocks which follow it, and emits \l seekCompleted with the tracks as they were at
+  that time. Seeking does not replay the archive, so it takes the same time anywhere
+  within it. Seeks requested while one is running are coalesced to the latest.
+
+  Select and unselect updates are not archived.
+ */
+
+/*!
+  \brief Constructor taking the \a messageFeeds to archive, the \a directory of the
+  archive files and an optional \a parent.
+
+  Nothing is recorded until the \l retention is set.
+ */
+MessageFeedArchive::MessageFeedArchive(MessageFeedListModel* messageFeeds, const QString& directory, QObject* parent) :
+  QObject(parent),
+  m_messageFeeds(messageFeeds),
+  m_directory(directory),
+  m_flushTimer(new QTimer(this)),
+  m_threadPool(new QThreadPool(this))
+{
+  // blocks are written and read in order, without competing with the app for cores
+  m_threadPool->setMaxThreadCount(1);
+
+  m_flushTimer->setInterval(s_blockInterval);
+  connect(m_flushTimer, &QTimer::timeout, this, &MessageFeedArchive::flush);
+}
+
+/*!
+  \brief Destructor.
+
+  Writes the updates recorded since the last block and waits for the writes to complete.
+ */
+MessageFeedArchive::~MessageFeedArchive()
+{
+  writePendingBlock();
+  m_threadPool->waitForDone();
+}
+
+/*!
+  \brief Returns the directory holding the archive files.
+ */
+QString MessageFeedArchive::directory() const
+{
+  return m_directory;
+}
+
+/*!
+  \brief Returns the number of hours of updates kept in the archive, or \c 0 if
+  updates are not recorded.
+ */
+int MessageFeedArchive::retention() const
+{
+  return m_retention;
+}
+
+/*!
+  \brief Sets the number of hours of updates kept in the archive to \a retention.
+
+  A \a retention of \c 0 stops recording. Files already in the archive are kept
+  until updates are recorded again.
+ */
+void MessageFeedArchive::setRetention(int retention)
+{
+  retention = qMax(0, retention);
+  if (m_retention == retention)
+    return;
+
+  m_retention = retention;
+  if (m_retention == 0)
+  {
+    writePendingBlock();
+    m_flushTimer->stop();
+    return;
+  }
+
+  m_flushTimer->start();
+  m_threadPool->start([this]()
+  {
+    loadIndex();
+    postRange();
+  });
+}
+
+/*!
+  \brief Returns the seconds between keyframes holding every track of the feeds.
+
+  The default is \c 60.
+ */
+int MessageFeedArchive::keyframeInterval() const
+{
+  return m_keyframeInterval;
+}
+
+/*!
+  \brief Sets the seconds between keyframes holding every track of the feeds to \a keyframeInterval.
+
+  Shorter intervals make seeking faster and the archive larger.
+ */
+void MessageFeedArchive::setKeyframeInterval(int keyframeInterval)
+{
+  m_keyframeInterval = qMax(1, keyframeInterval);
+}
+
+/*!
+  \brief Returns whether keyframes are not being written.
+ */
+bool MessageFeedArchive::isKeyframesPaused() const
+{
+  return m_keyframesPaused;
+}
+
+/*!
+  \brief Sets whether keyframes are not being written to \a keyframesPaused.
+
+  Keyframes are taken from the overlays of the feeds, so they are paused while
+  the overlays show a past state. Updates are still recorded.
+ */
+void MessageFeedArchive::setKeyframesPaused(bool keyframesPaused)
+{
+  m_keyframesPaused = keyframesPaused;
+}
+
+/*!
+  \brief Returns the time of the oldest update in the archive, in milliseconds since
+  the epoch, or \c 0 if the archive is empty.
+ */
+qint64 MessageFeedArchive::startTime() const
+{
+  return m_startTime;
+}
+
+/*!
+  \brief Returns the time of the newest update written to the archive, in milliseconds
+  since the epoch, or \c 0 if the archive is empty.
+ */
+qint64 MessageFeedArchive::endTime() const
+{
+  return m_endTime;
+}
+
+/*!
+  \brief Records the \a messages which have just been applied to the feeds.
+
+  The messages are buffered and written on a background thread with the next block.
+ */
+void MessageFeedArchive::record(const QList<Message>& messages)
+{
+  if (m_retention == 0)
+    return;
+
+  const qint64 time = recordTime();
+  for (const auto& message : messages)
+  {
+    const auto messageAction = message.messageAction();
+    if (messageAction != Message::MessageAction::Update && messageAction != Message::MessageAction::Remove)
+      continue;
+
+    m_pendingMessages.append(message);
+    m_pendingTimes.append(time);
+  }
+
+  if (m_pendingMessages.size() >= s_maximumBlockRows)
+    writePendingBlock();
+}
+
+/*!
+  \brief Writes the updates recorded since the last block, and a keyframe if one is due.
+
+  This is called every few seconds while recording.
+ */
+void MessageFeedArchive::flush()
+{
+  if (m_retention == 0)
+    return;
+
+  writePendingBlock();
+
+  if (m_keyframesPaused)
+    return;
+
+  // every partition starts with a keyframe, so that partitions can be deleted on their own
+  const qint64 time = recordTime();
+  if (m_lastKeyframeTime != 0 && time - m_lastKeyframeTime < m_keyframeInterval * 1000LL &&
+      time - time % s_partitionLength == m_lastKeyframeTime - m_lastKeyframeTime % s_partitionLength)
+  {
+    return;
+  }
+
+  QList<Message> messages;
+  QVector<qint64> times;
+  for (int i = 0; i < m_messageFeeds->count(); ++i)
+  {
+    MessagesOverlay* overlay = m_messageFeeds->at(i)->messagesOverlay();
+
+    // coalesced updates have been recorded already, so the keyframe must include them
+    overlay->flush();
+
+    const auto overlayMessages = overlay->snapshotMessages();
+    for (const auto& message : overlayMessages)
+    {
+      const qint64 lastUpdateTime = overlay->lastUpdateTime(message.messageKey());
+      messages.append(message);
+      times.append(lastUpdateTime > 0 ? qMin(lastUpdateTime, time) : time);
+    }
+  }
+
+  m_lastKeyframeTime = time;
+  writeBlock(messages, times, time);
+}
+
+/*!
+  \brief Reconstructs the tracks of the feeds at \a msecsSinceEpoch in the background,
+  and emits \l seekCompleted with them.
+
+  Tracks which were past their stale time, or their feed's time to live, at
+  \a msecsSinceEpoch are left out. The stale times of the others are cleared,
+  so that they are not expired at once as they are applied.
+ */
+void MessageFeedArchive::seek(qint64 msecsSinceEpoch)
+{
+  if (m_seeking)
+  {
+    m_pendingSeekTime = msecsSinceEpoch;
+    return;
+  }
+
+  startSeek(msecsSinceEpoch);
+}
+
+/*!
+  \internal
+  \brief Returns the time to record updates at, which never goes backwards.
+ */
+qint64 MessageFeedArchive::recordTime()
+{
+  m_lastRecordTime = qMax(m_lastRecordTime, QDateTime::currentMSecsSinceEpoch());
+  return m_lastRecordTime;
+}
+
+/*!
+  \internal
+  \brief Writes the updates recorded since the last block.
+ */
+void MessageFeedArchive::writePendingBlock()
+{
+  if (m_pendingMessages.isEmpty())
+    return;
+
+  writeBlock(m_pendingMessages, m_pendingTimes, 0);
+  m_pendingMessages.clear();
+  m_pendingTimes.clear();
+}
+
+/*!
+  \internal
+  \brief Writes \a messages, recorded at \a times, as a block on the worker thread.
+
+  The block is a keyframe taken at \a keyframeTime, or a block of updates if
+  \a keyframeTime is \c 0. The times of a keyframe are the last updates of its tracks.
+ */
+void MessageFeedArchive::writeBlock(const QList<Message>& messages, const QVector<qint64>& times, qint64 keyframeTime)
+{
+  const bool keyframe = keyframeTime != 0;
+  const qint64 firstTime = keyframe ? keyframeTime : times.first();
+  const qint64 lastTime = keyframe ? keyframeTime : times.last();
+  const qint64 partitionStart = firstTime - firstTime % s_partitionLength;
+  const QString path = QDir(m_directory).filePath(QString("%1%2%3").arg(s_partitionPrefix)
+                                                  .arg(partitionStart, 13, 10, QLatin1Char('0'))
+                                                  .arg(s_partitionSuffix));
+  const qint64 retentionStart = lastTime - m_retention * s_partitionLength;
+
+  m_threadPool->start([this, messages, times, keyframe, firstTime, lastTime, partitionStart, path, retentionStart]()
+  {
+    loadIndex();
+
+    const QByteArray body = encodeColumns(messages, times);
+
+    if (QDir().mkpath(m_directory))
+    {
+      QFile file(path);
+      if (file.open(QIODevice::WriteOnly | QIODevice::Append))
+      {
+        QDataStream stream(&file);
+        stream.setVersion(s_streamVersion);
+        if (file.size() == 0)
+          stream << s_magic << s_version;
+
+        BlockInfo block;
+        block.m_path = path;
+        block.m_partitionStart = partitionStart;
+        block.m_offset = file.pos();
+        block.m_firstTime = firstTime;
+        block.m_lastTime = lastTime;
+        block.m_keyframe = keyframe;
+
+        stream << (keyframe ? s_keyframeBlock : s_deltaBlock) << firstTime << lastTime
+               << static_cast<quint32>(messages.size()) << body;
+        if (stream.status() == QDataStream::Ok && file.flush())
+          m_blocks.append(block);
+      }
+    }
+
+    prune(retentionStart);
+    postRange();
+  });
+}
+
+/*!
+  \internal
+  \brief Starts reconstructing the tracks at \a msecsSinceEpoch on the worker thread.
+ */
+void MessageFeedArchive::startSeek(qint64 msecsSinceEpoch)
+{
+  m_seeking = true;
+
+  // the updates of the last few seconds are needed to seek close to now
+  writePendingBlock();
+
+  QHash<QString, int> timeToLives;
+  for (int i = 0; i < m_messageFeeds->count(); ++i)
+  {
+    const MessagesOverlay* overlay = m_messageFeeds->at(i)->messagesOverlay();
+    timeToLives.insert(overlay->messageType(), overlay->timeToLive());
+  }
+
+  m_threadPool->start([this, msecsSinceEpoch, timeToLives]()
+  {
+    loadIndex();
+    const QList<Message> messages = reconstruct(msecsSinceEpoch, timeToLives);
+
+    QMetaObject::invokeMethod(this, [this, msecsSinceEpoch, messages]()
+    {
+      m_seeking = false;
+      emit seekCompleted(msecsSinceEpoch, messages);
+
+      if (m_pendingSeekTime != -1)
+      {
+        const qint64 pendingSeekTime = m_pendingSeekTime;
+        m_pendingSeekTime = -1;
+        startSeek(pendingSeekTime);
+      }
+    }, Qt::QueuedConnection);
+  });
+}
+
+/*!
+  \internal
+  \brief Sets the times covered by the archive to \a startTime and \a endTime.
+ */
+void MessageFeedArchive::updateRange(qint64 startTime, qint64 endTime)
+{
+  if (m_startTime == startTime && m_endTime == endTime)
+    return;
+
+  m_startTime = startTime;
+  m_endTime = endTime;
+  emit rangeChanged();
+}
+
+/*!
+  \internal
+  \brief Posts the times covered by the index to the UI thread. Called on the worker thread.
+ */
+void MessageFeedArchive::postRange()
+{
+  const qint64 startTime = m_blocks.isEmpty() ? 0 : m_blocks.first().m_firstTime;
+  const qint64 endTime = m_blocks.isEmpty() ? 0 : m_blocks.last().m_lastTime;
+
+  QMetaObject::invokeMethod(this, [this, startTime, endTime]()
+  {
+    updateRange(startTime, endTime);
+  }, Qt::QueuedConnection);
+}
+
+/*!
+  \internal
+  \brief Reads the headers of the blocks in the archive files into the index, the
+  first time it is needed. Called on the worker thread.
+
+  A block cut short by a crash ends its file.
+ */
+void MessageFeedArchive::loadIndex()
+{
+  if (m_indexLoaded)
+    return;
+
+  m_indexLoaded = true;
+
+  const QDir directory(m_directory);
+  const QStringList fileNames = directory.entryList({s_partitionPrefix + QStringLiteral("*") + s_partitionSuffix},
+                                                    QDir::Files, QDir::Name);
+  for (const auto& fileName : fileNames)
+  {
+    bool ok = false;
+    const qint64 partitionStart = fileName.mid(s_partitionPrefix.size(),
+                                               fileName.size() - s_partitionPrefix.size() - s_partitionSuffix.size()).toLongLong(&ok);
+    if (!ok)
+      continue;
+
+    const QString path = directory.filePath(fileName);
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+      continue;
+
+    QDataStream stream(&file);
+    stream.setVersion(s_streamVersion);
+    quint32 magic = 0;
+    quint8 version = 0;
+    stream >> magic >> version;
+    if (stream.status() != QDataStream::Ok || magic != s_magic || version != s_version)
+      continue;
+
+    while (!stream.atEnd())
+    {
+      BlockInfo block;
+      block.m_path = path;
+      block.m_partitionStart = partitionStart;
+      block.m_offset = file.pos();
+
+      // the body is skipped, leaving only the header in the index
+      quint8 blockType = 0;
+      quint32 rowCount = 0;
+      quint32 bodySize = 0;
+      stream >> blockType >> block.m_firstTime >> block.m_lastTime >> rowCount >> bodySize;
+      if (stream.status() != QDataStream::Ok || bodySize == 0xFFFFFFFF ||
+          stream.skipRawData(static_cast<int>(bodySize)) != static_cast<int>(bodySize))
+      {
+        break;
+      }
+
+      block.m_keyframe = blockType == s_keyframeBlock;
+      m_blocks.append(block);
+    }
+  }
+}
+
+/*!
+  \internal
+  \brief Deletes the archive files which only hold updates before \a retentionStart.
+  Called on the worker thread.
+ */
+void MessageFeedArchive::prune(qint64 retentionStart)
+{
+  auto firstKept = std::find_if(m_blocks.begin(), m_blocks.end(), [retentionStart](const BlockInfo& block)
+  {
+    return block.m_partitionStart + s_partitionLength > retentionStart;
+  });
+
+  if (firstKept == m_blocks.begin())
+    return;
+
+  QString removedPath;
+  for (auto it = m_blocks.begin(); it != firstKept; ++it)
+  {
+    if (it->m_path != removedPath)
+    {
+      removedPath = it->m_path;
+      QFile::remove(removedPath);
+    }
+  }
+
+  m_blocks.erase(m_blocks.begin(), firstKept);
+}
+
+/*!
+  \internal
+  \brief Returns the tracks at \a msecsSinceEpoch, taken from the last keyframe before
+  it and the updates which follow the keyframe. Called on the worker thread.
+
+  Tracks are dropped once they are past their stale time, or not updated for
+  longer than the time to live in \a timeToLives for their message type.
+ */
+QList<Message> MessageFeedArchive::reconstruct(qint64 msecsSinceEpoch, const QHash<QString, int>& timeToLives) const
+{
+  int firstBlock = 0;
+  for (int i = m_blocks.size() - 1; i >= 0; --i)
+  {
+    const BlockInfo& block = m_blocks.at(i);
+    if (block.m_keyframe && block.m_firstTime <= msecsSinceEpoch)
+    {
+      firstBlock = i;
+      break;
+    }
+  }
+
+  // the latest row of each track, as the index of its block in readBlocks and its row
+  QVector<ArchiveColumns> readBlocks;
+  QHash<QString, QPair<int, int>> latestRows;
+
+  for (int i = firstBlock; i < m_blocks.size(); ++i)
+  {
+    const BlockInfo& block = m_blocks.at(i);
+    if (block.m_firstTime > msecsSinceEpoch)
+      break;
+
+    // every track is in the keyframe, so a later keyframe adds nothing
+    if (block.m_keyframe && i != firstBlock)
+      continue;
+
+    ArchiveColumns columns;
+    if (!readBlock(block.m_path, block.m_offset, columns))
+      continue;
+
+    // keyframe rows hold the last update times of their tracks, so are not sorted by time
+    const int rowCount = block.m_keyframe ? columns.m_times.size() :
+        static_cast<int>(std::upper_bound(columns.m_times.cbegin(), columns.m_times.cend(), msecsSinceEpoch) - columns.m_times.cbegin());
+
+    const int blockIndex = readBlocks.size();
+    for (int row = 0; row < rowCount; ++row)
+    {
+      const QString key = columns.m_strings.at(columns.m_types.at(row)) + QLatin1Char('\n') +
+          columns.m_strings.at(columns.m_ids.at(row));
+
+      if (static_cast<Message::MessageAction>(columns.m_actions.at(row)) == Message::MessageAction::Remove)
+        latestRows.remove(key);
+      else
+        latestRows.insert(key, qMakePair(blockIndex, row));
+    }
+
+    readBlocks.append(columns);
+  }
+
+  QList<Message> messages;
+  messages.reserve(latestRows.size());
+  for (const auto& latestRow : qAsConst(latestRows))
+  {
+    const ArchiveColumns& columns = readBlocks.at(latestRow.first);
+    const int row = latestRow.second;
+
+    const qint64 staleTime = columns.m_staleTimes.at(row);
+    if (staleTime > 0 && staleTime <= msecsSinceEpoch)
+      continue;
+
+    const int timeToLive = timeToLives.value(columns.m_strings.at(columns.m_types.at(row)));
+    if (timeToLive > 0 && columns.m_times.at(row) + timeToLive * 1000LL <= msecsSinceEpoch)
+      continue;
+
+    Message message = columns.message(row);
+    message.setStaleTime(0);
+    messages.append(message);
+  }
+
+  return messages;
+}
+
+} // Dsa
+
+// Signal Documentation
+/*!
+  \fn void MessageFeedArchive::rangeChanged();
+  \brief Signal emitted when the \l startTime or \l endTime of the archive changes.
+ */
+
+/*!
+  \fn void MessageFeedArchive::seekCompleted(qint64 msecsSinceEpoch, const QList<Message>& messages);
+  \brief Signal emitted when the tracks at \a msecsSinceEpoch have been reconstructed,
+  with the \a messages reproducing them.
+ */
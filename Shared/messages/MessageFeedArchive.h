@@ -0,0 +1,117 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef MESSAGEFEEDARCHIVE_H
+#define MESSAGEFEEDARCHIVE_H
+
+// dsa app headers
+#include "Message.h"
+
+// Qt headers
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+class QThreadPool;
+class QTimer;
+
+namespace Dsa {
+
+class MessageFeedListModel;
+
+class MessageFeedArchive : public QObject
+{
+  Q_OBJECT
+
+public:
+  MessageFeedArchive(MessageFeedListModel* messageFeeds, const QString& directory, QObject* parent = nullptr);
+  ~MessageFeedArchive();
+
+  QString directory() const;
+
+  int retention() const;
+  void setRetention(int retention);
+
+  int keyframeInterval() const;
+  void setKeyframeInterval(int keyframeInterval);
+
+  bool isKeyframesPaused() const;
+  void setKeyframesPaused(bool keyframesPaused);
+
+  qint64 startTime() const;
+  qint64 endTime() const;
+
+  void record(const QList<Message>& messages);
+  void flush();
+
+  void seek(qint64 msecsSinceEpoch);
+
+signals:
+  void rangeChanged();
+  void seekCompleted(qint64 msecsSinceEpoch, const QList<Message>& messages);
+
+private:
+  Q_DISABLE_COPY(MessageFeedArchive)
+
+  // where a block lies on disk and the times it covers
+  struct BlockInfo
+  {
+    QString m_path;
+    qint64 m_partitionStart = 0;
+    qint64 m_offset = 0;
+    qint64 m_firstTime = 0;
+    qint64 m_lastTime = 0;
+    bool m_keyframe = false;
+  };
+
+  qint64 recordTime();
+  void writePendingBlock();
+  void writeBlock(const QList<Message>& messages, const QVector<qint64>& times, qint64 keyframeTime);
+  void startSeek(qint64 msecsSinceEpoch);
+  void updateRange(qint64 startTime, qint64 endTime);
+  void postRange();
+  void loadIndex();
+  void prune(qint64 retentionStart);
+  QList<Message> reconstruct(qint64 msecsSinceEpoch, const QHash<QString, int>& timeToLives) const;
+
+  MessageFeedListModel* m_messageFeeds = nullptr;
+  QString m_directory;
+  int m_retention = 0;
+  int m_keyframeInterval = 60;
+  bool m_keyframesPaused = false;
+  qint64 m_startTime = 0;
+  qint64 m_endTime = 0;
+
+  // updates recorded since the last block was written
+  QList<Message> m_pendingMessages;
+  QVector<qint64> m_pendingTimes;
+  qint64 m_lastRecordTime = 0;
+  qint64 m_lastKeyframeTime = 0;
+  QTimer* m_flushTimer = nullptr;
+
+  // blocks and seeks run in order on a single worker thread, which alone touches m_blocks
+  QThreadPool* m_threadPool = nullptr;
+  QVector<BlockInfo> m_blocks;
+  bool m_indexLoaded = false;
+  bool m_seeking = false;
+  qint64 m_pendingSeekTime = -1;
+};
+
+} // Dsa
+
+#endif // MESSAGEFEEDARCHIVE_H
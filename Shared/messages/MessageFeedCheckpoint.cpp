@@ -0,0 +1,357 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "MessageFeedCheckpoint.h"
+
+// dsa app headers
+#include "MessageFeed.h"
+#include "MessageFeedListModel.h"
+#include "MessageFeedStats.h"
+#include "MessagesOverlay.h"
+
+// C++ API headers
+#include "GraphicListModel.h"
+#include "GraphicsOverlay.h"
+#include "Point.h"
+
+// Qt headers
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QThreadPool>
+#include <QTimer>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+namespace {
+
+// "DSAC" and the version of the checkpoint file
+constexpr quint32 s_checkpointMagic = 0x44534143;
+constexpr quint8 s_checkpointVersion = 1;
+constexpr QDataStream::Version s_checkpointStreamVersion = QDataStream::Qt_5_12;
+
+// the tracks of one feed, copied on the UI thread and written on the worker thread
+struct CheckpointEntry
+{
+  Message m_message;
+  qint64 m_updated = 0;
+};
+
+QByteArray encodeEntries(const QList<CheckpointEntry>& entries)
+{
+  QByteArray body;
+  QDataStream stream(&body, QIODevice::WriteOnly);
+  stream.setVersion(s_checkpointStreamVersion);
+  stream << static_cast<quint32>(entries.size());
+
+  for (const auto& entry : entries)
+  {
+    const Message& message = entry.m_message;
+    const Point point(message.geometry());
+    stream << message.messageType() << message.messageId() << message.symbolId()
+           << static_cast<qint32>(point.spatialReference().wkid())
+           << point.x() << point.y() << point.hasZ() << (point.hasZ() ? point.z() : 0.0)
+           << message.attributes()
+           << message.eventTime() << message.staleTime() << entry.m_updated;
+  }
+
+  return body;
+}
+
+QList<CheckpointEntry> decodeEntries(const QByteArray& body)
+{
+  QList<CheckpointEntry> entries;
+
+  QDataStream stream(body);
+  stream.setVersion(s_checkpointStreamVersion);
+  quint32 count = 0;
+  stream >> count;
+
+  for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i)
+  {
+    QString messageType;
+    QString messageId;
+    QString symbolId;
+    qint32 wkid = 0;
+    double x = 0.0;
+    double y = 0.0;
+    bool hasZ = false;
+    double z = 0.0;
+    QVariantMap attributes;
+    qint64 eventTime = 0;
+    qint64 staleTime = 0;
+    qint64 updated = 0;
+    stream >> messageType >> messageId >> symbolId >> wkid >> x >> y >> hasZ >> z
+           >> attributes >> eventTime >> staleTime >> updated;
+    if (stream.status() != QDataStream::Ok)
+      break;
+
+    const SpatialReference spatialReference(wkid);
+    CheckpointEntry entry;
+    entry.m_message = Message(Message::MessageAction::Update,
+                              hasZ ? Point(x, y, z, spatialReference) : Point(x, y, spatialReference));
+    entry.m_message.setMessageType(messageType);
+    entry.m_message.setMessageId(messageId);
+    entry.m_message.setSymbolId(symbolId);
+    entry.m_message.setAttributes(attributes);
+    entry.m_message.setEventTime(eventTime);
+    entry.m_message.setStaleTime(staleTime);
+    entry.m_updated = updated;
+    entries.append(entry);
+  }
+
+  return entries;
+}
+
+} // namespace
+
+/*!
+  \class Dsa::MessageFeedCheckpoint
+  \inmodule Dsa
+  \inherits QObject
+  \brief Periodically saves the tracks of the message feeds to a local file, and
+  restores them when the app starts again after a crash or power cycle.
+
+  Every \l interval seconds, if any feed has changed, the ID, geometry, attributes
+  and times of every graphic are copied from the overlays and written, compressed,
+  to \l path on a background thread. The file is replaced atomically so a crash
+  while writing leaves the previous checkpoint intact.
+
+  \l restore reads the file in the background and emits \l restored with the tracks
+  which have not aged out: tracks past their stale time, or not updated for longer
+  than their feed's time to live, are dropped. The others are given a stale time at
+  which their time to live would have run out, so that they expire as if the app
+  had never stopped.
+ */
+
+/*!
+  \brief Constructor taking the \a messageFeeds to checkpoint, the \a path of the
+  checkpoint file and an optional \a parent.
+ */
+MessageFeedCheckpoint::MessageFeedCheckpoint(MessageFeedListModel* messageFeeds, const QString& path, QObject* parent) :
+  QObject(parent),
+  m_messageFeeds(messageFeeds),
+  m_path(path),
+  m_timer(new QTimer(this)),
+  m_threadPool(new QThreadPool(this))
+{
+  // checkpoints are written one at a time so that they do not compete with the app for cores
+  m_threadPool->setMaxThreadCount(1);
+
+  connect(m_timer, &QTimer::timeout, this, &MessageFeedCheckpoint::save);
+}
+
+/*!
+  \brief Destructor.
+
+  Waits for a checkpoint which is being written to complete.
+ */
+MessageFeedCheckpoint::~MessageFeedCheckpoint()
+{
+  m_threadPool->waitForDone();
+}
+
+/*!
+  \brief Returns the path of the checkpoint file.
+ */
+QString MessageFeedCheckpoint::path() const
+{
+  return m_path;
+}
+
+/*!
+  \brief Returns the interval between checkpoints in seconds, or \c 0 if disabled.
+ */
+int MessageFeedCheckpoint::interval() const
+{
+  return m_interval;
+}
+
+/*!
+  \brief Sets the \a interval between checkpoints in seconds.
+
+  An interval of \c 0 stops checkpointing, and a checkpoint is then not restored.
+ */
+void MessageFeedCheckpoint::setInterval(int interval)
+{
+  m_interval = qMax(0, interval);
+  if (m_interval > 0)
+    m_timer->start(m_interval * 1000);
+  else
+    m_timer->stop();
+}
+
+/*!
+  \brief Saves the tracks of the message feeds, unless nothing has changed since
+  the last checkpoint or one is still being written.
+
+  The tracks are copied on the calling thread and written on a background thread.
+ */
+void MessageFeedCheckpoint::save()
+{
+  // a checkpoint written before the last one is restored would lose it
+  if (m_saving || !m_restoreStarted)
+    return;
+
+  const qint64 currentGeneration = generation();
+  if (currentGeneration == m_savedGeneration)
+    return;
+
+  QList<CheckpointEntry> entries;
+  for (int i = 0; i < m_messageFeeds->count(); ++i)
+  {
+    const MessagesOverlay* overlay = m_messageFeeds->at(i)->messagesOverlay();
+    const auto messages = overlay->snapshotMessages();
+    for (const auto& message : messages)
+      entries.append(CheckpointEntry{message, overlay->lastUpdateTime(message.messageKey())});
+  }
+
+  m_saving = true;
+  m_savedGeneration = currentGeneration;
+
+  const QString path = m_path;
+  m_threadPool->start([this, entries, path]()
+  {
+    const QByteArray body = qCompress(encodeEntries(entries));
+
+    bool written = false;
+    if (QDir().mkpath(QFileInfo(path).absolutePath()))
+    {
+      QSaveFile file(path);
+      if (file.open(QIODevice::WriteOnly))
+      {
+        QDataStream stream(&file);
+        stream.setVersion(s_checkpointStreamVersion);
+        stream << s_checkpointMagic << s_checkpointVersion << QDateTime::currentMSecsSinceEpoch() << body;
+        written = stream.status() == QDataStream::Ok && file.commit();
+      }
+    }
+
+    QMetaObject::invokeMethod(this, [this, written]()
+    {
+      m_saving = false;
+
+      // try again at the next interval
+      if (!written)
+        m_savedGeneration = -1;
+    }, Qt::QueuedConnection);
+  });
+}
+
+/*!
+  \brief Reads the checkpoint file in the background and emits \l restored with the
+  tracks which have not aged out.
+
+  Only the first call restores the checkpoint, and only if checkpointing is enabled.
+  Checkpoints are not saved until the restore has been started.
+ */
+void MessageFeedCheckpoint::restore()
+{
+  if (m_restoreStarted)
+    return;
+
+  m_restoreStarted = true;
+  if (m_interval == 0 || !QFileInfo::exists(m_path))
+    return;
+
+  const QString path = m_path;
+  m_threadPool->start([this, path]()
+  {
+    QList<CheckpointEntry> entries;
+
+    QFile file(path);
+    if (file.open(QIODevice::ReadOnly))
+    {
+      QDataStream stream(&file);
+      stream.setVersion(s_checkpointStreamVersion);
+      quint32 magic = 0;
+      quint8 version = 0;
+      qint64 savedTime = 0;
+      QByteArray body;
+      stream >> magic >> version >> savedTime >> body;
+      if (stream.status() == QDataStream::Ok && magic == s_checkpointMagic && version == s_checkpointVersion)
+        entries = decodeEntries(qUncompress(body));
+    }
+
+    QMetaObject::invokeMethod(this, [this, entries]()
+    {
+      const qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+      QList<Message> messages;
+      messages.reserve(entries.size());
+      for (const auto& entry : entries)
+      {
+        const MessageFeed* feed = m_messageFeeds->messageFeedByType(entry.m_message.messageType());
+        if (!feed)
+          continue;
+
+        Message message = entry.m_message;
+        if (message.staleTime() > 0 && now >= message.staleTime())
+          continue;
+
+        const int timeToLive = feed->messagesOverlay()->timeToLive();
+        if (timeToLive > 0)
+        {
+          const qint64 expiry = entry.m_updated + static_cast<qint64>(timeToLive) * 1000;
+          if (now >= expiry)
+            continue;
+
+          // the track expires when its time to live would have run out
+          if (message.staleTime() == 0 || expiry < message.staleTime())
+            message.setStaleTime(expiry);
+        }
+
+        messages.append(message);
+      }
+
+      if (!messages.isEmpty())
+        emit restored(messages);
+    }, Qt::QueuedConnection);
+  });
+}
+
+/*!
+  \internal
+  \brief Returns a value which changes whenever the tracks of any feed change.
+ */
+qint64 MessageFeedCheckpoint::generation() const
+{
+  qint64 value = 0;
+  for (int i = 0; i < m_messageFeeds->count(); ++i)
+  {
+    const MessagesOverlay* overlay = m_messageFeeds->at(i)->messagesOverlay();
+    value += overlay->stats()->appliedCount() + overlay->graphicsOverlay()->graphics()->size();
+  }
+
+  return value;
+}
+
+} // Dsa
+
+// Signal Documentation
+/*!
+  \fn void MessageFeedCheckpoint::restored(const QList<Message>& messages);
+  \brief Signal emitted when the checkpoint has been read, with the \a messages
+  reproducing the tracks which have not aged out.
+ */
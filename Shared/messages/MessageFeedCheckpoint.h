@@ -0,0 +1,71 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef MESSAGEFEEDCHECKPOINT_H
+#define MESSAGEFEEDCHECKPOINT_H
+
+// dsa app headers
+#include "Message.h"
+
+// Qt headers
+#include <QList>
+#include <QObject>
+#include <QString>
+
+class QThreadPool;
+class QTimer;
+
+namespace Dsa {
+
+class MessageFeedListModel;
+
+class MessageFeedCheckpoint : public QObject
+{
+  Q_OBJECT
+
+public:
+  MessageFeedCheckpoint(MessageFeedListModel* messageFeeds, const QString& path, QObject* parent = nullptr);
+  ~MessageFeedCheckpoint();
+
+  QString path() const;
+
+  int interval() const;
+  void setInterval(int interval);
+
+  void save();
+  void restore();
+
+signals:
+  void restored(const QList<Message>& messages);
+
+private:
+  Q_DISABLE_COPY(MessageFeedCheckpoint)
+
+  qint64 generation() const;
+
+  MessageFeedListModel* m_messageFeeds = nullptr;
+  QString m_path;
+  int m_interval = 0;
+  QTimer* m_timer = nullptr;
+  QThreadPool* m_threadPool = nullptr;
+  qint64 m_savedGeneration = -1;
+  bool m_saving = false;
+  bool m_restoreStarted = false;
+};
+
+} // Dsa
+
+#endif // MESSAGEFEEDCHECKPOINT_H
@@ -26,12 +26,49 @@ const QString MessageFeedConstants::OBSERVATION_REPORT_CONFIG_PORT = QStringLite
 const QString MessageFeedConstants::LOCATION_BROADCAST_CONFIG_PROPERTYNAME = QStringLiteral("LocationBroadcastConfig");
 const QString MessageFeedConstants::LOCATION_BROADCAST_CONFIG_MESSAGE_TYPE = QStringLiteral("messageType");
 const QString MessageFeedConstants::LOCATION_BROADCAST_CONFIG_PORT = QStringLiteral("port");
+const QString MessageFeedConstants::LOCATION_BROADCAST_CONFIG_WIRE_FORMAT = QStringLiteral("wireFormat");
+const QString MessageFeedConstants::LOCATION_BROADCAST_CONFIG_ADAPTIVE = QStringLiteral("adaptive");
+const QString MessageFeedConstants::LOCATION_BROADCAST_CONFIG_DISTANCE_THRESHOLD = QStringLiteral("distanceThreshold");
+const QString MessageFeedConstants::LOCATION_BROADCAST_CONFIG_HEADING_THRESHOLD = QStringLiteral("headingThreshold");
+const QString MessageFeedConstants::LOCATION_BROADCAST_CONFIG_HEARTBEAT_INTERVAL = QStringLiteral("heartbeatInterval");
+const QString MessageFeedConstants::LOCATION_BROADCAST_CONFIG_LATENCY_PROBE = QStringLiteral("latencyProbe");
 const QString MessageFeedConstants::MESSAGE_FEEDS_PROPERTYNAME = QStringLiteral("MessageFeeds");
 const QString MessageFeedConstants::MESSAGE_FEEDS_NAME = QStringLiteral("name");
 const QString MessageFeedConstants::MESSAGE_FEEDS_TYPE= QStringLiteral("type");
 const QString MessageFeedConstants::MESSAGE_FEEDS_RENDERER = QStringLiteral("renderer");
 const QString MessageFeedConstants::MESSAGE_FEEDS_THUMBNAIL = QStringLiteral("thumbnail");
 const QString MessageFeedConstants::MESSAGE_FEEDS_PLACEMENT = QStringLiteral("placement");
+const QString MessageFeedConstants::MESSAGE_FEEDS_TIME_TO_LIVE = QStringLiteral("timeToLive");
+const QString MessageFeedConstants::MESSAGE_FEEDS_FADE_AGE = QStringLiteral("fadeAge");
+const QString MessageFeedConstants::MESSAGE_FEEDS_CLUSTER_SCALE = QStringLiteral("clusterScale");
+const QString MessageFeedConstants::MESSAGE_FEEDS_CLUSTER_CELL_SIZE = QStringLiteral("clusterCellSize");
+const QString MessageFeedConstants::MESSAGE_FEEDS_TRAIL_LENGTH = QStringLiteral("trailLength");
+const QString MessageFeedConstants::MESSAGE_FEEDS_INTEREST_MANAGED = QStringLiteral("interestManaged");
+const QString MessageFeedConstants::MESSAGE_FEEDS_SUSPEND_WHEN_HIDDEN = QStringLiteral("suspendWhenHidden");
+const QString MessageFeedConstants::MESSAGE_FEEDS_RENDERING_MODE = QStringLiteral("renderingMode");
 const QString MessageFeedConstants::MESSAGE_FEED_UDP_PORTS_PROPERTYNAME = QStringLiteral("MessageFeedUdpPorts");
+const QString MessageFeedConstants::MESSAGE_FEED_TCP_SERVERS_PROPERTYNAME = QStringLiteral("MessageFeedTcpServers");
+const QString MessageFeedConstants::MESSAGE_FEED_SNAPSHOT_PORT_PROPERTYNAME = QStringLiteral("MessageFeedSnapshotPort");
+const QString MessageFeedConstants::MESSAGE_FEED_CHECKPOINT_INTERVAL_PROPERTYNAME = QStringLiteral("MessageFeedCheckpointInterval");
+const QString MessageFeedConstants::MESSAGE_FEED_ARCHIVE_RETENTION_PROPERTYNAME = QStringLiteral("MessageFeedArchiveRetention");
+const QString MessageFeedConstants::MESSAGE_FEED_ARCHIVE_KEYFRAME_INTERVAL_PROPERTYNAME = QStringLiteral("MessageFeedArchiveKeyframeInterval");
+const QString MessageFeedConstants::MESSAGE_FEED_FILTER_PROPERTYNAME = QStringLiteral("MessageFeedFilter");
+const QString MessageFeedConstants::MESSAGE_FEED_CAPTURE_FILE_PROPERTYNAME = QStringLiteral("MessageFeedCaptureFile");
+const QString MessageFeedConstants::MESSAGE_FEED_RELAY_PROPERTYNAME = QStringLiteral("MessageFeedRelay");
+const QString MessageFeedConstants::MESSAGE_FEED_RELAY_OUTPUT_PORT = QStringLiteral("outputPort");
+const QString MessageFeedConstants::MESSAGE_FEED_RELAY_MAXIMUM_RATE = QStringLiteral("maximumRate");
+const QString MessageFeedConstants::MESSAGE_FEED_RELAY_FILTER = QStringLiteral("filter");
+const QString MessageFeedConstants::TRACK_REPLAY_CONFIG_PROPERTYNAME = QStringLiteral("TrackReplayConfig");
+const QString MessageFeedConstants::TRACK_REPLAY_CONFIG_GPX_FILE = QStringLiteral("gpxFile");
+const QString MessageFeedConstants::TRACK_REPLAY_CONFIG_TRACK_COUNT = QStringLiteral("trackCount");
+const QString MessageFeedConstants::TRACK_REPLAY_CONFIG_SPACING = QStringLiteral("spacing");
+const QString MessageFeedConstants::TRACK_REPLAY_CONFIG_MESSAGE_TYPE = QStringLiteral("messageType");
+const QString MessageFeedConstants::TRACK_REPLAY_CONFIG_SYMBOL_ID = QStringLiteral("symbolId");
+const QString MessageFeedConstants::TRACK_REPLAY_CONFIG_UPDATE_INTERVAL = QStringLiteral("updateInterval");
+const QString MessageFeedConstants::TRACK_REPLAY_CONFIG_PLAYBACK_MULTIPLIER = QStringLiteral("playbackMultiplier");
+const QString MessageFeedConstants::MESSAGE_REPLAY_CONFIG_PROPERTYNAME = QStringLiteral("MessageReplayConfig");
+const QString MessageFeedConstants::MESSAGE_REPLAY_CONFIG_FILE = QStringLiteral("file");
+const QString MessageFeedConstants::MESSAGE_REPLAY_CONFIG_MESSAGES_PER_SECOND = QStringLiteral("messagesPerSecond");
+const QString MessageFeedConstants::MESSAGE_REPLAY_CONFIG_LOOP = QStringLiteral("loop");
 
 } // Dsa
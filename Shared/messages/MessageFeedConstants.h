@@ -32,13 +32,50 @@ public:
   static const QString LOCATION_BROADCAST_CONFIG_PROPERTYNAME;
   static const QString LOCATION_BROADCAST_CONFIG_MESSAGE_TYPE;
   static const QString LOCATION_BROADCAST_CONFIG_PORT;
+  static const QString LOCATION_BROADCAST_CONFIG_WIRE_FORMAT;
+  static const QString LOCATION_BROADCAST_CONFIG_ADAPTIVE;
+  static const QString LOCATION_BROADCAST_CONFIG_DISTANCE_THRESHOLD;
+  static const QString LOCATION_BROADCAST_CONFIG_HEADING_THRESHOLD;
+  static const QString LOCATION_BROADCAST_CONFIG_HEARTBEAT_INTERVAL;
+  static const QString LOCATION_BROADCAST_CONFIG_LATENCY_PROBE;
   static const QString MESSAGE_FEEDS_PROPERTYNAME;
   static const QString MESSAGE_FEEDS_NAME;
   static const QString MESSAGE_FEEDS_TYPE;
   static const QString MESSAGE_FEEDS_RENDERER;
   static const QString MESSAGE_FEEDS_THUMBNAIL;
   static const QString MESSAGE_FEEDS_PLACEMENT;
+  static const QString MESSAGE_FEEDS_TIME_TO_LIVE;
+  static const QString MESSAGE_FEEDS_FADE_AGE;
+  static const QString MESSAGE_FEEDS_CLUSTER_SCALE;
+  static const QString MESSAGE_FEEDS_CLUSTER_CELL_SIZE;
+  static const QString MESSAGE_FEEDS_TRAIL_LENGTH;
+  static const QString MESSAGE_FEEDS_INTEREST_MANAGED;
+  static const QString MESSAGE_FEEDS_SUSPEND_WHEN_HIDDEN;
+  static const QString MESSAGE_FEEDS_RENDERING_MODE;
   static const QString MESSAGE_FEED_UDP_PORTS_PROPERTYNAME;
+  static const QString MESSAGE_FEED_TCP_SERVERS_PROPERTYNAME;
+  static const QString MESSAGE_FEED_SNAPSHOT_PORT_PROPERTYNAME;
+  static const QString MESSAGE_FEED_CHECKPOINT_INTERVAL_PROPERTYNAME;
+  static const QString MESSAGE_FEED_ARCHIVE_RETENTION_PROPERTYNAME;
+  static const QString MESSAGE_FEED_ARCHIVE_KEYFRAME_INTERVAL_PROPERTYNAME;
+  static const QString MESSAGE_FEED_FILTER_PROPERTYNAME;
+  static const QString MESSAGE_FEED_CAPTURE_FILE_PROPERTYNAME;
+  static const QString MESSAGE_FEED_RELAY_PROPERTYNAME;
+  static const QString MESSAGE_FEED_RELAY_OUTPUT_PORT;
+  static const QString MESSAGE_FEED_RELAY_MAXIMUM_RATE;
+  static const QString MESSAGE_FEED_RELAY_FILTER;
+  static const QString TRACK_REPLAY_CONFIG_PROPERTYNAME;
+  static const QString TRACK_REPLAY_CONFIG_GPX_FILE;
+  static const QString TRACK_REPLAY_CONFIG_TRACK_COUNT;
+  static const QString TRACK_REPLAY_CONFIG_SPACING;
+  static const QString TRACK_REPLAY_CONFIG_MESSAGE_TYPE;
+  static const QString TRACK_REPLAY_CONFIG_SYMBOL_ID;
+  static const QString TRACK_REPLAY_CONFIG_UPDATE_INTERVAL;
+  static const QString TRACK_REPLAY_CONFIG_PLAYBACK_MULTIPLIER;
+  static const QString MESSAGE_REPLAY_CONFIG_PROPERTYNAME;
+  static const QString MESSAGE_REPLAY_CONFIG_FILE;
+  static const QString MESSAGE_REPLAY_CONFIG_MESSAGES_PER_SECOND;
+  static const QString MESSAGE_REPLAY_CONFIG_LOOP;
 };
 
 } // Dsa
@@ -21,6 +21,7 @@
 
 // dsa app headers
 #include "MessageFeed.h"
+#include "MessageFeedStats.h"
 
 namespace Dsa {
 
@@ -74,6 +75,7 @@ void MessageFeedListModel::setupRoles()
   m_roles[MessageFeedTypeRole] = "feedMessageType";
   m_roles[MessageFeedVisibleRole] = "feedVisible";
   m_roles[MessageFeedThumbnailUrlRole] = "thumbnailUrl";
+  m_roles[MessageFeedStatsRole] = "feedStats";
 }
 
 /*!
@@ -172,6 +174,9 @@ QVariant MessageFeedListModel::data(const QModelIndex& index, int role) const
   case MessageFeedThumbnailUrlRole:
     retVal = messageFeed->thumbnailUrl();
     break;
+  case MessageFeedStatsRole:
+    retVal = QVariant::fromValue<QObject*>(messageFeed->stats());
+    break;
   default:
     break;
   }
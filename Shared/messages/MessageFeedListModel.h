@@ -34,7 +34,8 @@ public:
     MessageFeedNameRole = Qt::DisplayRole,
     MessageFeedTypeRole = Qt::UserRole + 1,
     MessageFeedVisibleRole,
-    MessageFeedThumbnailUrlRole
+    MessageFeedThumbnailUrlRole,
+    MessageFeedStatsRole
   };
 
   explicit MessageFeedListModel(QObject* parent = nullptr);
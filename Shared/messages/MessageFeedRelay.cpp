@@ -0,0 +1,368 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+
+// PCH header
+#include "pch.hpp"
+
+#include "MessageFeedRelay.h"
+
+// dsa app headers
+#include "DataListener.h"
+#include "Message.h"
+#include "OutboundTransport.h"
+
+// Qt headers
+#include <QTimer>
+
+namespace Dsa {
+
+namespace {
+
+// the queued updates are sent at most this often, in ms
+constexpr int s_sendInterval = 100;
+
+// tracks without an update for this long are forgotten, in ms
+constexpr int s_pruneInterval = 60 * 1000;
+constexpr qint64 s_trackTimeout = 10 * 60 * 1000;
+
+QString trackKey(const QString& messageType, const QString& messageId)
+{
+  return messageType + QLatin1Char('|') + messageId;
+}
+
+} // namespace
+
+/*!
+  \class Dsa::MessageFeedRelay
+  \inmodule Dsa
+  \inherits QObject
+  \brief Rebroadcasts the message feeds received by this node on another port, so that
+  a node bridging two networks can pass on the tracks of one to the other.
+
+  Every datagram of the \l {addDataListener}{data listeners} is keyed by its message
+  type and id, peeked from the XML where possible so that most datagrams are not
+  decoded. A datagram identical to the last one relayed for its track, as happens when
+  a feed is heard on several ports or repeated by the sender, is dropped.
+
+  Each track is relayed at most \l maximumRate times a second. An update arriving
+  sooner is held, and replaced by any newer update of the same track, until the
+  track's allowance comes around; only the latest update is then sent. Before it is
+  sent the update is checked against the \l filter, so that traffic outside the area
+  of interest, of unwanted affiliations or too old is not passed on.
+
+  Updates are sent at routine priority through the \l OutboundTransport, coalesced
+  by track, so that the relay's link is shaped with the other traffic of the app.
+  The output port must not be one of the feed ports, or the relay would hear its own
+  traffic.
+ */
+
+/*!
+  \brief Constructor taking an optional \a parent.
+ */
+MessageFeedRelay::MessageFeedRelay(QObject* parent) :
+  QObject(parent),
+  m_sendTimer(new QTimer(this)),
+  m_pruneTimer(new QTimer(this))
+{
+  m_clock.start();
+
+  m_sendTimer->setInterval(s_sendInterval);
+  connect(m_sendTimer, &QTimer::timeout, this, &MessageFeedRelay::sendPending);
+
+  m_pruneTimer->setInterval(s_pruneInterval);
+  connect(m_pruneTimer, &QTimer::timeout, this, &MessageFeedRelay::pruneTracks);
+}
+
+/*!
+  \brief Destructor.
+ */
+MessageFeedRelay::~MessageFeedRelay()
+{
+}
+
+/*!
+  \brief Starts relaying to \a port with \a transport.
+
+  Returns \c false if the relay has already started or \a port is \c 0.
+ */
+bool MessageFeedRelay::start(const UdpTransport& transport, quint16 port)
+{
+  if (m_port != 0 || port == 0)
+    return false;
+
+  m_transport = transport;
+  m_port = port;
+  m_pruneTimer->start();
+  return true;
+}
+
+/*!
+  \brief Returns the port updates are relayed to, or \c 0 if not started.
+ */
+quint16 MessageFeedRelay::port() const
+{
+  return m_port;
+}
+
+/*!
+  \brief Returns the most updates of each track relayed per second.
+ */
+double MessageFeedRelay::maximumRate() const
+{
+  return m_maximumRate;
+}
+
+/*!
+  \brief Sets the most updates of each track relayed per second to \a maximumRate.
+
+  \c 0 or less relays every update which is not a duplicate. The default is 1.
+ */
+void MessageFeedRelay::setMaximumRate(double maximumRate)
+{
+  m_maximumRate = maximumRate;
+}
+
+/*!
+  \brief Returns the filter relayed updates must pass.
+ */
+MessageIngestFilter MessageFeedRelay::filter() const
+{
+  return m_filter;
+}
+
+/*!
+  \brief Sets the \a filter relayed updates must pass.
+ */
+void MessageFeedRelay::setFilter(const MessageIngestFilter& filter)
+{
+  m_filter = filter;
+}
+
+/*!
+  \brief Relays the datagrams received by \a dataListener.
+ */
+void MessageFeedRelay::addDataListener(DataListener* dataListener)
+{
+  if (!dataListener)
+    return;
+
+  connect(dataListener, &DataListener::dataReceived, this, &MessageFeedRelay::relay);
+  connect(dataListener, &DataListener::dataReceivedBatch, this, &MessageFeedRelay::relayBatch);
+}
+
+/*!
+  \brief Relays the message in \a data, unless it is a duplicate, or holds it until
+  its track may be relayed again.
+
+  Nothing is relayed unless the relay has been \l {start}{started}.
+ */
+void MessageFeedRelay::relay(const QByteArray& data)
+{
+  if (m_port == 0 || data.isEmpty())
+    return;
+
+  QString messageType;
+  QString messageId;
+  if (!Message::peekTypeAndId(data, messageType, messageId))
+  {
+    const Message message = Message::create(data);
+    if (message.isEmpty())
+      return;
+
+    messageType = message.messageType();
+    messageId = message.messageId();
+  }
+
+  const QString key = trackKey(messageType, messageId);
+  const qint64 now = m_clock.elapsed();
+  Track& track = m_tracks[key];
+  track.m_lastReceivedTime = now;
+
+  if (data == track.m_pending)
+  {
+    ++m_duplicateCount;
+    return;
+  }
+
+  // a track which returns to its last relayed state has nothing new to send
+  if (data == track.m_lastSent)
+  {
+    if (track.m_pending.isEmpty())
+    {
+      ++m_duplicateCount;
+    }
+    else
+    {
+      track.m_pending.clear();
+      ++m_coalescedCount;
+    }
+    return;
+  }
+
+  if (!track.m_pending.isEmpty())
+    ++m_coalescedCount;
+
+  track.m_pending = data;
+
+  if (track.m_lastSentTime == 0 || now - track.m_lastSentTime >= minimumInterval())
+  {
+    send(key, track, now);
+    return;
+  }
+
+  if (!track.m_queued)
+  {
+    track.m_queued = true;
+    m_queuedKeys.append(key);
+  }
+
+  if (!m_sendTimer->isActive())
+    m_sendTimer->start();
+}
+
+/*!
+  \brief Returns the number of updates relayed.
+ */
+qint64 MessageFeedRelay::relayedCount() const
+{
+  return m_relayedCount;
+}
+
+/*!
+  \brief Returns the number of updates dropped as duplicates of the last update of their track.
+ */
+qint64 MessageFeedRelay::duplicateCount() const
+{
+  return m_duplicateCount;
+}
+
+/*!
+  \brief Returns the number of held updates replaced by a newer update of their track.
+ */
+qint64 MessageFeedRelay::coalescedCount() const
+{
+  return m_coalescedCount;
+}
+
+/*!
+  \brief Returns the number of updates dropped by the \l filter.
+ */
+qint64 MessageFeedRelay::filteredCount() const
+{
+  return m_filteredCount;
+}
+
+/*!
+  \internal
+ */
+void MessageFeedRelay::relayBatch(const QVector<QByteArray>& data)
+{
+  for (const auto& datagram : data)
+    relay(datagram);
+}
+
+/*!
+  \internal
+  \brief Sends the held updates of the tracks whose allowance has come around.
+ */
+void MessageFeedRelay::sendPending()
+{
+  const qint64 now = m_clock.elapsed();
+  const qint64 interval = minimumInterval();
+
+  // the queue is in arrival order, so a track still waiting keeps its place
+  auto it = m_queuedKeys.begin();
+  while (it != m_queuedKeys.end())
+  {
+    auto trackIt = m_tracks.find(*it);
+    if (trackIt == m_tracks.end())
+    {
+      it = m_queuedKeys.erase(it);
+      continue;
+    }
+
+    Track& track = trackIt.value();
+    if (now - track.m_lastSentTime < interval)
+    {
+      ++it;
+      continue;
+    }
+
+    track.m_queued = false;
+    send(*it, track, now);
+    it = m_queuedKeys.erase(it);
+  }
+
+  if (m_queuedKeys.isEmpty())
+    m_sendTimer->stop();
+}
+
+/*!
+  \internal
+  \brief Sends the held update of \a track, with \a key, at \a now unless the filter
+  rejects it.
+ */
+void MessageFeedRelay::send(const QString& key, Track& track, qint64 now)
+{
+  const QByteArray data = track.m_pending;
+  track.m_pending.clear();
+  if (data.isEmpty())
+    return;
+
+  // only the updates which are sent are decoded to be filtered
+  if (m_filter.isEnabled() && !m_filter.accepts(Message::create(data)))
+  {
+    ++m_filteredCount;
+    return;
+  }
+
+  track.m_lastSent = data;
+  track.m_lastSentTime = now;
+  ++m_relayedCount;
+
+  OutboundTransport::SendOptions options;
+  options.m_priority = OutboundTransport::Priority::Routine;
+  options.m_coalesceKey = key;
+  OutboundTransport::instance()->send(m_transport, m_port, data, options);
+}
+
+/*!
+  \internal
+  \brief Forgets the tracks which have not been heard for a while.
+ */
+void MessageFeedRelay::pruneTracks()
+{
+  const qint64 now = m_clock.elapsed();
+  for (auto it = m_tracks.begin(); it != m_tracks.end();)
+  {
+    if (!it.value().m_queued && now - it.value().m_lastReceivedTime > s_trackTimeout)
+      it = m_tracks.erase(it);
+    else
+      ++it;
+  }
+}
+
+/*!
+  \internal
+  \brief Returns the shortest time between the updates of a track, in ms.
+ */
+qint64 MessageFeedRelay::minimumInterval() const
+{
+  return m_maximumRate > 0.0 ? static_cast<qint64>(1000.0 / m_maximumRate) : 0;
+}
+
+} // Dsa
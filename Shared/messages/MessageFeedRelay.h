@@ -0,0 +1,104 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+
+#ifndef MESSAGEFEEDRELAY_H
+#define MESSAGEFEEDRELAY_H
+
+// dsa app headers
+#include "MessageIngestFilter.h"
+#include "UdpTransport.h"
+
+// Qt headers
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+class QTimer;
+
+namespace Dsa {
+
+class DataListener;
+
+class MessageFeedRelay : public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit MessageFeedRelay(QObject* parent = nullptr);
+  ~MessageFeedRelay();
+
+  bool start(const UdpTransport& transport, quint16 port);
+  quint16 port() const;
+
+  double maximumRate() const;
+  void setMaximumRate(double maximumRate);
+
+  MessageIngestFilter filter() const;
+  void setFilter(const MessageIngestFilter& filter);
+
+  void addDataListener(DataListener* dataListener);
+  void relay(const QByteArray& data);
+
+  qint64 relayedCount() const;
+  qint64 duplicateCount() const;
+  qint64 coalescedCount() const;
+  qint64 filteredCount() const;
+
+private:
+  Q_DISABLE_COPY(MessageFeedRelay)
+
+  struct Track
+  {
+    QByteArray m_pending;
+    QByteArray m_lastSent;
+    qint64 m_lastSentTime = 0;
+    qint64 m_lastReceivedTime = 0;
+    bool m_queued = false;
+  };
+
+  void relayBatch(const QVector<QByteArray>& data);
+  void sendPending();
+  void send(const QString& key, Track& track, qint64 now);
+  void pruneTracks();
+  qint64 minimumInterval() const;
+
+  UdpTransport m_transport;
+  quint16 m_port = 0;
+  double m_maximumRate = 1.0;
+  MessageIngestFilter m_filter;
+
+  // the latest update of each track, keyed by message type and id
+  QHash<QString, Track> m_tracks;
+  // tracks holding an update which is waiting for the rate allowance, in arrival order
+  QList<QString> m_queuedKeys;
+  QElapsedTimer m_clock;
+  QTimer* m_sendTimer = nullptr;
+  QTimer* m_pruneTimer = nullptr;
+
+  qint64 m_relayedCount = 0;
+  qint64 m_duplicateCount = 0;
+  qint64 m_coalescedCount = 0;
+  qint64 m_filteredCount = 0;
+};
+
+} // Dsa
+
+#endif // MESSAGEFEEDRELAY_H
@@ -0,0 +1,712 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "MessageFeedStats.h"
+
+// dsa app headers
+#include "LatencyProbe.h"
+#include "Message.h"
+
+// Qt headers
+#include <QElapsedTimer>
+#include <QTimer>
+
+namespace Dsa {
+
+namespace {
+// upper bounds, in milliseconds, of the latency histogram buckets. A final
+// bucket holds all latencies above the last bound
+const QVector<int> s_latencyBucketBounds{1, 5, 10, 50, 100, 500, 1000};
+
+// interval at which the message rate is computed and statsChanged is emitted
+constexpr int s_updateInterval = 1000;
+
+constexpr double s_nsecsPerMsec = 1000000.0;
+
+constexpr int s_probeStageCount = 4;
+
+// applied probes wait this long, in ns, for an alert evaluation before they are forgotten
+constexpr qint64 s_alertProbeTimeout = 10000000000LL;
+constexpr int s_maximumPendingAlertProbes = 256;
+
+// the stats with applied probes, which are resolved by alert evaluations
+QVector<MessageFeedStats*> s_alertProbeStats;
+
+int latencyBucket(qint64 latencyNsecs)
+{
+  const double latencyMsecs = latencyNsecs / s_nsecsPerMsec;
+  int bucket = 0;
+  while (bucket < s_latencyBucketBounds.size() && latencyMsecs >= s_latencyBucketBounds.at(bucket))
+    ++bucket;
+
+  return bucket;
+}
+
+// returns the offset, in ns, from a timestamp to the time since the epoch
+qint64 epochOffset()
+{
+  static const qint64 offset = LatencyProbe::currentTime() * 1000000LL - MessageFeedStats::timestamp();
+  return offset;
+}
+}
+
+/*!
+  \class Dsa::MessageFeedStats
+  \inmodule Dsa
+  \inherits QObject
+  \brief Collects ingest statistics for message feeds.
+
+  Counters cover data which is received, dropped before decoding, fails to decode,
+  is rejected by an overlay, is superseded while coalescing and is finally applied to
+  the graphics of an overlay. The latency from the data being received to the message
+  being applied to a graphic is recorded in a histogram.
+
+  Messages stamped by a \l LatencyProbe are also timed through every stage of the
+  pipeline, in the \l probeHistogram of each \l ProbeStage: from being sent to being
+  received, and from being received to being decoded, to being applied and to the
+  first alert evaluation scheduled after being applied. The sequence numbers of
+  the stamps give the \l probeLostCount and \l probeOutOfOrderCount.
+
+  To avoid signal storms under load, \l statsChanged is emitted at most once per second.
+ */
+
+/*!
+  \brief Constructor taking an optional \a parent.
+ */
+MessageFeedStats::MessageFeedStats(QObject* parent) :
+  QObject(parent),
+  m_updateTimer(new QTimer(this)),
+  m_latencyHistogram(s_latencyBucketBounds.size() + 1, 0),
+  m_probeLatencies(s_probeStageCount),
+  m_lastRateTimestamp(timestamp())
+{
+  for (LatencyRecord& record : m_probeLatencies)
+    record.m_histogram.fill(0, s_latencyBucketBounds.size() + 1);
+
+  connect(m_updateTimer, &QTimer::timeout, this, &MessageFeedStats::updateRate);
+  m_updateTimer->start(s_updateInterval);
+}
+
+/*!
+  \brief Destructor.
+ */
+MessageFeedStats::~MessageFeedStats()
+{
+  s_alertProbeStats.removeOne(this);
+}
+
+/*!
+  \brief Returns a monotonic timestamp in nanoseconds which can be used to record latencies.
+
+  This method is thread-safe.
+ */
+qint64 MessageFeedStats::timestamp()
+{
+  static QElapsedTimer clock = []
+  {
+    QElapsedTimer timer;
+    timer.start();
+    return timer;
+  }();
+
+  return clock.nsecsElapsed();
+}
+
+/*!
+  \brief Returns the upper bounds, in milliseconds, of the buckets in \l latencyHistogram.
+
+  The histogram contains one more bucket than there are bounds, for all latencies
+  above the last bound.
+ */
+QVariantList MessageFeedStats::latencyHistogramBuckets()
+{
+  QVariantList buckets;
+  for (const int bound : s_latencyBucketBounds)
+    buckets.append(bound);
+
+  return buckets;
+}
+
+/*!
+  \property MessageFeedStats::receivedCount
+  \brief Returns the number of messages or datagrams received.
+ */
+qint64 MessageFeedStats::receivedCount() const
+{
+  return m_receivedCount;
+}
+
+/*!
+  \property MessageFeedStats::droppedCount
+  \brief Returns the number of datagrams dropped before decoding because the
+  decode queue was full.
+ */
+qint64 MessageFeedStats::droppedCount() const
+{
+  return m_droppedCount;
+}
+
+/*!
+  \property MessageFeedStats::socketDroppedCount
+  \brief Returns the number of datagrams dropped by the OS, or while waiting for
+  the UI thread, before they reached a data listener.
+
+  The count covers the lifetime of the sockets and is not cleared by \l reset.
+  Only listeners fed by a UdpReceiver report these drops.
+ */
+qint64 MessageFeedStats::socketDroppedCount() const
+{
+  return m_socketDroppedCount;
+}
+
+/*!
+  \property MessageFeedStats::decodeFailureCount
+  \brief Returns the number of datagrams which could not be decoded as a message.
+ */
+qint64 MessageFeedStats::decodeFailureCount() const
+{
+  return m_decodeFailureCount;
+}
+
+/*!
+  \property MessageFeedStats::rejectedCount
+  \brief Returns the number of messages rejected by the overlay.
+ */
+qint64 MessageFeedStats::rejectedCount() const
+{
+  return m_rejectedCount;
+}
+
+/*!
+  \property MessageFeedStats::coalescedCount
+  \brief Returns the number of messages superseded by a newer message
+  for the same ID before being applied.
+ */
+qint64 MessageFeedStats::coalescedCount() const
+{
+  return m_coalescedCount;
+}
+
+/*!
+  \property MessageFeedStats::appliedCount
+  \brief Returns the number of messages applied to the graphics of the overlay.
+ */
+qint64 MessageFeedStats::appliedCount() const
+{
+  return m_appliedCount;
+}
+
+/*!
+  \property MessageFeedStats::suppressedCount
+  \brief Returns the number of applied messages which were identical to the
+  previous update of their graphic, so the graphic was not written to.
+ */
+qint64 MessageFeedStats::suppressedCount() const
+{
+  return m_suppressedCount;
+}
+
+/*!
+  \property MessageFeedStats::outOfOrderCount
+  \brief Returns the number of messages dropped because a newer message for the
+  same ID had already been applied or queued.
+ */
+qint64 MessageFeedStats::outOfOrderCount() const
+{
+  return m_outOfOrderCount;
+}
+
+/*!
+  \property MessageFeedStats::messagesPerSecond
+  \brief Returns the rate at which messages were received over the last second.
+ */
+double MessageFeedStats::messagesPerSecond() const
+{
+  return m_messagesPerSecond;
+}
+
+/*!
+  \property MessageFeedStats::averageDecodeLatency
+  \brief Returns the average time, in milliseconds, which it took to decode a message.
+ */
+double MessageFeedStats::averageDecodeLatency() const
+{
+  const qint64 count = m_decodedCount + m_decodeFailureCount;
+  if (count == 0)
+    return 0.0;
+
+  return m_totalDecodeNsecs / s_nsecsPerMsec / count;
+}
+
+/*!
+  \property MessageFeedStats::averageDecodeAllocations
+  \brief Returns the average number of heap allocations made to decode a message.
+
+  This is \c 0 unless allocations are counted.
+
+  \sa AllocationCounter
+ */
+double MessageFeedStats::averageDecodeAllocations() const
+{
+  const qint64 count = m_decodedCount + m_decodeFailureCount;
+  if (count == 0)
+    return 0.0;
+
+  return static_cast<double>(m_decodeAllocationCount) / count;
+}
+
+/*!
+  \property MessageFeedStats::averageLatency
+  \brief Returns the average time, in milliseconds, from receiving a message
+  to applying it to a graphic.
+ */
+double MessageFeedStats::averageLatency() const
+{
+  if (m_latencyCount == 0)
+    return 0.0;
+
+  return m_totalLatencyNsecs / s_nsecsPerMsec / m_latencyCount;
+}
+
+/*!
+  \property MessageFeedStats::maximumLatency
+  \brief Returns the maximum time, in milliseconds, from receiving a message
+  to applying it to a graphic.
+ */
+double MessageFeedStats::maximumLatency() const
+{
+  return m_maximumLatencyNsecs / s_nsecsPerMsec;
+}
+
+/*!
+  \property MessageFeedStats::latencyHistogram
+  \brief Returns the number of messages in each latency bucket.
+
+  \sa latencyHistogramBuckets
+ */
+QVariantList MessageFeedStats::latencyHistogram() const
+{
+  QVariantList histogram;
+  for (const qint64 count : m_latencyHistogram)
+    histogram.append(count);
+
+  return histogram;
+}
+
+/*!
+  \property MessageFeedStats::probeCount
+  \brief Returns the number of messages received with a \l LatencyProbe stamp.
+ */
+qint64 MessageFeedStats::probeCount() const
+{
+  return m_probeCount;
+}
+
+/*!
+  \property MessageFeedStats::probeLostCount
+  \brief Returns the number of stamped messages missing from the sequences of their senders.
+
+  A gap in a sequence is counted as lost until the missing messages arrive late.
+ */
+qint64 MessageFeedStats::probeLostCount() const
+{
+  return m_probeLostCount;
+}
+
+/*!
+  \property MessageFeedStats::probeOutOfOrderCount
+  \brief Returns the number of stamped messages which arrived after a later message
+  in the sequence of their sender, including duplicates.
+ */
+qint64 MessageFeedStats::probeOutOfOrderCount() const
+{
+  return m_probeOutOfOrderCount;
+}
+
+/*!
+  \brief Returns the number of stamped messages in each latency bucket of \a stage.
+
+  The stages are timed from the message being received, except for
+  \c ProbeStage::Arrival which is timed from the message being sent. Latencies
+  between devices include the difference of their clocks, and negative latencies
+  are counted in the first bucket.
+
+  \sa latencyHistogramBuckets
+ */
+QVariantList MessageFeedStats::probeHistogram(ProbeStage stage) const
+{
+  QVariantList histogram;
+  for (const qint64 count : m_probeLatencies.at(static_cast<int>(stage)).m_histogram)
+    histogram.append(count);
+
+  return histogram;
+}
+
+/*!
+  \brief Returns the average latency, in milliseconds, of stamped messages at \a stage.
+
+  \sa probeHistogram
+ */
+double MessageFeedStats::probeAverageLatency(ProbeStage stage) const
+{
+  const LatencyRecord& record = m_probeLatencies.at(static_cast<int>(stage));
+  if (record.m_count == 0)
+    return 0.0;
+
+  return record.m_totalNsecs / s_nsecsPerMsec / record.m_count;
+}
+
+/*!
+  \brief Returns the maximum latency, in milliseconds, of stamped messages at \a stage.
+
+  \sa probeHistogram
+ */
+double MessageFeedStats::probeMaximumLatency(ProbeStage stage) const
+{
+  return m_probeLatencies.at(static_cast<int>(stage)).m_maximumNsecs / s_nsecsPerMsec;
+}
+
+/*!
+  \brief Records that \a count messages or datagrams were received.
+ */
+void MessageFeedStats::recordReceived(int count)
+{
+  m_receivedCount += count;
+  m_changed = true;
+}
+
+/*!
+  \brief Records that \a count datagrams were dropped before decoding.
+ */
+void MessageFeedStats::recordDropped(int count)
+{
+  m_droppedCount += count;
+  m_changed = true;
+}
+
+/*!
+  \brief Sets the total \a socketDroppedCount reported by the data listeners.
+ */
+void MessageFeedStats::setSocketDroppedCount(qint64 socketDroppedCount)
+{
+  if (m_socketDroppedCount == socketDroppedCount)
+    return;
+
+  m_socketDroppedCount = socketDroppedCount;
+  m_changed = true;
+}
+
+/*!
+  \brief Records that \a count messages were rejected.
+ */
+void MessageFeedStats::recordRejected(int count)
+{
+  m_rejectedCount += count;
+  m_changed = true;
+}
+
+/*!
+  \brief Records that \a count messages were superseded while coalescing.
+ */
+void MessageFeedStats::recordCoalesced(int count)
+{
+  m_coalescedCount += count;
+  m_changed = true;
+}
+
+/*!
+  \brief Records that a message which was received at \a receivedTimestamp has been applied.
+
+  The \a receivedTimestamp should be obtained from \l timestamp. If it is \c 0, only
+  the applied count is updated.
+ */
+void MessageFeedStats::recordApplied(qint64 receivedTimestamp)
+{
+  ++m_appliedCount;
+  m_changed = true;
+
+  if (receivedTimestamp <= 0)
+    return;
+
+  const qint64 latencyNsecs = timestamp() - receivedTimestamp;
+  ++m_latencyCount;
+  m_totalLatencyNsecs += latencyNsecs;
+  m_maximumLatencyNsecs = qMax(m_maximumLatencyNsecs, latencyNsecs);
+
+  ++m_latencyHistogram[latencyBucket(latencyNsecs)];
+}
+
+/*!
+  \brief Records that \a count applied messages did not change their graphics.
+ */
+void MessageFeedStats::recordSuppressed(int count)
+{
+  m_suppressedCount += count;
+  m_changed = true;
+}
+
+/*!
+  \brief Records that \a count messages were older than the latest message for their ID.
+ */
+void MessageFeedStats::recordOutOfOrder(int count)
+{
+  m_outOfOrderCount += count;
+  m_changed = true;
+}
+
+/*!
+  \brief Sets the totals reported by the decoder: the \a decodedCount, the \a decodeFailureCount,
+  the \a totalDecodeNsecs spent decoding and the \a decodeAllocationCount made while decoding.
+ */
+void MessageFeedStats::setDecodeStatistics(qint64 decodedCount, qint64 decodeFailureCount, qint64 totalDecodeNsecs,
+                                           qint64 decodeAllocationCount)
+{
+  if (m_decodedCount == decodedCount && m_decodeFailureCount == decodeFailureCount)
+    return;
+
+  m_decodedCount = decodedCount;
+  m_decodeFailureCount = decodeFailureCount;
+  m_totalDecodeNsecs = totalDecodeNsecs;
+  m_decodeAllocationCount = decodeAllocationCount;
+  m_changed = true;
+}
+
+/*!
+  \brief Records the arrival and decode latencies of the stamped \a message, which
+  has been received by a feed, and checks its place in the sequence of its sender.
+ */
+void MessageFeedStats::recordProbeReceived(const Message& message)
+{
+  const LatencyProbe::Stamp probe = message.latencyProbe();
+  if (!probe.isValid())
+    return;
+
+  ++m_probeCount;
+  m_changed = true;
+
+  auto it = m_probeNextSequences.find(probe.m_source);
+  if (it == m_probeNextSequences.end())
+  {
+    m_probeNextSequences.insert(probe.m_source, probe.m_sequence + 1);
+  }
+  else if (probe.m_sequence >= it.value())
+  {
+    m_probeLostCount += probe.m_sequence - it.value();
+    it.value() = probe.m_sequence + 1;
+  }
+  else
+  {
+    // a late message fills a gap which was counted as lost
+    ++m_probeOutOfOrderCount;
+    if (m_probeLostCount > 0)
+      --m_probeLostCount;
+  }
+
+  const qint64 receivedTimestamp = message.receivedTimestamp();
+  if (receivedTimestamp <= 0)
+    return;
+
+  recordProbeLatency(ProbeStage::Arrival, receivedTimestamp + epochOffset() - probe.m_sentTime * 1000000LL);
+  if (message.decodedTimestamp() > 0)
+    recordProbeLatency(ProbeStage::Decode, message.decodedTimestamp() - receivedTimestamp);
+}
+
+/*!
+  \brief Records the apply latency of the stamped \a message, which has been applied
+  to a graphic, and waits for the next alert evaluation to record its alert latency.
+
+  This method must be called on the UI thread.
+ */
+void MessageFeedStats::recordProbeApplied(const Message& message)
+{
+  const qint64 receivedTimestamp = message.receivedTimestamp();
+  if (!message.hasLatencyProbe() || receivedTimestamp <= 0)
+    return;
+
+  const qint64 now = timestamp();
+  recordProbeLatency(ProbeStage::Apply, now - receivedTimestamp);
+
+  if (m_pendingAlertProbes.size() >= s_maximumPendingAlertProbes)
+    m_pendingAlertProbes.removeFirst();
+
+  PendingAlertProbe pending;
+  pending.m_appliedTimestamp = now;
+  pending.m_receivedTimestamp = receivedTimestamp;
+  m_pendingAlertProbes.append(pending);
+
+  if (!s_alertProbeStats.contains(this))
+    s_alertProbeStats.append(this);
+}
+
+/*!
+  \brief Records that an alert evaluation, which was scheduled at \a scheduledTimestamp,
+  has completed.
+
+  The alert latency is recorded for every stamped message applied before the
+  evaluation was scheduled. This method must be called on the UI thread.
+ */
+void MessageFeedStats::recordAlertsEvaluated(qint64 scheduledTimestamp)
+{
+  if (s_alertProbeStats.isEmpty())
+    return;
+
+  const qint64 now = timestamp();
+  for (MessageFeedStats* stats : qAsConst(s_alertProbeStats))
+    stats->resolveAlertProbes(scheduledTimestamp, now);
+}
+
+/*!
+  \brief Returns a single line summary of the statistics, suitable for logging.
+ */
+QString MessageFeedStats::summary() const
+{
+  return QString("%1 msgs/s, received %2, dropped %3, decode failures %4, rejected %5, coalesced %6, applied %7, "
+                 "decode %8 ms, latency avg %9 ms max %10 ms, socket dropped %11, suppressed %12, out of order %13, "
+                 "decode allocations %14")
+      .arg(QString::number(m_messagesPerSecond, 'f', 1),
+           QString::number(m_receivedCount),
+           QString::number(m_droppedCount),
+           QString::number(m_decodeFailureCount),
+           QString::number(m_rejectedCount),
+           QString::number(m_coalescedCount),
+           QString::number(m_appliedCount),
+           QString::number(averageDecodeLatency(), 'f', 3),
+           QString::number(averageLatency(), 'f', 3))
+      .arg(QString::number(maximumLatency(), 'f', 3),
+           QString::number(m_socketDroppedCount),
+           QString::number(m_suppressedCount),
+           QString::number(m_outOfOrderCount),
+           QString::number(averageDecodeAllocations(), 'f', 1)) +
+      (m_probeCount == 0 ? QString() :
+                           QString(", probes %1, probes lost %2, probes out of order %3, "
+                                   "probe arrival %4 ms decode %5 ms apply %6 ms alert %7 ms")
+                           .arg(QString::number(m_probeCount),
+                                QString::number(m_probeLostCount),
+                                QString::number(m_probeOutOfOrderCount),
+                                QString::number(probeAverageLatency(ProbeStage::Arrival), 'f', 3),
+                                QString::number(probeAverageLatency(ProbeStage::Decode), 'f', 3),
+                                QString::number(probeAverageLatency(ProbeStage::Apply), 'f', 3),
+                                QString::number(probeAverageLatency(ProbeStage::AlertEvaluation), 'f', 3)));
+}
+
+/*!
+  \brief Resets all of the statistics.
+ */
+void MessageFeedStats::reset()
+{
+  m_receivedCount = 0;
+  m_droppedCount = 0;
+  m_rejectedCount = 0;
+  m_coalescedCount = 0;
+  m_appliedCount = 0;
+  m_suppressedCount = 0;
+  m_outOfOrderCount = 0;
+  m_latencyCount = 0;
+  m_totalLatencyNsecs = 0;
+  m_maximumLatencyNsecs = 0;
+  m_latencyHistogram.fill(0);
+  m_probeCount = 0;
+  m_probeLostCount = 0;
+  m_probeOutOfOrderCount = 0;
+  m_probeNextSequences.clear();
+  for (LatencyRecord& record : m_probeLatencies)
+  {
+    record.m_count = 0;
+    record.m_totalNsecs = 0;
+    record.m_maximumNsecs = 0;
+    record.m_histogram.fill(0);
+  }
+  m_pendingAlertProbes.clear();
+  m_lastReceivedCount = 0;
+  m_lastRateTimestamp = timestamp();
+  m_messagesPerSecond = 0.0;
+
+  emit statsChanged();
+}
+
+/*!
+  \internal
+ */
+void MessageFeedStats::updateRate()
+{
+  const qint64 now = timestamp();
+  const qint64 elapsed = now - m_lastRateTimestamp;
+  if (elapsed <= 0)
+    return;
+
+  // probes of feeds without alert conditions are never resolved
+  int expired = 0;
+  while (expired < m_pendingAlertProbes.size() &&
+         now - m_pendingAlertProbes.at(expired).m_appliedTimestamp > s_alertProbeTimeout)
+  {
+    ++expired;
+  }
+  m_pendingAlertProbes.remove(0, expired);
+
+  const double rate = (m_receivedCount - m_lastReceivedCount) * 1000000000.0 / elapsed;
+  m_lastReceivedCount = m_receivedCount;
+  m_lastRateTimestamp = now;
+
+  if (!m_changed && qFuzzyCompare(rate + 1.0, m_messagesPerSecond + 1.0))
+    return;
+
+  m_messagesPerSecond = rate;
+  m_changed = false;
+
+  emit statsChanged();
+}
+
+/*!
+  \internal
+ */
+void MessageFeedStats::recordProbeLatency(ProbeStage stage, qint64 latencyNsecs)
+{
+  LatencyRecord& record = m_probeLatencies[static_cast<int>(stage)];
+  latencyNsecs = qMax<qint64>(latencyNsecs, 0);
+  ++record.m_count;
+  record.m_totalNsecs += latencyNsecs;
+  record.m_maximumNsecs = qMax(record.m_maximumNsecs, latencyNsecs);
+  ++record.m_histogram[latencyBucket(latencyNsecs)];
+  m_changed = true;
+}
+
+/*!
+  \internal
+  \brief Records the alert latency at \a now of the probes applied at or before
+  \a scheduledTimestamp.
+ */
+void MessageFeedStats::resolveAlertProbes(qint64 scheduledTimestamp, qint64 now)
+{
+  int resolved = 0;
+  while (resolved < m_pendingAlertProbes.size() &&
+         m_pendingAlertProbes.at(resolved).m_appliedTimestamp <= scheduledTimestamp)
+  {
+    recordProbeLatency(ProbeStage::AlertEvaluation, now - m_pendingAlertProbes.at(resolved).m_receivedTimestamp);
+    ++resolved;
+  }
+  m_pendingAlertProbes.remove(0, resolved);
+}
+
+} // Dsa
+
+// Signal Documentation
+/*!
+  \fn void MessageFeedStats::statsChanged();
+  \brief Signal emitted, at most once per second, when the statistics change.
+ */
@@ -0,0 +1,173 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef MESSAGEFEEDSTATS_H
+#define MESSAGEFEEDSTATS_H
+
+// Qt headers
+#include <QByteArray>
+#include <QHash>
+#include <QObject>
+#include <QVariantList>
+#include <QVector>
+
+class QTimer;
+
+namespace Dsa {
+
+class Message;
+
+class MessageFeedStats : public QObject
+{
+  Q_OBJECT
+
+  Q_PROPERTY(qint64 receivedCount READ receivedCount NOTIFY statsChanged)
+  Q_PROPERTY(qint64 droppedCount READ droppedCount NOTIFY statsChanged)
+  Q_PROPERTY(qint64 socketDroppedCount READ socketDroppedCount NOTIFY statsChanged)
+  Q_PROPERTY(qint64 decodeFailureCount READ decodeFailureCount NOTIFY statsChanged)
+  Q_PROPERTY(qint64 rejectedCount READ rejectedCount NOTIFY statsChanged)
+  Q_PROPERTY(qint64 coalescedCount READ coalescedCount NOTIFY statsChanged)
+  Q_PROPERTY(qint64 appliedCount READ appliedCount NOTIFY statsChanged)
+  Q_PROPERTY(qint64 suppressedCount READ suppressedCount NOTIFY statsChanged)
+  Q_PROPERTY(qint64 outOfOrderCount READ outOfOrderCount NOTIFY statsChanged)
+  Q_PROPERTY(double messagesPerSecond READ messagesPerSecond NOTIFY statsChanged)
+  Q_PROPERTY(double averageDecodeLatency READ averageDecodeLatency NOTIFY statsChanged)
+  Q_PROPERTY(double averageDecodeAllocations READ averageDecodeAllocations NOTIFY statsChanged)
+  Q_PROPERTY(double averageLatency READ averageLatency NOTIFY statsChanged)
+  Q_PROPERTY(double maximumLatency READ maximumLatency NOTIFY statsChanged)
+  Q_PROPERTY(QVariantList latencyHistogram READ latencyHistogram NOTIFY statsChanged)
+  Q_PROPERTY(qint64 probeCount READ probeCount NOTIFY statsChanged)
+  Q_PROPERTY(qint64 probeLostCount READ probeLostCount NOTIFY statsChanged)
+  Q_PROPERTY(qint64 probeOutOfOrderCount READ probeOutOfOrderCount NOTIFY statsChanged)
+
+public:
+  enum class ProbeStage
+  {
+    Arrival = 0,
+    Decode = 1,
+    Apply = 2,
+    AlertEvaluation = 3
+  };
+
+  Q_ENUM(ProbeStage)
+
+  explicit MessageFeedStats(QObject* parent = nullptr);
+  ~MessageFeedStats();
+
+  static qint64 timestamp();
+  static QVariantList latencyHistogramBuckets();
+
+  qint64 receivedCount() const;
+  qint64 droppedCount() const;
+  qint64 socketDroppedCount() const;
+  qint64 decodeFailureCount() const;
+  qint64 rejectedCount() const;
+  qint64 coalescedCount() const;
+  qint64 appliedCount() const;
+  qint64 suppressedCount() const;
+  qint64 outOfOrderCount() const;
+  double messagesPerSecond() const;
+  double averageDecodeLatency() const;
+  double averageDecodeAllocations() const;
+  double averageLatency() const;
+  double maximumLatency() const;
+  QVariantList latencyHistogram() const;
+
+  qint64 probeCount() const;
+  qint64 probeLostCount() const;
+  qint64 probeOutOfOrderCount() const;
+  Q_INVOKABLE QVariantList probeHistogram(Dsa::MessageFeedStats::ProbeStage stage) const;
+  Q_INVOKABLE double probeAverageLatency(Dsa::MessageFeedStats::ProbeStage stage) const;
+  Q_INVOKABLE double probeMaximumLatency(Dsa::MessageFeedStats::ProbeStage stage) const;
+
+  void recordReceived(int count = 1);
+  void recordDropped(int count = 1);
+  void recordRejected(int count = 1);
+  void recordCoalesced(int count = 1);
+  void recordApplied(qint64 receivedTimestamp);
+  void recordSuppressed(int count = 1);
+  void recordOutOfOrder(int count = 1);
+  void setSocketDroppedCount(qint64 socketDroppedCount);
+  void setDecodeStatistics(qint64 decodedCount, qint64 decodeFailureCount, qint64 totalDecodeNsecs,
+                           qint64 decodeAllocationCount = 0);
+  void recordProbeReceived(const Message& message);
+  void recordProbeApplied(const Message& message);
+
+  static void recordAlertsEvaluated(qint64 scheduledTimestamp);
+
+  Q_INVOKABLE QString summary() const;
+  Q_INVOKABLE void reset();
+
+signals:
+  void statsChanged();
+
+private:
+  Q_DISABLE_COPY(MessageFeedStats)
+
+  struct LatencyRecord
+  {
+    qint64 m_count = 0;
+    qint64 m_totalNsecs = 0;
+    qint64 m_maximumNsecs = 0;
+    QVector<qint64> m_histogram;
+  };
+
+  struct PendingAlertProbe
+  {
+    qint64 m_appliedTimestamp = 0;
+    qint64 m_receivedTimestamp = 0;
+  };
+
+  void updateRate();
+  void recordProbeLatency(ProbeStage stage, qint64 latencyNsecs);
+  void resolveAlertProbes(qint64 scheduledTimestamp, qint64 now);
+
+  QTimer* m_updateTimer = nullptr;
+  bool m_changed = false;
+
+  qint64 m_receivedCount = 0;
+  qint64 m_droppedCount = 0;
+  qint64 m_socketDroppedCount = 0;
+  qint64 m_decodedCount = 0;
+  qint64 m_decodeFailureCount = 0;
+  qint64 m_totalDecodeNsecs = 0;
+  qint64 m_decodeAllocationCount = 0;
+  qint64 m_rejectedCount = 0;
+  qint64 m_coalescedCount = 0;
+  qint64 m_appliedCount = 0;
+  qint64 m_suppressedCount = 0;
+  qint64 m_outOfOrderCount = 0;
+  qint64 m_latencyCount = 0;
+  qint64 m_totalLatencyNsecs = 0;
+  qint64 m_maximumLatencyNsecs = 0;
+  QVector<qint64> m_latencyHistogram;
+
+  // latency probes stamped by the senders
+  qint64 m_probeCount = 0;
+  qint64 m_probeLostCount = 0;
+  qint64 m_probeOutOfOrderCount = 0;
+  QHash<QByteArray, quint32> m_probeNextSequences;
+  QVector<LatencyRecord> m_probeLatencies;
+  QVector<PendingAlertProbe> m_pendingAlertProbes;
+
+  qint64 m_lastReceivedCount = 0;
+  qint64 m_lastRateTimestamp = 0;
+  double m_messagesPerSecond = 0.0;
+};
+
+} // Dsa
+
+#endif // MESSAGEFEEDSTATS_H
@@ -21,15 +21,28 @@
 #include "MessageFeedsController.h"
 
 // dsa app headers
+#include "AllocationCounter.h"
 #include "AppConstants.h"
 #include "DataListener.h"
-#include "DataSender.h"
+#include "DatagramCaptureWriter.h"
 #include "LocationBroadcast.h"
 #include "Message.h"
+#include "MessageClusterOverlay.h"
+#include "MessageDecoderPool.h"
 #include "MessageFeed.h"
+#include "MessageFeedArchive.h"
+#include "MessageFeedCheckpoint.h"
 #include "MessageFeedConstants.h"
+#include "MessageFeedRelay.h"
+#include "MessageFeedStats.h"
 #include "MessageFeedListModel.h"
+#include "MessageFileReplay.h"
+#include "MessageSnapshotSync.h"
+#include "MessageSymbolWarmer.h"
 #include "MessagesOverlay.h"
+#include "TraceRecorder.h"
+#include "TrackReplaySimulator.h"
+#include "UdpTransport.h"
 
 // toolkit headers
 #include "ToolManager.h"
@@ -44,7 +57,9 @@
 // Qt headers
 #include <QFileInfo>
 #include <QJsonArray>
-#include <QUdpSocket>
+#include <QStandardPaths>
+#include <QTcpSocket>
+#include <QTimer>
 
 using namespace Esri::ArcGISRuntime;
 
@@ -52,6 +67,13 @@ namespace Dsa {
 
 const QString MessageFeedsController::RESOURCE_DIRECTORY_PROPERTYNAME = "ResourceDirectory";
 
+namespace {
+// delay before a dropped or refused TCP feed connection is retried, in ms
+constexpr int s_tcpReconnectInterval = 5000;
+// seconds between checkpoints of the feeds' tracks, for recovery after a restart
+constexpr int s_defaultCheckpointInterval = 30;
+}
+
 /*!
   \class Dsa::MessageFeedsController
   \inmodule Dsa
@@ -65,8 +87,21 @@ const QString MessageFeedsController::RESOURCE_DIRECTORY_PROPERTYNAME = "Resourc
 MessageFeedsController::MessageFeedsController(QObject* parent) :
   AbstractTool(parent),
   m_messageFeeds(new MessageFeedListModel(this)),
-  m_locationBroadcast(new LocationBroadcast(this))
+  m_locationBroadcast(new LocationBroadcast(this)),
+  m_messageDecoder(new MessageDecoderPool(this)),
+  m_ingestStats(new MessageFeedStats(this)),
+  m_checkpoint(new MessageFeedCheckpoint(m_messageFeeds, QString("%1/MessageFeedsCheckpoint.dat").arg(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation)), this)),
+  m_archive(new MessageFeedArchive(m_messageFeeds, QString("%1/MessageFeedArchive").arg(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation)), this)),
+  m_symbolWarmer(new MessageSymbolWarmer(QString("%1/MessageSymbols.json").arg(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation)), this))
 {
+  connect(m_messageDecoder, &MessageDecoderPool::messagesDecoded, this, &MessageFeedsController::applyDecodedMessages);
+
+  // the last known tracks are added through the same batch path as decoded messages
+  connect(m_checkpoint, &MessageFeedCheckpoint::restored, this, &MessageFeedsController::applyMessages);
+
+  connect(m_archive, &MessageFeedArchive::seekCompleted, this, &MessageFeedsController::applyPlaybackMessages);
+  connect(m_archive, &MessageFeedArchive::rangeChanged, this, &MessageFeedsController::archiveRangeChanged);
+
   connect(ToolResourceProvider::instance(), &ToolResourceProvider::geoViewChanged, this, [this]
   {
     setGeoView(ToolResourceProvider::instance()->geoView());
@@ -126,24 +161,30 @@ void MessageFeedsController::addDataListener(DataListener* dataListener)
 
   m_dataListeners.append(dataListener);
 
-  connect(dataListener, &DataListener::dataReceived, this, [this](const QByteArray& data)
-  {
-    Message m = Message::create(data);
-    if (m.isEmpty())
-      return;
+  // drain bursts of datagrams with a single signal per readyRead
+  dataListener->setBatchMode(true);
 
-    if (m_locationBroadcast->isEnabled())
-    {
-      if (m_locationBroadcast->message().messageId() == m.messageId()) // do not display our own location broadcast message
-        return;
-    }
+  if (m_captureWriter)
+    dataListener->setCaptureWriter(m_captureWriter);
 
-    MessageFeed* messageFeed = m_messageFeeds->messageFeedByType(m.messageType());
-    if (!messageFeed)
-      return;
+  // each listener decodes on its own shard, so the updates of a track stay in order
+  const uint shardKey = m_nextShardKey++;
+
+  connect(dataListener, &DataListener::dataReceived, this, [this, shardKey](const QByteArray& data)
+  {
+    processData(data, shardKey);
+  });
+
+  connect(dataListener, &DataListener::dataReceivedBatch, this, [this, shardKey](const QVector<QByteArray>& data)
+  {
+    for (const auto& datagram : data)
+      processData(datagram, shardKey);
 
-    messageFeed->messagesOverlay()->addMessage(m);
+    updateSocketDroppedCount();
   });
+
+  if (m_relay)
+    m_relay->addDataListener(dataListener);
 }
 
 /*!
@@ -161,6 +202,168 @@ void MessageFeedsController::removeDataListener(DataListener* dataListener)
   m_dataListeners.removeOne(dataListener);
 
   disconnect(dataListener, &DataListener::dataReceived, this, nullptr);
+  disconnect(dataListener, &DataListener::dataReceivedBatch, this, nullptr);
+
+  if (m_relay)
+    disconnect(dataListener, nullptr, m_relay, nullptr);
+}
+
+/*!
+  \internal
+  \brief Reports the datagrams dropped by the sockets of all data listeners.
+ */
+void MessageFeedsController::updateSocketDroppedCount()
+{
+  qint64 droppedCount = 0;
+  for (const DataListener* dataListener : qAsConst(m_dataListeners))
+    droppedCount += dataListener->droppedCount();
+
+  m_ingestStats->setSocketDroppedCount(droppedCount);
+}
+
+/*!
+  \internal
+  \brief Queues the received \a data to be decoded off the UI thread by the
+  decoder shard for \a shardKey.
+ */
+void MessageFeedsController::processData(const QByteArray& data, uint shardKey)
+{
+  DSA_TRACE_SCOPE("MessageFeedsController::processData");
+  DSA_ALLOCATION_SCOPE(Messages);
+
+  m_ingestStats->recordReceived();
+
+  if (!m_messageDecoder->enqueue(data, MessageFeedStats::timestamp(), shardKey))
+    m_ingestStats->recordDropped();
+}
+
+/*!
+  \internal
+  \brief Adds the messages which have been decoded to the overlays of the
+  matching message feeds.
+ */
+void MessageFeedsController::applyDecodedMessages()
+{
+  const auto messages = m_messageDecoder->takeMessages();
+  m_ingestStats->setDecodeStatistics(m_messageDecoder->decodedCount(),
+                                     m_messageDecoder->decodeFailureCount(),
+                                     m_messageDecoder->totalDecodeNsecs(),
+                                     m_messageDecoder->decodeAllocationCount());
+
+  applyMessages(messages);
+}
+
+/*!
+  \internal
+  \brief Adds \a messages to the overlays of the matching message feeds.
+
+  The messages are recorded in the \l archive. During playback they are only
+  recorded, as the overlays show a past state.
+ */
+void MessageFeedsController::applyMessages(const QList<Message>& messages)
+{
+  DSA_TRACE_SCOPE("MessageFeedsController::applyMessages");
+  DSA_ALLOCATION_SCOPE(Messages);
+
+  // group the messages by feed so each overlay receives a single block
+  QHash<MessagesOverlay*, QList<Message>> messagesByOverlay;
+  QList<Message> acceptedMessages;
+
+  for (const auto& m : messages)
+  {
+    if (m_locationBroadcast->isEnabled())
+    {
+      if (m_locationBroadcast->message().messageId() == m.messageId()) // do not display our own location broadcast message
+        continue;
+    }
+
+    MessageFeed* messageFeed = m_messageFeeds->messageFeedByType(m.messageType());
+    if (!messageFeed)
+      continue;
+
+    MessagesOverlay* overlay = messageFeed->messagesOverlay();
+    overlay->stats()->recordReceived();
+    if (m.hasLatencyProbe())
+      overlay->stats()->recordProbeReceived(m);
+
+    // reject messages of no interest before any graphic work
+    if (m_ingestFilter.isEnabled() && !m_ingestFilter.accepts(m))
+    {
+      overlay->stats()->recordRejected();
+      continue;
+    }
+
+    messagesByOverlay[overlay].append(m);
+    acceptedMessages.append(m);
+  }
+
+  m_archive->record(acceptedMessages);
+
+  if (m_playbackActive)
+  {
+    // the live state returned to is missing the messages received since it was read from the archive
+    if (m_liveSeekTime != -1)
+      m_heldMessages.append(acceptedMessages);
+
+    return;
+  }
+
+  for (auto it = messagesByOverlay.cbegin(); it != messagesByOverlay.cend(); ++it)
+    it.key()->addMessages(it.value());
+}
+
+/*!
+  \internal
+  \brief Replaces the tracks of the feeds with \a messages, the state of the
+  \l archive at \a msecsSinceEpoch.
+
+  When the state is the one returning to live, the messages held while it was
+  read are applied after it and playback ends.
+ */
+void MessageFeedsController::applyPlaybackMessages(qint64 msecsSinceEpoch, const QList<Message>& messages)
+{
+  if (!m_playbackActive)
+    return;
+
+  const bool returningToLive = msecsSinceEpoch == m_liveSeekTime;
+
+  // the held messages are in the archive already, so they go straight to the overlays
+  QHash<MessagesOverlay*, QList<Message>> messagesByOverlay;
+  auto addToOverlays = [this, &messagesByOverlay](const QList<Message>& feedMessages)
+  {
+    for (const auto& message : feedMessages)
+    {
+      MessageFeed* messageFeed = m_messageFeeds->messageFeedByType(message.messageType());
+      if (messageFeed)
+        messagesByOverlay[messageFeed->messagesOverlay()].append(message);
+    }
+  };
+
+  addToOverlays(messages);
+  if (returningToLive)
+    addToOverlays(m_heldMessages);
+
+  for (int i = 0; i < m_messageFeeds->count(); ++i)
+  {
+    MessagesOverlay* overlay = m_messageFeeds->at(i)->messagesOverlay();
+    overlay->clear();
+    overlay->addMessages(messagesByOverlay.value(overlay));
+  }
+
+  if (!returningToLive)
+  {
+    m_playbackTime = msecsSinceEpoch;
+    emit playbackTimeChanged();
+    return;
+  }
+
+  m_playbackActive = false;
+  m_liveSeekTime = -1;
+  m_heldMessages.clear();
+  m_archive->setKeyframesPaused(false);
+  m_checkpoint->setInterval(m_checkpointInterval);
+
+  emit playbackActiveChanged();
 }
 
 /*!
@@ -192,8 +395,46 @@ void MessageFeedsController::setupFeeds()
     const auto surfacePlacement = messageFeedJsonObject[MessageFeedConstants::MESSAGE_FEEDS_PLACEMENT].toString();
 
     MessagesOverlay* overlay = new MessagesOverlay(m_geoView, createRenderer(rendererInfo, this), feedType, toSurfacePlacement(surfacePlacement), this);
+    overlay->setCoalescingUpdates(true);
+
+    // optionally sample the ground elevation once per position instead of draping every frame
+    overlay->setGroundElevationResolved(surfacePlacement.compare(QStringLiteral("ground"), Qt::CaseInsensitive) == 0);
+
+    // optionally expire tracks which stop reporting, fading them first
+    overlay->setTimeToLive(messageFeedJsonObject[MessageFeedConstants::MESSAGE_FEEDS_TIME_TO_LIVE].toInt());
+    overlay->setFadeAge(messageFeedJsonObject[MessageFeedConstants::MESSAGE_FEEDS_FADE_AGE].toInt());
+
+    // optionally draw the tracks as count symbols when zoomed out
+    const double clusterScale = messageFeedJsonObject[MessageFeedConstants::MESSAGE_FEEDS_CLUSTER_SCALE].toDouble();
+    if (clusterScale > 0.0)
+    {
+      overlay->setClusterScale(clusterScale);
+      if (messageFeedJsonObject.contains(MessageFeedConstants::MESSAGE_FEEDS_CLUSTER_CELL_SIZE))
+        overlay->clusterOverlay()->setCellSize(messageFeedJsonObject[MessageFeedConstants::MESSAGE_FEEDS_CLUSTER_CELL_SIZE].toInt());
+    }
+
+    // optionally draw the recent positions of each track as a trail
+    overlay->setTrailLength(messageFeedJsonObject[MessageFeedConstants::MESSAGE_FEEDS_TRAIL_LENGTH].toInt());
+
+    // optionally only draw the tracks near the view, still alerting on all of them
+    overlay->setInterestManaged(messageFeedJsonObject[MessageFeedConstants::MESSAGE_FEEDS_INTEREST_MANAGED].toBool());
+
+    // optionally draw large feeds of mostly static objects in static mode
+    overlay->setRenderingPolicy(MessagesOverlay::toRenderingPolicy(messageFeedJsonObject[MessageFeedConstants::MESSAGE_FEEDS_RENDERING_MODE].toString()));
+
+    // generate the symbols seen in earlier sessions before the feed delivers them
+    if (overlay->renderer() && overlay->renderer()->rendererType() == RendererType::DictionaryRenderer)
+      m_symbolWarmer->addOverlay(overlay, rendererInfo.toLower());
+
     MessageFeed* feed = new MessageFeed(feedName, feedType, overlay, this);
 
+    // optionally stop decoding the feed while it is hidden, catching up when it is shown
+    feed->setSuspendedWhenHidden(messageFeedJsonObject[MessageFeedConstants::MESSAGE_FEEDS_SUSPEND_WHEN_HIDDEN].toBool());
+    connect(feed, &MessageFeed::suspendedChanged, this, [this, feed]()
+    {
+      m_messageDecoder->setSuspended(feed->feedMessageType(), feed->isSuspended());
+    });
+
     if (!rendererThumbnail.isEmpty())
     {
       if (QFile::exists(QString(":/Resources/icons/xhdpi/message/%1").arg(rendererThumbnail)))
@@ -209,6 +450,16 @@ void MessageFeedsController::setupFeeds()
 
   // only needs to be cached until the geoView is ready
   m_messageFeedProperties.clear();
+
+  if (m_messageFeeds->isEmpty())
+    return;
+
+  // show the last known tracks at once, then fill the new feeds from a peer
+  // rather than waiting for every track to report
+  m_checkpoint->restore();
+
+  if (m_snapshotSync)
+    m_snapshotSync->requestSnapshot();
 }
 
 /*!
@@ -218,9 +469,32 @@ void MessageFeedsController::setupFeeds()
   \list
     \li \c ResourceDirectory - The resource directory where symbol style files are located.
     \li \c MessageFeedUdpPorts - The UDP ports for listening to message feeds.
+    \li \c MessageFeedTcpServers - The \c host:port of TCP servers, such as TAK servers,
+        streaming CoT events to the message feeds.
+    \li \c MessageFeedSnapshotPort - The UDP port on which snapshots of the message feeds
+        are requested from peers at startup and served to peers; see \l MessageSnapshotSync.
+    \li \c MessageFeedCheckpointInterval - The seconds between checkpoints of the tracks
+        of the message feeds, which are restored when the app starts; \c 0 disables
+        checkpoints. The default is 30; see \l MessageFeedCheckpoint.
+    \li \c MessageFeedArchiveRetention - The hours of updates to the message feeds kept
+        in an archive for playback; \c 0, the default, disables the archive. See
+        \l MessageFeedArchive.
+    \li \c MessageFeedArchiveKeyframeInterval - The seconds between keyframes of the
+        archive. The default is 60.
     \li \c MessageFeeds - A list of message feed configurations.
+    \li \c MessageFeedFilter - The area of interest, affiliations and maximum age of
+        accepted messages; see \l MessageIngestFilter::fromProperties.
     \li \c LocationBroadcastConfig - The location broadcast configuration details.
     \li \c UserName - the name of the user to be broadcast.
+    \li \c UdpTransport - How feeds are sent and received; see \l UdpTransport::fromProperties.
+    \li \c MessageFeedCaptureFile - If set, every datagram received on the message feed
+        ports is captured to this file; see \l DatagramCaptureWriter. A relative path is
+        relative to the app's local data location.
+    \li \c MessageReplayConfig - A message file to replay through the feeds.
+    \li \c MessageFeedRelay - The \c outputPort on which the received feeds are
+        rebroadcast, with their optional \c maximumRate per track and \c filter, by
+        default the \c MessageFeedFilter. The \c UdpTransport of the relay may be
+        given in the same object; see \l MessageFeedRelay.
   \endlist
  */
 void MessageFeedsController::setProperties(const QVariantMap& properties)
@@ -232,6 +506,12 @@ void MessageFeedsController::setProperties(const QVariantMap& properties)
   if (userNameFindIt != properties.end())
     m_locationBroadcast->setUserName(userNameFindIt.value().toString());
 
+  m_ingestFilter = MessageIngestFilter::fromProperties(properties[MessageFeedConstants::MESSAGE_FEED_FILTER_PROPERTYNAME].toMap());
+
+  // broadcast unless a multicast group or unicast peers are configured
+  const auto transport = UdpTransport::fromProperties(properties);
+  m_locationBroadcast->setTransport(transport);
+
   // only add data listeners at startup
   if (m_dataListeners.isEmpty())
   {
@@ -239,13 +519,29 @@ void MessageFeedsController::setProperties(const QVariantMap& properties)
     const auto messageFeedUdpPorts = properties[MessageFeedConstants::MESSAGE_FEED_UDP_PORTS_PROPERTYNAME].toStringList();
     for (const auto& udpPort : messageFeedUdpPorts)
     {
-      QUdpSocket* udpSocket = new QUdpSocket(this);
-      udpSocket->bind(udpPort.toInt(), QUdpSocket::DontShareAddress | QUdpSocket::ReuseAddressHint);
-
-      addDataListener(new DataListener(udpSocket, this));
+      addDataListener(transport.createDataListener(udpPort.toUShort(), this));
     }
+
+    const auto messageFeedTcpServers = properties[MessageFeedConstants::MESSAGE_FEED_TCP_SERVERS_PROPERTYNAME].toStringList();
+    for (const auto& tcpServer : messageFeedTcpServers)
+      setupTcpFeed(tcpServer);
+
+    setupCapture(properties[MessageFeedConstants::MESSAGE_FEED_CAPTURE_FILE_PROPERTYNAME].toString());
+    setupSnapshotSync(transport, properties[MessageFeedConstants::MESSAGE_FEED_SNAPSHOT_PORT_PROPERTYNAME].toUInt());
+    setupRelay(properties[MessageFeedConstants::MESSAGE_FEED_RELAY_PROPERTYNAME].toMap(), transport);
   }
 
+  m_checkpointInterval = properties.value(MessageFeedConstants::MESSAGE_FEED_CHECKPOINT_INTERVAL_PROPERTYNAME,
+                                          s_defaultCheckpointInterval).toInt();
+
+  // a checkpoint taken during playback would restore a past state
+  if (!m_playbackActive)
+    m_checkpoint->setInterval(m_checkpointInterval);
+
+  if (properties.contains(MessageFeedConstants::MESSAGE_FEED_ARCHIVE_KEYFRAME_INTERVAL_PROPERTYNAME))
+    m_archive->setKeyframeInterval(properties[MessageFeedConstants::MESSAGE_FEED_ARCHIVE_KEYFRAME_INTERVAL_PROPERTYNAME].toInt());
+  m_archive->setRetention(properties[MessageFeedConstants::MESSAGE_FEED_ARCHIVE_RETENTION_PROPERTYNAME].toInt());
+
   // only setup message feeds at startup
   if (m_geoView && m_messageFeeds->rowCount() == 0)
   {
@@ -259,6 +555,237 @@ void MessageFeedsController::setProperties(const QVariantMap& properties)
     m_locationBroadcast->setMessageType(locationBroadcastConfig.value(MessageFeedConstants::LOCATION_BROADCAST_CONFIG_MESSAGE_TYPE).toString());
     m_locationBroadcast->setUdpPort(locationBroadcastConfig.value(MessageFeedConstants::LOCATION_BROADCAST_CONFIG_PORT).toInt());
   }
+
+  if (locationBroadcastConfig.contains(MessageFeedConstants::LOCATION_BROADCAST_CONFIG_WIRE_FORMAT))
+  {
+    const auto wireFormat = locationBroadcastConfig.value(MessageFeedConstants::LOCATION_BROADCAST_CONFIG_WIRE_FORMAT).toString();
+    m_locationBroadcast->setWireFormat(LocationBroadcast::toWireFormat(wireFormat));
+  }
+
+  if (locationBroadcastConfig.contains(MessageFeedConstants::LOCATION_BROADCAST_CONFIG_DISTANCE_THRESHOLD))
+    m_locationBroadcast->setDistanceThreshold(locationBroadcastConfig.value(MessageFeedConstants::LOCATION_BROADCAST_CONFIG_DISTANCE_THRESHOLD).toDouble());
+
+  if (locationBroadcastConfig.contains(MessageFeedConstants::LOCATION_BROADCAST_CONFIG_HEADING_THRESHOLD))
+    m_locationBroadcast->setHeadingThreshold(locationBroadcastConfig.value(MessageFeedConstants::LOCATION_BROADCAST_CONFIG_HEADING_THRESHOLD).toDouble());
+
+  if (locationBroadcastConfig.contains(MessageFeedConstants::LOCATION_BROADCAST_CONFIG_HEARTBEAT_INTERVAL))
+    m_locationBroadcast->setHeartbeatInterval(locationBroadcastConfig.value(MessageFeedConstants::LOCATION_BROADCAST_CONFIG_HEARTBEAT_INTERVAL).toInt());
+
+  if (locationBroadcastConfig.contains(MessageFeedConstants::LOCATION_BROADCAST_CONFIG_ADAPTIVE))
+    m_locationBroadcast->setAdaptive(locationBroadcastConfig.value(MessageFeedConstants::LOCATION_BROADCAST_CONFIG_ADAPTIVE).toBool());
+
+  if (locationBroadcastConfig.contains(MessageFeedConstants::LOCATION_BROADCAST_CONFIG_LATENCY_PROBE))
+    m_locationBroadcast->setLatencyProbeEnabled(locationBroadcastConfig.value(MessageFeedConstants::LOCATION_BROADCAST_CONFIG_LATENCY_PROBE).toBool());
+
+  // only start replaying tracks at startup
+  if (!m_trackReplay)
+    setupTrackReplay(properties[MessageFeedConstants::TRACK_REPLAY_CONFIG_PROPERTYNAME].toMap());
+
+  if (!m_messageReplay)
+    setupMessageReplay(properties[MessageFeedConstants::MESSAGE_REPLAY_CONFIG_PROPERTYNAME].toMap());
+}
+
+/*!
+  \internal
+  \brief Starts replaying the GPX tracks described by \a trackReplayConfig
+  through the message feeds, for soak testing.
+
+  The config names a \c gpxFile, relative to the resource directory if it is not
+  absolute, the \c trackCount copies to replay and the \c messageType of the feed
+  they are added to. The \c spacing in meters between the tracks, their
+  \c symbolId, \c updateInterval and \c playbackMultiplier are optional.
+ */
+void MessageFeedsController::setupTrackReplay(const QVariantMap& trackReplayConfig)
+{
+  const QString gpxFile = trackReplayConfig.value(MessageFeedConstants::TRACK_REPLAY_CONFIG_GPX_FILE).toString();
+  const int trackCount = trackReplayConfig.value(MessageFeedConstants::TRACK_REPLAY_CONFIG_TRACK_COUNT).toInt();
+  const QString messageType = trackReplayConfig.value(MessageFeedConstants::TRACK_REPLAY_CONFIG_MESSAGE_TYPE).toString();
+  if (gpxFile.isEmpty() || trackCount <= 0 || messageType.isEmpty())
+    return;
+
+  const QString gpxFilePath = QFileInfo(gpxFile).isAbsolute() ? gpxFile : QString("%1/%2").arg(m_resourcePath, gpxFile);
+  const double spacing = trackReplayConfig.value(MessageFeedConstants::TRACK_REPLAY_CONFIG_SPACING, 100.0).toDouble();
+
+  m_trackReplay = new TrackReplaySimulator(this);
+  if (!m_trackReplay->addTracks(gpxFilePath, trackCount, spacing))
+  {
+    emit toolErrorOccurred(QStringLiteral("Failed to load the track replay GPX file"), gpxFilePath);
+    return;
+  }
+
+  m_trackReplay->setMessageType(messageType);
+  m_trackReplay->setSymbolId(trackReplayConfig.value(MessageFeedConstants::TRACK_REPLAY_CONFIG_SYMBOL_ID).toString());
+
+  if (trackReplayConfig.contains(MessageFeedConstants::TRACK_REPLAY_CONFIG_UPDATE_INTERVAL))
+    m_trackReplay->setUpdateInterval(trackReplayConfig.value(MessageFeedConstants::TRACK_REPLAY_CONFIG_UPDATE_INTERVAL).toInt());
+
+  if (trackReplayConfig.contains(MessageFeedConstants::TRACK_REPLAY_CONFIG_PLAYBACK_MULTIPLIER))
+    m_trackReplay->setPlaybackMultiplier(trackReplayConfig.value(MessageFeedConstants::TRACK_REPLAY_CONFIG_PLAYBACK_MULTIPLIER).toInt());
+
+  connect(m_trackReplay, &TrackReplaySimulator::messagesGenerated, this, &MessageFeedsController::applyMessages);
+  m_trackReplay->start();
+}
+
+/*!
+  \internal
+  \brief Starts capturing the datagrams received by every data listener to \a captureFile,
+  so that the load can be replayed later.
+ */
+void MessageFeedsController::setupCapture(const QString& captureFile)
+{
+  if (captureFile.isEmpty() || m_captureWriter)
+    return;
+
+  const QString captureFilePath = QFileInfo(captureFile).isAbsolute()
+      ? captureFile
+      : QString("%1/%2").arg(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation), captureFile);
+
+  m_captureWriter = new DatagramCaptureWriter(this);
+  if (!m_captureWriter->open(captureFilePath))
+  {
+    emit toolErrorOccurred(QStringLiteral("Failed to create the message feed capture file"), captureFilePath);
+    return;
+  }
+
+  for (DataListener* dataListener : qAsConst(m_dataListeners))
+    dataListener->setCaptureWriter(m_captureWriter);
+}
+
+/*!
+  \internal
+  \brief Serves snapshots of the message feeds to peers on the UDP \a port with
+  \a transport, and requests one once the feeds are set up.
+ */
+void MessageFeedsController::setupSnapshotSync(const UdpTransport& transport, quint16 port)
+{
+  if (port == 0 || m_snapshotSync)
+    return;
+
+  m_snapshotSync = new MessageSnapshotSync(m_messageFeeds, this);
+  if (!m_snapshotSync->start(transport, port))
+  {
+    emit toolErrorOccurred(QStringLiteral("Failed to listen for message feed snapshots"), QString::number(port));
+    return;
+  }
+
+  // the snapshot is added through the same batch path as decoded messages
+  connect(m_snapshotSync, &MessageSnapshotSync::snapshotReceived, this, &MessageFeedsController::applyMessages);
+}
+
+/*!
+  \internal
+  \brief Rebroadcasts the feeds of all data listeners as described by \a relayConfig.
+
+  The relay is sent with the \c UdpTransport of \a relayConfig if it has one, so that
+  it can bridge to another network, and with \a transport otherwise.
+ */
+void MessageFeedsController::setupRelay(const QVariantMap& relayConfig, const UdpTransport& transport)
+{
+  const quint16 outputPort = relayConfig.value(MessageFeedConstants::MESSAGE_FEED_RELAY_OUTPUT_PORT).toUInt();
+  if (outputPort == 0 || m_relay)
+    return;
+
+  const auto relayTransport = relayConfig.contains(UdpTransport::TRANSPORT_PROPERTYNAME)
+      ? UdpTransport::fromProperties(relayConfig)
+      : transport;
+
+  m_relay = new MessageFeedRelay(this);
+  if (!m_relay->start(relayTransport, outputPort))
+  {
+    emit toolErrorOccurred(QStringLiteral("Failed to start the message feed relay"), QString::number(outputPort));
+    delete m_relay;
+    m_relay = nullptr;
+    return;
+  }
+
+  if (relayConfig.contains(MessageFeedConstants::MESSAGE_FEED_RELAY_MAXIMUM_RATE))
+    m_relay->setMaximumRate(relayConfig.value(MessageFeedConstants::MESSAGE_FEED_RELAY_MAXIMUM_RATE).toDouble());
+
+  m_relay->setFilter(relayConfig.contains(MessageFeedConstants::MESSAGE_FEED_RELAY_FILTER)
+                     ? MessageIngestFilter::fromProperties(relayConfig.value(MessageFeedConstants::MESSAGE_FEED_RELAY_FILTER).toMap())
+                     : m_ingestFilter);
+
+  for (DataListener* dataListener : qAsConst(m_dataListeners))
+    m_relay->addDataListener(dataListener);
+}
+
+/*!
+  \internal
+  \brief Adds a data listener for the CoT event stream of the TCP \a server, given as \c host:port.
+
+  The stream is split into events by the listener, and the connection is retried
+  whenever it is refused or dropped.
+ */
+void MessageFeedsController::setupTcpFeed(const QString& server)
+{
+  const int separator = server.lastIndexOf(QLatin1Char(':'));
+  bool portOk = false;
+  const QString host = server.left(separator);
+  const quint16 port = server.mid(separator + 1).toUShort(&portOk);
+  if (separator <= 0 || !portOk || port == 0)
+  {
+    emit toolErrorOccurred(QStringLiteral("Invalid message feed TCP server"), server);
+    return;
+  }
+
+  DataListener* dataListener = new DataListener(this);
+  QTcpSocket* socket = new QTcpSocket(dataListener);
+  connect(socket, &QAbstractSocket::stateChanged, socket, [socket, host, port](QAbstractSocket::SocketState state)
+  {
+    if (state != QAbstractSocket::UnconnectedState)
+      return;
+
+    QTimer::singleShot(s_tcpReconnectInterval, socket, [socket, host, port]()
+    {
+      if (socket->state() == QAbstractSocket::UnconnectedState)
+        socket->connectToHost(host, port, QIODevice::ReadOnly);
+    });
+  });
+
+  dataListener->setStreamFraming(true);
+  dataListener->setDevice(socket);
+  addDataListener(dataListener);
+
+  socket->connectToHost(host, port, QIODevice::ReadOnly);
+}
+
+/*!
+  \internal
+  \brief Starts replaying the messages of the file described by \a messageReplayConfig
+  through the message feeds, to measure ingest without a network.
+
+  The config names a Cursor-on-Target or GeoMessage \c file, such as a
+  MessageSimulator input file, relative to the resource directory if it is not
+  absolute. The \c messagesPerSecond rate and whether to \c loop are optional.
+  The replayed data is decoded and dispatched like data received from a
+  \l DataListener, so it is counted in \l ingestStats.
+ */
+void MessageFeedsController::setupMessageReplay(const QVariantMap& messageReplayConfig)
+{
+  const QString file = messageReplayConfig.value(MessageFeedConstants::MESSAGE_REPLAY_CONFIG_FILE).toString();
+  if (file.isEmpty())
+    return;
+
+  const QString filePath = QFileInfo(file).isAbsolute() ? file : QString("%1/%2").arg(m_resourcePath, file);
+
+  m_messageReplay = new MessageFileReplay(this);
+  if (!m_messageReplay->loadFile(filePath))
+  {
+    emit toolErrorOccurred(QStringLiteral("Failed to load the message replay file"), filePath);
+    return;
+  }
+
+  if (messageReplayConfig.contains(MessageFeedConstants::MESSAGE_REPLAY_CONFIG_MESSAGES_PER_SECOND))
+    m_messageReplay->setMessagesPerSecond(messageReplayConfig.value(MessageFeedConstants::MESSAGE_REPLAY_CONFIG_MESSAGES_PER_SECOND).toInt());
+
+  if (messageReplayConfig.contains(MessageFeedConstants::MESSAGE_REPLAY_CONFIG_LOOP))
+    m_messageReplay->setLooping(messageReplayConfig.value(MessageFeedConstants::MESSAGE_REPLAY_CONFIG_LOOP).toBool());
+
+  connect(m_messageReplay, &MessageFileReplay::dataReceived, this, [this](const QByteArray& data)
+  {
+    processData(data, 0);
+  });
+  m_messageReplay->start();
 }
 
 /*!
@@ -280,11 +807,113 @@ void MessageFeedsController::setResourcePath(const QString& resourcePath)
   emit propertyChanged(RESOURCE_DIRECTORY_PROPERTYNAME, resourcePath);
 }
 
+/*!
+  \property MessageFeedsController::ingestStats
+  \brief Returns the \l MessageFeedStats for all data received by the controller,
+  before it is assigned to a feed.
+
+  This includes the number of datagrams received, dropped and failing to decode.
+  Statistics for each feed are available from \l MessageFeed::stats.
+ */
+QObject* MessageFeedsController::ingestStats() const
+{
+  return m_ingestStats;
+}
+
 LocationBroadcast* MessageFeedsController::locationBroadcast() const
 {
   return m_locationBroadcast;
 }
 
+/*!
+  \brief Returns the archive of the updates to the message feeds.
+ */
+MessageFeedArchive* MessageFeedsController::archive() const
+{
+  return m_archive;
+}
+
+/*!
+  \property MessageFeedsController::playbackActive
+  \brief Returns \c true if the feeds show a past state from the archive rather
+  than their live tracks.
+ */
+bool MessageFeedsController::isPlaybackActive() const
+{
+  return m_playbackActive;
+}
+
+/*!
+  \property MessageFeedsController::playbackTime
+  \brief Returns the time of the state shown during playback.
+ */
+QDateTime MessageFeedsController::playbackTime() const
+{
+  return m_playbackTime > 0 ? QDateTime::fromMSecsSinceEpoch(m_playbackTime) : QDateTime();
+}
+
+/*!
+  \property MessageFeedsController::archiveStartTime
+  \brief Returns the time of the oldest update in the archive, or an invalid
+  time if it is empty.
+ */
+QDateTime MessageFeedsController::archiveStartTime() const
+{
+  return m_archive->startTime() > 0 ? QDateTime::fromMSecsSinceEpoch(m_archive->startTime()) : QDateTime();
+}
+
+/*!
+  \property MessageFeedsController::archiveEndTime
+  \brief Returns the time of the newest update in the archive, or an invalid
+  time if it is empty.
+ */
+QDateTime MessageFeedsController::archiveEndTime() const
+{
+  return m_archive->endTime() > 0 ? QDateTime::fromMSecsSinceEpoch(m_archive->endTime()) : QDateTime();
+}
+
+/*!
+  \brief Shows the tracks of the feeds as they were at \a time, starting playback
+  if it is not active.
+
+  Live messages are still recorded during playback, but are not shown until
+  \l stopPlayback is called. Seeking is quick anywhere in the archive, so this
+  can be called as a time slider is dragged.
+ */
+void MessageFeedsController::seekPlayback(const QDateTime& time)
+{
+  if (m_archive->retention() == 0 || !time.isValid())
+    return;
+
+  if (!m_playbackActive)
+  {
+    m_playbackActive = true;
+    m_archive->setKeyframesPaused(true);
+    m_checkpoint->setInterval(0);
+    emit playbackActiveChanged();
+  }
+
+  // seeking again cancels a return to live which has not completed yet
+  m_liveSeekTime = -1;
+  m_heldMessages.clear();
+
+  m_archive->seek(time.toMSecsSinceEpoch());
+}
+
+/*!
+  \brief Ends playback, returning the feeds to their live tracks.
+
+  The live tracks are read from the archive, and playback ends once they are shown.
+ */
+void MessageFeedsController::stopPlayback()
+{
+  if (!m_playbackActive || m_liveSeekTime != -1)
+    return;
+
+  m_liveSeekTime = QDateTime::currentMSecsSinceEpoch();
+  m_archive->seek(m_liveSeekTime);
+}
+
 /*!
   \property MessageFeedsController::locationBroadcastEnabled
   \brief Returns \c true if the location broadcast is enabled.
@@ -467,6 +1096,21 @@ Renderer* MessageFeedsController::createRenderer(const QString& rendererInfo, QO
   \brief Signal emitted when the \l locationBroadcastInDistress property changes.
  */
 
+/*!
+  \fn void MessageFeedsController::playbackActiveChanged();
+  \brief Signal emitted when the \l playbackActive property changes.
+ */
+
+/*!
+  \fn void MessageFeedsController::playbackTimeChanged();
+  \brief Signal emitted when the \l playbackTime property changes.
+ */
+
+/*!
+  \fn void MessageFeedsController::archiveRangeChanged();
+  \brief Signal emitted when the \l archiveStartTime or \l archiveEndTime property changes.
+ */
+
 } // Dsa
 
 /*!
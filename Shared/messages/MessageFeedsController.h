@@ -17,11 +17,15 @@
 #ifndef MESSAGEFEEDSCONTROLLER_H
 #define MESSAGEFEEDSCONTROLLER_H
 
+// dsa app headers
+#include "MessageIngestFilter.h"
+
 // toolkit headers
 #include "AbstractTool.h"
 
 // Qt headers
 #include <QAbstractListModel>
+#include <QDateTime>
 #include <QVariantList>
 
 namespace Esri {
@@ -38,8 +42,32 @@ class DataListener;
 
 class LocationBroadcast;
 
+class MessageDecoderPool;
+
+class MessageSnapshotSync;
+
+class MessageFeedRelay;
+
+class MessageFeedCheckpoint;
+
+class MessageFeedArchive;
+
+class MessageFeedStats;
+
 class MessageFeedListModel;
 
+class MessageSymbolWarmer;
+
+class DatagramCaptureWriter;
+
+class MessageFileReplay;
+
+class TrackReplaySimulator;
+
+class UdpTransport;
+
+class Message;
+
 class MessageFeedsController : public AbstractTool
 {
   Q_OBJECT
@@ -48,6 +76,11 @@ class MessageFeedsController : public AbstractTool
   Q_PROPERTY(bool locationBroadcastEnabled READ isLocationBroadcastEnabled WRITE setLocationBroadcastEnabled NOTIFY locationBroadcastEnabledChanged)
   Q_PROPERTY(int locationBroadcastFrequency READ locationBroadcastFrequency WRITE setLocationBroadcastFrequency NOTIFY locationBroadcastFrequencyChanged)
   Q_PROPERTY(bool locationBroadcastInDistress READ isLocationBroadcastInDistress WRITE setLocationBroadcastInDistress NOTIFY locationBroadcastInDistressChanged)
+  Q_PROPERTY(QObject* ingestStats READ ingestStats CONSTANT)
+  Q_PROPERTY(bool playbackActive READ isPlaybackActive NOTIFY playbackActiveChanged)
+  Q_PROPERTY(QDateTime playbackTime READ playbackTime NOTIFY playbackTimeChanged)
+  Q_PROPERTY(QDateTime archiveStartTime READ archiveStartTime NOTIFY archiveRangeChanged)
+  Q_PROPERTY(QDateTime archiveEndTime READ archiveEndTime NOTIFY archiveRangeChanged)
 
 public:
   static const QString RESOURCE_DIRECTORY_PROPERTYNAME;
@@ -80,16 +113,41 @@ public:
   bool isLocationBroadcastInDistress() const;
   void setLocationBroadcastInDistress(bool inDistress);
 
+  QObject* ingestStats() const;
+
+  MessageFeedArchive* archive() const;
+  bool isPlaybackActive() const;
+  QDateTime playbackTime() const;
+  QDateTime archiveStartTime() const;
+  QDateTime archiveEndTime() const;
+
+  Q_INVOKABLE void seekPlayback(const QDateTime& time);
+  Q_INVOKABLE void stopPlayback();
+
   static Esri::ArcGISRuntime::SurfacePlacement toSurfacePlacement(const QString& surfacePlacement);
 
 signals:
   void locationBroadcastEnabledChanged();
   void locationBroadcastFrequencyChanged();
   void locationBroadcastInDistressChanged();
+  void playbackActiveChanged();
+  void playbackTimeChanged();
+  void archiveRangeChanged();
   void toolErrorOccurred(const QString& errorMessage, const QString& additionalMessage);
 
 private:
   void setupFeeds();
+  void processData(const QByteArray& data, uint shardKey);
+  void updateSocketDroppedCount();
+  void applyDecodedMessages();
+  void applyMessages(const QList<Message>& messages);
+  void applyPlaybackMessages(qint64 msecsSinceEpoch, const QList<Message>& messages);
+  void setupTrackReplay(const QVariantMap& trackReplayConfig);
+  void setupMessageReplay(const QVariantMap& messageReplayConfig);
+  void setupCapture(const QString& captureFile);
+  void setupSnapshotSync(const UdpTransport& transport, quint16 port);
+  void setupRelay(const QVariantMap& relayConfig, const UdpTransport& transport);
+  void setupTcpFeed(const QString& server);
   Esri::ArcGISRuntime::Renderer* createRenderer(const QString& rendererInfo, QObject* parent = nullptr) const;
 
   Esri::ArcGISRuntime::GeoView* m_geoView = nullptr;
@@ -99,6 +157,25 @@ private:
   QString m_resourcePath;
   LocationBroadcast* m_locationBroadcast = nullptr;
   QVariantList m_messageFeedProperties;
+  MessageDecoderPool* m_messageDecoder = nullptr;
+  MessageSnapshotSync* m_snapshotSync = nullptr;
+  MessageFeedRelay* m_relay = nullptr;
+  uint m_nextShardKey = 0;
+  MessageFeedStats* m_ingestStats = nullptr;
+  MessageFeedCheckpoint* m_checkpoint = nullptr;
+  int m_checkpointInterval = 0;
+
+  // past states of the feeds, shown instead of the live tracks during playback
+  MessageFeedArchive* m_archive = nullptr;
+  bool m_playbackActive = false;
+  qint64 m_playbackTime = 0;
+  qint64 m_liveSeekTime = -1;
+  QList<Message> m_heldMessages;
+  TrackReplaySimulator* m_trackReplay = nullptr;
+  MessageFileReplay* m_messageReplay = nullptr;
+  DatagramCaptureWriter* m_captureWriter = nullptr;
+  MessageSymbolWarmer* m_symbolWarmer = nullptr;
+  MessageIngestFilter m_ingestFilter;
 };
 
 } // Dsa
@@ -0,0 +1,275 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "MessageFileReplay.h"
+
+// Qt headers
+#include <QFile>
+#include <QTimer>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+
+// STL headers
+#include <algorithm>
+
+namespace Dsa {
+
+namespace
+{
+// interval in milliseconds between bursts of replayed messages
+constexpr int s_replayInterval = 10;
+
+// the element of each message in Cursor-on-Target and GeoMessage files
+const QString s_cotElementName = QStringLiteral("event");
+const QString s_geoMessageElementName = QStringLiteral("geomessage");
+
+// returns whether the element name is that of a single message
+bool isMessageElement(const QStringRef& name)
+{
+  return name.compare(s_cotElementName, Qt::CaseInsensitive) == 0 ||
+         name.compare(s_geoMessageElementName, Qt::CaseInsensitive) == 0;
+}
+}
+
+/*!
+  \class Dsa::MessageFileReplay
+  \inmodule Dsa
+  \inherits QObject
+  \brief Replays the messages of a Cursor-on-Target or GeoMessage file as received data.
+
+  This is an ingest harness for the message feeds which needs no network. The file
+  can be a capture of a feed or a MessageSimulator input file: each \c event or
+  \c geomessage element is emitted as its own \l dataReceived, exactly as a
+  \l DataListener would report a datagram. The data therefore goes through the
+  whole ingest path of decoding, dispatch to the feeds and adding to the overlays,
+  whose \l MessageFeedStats give the decode throughput and time-to-graphic.
+
+  Messages are emitted at \l messagesPerSecond, so the same file can be
+  replayed at a range of update rates.
+ */
+
+/*!
+  \brief Constructor taking an optional \a parent.
+ */
+MessageFileReplay::MessageFileReplay(QObject* parent):
+  QObject(parent),
+  m_timer(new QTimer(this))
+{
+  m_timer->setInterval(s_replayInterval);
+  m_timer->setTimerType(Qt::PreciseTimer);
+  connect(m_timer, &QTimer::timeout, this, &MessageFileReplay::handleTimerEvent);
+}
+
+/*!
+  \brief Destructor.
+ */
+MessageFileReplay::~MessageFileReplay()
+{
+}
+
+/*!
+  \brief Loads the messages in the file \a filePath to be replayed.
+
+  Each message is split out of the file once, so that replaying does not parse
+  the file again. Returns \c false if the file could not be read or holds no messages.
+ */
+bool MessageFileReplay::loadFile(const QString& filePath)
+{
+  QFile file(filePath);
+  if (!file.open(QFile::ReadOnly))
+    return false;
+
+  QXmlStreamReader reader(&file);
+  QVector<QByteArray> messages;
+
+  while (!reader.atEnd())
+  {
+    if (reader.readNext() != QXmlStreamReader::StartElement || !isMessageElement(reader.name()))
+      continue;
+
+    // write the whole message element, including its children, as a document of its own
+    QByteArray message;
+    QXmlStreamWriter writer(&message);
+    int depth = 0;
+    do
+    {
+      if (reader.isStartElement())
+        ++depth;
+      else if (reader.isEndElement())
+        --depth;
+
+      writer.writeCurrentToken(reader);
+    }
+    while (depth > 0 && !reader.atEnd() && reader.readNext() != QXmlStreamReader::Invalid);
+
+    messages.append(message);
+  }
+
+  if (reader.hasError() || messages.isEmpty())
+    return false;
+
+  stop();
+  m_messages = messages;
+  m_nextIndex = 0;
+  return true;
+}
+
+/*!
+  \brief Stops the replay and removes all of the messages.
+ */
+void MessageFileReplay::clear()
+{
+  stop();
+  m_messages.clear();
+  m_nextIndex = 0;
+}
+
+/*!
+  \brief Returns the number of messages loaded to be replayed.
+ */
+int MessageFileReplay::messageCount() const
+{
+  return m_messages.size();
+}
+
+/*!
+  \brief Returns the number of messages emitted since the replay was started.
+ */
+qint64 MessageFileReplay::replayedCount() const
+{
+  return m_replayedCount;
+}
+
+/*!
+  \brief Returns the rate at which messages are replayed.
+
+  The default is \c 100 messages per second.
+ */
+int MessageFileReplay::messagesPerSecond() const
+{
+  return m_messagesPerSecond;
+}
+
+/*!
+  \brief Sets the rate at which messages are replayed to \a messagesPerSecond.
+ */
+void MessageFileReplay::setMessagesPerSecond(int messagesPerSecond)
+{
+  if (messagesPerSecond <= 0 || messagesPerSecond == m_messagesPerSecond)
+    return;
+
+  m_messagesPerSecond = messagesPerSecond;
+
+  // the rate applies from now, rather than catching up on the messages due at the old rate
+  if (isRunning())
+  {
+    m_replayedCount = 0;
+    m_elapsedTimer.restart();
+  }
+}
+
+/*!
+  \brief Returns whether the replay restarts from the first message once it reaches the end.
+
+  The default is \c true.
+ */
+bool MessageFileReplay::isLooping() const
+{
+  return m_looping;
+}
+
+/*!
+  \brief Sets whether the replay restarts from the first message once it reaches
+  the end to \a looping.
+ */
+void MessageFileReplay::setLooping(bool looping)
+{
+  m_looping = looping;
+}
+
+/*!
+  \brief Returns whether messages are being replayed.
+ */
+bool MessageFileReplay::isRunning() const
+{
+  return m_timer->isActive();
+}
+
+/*!
+  \brief Starts replaying messages.
+ */
+void MessageFileReplay::start()
+{
+  if (m_messages.isEmpty() || isRunning())
+    return;
+
+  m_replayedCount = 0;
+  m_elapsedTimer.start();
+  m_timer->start();
+}
+
+/*!
+  \brief Stops replaying messages.
+ */
+void MessageFileReplay::stop()
+{
+  m_timer->stop();
+}
+
+/*!
+  \internal
+
+  Emits all of the messages which are due at the current rate. Messages which fall
+  behind, for example while the UI thread is busy, are emitted in the next burst.
+ */
+void MessageFileReplay::handleTimerEvent()
+{
+  const qint64 dueCount = m_elapsedTimer.elapsed() * m_messagesPerSecond / 1000;
+
+  while (m_replayedCount < dueCount)
+  {
+    if (m_nextIndex >= m_messages.size())
+    {
+      if (!m_looping)
+      {
+        stop();
+        emit finished();
+        return;
+      }
+
+      m_nextIndex = 0;
+    }
+
+    ++m_replayedCount;
+    emit dataReceived(m_messages.at(m_nextIndex++));
+  }
+}
+
+} // Dsa
+
+// Signal Documentation
+/*!
+  \fn void MessageFileReplay::dataReceived(const QByteArray& data);
+  \brief Signal emitted with the \a data of each replayed message.
+ */
+
+/*!
+  \fn void MessageFileReplay::finished();
+  \brief Signal emitted when the last message has been replayed and \l isLooping is \c false.
+ */
@@ -0,0 +1,74 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef MESSAGEFILEREPLAY_H
+#define MESSAGEFILEREPLAY_H
+
+// Qt headers
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QObject>
+#include <QVector>
+
+class QTimer;
+
+namespace Dsa {
+
+class MessageFileReplay : public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit MessageFileReplay(QObject* parent = nullptr);
+  ~MessageFileReplay();
+
+  bool loadFile(const QString& filePath);
+  void clear();
+
+  int messageCount() const;
+  qint64 replayedCount() const;
+
+  int messagesPerSecond() const;
+  void setMessagesPerSecond(int messagesPerSecond);
+
+  bool isLooping() const;
+  void setLooping(bool looping);
+
+  bool isRunning() const;
+  void start();
+  void stop();
+
+signals:
+  void dataReceived(const QByteArray& data);
+  void finished();
+
+private:
+  Q_DISABLE_COPY(MessageFileReplay)
+
+  void handleTimerEvent();
+
+  QTimer* m_timer = nullptr;
+  QElapsedTimer m_elapsedTimer;
+  QVector<QByteArray> m_messages;
+  int m_nextIndex = 0;
+  int m_messagesPerSecond = 100;
+  bool m_looping = true;
+  qint64 m_replayedCount = 0;
+};
+
+} // Dsa
+
+#endif // MESSAGEFILEREPLAY_H
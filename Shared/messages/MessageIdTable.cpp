@@ -0,0 +1,236 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "MessageIdTable.h"
+
+namespace Dsa {
+
+/*!
+  \class Dsa::MessageIdTable
+  \inmodule Dsa
+  \brief Process-wide table which interns message IDs as integer keys.
+
+  Each message ID is given a key the first time it is \l {intern}{interned}. Messages
+  are interned as they are decoded, so that overlays can look up their graphics by key
+  in flat arrays rather than hashing the ID string on every update.
+
+  Keys are reference counted. \l intern and \l retain take a reference to a key and
+  \l release drops one; a \l Message holds a reference to the key of its ID, and an
+  overlay holds one for each graphic it shows. Once a key has no references it may be
+  given to a new message ID. Released keys are reused oldest first, and the most
+  recently released keys are held back, so that a key keeps its ID for a while and is
+  found again if the ID returns. The keys in use therefore stay close to the number of
+  live message IDs rather than the number ever seen.
+
+  Each time a key is given to a different message ID, its \l generation is incremented.
+  State which is kept by key without holding a reference, such as the event time of a
+  removed track, should record the generation and ignore the state once it changes.
+
+  \l intern returns \c -1 when every key in the table is referenced.
+
+  This class is thread-safe.
+ */
+
+/*!
+  \brief Returns the shared instance of the table.
+ */
+MessageIdTable* MessageIdTable::instance()
+{
+  // never deleted, since messages in static storage may release keys on exit
+  static MessageIdTable* s_instance = new MessageIdTable();
+  return s_instance;
+}
+
+/*!
+  \internal
+ */
+MessageIdTable::MessageIdTable()
+{
+  for (auto& chunk : m_chunks)
+    chunk = nullptr;
+}
+
+/*!
+  \internal
+ */
+MessageIdTable::~MessageIdTable()
+{
+  for (auto& chunk : m_chunks)
+    delete[] chunk;
+}
+
+/*!
+  \brief Returns the key for \a messageId, adding it to the table if it is new, and
+  takes a reference to the key.
+
+  Each call should be matched by a call to \l release.
+
+  Returns \c -1 if \a messageId is empty or every key in the table is referenced.
+ */
+int MessageIdTable::intern(const QString& messageId)
+{
+  if (messageId.isEmpty())
+    return -1;
+
+  {
+    QReadLocker locker(&m_lock);
+    auto findIt = m_keys.constFind(messageId);
+    if (findIt != m_keys.constEnd())
+    {
+      entry(findIt.value())->m_references.fetch_add(1, std::memory_order_relaxed);
+      return findIt.value();
+    }
+  }
+
+  QWriteLocker locker(&m_lock);
+
+  // another thread may have added the ID since the read lock was released
+  auto findIt = m_keys.constFind(messageId);
+  if (findIt != m_keys.constEnd())
+  {
+    entry(findIt.value())->m_references.fetch_add(1, std::memory_order_relaxed);
+    return findIt.value();
+  }
+
+  // reuse the oldest released key, keeping the most recent ones for IDs which return
+  const bool full = m_count == s_chunkSize * s_maximumChunks;
+  int key = -1;
+  while (key == -1 && (m_freeKeys.size() > s_retainedFreeKeys || (full && !m_freeKeys.isEmpty())))
+  {
+    // a queued key may have been interned again since it was released
+    const int freeKey = m_freeKeys.dequeue();
+    Entry* freeEntry = entry(freeKey);
+    freeEntry->m_queued = false;
+    if (freeEntry->m_references.load(std::memory_order_relaxed) == 0)
+      key = freeKey;
+  }
+
+  if (key == -1)
+  {
+    if (full)
+      return -1;
+
+    key = m_count++;
+    Entry*& chunk = m_chunks[key / s_chunkSize];
+    if (!chunk)
+      chunk = new Entry[s_chunkSize];
+  }
+
+  Entry* newEntry = entry(key);
+  if (!newEntry->m_messageId.isEmpty())
+  {
+    m_keys.remove(newEntry->m_messageId);
+    ++newEntry->m_generation;
+  }
+
+  newEntry->m_messageId = messageId;
+  newEntry->m_references.store(1, std::memory_order_relaxed);
+  m_keys.insert(messageId, key);
+
+  return key;
+}
+
+/*!
+  \brief Returns the key for \a messageId, or \c -1 if it has not been interned.
+
+  No reference is taken to the key.
+ */
+int MessageIdTable::find(const QString& messageId) const
+{
+  QReadLocker locker(&m_lock);
+  return m_keys.value(messageId, -1);
+}
+
+/*!
+  \brief Returns the message ID interned as \a key, or an empty string for an unknown key.
+ */
+QString MessageIdTable::messageId(int key) const
+{
+  QReadLocker locker(&m_lock);
+  if (key < 0 || key >= m_count)
+    return QString();
+
+  return entry(key)->m_messageId;
+}
+
+/*!
+  \brief Returns the number of times \a key has been given to a new message ID.
+ */
+quint32 MessageIdTable::generation(int key) const
+{
+  QReadLocker locker(&m_lock);
+  if (key < 0 || key >= m_count)
+    return 0;
+
+  return entry(key)->m_generation;
+}
+
+/*!
+  \brief Takes another reference to \a key, which must already be referenced.
+
+  Each call should be matched by a call to \l release.
+ */
+void MessageIdTable::retain(int key)
+{
+  if (key < 0)
+    return;
+
+  QReadLocker locker(&m_lock);
+  entry(key)->m_references.fetch_add(1, std::memory_order_relaxed);
+}
+
+/*!
+  \brief Drops a reference to \a key, taken by \l intern or \l retain.
+
+  Once \a key has no references, it may be given to a new message ID.
+ */
+void MessageIdTable::release(int key)
+{
+  if (key < 0)
+    return;
+
+  Entry* releasedEntry = nullptr;
+  {
+    QReadLocker locker(&m_lock);
+    releasedEntry = entry(key);
+    if (releasedEntry->m_references.fetch_sub(1, std::memory_order_acq_rel) != 1)
+      return;
+  }
+
+  // the key may have been interned again before the write lock was taken
+  QWriteLocker locker(&m_lock);
+  if (releasedEntry->m_references.load(std::memory_order_relaxed) != 0 || releasedEntry->m_queued)
+    return;
+
+  releasedEntry->m_queued = true;
+  m_freeKeys.enqueue(key);
+}
+
+/*!
+  \internal
+  \brief Returns the entry for \a key, which must be in the table.
+
+  The lock must be held by the caller.
+ */
+MessageIdTable::Entry* MessageIdTable::entry(int key) const
+{
+  return &m_chunks[key / s_chunkSize][key % s_chunkSize];
+}
+
+} // Dsa
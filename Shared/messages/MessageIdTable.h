@@ -0,0 +1,78 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef MESSAGEIDTABLE_H
+#define MESSAGEIDTABLE_H
+
+// Qt headers
+#include <QHash>
+#include <QQueue>
+#include <QReadWriteLock>
+#include <QString>
+
+// STL headers
+#include <atomic>
+
+namespace Dsa {
+
+class MessageIdTable
+{
+public:
+  static MessageIdTable* instance();
+
+  int intern(const QString& messageId);
+  int find(const QString& messageId) const;
+  QString messageId(int key) const;
+  quint32 generation(int key) const;
+
+  void retain(int key);
+  void release(int key);
+
+private:
+  MessageIdTable();
+  ~MessageIdTable();
+
+  Q_DISABLE_COPY(MessageIdTable)
+
+  struct Entry
+  {
+    QString m_messageId;
+    std::atomic<int> m_references{0};
+    quint32 m_generation = 0;
+    bool m_queued = false;
+  };
+
+  Entry* entry(int key) const;
+
+  static const int s_chunkSize = 4096;
+  static const int s_maximumChunks = 1024;
+  static const int s_retainedFreeKeys = 4096;
+
+  // guards the lookup from message ID to key and the reuse of keys
+  mutable QReadWriteLock m_lock;
+  QHash<QString, int> m_keys;
+
+  // entries by key, in chunks which never move once allocated
+  Entry* m_chunks[s_maximumChunks];
+  int m_count = 0;
+
+  // released keys, oldest first, which may be given to new message IDs
+  QQueue<int> m_freeKeys;
+};
+
+} // Dsa
+
+#endif // MESSAGEIDTABLE_H
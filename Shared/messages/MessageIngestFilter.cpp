@@ -0,0 +1,382 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "MessageIngestFilter.h"
+
+// dsa app headers
+#include "Message.h"
+
+// C++ API headers
+#include "Envelope.h"
+#include "GeometryEngine.h"
+#include "Point.h"
+#include "SpatialReference.h"
+
+// Qt headers
+#include <QDateTime>
+
+// STL headers
+#include <algorithm>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+namespace
+{
+const QString s_extentKey = QStringLiteral("extent");
+const QString s_polygonKey = QStringLiteral("polygon");
+const QString s_affiliationsKey = QStringLiteral("affiliations");
+const QString s_maximumAgeKey = QStringLiteral("maxAge");
+
+// GeoMessage attribute holding the time the report is valid from
+const QString s_geoMessageTimeName = QStringLiteral("datetimevalid");
+
+// standard identity digit of a 2525D symbol id, mapped to the 2525C affiliation letters
+const char s_numericAffiliations[] = {'P', 'U', 'A', 'F', 'N', 'S', 'H'};
+
+int affiliationBit(QChar affiliation)
+{
+  const char letter = affiliation.toUpper().toLatin1();
+  return letter >= 'A' && letter <= 'Z' ? letter - 'A' : -1;
+}
+}
+
+/*!
+  \class Dsa::MessageIngestFilter
+  \inmodule Dsa
+  \brief Rejects decoded messages which are of no interest before they reach
+  a \l MessagesOverlay.
+
+  A message can be rejected for lying outside an area of interest, for its
+  symbol's affiliation, or for being older than a maximum age. The area test
+  is a bounding box comparison, followed by a point in polygon test for point
+  messages when the area is a polygon, so rejected messages cost no
+  \c Graphic work.
+
+  Only update messages are filtered; removals and selections always pass so
+  that existing graphics can still be removed.
+ */
+
+/*!
+  \brief Constructs a filter which accepts every message.
+ */
+MessageIngestFilter::MessageIngestFilter()
+{
+}
+
+/*!
+  \brief Destructor.
+ */
+MessageIngestFilter::~MessageIngestFilter()
+{
+}
+
+/*!
+  \brief Returns a filter configured by \a filterConfig.
+
+  Applicable keys are:
+  \list
+    \li \c extent - The area of interest as \c [xMin, yMin, xMax, yMax] in WGS84.
+    \li \c polygon - The area of interest as a list of \c [x, y] WGS84 vertices.
+        Takes precedence over \c extent.
+    \li \c affiliations - The affiliation letters to accept, e.g. \c "FHN".
+    \li \c maxAge - The maximum age of a message from its time, in seconds.
+  \endlist
+ */
+MessageIngestFilter MessageIngestFilter::fromProperties(const QVariantMap& filterConfig)
+{
+  MessageIngestFilter filter;
+
+  const auto polygon = filterConfig.value(s_polygonKey).toList();
+  const auto extent = filterConfig.value(s_extentKey).toList();
+  if (polygon.size() >= 3)
+  {
+    QVector<QPointF> vertices;
+    vertices.reserve(polygon.size());
+    for (const auto& vertex : polygon)
+    {
+      const auto coordinates = vertex.toList();
+      if (coordinates.size() >= 2)
+        vertices.append(QPointF(coordinates.at(0).toDouble(), coordinates.at(1).toDouble()));
+    }
+
+    filter.setPolygon(vertices);
+  }
+  else if (extent.size() == 4)
+  {
+    filter.setExtent(extent.at(0).toDouble(), extent.at(1).toDouble(),
+                     extent.at(2).toDouble(), extent.at(3).toDouble());
+  }
+
+  filter.setAffiliations(filterConfig.value(s_affiliationsKey).toString());
+  filter.setMaximumAge(filterConfig.value(s_maximumAgeKey).toInt());
+
+  return filter;
+}
+
+/*!
+  \brief Returns whether the filter rejects any messages.
+ */
+bool MessageIngestFilter::isEnabled() const
+{
+  return m_hasArea || m_affiliationMask != 0 || m_maximumAge > 0;
+}
+
+/*!
+  \brief Returns whether the filter has an area of interest.
+ */
+bool MessageIngestFilter::hasArea() const
+{
+  return m_hasArea;
+}
+
+/*!
+  \brief Sets the area of interest to the WGS84 extent from \a xMin, \a yMin to \a xMax, \a yMax.
+ */
+void MessageIngestFilter::setExtent(double xMin, double yMin, double xMax, double yMax)
+{
+  m_polygon.clear();
+  m_xMin = std::min(xMin, xMax);
+  m_yMin = std::min(yMin, yMax);
+  m_xMax = std::max(xMin, xMax);
+  m_yMax = std::max(yMin, yMax);
+  m_hasArea = true;
+}
+
+/*!
+  \brief Sets the area of interest to the WGS84 \a polygon.
+
+  Fewer than three vertices clear the area of interest.
+ */
+void MessageIngestFilter::setPolygon(const QVector<QPointF>& polygon)
+{
+  if (polygon.size() < 3)
+  {
+    clearArea();
+    return;
+  }
+
+  m_polygon = polygon;
+  m_xMin = m_xMax = polygon.first().x();
+  m_yMin = m_yMax = polygon.first().y();
+  for (const auto& vertex : polygon)
+  {
+    m_xMin = std::min(m_xMin, vertex.x());
+    m_yMin = std::min(m_yMin, vertex.y());
+    m_xMax = std::max(m_xMax, vertex.x());
+    m_yMax = std::max(m_yMax, vertex.y());
+  }
+  m_hasArea = true;
+}
+
+/*!
+  \brief Removes the area of interest, so messages are accepted wherever they are.
+ */
+void MessageIngestFilter::clearArea()
+{
+  m_polygon.clear();
+  m_hasArea = false;
+}
+
+/*!
+  \brief Returns the accepted affiliation letters, or an empty string if every affiliation is accepted.
+ */
+QString MessageIngestFilter::affiliations() const
+{
+  QString letters;
+  for (int bit = 0; bit < 26; ++bit)
+  {
+    if (m_affiliationMask & (1u << bit))
+      letters.append(QChar('A' + bit));
+  }
+
+  return letters;
+}
+
+/*!
+  \brief Sets the accepted \a affiliations, as 2525C affiliation letters such as
+  \c F (friend), \c H (hostile), \c N (neutral) and \c U (unknown).
+
+  An empty string accepts every affiliation.
+ */
+void MessageIngestFilter::setAffiliations(const QString& affiliations)
+{
+  m_affiliationMask = 0;
+  for (const QChar letter : affiliations)
+  {
+    const int bit = affiliationBit(letter);
+    if (bit >= 0)
+      m_affiliationMask |= 1u << bit;
+  }
+}
+
+/*!
+  \brief Returns the maximum age of accepted messages in seconds, or \c 0 for no limit.
+ */
+int MessageIngestFilter::maximumAge() const
+{
+  return m_maximumAge;
+}
+
+/*!
+  \brief Sets the maximum age of accepted messages to \a maximumAge seconds.
+
+  The age is taken from the event time of the message, or from the GeoMessage
+  \c datetimevalid if it has no event time. Messages without a time are accepted.
+ */
+void MessageIngestFilter::setMaximumAge(int maximumAge)
+{
+  m_maximumAge = std::max(0, maximumAge);
+}
+
+/*!
+  \brief Returns why \a message is rejected, or \c Rejection::None if it is accepted.
+
+  The cheapest tests are made first.
+ */
+MessageIngestFilter::Rejection MessageIngestFilter::check(const Message& message) const
+{
+  if (message.messageAction() != Message::MessageAction::Update)
+    return Rejection::None;
+
+  if (m_affiliationMask != 0)
+  {
+    const int bit = affiliationBit(affiliation(message.symbolId()));
+    if (bit >= 0 && !(m_affiliationMask & (1u << bit)))
+      return Rejection::Affiliation;
+  }
+
+  if (m_hasArea)
+  {
+    const Geometry geometry = message.geometry();
+    if (!geometry.isEmpty())
+    {
+      const SpatialReference spatialReference = geometry.spatialReference();
+      const bool isWgs84 = spatialReference.isEmpty() || spatialReference == SpatialReference::wgs84();
+      if (geometry.geometryType() == GeometryType::Point)
+      {
+        const Point point = isWgs84 ? Point(geometry) : Point(GeometryEngine::project(geometry, SpatialReference::wgs84()));
+        if (!isInArea(point.x(), point.y()))
+          return Rejection::OutsideArea;
+      }
+      else
+      {
+        Envelope extent = geometry.extent();
+        if (!isWgs84)
+          extent = Envelope(GeometryEngine::project(extent, SpatialReference::wgs84()));
+
+        if (!intersectsArea(extent.xMin(), extent.yMin(), extent.xMax(), extent.yMax()))
+          return Rejection::OutsideArea;
+      }
+    }
+  }
+
+  if (m_maximumAge > 0)
+  {
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+
+    // both CoT decoders set the event time, but only the full parser keeps the time attribute
+    if (message.eventTime() > 0)
+    {
+      if (now.toMSecsSinceEpoch() - message.eventTime() > m_maximumAge * 1000ll)
+        return Rejection::Age;
+    }
+    else
+    {
+      const QVariant timeValue = message.messageAttributes().value(s_geoMessageTimeName);
+      if (timeValue.isValid())
+      {
+        const QDateTime time = QDateTime::fromString(timeValue.toString(), Qt::ISODateWithMs);
+        if (time.isValid() && time.secsTo(now) > m_maximumAge)
+          return Rejection::Age;
+      }
+    }
+  }
+
+  return Rejection::None;
+}
+
+/*!
+  \brief Returns whether \a message passes the filter.
+ */
+bool MessageIngestFilter::accepts(const Message& message) const
+{
+  return check(message) == Rejection::None;
+}
+
+/*!
+  \brief Returns the upper case affiliation letter of \a symbolId, or a null QChar if it has none.
+
+  Numeric 2525D symbol ids are mapped from their standard identity to the
+  equivalent 2525C letter.
+ */
+QChar MessageIngestFilter::affiliation(const QString& symbolId)
+{
+  if (symbolId.size() >= 20 && symbolId.at(0).isDigit())
+  {
+    const int identity = symbolId.at(3).digitValue();
+    if (identity >= 0 && identity < static_cast<int>(sizeof(s_numericAffiliations)))
+      return QChar(s_numericAffiliations[identity]);
+
+    return QChar();
+  }
+
+  if (symbolId.size() >= 2 && symbolId.at(1).isLetter())
+    return symbolId.at(1).toUpper();
+
+  return QChar();
+}
+
+/*!
+  \internal
+ */
+bool MessageIngestFilter::isInArea(double x, double y) const
+{
+  if (x < m_xMin || x > m_xMax || y < m_yMin || y > m_yMax)
+    return false;
+
+  if (m_polygon.isEmpty())
+    return true;
+
+  // even-odd ray casting
+  bool inside = false;
+  for (int i = 0, j = m_polygon.size() - 1; i < m_polygon.size(); j = i++)
+  {
+    const QPointF& a = m_polygon.at(i);
+    const QPointF& b = m_polygon.at(j);
+    if ((a.y() > y) != (b.y() > y) &&
+        x < (b.x() - a.x()) * (y - a.y()) / (b.y() - a.y()) + a.x())
+    {
+      inside = !inside;
+    }
+  }
+
+  return inside;
+}
+
+/*!
+  \internal
+ */
+bool MessageIngestFilter::intersectsArea(double xMin, double yMin, double xMax, double yMax) const
+{
+  return xMax >= m_xMin && xMin <= m_xMax && yMax >= m_yMin && yMin <= m_yMax;
+}
+
+} // Dsa
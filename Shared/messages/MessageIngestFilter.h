@@ -0,0 +1,85 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef MESSAGEINGESTFILTER_H
+#define MESSAGEINGESTFILTER_H
+
+// Qt headers
+#include <QPointF>
+#include <QString>
+#include <QVariantMap>
+#include <QVector>
+
+namespace Dsa {
+
+class Message;
+
+class MessageIngestFilter
+{
+public:
+  enum class Rejection
+  {
+    None = 0,
+    OutsideArea,
+    Affiliation,
+    Age
+  };
+
+  MessageIngestFilter();
+  ~MessageIngestFilter();
+
+  static MessageIngestFilter fromProperties(const QVariantMap& filterConfig);
+
+  bool isEnabled() const;
+
+  bool hasArea() const;
+  void setExtent(double xMin, double yMin, double xMax, double yMax);
+  void setPolygon(const QVector<QPointF>& polygon);
+  void clearArea();
+
+  QString affiliations() const;
+  void setAffiliations(const QString& affiliations);
+
+  int maximumAge() const;
+  void setMaximumAge(int maximumAge);
+
+  Rejection check(const Message& message) const;
+  bool accepts(const Message& message) const;
+
+  static QChar affiliation(const QString& symbolId);
+
+private:
+  bool isInArea(double x, double y) const;
+  bool intersectsArea(double xMin, double yMin, double xMax, double yMax) const;
+
+  // area of interest in WGS84, as a bounding box and an optional polygon within it
+  bool m_hasArea = false;
+  double m_xMin = 0.0;
+  double m_yMin = 0.0;
+  double m_xMax = 0.0;
+  double m_yMax = 0.0;
+  QVector<QPointF> m_polygon;
+
+  // bit per affiliation letter 'A' to 'Z', 0 accepts every affiliation
+  quint32 m_affiliationMask = 0;
+
+  // in seconds, 0 accepts messages of any age
+  int m_maximumAge = 0;
+};
+
+} // Dsa
+
+#endif // MESSAGEINGESTFILTER_H
@@ -0,0 +1,357 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "MessageSnapshotSync.h"
+
+// dsa app headers
+#include "MessageFeed.h"
+#include "MessageFeedListModel.h"
+#include "MessagesOverlay.h"
+#include "OutboundTransport.h"
+
+// Qt headers
+#include <QDataStream>
+#include <QNetworkDatagram>
+#include <QRandomGenerator>
+#include <QTimer>
+#include <QUdpSocket>
+#include <QtEndian>
+
+// STL headers
+#include <cstring>
+
+namespace Dsa {
+
+namespace {
+
+// "DSAS", version, request nonce
+constexpr char s_requestMagic[] = {'D', 'S', 'A', 'S'};
+constexpr quint8 s_version = 1;
+constexpr int s_requestSize = 4 + 1 + 4;
+
+// a request without a complete snapshot is retried after this long without a chunk, in ms
+constexpr int s_requestTimeout = 3000;
+constexpr int s_maxRequestAttempts = 3;
+
+// peers wait up to this long before answering, so that only the first answers, in ms
+constexpr int s_maxResponseDelay = 500;
+
+// pace the chunks of a snapshot, as for markups, in ms
+constexpr int s_chunkInterval = 2;
+constexpr int s_sendRetries = 2;
+
+quint32 createNonce()
+{
+  quint32 nonce = 0;
+  while (nonce == 0)
+    nonce = QRandomGenerator::global()->generate();
+
+  return nonce;
+}
+
+} // namespace
+
+/*!
+  \class Dsa::MessageSnapshotSync
+  \inmodule Dsa
+  \inherits QObject
+  \brief Fills the message feeds of a node which starts or joins the net with a
+  snapshot of the feeds of a peer, rather than waiting for every track to report again.
+
+  A node sends a request to the snapshot port with \l requestSnapshot. Every peer
+  which hears it waits a random delay of up to half a second and then answers with
+  the current graphics of all of its feeds, unless it hears another peer answering
+  first. The answer is a single blob of GeoMessages which is compressed and sent as
+  numbered chunks with the \l MarkupChunker format, at bulk priority so that live
+  traffic goes first. A request is a datagram of 9 bytes: the magic bytes \c DSAS, a
+  version byte and a random 32 bit nonce, big endian. The blob starts with the nonce
+  of the request it answers.
+
+  Once all of the chunks of an answer have arrived, \l snapshotReceived is emitted
+  with the messages so that they can be added to the overlays in a single batch.
+  Any chunk lost means the request is sent again, up to three times.
+ */
+
+/*!
+  \brief Constructor taking the \a messageFeeds whose overlays are served and an optional \a parent.
+ */
+MessageSnapshotSync::MessageSnapshotSync(MessageFeedListModel* messageFeeds, QObject* parent) :
+  QObject(parent),
+  m_messageFeeds(messageFeeds),
+  m_requestTimer(new QTimer(this)),
+  m_chunkTimer(new QTimer(this))
+{
+  m_requestTimer->setSingleShot(true);
+  m_requestTimer->setInterval(s_requestTimeout);
+  connect(m_requestTimer, &QTimer::timeout, this, &MessageSnapshotSync::sendRequest);
+
+  m_chunkTimer->setInterval(s_chunkInterval);
+  connect(m_chunkTimer, &QTimer::timeout, this, &MessageSnapshotSync::sendNextChunk);
+}
+
+/*!
+  \brief Destructor.
+ */
+MessageSnapshotSync::~MessageSnapshotSync()
+{
+}
+
+/*!
+  \brief Starts listening for snapshot requests and answers on \a port with \a transport.
+
+  Returns \c false if the port could not be bound.
+ */
+bool MessageSnapshotSync::start(const UdpTransport& transport, quint16 port)
+{
+  if (m_socket || port == 0)
+    return false;
+
+  m_transport = transport;
+  m_port = port;
+  m_socket = m_transport.createListener(m_port, this);
+  if (m_socket->state() != QAbstractSocket::BoundState)
+  {
+    delete m_socket;
+    m_socket = nullptr;
+    return false;
+  }
+
+  connect(m_socket, &QUdpSocket::readyRead, this, &MessageSnapshotSync::readDatagrams);
+  return true;
+}
+
+/*!
+  \brief Returns the snapshot port, or \c 0 if not started.
+ */
+quint16 MessageSnapshotSync::port() const
+{
+  return m_socket ? m_port : 0;
+}
+
+/*!
+  \brief Asks the peers for a snapshot of their message feeds.
+
+  Nothing is sent unless the sync has been \l {start}{started}.
+ */
+void MessageSnapshotSync::requestSnapshot()
+{
+  if (!m_socket)
+    return;
+
+  m_requestAttempts = 0;
+  sendRequest();
+}
+
+/*!
+  \brief Returns whether a snapshot has been requested and has not yet arrived.
+ */
+bool MessageSnapshotSync::isRequestPending() const
+{
+  return m_requestNonce != 0;
+}
+
+/*!
+  \internal
+  \brief Sends the request again with a new nonce, or gives up after the last attempt.
+ */
+void MessageSnapshotSync::sendRequest()
+{
+  if (m_requestAttempts >= s_maxRequestAttempts)
+  {
+    m_requestNonce = 0;
+    return;
+  }
+
+  ++m_requestAttempts;
+  m_requestNonce = createNonce();
+
+  QByteArray request(s_requestSize, Qt::Uninitialized);
+  char* data = request.data();
+  memcpy(data, s_requestMagic, sizeof(s_requestMagic));
+  data[4] = static_cast<char>(s_version);
+  qToBigEndian<quint32>(m_requestNonce, data + 5);
+
+  sendData(request);
+  m_requestTimer->start();
+}
+
+/*!
+  \internal
+ */
+void MessageSnapshotSync::readDatagrams()
+{
+  while (m_socket->hasPendingDatagrams())
+  {
+    const QByteArray datagram = m_socket->receiveDatagram().data();
+
+    if (datagram.size() == s_requestSize &&
+        memcmp(datagram.constData(), s_requestMagic, sizeof(s_requestMagic)) == 0 &&
+        static_cast<quint8>(datagram.at(4)) == s_version)
+    {
+      handleRequest(qFromBigEndian<quint32>(datagram.constData() + 5));
+      continue;
+    }
+
+    if (!MarkupChunker::isChunk(datagram))
+      continue;
+
+    // another peer is answering, so this node need not
+    m_responseNonce = 0;
+
+    if (m_requestNonce == 0)
+      continue;
+
+    // the transfer is alive, so wait for the rest of it
+    m_requestTimer->start();
+
+    QByteArray payload;
+    if (m_chunker.addChunk(datagram, payload))
+      handleSnapshot(payload);
+  }
+}
+
+/*!
+  \internal
+  \brief Schedules an answer to the request with \a nonce from another node.
+ */
+void MessageSnapshotSync::handleRequest(quint32 nonce)
+{
+  // our own request, or one which is already being answered
+  if (nonce == m_requestNonce || m_responseNonce != 0 || !m_pendingChunks.isEmpty())
+    return;
+
+  m_responseNonce = nonce;
+  QTimer::singleShot(QRandomGenerator::global()->bounded(s_maxResponseDelay), this, [this, nonce]
+  {
+    if (m_responseNonce != nonce)
+      return;
+
+    m_responseNonce = 0;
+    sendSnapshot(nonce);
+  });
+}
+
+/*!
+  \internal
+  \brief Emits the messages of a reassembled snapshot \a payload if it answers this node's request.
+ */
+void MessageSnapshotSync::handleSnapshot(const QByteArray& payload)
+{
+  QDataStream stream(payload);
+  quint32 nonce = 0;
+  stream >> nonce;
+  if (stream.status() != QDataStream::Ok || nonce != m_requestNonce)
+    return;
+
+  m_requestNonce = 0;
+  m_requestTimer->stop();
+
+  QList<Message> messages;
+  while (!stream.atEnd())
+  {
+    QByteArray data;
+    stream >> data;
+    if (stream.status() != QDataStream::Ok)
+      break;
+
+    Message message = Message::create(data);
+    if (!message.isEmpty())
+      messages.append(message);
+  }
+
+  emit snapshotReceived(messages);
+}
+
+/*!
+  \internal
+  \brief Queues the chunks of a snapshot answering the request with \a nonce.
+
+  Nothing is sent if no feed has any graphics.
+ */
+void MessageSnapshotSync::sendSnapshot(quint32 nonce)
+{
+  const QByteArray snapshot = encodeSnapshot(nonce);
+  if (snapshot.isEmpty())
+    return;
+
+  m_pendingChunks = MarkupChunker::split(snapshot);
+  if (!m_pendingChunks.isEmpty() && !m_chunkTimer->isActive())
+    m_chunkTimer->start();
+}
+
+/*!
+  \internal
+  \brief Sends the next queued chunk.
+ */
+void MessageSnapshotSync::sendNextChunk()
+{
+  if (m_pendingChunks.isEmpty())
+  {
+    m_chunkTimer->stop();
+    return;
+  }
+
+  sendData(m_pendingChunks.takeFirst());
+}
+
+/*!
+  \internal
+  \brief Queues \a data on the shared outbound transport, behind live traffic.
+ */
+void MessageSnapshotSync::sendData(const QByteArray& data)
+{
+  OutboundTransport::SendOptions options;
+  options.m_priority = OutboundTransport::Priority::Bulk;
+  options.m_retries = s_sendRetries;
+  OutboundTransport::instance()->send(m_transport, m_port, data, options);
+}
+
+/*!
+  \internal
+  \brief Returns the blob answering the request with \a nonce: the nonce followed by
+  a GeoMessage for each graphic of every feed, or an empty array if there are none.
+ */
+QByteArray MessageSnapshotSync::encodeSnapshot(quint32 nonce) const
+{
+  QByteArray snapshot;
+  QDataStream stream(&snapshot, QIODevice::WriteOnly);
+  stream << nonce;
+
+  int messageCount = 0;
+  for (int i = 0; i < m_messageFeeds->count(); ++i)
+  {
+    const MessagesOverlay* overlay = m_messageFeeds->at(i)->messagesOverlay();
+    const auto messages = overlay->snapshotMessages();
+    for (const auto& message : messages)
+      stream << message.toGeoMessage();
+
+    messageCount += messages.size();
+  }
+
+  return messageCount > 0 ? snapshot : QByteArray();
+}
+
+} // Dsa
+
+// Signal Documentation
+/*!
+  \fn void MessageSnapshotSync::snapshotReceived(const QList<Message>& messages);
+  \brief Signal emitted when a snapshot answering this node's request has arrived,
+  with the \a messages reproducing the graphics of the peer's feeds.
+ */
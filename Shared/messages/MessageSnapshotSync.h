@@ -0,0 +1,85 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef MESSAGESNAPSHOTSYNC_H
+#define MESSAGESNAPSHOTSYNC_H
+
+// dsa app headers
+#include "MarkupChunker.h"
+#include "Message.h"
+#include "UdpTransport.h"
+
+// Qt headers
+#include <QByteArray>
+#include <QList>
+#include <QObject>
+
+class QTimer;
+class QUdpSocket;
+
+namespace Dsa {
+
+class MessageFeedListModel;
+
+class MessageSnapshotSync : public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit MessageSnapshotSync(MessageFeedListModel* messageFeeds, QObject* parent = nullptr);
+  ~MessageSnapshotSync();
+
+  bool start(const UdpTransport& transport, quint16 port);
+  quint16 port() const;
+
+  void requestSnapshot();
+  bool isRequestPending() const;
+
+signals:
+  void snapshotReceived(const QList<Message>& messages);
+
+private:
+  Q_DISABLE_COPY(MessageSnapshotSync)
+
+  void readDatagrams();
+  void handleRequest(quint32 nonce);
+  void handleSnapshot(const QByteArray& payload);
+  void sendRequest();
+  void sendSnapshot(quint32 nonce);
+  void sendNextChunk();
+  void sendData(const QByteArray& data);
+  QByteArray encodeSnapshot(quint32 nonce) const;
+
+  MessageFeedListModel* m_messageFeeds = nullptr;
+  UdpTransport m_transport;
+  quint16 m_port = 0;
+  QUdpSocket* m_socket = nullptr;
+  MarkupChunker m_chunker;
+
+  // the outstanding request of this node, retried until a snapshot arrives
+  quint32 m_requestNonce = 0;
+  int m_requestAttempts = 0;
+  QTimer* m_requestTimer = nullptr;
+
+  // the request of another node this node will answer, unless another peer answers first
+  quint32 m_responseNonce = 0;
+  QList<QByteArray> m_pendingChunks;
+  QTimer* m_chunkTimer = nullptr;
+};
+
+} // Dsa
+
+#endif // MESSAGESNAPSHOTSYNC_H
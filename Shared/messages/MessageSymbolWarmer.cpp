@@ -0,0 +1,314 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "MessageSymbolWarmer.h"
+
+// dsa app headers
+#include "Message.h"
+#include "MessagesOverlay.h"
+
+// C++ API headers
+#include "AttributeListModel.h"
+#include "GeoView.h"
+#include "GraphicListModel.h"
+#include "GraphicsOverlay.h"
+#include "GraphicsOverlayListModel.h"
+
+// Qt headers
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QTimer>
+
+// STL headers
+#include <algorithm>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+namespace {
+
+// the most recent symbol IDs kept for each style
+constexpr int s_maxSymbolIds = 2048;
+
+// warm-up graphics are added in small batches so that each frame generates only a few symbols
+constexpr int s_warmUpInterval = 50;
+constexpr int s_warmUpBatchSize = 16;
+
+// how long the last warm-up graphics are kept for their symbols to be generated, in ms
+constexpr int s_warmUpHoldTime = 2000;
+
+// new symbol IDs are written at most this often, in ms
+constexpr int s_saveDelay = 10000;
+
+// faint enough not to be noticed, but still drawn
+constexpr float s_warmUpOpacity = 0.01f;
+
+} // namespace
+
+/*!
+  \class Dsa::MessageSymbolWarmer
+  \inmodule Dsa
+  \inherits QObject
+  \brief Generates the dictionary symbols of previously seen SIDCs at startup.
+
+  The first graphic with a new SIDC in a \l MessagesOverlay drawn by a
+  \l Esri::ArcGISRuntime::DictionaryRenderer stalls a frame while the symbol
+  is generated from the style. When a feed connects, many unit types arrive
+  at once and the stalls add up to visible jank.
+
+  The warmer records the SIDCs of the tracks added to each overlay, per
+  symbol style, and persists the most recent ones across sessions. When an
+  overlay is added, a faint overlay sharing its renderer is filled with one
+  graphic per known SIDC, a few at a time, so the symbols are generated and
+  cached before the feed delivers them.
+ */
+
+/*!
+  \brief Constructor taking the \a cachePath of the file holding the known
+  symbol IDs, and an optional \a parent.
+ */
+MessageSymbolWarmer::MessageSymbolWarmer(const QString& cachePath, QObject* parent) :
+  QObject(parent),
+  m_cachePath(cachePath),
+  m_warmUpTimer(new QTimer(this)),
+  m_saveTimer(new QTimer(this))
+{
+  m_warmUpTimer->setInterval(s_warmUpInterval);
+  connect(m_warmUpTimer, &QTimer::timeout, this, &MessageSymbolWarmer::warmUpNextBatch);
+
+  m_saveTimer->setSingleShot(true);
+  m_saveTimer->setInterval(s_saveDelay);
+  connect(m_saveTimer, &QTimer::timeout, this, &MessageSymbolWarmer::save);
+
+  load();
+}
+
+/*!
+  \brief Destructor.
+
+  Saves any symbol IDs seen since the last save.
+ */
+MessageSymbolWarmer::~MessageSymbolWarmer()
+{
+  if (m_saveTimer->isActive())
+    save();
+}
+
+/*!
+  \brief Records the symbol IDs of the graphics added to \a overlay under the
+  \a styleName of its dictionary renderer, such as \c mil2525d.
+
+  The first overlay for each style starts warming up the symbols of the
+  style's known symbol IDs.
+ */
+void MessageSymbolWarmer::addOverlay(MessagesOverlay* overlay, const QString& styleName)
+{
+  if (!overlay || !overlay->renderer() || !overlay->geoView())
+    return;
+
+  connect(overlay, &MessagesOverlay::graphicsAdded, this, [this, overlay, styleName](int index, int count)
+  {
+    recordSymbolIds(styleName, overlay, index, count);
+  });
+
+  StyleSymbols& style = m_styles[styleName];
+  if (style.m_warmedUp)
+    return;
+
+  style.m_warmedUp = true;
+  if (style.m_previous.isEmpty())
+    return;
+
+  GraphicsOverlay* graphicsOverlay = new GraphicsOverlay(this);
+  graphicsOverlay->setRenderingMode(GraphicsRenderingMode::Dynamic);
+  graphicsOverlay->setSceneProperties(LayerSceneProperties(overlay->surfacePlacement()));
+  graphicsOverlay->setRenderer(overlay->renderer());
+  graphicsOverlay->setOpacity(s_warmUpOpacity);
+  overlay->geoView()->graphicsOverlays()->append(graphicsOverlay);
+
+  // the most recently seen symbols are generated first
+  QStringList pending = style.m_previous;
+  std::reverse(pending.begin(), pending.end());
+  m_warmUps.append(WarmUp{overlay->geoView(), graphicsOverlay, pending});
+
+  if (!m_warmUpTimer->isActive())
+  {
+    m_warmUpTimer->start();
+    emit warmingUpChanged();
+  }
+}
+
+/*!
+  \brief Returns the known symbol IDs for \a styleName, most recently seen last.
+ */
+QStringList MessageSymbolWarmer::symbolIds(const QString& styleName) const
+{
+  const auto styleIt = m_styles.constFind(styleName);
+  if (styleIt == m_styles.constEnd())
+    return QStringList();
+
+  QStringList symbolIds;
+  for (const auto& symbolId : styleIt->m_previous)
+  {
+    if (!styleIt->m_seenSet.contains(symbolId))
+      symbolIds.append(symbolId);
+  }
+  symbolIds.append(styleIt->m_seen);
+
+  if (symbolIds.size() > s_maxSymbolIds)
+    symbolIds.erase(symbolIds.begin(), symbolIds.end() - s_maxSymbolIds);
+
+  return symbolIds;
+}
+
+/*!
+  \brief Returns whether symbols are still being warmed up.
+ */
+bool MessageSymbolWarmer::isWarmingUp() const
+{
+  return m_warmUpTimer->isActive();
+}
+
+/*!
+  \brief Writes the known symbol IDs of each style to the cache file.
+ */
+void MessageSymbolWarmer::save()
+{
+  m_saveTimer->stop();
+
+  QJsonObject cacheJson;
+  for (auto it = m_styles.cbegin(); it != m_styles.cend(); ++it)
+    cacheJson.insert(it.key(), QJsonArray::fromStringList(symbolIds(it.key())));
+
+  QDir().mkpath(QFileInfo(m_cachePath).absolutePath());
+
+  QSaveFile cacheFile(m_cachePath);
+  if (!cacheFile.open(QIODevice::WriteOnly))
+    return;
+
+  cacheFile.write(QJsonDocument(cacheJson).toJson(QJsonDocument::Compact));
+  cacheFile.commit();
+}
+
+/*!
+  \internal
+  \brief Records the symbol IDs of the \a count graphics added to \a overlay at \a index.
+ */
+void MessageSymbolWarmer::recordSymbolIds(const QString& styleName, MessagesOverlay* overlay, int index, int count)
+{
+  StyleSymbols& style = m_styles[styleName];
+  GraphicListModel* graphics = overlay->graphicsOverlay()->graphics();
+
+  bool changed = false;
+  for (int i = index; i < index + count; ++i)
+  {
+    const QString symbolId = graphics->at(i)->attributes()->attributeValue(Message::SIDC_NAME).toString();
+    if (symbolId.isEmpty() || style.m_seenSet.contains(symbolId))
+      continue;
+
+    style.m_seenSet.insert(symbolId);
+    style.m_seen.append(symbolId);
+    changed = true;
+  }
+
+  if (changed && !m_saveTimer->isActive())
+    m_saveTimer->start();
+}
+
+/*!
+  \internal
+  \brief Adds the next few warm-up graphics, and removes the warm-up overlays
+  which have had time to generate all of their symbols.
+ */
+void MessageSymbolWarmer::warmUpNextBatch()
+{
+  if (m_warmUps.isEmpty())
+  {
+    m_warmUpTimer->stop();
+    emit warmingUpChanged();
+    return;
+  }
+
+  WarmUp& warmUp = m_warmUps.first();
+
+  // place the graphics in view so that they are drawn
+  const Geometry center = warmUp.m_geoView->currentViewpoint(ViewpointType::CenterAndScale).targetGeometry();
+  const Point location = center.isEmpty() ? Point(0.0, 0.0, SpatialReference::wgs84()) : Point(center);
+
+  QList<Graphic*> batch;
+  while (!warmUp.m_pending.isEmpty() && batch.size() < s_warmUpBatchSize)
+  {
+    const QVariantMap attributes{{Message::SIDC_NAME, warmUp.m_pending.takeLast()}};
+    batch.append(new Graphic(location, attributes, warmUp.m_graphicsOverlay));
+  }
+  warmUp.m_graphicsOverlay->graphics()->append(batch);
+
+  if (!warmUp.m_pending.isEmpty())
+    return;
+
+  GeoView* geoView = warmUp.m_geoView;
+  GraphicsOverlay* graphicsOverlay = warmUp.m_graphicsOverlay;
+  m_warmUps.removeFirst();
+
+  QTimer::singleShot(s_warmUpHoldTime, this, [geoView, graphicsOverlay]()
+  {
+    GraphicsOverlayListModel* graphicsOverlays = geoView->graphicsOverlays();
+    const int index = graphicsOverlays->indexOf(graphicsOverlay);
+    if (index != -1)
+      graphicsOverlays->removeAt(index);
+
+    graphicsOverlay->deleteLater();
+  });
+}
+
+/*!
+  \internal
+  \brief Reads the symbol IDs seen in previous sessions from the cache file.
+ */
+void MessageSymbolWarmer::load()
+{
+  QFile cacheFile(m_cachePath);
+  if (!cacheFile.open(QIODevice::ReadOnly))
+    return;
+
+  const QJsonObject cacheJson = QJsonDocument::fromJson(cacheFile.readAll()).object();
+  for (auto it = cacheJson.constBegin(); it != cacheJson.constEnd(); ++it)
+  {
+    QStringList symbolIds;
+    const QJsonArray symbolIdsJson = it.value().toArray();
+    for (const auto& symbolId : symbolIdsJson)
+      symbolIds.append(symbolId.toString());
+
+    m_styles[it.key()].m_previous = symbolIds;
+  }
+}
+
+} // Dsa
+
+// Signal Documentation
+/*!
+  \fn void MessageSymbolWarmer::warmingUpChanged();
+  \brief Signal emitted when symbols start or stop being warmed up.
+ */
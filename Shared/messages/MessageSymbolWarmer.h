@@ -0,0 +1,93 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef MESSAGESYMBOLWARMER_H
+#define MESSAGESYMBOLWARMER_H
+
+// Qt headers
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+
+class QTimer;
+
+namespace Esri
+{
+  namespace ArcGISRuntime
+  {
+    class GeoView;
+    class GraphicsOverlay;
+  }
+}
+
+namespace Dsa {
+
+class MessagesOverlay;
+
+class MessageSymbolWarmer : public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit MessageSymbolWarmer(const QString& cachePath, QObject* parent = nullptr);
+  ~MessageSymbolWarmer();
+
+  void addOverlay(MessagesOverlay* overlay, const QString& styleName);
+
+  QStringList symbolIds(const QString& styleName) const;
+
+  bool isWarmingUp() const;
+
+  void save();
+
+signals:
+  void warmingUpChanged();
+
+private:
+  Q_DISABLE_COPY(MessageSymbolWarmer)
+
+  // the symbol IDs of a style seen in earlier sessions and in this one, most recent last
+  struct StyleSymbols
+  {
+    QStringList m_previous;
+    QStringList m_seen;
+    QSet<QString> m_seenSet;
+    bool m_warmedUp = false;
+  };
+
+  struct WarmUp
+  {
+    Esri::ArcGISRuntime::GeoView* m_geoView = nullptr;
+    Esri::ArcGISRuntime::GraphicsOverlay* m_graphicsOverlay = nullptr;
+    QStringList m_pending;
+  };
+
+  void recordSymbolIds(const QString& styleName, MessagesOverlay* overlay, int index, int count);
+  void warmUpNextBatch();
+  void load();
+
+  QString m_cachePath;
+  QHash<QString, StyleSymbols> m_styles;
+  QList<WarmUp> m_warmUps;
+  QTimer* m_warmUpTimer = nullptr;
+  QTimer* m_saveTimer = nullptr;
+};
+
+} // Dsa
+
+#endif // MESSAGESYMBOLWARMER_H
@@ -20,17 +20,83 @@
 #include "MessagesOverlay.h"
 
 // dsa app headers
+#include "ElevationSampleCache.h"
+#include "GraphicAttributeIndex.h"
 #include "Message.h"
+#include "MessageClusterOverlay.h"
+#include "MessageFeedStats.h"
+#include "MessageIdTable.h"
+#include "TraceRecorder.h"
+#include "TrackBreadcrumbOverlay.h"
+#include "ViewportInterestArea.h"
 
 // C++ API headers
+#include "AttributeListModel.h"
+#include "GeometryEngine.h"
 #include "GeoView.h"
+#include "GraphicListModel.h"
 #include "GraphicsOverlay.h"
+#include "GraphicsOverlayListModel.h"
+#include "Point.h"
 #include "Renderer.h"
 
+// Qt headers
+#include <QDateTime>
+#include <QTimer>
+
+// STL headers
+#include <algorithm>
+#include <functional>
+
 using namespace Esri::ArcGISRuntime;
 
 namespace Dsa {
 
+// flush coalesced updates roughly once per rendered frame
+static const int s_defaultFlushInterval = 16;
+
+// stale graphics are swept for at most this many graphics per interval, in ms
+static const int s_sweepInterval = 1000;
+static const int s_sweepBatchSize = 512;
+
+// the automatic rendering mode is checked this often, in ms
+static const int s_renderingModeInterval = 10000;
+
+// overlays with fewer graphics than this are always drawn in dynamic mode
+static const int s_staticMinimumGraphics = 500;
+
+// updates per graphic per second below which an overlay is drawn in static mode, and
+// above which it returns to dynamic mode. They differ so that the mode does not flip
+static const double s_staticUpdateRate = 1.0 / 60.0;
+static const double s_dynamicUpdateRate = 1.0 / 20.0;
+
+// tracks waiting for their ground elevation are retried this often, in ms, and at
+// most this many tiles are requested from the elevation cache for them at once
+static const int s_elevationRetryInterval = 1000;
+static const int s_maximumPendingElevationTiles = 8;
+
+// attribute set on graphics which have not been updated for the fade age
+static const QString s_staleAttributeName = QStringLiteral("_stale");
+
+// hash of everything an update writes to a graphic, used to detect unchanged updates
+static uint messageFingerprint(const Message& message)
+{
+  const Point point(message.geometry());
+  uint hash = qHash(message.geometry().spatialReference().wkid());
+  hash = qHash(point.x(), hash);
+  hash = qHash(point.y(), hash);
+  hash = qHash(point.z(), hash);
+  return message.messageAttributes().fingerprint(hash);
+}
+
+// the point geometry in WGS84
+static Point wgs84Point(const Geometry& geometry)
+{
+  const SpatialReference spatialReference = geometry.spatialReference();
+  const bool isWgs84 = spatialReference.isEmpty() || spatialReference == SpatialReference::wgs84();
+  return isWgs84 ? Point(geometry) : Point(GeometryEngine::project(geometry, SpatialReference::wgs84()));
+}
+
 /*!
   \class Dsa::MessagesOverlay
   \inmodule Dsa
@@ -40,6 +106,15 @@ namespace Dsa {
 
   The overlay currently only supports messages containing a
   point geometry type.
+
+  Graphics are drawn in dynamic mode by default, which suits tracks that move
+  often. Overlays of mostly static objects, such as control measures, can be drawn
+  in static mode instead, or left to pick their mode automatically; see
+  \l setRenderingPolicy.
+
+  Draped graphics have the elevation of the surface resolved for every symbol on
+  every frame. Dense feeds of ground tracks can instead have their ground elevation
+  \l {setGroundElevationResolved}{resolved} once for each new position.
  */
 
 /*!
@@ -60,11 +135,31 @@ MessagesOverlay::MessagesOverlay(GeoView* geoView, Renderer* renderer, const QSt
   m_geoView(geoView),
   m_renderer(renderer),
   m_surfacePlacement(surfacePlacement),
-  m_graphicsOverlay(new GraphicsOverlay(this))
+  m_graphicsOverlay(new GraphicsOverlay(this)),
+  m_flushTimer(new QTimer(this)),
+  m_stats(new MessageFeedStats(this)),
+  m_attributeIndex(new GraphicAttributeIndex(m_graphicsOverlay, this)),
+  m_sweepTimer(new QTimer(this)),
+  m_renderingModeTimer(new QTimer(this)),
+  m_elevationTimer(new QTimer(this))
 {
+  m_flushTimer->setSingleShot(true);
+  m_flushTimer->setInterval(s_defaultFlushInterval);
+  connect(m_flushTimer, &QTimer::timeout, this, &MessagesOverlay::flush);
+
+  m_ageClock.start();
+  m_sweepTimer->setInterval(s_sweepInterval);
+  connect(m_sweepTimer, &QTimer::timeout, this, &MessagesOverlay::expireStaleGraphics);
+
+  m_renderingModeTimer->setInterval(s_renderingModeInterval);
+  connect(m_renderingModeTimer, &QTimer::timeout, this, &MessagesOverlay::updateRenderingMode);
+
+  m_elevationTimer->setInterval(s_elevationRetryInterval);
+  connect(m_elevationTimer, &QTimer::timeout, this, &MessagesOverlay::resolvePendingElevations);
+
   m_graphicsOverlay->setOverlayId(messageType);
   m_graphicsOverlay->setRenderingMode(GraphicsRenderingMode::Dynamic);
-  m_graphicsOverlay->setSceneProperties(LayerSceneProperties(m_surfacePlacement));
+  updateSceneProperties();
   m_graphicsOverlay->setRenderer(m_renderer);
   m_geoView->graphicsOverlays()->append(m_graphicsOverlay);
 }
@@ -74,6 +169,13 @@ MessagesOverlay::MessagesOverlay(GeoView* geoView, Renderer* renderer, const QSt
  */
 MessagesOverlay::~MessagesOverlay()
 {
+  // release the message keys held for the graphics
+  MessageIdTable* idTable = MessageIdTable::instance();
+  for (int messageKey = 0; messageKey < m_existingGraphics.size(); ++messageKey)
+  {
+    if (m_existingGraphics.at(messageKey))
+      idTable->release(messageKey);
+  }
 }
 
 /*!
@@ -115,7 +217,53 @@ void MessagesOverlay::setSurfacePlacement(SurfacePlacement surfacePlacement)
 
   m_surfacePlacement = surfacePlacement;
 
-  m_graphicsOverlay->setSceneProperties(LayerSceneProperties(m_surfacePlacement));
+  updateSceneProperties();
+}
+
+/*!
+  \brief Returns whether graphics are placed at the ground elevation sampled for
+  each new position, rather than by the surface placement.
+
+  The default is \c false.
+ */
+bool MessagesOverlay::isGroundElevationResolved() const
+{
+  return m_groundElevationResolved;
+}
+
+/*!
+  \brief Sets whether graphics are placed at the ground elevation sampled for each
+  new position to \a groundElevationResolved.
+
+  When \c true, the ground elevation of each position is looked up in the
+  \l ElevationSampleCache as the position is applied, and the graphic is drawn with
+  that elevation and \c SurfacePlacement::Absolute. The renderer then has no surface
+  to resolve for each symbol on each frame. Positions whose tile has not been sampled
+  keep the track's last elevation until it has. Any elevation in the messages is
+  replaced, so this suits ground tracks.
+
+  Trails and clusters keep the \l surfacePlacement.
+ */
+void MessagesOverlay::setGroundElevationResolved(bool groundElevationResolved)
+{
+  if (m_groundElevationResolved == groundElevationResolved)
+    return;
+
+  m_groundElevationResolved = groundElevationResolved;
+  updateSceneProperties();
+
+  disconnect(m_tileLoadedConnection);
+  if (m_groundElevationResolved)
+  {
+    m_tileLoadedConnection = connect(ElevationSampleCache::instance(), &ElevationSampleCache::tileLoaded,
+                                     this, &MessagesOverlay::resolvePendingElevations);
+  }
+  else
+  {
+    m_elevationTimer->stop();
+    m_pendingElevations.clear();
+    m_groundElevations.clear();
+  }
 }
 
 /*!
@@ -155,135 +303,1390 @@ GeoView* MessagesOverlay::geoView() const
 
 /*!
   \brief Adds the \l Message \a message to the overlay. Returns whether adding was successful.
+
+  If the overlay is \l {isCoalescingUpdates}{coalescing updates}, the message is queued
+  and only applied to the overlay at the next flush. In that case, \c true is returned
+  once the message has been queued.
  */
 bool MessagesOverlay::addMessage(const Message& message)
 {
-  const auto messageId = message.messageId();
-  if (messageId.isEmpty())
+  DSA_TRACE_SCOPE("MessagesOverlay::addMessage");
+
+  if (!isValidMessage(message))
   {
-    emit errorOccurred(QStringLiteral("Failed to add message - message ID is empty"));
+    m_stats->recordRejected();
     return false;
   }
 
-  if (message.messageType() != messageType())
+  if (!m_coalescingUpdates)
   {
-    emit errorOccurred(QStringLiteral("Failed to add message - message type mismatch"));
-    return false;
-  }
+    QList<Graphic*> newGraphics;
+    if (!applyAndRecordMessage(message, newGraphics))
+      return false;
 
-  const auto symbolId = message.symbolId();
-  const auto geometry = message.geometry();
-  const auto messageAction = message.messageAction();
+    appendGraphics(newGraphics);
+    emitChangedGraphics();
 
-  if (messageAction == Message::MessageAction::Update)
+    return true;
+  }
+
+  // only the latest message for each ID is applied on the next flush. As in isOutOfOrder,
+  // a message without an event time is never older than the pending one
+  auto pendingIt = m_pendingMessages.find(message.messageKey());
+  if (pendingIt != m_pendingMessages.end())
   {
-    if (m_renderer && m_renderer->rendererType() == RendererType::DictionaryRenderer && symbolId.isEmpty())
+    if (message.eventTime() > 0 && message.eventTime() < pendingIt.value().eventTime())
     {
-      emit errorOccurred(QStringLiteral("Failed to add message - symbol ID is empty"));
-      return false;
+      m_stats->recordOutOfOrder();
+      return true;
     }
 
-    if (geometry.isEmpty())
+    m_stats->recordCoalesced();
+    pendingIt.value() = message;
+  }
+  else
+  {
+    m_pendingMessages.insert(message.messageKey(), message);
+  }
+
+  if (!m_flushTimer->isActive())
+    m_flushTimer->start();
+
+  return true;
+}
+
+/*!
+  \brief Adds the list of \l Message objects \a messages to the overlay.
+  Returns whether adding all of the messages was successful.
+
+  Graphics for new messages are appended to the graphics overlay as a single block.
+  As well as the graphic list model's own notifications, \l graphicsAdded is emitted
+  once for the whole block, allowing consumers to update once rather than for every
+  graphic.
+
+  If the overlay is \l {isCoalescingUpdates}{coalescing updates}, the messages are queued
+  and applied as a block at the next flush.
+ */
+bool MessagesOverlay::addMessages(const QList<Message>& messages)
+{
+  DSA_TRACE_SCOPE("MessagesOverlay::addMessages");
+
+  bool success = true;
+
+  if (m_coalescingUpdates)
+  {
+    for (const auto& message : messages)
     {
-      emit errorOccurred(QStringLiteral("Failed to add message - geometry is empty"));
-      return false;
+      if (!addMessage(message))
+        success = false;
     }
 
-    if (geometry.geometryType() != GeometryType::Point)
+    return success;
+  }
+
+  QList<Graphic*> newGraphics;
+  for (const auto& message : messages)
+  {
+    if (!isValidMessage(message))
     {
-      emit errorOccurred(QStringLiteral("Failed to add message - only point geometry types are supported"));
-      return false;
+      m_stats->recordRejected();
+      success = false;
+    }
+    else if (!applyAndRecordMessage(message, newGraphics))
+    {
+      success = false;
     }
   }
 
-  if (m_existingGraphics.contains(messageId))
+  appendGraphics(newGraphics);
+  emitChangedGraphics();
+
+  return success;
+}
+
+/*!
+  \brief Returns the MessagesOverlay which manages \a graphicsOverlay, or \c nullptr
+  if the graphics overlay was not created by a MessagesOverlay.
+ */
+MessagesOverlay* MessagesOverlay::fromGraphicsOverlay(GraphicsOverlay* graphicsOverlay)
+{
+  if (!graphicsOverlay)
+    return nullptr;
+
+  return qobject_cast<MessagesOverlay*>(graphicsOverlay->parent());
+}
+
+/*!
+  \brief Returns the \l MessagesOverlay which created \a graphic, or \c nullptr if the graphic
+  was not created by a messages overlay.
+ */
+MessagesOverlay* MessagesOverlay::fromGraphic(Graphic* graphic)
+{
+  if (!graphic)
+    return nullptr;
+
+  return qobject_cast<MessagesOverlay*>(graphic->parent());
+}
+
+/*!
+  \brief Returns whether the overlay is coalescing updates.
+
+  When coalescing, messages added with \l addMessage are held and keyed by message ID
+  so that only the latest message for each ID is applied to the graphics overlay
+  once per \l flushInterval.
+
+  The default is \c false.
+ */
+bool MessagesOverlay::isCoalescingUpdates() const
+{
+  return m_coalescingUpdates;
+}
+
+/*!
+  \brief Sets whether the overlay is coalescing updates to \a coalescingUpdates.
+
+  Turning coalescing off immediately applies any pending messages.
+
+  \sa isCoalescingUpdates
+ */
+void MessagesOverlay::setCoalescingUpdates(bool coalescingUpdates)
+{
+  if (m_coalescingUpdates == coalescingUpdates)
+    return;
+
+  m_coalescingUpdates = coalescingUpdates;
+
+  if (!m_coalescingUpdates)
+    flush();
+}
+
+/*!
+  \brief Returns the interval, in milliseconds, at which coalesced updates are applied.
+
+  The default is \c 16 milliseconds.
+ */
+int MessagesOverlay::flushInterval() const
+{
+  return m_flushTimer->interval();
+}
+
+/*!
+  \brief Sets the interval, in milliseconds, at which coalesced updates are applied to \a flushInterval.
+ */
+void MessagesOverlay::setFlushInterval(int flushInterval)
+{
+  m_flushTimer->setInterval(flushInterval);
+}
+
+/*!
+  \brief Applies all pending coalesced messages to the graphics overlay.
+ */
+void MessagesOverlay::flush()
+{
+  m_flushTimer->stop();
+
+  if (m_pendingMessages.isEmpty())
+    return;
+
+  const auto pendingMessages = m_pendingMessages;
+  m_pendingMessages.clear();
+
+  QList<Graphic*> newGraphics;
+  for (const auto& message : pendingMessages)
+    applyAndRecordMessage(message, newGraphics);
+
+  appendGraphics(newGraphics);
+  emitChangedGraphics();
+}
+
+/*!
+  \brief Removes every graphic from the overlay, and forgets the pending coalesced
+  messages and the event times of the tracks.
+
+  Messages applied afterwards are not dropped as out of order, even if they are
+  older than those applied before, so that a past state can be shown.
+ */
+void MessagesOverlay::clear()
+{
+  m_flushTimer->stop();
+  m_pendingMessages.clear();
+
+  for (int messageKey = 0; messageKey < m_existingGraphics.size(); ++messageKey)
+  {
+    Graphic* graphic = m_existingGraphics.at(messageKey);
+    if (graphic)
+      removeGraphic(messageKey, graphic);
+  }
+
+  m_lastEventTimes.clear();
+  emitChangedGraphics();
+}
+
+/*!
+  \brief Returns the time, in seconds, after which a graphic which has not been
+  updated is removed from the overlay.
+
+  Feeds rarely send remove messages, so without expiry the overlay keeps every
+  track it has ever seen. The default is \c 0, which never expires graphics.
+ */
+int MessagesOverlay::timeToLive() const
+{
+  return m_timeToLive;
+}
+
+/*!
+  \brief Sets the time to live of graphics which are not updated to \a timeToLive seconds.
+
+  \sa timeToLive
+ */
+void MessagesOverlay::setTimeToLive(int timeToLive)
+{
+  m_timeToLive = qMax(0, timeToLive);
+  updateSweepTimer();
+}
+
+/*!
+  \brief Returns the age, in seconds, after which a graphic which has not been
+  updated is shown as stale.
+
+  Stale graphics are drawn beneath current ones and have a \c _stale attribute
+  set to \c true, which renderers and popups can use to fade them, until they
+  are updated again or expire. The default is \c 0, which never marks graphics
+  as stale.
+
+  \sa timeToLive
+ */
+int MessagesOverlay::fadeAge() const
+{
+  return m_fadeAge;
+}
+
+/*!
+  \brief Sets the age at which graphics are shown as stale to \a fadeAge seconds.
+
+  \sa fadeAge
+ */
+void MessagesOverlay::setFadeAge(int fadeAge)
+{
+  m_fadeAge = qMax(0, fadeAge);
+  updateSweepTimer();
+}
+
+/*!
+  \brief Checks the next batch of graphics for staleness, fading those past the
+  \l fadeAge and removing those past the \l timeToLive or the
+  \l {Message::staleTime}{stale time} of their last message.
+
+  This is called periodically while any of these is set. Only a batch of graphics is
+  checked on each call so that a large overlay does not stall the UI thread.
+ */
+void MessagesOverlay::expireStaleGraphics()
+{
+  if (m_trackAges.isEmpty())
+    return;
+
+  const quint32 now = ageClock();
+  const qint64 currentTime = m_staleTimeCount > 0 ? QDateTime::currentMSecsSinceEpoch() : 0;
+  QList<TrackAge> expiredTracks;
+
+  const int count = qMin(s_sweepBatchSize, m_trackAges.size());
+  for (int i = 0; i < count; ++i)
   {
-    // update existing graphic attributes and geometry
-    // if the graphic already exists in the hash
-    Graphic* graphic = m_existingGraphics[messageId];
+    if (m_sweepPosition >= m_trackAges.size())
+      m_sweepPosition = 0;
 
-    switch (messageAction)
+    TrackAge& trackAge = m_trackAges[m_sweepPosition++];
+    const quint32 age = now - trackAge.m_lastUpdate;
+    if ((m_timeToLive > 0 && age >= static_cast<quint32>(m_timeToLive)) ||
+        (trackAge.m_staleTime > 0 && currentTime >= trackAge.m_staleTime))
     {
-    case Message::MessageAction::Update:
-    case Message::MessageAction::Select:
-    case Message::MessageAction::Unselect:
+      expiredTracks.append(trackAge);
+    }
+    else if (m_fadeAge > 0 && !trackAge.m_stale && age >= static_cast<quint32>(m_fadeAge))
     {
-      const Geometry geom = graphic->geometry();
-      if (geom.geometryType() != geometry.geometryType())
-        return false;
+      trackAge.m_stale = true;
 
-      if (!(geom == geometry))
-        graphic->setGeometry(geometry);
+      // the stale attribute must be cleared by the next update, even if it is unchanged
+      m_fingerprints.remove(trackAge.m_graphic);
 
-      graphic->attributes()->setAttributesMap(message.attributes());
+      AttributeListModel* attributes = trackAge.m_graphic->attributes();
+      if (attributes->containsAttribute(s_staleAttributeName))
+        attributes->replaceAttribute(s_staleAttributeName, true);
+      else
+        attributes->insertAttribute(s_staleAttributeName, true);
 
-      if (messageAction == Message::MessageAction::Select)
-      {
-        graphic->setSelected(true);
-      }
-      else if (messageAction == Message::MessageAction::Unselect)
-      {
-        graphic->setSelected(false);
-      }
+      // attributes written as the track comes into view must keep it stale
+      auto deferredIt = m_deferredAttributes.find(trackAge.m_graphic);
+      if (deferredIt != m_deferredAttributes.end())
+        deferredIt.value().insert(s_staleAttributeName, true);
 
-      break;
-    }
-    case Message::MessageAction::Remove:
-    {
-      m_graphicsOverlay->graphics()->removeOne(graphic);
-      break;
-    }
-    default:
-      emit errorOccurred(QStringLiteral("Unknown message action"));
-      return false;
+      trackAge.m_graphic->setZIndex(-1);
     }
+  }
 
-    return true;
+  if (expiredTracks.isEmpty())
+    return;
+
+  // removal moves the last ages into the swept slots, which are then checked on the next pass
+  for (const auto& trackAge : qAsConst(expiredTracks))
+    removeGraphic(trackAge.m_messageKey, trackAge.m_graphic);
+
+  emitChangedGraphics();
+}
+
+/*!
+  \brief Returns the map scale beyond which the graphics are drawn as clusters.
+
+  The default is \c 0, which never clusters.
+
+  \sa clusterOverlay
+ */
+double MessagesOverlay::clusterScale() const
+{
+  return m_clusterOverlay ? m_clusterOverlay->minScale() : 0.0;
+}
+
+/*!
+  \brief Sets the map scale beyond which the graphics are drawn as clusters to \a clusterScale.
+
+  While clustering, the graphics overlay is hidden and the \l clusterOverlay is
+  shown instead. A \a clusterScale of \c 0 turns clustering off.
+ */
+void MessagesOverlay::setClusterScale(double clusterScale)
+{
+  if (clusterScale <= 0.0)
+  {
+    if (!m_clusterOverlay)
+      return;
+
+    delete m_clusterOverlay;
+    m_clusterOverlay = nullptr;
+    updateVisibility();
+    return;
   }
 
-  if (messageAction != Message::MessageAction::Update)
+  if (!m_clusterOverlay)
   {
-    emit errorOccurred(QStringLiteral("Message action must be Update to add new message"));
-    return false;
+    m_clusterOverlay = new MessageClusterOverlay(this, this);
+    connect(m_clusterOverlay, &MessageClusterOverlay::clusteringChanged, this, &MessagesOverlay::updateVisibility);
   }
 
-  // add new graphic
-  Graphic* graphic = new Graphic(geometry, message.attributes(), this);
-  m_graphicsOverlay->graphics()->append(graphic);
-  m_existingGraphics.insert(messageId, graphic);
+  m_clusterOverlay->setMinScale(clusterScale);
+  updateVisibility();
+}
 
-  return true;
+/*!
+  \brief Returns the overlay drawing the graphics as clusters, or \c nullptr
+  if clustering is off.
+
+  \sa setClusterScale
+ */
+MessageClusterOverlay* MessagesOverlay::clusterOverlay() const
+{
+  return m_clusterOverlay;
 }
 
 /*!
-  \brief Returns whether the overlay is visible.
+  \brief Returns the number of recent positions drawn as a trail behind each track.
+
+  The default is \c 0, which draws no trails.
+
+  \sa breadcrumbOverlay
  */
-bool MessagesOverlay::isVisible() const
+int MessagesOverlay::trailLength() const
 {
-  return m_graphicsOverlay->isVisible();
+  return m_breadcrumbOverlay ? m_breadcrumbOverlay->capacity() : 0;
 }
 
 /*!
-  \brief Sets the overlay to be \a visible.
+  \brief Sets the number of recent positions drawn as a trail behind each track to \a trailLength.
+
+  Positions are recorded from the moment trails are turned on. A \a trailLength
+  of \c 0 turns the trails off.
  */
-void MessagesOverlay::setVisible(bool visible)
+void MessagesOverlay::setTrailLength(int trailLength)
 {
-  if (m_graphicsOverlay->isVisible() == visible)
+  if (trailLength <= 0)
+  {
+    if (!m_breadcrumbOverlay)
+      return;
+
+    delete m_breadcrumbOverlay;
+    m_breadcrumbOverlay = nullptr;
     return;
+  }
 
-  m_graphicsOverlay->setVisible(visible);
+  if (!m_breadcrumbOverlay)
+  {
+    m_breadcrumbOverlay = new TrackBreadcrumbOverlay(this, trailLength, this);
+    updateVisibility();
+    return;
+  }
 
-  emit visibleChanged();
+  m_breadcrumbOverlay->setCapacity(trailLength);
 }
 
-} // Dsa
-
-// Signal Documentation
+/*!
+  \brief Returns whether only the tracks near the current view are drawn.
+
+  The default is \c false.
+
+  \sa setInterestManaged
+ */
+bool MessagesOverlay::isInterestManaged() const
+{
+  return m_interestArea != nullptr;
+}
+
+/*!
+  \brief Sets whether only the tracks near the current view are drawn to \a interestManaged.
+
+  Tracks outside the \l ViewportInterestArea are hidden. Their geometry is still
+  updated, and their attributes kept in the \l attributeIndex, so that alert
+  conditions and the spatial index see every track, but the attributes are
+  only written to the graphics as they come into view. The renderer does not
+  symbolize, and the labels are not updated, for tracks which cannot be seen.
+ */
+void MessagesOverlay::setInterestManaged(bool interestManaged)
+{
+  if (isInterestManaged() == interestManaged)
+    return;
+
+  if (!interestManaged)
+  {
+    delete m_interestArea;
+    m_interestArea = nullptr;
+    m_interestPositions.clear();
+    updateInterest();
+    return;
+  }
+
+  m_interestArea = new ViewportInterestArea(m_geoView, this);
+  connect(m_interestArea, &ViewportInterestArea::areaChanged, this, &MessagesOverlay::updateInterest);
+
+  for (int messageKey = 0; messageKey < m_existingGraphics.size(); ++messageKey)
+  {
+    Graphic* graphic = m_existingGraphics.at(messageKey);
+    if (graphic)
+      isOfInterest(messageKey, graphic->geometry());
+  }
+
+  updateInterest();
+}
+
+/*!
+  \brief Returns the area around the view in which tracks are drawn, or \c nullptr
+  if every track is drawn.
+
+  \sa setInterestManaged
+ */
+ViewportInterestArea* MessagesOverlay::interestArea() const
+{
+  return m_interestArea;
+}
+
+/*!
+  \brief Returns the overlay drawing the trails of the tracks, or \c nullptr
+  if trails are off.
+
+  \sa setTrailLength
+ */
+TrackBreadcrumbOverlay* MessagesOverlay::breadcrumbOverlay() const
+{
+  return m_breadcrumbOverlay;
+}
+
+/*!
+  \brief Returns how the rendering mode of the overlay is chosen.
+
+  The default is \c RenderingPolicy::Dynamic.
+ */
+MessagesOverlay::RenderingPolicy MessagesOverlay::renderingPolicy() const
+{
+  return m_renderingPolicy;
+}
+
+/*!
+  \brief Sets how the rendering mode of the overlay is chosen to \a renderingPolicy.
+
+  \list
+    \li \c RenderingPolicy::Dynamic - graphics are drawn in dynamic mode, which
+         redraws moved graphics at once and suits fast moving tracks.
+    \li \c RenderingPolicy::Static - graphics are drawn in static mode, which is
+         much cheaper to draw for large numbers of graphics, but lags behind updates.
+    \li \c RenderingPolicy::Automatic - the update rate is measured every ten
+         seconds. Overlays of 500 or more graphics whose graphics are updated less
+         than once a minute on average are drawn in static mode, and return to
+         dynamic mode once they are updated more than every 20 seconds.
+  \endlist
+
+  The runtime only reads the mode as an overlay is added to the view, so the overlay
+  is removed and added again at the same position when its mode changes.
+ */
+void MessagesOverlay::setRenderingPolicy(RenderingPolicy renderingPolicy)
+{
+  if (m_renderingPolicy == renderingPolicy)
+    return;
+
+  m_renderingPolicy = renderingPolicy;
+
+  switch (m_renderingPolicy)
+  {
+  case RenderingPolicy::Static:
+    m_renderingModeTimer->stop();
+    setRenderingMode(GraphicsRenderingMode::Static);
+    break;
+  case RenderingPolicy::Automatic:
+    m_lastAppliedCount = m_stats->appliedCount();
+    m_renderingModeTimer->start();
+    break;
+  case RenderingPolicy::Dynamic:
+  default:
+    m_renderingModeTimer->stop();
+    setRenderingMode(GraphicsRenderingMode::Dynamic);
+    break;
+  }
+}
+
+/*!
+  \brief Returns the mode the graphics of the overlay are currently drawn in.
+ */
+GraphicsRenderingMode MessagesOverlay::renderingMode() const
+{
+  return m_graphicsOverlay->renderingMode();
+}
+
+/*!
+  \brief Returns the rendering policy named \a renderingPolicy: \c "static",
+  \c "automatic" or, by default, \c "dynamic".
+ */
+MessagesOverlay::RenderingPolicy MessagesOverlay::toRenderingPolicy(const QString& renderingPolicy)
+{
+  if (renderingPolicy.compare("static", Qt::CaseInsensitive) == 0)
+    return RenderingPolicy::Static;
+
+  if (renderingPolicy.compare("automatic", Qt::CaseInsensitive) == 0)
+    return RenderingPolicy::Automatic;
+
+  return RenderingPolicy::Dynamic; // default
+}
+
+/*!
+  \internal
+  \brief Returns whether \a message can be added to this overlay.
+ */
+bool MessagesOverlay::isValidMessage(const Message& message)
+{
+  if (message.messageId().isEmpty())
+  {
+    emit errorOccurred(QStringLiteral("Failed to add message - message ID is empty"));
+    return false;
+  }
+
+  if (message.messageKey() < 0)
+  {
+    emit errorOccurred(QStringLiteral("Failed to add message - message ID table is full"));
+    return false;
+  }
+
+  if (message.messageType() != messageType())
+  {
+    emit errorOccurred(QStringLiteral("Failed to add message - message type mismatch"));
+    return false;
+  }
+
+  return true;
+}
+
+/*!
+  \internal
+  \brief Applies the \a message and records the outcome in the \l stats.
+ */
+bool MessagesOverlay::applyAndRecordMessage(const Message& message, QList<Graphic*>& newGraphics)
+{
+  // an older message which arrives after a newer one is dropped, it is not an error
+  if (isOutOfOrder(message))
+  {
+    m_stats->recordOutOfOrder();
+    return true;
+  }
+
+  if (!applyMessage(message, newGraphics))
+  {
+    m_stats->recordRejected();
+    return false;
+  }
+
+  // kept after a remove as well, so that a late update does not bring the track back
+  const qint64 eventTime = message.eventTime();
+  if (eventTime > 0)
+  {
+    // the key is not held for the event time, so its generation is recorded with it
+    const int messageKey = message.messageKey();
+    if (messageKey >= m_lastEventTimes.size())
+      m_lastEventTimes.resize(messageKey + 1);
+    m_lastEventTimes[messageKey] = LastEvent{MessageIdTable::instance()->generation(messageKey), eventTime};
+  }
+
+  m_stats->recordApplied(message.receivedTimestamp());
+  if (message.hasLatencyProbe())
+    m_stats->recordProbeApplied(message);
+
+  return true;
+}
+
+/*!
+  \internal
+  \brief Returns whether \a message was generated before the latest message applied for its ID.
+
+  Messages without an \l {Message::eventTime}{event time} are never out of order.
+ */
+bool MessagesOverlay::isOutOfOrder(const Message& message) const
+{
+  const qint64 eventTime = message.eventTime();
+  return eventTime > 0 && eventTime < lastEventTime(message.messageKey());
+}
+
+/*!
+  \internal
+  \brief Returns the event time of the latest message applied for \a messageKey, or
+  \c 0 if there is none or the key has since been given to another message ID.
+ */
+qint64 MessagesOverlay::lastEventTime(int messageKey) const
+{
+  if (messageKey < 0 || messageKey >= m_lastEventTimes.size())
+    return 0;
+
+  const LastEvent& lastEvent = m_lastEventTimes.at(messageKey);
+  if (lastEvent.m_eventTime == 0 || lastEvent.m_generation != MessageIdTable::instance()->generation(messageKey))
+    return 0;
+
+  return lastEvent.m_eventTime;
+}
+
+/*!
+  \brief Returns the ingest statistics for the messages added to this overlay.
+ */
+MessageFeedStats* MessagesOverlay::stats() const
+{
+  return m_stats;
+}
+
+/*!
+  \brief Returns the index of the attribute values of the graphics in this overlay.
+
+  The index is updated as messages are applied.
+ */
+GraphicAttributeIndex* MessagesOverlay::attributeIndex() const
+{
+  return m_attributeIndex;
+}
+
+/*!
+  \brief Returns an update message reproducing each graphic in the overlay.
+
+  The messages carry the geometry and attributes of the graphics, and the event
+  and stale times of the last messages applied to them. Coalesced updates which
+  have not yet been flushed are not included.
+
+  \sa MessageSnapshotSync, lastUpdateTime
+ */
+QList<Message> MessagesOverlay::snapshotMessages() const
+{
+  QList<Message> messages;
+  messages.reserve(m_graphicRows.size());
+
+  const QString messageType = this->messageType();
+  const MessageIdTable* idTable = MessageIdTable::instance();
+  for (int messageKey = 0; messageKey < m_existingGraphics.size(); ++messageKey)
+  {
+    Graphic* graphic = m_existingGraphics.at(messageKey);
+    if (!graphic)
+      continue;
+
+    // the stale marker belongs to the overlay rather than the message
+    auto deferredIt = m_deferredAttributes.constFind(graphic);
+    QVariantMap attributes = deferredIt != m_deferredAttributes.constEnd() ? deferredIt.value().toVariantMap()
+                                                                         : graphic->attributes()->attributesMap();
+    attributes.remove(s_staleAttributeName);
+
+    Message message(Message::MessageAction::Update, graphic->geometry());
+    message.setMessageType(messageType);
+    message.setMessageId(idTable->messageId(messageKey));
+    message.setSymbolId(attributes.value(Message::SIDC_NAME).toString());
+    message.setAttributes(attributes);
+    message.setEventTime(lastEventTime(messageKey));
+
+    const int trackAgeIndex = m_trackAgeIndices.value(graphic, -1);
+    if (trackAgeIndex != -1)
+      message.setStaleTime(m_trackAges.at(trackAgeIndex).m_staleTime);
+
+    messages.append(message);
+  }
+
+  return messages;
+}
+
+/*!
+  \brief Returns when the graphic for \a messageKey was last updated, in milliseconds
+  since the epoch, or \c 0 if there is no graphic for the key.
+
+  The time is only accurate to the second.
+ */
+qint64 MessagesOverlay::lastUpdateTime(int messageKey) const
+{
+  Graphic* graphic = messageKey >= 0 ? existingGraphic(messageKey) : nullptr;
+  const int trackAgeIndex = graphic ? m_trackAgeIndices.value(graphic, -1) : -1;
+  if (trackAgeIndex == -1)
+    return 0;
+
+  const quint32 age = ageClock() - m_trackAges.at(trackAgeIndex).m_lastUpdate;
+  return QDateTime::currentMSecsSinceEpoch() - static_cast<qint64>(age) * 1000;
+}
+
+/*!
+  \brief Returns the ID of the message shown by \a graphic, or an empty string if
+  the graphic does not belong to this overlay.
+ */
+QString MessagesOverlay::messageId(Graphic* graphic) const
+{
+  const int messageKey = m_messageKeys.value(graphic, -1);
+  return messageKey != -1 ? MessageIdTable::instance()->messageId(messageKey) : QString();
+}
+
+/*!
+  \brief Returns the graphic showing the message with \a messageId, or \c nullptr
+  if there is none.
+ */
+Graphic* MessagesOverlay::graphicForMessageId(const QString& messageId) const
+{
+  const int messageKey = MessageIdTable::instance()->find(messageId);
+  return messageKey >= 0 ? existingGraphic(messageKey) : nullptr;
+}
+
+/*!
+  \internal
+  \brief Appends \a newGraphics to the graphics overlay as a single block.
+ */
+void MessagesOverlay::appendGraphics(const QList<Graphic*>& newGraphics)
+{
+  if (newGraphics.isEmpty())
+    return;
+
+  GraphicListModel* graphics = m_graphicsOverlay->graphics();
+  const int index = graphics->rowCount();
+
+  for (int i = 0; i < newGraphics.size(); ++i)
+    m_graphicRows.insert(newGraphics.at(i), index + i);
+
+  // the list model notifies its views of the new rows itself
+  graphics->append(newGraphics);
+
+  emit graphicsAdded(index, newGraphics.size());
+}
+
+/*!
+  \internal
+  \brief Emits \l graphicsUpdated and \l graphicsRemoved once for the graphics changed
+  by the messages which have just been applied.
+
+  Removed graphics are taken out of the graphics overlay here, as one batch, and
+  deleted once control returns to the event loop. Receivers of \l graphicsRemoved
+  must drop their references to them, or hold them in a QPointer.
+ */
+void MessagesOverlay::emitChangedGraphics()
+{
+  if (!m_updatedGraphics.isEmpty())
+  {
+    const QList<Graphic*> updatedGraphics = m_updatedGraphics;
+    m_updatedGraphics.clear();
+    emit graphicsUpdated(updatedGraphics);
+  }
+
+  if (!m_removedGraphics.isEmpty())
+  {
+    const QList<Graphic*> removedGraphics = m_removedGraphics;
+    m_removedGraphics.clear();
+    removeGraphicRows(removedGraphics);
+    emit graphicsRemoved(removedGraphics);
+
+    for (Graphic* graphic : removedGraphics)
+      graphic->deleteLater();
+  }
+}
+
+/*!
+  \internal
+  \brief Removes \a removedGraphics from the graphics overlay.
+
+  The rows are looked up in the row index rather than searched for, removed from
+  the highest down so that the remaining rows stay valid, and then the rows after
+  the first removal are renumbered once. \l graphicsRemoved is emitted for the
+  block after the graphic list model has notified each removal.
+ */
+void MessagesOverlay::removeGraphicRows(const QList<Graphic*>& removedGraphics)
+{
+  QVector<int> rows;
+  rows.reserve(removedGraphics.size());
+  for (Graphic* graphic : removedGraphics)
+  {
+    auto rowIt = m_graphicRows.find(graphic);
+    if (rowIt == m_graphicRows.end())
+      continue;
+
+    rows.append(rowIt.value());
+    m_graphicRows.erase(rowIt);
+  }
+
+  if (rows.isEmpty())
+    return;
+
+  std::sort(rows.begin(), rows.end(), std::greater<int>());
+
+  // the list model has no range removal, so each row is removed with its own notification
+  GraphicListModel* graphics = m_graphicsOverlay->graphics();
+  for (int row : rows)
+    graphics->removeAt(row);
+
+  const int count = graphics->rowCount();
+  for (int row = rows.last(); row < count; ++row)
+    m_graphicRows[graphics->at(row)] = row;
+}
+
+/*!
+  \internal
+  \brief Returns the graphic for the interned \a messageKey, or \c nullptr if there is none.
+ */
+Graphic* MessagesOverlay::existingGraphic(int messageKey) const
+{
+  return messageKey < m_existingGraphics.size() ? m_existingGraphics.at(messageKey) : nullptr;
+}
+
+/*!
+  \internal
+  \brief Removes the \a graphic for \a messageKey from the overlay and its indexes.
+ */
+void MessagesOverlay::removeGraphic(int messageKey, Graphic* graphic)
+{
+  m_existingGraphics[messageKey] = nullptr;
+  m_fingerprints.remove(graphic);
+  m_messageKeys.remove(graphic);
+  m_deferredAttributes.remove(graphic);
+  m_groundElevations.remove(messageKey);
+  m_pendingElevations.remove(messageKey);
+  if (m_breadcrumbOverlay)
+    m_breadcrumbOverlay->removeTrack(messageKey);
+  m_attributeIndex->removeGraphic(graphic);
+
+  // taken out of the graphics overlay with the rest of the batch on the next emitChangedGraphics
+  m_removedGraphics.append(graphic);
+  MessageIdTable::instance()->release(messageKey);
+
+  // swap the last age into the removed slot to keep the ages packed
+  auto indexIt = m_trackAgeIndices.find(graphic);
+  if (indexIt == m_trackAgeIndices.end())
+    return;
+
+  const int index = indexIt.value();
+  m_trackAgeIndices.erase(indexIt);
+
+  if (m_trackAges.at(index).m_staleTime > 0 && --m_staleTimeCount == 0)
+    updateSweepTimer();
+
+  const int lastIndex = m_trackAges.size() - 1;
+  if (index != lastIndex)
+  {
+    m_trackAges[index] = m_trackAges.at(lastIndex);
+    m_trackAgeIndices[m_trackAges.at(index).m_graphic] = index;
+  }
+  m_trackAges.removeLast();
+}
+
+/*!
+  \internal
+  \brief Records that \a graphic has just been created or updated by a message
+  which goes stale at \a staleTime, or \c 0 if it does not go stale.
+ */
+void MessagesOverlay::touchGraphic(int messageKey, Graphic* graphic, qint64 staleTime)
+{
+  const int staleTimeCount = m_staleTimeCount;
+  auto indexIt = m_trackAgeIndices.constFind(graphic);
+  if (indexIt == m_trackAgeIndices.constEnd())
+  {
+    m_trackAgeIndices.insert(graphic, m_trackAges.size());
+    m_trackAges.append(TrackAge{graphic, messageKey, ageClock(), false, staleTime});
+    if (staleTime > 0)
+      ++m_staleTimeCount;
+  }
+  else
+  {
+    TrackAge& trackAge = m_trackAges[indexIt.value()];
+    trackAge.m_lastUpdate = ageClock();
+    if ((trackAge.m_staleTime > 0) != (staleTime > 0))
+      m_staleTimeCount += staleTime > 0 ? 1 : -1;
+    trackAge.m_staleTime = staleTime;
+
+    if (trackAge.m_stale)
+    {
+      // the attributes were replaced by the update so only the z-index remains
+      trackAge.m_stale = false;
+      graphic->setZIndex(0);
+    }
+  }
+
+  // tracks with a stale time are swept even when no time to live or fade age is set
+  if ((staleTimeCount == 0) != (m_staleTimeCount == 0))
+    updateSweepTimer();
+}
+
+/*!
+  \internal
+ */
+void MessagesOverlay::updateSweepTimer()
+{
+  if (m_timeToLive > 0 || m_fadeAge > 0 || m_staleTimeCount > 0)
+  {
+    if (!m_sweepTimer->isActive())
+      m_sweepTimer->start();
+  }
+  else
+  {
+    m_sweepTimer->stop();
+  }
+}
+
+/*!
+  \internal
+  \brief Shows either the graphics or their clusters, if the overlay is visible.
+ */
+void MessagesOverlay::updateVisibility()
+{
+  const bool clustering = m_clusterOverlay && m_clusterOverlay->isClustering();
+
+  m_graphicsOverlay->setVisible(m_visible && !clustering);
+  if (m_clusterOverlay)
+    m_clusterOverlay->graphicsOverlay()->setVisible(m_visible && clustering);
+  if (m_breadcrumbOverlay)
+    m_breadcrumbOverlay->graphicsOverlay()->setVisible(m_visible && !clustering);
+}
+
+/*!
+  \internal
+  \brief Returns whether the point \a geometry of \a messageKey is within the area
+  of interest, and records the position for when the area moves.
+ */
+bool MessagesOverlay::isOfInterest(int messageKey, const Geometry& geometry)
+{
+  if (!m_interestArea)
+    return true;
+
+  const Point point = wgs84Point(geometry);
+  if (messageKey >= m_interestPositions.size())
+    m_interestPositions.resize(messageKey + 1);
+  m_interestPositions[messageKey] = QPointF(point.x(), point.y());
+
+  return m_interestArea->contains(point.x(), point.y());
+}
+
+/*!
+  \internal
+  \brief Shows the graphics which are within the area of interest, writing the
+  attributes they were sent while out of view, and hides the others.
+ */
+void MessagesOverlay::updateInterest()
+{
+  for (int messageKey = 0; messageKey < m_existingGraphics.size(); ++messageKey)
+  {
+    Graphic* graphic = m_existingGraphics.at(messageKey);
+    if (!graphic)
+      continue;
+
+    bool interest = true;
+    if (m_interestArea && messageKey < m_interestPositions.size())
+    {
+      const QPointF& position = m_interestPositions.at(messageKey);
+      interest = m_interestArea->contains(position.x(), position.y());
+    }
+
+    if (interest == graphic->isVisible())
+      continue;
+
+    if (!interest)
+    {
+      graphic->setVisible(false);
+      continue;
+    }
+
+    auto deferredIt = m_deferredAttributes.find(graphic);
+    if (deferredIt != m_deferredAttributes.end())
+    {
+      deferredIt.value().applyTo(graphic->attributes());
+      m_deferredAttributes.erase(deferredIt);
+    }
+
+    graphic->setVisible(true);
+  }
+}
+
+/*!
+  \internal
+  \brief Records the point \a geometry of \a messageKey at \a eventTime in its trail, if
+  trails are on.
+
+  Messages without an event time are recorded at the time they are applied.
+ */
+void MessagesOverlay::recordTrailPoint(int messageKey, const Geometry& geometry, qint64 eventTime)
+{
+  if (!m_breadcrumbOverlay)
+    return;
+
+  const Point point = wgs84Point(geometry);
+  m_breadcrumbOverlay->addPoint(messageKey, point.x(), point.y(),
+                                eventTime > 0 ? eventTime : QDateTime::currentMSecsSinceEpoch());
+}
+
+/*!
+  \internal
+  \brief Returns the seconds since the overlay was created.
+ */
+quint32 MessagesOverlay::ageClock() const
+{
+  return static_cast<quint32>(m_ageClock.elapsed() / 1000);
+}
+
+/*!
+  \internal
+  \brief Applies the \a message to the graphics in the overlay.
+
+  Graphics for new messages are created and appended to \a newGraphics
+  rather than being added to the graphics overlay. Updates which are identical
+  to the previous update of their graphic are counted as suppressed in the
+  \l stats and do not touch the graphic.
+ */
+bool MessagesOverlay::applyMessage(const Message& message, QList<Graphic*>& newGraphics)
+{
+  const int messageKey = message.messageKey();
+
+  const auto symbolId = message.symbolId();
+  const auto geometry = message.geometry();
+  const auto messageAction = message.messageAction();
+
+  if (messageAction == Message::MessageAction::Update)
+  {
+    if (m_renderer && m_renderer->rendererType() == RendererType::DictionaryRenderer && symbolId.isEmpty())
+    {
+      emit errorOccurred(QStringLiteral("Failed to add message - symbol ID is empty"));
+      return false;
+    }
+
+    if (geometry.isEmpty())
+    {
+      emit errorOccurred(QStringLiteral("Failed to add message - geometry is empty"));
+      return false;
+    }
+
+    if (geometry.geometryType() != GeometryType::Point)
+    {
+      emit errorOccurred(QStringLiteral("Failed to add message - only point geometry types are supported"));
+      return false;
+    }
+  }
+
+  Graphic* graphic = existingGraphic(messageKey);
+  if (graphic)
+  {
+    // update existing graphic attributes and geometry
+    // if the graphic already exists for the message key
+
+    switch (messageAction)
+    {
+    case Message::MessageAction::Update:
+    case Message::MessageAction::Select:
+    case Message::MessageAction::Unselect:
+    {
+      const Geometry geom = graphic->geometry();
+      if (geom.geometryType() != geometry.geometryType())
+        return false;
+
+      // an update identical to the last one is dropped before it reaches the graphic,
+      // so that the renderer and labels are not invalidated for nothing
+      const uint fingerprint = messageFingerprint(message);
+      auto fingerprintIt = m_fingerprints.find(graphic);
+      if (messageAction == Message::MessageAction::Update &&
+          fingerprintIt != m_fingerprints.end() && fingerprintIt.value() == fingerprint)
+      {
+        m_stats->recordSuppressed();
+        touchGraphic(messageKey, graphic, message.staleTime());
+        break;
+      }
+
+      if (fingerprintIt != m_fingerprints.end())
+        fingerprintIt.value() = fingerprint;
+      else
+        m_fingerprints.insert(graphic, fingerprint);
+
+      const Geometry placedGeometry = m_groundElevationResolved ? groundedGeometry(messageKey, geometry) : geometry;
+      if (!(geom == placedGeometry))
+      {
+        graphic->setGeometry(placedGeometry);
+        recordTrailPoint(messageKey, geometry, message.eventTime());
+      }
+
+      // only the attributes which changed are written to the graphic, and only once
+      // it is in view. The attribute index is always updated, for the alert conditions
+      const MessageAttributes attributes = message.messageAttributes();
+      if (isOfInterest(messageKey, geometry))
+      {
+        m_deferredAttributes.remove(graphic);
+        attributes.applyTo(graphic->attributes());
+        if (!graphic->isVisible())
+          graphic->setVisible(true);
+      }
+      else
+      {
+        m_deferredAttributes.insert(graphic, attributes);
+        if (graphic->isVisible())
+          graphic->setVisible(false);
+      }
+      m_attributeIndex->updateGraphic(graphic, attributes);
+      m_updatedGraphics.append(graphic);
+      touchGraphic(messageKey, graphic, message.staleTime());
+
+      if (messageAction == Message::MessageAction::Select)
+      {
+        graphic->setSelected(true);
+      }
+      else if (messageAction == Message::MessageAction::Unselect)
+      {
+        graphic->setSelected(false);
+      }
+
+      break;
+    }
+    case Message::MessageAction::Remove:
+    {
+      removeGraphic(messageKey, graphic);
+      break;
+    }
+    default:
+      emit errorOccurred(QStringLiteral("Unknown message action"));
+      return false;
+    }
+
+    return true;
+  }
+
+  if (messageAction != Message::MessageAction::Update)
+  {
+    emit errorOccurred(QStringLiteral("Message action must be Update to add new message"));
+    return false;
+  }
+
+  // create new graphic
+  graphic = new Graphic(m_groundElevationResolved ? groundedGeometry(messageKey, geometry) : geometry, message.attributes(), this);
+  newGraphics.append(graphic);
+
+  // released keys are reused, so the array grows to the number of live IDs rather than all those seen
+  if (messageKey >= m_existingGraphics.size())
+    m_existingGraphics.resize(messageKey + 1);
+  m_existingGraphics[messageKey] = graphic;
+  MessageIdTable::instance()->retain(messageKey);
+  m_fingerprints.insert(graphic, messageFingerprint(message));
+  m_messageKeys.insert(graphic, messageKey);
+  m_attributeIndex->updateGraphic(graphic, message.messageAttributes());
+  touchGraphic(messageKey, graphic, message.staleTime());
+  recordTrailPoint(messageKey, geometry, message.eventTime());
+
+  if (!isOfInterest(messageKey, geometry))
+    graphic->setVisible(false);
+
+  return true;
+}
+
+/*!
+  \internal
+
+  Picks the rendering mode from the number of graphics and how often they were
+  updated since the last check.
+ */
+void MessagesOverlay::updateRenderingMode()
+{
+  const qint64 appliedCount = m_stats->appliedCount();
+  const qint64 updateCount = appliedCount - m_lastAppliedCount;
+  m_lastAppliedCount = appliedCount;
+
+  const int graphicCount = m_graphicsOverlay->graphics()->size();
+  if (graphicCount < s_staticMinimumGraphics)
+  {
+    setRenderingMode(GraphicsRenderingMode::Dynamic);
+    return;
+  }
+
+  const double updateRate = updateCount * 1000.0 / (static_cast<double>(graphicCount) * s_renderingModeInterval);
+  if (updateRate < s_staticUpdateRate)
+    setRenderingMode(GraphicsRenderingMode::Static);
+  else if (updateRate > s_dynamicUpdateRate)
+    setRenderingMode(GraphicsRenderingMode::Dynamic);
+}
+
+/*!
+  \internal
+ */
+void MessagesOverlay::setRenderingMode(GraphicsRenderingMode renderingMode)
+{
+  if (m_graphicsOverlay->renderingMode() == renderingMode)
+    return;
+
+  DSA_TRACE_SCOPE("MessagesOverlay::setRenderingMode");
+
+  GraphicsOverlayListModel* graphicsOverlays = m_geoView->graphicsOverlays();
+  const int index = graphicsOverlays->indexOf(m_graphicsOverlay);
+  if (index < 0)
+  {
+    m_graphicsOverlay->setRenderingMode(renderingMode);
+    return;
+  }
+
+  graphicsOverlays->removeAt(index);
+  m_graphicsOverlay->setRenderingMode(renderingMode);
+  graphicsOverlays->insert(index, m_graphicsOverlay);
+}
+
+/*!
+  \internal
+ */
+void MessagesOverlay::updateSceneProperties()
+{
+  const SurfacePlacement surfacePlacement = m_groundElevationResolved ? SurfacePlacement::Absolute : m_surfacePlacement;
+  m_graphicsOverlay->setSceneProperties(LayerSceneProperties(surfacePlacement));
+}
+
+/*!
+  \internal
+
+  Returns the point \a geometry of the track \a messageKey at its ground elevation,
+  or at its last elevation if the ground has not been sampled there yet.
+ */
+Geometry MessagesOverlay::groundedGeometry(int messageKey, const Geometry& geometry)
+{
+  ElevationSampleCache* cache = ElevationSampleCache::instance();
+  if (!cache->surface())
+    return geometry;
+
+  const Point point(geometry);
+  double elevation = 0.0;
+  if (cache->cachedElevation(point, elevation))
+  {
+    m_groundElevations.insert(messageKey, elevation);
+    m_pendingElevations.remove(messageKey);
+  }
+  else
+  {
+    // the tile is requested by resolvePendingElevations, a few at a time
+    elevation = m_groundElevations.value(messageKey, 0.0);
+    m_pendingElevations.insert(messageKey);
+    if (!m_elevationTimer->isActive())
+      m_elevationTimer->start();
+  }
+
+  return Point(point.x(), point.y(), elevation, point.spatialReference());
+}
+
+/*!
+  \internal
+
+  Moves the tracks whose ground has since been sampled to their ground elevation,
+  and requests the tiles of a few of those still waiting. Requesting every tile at
+  once would have a feed spread over a wide area evict tiles before they complete.
+ */
+void MessagesOverlay::resolvePendingElevations()
+{
+  DSA_TRACE_SCOPE("MessagesOverlay::resolvePendingElevations");
+
+  ElevationSampleCache* cache = ElevationSampleCache::instance();
+  if (!cache->surface())
+    m_pendingElevations.clear();
+
+  for (auto it = m_pendingElevations.begin(); it != m_pendingElevations.end();)
+  {
+    const int messageKey = *it;
+    Graphic* graphic = existingGraphic(messageKey);
+    if (!graphic)
+    {
+      it = m_pendingElevations.erase(it);
+      continue;
+    }
+
+    const Point point(graphic->geometry());
+    double elevation = 0.0;
+    if (cache->cachedElevation(point, elevation))
+    {
+      m_groundElevations.insert(messageKey, elevation);
+      graphic->setGeometry(Point(point.x(), point.y(), elevation, point.spatialReference()));
+      it = m_pendingElevations.erase(it);
+      continue;
+    }
+
+    if (cache->pendingTileCount() < s_maximumPendingElevationTiles)
+      cache->elevation(point, elevation);
+
+    ++it;
+  }
+
+  if (m_pendingElevations.isEmpty())
+    m_elevationTimer->stop();
+}
+
+/*!
+  \brief Returns whether the overlay is visible.
+ */
+bool MessagesOverlay::isVisible() const
+{
+  return m_visible;
+}
+
+/*!
+  \brief Sets the overlay to be \a visible.
+ */
+void MessagesOverlay::setVisible(bool visible)
+{
+  if (m_visible == visible)
+    return;
+
+  m_visible = visible;
+  updateVisibility();
+
+  emit visibleChanged();
+}
+
+} // Dsa
+
+// Signal Documentation
 /*!
   \fn void MessagesOverlay::visibleChanged();
   \brief Signal emitted when the visibility of the overlay changes.
  */
 
+/*!
+  \fn void MessagesOverlay::graphicsAdded(int index, int count);
+  \brief Signal emitted when a block of \a count new graphics has been appended
+  to the graphics overlay, starting at \a index.
+
+  \sa addMessages
+ */
+
+/*!
+  \fn void MessagesOverlay::graphicsUpdated(const QList<Esri::ArcGISRuntime::Graphic*>& graphics);
+  \brief Signal emitted once for the block of existing \a graphics updated by newly applied messages.
+ */
+
+/*!
+  \fn void MessagesOverlay::graphicsRemoved(const QList<Esri::ArcGISRuntime::Graphic*>& graphics);
+  \brief Signal emitted once for the block of \a graphics removed from the overlay by newly applied messages.
+
+  The \a graphics are deleted once control returns to the event loop.
+ */
+
 /*!
   \fn void MessagesOverlay::errorOccurred(const QString& error);
   \brief Signal emitted when an \a error occurs.
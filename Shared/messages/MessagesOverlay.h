@@ -17,9 +17,20 @@
 #ifndef MESSAGESOVERLAY_H
 #define MESSAGESOVERLAY_H
 
+// dsa app headers
+#include "Message.h"
+
 // Qt headers
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
 #include <QObject>
+#include <QPointF>
 #include <QPointer>
+#include <QSet>
+#include <QVector>
+
+class QTimer;
 
 namespace Esri
 {
@@ -28,20 +39,33 @@ namespace Esri
     class GeoView;
     class Renderer;
     class GraphicsOverlay;
+    class Geometry;
     class Graphic;
+    enum class GraphicsRenderingMode;
     enum class SurfacePlacement;
   }
 }
 
 namespace Dsa {
 
-class Message;
+class GraphicAttributeIndex;
+class MessageClusterOverlay;
+class MessageFeedStats;
+class TrackBreadcrumbOverlay;
+class ViewportInterestArea;
 
 class MessagesOverlay : public QObject
 {
   Q_OBJECT
 
 public:
+  enum class RenderingPolicy
+  {
+    Dynamic = 0,
+    Static = 1,
+    Automatic = 2
+  };
+
   explicit MessagesOverlay(Esri::ArcGISRuntime::GeoView* geoView, QObject* parent = nullptr);
   MessagesOverlay(Esri::ArcGISRuntime::GeoView* geoView, Esri::ArcGISRuntime::Renderer* renderer,
                   const QString& messageType, Esri::ArcGISRuntime::SurfacePlacement surfacePlacement,
@@ -54,6 +78,9 @@ public:
   Esri::ArcGISRuntime::SurfacePlacement surfacePlacement() const;
   void setSurfacePlacement(Esri::ArcGISRuntime::SurfacePlacement surfacePlacement);
 
+  bool isGroundElevationResolved() const;
+  void setGroundElevationResolved(bool groundElevationResolved);
+
   QString messageType() const;
   void setMessageType(const QString& messageType);
 
@@ -62,23 +89,165 @@ public:
   Esri::ArcGISRuntime::GeoView* geoView() const;
 
   bool addMessage(const Message& message);
+  bool addMessages(const QList<Message>& messages);
+
+  bool isCoalescingUpdates() const;
+  void setCoalescingUpdates(bool coalescingUpdates);
+
+  int flushInterval() const;
+  void setFlushInterval(int flushInterval);
+
+  void flush();
+  void clear();
+
+  int timeToLive() const;
+  void setTimeToLive(int timeToLive);
+
+  int fadeAge() const;
+  void setFadeAge(int fadeAge);
+
+  void expireStaleGraphics();
+
+  double clusterScale() const;
+  void setClusterScale(double clusterScale);
+  MessageClusterOverlay* clusterOverlay() const;
+
+  int trailLength() const;
+  void setTrailLength(int trailLength);
+  TrackBreadcrumbOverlay* breadcrumbOverlay() const;
+
+  RenderingPolicy renderingPolicy() const;
+  void setRenderingPolicy(RenderingPolicy renderingPolicy);
+  Esri::ArcGISRuntime::GraphicsRenderingMode renderingMode() const;
+  static RenderingPolicy toRenderingPolicy(const QString& renderingPolicy);
+
+  bool isInterestManaged() const;
+  void setInterestManaged(bool interestManaged);
+  ViewportInterestArea* interestArea() const;
+
+  MessageFeedStats* stats() const;
+  GraphicAttributeIndex* attributeIndex() const;
+
+  QList<Message> snapshotMessages() const;
+  qint64 lastUpdateTime(int messageKey) const;
+
+  QString messageId(Esri::ArcGISRuntime::Graphic* graphic) const;
+  Esri::ArcGISRuntime::Graphic* graphicForMessageId(const QString& messageId) const;
+
+  static MessagesOverlay* fromGraphicsOverlay(Esri::ArcGISRuntime::GraphicsOverlay* graphicsOverlay);
+  static MessagesOverlay* fromGraphic(Esri::ArcGISRuntime::Graphic* graphic);
 
   bool isVisible() const;
   void setVisible(bool visible);
 
 signals:
   void visibleChanged();
+  void graphicsAdded(int index, int count);
+  void graphicsUpdated(const QList<Esri::ArcGISRuntime::Graphic*>& graphics);
+  void graphicsRemoved(const QList<Esri::ArcGISRuntime::Graphic*>& graphics);
   void errorOccurred(const QString& error);
 
 private:
   Q_DISABLE_COPY(MessagesOverlay)
 
+  bool isValidMessage(const Message& message);
+  bool isOutOfOrder(const Message& message) const;
+  qint64 lastEventTime(int messageKey) const;
+  bool applyMessage(const Message& message, QList<Esri::ArcGISRuntime::Graphic*>& newGraphics);
+  bool applyAndRecordMessage(const Message& message, QList<Esri::ArcGISRuntime::Graphic*>& newGraphics);
+  void appendGraphics(const QList<Esri::ArcGISRuntime::Graphic*>& newGraphics);
+  void emitChangedGraphics();
+  Esri::ArcGISRuntime::Graphic* existingGraphic(int messageKey) const;
+  void removeGraphic(int messageKey, Esri::ArcGISRuntime::Graphic* graphic);
+  void removeGraphicRows(const QList<Esri::ArcGISRuntime::Graphic*>& removedGraphics);
+  void touchGraphic(int messageKey, Esri::ArcGISRuntime::Graphic* graphic, qint64 staleTime);
+  void recordTrailPoint(int messageKey, const Esri::ArcGISRuntime::Geometry& geometry, qint64 eventTime);
+  bool isOfInterest(int messageKey, const Esri::ArcGISRuntime::Geometry& geometry);
+  void updateInterest();
+  void updateSweepTimer();
+  void updateVisibility();
+  void updateRenderingMode();
+  void updateSceneProperties();
+  Esri::ArcGISRuntime::Geometry groundedGeometry(int messageKey, const Esri::ArcGISRuntime::Geometry& geometry);
+  void resolvePendingElevations();
+  void setRenderingMode(Esri::ArcGISRuntime::GraphicsRenderingMode renderingMode);
+  quint32 ageClock() const;
+
+  // the last update of a graphic, in seconds of the overlay's age clock
+  struct TrackAge
+  {
+    Esri::ArcGISRuntime::Graphic* m_graphic = nullptr;
+    int m_messageKey = -1;
+    quint32 m_lastUpdate = 0;
+    bool m_stale = false;
+    qint64 m_staleTime = 0;
+  };
+
   Esri::ArcGISRuntime::GeoView* m_geoView = nullptr;
   QPointer<Esri::ArcGISRuntime::Renderer> m_renderer;
   Esri::ArcGISRuntime::SurfacePlacement m_surfacePlacement;
 
   Esri::ArcGISRuntime::GraphicsOverlay* m_graphicsOverlay = nullptr;
-  QHash<QString, Esri::ArcGISRuntime::Graphic*> m_existingGraphics;
+  // graphics indexed by the interned message key, see Message::messageKey
+  QVector<Esri::ArcGISRuntime::Graphic*> m_existingGraphics;
+  QHash<Esri::ArcGISRuntime::Graphic*, uint> m_fingerprints;
+  QHash<Esri::ArcGISRuntime::Graphic*, int> m_messageKeys;
+  QList<Esri::ArcGISRuntime::Graphic*> m_updatedGraphics;
+  QList<Esri::ArcGISRuntime::Graphic*> m_removedGraphics;
+
+  // the row of each graphic in the overlay, so removals need no search of the list model
+  QHash<Esri::ArcGISRuntime::Graphic*, int> m_graphicRows;
+
+  bool m_coalescingUpdates = false;
+  QHash<int, Message> m_pendingMessages;
+
+  // event time of the latest message applied for each message key
+  struct LastEvent
+  {
+    quint32 m_generation = 0;
+    qint64 m_eventTime = 0;
+  };
+  QVector<LastEvent> m_lastEventTimes;
+  QTimer* m_flushTimer = nullptr;
+  MessageFeedStats* m_stats = nullptr;
+  GraphicAttributeIndex* m_attributeIndex = nullptr;
+
+  // time-to-live expiry of graphics which are no longer updated
+  int m_timeToLive = 0;
+  int m_fadeAge = 0;
+  QElapsedTimer m_ageClock;
+  QVector<TrackAge> m_trackAges;
+  QHash<Esri::ArcGISRuntime::Graphic*, int> m_trackAgeIndices;
+  int m_staleTimeCount = 0;
+  int m_sweepPosition = 0;
+  QTimer* m_sweepTimer = nullptr;
+
+  // count symbols drawn instead of the graphics when zoomed out
+  MessageClusterOverlay* m_clusterOverlay = nullptr;
+
+  // recent positions of the tracks drawn as trails
+  TrackBreadcrumbOverlay* m_breadcrumbOverlay = nullptr;
+
+  // tracks away from the view are hidden, with the attributes they were last sent
+  // kept here until they come into view. Positions are in WGS84, by message key
+  ViewportInterestArea* m_interestArea = nullptr;
+  QVector<QPointF> m_interestPositions;
+  QHash<Esri::ArcGISRuntime::Graphic*, MessageAttributes> m_deferredAttributes;
+  bool m_visible = true;
+
+  // large overlays which are rarely updated are drawn in static mode, measured from
+  // the number of updates applied between checks
+  RenderingPolicy m_renderingPolicy = RenderingPolicy::Dynamic;
+  QTimer* m_renderingModeTimer = nullptr;
+  qint64 m_lastAppliedCount = 0;
+
+  // tracks placed at the ground elevation sampled for their latest position, by message key.
+  // Tracks whose elevation has not been sampled yet keep their last elevation until it is
+  bool m_groundElevationResolved = false;
+  QHash<int, double> m_groundElevations;
+  QSet<int> m_pendingElevations;
+  QTimer* m_elevationTimer = nullptr;
+  QMetaObject::Connection m_tileLoadedConnection;
 };
 
 } // Dsa
@@ -22,9 +22,9 @@
 
 // dsa app headers
 #include "AppConstants.h"
-#include "DataSender.h"
 #include "Message.h"
 #include "MessageFeedConstants.h"
+#include "OutboundTransport.h"
 #include "PointHighlighter.h"
 
 // toolkit headers
@@ -40,12 +40,15 @@
 // Qt headers
 #include <QDateTime>
 #include <QHostInfo>
-#include <QUdpSocket>
 
 using namespace Esri::ArcGISRuntime;
 
 namespace Dsa {
 
+// attempts after a failed write, and extra copies of each report for teammates who missed it
+static const int s_reportRetries = 3;
+static const int s_reportRepeats = 1;
+
 /*!
   \class Dsa::ObservationReportController
   \inmodule Dsa
@@ -115,6 +118,8 @@ void ObservationReportController::setProperties(const QVariantMap& properties)
     if (ok)
       setUdpPort(newPort);
   }
+
+  m_transport = UdpTransport::fromProperties(properties);
 }
 
 /*!
@@ -191,12 +196,16 @@ void ObservationReportController::setPickMode(bool pickMode)
 
   if (m_pickMode)
   {
-    m_mouseClickConnection = connect(ToolResourceProvider::instance(), &ToolResourceProvider::mouseClicked,
-                                     this, &ObservationReportController::onMouseClicked);
+    ToolResourceProvider::instance()->setMouseFocus(this, ToolResourceProvider::MouseEventType::Clicked,
+                                                    ToolResourceProvider::PickMousePriority,
+                                                    [this](ToolResourceProvider::MouseEventType, QMouseEvent& event)
+    {
+      return onMouseClicked(event);
+    });
   }
   else
   {
-    disconnect(m_mouseClickConnection);
+    ToolResourceProvider::instance()->clearMouseFocus(this);
   }
 
   emit pickModeChanged();
@@ -292,16 +301,15 @@ void ObservationReportController::broadcastReport(const QString& size,
   attribs.insert(QStringLiteral("unit"), description);
   observationReport.setAttributes(attribs);
 
-  if (!m_dataSender)
-  {
-    m_dataSender = new DataSender(this);
-
-    QUdpSocket* udpSocket = new QUdpSocket(m_dataSender);
-    udpSocket->connectToHost(QHostAddress::Broadcast, m_udpPort, QIODevice::WriteOnly);
-    m_dataSender->setDevice(udpSocket);
-  }
+  if (m_udpPort < 0)
+    return;
 
-  m_dataSender->sendData(observationReport.toGeoMessage());
+  // a report is sent once, so failed writes are retried and it is repeated for missed receipt
+  OutboundTransport::SendOptions options;
+  options.m_priority = OutboundTransport::Priority::Report;
+  options.m_retries = s_reportRetries;
+  options.m_repeats = s_reportRepeats;
+  OutboundTransport::instance()->send(m_transport, m_udpPort, observationReport.toGeoMessage(), options);
 }
 
 /*!
@@ -347,20 +355,22 @@ void ObservationReportController::onGeoViewChanged(GeoView* geoView)
 
 /*!
   \internal
+  Sets the control point to the position of \a event, returning whether the click
+  was used for the pick.
  */
-void ObservationReportController::onMouseClicked(QMouseEvent& event)
+bool ObservationReportController::onMouseClicked(QMouseEvent& event)
 {
   if (!isActive())
-    return;
+    return false;
 
   if (event.button() != Qt::MouseButton::LeftButton)
-    return;
+    return false;
 
   if (!m_pickMode)
-    return;
+    return false;
 
   if (!m_geoView)
-    return;
+    return false;
 
   togglePickMode();
 
@@ -375,10 +385,11 @@ void ObservationReportController::onMouseClicked(QMouseEvent& event)
     if (mapView)
       setControlPoint(mapView->screenToLocation(event.x(), event.y()));
     else
-      return;
+      return false;
   }
 
   event.accept();
+  return true;
 }
 
 /*!
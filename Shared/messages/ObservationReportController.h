@@ -17,6 +17,9 @@
 #ifndef OBSERVATIONREPORTCONTROLLER_H
 #define OBSERVATIONREPORTCONTROLLER_H
 
+// dsa app headers
+#include "UdpTransport.h"
+
 // toolkit headers
 #include "AbstractTool.h"
 
@@ -34,8 +37,6 @@ namespace ArcGISRuntime {
 
 namespace Dsa {
 
-class DataSender;
-
 class PointHighlighter;
 
 class ObservationReportController : public AbstractTool
@@ -90,21 +91,20 @@ public slots:
   void onGeoViewChanged(Esri::ArcGISRuntime::GeoView* geoView);
 
 private slots:
-  void onMouseClicked(QMouseEvent& event);
   void onUpdateControlPointHightlight();
 
 private:
+  bool onMouseClicked(QMouseEvent& event);
 
   Esri::ArcGISRuntime::GeoView* m_geoView = nullptr;
   QString m_observedBy;
   Esri::ArcGISRuntime::Point m_controlPoint;
-  DataSender* m_dataSender = nullptr;
   PointHighlighter* m_highlighter = nullptr;
   bool m_controlPointSet = false;
   int m_udpPort = -1;
+  UdpTransport m_transport;
   bool m_pickMode = false;
 
-  QMetaObject::Connection m_mouseClickConnection;
   QMetaObject::Connection m_myLocationConnection;
 };
 
@@ -0,0 +1,556 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "TakProtocolCodec.h"
+
+// C++ API headers
+#include "GeometryEngine.h"
+#include "Point.h"
+
+// Qt headers
+#include <QDateTime>
+#include <QtEndian>
+
+// STL headers
+#include <cstring>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+namespace {
+
+// protobuf wire types used by the TAK messages
+enum WireType
+{
+  Varint = 0,
+  Fixed64 = 1,
+  LengthDelimited = 2,
+  Fixed32 = 5
+};
+
+// field numbers of takmessage.proto, cotevent.proto, detail.proto and contact.proto
+enum TakMessageField
+{
+  TakMessageCotEvent = 2
+};
+
+enum CotEventField
+{
+  CotEventType = 1,
+  CotEventUid = 5,
+  CotEventSendTime = 6,
+  CotEventStartTime = 7,
+  CotEventStaleTime = 8,
+  CotEventHow = 9,
+  CotEventLat = 10,
+  CotEventLon = 11,
+  CotEventHae = 12,
+  CotEventCe = 13,
+  CotEventLe = 14,
+  CotEventDetail = 15
+};
+
+enum DetailField
+{
+  DetailXmlDetail = 1,
+  DetailContact = 2
+};
+
+enum ContactField
+{
+  ContactCallsign = 2
+};
+
+// TAK's value for an unknown height or error
+constexpr double s_unknownValue = 9999999.0;
+
+// the mesh header is the magic byte, the protocol version and the magic byte again
+constexpr int s_meshHeaderSize = 3;
+
+// reads protobuf fields from a buffer without copying it
+class ProtobufReader
+{
+public:
+  ProtobufReader(const char* data, int size) :
+    m_position(reinterpret_cast<const uchar*>(data)),
+    m_end(m_position + size)
+  {
+  }
+
+  bool atEnd() const
+  {
+    return m_position >= m_end;
+  }
+
+  bool readVarint(quint64& value)
+  {
+    value = 0;
+    for (int shift = 0; shift < 64 && m_position < m_end; shift += 7)
+    {
+      const uchar byte = *m_position++;
+      value |= static_cast<quint64>(byte & 0x7F) << shift;
+      if (!(byte & 0x80))
+        return true;
+    }
+
+    return false;
+  }
+
+  bool readTag(int& field, int& wireType)
+  {
+    quint64 tag = 0;
+    if (!readVarint(tag))
+      return false;
+
+    field = static_cast<int>(tag >> 3);
+    wireType = static_cast<int>(tag & 0x07);
+    return field > 0;
+  }
+
+  bool readDouble(double& value)
+  {
+    if (m_end - m_position < 8)
+      return false;
+
+    const quint64 bits = qFromLittleEndian<quint64>(m_position);
+    std::memcpy(&value, &bits, sizeof(value));
+    m_position += 8;
+    return true;
+  }
+
+  bool readBytes(const char*& data, int& size)
+  {
+    quint64 length = 0;
+    if (!readVarint(length) || length > static_cast<quint64>(m_end - m_position))
+      return false;
+
+    data = reinterpret_cast<const char*>(m_position);
+    size = static_cast<int>(length);
+    m_position += length;
+    return true;
+  }
+
+  bool skip(int wireType)
+  {
+    quint64 value = 0;
+    const char* data = nullptr;
+    int size = 0;
+    switch (wireType)
+    {
+    case Varint:
+      return readVarint(value);
+    case Fixed64:
+      if (m_end - m_position < 8)
+        return false;
+      m_position += 8;
+      return true;
+    case LengthDelimited:
+      return readBytes(data, size);
+    case Fixed32:
+      if (m_end - m_position < 4)
+        return false;
+      m_position += 4;
+      return true;
+    default:
+      return false;
+    }
+  }
+
+private:
+  const uchar* m_position = nullptr;
+  const uchar* m_end = nullptr;
+};
+
+void writeVarint(QByteArray& buffer, quint64 value)
+{
+  while (value >= 0x80)
+  {
+    buffer.append(static_cast<char>((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  buffer.append(static_cast<char>(value));
+}
+
+void writeTag(QByteArray& buffer, int field, WireType wireType)
+{
+  writeVarint(buffer, (static_cast<quint64>(field) << 3) | wireType);
+}
+
+void writeVarintField(QByteArray& buffer, int field, quint64 value)
+{
+  writeTag(buffer, field, Varint);
+  writeVarint(buffer, value);
+}
+
+void writeDoubleField(QByteArray& buffer, int field, double value)
+{
+  writeTag(buffer, field, Fixed64);
+
+  quint64 bits = 0;
+  std::memcpy(&bits, &value, sizeof(bits));
+  char bytes[8];
+  qToLittleEndian(bits, bytes);
+  buffer.append(bytes, sizeof(bytes));
+}
+
+void writeBytesField(QByteArray& buffer, int field, const QByteArray& value)
+{
+  if (value.isEmpty())
+    return;
+
+  writeTag(buffer, field, LengthDelimited);
+  writeVarint(buffer, static_cast<quint64>(value.size()));
+  buffer.append(value);
+}
+
+// the payload of the mesh (UDP) header, or of the length prefixed stream header
+bool takPayload(const QByteArray& data, const char*& payload, int& size)
+{
+  if (data.size() < 2 || data.at(0) != TakProtocolCodec::MAGIC_BYTE)
+    return false;
+
+  if (data.size() > s_meshHeaderSize && static_cast<quint8>(data.at(1)) == TakProtocolCodec::VERSION &&
+      data.at(2) == TakProtocolCodec::MAGIC_BYTE)
+  {
+    payload = data.constData() + s_meshHeaderSize;
+    size = data.size() - s_meshHeaderSize;
+    return true;
+  }
+
+  ProtobufReader reader(data.constData() + 1, data.size() - 1);
+  const char* streamPayload = nullptr;
+  int streamSize = 0;
+  if (!reader.readBytes(streamPayload, streamSize) || !reader.atEnd())
+    return false;
+
+  payload = streamPayload;
+  size = streamSize;
+  return true;
+}
+
+struct CotEvent
+{
+  QString type;
+  QString uid;
+  QString callsign;
+  QByteArray xmlDetail;
+  quint64 sendTime = 0;
+  quint64 staleTime = 0;
+  double lat = 0.0;
+  double lon = 0.0;
+  double hae = 0.0;
+  bool hasLat = false;
+  bool hasLon = false;
+};
+
+bool readContact(const char* data, int size, CotEvent& event)
+{
+  ProtobufReader reader(data, size);
+  while (!reader.atEnd())
+  {
+    int field = 0;
+    int wireType = 0;
+    if (!reader.readTag(field, wireType))
+      return false;
+
+    const char* value = nullptr;
+    int valueSize = 0;
+    if (field == ContactCallsign && wireType == LengthDelimited)
+    {
+      if (!reader.readBytes(value, valueSize))
+        return false;
+      event.callsign = QString::fromUtf8(value, valueSize);
+    }
+    else if (!reader.skip(wireType))
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool readDetail(const char* data, int size, CotEvent& event)
+{
+  ProtobufReader reader(data, size);
+  while (!reader.atEnd())
+  {
+    int field = 0;
+    int wireType = 0;
+    if (!reader.readTag(field, wireType))
+      return false;
+
+    const char* value = nullptr;
+    int valueSize = 0;
+    if ((field == DetailXmlDetail || field == DetailContact) && wireType == LengthDelimited)
+    {
+      if (!reader.readBytes(value, valueSize))
+        return false;
+
+      if (field == DetailXmlDetail)
+        event.xmlDetail = QByteArray::fromRawData(value, valueSize);
+      else if (!readContact(value, valueSize, event))
+        return false;
+    }
+    else if (!reader.skip(wireType))
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool readCotEvent(const char* data, int size, CotEvent& event)
+{
+  ProtobufReader reader(data, size);
+  while (!reader.atEnd())
+  {
+    int field = 0;
+    int wireType = 0;
+    if (!reader.readTag(field, wireType))
+      return false;
+
+    bool ok = true;
+    const char* value = nullptr;
+    int valueSize = 0;
+    if (wireType == LengthDelimited && (field == CotEventType || field == CotEventUid || field == CotEventDetail))
+    {
+      ok = reader.readBytes(value, valueSize);
+      if (ok && field == CotEventType)
+        event.type = QString::fromUtf8(value, valueSize);
+      else if (ok && field == CotEventUid)
+        event.uid = QString::fromUtf8(value, valueSize);
+      else if (ok)
+        ok = readDetail(value, valueSize, event);
+    }
+    else if (wireType == Varint && (field == CotEventSendTime || field == CotEventStaleTime))
+    {
+      ok = reader.readVarint(field == CotEventSendTime ? event.sendTime : event.staleTime);
+    }
+    else if (wireType == Fixed64 && field == CotEventLat)
+    {
+      ok = event.hasLat = reader.readDouble(event.lat);
+    }
+    else if (wireType == Fixed64 && field == CotEventLon)
+    {
+      ok = event.hasLon = reader.readDouble(event.lon);
+    }
+    else if (wireType == Fixed64 && field == CotEventHae)
+    {
+      ok = reader.readDouble(event.hae);
+    }
+    else
+    {
+      ok = reader.skip(wireType);
+    }
+
+    if (!ok)
+      return false;
+  }
+
+  return true;
+}
+
+}
+
+const char TakProtocolCodec::MAGIC_BYTE = static_cast<char>(0xBF);
+const quint8 TakProtocolCodec::VERSION = 1;
+
+/*!
+  \class Dsa::TakProtocolCodec
+  \inmodule Dsa
+  \brief Decodes and encodes CoT events in version 1 of the TAK protocol.
+
+  TAK endpoints send each CoT event as a protobuf \c TakMessage rather than as XML.
+  UDP uses the mesh header of the magic byte \c 0xBF, the protocol version and the
+  magic byte again; TCP streams use the magic byte followed by the varint length of
+  the message. Both are decoded.
+
+  Only the fields the app uses are read, straight from the bytes without a
+  protobuf library: the CoT type, uid, send and stale times, point and the contact
+  callsign. A \c 911 \c Alert emergency in the XML detail sets the distress status.
+  Other fields are skipped.
+ */
+
+/*!
+  \brief Returns whether \a data starts with a TAK protocol header.
+ */
+bool TakProtocolCodec::isTakMessage(const QByteArray& data)
+{
+  const char* payload = nullptr;
+  int size = 0;
+  return takPayload(data, payload, size);
+}
+
+/*!
+  \brief Decodes the TAK protocol \a data into a \l Message.
+
+  The message is decoded as the equivalent CoT XML event would be, with the
+  callsign as the unique designation. Returns an empty message if the data is
+  not a TAK message with a point and a CoT type which has a symbol.
+
+  This method is thread-safe.
+ */
+Message TakProtocolCodec::decode(const QByteArray& data)
+{
+  const char* payload = nullptr;
+  int size = 0;
+  if (!takPayload(data, payload, size))
+    return Message();
+
+  CotEvent event;
+  ProtobufReader reader(payload, size);
+  while (!reader.atEnd())
+  {
+    int field = 0;
+    int wireType = 0;
+    if (!reader.readTag(field, wireType))
+      return Message();
+
+    if (field == TakMessageCotEvent && wireType == LengthDelimited)
+    {
+      const char* value = nullptr;
+      int valueSize = 0;
+      if (!reader.readBytes(value, valueSize) || !readCotEvent(value, valueSize, event))
+        return Message();
+    }
+    else if (!reader.skip(wireType))
+    {
+      return Message();
+    }
+  }
+
+  if (!event.hasLat || !event.hasLon)
+    return Message();
+
+  const QString sidc = Message::cotTypeToSidc(event.type);
+  if (sidc.isEmpty())
+    return Message();
+
+  MessageAttributes attributes;
+  attributes.insert(Message::SIDC_NAME, sidc);
+  if (!event.callsign.isEmpty())
+    attributes.insert(Message::GEOMESSAGE_UNIQUE_DESIGNATION_NAME, event.callsign);
+  if (event.xmlDetail.contains("<emergency") && !event.xmlDetail.contains("cancel=\"true\""))
+    attributes.insert(Message::GEOMESSAGE_STATUS_911_NAME, QStringLiteral("1"));
+
+  const double hae = event.hae == s_unknownValue ? 0.0 : event.hae;
+
+  // TAK events are always updates, like CoT XML
+  Message message(Message::MessageAction::Update, Point(event.lon, event.lat, hae, SpatialReference::wgs84()));
+  message.setMessageType(QStringLiteral("cot"));
+  message.setSymbolId(sidc);
+  message.setMessageId(event.uid);
+  message.setMessageAttributes(attributes);
+  message.setEventTime(static_cast<qint64>(event.sendTime));
+  message.setStaleTime(static_cast<qint64>(event.staleTime));
+
+  return message;
+}
+
+/*!
+  \brief Encodes the update \a message as a TAK protocol mesh message which goes
+  stale \a staleInterval milliseconds after it is sent.
+
+  Returns an empty byte array if the message is not an update with a point
+  geometry whose symbol ID can be expressed as a CoT type.
+ */
+QByteArray TakProtocolCodec::encode(const Message& message, qint64 staleInterval)
+{
+  if (message.messageAction() != Message::MessageAction::Update ||
+      message.geometry().geometryType() != GeometryType::Point)
+  {
+    return QByteArray();
+  }
+
+  const QString cotType = sidcToCoTType(message.symbolId());
+  if (cotType.isEmpty())
+    return QByteArray();
+
+  const Geometry geometry = message.geometry();
+  const Point point(geometry.spatialReference() == SpatialReference::wgs84() ?
+                      geometry : GeometryEngine::project(geometry, SpatialReference::wgs84()));
+
+  QByteArray contact;
+  const QString callsign = message.attributeValue(Message::GEOMESSAGE_UNIQUE_DESIGNATION_NAME).toString();
+  writeBytesField(contact, ContactCallsign, callsign.toUtf8());
+
+  QByteArray detail;
+  if (message.attributeValue(Message::GEOMESSAGE_STATUS_911_NAME).toInt() == 1)
+  {
+    const QString emergency = QStringLiteral("<emergency type=\"911 Alert\">%1</emergency>").arg(callsign.toHtmlEscaped());
+    writeBytesField(detail, DetailXmlDetail, emergency.toUtf8());
+  }
+  writeBytesField(detail, DetailContact, contact);
+
+  const quint64 now = static_cast<quint64>(QDateTime::currentMSecsSinceEpoch());
+
+  QByteArray cotEvent;
+  writeBytesField(cotEvent, CotEventType, cotType.toUtf8());
+  writeBytesField(cotEvent, CotEventUid, message.messageId().toUtf8());
+  writeVarintField(cotEvent, CotEventSendTime, now);
+  writeVarintField(cotEvent, CotEventStartTime, now);
+  writeVarintField(cotEvent, CotEventStaleTime, now + static_cast<quint64>(qMax<qint64>(0, staleInterval)));
+  writeBytesField(cotEvent, CotEventHow, QByteArrayLiteral("m-g"));
+  writeDoubleField(cotEvent, CotEventLat, point.y());
+  writeDoubleField(cotEvent, CotEventLon, point.x());
+  writeDoubleField(cotEvent, CotEventHae, point.hasZ() ? point.z() : s_unknownValue);
+  writeDoubleField(cotEvent, CotEventCe, s_unknownValue);
+  writeDoubleField(cotEvent, CotEventLe, s_unknownValue);
+  writeBytesField(cotEvent, CotEventDetail, detail);
+
+  QByteArray data;
+  data.reserve(cotEvent.size() + s_meshHeaderSize + 4);
+  data.append(MAGIC_BYTE);
+  data.append(static_cast<char>(VERSION));
+  data.append(MAGIC_BYTE);
+  writeBytesField(data, TakMessageCotEvent, cotEvent);
+
+  return data;
+}
+
+/*!
+  \brief Converts the \a sidc symbol code of an atom to a CoT type, the reverse of
+  \l Message::cotTypeToSidc. Returns an empty string if \a sidc is not an atom.
+
+  For example, the sidc \c SFGPEVAL------- is the CoT type \c a-f-G-E-V-A-L.
+ */
+QString TakProtocolCodec::sidcToCoTType(const QString& sidc)
+{
+  if (sidc.size() < 4 || sidc.at(0) != QLatin1Char('S'))
+    return QString();
+
+  QString cotType = QStringLiteral("a-");
+  cotType += sidc.at(1).toLower();
+  cotType += QLatin1Char('-');
+  cotType += sidc.at(2);
+
+  // the function code ends at the first unused position
+  for (int i = 4; i < qMin(sidc.size(), 10) && sidc.at(i) != QLatin1Char('-'); ++i)
+  {
+    cotType += QLatin1Char('-');
+    cotType += sidc.at(i);
+  }
+
+  return cotType;
+}
+
+} // Dsa
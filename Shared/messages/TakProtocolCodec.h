@@ -0,0 +1,44 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef TAKPROTOCOLCODEC_H
+#define TAKPROTOCOLCODEC_H
+
+// dsa app headers
+#include "Message.h"
+
+// Qt headers
+#include <QByteArray>
+#include <QString>
+
+namespace Dsa {
+
+class TakProtocolCodec
+{
+public:
+  static const char MAGIC_BYTE;
+  static const quint8 VERSION;
+
+  static bool isTakMessage(const QByteArray& data);
+  static Message decode(const QByteArray& data);
+  static QByteArray encode(const Message& message, qint64 staleInterval);
+
+  static QString sidcToCoTType(const QString& sidc);
+};
+
+} // Dsa
+
+#endif // TAKPROTOCOLCODEC_H
@@ -0,0 +1,432 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "TrackBreadcrumbOverlay.h"
+
+// dsa app headers
+#include "MessagesOverlay.h"
+#include "WebMercator.h"
+
+// C++ API headers
+#include "GraphicListModel.h"
+#include "GraphicsOverlay.h"
+#include "GraphicsOverlayListModel.h"
+#include "MapQuickView.h"
+#include "PolylineBuilder.h"
+#include "Renderer.h"
+#include "SceneQuickView.h"
+
+// Qt headers
+#include <QTimer>
+
+// STL headers
+#include <cmath>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+namespace {
+
+// trails are redrawn at most this often, in ms
+constexpr int s_trailRefreshInterval = 250;
+
+const QString s_trailRendererJson = QStringLiteral(
+  "{\"type\":\"simple\","
+  "\"symbol\":{\"type\":\"esriSLS\",\"style\":\"esriSLSDot\",\"color\":[0,92,230,160],\"width\":1.5}}");
+
+} // namespace
+
+/*!
+  \class Dsa::TrackBreadcrumbOverlay
+  \inmodule Dsa
+  \inherits QObject
+  \brief Records the recent positions of the tracks of a \l MessagesOverlay and draws
+  them as trails of breadcrumbs.
+
+  The positions are held in a \l TrackHistory, with up to \l capacity points per track.
+  Each track is drawn as a polyline which is decimated for the current scale: a point is
+  only kept if it lies further than \l tolerance pixels from the point kept before it, and
+  the newest point always ends the trail.
+
+  The decimation levels form a hierarchy like those of \l MessageClusterOverlay, where each
+  level halves the tolerance of the one above. While the level stays the same, trails are
+  updated incrementally as points arrive and fall out of the history. They are only
+  decimated again from the history when the level changes, and only the trails which
+  changed are redrawn, in batches.
+ */
+
+/*!
+  \brief Constructor taking the \a messagesOverlay whose tracks are recorded, the
+  \a capacity of each track's history and an optional \a parent.
+ */
+TrackBreadcrumbOverlay::TrackBreadcrumbOverlay(MessagesOverlay* messagesOverlay, int capacity, QObject* parent) :
+  QObject(parent),
+  m_messagesOverlay(messagesOverlay),
+  m_geoView(messagesOverlay->geoView()),
+  m_graphicsOverlay(new GraphicsOverlay(this)),
+  m_history(capacity),
+  m_refreshTimer(new QTimer(this))
+{
+  m_refreshTimer->setSingleShot(true);
+  m_refreshTimer->setInterval(s_trailRefreshInterval);
+  connect(m_refreshTimer, &QTimer::timeout, this, &TrackBreadcrumbOverlay::refresh);
+
+  m_graphicsOverlay->setOverlayId(messagesOverlay->messageType() + QStringLiteral("_trails"));
+  m_graphicsOverlay->setRenderingMode(GraphicsRenderingMode::Dynamic);
+  m_graphicsOverlay->setSceneProperties(LayerSceneProperties(messagesOverlay->surfacePlacement()));
+  m_graphicsOverlay->setRenderer(Renderer::fromJson(s_trailRendererJson, this));
+
+  // trails are drawn beneath the track symbols
+  GraphicsOverlayListModel* graphicsOverlays = m_geoView->graphicsOverlays();
+  const int tracksIndex = graphicsOverlays->indexOf(messagesOverlay->graphicsOverlay());
+  if (tracksIndex != -1)
+    graphicsOverlays->insert(tracksIndex, m_graphicsOverlay);
+  else
+    graphicsOverlays->append(m_graphicsOverlay);
+
+  if (auto sceneView = dynamic_cast<SceneQuickView*>(m_geoView))
+    connect(sceneView, &SceneQuickView::viewpointChanged, this, &TrackBreadcrumbOverlay::handleViewpointChanged);
+  else if (auto mapView = dynamic_cast<MapQuickView*>(m_geoView))
+    connect(mapView, &MapQuickView::viewpointChanged, this, &TrackBreadcrumbOverlay::handleViewpointChanged);
+
+  handleViewpointChanged();
+}
+
+/*!
+  \brief Destructor.
+ */
+TrackBreadcrumbOverlay::~TrackBreadcrumbOverlay()
+{
+  GraphicsOverlayListModel* graphicsOverlays = m_geoView->graphicsOverlays();
+  const int index = graphicsOverlays->indexOf(m_graphicsOverlay);
+  if (index != -1)
+    graphicsOverlays->removeAt(index);
+}
+
+/*!
+  \brief Returns the graphics overlay holding the trail graphics.
+ */
+GraphicsOverlay* TrackBreadcrumbOverlay::graphicsOverlay() const
+{
+  return m_graphicsOverlay;
+}
+
+/*!
+  \brief Returns the recorded positions of the tracks, keyed by their message keys.
+ */
+const TrackHistory& TrackBreadcrumbOverlay::history() const
+{
+  return m_history;
+}
+
+/*!
+  \brief Returns the maximum number of points recorded for each track.
+ */
+int TrackBreadcrumbOverlay::capacity() const
+{
+  return m_history.capacity();
+}
+
+/*!
+  \brief Sets the maximum number of points recorded for each track to \a capacity.
+
+  Changing the capacity clears the recorded positions and the trails.
+ */
+void TrackBreadcrumbOverlay::setCapacity(int capacity)
+{
+  if (capacity <= 0 || capacity == m_history.capacity())
+    return;
+
+  m_history.setCapacity(capacity);
+
+  m_refreshTimer->stop();
+  m_graphicsOverlay->graphics()->clear();
+  for (const Trail& trail : qAsConst(m_trails))
+    delete trail.m_graphic;
+
+  m_trails.clear();
+  m_dirtyTrails.clear();
+}
+
+/*!
+  \brief Returns the distance, in pixels, within which points of a trail are merged.
+
+  The default is \c 2 pixels.
+ */
+int TrackBreadcrumbOverlay::tolerance() const
+{
+  return m_tolerance;
+}
+
+/*!
+  \brief Sets the distance within which points of a trail are merged to \a tolerance pixels.
+ */
+void TrackBreadcrumbOverlay::setTolerance(int tolerance)
+{
+  if (tolerance <= 0 || m_tolerance == tolerance)
+    return;
+
+  m_tolerance = tolerance;
+  handleViewpointChanged();
+}
+
+/*!
+  \brief Returns the decimation level in use.
+
+  Points are merged within 1/2^n of the width of the web mercator world at level \c n.
+ */
+int TrackBreadcrumbOverlay::level() const
+{
+  return m_level;
+}
+
+/*!
+  \brief Records the position at \a longitude and \a latitude, in WGS84 degrees, of
+  \a trackKey at \a msecsSinceEpoch and extends its trail.
+ */
+void TrackBreadcrumbOverlay::addPoint(int trackKey, double longitude, double latitude, qint64 msecsSinceEpoch)
+{
+  if (!m_history.append(trackKey, longitude, latitude, msecsSinceEpoch))
+    return;
+
+  double x = 0.0;
+  double y = 0.0;
+  WebMercator::toWebMercator(longitude, latitude, x, y);
+
+  Trail& trail = m_trails[trackKey];
+  trimTrail(trackKey, trail);
+  appendVertex(trail, x, y, m_history.time(trackKey, m_history.count(trackKey) - 1));
+  markDirty(trackKey);
+}
+
+/*!
+  \brief Removes the recorded positions and the trail of \a trackKey.
+ */
+void TrackBreadcrumbOverlay::removeTrack(int trackKey)
+{
+  m_history.remove(trackKey);
+  m_dirtyTrails.remove(trackKey);
+
+  auto trailIt = m_trails.find(trackKey);
+  if (trailIt == m_trails.end())
+    return;
+
+  if (trailIt->m_graphic)
+  {
+    m_graphicsOverlay->graphics()->removeOne(trailIt->m_graphic);
+    delete trailIt->m_graphic;
+  }
+
+  m_trails.erase(trailIt);
+}
+
+/*!
+  \brief Redraws the trails which have changed.
+
+  This is called shortly after trails change, so that a burst of messages
+  redraws each trail once.
+ */
+void TrackBreadcrumbOverlay::refresh()
+{
+  m_refreshTimer->stop();
+
+  if (m_dirtyTrails.isEmpty())
+    return;
+
+  QList<Graphic*> newGraphics;
+  GraphicListModel* graphics = m_graphicsOverlay->graphics();
+
+  for (const int trackKey : qAsConst(m_dirtyTrails))
+  {
+    auto trailIt = m_trails.find(trackKey);
+    if (trailIt == m_trails.end())
+      continue;
+
+    Trail& trail = trailIt.value();
+    if (trail.m_xs.size() < 2)
+    {
+      if (trail.m_graphic)
+      {
+        graphics->removeOne(trail.m_graphic);
+        delete trail.m_graphic;
+        trail.m_graphic = nullptr;
+      }
+      continue;
+    }
+
+    PolylineBuilder builder(SpatialReference::webMercator());
+    for (int i = 0; i < trail.m_xs.size(); ++i)
+      builder.addPoint(trail.m_xs.at(i), trail.m_ys.at(i));
+
+    if (trail.m_graphic)
+    {
+      trail.m_graphic->setGeometry(builder.toGeometry());
+    }
+    else
+    {
+      trail.m_graphic = new Graphic(builder.toGeometry(), this);
+      newGraphics.append(trail.m_graphic);
+    }
+  }
+
+  m_dirtyTrails.clear();
+
+  if (!newGraphics.isEmpty())
+    graphics->append(newGraphics);
+}
+
+/*!
+  \internal
+  \brief Switches to the decimation level for the current scale of the view.
+
+  The viewpoint changes every frame while navigating, but the trails are
+  only decimated again when the level changes.
+ */
+void TrackBreadcrumbOverlay::handleViewpointChanged()
+{
+  const double scale = m_geoView->currentViewpoint(ViewpointType::CenterAndScale).targetScale();
+  setLevel(levelForScale(scale));
+}
+
+/*!
+  \internal
+  \brief Appends the vertex at \a x, \a y, recorded at \a time, to the end of \a trail.
+
+  The previous newest vertex is replaced if it lies within the tolerance of the vertex before it.
+ */
+void TrackBreadcrumbOverlay::appendVertex(Trail& trail, double x, double y, qint64 time) const
+{
+  const int count = trail.m_xs.size();
+  if (count >= 2 &&
+      std::hypot(trail.m_xs.at(count - 1) - trail.m_xs.at(count - 2),
+                 trail.m_ys.at(count - 1) - trail.m_ys.at(count - 2)) < m_toleranceMeters)
+  {
+    trail.m_xs[count - 1] = x;
+    trail.m_ys[count - 1] = y;
+    trail.m_times[count - 1] = time;
+    return;
+  }
+
+  trail.m_xs.append(x);
+  trail.m_ys.append(y);
+  trail.m_times.append(time);
+}
+
+/*!
+  \internal
+  \brief Removes the vertices of \a trail whose points have fallen out of the history
+  of \a trackKey, so that the trail starts at the oldest recorded point.
+ */
+void TrackBreadcrumbOverlay::trimTrail(int trackKey, Trail& trail) const
+{
+  if (trail.m_times.isEmpty() || m_history.count(trackKey) == 0)
+    return;
+
+  const qint64 oldest = m_history.time(trackKey, 0);
+  if (trail.m_times.first() >= oldest)
+    return;
+
+  int dropped = 0;
+  while (dropped < trail.m_times.size() && trail.m_times.at(dropped) < oldest)
+    ++dropped;
+
+  trail.m_xs.remove(0, dropped);
+  trail.m_ys.remove(0, dropped);
+  trail.m_times.remove(0, dropped);
+
+  // the oldest recorded point was merged into a later vertex, so start the trail from it again
+  if (trail.m_times.isEmpty() || trail.m_times.first() > oldest)
+  {
+    double x = 0.0;
+    double y = 0.0;
+    WebMercator::toWebMercator(m_history.longitude(trackKey, 0), m_history.latitude(trackKey, 0), x, y);
+    trail.m_xs.prepend(x);
+    trail.m_ys.prepend(y);
+    trail.m_times.prepend(oldest);
+  }
+}
+
+/*!
+  \internal
+  \brief Rebuilds the vertices of \a trail from the history of \a trackKey at the current level.
+ */
+void TrackBreadcrumbOverlay::decimateTrail(int trackKey, Trail& trail) const
+{
+  trail.m_xs.clear();
+  trail.m_ys.clear();
+  trail.m_times.clear();
+
+  const int count = m_history.count(trackKey);
+  for (int i = 0; i < count; ++i)
+  {
+    double x = 0.0;
+    double y = 0.0;
+    WebMercator::toWebMercator(m_history.longitude(trackKey, i), m_history.latitude(trackKey, i), x, y);
+    appendVertex(trail, x, y, m_history.time(trackKey, i));
+  }
+}
+
+/*!
+  \internal
+  \brief Switches to the decimation \a level and decimates every trail again.
+ */
+void TrackBreadcrumbOverlay::setLevel(int level)
+{
+  if (m_level == level)
+    return;
+
+  m_level = level;
+  m_toleranceMeters = WebMercator::s_worldWidth / static_cast<double>(1 << m_level);
+
+  for (auto it = m_trails.begin(); it != m_trails.end(); ++it)
+  {
+    decimateTrail(it.key(), it.value());
+    m_dirtyTrails.insert(it.key());
+  }
+
+  refresh();
+}
+
+/*!
+  \internal
+ */
+void TrackBreadcrumbOverlay::markDirty(int trackKey)
+{
+  m_dirtyTrails.insert(trackKey);
+
+  if (!m_refreshTimer->isActive())
+    m_refreshTimer->start();
+}
+
+/*!
+  \internal
+  \brief Returns the coarsest level whose merge distance is no more than \l tolerance pixels at \a scale.
+ */
+int TrackBreadcrumbOverlay::levelForScale(double scale) const
+{
+  const double toleranceMeters = m_tolerance * scale * WebMercator::s_metersPerPixel;
+  if (toleranceMeters <= 0.0)
+    return WebMercator::s_maxLevel;
+
+  const int level = static_cast<int>(std::ceil(std::log2(WebMercator::s_worldWidth / toleranceMeters)));
+  return qBound(0, level, WebMercator::s_maxLevel);
+}
+
+} // Dsa
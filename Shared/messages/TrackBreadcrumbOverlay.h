@@ -0,0 +1,106 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef TRACKBREADCRUMBOVERLAY_H
+#define TRACKBREADCRUMBOVERLAY_H
+
+// dsa app headers
+#include "TrackHistory.h"
+
+// Qt headers
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QVector>
+
+class QTimer;
+
+namespace Esri
+{
+  namespace ArcGISRuntime
+  {
+    class GeoView;
+    class Graphic;
+    class GraphicsOverlay;
+  }
+}
+
+namespace Dsa {
+
+class MessagesOverlay;
+
+class TrackBreadcrumbOverlay : public QObject
+{
+  Q_OBJECT
+
+public:
+  TrackBreadcrumbOverlay(MessagesOverlay* messagesOverlay, int capacity, QObject* parent = nullptr);
+  ~TrackBreadcrumbOverlay();
+
+  Esri::ArcGISRuntime::GraphicsOverlay* graphicsOverlay() const;
+
+  const TrackHistory& history() const;
+
+  int capacity() const;
+  void setCapacity(int capacity);
+
+  int tolerance() const;
+  void setTolerance(int tolerance);
+
+  int level() const;
+
+  void addPoint(int trackKey, double longitude, double latitude, qint64 msecsSinceEpoch);
+  void removeTrack(int trackKey);
+
+  void refresh();
+
+private:
+  Q_DISABLE_COPY(TrackBreadcrumbOverlay)
+
+  // the vertices drawn for a track, in web mercator meters. The last vertex is
+  // always the newest point, even if it lies within the tolerance of the one before
+  struct Trail
+  {
+    Esri::ArcGISRuntime::Graphic* m_graphic = nullptr;
+    QVector<double> m_xs;
+    QVector<double> m_ys;
+    QVector<qint64> m_times;
+  };
+
+  void handleViewpointChanged();
+  void appendVertex(Trail& trail, double x, double y, qint64 time) const;
+  void trimTrail(int trackKey, Trail& trail) const;
+  void decimateTrail(int trackKey, Trail& trail) const;
+  void setLevel(int level);
+  void markDirty(int trackKey);
+  int levelForScale(double scale) const;
+
+  MessagesOverlay* m_messagesOverlay = nullptr;
+  Esri::ArcGISRuntime::GeoView* m_geoView = nullptr;
+  Esri::ArcGISRuntime::GraphicsOverlay* m_graphicsOverlay = nullptr;
+  TrackHistory m_history;
+  int m_tolerance = 2;
+  int m_level = -1;
+  double m_toleranceMeters = 0.0;
+
+  QHash<int, Trail> m_trails;
+  QSet<int> m_dirtyTrails;
+  QTimer* m_refreshTimer = nullptr;
+};
+
+} // Dsa
+
+#endif // TRACKBREADCRUMBOVERLAY_H
@@ -0,0 +1,294 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "TrackHistory.h"
+
+// STL headers
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace Dsa {
+
+namespace
+{
+// points are stored in units of 1e-7 degrees, roughly 1cm
+constexpr double s_degreesScale = 1e7;
+
+// times are stored in units of 100ms from the first point recorded, which covers
+// more than 13 years
+constexpr qint64 s_timeResolution = 100;
+
+qint32 quantizeDegrees(double degrees)
+{
+  return static_cast<qint32>(std::lround(degrees * s_degreesScale));
+}
+}
+
+/*!
+  \class Dsa::TrackHistory
+  \inmodule Dsa
+  \brief A compact store of the recent positions of many tracks, for trails and
+  after-action review.
+
+  Each track, identified by its dense \l {Message::messageKey}{message key}, holds a
+  ring buffer of up to \l capacity points. Once full, each new point replaces the oldest.
+  The points of every track are kept in structure-of-arrays form: longitudes, latitudes
+  and times are held in separate flat arrays of 32-bit integers, with \l capacity entries
+  per track. Positions are quantized to 1e-7 degrees and times to 100ms, so each point
+  costs 12 bytes and no allocation is made per point.
+
+  A point at the same quantized position as the last point of its track is not stored.
+
+  Points are indexed from \c 0, the oldest, to \c {count - 1}, the newest.
+ */
+
+/*!
+  \brief Constructor taking the \a capacity of each track.
+ */
+TrackHistory::TrackHistory(int capacity):
+  m_capacity(std::max(1, capacity))
+{
+}
+
+/*!
+  \brief Destructor.
+ */
+TrackHistory::~TrackHistory()
+{
+}
+
+/*!
+  \brief Returns the maximum number of points held for each track.
+ */
+int TrackHistory::capacity() const
+{
+  return m_capacity;
+}
+
+/*!
+  \brief Sets the maximum number of points held for each track to \a capacity.
+
+  Changing the capacity clears the history.
+ */
+void TrackHistory::setCapacity(int capacity)
+{
+  capacity = std::max(1, capacity);
+  if (capacity == m_capacity)
+    return;
+
+  clear();
+  m_capacity = capacity;
+}
+
+/*!
+  \brief Appends the point at \a longitude and \a latitude, in WGS84 degrees, at
+  \a msecsSinceEpoch to the history of \a trackKey.
+
+  Returns \c false if the point was not stored because \a trackKey is invalid or
+  the track has not moved since its last point.
+ */
+bool TrackHistory::append(int trackKey, double longitude, double latitude, qint64 msecsSinceEpoch)
+{
+  if (trackKey < 0)
+    return false;
+
+  if (m_epoch < 0)
+    m_epoch = msecsSinceEpoch;
+
+  const qint32 x = quantizeDegrees(longitude);
+  const qint32 y = quantizeDegrees(latitude);
+  const qint64 units = (msecsSinceEpoch - m_epoch) / s_timeResolution;
+  const quint32 t = static_cast<quint32>(std::min<qint64>(std::max<qint64>(units, 0), std::numeric_limits<quint32>::max()));
+
+  if (trackKey >= m_slots.size())
+    m_slots.resize(trackKey + 1);
+
+  int trackSlot = m_slots.at(trackKey) - 1;
+  if (trackSlot < 0)
+  {
+    // reuse the arrays of a removed track before growing them
+    if (!m_freeSlots.isEmpty())
+    {
+      trackSlot = m_freeSlots.takeLast();
+    }
+    else
+    {
+      trackSlot = m_heads.size();
+      m_heads.append(0);
+      m_counts.append(0);
+      const int size = (trackSlot + 1) * m_capacity;
+      m_longitudes.resize(size);
+      m_latitudes.resize(size);
+      m_times.resize(size);
+    }
+
+    m_heads[trackSlot] = 0;
+    m_counts[trackSlot] = 0;
+    m_slots[trackKey] = trackSlot + 1;
+    ++m_trackCount;
+  }
+
+  int& count = m_counts[trackSlot];
+  if (count > 0)
+  {
+    const int last = position(trackSlot, count - 1);
+    if (m_longitudes.at(last) == x && m_latitudes.at(last) == y)
+      return false;
+  }
+
+  int next = 0;
+  if (count < m_capacity)
+  {
+    next = position(trackSlot, count);
+    ++count;
+  }
+  else
+  {
+    // the oldest point is overwritten
+    next = position(trackSlot, 0);
+    m_heads[trackSlot] = (m_heads.at(trackSlot) + 1) % m_capacity;
+  }
+
+  m_longitudes[next] = x;
+  m_latitudes[next] = y;
+  m_times[next] = t;
+  return true;
+}
+
+/*!
+  \brief Removes the history of \a trackKey.
+ */
+void TrackHistory::remove(int trackKey)
+{
+  const int trackSlot = slot(trackKey);
+  if (trackSlot < 0)
+    return;
+
+  m_slots[trackKey] = 0;
+  m_counts[trackSlot] = 0;
+  m_freeSlots.append(trackSlot);
+  --m_trackCount;
+}
+
+/*!
+  \brief Removes the history of every track.
+ */
+void TrackHistory::clear()
+{
+  m_slots.clear();
+  m_freeSlots.clear();
+  m_heads.clear();
+  m_counts.clear();
+  m_longitudes.clear();
+  m_latitudes.clear();
+  m_times.clear();
+  m_trackCount = 0;
+  m_epoch = -1;
+}
+
+/*!
+  \brief Returns whether there is a history for \a trackKey.
+ */
+bool TrackHistory::contains(int trackKey) const
+{
+  return slot(trackKey) >= 0;
+}
+
+/*!
+  \brief Returns the number of points held for \a trackKey.
+ */
+int TrackHistory::count(int trackKey) const
+{
+  const int trackSlot = slot(trackKey);
+  return trackSlot < 0 ? 0 : m_counts.at(trackSlot);
+}
+
+/*!
+  \brief Returns the number of tracks with a history.
+ */
+int TrackHistory::trackCount() const
+{
+  return m_trackCount;
+}
+
+/*!
+  \brief Returns the longitude, in WGS84 degrees, of the point at \a index of \a trackKey.
+
+  \a index must be less than \l count for \a trackKey.
+ */
+double TrackHistory::longitude(int trackKey, int index) const
+{
+  return m_longitudes.at(position(slot(trackKey), index)) / s_degreesScale;
+}
+
+/*!
+  \brief Returns the latitude, in WGS84 degrees, of the point at \a index of \a trackKey.
+
+  \a index must be less than \l count for \a trackKey.
+ */
+double TrackHistory::latitude(int trackKey, int index) const
+{
+  return m_latitudes.at(position(slot(trackKey), index)) / s_degreesScale;
+}
+
+/*!
+  \brief Returns the time, in milliseconds since the epoch, of the point at \a index of \a trackKey.
+
+  \a index must be less than \l count for \a trackKey.
+ */
+qint64 TrackHistory::time(int trackKey, int index) const
+{
+  return m_epoch + static_cast<qint64>(m_times.at(position(slot(trackKey), index))) * s_timeResolution;
+}
+
+/*!
+  \brief Returns the approximate number of bytes used by the history.
+ */
+qint64 TrackHistory::memoryUsage() const
+{
+  return static_cast<qint64>(m_slots.capacity() + m_freeSlots.capacity() + m_heads.capacity() + m_counts.capacity()) * sizeof(int) +
+      static_cast<qint64>(m_longitudes.capacity() + m_latitudes.capacity()) * sizeof(qint32) +
+      static_cast<qint64>(m_times.capacity()) * sizeof(quint32);
+}
+
+/*!
+  \internal
+
+  Returns the slot holding the history of \a trackKey, or \c -1.
+ */
+int TrackHistory::slot(int trackKey) const
+{
+  if (trackKey < 0 || trackKey >= m_slots.size())
+    return -1;
+
+  return m_slots.at(trackKey) - 1;
+}
+
+/*!
+  \internal
+
+  Returns the array position of the point at \a index of \a slot.
+ */
+int TrackHistory::position(int slot, int index) const
+{
+  return slot * m_capacity + (m_heads.at(slot) + index) % m_capacity;
+}
+
+} // Dsa
@@ -0,0 +1,76 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef TRACKHISTORY_H
+#define TRACKHISTORY_H
+
+// Qt headers
+#include <QVector>
+
+namespace Dsa {
+
+class TrackHistory
+{
+public:
+  explicit TrackHistory(int capacity = s_defaultCapacity);
+  ~TrackHistory();
+
+  int capacity() const;
+  void setCapacity(int capacity);
+
+  bool append(int trackKey, double longitude, double latitude, qint64 msecsSinceEpoch);
+  void remove(int trackKey);
+  void clear();
+
+  bool contains(int trackKey) const;
+  int count(int trackKey) const;
+  int trackCount() const;
+
+  double longitude(int trackKey, int index) const;
+  double latitude(int trackKey, int index) const;
+  qint64 time(int trackKey, int index) const;
+
+  qint64 memoryUsage() const;
+
+  static constexpr int s_defaultCapacity = 64;
+
+private:
+  Q_DISABLE_COPY(TrackHistory)
+
+  int slot(int trackKey) const;
+  int position(int slot, int index) const;
+
+  int m_capacity = s_defaultCapacity;
+  int m_trackCount = 0;
+
+  // one more than the slot holding the history of each track key, or 0 if there is none
+  QVector<int> m_slots;
+  QVector<int> m_freeSlots;
+
+  // the ring buffer of each slot: the position of its oldest point and the number of points
+  QVector<int> m_heads;
+  QVector<int> m_counts;
+
+  // quantized points, m_capacity per slot
+  QVector<qint32> m_longitudes;
+  QVector<qint32> m_latitudes;
+  QVector<quint32> m_times;
+  qint64 m_epoch = -1;
+};
+
+} // Dsa
+
+#endif // TRACKHISTORY_H
@@ -0,0 +1,295 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "TrackReplaySimulator.h"
+
+// dsa app headers
+#include "GeodesicKernels.h"
+#include "MessageFeedStats.h"
+
+// C++ API headers
+#include "Point.h"
+
+// Qt headers
+#include <QTimer>
+
+// STL headers
+#include <algorithm>
+#include <cmath>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+/*!
+  \class Dsa::TrackReplaySimulator
+  \inmodule Dsa
+  \inherits QObject
+  \brief Replays many GPX tracks at once as a stream of \l Message updates.
+
+  This is a soak-test harness for the message feeds and the components which
+  consume them, such as the alert engine. Each track is a copy of a \l GPXTrack
+  offset in time and space, and is reported as its own message. Copies of the
+  same file share the parsed track points.
+
+  A single timer drives every track. On each tick the position of every track
+  is computed and \l messagesGenerated is emitted once with the whole batch.
+ */
+
+/*!
+  \brief Constructor taking an optional \a parent.
+ */
+TrackReplaySimulator::TrackReplaySimulator(QObject* parent):
+  QObject(parent),
+  m_timer(new QTimer(this))
+{
+  m_timer->setInterval(1000);
+  connect(m_timer, &QTimer::timeout, this, &TrackReplaySimulator::handleTimerEvent);
+}
+
+/*!
+  \brief Destructor.
+ */
+TrackReplaySimulator::~TrackReplaySimulator()
+{
+}
+
+/*!
+  \brief Adds \a count copies of the track in the GPX file \a gpxFileName.
+
+  The copies are laid out on a square grid with \a spacing meters between them,
+  and their start times are spread evenly across the duration of the track.
+
+  Returns \c false if the file does not contain a track which can be simulated.
+ */
+bool TrackReplaySimulator::addTracks(const QString& gpxFileName, int count, double spacing)
+{
+  const GPXTrack track = GPXTrack::fromFile(gpxFileName);
+  if (!track.isValid() || count <= 0)
+    return false;
+
+  const int columns = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(count))));
+  m_tracks.reserve(m_tracks.size() + count);
+
+  for (int i = 0; i < count; ++i)
+  {
+    const qint64 timeOffset = track.duration() * i / count;
+    addTrack(track, timeOffset, (i % columns) * spacing, (i / columns) * spacing);
+  }
+
+  return true;
+}
+
+/*!
+  \brief Adds a copy of \a track which is \a timeOffset milliseconds ahead of the track,
+  and offset by \a offsetX meters east and \a offsetY meters north.
+ */
+void TrackReplaySimulator::addTrack(const GPXTrack& track, qint64 timeOffset, double offsetX, double offsetY)
+{
+  if (!track.isValid())
+    return;
+
+  ReplayTrack replayTrack;
+  replayTrack.m_track = track;
+  replayTrack.m_timeOffset = track.duration() > 0 ? timeOffset % track.duration() : 0;
+  replayTrack.m_offsetX = offsetX;
+  replayTrack.m_offsetY = offsetY;
+  replayTrack.m_messageId = QStringLiteral("replay-%1").arg(m_tracks.size());
+  m_tracks.append(replayTrack);
+}
+
+/*!
+  \brief Removes every track.
+ */
+void TrackReplaySimulator::clear()
+{
+  m_tracks.clear();
+}
+
+/*!
+  \brief Returns the number of tracks being replayed.
+ */
+int TrackReplaySimulator::trackCount() const
+{
+  return m_tracks.size();
+}
+
+/*!
+  \brief Returns the message type of the generated messages.
+ */
+QString TrackReplaySimulator::messageType() const
+{
+  return m_messageType;
+}
+
+/*!
+  \brief Sets the message type of the generated messages to \a messageType.
+
+  This should match the type of a configured message feed.
+ */
+void TrackReplaySimulator::setMessageType(const QString& messageType)
+{
+  m_messageType = messageType;
+}
+
+/*!
+  \brief Returns the symbol ID of the generated messages.
+ */
+QString TrackReplaySimulator::symbolId() const
+{
+  return m_symbolId;
+}
+
+/*!
+  \brief Sets the symbol ID of the generated messages to \a symbolId.
+ */
+void TrackReplaySimulator::setSymbolId(const QString& symbolId)
+{
+  m_symbolId = symbolId;
+}
+
+/*!
+  \brief Returns the interval between updates in milliseconds.
+ */
+int TrackReplaySimulator::updateInterval() const
+{
+  return m_timer->interval();
+}
+
+/*!
+  \brief Sets the interval between updates to \a updateInterval milliseconds.
+ */
+void TrackReplaySimulator::setUpdateInterval(int updateInterval)
+{
+  m_timer->setInterval(updateInterval);
+}
+
+/*!
+  \brief Returns the playback multiplier.
+ */
+int TrackReplaySimulator::playbackMultiplier() const
+{
+  return m_playbackMultiplier;
+}
+
+/*!
+  \brief Sets the playback multiplier to \a playbackMultiplier.
+ */
+void TrackReplaySimulator::setPlaybackMultiplier(int playbackMultiplier)
+{
+  m_playbackMultiplier = playbackMultiplier;
+}
+
+/*!
+  \brief Returns whether the tracks are being replayed.
+ */
+bool TrackReplaySimulator::isRunning() const
+{
+  return m_timer->isActive();
+}
+
+/*!
+  \brief Starts replaying the tracks from their start.
+ */
+void TrackReplaySimulator::start()
+{
+  if (m_tracks.isEmpty() || isRunning())
+    return;
+
+  for (ReplayTrack& replayTrack : m_tracks)
+    replayTrack.m_segment = 0;
+
+  m_elapsedTimer.start();
+  m_timer->start();
+}
+
+/*!
+  \brief Stops replaying the tracks.
+ */
+void TrackReplaySimulator::stop()
+{
+  m_timer->stop();
+}
+
+/*!
+  \internal
+
+  Computes the current position of every track and emits them as a single batch.
+ */
+void TrackReplaySimulator::handleTimerEvent()
+{
+  const qint64 playbackTime = m_elapsedTimer.elapsed() * m_playbackMultiplier;
+  const qint64 receivedTimestamp = MessageFeedStats::timestamp();
+
+  QList<Message> messages;
+  messages.reserve(m_tracks.size());
+
+  for (ReplayTrack& replayTrack : m_tracks)
+  {
+    const GPXTrack& track = replayTrack.m_track;
+    const qint64 duration = track.duration();
+
+    // each track loops back to its start once it reaches its end
+    const qint64 trackTime = track.startTime() + (duration > 0 ? (playbackTime + replayTrack.m_timeOffset) % duration : 0);
+    if (trackTime < track.at(replayTrack.m_segment).m_time)
+      replayTrack.m_segment = 0;
+
+    replayTrack.m_segment = std::max(0, track.segmentAt(trackTime, replayTrack.m_segment));
+
+    const double normalizedTime = track.segmentFraction(replayTrack.m_segment, trackTime);
+    double latitude = 0.0;
+    double longitude = 0.0;
+    double elevation = 0.0;
+    track.interpolate(replayTrack.m_segment, normalizedTime, latitude, longitude, elevation);
+
+    const double metersPerDegreeLongitude = Geodesic::s_metersPerDegree * std::max(std::cos(latitude * M_PI / 180.0), 0.01);
+    const double x = longitude + replayTrack.m_offsetX / metersPerDegreeLongitude;
+    const double y = latitude + replayTrack.m_offsetY / Geodesic::s_metersPerDegree;
+    const Point point = std::isnan(elevation) ?
+          Point(x, y, SpatialReference::wgs84()) :
+          Point(x, y, elevation, SpatialReference::wgs84());
+
+    QVariantMap attributes;
+    attributes.insert(Message::SIDC_NAME, m_symbolId);
+    attributes.insert(Message::GEOMESSAGE_UNIQUE_DESIGNATION_NAME, replayTrack.m_messageId);
+    attributes.insert(QStringLiteral("heading"), track.interpolatedHeading(replayTrack.m_segment, normalizedTime));
+
+    Message message(Message::MessageAction::Update, point);
+    message.setMessageId(replayTrack.m_messageId);
+    message.setMessageName(replayTrack.m_messageId);
+    message.setMessageType(m_messageType);
+    message.setSymbolId(m_symbolId);
+    message.setAttributes(attributes);
+    message.setReceivedTimestamp(receivedTimestamp);
+    messages.append(message);
+  }
+
+  if (!messages.isEmpty())
+    emit messagesGenerated(messages);
+}
+
+} // Dsa
+
+// Signal Documentation
+
+/*!
+  \fn void TrackReplaySimulator::messagesGenerated(const QList<Dsa::Message>& messages);
+
+  \brief Signal emitted with the \a messages for the current position of every track.
+ */
@@ -0,0 +1,92 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef TRACKREPLAYSIMULATOR_H
+#define TRACKREPLAYSIMULATOR_H
+
+// dsa app headers
+#include "GPXTrack.h"
+#include "Message.h"
+
+// Qt headers
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QVector>
+
+class QTimer;
+
+namespace Dsa {
+
+class TrackReplaySimulator : public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit TrackReplaySimulator(QObject* parent = nullptr);
+  ~TrackReplaySimulator();
+
+  bool addTracks(const QString& gpxFileName, int count, double spacing = 100.0);
+  void addTrack(const GPXTrack& track, qint64 timeOffset, double offsetX, double offsetY);
+  void clear();
+
+  int trackCount() const;
+
+  QString messageType() const;
+  void setMessageType(const QString& messageType);
+
+  QString symbolId() const;
+  void setSymbolId(const QString& symbolId);
+
+  int updateInterval() const;
+  void setUpdateInterval(int updateInterval);
+
+  int playbackMultiplier() const;
+  void setPlaybackMultiplier(int playbackMultiplier);
+
+  bool isRunning() const;
+  void start();
+  void stop();
+
+signals:
+  void messagesGenerated(const QList<Dsa::Message>& messages);
+
+private:
+  Q_DISABLE_COPY(TrackReplaySimulator)
+
+  struct ReplayTrack
+  {
+    GPXTrack m_track;
+    qint64 m_timeOffset = 0;
+    double m_offsetX = 0.0;
+    double m_offsetY = 0.0;
+    int m_segment = 0;
+    QString m_messageId;
+  };
+
+  void handleTimerEvent();
+
+  QTimer* m_timer = nullptr;
+  QElapsedTimer m_elapsedTimer;
+  QVector<ReplayTrack> m_tracks;
+  QString m_messageType;
+  QString m_symbolId;
+  int m_playbackMultiplier = 1;
+};
+
+} // Dsa
+
+#endif // TRACKREPLAYSIMULATOR_H
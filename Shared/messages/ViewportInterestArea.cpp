@@ -0,0 +1,252 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "ViewportInterestArea.h"
+
+// dsa app headers
+#include "GeodesicKernels.h"
+#include "WebMercator.h"
+
+// C++ API headers
+#include "GeometryEngine.h"
+#include "MapQuickView.h"
+#include "Point.h"
+#include "SceneQuickView.h"
+
+// STL headers
+#include <cmath>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+namespace {
+
+// beyond this camera pitch, in degrees, the view reaches too far toward the horizon to bound
+constexpr double s_maximumPitch = 60.0;
+
+double longitudeDifference(double longitude, double centerLongitude)
+{
+  return std::remainder(longitude - centerLongitude, 360.0);
+}
+
+} // namespace
+
+/*!
+  \class Dsa::ViewportInterestArea
+  \inmodule Dsa
+  \inherits QObject
+  \brief The area around the current view of a GeoView in which tracks are of interest.
+
+  The area is the extent of the view, estimated from the center and scale of the
+  viewpoint, widened on every side by the \l margin. It only moves when the view
+  leaves it or the scale changes by more than a factor of two, so \l areaChanged
+  is emitted a few times while panning rather than on every frame.
+
+  The area is unbounded, and contains everything, when the view covers most of
+  the globe, when a scene is tilted toward the horizon, or before the view has a
+  viewpoint.
+ */
+
+/*!
+  \brief Constructor taking the \a geoView whose view is followed and an optional \a parent.
+ */
+ViewportInterestArea::ViewportInterestArea(GeoView* geoView, QObject* parent) :
+  QObject(parent),
+  m_geoView(geoView)
+{
+  if (auto sceneView = dynamic_cast<SceneQuickView*>(m_geoView))
+    connect(sceneView, &SceneQuickView::viewpointChanged, this, &ViewportInterestArea::update);
+  else if (auto mapView = dynamic_cast<MapQuickView*>(m_geoView))
+    connect(mapView, &MapQuickView::viewpointChanged, this, &ViewportInterestArea::update);
+
+  update();
+}
+
+/*!
+  \brief Destructor.
+ */
+ViewportInterestArea::~ViewportInterestArea()
+{
+}
+
+/*!
+  \brief Returns the margin added to every side of the view, as a fraction of its size.
+
+  The default is \c 1.0, an area three times the width and height of the view.
+ */
+double ViewportInterestArea::margin() const
+{
+  return m_margin;
+}
+
+/*!
+  \brief Sets the margin added to every side of the view to \a margin, as a fraction of its size.
+ */
+void ViewportInterestArea::setMargin(double margin)
+{
+  margin = qMax(0.0, margin);
+  if (m_margin == margin)
+    return;
+
+  m_margin = margin;
+
+  // recompute the area from the view rather than keeping the old margin
+  const bool wasUnbounded = m_unbounded;
+  m_unbounded = true;
+  update();
+
+  if (m_unbounded && !wasUnbounded)
+    emit areaChanged();
+}
+
+/*!
+  \brief Returns whether the area contains everything.
+ */
+bool ViewportInterestArea::isUnbounded() const
+{
+  return m_unbounded;
+}
+
+/*!
+  \brief Returns whether the location at \a longitude and \a latitude, in WGS84
+  degrees, is within the area.
+ */
+bool ViewportInterestArea::contains(double longitude, double latitude) const
+{
+  if (m_unbounded)
+    return true;
+
+  return std::abs(latitude - m_centerLatitude) <= m_halfHeight &&
+      std::abs(longitudeDifference(longitude, m_centerLongitude)) <= m_halfWidth;
+}
+
+/*!
+  \brief Moves the area to the current view, if the view has left it.
+
+  This is called whenever the viewpoint changes.
+ */
+void ViewportInterestArea::update()
+{
+  double centerLongitude = 0.0;
+  double centerLatitude = 0.0;
+  double halfWidth = 0.0;
+  double halfHeight = 0.0;
+  double scale = 0.0;
+
+  if (!viewExtent(centerLongitude, centerLatitude, halfWidth, halfHeight, scale))
+  {
+    if (m_unbounded)
+      return;
+
+    m_unbounded = true;
+    emit areaChanged();
+    return;
+  }
+
+  if (!m_unbounded && containsView(centerLongitude, centerLatitude, halfWidth, halfHeight, scale))
+    return;
+
+  const double factor = 1.0 + 2.0 * m_margin;
+  m_unbounded = false;
+  m_centerLongitude = centerLongitude;
+  m_centerLatitude = centerLatitude;
+  m_halfWidth = halfWidth * factor;
+  m_halfHeight = halfHeight * factor;
+  m_scale = scale;
+  emit areaChanged();
+}
+
+/*!
+  \internal
+  \brief Estimates the center, the half width and half height, in WGS84 degrees, and
+  the \a scale of the view. Returns \c false if the view is not bounded.
+ */
+bool ViewportInterestArea::viewExtent(double& centerLongitude, double& centerLatitude,
+                                      double& halfWidth, double& halfHeight, double& scale) const
+{
+  if (!m_geoView)
+    return false;
+
+  const Viewpoint viewpoint = m_geoView->currentViewpoint(ViewpointType::CenterAndScale);
+  scale = viewpoint.targetScale();
+  if (viewpoint.isEmpty() || !(scale > 0.0))
+    return false;
+
+  Point center = geometry_cast<Point>(viewpoint.targetGeometry());
+  if (center.isEmpty())
+    return false;
+
+  if (center.spatialReference() != SpatialReference::wgs84())
+    center = geometry_cast<Point>(GeometryEngine::project(center, SpatialReference::wgs84()));
+
+  double width = 0.0;
+  double height = 0.0;
+  if (auto sceneView = dynamic_cast<SceneQuickView*>(m_geoView))
+  {
+    if (sceneView->currentViewpointCamera().pitch() > s_maximumPitch)
+      return false;
+
+    width = sceneView->widthInPixels();
+    height = sceneView->heightInPixels();
+  }
+  else if (auto mapView = dynamic_cast<MapQuickView*>(m_geoView))
+  {
+    width = mapView->widthInPixels();
+    height = mapView->heightInPixels();
+  }
+  else
+  {
+    return false;
+  }
+
+  centerLongitude = center.x();
+  centerLatitude = center.y();
+
+  const double cosLatitude = qMax(0.01, std::cos(centerLatitude * M_PI / 180.0));
+  halfWidth = width * 0.5 * scale * WebMercator::s_metersPerPixel / (Geodesic::s_metersPerDegree * cosLatitude);
+  halfHeight = height * 0.5 * scale * WebMercator::s_metersPerPixel / Geodesic::s_metersPerDegree;
+
+  // the area would wrap around the globe
+  const double factor = 1.0 + 2.0 * m_margin;
+  return halfWidth * factor < 180.0 && halfHeight * factor < 90.0;
+}
+
+/*!
+  \internal
+  \brief Returns whether the view, given by its center, half width, half height and
+  \a scale, is still within the area at a similar scale.
+ */
+bool ViewportInterestArea::containsView(double centerLongitude, double centerLatitude,
+                                        double halfWidth, double halfHeight, double scale) const
+{
+  if (scale < m_scale * 0.5 || scale > m_scale * 2.0)
+    return false;
+
+  return std::abs(centerLatitude - m_centerLatitude) + halfHeight <= m_halfHeight &&
+      std::abs(longitudeDifference(centerLongitude, m_centerLongitude)) + halfWidth <= m_halfWidth;
+}
+
+} // Dsa
+
+// Signal Documentation
+/*!
+  \fn void ViewportInterestArea::areaChanged();
+  \brief Signal emitted when the area moves, or becomes bounded or unbounded.
+ */
@@ -0,0 +1,74 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef VIEWPORTINTERESTAREA_H
+#define VIEWPORTINTERESTAREA_H
+
+// Qt headers
+#include <QObject>
+
+namespace Esri
+{
+  namespace ArcGISRuntime
+  {
+    class GeoView;
+  }
+}
+
+namespace Dsa {
+
+class ViewportInterestArea : public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit ViewportInterestArea(Esri::ArcGISRuntime::GeoView* geoView, QObject* parent = nullptr);
+  ~ViewportInterestArea();
+
+  double margin() const;
+  void setMargin(double margin);
+
+  bool isUnbounded() const;
+  bool contains(double longitude, double latitude) const;
+
+  void update();
+
+signals:
+  void areaChanged();
+
+private:
+  Q_DISABLE_COPY(ViewportInterestArea)
+
+  bool viewExtent(double& centerLongitude, double& centerLatitude,
+                  double& halfWidth, double& halfHeight, double& scale) const;
+  bool containsView(double centerLongitude, double centerLatitude,
+                    double halfWidth, double halfHeight, double scale) const;
+
+  Esri::ArcGISRuntime::GeoView* m_geoView = nullptr;
+  double m_margin = 1.0;
+
+  // the area around the view, in WGS84 degrees
+  bool m_unbounded = true;
+  double m_centerLongitude = 0.0;
+  double m_centerLatitude = 0.0;
+  double m_halfWidth = 0.0;
+  double m_halfHeight = 0.0;
+  double m_scale = 0.0;
+};
+
+} // Dsa
+
+#endif // VIEWPORTINTERESTAREA_H
@@ -0,0 +1,52 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef WEBMERCATOR_H
+#define WEBMERCATOR_H
+
+// STL headers
+#include <algorithm>
+#include <cmath>
+
+namespace Dsa {
+namespace WebMercator {
+
+// Helpers for the overlays which bucket tracks on a power-of-two grid of Web Mercator
+// meters, choosing the grid level from the map scale.
+
+constexpr double s_earthRadius = 6378137.0;
+constexpr double s_worldWidth = 2.0 * M_PI * s_earthRadius;
+constexpr double s_maxLatitude = 85.0511287798;
+
+// finest grid level, giving cells of roughly 2m
+constexpr int s_maxLevel = 24;
+
+// meters per screen pixel at a scale of 1, assuming 96 DPI
+constexpr double s_metersPerPixel = 0.0254 / 96.0;
+
+// projects a WGS84 location in degrees to Web Mercator meters, clamping the latitude
+// to the extent of the projection
+inline void toWebMercator(double longitude, double latitude, double& x, double& y)
+{
+  const double clampedLatitude = std::min(std::max(latitude, -s_maxLatitude), s_maxLatitude) * M_PI / 180.0;
+  x = s_earthRadius * longitude * M_PI / 180.0;
+  y = s_earthRadius * std::log(std::tan(M_PI / 4.0 + clampedLatitude / 2.0));
+}
+
+} // WebMercator
+} // Dsa
+
+#endif // WEBMERCATOR_H
@@ -19,7 +19,8 @@
 
 #include "MobileScenePackagesListModel.h"
 
-#include <iterator>
+// STL headers
+#include <algorithm>
 
 namespace Dsa {
 
@@ -30,6 +31,10 @@ namespace Dsa {
   \brief A model for storing details about mobile scene packages
   available to the app.
 
+  Packages are kept in a contiguous list of rows, ordered by name, with a
+  hash from each package name to its row. Rows are inserted and removed
+  individually so that views only update the affected delegates.
+
   The model returns data for the following roles:
   \table
     \header
@@ -86,12 +91,35 @@ MobileScenePackagesListModel::~MobileScenePackagesListModel()
 
 /*!
   \brief Add a data row for the package called \a packageName.
+
+  The row is inserted in name order. If the package is already in the model,
+  its details are reset.
  */
 void MobileScenePackagesListModel::addPackageData(const QString& packageName)
 {
-  beginResetModel();
-  m_packageDetails.insert(packageName, PackageDetails());
-  endResetModel();
+  int existingRow = -1;
+  if (findPackageDetails(packageName, existingRow))
+  {
+    m_packageDetails[existingRow] = PackageDetails();
+    m_packageDetails[existingRow].m_packageName = packageName;
+    broadcastDataChanged(existingRow);
+    return;
+  }
+
+  auto insertIt = std::lower_bound(m_packageDetails.begin(), m_packageDetails.end(), packageName,
+                                   [](const PackageDetails& details, const QString& name)
+  {
+    return details.m_packageName < name;
+  });
+  const int row = static_cast<int>(std::distance(m_packageDetails.begin(), insertIt));
+
+  PackageDetails details;
+  details.m_packageName = packageName;
+
+  beginInsertRows(QModelIndex(), row, row);
+  m_packageDetails.insert(row, details);
+  updatePackageRows(row);
+  endInsertRows();
 }
 
 /*!
@@ -99,19 +127,49 @@ void MobileScenePackagesListModel::addPackageData(const QString& packageName)
  */
 void MobileScenePackagesListModel::removePackageDetails(const QString& packageName)
 {
-  beginResetModel();
-  m_packageDetails.remove(packageName);
-  endResetModel();
+  int row = -1;
+  if (!findPackageDetails(packageName, row))
+    return;
+
+  beginRemoveRows(QModelIndex(), row, row);
+  m_packageDetails.remove(row);
+  m_packageRows.remove(packageName);
+  updatePackageRows(row);
+  endRemoveRows();
+}
+
+/*!
+  \internal
+  Returns the details for \a packageName and sets \a row to its row, or returns
+  \c nullptr if the package is not in the model.
+ */
+MobileScenePackagesListModel::PackageDetails* MobileScenePackagesListModel::findPackageDetails(const QString& packageName, int& row)
+{
+  auto findIt = m_packageRows.constFind(packageName);
+  if (findIt == m_packageRows.constEnd())
+    return nullptr;
+
+  row = findIt.value();
+  return &m_packageDetails[row];
+}
+
+/*!
+  \internal
+  Refresh the name to row lookup for every row from \a firstRow onwards.
+ */
+void MobileScenePackagesListModel::updatePackageRows(int firstRow)
+{
+  for (int row = firstRow; row < m_packageDetails.size(); ++row)
+    m_packageRows.insert(m_packageDetails.at(row).m_packageName, row);
 }
 
 /*!
   \internal
-  Emit the \l dataChanged signal for the row referenced by \a changedIterator.
+  Emit the \l dataChanged signal for \a row.
  */
-void MobileScenePackagesListModel::broadcastDataChanged(const QMap<QString, PackageDetails>::iterator& changedIterator)
+void MobileScenePackagesListModel::broadcastDataChanged(int row)
 {
-  int index = static_cast<int>(std::distance(m_packageDetails.begin(), changedIterator));
-  auto changedIndex = createIndex(index, 0);
+  auto changedIndex = createIndex(row, 0);
   emit dataChanged(changedIndex, changedIndex);
 }
 
@@ -120,12 +178,13 @@ void MobileScenePackagesListModel::broadcastDataChanged(const QMap<QString, Pack
  */
 void MobileScenePackagesListModel::setImageReady(const QString& packageName, bool imageReady)
 {
-  auto findIt = m_packageDetails.find(packageName);
-  if (findIt == m_packageDetails.end())
+  int row = -1;
+  PackageDetails* details = findPackageDetails(packageName, row);
+  if (!details)
     return;
 
-  findIt.value().m_imageReady = imageReady;
-  broadcastDataChanged(findIt);
+  details->m_imageReady = imageReady;
+  broadcastDataChanged(row);
 }
 
 /*!
@@ -133,13 +192,14 @@ void MobileScenePackagesListModel::setImageReady(const QString& packageName, boo
  */
 void MobileScenePackagesListModel::setSceneNames(const QString& packageName, const QStringList& sceneNames)
 {
-  auto findIt = m_packageDetails.find(packageName);
-  if (findIt == m_packageDetails.end())
+  int row = -1;
+  PackageDetails* details = findPackageDetails(packageName, row);
+  if (!details)
     return;
 
-  findIt.value().m_sceneNames = sceneNames;
+  details->m_sceneNames = sceneNames;
 
-  broadcastDataChanged(findIt);
+  broadcastDataChanged(row);
 }
 
 /*!
@@ -147,13 +207,14 @@ void MobileScenePackagesListModel::setSceneNames(const QString& packageName, con
  */
 void MobileScenePackagesListModel::setSceneImagesReady(const QString& packageName, bool sceneImagesReady)
 {
-  auto findIt = m_packageDetails.find(packageName);
-  if (findIt == m_packageDetails.end())
+  int row = -1;
+  PackageDetails* details = findPackageDetails(packageName, row);
+  if (!details)
     return;
 
-  findIt.value().m_sceneImagesReady = sceneImagesReady;
+  details->m_sceneImagesReady = sceneImagesReady;
 
-  broadcastDataChanged(findIt);
+  broadcastDataChanged(row);
 }
 
 /*!
@@ -161,14 +222,15 @@ void MobileScenePackagesListModel::setSceneImagesReady(const QString& packageNam
  */
 void MobileScenePackagesListModel::setTitleAndDescription(const QString& packageName, const QString& title, const QString& description)
 {
-  auto findIt = m_packageDetails.find(packageName);
-  if (findIt == m_packageDetails.end())
+  int row = -1;
+  PackageDetails* details = findPackageDetails(packageName, row);
+  if (!details)
     return;
 
-  findIt.value().m_title = title;
-  findIt.value().m_description = description;
+  details->m_title = title;
+  details->m_description = description;
 
-  broadcastDataChanged(findIt);
+  broadcastDataChanged(row);
 }
 
 /*!
@@ -194,23 +256,22 @@ QVariant MobileScenePackagesListModel::data(const QModelIndex& index, int role)
   if (index.row() < 0 || index.row() >= rowCount(index))
     return QVariant();
 
-  auto it = m_packageDetails.constBegin();
-  it.operator +=(index.row());
+  const PackageDetails& details = m_packageDetails.at(index.row());
 
   switch (role)
   {
   case PackageNameRole:
-    return it.key();
+    return details.m_packageName;
   case ImageReadyRole:
-    return it.value().m_imageReady;
+    return details.m_imageReady;
   case SceneNamesRole:
-    return it.value().m_sceneNames;
+    return details.m_sceneNames;
   case SceneImagesReadyRole:
-    return it.value().m_sceneImagesReady;
+    return details.m_sceneImagesReady;
   case PackageTitleRole:
-    return it.value().m_title;
+    return details.m_title;
   case PackageDescriptionRole:
-    return it.value().m_description;
+    return details.m_description;
   default:
     break;
   }
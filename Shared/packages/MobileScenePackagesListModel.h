@@ -20,8 +20,8 @@
 // Qt headers
 #include <QAbstractListModel>
 #include <QHash>
-#include <QMap>
 #include <QStringList>
+#include <QVector>
 
 namespace Dsa {
 
@@ -63,6 +63,7 @@ private:
 
   struct PackageDetails
   {
+    QString m_packageName;
     bool m_imageReady = false;
     QStringList m_sceneNames;
     bool m_sceneImagesReady = false;
@@ -70,10 +71,13 @@ private:
     QString m_description;
   };
 
-  void broadcastDataChanged(const QMap<QString, PackageDetails>::iterator& changedIterator);
+  PackageDetails* findPackageDetails(const QString& packageName, int& row);
+  void updatePackageRows(int firstRow);
+  void broadcastDataChanged(int row);
 
   QHash<int, QByteArray> m_roles;
-  QMap<QString, PackageDetails> m_packageDetails;
+  QVector<PackageDetails> m_packageDetails;
+  QHash<QString, int> m_packageRows;
 };
 
 } // Dsa
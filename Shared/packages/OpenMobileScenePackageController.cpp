@@ -20,6 +20,7 @@
 
 #include "MobileScenePackagesListModel.h"
 #include "OpenMobileScenePackageController.h"
+#include "ThumbnailCache.h"
 
 // toolkit headers
 #include "ToolManager.h"
@@ -45,6 +46,8 @@ namespace Dsa {
 const QString OpenMobileScenePackageController::PACKAGE_DIRECTORY_PROPERTYNAME = "PackageDirectory";
 const QString OpenMobileScenePackageController::CURRENT_PACKAGE_PROPERTYNAME = "CurrentPackage";
 const QString OpenMobileScenePackageController::SCENE_INDEX_PROPERTYNAME = "SceneIndex";
+const QString OpenMobileScenePackageController::RECENT_PACKAGES_PROPERTYNAME = "RecentPackages";
+const QString OpenMobileScenePackageController::PRELOAD_PACKAGES_PROPERTYNAME = "PreloadPackages";
 const QString OpenMobileScenePackageController::MSPK_EXTENSION = ".mspk";
 const QString OpenMobileScenePackageController::MMPK_EXTENSION = ".mmpk";
 
@@ -54,6 +57,22 @@ const QString OpenMobileScenePackageController::MMPK_EXTENSION = ".mmpk";
   \inherits AbstractTool
   \brief Tool controller for opening mobile scene packages.
 
+  The thumbnails of each package and its scenes are stored in the
+  \l ThumbnailCache, so that they are shown straight away on later runs
+  rather than being fetched from the package again.
+
+  When the package directory is listed, a row is added to the model for each
+  package straight away. The packages are then loaded in the background, a
+  few at a time, to fill in their titles, scene names and thumbnails. The
+  current package skips this queue so that its scene is opened without waiting
+  for the others.
+
+  The most recently used packages are kept loaded, so that switching between
+  their scenes does not wait for the package to be opened again. Other packages
+  are released once their details have been read. When \c PreloadPackages is
+  set, the recently used packages are loaded ahead of the rest of the queue at
+  startup.
+
   \sa Esri::ArcGISRuntime::MobileScenePackage
  */
 
@@ -91,10 +110,21 @@ QString OpenMobileScenePackageController::toolName() const
  *  \li PackageDirectory. The directory containing package data.
  *  \li CurrentPackage. The name of the current package.
  *  \li SceneIndex. The index of the scene in the current package.
+ *  \li RecentPackages. The names of the most recently used packages.
+ *  \li PreloadPackages. Whether the recently used packages are loaded in the
+ *      background at startup. The default is \c true.
  * \endlist
  */
 void OpenMobileScenePackageController::setProperties(const QVariantMap& properties)
 {
+  if (properties.contains(PRELOAD_PACKAGES_PROPERTYNAME))
+    m_preloadPackages = properties.value(PRELOAD_PACKAGES_PROPERTYNAME).toBool();
+
+  // the recent packages must be known before the package directory is listed
+  const QStringList recentPackageNames = properties.value(RECENT_PACKAGES_PROPERTYNAME).toStringList();
+  if (m_recentPackageNames.isEmpty() && !recentPackageNames.isEmpty())
+    m_recentPackageNames = recentPackageNames.mid(0, s_maxRecentPackages);
+
   const QString newPackageDirectoryPath = properties.value(PACKAGE_DIRECTORY_PROPERTYNAME).toString();
   const bool dataPathChanged = setPackageDataPath(newPackageDirectoryPath);
 
@@ -258,6 +288,8 @@ bool OpenMobileScenePackageController::setCurrentPackageName(const QString& pack
   emit currentSceneNameChanged();
   emit propertyChanged(CURRENT_PACKAGE_PROPERTYNAME, m_currentPackageName);
 
+  touchRecentPackage(packageName);
+
   return true;
 }
 
@@ -291,6 +323,9 @@ void OpenMobileScenePackageController::loadCurrentScene(MobileScenePackage* pack
  */
 void OpenMobileScenePackageController::loadMobileScenePackage(const QString& packageName)
 {
+  // the package no longer needs to wait for a background metadata load
+  m_pendingMetadataLoads.removeAll(packageName);
+
   MobileScenePackage* package = getPackage(packageName);
   if (!package)
     return;
@@ -300,6 +335,8 @@ void OpenMobileScenePackageController::loadMobileScenePackage(const QString& pac
 
   connect(package, &MobileScenePackage::doneLoading, this, [this, package, packageName](Error e)
   {
+    finishMetadataLoad(packageName);
+
     if (!e.isEmpty())
     {
       qDebug() << packageName << e.message() << e.additionalMessage();
@@ -332,30 +369,52 @@ void OpenMobileScenePackageController::loadMobileScenePackage(const QString& pac
       if (!item->thumbnail().isNull())
         continue;
 
-      connect(item, &Item::fetchThumbnailCompleted, this, [this, packageName, item](bool success)
+      const QString imageId = packageName + "_" + item->title();
+      if (useCachedImage(packageName, imageId))
+      {
+        m_packagesModel->setSceneImagesReady(packageName, true);
+        continue;
+      }
+
+      connect(item, &Item::fetchThumbnailCompleted, this, [this, packageName, imageId, item](bool success)
       {
         if (success)
-          emit imageReady(packageName + "_" + item->title(), item->thumbnail());
+        {
+          emit imageReady(imageId, item->thumbnail());
+          ThumbnailCache::instance()->storeThumbnail(pathInPackagesDirectory(packageName), imageId, item->thumbnail());
+        }
 
         m_packagesModel->setSceneImagesReady(packageName, success);
+        finishThumbnailFetch(packageName);
       });
 
+      ++m_pendingThumbnailFetches[packageName];
       item->fetchThumbnail();
     }
 
     m_packagesModel->setSceneNames(packageName, sceneNames);
 
-    connect(packageItem, &Item::fetchThumbnailCompleted, this, [this, packageName, packageItem](bool success)
+    // the package thumbnail may already have been found when the package was listed
+    if (!useCachedImage(packageName, packageName))
     {
-      if (success)
-        emit imageReady(packageName, packageItem->thumbnail());
+      connect(packageItem, &Item::fetchThumbnailCompleted, this, [this, packageName, packageItem](bool success)
+      {
+        if (success)
+        {
+          emit imageReady(packageName, packageItem->thumbnail());
+          ThumbnailCache::instance()->storeThumbnail(pathInPackagesDirectory(packageName), packageName, packageItem->thumbnail());
+        }
 
-      m_packagesModel->setImageReady(packageName, success);
-    });
+        m_packagesModel->setImageReady(packageName, success);
+        finishThumbnailFetch(packageName);
+      });
 
-    package->item()->fetchThumbnail();
+      ++m_pendingThumbnailFetches[packageName];
+      package->item()->fetchThumbnail();
+    }
 
     loadCurrentScene(package);
+    releaseIdlePackage(packageName);
   });
 
   if (package->loadStatus() == LoadStatus::Loaded)
@@ -364,6 +423,139 @@ void OpenMobileScenePackageController::loadMobileScenePackage(const QString& pac
     package->load();
 }
 
+/*!
+  \internal
+  Adds \a packageName to the queue of packages to load in the background.
+ */
+void OpenMobileScenePackageController::queueMetadataLoad(const QString& packageName)
+{
+  if (m_loadingMetadata.contains(packageName) || m_pendingMetadataLoads.contains(packageName))
+    return;
+
+  m_pendingMetadataLoads.append(packageName);
+}
+
+/*!
+  \internal
+  Starts loading queued packages, keeping at most \c s_maxMetadataLoads loads
+  in progress.
+ */
+void OpenMobileScenePackageController::startMetadataLoads()
+{
+  while (m_loadingMetadata.size() < s_maxMetadataLoads && !m_pendingMetadataLoads.isEmpty())
+  {
+    const QString packageName = m_pendingMetadataLoads.takeFirst();
+    m_loadingMetadata.insert(packageName);
+    loadMobileScenePackage(packageName);
+  }
+}
+
+/*!
+  \internal
+  Records that the background load of \a packageName has finished and starts
+  the next queued load.
+ */
+void OpenMobileScenePackageController::finishMetadataLoad(const QString& packageName)
+{
+  if (!m_loadingMetadata.remove(packageName))
+    return;
+
+  // start the next load once the current doneLoading handlers have run
+  QMetaObject::invokeMethod(this, [this]()
+  {
+    startMetadataLoads();
+  }, Qt::QueuedConnection);
+}
+
+/*!
+  \internal
+  Moves the recently used packages to the front of the queue of packages to
+  load, if \l preloadPackages is set.
+ */
+void OpenMobileScenePackageController::prioritizeRecentPackages()
+{
+  if (!m_preloadPackages)
+    return;
+
+  // insert in reverse so that the most recent package is loaded first
+  for (auto it = m_recentPackageNames.crbegin(); it != m_recentPackageNames.crend(); ++it)
+  {
+    if (m_pendingMetadataLoads.removeAll(*it) > 0)
+      m_pendingMetadataLoads.prepend(*it);
+  }
+}
+
+/*!
+  \internal
+  Marks \a packageName as the most recently used package.
+
+  The package is kept loaded while it is one of the \c s_maxRecentPackages most
+  recently used packages. A package which drops out of that list is released.
+ */
+void OpenMobileScenePackageController::touchRecentPackage(const QString& packageName)
+{
+  if (!m_recentPackageNames.isEmpty() && m_recentPackageNames.constFirst() == packageName)
+    return;
+
+  m_recentPackageNames.removeAll(packageName);
+  m_recentPackageNames.prepend(packageName);
+
+  QStringList evictedPackageNames;
+  while (m_recentPackageNames.size() > s_maxRecentPackages)
+    evictedPackageNames.append(m_recentPackageNames.takeLast());
+
+  emit propertyChanged(RECENT_PACKAGES_PROPERTYNAME, m_recentPackageNames);
+
+  for (const QString& evictedPackageName : evictedPackageNames)
+    releaseIdlePackage(evictedPackageName);
+}
+
+/*!
+  \internal
+  Deletes the loaded mobile scene package called \a packageName, unless it is
+  the current package, one of the recently used packages, or is still being
+  read.
+
+  The package will be opened again if it is needed later.
+ */
+void OpenMobileScenePackageController::releaseIdlePackage(const QString& packageName)
+{
+  if (packageName == m_currentPackageName || m_recentPackageNames.contains(packageName))
+    return;
+
+  if (m_loadingMetadata.contains(packageName) || m_pendingThumbnailFetches.value(packageName) > 0)
+    return;
+
+  auto findIt = m_packages.find(packageName);
+  if (findIt == m_packages.end() || !findIt.value() || findIt.value() == m_mspk)
+    return;
+
+  findIt.value()->deleteLater();
+  findIt.value() = nullptr;
+}
+
+/*!
+  \internal
+  Records that a thumbnail fetch for \a packageName has completed.
+ */
+void OpenMobileScenePackageController::finishThumbnailFetch(const QString& packageName)
+{
+  auto findIt = m_pendingThumbnailFetches.find(packageName);
+  if (findIt == m_pendingThumbnailFetches.end())
+    return;
+
+  if (--findIt.value() > 0)
+    return;
+
+  m_pendingThumbnailFetches.erase(findIt);
+
+  // release the package once the completion handlers have returned
+  QMetaObject::invokeMethod(this, [this, packageName]()
+  {
+    releaseIdlePackage(packageName);
+  }, Qt::QueuedConnection);
+}
+
 /*!
   \internal
   Creates place-holder details for the given \a packageName.
@@ -376,6 +568,27 @@ bool OpenMobileScenePackageController::createPackageDetails(const QString& packa
   m_packages.insert(packageName, nullptr);
   m_packagesModel->addPackageData(packageName);
 
+  // show the thumbnail from an earlier run while the package loads
+  if (useCachedImage(packageName, packageName))
+    m_packagesModel->setImageReady(packageName, true);
+
+  return true;
+}
+
+/*!
+  \internal
+  Returns whether there is a cached thumbnail with the id \a imageId for the
+  current version of the package called \a packageName.
+
+  If so, \l imageCached is emitted so that the image can be served from the cache.
+ */
+bool OpenMobileScenePackageController::useCachedImage(const QString& packageName, const QString& imageId)
+{
+  const QString imagePath = ThumbnailCache::instance()->cachedThumbnailPath(pathInPackagesDirectory(packageName), imageId);
+  if (imagePath.isEmpty())
+    return false;
+
+  emit imageCached(imageId, imagePath);
   return true;
 }
 
@@ -460,8 +673,8 @@ bool OpenMobileScenePackageController::setCurrentSceneIndex(int packageIndex)
   \internal
   Updates the details for the packages in the \l packageDataPath.
 
-  Packages will be tested to see if they can be read directly, and if so,
-  loaded to obtaiin meta-data and images.
+  A row is added for each package straight away. The packages are then
+  queued to be loaded in the background to obtain meta-data and images.
  */
 void OpenMobileScenePackageController::updatePackageDetails()
 {
@@ -481,7 +694,7 @@ void OpenMobileScenePackageController::updatePackageDetails()
     if (!createPackageDetails(packageName))
       continue;
 
-    loadMobileScenePackage(packageName);
+    queueMetadataLoad(packageName);
   }
 
   for (const auto& packageName : dirPackageNames)
@@ -490,9 +703,16 @@ void OpenMobileScenePackageController::updatePackageDetails()
     if (!createPackageDetails(packageName))
       continue;
 
-    loadMobileScenePackage(packageName);
+    queueMetadataLoad(packageName);
   }
 
+  prioritizeRecentPackages();
+
+  // defer the loads so that the list is shown before any package is opened
+  QMetaObject::invokeMethod(this, [this]()
+  {
+    startMetadataLoads();
+  }, Qt::QueuedConnection);
 }
 
 /*!
@@ -504,6 +724,23 @@ bool OpenMobileScenePackageController::hasActiveScene() const
   return m_mspk && m_currentSceneIndex >= 0;
 }
 
+/*!
+  \brief Returns the names of the most recently used packages, most recent first.
+ */
+QStringList OpenMobileScenePackageController::recentPackageNames() const
+{
+  return m_recentPackageNames;
+}
+
+/*!
+  \brief Returns whether the recently used packages are loaded in the
+  background at startup.
+ */
+bool OpenMobileScenePackageController::preloadPackages() const
+{
+  return m_preloadPackages;
+}
+
 } // Dsa
 
 // Signal Documentation
@@ -540,6 +777,12 @@ bool OpenMobileScenePackageController::hasActiveScene() const
   \brief Signal emitted when the \a packageImage for the package \a packageName is ready.
  */
 
+/*!
+  \fn void OpenMobileScenePackageController::imageCached(const QString& imageId, const QString& imagePath);
+
+  \brief Signal emitted when the image \a imageId can be read from the thumbnail cache at \a imagePath.
+ */
+
 /*!
   \fn void OpenMobileScenePackageController::packagesChanged();
 
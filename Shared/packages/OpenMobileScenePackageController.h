@@ -24,6 +24,7 @@
 #include <QAbstractListModel>
 #include <QHash>
 #include <QObject>
+#include <QSet>
 #include <QStringList>
 #include <QUuid>
 
@@ -52,6 +53,8 @@ public:
   static const QString PACKAGE_DIRECTORY_PROPERTYNAME;
   static const QString CURRENT_PACKAGE_PROPERTYNAME;
   static const QString SCENE_INDEX_PROPERTYNAME;
+  static const QString RECENT_PACKAGES_PROPERTYNAME;
+  static const QString PRELOAD_PACKAGES_PROPERTYNAME;
 
   explicit OpenMobileScenePackageController(QObject* parent = nullptr);
   ~OpenMobileScenePackageController() override;
@@ -77,12 +80,16 @@ public:
 
   bool hasActiveScene() const;
 
+  QStringList recentPackageNames() const;
+  bool preloadPackages() const;
+
 signals:
   void toolErrorOccurred(const QString& errorMessage, const QString& additionalMessage);
   void packageDataPathChanged();
   void currentSceneNameChanged();
   void packageIndexChanged();
   void imageReady(const QString& packageName, const QImage& packageImage);
+  void imageCached(const QString& imageId, const QString& imagePath);
   void packagesChanged();
 
 private:
@@ -92,6 +99,13 @@ private:
   void updatePackageDetails();
 
   void loadMobileScenePackage(const QString& packageName);
+  void queueMetadataLoad(const QString& packageName);
+  void startMetadataLoads();
+  void finishMetadataLoad(const QString& packageName);
+  void prioritizeRecentPackages();
+  void touchRecentPackage(const QString& packageName);
+  void releaseIdlePackage(const QString& packageName);
+  void finishThumbnailFetch(const QString& packageName);
   bool createPackageDetails(const QString& packageName);
 
   QString combinedPackagePath() const;
@@ -100,9 +114,12 @@ private:
 
   Esri::ArcGISRuntime::MobileScenePackage* getPackage(const QString& packageName);
   void loadCurrentScene(Esri::ArcGISRuntime::MobileScenePackage* package);
+  bool useCachedImage(const QString& packageName, const QString& imageId);
 
   static const QString MSPK_EXTENSION;
   static const QString MMPK_EXTENSION;
+  static constexpr int s_maxMetadataLoads = 2;
+  static constexpr int s_maxRecentPackages = 3;
 
   QString m_packageDataPath;
   QString m_currentPackageName;
@@ -111,6 +128,11 @@ private:
   Esri::ArcGISRuntime::MobileScenePackage* m_mspk = nullptr;
   QHash<QUuid, QString> m_directReadTasks;
   QHash<QString, Esri::ArcGISRuntime::MobileScenePackage*> m_packages;
+  QStringList m_pendingMetadataLoads;
+  QSet<QString> m_loadingMetadata;
+  QHash<QString, int> m_pendingThumbnailFetches;
+  QStringList m_recentPackageNames;
+  bool m_preloadPackages = true;
   bool m_userSelected = false;
 };
 
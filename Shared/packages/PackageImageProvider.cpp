@@ -32,6 +32,9 @@ namespace Dsa {
   \inherits QQuickImageProvider
   \brief Image provider for the thumbnails contained in mobile scene packages.
 
+  Images are requested on QML's image loading thread. Thumbnails stored by the
+  \l ThumbnailCache are read from disk there, so they do not block the UI.
+
   \sa Dsa::OpenMobileScenePackageController
  */
 
@@ -39,7 +42,7 @@ namespace Dsa {
   \brief Constructor taking an optional \a parent.
  */
 PackageImageProvider::PackageImageProvider(QObject* parent /*= nullptr*/) :
-  QQuickImageProvider(QQuickImageProvider::Image),
+  QQuickImageProvider(QQuickImageProvider::Image, QQmlImageProviderBase::ForceAsynchronousImageLoading),
   QObject(parent),
   m_defaultImage(":/Resources/AppIcon.png")
 {
@@ -58,9 +61,17 @@ PackageImageProvider::PackageImageProvider(QObject* parent /*= nullptr*/) :
     // store images created by the tool
     connect(m_packageController, &OpenMobileScenePackageController::imageReady, this, [this](const QString& packageName, const QImage& packageImage)
     {
+      QMutexLocker locker(&m_mutex);
       m_packages.insert(packageName, packageImage.copy());
     });
 
+    // images from an earlier run are read from the thumbnail cache when first requested
+    connect(m_packageController, &OpenMobileScenePackageController::imageCached, this, [this](const QString& imageId, const QString& imagePath)
+    {
+      QMutexLocker locker(&m_mutex);
+      m_cachedImagePaths.insert(imageId, imagePath);
+    });
+
   disconnect(m_findToolConnection);
 });
 }
@@ -68,13 +79,39 @@ PackageImageProvider::PackageImageProvider(QObject* parent /*= nullptr*/) :
 /*!
   \brief Return the image with the specified \a id.
 
-  If none is foound, return a default image.
+  If none is foound, return a default image. The image is scaled to fit
+  \a requestedSize if both of its dimensions are set, and \a size is set to the original size.
  */
-QImage PackageImageProvider::requestImage(const QString &id, QSize* /*size*/, const QSize& /*requestedSize*/)
+QImage PackageImageProvider::requestImage(const QString &id, QSize* size, const QSize& requestedSize)
 {
-  auto findIt = m_packages.constFind(id);
-  auto image = findIt == m_packages.constEnd() ? m_defaultImage : findIt.value();
-  return image.isNull() ? m_defaultImage : image;
+  QImage image;
+  QString imagePath;
+  {
+    QMutexLocker locker(&m_mutex);
+    image = m_packages.value(id);
+    if (image.isNull())
+      imagePath = m_cachedImagePaths.value(id);
+  }
+
+  if (image.isNull() && !imagePath.isEmpty())
+  {
+    image = QImage(imagePath);
+
+    QMutexLocker locker(&m_mutex);
+    if (!image.isNull() && !m_packages.contains(id))
+      m_packages.insert(id, image);
+  }
+
+  if (image.isNull())
+    image = m_defaultImage;
+
+  if (size)
+    *size = image.size();
+
+  if (requestedSize.width() > 0 && requestedSize.height() > 0 && !image.isNull())
+    return image.scaled(requestedSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+
+  return image;
 }
 
 } // Dsa
@@ -18,6 +18,7 @@
 #define PACKAGEIMAGEPROVIDER_H
 
 // Qt headers
+#include <QMutex>
 #include <QObject>
 #include <QQuickImageProvider>
 
@@ -34,7 +35,9 @@ public:
   QImage requestImage(const QString& id, QSize* size, const QSize& requestedSize) override;
 
   private:
+    mutable QMutex m_mutex;
     QHash<QString, QImage> m_packages;
+    QHash<QString, QString> m_cachedImagePaths;
     OpenMobileScenePackageController* m_packageController = nullptr;
 
     QMetaObject::Connection m_findToolConnection;
@@ -29,8 +29,15 @@
 #include "ToolResourceProvider.h"
 
 // C++ API headers
+#include "Envelope.h"
+#include "FeatureLayer.h"
 #include "GeoElement.h"
+#include "GeoView.h"
+#include "Geometry.h"
+#include "GeometryEngine.h"
 #include "GeometryTypes.h"
+#include "Graphic.h"
+#include "GraphicsOverlay.h"
 #include "Point.h"
 #include "Scene.h"
 #include "SceneView.h"
@@ -38,10 +45,32 @@
 
 // Qt headers
 #include <QAbstractListModel>
+#include <QByteArray>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
 #include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QList>
 #include <QObject>
 #include <QPointer>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+#include <QUuid>
 #include <QVariantMap>
+#include <QVector>
+
+// STL headers
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <memory>
 
 #endif // DSA_PCH_HPP
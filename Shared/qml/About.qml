@@ -24,6 +24,7 @@ import Esri.ArcGISRuntime.OpenSourceApps.DSA 1.1
 Item {
     id: aboutRoot
     property real scaleFactor: (Screen.logicalPixelDensity * 25.4) / (Qt.platform.os === "windows" || Qt.platform.os === "linux" ? 96 : 72)
+    signal closed()
 
     MouseArea {
         anchors.fill: parent
@@ -125,7 +126,7 @@ Item {
                 pixelSize: 12 * scaleFactor
                 family: DsaStyles.fontFamily
             }
-            onClicked: aboutRoot.visible = false;
+            onClicked: aboutRoot.closed();
         }
     }
 
@@ -62,6 +62,15 @@ DsaPanel {
             text: fileName
             width: localDataList.width
 
+            // rows are kept when the list is filtered, so their checks are cleared with the selection
+            Connections {
+                target: localDataRoot
+                function onSelectedItemsChanged() {
+                    if (selectedItems.length === 0)
+                        control.checked = false;
+                }
+            }
+
             contentItem: Label {
                 rightPadding: control.indicator.width + control.spacing
                 text: control.text
@@ -96,12 +105,38 @@ DsaPanel {
         }
         spacing: 1 * scaleFactor
 
+        // progress of the background preparation of added shapefiles and rasters
+        Label {
+            visible: toolController.preprocessing
+            text: "Preparing data..."
+            font.pixelSize: 12 * scaleFactor
+            color: Material.foreground
+        }
+
+        ProgressBar {
+            visible: toolController.preprocessing
+            width: parent.width
+            value: toolController.preprocessingProgress
+        }
+
         Label {
             text: "Filter:"
             font.pixelSize: 12 * scaleFactor
             color: Material.foreground
         }
 
+        TextField {
+            id: nameFilter
+            width: parent.width
+            placeholderText: "Name contains"
+            color: Material.foreground
+            font.pixelSize: 12 * scaleFactor
+            onTextChanged: {
+                selectedItems = [];
+                toolController.setNameFilter(text);
+            }
+        }
+
         ComboBox {
             id: filter
             model: toolController.fileFilterList
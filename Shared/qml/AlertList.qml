@@ -191,6 +191,23 @@ DsaPanel {
                 toolController.clearAllFilters();
             }
         }
+
+        Button {
+            id: dismissAllButton
+
+            visible: alertsView.count > 0
+            anchors.verticalCenter: parent.verticalCenter
+            text: "Dismiss all"
+            font {
+                pixelSize: 12 * scaleFactor
+                family: DsaStyles.fontFamily
+            }
+
+            onClicked: {
+                hightlightIndex = -1;
+                toolController.dismissAll();
+            }
+        }
     }
 
     Row {
@@ -357,23 +374,9 @@ DsaPanel {
         }
     }
 
-    Timer {
-        id: flashTimer
-        interval: 500
-
-        property bool highlightOn: true
-        running: alertsView.count > 0
-        repeat: true
-        onTriggered: {
-            toolController.flashAll(highlightOn);
-            highlightOn = !highlightOn;
-        }
-
-        onRunningChanged: {
-            if (!running) {
-                highlightOn = false;
-                toolController.flashAll(highlightOn);
-            }
-        }
+    Binding {
+        target: toolController
+        property: "flashing"
+        value: alertsView.count > 0
     }
 }
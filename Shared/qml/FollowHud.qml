@@ -30,6 +30,7 @@ Item {
 
     FollowPositionController {
         id: followPositionController
+        predictive: true
         onFollowModeChanged: {
             if (followPositionController.followMode === FollowPositionController.Disabled)
                 followHud.state = disableLocation.name;
@@ -0,0 +1,90 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+import QtQuick 2.9
+import QtQuick.Controls 2.2
+import QtQuick.Controls.Material 2.2
+import QtQuick.Window 2.2
+import Esri.ArcGISRuntime.Toolkit 100.10 as Toolkit
+import Esri.ArcGISRuntime.OpenSourceApps.DSA 1.1
+
+// Displays the popups of an IdentifyController one at a time. The controller
+// only creates the PopupManager for a popup when it is paged to.
+Pane {
+    id: identifyResultsRoot
+    property real scaleFactor: (Screen.logicalPixelDensity * 25.4) / (Qt.platform.os === "windows" || Qt.platform.os === "linux" ? 96 : 72)
+    property var identifyController: null
+
+    readonly property int popupCount: identifyController ? identifyController.popupCount : 0
+    readonly property int currentPopupIndex: identifyController ? identifyController.currentPopupIndex : 0
+
+    padding: 0
+
+    function dismiss() {
+        visible = false;
+    }
+
+    Toolkit.PopupView {
+        id: popupView
+        anchors {
+            top: parent.top
+            left: parent.left
+            right: parent.right
+            bottom: pager.visible ? pager.top : parent.bottom
+        }
+        palette {
+            text: Material.foreground
+        }
+        background: Rectangle {
+            color: Material.primary
+        }
+        popupManager: identifyController ? identifyController.currentPopupManager : null
+        closeCallback: function() {
+            identifyResultsRoot.dismiss();
+        }
+    }
+
+    Row {
+        id: pager
+        anchors {
+            horizontalCenter: parent.horizontalCenter
+            bottom: parent.bottom
+            margins: 4 * scaleFactor
+        }
+        spacing: 8 * scaleFactor
+        visible: popupCount > 1
+
+        Button {
+            text: "<"
+            width: 40 * scaleFactor
+            enabled: currentPopupIndex > 0
+            onClicked: identifyController.currentPopupIndex = currentPopupIndex - 1;
+        }
+
+        Label {
+            anchors.verticalCenter: parent.verticalCenter
+            text: (currentPopupIndex + 1) + qsTr(" of ") + popupCount
+            color: Material.foreground
+        }
+
+        Button {
+            text: ">"
+            width: 40 * scaleFactor
+            enabled: currentPopupIndex < popupCount - 1
+            onClicked: identifyController.currentPopupIndex = currentPopupIndex + 1;
+        }
+    }
+}
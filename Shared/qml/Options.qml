@@ -233,6 +233,126 @@ Rectangle {
                     }
                 }
             }
+
+            Label {
+                text: "Diagnostics"
+                font {
+                    family: DsaStyles.fontFamily
+                    underline: true
+                    pixelSize: DsaStyles.titleFontPixelSize * 0.75
+                }
+                color: Material.foreground
+            }
+
+            // Show frame time, ingest and alert rates and memory over the map
+            CheckBox {
+                text: "Show performance HUD"
+                checked: optionsController.showPerformanceHud
+                onCheckedChanged: optionsController.showPerformanceHud = checked
+            }
+
+            // Apply a coordinated set of location, broadcast, feed and rendering settings
+            Row {
+                width: parent.width
+                spacing: 10 * scaleFactor
+
+                Label {
+                    anchors.verticalCenter: parent.verticalCenter
+                    text: "Performance profile"
+                    font {
+                        pixelSize: 12 * scaleFactor
+                        family: DsaStyles.fontFamily
+                    }
+                    color: Material.foreground
+                }
+
+                ComboBox {
+                    anchors.verticalCenter: parent.verticalCenter
+                    model: optionsController.performanceProfiles
+                    currentIndex: optionsController.performanceProfiles.indexOf(optionsController.performanceProfile)
+                    onActivated: optionsController.performanceProfile = currentText
+                }
+            }
+
+            // Cap the frame rate of highlights and flashing alerts while the map is idle, to save power
+            Row {
+                width: parent.width
+                spacing: 10 * scaleFactor
+
+                Label {
+                    anchors.verticalCenter: parent.verticalCenter
+                    text: "Idle frame rate (0 for no cap)"
+                    font {
+                        pixelSize: 12 * scaleFactor
+                        family: DsaStyles.fontFamily
+                    }
+                    color: Material.foreground
+                }
+
+                SpinBox {
+                    anchors.verticalCenter: parent.verticalCenter
+                    width: 128 * scaleFactor
+                    editable: true
+                    from: 0
+                    to: 60
+                    value: optionsController.idleFrameRate
+                    onValueModified: optionsController.idleFrameRate = value
+                }
+            }
+
+            // Limit how far out 3D content is drawn, so that it does not crowd out everything else
+            Row {
+                width: parent.width
+                spacing: 10 * scaleFactor
+
+                Label {
+                    anchors.verticalCenter: parent.verticalCenter
+                    text: "Scene layer quality"
+                    font {
+                        pixelSize: 12 * scaleFactor
+                        family: DsaStyles.fontFamily
+                    }
+                    color: Material.foreground
+                }
+
+                ComboBox {
+                    anchors.verticalCenter: parent.verticalCenter
+                    model: optionsController.sceneLayerQualities
+                    currentIndex: optionsController.sceneLayerQualities.indexOf(optionsController.sceneLayerQuality)
+                    onActivated: optionsController.sceneLayerQuality = currentText
+                }
+            }
+
+            // Record where the app spends its time, to be sent for analysis
+            CheckBox {
+                text: "Record performance trace"
+                checked: optionsController.performanceTracing
+                onCheckedChanged: optionsController.performanceTracing = checked
+            }
+
+            Row {
+                height: 40 * scaleFactor
+                spacing: 5 * scaleFactor
+
+                Button {
+                    id: saveTraceButton
+                    text: "Save trace"
+                    enabled: optionsController.performanceTracing
+                    onClicked: traceLabel.text = optionsController.writePerformanceTrace()
+                }
+
+                Text {
+                    id: traceLabel
+                    anchors.verticalCenter: saveTraceButton.verticalCenter
+                    width: optionsColumn.width - saveTraceButton.width - 5 * scaleFactor
+                    elide: Text.ElideMiddle
+                    color: Material.foreground
+                    font {
+                        pixelSize: 10 * scaleFactor
+                        family: DsaStyles.fontFamily
+                    }
+                }
+            }
         }
     }
 
@@ -0,0 +1,59 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+import QtQuick 2.9
+import Esri.ArcGISRuntime.OpenSourceApps.DSA 1.1
+
+// Creates its panel the first time the loader is shown, so the panel and the
+// controller it declares are not built at startup. Showing and hiding the
+// loader shows and hides the panel. While hidden the panel can be released
+// again with unload(), which happens automatically when memory is short.
+Loader {
+    id: panelLoader
+
+    // whether the panel is released when memory is short
+    property bool unloadOnLowMemory: true
+
+    active: false
+    visible: false
+
+    onVisibleChanged: {
+        if (visible)
+            active = true;
+    }
+
+    onLoaded: {
+        // replay the show that created the panel, so its own visibility
+        // handlers run on first open just as they do on every later one
+        item.visible = false;
+        item.visible = true;
+    }
+
+    // Releases the panel, and the models of its controller, if it is hidden.
+    function unload() {
+        if (!visible)
+            active = false;
+    }
+
+    Connections {
+        target: MemoryBudget
+        enabled: panelLoader.unloadOnLowMemory
+
+        function onLowMemory() {
+            panelLoader.unload();
+        }
+    }
+}
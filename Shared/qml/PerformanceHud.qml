@@ -0,0 +1,93 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+import QtQuick 2.9
+import QtQuick.Controls 2.2
+import QtQuick.Controls.Material 2.2
+import QtQuick.Window 2.2
+import Esri.ArcGISRuntime.OpenSourceApps.DSA 1.1
+
+// Shows the statistics sampled by the PerformanceMonitor while it is enabled.
+Rectangle {
+    id: performanceHudRoot
+    property real scaleFactor: (Screen.logicalPixelDensity * 25.4) / (Qt.platform.os === "windows" || Qt.platform.os === "linux" ? 96 : 72)
+
+    visible: PerformanceMonitor.enabled
+    width: statsColumn.width + 12 * scaleFactor
+    height: statsColumn.height + 12 * scaleFactor
+    radius: 4 * scaleFactor
+    color: "#99000000"
+
+    Column {
+        id: statsColumn
+        anchors.centerIn: parent
+        spacing: 2 * scaleFactor
+
+        Repeater {
+            model: [
+                "%1 fps, %2 ms/frame (max %3 ms)".arg(PerformanceMonitor.framesPerSecond.toFixed(0))
+                                                  .arg(PerformanceMonitor.frameTime.toFixed(1))
+                                                  .arg(PerformanceMonitor.maximumFrameTime.toFixed(1)),
+                "%1 messages/s".arg(PerformanceMonitor.messagesPerSecond.toFixed(0)),
+                "%1 alert evaluations/s".arg(PerformanceMonitor.alertEvaluationsPerSecond.toFixed(0)),
+                "%1 quadtree rebuilds/s".arg(PerformanceMonitor.quadtreeRebuildsPerSecond.toFixed(1)),
+                PerformanceMonitor.memoryUsage < 0 ? "memory n/a"
+                                                   : "%1 MB".arg(PerformanceMonitor.memoryUsage.toFixed(0))
+            ]
+
+            Text {
+                text: modelData
+                color: "white"
+                font {
+                    pixelSize: 10 * scaleFactor
+                    family: DsaStyles.fontFamily
+                }
+            }
+        }
+
+        // estimated footprint of each cache which gives memory back when it is short
+        Repeater {
+            model: PerformanceMonitor.memoryFootprints
+
+            Text {
+                text: "  %1: %2 MB".arg(modelData.name).arg(modelData.megabytes.toFixed(1))
+                color: "white"
+                font {
+                    pixelSize: 10 * scaleFactor
+                    family: DsaStyles.fontFamily
+                }
+            }
+        }
+
+        // heap allocations of each subsystem, when the app is built to count them
+        Repeater {
+            model: PerformanceMonitor.allocationStats
+
+            Text {
+                text: modelData.liveMegabytes < 0 ? "  %1: %2 allocs/s".arg(modelData.name).arg(modelData.allocationsPerSecond.toFixed(0))
+                                                  : "  %1: %2 allocs/s, %3 MB (peak %4 MB)".arg(modelData.name)
+                                                                                            .arg(modelData.allocationsPerSecond.toFixed(0))
+                                                                                            .arg(modelData.liveMegabytes.toFixed(1))
+                                                                                            .arg(modelData.peakMegabytes.toFixed(1))
+                color: "white"
+                font {
+                    pixelSize: 10 * scaleFactor
+                    family: DsaStyles.fontFamily
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,333 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "AllocationCounter.h"
+
+// STL headers
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+using Subsystem = Dsa::AllocationCounter::Subsystem;
+
+namespace {
+// heap allocations made by the current thread, a trivial type so it is usable from operator new
+thread_local qint64 s_threadAllocationCount = 0;
+
+// the subsystem to which the current thread's allocations are attributed
+thread_local Subsystem s_threadSubsystem = Subsystem::Other;
+
+// zero initialized before any dynamic initialization, so they are usable by allocations made before main
+std::atomic<qint64> s_subsystemAllocationCounts[Dsa::AllocationCounter::SubsystemCount];
+std::atomic<qint64> s_subsystemLiveBytes[Dsa::AllocationCounter::SubsystemCount];
+std::atomic<qint64> s_subsystemPeakBytes[Dsa::AllocationCounter::SubsystemCount];
+
+#ifdef DSA_COUNT_ALLOCATIONS
+#ifndef Q_OS_WIN
+// Each block is prefixed with its size and subsystem so that its bytes can be given
+// back to the subsystem which allocated it. On Windows each module may have its own
+// allocation functions, which would free a prefixed block at the wrong address, so
+// only allocation counts are kept there.
+#define DSA_TRACK_LIVE_BYTES
+
+struct alignas(std::max_align_t) BlockHeader
+{
+  std::size_t m_size;
+  Subsystem m_subsystem;
+};
+
+void* allocate(std::size_t size) noexcept
+{
+  auto header = static_cast<BlockHeader*>(std::malloc(sizeof(BlockHeader) + size));
+  if (!header)
+    return nullptr;
+
+  header->m_size = size;
+  header->m_subsystem = s_threadSubsystem;
+
+  const int index = static_cast<int>(header->m_subsystem);
+  const qint64 liveBytes = s_subsystemLiveBytes[index].fetch_add(size, std::memory_order_relaxed) + size;
+  qint64 peakBytes = s_subsystemPeakBytes[index].load(std::memory_order_relaxed);
+  while (liveBytes > peakBytes &&
+         !s_subsystemPeakBytes[index].compare_exchange_weak(peakBytes, liveBytes, std::memory_order_relaxed))
+  {
+  }
+
+  return header + 1;
+}
+
+void deallocate(void* p) noexcept
+{
+  if (!p)
+    return;
+
+  BlockHeader* header = static_cast<BlockHeader*>(p) - 1;
+  s_subsystemLiveBytes[static_cast<int>(header->m_subsystem)].fetch_sub(header->m_size, std::memory_order_relaxed);
+  std::free(header);
+}
+#else // Q_OS_WIN
+void* allocate(std::size_t size) noexcept
+{
+  return std::malloc(size);
+}
+
+void deallocate(void* p) noexcept
+{
+  std::free(p);
+}
+#endif // Q_OS_WIN
+
+void* countedAllocate(std::size_t size) noexcept
+{
+  ++s_threadAllocationCount;
+  s_subsystemAllocationCounts[static_cast<int>(s_threadSubsystem)].fetch_add(1, std::memory_order_relaxed);
+  return allocate(size ? size : 1);
+}
+#endif // DSA_COUNT_ALLOCATIONS
+}
+
+#ifdef DSA_COUNT_ALLOCATIONS
+
+// the global allocation functions are replaced to count every heap allocation
+
+void* operator new(std::size_t size)
+{
+  if (void* p = countedAllocate(size))
+    return p;
+
+  throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+  return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+  return countedAllocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept
+{
+  return operator new(size, tag);
+}
+
+void operator delete(void* p) noexcept
+{
+  deallocate(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+  deallocate(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+  deallocate(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+  deallocate(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+  deallocate(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+  deallocate(p);
+}
+
+#endif // DSA_COUNT_ALLOCATIONS
+
+namespace Dsa {
+
+/*!
+  \class Dsa::AllocationCounter
+  \inmodule Dsa
+  \brief Counts the heap allocations made through \c {operator new} by each thread.
+
+  Counting is only compiled in when \c DSA_COUNT_ALLOCATIONS is defined, e.g. with
+  \c {qmake CONFIG+=dsa_count_allocations}, as it replaces the global allocation
+  functions for the whole application. It is intended for verifying that hot paths,
+  such as decoding messages, do not allocate in the steady state.
+
+  Allocations made by Qt with \c malloc, such as the data of a \c QString, are
+  not counted.
+
+  Allocations are also attributed to the subsystem which made them, so that the
+  performance HUD can show which part of the app is responsible for heap churn and
+  growth. Code which belongs to a subsystem declares it with the
+  \c DSA_ALLOCATION_SCOPE macro, for example \c {DSA_ALLOCATION_SCOPE(Messages);},
+  which attributes the allocations made on the calling thread until the end of the
+  enclosing block. Allocations made outside of any scope are attributed to
+  \c Other.
+ */
+
+/*!
+  \enum Dsa::AllocationCounter::Subsystem
+
+  The parts of the app to which allocations are attributed.
+
+  \value Other Allocations made outside of any subsystem scope.
+  \value Messages Decoding and applying messages from the message feeds.
+  \value Alerts Evaluating alert conditions.
+  \value Analysis Running the analysis tools, such as viewsheds and line of sight.
+  \value Markup Drawing, sharing and receiving markups.
+  \value Layers Adding, caching and restoring layers.
+ */
+
+/*!
+  \class Dsa::AllocationCounter::SubsystemStats
+  \inmodule Dsa
+  \brief The allocations attributed to a subsystem so far.
+
+  \c m_allocationCount is the number of heap allocations made, while
+  \c m_liveBytes and \c m_peakBytes are the bytes currently allocated and the
+  most that have been allocated at once. The byte counts are \c -1 where they
+  are not tracked, see \l isTrackingLiveBytes.
+ */
+
+/*!
+  \class Dsa::AllocationCounter::Scope
+  \inmodule Dsa
+  \brief Attributes the allocations made by the calling thread to a subsystem for
+  the lifetime of the scope.
+
+  Scopes may be nested, in which case the innermost subsystem is used. This is
+  cheap enough to leave in release builds, as it only sets a thread local value.
+ */
+
+/*!
+  \brief Attributes the allocations made by the calling thread to \a subsystem
+  until the scope is destroyed.
+ */
+AllocationCounter::Scope::Scope(Subsystem subsystem):
+  m_previous(s_threadSubsystem)
+{
+  s_threadSubsystem = subsystem;
+}
+
+/*!
+  \brief Restores the subsystem which was current when the scope was created.
+ */
+AllocationCounter::Scope::~Scope()
+{
+  s_threadSubsystem = m_previous;
+}
+
+/*!
+  \brief Returns whether allocations are being counted.
+ */
+bool AllocationCounter::isEnabled()
+{
+#ifdef DSA_COUNT_ALLOCATIONS
+  return true;
+#else
+  return false;
+#endif
+}
+
+/*!
+  \brief Returns whether the bytes allocated by each subsystem are tracked, in
+  addition to the number of allocations.
+
+  This is \c false when allocations are not being counted, and on Windows, where
+  blocks may be freed by the allocation functions of another module.
+ */
+bool AllocationCounter::isTrackingLiveBytes()
+{
+#ifdef DSA_TRACK_LIVE_BYTES
+  return true;
+#else
+  return false;
+#endif
+}
+
+/*!
+  \brief Returns the number of heap allocations the calling thread has made so far,
+  or \c 0 if allocations are not being counted.
+
+  Take the difference of two counts to find the allocations made by a section of code.
+ */
+qint64 AllocationCounter::threadAllocationCount()
+{
+  return s_threadAllocationCount;
+}
+
+/*!
+  \brief Returns the subsystem to which the calling thread's allocations are
+  currently attributed.
+ */
+AllocationCounter::Subsystem AllocationCounter::currentSubsystem()
+{
+  return s_threadSubsystem;
+}
+
+/*!
+  \brief Returns the allocations attributed to \a subsystem by all threads so far.
+
+  Take the difference of two allocation counts to find the allocation rate.
+ */
+AllocationCounter::SubsystemStats AllocationCounter::subsystemStats(Subsystem subsystem)
+{
+  const int index = static_cast<int>(subsystem);
+
+  SubsystemStats stats;
+  stats.m_allocationCount = s_subsystemAllocationCounts[index].load(std::memory_order_relaxed);
+  if (isTrackingLiveBytes())
+  {
+    stats.m_liveBytes = s_subsystemLiveBytes[index].load(std::memory_order_relaxed);
+    stats.m_peakBytes = s_subsystemPeakBytes[index].load(std::memory_order_relaxed);
+  }
+
+  return stats;
+}
+
+/*!
+  \brief Returns the display name of \a subsystem.
+ */
+const char* AllocationCounter::subsystemName(Subsystem subsystem)
+{
+  switch (subsystem)
+  {
+  case Subsystem::Messages:
+    return "messages";
+  case Subsystem::Alerts:
+    return "alerts";
+  case Subsystem::Analysis:
+    return "analysis";
+  case Subsystem::Markup:
+    return "markup";
+  case Subsystem::Layers:
+    return "layers";
+  case Subsystem::Other:
+    break;
+  }
+
+  return "other";
+}
+
+} // Dsa
@@ -0,0 +1,80 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+// Qt headers
+#include <QtGlobal>
+
+namespace Dsa {
+
+class AllocationCounter
+{
+public:
+  enum class Subsystem
+  {
+    Other = 0,
+    Messages,
+    Alerts,
+    Analysis,
+    Markup,
+    Layers
+  };
+
+  static constexpr int SubsystemCount = static_cast<int>(Subsystem::Layers) + 1;
+
+  struct SubsystemStats
+  {
+    qint64 m_allocationCount = 0;
+    qint64 m_liveBytes = -1;
+    qint64 m_peakBytes = -1;
+  };
+
+  class Scope
+  {
+  public:
+    explicit Scope(Subsystem subsystem);
+    ~Scope();
+
+  private:
+    Q_DISABLE_COPY(Scope)
+
+    Subsystem m_previous;
+  };
+
+  static bool isEnabled();
+  static bool isTrackingLiveBytes();
+  static qint64 threadAllocationCount();
+
+  static Subsystem currentSubsystem();
+  static SubsystemStats subsystemStats(Subsystem subsystem);
+  static const char* subsystemName(Subsystem subsystem);
+
+private:
+  AllocationCounter() = delete;
+};
+
+} // Dsa
+
+#define DSA_ALLOCATION_CONCAT_IMPL(a, b) a##b
+#define DSA_ALLOCATION_CONCAT(a, b) DSA_ALLOCATION_CONCAT_IMPL(a, b)
+
+// attributes the heap allocations made by the rest of the enclosing block to a subsystem
+#define DSA_ALLOCATION_SCOPE(subsystem) \
+  Dsa::AllocationCounter::Scope DSA_ALLOCATION_CONCAT(dsaAllocationScope, __LINE__)(Dsa::AllocationCounter::Subsystem::subsystem)
+
+#endif // ALLOCATIONCOUNTER_H
@@ -0,0 +1,266 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "CoTStreamFramer.h"
+
+// Qt headers
+#include <QIODevice>
+
+// STL headers
+#include <cstring>
+
+namespace Dsa {
+
+namespace {
+// the closing tag which ends every CoT event on a stream
+constexpr char s_eventEndTag[] = "</event>";
+constexpr int s_eventEndTagLength = sizeof(s_eventEndTag) - 1;
+
+// a stream which goes this long without an event end is out of sync
+constexpr int s_defaultMaximumMessageSize = 1024 * 1024;
+
+constexpr int s_initialBufferSize = 64 * 1024;
+
+bool isXmlSpace(char c)
+{
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+}
+
+/*!
+  \class Dsa::CoTStreamFramer
+  \inmodule Dsa
+  \brief Splits a stream of CoT events, such as a TCP feed, into one message per event.
+
+  A stream delivers events split across reads or several to a read, so the bytes
+  read are appended to a buffer and each event is taken once its closing
+  \c {</event>} tag has arrived. Scanning resumes where the previous call
+  stopped, so a partial event is never scanned twice, and the bytes of a complete
+  event are copied only once, into the message which is taken.
+
+  The buffer is reused for the life of the framer; consumed bytes are dropped by
+  moving the unread tail to the front only when space is needed for new data.
+
+  If more than \l maximumMessageSize bytes arrive without the end of an event, the
+  stream is assumed to be out of sync and the buffered bytes are discarded.
+ */
+
+/*!
+  \brief Constructor.
+ */
+CoTStreamFramer::CoTStreamFramer() :
+  m_maximumMessageSize(s_defaultMaximumMessageSize)
+{
+}
+
+/*!
+  \brief Destructor.
+ */
+CoTStreamFramer::~CoTStreamFramer()
+{
+}
+
+/*!
+  \brief Returns the largest number of bytes buffered while waiting for the end of an event.
+
+  The default is 1 MB.
+ */
+int CoTStreamFramer::maximumMessageSize() const
+{
+  return m_maximumMessageSize;
+}
+
+/*!
+  \brief Sets the largest number of bytes buffered for a single event to \a maximumMessageSize.
+ */
+void CoTStreamFramer::setMaximumMessageSize(int maximumMessageSize)
+{
+  m_maximumMessageSize = qMax(s_eventEndTagLength, maximumMessageSize);
+}
+
+/*!
+  \brief Reads all of the bytes available from \a device straight into the buffer.
+
+  Returns the number of bytes read, or \c -1 if reading failed.
+ */
+qint64 CoTStreamFramer::readFrom(QIODevice* device)
+{
+  if (!device)
+    return -1;
+
+  qint64 totalRead = 0;
+  for (;;)
+  {
+    const qint64 available = device->bytesAvailable();
+    if (available <= 0)
+      break;
+
+    const int size = static_cast<int>(qMin<qint64>(available, m_maximumMessageSize));
+    char* data = reserve(size);
+    const qint64 bytesRead = device->read(data, size);
+    if (bytesRead < 0)
+      return totalRead > 0 ? totalRead : -1;
+
+    m_writePosition += static_cast<int>(bytesRead);
+    totalRead += bytesRead;
+    if (bytesRead < size)
+      break;
+  }
+
+  return totalRead;
+}
+
+/*!
+  \brief Appends \a size bytes of \a data to the buffer.
+ */
+void CoTStreamFramer::append(const char* data, int size)
+{
+  if (size <= 0)
+    return;
+
+  std::memcpy(reserve(size), data, static_cast<size_t>(size));
+  m_writePosition += size;
+}
+
+/*!
+  \brief Appends every complete event in the buffer to \a messages and returns how many were taken.
+
+  An incomplete event at the end of the buffer is kept until the rest of it arrives.
+ */
+int CoTStreamFramer::takeMessages(QVector<QByteArray>& messages)
+{
+  int count = 0;
+  for (;;)
+  {
+    const int eventEnd = findEventEnd();
+    if (eventEnd == -1)
+      break;
+
+    // whitespace between events is not part of either
+    int start = m_readPosition;
+    while (start < eventEnd && isXmlSpace(m_buffer.at(start)))
+      ++start;
+
+    messages.append(QByteArray(m_buffer.constData() + start, eventEnd - start));
+    ++count;
+
+    m_readPosition = eventEnd;
+    m_scanPosition = eventEnd;
+  }
+
+  if (m_writePosition - m_readPosition > m_maximumMessageSize)
+  {
+    m_discardedBytes += m_writePosition - m_readPosition;
+    m_readPosition = m_writePosition;
+  }
+
+  // with nothing left unread the next data can start at the front again
+  if (m_readPosition == m_writePosition)
+  {
+    m_readPosition = 0;
+    m_writePosition = 0;
+    m_scanPosition = 0;
+  }
+
+  return count;
+}
+
+/*!
+  \brief Returns the number of bytes waiting for the end of their event.
+ */
+int CoTStreamFramer::bufferedSize() const
+{
+  return m_writePosition - m_readPosition;
+}
+
+/*!
+  \brief Returns the number of bytes discarded because no event end was found in time.
+ */
+qint64 CoTStreamFramer::discardedBytes() const
+{
+  return m_discardedBytes;
+}
+
+/*!
+  \brief Discards any buffered bytes, e.g. when the stream is reconnected.
+ */
+void CoTStreamFramer::clear()
+{
+  m_readPosition = 0;
+  m_writePosition = 0;
+  m_scanPosition = 0;
+}
+
+/*!
+  \internal
+  \brief Returns a pointer to at least \a size bytes free at the write position.
+ */
+char* CoTStreamFramer::reserve(int size)
+{
+  if (m_writePosition + size > m_buffer.size())
+  {
+    // drop the consumed bytes before growing
+    const int unread = m_writePosition - m_readPosition;
+    if (m_readPosition > 0)
+    {
+      std::memmove(m_buffer.data(), m_buffer.constData() + m_readPosition, static_cast<size_t>(unread));
+      m_scanPosition -= m_readPosition;
+      m_readPosition = 0;
+      m_writePosition = unread;
+    }
+
+    if (m_writePosition + size > m_buffer.size())
+      m_buffer.resize(qMax(qMax(s_initialBufferSize, m_buffer.size() * 2), m_writePosition + size));
+  }
+
+  return m_buffer.data() + m_writePosition;
+}
+
+/*!
+  \internal
+  \brief Returns the position just after the next event end tag, or \c -1 if there is none yet.
+
+  The scan position is left where the next search must resume.
+ */
+int CoTStreamFramer::findEventEnd()
+{
+  const char* data = m_buffer.constData();
+  int position = m_scanPosition;
+  while (position <= m_writePosition - s_eventEndTagLength)
+  {
+    const void* found = std::memchr(data + position, '<', static_cast<size_t>(m_writePosition - position));
+    if (!found)
+      break;
+
+    position = static_cast<int>(static_cast<const char*>(found) - data);
+    if (position > m_writePosition - s_eventEndTagLength)
+      break;
+
+    if (std::memcmp(data + position, s_eventEndTag, s_eventEndTagLength) == 0)
+      return position + s_eventEndTagLength;
+
+    ++position;
+  }
+
+  // a tag split across reads is found once the rest of it arrives
+  m_scanPosition = qMax(m_readPosition, m_writePosition - s_eventEndTagLength + 1);
+  return -1;
+}
+
+} // Dsa
@@ -0,0 +1,64 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef COTSTREAMFRAMER_H
+#define COTSTREAMFRAMER_H
+
+// Qt headers
+#include <QByteArray>
+#include <QVector>
+
+class QIODevice;
+
+namespace Dsa {
+
+class CoTStreamFramer
+{
+public:
+  CoTStreamFramer();
+  ~CoTStreamFramer();
+
+  int maximumMessageSize() const;
+  void setMaximumMessageSize(int maximumMessageSize);
+
+  qint64 readFrom(QIODevice* device);
+  void append(const char* data, int size);
+
+  int takeMessages(QVector<QByteArray>& messages);
+
+  int bufferedSize() const;
+  qint64 discardedBytes() const;
+  void clear();
+
+private:
+  Q_DISABLE_COPY(CoTStreamFramer)
+
+  char* reserve(int size);
+  int findEventEnd();
+
+  // unread bytes run from the read to the write position, scanned up to the scan position
+  QByteArray m_buffer;
+  int m_readPosition = 0;
+  int m_writePosition = 0;
+  int m_scanPosition = 0;
+
+  int m_maximumMessageSize;
+  qint64 m_discardedBytes = 0;
+};
+
+} // Dsa
+
+#endif // COTSTREAMFRAMER_H
@@ -0,0 +1,164 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "CoordinateFormatUtils.h"
+
+// C++ API headers
+#include "CoordinateFormatter.h"
+#include "Point.h"
+
+// Qt headers
+#include <QHash>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <QVector>
+
+// STL headers
+#include <algorithm>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+namespace
+{
+// the smallest number of points formatted by each worker thread
+constexpr int s_minimumChunkSize = 256;
+
+QHash<QString, CoordinateFormatUtils::Formatter> createFormatters()
+{
+  QHash<QString, CoordinateFormatUtils::Formatter> formatters;
+
+  // Decimal Degrees
+  formatters.insert(QStringLiteral("DD"), [](const Point& p)
+  {
+    return CoordinateFormatter::toLatitudeLongitude(p, LatitudeLongitudeFormat::DecimalDegrees, 5);
+  });
+
+  // Degrees Decimal Minutes
+  formatters.insert(QStringLiteral("DDM"), [](const Point& p)
+  {
+    return CoordinateFormatter::toLatitudeLongitude(p, LatitudeLongitudeFormat::DegreesDecimalMinutes, 5);
+  });
+
+  // Degrees Minutes Seconds
+  formatters.insert(QStringLiteral("DMS"), [](const Point& p)
+  {
+    return CoordinateFormatter::toLatitudeLongitude(p, LatitudeLongitudeFormat::DegreesMinutesSeconds, 3);
+  });
+
+  // UTM
+  formatters.insert(QStringLiteral("UTM"), [](const Point& p)
+  {
+    return CoordinateFormatter::toUtm(p, UtmConversionMode::NorthSouthIndicators, true);
+  });
+
+  // MGRS
+  formatters.insert(QStringLiteral("MGRS"), [](const Point& p)
+  {
+    return CoordinateFormatter::toMgrs(p, MgrsConversionMode::Automatic, 5, true);
+  });
+
+  // USNG
+  formatters.insert(QStringLiteral("USNG"), [](const Point& p)
+  {
+    return CoordinateFormatter::toUsng(p, 5, true);
+  });
+
+  // GEOREF
+  formatters.insert(QStringLiteral("GEOREF"), [](const Point& p)
+  {
+    return CoordinateFormatter::toGeoRef(p, 5);
+  });
+
+  // GARS
+  formatters.insert(QStringLiteral("GARS"), [](const Point& p)
+  {
+    return CoordinateFormatter::toGars(p);
+  });
+
+  return formatters;
+}
+}
+
+/*!
+  \fn Dsa::CoordinateFormatUtils::Formatter Dsa::CoordinateFormatUtils::formatter(const QString& format)
+  \brief Returns the function which formats a point in the notation named \a format.
+
+  \a format is one of \c DD, \c DDM, \c DMS, \c UTM, \c MGRS, \c USNG, \c GEOREF or
+  \c GARS. Any other value returns the \c DMS formatter.
+ */
+CoordinateFormatUtils::Formatter CoordinateFormatUtils::formatter(const QString& format)
+{
+  static const QHash<QString, Formatter> s_formatters = createFormatters();
+
+  const auto findIt = s_formatters.constFind(format);
+  return findIt != s_formatters.constEnd() ? findIt.value() : s_formatters.value(QStringLiteral("DMS"));
+}
+
+/*!
+  \fn QStringList Dsa::CoordinateFormatUtils::formatPoints(const QList<Esri::ArcGISRuntime::Point>& points, const QString& format)
+  \brief Returns each of the \a points formatted in the notation named \a format.
+
+  The formatter is looked up once for the whole batch. Large batches are split into
+  chunks which are formatted in parallel on the global thread pool, with the calling
+  thread formatting the first chunk. Empty points are returned as empty strings.
+ */
+QStringList CoordinateFormatUtils::formatPoints(const QList<Point>& points, const QString& format)
+{
+  if (points.isEmpty())
+    return QStringList();
+
+  const Formatter formatPoint = formatter(format);
+  QVector<QString> results(points.size());
+
+  auto formatRange = [&points, &results, &formatPoint](int begin, int end)
+  {
+    for (int i = begin; i < end; ++i)
+    {
+      const Point& point = points.at(i);
+      if (!point.isEmpty())
+        results[i] = formatPoint(point);
+    }
+  };
+
+  QThreadPool* threadPool = QThreadPool::globalInstance();
+  const int chunkCount = std::max(1, std::min(threadPool->maxThreadCount(), points.size() / s_minimumChunkSize));
+  const int chunkSize = (points.size() + chunkCount - 1) / chunkCount;
+
+  // each worker writes only to its own range of the results
+  QSemaphore finishedChunks;
+  for (int chunk = 1; chunk < chunkCount; ++chunk)
+  {
+    const int begin = chunk * chunkSize;
+    const int end = std::min(points.size(), begin + chunkSize);
+    threadPool->start([&formatRange, &finishedChunks, begin, end]()
+    {
+      formatRange(begin, end);
+      finishedChunks.release();
+    });
+  }
+
+  formatRange(0, std::min(points.size(), chunkSize));
+  finishedChunks.acquire(chunkCount - 1);
+
+  return results.toList();
+}
+
+} // Dsa
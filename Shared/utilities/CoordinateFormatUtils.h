@@ -0,0 +1,46 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef COORDINATEFORMATUTILS_H
+#define COORDINATEFORMATUTILS_H
+
+// Qt headers
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+// STL headers
+#include <functional>
+
+namespace Esri {
+namespace ArcGISRuntime {
+  class Point;
+}
+}
+
+namespace Dsa {
+
+namespace CoordinateFormatUtils
+{
+  using Formatter = std::function<QString(const Esri::ArcGISRuntime::Point&)>;
+
+  Formatter formatter(const QString& format);
+  QStringList formatPoints(const QList<Esri::ArcGISRuntime::Point>& points, const QString& format);
+}
+
+} // Dsa
+
+#endif // COORDINATEFORMATUTILS_H
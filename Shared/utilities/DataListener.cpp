@@ -19,7 +19,12 @@
 
 #include "DataListener.h"
 
+// dsa app headers
+#include "DatagramCaptureWriter.h"
+#include "UdpReceiver.h"
+
 // Qt headers
+#include <QAbstractSocket>
 #include <QUdpSocket>
 
 namespace Dsa {
@@ -29,6 +34,10 @@ namespace Dsa {
   \inmodule Dsa
   \inherits QObject
   \brief Utility class for listening on a UDP socket.
+
+  Other devices, such as a QTcpSocket connected to a TAK server, are read as a
+  stream. With \l {isStreamFraming}{stream framing}, the stream is split into one
+  message per CoT event; otherwise each read is taken to be a single message.
  */
 
 /*!
@@ -76,6 +85,36 @@ QIODevice* DataListener::device() const
   return m_device.data();
 }
 
+/*!
+  \brief Sets the UdpReceiver to \a receiver, which reads datagrams on its own
+  thread instead of through a QIODevice.
+
+  The listener takes the datagrams delivered by the receiver as if they had been
+  read from a device, but does not take ownership of it.
+
+  \sa UdpReceiver::isSupported
+ */
+void DataListener::setReceiver(UdpReceiver* receiver)
+{
+  if (m_receiverConn)
+    disconnect(m_receiverConn);
+
+  m_receiver = receiver;
+  if (m_receiver)
+  {
+    m_receiverConn = connect(m_receiver.data(), &UdpReceiver::datagramsReceived,
+                             this, &DataListener::processReceivedDatagrams);
+  }
+}
+
+/*!
+  \brief Returns the current UdpReceiver.
+ */
+UdpReceiver* DataListener::receiver() const
+{
+  return m_receiver.data();
+}
+
 /*!
   \brief Returns whether the data listener is enabled.
  */
@@ -100,6 +139,109 @@ void DataListener::setEnabled(bool enabled)
   m_enabled = enabled;
 }
 
+/*!
+  \brief Returns whether the data listener is in batch mode.
+
+  In batch mode, all pending data is drained on each \c readyRead
+  and emitted with a single \l dataReceivedBatch signal instead of
+  one \l dataReceived signal per datagram.
+
+  The default is \c false.
+ */
+bool DataListener::isBatchMode() const
+{
+  return m_batchMode;
+}
+
+/*!
+  \brief Sets whether the data listener is in batch mode to \a batchMode.
+
+  \sa isBatchMode
+ */
+void DataListener::setBatchMode(bool batchMode)
+{
+  m_batchMode = batchMode;
+}
+
+/*!
+  \brief Returns whether data read from a stream device is split into CoT events.
+
+  Streams such as TCP deliver events split across reads or several in one read.
+  When framing, the bytes are buffered by a CoTStreamFramer and one message is
+  emitted for each complete event; in batch mode all of the events completed by a
+  read are emitted with a single \l dataReceivedBatch signal. Framing has no effect
+  on UDP sockets, whose datagrams are already messages.
+
+  The default is \c false.
+ */
+bool DataListener::isStreamFraming() const
+{
+  return m_streamFraming;
+}
+
+/*!
+  \brief Sets whether data read from a stream device is split into CoT events to \a streamFraming.
+
+  \sa isStreamFraming
+ */
+void DataListener::setStreamFraming(bool streamFraming)
+{
+  if (m_streamFraming == streamFraming)
+    return;
+
+  m_streamFraming = streamFraming;
+  m_framer.clear();
+}
+
+/*!
+  \brief Returns the number of datagrams, or reads for other devices, received by the listener.
+
+  When \l {isStreamFraming}{stream framing}, this is the number of CoT events received.
+ */
+qint64 DataListener::receivedCount() const
+{
+  return m_receivedCount;
+}
+
+/*!
+  \brief Returns the number of bytes received by the listener.
+ */
+qint64 DataListener::receivedBytes() const
+{
+  return m_receivedBytes;
+}
+
+/*!
+  \brief Returns the number of datagrams dropped before they reached the listener,
+  as reported by the UdpReceiver.
+
+  Sockets read through a QIODevice do not report drops, so this is \c 0 without a receiver.
+ */
+qint64 DataListener::droppedCount() const
+{
+  return m_receiver ? m_receiver->droppedCount() : 0;
+}
+
+/*!
+  \brief Sets the \a captureWriter which records every received datagram, with
+  the time it was received and the listener's port.
+
+  The listener does not take ownership of the writer, which can be shared by
+  several listeners. Set \c nullptr to stop capturing.
+ */
+void DataListener::setCaptureWriter(DatagramCaptureWriter* captureWriter)
+{
+  m_captureWriter = captureWriter;
+}
+
+/*!
+  \brief Returns the current capture writer.
+ */
+DatagramCaptureWriter* DataListener::captureWriter() const
+{
+  return m_captureWriter.data();
+}
+
 /*!
   \internal
  */
@@ -112,13 +254,45 @@ void DataListener::connectDevice()
 
   m_deviceConn = connect(m_device.data(), &QIODevice::readyRead, this, [this]
   {
-    if (!processUdpDatagrams())
+    if (processUdpDatagrams())
+      return;
+
+    if (m_streamFraming)
+    {
+      processStream();
+    }
+    else
     {
       // if bytes were not processed as UDP datagram then
       // read bytes directly from the device
-      emit dataReceived(m_device->readAll());
+      const QByteArray data = m_device->readAll();
+      ++m_receivedCount;
+      m_receivedBytes += data.size();
+
+      if (m_captureWriter)
+        m_captureWriter->append(port(), data);
+
+      if (m_batchMode)
+      {
+        m_batch.append(data);
+        emitBatch();
+      }
+      else
+      {
+        emit dataReceived(data);
+      }
     }
   });
+
+  // a partial event from a dropped connection must not prefix the next one
+  QAbstractSocket* socket = qobject_cast<QAbstractSocket*>(m_device.data());
+  if (socket)
+  {
+    m_disconnectedConn = connect(socket, &QAbstractSocket::disconnected, this, [this]
+    {
+      m_framer.clear();
+    });
+  }
 }
 
 /*!
@@ -129,6 +303,11 @@ void DataListener::disconnectDevice()
   if (m_deviceConn)
     disconnect(m_deviceConn);
 
+  if (m_disconnectedConn)
+    disconnect(m_disconnectedConn);
+
+  m_framer.clear();
+
   // any pending UDP datagrams need to be processed or else
   // QIODevice::readyRead() signal is not emitted for the next datagram
   processUdpDatagrams();
@@ -145,24 +324,205 @@ bool DataListener::processUdpDatagrams()
     // there is currently a Qt limitation that the listener needs to call
     // the QUdpSocket datagram methods instead of being able to use
     // QIODevice's readAll() method directly.
+    if (!m_batchMode)
+    {
+      while (udpSocket->hasPendingDatagrams())
+      {
+        QByteArray datagram;
+        if (!readDatagram(udpSocket, datagram))
+          continue;
+
+        if (m_captureWriter)
+          m_captureWriter->append(udpSocket->localPort(), datagram);
+
+        // the byte array carries the length of the datagram, so binary payloads are passed whole
+        emit dataReceived(datagram);
+        recycleBuffer(datagram);
+      }
+
+      return true;
+    }
+
+    // drain every pending datagram so that a burst results in a single signal emission
     while (udpSocket->hasPendingDatagrams())
     {
       QByteArray datagram;
-      datagram.resize(udpSocket->pendingDatagramSize());
-      udpSocket->readDatagram(datagram.data(), datagram.size());
-      emit dataReceived(datagram.data());
+      if (readDatagram(udpSocket, datagram))
+      {
+        if (m_captureWriter)
+          m_captureWriter->append(udpSocket->localPort(), datagram);
+        m_batch.append(datagram);
+      }
     }
 
+    emitBatch();
+
     return true;
   }
 
   return false;
 }
 
+/*!
+  \internal
+  \brief Reads the next datagram from \a udpSocket into \a datagram, a buffer taken
+  from the pool and sized from the pending datagram, so that it is read without a copy.
+
+  Returns \c false, returning the buffer to the pool, if nothing could be read.
+ */
+bool DataListener::readDatagram(QUdpSocket* udpSocket, QByteArray& datagram)
+{
+  datagram = m_bufferPool.isEmpty() ? QByteArray() : m_bufferPool.takeLast();
+  datagram.resize(static_cast<int>(udpSocket->pendingDatagramSize()));
+  const qint64 bytesRead = udpSocket->readDatagram(datagram.data(), datagram.size());
+  if (bytesRead <= 0)
+  {
+    recycleBuffer(datagram);
+    return false;
+  }
+
+  datagram.resize(static_cast<int>(bytesRead));
+  ++m_receivedCount;
+  m_receivedBytes += bytesRead;
+  return true;
+}
+
+/*!
+  \internal
+  \brief Returns \a buffer to the pool if no receiver still holds on to it.
+
+  Receivers which held on to the data (e.g. queued connections) share the buffer,
+  so only detached buffers can be reused without a copy. Shrinking a buffer keeps
+  its allocation, so a reused buffer is only reallocated for a larger datagram.
+ */
+void DataListener::recycleBuffer(QByteArray& buffer)
+{
+  if (buffer.isDetached() && m_bufferPool.size() < s_maximumPooledBuffers)
+    m_bufferPool.append(std::move(buffer));
+
+  buffer = QByteArray();
+}
+
+/*!
+  \internal
+  \brief Reads the stream device and emits each CoT event it completes.
+ */
+void DataListener::processStream()
+{
+  const qint64 bytesRead = m_framer.readFrom(m_device);
+  if (bytesRead <= 0)
+    return;
+
+  m_receivedBytes += bytesRead;
+
+  const int count = m_framer.takeMessages(m_batch);
+  if (count == 0)
+    return;
+
+  m_receivedCount += count;
+
+  if (m_captureWriter)
+  {
+    const quint16 devicePort = port();
+    for (const auto& message : qAsConst(m_batch))
+      m_captureWriter->append(devicePort, message);
+  }
+
+  // the framer allocates each message, so there are no buffers to return to the pool
+  const QVector<QByteArray> messages = m_batch;
+  m_batch.clear();
+
+  if (m_batchMode)
+  {
+    emit dataReceivedBatch(messages);
+    return;
+  }
+
+  for (const auto& message : messages)
+    emit dataReceived(message);
+}
+
+/*!
+  \internal
+  \brief Handles the \a datagrams delivered by the UdpReceiver.
+ */
+void DataListener::processReceivedDatagrams(const QVector<QByteArray>& datagrams)
+{
+  if (!m_enabled)
+    return;
+
+  m_receivedCount += datagrams.size();
+  for (const auto& datagram : datagrams)
+    m_receivedBytes += datagram.size();
+
+  if (m_captureWriter)
+  {
+    const quint16 receiverPort = port();
+    for (const auto& datagram : datagrams)
+      m_captureWriter->append(receiverPort, datagram);
+  }
+
+  if (m_batchMode)
+  {
+    emit dataReceivedBatch(datagrams);
+    return;
+  }
+
+  for (const auto& datagram : datagrams)
+    emit dataReceived(datagram);
+}
+
+/*!
+  \internal
+  \brief Emits the drained batch and returns the buffers which are no
+  longer referenced by a receiver to the pool for reuse.
+ */
+void DataListener::emitBatch()
+{
+  if (m_batch.isEmpty())
+    return;
+
+  emit dataReceivedBatch(m_batch);
+
+  for (auto& datagram : m_batch)
+    recycleBuffer(datagram);
+
+  m_batch.clear();
+}
+
+/*!
+  \internal
+  \brief Returns the port the listener receives on, or \c 0 if it is not known.
+ */
+quint16 DataListener::port() const
+{
+  if (m_receiver)
+    return m_receiver->port();
+
+  // a TCP feed is identified by the server port it is connected to
+  const QAbstractSocket* socket = qobject_cast<const QAbstractSocket*>(m_device.data());
+  if (!socket)
+    return 0;
+
+  return socket->socketType() == QAbstractSocket::TcpSocket ? socket->peerPort() : socket->localPort();
+}
+
 } // Dsa
 
 // Signal Documentation
 /*!
   \fn void DataListener::dataReceived(const QByteArray& data);
   \brief Signal emitted when \a data is received as a byte array.
+
+  The byte array holds the whole datagram, including any NUL bytes, so binary
+  formats can be decoded from it. It shares the listener's buffer, which is reused
+  for a later datagram once no receiver holds on to it.
+ */
+
+/*!
+  \fn void DataListener::dataReceivedBatch(const QVector<QByteArray>& data);
+  \brief Signal emitted in batch mode when all pending \a data has been drained
+  from the device, with one byte array per datagram.
+
+  \sa isBatchMode
  */
@@ -17,13 +17,22 @@
 #ifndef DATALISTENER_H
 #define DATALISTENER_H
 
+// dsa app headers
+#include "CoTStreamFramer.h"
+
 // Qt headers
 #include <QIODevice>
 #include <QObject>
 #include <QPointer>
+#include <QVector>
+
+class QUdpSocket;
 
 namespace Dsa {
 
+class DatagramCaptureWriter;
+class UdpReceiver;
+
 class DataListener : public QObject
 {
   Q_OBJECT
@@ -36,24 +45,60 @@ public:
   void setDevice(QIODevice* device);
   QIODevice* device() const;
 
+  void setReceiver(UdpReceiver* receiver);
+  UdpReceiver* receiver() const;
+
   bool isEnabled() const;
   void setEnabled(bool enabled);
 
+  bool isBatchMode() const;
+  void setBatchMode(bool batchMode);
+
+  bool isStreamFraming() const;
+  void setStreamFraming(bool streamFraming);
+
+  qint64 receivedCount() const;
+  qint64 receivedBytes() const;
+  qint64 droppedCount() const;
+
+  void setCaptureWriter(DatagramCaptureWriter* captureWriter);
+  DatagramCaptureWriter* captureWriter() const;
+
 signals:
   void dataReceived(const QByteArray& data);
+  void dataReceivedBatch(const QVector<QByteArray>& data);
 
 private:
   Q_DISABLE_COPY(DataListener)
 
   void connectDevice();
   void disconnectDevice();
+  void processReceivedDatagrams(const QVector<QByteArray>& datagrams);
 
   bool processUdpDatagrams();
+  bool readDatagram(QUdpSocket* udpSocket, QByteArray& datagram);
+  void recycleBuffer(QByteArray& buffer);
+  void processStream();
+  void emitBatch();
+  quint16 port() const;
 
   QPointer<QIODevice> m_device;
   QMetaObject::Connection m_deviceConn;
+  QMetaObject::Connection m_disconnectedConn;
+  QPointer<UdpReceiver> m_receiver;
+  QMetaObject::Connection m_receiverConn;
+  QPointer<DatagramCaptureWriter> m_captureWriter;
 
   bool m_enabled = true;
+  bool m_batchMode = false;
+  bool m_streamFraming = false;
+  qint64 m_receivedCount = 0;
+  qint64 m_receivedBytes = 0;
+
+  QVector<QByteArray> m_batch;
+  QVector<QByteArray> m_bufferPool;
+  static constexpr int s_maximumPooledBuffers = 64;
+  CoTStreamFramer m_framer;
 };
 
 } // Dsa
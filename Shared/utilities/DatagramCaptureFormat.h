@@ -0,0 +1,42 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef DATAGRAMCAPTUREFORMAT_H
+#define DATAGRAMCAPTUREFORMAT_H
+
+namespace Dsa {
+namespace DatagramCapture {
+
+// The layout of the capture files written by DatagramCaptureWriter and read by
+// DatagramCaptureReader. All values are little-endian.
+
+// the file starts with the magic bytes and the capture start time in msecs since the epoch
+constexpr char s_fileMagic[] = "DSACAP01";
+constexpr int s_fileMagicSize = 8;
+constexpr int s_fileHeaderSize = s_fileMagicSize + 8;
+
+// each record holds the usecs since the capture started as a qint64, the port the
+// datagram was received on as a quint16 and the size of the datagram as a quint32,
+// followed by the datagram itself
+constexpr int s_recordTimestampOffset = 0;
+constexpr int s_recordPortOffset = 8;
+constexpr int s_recordSizeOffset = 10;
+constexpr int s_recordHeaderSize = 14;
+
+} // DatagramCapture
+} // Dsa
+
+#endif // DATAGRAMCAPTUREFORMAT_H
@@ -0,0 +1,161 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#include "DatagramCaptureReader.h"
+
+// dsa app headers
+#include "DatagramCaptureFormat.h"
+
+// Qt headers
+#include <QtEndian>
+
+// STL headers
+#include <cstring>
+
+namespace Dsa {
+
+/*!
+  \class Dsa::DatagramCaptureReader
+  \inmodule Dsa
+  \brief Reads the records of a capture file written by \l DatagramCaptureWriter.
+
+  The file is memory mapped, and each datagram is returned as a shallow slice of the
+  mapping, so reading a record does not copy the datagram. The returned datagrams are
+  only valid until the reader is closed.
+ */
+
+/*!
+  \brief Constructor.
+ */
+DatagramCaptureReader::DatagramCaptureReader()
+{
+}
+
+/*!
+  \brief Destructor.
+ */
+DatagramCaptureReader::~DatagramCaptureReader()
+{
+  close();
+}
+
+/*!
+  \brief Opens the capture file at \a filePath for reading from its first record.
+
+  Returns \c false if the file could not be opened or is not a capture file.
+ */
+bool DatagramCaptureReader::open(const QString& filePath)
+{
+  close();
+
+  m_file.setFileName(filePath);
+  if (!m_file.open(QIODevice::ReadOnly))
+    return false;
+
+  m_size = m_file.size();
+  m_data = m_size >= DatagramCapture::s_fileHeaderSize ? m_file.map(0, m_size) : nullptr;
+  if (!m_data || std::memcmp(m_data, DatagramCapture::s_fileMagic, DatagramCapture::s_fileMagicSize) != 0)
+  {
+    close();
+    return false;
+  }
+
+  m_startTime = qFromLittleEndian<qint64>(m_data + DatagramCapture::s_fileMagicSize);
+  m_position = DatagramCapture::s_fileHeaderSize;
+  return true;
+}
+
+/*!
+  \brief Closes the capture file.
+ */
+void DatagramCaptureReader::close()
+{
+  if (m_data)
+    m_file.unmap(const_cast<uchar*>(m_data));
+
+  if (m_file.isOpen())
+    m_file.close();
+
+  m_data = nullptr;
+  m_size = 0;
+  m_position = 0;
+  m_startTime = 0;
+}
+
+/*!
+  \brief Returns whether a capture file is open.
+ */
+bool DatagramCaptureReader::isOpen() const
+{
+  return m_data != nullptr;
+}
+
+/*!
+  \brief Returns the time the capture was started, in msecs since the epoch.
+ */
+qint64 DatagramCaptureReader::startTime() const
+{
+  return m_startTime;
+}
+
+/*!
+  \brief Reads the next record into \a record.
+
+  The timestamp of the record is in usecs since the capture started. Returns \c false
+  at the end of the file, or if the last record was truncated, for example because
+  the app was stopped while capturing.
+ */
+bool DatagramCaptureReader::readNext(Record& record)
+{
+  if (!m_data || m_position + DatagramCapture::s_recordHeaderSize > m_size)
+    return false;
+
+  const uchar* header = m_data + m_position;
+  const quint32 size = qFromLittleEndian<quint32>(header + DatagramCapture::s_recordSizeOffset);
+  if (m_position + DatagramCapture::s_recordHeaderSize + size > m_size)
+    return false;
+
+  record.m_timestamp = qFromLittleEndian<qint64>(header + DatagramCapture::s_recordTimestampOffset);
+  record.m_port = qFromLittleEndian<quint16>(header + DatagramCapture::s_recordPortOffset);
+  record.m_datagram = QByteArray::fromRawData(reinterpret_cast<const char*>(header + DatagramCapture::s_recordHeaderSize),
+                                              static_cast<int>(size));
+
+  m_position += DatagramCapture::s_recordHeaderSize + size;
+  return true;
+}
+
+/*!
+  \brief Returns whether there are no more complete records to read.
+ */
+bool DatagramCaptureReader::atEnd() const
+{
+  if (!m_data || m_position + DatagramCapture::s_recordHeaderSize > m_size)
+    return true;
+
+  const quint32 size = qFromLittleEndian<quint32>(m_data + m_position + DatagramCapture::s_recordSizeOffset);
+  return m_position + DatagramCapture::s_recordHeaderSize + size > m_size;
+}
+
+/*!
+  \brief Returns to the first record of the capture.
+ */
+void DatagramCaptureReader::rewind()
+{
+  if (m_data)
+    m_position = DatagramCapture::s_fileHeaderSize;
+}
+
+} // Dsa
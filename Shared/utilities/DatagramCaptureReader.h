@@ -0,0 +1,61 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef DATAGRAMCAPTUREREADER_H
+#define DATAGRAMCAPTUREREADER_H
+
+// Qt headers
+#include <QByteArray>
+#include <QFile>
+
+namespace Dsa {
+
+class DatagramCaptureReader
+{
+public:
+  struct Record
+  {
+    qint64 m_timestamp = 0;
+    quint16 m_port = 0;
+    QByteArray m_datagram;
+  };
+
+  DatagramCaptureReader();
+  ~DatagramCaptureReader();
+
+  bool open(const QString& filePath);
+  void close();
+  bool isOpen() const;
+
+  qint64 startTime() const;
+
+  bool readNext(Record& record);
+  bool atEnd() const;
+  void rewind();
+
+private:
+  Q_DISABLE_COPY(DatagramCaptureReader)
+
+  QFile m_file;
+  const uchar* m_data = nullptr;
+  qint64 m_size = 0;
+  qint64 m_position = 0;
+  qint64 m_startTime = 0;
+};
+
+} // Dsa
+
+#endif // DATAGRAMCAPTUREREADER_H
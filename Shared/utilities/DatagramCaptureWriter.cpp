@@ -0,0 +1,234 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "DatagramCaptureWriter.h"
+
+// dsa app headers
+#include "DatagramCaptureFormat.h"
+
+// Qt headers
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QThread>
+#include <QtEndian>
+
+// STL headers
+#include <cstring>
+
+namespace Dsa {
+
+namespace
+{
+// maximum number of bytes waiting to be written before datagrams are dropped from the capture
+constexpr int s_pendingCapacity = 16 * 1024 * 1024;
+
+// the writer thread wakes at least this often, in ms, to flush the file
+constexpr unsigned long s_flushInterval = 1000;
+}
+
+/*!
+  \class Dsa::DatagramCaptureWriter
+  \inmodule Dsa
+  \inherits QObject
+  \brief Writes received datagrams to a compact, append-only binary capture file.
+
+  A capture records the exact load seen by the data listeners in the field so
+  that it can be replayed later, for example by the MessageSimulator. Each record
+  holds the time since the capture started in microseconds, the port the datagram
+  was received on, and the raw bytes of the datagram. The layout is described in
+  DatagramCaptureFormat.h.
+
+  \l append only copies the record into a buffer, and the file is written on a
+  dedicated thread. If the writer thread falls too far behind, further datagrams
+  are dropped from the capture rather than slowing down the listeners.
+
+  \sa DataListener::setCaptureWriter
+ */
+
+/*!
+  \brief Constructor taking an optional \a parent.
+ */
+DatagramCaptureWriter::DatagramCaptureWriter(QObject* parent):
+  QObject(parent)
+{
+}
+
+/*!
+  \brief Destructor.
+ */
+DatagramCaptureWriter::~DatagramCaptureWriter()
+{
+  close();
+}
+
+/*!
+  \brief Creates the capture file at \a filePath and starts the writer thread.
+
+  Any existing file at \a filePath is replaced. Returns \c false if the file could not be created.
+ */
+bool DatagramCaptureWriter::open(const QString& filePath)
+{
+  close();
+
+  QDir().mkpath(QFileInfo(filePath).absolutePath());
+
+  m_file.setFileName(filePath);
+  if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    return false;
+
+  char header[DatagramCapture::s_fileHeaderSize];
+  std::memcpy(header, DatagramCapture::s_fileMagic, DatagramCapture::s_fileMagicSize);
+  qToLittleEndian<qint64>(QDateTime::currentMSecsSinceEpoch(), header + DatagramCapture::s_fileMagicSize);
+  if (m_file.write(header, DatagramCapture::s_fileHeaderSize) != DatagramCapture::s_fileHeaderSize)
+  {
+    m_file.close();
+    return false;
+  }
+
+  m_capturedCount = 0;
+  m_droppedCount = 0;
+  m_stopping = false;
+  m_clock.start();
+
+  m_thread = QThread::create([this] { writeLoop(); });
+  m_thread->setObjectName(QStringLiteral("DatagramCaptureWriter"));
+  m_thread->start(QThread::LowPriority);
+
+  return true;
+}
+
+/*!
+  \brief Writes any pending datagrams, stops the writer thread and closes the file.
+ */
+void DatagramCaptureWriter::close()
+{
+  if (m_thread)
+  {
+    {
+      QMutexLocker locker(&m_pendingMutex);
+      m_stopping = true;
+      m_pendingCondition.wakeOne();
+    }
+
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+  }
+
+  if (m_file.isOpen())
+    m_file.close();
+}
+
+/*!
+  \brief Returns whether datagrams are being captured.
+ */
+bool DatagramCaptureWriter::isOpen() const
+{
+  return m_thread != nullptr;
+}
+
+/*!
+  \brief Returns the path of the capture file.
+ */
+QString DatagramCaptureWriter::filePath() const
+{
+  return m_file.fileName();
+}
+
+/*!
+  \brief Appends \a datagram, received on \a port, to the capture.
+
+  This method is thread-safe and does not block on the file.
+ */
+void DatagramCaptureWriter::append(quint16 port, const QByteArray& datagram)
+{
+  if (!m_thread)
+    return;
+
+  char header[DatagramCapture::s_recordHeaderSize];
+  qToLittleEndian<qint64>(m_clock.nsecsElapsed() / 1000, header + DatagramCapture::s_recordTimestampOffset);
+  qToLittleEndian<quint16>(port, header + DatagramCapture::s_recordPortOffset);
+  qToLittleEndian<quint32>(static_cast<quint32>(datagram.size()), header + DatagramCapture::s_recordSizeOffset);
+
+  QMutexLocker locker(&m_pendingMutex);
+  if (m_pendingRecords.size() + DatagramCapture::s_recordHeaderSize + datagram.size() > s_pendingCapacity)
+  {
+    ++m_droppedCount;
+    return;
+  }
+
+  const bool wasEmpty = m_pendingRecords.isEmpty();
+  m_pendingRecords.append(header, DatagramCapture::s_recordHeaderSize);
+  m_pendingRecords.append(datagram);
+  ++m_capturedCount;
+
+  if (wasEmpty)
+    m_pendingCondition.wakeOne();
+}
+
+/*!
+  \brief Returns the number of datagrams written to the capture.
+ */
+qint64 DatagramCaptureWriter::capturedCount() const
+{
+  return m_capturedCount;
+}
+
+/*!
+  \brief Returns the number of datagrams dropped from the capture because the
+  writer thread could not keep up.
+ */
+qint64 DatagramCaptureWriter::droppedCount() const
+{
+  return m_droppedCount;
+}
+
+/*!
+  \internal
+  \brief Writes the pending records until the writer is closed. Runs on the writer thread.
+ */
+void DatagramCaptureWriter::writeLoop()
+{
+  QByteArray records;
+  bool stopping = false;
+
+  while (!stopping)
+  {
+    {
+      QMutexLocker locker(&m_pendingMutex);
+      if (m_pendingRecords.isEmpty() && !m_stopping)
+        m_pendingCondition.wait(&m_pendingMutex, s_flushInterval);
+
+      // the buffers are swapped so that appending never waits for the file
+      records.swap(m_pendingRecords);
+      stopping = m_stopping;
+    }
+
+    if (!records.isEmpty())
+    {
+      m_file.write(records);
+      records.clear();
+    }
+
+    m_file.flush();
+  }
+}
+
+} // Dsa
@@ -0,0 +1,75 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef DATAGRAMCAPTUREWRITER_H
+#define DATAGRAMCAPTUREWRITER_H
+
+// Qt headers
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
+#include <QObject>
+#include <QVector>
+#include <QWaitCondition>
+
+// STL headers
+#include <atomic>
+
+class QThread;
+
+namespace Dsa {
+
+class DatagramCaptureWriter : public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit DatagramCaptureWriter(QObject* parent = nullptr);
+  ~DatagramCaptureWriter();
+
+  bool open(const QString& filePath);
+  void close();
+  bool isOpen() const;
+
+  QString filePath() const;
+
+  void append(quint16 port, const QByteArray& datagram);
+
+  qint64 capturedCount() const;
+  qint64 droppedCount() const;
+
+private:
+  Q_DISABLE_COPY(DatagramCaptureWriter)
+
+  void writeLoop();
+
+  QFile m_file;
+  QThread* m_thread = nullptr;
+  QElapsedTimer m_clock;
+
+  QMutex m_pendingMutex;
+  QWaitCondition m_pendingCondition;
+  QByteArray m_pendingRecords;
+  bool m_stopping = false;
+
+  std::atomic<qint64> m_capturedCount{0};
+  std::atomic<qint64> m_droppedCount{0};
+};
+
+} // Dsa
+
+#endif // DATAGRAMCAPTUREWRITER_H
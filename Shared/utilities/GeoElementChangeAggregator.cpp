@@ -0,0 +1,198 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "GeoElementChangeAggregator.h"
+
+// dsa app headers
+#include "GeoElementUtils.h"
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+/*!
+  \class Dsa::GeoElementChangeAggregator
+  \inmodule Dsa
+  \inherits QObject
+  \brief Watches the geometry of a collection of
+  \l Esri::ArcGISRuntime::GeoElement objects and reports changes in batches.
+
+  Each element is identified by an integer key chosen by the owner of the aggregator,
+  e.g. the storage key of an index built for an overlay or layer. The aggregator
+  connects directly to the signals of each element, so no QObject is allocated per
+  element as is the case with \l GeoElementSignaler.
+
+  Changes are collected until control returns to the event loop and are then reported
+  with a single \l geometriesChanged signal. An element which moves several times in
+  that period is reported once.
+
+  \sa GeoElementUtils::connectGeometryChanged
+ */
+
+/*!
+  \brief Constructor taking an optional \a parent.
+ */
+GeoElementChangeAggregator::GeoElementChangeAggregator(QObject* parent):
+  QObject(parent)
+{
+  m_flushTimer.setSingleShot(true);
+  m_flushTimer.setInterval(0);
+  connect(&m_flushTimer, &QTimer::timeout, this, &GeoElementChangeAggregator::flush);
+}
+
+/*!
+  \brief Destructor.
+ */
+GeoElementChangeAggregator::~GeoElementChangeAggregator()
+{
+  clear();
+}
+
+/*!
+  \brief Starts watching \a geoElement, which is reported using \a key.
+
+  Any element previously watched with \a key is no longer watched.
+ */
+void GeoElementChangeAggregator::watch(GeoElement* geoElement, int key)
+{
+  QObject* object = GeoElementUtils::toQObject(geoElement);
+  if (!object)
+    return;
+
+  unwatch(key);
+
+  Connections connections;
+  connections.m_geometryChanged = GeoElementUtils::connectGeometryChanged(geoElement, this, [this, key]()
+  {
+    markChanged(key);
+  });
+
+  connections.m_destroyed = connect(object, &QObject::destroyed, this, [this, key]()
+  {
+    // the element is being destroyed so the connection is dropped without being used again
+    m_connections.remove(key);
+    if (m_pendingKeys.remove(key))
+      m_pending.removeOne(key);
+
+    emit elementDestroyed(key);
+  });
+
+  m_connections.insert(key, connections);
+}
+
+/*!
+  \brief Stops watching the element with \a key.
+
+  Any pending change for the element is discarded.
+ */
+void GeoElementChangeAggregator::unwatch(int key)
+{
+  auto findIt = m_connections.find(key);
+  if (findIt == m_connections.end())
+    return;
+
+  disconnect(findIt.value().m_geometryChanged);
+  disconnect(findIt.value().m_destroyed);
+  m_connections.erase(findIt);
+
+  if (m_pendingKeys.remove(key))
+    m_pending.removeOne(key);
+}
+
+/*!
+  \brief Stops watching all elements and discards any pending changes.
+ */
+void GeoElementChangeAggregator::clear()
+{
+  for (const Connections& connections : qAsConst(m_connections))
+  {
+    disconnect(connections.m_geometryChanged);
+    disconnect(connections.m_destroyed);
+  }
+
+  m_connections.clear();
+  m_pending.clear();
+  m_pendingKeys.clear();
+  m_flushTimer.stop();
+}
+
+/*!
+  \brief Returns whether an element is being watched with \a key.
+ */
+bool GeoElementChangeAggregator::isWatching(int key) const
+{
+  return m_connections.contains(key);
+}
+
+/*!
+  \brief Returns the number of elements being watched.
+ */
+int GeoElementChangeAggregator::watchedCount() const
+{
+  return m_connections.size();
+}
+
+/*!
+  \internal
+ */
+void GeoElementChangeAggregator::markChanged(int key)
+{
+  if (m_pendingKeys.contains(key))
+    return;
+
+  m_pendingKeys.insert(key);
+  m_pending.append(key);
+
+  if (!m_flushTimer.isActive())
+    m_flushTimer.start();
+}
+
+/*!
+  \internal
+
+  Reports the changes which have been collected since the last batch, in the order
+  in which the elements first changed.
+ */
+void GeoElementChangeAggregator::flush()
+{
+  if (m_pending.isEmpty())
+    return;
+
+  QVector<int> keys;
+  keys.swap(m_pending);
+  m_pendingKeys.clear();
+
+  emit geometriesChanged(keys);
+}
+
+// Signal Documentation
+
+/*!
+  \fn void GeoElementChangeAggregator::geometriesChanged(const QVector<int>& keys);
+  \brief Signals that the geometry of the elements with \a keys has changed.
+ */
+
+/*!
+  \fn void GeoElementChangeAggregator::elementDestroyed(int key);
+  \brief Signals that the element with \a key is being destroyed.
+
+  The element is no longer watched and must not be accessed.
+ */
+
+} // Dsa
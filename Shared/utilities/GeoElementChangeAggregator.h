@@ -0,0 +1,74 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef GEOELEMENTCHANGEAGGREGATOR_H
+#define GEOELEMENTCHANGEAGGREGATOR_H
+
+// Qt headers
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QTimer>
+#include <QVector>
+
+namespace Esri {
+namespace ArcGISRuntime {
+class GeoElement;
+}
+}
+
+namespace Dsa {
+
+class GeoElementChangeAggregator : public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit GeoElementChangeAggregator(QObject* parent = nullptr);
+  ~GeoElementChangeAggregator();
+
+  void watch(Esri::ArcGISRuntime::GeoElement* geoElement, int key);
+  void unwatch(int key);
+  void clear();
+
+  bool isWatching(int key) const;
+  int watchedCount() const;
+
+signals:
+  void geometriesChanged(const QVector<int>& keys);
+  void elementDestroyed(int key);
+
+private:
+  Q_DISABLE_COPY(GeoElementChangeAggregator)
+
+  void markChanged(int key);
+  void flush();
+
+  struct Connections
+  {
+    QMetaObject::Connection m_geometryChanged;
+    QMetaObject::Connection m_destroyed;
+  };
+
+  QHash<int, Connections> m_connections;
+  QVector<int> m_pending;
+  QSet<int> m_pendingKeys;
+  QTimer m_flushTimer;
+};
+
+} // Dsa
+
+#endif // GEOELEMENTCHANGEAGGREGATOR_H
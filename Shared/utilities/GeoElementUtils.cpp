@@ -52,40 +52,10 @@ GeoElementSignaler::GeoElementSignaler(GeoElement* geoElement, QObject* parent)
   QObject(parent),
   m_geoElement(geoElement)
 {
-  if (dynamic_cast<Feature*>(m_geoElement))
+  GeoElementUtils::connectGeometryChanged(m_geoElement, this, [this]()
   {
-    connect(static_cast<Feature*>(m_geoElement), &Feature::geometryChanged,
-            this, &GeoElementSignaler::geometryChanged);
-  }
-  else if (dynamic_cast<Graphic*>(m_geoElement))
-  {
-    connect(static_cast<Graphic*>(m_geoElement), &Graphic::geometryChanged,
-            this, &GeoElementSignaler::geometryChanged);
-  }
-  else if (dynamic_cast<KmlPlacemark*>(m_geoElement))
-  {
-    connect(static_cast<KmlPlacemark*>(m_geoElement), &KmlPlacemark::geometryChanged,
-            this, &GeoElementSignaler::geometryChanged);
-  }
-  else if (dynamic_cast<EncFeature*>(m_geoElement))
-  {
-    connect(static_cast<EncFeature*>(m_geoElement), &EncFeature::geometryChanged,
-            this, &GeoElementSignaler::geometryChanged);
-  }
-  else if (dynamic_cast<WmsFeature*>(m_geoElement))
-  {
-    connect(static_cast<WmsFeature*>(m_geoElement), &WmsFeature::geometryChanged,
-            this, &GeoElementSignaler::geometryChanged);
-  }
-  else if (dynamic_cast<RasterCell*>(m_geoElement))
-  {
-    connect(static_cast<RasterCell*>(m_geoElement), &RasterCell::geometryChanged,
-            this, &GeoElementSignaler::geometryChanged);
-  }
-  else
-  {
-    qWarning() << Q_FUNC_INFO << "Unhandled GeoElement type";
-  }
+    emit geometryChanged();
+  });
 }
 
 /*!
@@ -161,4 +131,40 @@ QObject* GeoElementUtils::toQObject(GeoElement* geoElement)
   return nullptr;
 }
 
+/*!
+  \fn QMetaObject::Connection Dsa::GeoElementUtils::connectGeometryChanged(Esri::ArcGISRuntime::GeoElement* geoElement, const QObject* context, std::function<void()> slot)
+  \brief Connects the geometryChanged signal of \a geoElement to \a slot, which is
+  disconnected when \a context is destroyed.
+
+  Unlike \l GeoElementSignaler, no QObject is created for the connection.
+
+  Returns the connection, which is invalid if the type of \a geoElement is not handled.
+ */
+QMetaObject::Connection GeoElementUtils::connectGeometryChanged(GeoElement* geoElement,
+                                                                const QObject* context,
+                                                                std::function<void()> slot)
+{
+  if (dynamic_cast<Feature*>(geoElement))
+    return QObject::connect(static_cast<Feature*>(geoElement), &Feature::geometryChanged, context, slot);
+
+  if (dynamic_cast<Graphic*>(geoElement))
+    return QObject::connect(static_cast<Graphic*>(geoElement), &Graphic::geometryChanged, context, slot);
+
+  if (dynamic_cast<KmlPlacemark*>(geoElement))
+    return QObject::connect(static_cast<KmlPlacemark*>(geoElement), &KmlPlacemark::geometryChanged, context, slot);
+
+  if (dynamic_cast<EncFeature*>(geoElement))
+    return QObject::connect(static_cast<EncFeature*>(geoElement), &EncFeature::geometryChanged, context, slot);
+
+  if (dynamic_cast<WmsFeature*>(geoElement))
+    return QObject::connect(static_cast<WmsFeature*>(geoElement), &WmsFeature::geometryChanged, context, slot);
+
+  if (dynamic_cast<RasterCell*>(geoElement))
+    return QObject::connect(static_cast<RasterCell*>(geoElement), &RasterCell::geometryChanged, context, slot);
+
+  qWarning() << Q_FUNC_INFO << "Unhandled GeoElement type";
+
+  return QMetaObject::Connection();
+}
+
 } // Dsa
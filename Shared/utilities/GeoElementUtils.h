@@ -21,6 +21,9 @@
 #include <QList>
 #include <QObject>
 
+// STL headers
+#include <functional>
+
 namespace Esri {
 namespace ArcGISRuntime {
   class GeoElement;
@@ -51,6 +54,9 @@ namespace GeoElementUtils
   void setParent(const QList<Esri::ArcGISRuntime::GeoElement*>& geoElements, QObject* parent);
   void setParent(Esri::ArcGISRuntime::GeoElement* geoElement, QObject* parent);
   QObject* toQObject(Esri::ArcGISRuntime::GeoElement* geoElement);
+  QMetaObject::Connection connectGeometryChanged(Esri::ArcGISRuntime::GeoElement* geoElement,
+                                                 const QObject* context,
+                                                 std::function<void()> slot);
 }
 
 } // Dsa
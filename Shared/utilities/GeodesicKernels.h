@@ -0,0 +1,352 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef GEODESICKERNELS_H
+#define GEODESICKERNELS_H
+
+// STL headers
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+// the envelope mask kernel uses the vector registers which every target of the app has:
+// SSE2 on x86-64 vehicle systems and NEON on 64-bit ARM handhelds
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DSA_GEODESIC_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define DSA_GEODESIC_NEON
+#include <arm_neon.h>
+#endif
+
+namespace Dsa {
+namespace Geodesic {
+
+// Closed-form distance and direction kernels for WGS84 locations given in degrees.
+// They are a fast path for point-to-point tests which would otherwise go through
+// GeometryEngine::distanceGeodetic, moveGeodetic or bufferGeodetic.
+//
+// The batch forms work over contiguous latitude and longitude arrays and have no
+// branches in their loop bodies, so that the compiler can vectorize them.
+
+// mean radius of the earth in meters
+constexpr double s_earthRadius = 6371008.8;
+
+// WGS84 ellipsoid
+constexpr double s_semiMajorAxis = 6378137.0;
+constexpr double s_flattening = 1.0 / 298.257223563;
+constexpr double s_semiMinorAxis = s_semiMajorAxis * (1.0 - s_flattening);
+
+constexpr double s_pi = 3.14159265358979323846;
+constexpr double s_degreesToRadians = s_pi / 180.0;
+constexpr double s_radiansToDegrees = 180.0 / s_pi;
+
+// the length of a degree of latitude in meters, for converting small offsets
+constexpr double s_metersPerDegree = 111320.0;
+
+// the number of iterations after which Vincenty's formula is treated as not converging,
+// which only happens for nearly antipodal locations
+constexpr int s_maxVincentyIterations = 100;
+constexpr double s_vincentyTolerance = 1e-12;
+
+// returns the haversine term for the two locations, which increases with the distance between them
+inline double haversineTerm(double lat1, double lon1, double lat2, double lon2)
+{
+  const double phi1 = lat1 * s_degreesToRadians;
+  const double phi2 = lat2 * s_degreesToRadians;
+  const double sinHalfLat = std::sin((phi2 - phi1) * 0.5);
+  const double sinHalfLon = std::sin((lon2 - lon1) * s_degreesToRadians * 0.5);
+  return (sinHalfLat * sinHalfLat) + (std::cos(phi1) * std::cos(phi2) * sinHalfLon * sinHalfLon);
+}
+
+// returns the haversine term of the given distance in meters, for comparison with haversineTerm
+inline double haversineTermForDistance(double meters)
+{
+  const double sinHalfAngle = std::sin(std::min(s_pi, meters / s_earthRadius) * 0.5);
+  return sinHalfAngle * sinHalfAngle;
+}
+
+// returns the great-circle distance in meters between two locations on the mean sphere
+inline double haversineDistance(double lat1, double lon1, double lat2, double lon2)
+{
+  const double a = haversineTerm(lat1, lon1, lat2, lon2);
+  return 2.0 * s_earthRadius * std::asin(std::min(1.0, std::sqrt(a)));
+}
+
+// returns the geodesic distance in meters between two locations on the WGS84 ellipsoid,
+// using Vincenty's inverse formula. Falls back to the haversine distance when the
+// formula does not converge
+inline double vincentyDistance(double lat1, double lon1, double lat2, double lon2)
+{
+  const double u1 = std::atan((1.0 - s_flattening) * std::tan(lat1 * s_degreesToRadians));
+  const double u2 = std::atan((1.0 - s_flattening) * std::tan(lat2 * s_degreesToRadians));
+  const double sinU1 = std::sin(u1);
+  const double cosU1 = std::cos(u1);
+  const double sinU2 = std::sin(u2);
+  const double cosU2 = std::cos(u2);
+  const double l = (lon2 - lon1) * s_degreesToRadians;
+
+  double lambda = l;
+  for (int i = 0; i < s_maxVincentyIterations; ++i)
+  {
+    const double sinLambda = std::sin(lambda);
+    const double cosLambda = std::cos(lambda);
+    const double crossTerm = (cosU1 * sinU2) - (sinU1 * cosU2 * cosLambda);
+    const double sinSigma = std::sqrt((cosU2 * sinLambda * cosU2 * sinLambda) + (crossTerm * crossTerm));
+    if (sinSigma == 0.0)
+      return 0.0; // coincident locations
+
+    const double cosSigma = (sinU1 * sinU2) + (cosU1 * cosU2 * cosLambda);
+    const double sigma = std::atan2(sinSigma, cosSigma);
+    const double sinAlpha = cosU1 * cosU2 * sinLambda / sinSigma;
+    const double cosSqAlpha = 1.0 - (sinAlpha * sinAlpha);
+
+    // the geodesic lies on the equator when cosSqAlpha is 0
+    const double cos2SigmaM = cosSqAlpha != 0.0 ? cosSigma - (2.0 * sinU1 * sinU2 / cosSqAlpha) : 0.0;
+    const double c = s_flattening / 16.0 * cosSqAlpha * (4.0 + (s_flattening * (4.0 - (3.0 * cosSqAlpha))));
+    const double previousLambda = lambda;
+    lambda = l + ((1.0 - c) * s_flattening * sinAlpha *
+                  (sigma + (c * sinSigma * (cos2SigmaM + (c * cosSigma * (-1.0 + (2.0 * cos2SigmaM * cos2SigmaM)))))));
+
+    if (std::abs(lambda - previousLambda) > s_vincentyTolerance)
+      continue;
+
+    const double uSq = cosSqAlpha * ((s_semiMajorAxis * s_semiMajorAxis) - (s_semiMinorAxis * s_semiMinorAxis)) /
+                       (s_semiMinorAxis * s_semiMinorAxis);
+    const double a = 1.0 + (uSq / 16384.0 * (4096.0 + (uSq * (-768.0 + (uSq * (320.0 - (175.0 * uSq)))))));
+    const double b = uSq / 1024.0 * (256.0 + (uSq * (-128.0 + (uSq * (74.0 - (47.0 * uSq))))));
+    const double deltaSigma = b * sinSigma *
+                              (cos2SigmaM + (b / 4.0 * ((cosSigma * (-1.0 + (2.0 * cos2SigmaM * cos2SigmaM))) -
+                                                        (b / 6.0 * cos2SigmaM * (-3.0 + (4.0 * sinSigma * sinSigma)) *
+                                                         (-3.0 + (4.0 * cos2SigmaM * cos2SigmaM))))));
+    return s_semiMinorAxis * a * (sigma - deltaSigma);
+  }
+
+  return haversineDistance(lat1, lon1, lat2, lon2);
+}
+
+// returns the initial great-circle bearing in degrees clockwise from north, in the
+// range [0, 360), from the first location towards the second
+inline double initialBearing(double lat1, double lon1, double lat2, double lon2)
+{
+  const double phi1 = lat1 * s_degreesToRadians;
+  const double phi2 = lat2 * s_degreesToRadians;
+  const double deltaLon = (lon2 - lon1) * s_degreesToRadians;
+  const double y = std::sin(deltaLon) * std::cos(phi2);
+  const double x = (std::cos(phi1) * std::sin(phi2)) - (std::sin(phi1) * std::cos(phi2) * std::cos(deltaLon));
+  const double bearing = std::atan2(y, x) * s_radiansToDegrees;
+  return std::fmod(bearing + 360.0, 360.0);
+}
+
+// sets lat2 and lon2 to the location reached by travelling meters from the given location
+// along the great circle with the initial bearing in degrees clockwise from north.
+// The longitude is normalized to the range [-180, 180)
+inline void destinationPoint(double lat1, double lon1, double bearing, double meters, double& lat2, double& lon2)
+{
+  const double phi1 = lat1 * s_degreesToRadians;
+  const double theta = bearing * s_degreesToRadians;
+  const double delta = meters / s_earthRadius;
+  const double sinPhi1 = std::sin(phi1);
+  const double cosPhi1 = std::cos(phi1);
+  const double sinDelta = std::sin(delta);
+  const double cosDelta = std::cos(delta);
+
+  const double sinPhi2 = std::max(-1.0, std::min(1.0, (sinPhi1 * cosDelta) + (cosPhi1 * sinDelta * std::cos(theta))));
+  const double phi2 = std::asin(sinPhi2);
+  const double lambda = std::atan2(std::sin(theta) * sinDelta * cosPhi1, cosDelta - (sinPhi1 * sinPhi2));
+
+  lat2 = phi2 * s_radiansToDegrees;
+  lon2 = std::fmod(lon1 + (lambda * s_radiansToDegrees) + 540.0, 360.0) - 180.0;
+}
+
+// writes the haversine distance from the location to each of the count locations in the
+// lats and lons arrays into distances
+inline void haversineDistances(double lat, double lon, const double* lats, const double* lons,
+                               std::size_t count, double* distances)
+{
+  for (std::size_t i = 0; i < count; ++i)
+    distances[i] = haversineDistance(lat, lon, lats[i], lons[i]);
+}
+
+// writes the initial bearing from the location to each of the count locations in the
+// lats and lons arrays into bearings
+inline void initialBearings(double lat, double lon, const double* lats, const double* lons,
+                            std::size_t count, double* bearings)
+{
+  for (std::size_t i = 0; i < count; ++i)
+    bearings[i] = initialBearing(lat, lon, lats[i], lons[i]);
+}
+
+// writes the destination of each of the count locations in the lats and lons arrays, moved
+// meters along the bearing, into destLats and destLons
+inline void destinationPoints(const double* lats, const double* lons, std::size_t count, double bearing,
+                              double meters, double* destLats, double* destLons)
+{
+  for (std::size_t i = 0; i < count; ++i)
+    destinationPoint(lats[i], lons[i], bearing, meters, destLats[i], destLons[i]);
+}
+
+// returns whether any of the count locations in the lats and lons arrays lies within
+// meters of the location on the mean sphere. The haversine terms are compared directly,
+// so no inverse trigonometry is evaluated per location. The locations are tested in
+// fixed-size blocks, which are accumulated without branching
+inline bool anyWithinDistance(double lat, double lon, const double* lats, const double* lons,
+                              std::size_t count, double meters)
+{
+  if (meters < 0.0)
+    return false;
+
+  constexpr std::size_t blockSize = 8;
+  const double threshold = haversineTermForDistance(meters);
+  const double phi = lat * s_degreesToRadians;
+  const double cosPhi = std::cos(phi);
+
+  std::size_t i = 0;
+  for (; i + blockSize <= count; i += blockSize)
+  {
+    int matches = 0;
+    for (std::size_t j = i; j < i + blockSize; ++j)
+    {
+      const double phi2 = lats[j] * s_degreesToRadians;
+      const double sinHalfLat = std::sin((phi2 - phi) * 0.5);
+      const double sinHalfLon = std::sin((lons[j] - lon) * s_degreesToRadians * 0.5);
+      const double a = (sinHalfLat * sinHalfLat) + (cosPhi * std::cos(phi2) * sinHalfLon * sinHalfLon);
+      matches += a <= threshold ? 1 : 0;
+    }
+
+    if (matches > 0)
+      return true;
+  }
+
+  for (; i < count; ++i)
+  {
+    if (haversineTerm(lat, lon, lats[i], lons[i]) <= threshold)
+      return true;
+  }
+
+  return false;
+}
+
+// sets each of the count entries of mask to 1 if the location in the lats and lons arrays
+// lies within the envelope, edges included, and to 0 otherwise. Returns the number of
+// locations within it. The envelope must not cross the antimeridian. Two locations are
+// tested at a time with SSE2 or NEON where available, with a scalar loop for the rest
+inline std::size_t withinEnvelopeMask(const double* lats, const double* lons, std::size_t count,
+                                      double south, double west, double north, double east,
+                                      unsigned char* mask)
+{
+  std::size_t hits = 0;
+  std::size_t i = 0;
+
+#if defined(DSA_GEODESIC_SSE2)
+  const __m128d southValues = _mm_set1_pd(south);
+  const __m128d westValues = _mm_set1_pd(west);
+  const __m128d northValues = _mm_set1_pd(north);
+  const __m128d eastValues = _mm_set1_pd(east);
+  for (; i + 2 <= count; i += 2)
+  {
+    const __m128d latValues = _mm_loadu_pd(lats + i);
+    const __m128d lonValues = _mm_loadu_pd(lons + i);
+    const __m128d inside = _mm_and_pd(_mm_and_pd(_mm_cmpge_pd(latValues, southValues), _mm_cmple_pd(latValues, northValues)),
+                                      _mm_and_pd(_mm_cmpge_pd(lonValues, westValues), _mm_cmple_pd(lonValues, eastValues)));
+    const int bits = _mm_movemask_pd(inside);
+    mask[i] = static_cast<unsigned char>(bits & 1);
+    mask[i + 1] = static_cast<unsigned char>((bits >> 1) & 1);
+    hits += mask[i] + mask[i + 1];
+  }
+#elif defined(DSA_GEODESIC_NEON)
+  const float64x2_t southValues = vdupq_n_f64(south);
+  const float64x2_t westValues = vdupq_n_f64(west);
+  const float64x2_t northValues = vdupq_n_f64(north);
+  const float64x2_t eastValues = vdupq_n_f64(east);
+  for (; i + 2 <= count; i += 2)
+  {
+    const float64x2_t latValues = vld1q_f64(lats + i);
+    const float64x2_t lonValues = vld1q_f64(lons + i);
+    const uint64x2_t inside = vandq_u64(vandq_u64(vcgeq_f64(latValues, southValues), vcleq_f64(latValues, northValues)),
+                                        vandq_u64(vcgeq_f64(lonValues, westValues), vcleq_f64(lonValues, eastValues)));
+    mask[i] = static_cast<unsigned char>(vgetq_lane_u64(inside, 0) & 1);
+    mask[i + 1] = static_cast<unsigned char>(vgetq_lane_u64(inside, 1) & 1);
+    hits += mask[i] + mask[i + 1];
+  }
+#endif
+
+  for (; i < count; ++i)
+  {
+    const bool inside = lats[i] >= south && lats[i] <= north && lons[i] >= west && lons[i] <= east;
+    mask[i] = inside ? 1 : 0;
+    hits += mask[i];
+  }
+
+  return hits;
+}
+
+// sets each of the count entries of mask to 1 if the location in the lats and lons arrays
+// lies within meters of the location on the mean sphere, and to 0 otherwise. Returns the
+// number of locations within the distance. The locations are first tested against the
+// bounding envelope of the distance with withinEnvelopeMask, so the haversine term is only
+// evaluated for those inside it. When the envelope would reach a pole or cross the
+// antimeridian every location is tested by distance
+inline std::size_t withinDistanceMask(double lat, double lon, const double* lats, const double* lons,
+                                      std::size_t count, double meters, unsigned char* mask)
+{
+  if (meters < 0.0)
+  {
+    std::fill(mask, mask + count, static_cast<unsigned char>(0));
+    return 0;
+  }
+
+  const double angle = std::min(s_pi, meters / s_earthRadius);
+  const double latDelta = angle * s_radiansToDegrees;
+  const double sinLonDelta = std::sin(angle) / std::cos(lat * s_degreesToRadians);
+
+  std::size_t hits = count;
+  if (angle < s_pi * 0.5 && std::abs(lat) + latDelta < 90.0 && sinLonDelta < 1.0)
+  {
+    // a small margin keeps rounding from excluding locations on the edge of the distance
+    const double margin = 1e-9;
+    const double lonDelta = std::asin(sinLonDelta) * s_radiansToDegrees + margin;
+    if (lon - lonDelta >= -180.0 && lon + lonDelta <= 180.0)
+      hits = withinEnvelopeMask(lats, lons, count, lat - latDelta - margin, lon - lonDelta, lat + latDelta + margin, lon + lonDelta, mask);
+    else
+      std::fill(mask, mask + count, static_cast<unsigned char>(1));
+  }
+  else
+  {
+    std::fill(mask, mask + count, static_cast<unsigned char>(1));
+  }
+
+  if (hits == 0)
+    return 0;
+
+  const double threshold = haversineTermForDistance(meters);
+  hits = 0;
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    if (mask[i] == 0)
+      continue;
+
+    mask[i] = haversineTerm(lat, lon, lats[i], lons[i]) <= threshold ? 1 : 0;
+    hits += mask[i];
+  }
+
+  return hits;
+}
+
+} // Geodesic
+} // Dsa
+
+#endif // GEODESICKERNELS_H
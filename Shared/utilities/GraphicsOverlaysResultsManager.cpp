@@ -41,6 +41,15 @@ GraphicsOverlaysResultsManager::GraphicsOverlaysResultsManager(const QList<Esri:
 
 }
 
+/*!
+  \brief Constructor taking ownership of the list of \l Esri::ArcGISRuntime::IdentifyGraphicsOverlayResult \a results,
+  without copying it.
+ */
+GraphicsOverlaysResultsManager::GraphicsOverlaysResultsManager(QList<Esri::ArcGISRuntime::IdentifyGraphicsOverlayResult*>&& results):
+  m_results(std::move(results))
+{
+}
+
 /*!
   \brief Destructor.
  */
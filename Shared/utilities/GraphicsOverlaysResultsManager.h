@@ -33,6 +33,7 @@ struct GraphicsOverlaysResultsManager {
   QList<Esri::ArcGISRuntime::IdentifyGraphicsOverlayResult*> m_results;
 
   explicit GraphicsOverlaysResultsManager(const QList<Esri::ArcGISRuntime::IdentifyGraphicsOverlayResult*>& results);
+  explicit GraphicsOverlaysResultsManager(QList<Esri::ArcGISRuntime::IdentifyGraphicsOverlayResult*>&& results);
 
   ~GraphicsOverlaysResultsManager();
 };
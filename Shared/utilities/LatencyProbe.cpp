@@ -0,0 +1,182 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#include "LatencyProbe.h"
+
+// Qt headers
+#include <QDateTime>
+#include <QUuid>
+
+namespace Dsa {
+
+namespace {
+const char s_probeStart[] = "<!--dsa-probe ";
+constexpr int s_probeStartSize = sizeof(s_probeStart) - 1;
+const char s_probeEnd[] = "-->";
+constexpr int s_probeEndSize = sizeof(s_probeEnd) - 1;
+
+// returns the value of the attribute name="value" between from and to, or a null array
+QByteArray attributeValue(const QByteArray& data, int from, int to, const char* name)
+{
+  const QByteArray key = QByteArray(" ") + name + "=\"";
+  const int keyPos = data.indexOf(key, from - 1);
+  if (keyPos == -1 || keyPos >= to)
+    return QByteArray();
+
+  const int valueStart = keyPos + key.size();
+  const int valueEnd = data.indexOf('"', valueStart);
+  if (valueEnd == -1 || valueEnd > to)
+    return QByteArray();
+
+  return data.mid(valueStart, valueEnd - valueStart);
+}
+}
+
+/*!
+  \class Dsa::LatencyProbe
+  \inmodule Dsa
+  \brief Stamps outbound messages with their send time and a sequence number, so
+  that receivers can measure the latency of the whole pipeline.
+
+  The stamp is appended to an XML message as a trailing comment:
+
+  \code
+  <!--dsa-probe src="1f0e6c2a" seq="42" sent="1760000000000"-->
+  \endcode
+
+  XML parsers, including those of other receivers, ignore the comment, so a stamped
+  message remains a valid CoT or GeoMessage. The \c src identifies the sender, whose
+  sequence numbers start at \c 0 and increase by one with each stamped message; gaps
+  and reordering in them show loss and out of order delivery. The \c sent time is in
+  msecs since the epoch, so latencies measured across devices include the difference
+  of their clocks.
+
+  Binary encodings, such as the compact and TAK formats, are not stamped.
+ */
+
+/*!
+  \brief Constructor for a probe with a random source.
+ */
+LatencyProbe::LatencyProbe() :
+  m_source(QUuid::createUuid().toByteArray(QUuid::WithoutBraces).left(8))
+{
+}
+
+/*!
+  \brief Constructor for a probe identified by \a source, which must not contain
+  quotes or spaces.
+ */
+LatencyProbe::LatencyProbe(const QByteArray& source) :
+  m_source(source)
+{
+}
+
+/*!
+  \brief Destructor.
+ */
+LatencyProbe::~LatencyProbe()
+{
+}
+
+/*!
+  \brief Returns the source which identifies the stamps of this probe.
+ */
+QByteArray LatencyProbe::source() const
+{
+  return m_source;
+}
+
+/*!
+  \brief Returns the sequence number of the next stamp.
+ */
+quint32 LatencyProbe::nextSequence() const
+{
+  return m_sequence;
+}
+
+/*!
+  \brief Appends a stamp with the current time and the next sequence number to \a data.
+
+  Nothing is appended if the \a data cannot be stamped.
+
+  \sa canStamp
+ */
+void LatencyProbe::stamp(QByteArray& data)
+{
+  if (!canStamp(data))
+    return;
+
+  data.reserve(data.size() + s_probeStartSize + m_source.size() + 48);
+  data.append(s_probeStart)
+      .append("src=\"").append(m_source)
+      .append("\" seq=\"").append(QByteArray::number(m_sequence++))
+      .append("\" sent=\"").append(QByteArray::number(currentTime()))
+      .append('"').append(s_probeEnd);
+}
+
+/*!
+  \brief Returns whether \a data is an XML message which can carry a stamp.
+ */
+bool LatencyProbe::canStamp(const QByteArray& data)
+{
+  int end = data.size();
+  while (end > 0 && (data.at(end - 1) == '\n' || data.at(end - 1) == '\r' || data.at(end - 1) == ' '))
+    --end;
+
+  return end > 0 && data.at(0) == '<' && data.at(end - 1) == '>';
+}
+
+/*!
+  \brief Reads the stamp at the end of \a data into \a stamp.
+
+  Returns \c false if \a data is not stamped. Unstamped messages are rejected
+  after checking their last few bytes.
+ */
+bool LatencyProbe::read(const QByteArray& data, Stamp& stamp)
+{
+  if (!data.endsWith(s_probeEnd))
+    return false;
+
+  const int start = data.lastIndexOf(s_probeStart);
+  if (start == -1)
+    return false;
+
+  const int from = start + s_probeStartSize;
+  const int to = data.size() - s_probeEndSize;
+
+  bool sequenceOk = false;
+  bool sentOk = false;
+  stamp.m_source = attributeValue(data, from, to, "src");
+  stamp.m_sequence = attributeValue(data, from, to, "seq").toUInt(&sequenceOk);
+  stamp.m_sentTime = attributeValue(data, from, to, "sent").toLongLong(&sentOk);
+  if (stamp.m_source.isEmpty() || !sequenceOk || !sentOk)
+  {
+    stamp = Stamp();
+    return false;
+  }
+
+  return true;
+}
+
+/*!
+  \brief Returns the current time, in msecs since the epoch, used by the stamps.
+ */
+qint64 LatencyProbe::currentTime()
+{
+  return QDateTime::currentMSecsSinceEpoch();
+}
+
+} // Dsa
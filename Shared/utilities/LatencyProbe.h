@@ -0,0 +1,57 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef LATENCYPROBE_H
+#define LATENCYPROBE_H
+
+// Qt headers
+#include <QByteArray>
+
+namespace Dsa {
+
+class LatencyProbe
+{
+public:
+  struct Stamp
+  {
+    QByteArray m_source;
+    quint32 m_sequence = 0;
+    qint64 m_sentTime = 0; // in msecs since the epoch
+
+    bool isValid() const { return !m_source.isEmpty(); }
+  };
+
+  LatencyProbe();
+  explicit LatencyProbe(const QByteArray& source);
+  ~LatencyProbe();
+
+  QByteArray source() const;
+  quint32 nextSequence() const;
+
+  void stamp(QByteArray& data);
+
+  static bool canStamp(const QByteArray& data);
+  static bool read(const QByteArray& data, Stamp& stamp);
+  static qint64 currentTime();
+
+private:
+  QByteArray m_source;
+  quint32 m_sequence = 0;
+};
+
+} // Dsa
+
+#endif // LATENCYPROBE_H
@@ -41,6 +41,15 @@ LayerResultsManager::LayerResultsManager(const QList<Esri::ArcGISRuntime::Identi
 
 }
 
+/*!
+  \brief Constructor taking ownership of the list of \l Esri::ArcGISRuntime::IdentifyLayerResult \a results,
+  without copying it.
+ */
+LayerResultsManager::LayerResultsManager(QList<Esri::ArcGISRuntime::IdentifyLayerResult*>&& results):
+  m_results(std::move(results))
+{
+}
+
 /*!
   \brief Destructor.
  */
@@ -33,6 +33,7 @@ struct LayerResultsManager {
   QList<Esri::ArcGISRuntime::IdentifyLayerResult*> m_results;
 
   explicit LayerResultsManager(const QList<Esri::ArcGISRuntime::IdentifyLayerResult*>& results);
+  explicit LayerResultsManager(QList<Esri::ArcGISRuntime::IdentifyLayerResult*>&& results);
   ~LayerResultsManager();
 };
 
@@ -0,0 +1,361 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "OutboundTransport.h"
+
+// Qt headers
+#include <QIODevice>
+#include <QThread>
+#include <QTimer>
+#include <QtMath>
+
+namespace Dsa {
+
+// the wait before a retry doubles with each attempt, up to this many times the retry interval
+static const int s_maxRetryBackoff = 8;
+
+// a rate-limited link may send this much of its rate at once after standing idle
+static const double s_burstSeconds = 0.5;
+
+// the bucket always holds at least one full-size datagram, in bytes
+static const int s_minimumBurst = 1500;
+
+namespace
+{
+double burstSize(int sendRate)
+{
+  return qMax(sendRate * s_burstSeconds, static_cast<double>(s_minimumBurst));
+}
+
+QString sequenceKey(const QString& coalesceKey, quint16 port)
+{
+  return QString::number(port) + QLatin1Char('|') + coalesceKey;
+}
+}
+
+/*!
+  \class Dsa::OutboundTransport
+  \inmodule Dsa
+  \inherits QObject
+  \brief Schedules outgoing datagrams and sends them through long-lived sockets
+  on a background thread.
+
+  Callers hand a payload, the \l UdpTransport and the port to \l send and
+  return immediately. Sends are written on a dedicated worker thread,
+  through one socket per destination which is created on first use and then
+  kept, so reports and markups no longer set up a socket of their own.
+
+  Sends are queued per link, the network destination shared by every port of
+  a transport, and leave in \l Priority order: a distress call goes ahead of
+  reports, routine position updates and bulk markup transfers. A link whose
+  transport has a \l {UdpTransport::sendRate}{sendRate} is capped by a token
+  bucket, so a constrained radio is never handed more than it can carry and
+  lower classes wait rather than starving higher ones. While a send waits,
+  a newer one with the same \l {SendOptions}{coalesce key}, such as the next
+  location update of the same track, replaces it.
+
+  The feeds have no acknowledgement, so delivery is made more reliable with
+  \l SendOptions: a failed write is retried with a growing wait, on a fresh
+  socket in case the network changed, and a successful one can be
+  repeated for teammates who may have missed it. Receivers already drop
+  duplicate messages. Once the retries are exhausted, \l sendFailed is
+  emitted.
+ */
+
+/*!
+  \brief Returns the process-wide outbound transport.
+ */
+OutboundTransport* OutboundTransport::instance()
+{
+  static OutboundTransport s_instance;
+  return &s_instance;
+}
+
+/*!
+  \internal
+  \brief Constructor taking an optional \a parent.
+
+  The worker thread is started immediately.
+ */
+OutboundTransport::OutboundTransport(QObject* parent) :
+  QObject(parent),
+  m_thread(new QThread(this)),
+  m_worker(new QObject())
+{
+  // the timer moves to the worker thread with its parent
+  m_drainTimer = new QTimer(m_worker);
+  m_drainTimer->setSingleShot(true);
+  connect(m_drainTimer, &QTimer::timeout, m_worker, [this]
+  {
+    drain();
+  });
+
+  m_clock.start();
+
+  m_thread->setObjectName(QStringLiteral("OutboundTransport"));
+  m_worker->moveToThread(m_thread);
+  m_thread->start();
+}
+
+/*!
+  \brief Destructor.
+
+  Stops the worker thread. Sends which are still queued are discarded.
+ */
+OutboundTransport::~OutboundTransport()
+{
+  m_thread->quit();
+  m_thread->wait();
+
+  // the sockets and the drain timer are children of the worker
+  delete m_worker;
+}
+
+/*!
+  \brief Queues \a data to be sent on \a port with \a transport, using \a options.
+
+  This returns immediately; the socket is created and written on the worker thread.
+ */
+void OutboundTransport::send(const UdpTransport& transport, quint16 port, const QByteArray& data,
+                             const SendOptions& options)
+{
+  PendingSend pending;
+  pending.m_transport = transport;
+  pending.m_port = port;
+  pending.m_data = data;
+  pending.m_options = options;
+  pending.m_sequence = m_sequence.fetch_add(1, std::memory_order_relaxed) + 1;
+  pending.m_repeatsLeft = options.m_repeats;
+
+  QMetaObject::invokeMethod(m_worker, [this, pending]
+  {
+    enqueue(pending);
+  }, Qt::QueuedConnection);
+}
+
+/*!
+  \brief Returns the number of datagrams written, including repeats.
+ */
+qint64 OutboundTransport::sentCount() const
+{
+  return m_sentCount.load(std::memory_order_relaxed);
+}
+
+/*!
+  \brief Returns the number of sends given up after all retries failed.
+ */
+qint64 OutboundTransport::failedCount() const
+{
+  return m_failedCount.load(std::memory_order_relaxed);
+}
+
+/*!
+  \brief Returns the number of sends dropped because a newer one with the
+  same coalesce key superseded them.
+ */
+qint64 OutboundTransport::coalescedCount() const
+{
+  return m_coalescedCount.load(std::memory_order_relaxed);
+}
+
+/*!
+  \internal
+  \brief Queues \a pending on its link on the worker thread, replacing or
+  dropping a send it supersedes or is superseded by, then sends what the link allows.
+ */
+void OutboundTransport::enqueue(const PendingSend& pending)
+{
+  const QString linkKey = pending.m_transport.linkKey();
+  auto linkIt = m_links.find(linkKey);
+  if (linkIt == m_links.end())
+  {
+    linkIt = m_links.insert(linkKey, Link());
+    linkIt->m_tokens = burstSize(pending.m_transport.sendRate());
+    linkIt->m_refillTimestamp = m_clock.elapsed();
+  }
+
+  Link& link = linkIt.value();
+  const QString& coalesceKey = pending.m_options.m_coalesceKey;
+  if (!coalesceKey.isEmpty())
+  {
+    // a retry or repeat which a newer send has already overtaken would undo it
+    if (pending.m_sequence < link.m_sentSequences.value(sequenceKey(coalesceKey, pending.m_port)))
+    {
+      m_coalescedCount.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+
+    // the older of two queued sends is dropped, even across priorities
+    for (QList<PendingSend>& queue : link.m_queues)
+    {
+      for (int i = 0; i < queue.size(); ++i)
+      {
+        const PendingSend& queued = queue.at(i);
+        if (queued.m_port != pending.m_port || queued.m_options.m_coalesceKey != coalesceKey)
+          continue;
+
+        m_coalescedCount.fetch_add(1, std::memory_order_relaxed);
+        if (queued.m_sequence > pending.m_sequence)
+          return;
+
+        queue.removeAt(i);
+        break;
+      }
+    }
+  }
+
+  link.m_queues[static_cast<int>(pending.m_options.m_priority)].append(pending);
+  drain();
+}
+
+/*!
+  \internal
+  \brief Sends the queued datagrams of every link in priority order, as far
+  as each link's token bucket allows, and sets the timer for the rest.
+ */
+void OutboundTransport::drain()
+{
+  const qint64 now = m_clock.elapsed();
+  qint64 nextDrain = -1;
+
+  for (Link& link : m_links)
+  {
+    for (int priority = 0; priority < s_priorityCount; )
+    {
+      QList<PendingSend>& queue = link.m_queues[priority];
+      if (queue.isEmpty())
+      {
+        ++priority;
+        continue;
+      }
+
+      const PendingSend& next = queue.first();
+      const int sendRate = next.m_transport.sendRate();
+      if (sendRate > 0)
+      {
+        const double burst = burstSize(sendRate);
+        link.m_tokens = qMin(burst, link.m_tokens + (now - link.m_refillTimestamp) * sendRate / 1000.0);
+        link.m_refillTimestamp = now;
+
+        // an oversized datagram is let through with a full bucket and paid off afterwards
+        const double needed = qMin(static_cast<double>(next.m_data.size()), burst);
+        if (link.m_tokens < needed)
+        {
+          const qint64 wait = qCeil((needed - link.m_tokens) * 1000.0 / sendRate);
+          nextDrain = nextDrain < 0 ? wait : qMin(nextDrain, wait);
+          break;
+        }
+
+        link.m_tokens -= next.m_data.size();
+      }
+
+      PendingSend pending = queue.takeFirst();
+      if (!pending.m_options.m_coalesceKey.isEmpty())
+        link.m_sentSequences.insert(sequenceKey(pending.m_options.m_coalesceKey, pending.m_port), pending.m_sequence);
+
+      write(pending);
+    }
+  }
+
+  if (nextDrain >= 0 && (!m_drainTimer->isActive() || m_drainTimer->remainingTime() > nextDrain))
+    m_drainTimer->start(static_cast<int>(nextDrain));
+}
+
+/*!
+  \internal
+  \brief Writes \a pending on the worker thread, then schedules its retry or repeat.
+ */
+void OutboundTransport::write(PendingSend pending)
+{
+  QIODevice* sender = device(pending);
+  const bool written = sender && sender->write(pending.m_data) != -1;
+
+  if (written)
+  {
+    m_sentCount.fetch_add(1, std::memory_order_relaxed);
+    if (pending.m_repeatsLeft <= 0)
+      return;
+
+    --pending.m_repeatsLeft;
+    pending.m_attempt = 0;
+    QTimer::singleShot(pending.m_options.m_repeatInterval, m_worker, [this, pending]
+    {
+      enqueue(pending);
+    });
+    return;
+  }
+
+  // the socket may be stale after a network change, so the next attempt starts afresh
+  dropDevice(pending);
+
+  if (pending.m_attempt >= pending.m_options.m_retries)
+  {
+    m_failedCount.fetch_add(1, std::memory_order_relaxed);
+    const quint16 port = pending.m_port;
+    const QByteArray data = pending.m_data;
+    QMetaObject::invokeMethod(this, [this, port, data]
+    {
+      emit sendFailed(port, data);
+    }, Qt::QueuedConnection);
+    return;
+  }
+
+  const int backoff = qMin(1 << qMin(pending.m_attempt, 16), s_maxRetryBackoff);
+  const int wait = pending.m_options.m_retryInterval * backoff;
+  ++pending.m_attempt;
+  QTimer::singleShot(wait, m_worker, [this, pending]
+  {
+    enqueue(pending);
+  });
+}
+
+/*!
+  \internal
+  \brief Returns the socket for the destination of \a pending, creating it on first use.
+ */
+QIODevice* OutboundTransport::device(const PendingSend& pending)
+{
+  const QString key = pending.m_transport.senderKey(pending.m_port);
+  auto it = m_devices.find(key);
+  if (it != m_devices.end())
+    return it.value();
+
+  QIODevice* sender = pending.m_transport.createSender(pending.m_port, m_worker);
+  m_devices.insert(key, sender);
+  return sender;
+}
+
+/*!
+  \internal
+  \brief Discards the socket for the destination of \a pending.
+ */
+void OutboundTransport::dropDevice(const PendingSend& pending)
+{
+  QIODevice* sender = m_devices.take(pending.m_transport.senderKey(pending.m_port));
+  if (sender)
+    sender->deleteLater();
+}
+
+} // Dsa
+
+// Signal Documentation
+/*!
+  \fn void OutboundTransport::sendFailed(quint16 port, const QByteArray& data);
+  \brief Signal emitted when \a data could not be sent on \a port after all retries.
+ */
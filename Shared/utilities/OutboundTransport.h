@@ -0,0 +1,131 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef OUTBOUNDTRANSPORT_H
+#define OUTBOUNDTRANSPORT_H
+
+// dsa app headers
+#include "UdpTransport.h"
+
+// Qt headers
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QObject>
+
+// STL headers
+#include <atomic>
+
+class QIODevice;
+class QThread;
+class QTimer;
+
+namespace Dsa {
+
+class OutboundTransport : public QObject
+{
+  Q_OBJECT
+
+public:
+  // higher classes go first when a link is short of bandwidth
+  enum class Priority
+  {
+    Distress = 0,
+    Report,
+    Routine,
+    Bulk
+  };
+
+  struct SendOptions
+  {
+    Priority m_priority = Priority::Routine;
+    // a queued send with the same key on the same link is replaced by the newer one
+    QString m_coalesceKey;
+    // further attempts after a failed write, each after a longer wait
+    int m_retries = 0;
+    int m_retryInterval = 250;
+    // copies sent again after a successful write, for links without acknowledgement
+    int m_repeats = 0;
+    int m_repeatInterval = 100;
+  };
+
+  static OutboundTransport* instance();
+
+  ~OutboundTransport();
+
+  void send(const UdpTransport& transport, quint16 port, const QByteArray& data,
+            const SendOptions& options = SendOptions());
+
+  qint64 sentCount() const;
+  qint64 failedCount() const;
+  qint64 coalescedCount() const;
+
+signals:
+  void sendFailed(quint16 port, const QByteArray& data);
+
+private:
+  Q_DISABLE_COPY(OutboundTransport)
+
+  explicit OutboundTransport(QObject* parent = nullptr);
+
+  struct PendingSend
+  {
+    UdpTransport m_transport;
+    quint16 m_port = 0;
+    QByteArray m_data;
+    SendOptions m_options;
+    qint64 m_sequence = 0;
+    int m_attempt = 0;
+    int m_repeatsLeft = 0;
+  };
+
+  static constexpr int s_priorityCount = static_cast<int>(Priority::Bulk) + 1;
+
+  // the queues and token bucket of one network destination, shared by all of its ports
+  struct Link
+  {
+    QList<PendingSend> m_queues[s_priorityCount];
+    double m_tokens = 0.0;
+    qint64 m_refillTimestamp = 0;
+    // the newest sequence sent for each coalesce key, so late retries cannot overtake it
+    QHash<QString, qint64> m_sentSequences;
+  };
+
+  void enqueue(const PendingSend& pending);
+  void drain();
+  void write(PendingSend pending);
+  QIODevice* device(const PendingSend& pending);
+  void dropDevice(const PendingSend& pending);
+
+  QThread* m_thread = nullptr;
+  QObject* m_worker = nullptr;
+
+  // only accessed on the worker thread
+  QTimer* m_drainTimer = nullptr;
+  QElapsedTimer m_clock;
+  QHash<QString, QIODevice*> m_devices;
+  QHash<QString, Link> m_links;
+
+  std::atomic<qint64> m_sequence{0};
+  std::atomic<qint64> m_sentCount{0};
+  std::atomic<qint64> m_failedCount{0};
+  std::atomic<qint64> m_coalescedCount{0};
+};
+
+} // Dsa
+
+#endif // OUTBOUNDTRANSPORT_H
@@ -0,0 +1,115 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+// STL headers
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace Dsa {
+
+// A bounded, lock-free queue for exactly one producer thread
+// and exactly one consumer thread.
+template<class T>
+class SpscQueue
+{
+public:
+  explicit SpscQueue(std::size_t capacity);
+
+  bool push(const T& value);
+  bool pop(T& value);
+
+  bool isEmpty() const;
+  bool isFull() const;
+  std::size_t capacity() const;
+
+private:
+  SpscQueue(const SpscQueue&) = delete;
+  SpscQueue& operator=(const SpscQueue&) = delete;
+
+  std::size_t next(std::size_t index) const;
+
+  // one slot is always left free to distinguish full from empty
+  std::vector<T> m_buffer;
+  std::atomic<std::size_t> m_head{0};
+  std::atomic<std::size_t> m_tail{0};
+};
+
+template<class T>
+SpscQueue<T>::SpscQueue(std::size_t capacity) :
+  m_buffer(capacity + 1)
+{
+}
+
+// producer only
+template<class T>
+bool SpscQueue<T>::push(const T& value)
+{
+  const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+  const std::size_t nextTail = next(tail);
+  if (nextTail == m_head.load(std::memory_order_acquire))
+    return false;
+
+  m_buffer[tail] = value;
+  m_tail.store(nextTail, std::memory_order_release);
+  return true;
+}
+
+// consumer only
+template<class T>
+bool SpscQueue<T>::pop(T& value)
+{
+  const std::size_t head = m_head.load(std::memory_order_relaxed);
+  if (head == m_tail.load(std::memory_order_acquire))
+    return false;
+
+  value = std::move(m_buffer[head]);
+  m_buffer[head] = T();
+  m_head.store(next(head), std::memory_order_release);
+  return true;
+}
+
+template<class T>
+bool SpscQueue<T>::isEmpty() const
+{
+  return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+}
+
+template<class T>
+bool SpscQueue<T>::isFull() const
+{
+  return next(m_tail.load(std::memory_order_acquire)) == m_head.load(std::memory_order_acquire);
+}
+
+template<class T>
+std::size_t SpscQueue<T>::capacity() const
+{
+  return m_buffer.size() - 1;
+}
+
+template<class T>
+std::size_t SpscQueue<T>::next(std::size_t index) const
+{
+  return (index + 1) % m_buffer.size();
+}
+
+} // Dsa
+
+#endif // SPSCQUEUE_H
@@ -0,0 +1,336 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "UdpReceiver.h"
+
+// Qt headers
+#include <QMutexLocker>
+#include <QThread>
+
+#if defined(Q_OS_LINUX) && !defined(Q_OS_ANDROID)
+#define DSA_UDP_RECVMMSG
+
+// system headers
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// STL headers
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace Dsa {
+
+namespace {
+#ifdef DSA_UDP_RECVMMSG
+// datagrams read by each recvmmsg call
+constexpr int s_batchSize = 32;
+// the largest UDP payload
+constexpr int s_maximumDatagramSize = 65536;
+// how often the receive thread checks whether it should stop, in ms
+constexpr int s_pollTimeout = 100;
+#endif
+// maximum number of datagrams waiting to be delivered to the UI thread
+constexpr int s_pendingCapacity = 8192;
+}
+
+/*!
+  \class Dsa::UdpReceiver
+  \inmodule Dsa
+  \inherits QObject
+  \brief Receives UDP datagrams on a dedicated thread.
+
+  On Linux the thread pulls up to 32 datagrams per \c recvmmsg system call, so
+  a burst is drained from the socket before its receive buffer overflows, and
+  the kernel's count of datagrams dropped on a full buffer is read with each
+  batch. Received datagrams are delivered on the receiver's thread with
+  \l datagramsReceived.
+
+  The receiver is not supported on other platforms; use a QUdpSocket with a
+  \l DataListener instead.
+
+  \sa isSupported
+ */
+
+/*!
+  \brief Constructs a receiver for \a port with an optional \a parent.
+
+  A positive \a receiveBufferSize, in bytes, replaces the OS default socket
+  receive buffer size. If \a multicastGroup is not null the socket joins it.
+ */
+UdpReceiver::UdpReceiver(quint16 port, int receiveBufferSize, const QHostAddress& multicastGroup, QObject* parent) :
+  QObject(parent),
+  m_port(port),
+  m_receiveBufferSize(receiveBufferSize),
+  m_multicastGroup(multicastGroup)
+{
+  qRegisterMetaType<QVector<QByteArray>>("QVector<QByteArray>");
+}
+
+/*!
+  \brief Destructor.
+ */
+UdpReceiver::~UdpReceiver()
+{
+  stop();
+}
+
+/*!
+  \brief Returns whether a dedicated receive thread is supported on this platform.
+ */
+bool UdpReceiver::isSupported()
+{
+#ifdef DSA_UDP_RECVMMSG
+  return true;
+#else
+  return false;
+#endif
+}
+
+/*!
+  \brief Binds the socket and starts the receive thread.
+
+  Returns \c false if the platform is not supported or the socket could not be bound.
+ */
+bool UdpReceiver::start()
+{
+#ifdef DSA_UDP_RECVMMSG
+  if (m_thread)
+    return true;
+
+  m_socket = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+  if (m_socket == -1)
+    return false;
+
+  const int enable = 1;
+  ::setsockopt(m_socket, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+  // the kernel reports the datagrams it dropped with every received datagram
+  ::setsockopt(m_socket, SOL_SOCKET, SO_RXQ_OVFL, &enable, sizeof(enable));
+
+  if (m_receiveBufferSize > 0)
+    ::setsockopt(m_socket, SOL_SOCKET, SO_RCVBUF, &m_receiveBufferSize, sizeof(m_receiveBufferSize));
+
+  sockaddr_in address;
+  std::memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_port = htons(m_port);
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (::bind(m_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == -1)
+  {
+    closeSocket();
+    return false;
+  }
+
+  if (!m_multicastGroup.isNull())
+  {
+    ip_mreq membership;
+    membership.imr_multiaddr.s_addr = htonl(m_multicastGroup.toIPv4Address());
+    membership.imr_interface.s_addr = htonl(INADDR_ANY);
+    if (::setsockopt(m_socket, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) == -1)
+    {
+      closeSocket();
+      return false;
+    }
+  }
+
+  m_stopping = false;
+  m_thread = QThread::create([this] { receiveLoop(); });
+  m_thread->setObjectName(QStringLiteral("UdpReceiver %1").arg(m_port));
+  m_thread->start();
+
+  return true;
+#else
+  return false;
+#endif
+}
+
+/*!
+  \brief Stops the receive thread and closes the socket, leaving any multicast group.
+ */
+void UdpReceiver::stop()
+{
+  if (m_thread)
+  {
+    m_stopping = true;
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+  }
+
+  closeSocket();
+}
+
+/*!
+  \brief Returns whether the receive thread is running.
+ */
+bool UdpReceiver::isRunning() const
+{
+  return m_thread != nullptr;
+}
+
+/*!
+  \brief Returns the port the receiver listens on.
+ */
+quint16 UdpReceiver::port() const
+{
+  return m_port;
+}
+
+/*!
+  \brief Returns the number of datagrams dropped because the socket receive
+  buffer, or the queue to the receiver's thread, was full.
+ */
+qint64 UdpReceiver::droppedCount() const
+{
+  return m_socketDroppedCount + m_queueDroppedCount;
+}
+
+/*!
+  \internal
+ */
+void UdpReceiver::closeSocket()
+{
+#ifdef DSA_UDP_RECVMMSG
+  if (m_socket == -1)
+    return;
+
+  if (!m_multicastGroup.isNull())
+  {
+    ip_mreq membership;
+    membership.imr_multiaddr.s_addr = htonl(m_multicastGroup.toIPv4Address());
+    membership.imr_interface.s_addr = htonl(INADDR_ANY);
+    ::setsockopt(m_socket, IPPROTO_IP, IP_DROP_MEMBERSHIP, &membership, sizeof(membership));
+  }
+
+  ::close(m_socket);
+  m_socket = -1;
+#endif
+}
+
+/*!
+  \internal
+  \brief Reads batches of datagrams until the receiver is stopped. Runs on the receive thread.
+ */
+void UdpReceiver::receiveLoop()
+{
+#ifdef DSA_UDP_RECVMMSG
+  QVector<QByteArray> buffers(s_batchSize);
+  for (auto& buffer : buffers)
+    buffer.resize(s_maximumDatagramSize);
+
+  mmsghdr messages[s_batchSize];
+  iovec vectors[s_batchSize];
+  char control[s_batchSize][CMSG_SPACE(sizeof(quint32))];
+
+  while (!m_stopping)
+  {
+    pollfd pollDescriptor{m_socket, POLLIN, 0};
+    if (::poll(&pollDescriptor, 1, s_pollTimeout) <= 0)
+      continue;
+
+    // the headers are updated by each call so are reset every time
+    std::memset(messages, 0, sizeof(messages));
+    for (int i = 0; i < s_batchSize; ++i)
+    {
+      vectors[i].iov_base = buffers[i].data();
+      vectors[i].iov_len = s_maximumDatagramSize;
+      messages[i].msg_hdr.msg_iov = &vectors[i];
+      messages[i].msg_hdr.msg_iovlen = 1;
+      messages[i].msg_hdr.msg_control = control[i];
+      messages[i].msg_hdr.msg_controllen = sizeof(control[i]);
+    }
+
+    const int received = ::recvmmsg(m_socket, messages, s_batchSize, MSG_DONTWAIT, nullptr);
+    if (received <= 0)
+      continue;
+
+    QVector<QByteArray> datagrams;
+    datagrams.reserve(received);
+    for (int i = 0; i < received; ++i)
+    {
+      datagrams.append(QByteArray(buffers.at(i).constData(), static_cast<int>(messages[i].msg_len)));
+
+      // the drop count is cumulative over the life of the socket
+      for (cmsghdr* header = CMSG_FIRSTHDR(&messages[i].msg_hdr); header; header = CMSG_NXTHDR(&messages[i].msg_hdr, header))
+      {
+        if (header->cmsg_level == SOL_SOCKET && header->cmsg_type == SO_RXQ_OVFL)
+        {
+          quint32 dropped = 0;
+          std::memcpy(&dropped, CMSG_DATA(header), sizeof(dropped));
+          m_socketDroppedCount = dropped;
+        }
+      }
+    }
+
+    queueDatagrams(datagrams);
+  }
+#endif
+}
+
+/*!
+  \internal
+  \brief Queues \a datagrams for delivery, scheduling a single delivery while
+  earlier batches are still waiting.
+ */
+void UdpReceiver::queueDatagrams(QVector<QByteArray>& datagrams)
+{
+  {
+    QMutexLocker locker(&m_pendingMutex);
+    const int available = s_pendingCapacity - m_pendingDatagrams.size();
+    if (datagrams.size() > available)
+    {
+      m_queueDroppedCount += datagrams.size() - available;
+      datagrams.resize(available);
+    }
+
+    m_pendingDatagrams.append(datagrams);
+  }
+
+  if (!m_deliveryScheduled.exchange(true))
+    QMetaObject::invokeMethod(this, [this] { deliverDatagrams(); }, Qt::QueuedConnection);
+}
+
+/*!
+  \internal
+ */
+void UdpReceiver::deliverDatagrams()
+{
+  m_deliveryScheduled = false;
+
+  QVector<QByteArray> datagrams;
+  {
+    QMutexLocker locker(&m_pendingMutex);
+    datagrams.swap(m_pendingDatagrams);
+  }
+
+  if (!datagrams.isEmpty())
+    emit datagramsReceived(datagrams);
+}
+
+} // Dsa
+
+// Signal Documentation
+/*!
+  \fn void UdpReceiver::datagramsReceived(const QVector<QByteArray>& datagrams);
+  \brief Signal emitted on the receiver's thread with the \a datagrams received since the last emission.
+ */
@@ -0,0 +1,82 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef UDPRECEIVER_H
+#define UDPRECEIVER_H
+
+// Qt headers
+#include <QByteArray>
+#include <QHostAddress>
+#include <QMutex>
+#include <QObject>
+#include <QVector>
+
+// STL headers
+#include <atomic>
+
+class QThread;
+
+namespace Dsa {
+
+class UdpReceiver : public QObject
+{
+  Q_OBJECT
+
+public:
+  UdpReceiver(quint16 port, int receiveBufferSize, const QHostAddress& multicastGroup, QObject* parent = nullptr);
+  ~UdpReceiver();
+
+  static bool isSupported();
+
+  bool start();
+  void stop();
+  bool isRunning() const;
+
+  quint16 port() const;
+
+  qint64 droppedCount() const;
+
+signals:
+  void datagramsReceived(const QVector<QByteArray>& datagrams);
+
+private:
+  Q_DISABLE_COPY(UdpReceiver)
+  UdpReceiver() = delete;
+
+  void closeSocket();
+  void receiveLoop();
+  void queueDatagrams(QVector<QByteArray>& datagrams);
+  void deliverDatagrams();
+
+  quint16 m_port = 0;
+  int m_receiveBufferSize = 0;
+  QHostAddress m_multicastGroup;
+
+  int m_socket = -1;
+  QThread* m_thread = nullptr;
+  std::atomic<bool> m_stopping{false};
+
+  QMutex m_pendingMutex;
+  QVector<QByteArray> m_pendingDatagrams;
+  std::atomic<bool> m_deliveryScheduled{false};
+
+  std::atomic<qint64> m_socketDroppedCount{0};
+  std::atomic<qint64> m_queueDroppedCount{0};
+};
+
+} // Dsa
+
+#endif // UDPRECEIVER_H
@@ -0,0 +1,392 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "UdpTransport.h"
+
+// dsa app headers
+#include "DataListener.h"
+#include "UdpReceiver.h"
+
+// Qt headers
+#include <QStringList>
+#include <QUdpSocket>
+
+namespace Dsa {
+
+namespace
+{
+/*
+ Write-only device sending every write as one datagram to each peer, so a
+ DataSender can address a unicast peer list as if it were a single socket.
+ */
+class UdpPeerDevice : public QIODevice
+{
+public:
+  UdpPeerDevice(const QList<QHostAddress>& peers, quint16 port, QObject* parent) :
+    QIODevice(parent),
+    m_socket(new QUdpSocket(this)),
+    m_peers(peers),
+    m_port(port)
+  {
+    open(QIODevice::WriteOnly);
+  }
+
+  bool isSequential() const override
+  {
+    return true;
+  }
+
+protected:
+  qint64 readData(char*, qint64) override
+  {
+    return -1;
+  }
+
+  qint64 writeData(const char* data, qint64 size) override
+  {
+    qint64 bytesWritten = -1;
+    for (const auto& peer : m_peers)
+    {
+      if (m_socket->writeDatagram(data, size, peer, m_port) != -1)
+        bytesWritten = size;
+    }
+
+    return bytesWritten;
+  }
+
+private:
+  QUdpSocket* m_socket = nullptr;
+  QList<QHostAddress> m_peers;
+  quint16 m_port = 0;
+};
+}
+
+const QString UdpTransport::TRANSPORT_PROPERTYNAME = QStringLiteral("UdpTransport");
+const QString UdpTransport::TRANSPORT_MODE = QStringLiteral("mode");
+const QString UdpTransport::TRANSPORT_MULTICAST_GROUP = QStringLiteral("multicastGroup");
+const QString UdpTransport::TRANSPORT_MULTICAST_TTL = QStringLiteral("multicastTtl");
+const QString UdpTransport::TRANSPORT_UNICAST_PEERS = QStringLiteral("unicastPeers");
+const QString UdpTransport::TRANSPORT_RECEIVE_BUFFER_SIZE = QStringLiteral("receiveBufferSize");
+const QString UdpTransport::TRANSPORT_RECEIVE_BUFFER_SIZES = QStringLiteral("receiveBufferSizes");
+const QString UdpTransport::TRANSPORT_RECEIVE_THREAD = QStringLiteral("receiveThread");
+const QString UdpTransport::TRANSPORT_SEND_RATE = QStringLiteral("sendRate");
+
+/*!
+  \class Dsa::UdpTransport
+  \inmodule Dsa
+  \brief Describes how message feeds are sent and received over UDP: as
+  broadcast, to a multicast group, or to a list of unicast peers.
+
+  Hosts which do not join a multicast group, or are not in the peer list,
+  never receive the traffic, unlike broadcast which reaches the whole segment.
+ */
+
+/*!
+  \brief Constructs a broadcast transport.
+ */
+UdpTransport::UdpTransport()
+{
+}
+
+/*!
+  \brief Destructor.
+ */
+UdpTransport::~UdpTransport()
+{
+}
+
+/*!
+  \brief Returns the transport described by the \c UdpTransport map in \a properties.
+
+  The map's \c mode is \c broadcast (the default), \c multicast or \c unicast.
+  Multicast needs a \c multicastGroup address and takes an optional
+  \c multicastTtl (default \c 1). Unicast needs a list of \c unicastPeers
+  IP addresses. An incomplete configuration falls back to broadcast.
+
+  Listening sockets keep the OS default receive buffer unless the map has a
+  \c receiveBufferSize in bytes, or a \c receiveBufferSizes map from port to
+  bytes for individual feeds. \c receiveThread (default \c true) selects a
+  dedicated UdpReceiver thread where it is supported.
+
+  A \c sendRate in bytes per second caps what \l OutboundTransport sends to
+  the destination across all ports; \c 0 (the default) leaves it uncapped.
+ */
+UdpTransport UdpTransport::fromProperties(const QVariantMap& properties)
+{
+  UdpTransport transport;
+
+  const auto transportConfig = properties.value(TRANSPORT_PROPERTYNAME).toMap();
+
+  transport.m_receiveBufferSize = qMax(0, transportConfig.value(TRANSPORT_RECEIVE_BUFFER_SIZE).toInt());
+  const auto receiveBufferSizes = transportConfig.value(TRANSPORT_RECEIVE_BUFFER_SIZES).toMap();
+  for (auto it = receiveBufferSizes.cbegin(); it != receiveBufferSizes.cend(); ++it)
+  {
+    bool ok = false;
+    const quint16 port = it.key().toUShort(&ok);
+    const int size = it.value().toInt();
+    if (ok && size > 0)
+      transport.m_receiveBufferSizes.insert(port, size);
+  }
+
+  if (transportConfig.contains(TRANSPORT_RECEIVE_THREAD))
+    transport.m_receiveThreadEnabled = transportConfig.value(TRANSPORT_RECEIVE_THREAD).toBool();
+
+  transport.m_sendRate = qMax(0, transportConfig.value(TRANSPORT_SEND_RATE).toInt());
+
+  const Mode mode = toMode(transportConfig.value(TRANSPORT_MODE).toString());
+  if (mode == Mode::Multicast)
+  {
+    const QHostAddress group(transportConfig.value(TRANSPORT_MULTICAST_GROUP).toString());
+    if (!group.isMulticast())
+      return transport;
+
+    transport.m_mode = mode;
+    transport.m_multicastGroup = group;
+
+    bool ok = false;
+    const int ttl = transportConfig.value(TRANSPORT_MULTICAST_TTL).toInt(&ok);
+    if (ok && ttl > 0)
+      transport.m_multicastTtl = ttl;
+  }
+  else if (mode == Mode::Unicast)
+  {
+    const auto peers = transportConfig.value(TRANSPORT_UNICAST_PEERS).toStringList();
+    for (const auto& peer : peers)
+    {
+      const QHostAddress address(peer.trimmed());
+      if (!address.isNull())
+        transport.m_unicastPeers.append(address);
+    }
+
+    if (!transport.m_unicastPeers.isEmpty())
+      transport.m_mode = mode;
+  }
+
+  return transport;
+}
+
+/*!
+  \brief Returns the transport mode.
+ */
+UdpTransport::Mode UdpTransport::mode() const
+{
+  return m_mode;
+}
+
+/*!
+  \brief Returns the multicast group address, which is null unless the mode is multicast.
+ */
+QHostAddress UdpTransport::multicastGroup() const
+{
+  return m_multicastGroup;
+}
+
+/*!
+  \brief Returns the time to live of sent multicast datagrams.
+ */
+int UdpTransport::multicastTtl() const
+{
+  return m_multicastTtl;
+}
+
+/*!
+  \brief Returns the unicast peer addresses, which are empty unless the mode is unicast.
+ */
+QList<QHostAddress> UdpTransport::unicastPeers() const
+{
+  return m_unicastPeers;
+}
+
+/*!
+  \brief Returns the receive buffer size in bytes for listening on \a port, or
+  \c 0 to keep the OS default.
+ */
+int UdpTransport::receiveBufferSize(quint16 port) const
+{
+  return m_receiveBufferSizes.value(port, m_receiveBufferSize);
+}
+
+/*!
+  \brief Returns whether listeners use a dedicated UdpReceiver thread where it is supported.
+ */
+bool UdpTransport::isReceiveThreadEnabled() const
+{
+  return m_receiveThreadEnabled;
+}
+
+/*!
+  \brief Returns the send rate cap in bytes per second, or \c 0 for none.
+ */
+int UdpTransport::sendRate() const
+{
+  return m_sendRate;
+}
+
+/*!
+  \brief Returns a new socket with \a parent listening on \a port.
+
+  In multicast mode the socket joins the multicast group; the membership is
+  dropped when the socket is closed or destroyed.
+ */
+QUdpSocket* UdpTransport::createListener(quint16 port, QObject* parent) const
+{
+  QUdpSocket* udpSocket = new QUdpSocket(parent);
+  if (m_mode == Mode::Multicast)
+  {
+    // other listeners on this host may join the same group and port
+    udpSocket->bind(QHostAddress::AnyIPv4, port, QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint);
+    udpSocket->joinMulticastGroup(m_multicastGroup);
+    QObject::connect(udpSocket, &QIODevice::aboutToClose, udpSocket, [udpSocket, group = m_multicastGroup]
+    {
+      udpSocket->leaveMulticastGroup(group);
+    });
+  }
+  else
+  {
+    udpSocket->bind(port, QUdpSocket::DontShareAddress | QUdpSocket::ReuseAddressHint);
+  }
+
+  const int bufferSize = receiveBufferSize(port);
+  if (bufferSize > 0)
+    udpSocket->setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, bufferSize);
+
+  return udpSocket;
+}
+
+/*!
+  \brief Returns a new DataListener with \a parent listening on \a port.
+
+  Where supported, the listener is fed by a UdpReceiver thread which drains many
+  datagrams per system call and reports the datagrams dropped by the OS.
+  Otherwise it reads a socket from \l createListener.
+ */
+DataListener* UdpTransport::createDataListener(quint16 port, QObject* parent) const
+{
+  DataListener* dataListener = new DataListener(parent);
+
+  if (m_receiveThreadEnabled && UdpReceiver::isSupported())
+  {
+    const QHostAddress group = m_mode == Mode::Multicast ? m_multicastGroup : QHostAddress();
+    UdpReceiver* receiver = new UdpReceiver(port, receiveBufferSize(port), group, dataListener);
+    if (receiver->start())
+    {
+      dataListener->setReceiver(receiver);
+      return dataListener;
+    }
+
+    delete receiver;
+  }
+
+  dataListener->setDevice(createListener(port, dataListener));
+  return dataListener;
+}
+
+/*!
+  \brief Returns a new write-only device with \a parent sending to \a port.
+
+  Use the device with a \l DataSender.
+ */
+QIODevice* UdpTransport::createSender(quint16 port, QObject* parent) const
+{
+  switch (m_mode)
+  {
+  case Mode::Multicast:
+  {
+    QUdpSocket* udpSocket = new QUdpSocket(parent);
+    udpSocket->setSocketOption(QAbstractSocket::MulticastTtlOption, m_multicastTtl);
+    udpSocket->connectToHost(m_multicastGroup, port, QIODevice::WriteOnly);
+    return udpSocket;
+  }
+  case Mode::Unicast:
+    return new UdpPeerDevice(m_unicastPeers, port, parent);
+  case Mode::Broadcast:
+  default:
+  {
+    QUdpSocket* udpSocket = new QUdpSocket(parent);
+    udpSocket->connectToHost(QHostAddress::Broadcast, port, QIODevice::WriteOnly);
+    return udpSocket;
+  }
+  }
+}
+
+/*!
+  \brief Returns a key identifying the destination of a sender created on \a port.
+
+  Senders with the same key write to the same destination and can be shared.
+ */
+QString UdpTransport::senderKey(quint16 port) const
+{
+  return linkKey() + QLatin1Char('|') + QString::number(port);
+}
+
+/*!
+  \brief Returns a key identifying the network destination of this transport,
+  which the senders on all ports share.
+ */
+QString UdpTransport::linkKey() const
+{
+  QStringList peers;
+  for (const QHostAddress& peer : m_unicastPeers)
+    peers.append(peer.toString());
+
+  return QStringLiteral("%1|%2|%3|%4").arg(static_cast<int>(m_mode))
+      .arg(m_multicastGroup.toString())
+      .arg(m_multicastTtl)
+      .arg(peers.join(QLatin1Char(',')));
+}
+
+/*!
+  \brief Returns whether this transport is the same as \a other.
+ */
+bool UdpTransport::operator==(const UdpTransport& other) const
+{
+  return m_mode == other.m_mode &&
+      m_multicastGroup == other.m_multicastGroup &&
+      m_multicastTtl == other.m_multicastTtl &&
+      m_unicastPeers == other.m_unicastPeers &&
+      m_receiveBufferSize == other.m_receiveBufferSize &&
+      m_receiveBufferSizes == other.m_receiveBufferSizes &&
+      m_receiveThreadEnabled == other.m_receiveThreadEnabled &&
+      m_sendRate == other.m_sendRate;
+}
+
+/*!
+  \brief Returns whether this transport differs from \a other.
+ */
+bool UdpTransport::operator!=(const UdpTransport& other) const
+{
+  return !(*this == other);
+}
+
+/*!
+  \brief Converts the \a mode string (\c "broadcast", \c "multicast" or \c "unicast") to a Mode.
+
+  Unrecognized values map to \c Mode::Broadcast.
+ */
+UdpTransport::Mode UdpTransport::toMode(const QString& mode)
+{
+  if (mode.compare("multicast", Qt::CaseInsensitive) == 0)
+    return Mode::Multicast;
+  else if (mode.compare("unicast", Qt::CaseInsensitive) == 0)
+    return Mode::Unicast;
+
+  return Mode::Broadcast;
+}
+
+} // Dsa
@@ -0,0 +1,93 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef UDPTRANSPORT_H
+#define UDPTRANSPORT_H
+
+// Qt headers
+#include <QHash>
+#include <QHostAddress>
+#include <QList>
+#include <QString>
+#include <QVariantMap>
+
+class QIODevice;
+class QObject;
+class QUdpSocket;
+
+namespace Dsa {
+
+class DataListener;
+
+class UdpTransport
+{
+public:
+  enum class Mode
+  {
+    Broadcast = 0,
+    Multicast,
+    Unicast
+  };
+
+  static const QString TRANSPORT_PROPERTYNAME;
+  static const QString TRANSPORT_MODE;
+  static const QString TRANSPORT_MULTICAST_GROUP;
+  static const QString TRANSPORT_MULTICAST_TTL;
+  static const QString TRANSPORT_UNICAST_PEERS;
+  static const QString TRANSPORT_RECEIVE_BUFFER_SIZE;
+  static const QString TRANSPORT_RECEIVE_BUFFER_SIZES;
+  static const QString TRANSPORT_RECEIVE_THREAD;
+  static const QString TRANSPORT_SEND_RATE;
+
+  UdpTransport();
+  ~UdpTransport();
+
+  static UdpTransport fromProperties(const QVariantMap& properties);
+
+  Mode mode() const;
+  QHostAddress multicastGroup() const;
+  int multicastTtl() const;
+  QList<QHostAddress> unicastPeers() const;
+
+  int receiveBufferSize(quint16 port) const;
+  bool isReceiveThreadEnabled() const;
+  int sendRate() const;
+
+  QUdpSocket* createListener(quint16 port, QObject* parent) const;
+  DataListener* createDataListener(quint16 port, QObject* parent) const;
+  QIODevice* createSender(quint16 port, QObject* parent) const;
+  QString senderKey(quint16 port) const;
+  QString linkKey() const;
+
+  bool operator==(const UdpTransport& other) const;
+  bool operator!=(const UdpTransport& other) const;
+
+  static Mode toMode(const QString& mode);
+
+private:
+  Mode m_mode = Mode::Broadcast;
+  QHostAddress m_multicastGroup;
+  int m_multicastTtl = 1;
+  QList<QHostAddress> m_unicastPeers;
+  int m_receiveBufferSize = 0;
+  QHash<quint16, int> m_receiveBufferSizes;
+  bool m_receiveThreadEnabled = true;
+  int m_sendRate = 0;
+};
+
+} // Dsa
+
+#endif // UDPTRANSPORT_H
@@ -68,6 +68,9 @@ QML_IMPORT_PATH += $$PWD/../Shared/qml
   CONFIG += precompile_header
 }
 
+# qmake CONFIG+=dsa_unity compiles the Shared sources in batches
+include($$PWD/../Shared/build/unity.pri)
+
 #-------------------------------------------------------------------------------
 
 win32 {
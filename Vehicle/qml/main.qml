@@ -243,7 +243,7 @@ Vehicle {
             onAboutClicked: aboutTool.visible = true;
         }
 
-        TableOfContents {
+        PanelLoader {
             id: tableOfContentsTool
             anchors {
                 right: parent.right
@@ -251,16 +251,19 @@ Vehicle {
                 bottom: sceneView.attributionTop
             }
             width: drawer.width
-            visible: false
-            isMobile: false
-            onClosed: {
-                mapToolRow.tocIconSelected = false;
-                visible = false;
-                mapToolRow.state = "clear";
+            sourceComponent: Component {
+                TableOfContents {
+                    isMobile: false
+                    onClosed: {
+                        mapToolRow.tocIconSelected = false;
+                        tableOfContentsTool.visible = false;
+                        mapToolRow.state = "clear";
+                    }
+                }
             }
         }
 
-        AlertList {
+        PanelLoader {
             id: alertsTool
             anchors {
                 right: parent.right
@@ -268,11 +271,14 @@ Vehicle {
                 bottom: sceneView.attributionTop
             }
             width: drawer.width
-            visible: false
-            isMobile: false
-            onClosed: {
-                visible = false;
-                alertToolRow.state = "clear";
+            sourceComponent: Component {
+                AlertList {
+                    isMobile: false
+                    onClosed: {
+                        alertsTool.visible = false;
+                        alertToolRow.state = "clear";
+                    }
+                }
             }
         }
 
@@ -330,7 +336,7 @@ Vehicle {
             visible: false
         }
 
-        AnalysisList {
+        PanelLoader {
             id: analysisListTool
             anchors {
                 right: parent.right
@@ -338,11 +344,14 @@ Vehicle {
                 bottom: sceneView.attributionTop
             }
             width: drawer.width
-            visible: false
-            isMobile: false
-            onClosed: {
-                visible = false;
-                analysisToolRow.state = "clear";
+            sourceComponent: Component {
+                AnalysisList {
+                    isMobile: false
+                    onClosed: {
+                        analysisListTool.visible = false;
+                        analysisToolRow.state = "clear";
+                    }
+                }
             }
         }
 
@@ -372,19 +381,14 @@ Vehicle {
             }
         }
 
-        Toolkit.PopupStackView {
+        IdentifyResults {
             id: identifyResults
             anchors {
                 top: sceneView.top
                 right: sceneView.right
                 bottom: sceneView.attributionTop
             }
-            palette {
-                text: Material.foreground
-            }
-            background: Rectangle {
-                color: Material.primary
-            }
+            identifyController: identifyController
             visible: false
         }
 
@@ -475,10 +479,14 @@ Vehicle {
         }
     }
 
-    About {
+    PanelLoader {
         id: aboutTool
         anchors.fill: parent
-        visible: false
+        sourceComponent: Component {
+            About {
+                onClosed: aboutTool.visible = false;
+            }
+        }
     }
 
     IdentifyController {
@@ -494,10 +502,8 @@ Vehicle {
         }
 
         onPopupManagersChanged: {
-            if (popupManagers.length > 0) {
-                identifyResults.popupManagers = popupManagers;
+            if (popupCount > 0)
                 identifyResults.visible = true;
-            }
         }
     }
 
@@ -534,6 +540,14 @@ Vehicle {
         visible: identifyController.busy
     }
 
+    PerformanceHud {
+        anchors {
+            left: parent.left
+            top: parent.top
+            margins: 10 * scaleFactor
+        }
+    }
+
     Shortcut {
         sequence: "Ctrl+Q"
         onActivated: Qt.quit()